@@ -64,6 +64,58 @@ namespace config
     void Config::clear()
     {
         m_root.clear();
+        m_key_index.clear();
+        m_compiled = false;
+    }
+
+    void Config::compile()
+    {
+        m_key_index.clear();
+        indexSection(m_root, "");
+        m_compiled = true;
+    }
+
+    void Config::indexSection(const Section & section, const std::string & path)
+    {
+        //The names in the lists are already lower-case if not case sensitive
+        KeyList const & keys = section.getKeys();
+        for(KeyList::const_iterator i = keys.begin(); i != keys.end(); i++)
+            m_key_index[path + i->first] = i->second.get();
+
+        SectionList const & subsections = section.getSubsections();
+        for(SectionList::const_iterator i = subsections.begin(); i != subsections.end(); i++)
+            indexSection(*(i->second.get()), path + i->first + "/");
+    }
+
+    void Config::indexKey(const std::string & path, const Key & key)
+    {
+        std::string ipath(path);
+        if(!m_case_sensitive)
+            boost::to_lower(ipath);
+        m_key_index[ipath] = &key;
+    }
+
+    const Key * Config::findCompiledKey(const std::string & path) const
+    {
+        KeyIndex::const_iterator found = m_key_index.find(path);
+        if(found != m_key_index.end())
+            return found->second;
+        if(m_case_sensitive)
+            return NULL;
+
+        //Only pay for the copy on a miss, most paths are lower-case already
+        std::string ipath(path);
+        boost::to_lower(ipath);
+        found = m_key_index.find(ipath);
+        return (found != m_key_index.end()) ? found->second : NULL;
+    }
+
+    const Key & Config::getCompiledKey(const std::string & path) const
+    {
+        const Key * key = findCompiledKey(path);
+        if(key == NULL)
+            throw KeyNotFound();
+        return *key;
     }
 
     const Key & Config::getKey(const std::string & path)
@@ -255,54 +307,88 @@ namespace config
 
     void Config::set(const std::string & path, const std::string & new_value)
     {
-        addKey(path, new_value);
+        const Key & key = addKey(path, new_value);
+        if(m_compiled)
+            indexKey(path, key);
     }
 
     void Config::set(const std::string & path, int new_value)
     {
-        addKey(path, new_value);
+        const Key & key = addKey(path, new_value);
+        if(m_compiled)
+            indexKey(path, key);
     }
 
     void Config::set(const std::string & path, double new_value)
     {
-        addKey(path, new_value);
+        const Key & key = addKey(path, new_value);
+        if(m_compiled)
+            indexKey(path, key);
     }
 
     //Below are the getters which also handle default values
     bool Config::getBool(const std::string & path)
     {
+        if(m_compiled)
+            return getCompiledKey(path).getBool();
         return getKey(path).getBool();
     }
 
     bool Config::getBool(const std::string & path, bool default_val)
     {
+        if(m_compiled)
+        {
+            const Key * key = findCompiledKey(path);
+            return key ? key->getBool() : default_val;
+        }
         return getKey(path,default_val).getBool();
     }
 
     int Config::getInt(const std::string & path)
     {
+        if(m_compiled)
+            return getCompiledKey(path).getInt();
         return getKey(path).getInt();
     }
     int Config::getInt(const std::string & path, int default_val)
     {
+        if(m_compiled)
+        {
+            const Key * key = findCompiledKey(path);
+            return key ? key->getInt() : default_val;
+        }
         return getKey(path,default_val).getInt();
     }
 
     const std::string Config::getString(const std::string & path)
     {
+        if(m_compiled)
+            return getCompiledKey(path).getString();
         return getKey(path).getString();
     }
     const std::string Config::getString(const std::string & path, const std::string & default_val)
     {
+        if(m_compiled)
+        {
+            const Key * key = findCompiledKey(path);
+            return key ? key->getString() : default_val;
+        }
         return getKey(path,default_val).getString();
     }
 
     double Config::getFloat(const std::string & path)
     {
+        if(m_compiled)
+            return getCompiledKey(path).getFloat();
         return getKey(path).getFloat();
     }
     double Config::getFloat(const std::string & path, double default_val)
     {
+        if(m_compiled)
+        {
+            const Key * key = findCompiledKey(path);
+            return key ? key->getFloat() : default_val;
+        }
         return getKey(path,default_val).getFloat();
     }
 
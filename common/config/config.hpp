@@ -15,6 +15,8 @@
 #include <string>
 #include <iostream>
 
+#include <boost/unordered_map.hpp>
+
 #include "key.hpp"
 #include "section.hpp"
 #include "config_exceptions.hpp"
@@ -34,8 +36,8 @@ namespace config
     class Config
     {
         public:
-            Config(bool case_sensitive = false): m_case_sensitive(case_sensitive), m_root("", case_sensitive){}
-            Config(const Section & root, bool case_sensitive = false): m_case_sensitive(case_sensitive), m_root(root, "", case_sensitive){}
+            Config(bool case_sensitive = false): m_case_sensitive(case_sensitive), m_root("", case_sensitive), m_compiled(false){}
+            Config(const Section & root, bool case_sensitive = false): m_case_sensitive(case_sensitive), m_root(root, "", case_sensitive), m_compiled(false){}
             virtual ~Config(){}
 
             /*! \brief A function for saving the entire configuration
@@ -67,6 +69,17 @@ namespace config
 
             void clear();
 
+            /*! \brief compile() indexes every key of the configuration by its full path,
+             * once it is loaded. The getters then find a key with a single lookup and no
+             * longer change the tree: a key looked up with a default that is not in the
+             * configuration gives the default without being added, and a key looked up
+             * without a default must be in the configuration (KeyNotFound). Several
+             * threads can then read the configuration at once.
+             * A key set() after compile() is indexed too, but set() is not thread-safe.
+             */
+            void compile();
+            bool isCompiled() const { return m_compiled; }
+
             //! A function that will save a given value to key at the specified path.
             virtual void set(const std::string & path, const std::string & new_value);
 
@@ -178,6 +191,17 @@ namespace config
             Key & getKey_unsafe(std::string const& path);
 
         private:
+            // Full path (lower-case, unless case sensitive) -> key, see compile()
+            typedef boost::unordered_map<std::string, const Key*> KeyIndex;
+            bool m_compiled;
+            KeyIndex m_key_index;
+
+            void indexSection(const Section & section, const std::string & path);
+            void indexKey(const std::string & path, const Key & key);
+            // NULL if not found
+            const Key * findCompiledKey(const std::string & path) const;
+            const Key & getCompiledKey(const std::string & path) const;
+
             const Key & getKey(const std::string & path);
             const Key & getKey(const std::string & path, int default_val);
             const Key & getKey(const std::string & path, double default_val);
@@ -1,13 +1,22 @@
 #include <sstream>
 #include <fstream>
+#include <set>
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/file.h>
 #include <unistd.h>
 using namespace std;
 
 #include "mcpat_cache.h"
 #include "simulator.h"
 #include "config.h"
+#include "tile.h"
+#include "constants.h"
 #include "utils.h"
 #include "log.h"
 
@@ -29,9 +38,11 @@ McPATCache::release()
 
 McPATCache::McPATCache()
 {
+   bool precompute_presets = false;
    try
    {
       _mcpat_home = Sim()->getCfg()->getString("general/McPAT_home");
+      precompute_presets = Sim()->getCfg()->getBool("general/McPAT_cache_precompute", false);
    }
    catch (...)
    {
@@ -41,6 +52,34 @@ McPATCache::McPATCache()
    {
       LOG_PRINT_ERROR("\"Enter Correct Path to McPAT installation\" (or) \"Set [general/enable_power_modeling] and [general/enable_area_modeling] to false\"");
    }
+
+   _persistent_file = Sim()->getModelCacheFile("general/McPAT_cache_file", "mcpat.cache");
+   if (_persistent_file == "")
+      return;
+
+   // A rebuilt McPAT or a changed default input invalidates the results
+   ostringstream version;
+   string version_files[] = { _mcpat_home + "/mcpat", Sim()->getGraphiteHome() + "/common/mcpat/default_input.xml" };
+   for (UInt32 i = 0; i < 2; i++)
+   {
+      struct stat file_stat;
+      if (stat(version_files[i].c_str(), &file_stat) != 0)
+         LOG_PRINT_ERROR("McPAT Cache: Could not stat (%s)", version_files[i].c_str());
+      version << ((i == 0) ? "" : ":") << file_stat.st_size << "." << file_stat.st_mtime;
+   }
+   _mcpat_version = version.str();
+
+   SInt32 fd = open(_persistent_file.c_str(), O_RDONLY);
+   if (fd >= 0)
+   {
+      flock(fd, LOCK_SH);
+      loadPersistent(fd);
+      flock(fd, LOCK_UN);
+      close(fd);
+   }
+
+   if (precompute_presets)
+      precompute();
 }
 
 McPATCache::~McPATCache()
@@ -103,7 +142,58 @@ McPATCache::runMcPAT(CacheParams* cache_params_)
    CacheParams* cache_params = new CacheParams(*cache_params_);
    CacheArea* cache_area = new CacheArea();
    CachePower* cache_power = new CachePower();
- 
+
+   if (_persistent_file == "")
+   {
+      invokeMcPAT(cache_params, cache_area, cache_power);
+   }
+   else
+   {
+      string key = getPersistentKey(cache_params);
+      if (!findPersistent(key, cache_area, cache_power))
+      {
+         SInt32 fd = open(_persistent_file.c_str(), O_RDWR | O_CREAT | O_APPEND, 0664);
+         if (fd < 0)
+            LOG_PRINT_ERROR("McPAT Cache: Could not open (%s): %s", _persistent_file.c_str(), strerror(errno));
+         flock(fd, LOCK_EX);
+
+         // Another run may have added it while this one waited for the lock
+         loadPersistent(fd);
+         if (!findPersistent(key, cache_area, cache_power))
+         {
+            invokeMcPAT(cache_params, cache_area, cache_power);
+
+            char values[128];
+            snprintf(values, sizeof(values), "\t%.17g %.17g %.17g %.17g\n",
+                     cache_area->_area, cache_power->_subthreshold_leakage_power,
+                     cache_power->_gate_leakage_power, cache_power->_dynamic_energy);
+            string line = key + values;
+            if (write(fd, line.c_str(), line.length()) != (ssize_t) line.length())
+               LOG_PRINT_WARNING("McPAT Cache: Could not write to (%s)", _persistent_file.c_str());
+
+            vector<double>& entry = _persistent_map[key];
+            entry.push_back(cache_area->_area);
+            entry.push_back(cache_power->_subthreshold_leakage_power);
+            entry.push_back(cache_power->_gate_leakage_power);
+            entry.push_back(cache_power->_dynamic_energy);
+         }
+
+         flock(fd, LOCK_UN);
+         close(fd);
+      }
+   }
+
+   _cache_info_map.insert(make_pair<CacheParams*, CacheInfo>(
+            cache_params, make_pair<CacheArea*, CachePower*>(cache_area, cache_power) ) );
+
+   LOG_PRINT("runMcPAT(%p) exit", cache_params_);
+
+   return make_pair<CacheArea*,CachePower*>(cache_area, cache_power);
+}
+
+void
+McPATCache::invokeMcPAT(CacheParams* cache_params, CacheArea* cache_area, CachePower* cache_power)
+{
    UInt32 num_read_accesses = 100000;
    UInt64 total_cycles = 100000;
 
@@ -172,11 +262,103 @@ McPATCache::runMcPAT(CacheParams* cache_params_)
    ret = system((rm_cmd.str()).c_str());
    if (ret != 0)
       LOG_PRINT_ERROR("McPAT Cache: Could not delete output file (%s)", (mcpat_output_filename.str()).c_str());
+}
 
-   _cache_info_map.insert(make_pair<CacheParams*, CacheInfo>(
-            cache_params, make_pair<CacheArea*, CachePower*>(cache_area, cache_power) ) );
+string
+McPATCache::getPersistentKey(CacheParams* cache_params)
+{
+   SInt32 technology_node = Sim()->getCfg()->getInt("general/technology_node", 0);
 
-   LOG_PRINT("runMcPAT(%p) exit", cache_params_);
+   char frequency[32];
+   snprintf(frequency, sizeof(frequency), "%.6g", cache_params->_frequency);
 
-   return make_pair<CacheArea*,CachePower*>(cache_area, cache_power);
+   ostringstream key;
+   key << "mcpat=" << _mcpat_version
+       << " tech=" << technology_node
+       << " type=" << cache_params->_type
+       << " size=" << cache_params->_size
+       << " blocksize=" << cache_params->_blocksize
+       << " associativity=" << cache_params->_associativity
+       << " delay=" << cache_params->_delay
+       << " frequency=" << frequency;
+   return key.str();
+}
+
+void
+McPATCache::loadPersistent(SInt32 fd)
+{
+   string contents;
+   char buffer[4096];
+   lseek(fd, 0, SEEK_SET);
+   ssize_t num_bytes;
+   while ((num_bytes = read(fd, buffer, sizeof(buffer))) > 0)
+      contents.append(buffer, num_bytes);
+
+   // key<TAB>area subthreshold_leakage gate_leakage dynamic_energy
+   istringstream lines(contents);
+   string line;
+   while (getline(lines, line))
+   {
+      size_t tab = line.find('\t');
+      if (tab == string::npos)
+         continue;
+      istringstream values(line.substr(tab + 1));
+      vector<double> entry(4);
+      if (values >> entry[0] >> entry[1] >> entry[2] >> entry[3])
+         _persistent_map[line.substr(0, tab)] = entry;
+   }
+}
+
+bool
+McPATCache::findPersistent(const string& key, CacheArea* cache_area, CachePower* cache_power)
+{
+   PersistentMap::iterator it = _persistent_map.find(key);
+   if (it == _persistent_map.end())
+      return false;
+
+   cache_area->_area = it->second[0];
+   cache_power->_subthreshold_leakage_power = it->second[1];
+   cache_power->_gate_leakage_power = it->second[2];
+   cache_power->_dynamic_energy = it->second[3];
+   return true;
+}
+
+void
+McPATCache::precompute()
+{
+   // The frequencies the caches of this run are modeled at
+   set<float> frequencies;
+   for (UInt32 i = 0; i < Config::getSingleton()->getTotalTiles(); i++)
+      frequencies.insert(Config::getSingleton()->getCoreFrequency(Tile::getMainCoreId(i)));
+
+   string cache_sections[] = { "l1_icache", "l1_dcache", "l2_cache" };
+   for (UInt32 i = 0; i < 3; i++)
+   {
+      const config::SectionList& presets = Sim()->getCfg()->getSection(cache_sections[i]).getSubsections();
+      for (config::SectionList::const_iterator it = presets.begin(); it != presets.end(); it++)
+      {
+         string preset = cache_sections[i] + "/" + it->first;
+         UInt32 size = 0, line_size = 0, associativity = 0, access_time = 0;
+         try
+         {
+            size = Sim()->getCfg()->getInt(preset + "/cache_size");
+            line_size = Sim()->getCfg()->getInt(preset + "/cache_line_size");
+            associativity = Sim()->getCfg()->getInt(preset + "/associativity");
+            access_time = Sim()->getCfg()->getInt(preset + "/data_access_time");
+         }
+         catch (...)
+         {
+            LOG_PRINT_ERROR("Could not read the parameters of [%s] from the cfg file", preset.c_str());
+         }
+
+         // The parameters of the area and power models of a Cache
+         for (set<float>::iterator f = frequencies.begin(); f != frequencies.end(); f++)
+         {
+            CacheParams cache_params("data", k_KILO * size, line_size, associativity, access_time, *f);
+            CachePower cache_power;
+            getPower(&cache_params, &cache_power);
+         }
+         LOG_PRINT("McPAT Cache: precomputed [%s]", preset.c_str());
+      }
+   }
 }
@@ -1,8 +1,24 @@
 #pragma once
 
 #include <map>
+#include <vector>
+#include <string>
 #include "cache_info.h"
 
+/*
+  Area and power of the caches from McPAT, memoized in the process. With
+  general/McPAT_cache_file set, the results are also kept in that file and
+  shared by the runs: a line per configuration, keyed by the normalized
+  cache parameters, the technology node and the version of McPAT (size and
+  modification time of the executable and of the default input), so that
+  McPAT is only run once per configuration. The runs that share the file
+  take an exclusive lock (flock) on it while they run McPAT, and the ones
+  waiting for the same configuration find it there afterwards.
+
+  With general/McPAT_cache_precompute, the file is filled at startup for
+  every preset of the cfg ([l1_icache/<type>], [l1_dcache/<type>] and
+  [l2_cache/<type>]) at the core frequencies of the tiles.
+ */
 class McPATCache
 {
    public:
@@ -26,6 +42,19 @@ class McPATCache
       typedef std::map<CacheParams*, CacheInfo> CacheInfoMap;
       CacheInfoMap _cache_info_map;
 
+      // Persistent cache: key -> area, subthreshold and gate leakage power,
+      // dynamic energy
+      typedef std::map<std::string, std::vector<double> > PersistentMap;
+      std::string _persistent_file;
+      std::string _mcpat_version;
+      PersistentMap _persistent_map;
+
       CacheInfo findCached(CacheParams* cache_params, bool& found);
       CacheInfo runMcPAT(CacheParams* cache_params_);
+      void invokeMcPAT(CacheParams* cache_params, CacheArea* cache_area, CachePower* cache_power);
+
+      std::string getPersistentKey(CacheParams* cache_params);
+      void loadPersistent(SInt32 fd);
+      bool findPersistent(const std::string& key, CacheArea* cache_area, CachePower* cache_power);
+      void precompute();
 };
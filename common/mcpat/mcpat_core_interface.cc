@@ -1,4 +1,6 @@
 #include "mcpat_core_interface.h"
+#include "simulator.h"
+#include "stats_registry.h"
 #include "log.h"
 
 McPATCoreInterface::McPATCoreInterface(UInt32 load_buffer_size, UInt32 store_buffer_size)
@@ -172,15 +174,105 @@ void McPATCoreInterface::initializeMiscEventCounters()
    m_context_switches = 0;
 }
 
+void McPATCoreInterface::registerEventCounters(tile_id_t tile_id)
+{
+   StatsRegistry* stats = Sim()->getStatsRegistry();
+   if (!stats)
+      return;
+
+   string prefix = "Core Model/McPAT/";
+   // Instructions
+   stats->registerCounter(tile_id, prefix + "Total Instructions", &m_total_instructions);
+   stats->registerCounter(tile_id, prefix + "Integer Instructions", &m_int_instructions);
+   stats->registerCounter(tile_id, prefix + "Floating Point Instructions", &m_fp_instructions);
+   stats->registerCounter(tile_id, prefix + "Branch Instructions", &m_branch_instructions);
+   stats->registerCounter(tile_id, prefix + "Branch Mispredictions", &m_branch_mispredictions);
+   stats->registerCounter(tile_id, prefix + "Load Instructions", &m_load_instructions);
+   stats->registerCounter(tile_id, prefix + "Store Instructions", &m_store_instructions);
+   stats->registerCounter(tile_id, prefix + "Committed Instructions", &m_committed_instructions);
+   stats->registerCounter(tile_id, prefix + "Committed Integer Instructions", &m_committed_int_instructions);
+   stats->registerCounter(tile_id, prefix + "Committed Floating Point Instructions", &m_committed_fp_instructions);
+   // Cycles
+   stats->registerCounter(tile_id, prefix + "Total Cycles", &m_total_cycles);
+   stats->registerCounter(tile_id, prefix + "Idle Cycles", &m_idle_cycles);
+   stats->registerCounter(tile_id, prefix + "Busy Cycles", &m_busy_cycles);
+   // Register files
+   stats->registerCounter(tile_id, prefix + "Integer Register File Reads", &m_int_regfile_reads);
+   stats->registerCounter(tile_id, prefix + "Integer Register File Writes", &m_int_regfile_writes);
+   stats->registerCounter(tile_id, prefix + "Floating Point Register File Reads", &m_fp_regfile_reads);
+   stats->registerCounter(tile_id, prefix + "Floating Point Register File Writes", &m_fp_regfile_writes);
+   // Execution units
+   stats->registerCounter(tile_id, prefix + "ALU Accesses", &m_ialu_accesses);
+   stats->registerCounter(tile_id, prefix + "MUL Accesses", &m_mul_accesses);
+   stats->registerCounter(tile_id, prefix + "FPU Accesses", &m_fpu_accesses);
+   stats->registerCounter(tile_id, prefix + "CDB ALU Accesses", &m_cdb_alu_accesses);
+   stats->registerCounter(tile_id, prefix + "CDB MUL Accesses", &m_cdb_mul_accesses);
+   stats->registerCounter(tile_id, prefix + "CDB FPU Accesses", &m_cdb_fpu_accesses);
+   // OoO core
+   stats->registerCounter(tile_id, prefix + "Instruction Window Reads", &m_inst_window_reads);
+   stats->registerCounter(tile_id, prefix + "Instruction Window Writes", &m_inst_window_writes);
+   stats->registerCounter(tile_id, prefix + "Instruction Window Wakeup Accesses", &m_inst_window_wakeup_accesses);
+   stats->registerCounter(tile_id, prefix + "FP Instruction Window Reads", &m_fp_inst_window_reads);
+   stats->registerCounter(tile_id, prefix + "FP Instruction Window Writes", &m_fp_inst_window_writes);
+   stats->registerCounter(tile_id, prefix + "FP Instruction Window Wakeup Accesses", &m_fp_inst_window_wakeup_accesses);
+   stats->registerCounter(tile_id, prefix + "ROB Reads", &m_ROB_reads);
+   stats->registerCounter(tile_id, prefix + "ROB Writes", &m_ROB_writes);
+   stats->registerCounter(tile_id, prefix + "Rename Accesses", &m_rename_accesses);
+   stats->registerCounter(tile_id, prefix + "FP Rename Accesses", &m_fp_rename_accesses);
+   // Misc
+   stats->registerCounter(tile_id, prefix + "Function Calls", &m_function_calls);
+   stats->registerCounter(tile_id, prefix + "Context Switches", &m_context_switches);
+}
+
 void McPATCoreInterface::updateEventCounters(Instruction* instruction, UInt64 cycle_count)
 {
-   // Get Instruction Type
-   InstructionType instruction_type = getInstructionType(instruction->getOpcode());
-   updateInstructionCounters(instruction_type);
+   McPATInstructionEvents* events = instruction->getMcPATEvents();
+   if (events == NULL)
+   {
+      // Another core may have computed them meanwhile, theirs are the same
+      events = computeEvents(instruction);
+      if (!instruction->setMcPATEvents(events))
+      {
+         delete events;
+         events = instruction->getMcPATEvents();
+      }
+   }
+
+   // Update Instruction Counters
+   m_total_instructions += events->total_instructions;
+   m_committed_instructions += events->committed_instructions;
+   m_int_instructions += events->int_instructions;
+   m_fp_instructions += events->fp_instructions;
+   m_committed_fp_instructions += events->committed_fp_instructions;
+   m_branch_instructions += events->branch_instructions;
+   m_branch_mispredictions += events->branch_mispredictions;
+   m_load_instructions += events->load_instructions;
+   m_store_instructions += events->store_instructions;
+   // Update Reg File Access Counters
+   m_int_regfile_reads += events->int_regfile_reads;
+   m_int_regfile_writes += events->int_regfile_writes;
+   m_fp_regfile_reads += events->fp_regfile_reads;
+   m_fp_regfile_writes += events->fp_regfile_writes;
+   // Update Execution Unit Access Counters
+   m_ialu_accesses += events->ialu_accesses;
+   m_mul_accesses += events->mul_accesses;
+   m_fpu_accesses += events->fpu_accesses;
+   m_cdb_alu_accesses += events->ialu_accesses;
+   m_cdb_mul_accesses += events->mul_accesses;
+   m_cdb_fpu_accesses += events->fpu_accesses;
 
    // Update Cycle Counters
    updateCycleCounters(cycle_count);
-   
+}
+
+McPATInstructionEvents* McPATCoreInterface::computeEvents(Instruction* instruction)
+{
+   McPATInstructionEvents* events = new McPATInstructionEvents();
+
+   // Get Instruction Type
+   InstructionType instruction_type = getInstructionType(instruction->getOpcode());
+   updateInstructionEvents(*events, instruction_type);
+
    const OperandList& ops = instruction->getOperands();
    for (unsigned int i = 0; i < ops.size(); i++)
    {
@@ -188,13 +280,13 @@ void McPATCoreInterface::updateEventCounters(Instruction* instruction, UInt64 cy
 
       // Loads/Stores
       if ((o.m_type == Operand::MEMORY) && (o.m_direction == Operand::READ))
-         updateInstructionCounters(LOAD_INST);
+         updateInstructionEvents(*events, LOAD_INST);
       if ((o.m_type == Operand::MEMORY) && (o.m_direction == Operand::WRITE))
-         updateInstructionCounters(STORE_INST);
+         updateInstructionEvents(*events, STORE_INST);
 
       // Reg File Accesses
       if (o.m_type == Operand::REG)
-         updateRegFileAccessCounters(o.m_direction, o.m_value);
+         updateRegFileAccessEvents(*events, o.m_direction, o.m_value);
    }
 
    // Execution Unit Accesses
@@ -202,40 +294,42 @@ void McPATCoreInterface::updateEventCounters(Instruction* instruction, UInt64 cy
    // FIXME: Find out whether we need the whole instruction for this purpose
    ExecutionUnitList access_list = getExecutionUnitAccessList(instruction->getOpcode());
    for (UInt32 i = 0; i < access_list.size(); i++)
-      updateExecutionUnitAccessCounters(access_list[i]);
+      updateExecutionUnitAccessEvents(*events, access_list[i]);
+
+   return events;
 }
 
-void McPATCoreInterface::updateInstructionCounters(InstructionType instruction_type)
+void McPATCoreInterface::updateInstructionEvents(McPATInstructionEvents& events, InstructionType instruction_type)
 {
-   m_total_instructions ++;
-   m_committed_instructions ++;
+   events.total_instructions ++;
+   events.committed_instructions ++;
    
    switch (instruction_type)
    {
    case INTEGER_INST:
-      m_int_instructions ++;
-      m_committed_instructions ++;
+      events.int_instructions ++;
+      events.committed_instructions ++;
       break;
 
    case FLOATING_POINT_INST:
-      m_fp_instructions ++;
-      m_committed_fp_instructions ++;
+      events.fp_instructions ++;
+      events.committed_fp_instructions ++;
       break;
 
    case LOAD_INST:
-      m_load_instructions ++;
+      events.load_instructions ++;
       break;
 
    case STORE_INST:
-      m_store_instructions ++;
+      events.store_instructions ++;
       break;
 
    case BRANCH_INST:
-      m_branch_instructions ++;
+      events.branch_instructions ++;
       break;
 
    case BRANCH_NOT_TAKEN_INST:
-      m_branch_mispredictions ++;
+      events.branch_mispredictions ++;
       break;
 
    default:
@@ -244,25 +338,25 @@ void McPATCoreInterface::updateInstructionCounters(InstructionType instruction_t
    }
 }
 
-void McPATCoreInterface::updateRegFileAccessCounters(Operand::Direction operand_direction, UInt32 reg_id)
+void McPATCoreInterface::updateRegFileAccessEvents(McPATInstructionEvents& events, Operand::Direction operand_direction, UInt32 reg_id)
 {
    if (operand_direction == Operand::READ)
    {
       if (isIntegerReg(reg_id))
-         m_int_regfile_reads ++;
+         events.int_regfile_reads ++;
       else if (isFloatingPointReg(reg_id))
-         m_fp_regfile_reads ++;
+         events.fp_regfile_reads ++;
       else if (isXMMReg(reg_id))
-         m_fp_regfile_reads += 2;
+         events.fp_regfile_reads += 2;
    }
    else if (operand_direction == Operand::WRITE)
    {
       if (isIntegerReg(reg_id))
-         m_int_regfile_writes ++;
+         events.int_regfile_writes ++;
       else if (isFloatingPointReg(reg_id))
-         m_fp_regfile_writes ++;
+         events.fp_regfile_writes ++;
       else if (isXMMReg(reg_id))
-         m_fp_regfile_writes += 2;
+         events.fp_regfile_writes += 2;
    }
    else
    {
@@ -270,23 +364,20 @@ void McPATCoreInterface::updateRegFileAccessCounters(Operand::Direction operand_
    }
 }
 
-void McPATCoreInterface::updateExecutionUnitAccessCounters(ExecutionUnitType unit_type)
+void McPATCoreInterface::updateExecutionUnitAccessEvents(McPATInstructionEvents& events, ExecutionUnitType unit_type)
 {
    switch (unit_type)
    {
    case ALU:
-      m_ialu_accesses ++;
-      m_cdb_alu_accesses ++;
+      events.ialu_accesses ++;
       break;
 
    case MUL:
-      m_mul_accesses ++;
-      m_cdb_mul_accesses ++;
+      events.mul_accesses ++;
       break;
 
    case FPU:
-      m_fpu_accesses ++;
-      m_cdb_fpu_accesses ++;
+      events.fpu_accesses ++;
       break;
 
    default:
@@ -8,6 +8,29 @@ using std::string;
 #include "fixed_types.h"
 #include "instruction.h"
 
+// Events of one execution of an instruction. They only depend on the
+// instruction, so they are computed on its first execution and kept with it
+// (see Instruction::getMcPATEvents())
+struct McPATInstructionEvents
+{
+   UInt16 total_instructions;
+   UInt16 committed_instructions;
+   UInt16 int_instructions;
+   UInt16 fp_instructions;
+   UInt16 committed_fp_instructions;
+   UInt16 branch_instructions;
+   UInt16 branch_mispredictions;
+   UInt16 load_instructions;
+   UInt16 store_instructions;
+   UInt16 int_regfile_reads;
+   UInt16 int_regfile_writes;
+   UInt16 fp_regfile_reads;
+   UInt16 fp_regfile_writes;
+   UInt16 ialu_accesses;
+   UInt16 mul_accesses;
+   UInt16 fpu_accesses;
+};
+
 class McPATCoreInterface
 {
 public:
@@ -33,6 +56,8 @@ public:
    
    // Update Event Counters
    void updateEventCounters(Instruction* instruction, UInt64 cycle_count);
+   // Event counters of the stats file
+   void registerEventCounters(tile_id_t tile_id);
 
 private:
    // Architectural Parameters
@@ -135,10 +160,13 @@ private:
    void initializeOoOEventCounters();
    void initializeMiscEventCounters();
    
+   // Compute the events of an instruction
+   static McPATInstructionEvents* computeEvents(Instruction* instruction);
+   static void updateInstructionEvents(McPATInstructionEvents& events, InstructionType instruction_type);
+   static void updateRegFileAccessEvents(McPATInstructionEvents& events, Operand::Direction operand_direction, UInt32 reg_id);
+   static void updateExecutionUnitAccessEvents(McPATInstructionEvents& events, ExecutionUnitType unit_type);
+
    // Update Event Counters
-   void updateInstructionCounters(InstructionType instruction_type);
-   void updateRegFileAccessCounters(Operand::Direction operand_direction, UInt32 reg_id);
-   void updateExecutionUnitAccessCounters(ExecutionUnitType unit_type);
    void updateCycleCounters(UInt64 cycle_count);
 };
 
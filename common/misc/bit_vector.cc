@@ -38,68 +38,25 @@ bool BitVector::resetFind()
 
 SInt32 BitVector::find()
 {
-
-   int windex = (m_last_pos == -1) ? 0 : m_last_pos >> 6; //divide by 64
-   int word_count = (m_capacity + 64 -1)  >> 6;
+   UInt32 pos = m_last_pos + 1;
+   UInt32 windex = pos >> 6; //divide by 64
 
    //walk through bitVector one word at a time
    //return when we find a set bit (whose pos is > last_pos)
-   while (windex < word_count)
+   if (windex < VECTOR_SIZE)
    {
-
-      UInt64 word64 = m_words[windex];
-
-      if (word64 != 0)
+      UInt64 word64 = m_words[windex] & (~((UInt64) 0) << (pos & 63));
+      while (true)
       {
-
-         UInt32 words32[2];
-         words32[1] = (word64 >> 32) ;
-         words32[0] = word64 & 0xFFFFFFFF;
-
-         for (int i = 0; i < 2; i++)
+         if (word64 != 0)
          {
-            if (words32[i] != 0)
-            {
-
-               UInt16 words16[2];
-               words16[1] = (words32[i] >> 16);
-               words16[0] = words32[i] & 0xFFFF;
-
-               for (int j = 0; j < 2; j++)
-               {
-                  if (words16[j] != 0)
-                  {
-
-                     UInt8 words8[2];
-                     words8[1] = (words16[j] >> 8);
-                     words8[0] = words16[j] & 0xFF;
-
-                     for (int k = 0; k < 2; k++)
-                     {
-                        if (words8[k] != 0)
-                        {
-
-                           for (int l = 0; l < 8; l++)
-                           {
-                              //loop through byte and look for set bit
-                              if (bTestBit(words8[k], l))
-                              {
-                                 int return_pos = 64*windex + 32*i + 16*j + 8*k + l;
-                                 if (return_pos > m_last_pos)
-                                 {
-                                    m_last_pos = return_pos;
-                                    return return_pos;
-                                 }
-                              }
-                           }
-                        }
-                     }
-                  }
-               }
-            }
+            m_last_pos = 64*windex + __builtin_ctzll(word64);
+            return m_last_pos;
          }
+         if (++windex == VECTOR_SIZE)
+            break;
+         word64 = m_words[windex];
       }
-      ++windex;
    }
 
    //if we get here, there is no set bit in bitVector (after the last_pos that is)
@@ -107,6 +64,38 @@ SInt32 BitVector::find()
    return -1;
 }
 
+void BitVector::getSetBits(std::vector<SInt32>& bits)
+{
+   bits.resize(m_size);
+
+   UInt32 i = 0;
+   for (UInt32 windex = 0; windex < VECTOR_SIZE; windex++)
+   {
+      //clear the lowest set bit at every step
+      for (UInt64 word64 = m_words[windex]; word64 != 0; word64 &= (word64 - 1))
+         bits[i++] = 64*windex + __builtin_ctzll(word64);
+   }
+   assert(i == m_size);
+}
+
+SInt32 BitVector::findNth(UInt32 n)
+{
+   for (UInt32 windex = 0; windex < VECTOR_SIZE; windex++)
+   {
+      UInt64 word64 = m_words[windex];
+      UInt32 count = __builtin_popcountll(word64);
+      if (n >= count)
+      {
+         n -= count;
+         continue;
+      }
+      for ( ; n > 0; n--)
+         word64 &= (word64 - 1);
+      return 64*windex + __builtin_ctzll(word64);
+   }
+   return -1;
+}
+
 //helper function to "find", accepts a byte
 //and a bit location and returns true if bit is set
 bool BitVector::bTestBit(UInt8 byte_word, UInt32 bit)
@@ -160,14 +149,13 @@ void BitVector::clear(UInt32 bit)
    }
 }
 
-#if BITVECT_DEBUG
-
 void BitVector::set(const BitVector& vec2)
 {
    assert(m_capacity == vec2.m_capacity);
 
    for (UInt32 i = 0; i < VECTOR_SIZE; i++)
-      words[i] |= vec2.m_words[i];
+      m_words[i] |= vec2.m_words[i];
+   recomputeSize();
 }
 
 void BitVector::clear(const BitVector& vec2)
@@ -175,22 +163,29 @@ void BitVector::clear(const BitVector& vec2)
    assert(m_capacity == vec2.m_capacity);
 
    for (UInt32 i = 0; i < VECTOR_SIZE; i++)
-      words[i] &= ~vec2.m_words[i];
+      m_words[i] &= ~vec2.m_words[i];
+   recomputeSize();
 }
 
 bool BitVector::test(const BitVector& vec2)
 {
    assert(vec2.m_capacity == m_capacity);
 
+   UInt64 common = 0;
    for (UInt32 i = 0; i < VECTOR_SIZE; i++)
-   {
-      if (vec2.m_words[i] & m_words[i])
-         return true;
-   }
+      common |= (vec2.m_words[i] & m_words[i]);
 
-   return false;
+   return (common != 0);
 }
 
+void BitVector::recomputeSize()
+{
+   m_size = 0;
+   for (UInt32 i = 0; i < VECTOR_SIZE; i++)
+      m_size += __builtin_popcountll(m_words[i]);
+}
+
+#if BITVECT_DEBUG
 
 void BitVector::debug()
 {
@@ -52,9 +52,15 @@ class BitVector
       bool resetFind();
 
       //given an 8bit word, test to see if 'bit' is set
-      //this is a helper function to the "find" function
       bool bTestBit(UInt8 word, UInt32 bit);
 
+      //positions of all the set bits, in increasing order.
+      //walks the words with count-trailing-zeros and does not
+      //touch the state used by "find"
+      void getSetBits(std::vector<SInt32>& bits);
+      //position of the n-th (from 0) set bit, -1 if there are fewer set bits
+      SInt32 findNth(UInt32 n);
+
       UInt32 capacity() { return m_capacity; }
       UInt32 size() { return m_size; }
 
@@ -63,11 +69,13 @@ class BitVector
       void set(UInt32 bit);
       void clear(UInt32 bit);
 
-#ifdef BITVECT_DEBUG
+      //word-parallel operations with a vector of the same capacity
       void set(const BitVector& vec2);
       void clear(const BitVector& vec2);
       bool test(const BitVector& vec2);
-#endif
+
+   private:
+      void recomputeSize();
 
 };
 
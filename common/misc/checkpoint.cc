@@ -0,0 +1,122 @@
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+
+#include "checkpoint.h"
+#include "log.h"
+
+static const char CHECKPOINT_MAGIC[8] = { 'G', 'R', 'A', 'P', 'H', 'C', 'K', 'P' };
+static const UInt32 CHECKPOINT_VERSION = 1;
+
+// CheckpointWriter
+
+CheckpointWriter::CheckpointWriter(const std::string& filename)
+   : m_filename(filename)
+{
+   m_file = fopen(m_filename.c_str(), "wb");
+   LOG_ASSERT_ERROR(m_file, "Could not open checkpoint file(%s) for writing", m_filename.c_str());
+
+   put(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+   put<UInt32>(CHECKPOINT_VERSION);
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+   __attribute(__unused__) SInt32 err = fclose(m_file);
+   LOG_ASSERT_ERROR(err == 0, "Could not write checkpoint file(%s)", m_filename.c_str());
+}
+
+void CheckpointWriter::beginSection(const std::string& name)
+{
+   put<UInt32>(name.size());
+   put(name.c_str(), name.size());
+}
+
+void CheckpointWriter::put(const void* data, UInt32 size)
+{
+   __attribute(__unused__) size_t written = fwrite(data, 1, size, m_file);
+   LOG_ASSERT_ERROR(written == size, "Could not write checkpoint file(%s)", m_filename.c_str());
+}
+
+void CheckpointWriter::putVector(const std::vector<bool>& vec)
+{
+   put<UInt64>(vec.size());
+   for (UInt64 i = 0; i < vec.size(); i++)
+      put<UInt8>(vec[i]);
+}
+
+// CheckpointReader
+
+CheckpointReader::CheckpointReader(const std::string& filename)
+   : m_filename(filename)
+   , m_pos(0)
+{
+   SInt32 fd = open(m_filename.c_str(), O_RDONLY);
+   LOG_ASSERT_ERROR(fd >= 0, "Could not open checkpoint file(%s)", m_filename.c_str());
+
+   struct stat st;
+   __attribute(__unused__) SInt32 err = fstat(fd, &st);
+   LOG_ASSERT_ERROR(err == 0, "Could not stat checkpoint file(%s)", m_filename.c_str());
+   m_size = st.st_size;
+   LOG_ASSERT_ERROR(m_size > 0, "Empty checkpoint file(%s)", m_filename.c_str());
+
+   // Private mapping: pages stay shared with the page cache until written
+   void* addr = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   LOG_ASSERT_ERROR(addr != MAP_FAILED, "Could not map checkpoint file(%s)", m_filename.c_str());
+   close(fd);
+   m_base = (const Byte*) addr;
+
+   char magic[sizeof(CHECKPOINT_MAGIC)];
+   get(magic, sizeof(magic));
+   LOG_ASSERT_ERROR(memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) == 0,
+                    "File(%s) is not a checkpoint", m_filename.c_str());
+   UInt32 version;
+   get<UInt32>(version);
+   LOG_ASSERT_ERROR(version == CHECKPOINT_VERSION, "Checkpoint file(%s): version(%u), expected(%u)",
+                    m_filename.c_str(), version, CHECKPOINT_VERSION);
+}
+
+CheckpointReader::~CheckpointReader()
+{
+   munmap((void*) m_base, m_size);
+}
+
+void CheckpointReader::beginSection(const std::string& name)
+{
+   UInt32 length;
+   get<UInt32>(length);
+   LOG_ASSERT_ERROR(m_pos + length <= m_size, "Checkpoint file(%s) truncated", m_filename.c_str());
+   std::string saved_name((const char*) (m_base + m_pos), length);
+   m_pos += length;
+   LOG_ASSERT_ERROR(saved_name == name, "Checkpoint file(%s): found section(%s), expected(%s)",
+                    m_filename.c_str(), saved_name.c_str(), name.c_str());
+}
+
+void CheckpointReader::get(void* data, UInt32 size)
+{
+   LOG_ASSERT_ERROR(m_pos + size <= m_size, "Checkpoint file(%s) truncated", m_filename.c_str());
+   memcpy(data, m_base + m_pos, size);
+   m_pos += size;
+}
+
+void CheckpointReader::getVector(std::vector<bool>& vec)
+{
+   UInt64 size;
+   get<UInt64>(size);
+   checkSize(size, vec.size());
+   for (UInt64 i = 0; i < vec.size(); i++)
+   {
+      UInt8 value;
+      get<UInt8>(value);
+      vec[i] = value;
+   }
+}
+
+void CheckpointReader::checkSize(UInt64 saved_size, UInt64 size)
+{
+   LOG_ASSERT_ERROR(saved_size == size, "Checkpoint file(%s): saved size(%llu), expected(%llu). "
+                    "Restore with the cache and directory parameters the checkpoint was taken with",
+                    m_filename.c_str(), saved_size, size);
+}
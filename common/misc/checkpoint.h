@@ -0,0 +1,84 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+// Binary checkpoints of the simulated state. A checkpoint is written
+// sequentially and read back from a private read-only mapping of the file,
+// so the pages of the checkpoint are shared by all runs restoring from it
+// and restoring only copies what it needs out of the mapping.
+//   The layout is just the sequence of values put by the components, each
+// component starting with a named section so that mismatched checkpoints
+// are caught early.
+
+#include <string>
+#include <vector>
+#include <cstdio>
+
+#include "fixed_types.h"
+
+class CheckpointWriter
+{
+   public:
+      CheckpointWriter(const std::string& filename);
+      ~CheckpointWriter();
+
+      void beginSection(const std::string& name);
+
+      void put(const void* data, UInt32 size);
+      template<class T> void put(const T& data)
+      { put(&data, sizeof(T)); }
+      template<class T> void putVector(const std::vector<T>& vec);
+      void putVector(const std::vector<bool>& vec);
+
+      template<class T> CheckpointWriter& operator<<(const T& data)
+      { put<T>(data); return *this; }
+
+   private:
+      std::string m_filename;
+      FILE* m_file;
+};
+
+class CheckpointReader
+{
+   public:
+      CheckpointReader(const std::string& filename);
+      ~CheckpointReader();
+
+      // Checks that the next section has this name
+      void beginSection(const std::string& name);
+
+      void get(void* data, UInt32 size);
+      template<class T> void get(T& data)
+      { get(&data, sizeof(T)); }
+      // The vector must already have the size it was saved with
+      template<class T> void getVector(std::vector<T>& vec);
+      void getVector(std::vector<bool>& vec);
+
+      template<class T> CheckpointReader& operator>>(T& data)
+      { get<T>(data); return *this; }
+
+   private:
+      std::string m_filename;
+      const Byte* m_base;
+      UInt64 m_size;
+      UInt64 m_pos;
+
+      void checkSize(UInt64 saved_size, UInt64 size);
+};
+
+template<class T> void CheckpointWriter::putVector(const std::vector<T>& vec)
+{
+   put<UInt64>(vec.size());
+   if (!vec.empty())
+      put(&vec[0], vec.size() * sizeof(T));
+}
+
+template<class T> void CheckpointReader::getVector(std::vector<T>& vec)
+{
+   UInt64 size;
+   get<UInt64>(size);
+   checkSize(size, vec.size());
+   if (!vec.empty())
+      get(&vec[0], vec.size() * sizeof(T));
+}
+
+#endif
@@ -1,12 +1,118 @@
+#include <string.h>
+
 #include "checksum.h"
 #include "log.h"
 
-UInt64 computeCheckSum(const Byte* buffer, UInt32 length)
+#if defined(__x86_64__)
+#include <cpuid.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+// Reflected polynomial of CRC32C
+static const UInt32 CRC32C_POLY = 0x82f63b78;
+
+static UInt32 s_crc32c_table[256];
+
+static bool initCrc32cTable()
 {
-   UInt64 checksum = 0;
+   for (UInt32 i = 0; i < 256; i++)
+   {
+      UInt32 crc = i;
+      for (UInt32 j = 0; j < 8; j++)
+         crc = (crc & 1) ? ((crc >> 1) ^ CRC32C_POLY) : (crc >> 1);
+      s_crc32c_table[i] = crc;
+   }
+   return true;
+}
+
+static UInt32 crc32cSoftware(UInt32 crc, const Byte* buffer, UInt32 length)
+{
+   static bool initialized = initCrc32cTable();
+   (void) initialized;
+
    for (UInt32 i = 0; i < length; i++)
+      crc = s_crc32c_table[(crc ^ buffer[i]) & 0xff] ^ (crc >> 8);
+   return crc;
+}
+
+#if defined(__x86_64__)
+
+// The instructions are emitted directly, so no -msse4.2 is needed
+static UInt32 crc32cHardware(UInt32 crc, const Byte* buffer, UInt32 length)
+{
+   UInt64 crc64 = crc;
+   while (length >= sizeof(UInt64))
+   {
+      UInt64 word;
+      memcpy(&word, buffer, sizeof(word));
+      __asm__("crc32q %1, %0" : "+r" (crc64) : "rm" (word));
+      buffer += sizeof(word);
+      length -= sizeof(word);
+   }
+   UInt32 crc32 = (UInt32) crc64;
+   while (length > 0)
+   {
+      __asm__("crc32b %1, %0" : "+r" (crc32) : "rm" (*buffer));
+      buffer ++;
+      length --;
+   }
+   return crc32;
+}
+
+static bool hasCrc32cInstructions()
+{
+   UInt32 eax, ebx, ecx, edx;
+   if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+      return false;
+   return (ecx & bit_SSE4_2);
+}
+
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+
+static UInt32 crc32cHardware(UInt32 crc, const Byte* buffer, UInt32 length)
+{
+   while (length >= sizeof(UInt64))
+   {
+      UInt64 word;
+      memcpy(&word, buffer, sizeof(word));
+      crc = __crc32cd(crc, word);
+      buffer += sizeof(word);
+      length -= sizeof(word);
+   }
+   while (length > 0)
    {
-      checksum += (UInt64) buffer[i];
+      crc = __crc32cb(crc, *buffer);
+      buffer ++;
+      length --;
    }
-   return checksum;
+   return crc;
+}
+
+static bool hasCrc32cInstructions()
+{
+   return true;
+}
+
+#else
+
+static UInt32 crc32cHardware(UInt32 crc, const Byte* buffer, UInt32 length)
+{
+   return crc32cSoftware(crc, buffer, length);
+}
+
+static bool hasCrc32cInstructions()
+{
+   return false;
+}
+
+#endif
+
+UInt32 computeCrc32c(const Byte* buffer, UInt32 length)
+{
+   static bool hardware = hasCrc32cInstructions();
+
+   UInt32 crc = ~((UInt32) 0);
+   crc = hardware ? crc32cHardware(crc, buffer, length) : crc32cSoftware(crc, buffer, length);
+   return ~crc;
 }
@@ -3,6 +3,9 @@
 
 #include "fixed_types.h"
 
-UInt64 computeCheckSum(const Byte* buffer, UInt32 length);
+// CRC32C (Castagnoli) of the buffer. Uses the crc32 instructions of
+// SSE4.2 (x86-64, detected at run time) or ARMv8 (when compiled for
+// them), a table otherwise.
+UInt32 computeCrc32c(const Byte* buffer, UInt32 length);
 
 #endif // __CHECKSUM_H__
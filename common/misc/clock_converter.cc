@@ -12,3 +12,17 @@ UInt64 convertCycleCount(UInt64 cycle_count, volatile float from_frequency, vola
 
    return converted_cycle_count;
 }
+
+const UInt32 CycleCountConverter::FRACTION_BITS;
+const UInt64 CycleCountConverter::ONE;
+
+void
+CycleCountConverter::setFrequencies(volatile float from_frequency, volatile float to_frequency)
+{
+   LOG_ASSERT_ERROR((from_frequency > 0) && (to_frequency > 0),
+                    "Invalid frequencies: from_frequency(%f), to_frequency(%f)", from_frequency, to_frequency);
+   if (from_frequency == to_frequency)
+      _ratio = ONE;
+   else
+      _ratio = (UInt64) floor(((double) to_frequency / from_frequency) * ONE);
+}
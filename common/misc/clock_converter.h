@@ -5,4 +5,45 @@
 
 UInt64 convertCycleCount(UInt64 cycle_count, volatile float from_frequency, volatile float to_frequency);
 
+// Converts cycle counts between two clocks whose frequencies seldom change,
+// e.g., on every packet between the core and a network. The ratio of the
+// frequencies is computed once when they are set, as a fixed-point number
+// with FRACTION_BITS fractional bits, so that a conversion is a few integer
+// multiplications. Like convertCycleCount(), the result is rounded up.
+class CycleCountConverter
+{
+public:
+   CycleCountConverter() : _ratio(ONE) {}
+
+   void setFrequencies(volatile float from_frequency, volatile float to_frequency);
+
+   UInt64 convert(UInt64 cycle_count) const
+   {
+      UInt64 ratio = _ratio;
+      if (ratio == ONE)
+         return cycle_count;
+
+      // 64 x 64 bit product, without the low FRACTION_BITS bits
+      UInt64 cycle_count_high = cycle_count >> FRACTION_BITS;
+      UInt64 cycle_count_low = cycle_count & (ONE - 1);
+      UInt64 ratio_high = ratio >> FRACTION_BITS;
+      UInt64 ratio_low = ratio & (ONE - 1);
+      UInt64 low = cycle_count_low * ratio_low;
+      UInt64 converted_cycle_count = ((cycle_count_high * ratio_high) << FRACTION_BITS) +
+                                     (cycle_count_high * ratio_low) + (cycle_count_low * ratio_high) +
+                                     (low >> FRACTION_BITS);
+      if (low & (ONE - 1))
+         converted_cycle_count ++;
+      return converted_cycle_count;
+   }
+
+private:
+   static const UInt32 FRACTION_BITS = 32;
+   static const UInt64 ONE = ((UInt64) 1) << FRACTION_BITS;
+
+   // to_frequency / from_frequency, set from another thread than the one
+   // converting (a single aligned store)
+   volatile UInt64 _ratio;
+};
+
 #endif /* __CLOCK_CONVERTER_H__ */
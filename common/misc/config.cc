@@ -14,6 +14,10 @@
 UInt32 Config::m_knob_total_tiles;
 UInt32 Config::m_knob_num_process;
 bool Config::m_knob_simarch_has_shared_mem;
+bool Config::m_knob_caches_timing_only;
+bool Config::m_knob_memory_report;
+bool Config::m_knob_scale_memory_mode;
+bool Config::m_knob_deterministic;
 std::string Config::m_knob_output_file;
 bool Config::m_knob_enable_performance_modeling;
 bool Config::m_knob_enable_power_modeling;
@@ -35,6 +39,8 @@ Config::Config()
 {
    // NOTE: We can NOT use logging in the config constructor! The log
    // has not been instantiated at this point!
+   std::string memory_mode;
+   std::string clock_skew_minimization_scheme;
    try
    {
       m_knob_total_tiles = Sim()->getCfg()->getInt("general/total_cores");
@@ -44,6 +50,12 @@ Config::Config()
       m_knob_enable_performance_modeling = Sim()->getCfg()->getBool("general/enable_performance_modeling");
       m_knob_enable_power_modeling = Sim()->getCfg()->getBool("general/enable_power_modeling");
       m_knob_enable_area_modeling = Sim()->getCfg()->getBool("general/enable_area_modeling");
+      m_knob_caches_timing_only = Sim()->getCfg()->getBool("caching_protocol/timing_only", false);
+      m_knob_memory_report = Sim()->getCfg()->getBool("general/memory_report", false);
+      memory_mode = Sim()->getCfg()->getString("general/memory_mode", "normal");
+      m_knob_deterministic = Sim()->getCfg()->getBool("general/deterministic", false);
+      m_num_sockets = Sim()->getCfg()->getInt("socket/num_sockets", 1);
+      clock_skew_minimization_scheme = Sim()->getCfg()->getString("clock_skew_minimization/scheme");
       // WARNING: Do not change this parameter. Hard-coded until multi-threading bug is fixed
       m_knob_max_threads_per_core = 1; // Sim()->getCfg()->getInt("general/max_threads_per_core");
 
@@ -63,12 +75,46 @@ Config::Config()
 
    m_num_cores_per_tile = 1;
 
+   if ((m_num_sockets == 0) || ((m_application_tiles % m_num_sockets) != 0))
+   {
+      fprintf(stderr, "ERROR: socket/num_sockets(%u) must divide general/total_cores(%u)\n",
+              m_num_sockets, m_application_tiles);
+      exit(EXIT_FAILURE);
+   }
+
    if ((m_simulation_mode == LITE) && (m_num_processes > 1))
    {
       fprintf(stderr, "ERROR: Use only 1 process in lite mode\n");
       exit(EXIT_FAILURE);
    }
 
+   if ((memory_mode != "normal") && (memory_mode != "scale"))
+   {
+      fprintf(stderr, "ERROR: Unrecognized general/memory_mode(%s), expected normal or scale\n", memory_mode.c_str());
+      exit(EXIT_FAILURE);
+   }
+   m_knob_scale_memory_mode = (memory_mode == "scale");
+   // The caches of a scale run keep no data, unless the application reads
+   // its data from them (full mode)
+   if (m_knob_scale_memory_mode && (m_simulation_mode == LITE))
+      m_knob_caches_timing_only = true;
+
+   // The barrier quantum is the window in which the tiles run in parallel;
+   // the other schemes take host timing into their decisions
+   if (m_knob_deterministic && (clock_skew_minimization_scheme != "lax_barrier"))
+   {
+      fprintf(stderr, "ERROR: general/deterministic needs clock_skew_minimization/scheme = lax_barrier, not %s\n",
+              clock_skew_minimization_scheme.c_str());
+      exit(EXIT_FAILURE);
+   }
+
+   // In full mode, the application reads its data from the caches
+   if ((m_simulation_mode == FULL) && m_knob_caches_timing_only)
+   {
+      fprintf(stderr, "ERROR: Timing-only caches are only supported in lite mode\n");
+      exit(EXIT_FAILURE);
+   }
+
    m_singleton = this;
 
    assert(m_num_processes > 0);
@@ -194,6 +240,45 @@ void Config::GenerateTileMap()
 vector<Config::TileList>
 Config::computeProcessToTileMapping()
 {
+   // A mapping given in the cfg file (e.g. by tools/plan_process_map.py)
+   // overrides that of the network models: the process of every application
+   // tile, in the order of the tile ids
+   string tile_process_map_str;
+   try
+   {
+      tile_process_map_str = Sim()->getCfg()->getString("general/tile_process_map", "");
+   }
+   catch(...)
+   {
+      fprintf(stderr, "ERROR: Could not read general/tile_process_map from the cfg file\n");
+      exit(EXIT_FAILURE);
+   }
+   if (tile_process_map_str != "")
+   {
+      vector<string> tile_process_list;
+      parseList(tile_process_map_str, tile_process_list, ",");
+      if (tile_process_list.size() != m_application_tiles)
+      {
+         fprintf(stderr, "ERROR: general/tile_process_map has %u entries, expected one per application tile(%u)\n",
+                 (UInt32) tile_process_list.size(), m_application_tiles);
+         exit(EXIT_FAILURE);
+      }
+
+      vector<TileList> process_to_tile_mapping(m_num_processes);
+      for (UInt32 i = 0; i < m_application_tiles; i++)
+      {
+         SInt32 process_num = convertFromString<SInt32>(trimSpaces(tile_process_list[i]));
+         if ((process_num < 0) || (process_num >= (SInt32) m_num_processes))
+         {
+            fprintf(stderr, "ERROR: general/tile_process_map maps tile(%u) to process(%i), expected [0,%u)\n",
+                    i, process_num, m_num_processes);
+            exit(EXIT_FAILURE);
+         }
+         process_to_tile_mapping[process_num].push_back(i);
+      }
+      return process_to_tile_mapping;
+   }
+
    for (UInt32 i = 0; i < NUM_STATIC_NETWORKS; i++)
    {
       UInt32 network_model = NetworkModel::parseNetworkType(Config::getSingleton()->getNetworkType(i));
@@ -325,6 +410,26 @@ bool Config::getEnableAreaModeling() const
    return (bool)m_knob_enable_area_modeling;
 }
 
+bool Config::areCachesTimingOnly() const
+{
+   return (bool)m_knob_caches_timing_only;
+}
+
+bool Config::isMemoryReportEnabled() const
+{
+   return m_knob_memory_report;
+}
+
+bool Config::isScaleMemoryMode() const
+{
+   return m_knob_scale_memory_mode;
+}
+
+bool Config::isDeterministic() const
+{
+   return m_knob_deterministic;
+}
+
 std::string Config::getOutputFileName() const
 {
    return formatOutputFileName(m_knob_output_file);
@@ -121,6 +121,13 @@ public:
    UInt32 getApplicationTiles();
    bool isApplicationTile(tile_id_t tile_id);
 
+   // Sockets ([socket] num_sockets): the application tiles are split in
+   // blocks of consecutive tile ids, one per socket. The system tiles are
+   // in socket 0
+   UInt32 getNumSockets() { return m_num_sockets; }
+   UInt32 getSocketId(tile_id_t tile_id)
+   { return isApplicationTile(tile_id) ? (tile_id / (m_application_tiles / m_num_sockets)) : 0; }
+
    // Return an array of tile numbers for a given process
    //  The returned array will have numMods(proc_num) elements
    const TileList & getTileListForProcess(UInt32 proc_num)
@@ -165,6 +172,13 @@ public:
    bool getEnablePerformanceModeling() const;
    bool getEnablePowerModeling() const;
    bool getEnableAreaModeling() const;
+   bool areCachesTimingOnly() const;
+   // general/memory_report, general/memory_mode = scale
+   bool isMemoryReportEnabled() const;
+   bool isScaleMemoryMode() const;
+   // general/deterministic: the received packets and the scheduling
+   // decisions are ordered by simulated time, then tile id
+   bool isDeterministic() const;
 
    // Logging
    std::string getOutputFileName() const;
@@ -181,6 +195,7 @@ private:
    UInt32  m_num_processes;         // Total number of processes (incl myself)
    UInt32  m_total_tiles;           // Total number of tiles in all processes
    UInt32  m_application_tiles;     // Total number of tiles used by the application
+   UInt32  m_num_sockets;           // Number of sockets the application tiles are split in
    UInt32  m_num_cores_per_tile;    // Number of cores per tile
    UInt32  m_tile_id_length;        // Number of bits needed to store a tile_id
    UInt32  m_max_threads_per_core;
@@ -214,6 +229,10 @@ private:
    static bool m_knob_enable_performance_modeling;
    static bool m_knob_enable_power_modeling;
    static bool m_knob_enable_area_modeling;
+   static bool m_knob_caches_timing_only;
+   static bool m_knob_memory_report;
+   static bool m_knob_scale_memory_mode;
+   static bool m_knob_deterministic;
 
    // Get Tile & Network Parameters
    void parseCoreParameters();
@@ -1,10 +1,13 @@
 #include <stdlib.h>
+#include <string.h>
+#include <cpuid.h>
 using namespace std;
 
 #include "fxsupport.h"
 #include "tile_manager.h"
 #include "simulator.h"
 #include "tile.h"
+#include "log.h"
 
 FloatingPointHandler::FloatingPointHandler()
 {
@@ -19,16 +22,26 @@ FloatingPointHandler::~FloatingPointHandler()
 
 Fxsupport *Fxsupport::m_singleton = NULL;
 
-Fxsupport::Fxsupport(tile_id_t num_local_cores):
+Fxsupport::Fxsupport(tile_id_t num_local_cores, Mode mode):
+   m_mode(mode),
+   m_xsave_mask(0),
    m_num_local_cores(num_local_cores)
 {
+   UInt32 buf_size = 512;
+   if (m_mode == XSAVEOPT)
+   {
+      __attribute(__unused__) bool supported = getXsaveSupport(m_xsave_mask, buf_size);
+      assert(supported);
+   }
+
    m_fx_buf = (char**) malloc(m_num_local_cores * sizeof(char*));
    m_context_saved = (bool*) malloc(m_num_local_cores * sizeof(bool));
    for (int i = 0; i < m_num_local_cores; i++)
    {
-      // FIXME: I think it is not nice to hard-code these values, esp. 512
-      __attribute(__unused__) int status = posix_memalign ((void**) &m_fx_buf[i], 16, 512);
+      // The xsave area is 64-byte aligned, and its header must start zeroed
+      __attribute(__unused__) int status = posix_memalign ((void**) &m_fx_buf[i], 64, buf_size);
       assert (status == 0);
+      memset(m_fx_buf[i], 0, buf_size);
       m_context_saved[i] = false;
    }
 }
@@ -44,8 +57,68 @@ Fxsupport::~Fxsupport()
 void Fxsupport::allocate()
 {
    assert (m_singleton == NULL);
+   std::string mode = "auto";
+   try
+   {
+      mode = Sim()->getCfg()->getString("general/fp_state_save", "auto");
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read general/fp_state_save from the cfg file");
+   }
    tile_id_t num_local_cores = Sim()->getConfig()->getNumLocalTiles();
-   m_singleton = new Fxsupport(num_local_cores);
+   m_singleton = new Fxsupport(num_local_cores, parseMode(mode));
+}
+
+Fxsupport::Mode Fxsupport::parseMode(std::string mode)
+{
+   UInt64 mask;
+   UInt32 size;
+   bool xsave_supported = getXsaveSupport(mask, size);
+   if (mode == "auto")
+      return xsave_supported ? XSAVEOPT : FXSAVE;
+   else if (mode == "fxsave")
+      return FXSAVE;
+   else if (mode == "xsaveopt")
+   {
+      LOG_ASSERT_ERROR(xsave_supported, "general/fp_state_save = xsaveopt, but the host does not support it");
+      return XSAVEOPT;
+   }
+   else
+   {
+      LOG_PRINT_ERROR("Unrecognized general/fp_state_save(%s), expected auto, fxsave or xsaveopt", mode.c_str());
+      return NUM_MODES;
+   }
+}
+
+bool Fxsupport::getXsaveSupport(UInt64& mask, UInt32& size)
+{
+   unsigned int eax, ebx, ecx, edx;
+   if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+      return false;
+   // XSAVE, and enabled by the OS (OSXSAVE)
+   if (!(ecx & (1 << 26)) || !(ecx & (1 << 27)))
+      return false;
+   if (__get_cpuid_max(0, NULL) < 0xD)
+      return false;
+   __cpuid_count(0xD, 1, eax, ebx, ecx, edx);
+   if (!(eax & 1))
+      return false;
+
+   // The components the OS has enabled (XCR0), of x87, SSE and AVX
+   UInt32 xcr0_low, xcr0_high;
+   asm volatile ("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+   mask = ((((UInt64) xcr0_high) << 32) | xcr0_low) & 0x7;
+
+   // Size of the save area up to the last of these components: the legacy
+   // area and the header, then the AVX state at its offset
+   size = 512 + 64;
+   if (mask & 0x4)
+   {
+      __cpuid_count(0xD, 2, eax, ebx, ecx, edx);
+      size = ebx + eax;
+   }
+   return true;
 }
 
 void Fxsupport::release()
@@ -76,9 +149,20 @@ bool Fxsupport::fxsave()
             m_context_saved[tile_index] = true;
 
             char *buf = m_fx_buf[tile_index];
-            asm volatile ("fxsave %0\n\t"
-                          "emms"
-                          :"=m"(*buf));
+            if (m_mode == XSAVEOPT)
+            {
+               asm volatile ("xsaveopt %0\n\t"
+                             "emms"
+                             :"+m"(*buf)
+                             :"a"((UInt32) m_xsave_mask), "d"((UInt32) (m_xsave_mask >> 32))
+                             :"memory");
+            }
+            else
+            {
+               asm volatile ("fxsave %0\n\t"
+                             "emms"
+                             :"=m"(*buf));
+            }
             
             LOG_PRINT("fxsave() end");
             ret = true;
@@ -102,7 +186,16 @@ void Fxsupport::fxrstor()
          m_context_saved[tile_index] = false;
 
          char *buf = m_fx_buf[tile_index];
-         asm volatile ("fxrstor %0"::"m"(*buf));
+         if (m_mode == XSAVEOPT)
+         {
+            asm volatile ("xrstor %0"
+                          ::"m"(*buf), "a"((UInt32) m_xsave_mask), "d"((UInt32) (m_xsave_mask >> 32))
+                          :"memory");
+         }
+         else
+         {
+            asm volatile ("fxrstor %0"::"m"(*buf));
+         }
       
          LOG_PRINT("fxrstor() end");
       }
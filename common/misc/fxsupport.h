@@ -2,6 +2,7 @@
 #define FXSUPPORT_H
 
 #include <vector>
+#include <string>
 using namespace std;
 
 #include "fixed_types.h"
@@ -16,9 +17,23 @@ class FloatingPointHandler
       bool is_saved;
 };
 
+// The floating point state of the application threads is saved while they
+// run simulator code ([general] fp_state_save). fxsave saves the whole x87
+// and SSE state every time. xsaveopt (if the host supports it) also covers
+// the AVX state, and skips the components that are in their initial state
+// or have not been modified since they were last restored from the same
+// buffer, so the back-to-back sends of an application thread that does no
+// floating point in between save almost nothing.
 class Fxsupport
 {
    public:
+      enum Mode
+      {
+         FXSAVE = 0,
+         XSAVEOPT,
+         NUM_MODES
+      };
+
       static void allocate();
       static void release();
 
@@ -27,10 +42,21 @@ class Fxsupport
       bool fxsave();
       void fxrstor();
 
+      Mode getMode() const { return m_mode; }
+
    private:
-      Fxsupport(tile_id_t core_count);
+      Fxsupport(tile_id_t core_count, Mode mode);
       ~Fxsupport();
 
+      // auto is xsaveopt if the host supports it, fxsave otherwise
+      static Mode parseMode(std::string mode);
+      // XSAVEOPT is supported and enabled by the OS: the state components
+      // to save (x87, SSE, AVX) and the size of the save area
+      static bool getXsaveSupport(UInt64& mask, UInt32& size);
+
+      Mode m_mode;
+      UInt64 m_xsave_mask;
+
       // Per-thread buffers for storing fx state
       char** m_fx_buf;
       bool* m_context_saved;
@@ -75,7 +75,11 @@ void handle_args(const string_vec & args, config::ConfigFile & cfg)
             i != args.end();
             i++)
     {
-        handle_generic_arg(*i, cfg);
+        // Shorthand for --general/memory_report=true
+        if (*i == "--memory-report")
+            cfg.set("general/memory_report", "true");
+        else
+            handle_generic_arg(*i, cfg);
     }
 }
 
@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <malloc.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "host_memory.h"
+#include "log.h"
+
+// From <numaif.h>, without a dependency on libnuma
+#ifndef MPOL_DEFAULT
+#define MPOL_DEFAULT    0
+#define MPOL_PREFERRED  1
+#endif
+
+bool HostMemory::s_huge_pages_enabled = false;
+
+static const UInt64 HUGE_PAGE_SIZE = 2 << 20;
+
+UInt64 HostMemory::getHeapBytesInUse()
+{
+   // Small blocks in the arenas and the blocks mmap'ed on their own
+#if defined(__GLIBC__) && ((__GLIBC__ > 2) || ((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 33)))
+   struct mallinfo2 info = mallinfo2();
+#else
+   struct mallinfo info = mallinfo();
+#endif
+   return ((UInt64) (UInt32) info.uordblks) + ((UInt64) (UInt32) info.hblkhd);
+}
+
+UInt64 HostMemory::getResidentBytes()
+{
+   FILE* file = fopen("/proc/self/statm", "r");
+   if (file == NULL)
+      return 0;
+
+   unsigned long total_pages = 0;
+   unsigned long resident_pages = 0;
+   if (fscanf(file, "%lu %lu", &total_pages, &resident_pages) != 2)
+      resident_pages = 0;
+   fclose(file);
+   return ((UInt64) resident_pages) * sysconf(_SC_PAGESIZE);
+}
+
+UInt64 HostMemory::getPeakResidentBytes()
+{
+   FILE* file = fopen("/proc/self/status", "r");
+   if (file == NULL)
+      return 0;
+
+   UInt64 peak_resident_bytes = 0;
+   char line[256];
+   while (fgets(line, sizeof(line), file) != NULL)
+   {
+      unsigned long peak_resident_kb;
+      if ((strncmp(line, "VmHWM:", 6) == 0) && (sscanf(line + 6, "%lu", &peak_resident_kb) == 1))
+      {
+         peak_resident_bytes = ((UInt64) peak_resident_kb) * 1024;
+         break;
+      }
+   }
+   fclose(file);
+   return peak_resident_bytes;
+}
+
+void* HostMemory::allocateArray(UInt64 bytes)
+{
+   // Anonymous pages are only placed when they are first touched
+   void* array = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   LOG_ASSERT_ERROR(array != MAP_FAILED, "Could not map %llu bytes: %s", bytes, strerror(errno));
+
+#ifdef MADV_HUGEPAGE
+   if (s_huge_pages_enabled && (bytes >= HUGE_PAGE_SIZE))
+   {
+      if (madvise(array, bytes, MADV_HUGEPAGE) != 0)
+         LOG_PRINT_WARNING("Could not back %llu bytes with huge pages: %s", bytes, strerror(errno));
+   }
+#endif
+   return array;
+}
+
+void HostMemory::freeArray(void* array, UInt64 bytes)
+{
+   if (array != NULL)
+      munmap(array, bytes);
+}
+
+void HostMemory::setPreferredNode(SInt32 node)
+{
+   unsigned long node_mask = 0;
+   long err;
+   if (node < 0)
+   {
+      err = syscall(SYS_set_mempolicy, MPOL_DEFAULT, NULL, 0);
+   }
+   else
+   {
+      LOG_ASSERT_ERROR(node < (SInt32) (8 * sizeof(node_mask)), "Host NUMA node(%i) out of range", node);
+      node_mask = 1UL << node;
+      err = syscall(SYS_set_mempolicy, MPOL_PREFERRED, &node_mask, 8 * sizeof(node_mask));
+   }
+   if (err != 0)
+      LOG_PRINT_WARNING("Could not set the memory policy of the thread to node(%i): %s", node, strerror(errno));
+}
@@ -0,0 +1,34 @@
+#ifndef HOST_MEMORY_H
+#define HOST_MEMORY_H
+
+#include "fixed_types.h"
+
+// Memory used by the simulator process on the host (in bytes), for the
+// memory footprint report (general/memory_report), and placement of the
+// simulator's own data in the host memory ([host_resources])
+class HostMemory
+{
+public:
+   // Bytes allocated with malloc/new and not freed yet
+   static UInt64 getHeapBytesInUse();
+   // Resident set size, current and peak
+   static UInt64 getResidentBytes();
+   static UInt64 getPeakResidentBytes();
+
+   // Large arrays of the tiles. The pages are placed on the NUMA node of
+   // the thread that first touches them, and are backed by transparent
+   // huge pages if enabled. Zero-filled
+   static void* allocateArray(UInt64 bytes);
+   static void freeArray(void* array, UInt64 bytes);
+   static void setHugePagesEnabled(bool enabled) { s_huge_pages_enabled = enabled; }
+
+   // The pages first touched by the calling thread from now on are placed
+   // on the host NUMA node 'node' if it has free memory, -1 to go back to
+   // the default (the node of the thread)
+   static void setPreferredNode(SInt32 node);
+
+private:
+   static bool s_huge_pages_enabled;
+};
+
+#endif /* HOST_MEMORY_H */
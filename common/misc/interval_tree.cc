@@ -1,414 +1,171 @@
-#include <cassert>
 #include <stdlib.h>
+#include <string.h>
 
 #include "interval_tree.h"
 #include "utils.h"
 #include "log.h"
 
-IntervalTree::Node::Node():
-   parent(NULL),
-   left(NULL),
-   right(NULL),
-   height(0),
-   key(0),
-   interval(make_pair<UInt64,UInt64>(0,0))
-{ }
-
-IntervalTree::Node::Node(const Node& node_):
-   parent(node_.parent),
-   left(node_.left),
-   right(node_.right),
-   height(node_.height),
-   key(node_.key),
-   interval(node_.interval)
-{ }
-
-IntervalTree::Node::~Node()
-{ }
-
-void
-IntervalTree::Node::initialize(pair<UInt64,UInt64> interval_)
-{
-   parent = NULL;
-   left = NULL;
-   right = NULL;
-   height = 1;
-   key = interval_.first;
-   interval = interval_;
-}
-
-IntervalTree::IntervalTree(Node* root_tree):
-   _root_tree(root_tree),
-   _size(1)
-{ }
-
-IntervalTree::~IntervalTree()
-{
-   // inOrderTraversal();
-}
-
-void
-IntervalTree::updateChildPointer(Node* node, Node* child_node, ChildDirection child_direction)
-{
-   if (node)
-   {
-      switch (child_direction)
-      {
-         case INVALID:
-            assert(child_node);
-            if (node->key < child_node->key)
-               node->right = child_node;
-            else
-               node->left = child_node;
-            break;
-
-         case LEFT:
-            node->left = child_node;
-            break;
-
-         case RIGHT:
-            node->right = child_node;
-            break;
-
-         default:
-            LOG_PRINT_ERROR("Undefined child_direction(%u)", child_direction);
-            break;
-      }
-   }
-}
-
-void
-IntervalTree::updateParentPointer(Node* node, Node* parent_node)
+IntervalTree::IntervalTree(UInt32 max_size):
+   _max_size(max_size)
 {
-   if (node)
-      node->parent = parent_node;
-   if (parent_node == NULL)
-      _root_tree = node;
-}
+   // Room for a shift on either side of the intervals in use
+   _num_slots = ((2 * _max_size + 2 + INTERVALS_PER_BLOCK - 1) / INTERVALS_PER_BLOCK) * INTERVALS_PER_BLOCK;
+   if (posix_memalign((void**) &_intervals, 64, _num_slots * sizeof(Interval)) != 0)
+      LOG_PRINT_ERROR("Could not allocate interval tree(%u slots)", _num_slots);
 
-inline SInt32
-IntervalTree::getHeight(Node* root_subtree)
-{
-   return root_subtree ? (root_subtree->height) : 0;
+   _block_max_length = new UInt64[_num_slots / INTERVALS_PER_BLOCK];
+   for (UInt32 i = 0; i < (_num_slots / INTERVALS_PER_BLOCK); i++)
+      _block_max_length[i] = 0;
+   _begin = _num_slots / 2;
+   _end = _begin;
 }
 
-bool
-IntervalTree::heightBalanced(Node* node)
-{
-   assert(node);
-   return ( ( abs( getHeight(node->left) - getHeight(node->right) ) <= 1) ? true : false );
-}
-
-void
-IntervalTree::updateHeight(Node* node)
+IntervalTree::~IntervalTree()
 {
-   assert(node);
-   node->height = getMax<SInt32>( getHeight(node->left), getHeight(node->right) ) + 1;
+   delete [] _block_max_length;
+   free(_intervals);
 }
 
-void
-IntervalTree::performRotation(Node* y, RotationDirection rotation_direction)
+UInt32
+IntervalTree::search(UInt64 time, UInt64 length)
 {
-   LOG_PRINT("performRotation(%llu), direction(%u)", y->key, rotation_direction);
-   Node* x;
-
-   if (rotation_direction == CLOCKWISE)
-   {
-      x = y->left;
-      
-      updateParentPointer(x, y->parent);
-      updateChildPointer(x->parent, x);
+   LOG_PRINT("Search(%llu,%llu)", time, length);
 
-      y->left = x->right;
-      updateParentPointer(y->left, y);
-
-      x->right = y;
-      updateParentPointer(y, x);
-   }
-   else // rotation_direction == ANTI_CLOCKWISE
+   // The intervals that end before (time + length) can hold no part of it.
+   // Of the others, the first one contains it or is after time, so the
+   // answer is the first one that is long enough.
+   UInt32 low = 0;
+   UInt32 high = size();
+   while (low < high)
    {
-      x = y->right;
-      
-      updateParentPointer(x, y->parent);
-      updateChildPointer(x->parent, x);
-
-      y->right = x->left;
-      updateParentPointer(y->right, y);
-
-      x->left = y;
-      updateParentPointer(y, x);
-   }
-
-   // Adjust Heights - Adjust y's height first
-   updateHeight(y);
-   updateHeight(x);
-}
-
-IntervalTree::Node*
-IntervalTree::balanceHeight(Node* root_subtree)
-{
-   Node* z = root_subtree;
-
-   assert(getHeight(z->left) != getHeight(z->right));
-   Node* y = (getHeight(z->left) > getHeight(z->right)) ? z->left : z->right;
-   ChildDirection y_direction = (getHeight(z->left) > getHeight(z->right)) ? LEFT : RIGHT;
-
-   assert(y);
-
-   Node* x;
-   ChildDirection x_direction;
-   if (getHeight(y->left) != getHeight(y->right))
-   {
-      x = (getHeight(y->left) > getHeight(y->right)) ? y->left : y->right;
-      x_direction = (getHeight(y->left) > getHeight(y->right)) ? LEFT : RIGHT;
-   }
-   else if (y_direction == LEFT)
-   {
-      x = y->left;
-      x_direction = LEFT;
-   }
-   else // y->direction == RIGHT
-   {
-      x = y->right;
-      x_direction = RIGHT;
+      UInt32 middle = low + (high - low) / 2;
+      if (at(middle).end < (time + length))
+         low = middle + 1;
+      else
+         high = middle;
    }
 
-   assert(x);
-
-   // Perform single/double rotation
-   if (y_direction == LEFT)
-   {
-      if (x_direction == RIGHT)
-      {
-         performRotation(y, ANTI_CLOCKWISE);
-         performRotation(z, CLOCKWISE);
-         return x;
-      }
-      else // x_direction == LEFT
-      {
-         performRotation(z, CLOCKWISE);
-         return y;
-      }
-   }
-   else // y_direction == RIGHT
+   UInt32 slot = _begin + low;
+   while (slot < _end)
    {
-      if (x_direction == LEFT)
+      if (((slot % INTERVALS_PER_BLOCK) == 0) && (_block_max_length[slot / INTERVALS_PER_BLOCK] < length))
       {
-         performRotation(y, CLOCKWISE);
-         performRotation(z, ANTI_CLOCKWISE);
-         return x;
-      }
-      else // x_direction == RIGHT
-      {
-         performRotation(z, ANTI_CLOCKWISE);
-         return y;
+         // No interval of the block is long enough
+         slot += INTERVALS_PER_BLOCK;
+         continue;
       }
+      if ((_intervals[slot].end - _intervals[slot].start) >= length)
+         return slot - _begin;
+      slot ++;
    }
+
+   inOrderTraversal();
+   LOG_PRINT_ERROR("No interval for (%llu,%llu)", time, length);
+   return size();
 }
 
 void
-IntervalTree::rebalanceAVLTree(Node* root_subtree)
+IntervalTree::insert(UInt32 index, UInt64 start, UInt64 end)
 {
-   if (root_subtree == NULL)
-      return;
+   LOG_PRINT("Insert(%u, %llu, %llu)", index, start, end);
+   LOG_ASSERT_ERROR(size() < _max_size, "Interval tree full(%u)", size());
+   LOG_ASSERT_ERROR(index <= size(), "Index(%u) > Size(%u)", index, size());
 
-   SInt32 old_height = root_subtree->height;
-   Node* new_root_subtree = root_subtree;
+   // Move the intervals on the shorter side
+   bool move_front = (index < (size() - index));
+   if ((move_front && (_begin == 0)) || (!move_front && (_end == _num_slots)))
+      recenter();
 
-   if (!heightBalanced(root_subtree))
+   UInt32 slot;
+   if (move_front)
    {
-      // Do rotations for balancing (node)
-      new_root_subtree = balanceHeight(root_subtree);
+      memmove(&_intervals[_begin - 1], &_intervals[_begin], index * sizeof(Interval));
+      _begin --;
+      slot = _begin + index;
    }
    else
    {
-      // Update height of node to reflect changes
-      updateHeight(root_subtree);
-   }
-
-   // (node) should be height balanced by now
-   if (!heightBalanced(new_root_subtree))
-   {
-      inOrderTraversal();
-      LOG_PRINT_ERROR("Left Subtree Height(%i), Right Subtree Height(%i)", \
-         getHeight(new_root_subtree->left), getHeight(new_root_subtree->right));
-   }
-   
-   if (new_root_subtree->height != old_height)
-   {
-      // Propagate height changes up
-      rebalanceAVLTree(new_root_subtree->parent);
+      slot = _begin + index;
+      memmove(&_intervals[slot + 1], &_intervals[slot], (_end - slot) * sizeof(Interval));
+      _end ++;
    }
-}
-
-void
-IntervalTree::swap(Node* node1, Node* node2)
-{
-   Node temp_node(*node1);
-
-   node1->key = node2->key;
-   node1->interval = node2->interval;
-
-   node2->key = temp_node.key;
-   node2->interval = temp_node.interval;
-}
+   _intervals[slot].start = start;
+   _intervals[slot].end = end;
 
-IntervalTree::Node*
-IntervalTree::findMinKeyNode(Node* root_subtree)
-{
-   if (root_subtree->left)
-      return findMinKeyNode(root_subtree->left);
+   if (move_front)
+      updateBlocks(_begin, slot);
    else
-      return root_subtree;
+      updateBlocks(slot, _end - 1);
 }
 
 void
-IntervalTree::insert(Node* node)
+IntervalTree::remove(UInt32 index)
 {
-   LOG_PRINT("Insert(%llu)", node->key);
-   _size ++;
-   return insertInTree(node, _root_tree);
-}
+   LOG_PRINT("Remove(%u)", index);
+   LOG_ASSERT_ERROR(index < size(), "Index(%u) >= Size(%u)", index, size());
 
-void
-IntervalTree::insertInTree(Node* node, Node* root_subtree)
-{
-   if (node->key < root_subtree->key)
+   UInt32 slot = _begin + index;
+   if (index < (size() - 1 - index))
    {
-      if (root_subtree->left)
-      {
-         insertInTree(node, root_subtree->left);
-      }
-      else
-      {
-         root_subtree->left = node;
-         node->parent = root_subtree;
-         // Rebalance the AVL Tree
-         rebalanceAVLTree(root_subtree);
-      }
-   }
-   else if (node->key > root_subtree->key)
-   {
-      if (root_subtree->right)
-      {
-         insertInTree(node, root_subtree->right);
-      }
-      else
-      {
-         root_subtree->right = node;
-         node->parent = root_subtree;
-         // Rebalance the AVL Tree
-         rebalanceAVLTree(root_subtree);
-      }
+      memmove(&_intervals[_begin + 1], &_intervals[_begin], index * sizeof(Interval));
+      _begin ++;
+      updateBlocks(_begin - 1, slot);
    }
    else
    {
-      inOrderTraversal();
-      LOG_PRINT_ERROR("Found 2 nodes with same key(%llu)", node->key);
+      memmove(&_intervals[slot], &_intervals[slot + 1], (_end - slot - 1) * sizeof(Interval));
+      _end --;
+      updateBlocks(slot, _end);
    }
 }
 
-IntervalTree::Node*
-IntervalTree::remove(Node* node)
+void
+IntervalTree::setStart(UInt32 index, UInt64 start)
 {
-   LOG_PRINT("Remove(%llu)", node->key);
-   _size --;
-   return removeFromTree(node);
+   at(index).start = start;
+   updateBlocks(_begin + index, _begin + index);
 }
 
-IntervalTree::Node*
-IntervalTree::removeFromTree(Node* node)
-{
-   if (!node->left)
-   {
-      if (node->parent)
-         updateChildPointer(node->parent, node->right, (node->parent->key < node->key) ? RIGHT : LEFT);
-      updateParentPointer(node->right, node->parent);
-      // Rebalance the AVL Tree
-      rebalanceAVLTree(node->parent);
-
-      return node;
-   }
-   else if (!node->right)
-   {
-      updateChildPointer(node->parent, node->left);
-      updateParentPointer(node->left, node->parent);
-      // Rebalance the AVL Tree
-      rebalanceAVLTree(node->parent);
-
-      return node;
-   }
-   else // ((node->left) && (node->right))
-   {
-      // Node has both children
-      // Find Successor of node
-      Node* successor_node = findMinKeyNode(node->right);
-      __attribute(__unused__) Node* removed_node = removeFromTree(successor_node);
-      assert(removed_node == successor_node);
-
-      // Swap Node & Successor Node Parameters
-      swap(node, successor_node);
-
-      // Return the successor node
-      return successor_node;
-   }
-
-}
-
-IntervalTree::Node*
-IntervalTree::search(pair<UInt64,UInt64> interval)
+void
+IntervalTree::setEnd(UInt32 index, UInt64 end)
 {
-   LOG_PRINT("Search(%llu,%llu)", interval.first, interval.second);
-   return searchTree(interval, _root_tree);
+   at(index).end = end;
+   updateBlocks(_begin + index, _begin + index);
 }
 
-IntervalTree::Node*
-IntervalTree::searchTree(pair<UInt64,UInt64> interval, Node* root_subtree)
+void
+IntervalTree::updateBlocks(UInt32 first_slot, UInt32 last_slot)
 {
-   if (!root_subtree)
-      return NULL;
-
-   if ((interval.first >= root_subtree->interval.first) && (interval.second <= root_subtree->interval.second))
-   {
-      // Found interval in current node
-      return root_subtree;
-   }
-   
-   if (interval.second < root_subtree->interval.first)
-   {
-      // Explore left subtree
-      Node* found_node = searchTree(interval, root_subtree->left);
-      if (found_node)
-         return found_node;
-   }
-
-   if ((interval.first < root_subtree->interval.first) && \
-         ((root_subtree->interval.second - root_subtree->interval.first) >= (interval.second - interval.first)))
+   for (UInt32 block = first_slot / INTERVALS_PER_BLOCK; block <= (last_slot / INTERVALS_PER_BLOCK); block++)
    {
-      // Found interval in current node
-      return root_subtree;
+      UInt32 block_begin = getMax<UInt32>(block * INTERVALS_PER_BLOCK, _begin);
+      UInt32 block_end = getMin<UInt32>((block + 1) * INTERVALS_PER_BLOCK, _end);
+      UInt64 max_length = 0;
+      for (UInt32 slot = block_begin; slot < block_end; slot++)
+         max_length = getMax<UInt64>(max_length, _intervals[slot].end - _intervals[slot].start);
+      _block_max_length[block] = max_length;
    }
-
-   // Explore right subtree
-   return searchTree(interval, root_subtree->right);
 }
 
 void
-IntervalTree::inOrderTraversal()
+IntervalTree::recenter()
 {
-   inOrderTraversalTree(_root_tree, "");
-   fprintf(stderr, "Size(%i)\n", _size);
+   UInt32 num_intervals = size();
+   UInt32 begin = (_num_slots - num_intervals) / 2;
+   memmove(&_intervals[begin], &_intervals[_begin], num_intervals * sizeof(Interval));
+   _begin = begin;
+   _end = begin + num_intervals;
+   updateBlocks(0, _num_slots - 1);
 }
 
 void
-IntervalTree::inOrderTraversalTree(Node* root_subtree, string prefix)
+IntervalTree::inOrderTraversal()
 {
-   if (!root_subtree)
-      return;
-   inOrderTraversalTree(root_subtree->left, prefix + "LL ");
-   fprintf(stderr, "%s(%llu, %llu)\n", \
-         prefix.c_str(), \
-         (long long unsigned int) root_subtree->interval.first, \
-         (long long unsigned int) root_subtree->interval.second);
-   inOrderTraversalTree(root_subtree->right, prefix + "RR ");
+   for (UInt32 i = 0; i < size(); i++)
+   {
+      fprintf(stderr, "(%llu, %llu)\n", \
+            (long long unsigned int) at(i).start, \
+            (long long unsigned int) at(i).end);
+   }
+   fprintf(stderr, "Size(%i)\n", size());
 }
@@ -7,71 +7,57 @@ using namespace std;
 
 #include "fixed_types.h"
 
+/*
+  Set of disjoint intervals, sorted by time, for the history tree queue
+  model. The intervals are in one contiguous (cache line aligned) array,
+  four to a 64-byte block, and each block keeps the maximum length of its
+  intervals: that is the upper level of the tree, it lets a search skip
+  the blocks with no interval long enough. An interval is named by its
+  index in time order. All the memory is allocated by the constructor.
+ */
 class IntervalTree
 {
    public:
-      class Node
-      {
-         public:
-            Node();
-            Node(const Node& node_);
-            ~Node();
+      IntervalTree(UInt32 max_size);
+      ~IntervalTree();
 
-            void initialize(pair<UInt64,UInt64> interval_);
+      // Index of the first interval that contains [time, time + length) or,
+      // if none does, of the first one after time of at least length
+      UInt32 search(UInt64 time, UInt64 length);
 
-            Node* parent;
-            Node* left;
-            Node* right;
-            SInt32 height;
-            UInt64 key;
-            pair<UInt64,UInt64> interval;
-      };
+      void insert(UInt32 index, UInt64 start, UInt64 end);
+      void remove(UInt32 index);
 
-      IntervalTree(Node* root_tree);
-      ~IntervalTree();
+      UInt64 getStart(UInt32 index) { return at(index).start; }
+      UInt64 getEnd(UInt32 index) { return at(index).end; }
+      void setStart(UInt32 index, UInt64 start);
+      void setEnd(UInt32 index, UInt64 end);
 
-      void insert(Node* node);
-      Node* remove(Node* node);
-      Node* search(pair<UInt64,UInt64> interval);
-      UInt32 size() { return _size; }
+      UInt32 size() { return _end - _begin; }
       void inOrderTraversal();
 
    private:
-      
-      enum RotationDirection
+      struct Interval
       {
-         CLOCKWISE = 0,
-         ANTI_CLOCKWISE,
-         NUM_ROTATION_DIRECTIONS
+         UInt64 start;
+         UInt64 end;
       };
-      enum ChildDirection
-      {
-         INVALID = 0,
-         LEFT,
-         RIGHT,
-         NUM_CHILD_DIRECTIONS = 2
-      };
-
-      void insertInTree(Node* node, Node* root_subtree);
-      Node* removeFromTree(Node* node);
-      Node* searchTree(pair<UInt64,UInt64> interval, Node* root_subtree);
 
-      void rebalanceAVLTree(Node* root_subtree);
-      Node* balanceHeight(Node* root_subtree);
-      void performRotation(Node* y, RotationDirection rotation_direction);
+      static const UInt32 INTERVALS_PER_BLOCK = 4;
 
-      void updateHeight(Node* node);
-      bool heightBalanced(Node* node);
-      inline SInt32 getHeight(Node* root_subtree);
+      Interval& at(UInt32 index) { return _intervals[_begin + index]; }
 
-      void updateChildPointer(Node* node, Node* child_node, ChildDirection child_direction = INVALID);
-      void updateParentPointer(Node* node, Node* parent_node);
+      void updateBlocks(UInt32 first_slot, UInt32 last_slot);
+      void recenter();
 
-      void swap(Node* node1, Node* node2);
-      Node* findMinKeyNode(Node* root_subtree);
+      UInt32 _max_size;
 
-      void inOrderTraversalTree(Node* root_subtree, string prefix);
+      // Slots [_begin, _end) of _intervals are in use
+      Interval* _intervals;
+      UInt32 _num_slots;
+      UInt32 _begin;
+      UInt32 _end;
 
-      Node* _root_tree;
-      UInt32 _size;
+      // Maximum length of the intervals in use of each block
+      UInt64* _block_max_length;
 };
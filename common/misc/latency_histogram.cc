@@ -0,0 +1,76 @@
+#include "latency_histogram.h"
+#include "log.h"
+
+LatencyHistogram::LatencyHistogram()
+{
+   clear();
+}
+
+LatencyHistogram::~LatencyHistogram()
+{}
+
+void
+LatencyHistogram::clear()
+{
+   for (UInt32 i = 0; i < NUM_BUCKETS; i++)
+      _counts[i] = 0;
+   _total_count = 0;
+}
+
+void
+LatencyHistogram::merge(const LatencyHistogram& histogram)
+{
+   UInt64 total_count = 0;
+   for (UInt32 i = 0; i < NUM_BUCKETS; i++)
+   {
+      UInt64 count = histogram._counts[i];
+      _counts[i] += count;
+      total_count += count;
+   }
+   // Sum the buckets instead of reading _total_count so that the
+   // result is consistent even if the histogram is being written
+   _total_count += total_count;
+}
+
+void
+LatencyHistogram::subtract(const LatencyHistogram& histogram)
+{
+   for (UInt32 i = 0; i < NUM_BUCKETS; i++)
+   {
+      LOG_ASSERT_ERROR(_counts[i] >= histogram._counts[i], "Bucket(%u): count(%llu) < subtracted count(%llu)",
+                       i, _counts[i], histogram._counts[i]);
+      _counts[i] -= histogram._counts[i];
+   }
+   _total_count -= histogram._total_count;
+}
+
+UInt64
+LatencyHistogram::getBucketHighestValue(UInt32 bucket)
+{
+   if (bucket < 2 * NUM_SUB_BUCKETS)
+      return bucket;
+   UInt32 shift = (bucket / NUM_SUB_BUCKETS) - 1;
+   UInt64 lowest_value = ((UInt64) (NUM_SUB_BUCKETS + (bucket % NUM_SUB_BUCKETS))) << shift;
+   return lowest_value + ((1ULL << shift) - 1);
+}
+
+UInt64
+LatencyHistogram::getPercentile(double percentile) const
+{
+   if (_total_count == 0)
+      return 0;
+
+   // Number of samples at or below the percentile
+   UInt64 target_count = (UInt64) ((percentile / 100.0) * _total_count + 0.5);
+   if (target_count == 0)
+      target_count = 1;
+
+   UInt64 running_count = 0;
+   for (UInt32 i = 0; i < NUM_BUCKETS; i++)
+   {
+      running_count += _counts[i];
+      if (running_count >= target_count)
+         return getBucketHighestValue(i);
+   }
+   return getBucketHighestValue(NUM_BUCKETS - 1);
+}
@@ -0,0 +1,56 @@
+#ifndef __LATENCY_HISTOGRAM_H__
+#define __LATENCY_HISTOGRAM_H__
+
+#include "fixed_types.h"
+
+// Fixed-size log-linear histogram of latencies (HDR style).
+// Values below 2 * NUM_SUB_BUCKETS are recorded exactly, larger values
+// fall into one of NUM_SUB_BUCKETS buckets per power of 2, i.e., with a
+// relative error below 1 / NUM_SUB_BUCKETS. Values of 2^MAX_VALUE_BITS
+// and above are recorded in the last bucket.
+//
+// add() takes no lock and allocates nothing. It must have a single
+// writer; readers running concurrently see a slightly stale snapshot.
+
+class LatencyHistogram
+{
+public:
+   LatencyHistogram();
+   ~LatencyHistogram();
+
+   void add(UInt64 value)
+   {
+      _counts[getBucket(value)] ++;
+      _total_count ++;
+   }
+
+   void clear();
+   void merge(const LatencyHistogram& histogram);
+   void subtract(const LatencyHistogram& histogram);
+
+   UInt64 getCount() const { return _total_count; }
+   // Highest value equivalent to the given percentile (0 < percentile <= 100)
+   UInt64 getPercentile(double percentile) const;
+
+private:
+   static const UInt32 SUB_BUCKET_BITS = 4;
+   static const UInt32 NUM_SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+   static const UInt32 MAX_VALUE_BITS = 40;
+   static const UInt32 NUM_BUCKETS = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * NUM_SUB_BUCKETS;
+
+   static UInt32 getBucket(UInt64 value)
+   {
+      if (value < 2 * NUM_SUB_BUCKETS)
+         return value;
+      if (value >> MAX_VALUE_BITS)
+         return NUM_BUCKETS - 1;
+      UInt32 shift = (63 - __builtin_clzll(value)) - SUB_BUCKET_BITS;
+      return (shift + 1) * NUM_SUB_BUCKETS + ((value >> shift) - NUM_SUB_BUCKETS);
+   }
+   static UInt64 getBucketHighestValue(UInt32 bucket);
+
+   volatile UInt64 _counts[NUM_BUCKETS];
+   volatile UInt64 _total_count;
+};
+
+#endif /* __LATENCY_HISTOGRAM_H__ */
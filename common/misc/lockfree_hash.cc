@@ -1,38 +1,315 @@
+#include <assert.h>
+#include <iostream>
+
 #include "lockfree_hash.h"
+#include "utils.h"
 
 using namespace std;
 
+const UInt64 LockFreeHash::EMPTY_KEY;
+const UInt64 LockFreeHash::CLOSED_KEY;
+const UInt64 LockFreeHash::EMPTY_VALUE;
+const UInt64 LockFreeHash::TOMBSTONE;
+const UInt64 LockFreeHash::MOVED;
 
-LockFreeHash::LockFreeHash(UInt64 size) : BasicHash::BasicHash(size)
+LockFreeHash::Table::Table(UInt64 capacity_):
+   capacity(capacity_),
+   mask(capacity_ - 1),
+   shift(64 - floorLog2(capacity_)),
+   reprobe_limit(10 + capacity_ / 4),
+   num_keys(0),
+   copy_index(0),
+   num_copied(0),
+   next(NULL)
 {
+   assert(isPower2(capacity));
+   slots = new Slot[capacity];
+   for (UInt64 i = 0; i < capacity; i++)
+   {
+      slots[i].key = EMPTY_KEY;
+      slots[i].value = EMPTY_VALUE;
+   }
 }
 
-LockFreeHash::~LockFreeHash()
+LockFreeHash::Table::~Table()
+{
+   delete [] slots;
+}
+
+LockFreeHash::LockFreeHash(UInt64 size):
+   _num_entries(0)
 {
+   UInt64 capacity = 16;
+   while (capacity < (2 * size))
+      capacity <<= 1;
+   _table = new Table(capacity);
+   _first_table = _table;
 }
 
+LockFreeHash::~LockFreeHash()
+{
+   Table* table = _first_table;
+   while (table)
+   {
+      Table* next = table->next;
+      delete table;
+      table = next;
+   }
+}
 
-UInt64 LockFreeHash::bucket_size(UInt64 key)
+UInt64 LockFreeHash::encode(UInt64 value)
 {
-   UInt64 index = key % size;
-   Bucket& bucket = array[index];
-   return bucket.size();
+   // The 3 top bits must be the same
+   assert(decode(value & VALUE_MASK) == value);
+   return value & VALUE_MASK;
 }
 
 pair<bool, UInt64> LockFreeHash::find(UInt64 key)
 {
-   pair<bool, UInt64> res = BasicHash::find(key);
-   assert(bucket_size(key) <= 1);
+   assert((key != EMPTY_KEY) && (key != CLOSED_KEY));
+
+   for (Table* table = _table; table != NULL; table = table->next)
+   {
+      UInt64 index = table->getIndex(key);
+      for (UInt64 reprobes = 0; reprobes < table->reprobe_limit; reprobes++)
+      {
+         Slot& slot = table->slots[index];
+         UInt64 slot_key = slot.key;
+         if (slot_key == key)
+         {
+            UInt64 stored_value = slot.value;
+            if (isValue(stored_value))
+               return make_pair(true, decode(stored_value));
+            if ((stored_value == EMPTY_VALUE) || (stored_value == TOMBSTONE))
+               return make_pair(false, ~0);
 
-   return res;
+            // Being moved, or moved: the value is in the next table
+            copySlot(table, index);
+            break;
+         }
+         // A key is never past a slot that was free when it was inserted
+         if ((slot_key == EMPTY_KEY) || (slot_key == CLOSED_KEY))
+            break;
+         index = (index + 1) & table->mask;
+      }
+   }
+   return make_pair(false, ~0);
 }
 
 bool LockFreeHash::insert(UInt64 key, UInt64 value)
 {
-   bool res = BasicHash::insert(key, value);
-   assert(bucket_size(key) <= 1);
+   assert((key != EMPTY_KEY) && (key != CLOSED_KEY));
+   return apply(_table, key, encode(value), INSERT);
+}
+
+bool LockFreeHash::update(UInt64 key, UInt64 value)
+{
+   assert((key != EMPTY_KEY) && (key != CLOSED_KEY));
+   return apply(_table, key, encode(value), UPDATE);
+}
+
+bool LockFreeHash::erase(UInt64 key)
+{
+   assert((key != EMPTY_KEY) && (key != CLOSED_KEY));
+   return apply(_table, key, TOMBSTONE, ERASE);
+}
+
+bool LockFreeHash::apply(Table* table, UInt64 key, UInt64 stored_value, Operation operation)
+{
+   bool claims_slot = ((operation == INSERT) || (operation == COPY));
+
+   while (true)
+   {
+      // Find the slot of the key, claim a free one if inserting
+      UInt64 index = table->getIndex(key);
+      UInt64 reprobes = 0;
+      bool found = false;
+      while (true)
+      {
+         Slot& slot = table->slots[index];
+         UInt64 slot_key = slot.key;
+         if (slot_key == EMPTY_KEY)
+         {
+            // No new key in a table that is being moved
+            if (!claims_slot || table->next)
+               break;
+            slot_key = __sync_val_compare_and_swap(&slot.key, EMPTY_KEY, key);
+            if (slot_key == EMPTY_KEY)
+            {
+               slot_key = key;
+               if (__sync_add_and_fetch(&table->num_keys, 1) >= ((table->capacity / 4) * 3))
+                  resize(table);
+            }
+         }
+         if (slot_key == key)
+         {
+            found = true;
+            break;
+         }
+         if (slot_key == CLOSED_KEY)
+            break;
+         if (++reprobes >= table->reprobe_limit)
+         {
+            if (claims_slot)
+               resize(table);
+            break;
+         }
+         index = (index + 1) & table->mask;
+      }
+
+      if (!found)
+      {
+         if (table->next == NULL)
+         {
+            // Only an update or an erase of an absent key gets here
+            assert(!claims_slot);
+            return false;
+         }
+         helpCopy(table);
+         table = table->next;
+         continue;
+      }
+
+      // Once a new table is there, the key is moved before it is changed
+      Slot& slot = table->slots[index];
+      while (table->next == NULL)
+      {
+         UInt64 old_value = slot.value;
+         if ((old_value == MOVED) || isPrimed(old_value))
+            break;
+
+         bool present = isValue(old_value);
+         switch (operation)
+         {
+         case INSERT:
+            if (present)
+               return false;
+            break;
+         case UPDATE:
+         case ERASE:
+            if (!present)
+               return false;
+            break;
+         case COPY:
+            if (old_value != EMPTY_VALUE)
+               return false;
+            break;
+         default:
+            assert(false);
+            break;
+         }
+
+         if (__sync_val_compare_and_swap(&slot.value, old_value, stored_value) == old_value)
+         {
+            if (operation == INSERT)
+               __sync_fetch_and_add(&_num_entries, 1);
+            else if (operation == ERASE)
+               __sync_fetch_and_sub(&_num_entries, 1);
+            return true;
+         }
+      }
+
+      copySlot(table, index);
+      helpCopy(table);
+      table = table->next;
+   }
+}
+
+void LockFreeHash::resize(Table* table)
+{
+   if (table->next)
+      return;
+
+   // Twice the capacity if the entries take at least half the slots after
+   // the last resize; else only drop the tombstones
+   UInt64 capacity = table->capacity;
+   while (capacity < (4 * getNumEntries()))
+      capacity <<= 1;
+
+   Table* new_table = new Table(capacity);
+   if (__sync_val_compare_and_swap(&table->next, (Table*) NULL, new_table) != NULL)
+      delete new_table;
+}
+
+void LockFreeHash::helpCopy(Table* table)
+{
+   if (table->copy_index >= table->capacity)
+      return;
+
+   UInt64 first = __sync_fetch_and_add(&table->copy_index, COPY_CHUNK);
+   UInt64 last = getMin<UInt64>(first + COPY_CHUNK, table->capacity);
+   for (UInt64 index = first; index < last; index++)
+      copySlot(table, index);
+}
+
+void LockFreeHash::copySlot(Table* table, UInt64 index)
+{
+   Slot& slot = table->slots[index];
 
-   return res;
+   UInt64 slot_key = slot.key;
+   if (slot_key == EMPTY_KEY)
+   {
+      // Close the slot so that no key is inserted in it
+      slot_key = __sync_val_compare_and_swap(&slot.key, EMPTY_KEY, CLOSED_KEY);
+      if (slot_key == EMPTY_KEY)
+      {
+         slotCopied(table);
+         return;
+      }
+   }
+   if (slot_key == CLOSED_KEY)
+      return;
+
+   while (true)
+   {
+      UInt64 old_value = slot.value;
+      if (old_value == MOVED)
+         return;
+
+      if ((old_value == EMPTY_VALUE) || (old_value == TOMBSTONE))
+      {
+         // Nothing to copy
+         if (__sync_val_compare_and_swap(&slot.value, old_value, MOVED) == old_value)
+         {
+            slotCopied(table);
+            return;
+         }
+         continue;
+      }
+
+      if (isValue(old_value))
+      {
+         // Prime the value: it cannot change any more
+         UInt64 primed_value = old_value | PRIME_BIT;
+         if (__sync_val_compare_and_swap(&slot.value, old_value, primed_value) != old_value)
+            continue;
+         old_value = primed_value;
+      }
+
+      // Copy the value unless the key already has one in the next table
+      // (every thread moving this slot copies the same value)
+      apply(table->next, slot_key, old_value & VALUE_MASK, COPY);
+      if (__sync_val_compare_and_swap(&slot.value, old_value, MOVED) == old_value)
+         slotCopied(table);
+      return;
+   }
+}
+
+void LockFreeHash::slotCopied(Table* table)
+{
+   if (__sync_add_and_fetch(&table->num_copied, 1) == table->capacity)
+      promote();
+}
+
+void LockFreeHash::promote()
+{
+   // Move on from the tables that are all copied, in order
+   Table* table = _table;
+   while (table->next && (table->num_copied == table->capacity))
+   {
+      __sync_bool_compare_and_swap(&_table, table, table->next);
+      table = _table;
+   }
 }
 
 
@@ -40,22 +317,33 @@ bool LockFreeHash::insert(UInt64 key, UInt64 value)
 
 int main(int argc, char* argv[])
 {
-   LockFreeHash hash(100);
-   UInt64 ids[4] = {1001, 1050, 1011, 1099};
-
-   for (int i = 0; i < 4; i++)
-      hash.insert(ids[i], i);
+   LockFreeHash hash(4);
+   UInt64 num_keys = 1000;
 
-   for (int i = 3; i >= 0; i--)
-      assert(hash.find(ids[i]).first == true);
+   for (UInt64 i = 0; i < num_keys; i++)
+      assert(hash.insert(i * 7919, i));
+   assert(!hash.insert(0, 1));
    cerr << "Test 1 passed" << endl;
 
+   for (UInt64 i = 0; i < num_keys; i++)
+      assert(hash.find(i * 7919) == make_pair(true, i));
+   assert(!hash.find(1).first);
+   cerr << "Test 2 passed" << endl;
 
-   cerr << "Test 2 should fail in assertion" << endl;
-   ids[3] = ids[0] + 100;
-
-   for (int i = 0; i < 4; i++)
-      hash.insert(ids[i], i);
+   for (UInt64 i = 0; i < num_keys; i += 2)
+      assert(hash.erase(i * 7919));
+   for (UInt64 i = 1; i < num_keys; i += 2)
+      assert(hash.update(i * 7919, (UInt64) -1));
+   for (UInt64 i = 0; i < num_keys; i++)
+   {
+      pair<bool, UInt64> res = hash.find(i * 7919);
+      assert(res.first == ((i % 2) == 1));
+      assert(!res.first || (res.second == (UInt64) -1));
+   }
+   assert(hash.size() == (num_keys / 2));
+   hash.insert(0, 0);
+   assert(hash.find(0) == make_pair(true, (UInt64) 0));
+   cerr << "Test 3 passed" << endl;
 
    cerr << "All tests passed" << endl;
 
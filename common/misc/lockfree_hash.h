@@ -1,27 +1,117 @@
 #ifndef LOCKFREE_HASH_H
 #define LOCKFREE_HASH_H
 
-#include <map>
 #include <utility>
-#include <iostream>
-#include <assert.h>
-#include "basic_hash.h"
 #include "fixed_types.h"
 
 //#define DEBUG_LOCKFREE_HASH
 
+/*
+  Lock-free hash map from UInt64 keys to values that fit in 62 bits, sign
+  extended (pointers and integers, negative ones included). The table is
+  open addressed with linear probing. A key keeps its slot once it has
+  one; erasing it leaves a tombstone in place of the value, and a later
+  insert of the same key reuses the slot.
 
-class LockFreeHash : private BasicHash
-{
-   private:
-      UInt64 bucket_size(UInt64 key);
+  To grow, or to get rid of the tombstones, a new table is chained to the
+  current one. The slots are then moved to it one at a time, by the
+  threads that insert, update or erase, which each copy a chunk of slots.
+  Moving a slot first marks its value as being copied (primed), then puts
+  the value in the new table, then marks the slot as moved. Any thread
+  that meets a primed or moved value finishes the move and goes on in the
+  new table. When all the slots of a table are moved, the new one becomes
+  the current table. A find never waits or writes unless it meets a slot
+  being moved.
 
+  There is no safe point to free a table that a thread may still read, so
+  the old tables are freed with the map.
+ */
+class LockFreeHash
+{
    public:
       LockFreeHash(UInt64 size);
       ~LockFreeHash();
 
       std::pair<bool, UInt64> find(UInt64 key);
+      // Inserts if the key is absent, returns false if it is present
       bool insert(UInt64 key, UInt64 value);
+      // Replaces the value of a present key, returns false if it is absent
+      bool update(UInt64 key, UInt64 value);
+      // Returns false if the key is absent
+      bool erase(UInt64 key);
+
+      UInt64 size() { return getNumEntries(); }
+
+   private:
+      enum Operation
+      {
+         INSERT = 0,
+         UPDATE,
+         ERASE,
+         COPY        // Inserts a moved value only if the key never had one
+      };
+
+      struct Slot
+      {
+         volatile UInt64 key;
+         volatile UInt64 value;
+      };
+
+      struct Table
+      {
+         Table(UInt64 capacity_);
+         ~Table();
+
+         UInt64 getIndex(UInt64 key) { return (key * 0x9E3779B97F4A7C15ULL) >> shift; }
+
+         UInt64 capacity;
+         UInt64 mask;
+         UInt32 shift;
+         UInt64 reprobe_limit;
+         Slot* slots;
+         // Slots with a key
+         volatile UInt64 num_keys;
+         // Resizing: first slot not given to a copier yet, number of slots moved
+         volatile UInt64 copy_index;
+         volatile UInt64 num_copied;
+         Table* volatile next;
+      };
+
+      // Keys no one can use: a slot never used, a slot closed by a resize
+      static const UInt64 EMPTY_KEY = ~0ULL;
+      static const UInt64 CLOSED_KEY = ~0ULL - 1;
+
+      // The 2 top bits of a stored value tell what it is: 0 for a value,
+      // 1 for a value being moved (primed), 2 for the states below
+      static const UInt32 KIND_SHIFT = 62;
+      static const UInt64 VALUE_MASK = (1ULL << KIND_SHIFT) - 1;
+      static const UInt64 PRIME_BIT = 1ULL << KIND_SHIFT;
+      static const UInt64 EMPTY_VALUE = (2ULL << KIND_SHIFT) | 0;    // Never had a value
+      static const UInt64 TOMBSTONE = (2ULL << KIND_SHIFT) | 1;      // Erased
+      static const UInt64 MOVED = (2ULL << KIND_SHIFT) | 2;          // In the next table
+
+      static const UInt64 COPY_CHUNK = 16;
+
+      static UInt64 encode(UInt64 value);
+      static UInt64 decode(UInt64 stored_value) { return (UInt64) (((SInt64) (stored_value << 2)) >> 2); }
+      static bool isValue(UInt64 stored_value) { return (stored_value >> KIND_SHIFT) == 0; }
+      static bool isPrimed(UInt64 stored_value) { return (stored_value >> KIND_SHIFT) == 1; }
+
+      bool apply(Table* table, UInt64 key, UInt64 stored_value, Operation operation);
+
+      void resize(Table* table);
+      void helpCopy(Table* table);
+      void copySlot(Table* table, UInt64 index);
+      void slotCopied(Table* table);
+      void promote();
+
+      // An erase may count before the insert it follows
+      UInt64 getNumEntries() { SInt64 num_entries = _num_entries; return (num_entries > 0) ? num_entries : 0; }
+
+      Table* volatile _table;
+      // All the tables, oldest first (Table::next)
+      Table* _first_table;
+      volatile SInt64 _num_entries;
 };
 
 #endif
@@ -2,17 +2,21 @@
 #include <sys/syscall.h>
 #include <stdarg.h>
 #include <string.h>
+#include <ctype.h>
 
 #include "log.h"
 #include "config.h"
 #include "simulator.h"
 #include "tile_manager.h"
+#include "tls.h"
+#include "utils.h"
 
 using namespace std;
 
 Log *Log::_singleton;
 
 const size_t Log::MODULE_LENGTH;
+const UInt32 Log::BINARY_VERSION;
 
 static string formatFileName(const char* s)
 {
@@ -30,6 +34,7 @@ Log::Log(Config &config)
    getDisabledModules();
 
    _loggingEnabled = initIsLoggingEnabled();
+   initFormat();
 
    assert(_singleton == NULL);
    _singleton = this;
@@ -39,6 +44,15 @@ Log::~Log()
 {
    _singleton = NULL;
 
+   for (std::vector<ThreadBuffer*>::iterator it = _allThreadBuffers.begin(); it != _allThreadBuffers.end(); it++)
+   {
+      flush(*it);
+      fclose((*it)->file);
+      delete [] (*it)->data;
+      delete *it;
+   }
+   delete _threadBuffers;
+
    for (tile_id_t i = 0; i < _tileCount; i++)
    {
       if (_tileFiles[i])
@@ -63,8 +77,9 @@ Log* Log::getSingleton()
    return _singleton;
 }
 
-bool Log::isEnabled(const char* module)
+bool Log::isEnabled(const char* source_file)
 {
+   string module = getModule(source_file);
    // either the module is specifically enabled, or all logging is
    // enabled and this one isn't disabled
    return _enabledModules.find(module) != _enabledModules.end()
@@ -173,6 +188,33 @@ bool Log::initIsLoggingEnabled()
    }
 }
 
+void Log::initFormat()
+{
+   string format;
+   try
+   {
+      format = Sim()->getCfg()->getString("log/format", "text");
+      _bufferSize = Sim()->getCfg()->getInt("log/buffer_size", 65536);
+   }
+   catch (...)
+   {
+      assert(false);
+   }
+
+   if (format == "text")
+      _format = TEXT;
+   else if (format == "binary")
+      _format = BINARY;
+   else
+   {
+      fprintf(stderr, "Unrecognized log/format(%s), must be text or binary\n", format.c_str());
+      abort();
+   }
+   assert(_bufferSize > 0);
+
+   _threadBuffers = TLS::create();
+}
+
 UInt64 Log::getTimestamp()
 {
    timeval t;
@@ -304,24 +346,37 @@ void Log::log(ErrorState err, const char* source_file, SInt32 source_line, const
    tile_id_t tile_id;
    bool sim_thread;
    discoverCore(&tile_id, &sim_thread);
-   
+
+   va_list args;
+   va_start(args, format);
+   // The warnings and errors also go to stderr, they are not deferred
+   if ((_format == BINARY) && (err == None))
+      logBinary(tile_id, sim_thread, source_file, source_line, format, args);
+   else
+      logText(err, tile_id, sim_thread, source_file, source_line, format, args);
+   va_end(args);
+}
+
+void Log::logText(ErrorState err, tile_id_t tile_id, bool sim_thread,
+                  const char* source_file, SInt32 source_line, const char *format, va_list args)
+{
    FILE *file;
    Lock *lock;
 
    getFile(tile_id, sim_thread, &file, &lock);
    int tid = syscall(__NR_gettid);
-
+   string module = getModule(source_file);
 
    char message[512];
    char *p = message;
 
    // This is ugly, but it just prints the time stamp, process number, tile number, source file/line
    if (tile_id != INVALID_TILE_ID) // valid tile id
-      p += sprintf(p, "%-10llu [%5d]  (%2i) [%2i]%s[%s:%4d]  ", (long long unsigned int) getTimestamp(), tid, Config::getSingleton()->getCurrentProcessNum(), tile_id, (sim_thread ? "* " : "  "), source_file, source_line);
+      p += sprintf(p, "%-10llu [%5d]  (%2i) [%2i]%s[%s:%4d]  ", (long long unsigned int) getTimestamp(), tid, Config::getSingleton()->getCurrentProcessNum(), tile_id, (sim_thread ? "* " : "  "), module.c_str(), source_line);
    else if (Config::getSingleton()->getCurrentProcessNum() != (UInt32)-1) // valid proc id
-      p += sprintf(p, "%-10llu [%5d]  (%2i) [  ]  [%s:%4d]  ", (long long unsigned int) getTimestamp(), tid, Config::getSingleton()->getCurrentProcessNum(), source_file, source_line);
+      p += sprintf(p, "%-10llu [%5d]  (%2i) [  ]  [%s:%4d]  ", (long long unsigned int) getTimestamp(), tid, Config::getSingleton()->getCurrentProcessNum(), module.c_str(), source_line);
    else // who knows
-      p += sprintf(p, "%-10llu [%5d]  (  ) [  ]  [%s:%4d]  ", (long long unsigned int) getTimestamp(), tid, source_file, source_line);
+      p += sprintf(p, "%-10llu [%5d]  (  ) [  ]  [%s:%4d]  ", (long long unsigned int) getTimestamp(), tid, module.c_str(), source_line);
 
    switch (err)
    {
@@ -338,10 +393,7 @@ void Log::log(ErrorState err, const char* source_file, SInt32 source_line, const
       break;
    };
 
-   va_list args;
-   va_start(args, format);
    p += vsprintf(p, format, args);
-   va_end(args);
 
    p += sprintf(p, "\n");
 
@@ -356,6 +408,13 @@ void Log::log(ErrorState err, const char* source_file, SInt32 source_line, const
    {
    case Error:
       fputs(message, stderr);
+      if (_format == BINARY)
+      {
+         // Keep what led to the error
+         ThreadBuffer* buffer = _threadBuffers->get<ThreadBuffer>();
+         if (buffer)
+            flush(buffer);
+      }
       abort();
       break;
 
@@ -368,3 +427,220 @@ void Log::log(ErrorState err, const char* source_file, SInt32 source_line, const
       break;
    }
 }
+
+Log::ThreadBuffer* Log::getThreadBuffer()
+{
+   ThreadBuffer* buffer = _threadBuffers->get<ThreadBuffer>();
+   if (buffer)
+      return buffer;
+
+   int tid = syscall(__NR_gettid);
+   char filename[256];
+   sprintf(filename, "log_%d.bin", tid);
+
+   buffer = new ThreadBuffer();
+   buffer->file = fopen(formatFileName(filename).c_str(), "w");
+   assert(buffer->file != NULL);
+   buffer->data = new char[_bufferSize];
+   buffer->size = 0;
+
+   fwrite("GLOG", 1, 4, buffer->file);
+   fwrite(&BINARY_VERSION, sizeof(BINARY_VERSION), 1, buffer->file);
+
+   _threadBuffers->insert<ThreadBuffer>(buffer);
+   ScopedLock sl(_allThreadBuffersLock);
+   _allThreadBuffers.push_back(buffer);
+   return buffer;
+}
+
+void Log::append(ThreadBuffer* buffer, const void* bytes, UInt32 length)
+{
+   const char* data = (const char*) bytes;
+   while (length > 0)
+   {
+      if (buffer->size == _bufferSize)
+         flush(buffer);
+      UInt32 num_bytes = getMin<UInt32>(length, _bufferSize - buffer->size);
+      memcpy(buffer->data + buffer->size, data, num_bytes);
+      buffer->size += num_bytes;
+      data += num_bytes;
+      length -= num_bytes;
+   }
+}
+
+void Log::appendText(ThreadBuffer* buffer, const char* str)
+{
+   UInt32 length = strlen(str);
+   append(buffer, &length, sizeof(length));
+   append(buffer, str, length);
+}
+
+void Log::defineString(ThreadBuffer* buffer, const char* str)
+{
+   if (!buffer->strings.insert(str).second)
+      return;
+
+   UInt64 address = (UInt64) (IntPtr) str;
+   appendTag(buffer, BINARY_STRING);
+   append(buffer, &address, sizeof(address));
+   appendText(buffer, str);
+}
+
+void Log::flush(ThreadBuffer* buffer)
+{
+   fwrite(buffer->data, 1, buffer->size, buffer->file);
+   fflush(buffer->file);
+   buffer->size = 0;
+}
+
+void Log::logBinary(tile_id_t tile_id, bool sim_thread,
+                    const char* source_file, SInt32 source_line, const char *format, va_list args)
+{
+   // No formatting here: the format and the file go once in the thread's
+   // file, the entries keep their addresses and the raw arguments
+   ThreadBuffer* buffer = getThreadBuffer();
+   defineString(buffer, format);
+   defineString(buffer, source_file);
+
+   UInt64 time = getTimestamp();
+   UInt64 format_address = (UInt64) (IntPtr) format;
+   UInt64 file_address = (UInt64) (IntPtr) source_file;
+   SInt32 process_num = Config::getSingleton()->getCurrentProcessNum();
+   UInt8 is_sim_thread = sim_thread;
+
+   appendTag(buffer, BINARY_ENTRY);
+   append(buffer, &time, sizeof(time));
+   append(buffer, &format_address, sizeof(format_address));
+   append(buffer, &file_address, sizeof(file_address));
+   append(buffer, &source_line, sizeof(source_line));
+   append(buffer, &tile_id, sizeof(tile_id));
+   append(buffer, &process_num, sizeof(process_num));
+   append(buffer, &is_sim_thread, sizeof(is_sim_thread));
+
+   // Take the arguments as the conversions of the format say
+   for (const char* p = format; *p != '\0'; p++)
+   {
+      if (*p != '%')
+         continue;
+      p++;
+
+      while ((*p != '\0') && strchr("-+ #0'", *p))
+         p++;
+      // Widths and precisions given as arguments are ints
+      for (UInt32 field = 0; field < 2; field++)
+      {
+         if (*p == '*')
+         {
+            UInt64 value = (SInt64) va_arg(args, int);
+            appendTag(buffer, BINARY_INT);
+            append(buffer, &value, sizeof(value));
+            p++;
+         }
+         else
+         {
+            while (isdigit(*p))
+               p++;
+         }
+         if ((field == 0) && (*p == '.'))
+            p++;
+         else
+            break;
+      }
+
+      UInt32 num_longs = 0;
+      bool is_size = false;
+      bool is_long_double = false;
+      while ((*p != '\0') && strchr("hlqjztL", *p))
+      {
+         if (*p == 'l')
+            num_longs ++;
+         else if ((*p == 'q') || (*p == 'j'))
+            num_longs = 2;
+         else if ((*p == 'z') || (*p == 't'))
+            is_size = true;
+         else if (*p == 'L')
+            is_long_double = true;
+         p++;
+      }
+
+      UInt64 value;
+      double float_value;
+      switch (*p)
+      {
+      case 'd':
+      case 'i':
+         if (num_longs >= 2)
+            value = va_arg(args, long long);
+         else if ((num_longs == 1) || is_size)
+            value = va_arg(args, long);
+         else
+            value = va_arg(args, int);
+         appendTag(buffer, BINARY_INT);
+         append(buffer, &value, sizeof(value));
+         break;
+
+      case 'o':
+      case 'u':
+      case 'x':
+      case 'X':
+         if (num_longs >= 2)
+            value = va_arg(args, unsigned long long);
+         else if ((num_longs == 1) || is_size)
+            value = va_arg(args, unsigned long);
+         else
+            value = va_arg(args, unsigned int);
+         appendTag(buffer, BINARY_INT);
+         append(buffer, &value, sizeof(value));
+         break;
+
+      case 'c':
+         value = va_arg(args, int);
+         appendTag(buffer, BINARY_INT);
+         append(buffer, &value, sizeof(value));
+         break;
+
+      case 'p':
+         value = (UInt64) (IntPtr) va_arg(args, void*);
+         appendTag(buffer, BINARY_INT);
+         append(buffer, &value, sizeof(value));
+         break;
+
+      case 'e':
+      case 'E':
+      case 'f':
+      case 'F':
+      case 'g':
+      case 'G':
+      case 'a':
+      case 'A':
+         if (is_long_double)
+            float_value = va_arg(args, long double);
+         else
+            float_value = va_arg(args, double);
+         appendTag(buffer, BINARY_FLOAT);
+         append(buffer, &float_value, sizeof(float_value));
+         break;
+
+      case 's':
+         {
+            const char* str = va_arg(args, const char*);
+            appendTag(buffer, BINARY_TEXT);
+            appendText(buffer, str ? str : "(null)");
+         }
+         break;
+
+      case 'n':
+         va_arg(args, void*);
+         break;
+
+      case '\0':
+         p--;
+         break;
+
+      default:
+         break;
+      }
+   }
+
+   appendTag(buffer, BINARY_END);
+}
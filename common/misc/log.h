@@ -2,13 +2,16 @@
 #define LOG_H
 
 #include <stdio.h>
+#include <stdarg.h>
 #include <set>
 #include <string>
 #include <map>
+#include <vector>
 #include "fixed_types.h"
 #include "lock.h"
 
 class Config;
+class TLS;
 
 class Log
 {
@@ -25,22 +28,86 @@ class Log
          Error,
       };
 
+      // Call site states for isSiteEnabled()
+      enum SiteState
+      {
+         SITE_UNRESOLVED = 0,
+         SITE_DISABLED,
+         SITE_ENABLED,
+      };
+
       void log(ErrorState err, const char *source_file, SInt32 source_line, const char* format, ...);
 
-      bool isEnabled(const char* module);
+      bool isEnabled(const char* source_file);
       bool isLoggingEnabled();
       std::string getModule(const char *filename);
 
+      // The modules do not change once the log is up, so a call site
+      // resolves its file once and then costs one load
+      static bool isSiteEnabled(volatile SInt8* site, const char* source_file)
+      {
+         SInt8 state = *site;
+         if (state == SITE_UNRESOLVED)
+         {
+            state = getSingleton()->isEnabled(source_file) ? SITE_ENABLED : SITE_DISABLED;
+            *site = state;
+         }
+         return (state == SITE_ENABLED);
+      }
+
    private:
+      enum Format
+      {
+         TEXT = 0,
+         BINARY,
+      };
+
+      // Binary log of a thread, see logBinary()
+      struct ThreadBuffer
+      {
+         FILE* file;
+         char* data;
+         UInt32 size;
+         // Strings (formats and files) already in the file
+         std::set<const char*> strings;
+      };
+
+      // Record tags and argument kinds of the binary log (tools/decode_log.py)
+      enum BinaryTag
+      {
+         BINARY_END = 0,
+         BINARY_STRING,       // UInt64 address, UInt32 length, chars
+         BINARY_ENTRY,        // UInt64 time, format, file, SInt32 line, tile, process, UInt8 sim thread, args, end
+         BINARY_INT,          // UInt64
+         BINARY_FLOAT,        // double
+         BINARY_TEXT,         // UInt32 length, chars
+      };
+
+      static const UInt32 BINARY_VERSION = 1;
+
       UInt64 getTimestamp();
 
+      void discoverCore(tile_id_t *tile_id, bool *sim_thread);
+
+      void logText(ErrorState err, tile_id_t tile_id, bool sim_thread,
+                   const char *source_file, SInt32 source_line, const char* format, va_list args);
+      void logBinary(tile_id_t tile_id, bool sim_thread,
+                     const char *source_file, SInt32 source_line, const char* format, va_list args);
+
+      ThreadBuffer* getThreadBuffer();
+      void append(ThreadBuffer* buffer, const void* bytes, UInt32 length);
+      void appendTag(ThreadBuffer* buffer, UInt8 tag) { append(buffer, &tag, sizeof(tag)); }
+      void appendText(ThreadBuffer* buffer, const char* str);
+      void defineString(ThreadBuffer* buffer, const char* str);
+      void flush(ThreadBuffer* buffer);
+
       void initFileDescriptors();
       static void parseModules(std::set<std::string> &mods, std::string list);
       void getDisabledModules();
       void getEnabledModules();
       bool initIsLoggingEnabled();
+      void initFormat();
 
-      void discoverCore(tile_id_t *tile_id, bool *sim_thread);
       void getFile(tile_id_t tile_id, bool sim_thread, FILE ** f, Lock ** l);
 
       ErrorState _state;
@@ -67,6 +134,12 @@ class Log
       std::set<std::string> _enabledModules;
       bool _loggingEnabled;
 
+      Format _format;
+      UInt32 _bufferSize;
+      TLS* _threadBuffers;
+      std::vector<ThreadBuffer*> _allThreadBuffers;
+      Lock _allThreadBuffersLock;
+
       /* std::map<const char*, std::string> _modules; */
       /* Lock _modules_lock; */
 
@@ -95,22 +168,39 @@ class Log
    {                                                                    \
       if (Log::getSingleton()->isLoggingEnabled() || err != Log::None)  \
       {                                                                 \
-         std::string module = Log::getSingleton()->getModule(file);     \
          if (err != Log::None ||                                        \
-             Log::getSingleton()->isEnabled(module.c_str()))            \
+             Log::getSingleton()->isEnabled(file))                      \
          {                                                              \
-            Log::getSingleton()->log(err, module.c_str(), line, __VA_ARGS__); \
+            Log::getSingleton()->log(err, file, line, __VA_ARGS__);     \
          }                                                              \
       }                                                                 \
    }                                                                    \
 
+// Same as __LOG_PRINT, with the module of the call site resolved once
 #define _LOG_PRINT(err, ...)                                            \
    {                                                                    \
-   __LOG_PRINT(err, __FILE__, __LINE__, __VA_ARGS__);                   \
+      static volatile SInt8 __log_site = Log::SITE_UNRESOLVED;          \
+      if (err != Log::None ||                                           \
+          Log::isSiteEnabled(&__log_site, __FILE__))                    \
+      {                                                                 \
+         Log::getSingleton()->log(err, __FILE__, __LINE__, __VA_ARGS__); \
+      }                                                                 \
    }                                                                    \
  
+#ifdef DISABLE_LOG_PRINT
+// Only the warnings and errors are compiled in, the arguments are still
+// type checked and used so that no variable becomes unused
+#define LOG_PRINT(...)                                                  \
+   {                                                                    \
+      if (false)                                                        \
+         Log::getSingleton()->log(Log::None, __FILE__, __LINE__, __VA_ARGS__); \
+   }                                                                    \
+
+#else
 #define LOG_PRINT(...)                                                  \
    _LOG_PRINT(Log::None, __VA_ARGS__);                                  \
+
+#endif
  
 #define LOG_PRINT_WARNING(...)                  \
    _LOG_PRINT(Log::Warning, __VA_ARGS__);
@@ -0,0 +1,171 @@
+#include <unistd.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <limits.h>
+
+#include "message_ring.h"
+#include "log.h"
+
+MessageRing::MessageRing(UInt32 num_slots, UInt32 spin_count)
+   : m_mask(num_slots - 1)
+   , m_spin_count(spin_count)
+   , m_enqueue_pos(0)
+   , m_dequeue_pos(0)
+   , m_num_waiters(0)
+   , m_wake_futx(0)
+{
+   LOG_ASSERT_ERROR(num_slots >= 2 && (num_slots & (num_slots - 1)) == 0,
+                    "Number of ring slots(%u) must be a power of 2", num_slots);
+
+   m_slots = new Slot[num_slots];
+   for (UInt32 i = 0; i < num_slots; i++)
+   {
+      m_slots[i].sequence = i;
+      m_slots[i].data = NULL;
+   }
+}
+
+MessageRing::~MessageRing()
+{
+   delete [] m_slots;
+}
+
+bool MessageRing::tryPush(Byte* data)
+{
+   UInt64 pos = m_enqueue_pos;
+   Slot* slot;
+
+   while (true)
+   {
+      slot = &m_slots[pos & m_mask];
+      SInt64 diff = (SInt64) slot->sequence - (SInt64) pos;
+
+      if (diff == 0)
+      {
+         // Slot is free, try to claim it
+         UInt64 prev_pos = __sync_val_compare_and_swap(&m_enqueue_pos, pos, pos + 1);
+         if (prev_pos == pos)
+            break;
+         pos = prev_pos;
+      }
+      else if (diff < 0)
+      {
+         // Ring is full
+         return false;
+      }
+      else
+      {
+         pos = m_enqueue_pos;
+      }
+   }
+
+   slot->data = data;
+   // Publish the data before marking the slot as full
+   __sync_synchronize();
+   slot->sequence = pos + 1;
+
+   return true;
+}
+
+bool MessageRing::tryPop(Byte*& data)
+{
+   UInt64 pos = m_dequeue_pos;
+   Slot* slot;
+
+   while (true)
+   {
+      slot = &m_slots[pos & m_mask];
+      SInt64 diff = (SInt64) slot->sequence - (SInt64) (pos + 1);
+
+      if (diff == 0)
+      {
+         // Slot is full, try to claim it
+         UInt64 prev_pos = __sync_val_compare_and_swap(&m_dequeue_pos, pos, pos + 1);
+         if (prev_pos == pos)
+            break;
+         pos = prev_pos;
+      }
+      else if (diff < 0)
+      {
+         // Ring is empty
+         return false;
+      }
+      else
+      {
+         pos = m_dequeue_pos;
+      }
+   }
+
+   data = slot->data;
+   // Read the data before handing the slot back to the producers
+   __sync_synchronize();
+   slot->sequence = pos + m_mask + 1;
+
+   return true;
+}
+
+void MessageRing::push(Byte* data)
+{
+   // The ring is sized so that it is almost never full. If it is, the
+   // consumer is running behind, so give up the processor to it.
+   while (!tryPush(data))
+      sched_yield();
+
+   // Full barrier so that the check for waiters is not re-ordered
+   // before the slot update above
+   __sync_synchronize();
+   if (m_num_waiters > 0)
+      wakeWaiters();
+}
+
+Byte* MessageRing::pop()
+{
+   Byte* data;
+
+   for (UInt32 i = 0; i < m_spin_count; i++)
+   {
+      if (tryPop(data))
+         return data;
+      asm volatile ("pause" ::: "memory");
+   }
+
+   while (true)
+   {
+      // Read the futex value before announcing ourselves, so that a wakeup
+      // that happens after the final check below is never lost
+      SInt32 futx = m_wake_futx;
+      __sync_fetch_and_add(&m_num_waiters, 1);
+
+      if (tryPop(data))
+      {
+         __sync_fetch_and_sub(&m_num_waiters, 1);
+         return data;
+      }
+
+      syscall(SYS_futex, (void*) &m_wake_futx, FUTEX_WAIT, futx, NULL, NULL, 0);
+      __sync_fetch_and_sub(&m_num_waiters, 1);
+
+      if (tryPop(data))
+         return data;
+   }
+}
+
+bool MessageRing::empty() const
+{
+   UInt64 pos = m_dequeue_pos;
+   return (m_slots[pos & m_mask].sequence != (pos + 1));
+}
+
+UInt32 MessageRing::size() const
+{
+   UInt64 dequeue_pos = m_dequeue_pos;
+   UInt64 enqueue_pos = m_enqueue_pos;
+   return (enqueue_pos > dequeue_pos) ? (UInt32) (enqueue_pos - dequeue_pos) : 0;
+}
+
+void MessageRing::wakeWaiters()
+{
+   __sync_fetch_and_add(&m_wake_futx, 1);
+   syscall(SYS_futex, (void*) &m_wake_futx, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
@@ -0,0 +1,58 @@
+#ifndef MESSAGE_RING_H
+#define MESSAGE_RING_H
+
+#include "fixed_types.h"
+
+// Bounded, lock-free multi-producer queue of message buffers.
+// Every slot carries a sequence number that tells producers and consumers
+// whether it is free or full, so neither side needs a lock. The slots are
+// allocated once when the ring is created.
+//
+// Consumers that find the ring empty spin for a configurable number of
+// iterations and then sleep on a futex until a producer wakes them up.
+
+class MessageRing
+{
+public:
+   MessageRing(UInt32 num_slots, UInt32 spin_count);
+   ~MessageRing();
+
+   // Non-blocking versions. Return false if the ring is full/empty
+   bool tryPush(Byte* data);
+   bool tryPop(Byte*& data);
+
+   // Blocking versions
+   void push(Byte* data);
+   Byte* pop();
+
+   bool empty() const;
+   // Messages pushed and not yet popped. Read without synchronization, so
+   // only an estimate while producers and consumers run
+   UInt32 size() const;
+
+private:
+   struct Slot
+   {
+      volatile UInt64 sequence;
+      Byte* data;
+   };
+
+   static const UInt32 CACHE_LINE_SIZE = 64;
+
+   void wakeWaiters();
+
+   Slot* m_slots;
+   UInt64 m_mask;
+   UInt32 m_spin_count;
+
+   // Keep the producer and consumer positions on separate cache lines
+   char m_pad0[CACHE_LINE_SIZE];
+   volatile UInt64 m_enqueue_pos;
+   char m_pad1[CACHE_LINE_SIZE];
+   volatile UInt64 m_dequeue_pos;
+   char m_pad2[CACHE_LINE_SIZE];
+   volatile SInt32 m_num_waiters;
+   volatile SInt32 m_wake_futx;
+};
+
+#endif // MESSAGE_RING_H
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <new>
+#include <vector>
+using std::vector;
+
+#include "fixed_types.h"
+
+// Recycles the storage of objects that are created and destroyed at a high
+// rate (e.g., the coherence requests queued at a directory). A released
+// object is destroyed and its storage kept for the next allocation, up to
+// 'max_free_objects' of them:
+//    T* object = new (pool.allocate()) T(...);
+//    pool.release(object);
+// Not thread-safe, the pool is used under the lock of its owner
+template <typename T>
+class ObjectPool
+{
+public:
+   ObjectPool(UInt32 max_free_objects = 1024);
+   ~ObjectPool();
+
+   void* allocate();
+   void release(T* object);
+
+private:
+   vector<void*> _free_list;
+   UInt32 _max_free_objects;
+};
+
+template <typename T>
+ObjectPool<T>::ObjectPool(UInt32 max_free_objects)
+   : _max_free_objects(max_free_objects)
+{}
+
+template <typename T>
+ObjectPool<T>::~ObjectPool()
+{
+   for (typename vector<void*>::iterator it = _free_list.begin(); it != _free_list.end(); it++)
+      ::operator delete(*it);
+}
+
+template <typename T>
+void* ObjectPool<T>::allocate()
+{
+   if (_free_list.empty())
+      return ::operator new(sizeof(T));
+
+   void* storage = _free_list.back();
+   _free_list.pop_back();
+   return storage;
+}
+
+template <typename T>
+void ObjectPool<T>::release(T* object)
+{
+   object->~T();
+   if (_free_list.size() < _max_free_objects)
+      _free_list.push_back((void*) object);
+   else
+      ::operator delete((void*) object);
+}
@@ -3,22 +3,101 @@
 using namespace std;
 
 UnstructuredBuffer::UnstructuredBuffer()
+   : m_data(m_inline)
+   , m_capacity(INLINE_CAPACITY)
+   , m_read_pos(0)
+   , m_write_pos(0)
 {
 }
 
+UnstructuredBuffer::UnstructuredBuffer(const UnstructuredBuffer& other)
+   : m_data(m_inline)
+   , m_capacity(INLINE_CAPACITY)
+   , m_read_pos(0)
+   , m_write_pos(0)
+{
+   *this = other;
+}
+
+UnstructuredBuffer& UnstructuredBuffer::operator=(const UnstructuredBuffer& other)
+{
+   if (this != &other)
+   {
+      clear();
+      put<Byte>(other.m_data + other.m_read_pos, other.m_write_pos - other.m_read_pos);
+   }
+   return *this;
+}
+
+UnstructuredBuffer::~UnstructuredBuffer()
+{
+   if (m_data != m_inline)
+      delete [] m_data;
+}
+
+void UnstructuredBuffer::grow(UInt32 capacity)
+{
+   // The data that was read is dropped on the way
+   UInt32 new_capacity = m_capacity;
+   while (new_capacity < (capacity - m_read_pos))
+      new_capacity *= 2;
+
+   if (new_capacity == m_capacity)
+   {
+      memmove(m_data, m_data + m_read_pos, m_write_pos - m_read_pos);
+   }
+   else
+   {
+      Byte* new_data = new Byte[new_capacity];
+      memcpy(new_data, m_data + m_read_pos, m_write_pos - m_read_pos);
+      if (m_data != m_inline)
+         delete [] m_data;
+
+      m_data = new_data;
+      m_capacity = new_capacity;
+   }
+
+   m_write_pos -= m_read_pos;
+   m_read_pos = 0;
+}
+
 const void* UnstructuredBuffer::getBuffer()
 {
-   return m_chars.data();
+   return m_data + m_read_pos;
 }
 
 void UnstructuredBuffer::clear()
 {
-   m_chars.erase();
+   // The capacity is kept for the next message
+   m_read_pos = 0;
+   m_write_pos = 0;
 }
 
 int UnstructuredBuffer::size()
 {
-   return m_chars.size();
+   return m_write_pos - m_read_pos;
+}
+
+void UnstructuredBuffer::reserve(UInt32 num)
+{
+   if ((m_read_pos + num) > m_capacity)
+      grow(m_read_pos + num);
+}
+
+const void* UnstructuredBuffer::getView(UInt32 num)
+{
+   if ((m_write_pos - m_read_pos) < num)
+      return NULL;
+
+   const void* view = m_data + m_read_pos;
+   m_read_pos += num;
+   // Start over once everything is read, the view stays valid until the next write
+   if (m_read_pos == m_write_pos)
+   {
+      m_read_pos = 0;
+      m_write_pos = 0;
+   }
+   return view;
 }
 
 // put buffer
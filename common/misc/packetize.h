@@ -9,6 +9,7 @@
 #include <string>
 #include <iostream>
 #include <utility>
+#include <string.h>
 #include "fixed_types.h"
 
 #include "log.h"
@@ -16,18 +17,40 @@
 #include <sstream>
 using std::stringstream;
 
+// The data is appended at the write position and consumed from the read
+// position, so reading a field does not move the rest. Small messages fit
+// in the inline storage, larger ones go to the heap.
 class UnstructuredBuffer
 {
 
 private:
-    std::string m_chars;
+    static const UInt32 INLINE_CAPACITY = 256;
+
+    Byte* m_data;
+    UInt32 m_capacity;
+    UInt32 m_read_pos;
+    UInt32 m_write_pos;
+    Byte m_inline[INLINE_CAPACITY];
+
+    void grow(UInt32 capacity);
 
 public:
 
     UnstructuredBuffer();
+    UnstructuredBuffer(const UnstructuredBuffer& other);
+    UnstructuredBuffer& operator=(const UnstructuredBuffer& other);
+    ~UnstructuredBuffer();
+
+    // The data that has not been read
     const void* getBuffer();
     void clear();
     int size();
+    // Room for 'num' bytes in all
+    void reserve(UInt32 num);
+
+    // Consumes the next 'num' bytes without copying them (NULL if there are
+    // fewer). Valid until the next write or clear
+    const void* getView(UInt32 num);
 
     // These put / get scalars
     template<class T> void put(const T & data);
@@ -56,18 +79,22 @@ public:
 template<class T> void UnstructuredBuffer::put(const T* data, int num)
 {
     assert(num >= 0);
-    m_chars.append((const char *) data, num * sizeof(T));
+    UInt32 bytes = num * sizeof(T);
+    if ((m_write_pos + bytes) > m_capacity)
+        grow(m_write_pos + bytes);
+
+    memcpy(m_data + m_write_pos, data, bytes);
+    m_write_pos += bytes;
 }
 
 template<class T> bool UnstructuredBuffer::get(T* data, int num)
 {
     assert(num >= 0);
-    if (m_chars.size() < (num * sizeof(T)))
+    const void* view = getView(num * sizeof(T));
+    if (view == NULL)
         return false;
 
-    m_chars.copy((char *) data, num * sizeof(T));
-    m_chars.erase(0, num * sizeof(T));
-
+    memcpy((void*) data, view, num * sizeof(T));
     return true;
 }
 
@@ -0,0 +1,110 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include "fixed_types.h"
+#include "log.h"
+
+// Bounded, lock-free queue with a single producer and a single consumer.
+// The producer only writes the tail and the consumer only writes the head,
+// so a memory barrier between filling (emptying) a slot and publishing the
+// new position is all the synchronization needed. The slots are allocated
+// once when the ring is created. Blocking is left to the users.
+
+template <typename T>
+class SPSCRing
+{
+public:
+   SPSCRing(UInt32 num_slots);
+   ~SPSCRing();
+
+   // Return false if the ring is full/empty
+   bool tryPush(const T& value);
+   bool tryPop(T& value);
+
+   // Consumer side: the oldest value (NULL if the ring is empty), which
+   // stays in place until it is popped
+   T* front();
+   void pop();
+
+   bool empty() const { return (m_head == m_tail); }
+   UInt64 size() const { return (m_tail - m_head); }
+
+private:
+   static const UInt32 CACHE_LINE_SIZE = 64;
+
+   T* m_slots;
+   UInt64 m_mask;
+
+   // Keep the producer and consumer positions on separate cache lines
+   char m_pad0[CACHE_LINE_SIZE];
+   volatile UInt64 m_tail;
+   char m_pad1[CACHE_LINE_SIZE];
+   volatile UInt64 m_head;
+   char m_pad2[CACHE_LINE_SIZE];
+};
+
+template <typename T>
+SPSCRing<T>::SPSCRing(UInt32 num_slots)
+   : m_mask(num_slots - 1)
+   , m_tail(0)
+   , m_head(0)
+{
+   LOG_ASSERT_ERROR(num_slots >= 2 && (num_slots & (num_slots - 1)) == 0,
+                    "Number of ring slots(%u) must be a power of 2", num_slots);
+   m_slots = new T[num_slots];
+}
+
+template <typename T>
+SPSCRing<T>::~SPSCRing()
+{
+   delete [] m_slots;
+}
+
+template <typename T>
+bool SPSCRing<T>::tryPush(const T& value)
+{
+   UInt64 tail = m_tail;
+   if ((tail - m_head) > m_mask)
+      return false;
+
+   m_slots[tail & m_mask] = value;
+   // Publish the value before the new tail
+   __sync_synchronize();
+   m_tail = tail + 1;
+   return true;
+}
+
+template <typename T>
+bool SPSCRing<T>::tryPop(T& value)
+{
+   T* oldest = front();
+   if (!oldest)
+      return false;
+
+   value = *oldest;
+   pop();
+   return true;
+}
+
+template <typename T>
+T* SPSCRing<T>::front()
+{
+   UInt64 head = m_head;
+   if (head == m_tail)
+      return NULL;
+
+   // Read the value only after seeing the tail that published it
+   __sync_synchronize();
+   return &m_slots[head & m_mask];
+}
+
+template <typename T>
+void SPSCRing<T>::pop()
+{
+   LOG_ASSERT_ERROR(m_head != m_tail, "Pop from an empty ring");
+   // Release the slot only once the value is read
+   __sync_synchronize();
+   m_head = m_head + 1;
+}
+
+#endif // SPSC_RING_H
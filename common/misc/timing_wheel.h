@@ -0,0 +1,178 @@
+#pragma once
+
+#include <vector>
+#include <map>
+#include <utility>
+#include <algorithm>
+using std::vector;
+using std::multimap;
+using std::pair;
+using std::make_pair;
+
+#include "fixed_types.h"
+
+/*
+  Two-level timing wheel of items keyed by time. The fine level has
+  NUM_SLOTS buckets of bucket_size cycles each, starting at the window
+  time. The coarse level has NUM_SLOTS buckets, each as long as the
+  whole fine level, for the windows that follow. When the fine level is
+  drained, the next coarse bucket is spread over it. Items past the
+  coarse level wait in an overflow map, and items before the window
+  time (scheduled after the wheel has moved past them) are overdue and
+  come out first.
+
+  popBatch() takes out all the items of the earliest bucket, in
+  timestamp order (in scheduling order for equal times).
+ */
+template <typename T>
+class TimingWheel
+{
+public:
+   typedef vector<pair<UInt64, T> > Batch;
+
+   TimingWheel(UInt64 bucket_size);
+
+   void schedule(UInt64 time, const T& item);
+   void popBatch(Batch& batch);
+
+   bool empty() const { return (_size == 0); }
+   UInt64 size() const { return _size; }
+
+private:
+   static const UInt32 NUM_SLOTS = 256;
+
+   struct TimeLess
+   {
+      bool operator()(const pair<UInt64, T>& a, const pair<UInt64, T>& b) const
+      { return a.first < b.first; }
+   };
+
+   // Puts an item in the window by time, the window time is <= the time
+   void place(UInt64 time, const T& item);
+   // Moves the window to the next span of the fine level
+   void advance();
+
+   UInt64 _bucket_size;
+   // Cycles covered by the fine level (and by a coarse bucket)
+   UInt64 _span;
+
+   UInt64 _window_time;
+   UInt32 _cursor;
+   Batch _fine[NUM_SLOTS];
+   // Coarse bucket i covers the window (i+1) spans after the current one,
+   // stored at (_coarse_head + i) % NUM_SLOTS
+   Batch _coarse[NUM_SLOTS];
+   UInt32 _coarse_head;
+   UInt64 _coarse_size;
+   multimap<UInt64, T> _overflow;
+   Batch _overdue;
+
+   UInt64 _size;
+};
+
+template <typename T>
+TimingWheel<T>::TimingWheel(UInt64 bucket_size)
+   : _bucket_size(bucket_size)
+   , _span(bucket_size * NUM_SLOTS)
+   , _window_time(0)
+   , _cursor(0)
+   , _coarse_head(0)
+   , _coarse_size(0)
+   , _size(0)
+{}
+
+template <typename T>
+void TimingWheel<T>::schedule(UInt64 time, const T& item)
+{
+   if (_size == 0)
+   {
+      // Start over around the first item
+      _window_time = (time / _span) * _span;
+      _cursor = 0;
+      _coarse_head = 0;
+   }
+   _size ++;
+
+   if (time < _window_time + (_cursor * _bucket_size))
+      _overdue.push_back(make_pair(time, item));
+   else
+      place(time, item);
+}
+
+template <typename T>
+void TimingWheel<T>::place(UInt64 time, const T& item)
+{
+   UInt64 offset = time - _window_time;
+   if (offset < _span)
+   {
+      _fine[offset / _bucket_size].push_back(make_pair(time, item));
+   }
+   else if (offset < (NUM_SLOTS + 1) * _span)
+   {
+      UInt32 slot = (_coarse_head + (offset / _span) - 1) % NUM_SLOTS;
+      _coarse[slot].push_back(make_pair(time, item));
+      _coarse_size ++;
+   }
+   else
+   {
+      _overflow.insert(make_pair(time, item));
+   }
+}
+
+template <typename T>
+void TimingWheel<T>::advance()
+{
+   if ((_coarse_size == 0) && !_overflow.empty())
+   {
+      // Skip the empty windows
+      _window_time = (_overflow.begin()->first / _span) * _span;
+   }
+   else
+   {
+      _window_time += _span;
+      Batch& next = _coarse[_coarse_head];
+      _coarse_head = (_coarse_head + 1) % NUM_SLOTS;
+      _coarse_size -= next.size();
+      for (typename Batch::iterator it = next.begin(); it != next.end(); it++)
+         _fine[(it->first - _window_time) / _bucket_size].push_back(*it);
+      next.clear();
+   }
+   _cursor = 0;
+
+   // Bring in the overflow items the coarse level now covers
+   UInt64 coarse_end = _window_time + (NUM_SLOTS + 1) * _span;
+   while (!_overflow.empty() && (_overflow.begin()->first < coarse_end))
+   {
+      place(_overflow.begin()->first, _overflow.begin()->second);
+      _overflow.erase(_overflow.begin());
+   }
+}
+
+template <typename T>
+void TimingWheel<T>::popBatch(Batch& batch)
+{
+   batch.clear();
+   if (_size == 0)
+      return;
+
+   if (!_overdue.empty())
+   {
+      batch.swap(_overdue);
+   }
+   else
+   {
+      while (true)
+      {
+         while ((_cursor < NUM_SLOTS) && _fine[_cursor].empty())
+            _cursor ++;
+         if (_cursor < NUM_SLOTS)
+            break;
+         advance();
+      }
+      batch.swap(_fine[_cursor]);
+   }
+
+   if (batch.size() > 1)
+      std::stable_sort(batch.begin(), batch.end(), TimeLess());
+   _size -= batch.size();
+}
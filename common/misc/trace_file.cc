@@ -0,0 +1,271 @@
+#include <vector>
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+#include "trace_file.h"
+#include "thread.h"
+#include "cond.h"
+#include "lock.h"
+#include "log.h"
+
+// Writes the chunks of all the open trace files, started with the first
+// one and stopped with the last one
+class TraceFileWriter : public Runnable
+{
+public:
+   TraceFileWriter();
+
+   void addBuffer(TraceFile::Buffer* buffer);
+   void removeBuffer(TraceFile::Buffer* buffer);
+   void notify();
+
+private:
+   Thread* _thread;
+   volatile bool _exit;
+   volatile bool _finished;
+   std::vector<TraceFile::Buffer*> _buffers;
+   Lock _lock;
+   ConditionVariable _cond_var;
+
+   void run();
+   static void write(const TraceFile::Buffer::Chunk& chunk);
+};
+
+static TraceFileWriter s_trace_file_writer;
+
+TraceFileWriter::TraceFileWriter()
+   : _thread(NULL)
+   , _exit(false)
+   , _finished(false)
+{}
+
+void
+TraceFileWriter::addBuffer(TraceFile::Buffer* buffer)
+{
+   ScopedLock sl(_lock);
+   _buffers.push_back(buffer);
+   if (!_thread)
+   {
+      _exit = false;
+      _finished = false;
+      _thread = Thread::create(this);
+      _thread->run();
+   }
+}
+
+void
+TraceFileWriter::removeBuffer(TraceFile::Buffer* buffer)
+{
+   // The chunks of the buffer are all written
+   _lock.acquire();
+   for (UInt32 i = 0; i < _buffers.size(); i++)
+   {
+      if (_buffers[i] == buffer)
+      {
+         _buffers.erase(_buffers.begin() + i);
+         break;
+      }
+   }
+   bool stop = _buffers.empty();
+   if (stop)
+   {
+      _exit = true;
+      _cond_var.signal();
+   }
+   _lock.release();
+
+   if (stop)
+   {
+      while (!_finished)
+         sched_yield();
+      delete _thread;
+      _thread = NULL;
+   }
+}
+
+void
+TraceFileWriter::notify()
+{
+   ScopedLock sl(_lock);
+   _cond_var.signal();
+}
+
+void
+TraceFileWriter::run()
+{
+   std::vector<std::pair<TraceFile::Buffer*, TraceFile::Buffer::Chunk> > chunks;
+
+   while (true)
+   {
+      // The buffers are only looked at with the lock held, the producers
+      // take it to wake the writer up or to remove their buffer
+      _lock.acquire();
+      while (true)
+      {
+         for (UInt32 i = 0; i < _buffers.size(); i++)
+         {
+            TraceFile::Buffer::Chunk chunk;
+            while (_buffers[i]->getRing().tryPop(chunk))
+               chunks.push_back(std::make_pair(_buffers[i], chunk));
+         }
+         if (!chunks.empty() || _exit)
+            break;
+         _cond_var.wait(_lock);
+      }
+      bool exit = chunks.empty();
+      _lock.release();
+      if (exit)
+         break;
+
+      // A buffer is not removed before its chunks are written, and
+      // chunkWritten() is the last time the writer touches it
+      for (UInt32 i = 0; i < chunks.size(); i++)
+      {
+         write(chunks[i].second);
+         delete [] chunks[i].second.data;
+         chunks[i].first->chunkWritten(chunks[i].second.size);
+      }
+      chunks.clear();
+   }
+
+   _finished = true;
+}
+
+void
+TraceFileWriter::write(const TraceFile::Buffer::Chunk& chunk)
+{
+   UInt32 offset = 0;
+   while (offset < chunk.size)
+   {
+      ssize_t written = ::write(chunk.fd, chunk.data + offset, chunk.size - offset);
+      if (written < 0)
+      {
+         if (errno == EINTR)
+            continue;
+         LOG_PRINT_ERROR("Could not write trace file: %s", strerror(errno));
+      }
+      offset += written;
+   }
+}
+
+TraceFile::Buffer::Buffer()
+   : m_fd(-1)
+   , m_chunk(NULL)
+   , m_ring(NUM_CHUNKS)
+   , m_bytes_pushed(0)
+   , m_bytes_written(0)
+{}
+
+TraceFile::Buffer::~Buffer()
+{
+   close();
+}
+
+void
+TraceFile::Buffer::open(int fd)
+{
+   m_fd = fd;
+   m_chunk = new char[CHUNK_SIZE];
+   setp(m_chunk, m_chunk + CHUNK_SIZE);
+   m_bytes_pushed = 0;
+   m_bytes_written = 0;
+   s_trace_file_writer.addBuffer(this);
+}
+
+void
+TraceFile::Buffer::close()
+{
+   if (m_fd < 0)
+      return;
+
+   pushChunk();
+   while (m_bytes_written < m_bytes_pushed)
+      sched_yield();
+   s_trace_file_writer.removeBuffer(this);
+
+   delete [] m_chunk;
+   m_chunk = NULL;
+   setp(NULL, NULL);
+   ::close(m_fd);
+   m_fd = -1;
+}
+
+void
+TraceFile::Buffer::chunkWritten(UInt32 size)
+{
+   __sync_synchronize();
+   m_bytes_written += size;
+}
+
+TraceFile::Buffer::int_type
+TraceFile::Buffer::overflow(int_type c)
+{
+   if (m_fd < 0)
+      return traits_type::eof();
+
+   pushChunk();
+   if (!traits_type::eq_int_type(c, traits_type::eof()))
+   {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+   }
+   return traits_type::not_eof(c);
+}
+
+TraceFile::Buffer::pos_type
+TraceFile::Buffer::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode mode)
+{
+   if ((off != 0) || (dir != std::ios_base::cur) || !(mode & std::ios_base::out))
+      return pos_type(off_type(-1));
+   return pos_type(off_type(m_bytes_pushed + (pptr() - pbase())));
+}
+
+void
+TraceFile::Buffer::pushChunk()
+{
+   if (pptr() == pbase())
+      return;
+
+   Chunk chunk;
+   chunk.data = m_chunk;
+   chunk.size = pptr() - pbase();
+   chunk.fd = m_fd;
+   // The writer is NUM_CHUNKS chunks behind
+   while (!m_ring.tryPush(chunk))
+      sched_yield();
+   m_bytes_pushed += chunk.size;
+   s_trace_file_writer.notify();
+
+   m_chunk = new char[CHUNK_SIZE];
+   setp(m_chunk, m_chunk + CHUNK_SIZE);
+}
+
+TraceFile::TraceFile()
+   : std::ostream(NULL)
+{
+   rdbuf(&m_buffer);
+}
+
+TraceFile::~TraceFile()
+{
+   close();
+}
+
+void
+TraceFile::open(const char* filename)
+{
+   LOG_ASSERT_ERROR(m_buffer.getFd() < 0, "Trace file(%s) opened twice", filename);
+   int fd = ::open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   LOG_ASSERT_ERROR(fd >= 0, "Could not open trace file(%s): %s", filename, strerror(errno));
+   m_buffer.open(fd);
+   clear();
+}
+
+void
+TraceFile::close()
+{
+   m_buffer.close();
+}
@@ -0,0 +1,73 @@
+#ifndef TRACE_FILE_H
+#define TRACE_FILE_H
+
+#include <ostream>
+#include <streambuf>
+
+#include "fixed_types.h"
+#include "spsc_ring.h"
+
+// Output stream for the trace files written by one thread all along the run
+// (the statistics traces). The text goes into large chunks that a writer
+// thread, shared by all the trace files of the process, writes to disk in
+// the background: std::endl does not flush, and the producer only waits if
+// the writer falls NUM_CHUNKS chunks behind. Each file has its own ring of
+// chunks, so the producers do not share anything but the wakeup of the
+// writer. close() (or the destructor) waits for all the text to be written.
+
+class TraceFile : public std::ostream
+{
+public:
+   TraceFile();
+   ~TraceFile();
+
+   void open(const char* filename);
+   void close();
+   bool is_open() const { return m_buffer.getFd() >= 0; }
+
+   class Buffer : public std::streambuf
+   {
+   public:
+      static const UInt32 CHUNK_SIZE = 1 << 16;
+      static const UInt32 NUM_CHUNKS = 64;
+
+      struct Chunk
+      {
+         char* data;
+         UInt32 size;
+         int fd;
+      };
+
+      Buffer();
+      ~Buffer();
+
+      void open(int fd);
+      void close();
+      int getFd() const { return m_fd; }
+
+      // Writer thread
+      SPSCRing<Chunk>& getRing() { return m_ring; }
+      void chunkWritten(UInt32 size);
+
+   protected:
+      int_type overflow(int_type c);
+      // Not flushed to disk before the chunk is full
+      int sync() { return 0; }
+      // Only the current position (tellp())
+      pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode mode);
+
+   private:
+      int m_fd;
+      char* m_chunk;
+      SPSCRing<Chunk> m_ring;
+      UInt64 m_bytes_pushed;
+      volatile UInt64 m_bytes_written;
+
+      void pushChunk();
+   };
+
+private:
+   Buffer m_buffer;
+};
+
+#endif // TRACE_FILE_H
@@ -0,0 +1,56 @@
+#include "channel_model.h"
+#include "log.h"
+
+ChannelModel::ChannelModel(SInt32 num_writers, UInt64 token_hop_delay)
+   : _num_writers(num_writers)
+   , _token_hop_delay(token_hop_delay)
+   , _free_time(0)
+   , _token_holder(0)
+   , _total_packets(0)
+   , _total_delay(0)
+   , _total_busy_time(0)
+{
+   LOG_ASSERT_ERROR(num_writers > 0, "Number of writers of a channel(%i) must be > 0", num_writers);
+}
+
+ChannelModel::~ChannelModel()
+{}
+
+UInt64
+ChannelModel::computeDelay(UInt64 time, SInt32 num_flits, SInt32 writer)
+{
+   LOG_ASSERT_ERROR(writer >= 0 && writer < _num_writers, "Writer(%i) of a channel with %i writers", writer, _num_writers);
+
+   UInt64 grant_time = (time > _free_time) ? time : _free_time;
+   if ((_num_writers > 1) && (_token_hop_delay > 0))
+   {
+      // The token reaches the writer at token_time, then once per round trip
+      SInt32 num_hops = (writer - _token_holder + _num_writers) % _num_writers;
+      UInt64 token_time = _free_time + num_hops * _token_hop_delay;
+      UInt64 round_trip = _num_writers * _token_hop_delay;
+      if (grant_time > token_time)
+         token_time += (grant_time - token_time + round_trip - 1) / round_trip * round_trip;
+      grant_time = token_time;
+   }
+   _token_holder = writer;
+
+   _free_time = grant_time + num_flits;
+
+   UInt64 delay = grant_time - time;
+   _total_packets ++;
+   _total_delay += delay;
+   _total_busy_time += num_flits;
+   return delay;
+}
+
+float
+ChannelModel::getAverageDelay()
+{
+   return (_total_packets > 0) ? (((float) _total_delay) / _total_packets) : 0.0;
+}
+
+float
+ChannelModel::getUtilization()
+{
+   return (_free_time > 0) ? (((float) _total_busy_time) / _free_time) : 0.0;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "fixed_types.h"
+
+/*
+  A channel that carries one packet at a time (an ONet waveguide or the link
+  into a receive net), busy until the last flit of its last packet.
+
+  With one writer (SWMR waveguide, receive link) a packet waits for the
+  channel to be free. With several writers (MWSR waveguide) they arbitrate
+  with a token that goes around them, a hop of 'token_hop_delay' cycles per
+  writer: the last writer releases it when the channel frees, and a writer
+  gets it when it passes by after its packet arrives, so the delay is in
+  closed form (O(1) per packet). Like the history queue models, the packets
+  take the channel in the order they are seen.
+ */
+class ChannelModel
+{
+public:
+   ChannelModel(SInt32 num_writers = 1, UInt64 token_hop_delay = 0);
+   ~ChannelModel();
+
+   // Wait (in cycles) of a packet of num_flits from 'writer' arriving at 'time'
+   UInt64 computeDelay(UInt64 time, SInt32 num_flits, SInt32 writer = 0);
+
+   float getAverageDelay();
+   float getUtilization();
+
+private:
+   SInt32 _num_writers;
+   UInt64 _token_hop_delay;
+
+   UInt64 _free_time;
+   SInt32 _token_holder;
+
+   // Counters
+   UInt64 _total_packets;
+   UInt64 _total_delay;
+   UInt64 _total_busy_time;
+};
@@ -2,6 +2,8 @@
 #include "electrical_link_model.h"
 #include "network_model.h"
 #include "network.h"
+#include "simulator.h"
+#include "statistics_manager.h"
 #include "log.h"
 
 ElectricalLinkModel::ElectricalLinkModel(NetworkModel* model, string link_type,
@@ -17,7 +19,13 @@ ElectricalLinkModel::ElectricalLinkModel(NetworkModel* model, string link_type,
 
    // Power model
    if (Config::getSingleton()->getEnablePowerModeling())
+   {
       _power_model = new ElectricalLinkPowerModel(link_type, link_frequency, link_length, link_width);
+      // Power trace
+      if (Sim()->getStatisticsManager())
+         Sim()->getStatisticsManager()->registerPowerModel(_model->getTileId(), _power_model);
+      _power_model->registerEventCounters(_model->getTileId(), _model->getPowerModelCounterPrefix("Electrical Link"));
+   }
 }
 
 ElectricalLinkModel::~ElectricalLinkModel()
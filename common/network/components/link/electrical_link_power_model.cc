@@ -1,10 +1,13 @@
 #include "electrical_link_power_model.h"
+#include "simulator.h"
+#include "stats_registry.h"
 #include "log.h"
 
 using namespace dsent_contrib;
 
 ElectricalLinkPowerModel::ElectricalLinkPowerModel(string link_type, float link_frequency, double link_length, UInt32 link_width)
    : LinkPowerModel(link_frequency, link_length, link_width)
+   , _num_flits(0)
 {
    LOG_ASSERT_ERROR(link_type == "electrical_repeated", "DSENT only supports electrical_repeated link models currently");
    // DSENT expects link length to be in meters(m)
@@ -20,8 +23,16 @@ ElectricalLinkPowerModel::~ElectricalLinkPowerModel()
    delete _dsent_link;
 }
 
+volatile double
+ElectricalLinkPowerModel::getDynamicEnergy()
+{
+   return _num_flits * _dsent_link->calc_dynamic_energy(1);
+}
+
 void
-ElectricalLinkPowerModel::updateDynamicEnergy(UInt32 num_flits)
+ElectricalLinkPowerModel::registerEventCounters(tile_id_t tile_id, const string& prefix)
 {
-   _total_dynamic_energy += _dsent_link->calc_dynamic_energy(num_flits);
+   StatsRegistry* stats = Sim()->getStatsRegistry();
+   if (stats)
+      stats->registerCounter(tile_id, prefix + "Flits", &_num_flits);
 }
@@ -10,8 +10,13 @@ public:
    ElectricalLinkPowerModel(std::string link_type, float link_frequency, double link_length, UInt32 link_width);
    ~ElectricalLinkPowerModel();
 
-   void updateDynamicEnergy(UInt32 num_flits);
+   void updateDynamicEnergy(UInt32 num_flits) { _num_flits += num_flits; }
+   volatile double getDynamicEnergy();
+
+   void registerEventCounters(tile_id_t tile_id, const std::string& prefix);
 
 private:
    dsent_contrib::DSENTElectricalLink* _dsent_link;
+
+   UInt64 _num_flits;
 };
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <string>
 #include "fixed_types.h"
 
 class LinkPowerModel
@@ -10,12 +11,15 @@ public:
       , _link_length(link_length)
       , _link_width(link_width)
       , _total_static_power(0.0)
-      , _total_dynamic_energy(0.0)
    {}
    virtual ~LinkPowerModel() {}
 
    volatile double getStaticPower()    { return _total_static_power;    }
-   volatile double getDynamicEnergy()  { return _total_dynamic_energy;  }
+   // Only the flits are counted, the energy is computed when read
+   virtual volatile double getDynamicEnergy() = 0;
+
+   // Event counters of the stats file, named prefix + counter
+   virtual void registerEventCounters(tile_id_t tile_id, const std::string& prefix) = 0;
    
 protected:
    // Input parameters
@@ -25,5 +29,4 @@ protected:
    
    // Output parameters 
    volatile double _total_static_power;
-   volatile double _total_dynamic_energy;
 };
@@ -6,6 +6,7 @@
 #include "config.h"
 #include "network_model.h"
 #include "network.h"
+#include "statistics_manager.h"
 #include "utils.h"
 #include "log.h"
 
@@ -16,6 +17,14 @@ OpticalLinkModel::OpticalLinkModel(NetworkModel* model, UInt32 num_readers_per_w
    , _num_readers_per_wavelength(num_readers_per_wavelength)
    , _total_link_unicasts(0)
    , _total_link_broadcasts(0)
+   , _laser_gating_enabled(isLaserGatingEnabled())
+   , _laser_idle_window(0)
+   , _laser_wakeup_latency(0)
+   , _laser_last_use_time(0)
+   , _laser_ready_time(0)
+   , _total_laser_wakeups(0)
+   , _total_laser_gated_cycles(0)
+   , _total_laser_wakeup_delay(0)
 {
    double waveguide_delay_per_mm = 0.0;
    double e_o_conversion_delay = 0.0;
@@ -31,6 +40,12 @@ OpticalLinkModel::OpticalLinkModel(NetworkModel* model, UInt32 num_readers_per_w
       _laser_type = parseLaserType(Sim()->getCfg()->getString("link_model/optical/laser_type"));
       // Ring tuning
       _ring_tuning_strategy = Sim()->getCfg()->getString("link_model/optical/ring_tuning_strategy");
+      // Laser gating
+      if (_laser_gating_enabled)
+      {
+         _laser_idle_window = Sim()->getCfg()->getInt("link_model/optical/laser_gating/idle_window", 100);
+         _laser_wakeup_latency = Sim()->getCfg()->getInt("link_model/optical/laser_gating/wakeup_latency", 10);
+      }
    }
    catch (...)
    {
@@ -55,9 +70,15 @@ OpticalLinkModel::OpticalLinkModel(NetworkModel* model, UInt32 num_readers_per_w
 
    // Power Model
    if (Config::getSingleton()->getEnablePowerModeling())
+   {
       _power_model = new OpticalLinkPowerModel(_laser_modes, _laser_type, _ring_tuning_strategy,
                                                _num_readers_per_wavelength, link_frequency,
                                                waveguide_length, link_width);
+      // Power trace
+      if (Sim()->getStatisticsManager())
+         Sim()->getStatisticsManager()->registerPowerModel(_model->getTileId(), _power_model);
+      _power_model->registerEventCounters(_model->getTileId(), _model->getPowerModelCounterPrefix("Optical Link"));
+   }
 }
 
 OpticalLinkModel::~OpticalLinkModel()
@@ -66,6 +87,20 @@ OpticalLinkModel::~OpticalLinkModel()
       delete _power_model;
 }
 
+bool
+OpticalLinkModel::isLaserGatingEnabled()
+{
+   try
+   {
+      return Sim()->getCfg()->getBool("link_model/optical/laser_gating/enabled", false);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read link_model/optical/laser_gating/enabled from the cfg file");
+      return false;
+   }
+}
+
 OpticalLinkModel::LaserModes
 OpticalLinkModel::parseLaserModes(string laser_modes_str)
 {
@@ -138,7 +173,39 @@ OpticalLinkModel::processPacket(const NetPacket& pkt, SInt32 num_endpoints, UInt
       LOG_PRINT_ERROR("Num endpoints is neither 1 nor ENDPOINT_ALL: (%i)", num_endpoints);
    }
 
+   // Laser gating
+   if (_laser_gating_enabled)
+      zero_load_delay += computeLaserWakeupDelay(pkt.time, num_flits);
+
    // Update dynamic energy counters
    if (Config::getSingleton()->getEnablePowerModeling())
       _power_model->updateDynamicEnergy(num_flits, num_endpoints);
 }
+
+UInt64
+OpticalLinkModel::computeLaserWakeupDelay(UInt64 time, SInt32 num_flits)
+{
+   // The laser went off idle_window cycles after the last transmission. The
+   // packets of the send hub are seen roughly in time order, one seen late
+   // just finds the laser on
+   if (time > _laser_last_use_time + _laser_idle_window)
+   {
+      _total_laser_gated_cycles += time - (_laser_last_use_time + _laser_idle_window);
+      _total_laser_wakeups ++;
+      _laser_ready_time = time + _laser_wakeup_latency;
+   }
+
+   UInt64 delay = (_laser_ready_time > time) ? (_laser_ready_time - time) : 0;
+   _total_laser_wakeup_delay += delay;
+   _laser_last_use_time = max(_laser_last_use_time, time + delay + num_flits);
+   return delay;
+}
+
+double
+OpticalLinkModel::getLaserEnergySaved()
+{
+   if (!Config::getSingleton()->getEnablePowerModeling())
+      return 0;
+   // _frequency is in GHz
+   return _power_model->getStaticLaserPower() * (_total_laser_gated_cycles / (_frequency * 1e9));
+}
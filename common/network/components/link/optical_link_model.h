@@ -44,6 +44,16 @@ public:
    UInt64 getTotalUnicasts() const    { return _total_link_unicasts; }
    UInt64 getTotalBroadcasts() const  { return _total_link_broadcasts; }
 
+   // Laser gating ([link_model/optical/laser_gating]): the laser is turned
+   // off once the link has been idle for idle_window cycles, the next
+   // packet waits for it to wake up (in link cycles)
+   static bool isLaserGatingEnabled();
+   UInt64 getTotalLaserWakeups() const      { return _total_laser_wakeups; }
+   UInt64 getTotalLaserGatedCycles() const  { return _total_laser_gated_cycles; }
+   UInt64 getTotalLaserWakeupDelay() const  { return _total_laser_wakeup_delay; }
+   // Laser energy not spent while gated (in J)
+   double getLaserEnergySaved();
+
    // Energy Models
    OpticalLinkPowerModel* getPowerModel() { return _power_model; }
 
@@ -65,6 +75,21 @@ private:
    UInt64 _total_link_unicasts;
    UInt64 _total_link_broadcasts;
 
+   // Laser gating
+   bool _laser_gating_enabled;
+   UInt64 _laser_idle_window;
+   UInt64 _laser_wakeup_latency;
+   // End of the last transmission, and time the laser is on after its
+   // last wake-up
+   UInt64 _laser_last_use_time;
+   UInt64 _laser_ready_time;
+   UInt64 _total_laser_wakeups;
+   UInt64 _total_laser_gated_cycles;
+   UInt64 _total_laser_wakeup_delay;
+
+   // Wake-up delay of a packet sent at 'time'
+   UInt64 computeLaserWakeupDelay(UInt64 time, SInt32 num_flits);
+
    // Parse laser modes
    static LaserModes parseLaserModes(string laser_modes_str);
    static LaserType parseLaserType(string laser_type_str);
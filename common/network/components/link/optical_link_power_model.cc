@@ -1,9 +1,11 @@
 #include <cmath>
+#include <sstream>
 
 #include "optical_link_power_model.h"
 #include "simulator.h"
 #include "config.h"
 #include "utils.h"
+#include "stats_registry.h"
 #include "log.h"
 
 using namespace dsent_contrib;
@@ -14,6 +16,7 @@ OpticalLinkPowerModel::OpticalLinkPowerModel(OpticalLinkModel::LaserModes laser_
                                              float link_frequency, double waveguide_length, UInt32 link_width)
    : LinkPowerModel(link_frequency, waveguide_length, link_width)
    , _num_readers_per_wavelength(num_readers_per_wavelength)
+   , _num_flits(num_readers_per_wavelength + 1, 0)
 {
    // Tuning strategy and laser type read from config file
    // Map to dsent tuning strategy
@@ -99,11 +102,40 @@ OpticalLinkPowerModel::~OpticalLinkPowerModel()
 void
 OpticalLinkPowerModel::updateDynamicEnergy(UInt32 num_flits, SInt32 num_endpoints)
 {    
-   // Add dynamic energies
-   _total_dynamic_energy += _dsent_data_link->calc_dynamic_energy(num_flits, num_endpoints);
+   LOG_ASSERT_ERROR(num_endpoints >= 1 && num_endpoints <= (SInt32) _num_readers_per_wavelength,
+                    "Num endpoints should be between 1 and %u. Now, it is %i", _num_readers_per_wavelength, num_endpoints);
+   _num_flits[num_endpoints] += num_flits;
+}
+
+volatile double
+OpticalLinkPowerModel::getDynamicEnergy()
+{
+   double dynamic_energy = 0;
+   UInt64 total_flits = 0;
+   for (UInt32 num_endpoints = 1; num_endpoints <= _num_readers_per_wavelength; num_endpoints++)
+   {
+      if (_num_flits[num_endpoints] > 0)
+         dynamic_energy += _dsent_data_link->calc_dynamic_energy(_num_flits[num_endpoints], num_endpoints);
+      total_flits += _num_flits[num_endpoints];
+   }
    // Select network needed during unicasts/broadcasts
    if (_select_link_enabled)
-      _total_dynamic_energy += _dsent_select_link->calc_dynamic_energy(num_flits, _num_readers_per_wavelength);
+      dynamic_energy += _dsent_select_link->calc_dynamic_energy(total_flits, _num_readers_per_wavelength);
+   return dynamic_energy;
+}
+
+void
+OpticalLinkPowerModel::registerEventCounters(tile_id_t tile_id, const string& prefix)
+{
+   StatsRegistry* stats = Sim()->getStatsRegistry();
+   if (!stats)
+      return;
+   for (UInt32 num_endpoints = 1; num_endpoints <= _num_readers_per_wavelength; num_endpoints++)
+   {
+      std::ostringstream name;
+      name << prefix << "Flits to " << num_endpoints << " Readers";
+      stats->registerCounter(tile_id, name.str(), &_num_flits[num_endpoints]);
+   }
 }
 
 const string
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 using std::string;
 
 #include "optical_link_model.h"
@@ -15,8 +16,12 @@ public:
                          float link_frequency, double waveguide_length, UInt32 link_width);
    ~OpticalLinkPowerModel();
 
-   // Update Dynamic Energy
+   // Update Dynamic Energy (only the flits are counted, the energy is
+   // computed from them when read)
    void updateDynamicEnergy(UInt32 num_flits, SInt32 num_endpoints);
+   volatile double getDynamicEnergy();
+
+   void registerEventCounters(tile_id_t tile_id, const string& prefix);
    
    // Energy parameters specific to OpticalLink
    volatile double getStaticLeakagePower()      { return _static_power_leakage;     }
@@ -44,4 +49,7 @@ private:
    volatile double _static_power_leakage;
    volatile double _static_power_laser;
    volatile double _static_power_heating;
+
+   // Event Counters, indexed by the number of readers of the flits
+   std::vector<UInt64> _num_flits;
 };
@@ -1,9 +1,13 @@
 #include "router_model.h"
 #include "network_model.h"
 #include "network.h"
+#include "simulator.h"
+#include "statistics_manager.h"
 #include "utils.h"
 #include "queue_model_history_list.h"
 #include "queue_model_history_tree.h"
+#include "queue_model_history_list_fast.h"
+#include "queue_model_windowed.h"
 #include "log.h"
 
 RouterModel::RouterModel(NetworkModel* model, float frequency,
@@ -17,6 +21,11 @@ RouterModel::RouterModel(NetworkModel* model, float frequency,
    , _flit_width(flit_width)
    , _delay(delay)
    , _contention_model_enabled(contention_model_enabled)
+   , _contention_sampling_enabled(false)
+   , _detailed_window(0)
+   , _sampling_period(0)
+   , _num_sampled_packets(0)
+   , _flow_control_enabled(false)
    , _power_model(NULL)
 {
    if (_contention_model_enabled)
@@ -30,7 +39,13 @@ RouterModel::RouterModel(NetworkModel* model, float frequency,
    initializeContentionCounters();
    
    if (Config::getSingleton()->getEnablePowerModeling())
+   {
       _power_model = new RouterPowerModel(_frequency, _num_input_ports, _num_output_ports, num_flits_per_port_buffer, flit_width);
+      // Power trace
+      if (Sim()->getStatisticsManager())
+         Sim()->getStatisticsManager()->registerPowerModel(_model->getTileId(), _power_model);
+      _power_model->registerEventCounters(_model->getTileId(), _model->getPowerModelCounterPrefix("Router"));
+   }
 }
 
 RouterModel::~RouterModel()
@@ -43,6 +58,35 @@ RouterModel::~RouterModel()
       for (SInt32 i = 0; i < _num_output_ports; i++)
          delete _contention_model_list[i];
    }
+
+   for (UInt32 i = 0; i < _virtual_channel_model_list.size(); i++)
+      delete _virtual_channel_model_list[i];
+}
+
+void
+RouterModel::enableContentionSampling(UInt64 detailed_window, float sampling_ratio)
+{
+   LOG_ASSERT_ERROR(detailed_window > 0, "Contention sampling detailed window must be > 0");
+   LOG_ASSERT_ERROR((sampling_ratio > 0.0) && (sampling_ratio <= 1.0),
+                    "Contention sampling ratio(%f) must be in (0,1]", sampling_ratio);
+
+   if (!_contention_model_enabled)
+      return;
+
+   _contention_sampling_enabled = true;
+   _detailed_window = detailed_window;
+   _sampling_period = (UInt64) (detailed_window / sampling_ratio);
+   _num_sampled_packets = 0;
+}
+
+void
+RouterModel::enableFlowControl(SInt32 num_virtual_channels, SInt32 num_flits_per_vc_buffer, UInt64 credit_round_trip)
+{
+   _flow_control_enabled = true;
+   _virtual_channel_model_list.resize(_num_output_ports);
+   for (SInt32 i = 0; i < _num_output_ports; i++)
+      _virtual_channel_model_list[i] = new VirtualChannelModel(num_virtual_channels, num_flits_per_vc_buffer, credit_round_trip,
+                                                               _model->getNumVirtualChannelClasses());
 }
 
 void
@@ -79,21 +123,49 @@ RouterModel::processPacket(const NetPacket& pkt, vector<SInt32>& output_port_lis
 
    // Add to zero_load_delay
    zero_load_delay += _delay;
-  
+
+   UInt64 max_queue_delay = 0;
    if (_contention_model_enabled)
    {
-      UInt64 max_queue_delay = 0;
-      for (vector<SInt32>::iterator it = output_port_list.begin(); it != output_port_list.end(); it++)
+      bool detailed = true;
+      if (_contention_sampling_enabled)
+      {
+         detailed = (_num_sampled_packets < _detailed_window);
+         _num_sampled_packets = (_num_sampled_packets + 1) % _sampling_period;
+      }
+
+      if (detailed)
+      {
+         for (vector<SInt32>::iterator it = output_port_list.begin(); it != output_port_list.end(); it++)
+         {
+            UInt64 queue_delay = _contention_model_list[*it]->computeQueueDelay(pkt.time, num_flits);
+            max_queue_delay = max<UInt64>(max_queue_delay, queue_delay);
+         }
+      }
+      else
       {
-         UInt64 queue_delay = _contention_model_list[*it]->computeQueueDelay(pkt.time, num_flits);
-         max_queue_delay = max<UInt64>(max_queue_delay, queue_delay);
+         max_queue_delay = estimateContentionDelay(output_port_list);
       }
 
       // Add to contention_delay
       contention_delay += max_queue_delay;
 
       // Update Contention Counters
-      updateContentionCounters(max_queue_delay, output_port_list);
+      updateContentionCounters(max_queue_delay, output_port_list, detailed);
+   }
+
+   if (_flow_control_enabled)
+   {
+      // The packet holds a virtual channel on each output port from the
+      // time it wins the port
+      UInt64 max_stall_delay = 0;
+      SInt32 vc_class = _model->getVirtualChannelClass(pkt);
+      for (vector<SInt32>::iterator it = output_port_list.begin(); it != output_port_list.end(); it++)
+      {
+         UInt64 stall_delay = _virtual_channel_model_list[*it]->computeStallDelay(pkt.time + max_queue_delay, num_flits, vc_class);
+         max_stall_delay = max<UInt64>(max_stall_delay, stall_delay);
+      }
+      contention_delay += max_stall_delay;
    }
 
    // Update Event Counters
@@ -128,16 +200,42 @@ RouterModel::initializeContentionCounters()
 {
    _total_contention_delay.resize(_num_output_ports, 0);
    _total_packets.resize(_num_output_ports, 0);
+   _total_detailed_contention_delay.resize(_num_output_ports, 0);
+   _total_detailed_packets.resize(_num_output_ports, 0);
+   _recent_contention_delay.resize(_num_output_ports, 0);
 }
 
 void
-RouterModel::updateContentionCounters(UInt64 contention_delay, vector<SInt32>& output_port_list)
+RouterModel::updateContentionCounters(UInt64 contention_delay, vector<SInt32>& output_port_list, bool detailed)
 {
    for (vector<SInt32>::iterator it = output_port_list.begin(); it != output_port_list.end(); it++)
    {
       _total_contention_delay[*it] += contention_delay;
       _total_packets[*it] ++;
+      // Each packet weighs 1/8
+      _recent_contention_delay[*it] += (((float) contention_delay) - _recent_contention_delay[*it]) / 8;
+      if (detailed)
+      {
+         _total_detailed_contention_delay[*it] += contention_delay;
+         _total_detailed_packets[*it] ++;
+      }
+   }
+}
+
+UInt64
+RouterModel::estimateContentionDelay(vector<SInt32>& output_port_list)
+{
+   // The packet waits for the most congested of its output ports
+   UInt64 max_queue_delay = 0;
+   for (vector<SInt32>::iterator it = output_port_list.begin(); it != output_port_list.end(); it++)
+   {
+      UInt64 total_packets = _total_detailed_packets[*it];
+      if (total_packets == 0)
+         continue;
+      UInt64 queue_delay = (_total_detailed_contention_delay[*it] + total_packets/2) / total_packets;
+      max_queue_delay = max<UInt64>(max_queue_delay, queue_delay);
    }
+   return max_queue_delay;
 }
 
 float
@@ -161,6 +259,48 @@ RouterModel::getAverageContentionDelay(SInt32 output_port_start, SInt32 output_p
    return (total_packets > 0) ? (((float) total_contention_delay) / total_packets) : 0.0;
 }
 
+float
+RouterModel::getAverageFlowControlStallDelay(SInt32 output_port_start, SInt32 output_port_end)
+{
+   if (output_port_end == INVALID_PORT)
+      output_port_end = output_port_start;
+
+   LOG_ASSERT_ERROR(_flow_control_enabled, "Flow control not enabled");
+   LOG_ASSERT_ERROR(output_port_end >= output_port_start, "output_port_end(%i) < output_port_start(%i)",
+                    output_port_end, output_port_start);
+
+   UInt64 total_stall_delay = 0;
+   UInt64 total_packets = 0;
+   for (SInt32 i = output_port_start; i <= output_port_end; i++)
+   {
+      total_stall_delay += _virtual_channel_model_list[i]->getTotalStallDelay();
+      total_packets += _virtual_channel_model_list[i]->getTotalPackets();
+   }
+
+   return (total_packets > 0) ? (((float) total_stall_delay) / total_packets) : 0.0;
+}
+
+float
+RouterModel::getPercentPacketsStalledByFlowControl(SInt32 output_port_start, SInt32 output_port_end)
+{
+   if (output_port_end == INVALID_PORT)
+      output_port_end = output_port_start;
+
+   LOG_ASSERT_ERROR(_flow_control_enabled, "Flow control not enabled");
+   LOG_ASSERT_ERROR(output_port_end >= output_port_start, "output_port_end(%i) < output_port_start(%i)",
+                    output_port_end, output_port_start);
+
+   UInt64 total_stalled_packets = 0;
+   UInt64 total_packets = 0;
+   for (SInt32 i = output_port_start; i <= output_port_end; i++)
+   {
+      total_stalled_packets += _virtual_channel_model_list[i]->getTotalStalledPackets();
+      total_packets += _virtual_channel_model_list[i]->getTotalPackets();
+   }
+
+   return (total_packets > 0) ? (((float) total_stalled_packets * 100) / total_packets) : 0.0;
+}
+
 float
 RouterModel::getAverageLinkUtilization(SInt32 output_port_start, SInt32 output_port_end)
 {
@@ -192,8 +332,8 @@ RouterModel::getPercentAnalyticalModelsUsed(SInt32 output_port_start, SInt32 out
    UInt64 total_requests = 0;
    for (SInt32 i = output_port_start; i <= output_port_end; i++)
    {
-      assert(_total_packets[i] == _contention_model_list[i]->getTotalRequests());
-      total_requests += _total_packets[i];
+      assert(_total_detailed_packets[i] == _contention_model_list[i]->getTotalRequests());
+      total_requests += _total_detailed_packets[i];
 
       QueueModel::Type queue_model_type = _contention_model_list[i]->getType();
       if (queue_model_type == QueueModel::HISTORY_LIST)
@@ -206,7 +346,37 @@ RouterModel::getPercentAnalyticalModelsUsed(SInt32 output_port_start, SInt32 out
          QueueModelHistoryTree* queue_model = (QueueModelHistoryTree*) _contention_model_list[i];
          total_analytical_model_requests += queue_model->getTotalRequestsUsingAnalyticalModel();
       }
+      else if (queue_model_type == QueueModel::HISTORY_LIST_FAST)
+      {
+         QueueModelHistoryListFast* queue_model = (QueueModelHistoryListFast*) _contention_model_list[i];
+         total_analytical_model_requests += queue_model->getTotalRequestsUsingAnalyticalModel();
+      }
+      else if (queue_model_type == QueueModel::WINDOWED)
+      {
+         QueueModelWindowed* queue_model = (QueueModelWindowed*) _contention_model_list[i];
+         total_analytical_model_requests += queue_model->getTotalRequestsUsingAnalyticalModel();
+      }
    }
 
    return (total_requests > 0) ? (((float) total_analytical_model_requests * 100) / total_requests) : 0.0;
 }
+
+float
+RouterModel::getPercentPacketsFastForwarded(SInt32 output_port_start, SInt32 output_port_end)
+{
+   if (output_port_end == INVALID_PORT)
+      output_port_end = output_port_start;
+
+   LOG_ASSERT_ERROR(output_port_end >= output_port_start, "output_port_end(%i) < output_port_start(%i)",
+                    output_port_end, output_port_start);
+
+   UInt64 total_fast_forwarded_packets = 0;
+   UInt64 total_packets = 0;
+   for (SInt32 i = output_port_start; i <= output_port_end; i++)
+   {
+      total_fast_forwarded_packets += _total_packets[i] - _total_detailed_packets[i];
+      total_packets += _total_packets[i];
+   }
+
+   return (total_packets > 0) ? (((float) total_fast_forwarded_packets * 100) / total_packets) : 0.0;
+}
@@ -8,6 +8,7 @@ using std::vector;
 #include "fixed_types.h"
 #include "queue_model.h"
 #include "router_power_model.h"
+#include "virtual_channel_model.h"
 
 class NetworkModel;
 class NetPacket;
@@ -21,6 +22,16 @@ public:
                bool contention_model_enabled, string& contention_model_type);
    ~RouterModel();
 
+   // Sampled contention modeling: out of every (detailed_window / sampling_ratio)
+   // packets, the first detailed_window go through the queue models and the
+   // rest are charged the per-port average contention delay those saw
+   void enableContentionSampling(UInt64 detailed_window, float sampling_ratio);
+   // Finite-buffer flow control: num_virtual_channels per output port, each
+   // with num_flits_per_vc_buffer flits at the next router, credits back
+   // credit_round_trip cycles after a flit leaves (see VirtualChannelModel).
+   // The stalls add to the contention delay
+   void enableFlowControl(SInt32 num_virtual_channels, SInt32 num_flits_per_vc_buffer, UInt64 credit_round_trip);
+
    void processPacket(const NetPacket& pkt, SInt32 output_port,
                       UInt64& zero_load_delay, UInt64& contention_delay);
    void processPacket(const NetPacket& pkt, vector<SInt32>& output_port_list,
@@ -42,6 +53,14 @@ public:
    float getAverageLinkUtilization(SInt32 output_port_start, SInt32 output_port_end = INVALID_PORT);
    // Percent Analytical Model Used
    float getPercentAnalyticalModelsUsed(SInt32 output_port_start, SInt32 output_port_end = INVALID_PORT);
+   // Percent of packets fast-forwarded by contention sampling
+   float getPercentPacketsFastForwarded(SInt32 output_port_start, SInt32 output_port_end = INVALID_PORT);
+   // Flow control stalls
+   float getAverageFlowControlStallDelay(SInt32 output_port_start, SInt32 output_port_end = INVALID_PORT);
+   float getPercentPacketsStalledByFlowControl(SInt32 output_port_start, SInt32 output_port_end = INVALID_PORT);
+   // Contention delay of the last packets on an output port (moving average,
+   // in cycles), the congestion estimate of adaptive routing
+   float getRecentContentionDelay(SInt32 output_port) { return _recent_contention_delay[output_port]; }
 
    static const SInt32 OUTPUT_PORT_ALL = 0xbabecafe;
    static const SInt32 INVALID_PORT = 0xdeadbeef;
@@ -56,6 +75,16 @@ private:
    bool _contention_model_enabled;
    vector<QueueModel*> _contention_model_list;
 
+   // Contention Sampling
+   bool _contention_sampling_enabled;
+   UInt64 _detailed_window;
+   UInt64 _sampling_period;
+   UInt64 _num_sampled_packets;
+
+   // Flow Control
+   bool _flow_control_enabled;
+   vector<VirtualChannelModel*> _virtual_channel_model_list;
+
    // Event Counters
    UInt64 _total_buffer_writes;
    UInt64 _total_buffer_reads;
@@ -68,6 +97,10 @@ private:
    // Contention Counters
    vector<UInt64> _total_contention_delay;
    vector<UInt64> _total_packets;
+   // Packets that went through the queue models (all of them without sampling)
+   vector<UInt64> _total_detailed_contention_delay;
+   vector<UInt64> _total_detailed_packets;
+   vector<float> _recent_contention_delay;
 
    // Initialize Event Counters
    void initializeEventCounters();
@@ -76,5 +109,7 @@ private:
    // Initialize Contention Counters
    void initializeContentionCounters();
    // Update Contention Counters
-   void updateContentionCounters(UInt64 contention_delay, vector<SInt32>& output_port_list);
+   void updateContentionCounters(UInt64 contention_delay, vector<SInt32>& output_port_list, bool detailed);
+   // Contention delay estimated from the detailed samples
+   UInt64 estimateContentionDelay(vector<SInt32>& output_port_list);
 };
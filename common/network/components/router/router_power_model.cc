@@ -1,5 +1,8 @@
 #include <cmath>
+#include <sstream>
 #include "router_power_model.h"
+#include "simulator.h"
+#include "stats_registry.h"
 #include "log.h"
 
 using namespace dsent_contrib;
@@ -25,10 +28,13 @@ RouterPowerModel::~RouterPowerModel()
 void
 RouterPowerModel::initializeCounters()
 {
-   _total_dynamic_energy_buffer = 0;
-   _total_dynamic_energy_crossbar = 0;
-   _total_dynamic_energy_switch_allocator = 0;
-   _total_dynamic_energy_clock = 0;
+   _contention = ceil((1.0*_num_input_ports)/2);
+
+   _num_buffer_writes = 0;
+   _num_buffer_reads = 0;
+   _num_crossbar_traversals.assign(_num_output_ports + 1, 0);
+   _num_switch_allocator_requests = 0;
+   _num_clock_events = 0;
 }
 
 void
@@ -38,51 +44,63 @@ RouterPowerModel::updateDynamicEnergy(UInt32 num_flits, UInt32 num_packets, UInt
                     "Multicast idx should be between >= 1 (and) <= %u. Now, it is %u",
                     _num_output_ports, multicast_idx);
 
-   UInt32 contention = ceil((1.0*_num_input_ports)/2);
-
    // Buffer write
-   updateDynamicEnergyBufferWrite(num_flits);
+   _num_buffer_writes += num_flits;
    // Switch allocator
-   updateDynamicEnergySwitchAllocator(contention, num_packets);
+   _num_switch_allocator_requests += _contention * num_packets;
    // Buffer read
-   updateDynamicEnergyBufferRead(num_flits);
+   _num_buffer_reads += num_flits;
    // Crossbar
-   updateDynamicEnergyCrossbar(num_flits, multicast_idx);
+   _num_crossbar_traversals[multicast_idx] += num_flits;
    // Clock - pretty much always on...not sure how to add the context of these variables
-   updateDynamicEnergyClock(3 * num_flits + num_packets);
+   _num_clock_events += 3 * num_flits + num_packets;
 }
 
 void
-RouterPowerModel::updateDynamicEnergyBufferWrite(UInt32 num_flits)
+RouterPowerModel::registerEventCounters(tile_id_t tile_id, const std::string& prefix)
 {
-   volatile double dynamic_energy_buffer = _dsent_router->calc_dynamic_energy_buf_write(num_flits);
-   _total_dynamic_energy_buffer += dynamic_energy_buffer;
+   StatsRegistry* stats = Sim()->getStatsRegistry();
+   if (!stats)
+      return;
+   stats->registerCounter(tile_id, prefix + "Buffer Writes", &_num_buffer_writes);
+   stats->registerCounter(tile_id, prefix + "Buffer Reads", &_num_buffer_reads);
+   for (UInt32 multicast_idx = 1; multicast_idx <= _num_output_ports; multicast_idx++)
+   {
+      std::ostringstream name;
+      name << prefix << "Crossbar Traversals to " << multicast_idx << " Ports";
+      stats->registerCounter(tile_id, name.str(), &_num_crossbar_traversals[multicast_idx]);
+   }
+   stats->registerCounter(tile_id, prefix + "Switch Allocator Requests", &_num_switch_allocator_requests);
+   stats->registerCounter(tile_id, prefix + "Clock Events", &_num_clock_events);
 }
 
-void
-RouterPowerModel::updateDynamicEnergyBufferRead(UInt32 num_flits)
+volatile double
+RouterPowerModel::getDynamicEnergyBuffer()
 {
-   volatile double dynamic_energy_buffer = _dsent_router->calc_dynamic_energy_buf_read(num_flits);
-   _total_dynamic_energy_buffer += dynamic_energy_buffer;
+   return (_dsent_router->calc_dynamic_energy_buf_write(_num_buffer_writes) +
+           _dsent_router->calc_dynamic_energy_buf_read(_num_buffer_reads));
 }
 
-void
-RouterPowerModel::updateDynamicEnergyCrossbar(UInt32 num_flits, UInt32 multicast_idx)
+volatile double
+RouterPowerModel::getDynamicEnergyCrossbar()
 {
-   volatile double dynamic_energy_crossbar = _dsent_router->calc_dynamic_energy_xbar(num_flits, multicast_idx);
-   _total_dynamic_energy_crossbar += dynamic_energy_crossbar;
+   double dynamic_energy_crossbar = 0;
+   for (UInt32 multicast_idx = 1; multicast_idx <= _num_output_ports; multicast_idx++)
+   {
+      if (_num_crossbar_traversals[multicast_idx] > 0)
+         dynamic_energy_crossbar += _dsent_router->calc_dynamic_energy_xbar(_num_crossbar_traversals[multicast_idx], multicast_idx);
+   }
+   return dynamic_energy_crossbar;
 }
 
-void
-RouterPowerModel::updateDynamicEnergySwitchAllocator(UInt32 num_requests_per_packet, UInt32 num_packets)
+volatile double
+RouterPowerModel::getDynamicEnergySwitchAllocator()
 {
-   volatile double dynamic_energy_switch_allocator = _dsent_router->calc_dynamic_energy_sa(num_requests_per_packet);
-   _total_dynamic_energy_switch_allocator += (num_packets * dynamic_energy_switch_allocator);
+   return _dsent_router->calc_dynamic_energy_sa(_num_switch_allocator_requests);
 }
 
-void
-RouterPowerModel::updateDynamicEnergyClock(UInt32 num_events)
+volatile double
+RouterPowerModel::getDynamicEnergyClock()
 {
-   volatile double dynamic_energy_clock = _dsent_router->calc_dynamic_energy_clock(num_events);
-   _total_dynamic_energy_clock += dynamic_energy_clock;
+   return _dsent_router->calc_dynamic_energy_clock(_num_clock_events);
 }
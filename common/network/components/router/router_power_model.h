@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+#include <string>
 #include "fixed_types.h"
 #include "contrib/dsent/dsent_contrib.h"
 
@@ -9,19 +11,20 @@ public:
    RouterPowerModel(float frequency, UInt32 num_input_ports, UInt32 num_output_ports, UInt32 num_flits_per_port_buffer, UInt32 flit_width);
    ~RouterPowerModel();
 
-   // Update Dynamic Energy
+   // Update Dynamic Energy (only the events are counted, the energy is
+   // computed from them when read)
    void updateDynamicEnergy(UInt32 num_flits, UInt32 num_packets, UInt32 multicast_idx = 1);
    
    // Get Dynamic Energy
    volatile double getDynamicEnergy()
    {  
-      return (_total_dynamic_energy_buffer + _total_dynamic_energy_crossbar + 
-              _total_dynamic_energy_switch_allocator + _total_dynamic_energy_clock);
+      return (getDynamicEnergyBuffer() + getDynamicEnergyCrossbar() + 
+              getDynamicEnergySwitchAllocator() + getDynamicEnergyClock());
    }
-   volatile double getDynamicEnergyBuffer()           { return _total_dynamic_energy_buffer;             }
-   volatile double getDynamicEnergyCrossbar()         { return _total_dynamic_energy_crossbar;           }
-   volatile double getDynamicEnergySwitchAllocator()  { return _total_dynamic_energy_switch_allocator;   }
-   volatile double getDynamicEnergyClock()            { return _total_dynamic_energy_clock;              }
+   volatile double getDynamicEnergyBuffer();
+   volatile double getDynamicEnergyCrossbar();
+   volatile double getDynamicEnergySwitchAllocator();
+   volatile double getDynamicEnergyClock();
    
    // Static Power
    volatile double getStaticPowerBuffer()             { return _dsent_router->get_static_power_buf();    }
@@ -34,6 +37,9 @@ public:
               _dsent_router->get_static_power_sa() + _dsent_router->get_static_power_clock());
    }
 
+   // Event counters of the stats file, named prefix + counter
+   void registerEventCounters(tile_id_t tile_id, const std::string& prefix);
+
 private:
    volatile float _frequency;
    UInt32 _num_input_ports;
@@ -43,16 +49,16 @@ private:
 
    dsent_contrib::DSENTRouter* _dsent_router;
 
-   volatile double _total_dynamic_energy_buffer;
-   volatile double _total_dynamic_energy_crossbar;
-   volatile double _total_dynamic_energy_switch_allocator;
-   volatile double _total_dynamic_energy_clock;
+   // Requests to the switch allocator per packet
+   UInt32 _contention;
+
+   // Event Counters
+   UInt64 _num_buffer_writes;
+   UInt64 _num_buffer_reads;
+   // Indexed by the number of output ports of the flits
+   std::vector<UInt64> _num_crossbar_traversals;
+   UInt64 _num_switch_allocator_requests;
+   UInt64 _num_clock_events;
 
    void initializeCounters();
-   
-   void updateDynamicEnergyBufferWrite(UInt32 num_flits);
-   void updateDynamicEnergyBufferRead(UInt32 num_flits);
-   void updateDynamicEnergyCrossbar(UInt32 num_flits, UInt32 multicast_idx);
-   void updateDynamicEnergySwitchAllocator(UInt32 num_requests_per_packet, UInt32 num_packets);
-   void updateDynamicEnergyClock(UInt32 num_events);
 };
@@ -0,0 +1,83 @@
+#include "virtual_channel_model.h"
+#include "log.h"
+
+VirtualChannelModel::VirtualChannelModel(SInt32 num_virtual_channels, SInt32 num_flits_per_vc_buffer,
+                                         UInt64 credit_round_trip, SInt32 num_classes)
+   : _num_virtual_channels(num_virtual_channels)
+   , _credit_round_trip(credit_round_trip)
+   , _held_mask(0)
+   , _total_packets(0)
+   , _total_stalled_packets(0)
+   , _total_stall_delay(0)
+{
+   LOG_ASSERT_ERROR((num_virtual_channels >= 1) && (num_virtual_channels <= MAX_VIRTUAL_CHANNELS),
+                    "Number of virtual channels(%i) must be in [1,%i]", num_virtual_channels, MAX_VIRTUAL_CHANNELS);
+   LOG_ASSERT_ERROR(num_flits_per_vc_buffer >= 1, "Virtual channel buffer(%i flits) must hold a flit", num_flits_per_vc_buffer);
+   LOG_ASSERT_ERROR((num_classes >= 1) && (num_classes <= num_virtual_channels),
+                    "Each of the %i classes of packets needs a virtual channel, there are %i",
+                    num_classes, num_virtual_channels);
+
+   // A flit per cycle if the buffer covers the credit round trip
+   _cycles_per_flit = (credit_round_trip + num_flits_per_vc_buffer - 1) / num_flits_per_vc_buffer;
+   if (_cycles_per_flit < 1)
+      _cycles_per_flit = 1;
+
+   _free_time.resize(_num_virtual_channels, 0);
+
+   _class_masks.resize(num_classes, 0);
+   for (SInt32 i = 0; i < _num_virtual_channels; i++)
+      _class_masks[i % num_classes] |= (1U << i);
+}
+
+VirtualChannelModel::~VirtualChannelModel()
+{}
+
+UInt64
+VirtualChannelModel::computeStallDelay(UInt64 time, SInt32 num_flits, SInt32 vc_class)
+{
+   // Release the channels whose credits are back
+   UInt32 held_mask = _held_mask;
+   while (held_mask)
+   {
+      SInt32 vc = __builtin_ctz(held_mask);
+      held_mask &= (held_mask - 1);
+      if (_free_time[vc] <= time)
+         _held_mask &= ~(1U << vc);
+   }
+
+   SInt32 vc;
+   UInt64 stall_delay = 0;
+   UInt32 class_mask = _class_masks[vc_class];
+   UInt32 free_mask = class_mask & ~_held_mask;
+   if (free_mask)
+   {
+      vc = __builtin_ctz(free_mask);
+   }
+   else
+   {
+      // Wait for the first channel of the class to free
+      vc = __builtin_ctz(class_mask);
+      UInt32 mask = class_mask & (class_mask - 1);
+      while (mask)
+      {
+         SInt32 i = __builtin_ctz(mask);
+         mask &= (mask - 1);
+         if (_free_time[i] < _free_time[vc])
+            vc = i;
+      }
+      stall_delay = _free_time[vc] - time;
+   }
+
+   // Transfer throttled by the credits
+   UInt64 transfer_time = num_flits * _cycles_per_flit;
+   stall_delay += transfer_time - num_flits;
+
+   _free_time[vc] = time + stall_delay + num_flits + _credit_round_trip;
+   _held_mask |= (1U << vc);
+
+   _total_packets ++;
+   if (stall_delay > 0)
+      _total_stalled_packets ++;
+   _total_stall_delay += stall_delay;
+   return stall_delay;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+using std::vector;
+
+#include "fixed_types.h"
+
+/*
+  Virtual channels of one router output port, with credit-based flow control
+  into the finite input buffers of the next router.
+
+  A packet holds a virtual channel from the time it wins the output port
+  until the credit of its tail returns, i.e., its transfer plus the credit
+  round trip (link, next router and credit return). When every channel is
+  held the packet stalls until the first one frees (buffer-full stall / head
+  of line blocking). A channel buffer that is shallower than the credit
+  round trip also throttles the transfer, to num_flits_per_vc_buffer flits
+  per round trip.
+
+  With several classes of packets (the static networks that share a network
+  model, see network/shared_networks), channel i belongs to class
+  i % num_classes, and a packet only takes a channel of its class: the
+  classes share the port but do not block each other's channels.
+
+  The held channels are a bitmask, so a packet costs a pass over the held
+  ones. Like the history queue models, channels are allocated in the order
+  the packets are seen, not in the order of their times.
+ */
+class VirtualChannelModel
+{
+public:
+   VirtualChannelModel(SInt32 num_virtual_channels, SInt32 num_flits_per_vc_buffer, UInt64 credit_round_trip,
+                       SInt32 num_classes = 1);
+   ~VirtualChannelModel();
+
+   // Stall (in cycles) of a packet of num_flits that wins the output port
+   // of class 'vc_class' at 'time', before and during its transfer
+   UInt64 computeStallDelay(UInt64 time, SInt32 num_flits, SInt32 vc_class = 0);
+
+   UInt64 getTotalPackets()           { return _total_packets; }
+   UInt64 getTotalStalledPackets()    { return _total_stalled_packets; }
+   UInt64 getTotalStallDelay()        { return _total_stall_delay; }
+
+   static const SInt32 MAX_VIRTUAL_CHANNELS = 32;
+
+private:
+   SInt32 _num_virtual_channels;
+   UInt64 _credit_round_trip;
+   UInt64 _cycles_per_flit;
+
+   UInt32 _held_mask;
+   vector<UInt64> _free_time;
+   // Channels of each class
+   vector<UInt32> _class_masks;
+
+   // Counters
+   UInt64 _total_packets;
+   UInt64 _total_stalled_packets;
+   UInt64 _total_stall_delay;
+};
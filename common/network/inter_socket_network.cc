@@ -0,0 +1,90 @@
+#include <cmath>
+
+#include "inter_socket_network.h"
+#include "simulator.h"
+#include "config.h"
+#include "queue_model.h"
+#include "log.h"
+
+using namespace std;
+
+InterSocketNetwork::InterSocketNetwork()
+   : _num_sockets(Config::getSingleton()->getNumSockets())
+   , _link_latency(0)
+   , _link_bandwidth(0)
+{
+   _links = new Link[_num_sockets * _num_sockets];
+
+   bool queue_model_enabled = false;
+   string queue_model_type;
+   try
+   {
+      _link_latency = Sim()->getCfg()->getInt("socket/link_latency", 40);
+      _link_bandwidth = Sim()->getCfg()->getFloat("socket/link_bandwidth", 20.0);
+      queue_model_enabled = Sim()->getCfg()->getBool("socket/queue_model/enabled", true);
+      queue_model_type = Sim()->getCfg()->getString("socket/queue_model/type", "history_tree");
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read [socket] parameters from the cfg file");
+   }
+   LOG_ASSERT_ERROR(_link_bandwidth > 0, "socket/link_bandwidth(%g) must be > 0", _link_bandwidth);
+
+   for (UInt32 i = 0; i < _num_sockets * _num_sockets; i++)
+   {
+      if (queue_model_enabled && ((i / _num_sockets) != (i % _num_sockets)))
+         _links[i].queue_model = QueueModel::create(queue_model_type, 1);
+   }
+}
+
+InterSocketNetwork::~InterSocketNetwork()
+{
+   for (UInt32 i = 0; i < _num_sockets * _num_sockets; i++)
+      delete _links[i].queue_model;
+   delete [] _links;
+}
+
+UInt64
+InterSocketNetwork::computeDelay(UInt32 sender, UInt32 receiver, UInt64 time, UInt32 length, UInt64& queue_delay)
+{
+   assert((sender < _num_sockets) && (receiver < _num_sockets));
+   queue_delay = 0;
+   if (sender == receiver)
+      return 0;
+
+   UInt64 serialization_delay = (UInt64) ceil(length / _link_bandwidth);
+   if (serialization_delay == 0)
+      serialization_delay = 1;
+
+   Link& link = _links[sender * _num_sockets + receiver];
+   ScopedLock sl(link.lock);
+   if (link.queue_model)
+      queue_delay = link.queue_model->computeQueueDelay(time, serialization_delay);
+   link.total_packets ++;
+   link.total_bytes += length;
+   link.total_queue_delay += queue_delay;
+   return _link_latency + serialization_delay + queue_delay;
+}
+
+void
+InterSocketNetwork::outputSummary(ostream& out)
+{
+   // The packets received by the tiles of this process
+   out << "Inter-Socket Network Summary:" << endl;
+   for (UInt32 sender = 0; sender < _num_sockets; sender++)
+   {
+      for (UInt32 receiver = 0; receiver < _num_sockets; receiver++)
+      {
+         if (sender == receiver)
+            continue;
+         const Link& link = _links[sender * _num_sockets + receiver];
+         out << "  Link " << sender << " -> " << receiver << ":" << endl;
+         out << "    Total Packets: " << link.total_packets << endl;
+         out << "    Total Bytes: " << link.total_bytes << endl;
+         out << "    Average Queue Delay (in ns): ";
+         if (link.total_packets > 0)
+            out << ((double) link.total_queue_delay) / link.total_packets;
+         out << endl;
+      }
+   }
+}
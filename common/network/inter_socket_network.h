@@ -0,0 +1,52 @@
+#ifndef INTER_SOCKET_NETWORK_H
+#define INTER_SOCKET_NETWORK_H
+
+#include <iostream>
+
+#include "fixed_types.h"
+#include "lock.h"
+
+class QueueModel;
+
+// Point-to-point links between every pair of sockets ([socket]), like the
+// QPI/UPI links of a 2-4 socket server. The network models of the tiles
+// route a packet on their own network as if the sockets were one chip; a
+// packet received from a tile of another socket also pays the latency and
+// the serialization of the link between the two sockets, and the queueing
+// behind the other packets on it (one queue model per direction, shared by
+// the tiles of the process). The coherence of the lines shared across the
+// sockets goes through the directory of their home tile, the memory of a
+// socket is the DRAM controllers of its tiles.
+class InterSocketNetwork
+{
+public:
+   InterSocketNetwork();
+   ~InterSocketNetwork();
+
+   // Delay (in ns) of a packet of 'length' bytes sent at 'time' (in ns)
+   // from socket 'sender' to socket 'receiver', 'queue_delay' of it behind
+   // the other packets
+   UInt64 computeDelay(UInt32 sender, UInt32 receiver, UInt64 time, UInt32 length, UInt64& queue_delay);
+
+   void outputSummary(std::ostream& out);
+
+private:
+   struct Link
+   {
+      Link() : queue_model(NULL), total_packets(0), total_bytes(0), total_queue_delay(0) {}
+
+      Lock lock;
+      QueueModel* queue_model;
+      UInt64 total_packets;
+      UInt64 total_bytes;
+      UInt64 total_queue_delay;
+   };
+
+   UInt32 _num_sockets;
+   UInt64 _link_latency;      // In ns
+   double _link_bandwidth;    // In bytes per ns (GB/s)
+   // Directed link from socket i to socket j at i * _num_sockets + j
+   Link* _links;
+};
+
+#endif // INTER_SOCKET_NETWORK_H
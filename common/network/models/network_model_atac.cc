@@ -1,5 +1,6 @@
 #include <math.h>
 #include <vector>
+#include <algorithm>
 using namespace std;
 
 #include "network_model_atac.h"
@@ -32,6 +33,9 @@ SInt32 NetworkModelAtac::_sub_cluster_width;
 SInt32 NetworkModelAtac::_sub_cluster_height;
 // Cluster Boundaries and Access Points
 vector<NetworkModelAtac::ClusterInfo> NetworkModelAtac::_cluster_info_list;
+// Per Tile Cluster Info and Global Routes
+vector<NetworkModelAtac::TileInfo> NetworkModelAtac::_tile_info_list;
+vector<UInt8> NetworkModelAtac::_global_route_table;
 // Type of Receive Network
 NetworkModelAtac::ReceiveNetType NetworkModelAtac::_receive_net_type;
 // Num Receive Nets
@@ -41,9 +45,12 @@ NetworkModelAtac::GlobalRoutingStrategy NetworkModelAtac::_global_routing_strate
 SInt32 NetworkModelAtac::_unicast_distance_threshold;
 // Is contention model enabled?
 bool NetworkModelAtac::_contention_model_enabled;
+NetworkModelAtac::ONetChannelType NetworkModelAtac::_onet_channel_type;
+UInt64 NetworkModelAtac::_token_hop_delay;
 
 NetworkModelAtac::NetworkModelAtac(Network *net, SInt32 network_id):
    NetworkModel(net, network_id)
+   , _onet_channel(NULL)
 {
    try
    {
@@ -96,6 +103,8 @@ NetworkModelAtac::initializeANetTopologyParams()
 
       // Is contention model enabled?
       _contention_model_enabled = Sim()->getCfg()->getBool("network/atac/queue_model/enabled");
+      _onet_channel_type = parseONetChannelType(Sim()->getCfg()->getString("network/atac/onet/channel_model", "hub_queues"));
+      _token_hop_delay = (UInt64) Sim()->getCfg()->getInt("network/atac/onet/token_hop_delay", 1);
    }
    catch (...)
    {
@@ -124,6 +133,7 @@ NetworkModelAtac::initializeANetTopologyParams()
    _enet_height = _enet_width;
    
    initializeClusters();
+   initializeRoutingTables();
 }
 
 void
@@ -214,11 +224,14 @@ NetworkModelAtac::createANetRouterAndLinkModels()
    // All on Tiles with Hubs only
    if (_tile_id == getTileIDWithOpticalHub(getClusterID(_tile_id)))
    {
+      // The channel models take the contention of the hub and star net routers
+      bool hub_queues_enabled = _contention_model_enabled && !isChannelModelEnabled();
+
       // Send Hub Router
       // Performance Model
       _send_hub_router = new RouterModel(this, _frequency, _num_access_points_per_cluster, 1 /* num_output_ports */,
                                          num_flits_per_output_buffer_send_hub_router, send_hub_router_delay, _flit_width,
-                                         _contention_model_enabled, contention_model_type);
+                                         hub_queues_enabled, contention_model_type);
 
       // Optical Network Link Models
       volatile double waveguide_length = computeOpticalLinkLength();   // In mm
@@ -228,7 +241,30 @@ NetworkModelAtac::createANetRouterAndLinkModels()
       // Receive Hub Router Models
       _receive_hub_router = new RouterModel(this, _frequency, _num_clusters, _num_receive_networks_per_cluster,
                                             num_flits_per_output_buffer_receive_hub_router, receive_hub_router_delay, _flit_width,
-                                            _contention_model_enabled, contention_model_type);
+                                            hub_queues_enabled, contention_model_type);
+
+      // Channel Models
+      if (isChannelModelEnabled())
+      {
+         if (_onet_channel_type == SWMR)
+            _onet_channel = new ChannelModel();
+         else // (_onet_channel_type == MWSR)
+            _onet_channel = new ChannelModel(_num_clusters, _token_hop_delay);
+
+         _receive_hub_channel_list.resize(_num_receive_networks_per_cluster);
+         for (SInt32 i = 0; i < _num_receive_networks_per_cluster; i++)
+            _receive_hub_channel_list[i] = new ChannelModel();
+         if (_receive_net_type == STAR)
+         {
+            _star_net_channel_list.resize(_num_receive_networks_per_cluster);
+            for (SInt32 i = 0; i < _num_receive_networks_per_cluster; i++)
+            {
+               _star_net_channel_list[i].resize(_cluster_size);
+               for (SInt32 j = 0; j < _cluster_size; j++)
+                  _star_net_channel_list[i][j] = new ChannelModel();
+            }
+         }
+      }
 
          // Receive Net
       if (_receive_net_type == BTREE) // Broadcast-Tree
@@ -254,11 +290,10 @@ NetworkModelAtac::createANetRouterAndLinkModels()
             // Star Net Router
             _star_net_router_list[i] = new RouterModel(this, _frequency, 1 /* num_input_ports */, _cluster_size,
                                                        num_flits_per_output_buffer_star_net_router, star_net_router_delay, _flit_width,
-                                                       _contention_model_enabled, contention_model_type);
+                                                       hub_queues_enabled, contention_model_type);
 
             // Star Net Link
-            vector<tile_id_t> tile_id_list;
-            getTileIDListInCluster(getClusterID(_tile_id), tile_id_list);
+            const vector<tile_id_t>& tile_id_list = getTileIDListInCluster(getClusterID(_tile_id));
             assert(_cluster_size == (SInt32) tile_id_list.size());
 
             _star_net_link_list[i].resize(_cluster_size);
@@ -321,6 +356,16 @@ NetworkModelAtac::destroyANetRouterAndLinkModels()
                delete _star_net_link_list[i][j];
          }
       }
+
+      // Channel Models
+      delete _onet_channel;
+      for (UInt32 i = 0; i < _receive_hub_channel_list.size(); i++)
+         delete _receive_hub_channel_list[i];
+      for (UInt32 i = 0; i < _star_net_channel_list.size(); i++)
+      {
+         for (UInt32 j = 0; j < _star_net_channel_list[i].size(); j++)
+            delete _star_net_channel_list[i][j];
+      }
    }
 }
 
@@ -427,6 +472,8 @@ NetworkModelAtac::routePacketOnONet(const NetPacket& pkt, tile_id_t pkt_sender,
             UInt64 contention_delay = 0;
 
             _send_hub_router->processPacket(pkt, 0, zero_load_delay, contention_delay);
+            if (_onet_channel_type == SWMR)
+               contention_delay += computeChannelDelay(_onet_channel, pkt, pkt.time);
             _optical_link->processPacket(pkt, OpticalLinkModel::ENDPOINT_ALL, zero_load_delay);
             
             for (SInt32 i = 0; i < _num_clusters; i++)
@@ -443,6 +490,8 @@ NetworkModelAtac::routePacketOnONet(const NetPacket& pkt, tile_id_t pkt_sender,
                UInt64 contention_delay = 0;
 
                _send_hub_router->processPacket(pkt, 0, zero_load_delay, contention_delay);
+               if (_onet_channel_type == SWMR)
+                  contention_delay += computeChannelDelay(_onet_channel, pkt, pkt.time);
                _optical_link->processPacket(pkt, 1 /* send to only 1 endpoint */, zero_load_delay);
               
                LOG_PRINT("Cluster: %i, Contention delay: %llu", i, contention_delay); 
@@ -461,6 +510,8 @@ NetworkModelAtac::routePacketOnONet(const NetPacket& pkt, tile_id_t pkt_sender,
          UInt64 contention_delay = 0;
 
          _send_hub_router->processPacket(pkt, 0, zero_load_delay, contention_delay);
+         if (_onet_channel_type == SWMR)
+            contention_delay += computeChannelDelay(_onet_channel, pkt, pkt.time);
          _optical_link->processPacket(pkt, 1 /* send to only 1 endpoint */, zero_load_delay);
 
          Hop hop(pkt, getTileIDWithOpticalHub(getClusterID(pkt_receiver)), RECEIVE_HUB, zero_load_delay, contention_delay);
@@ -470,8 +521,7 @@ NetworkModelAtac::routePacketOnONet(const NetPacket& pkt, tile_id_t pkt_sender,
 
    else if (pkt.node_type == RECEIVE_HUB)
    {
-      vector<tile_id_t> tile_id_list;
-      getTileIDListInCluster(getClusterID(_tile_id), tile_id_list);
+      const vector<tile_id_t>& tile_id_list = getTileIDListInCluster(getClusterID(_tile_id));
       assert(_cluster_size == (SInt32) tile_id_list.size());
 
       // get receive net id
@@ -483,6 +533,14 @@ NetworkModelAtac::routePacketOnONet(const NetPacket& pkt, tile_id_t pkt_sender,
       // Receive Hub Router
       // Update router event counters, get delay, update dynamic energy
       _receive_hub_router->processPacket(pkt, receive_net_id, zero_load_delay, contention_delay);
+      if (isChannelModelEnabled())
+      {
+         // The packet wins the waveguide of this cluster (MWSR), then the
+         // link into its receive net
+         if (_onet_channel_type == MWSR)
+            contention_delay += computeChannelDelay(_onet_channel, pkt, pkt.time, getClusterID(pkt_sender));
+         contention_delay += computeChannelDelay(_receive_hub_channel_list[receive_net_id], pkt, pkt.time + contention_delay);
+      }
 
       if (_receive_net_type == BTREE)
       {
@@ -494,6 +552,17 @@ NetworkModelAtac::routePacketOnONet(const NetPacket& pkt, tile_id_t pkt_sender,
          if (pkt_receiver == NetPacket::BROADCAST)
          {
             _star_net_router_list[receive_net_id]->processPacket(pkt, RouterModel::OUTPUT_PORT_ALL, zero_load_delay, contention_delay);
+            if (isChannelModelEnabled())
+            {
+               // The receivers of all the tiles of the cluster
+               UInt64 max_channel_delay = 0;
+               for (SInt32 i = 0; i < _cluster_size; i++)
+               {
+                  UInt64 channel_delay = computeChannelDelay(_star_net_channel_list[receive_net_id][i], pkt, pkt.time + contention_delay);
+                  max_channel_delay = max<UInt64>(max_channel_delay, channel_delay);
+               }
+               contention_delay += max_channel_delay;
+            }
             // For links, compute max_delay
             UInt64 max_link_delay = 0;
             for (SInt32 i = 0; i < _cluster_size; i++)
@@ -506,17 +575,19 @@ NetworkModelAtac::routePacketOnONet(const NetPacket& pkt, tile_id_t pkt_sender,
          }
          else // (pkt_receiver != NetPacket::BROADCAST)
          {
-            SInt32 idx = getIndexInList(pkt_receiver, tile_id_list);
+            SInt32 idx = _tile_info_list[pkt_receiver]._index_in_cluster;
             assert(idx >= 0 && idx < (SInt32) _cluster_size);
 
             _star_net_router_list[receive_net_id]->processPacket(pkt, idx, zero_load_delay, contention_delay);
+            if (isChannelModelEnabled())
+               contention_delay += computeChannelDelay(_star_net_channel_list[receive_net_id][idx], pkt, pkt.time + contention_delay);
             _star_net_link_list[receive_net_id][idx]->processPacket(pkt, zero_load_delay);
          }
       }
 
       if (pkt_receiver == NetPacket::BROADCAST)
       {
-         for (vector<tile_id_t>::iterator it = tile_id_list.begin(); it != tile_id_list.end(); it++)
+         for (vector<tile_id_t>::const_iterator it = tile_id_list.begin(); it != tile_id_list.end(); it++)
          {
             Hop hop(pkt, *it, RECEIVE_TILE, zero_load_delay, contention_delay);
             next_hops.push(hop);
@@ -543,6 +614,8 @@ NetworkModelAtac::outputSummary(ostream &out)
    outputEventCountSummary(out);
    if (_contention_model_enabled)
       outputContentionModelsSummary(out);
+   if (isChannelModelEnabled())
+      outputChannelModelsSummary(out);
 }
 
 volatile double
@@ -647,8 +720,66 @@ NetworkModelAtac::initializeAccessPointList(SInt32 cluster_id)
    }
 }
 
+void
+NetworkModelAtac::initializeRoutingTables()
+{
+   SInt32 num_application_tiles = Config::getSingleton()->getApplicationTiles();
+
+   for (SInt32 i = 0; i < _num_clusters; i++)
+   {
+      _cluster_info_list[i]._optical_hub = computeTileIDWithOpticalHub(i);
+      computeTileIDListInCluster(i, _cluster_info_list[i]._tile_id_list);
+   }
+
+   _tile_info_list.resize(num_application_tiles);
+   for (tile_id_t tile_id = 0; tile_id < num_application_tiles; tile_id++)
+   {
+      TileInfo& tile_info = _tile_info_list[tile_id];
+      tile_info._cluster_id = computeClusterID(tile_id);
+      tile_info._nearest_access_point = _cluster_info_list[tile_info._cluster_id]._access_point_list[computeSubClusterID(tile_id)];
+      const vector<tile_id_t>& tile_id_list = _cluster_info_list[tile_info._cluster_id]._tile_id_list;
+      tile_info._index_in_cluster = find(tile_id_list.begin(), tile_id_list.end(), tile_id) - tile_id_list.begin();
+   }
+
+   // The hop counts between two clusters span [min_hops, max_hops], only
+   // the pairs that straddle the threshold need the tiles' hop count
+   _global_route_table.resize(_num_clusters * _num_clusters);
+   for (SInt32 sender_cluster = 0; sender_cluster < _num_clusters; sender_cluster++)
+   {
+      const ClusterInfo::Boundary& s = _cluster_info_list[sender_cluster]._boundary;
+      for (SInt32 receiver_cluster = 0; receiver_cluster < _num_clusters; receiver_cluster++)
+      {
+         const ClusterInfo::Boundary& r = _cluster_info_list[receiver_cluster]._boundary;
+         GlobalRoute global_route;
+         if (sender_cluster == receiver_cluster)
+         {
+            global_route = GLOBAL_ENET;
+         }
+         else if (_global_routing_strategy == CLUSTER_BASED)
+         {
+            global_route = GLOBAL_ONET;
+         }
+         else // (_global_routing_strategy == DISTANCE_BASED)
+         {
+            // Boundaries are [min, max)
+            SInt32 min_hops = max<SInt32>(0, max<SInt32>(r.minX - (s.maxX-1), s.minX - (r.maxX-1))) +
+                              max<SInt32>(0, max<SInt32>(r.minY - (s.maxY-1), s.minY - (r.maxY-1)));
+            SInt32 max_hops = max<SInt32>((r.maxX-1) - s.minX, (s.maxX-1) - r.minX) +
+                              max<SInt32>((r.maxY-1) - s.minY, (s.maxY-1) - r.minY);
+            if (max_hops <= _unicast_distance_threshold)
+               global_route = GLOBAL_ENET;
+            else if (min_hops > _unicast_distance_threshold)
+               global_route = GLOBAL_ONET;
+            else
+               global_route = GLOBAL_BY_DISTANCE;
+         }
+         _global_route_table[sender_cluster * _num_clusters + receiver_cluster] = global_route;
+      }
+   }
+}
+
 SInt32
-NetworkModelAtac::getClusterID(tile_id_t tile_id)
+NetworkModelAtac::computeClusterID(tile_id_t tile_id)
 {
    // Consider a mesh formed by the clusters
    SInt32 cluster_mesh_width;
@@ -665,12 +796,12 @@ NetworkModelAtac::getClusterID(tile_id_t tile_id)
 }
 
 SInt32
-NetworkModelAtac::getSubClusterID(tile_id_t tile_id)
+NetworkModelAtac::computeSubClusterID(tile_id_t tile_id)
 {
    SInt32 cx, cy;
    computePositionOnENet(tile_id, cx, cy);
 
-   SInt32 cluster_id = getClusterID(tile_id);
+   SInt32 cluster_id = computeClusterID(tile_id);
    // Get the cluster boundary
    ClusterInfo::Boundary& boundary = _cluster_info_list[cluster_id]._boundary;
    SInt32 pos_x = (cx - boundary.minX) / _sub_cluster_width;
@@ -679,21 +810,7 @@ NetworkModelAtac::getSubClusterID(tile_id_t tile_id)
 }
 
 tile_id_t
-NetworkModelAtac::getNearestAccessPoint(tile_id_t tile_id)
-{
-   SInt32 cluster_id = getClusterID(tile_id);
-   SInt32 sub_cluster_id = getSubClusterID(tile_id);
-   return _cluster_info_list[cluster_id]._access_point_list[sub_cluster_id];
-}
-
-bool
-NetworkModelAtac::isAccessPoint(tile_id_t tile_id)
-{
-   return (tile_id == getNearestAccessPoint(tile_id));
-}
-
-tile_id_t
-NetworkModelAtac::getTileIDWithOpticalHub(SInt32 cluster_id)
+NetworkModelAtac::computeTileIDWithOpticalHub(SInt32 cluster_id)
 {
    // Consider a mesh formed by the clusters
    SInt32 cluster_mesh_width;
@@ -711,7 +828,7 @@ NetworkModelAtac::getTileIDWithOpticalHub(SInt32 cluster_id)
 }
 
 void
-NetworkModelAtac::getTileIDListInCluster(SInt32 cluster_id, vector<tile_id_t>& tile_id_list)
+NetworkModelAtac::computeTileIDListInCluster(SInt32 cluster_id, vector<tile_id_t>& tile_id_list)
 {
    SInt32 cluster_mesh_width;
    cluster_mesh_width = _enet_width / _cluster_width;
@@ -735,19 +852,6 @@ NetworkModelAtac::getTileIDListInCluster(SInt32 cluster_id, vector<tile_id_t>& t
    }
 }
 
-SInt32
-NetworkModelAtac::getIndexInList(tile_id_t tile_id, vector<tile_id_t>& tile_id_list)
-{
-   SInt32 idx = 0;
-   for (vector<tile_id_t>::iterator it = tile_id_list.begin(); it != tile_id_list.end(); it++, idx++)
-   {
-      if (tile_id == *it)
-         return idx;
-   }
-   LOG_PRINT_ERROR("Could not find (%i)", tile_id);
-   return -1;
-}
-
 SInt32
 NetworkModelAtac::computeNumHopsOnENet(tile_id_t sender, tile_id_t receiver)
 {
@@ -791,24 +895,40 @@ NetworkModelAtac::computeGlobalRoute(tile_id_t sender, tile_id_t receiver)
    if (receiver == NetPacket::BROADCAST)
       return GLOBAL_ONET;
 
-   if (getClusterID(sender) == getClusterID(receiver))
+   GlobalRoute global_route = (GlobalRoute) _global_route_table[getClusterID(sender) * _num_clusters + getClusterID(receiver)];
+   if (global_route == GLOBAL_BY_DISTANCE)
    {
-      return GLOBAL_ENET;
+      SInt32 num_hops_on_enet = computeNumHopsOnENet(sender, receiver);
+      return (num_hops_on_enet <= _unicast_distance_threshold) ? GLOBAL_ENET : GLOBAL_ONET;
    }
-   else // (getClusterID(sender) != getClusterID(receiver))
+   return global_route;
+}
+
+NetworkModelAtac::ONetChannelType
+NetworkModelAtac::parseONetChannelType(string str)
+{
+   if (str == "hub_queues")
+      return HUB_QUEUES;
+   else if (str == "swmr")
+      return SWMR;
+   else if (str == "mwsr")
+      return MWSR;
+   else
    {
-      if (_global_routing_strategy == CLUSTER_BASED)
-      {
-         return GLOBAL_ONET;
-      }
-      else // (_global_routing_strategy == DISTANCE_BASED)
-      {
-         SInt32 num_hops_on_enet = computeNumHopsOnENet(sender, receiver);
-         return (num_hops_on_enet <= _unicast_distance_threshold) ? GLOBAL_ENET : GLOBAL_ONET;
-      }
+      LOG_PRINT_ERROR("Unrecognized ONet Channel Model(%s)", str.c_str());
+      return (ONetChannelType) -1;
    }
 }
 
+UInt64
+NetworkModelAtac::computeChannelDelay(ChannelModel* channel, const NetPacket& pkt, UInt64 time, SInt32 writer)
+{
+   if (!isChannelModelEnabled() || !isModelEnabled(pkt))
+      return 0;
+   SInt32 num_flits = computeNumFlits(getModeledLength(pkt));
+   return channel->computeDelay(time, num_flits, writer);
+}
+
 NetworkModelAtac::ReceiveNetType
 NetworkModelAtac::parseReceiveNetType(string str)
 {
@@ -823,14 +943,6 @@ NetworkModelAtac::parseReceiveNetType(string str)
    }
 }
 
-SInt32
-NetworkModelAtac::computeReceiveNetID(tile_id_t sender)
-{
-   // This can be made random also if needed
-   SInt32 sending_cluster_id = getClusterID(sender);
-   return (sending_cluster_id % _num_receive_networks_per_cluster);
-}
-
 bool
 NetworkModelAtac::isTileCountPermissible(SInt32 tile_count)
 {
@@ -882,9 +994,8 @@ NetworkModelAtac::computeProcessToTileMapping()
    UInt32 process_num = 0;
    for (SInt32 i = 0; i < _num_clusters; i++)
    {
-      Config::TileList tile_id_list;
-      Config::TileList::iterator tile_it;
-      getTileIDListInCluster(i, tile_id_list);
+      const Config::TileList& tile_id_list = getTileIDListInCluster(i);
+      Config::TileList::const_iterator tile_it;
       for (tile_it = tile_id_list.begin(); tile_it != tile_id_list.end(); tile_it ++)
       {
          process_to_tile_mapping[process_num].push_back(*tile_it);
@@ -941,11 +1052,23 @@ NetworkModelAtac::outputEventCountSummary(ostream& out)
       {
          out << "      Optical Link Unicasts: " << _optical_link->getTotalUnicasts() << endl;
          out << "      Optical Link Broadcasts: " << _optical_link->getTotalBroadcasts() << endl;
+         if (OpticalLinkModel::isLaserGatingEnabled())
+         {
+            out << "      Optical Link Laser Wake-ups: " << _optical_link->getTotalLaserWakeups() << endl;
+            out << "      Optical Link Laser Gated Cycles: " << _optical_link->getTotalLaserGatedCycles() << endl;
+            out << "      Optical Link Laser Wake-up Delay (in cycles): " << _optical_link->getTotalLaserWakeupDelay() << endl;
+         }
       }
       else
       {
          out << "      Optical Link Unicasts: " << endl;
          out << "      Optical Link Broadcasts: " << endl;
+         if (OpticalLinkModel::isLaserGatingEnabled())
+         {
+            out << "      Optical Link Laser Wake-ups: " << endl;
+            out << "      Optical Link Laser Gated Cycles: " << endl;
+            out << "      Optical Link Laser Wake-up Delay (in cycles): " << endl;
+         }
       }
 
       // Receive Hub Router
@@ -1102,7 +1225,8 @@ NetworkModelAtac::outputContentionModelsSummary(ostream& out)
          out << "      Percentage Analytical Models Used ENet Router To Send Hub Router Link: " << endl;
       }
 
-      if (_tile_id == getTileIDWithOpticalHub(getClusterID(_tile_id)))
+      // The hub routers have no queue models with the channel models
+      if ((_tile_id == getTileIDWithOpticalHub(getClusterID(_tile_id))) && !isChannelModelEnabled())
       {
          // Send Hub Router
          out << "      Average Contention Delay Send Hub Router: " << _send_hub_router->getAverageContentionDelay(0) << endl;
@@ -1165,6 +1289,45 @@ NetworkModelAtac::outputContentionModelsSummary(ostream& out)
    }
 }
 
+void
+NetworkModelAtac::outputChannelModelsSummary(ostream& out)
+{
+   out << "    Channel Models:" << endl;
+
+   if (isApplicationTile(_tile_id) && (_tile_id == getTileIDWithOpticalHub(getClusterID(_tile_id))))
+   {
+      out << "      Average Contention Delay ONet Channel: " << _onet_channel->getAverageDelay() << endl;
+      out << "      Average Utilization ONet Channel: " << _onet_channel->getUtilization() << endl;
+      for (SInt32 i = 0; i < _num_receive_networks_per_cluster; i++)
+      {
+         out << "      Average Contention Delay Receive Hub Link[" << i << "]: " << _receive_hub_channel_list[i]->getAverageDelay() << endl;
+         out << "      Average Utilization Receive Hub Link[" << i << "]: " << _receive_hub_channel_list[i]->getUtilization() << endl;
+      }
+      if (_receive_net_type == STAR)
+      {
+         float total_delay = 0.0;
+         for (SInt32 i = 0; i < _num_receive_networks_per_cluster; i++)
+         {
+            for (SInt32 j = 0; j < _cluster_size; j++)
+               total_delay += _star_net_channel_list[i][j]->getAverageDelay();
+         }
+         out << "      Average Contention Delay Star Net Links: " << total_delay / (_num_receive_networks_per_cluster * _cluster_size) << endl;
+      }
+   }
+   else
+   {
+      out << "      Average Contention Delay ONet Channel: " << endl;
+      out << "      Average Utilization ONet Channel: " << endl;
+      for (SInt32 i = 0; i < _num_receive_networks_per_cluster; i++)
+      {
+         out << "      Average Contention Delay Receive Hub Link[" << i << "]: " << endl;
+         out << "      Average Utilization Receive Hub Link[" << i << "]: " << endl;
+      }
+      if (_receive_net_type == STAR)
+         out << "      Average Contention Delay Star Net Links: " << endl;
+   }
+}
+
 void
 NetworkModelAtac::outputPowerSummary(ostream& out)
 {
@@ -1179,6 +1342,7 @@ NetworkModelAtac::outputPowerSummary(ostream& out)
    double enet_link_dynamic_energy = 0.0;
    double optical_link_static_power = 0.0;
    double optical_link_dynamic_energy = 0.0;
+   double optical_link_laser_energy_saved = 0.0;
    double receive_hub_router_static_power = 0.0;
    double receive_hub_router_dynamic_energy = 0.0;
    double receive_net_static_power = 0.0;
@@ -1217,6 +1381,7 @@ NetworkModelAtac::outputPowerSummary(ostream& out)
       {
          optical_link_static_power += _optical_link->getPowerModel()->getStaticPower();
          optical_link_dynamic_energy += _optical_link->getPowerModel()->getDynamicEnergy();
+         optical_link_laser_energy_saved += _optical_link->getLaserEnergySaved();
       }
 
       // Receive Hub Router
@@ -1271,6 +1436,9 @@ NetworkModelAtac::outputPowerSummary(ostream& out)
    out << "      ENet Link Dynamic Energy (in J): " << enet_link_dynamic_energy << endl; 
    out << "      Optical Link Static Power (in W): " << optical_link_static_power << endl; 
    out << "      Optical Link Dynamic Energy (in J): " << optical_link_dynamic_energy << endl; 
+   // The static power above has the laser always on
+   if (OpticalLinkModel::isLaserGatingEnabled())
+      out << "      Optical Link Laser Energy Saved (in J): " << optical_link_laser_energy_saved << endl;
    out << "      Receive Hub Static Power (in W): " << receive_hub_router_static_power << endl; 
    out << "      Receive Hub Dynamic Energy (in J): " << receive_hub_router_dynamic_energy << endl;
    if (_receive_net_type == BTREE)
@@ -12,6 +12,7 @@ using namespace std;
 #include "electrical_link_power_model.h"
 #include "optical_link_model.h"
 #include "optical_link_power_model.h"
+#include "channel_model.h"
 
 // Single Sender Multiple Receivers Model
 // 1 sender, N receivers (1 to N)
@@ -56,7 +57,10 @@ private:
    enum GlobalRoute
    {
       GLOBAL_ENET = 0,
-      GLOBAL_ONET
+      GLOBAL_ONET,
+      // Route table only: the clusters are both nearer and farther than
+      // the unicast distance threshold, the hop count decides
+      GLOBAL_BY_DISTANCE
    };
 
    enum ReceiveNetType
@@ -65,6 +69,19 @@ private:
       STAR
    };
 
+   // Contention on the ONet ([network/atac/onet] channel_model)
+   enum ONetChannelType
+   {
+      // Queue models of the send hub, receive hub and star net routers
+      HUB_QUEUES = 0,
+      // A waveguide per sending cluster, the busy receive links of the
+      // receive hubs and star nets (closed form)
+      SWMR,
+      // A waveguide per receiving cluster, the sending clusters get it with
+      // a token; and the receive links as with SWMR
+      MWSR
+   };
+
    static bool _initialized;
    
    // ENet
@@ -103,9 +120,27 @@ private:
       };
       Boundary _boundary;
       vector<tile_id_t> _access_point_list;
+      tile_id_t _optical_hub;
+      vector<tile_id_t> _tile_id_list;
    };
 
    static vector<ClusterInfo> _cluster_info_list;
+
+   // Per application tile, computed once with the clusters
+   class TileInfo
+   {
+   public:
+      SInt32 _cluster_id;
+      tile_id_t _nearest_access_point;
+      // Position in the _tile_id_list of its cluster (star net output port)
+      SInt32 _index_in_cluster;
+   };
+
+   static vector<TileInfo> _tile_info_list;
+
+   // Global route of the unicasts between two clusters,
+   // _global_route_table[sender_cluster * _num_clusters + receiver_cluster]
+   static vector<UInt8> _global_route_table;
    
    // Type of Receive Network
    static ReceiveNetType _receive_net_type;
@@ -118,6 +153,8 @@ private:
 
    // Contention Modeling
    static bool _contention_model_enabled;
+   static ONetChannelType _onet_channel_type;
+   static UInt64 _token_hop_delay;
 
    // Injection Port Router
    RouterModel* _injection_router;
@@ -142,6 +179,13 @@ private:
    vector<RouterModel*> _star_net_router_list;
    vector<vector<ElectricalLinkModel*> > _star_net_link_list;
 
+   // Channel Models (channel_model swmr, mwsr): the waveguide of this
+   // cluster, the links from the receive hub into the receive nets and the
+   // star net links to the tiles
+   ChannelModel* _onet_channel;
+   vector<ChannelModel*> _receive_hub_channel_list;
+   vector<vector<ChannelModel*> > _star_net_channel_list;
+
    // Private Functions
    void routePacketOnENet(const NetPacket& pkt, tile_id_t sender, tile_id_t receiver, queue<Hop>& next_hops);
    void routePacketOnONet(const NetPacket& pkt, tile_id_t sender, tile_id_t receiver, queue<Hop>& next_hops);
@@ -154,22 +198,27 @@ private:
    void outputPowerSummary(ostream& out);
    void outputEventCountSummary(ostream& out);
    void outputContentionModelsSummary(ostream& out);
+   void outputChannelModelsSummary(ostream& out);
   
    // Static Functions
    static void initializeClusters();
    static void initializeAccessPointList(SInt32 cluster_id);
-   static SInt32 getClusterID(tile_id_t tile_id);
-   static SInt32 getSubClusterID(tile_id_t tile_id);
-   static tile_id_t getNearestAccessPoint(tile_id_t tile_id);
-   bool isAccessPoint(tile_id_t tile_id);
-   static tile_id_t getTileIDWithOpticalHub(SInt32 cluster_id);
-   static void getTileIDListInCluster(SInt32 cluster_id, vector<tile_id_t>& tile_id_list);
-   static SInt32 getIndexInList(tile_id_t tile_id, vector<tile_id_t>& tile_id_list);
+   static void initializeRoutingTables();
+   static SInt32 computeClusterID(tile_id_t tile_id);
+   static SInt32 computeSubClusterID(tile_id_t tile_id);
+   static tile_id_t computeTileIDWithOpticalHub(SInt32 cluster_id);
+   static void computeTileIDListInCluster(SInt32 cluster_id, vector<tile_id_t>& tile_id_list);
+   static SInt32 getClusterID(tile_id_t tile_id)                  { return _tile_info_list[tile_id]._cluster_id; }
+   static tile_id_t getNearestAccessPoint(tile_id_t tile_id)      { return _tile_info_list[tile_id]._nearest_access_point; }
+   bool isAccessPoint(tile_id_t tile_id)                          { return (tile_id == getNearestAccessPoint(tile_id)); }
+   static tile_id_t getTileIDWithOpticalHub(SInt32 cluster_id)    { return _cluster_info_list[cluster_id]._optical_hub; }
+   static const vector<tile_id_t>& getTileIDListInCluster(SInt32 cluster_id)
+   { return _cluster_info_list[cluster_id]._tile_id_list; }
     
    static SInt32 computeNumHopsOnENet(tile_id_t sender, tile_id_t receiver);
    static void computePositionOnENet(tile_id_t tile_id, SInt32& x, SInt32& y);
    static tile_id_t computeTileIDOnENet(SInt32 x, SInt32 y);
-   static SInt32 computeReceiveNetID(tile_id_t sender);
+   static SInt32 computeReceiveNetID(tile_id_t sender)            { return (getClusterID(sender) % _num_receive_networks_per_cluster); }
 
    // Compute Waveguide Length
    volatile double computeOpticalLinkLength();
@@ -178,4 +227,11 @@ private:
    static GlobalRoutingStrategy parseGlobalRoutingStrategy(string strategy);
    GlobalRoute computeGlobalRoute(tile_id_t sender, tile_id_t receiver);
    static ReceiveNetType parseReceiveNetType(string receive_net_type);
+   static ONetChannelType parseONetChannelType(string onet_channel_type);
+
+   // Contention through the channel models instead of the hub queue models
+   static bool isChannelModelEnabled()
+   { return _contention_model_enabled && (_onet_channel_type != HUB_QUEUES); }
+   // Wait of the packet at 'time' for a channel (0 if it is not modeled)
+   UInt64 computeChannelDelay(ChannelModel* channel, const NetPacket& pkt, UInt64 time, SInt32 writer = 0);
 };
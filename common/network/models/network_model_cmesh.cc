@@ -0,0 +1,95 @@
+#include <math.h>
+
+#include "network_model_cmesh.h"
+#include "simulator.h"
+#include "log.h"
+
+NetworkModelCMesh::NetworkModelCMesh(Network* net, SInt32 network_id)
+   : NetworkModelElectricalGrid(net, network_id, "network/cmesh", getConcentration())
+{
+   createRouterAndLinkModels();
+}
+
+NetworkModelCMesh::~NetworkModelCMesh()
+{}
+
+SInt32
+NetworkModelCMesh::getConcentration()
+{
+   try
+   {
+      return Sim()->getCfg()->getInt("network/cmesh/concentration");
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read network/cmesh/concentration from the cfg file");
+      return 1;
+   }
+}
+
+bool
+NetworkModelCMesh::isTileCountPermissible(SInt32 tile_count)
+{
+   SInt32 width, height;
+   if (!computeGridDimensions(tile_count, getConcentration(), width, height))
+   {
+      fprintf(stderr, "Can't form a concentrated mesh with tile count(%i), concentration(%i)\n",
+              tile_count, getConcentration());
+      return false;
+   }
+   return true;
+}
+
+SInt32
+NetworkModelCMesh::computeNetworkPort(SInt32 router, SInt32 destination)
+{
+   SInt32 cx, cy, dx, dy;
+   computeRouterPosition(router, cx, cy);
+   computeRouterPosition(destination, dx, dy);
+
+   if (cx > dx)
+      return LEFT;
+   else if (cx < dx)
+      return RIGHT;
+   else if (cy > dy)
+      return DOWN;
+   else
+   {
+      LOG_ASSERT_ERROR(cy < dy, "Router(%i) routing to itself", router);
+      return UP;
+   }
+}
+
+SInt32
+NetworkModelCMesh::computeNeighborRouter(SInt32 router, SInt32 network_port)
+{
+   SInt32 x, y;
+   computeRouterPosition(router, x, y);
+   switch (network_port)
+   {
+   case LEFT:
+      x --;
+      break;
+   case RIGHT:
+      x ++;
+      break;
+   case DOWN:
+      y --;
+      break;
+   case UP:
+      y ++;
+      break;
+   default:
+      LOG_PRINT_ERROR("Unrecognized network port(%i)", network_port);
+      break;
+   }
+   if ((x < 0) || (y < 0) || (x >= _grid_width) || (y >= _grid_height))
+      return -1;
+   return computeRouterID(x, y);
+}
+
+double
+NetworkModelCMesh::computeLinkLength(SInt32 router, SInt32 network_port)
+{
+   return sqrt((double) _concentration) * _tile_width;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "network_model_electrical_grid.h"
+
+// Concentrated mesh ([network/cmesh]): a mesh of routers, each shared by
+// 'concentration' tiles. XY routing. The routers are sqrt(concentration)
+// tiles apart
+class NetworkModelCMesh : public NetworkModelElectricalGrid
+{
+public:
+   NetworkModelCMesh(Network* net, SInt32 network_id);
+   ~NetworkModelCMesh();
+
+   static bool isTileCountPermissible(SInt32 tile_count);
+
+private:
+   enum NetworkPort
+   {
+      LEFT = 0,
+      RIGHT,
+      DOWN,
+      UP,
+      NUM_NETWORK_PORTS
+   };
+
+   static SInt32 getConcentration();
+
+   SInt32 getNumNetworkPorts() { return NUM_NETWORK_PORTS; }
+   SInt32 computeNetworkPort(SInt32 router, SInt32 destination);
+   SInt32 computeNeighborRouter(SInt32 router, SInt32 network_port);
+   double computeLinkLength(SInt32 router, SInt32 network_port);
+};
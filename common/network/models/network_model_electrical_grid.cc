@@ -0,0 +1,290 @@
+#include <math.h>
+using namespace std;
+
+#include "network_model_electrical_grid.h"
+#include "simulator.h"
+#include "config.h"
+#include "log.h"
+
+NetworkModelElectricalGrid::NetworkModelElectricalGrid(Network* net, SInt32 network_id,
+                                                       const string& cfg_section, SInt32 concentration)
+   : NetworkModel(net, network_id)
+   , _concentration(concentration)
+   , _grid_width(0)
+   , _grid_height(0)
+   , _cfg_section(cfg_section)
+   , _router_id(-1)
+   , _router_tile_id(INVALID_TILE_ID)
+   , _contention_model_enabled(false)
+   , _injection_router(NULL)
+   , _injection_link(NULL)
+   , _num_router_ports(0)
+   , _router(NULL)
+{
+   try
+   {
+      // Network Frequency is specified in GHz
+      _frequency = Sim()->getCfg()->getFloat(_cfg_section + "/frequency");
+      // Flit Width is specified in bits
+      _flit_width = Sim()->getCfg()->getInt(_cfg_section + "/flit_width");
+      _contention_model_enabled = Sim()->getCfg()->getBool(_cfg_section + "/queue_model/enabled");
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read %s parameters from the cfg file", _cfg_section.c_str());
+   }
+
+   // Broadcasts are sent as unicasts
+   _has_broadcast_capability = false;
+
+   bool permissible = computeGridDimensions(Config::getSingleton()->getApplicationTiles(), _concentration,
+                                            _grid_width, _grid_height);
+   LOG_ASSERT_ERROR(permissible, "Num Application Tiles(%u) do not form a grid of routers with concentration(%i)",
+                    Config::getSingleton()->getApplicationTiles(), _concentration);
+
+   if (isApplicationTile(_tile_id))
+   {
+      _router_id = _tile_id / _concentration;
+      _router_tile_id = _router_id * _concentration;
+   }
+}
+
+NetworkModelElectricalGrid::~NetworkModelElectricalGrid()
+{
+   destroyRouterAndLinkModels();
+}
+
+bool
+NetworkModelElectricalGrid::computeGridDimensions(SInt32 tile_count, SInt32 concentration, SInt32& width, SInt32& height)
+{
+   if ((concentration < 1) || (tile_count % concentration != 0))
+      return false;
+
+   SInt32 num_routers = tile_count / concentration;
+   width = (SInt32) floor(sqrt(num_routers));
+   height = (SInt32) ceil(1.0 * num_routers / width);
+   return (num_routers == (width * height));
+}
+
+void
+NetworkModelElectricalGrid::computeRouterPosition(SInt32 router, SInt32& x, SInt32& y) const
+{
+   x = router % _grid_width;
+   y = router / _grid_width;
+}
+
+SInt32
+NetworkModelElectricalGrid::computeRouterID(SInt32 x, SInt32 y) const
+{
+   return (y * _grid_width + x);
+}
+
+void
+NetworkModelElectricalGrid::createRouterAndLinkModels()
+{
+   if (isSystemTile(_tile_id))
+      return;
+
+   UInt64 router_delay = 0;
+   UInt32 num_flits_per_port_buffer = 0;
+   string link_type;
+   string contention_model_type;
+   try
+   {
+      // Router Delay (pipeline delay) is specified in cycles
+      router_delay = (UInt64) Sim()->getCfg()->getInt(_cfg_section + "/router/delay");
+      // Number of flits per port - used only for power modeling purposes now
+      num_flits_per_port_buffer = Sim()->getCfg()->getInt(_cfg_section + "/router/num_flits_per_port_buffer");
+      link_type = Sim()->getCfg()->getString(_cfg_section + "/link/type");
+      contention_model_type = Sim()->getCfg()->getString(_cfg_section + "/queue_model/type");
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read %s router & link parameters from the cfg file", _cfg_section.c_str());
+   }
+
+   // Injection port contention model, and the link to the router
+   _injection_router = new RouterModel(this, _frequency, 1, 1,
+                                       4, 0, _flit_width,
+                                       _contention_model_enabled, contention_model_type);
+   if (_router_tile_id != _tile_id)
+      _injection_link = new ElectricalLinkModel(this, link_type, _frequency, _tile_width, _flit_width);
+
+   if (_router_tile_id != _tile_id)
+      return;
+
+   // Router of the group: ejection ports, then network ports
+   SInt32 num_network_ports = getNumNetworkPorts();
+   _num_router_ports = _concentration + num_network_ports;
+   _router = new RouterModel(this, _frequency, _num_router_ports, _num_router_ports,
+                             num_flits_per_port_buffer * getNumVirtualChannels(), router_delay, _flit_width,
+                             _contention_model_enabled, contention_model_type);
+
+   _link_list.resize(_num_router_ports);
+   for (SInt32 i = 0; i < _concentration; i++)
+      _link_list[i] = new ElectricalLinkModel(this, link_type, _frequency, _tile_width, _flit_width);
+   _neighbor_router_tile.resize(num_network_ports);
+   for (SInt32 i = 0; i < num_network_ports; i++)
+   {
+      _link_list[_concentration + i] = new ElectricalLinkModel(this, link_type, _frequency,
+                                                               computeLinkLength(_router_id, i), _flit_width);
+      // Ports on the edges of the grid lead nowhere
+      SInt32 neighbor = computeNeighborRouter(_router_id, i);
+      _neighbor_router_tile[i] = (neighbor >= 0) ? (neighbor * _concentration) : INVALID_TILE_ID;
+   }
+
+   // Routes from this router, computed once
+   SInt32 num_routers = _grid_width * _grid_height;
+   _output_port.resize(num_routers, -1);
+   for (SInt32 destination = 0; destination < num_routers; destination++)
+   {
+      if (destination != _router_id)
+         _output_port[destination] = _concentration + computeNetworkPort(_router_id, destination);
+   }
+}
+
+void
+NetworkModelElectricalGrid::destroyRouterAndLinkModels()
+{
+   delete _injection_router;
+   delete _injection_link;
+   delete _router;
+   for (UInt32 i = 0; i < _link_list.size(); i++)
+      delete _link_list[i];
+}
+
+void
+NetworkModelElectricalGrid::routePacket(const NetPacket& pkt, queue<Hop>& next_hops)
+{
+   tile_id_t pkt_receiver = TILE_ID(pkt.receiver);
+   LOG_ASSERT_ERROR(pkt_receiver != NetPacket::BROADCAST, "Broadcasts are sent as unicasts");
+
+   if (pkt.node_type == SEND_TILE)
+   {
+      UInt64 zero_load_delay = 0;
+      UInt64 contention_delay = 0;
+      _injection_router->processPacket(pkt, 0, zero_load_delay, contention_delay);
+      if (_injection_link)
+         _injection_link->processPacket(pkt, zero_load_delay);
+
+      Hop hop(pkt, _router_tile_id, ROUTER, zero_load_delay, contention_delay);
+      next_hops.push(hop);
+   }
+
+   else if (pkt.node_type == ROUTER)
+   {
+      LOG_ASSERT_ERROR(hasRouter(), "No router on tile(%i)", _tile_id);
+
+      SInt32 destination = pkt_receiver / _concentration;
+      NextDest next_dest = (destination == _router_id) ?
+                           NextDest(pkt_receiver, pkt_receiver % _concentration, RECEIVE_TILE) :
+                           NextDest(_neighbor_router_tile[_output_port[destination] - _concentration],
+                                    _output_port[destination], ROUTER);
+
+      UInt64 zero_load_delay = 0;
+      UInt64 contention_delay = 0;
+      _router->processPacket(pkt, next_dest._output_port, zero_load_delay, contention_delay);
+      _link_list[next_dest._output_port]->processPacket(pkt, zero_load_delay);
+
+      Hop hop(pkt, next_dest._tile_id, next_dest._node_type, zero_load_delay, contention_delay);
+      next_hops.push(hop);
+   }
+
+   else
+   {
+      LOG_PRINT_ERROR("Unrecognized Node Type(%i)", pkt.node_type);
+   }
+}
+
+void
+NetworkModelElectricalGrid::outputSummary(ostream& out)
+{
+   NetworkModel::outputSummary(out);
+   outputPowerSummary(out);
+   outputEventCountSummary(out);
+   if (_contention_model_enabled)
+      outputContentionModelsSummary(out);
+}
+
+void
+NetworkModelElectricalGrid::outputEventCountSummary(ostream& out)
+{
+   out << "    Event Counters:" << endl;
+
+   // The routers are reported on the first tile of their group
+   if (hasRouter())
+   {
+      out << "      Buffer Writes: " << _router->getTotalBufferWrites() << endl;
+      out << "      Buffer Reads: " << _router->getTotalBufferReads() << endl;
+      out << "      Switch Allocator Requests: " << _router->getTotalSwitchAllocatorRequests() << endl;
+      out << "      Crossbar Traversals: " << _router->getTotalCrossbarTraversals(1) << endl;
+
+      UInt64 total_link_traversals = 0;
+      for (SInt32 i = 0; i < _num_router_ports; i++)
+         total_link_traversals += _link_list[i]->getTotalTraversals();
+      out << "      Link Traversals: " << total_link_traversals << endl;
+   }
+   else
+   {
+      out << "      Buffer Writes: " << endl;
+      out << "      Buffer Reads: " << endl;
+      out << "      Switch Allocator Requests: " << endl;
+      out << "      Crossbar Traversals: " << endl;
+      out << "      Link Traversals: " << endl;
+   }
+}
+
+void
+NetworkModelElectricalGrid::outputContentionModelsSummary(ostream& out)
+{
+   out << "    Contention Counters:" << endl;
+
+   if (hasRouter())
+   {
+      out << "      Average Router Contention Delay: " << _router->getAverageContentionDelay(0, _num_router_ports-1) << endl;
+      out << "      Average Router Link Utilization: " << _router->getAverageLinkUtilization(0, _num_router_ports-1) << endl;
+      out << "      Percentage Analytical Models Used: " << _router->getPercentAnalyticalModelsUsed(0, _num_router_ports-1) << endl;
+   }
+   else
+   {
+      out << "      Average Router Contention Delay: " << endl;
+      out << "      Average Router Link Utilization: " << endl;
+      out << "      Percentage Analytical Models Used: " << endl;
+   }
+}
+
+void
+NetworkModelElectricalGrid::outputPowerSummary(ostream& out)
+{
+   if (!Config::getSingleton()->getEnablePowerModeling())
+      return;
+
+   out << "    Energy Counters:" << endl;
+   if (isApplicationTile(_tile_id))
+   {
+      double static_power = 0;
+      double dynamic_energy = 0;
+      if (_injection_link)
+      {
+         static_power += _injection_link->getPowerModel()->getStaticPower();
+         dynamic_energy += _injection_link->getPowerModel()->getDynamicEnergy();
+      }
+      if (hasRouter())
+      {
+         static_power += _router->getPowerModel()->getStaticPower();
+         dynamic_energy += _router->getPowerModel()->getDynamicEnergy();
+         for (SInt32 i = 0; i < _num_router_ports; i++)
+         {
+            static_power += _link_list[i]->getPowerModel()->getStaticPower();
+            dynamic_energy += _link_list[i]->getPowerModel()->getDynamicEnergy();
+         }
+      }
+      out << "      Static Power (in W): " << static_power << endl;
+      out << "      Dynamic Energy (in J): " << dynamic_energy << endl;
+   }
+   else
+   {
+      out << "      Static Power (in W): " << endl;
+      out << "      Dynamic Energy (in J): " << endl;
+   }
+}
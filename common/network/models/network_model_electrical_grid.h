@@ -0,0 +1,99 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <iostream>
+using std::vector;
+using std::string;
+using std::ostream;
+
+#include "network.h"
+#include "network_model.h"
+#include "fixed_types.h"
+#include "router_model.h"
+#include "electrical_link_model.h"
+
+// Electrical network of routers laid out on a grid, with 'concentration'
+// application tiles per router (torus, cmesh, flattened_butterfly).
+//   Router r serves the tiles [r * concentration, (r+1) * concentration) and
+// is modeled on the first of them. Its ports are the ejection ports of its
+// tiles (0 .. concentration-1), then the network ports of the topology.
+// Packets are routed one dimension after the other, the subclass gives the
+// network port towards a router and the router it leads to. Broadcasts are
+// sent as unicasts.
+//   Each tile has an injection port contention model and, when its router is
+// on another tile, a link to it.
+class NetworkModelElectricalGrid : public NetworkModel
+{
+public:
+   NetworkModelElectricalGrid(Network* net, SInt32 network_id, const string& cfg_section, SInt32 concentration);
+   ~NetworkModelElectricalGrid();
+
+   void outputSummary(ostream& out);
+
+protected:
+   enum NodeType
+   {
+      ROUTER = 2 // Always Start at 2
+   };
+
+   // Grid of routers (in routers)
+   SInt32 _concentration;
+   SInt32 _grid_width;
+   SInt32 _grid_height;
+
+   // Shape of the grid for a tile count, false if it cannot be formed
+   static bool computeGridDimensions(SInt32 tile_count, SInt32 concentration, SInt32& width, SInt32& height);
+
+   void computeRouterPosition(SInt32 router, SInt32& x, SInt32& y) const;
+   SInt32 computeRouterID(SInt32 x, SInt32 y) const;
+
+   // Topology, implemented by the subclasses
+   virtual SInt32 getNumNetworkPorts() = 0;
+   // Network port (0 .. getNumNetworkPorts()-1) of 'router' on the route to
+   // 'destination' (!= router)
+   virtual SInt32 computeNetworkPort(SInt32 router, SInt32 destination) = 0;
+   // Router at the other end of a network port (-1 if none)
+   virtual SInt32 computeNeighborRouter(SInt32 router, SInt32 network_port) = 0;
+   // Length of the link of a network port (in mm)
+   virtual double computeLinkLength(SInt32 router, SInt32 network_port) = 0;
+   // Virtual channels per port, they only scale the buffers of the router
+   // power model (latency is modeled with infinite output buffers)
+   virtual SInt32 getNumVirtualChannels() { return 1; }
+
+   // Call once the subclass can compute its topology
+   void createRouterAndLinkModels();
+
+private:
+   string _cfg_section;
+
+   // Router of this tile, the tile its model is on
+   SInt32 _router_id;
+   tile_id_t _router_tile_id;
+
+   // Is contention model enabled?
+   bool _contention_model_enabled;
+
+   // Injection port, and link to the router when it is on another tile
+   RouterModel* _injection_router;
+   ElectricalLinkModel* _injection_link;
+
+   // Router of the grid, on the first tile of its group
+   SInt32 _num_router_ports;
+   RouterModel* _router;
+   vector<ElectricalLinkModel*> _link_list;
+   // Tile of the router at the other end of each network port
+   vector<tile_id_t> _neighbor_router_tile;
+   // Output port towards each router (_concentration + network port)
+   vector<SInt32> _output_port;
+
+   void routePacket(const NetPacket& pkt, queue<Hop>& next_hops);
+
+   void destroyRouterAndLinkModels();
+
+   bool hasRouter() { return (_router != NULL); }
+
+   void outputEventCountSummary(ostream& out);
+   void outputPowerSummary(ostream& out);
+   void outputContentionModelsSummary(ostream& out);
+};
@@ -1,4 +1,5 @@
 #include <math.h>
+#include <algorithm>
 using namespace std;
 
 #include "network_model_emesh_hop_by_hop.h"
@@ -12,9 +13,21 @@ bool NetworkModelEMeshHopByHop::_initialized = false;
 SInt32 NetworkModelEMeshHopByHop::_mesh_width;
 SInt32 NetworkModelEMeshHopByHop::_mesh_height;
 bool NetworkModelEMeshHopByHop::_contention_model_enabled;
+bool NetworkModelEMeshHopByHop::_contention_sampling_enabled;
+UInt64 NetworkModelEMeshHopByHop::_contention_sampling_detailed_window;
+float NetworkModelEMeshHopByHop::_contention_sampling_ratio;
+bool NetworkModelEMeshHopByHop::_flow_control_enabled;
+SInt32 NetworkModelEMeshHopByHop::_num_virtual_channels;
+UInt64 NetworkModelEMeshHopByHop::_credit_delay;
+vector<UInt8> NetworkModelEMeshHopByHop::_unicast_output_port;
+vector<UInt8> NetworkModelEMeshHopByHop::_broadcast_output_ports;
+vector<tile_id_t> NetworkModelEMeshHopByHop::_neighbor_tile;
+NetworkModelEMeshHopByHop::RoutingAlgorithm NetworkModelEMeshHopByHop::_routing_algorithm;
 
 NetworkModelEMeshHopByHop::NetworkModelEMeshHopByHop(Network* net, SInt32 network_id)
    : NetworkModel(net, network_id)
+   , _total_adaptive_routing_decisions(0)
+   , _total_non_xy_hops(0)
 {
    try
    {
@@ -59,11 +72,26 @@ NetworkModelEMeshHopByHop::initializeEMeshTopologyParams()
    LOG_ASSERT_ERROR(num_application_tiles == (_mesh_width * _mesh_height),
          "Num Application Tiles(%i), Mesh Width(%i), Mesh Height(%i)",
          num_application_tiles, _mesh_width, _mesh_height);
+
+   initializeRoutingTables();
       
    try
    {
       // Is contention model enabled?
       _contention_model_enabled = Sim()->getCfg()->getBool("network/emesh_hop_by_hop/queue_model/enabled");
+
+      // Fast-forward part of the packets with a contention estimate
+      _contention_sampling_enabled = Sim()->getCfg()->getBool("network/emesh_hop_by_hop/queue_model/sampling/enabled", false);
+      _contention_sampling_detailed_window = Sim()->getCfg()->getInt("network/emesh_hop_by_hop/queue_model/sampling/detailed_window", 1000);
+      _contention_sampling_ratio = Sim()->getCfg()->getFloat("network/emesh_hop_by_hop/queue_model/sampling/ratio", 0.1);
+
+      // Flow control stalls are part of the contention delay
+      _flow_control_enabled = _contention_model_enabled &&
+                              Sim()->getCfg()->getBool("network/emesh_hop_by_hop/flow_control/enabled", false);
+      _num_virtual_channels = Sim()->getCfg()->getInt("network/emesh_hop_by_hop/flow_control/num_virtual_channels", 2);
+      _credit_delay = (UInt64) Sim()->getCfg()->getInt("network/emesh_hop_by_hop/flow_control/credit_delay", 1);
+
+      _routing_algorithm = parseRoutingAlgorithm(Sim()->getCfg()->getString("network/emesh_hop_by_hop/routing_algorithm", "xy"));
    }
    catch (...)
    {
@@ -71,6 +99,226 @@ NetworkModelEMeshHopByHop::initializeEMeshTopologyParams()
    }
 }
 
+void
+NetworkModelEMeshHopByHop::initializeRoutingTables()
+{
+   SInt32 num_tiles = _mesh_width * _mesh_height;
+
+   _neighbor_tile.resize(num_tiles * NUM_OUTPUT_DIRECTIONS);
+   for (tile_id_t tile = 0; tile < num_tiles; tile++)
+   {
+      SInt32 x, y;
+      computePosition(tile, x, y);
+      tile_id_t* neighbors = &_neighbor_tile[tile * NUM_OUTPUT_DIRECTIONS];
+      neighbors[SELF] = tile;
+      neighbors[LEFT] = computeTileID(x-1,y);
+      neighbors[RIGHT] = computeTileID(x+1,y);
+      neighbors[DOWN] = computeTileID(x,y-1);
+      neighbors[UP] = computeTileID(x,y+1);
+   }
+
+   // XY routing: first along X, then along Y
+   _unicast_output_port.resize(num_tiles * num_tiles);
+   for (tile_id_t current = 0; current < num_tiles; current++)
+   {
+      SInt32 cx, cy;
+      computePosition(current, cx, cy);
+      for (tile_id_t receiver = 0; receiver < num_tiles; receiver++)
+      {
+         SInt32 dx, dy;
+         computePosition(receiver, dx, dy);
+
+         OutputDirection direction;
+         if (cx > dx)
+            direction = LEFT;
+         else if (cx < dx)
+            direction = RIGHT;
+         else if (cy > dy)
+            direction = DOWN;
+         else if (cy < dy)
+            direction = UP;
+         else
+            direction = SELF;
+         _unicast_output_port[current * num_tiles + receiver] = direction;
+      }
+   }
+
+   // Broadcast tree: along Y away from the sender's row, and along X
+   // within the sender's row
+   _broadcast_output_ports.resize(num_tiles * num_tiles);
+   for (tile_id_t sender = 0; sender < num_tiles; sender++)
+   {
+      SInt32 sx, sy;
+      computePosition(sender, sx, sy);
+      for (tile_id_t current = 0; current < num_tiles; current++)
+      {
+         SInt32 cx, cy;
+         computePosition(current, cx, cy);
+
+         UInt8 ports = 0;
+         if (cy >= sy)
+            ports |= (1 << UP);
+         if (cy <= sy)
+            ports |= (1 << DOWN);
+         if (cy == sy)
+         {
+            if (cx >= sx)
+               ports |= (1 << RIGHT);
+            if (cx <= sx)
+               ports |= (1 << LEFT);
+         }
+
+         // Drop the directions that fall off the mesh
+         for (SInt32 direction = LEFT; direction < NUM_OUTPUT_DIRECTIONS; direction++)
+         {
+            if (_neighbor_tile[current * NUM_OUTPUT_DIRECTIONS + direction] == INVALID_TILE_ID)
+               ports &= ~(1 << direction);
+         }
+         _broadcast_output_ports[sender * num_tiles + current] = ports;
+      }
+   }
+}
+
+UInt8
+NetworkModelEMeshHopByHop::computeMulticastOutputPorts(const NetPacket &pkt)
+{
+   // The broadcast tree goes along X in the sender's row, then along Y
+   // in every column. The ports towards the receivers that are not below
+   // this tile in the tree are masked off by the caller
+   SInt32 num_tiles = _mesh_width * _mesh_height;
+   SInt32 sx, sy, cx, cy;
+   computePosition(TILE_ID(pkt.sender), sx, sy);
+   computePosition(_tile_id, cx, cy);
+
+   vector<tile_id_t> receivers;
+   pkt.getMulticastReceivers(receivers);
+
+   UInt8 ports = 0;
+   for (vector<tile_id_t>::iterator it = receivers.begin(); it != receivers.end(); it++)
+   {
+      // System tiles are not on the mesh
+      if (*it >= num_tiles)
+         continue;
+
+      SInt32 rx, ry;
+      computePosition(*it, rx, ry);
+      if (rx == cx)
+      {
+         if (ry > cy)
+            ports |= (1 << UP);
+         else if (ry < cy)
+            ports |= (1 << DOWN);
+         else
+            ports |= (1 << SELF);
+      }
+      else if (cy == sy)
+      {
+         ports |= (rx > cx) ? (1 << RIGHT) : (1 << LEFT);
+      }
+   }
+   return ports;
+}
+
+NetworkModelEMeshHopByHop::RoutingAlgorithm
+NetworkModelEMeshHopByHop::parseRoutingAlgorithm(string algorithm)
+{
+   if (algorithm == "xy")
+      return XY_ROUTING;
+   else if (algorithm == "west_first")
+      return WEST_FIRST_ROUTING;
+   else if (algorithm == "odd_even")
+      return ODD_EVEN_ROUTING;
+   else
+      LOG_PRINT_ERROR("Unrecognized Routing Algorithm (%s)", algorithm.c_str());
+   return (RoutingAlgorithm) -1;
+}
+
+UInt8
+NetworkModelEMeshHopByHop::computeAdaptiveOutputPorts(tile_id_t sender, tile_id_t receiver)
+{
+   SInt32 cx, cy, dx, dy;
+   computePosition(_tile_id, cx, cy);
+   computePosition(receiver, dx, dy);
+
+   UInt8 y_port = (dy > cy) ? (1 << UP) : ((dy < cy) ? (1 << DOWN) : 0);
+
+   if (_routing_algorithm == WEST_FIRST_ROUTING)
+   {
+      // All the hops to the west come first
+      if (dx < cx)
+         return (1 << LEFT);
+      return ((dx > cx) ? (1 << RIGHT) : 0) | y_port;
+   }
+
+   else // (_routing_algorithm == ODD_EVEN_ROUTING)
+   {
+      // Chiu's odd-even turn model: no east->north/south turn in an even
+      // column, no north/south->west turn in an odd column. Packets from
+      // the system tiles enter the mesh on their first hop
+      SInt32 sx = -1, sy;
+      if (sender < _mesh_width * _mesh_height)
+         computePosition(sender, sx, sy);
+
+      if (dx == cx)
+         return y_port;
+
+      UInt8 ports = 0;
+      if (dx > cx)
+      {
+         if (dy == cy)
+            return (1 << RIGHT);
+         if ((cx % 2 == 1) || (cx == sx))
+            ports |= y_port;
+         if ((dx % 2 == 1) || (dx - cx != 1))
+            ports |= (1 << RIGHT);
+      }
+      else
+      {
+         ports |= (1 << LEFT);
+         if (cx % 2 == 0)
+            ports |= y_port;
+      }
+      return ports;
+   }
+}
+
+SInt32
+NetworkModelEMeshHopByHop::computeAdaptiveOutputPort(tile_id_t sender, tile_id_t receiver, SInt32 xy_output_port)
+{
+   UInt8 ports = computeAdaptiveOutputPorts(sender, receiver);
+   LOG_ASSERT_ERROR(ports != 0, "No output port from tile(%i) to tile(%i)", _tile_id, receiver);
+   // Only one choice
+   if ((ports & (ports - 1)) == 0)
+   {
+      SInt32 output_port = LEFT;
+      while (!(ports & (1 << output_port)))
+         output_port ++;
+      if (output_port != xy_output_port)
+         _total_non_xy_hops ++;
+      return output_port;
+   }
+
+   // The queue models of the output ports estimate their congestion (the
+   // directions are tried in XY order, the first one wins ties)
+   _total_adaptive_routing_decisions ++;
+   SInt32 output_port = -1;
+   float min_contention_delay = 0;
+   for (SInt32 direction = LEFT; direction < NUM_OUTPUT_DIRECTIONS; direction++)
+   {
+      if (!(ports & (1 << direction)))
+         continue;
+      float contention_delay = _mesh_router->getRecentContentionDelay(direction);
+      if ((output_port == -1) || (contention_delay < min_contention_delay))
+      {
+         output_port = direction;
+         min_contention_delay = contention_delay;
+      }
+   }
+   if (output_port != xy_output_port)
+      _total_non_xy_hops ++;
+   return output_port;
+}
+
 void
 NetworkModelEMeshHopByHop::createRouterAndLinkModels()
 {
@@ -115,6 +363,24 @@ NetworkModelEMeshHopByHop::createRouterAndLinkModels()
    _mesh_router = new RouterModel(this, _frequency, _num_mesh_router_ports, _num_mesh_router_ports,
                                   num_flits_per_output_buffer, router_delay, _flit_width,
                                   _contention_model_enabled, contention_model_type);
+
+   if (_contention_model_enabled && _contention_sampling_enabled)
+   {
+      _injection_router->enableContentionSampling(_contention_sampling_detailed_window, _contention_sampling_ratio);
+      _mesh_router->enableContentionSampling(_contention_sampling_detailed_window, _contention_sampling_ratio);
+   }
+
+   // The port buffer is split among the virtual channels. A credit comes
+   // back after the flit crosses the link and the next router
+   if (_flow_control_enabled)
+   {
+      LOG_ASSERT_ERROR((SInt32) num_flits_per_output_buffer >= _num_virtual_channels,
+                       "Port buffer(%u flits) smaller than the number of virtual channels(%i)",
+                       num_flits_per_output_buffer, _num_virtual_channels);
+      _mesh_router->enableFlowControl(_num_virtual_channels, num_flits_per_output_buffer / _num_virtual_channels,
+                                      link_delay + router_delay + _credit_delay);
+   }
+
    // Mesh Link List
    volatile double link_length = _tile_width;
    _mesh_link_list.resize(_num_mesh_router_ports);
@@ -159,51 +425,49 @@ NetworkModelEMeshHopByHop::routePacket(const NetPacket &pkt, queue<Hop> &next_ho
 
    else if (pkt.node_type == EMESH)
    {
+      SInt32 num_tiles = _mesh_width * _mesh_height;
+      const tile_id_t* neighbors = &_neighbor_tile[_tile_id * NUM_OUTPUT_DIRECTIONS];
+
       if (pkt_receiver == NetPacket::BROADCAST)
       {
-         SInt32 sx, sy, cx, cy;
-         computePosition(pkt_sender, sx, sy);
-         computePosition(_tile_id, cx, cy);
+         UInt8 ports = _broadcast_output_ports[pkt_sender * num_tiles + _tile_id];
+         // A multicast is replicated along the broadcast tree, only on the
+         // branches that lead to its receivers
+         bool deliver = true;
+         if (pkt.isMulticast())
+         {
+            UInt8 multicast_ports = computeMulticastOutputPorts(pkt);
+            ports &= multicast_ports;
+            deliver = (multicast_ports & (1 << SELF));
+         }
 
+         // Same order as the broadcast tree is traversed: up, down, right, left, self
+         static const SInt32 broadcast_order[] = { UP, DOWN, RIGHT, LEFT };
          list<NextDest> next_dest_list;
-
-         if (cy >= sy)
-            next_dest_list.push_back(NextDest(computeTileID(cx,cy+1), UP, EMESH));
-         if (cy <= sy)
-            next_dest_list.push_back(NextDest(computeTileID(cx,cy-1), DOWN, EMESH));
-         if (cy == sy)
+         for (UInt32 i = 0; i < sizeof(broadcast_order) / sizeof(broadcast_order[0]); i++)
          {
-            if (cx >= sx)
-               next_dest_list.push_back(NextDest(computeTileID(cx+1,cy), RIGHT, EMESH));
-            if (cx <= sx)
-               next_dest_list.push_back(NextDest(computeTileID(cx-1,cy), LEFT, EMESH));
+            SInt32 direction = broadcast_order[i];
+            if (ports & (1 << direction))
+               next_dest_list.push_back(NextDest(neighbors[direction], direction, EMESH));
          }
-         next_dest_list.push_back(NextDest(_tile_id, SELF, RECEIVE_TILE));
+         if (deliver)
+            next_dest_list.push_back(NextDest(_tile_id, SELF, RECEIVE_TILE));
+         assert(!next_dest_list.empty());
 
          UInt64 zero_load_delay = 0;
          UInt64 contention_delay = 0;
         
          // Get the link delay as well as a vector of directions
-         // Remove the tile_ids' that are invalid
          UInt64 max_link_delay = 0;
          vector<SInt32> output_port_list;
-         for (list<NextDest>::iterator it = next_dest_list.begin(); it != next_dest_list.end(); )
+         for (list<NextDest>::iterator it = next_dest_list.begin(); it != next_dest_list.end(); it++)
          {
-            if ((*it)._tile_id != INVALID_TILE_ID)
-            {
-               SInt32 output_port = (*it)._output_port;
-               output_port_list.push_back(output_port);
-            
-               UInt64 link_delay = 0;
-               _mesh_link_list[output_port]->processPacket(pkt, link_delay);
-               max_link_delay = max<UInt64>(max_link_delay, link_delay);
-
-               it ++;
-            }
-            else
-            {
-               it = next_dest_list.erase(it);
-            }
+            SInt32 output_port = (*it)._output_port;
+            output_port_list.push_back(output_port);
+         
+            UInt64 link_delay = 0;
+            _mesh_link_list[output_port]->processPacket(pkt, link_delay);
+            max_link_delay = max<UInt64>(max_link_delay, link_delay);
          }
          // Update the zero_load_delay
          zero_load_delay += max_link_delay;
@@ -221,22 +485,12 @@ NetworkModelEMeshHopByHop::routePacket(const NetPacket &pkt, queue<Hop> &next_ho
 
       else // (pkt_receiver != NetPacket::BROADCAST)
       {
-         SInt32 cx, cy, dx, dy;
-         computePosition(_tile_id, cx, cy);
-         computePosition(pkt_receiver, dx, dy);
-
-         NextDest next_dest;
-
-         if (cx > dx)
-            next_dest = NextDest(computeTileID(cx-1,cy), LEFT, EMESH);
-         else if (cx < dx)
-            next_dest = NextDest(computeTileID(cx+1,cy), RIGHT, EMESH);
-         else if (cy > dy)
-            next_dest = NextDest(computeTileID(cx,cy-1), DOWN, EMESH);
-         else if (cy < dy)
-            next_dest = NextDest(computeTileID(cx,cy+1), UP, EMESH);
-         else
-            next_dest = NextDest(_tile_id, SELF, RECEIVE_TILE);
+         SInt32 output_port = _unicast_output_port[_tile_id * num_tiles + pkt_receiver];
+         if ((_routing_algorithm != XY_ROUTING) && (output_port != SELF))
+            output_port = computeAdaptiveOutputPort(pkt_sender, pkt_receiver, output_port);
+         NextDest next_dest = (output_port == SELF) ?
+                              NextDest(_tile_id, SELF, RECEIVE_TILE) :
+                              NextDest(neighbors[output_port], output_port, EMESH);
 
          UInt64 zero_load_delay = 0;
          UInt64 contention_delay = 0;
@@ -302,6 +556,8 @@ NetworkModelEMeshHopByHop::outputSummary(ostream &out)
    outputEventCountSummary(out);
    if (_contention_model_enabled)
       outputContentionModelsSummary(out);
+   if (_routing_algorithm != XY_ROUTING)
+      outputAdaptiveRoutingSummary(out);
 }
 
 bool
@@ -362,6 +618,102 @@ NetworkModelEMeshHopByHop::computeMemoryControllerPositions(SInt32 num_memory_co
    return (make_pair(true, tile_id_list_with_memory_controllers));
 }
 
+// Local search from 'initial_positions': a controller moves to a neighboring
+// tile as long as that lowers the cost of the placement, i.e., the hop
+// distance from every tile to its nearest controller weighted by the DRAM
+// traffic of the tile, plus 'link_load_weight' times the traffic on the
+// busiest link (requests and replies follow the XY routes)
+pair<bool, vector<tile_id_t> >
+NetworkModelEMeshHopByHop::optimizeMemoryControllerPositions(const vector<UInt64>& traffic,
+                                                             const vector<tile_id_t>& initial_positions,
+                                                             double link_load_weight)
+{
+   // Initialize mesh_width, mesh_height
+   initializeEMeshTopologyParams();
+
+   SInt32 num_tiles = _mesh_width * _mesh_height;
+   LOG_ASSERT_ERROR(traffic.size() == (size_t) num_tiles, "Traffic profile has %u tiles, mesh has %i",
+                    (UInt32) traffic.size(), num_tiles);
+
+   vector<tile_id_t> positions = initial_positions;
+   vector<bool> has_memory_controller(num_tiles, false);
+   for (vector<tile_id_t>::iterator it = positions.begin(); it != positions.end(); it++)
+      has_memory_controller[*it] = true;
+
+   double cost = computePlacementCost(traffic, positions, link_load_weight);
+   bool improved = true;
+   while (improved)
+   {
+      improved = false;
+      for (UInt32 i = 0; i < positions.size(); i++)
+      {
+         for (SInt32 direction = LEFT; direction < NUM_OUTPUT_DIRECTIONS; direction++)
+         {
+            tile_id_t current = positions[i];
+            tile_id_t neighbor = _neighbor_tile[current * NUM_OUTPUT_DIRECTIONS + direction];
+            if ((neighbor == INVALID_TILE_ID) || has_memory_controller[neighbor])
+               continue;
+
+            positions[i] = neighbor;
+            double new_cost = computePlacementCost(traffic, positions, link_load_weight);
+            if (new_cost < cost)
+            {
+               has_memory_controller[current] = false;
+               has_memory_controller[neighbor] = true;
+               cost = new_cost;
+               improved = true;
+            }
+            else
+            {
+               positions[i] = current;
+            }
+         }
+      }
+   }
+
+   return (make_pair(true, positions));
+}
+
+double
+NetworkModelEMeshHopByHop::computePlacementCost(const vector<UInt64>& traffic, const vector<tile_id_t>& positions,
+                                                double link_load_weight)
+{
+   SInt32 num_tiles = _mesh_width * _mesh_height;
+   vector<UInt64> link_load(num_tiles * NUM_OUTPUT_DIRECTIONS, 0);
+
+   double weighted_distance = 0;
+   for (tile_id_t tile = 0; tile < num_tiles; tile++)
+   {
+      if (traffic[tile] == 0)
+         continue;
+
+      tile_id_t nearest = positions[0];
+      for (vector<tile_id_t>::const_iterator it = positions.begin(); it != positions.end(); it++)
+      {
+         if (computeDistance(tile, *it) < computeDistance(tile, nearest))
+            nearest = *it;
+      }
+      weighted_distance += (double) traffic[tile] * computeDistance(tile, nearest);
+
+      // Request to the controller, then reply
+      tile_id_t endpoints[2][2] = { {tile, nearest}, {nearest, tile} };
+      for (SInt32 i = 0; i < 2; i++)
+      {
+         tile_id_t current = endpoints[i][0];
+         tile_id_t receiver = endpoints[i][1];
+         while (current != receiver)
+         {
+            UInt8 direction = _unicast_output_port[current * num_tiles + receiver];
+            link_load[current * NUM_OUTPUT_DIRECTIONS + direction] += traffic[tile];
+            current = _neighbor_tile[current * NUM_OUTPUT_DIRECTIONS + direction];
+         }
+      }
+   }
+
+   UInt64 max_link_load = *max_element(link_load.begin(), link_load.end());
+   return weighted_distance + link_load_weight * max_link_load;
+}
+
 pair<bool, vector<Config::TileList> >
 NetworkModelEMeshHopByHop::computeProcessToTileMapping()
 {
@@ -476,6 +828,13 @@ NetworkModelEMeshHopByHop::outputContentionModelsSummary(ostream& out)
       out << "      Average EMesh Router Contention Delay: " << _mesh_router->getAverageContentionDelay(0, _num_mesh_router_ports-1) << endl;
       out << "      Average EMesh Router Link Utilization: " << _mesh_router->getAverageLinkUtilization(0, _num_mesh_router_ports-1) << endl;
       out << "      Percentage Analytical Models Used: " << _mesh_router->getPercentAnalyticalModelsUsed(0, _num_mesh_router_ports-1) << endl;
+      if (_contention_sampling_enabled)
+         out << "      Percentage Packets Fast-Forwarded: " << _mesh_router->getPercentPacketsFastForwarded(0, _num_mesh_router_ports-1) << endl;
+      if (_flow_control_enabled)
+      {
+         out << "      Average Flow Control Stall Delay: " << _mesh_router->getAverageFlowControlStallDelay(0, _num_mesh_router_ports-1) << endl;
+         out << "      Percentage Packets Stalled by Flow Control: " << _mesh_router->getPercentPacketsStalledByFlowControl(0, _num_mesh_router_ports-1) << endl;
+      }
    }
 
    else if (isSystemTile(_tile_id))
@@ -483,6 +842,13 @@ NetworkModelEMeshHopByHop::outputContentionModelsSummary(ostream& out)
       out << "      Average EMesh Router Contention Delay: " << endl;
       out << "      Average EMesh Router Link Utilization: " << endl;
       out << "      Percentage Analytical Models Used: " << endl;
+      if (_contention_sampling_enabled)
+         out << "      Percentage Packets Fast-Forwarded: " << endl;
+      if (_flow_control_enabled)
+      {
+         out << "      Average Flow Control Stall Delay: " << endl;
+         out << "      Percentage Packets Stalled by Flow Control: " << endl;
+      }
    }
 
    else
@@ -520,3 +886,23 @@ NetworkModelEMeshHopByHop::outputPowerSummary(ostream& out)
       LOG_PRINT_ERROR("Unrecognized Tile ID(%i)", _tile_id);
    }
 }
+
+void
+NetworkModelEMeshHopByHop::outputAdaptiveRoutingSummary(ostream& out)
+{
+   out << "    Adaptive Routing:" << endl;
+   if (isApplicationTile(_tile_id))
+   {
+      out << "      Adaptive Routing Decisions: " << _total_adaptive_routing_decisions << endl;
+      out << "      Non-XY Hops: " << _total_non_xy_hops << endl;
+   }
+   else if (isSystemTile(_tile_id))
+   {
+      out << "      Adaptive Routing Decisions: " << endl;
+      out << "      Non-XY Hops: " << endl;
+   }
+   else
+   {
+      LOG_PRINT_ERROR("Unrecognized Tile ID(%i)", _tile_id);
+   }
+}
@@ -21,6 +21,9 @@ public:
 
    static bool isTileCountPermissible(SInt32 tile_count);
    static pair<bool,vector<tile_id_t> > computeMemoryControllerPositions(SInt32 num_memory_controllers, SInt32 tile_count);
+   static pair<bool,vector<tile_id_t> > optimizeMemoryControllerPositions(const vector<UInt64>& traffic,
+                                                                         const vector<tile_id_t>& initial_positions,
+                                                                         double link_load_weight);
    static pair<bool,vector<Config::TileList> > computeProcessToTileMapping();
 
    void outputSummary(std::ostream &out);
@@ -39,7 +42,18 @@ private:
       LEFT,
       RIGHT,
       DOWN,
-      UP
+      UP,
+      NUM_OUTPUT_DIRECTIONS
+   };
+
+   // Unicast routing. The adaptive algorithms are minimal and
+   // turn-restricted (deadlock-free), a packet takes the least congested of
+   // the directions they allow
+   enum RoutingAlgorithm
+   {
+      XY_ROUTING = 0,
+      WEST_FIRST_ROUTING,
+      ODD_EVEN_ROUTING
    };
 
    // Fields
@@ -47,8 +61,29 @@ private:
    static SInt32 _mesh_width;
    static SInt32 _mesh_height;
 
+   // Routing tables, computed once for the mesh. XY routing only
+   // depends on the current tile and the destination (unicast) or the
+   // sender (broadcast), so routePacket() never has to recompute it.
+   // _unicast_output_port[current * num_tiles + receiver]
+   static vector<UInt8> _unicast_output_port;
+   // Bitmask of (1 << OutputDirection), SELF excluded.
+   // _broadcast_output_ports[sender * num_tiles + current]
+   static vector<UInt8> _broadcast_output_ports;
+   // _neighbor_tile[current * NUM_OUTPUT_DIRECTIONS + direction]
+   static vector<tile_id_t> _neighbor_tile;
+
+   static RoutingAlgorithm _routing_algorithm;
+
    // Is contention model enabled?
    static bool _contention_model_enabled;
+   // Is contention sampling (fast-forward) enabled?
+   static bool _contention_sampling_enabled;
+   static UInt64 _contention_sampling_detailed_window;
+   static float _contention_sampling_ratio;
+   // Is finite-buffer flow control (virtual channels and credits) enabled?
+   static bool _flow_control_enabled;
+   static SInt32 _num_virtual_channels;
+   static UInt64 _credit_delay;
 
    // Injection Router 
    RouterModel* _injection_router;
@@ -58,11 +93,24 @@ private:
    RouterModel* _mesh_router;
    vector<ElectricalLinkModel*> _mesh_link_list;
 
+   // Adaptive Routing Counters
+   UInt64 _total_adaptive_routing_decisions;
+   UInt64 _total_non_xy_hops;
+
    // Routing Function
    void routePacket(const NetPacket &pkt, queue<Hop> &next_hops);
+   // Ports of the broadcast tree that lead to a receiver of the multicast
+   UInt8 computeMulticastOutputPorts(const NetPacket &pkt);
+   // Bitmask of the directions the adaptive algorithm allows towards the
+   // receiver (SELF excluded, current != receiver)
+   UInt8 computeAdaptiveOutputPorts(tile_id_t sender, tile_id_t receiver);
+   // Least congested of them, the XY direction on ties
+   SInt32 computeAdaptiveOutputPort(tile_id_t sender, tile_id_t receiver, SInt32 xy_output_port);
+   static RoutingAlgorithm parseRoutingAlgorithm(string algorithm);
    
    // Toplogy Params
    static void initializeEMeshTopologyParams();
+   static void initializeRoutingTables();
    
    // Router & Link Models
    void createRouterAndLinkModels();
@@ -71,8 +119,12 @@ private:
    // Utilities
    static void computePosition(tile_id_t tile, SInt32 &x, SInt32 &y);
    static tile_id_t computeTileID(SInt32 x, SInt32 y);
+   // Cost of a memory controller placement (see optimizeMemoryControllerPositions())
+   static double computePlacementCost(const vector<UInt64>& traffic, const vector<tile_id_t>& positions,
+                                      double link_load_weight);
 
    void outputEventCountSummary(ostream& out);
    void outputPowerSummary(ostream& out);
    void outputContentionModelsSummary(ostream& out);
+   void outputAdaptiveRoutingSummary(ostream& out);
 };
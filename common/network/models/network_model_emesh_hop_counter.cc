@@ -6,6 +6,7 @@
 #include "config.h"
 #include "config.h"
 #include "tile.h"
+#include "statistics_manager.h"
 
 NetworkModelEMeshHopCounter::NetworkModelEMeshHopCounter(Network *net, SInt32 network_id)
    : NetworkModel(net, network_id)
@@ -89,6 +90,15 @@ NetworkModelEMeshHopCounter::createRouterAndLinkModels()
       _router_power_model = new RouterPowerModel(_frequency, num_router_ports, num_router_ports,
                                                  num_flits_per_output_buffer, _flit_width);
       _electrical_link_power_model = new ElectricalLinkPowerModel(link_type, _frequency, link_length, _flit_width);
+
+      // Power trace (the link model stands for the links in all directions)
+      if (Sim()->getStatisticsManager())
+      {
+         Sim()->getStatisticsManager()->registerPowerModel(_tile_id, _router_power_model);
+         Sim()->getStatisticsManager()->registerPowerModel(_tile_id, _electrical_link_power_model, _NUM_OUTPUT_DIRECTIONS);
+      }
+      _router_power_model->registerEventCounters(_tile_id, getPowerModelCounterPrefix("Router"));
+      _electrical_link_power_model->registerEventCounters(_tile_id, getPowerModelCounterPrefix("Electrical Link"));
    }
 
 }
@@ -148,7 +158,13 @@ NetworkModelEMeshHopCounter::routePacket(const NetPacket &pkt, queue<Hop> &next_
    computePosition(TILE_ID(pkt.receiver), dx, dy);
 
    UInt32 num_hops = computeDistance(sx, sy, dx, dy);
-   UInt64 latency = (isModelEnabled(pkt)) ? (num_hops * _hop_latency) : 0;
+   UInt64 latency = 0;
+   if (isModelEnabled(pkt))
+   {
+      latency = num_hops * _hop_latency;
+      if (getSwitchingMode() == STORE_AND_FORWARD)
+         latency += computeStoreAndForwardDelay(computeNumFlits(getModeledLength(pkt)), num_hops);
+   }
 
    updateDynamicEnergy(pkt, num_hops);
 
@@ -156,6 +172,32 @@ NetworkModelEMeshHopCounter::routePacket(const NetPacket &pkt, queue<Hop> &next_
    next_hops.push(hop);
 }
 
+void
+NetworkModelEMeshHopCounter::routePacketToReceivers(const NetPacket &pkt, SInt32 num_flits,
+                                                    const vector<tile_id_t>& receivers, vector<Hop>& hops)
+{
+   SInt32 sx, sy;
+   computePosition(TILE_ID(pkt.sender), sx, sy);
+
+   bool enabled = isModelEnabled(pkt);
+   UInt32 total_hops = 0;
+   for (vector<tile_id_t>::const_iterator it = receivers.begin(); it != receivers.end(); it++)
+   {
+      SInt32 dx, dy;
+      computePosition(*it, dx, dy);
+
+      UInt32 num_hops = computeDistance(sx, sy, dx, dy);
+      UInt64 latency = enabled ? ((num_hops * _hop_latency) + computeStoreAndForwardDelay(num_flits, num_hops)) : 0;
+      total_hops += num_hops;
+
+      hops.push_back(Hop(pkt, *it, RECEIVE_TILE, latency, 0));
+   }
+
+   // Energy and event counts are linear in the number of hops
+   if (enabled)
+      updateDynamicEnergy(num_flits, total_hops);
+}
+
 void
 NetworkModelEMeshHopCounter::outputSummary(std::ostream &out)
 {
@@ -172,7 +214,12 @@ NetworkModelEMeshHopCounter::updateDynamicEnergy(const NetPacket& packet, UInt32
       return;
 
    UInt32 num_flits = computeNumFlits(getModeledLength(packet));
-    
+   updateDynamicEnergy(num_flits, num_hops);
+}
+
+void
+NetworkModelEMeshHopCounter::updateDynamicEnergy(UInt32 num_flits, UInt32 num_hops)
+{
    // Update event counters 
    updateEventCounters(num_flits, num_hops);
 
@@ -13,6 +13,7 @@ public:
    ~NetworkModelEMeshHopCounter();
 
    void routePacket(const NetPacket &pkt, queue<Hop> &next_hops);
+   bool hasSingleHopRoutes() { return true; }
    void outputSummary(std::ostream &out);
 
 private:
@@ -41,7 +42,10 @@ private:
    
    void computePosition(tile_id_t tile, SInt32 &x, SInt32 &y);
    SInt32 computeDistance(SInt32 x1, SInt32 y1, SInt32 x2, SInt32 y2);
+   void routePacketToReceivers(const NetPacket &pkt, SInt32 num_flits,
+                               const vector<tile_id_t>& receivers, vector<Hop>& hops);
    void updateDynamicEnergy(const NetPacket& packet, UInt32 num_hops);
+   void updateDynamicEnergy(UInt32 num_flits, UInt32 num_hops);
    void updateEventCounters(UInt32 num_flits, UInt32 num_hops);
    
    // Summary
@@ -0,0 +1,76 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include "network_model_flattened_butterfly.h"
+#include "simulator.h"
+#include "log.h"
+
+NetworkModelFlattenedButterfly::NetworkModelFlattenedButterfly(Network* net, SInt32 network_id)
+   : NetworkModelElectricalGrid(net, network_id, "network/flattened_butterfly", getConcentration())
+{
+   createRouterAndLinkModels();
+}
+
+NetworkModelFlattenedButterfly::~NetworkModelFlattenedButterfly()
+{}
+
+SInt32
+NetworkModelFlattenedButterfly::getConcentration()
+{
+   try
+   {
+      return Sim()->getCfg()->getInt("network/flattened_butterfly/concentration");
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read network/flattened_butterfly/concentration from the cfg file");
+      return 1;
+   }
+}
+
+bool
+NetworkModelFlattenedButterfly::isTileCountPermissible(SInt32 tile_count)
+{
+   SInt32 width, height;
+   if (!computeGridDimensions(tile_count, getConcentration(), width, height))
+   {
+      fprintf(stderr, "Can't form a flattened butterfly with tile count(%i), concentration(%i)\n",
+              tile_count, getConcentration());
+      return false;
+   }
+   return true;
+}
+
+SInt32
+NetworkModelFlattenedButterfly::computeNetworkPort(SInt32 router, SInt32 destination)
+{
+   SInt32 cx, cy, dx, dy;
+   computeRouterPosition(router, cx, cy);
+   computeRouterPosition(destination, dx, dy);
+
+   if (cx != dx)
+      return (dx < cx) ? dx : (dx - 1);
+   LOG_ASSERT_ERROR(cy != dy, "Router(%i) routing to itself", router);
+   return (_grid_width - 1) + ((dy < cy) ? dy : (dy - 1));
+}
+
+SInt32
+NetworkModelFlattenedButterfly::computeNeighborRouter(SInt32 router, SInt32 network_port)
+{
+   SInt32 x, y;
+   computeRouterPosition(router, x, y);
+   if (network_port < (_grid_width - 1))
+      return computeRouterID((network_port < x) ? network_port : (network_port + 1), y);
+   network_port -= (_grid_width - 1);
+   LOG_ASSERT_ERROR(network_port < (_grid_height - 1), "Unrecognized network port(%i)", network_port);
+   return computeRouterID(x, (network_port < y) ? network_port : (network_port + 1));
+}
+
+double
+NetworkModelFlattenedButterfly::computeLinkLength(SInt32 router, SInt32 network_port)
+{
+   SInt32 x, y, nx, ny;
+   computeRouterPosition(router, x, y);
+   computeRouterPosition(computeNeighborRouter(router, network_port), nx, ny);
+   return (abs(nx - x) + abs(ny - y)) * sqrt((double) _concentration) * _tile_width;
+}
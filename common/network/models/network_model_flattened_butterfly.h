@@ -0,0 +1,27 @@
+#pragma once
+
+#include "network_model_electrical_grid.h"
+
+// 2D flattened butterfly ([network/flattened_butterfly]): a grid of routers,
+// each shared by 'concentration' tiles and linked to every router of its row
+// and of its column. Minimal routing, at most one hop along X then one along
+// Y. The links are as long as the distance between their routers, which are
+// sqrt(concentration) tiles apart
+class NetworkModelFlattenedButterfly : public NetworkModelElectricalGrid
+{
+public:
+   NetworkModelFlattenedButterfly(Network* net, SInt32 network_id);
+   ~NetworkModelFlattenedButterfly();
+
+   static bool isTileCountPermissible(SInt32 tile_count);
+
+private:
+   static SInt32 getConcentration();
+
+   // The network ports go to the other routers of the row (by column), then
+   // to the other routers of the column (by row)
+   SInt32 getNumNetworkPorts() { return (_grid_width - 1) + (_grid_height - 1); }
+   SInt32 computeNetworkPort(SInt32 router, SInt32 destination);
+   SInt32 computeNeighborRouter(SInt32 router, SInt32 network_port);
+   double computeLinkLength(SInt32 router, SInt32 network_port);
+};
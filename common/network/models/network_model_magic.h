@@ -10,6 +10,7 @@ public:
    ~NetworkModelMagic();
 
    void routePacket(const NetPacket &pkt, queue<Hop>& next_hops);
+   bool hasSingleHopRoutes() { return true; }
    void outputSummary(std::ostream &out);
 };
 
@@ -0,0 +1,74 @@
+#include "network_model_torus.h"
+#include "log.h"
+
+NetworkModelTorus::NetworkModelTorus(Network* net, SInt32 network_id)
+   : NetworkModelElectricalGrid(net, network_id, "network/torus", 1)
+{
+   createRouterAndLinkModels();
+}
+
+NetworkModelTorus::~NetworkModelTorus()
+{}
+
+bool
+NetworkModelTorus::isTileCountPermissible(SInt32 tile_count)
+{
+   SInt32 width, height;
+   if (!computeGridDimensions(tile_count, 1, width, height))
+   {
+      fprintf(stderr, "Can't form a torus with tile count(%i)\n", tile_count);
+      return false;
+   }
+   return true;
+}
+
+SInt32
+NetworkModelTorus::computeNetworkPort(SInt32 router, SInt32 destination)
+{
+   SInt32 cx, cy, dx, dy;
+   computeRouterPosition(router, cx, cy);
+   computeRouterPosition(destination, dx, dy);
+
+   // Hops to the destination going right (up), the other way round the ring
+   // is shorter if they are more than half of it
+   if (cx != dx)
+   {
+      SInt32 hops = (dx - cx + _grid_width) % _grid_width;
+      return (2 * hops <= _grid_width) ? RIGHT : LEFT;
+   }
+   else
+   {
+      LOG_ASSERT_ERROR(cy != dy, "Router(%i) routing to itself", router);
+      SInt32 hops = (dy - cy + _grid_height) % _grid_height;
+      return (2 * hops <= _grid_height) ? UP : DOWN;
+   }
+}
+
+SInt32
+NetworkModelTorus::computeNeighborRouter(SInt32 router, SInt32 network_port)
+{
+   SInt32 x, y;
+   computeRouterPosition(router, x, y);
+   switch (network_port)
+   {
+   case LEFT:
+      return computeRouterID((x - 1 + _grid_width) % _grid_width, y);
+   case RIGHT:
+      return computeRouterID((x + 1) % _grid_width, y);
+   case DOWN:
+      return computeRouterID(x, (y - 1 + _grid_height) % _grid_height);
+   case UP:
+      return computeRouterID(x, (y + 1) % _grid_height);
+   default:
+      LOG_PRINT_ERROR("Unrecognized network port(%i)", network_port);
+      return -1;
+   }
+}
+
+double
+NetworkModelTorus::computeLinkLength(SInt32 router, SInt32 network_port)
+{
+   // Folded rings of more than two routers skip every other tile
+   SInt32 ring_size = ((network_port == LEFT) || (network_port == RIGHT)) ? _grid_width : _grid_height;
+   return (ring_size > 2) ? (2 * _tile_width) : _tile_width;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "network_model_electrical_grid.h"
+
+// 2D torus of routers, one per tile ([network/torus]). Dimension-order
+// routing along X then Y, each in the shorter direction around the ring.
+// The rings are folded, so every link spans two tiles. The dateline
+// virtual channels that keep the rings deadlock-free double the router
+// buffers of the power model; latency is modeled with infinite buffers
+class NetworkModelTorus : public NetworkModelElectricalGrid
+{
+public:
+   NetworkModelTorus(Network* net, SInt32 network_id);
+   ~NetworkModelTorus();
+
+   static bool isTileCountPermissible(SInt32 tile_count);
+
+private:
+   enum NetworkPort
+   {
+      LEFT = 0,
+      RIGHT,
+      DOWN,
+      UP,
+      NUM_NETWORK_PORTS
+   };
+
+   SInt32 getNumNetworkPorts() { return NUM_NETWORK_PORTS; }
+   SInt32 computeNetworkPort(SInt32 router, SInt32 destination);
+   SInt32 computeNeighborRouter(SInt32 router, SInt32 network_port);
+   double computeLinkLength(SInt32 router, SInt32 network_port);
+   SInt32 getNumVirtualChannels() { return 2; }
+};
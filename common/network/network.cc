@@ -1,5 +1,11 @@
+#include <algorithm>
+
 #include "transport.h"
+#include "message_buffer.h"
 #include "tile.h"
+#include "core.h"
+#include "config.h"
+#include "clock_skew_minimization_object.h"
 #include "network.h"
 #include "memory_manager.h"
 #include "simulator.h"
@@ -7,7 +13,11 @@
 #include "clock_converter.h"
 #include "fxsupport.h"
 #include "network_model.h"
+#include "latency_histogram.h"
 #include "statistics_manager.h"
+#include "host_profiler.h"
+#include "event_tracer.h"
+#include "network_trace.h"
 #include "utils.h"
 #include "log.h"
 
@@ -21,13 +31,20 @@ using namespace std;
 
 // For getting a periodic summary of network utilization
 bool* Network::_utilizationTraceEnabled;
-ofstream* Network::_utilizationTraceFiles;
+TraceFile* Network::_utilizationTraceFiles;
+// For getting a periodic summary of network latency percentiles
+bool* Network::_latencyTraceEnabled;
+TraceFile* Network::_latencyTraceFiles;
+LatencyHistogram* Network::_latencyTraceHistograms;
+UInt64 Network::_latencyTraceNumSamples;
 
 Network::Network(Tile *tile)
       : _tile(tile)
 {
    LOG_ASSERT_ERROR(sizeof(g_type_to_static_network_map) / sizeof(EStaticNetwork) == NUM_PACKET_TYPES,
                     "Static network type map has incorrect number of entries.");
+   LOG_ASSERT_ERROR(sizeof(g_packet_type_name_list) / sizeof(string) == NUM_PACKET_TYPES,
+                    "Packet type name list has incorrect number of entries.");
 
    _numMod = Config::getSingleton()->getTotalTiles();
    _tid = _tile->getId();
@@ -39,11 +56,23 @@ Network::Network(Tile *tile)
    for (SInt32 i = 0; i < NUM_PACKET_TYPES; i++)
       _callbacks[i] = NULL;
 
+   _numPacketsSentTo = new UInt64 [_numMod];
+   for (SInt32 i = 0; i < _numMod; i++)
+      _numPacketsSentTo[i] = 0;
+
+   // The networks not in network/active_networks have no model. A scale
+   // run only builds the models of the active networks that are used
+   parseNetworkList("network/active_networks", _activeNetworks, "user_1, user_2, memory_1, memory_2, system");
+   LOG_ASSERT_ERROR(_activeNetworks[STATIC_NETWORK_USER_1] && _activeNetworks[STATIC_NETWORK_SYSTEM],
+                    "network/active_networks must include user_1 and system");
+   parseSharedNetworks();
+   _modelsEnabled = false;
+   _coreFrequency = Config::getSingleton()->getCoreFrequency(Tile::getMainCoreId(_tid));
    for (SInt32 i = 0; i < NUM_STATIC_NETWORKS; i++)
    {
-      UInt32 network_model = NetworkModel::parseNetworkType(Config::getSingleton()->getNetworkType(i));
-      
-      _models[i] = NetworkModel::createModel(this, i, network_model);
+      _models[i] = NULL;
+      if (_activeNetworks[i] && !Config::getSingleton()->isScaleMemoryMode())
+         createNetworkModel(i);
    }
 
    // Shared Memory Shortcut enabled
@@ -54,17 +83,83 @@ Network::Network(Tile *tile)
                        "Cannot Enable Shared Memory Shortcut for (%i) processes", Config::getSingleton()->getProcessCount());
    }
 
+   // Timestamp ordered delivery of the received packets
+   bool delivery_wheel_enabled = false;
+   UInt64 delivery_wheel_bucket_size = 0;
+   try
+   {
+      delivery_wheel_enabled = Sim()->getCfg()->getBool("network/delivery_wheel/enabled", false);
+      delivery_wheel_bucket_size = Sim()->getCfg()->getInt("network/delivery_wheel/bucket_size", 1);
+   }
+   catch(...)
+   {
+      LOG_PRINT_ERROR("Could not read network/delivery_wheel parameters from the cfg file");
+   }
+   LOG_ASSERT_ERROR(delivery_wheel_bucket_size >= 1, "network/delivery_wheel/bucket_size must be >= 1");
+   // A deterministic run orders the packets of every pull
+   if (Config::getSingleton()->isDeterministic())
+      delivery_wheel_enabled = true;
+   _deliveryWheel = delivery_wheel_enabled ? new TimingWheel<ScheduledPacket>(delivery_wheel_bucket_size) : NULL;
+   _numScheduledPackets = 0;
+   _numDeliveryBatches = 0;
+   _numReorderedPackets = 0;
+
+   try
+   {
+      _directDeliveryEnabled = Sim()->getCfg()->getBool("network/direct_delivery", false);
+   }
+   catch(...)
+   {
+      LOG_PRINT_ERROR("Could not read network/direct_delivery from the cfg file");
+   }
+   for (SInt32 i = 0; i < NUM_STATIC_NETWORKS; i++)
+      _magicNetworks[i] = (Config::getSingleton()->getNetworkType(i) == "magic");
+   _directDeliveryOnDisabledModels = true;
+   _numDirectlyDeliveredPackets = 0;
+
+   // Packet traces of the application tiles
+   bool trace_enabled = false;
+   UInt64 trace_dependency_window = 0;
+   try
+   {
+      trace_enabled = Sim()->getCfg()->getBool("network_trace/enabled", false);
+      trace_dependency_window = Sim()->getCfg()->getInt("network_trace/dependency_window", 1000);
+   }
+   catch(...)
+   {
+      LOG_PRINT_ERROR("Could not read [network_trace] parameters from the cfg file");
+   }
+   bool traced_networks[NUM_STATIC_NETWORKS];
+   parseNetworkList("network_trace/networks", traced_networks, "user_1, user_2, memory_1, memory_2");
+   for (SInt32 i = 0; i < NUM_STATIC_NETWORKS; i++)
+   {
+      _traceWriters[i] = NULL;
+      if (trace_enabled && traced_networks[i] && (i != STATIC_NETWORK_SYSTEM) &&
+          (_tid < (SInt32) Config::getSingleton()->getApplicationTiles()))
+      {
+         string filename = Config::getSingleton()->formatOutputFileName(NetworkTrace::getFileName(".", i, _tid));
+         _traceWriters[i] = new NetworkTraceWriter(filename, _tid, i, Config::getSingleton()->getApplicationTiles(),
+                                                   trace_dependency_window);
+      }
+   }
+
    LOG_PRINT("Initialized Network.");
 }
 
 Network::~Network()
 {
    for (SInt32 i = 0; i < NUM_STATIC_NETWORKS; i++)
-      delete _models[i];
+   {
+      if (_physicalNetworks[i] == i)
+         delete _models[i];
+      delete _traceWriters[i];
+   }
 
    delete [] _callbackObjs;
    delete [] _callbacks;
+   delete [] _numPacketsSentTo;
 
+   delete _deliveryWheel;
    delete _transport;
 
    LOG_PRINT("Destroyed Network.");
@@ -82,14 +177,69 @@ void Network::unregisterCallback(PacketType type)
    _callbacks[type] = NULL;
 }
 
-void Network::outputSummary(std::ostream &out) const
+NetworkModel* Network::createNetworkModel(SInt32 network_id)
+{
+   LOG_ASSERT_ERROR(_activeNetworks[network_id], "Network(%s) is used but not in network/active_networks",
+                    g_static_network_name_list[network_id].c_str());
+
+   ScopedLock sl(_modelsLock);
+   if (_models[network_id] == NULL)
+   {
+      SInt32 physical_network_id = _physicalNetworks[network_id];
+      UInt32 network_model = NetworkModel::parseNetworkType(Config::getSingleton()->getNetworkType(physical_network_id));
+      NetworkModel* model = NetworkModel::createModel(this, physical_network_id, network_model);
+      model->setCoreFrequency(_coreFrequency);
+      if (_modelsEnabled)
+         model->enable();
+
+      // Built before it can be seen without the lock
+      __sync_synchronize();
+      for (SInt32 i = 0; i < NUM_STATIC_NETWORKS; i++)
+      {
+         if (_physicalNetworks[i] == physical_network_id)
+            _models[i] = model;
+      }
+   }
+   return _models[network_id];
+}
+
+UInt32 Network::getNumModelsCreated() const
+{
+   UInt32 num_models_created = 0;
+   for (SInt32 i = 0; i < NUM_STATIC_NETWORKS; i++)
+   {
+      if (_models[i] && (_physicalNetworks[i] == i))
+         num_models_created ++;
+   }
+   return num_models_created;
+}
+
+void Network::outputSummary(std::ostream &out)
 {
    out << "Network summary:\n";
    for (UInt32 i = 0; i < NUM_STATIC_NETWORKS; i++)
    {
+      if (!_activeNetworks[i])
+         continue;
       out << "  Network model " << i << ":\n";
-      _models[i]->outputSummary(out);
+      if (_physicalNetworks[i] != (SInt32) i)
+      {
+         out << "    Shared With Network Model: " << _physicalNetworks[i] << endl;
+         continue;
+      }
+      // The summary of a model that was never used, which is all zeros
+      NetworkModel* model = _models[i] ? _models[i] : createNetworkModel(i);
+      model->outputSummary(out);
    }
+   if (_deliveryWheel)
+   {
+      out << "  Delivery Wheel:\n";
+      out << "    Scheduled Packets: " << _numScheduledPackets << endl;
+      out << "    Delivery Batches: " << _numDeliveryBatches << endl;
+      out << "    Reordered Packets: " << _numReorderedPackets << endl;
+   }
+   if (_directDeliveryEnabled)
+      out << "  Directly Delivered Packets: " << _numDirectlyDeliveredPackets << endl;
 }
 
 // Polling function that performs background activities, such as
@@ -102,7 +252,10 @@ void Network::netPullFromTransport()
    {
       LOG_PRINT("Entering netPullFromTransport");
 
-      NetPacket packet(_transport->recv());
+      // The packet payload points into the received buffer, which is
+      // released once the packet has been handled
+      Byte *buffer = _transport->recv();
+      NetPacket packet(buffer);
 
       LOG_PRINT("Pull packet : type %i, from (%i, %i), time %llu",
                 (SInt32)packet.type, packet.sender.tile_id, packet.sender.core_type, packet.time);
@@ -112,48 +265,45 @@ void Network::netPullFromTransport()
                        "Packet type: %d not between 0 and %d", packet.type, NUM_PACKET_TYPES);
 
       NetworkModel* model = getNetworkModelFromPacketType(packet.type);
+      bool ready_to_be_received = model->isPacketReadyToBeReceived(packet);
    
-      if (model->isPacketReadyToBeReceived(packet))   // Receive Packet
+      if (ready_to_be_received && packet.isMulticast() && !packet.isMulticastReceiver(_tile->getId()))
+      {
+         // Models that broadcast a multicast also deliver it to the tiles
+         // that are not receivers, drop it there
+         LOG_PRINT("Dropping multicast packet : type %i, from (%i, %i), tile_id %i, time %llu",
+                   (SInt32) packet.type, packet.sender.tile_id, packet.sender.core_type,
+                   _tile->getId(), packet.time);
+      }
+
+      else if (ready_to_be_received)   // Receive Packet
       {
-         // I have accepted the packet - process the received packet
-         model->__processReceivedPacket(packet);
-         
-         // Convert from network cycle count to core cycle count
-         packet.time = convertCycleCount(packet.time, model->getFrequency(),
-                                         _tile->getCore()->getPerformanceModel()->getFrequency());
-         
-         // asynchronous I/O support
-         NetworkCallback callback = _callbacks[packet.type];
-
-         if (callback != NULL)
+         // The senders process the packets they deliver directly too
+         if (_directDeliveryEnabled)
          {
-            LOG_PRINT("Executing callback on packet : type %i, from (%i, %i), to (%i, %i), tile_id %i, time %llu", 
-                      (SInt32) packet.type, packet.sender.tile_id, packet.sender.core_type,
-                      packet.receiver.tile_id, packet.receiver.core_type,
-                      _tile->getId(), packet.time);
-            assert(0 <= packet.sender.tile_id && packet.sender.tile_id < _numMod);
-            assert(0 <= packet.type && packet.type < NUM_PACKET_TYPES);
-
-            callback(_callbackObjs[packet.type], packet);
-
-            // De-allocate packet payload
-            if (packet.length > 0)
-               delete [] (Byte*) packet.data;
+            ScopedLock sl(_receiveLock);
+            processReceivedPacket(packet, model);
          }
-
-         // synchronous I/O support
          else
          {
-            LOG_PRINT("Enqueuing packet : type %i, from (%i, %i), to (%i, %i), tile_id %i, time %llu",
-                      (SInt32)packet.type, packet.sender.tile_id, packet.sender.core_type,
-                      packet.receiver.tile_id, packet.receiver.core_type,
-                      _tile->getId(), packet.time);
-
-            _netQueueLock.acquire();
-            _netQueue.push_back(packet);
-            _netQueueLock.release();
+            processReceivedPacket(packet, model);
+         }
+         // The receivers are not needed past the network
+         packet.clearMulticastReceivers();
 
-            _netQueueCond.broadcast();
+         if (_deliveryWheel)
+         {
+            // Delivered once the transport is drained, the buffer is kept until then
+            ScheduledPacket scheduled_packet;
+            scheduled_packet.packet = packet;
+            scheduled_packet.buffer = buffer;
+            scheduled_packet.sequence_num = _numScheduledPackets ++;
+            _deliveryWheel->schedule(packet.time, scheduled_packet);
+            buffer = NULL;
+         }
+         else
+         {
+            deliverPacket(packet);
          }
       }
 
@@ -163,20 +313,143 @@ void Network::netPullFromTransport()
                    (SInt32) packet.type, packet.sender.tile_id, packet.sender.core_type,
                    packet.receiver.tile_id, packet.receiver.core_type,
                    _tile->getId(), packet.time);
-         forwardPacket(packet);
-         
-         // De-allocate packet payload
-         if (packet.length > 0)
-            delete [] (Byte*) packet.data;
+         forwardPacket(packet, buffer);
       }
+
+      if (buffer)
+         MessageBuffer::release(buffer);
    }
    while (_transport->query());
+
+   if (_deliveryWheel)
+      deliverScheduledPackets();
+}
+
+void Network::processReceivedPacket(NetPacket& packet, NetworkModel* model)
+{
+   // I have accepted the packet - process the received packet
+   model->__processReceivedPacket(packet);
+
+   EventTracer* event_tracer = Sim()->getEventTracer();
+   if (event_tracer && event_tracer->isEnabled(EventTracer::NETWORK) &&
+       (packet.sender.tile_id != _tile->getId()))
+      tracePacket(event_tracer, model, packet);
+
+   // Convert from network cycle count to core cycle count
+   packet.time = model->convertToCoreCycles(packet.time);
+
+   // The packets sent after it may depend on it
+   NetworkTraceWriter* trace_writer = _traceWriters[g_type_to_static_network_map[packet.type]];
+   if (trace_writer && (packet.sender.tile_id != _tile->getId()) &&
+       (packet.sender.tile_id < (tile_id_t) Config::getSingleton()->getApplicationTiles()))
+   {
+      trace_writer->recordReceive(packet.sender.tile_id, packet.time);
+   }
+
+   // The adaptive clock skew schemes follow the skew between the application tiles
+   ClockSkewMinimizationClient* clock_skew_client = _tile->getCore()->getClockSkewMinimizationClient();
+   if (clock_skew_client && (packet.sender.tile_id != _tile->getId()) &&
+       (packet.sender.tile_id < (tile_id_t) Config::getSingleton()->getApplicationTiles()))
+   {
+      clock_skew_client->netObservePacketTime(packet.time);
+   }
+}
+
+void Network::deliverScheduledPackets()
+{
+   // Bucket by bucket, in timestamp order
+   TimingWheel<ScheduledPacket>::Batch batch;
+   UInt64 max_sequence_num = 0;
+   bool delivered = false;
+   while (!_deliveryWheel->empty())
+   {
+      _deliveryWheel->popBatch(batch);
+      _numDeliveryBatches ++;
+      if (Config::getSingleton()->isDeterministic() && (batch.size() > 1))
+         std::stable_sort(batch.begin(), batch.end(), SenderLess());
+
+      for (TimingWheel<ScheduledPacket>::Batch::iterator it = batch.begin(); it != batch.end(); it++)
+      {
+         ScheduledPacket& scheduled_packet = it->second;
+         if (delivered && (scheduled_packet.sequence_num < max_sequence_num))
+            _numReorderedPackets ++;
+         max_sequence_num = getMax<UInt64>(max_sequence_num, scheduled_packet.sequence_num);
+         delivered = true;
+
+         deliverPacket(scheduled_packet.packet);
+         MessageBuffer::release(scheduled_packet.buffer);
+      }
+   }
+}
+
+void Network::tracePacket(EventTracer* event_tracer, NetworkModel* model, const NetPacket& packet)
+{
+   UInt64 latency = packet.zero_load_delay + packet.contention_delay;
+   UInt64 send_time = (packet.time > latency) ? (packet.time - latency) : 0;
+   float frequency = model->getFrequency();
+   event_tracer->record(EventTracer::NETWORK, g_packet_type_name_list[packet.type].c_str(), _tile->getId(),
+                        convertCycleCount(send_time, frequency, 1.0),
+                        convertCycleCount(packet.time, frequency, 1.0),
+                        convertCycleCount(packet.contention_delay, frequency, 1.0));
 }
 
-SInt32 Network::forwardPacket(const NetPacket& packet)
+void Network::deliverPacket(NetPacket& packet)
 {
-   // Create a buffer suitable for forwarding
-   Byte* buffer = packet.makeBuffer();
+   // asynchronous I/O support
+   NetworkCallback callback = _callbacks[packet.type];
+
+   if (callback != NULL)
+   {
+      LOG_PRINT("Executing callback on packet : type %i, from (%i, %i), to (%i, %i), tile_id %i, time %llu", 
+                (SInt32) packet.type, packet.sender.tile_id, packet.sender.core_type,
+                packet.receiver.tile_id, packet.receiver.core_type,
+                _tile->getId(), packet.time);
+      assert(0 <= packet.sender.tile_id && packet.sender.tile_id < _numMod);
+      assert(0 <= packet.type && packet.type < NUM_PACKET_TYPES);
+
+      HostProfiler::Scope profile(Sim()->getHostProfiler(),
+            ((packet.type == SHARED_MEM_1) || (packet.type == SHARED_MEM_2)) ?
+            HostProfiler::COHERENCE : HostProfiler::NETWORK_CALLBACK);
+      callback(_callbackObjs[packet.type], packet);
+   }
+
+   // synchronous I/O support
+   else
+   {
+      LOG_PRINT("Enqueuing packet : type %i, from (%i, %i), to (%i, %i), tile_id %i, time %llu",
+                (SInt32)packet.type, packet.sender.tile_id, packet.sender.core_type,
+                packet.receiver.tile_id, packet.receiver.core_type,
+                _tile->getId(), packet.time);
+
+      // The receiver of a queued packet frees its payload
+      if (packet.length > 0)
+      {
+         Byte *data = new Byte[packet.length];
+         memcpy(data, packet.data, packet.length);
+         packet.data = data;
+      }
+
+      _netQueueLock.acquire();
+      _netQueue.push(packet);
+      _netQueueLock.release();
+
+      _netQueueCond.broadcast();
+   }
+}
+
+SInt32 Network::forwardPacket(const NetPacket& packet, Byte *buffer)
+{
+   // Create a buffer suitable for forwarding, or re-use the buffer
+   // the packet was received in
+   if (buffer == NULL)
+   {
+      buffer = packet.makeMessageBuffer();
+   }
+   else
+   {
+      MessageBuffer::addReference(buffer);
+      memcpy(buffer, &packet, sizeof(packet));
+   }
    NetPacket* buf_pkt = (NetPacket*) buffer;
 
    LOG_ASSERT_ERROR((buf_pkt->type >= 0) && (buf_pkt->type < NUM_PACKET_TYPES),
@@ -212,18 +485,138 @@ SInt32 Network::forwardPacket(const NetPacket& packet)
                    buf_pkt->receiver.tile_id, buf_pkt->receiver.core_type,
                    hop._next_tile_id,
                    _tile->getId(), hop._time);
-         _transport->send(hop._next_tile_id, buffer, packet.bufferSize());
+
+         if (hop_queue.empty())
+         {
+            // Last hop, hand the buffer itself to the transport
+            _transport->sendBuffer(hop._next_tile_id, buffer, packet.bufferSize());
+            buffer = NULL;
+         }
+         else
+         {
+            // Every hop needs its own copy of the header
+            Byte *hop_buffer = MessageBuffer::allocate(packet.bufferSize());
+            memcpy(hop_buffer, buffer, packet.bufferSize());
+            _transport->sendBuffer(hop._next_tile_id, hop_buffer, packet.bufferSize());
+         }
       }
    }
 
-   delete [] buffer;
+   if (buffer)
+      MessageBuffer::release(buffer);
 
    return packet.length;
 }
 
+bool Network::deliverDirectly(NetPacket& packet, NetworkModel* model)
+{
+   tile_id_t receiver = TILE_ID(packet.receiver);
+   if ( (!_directDeliveryEnabled) || (_deliveryWheel) || (receiver == NetPacket::BROADCAST) )
+      return false;
+
+   bool magic = _magicNetworks[g_type_to_static_network_map[packet.type]];
+   if ( (!magic) && ((!_directDeliveryOnDisabledModels) || model->isModelEnabled(packet)) )
+      return false;
+
+   // NULL if the tile is in another process
+   Tile* receiver_tile = Sim()->getTileManager()->getTileFromID(receiver);
+   if ( (receiver_tile == NULL) || (receiver_tile->getNetwork()->_callbacks[packet.type] != NULL) )
+      return false;
+   Network* receiver_network = receiver_tile->getNetwork();
+
+   NetPacket received_packet = packet;
+   if (magic)
+   {
+      // A single hop, to the receiver
+      queue<NetworkModel::Hop> hop_queue;
+      model->__routePacket(received_packet, hop_queue);
+      LOG_ASSERT_ERROR((hop_queue.size() == 1) && (hop_queue.front()._next_node_type == NetworkModel::RECEIVE_TILE),
+                       "Magic network route has %u hops", (UInt32) hop_queue.size());
+      const NetworkModel::Hop& hop = hop_queue.front();
+      received_packet.time = hop._time;
+      received_packet.zero_load_delay = hop._zero_load_delay;
+      received_packet.contention_delay = hop._contention_delay;
+   }
+   received_packet.node_type = NetworkModel::RECEIVE_TILE;
+
+   LOG_PRINT("Deliver packet directly : type %i, from (%i,%i), to (%i, %i), tile_id %i, time %llu",
+             (SInt32) packet.type, packet.sender.tile_id, packet.sender.core_type,
+             packet.receiver.tile_id, packet.receiver.core_type, _tile->getId(), received_packet.time);
+
+   // Queued with a copy of the payload
+   NetworkModel* receiver_model = receiver_network->getNetworkModelFromPacketType(packet.type);
+   ScopedLock sl(receiver_network->_receiveLock);
+   receiver_network->processReceivedPacket(received_packet, receiver_model);
+   receiver_network->deliverPacket(received_packet);
+   return true;
+}
+
+SInt32 Network::forwardPacketToReceivers(const NetPacket& packet, const vector<tile_id_t>& receivers)
+{
+   NetworkModel *model = getNetworkModelFromPacketType(packet.type);
+
+   vector<NetworkModel::Hop> hops;
+   model->__routePacketToReceivers(packet, receivers, hops);
+
+   // The copies are unicasts
+   NetPacket hop_pkt = packet;
+   hop_pkt.clearMulticastReceivers();
+   for (UInt32 i = 0; i < receivers.size(); i++)
+   {
+      const NetworkModel::Hop &hop = hops[i];
+      assert(hop._next_node_type == NetworkModel::RECEIVE_TILE);
+
+      hop_pkt.receiver = CORE_ID(receivers[i]);
+      hop_pkt.node_type = hop._next_node_type;
+      hop_pkt.time = hop._time;
+      hop_pkt.zero_load_delay = hop._zero_load_delay;
+      hop_pkt.contention_delay = hop._contention_delay;
+
+      LOG_PRINT("Send packet : type %i, from (%i,%i), to (%i, %i), next_hop %i, tile_id %i, time %llu",
+                (SInt32) hop_pkt.type,
+                hop_pkt.sender.tile_id, hop_pkt.sender.core_type,
+                hop_pkt.receiver.tile_id, hop_pkt.receiver.core_type,
+                hop._next_tile_id,
+                _tile->getId(), hop._time);
+
+      _transport->sendBuffer(hop._next_tile_id, hop_pkt.makeMessageBuffer(), hop_pkt.bufferSize());
+   }
+
+   return packet.length;
+}
+
+void Network::writePacketTrace(NetworkTraceWriter* trace_writer, const NetPacket& packet)
+{
+   tile_id_t num_application_tiles = (tile_id_t) Config::getSingleton()->getApplicationTiles();
+
+   vector<tile_id_t> receivers;
+   if (TILE_ID(packet.receiver) != NetPacket::BROADCAST)
+   {
+      receivers.push_back(TILE_ID(packet.receiver));
+   }
+   else if (packet.isMulticast())
+   {
+      packet.getMulticastReceivers(receivers);
+   }
+   else
+   {
+      receivers.resize(num_application_tiles);
+      for (tile_id_t i = 0; i < num_application_tiles; i++)
+         receivers[i] = i;
+   }
+
+   for (vector<tile_id_t>::iterator it = receivers.begin(); it != receivers.end(); it++)
+   {
+      if ((*it != _tile->getId()) && (*it < num_application_tiles))
+         trace_writer->writePacket(packet.time, packet.type, *it, packet.length);
+   }
+}
+
 NetworkModel* Network::getNetworkModelFromPacketType(PacketType packet_type)
 {
-   return _models[g_type_to_static_network_map[packet_type]];
+   SInt32 network_id = g_type_to_static_network_map[packet_type];
+   NetworkModel* model = _models[network_id];
+   return model ? model : createNetworkModel(network_id);
 }
 
 SInt32 Network::netSend(NetPacket& packet)
@@ -242,20 +635,58 @@ SInt32 Network::netSend(NetPacket& packet)
              packet.receiver.tile_id, packet.receiver.core_type,
              _tile->getId(), packet.time);
 
+   // The communication between the tiles (for lax_p2p peer selection)
+   if ( (TILE_ID(packet.receiver) != NetPacket::BROADCAST) && (TILE_ID(packet.receiver) != _tile->getId()) &&
+        (g_type_to_static_network_map[packet.type] != STATIC_NETWORK_SYSTEM) )
+   {
+      // Sent from both the app and the sim threads
+      __sync_fetch_and_add(&_numPacketsSentTo[TILE_ID(packet.receiver)], 1);
+   }
+
+   NetworkTraceWriter* trace_writer = _traceWriters[g_type_to_static_network_map[packet.type]];
+   if (trace_writer)
+      writePacketTrace(trace_writer, packet);
+
    // Convert from core cycle count to network cycle count
-   packet.time = convertCycleCount(packet.time,
-                                   _tile->getCore()->getPerformanceModel()->getFrequency(),
-                                   model->getFrequency());
+   packet.time = model->convertFromCoreCycles(packet.time);
 
    // Send packet as multiple packets if model has not broadcast capability and receiver is ALL
+   // (or the receivers of a multicast)
    if ( (TILE_ID(packet.receiver) == NetPacket::BROADCAST) && (!model->hasBroadcastCapability()) )
    {
-      for (tile_id_t i = 0; i < (tile_id_t) Config::getSingleton()->getTotalTiles(); i++)
+      vector<tile_id_t> receivers;
+      if (packet.isMulticast())
       {
-         packet.receiver = CORE_ID(i);
-         __attribute(__unused__) SInt32 ret = forwardPacket(packet);
-         LOG_ASSERT_ERROR(ret == (SInt32) packet.length, "forwardPacket-ret(%i) != packet.length(%u)", ret, packet.length);
+         packet.getMulticastReceivers(receivers);
       }
+      else
+      {
+         receivers.resize(Config::getSingleton()->getTotalTiles());
+         for (tile_id_t i = 0; i < (tile_id_t) receivers.size(); i++)
+            receivers[i] = i;
+      }
+
+      if (model->hasSingleHopRoutes())
+      {
+         // Route all the copies in one pass
+         __attribute(__unused__) SInt32 ret = forwardPacketToReceivers(packet, receivers);
+         LOG_ASSERT_ERROR(ret == (SInt32) packet.length, "forwardPacketToReceivers-ret(%i) != packet.length(%u)", ret, packet.length);
+      }
+      else
+      {
+         packet.clearMulticastReceivers();
+         for (vector<tile_id_t>::iterator it = receivers.begin(); it != receivers.end(); it++)
+         {
+            packet.receiver = CORE_ID(*it);
+            __attribute(__unused__) SInt32 ret = forwardPacket(packet);
+            LOG_ASSERT_ERROR(ret == (SInt32) packet.length, "forwardPacket-ret(%i) != packet.length(%u)", ret, packet.length);
+         }
+      }
+   }
+
+   else if (deliverDirectly(packet, model))
+   {
+      __sync_fetch_and_add(&_numDirectlyDeliveredPackets, 1);
    }
 
    else // (packet.receiver != NetPacket::BROADCAST) || (model->hasBroadcastCapability())
@@ -267,117 +698,57 @@ SInt32 Network::netSend(NetPacket& packet)
    return packet.length;
 }
 
-// Stupid helper class to eliminate special cases for empty
-// sender/type vectors in a NetMatch
-class NetRecvIterator
+UInt64 Network::netModelSend(NetPacket& packet)
 {
-   public:
-      NetRecvIterator(UInt32 i)
-            : _mode(INT)
-            , _max(i)
-            , _i(0)
-      {
-      }
-      NetRecvIterator(const std::vector<core_id_t> &v)
-            : _mode(SENDER_VECTOR)
-            , _senders(&v)
-            , _i(0)
-      {
-      }
-      NetRecvIterator(const std::vector<PacketType> &v)
-            : _mode(TYPE_VECTOR)
-            , _types(&v)
-            , _i(0)
-      {
-      }
+   // Floating Point Save/Restore
+   FloatingPointHandler floating_point_handler;
 
-      inline UInt32 get()
-      {
-         switch (_mode)
-         {
-         case INT:
-            return _i;
-         case TYPE_VECTOR:
-            return (UInt32)_types->at(_i);
-         default:
-            assert(false);
-            return (UInt32)-1;
-         };
-      }
+   tile_id_t receiver = TILE_ID(packet.receiver);
+   LOG_ASSERT_ERROR(receiver != NetPacket::BROADCAST, "netModelSend() is for unicasts");
+   Tile* receiver_tile = Sim()->getTileManager()->getTileFromID(receiver);
+   LOG_ASSERT_ERROR(receiver_tile, "Receiver tile(%i) is not in this process", receiver);
 
-      inline core_id_t getId()
-      {
-         switch (_mode)
-         {
-         case INT:
-            return Tile::getMainCoreId(_i);
-         case SENDER_VECTOR:
-            return (core_id_t)_senders->at(_i);
-         default:
-            assert(false);
-            return INVALID_CORE_ID;
-         };
-      }
-
-      inline Boolean done()
-      {
-         switch (_mode)
-         {
-         case INT:
-            return _i >= _max;
-         case SENDER_VECTOR:
-            return _i >= _senders->size();
-         case TYPE_VECTOR:
-            return _i >= _types->size();
-         default:
-            assert(false);
-            return true;
-         };
-      }
+   // The communication between the tiles (for lax_p2p peer selection)
+   if ( (receiver != _tile->getId()) && (g_type_to_static_network_map[packet.type] != STATIC_NETWORK_SYSTEM) )
+      __sync_fetch_and_add(&_numPacketsSentTo[receiver], 1);
 
-      inline void next()
-      {
-         ++_i;
-      }
+   NetworkModel* model = getNetworkModelFromPacketType(packet.type);
+   packet.time = model->convertFromCoreCycles(packet.time);
+   packet.node_type = NetworkModel::SEND_TILE;
 
-      inline void reset()
-      {
-         _i = 0;
-      }
+   // As with the shared memory shortcut, each hop is routed at once by the
+   // model of its tile, up to the receiver
+   queue<NetworkModel::Hop> hop_queue;
+   model->__routePacket(packet, hop_queue);
+   while (!hop_queue.empty())
+   {
+      NetworkModel::Hop hop = hop_queue.front();
+      hop_queue.pop();
 
-   private:
-      enum
-      {
-         INT, SENDER_VECTOR, TYPE_VECTOR
-      } _mode;
+      packet.node_type = hop._next_node_type;
+      packet.time = hop._time;
+      packet.zero_load_delay = hop._zero_load_delay;
+      packet.contention_delay = hop._contention_delay;
 
-      union
+      if (hop._next_node_type != NetworkModel::RECEIVE_TILE)
       {
-         UInt32 _max;
-         const std::vector<core_id_t> *_senders;
-         const std::vector<PacketType> *_types;
-      };
+         Tile* next_tile = Sim()->getTileManager()->getTileFromID(hop._next_tile_id);
+         assert(next_tile);
+         next_tile->getNetwork()->getNetworkModelFromPacketType(packet.type)->__routePacket(packet, hop_queue);
+      }
+   }
+   LOG_ASSERT_ERROR(packet.node_type == NetworkModel::RECEIVE_TILE, "Packet to tile(%i) was dropped", receiver);
 
-      UInt32 _i;
-};
+   Network* receiver_network = receiver_tile->getNetwork();
+   receiver_network->processReceivedPacket(packet, receiver_network->getNetworkModelFromPacketType(packet.type));
+   return packet.time;
+}
 
 NetPacket Network::netRecv(const NetMatch &match)
 {
    LOG_PRINT("netRecv: Entering.");
 
-   // Track via iterator to minimize copying
-   NetQueue::iterator itr;
-   Boolean found;
-
-   found = false;
-
-   NetRecvIterator sender = match.senders.empty()
-                            ? NetRecvIterator(_numMod)
-                            : NetRecvIterator(match.senders);
-
-   NetRecvIterator type = match.types.empty()
-                          ? NetRecvIterator((UInt32)NUM_PACKET_TYPES)
-                          : NetRecvIterator(match.types);
+   NetPacket packet;
 
    core_id_t receiver = match.receiver.tile_id == INVALID_TILE_ID 
                         ? _tile->getCore()->getId() 
@@ -390,59 +761,20 @@ NetPacket Network::netRecv(const NetMatch &match)
 
    _netQueueLock.acquire();
 
-   while (!found)
+   // go to sleep until a matching packet arrives
+   while (!_netQueue.pop(match, receiver, packet))
    {
-      itr = _netQueue.end();
-
-      // check every entry in the queue
-      for (NetQueue::iterator i = _netQueue.begin();
-            (i != _netQueue.end()) && !found;
-            i++)
-      {
-         // make sure that this core is the proper destination core for this tile
-         if (i->receiver.tile_id != receiver.tile_id || i->receiver.core_type != receiver.core_type)
-         {
-            if (i->receiver.tile_id != NetPacket::BROADCAST)
-               continue;
-         }
-
-         // only find packets that match
-         for (sender.reset(); !sender.done() && !found; sender.next())
-         {
-            if (i->sender.tile_id != sender.getId().tile_id || i->sender.core_type != sender.getId().core_type)
-               continue;
-
-            for (type.reset(); !type.done() && !found; type.next())
-            {
-               if (i->type != (PacketType)type.get())
-                  continue;
-
-               found = true;
-               itr = i;
-            }
-         }
-      }
-
-      // go to sleep until a packet arrives if none have been found
-      if (!found)
-      {
-         LOG_PRINT("netRecv: Waiting on condition variable");
-         _netQueueCond.wait(_netQueueLock);
-         LOG_PRINT("netRecv: Exit waiting");
-      }
+      LOG_PRINT("netRecv: Waiting on condition variable");
+      _netQueueCond.wait(_netQueueLock);
+      LOG_PRINT("netRecv: Exit waiting");
    }
 
-   assert(found == true && itr != _netQueue.end());
-   assert(0 <= itr->sender.tile_id && itr->sender.tile_id < _numMod);
-   assert(0 <= itr->type && itr->type < NUM_PACKET_TYPES);
-   assert((itr->receiver.tile_id == _tile->getId()) || (itr->receiver.tile_id == NetPacket::BROADCAST));
-
-   // Copy result
-   NetPacket packet = *itr;
-   _netQueue.erase(itr);
-
    _netQueueLock.release();
 
+   assert(0 <= packet.sender.tile_id && packet.sender.tile_id < _numMod);
+   assert(0 <= packet.type && packet.type < NUM_PACKET_TYPES);
+   assert((packet.receiver.tile_id == _tile->getId()) || (packet.receiver.tile_id == NetPacket::BROADCAST));
+
    LOG_PRINT("netRecv: Started waiting at %llu, Got packet at %llu", start_time, packet.time);
 
    if (packet.time > start_time)
@@ -458,6 +790,24 @@ NetPacket Network::netRecv(const NetMatch &match)
    return packet;
 }
 
+bool Network::netTryRecv(const NetMatch &match, NetPacket &packet)
+{
+   core_id_t receiver = match.receiver.tile_id == INVALID_TILE_ID 
+                        ? _tile->getCore()->getId() 
+                        : match.receiver;
+
+   LOG_ASSERT_ERROR(_tile && _tile->getCore()->getPerformanceModel(),
+                    "Tile and/or performance model not initialized.");
+   UInt64 curr_time = _tile->getCore()->getPerformanceModel()->getCycleCount();
+
+   _netQueueLock.acquire();
+   bool received = _netQueue.pop(match, receiver, packet, curr_time);
+   _netQueueLock.release();
+
+   LOG_PRINT("netTryRecv: At %llu, %s", curr_time, received ? "got packet" : "no packet");
+   return received;
+}
+
 // -- Wrappers
 
 SInt32 Network::netSend(core_id_t dest, PacketType type, const void *buf, UInt32 len)
@@ -512,19 +862,43 @@ NetPacket Network::netRecvType(PacketType type, core_id_t recv)
 void Network::enableModels()
 {
    LOG_PRINT("enableModels: (%i) start", _tile->getId());
+   ScopedLock sl(_modelsLock);
+   _modelsEnabled = true;
+   // The packets that are still in the transport when the models are
+   // disabled again must not be overtaken (see deliverDirectly())
+   _directDeliveryOnDisabledModels = false;
    for (int i = 0; i < NUM_STATIC_NETWORKS; i++)
-      _models[i]->enable();
+   {
+      if (_models[i])
+         _models[i]->enable();
+   }
    LOG_PRINT("enableModels: (%i) end", _tile->getId());
 }
 
 void Network::disableModels()
 {
    LOG_PRINT("disableModels: (%i) start", _tile->getId());
+   ScopedLock sl(_modelsLock);
+   _modelsEnabled = false;
    for (int i = 0; i < NUM_STATIC_NETWORKS; i++)
-      _models[i]->disable();
+   {
+      if (_models[i])
+         _models[i]->disable();
+   }
    LOG_PRINT("disableModels: (%i) end", _tile->getId());
 }
 
+void Network::updateInternalVariablesOnFrequencyChange(volatile float core_frequency)
+{
+   ScopedLock sl(_modelsLock);
+   _coreFrequency = core_frequency;
+   for (int i = 0; i < NUM_STATIC_NETWORKS; i++)
+   {
+      if (_models[i])
+         _models[i]->setCoreFrequency(core_frequency);
+   }
+}
+
 // Get a Trace of Network Traffic
 // Works only on a single process currently
 
@@ -532,10 +906,10 @@ void Network::openUtilizationTraceFiles()
 {
    // Create the TraceEnabled and TraceFiles array
    _utilizationTraceEnabled = new bool[NUM_STATIC_NETWORKS];
-   _utilizationTraceFiles = new ofstream[NUM_STATIC_NETWORKS];
+   _utilizationTraceFiles = new TraceFile[NUM_STATIC_NETWORKS];
 
    // Populate _network_traffic_trace_enabled with the networks for which tracing is enabled 
-   computeTraceEnabledNetworks();
+   parseNetworkList("statistics_trace/network_utilization/enabled_networks", _utilizationTraceEnabled);
 
    // Open the trace files 
    for (SInt32 network_id = 0; network_id < NUM_STATIC_NETWORKS; network_id ++)
@@ -558,20 +932,76 @@ void Network::openUtilizationTraceFiles()
    }
 }
 
-void Network::computeTraceEnabledNetworks()
+void Network::parseSharedNetworks()
 {
-   // Is tracing enabled for the individual networks
+   for (SInt32 i = 0; i < NUM_STATIC_NETWORKS; i++)
+      _physicalNetworks[i] = i;
+
+   string shared_networks_line;
+   try
+   {
+      shared_networks_line = Sim()->getCfg()->getString("network/shared_networks", "");
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read network/shared_networks from the cfg file");
+   }
+
+   // Groups of networks joined by '+', e.g. "user_1+user_2, memory_1+memory_2"
+   bool grouped[NUM_STATIC_NETWORKS];
+   for (SInt32 i = 0; i < NUM_STATIC_NETWORKS; i++)
+      grouped[i] = false;
+
+   vector<string> groups;
+   splitIntoTokens(shared_networks_line, groups, ", ");
+   for (vector<string>::iterator it = groups.begin(); it != groups.end(); it ++)
+   {
+      vector<string> network_names;
+      splitIntoTokens(*it, network_names, "+");
+      vector<SInt32> group;
+      for (vector<string>::iterator name_it = network_names.begin(); name_it != network_names.end(); name_it ++)
+      {
+         SInt32 network_id = 0;
+         while ((network_id < NUM_STATIC_NETWORKS) && (g_static_network_name_list[network_id] != *name_it))
+            network_id ++;
+         LOG_ASSERT_ERROR(network_id < NUM_STATIC_NETWORKS, "Unrecognized network(%s) in network/shared_networks",
+                          name_it->c_str());
+         // The packets of the system network are received at every hop
+         LOG_ASSERT_ERROR(network_id != STATIC_NETWORK_SYSTEM, "The system network can not be shared");
+         LOG_ASSERT_ERROR(_activeNetworks[network_id], "Shared network(%s) is not in network/active_networks",
+                          name_it->c_str());
+         LOG_ASSERT_ERROR(!grouped[network_id], "Network(%s) is in two groups of network/shared_networks",
+                          name_it->c_str());
+         LOG_ASSERT_ERROR(Config::getSingleton()->getNetworkType(network_id) == Config::getSingleton()->getNetworkType(group.empty() ? network_id : group[0]),
+                          "The shared networks of group(%s) must be of the same type", it->c_str());
+         grouped[network_id] = true;
+         group.push_back(network_id);
+      }
+
+      if (group.empty())
+         continue;
+      // The model of a group is the one of its first network
+      SInt32 physical_network_id = *min_element(group.begin(), group.end());
+      for (UInt32 i = 0; i < group.size(); i++)
+         _physicalNetworks[group[i]] = physical_network_id;
+   }
+}
+
+void Network::parseNetworkList(const string& key, bool* listed, const char* default_list)
+{
+   // Is each network in the list
    for (SInt32 network_id = 0; network_id < NUM_STATIC_NETWORKS; network_id ++)
-      _utilizationTraceEnabled[network_id] = false;
+      listed[network_id] = false;
 
    string enabled_networks_line;
    try
    {
-      enabled_networks_line = Sim()->getCfg()->getString("statistics_trace/network_utilization/enabled_networks");
+      enabled_networks_line = default_list ? Sim()->getCfg()->getString(key, default_list) :
+                                             Sim()->getCfg()->getString(key);
    }
    catch (...)
    {
-      LOG_PRINT_ERROR("Could not read statistics_trace/network/enabled_networks from the cfg file");
+      LOG_PRINT_ERROR("Could not read %s from the cfg file", key.c_str());
    }
  
    vector<string> enabled_networks; 
@@ -582,7 +1012,7 @@ void Network::computeTraceEnabledNetworks()
       for (SInt32 network_id = 0; network_id < NUM_STATIC_NETWORKS; network_id ++)
       {
          if (g_static_network_name_list[network_id] == network_name)
-            _utilizationTraceEnabled[network_id] = true;
+            listed[network_id] = true;
       }
    }
 }
@@ -613,20 +1043,21 @@ void Network::outputUtilizationSummary()
          UInt64 total_flits_received = 0;
 
          SInt32 total_tiles = (SInt32) Config::getSingleton()->getTotalTiles();
-         SInt32 sampling_interval = Sim()->getStatisticsManager()->getSamplingInterval();
+         StatisticsManager* statistics_manager = Sim()->getStatisticsManager();
+         SInt32 sampling_interval = statistics_manager->getSamplingInterval();
 
-         for (SInt32 tile_id = 0; tile_id < total_tiles; tile_id ++)
+         // From the counters sampled by the statistics manager, the models
+         // are not touched
+         const Config::TileList& tile_list = Config::getSingleton()->getTileListForCurrentProcess();
+         for (UInt32 i = 0; i < tile_list.size(); i++)
          {
-            Tile* tile = Sim()->getTileManager()->getTileFromID(tile_id);
-            assert(tile);
-            NetworkModel* network_model = tile->getNetwork()->getNetworkModel(network_id);
-           
-            UInt64 flits_sent, flits_broadcasted, flits_received;
-            network_model->popCurrentUtilizationStatistics(flits_sent, flits_broadcasted, flits_received);
-            
-            total_flits_sent += flits_sent;
-            total_flits_broadcasted += flits_broadcasted;
-            total_flits_received += flits_received;
+            tile_id_t tile_id = tile_list[i];
+            total_flits_sent += statistics_manager->getCounterDelta(tile_id,
+                  (StatisticsManager::Counter) (StatisticsManager::NETWORK_FLITS_SENT + network_id));
+            total_flits_broadcasted += statistics_manager->getCounterDelta(tile_id,
+                  (StatisticsManager::Counter) (StatisticsManager::NETWORK_FLITS_BROADCASTED + network_id));
+            total_flits_received += statistics_manager->getCounterDelta(tile_id,
+                  (StatisticsManager::Counter) (StatisticsManager::NETWORK_FLITS_RECEIVED + network_id));
          }
            
          double flits_send_rate = ((double) total_flits_sent) / (total_tiles * sampling_interval);
@@ -637,6 +1068,105 @@ void Network::outputUtilizationSummary()
    }
 }
 
+void Network::openLatencyTraceFiles()
+{
+   LOG_ASSERT_ERROR(NetworkModel::areLatencyHistogramsEnabled(),
+                    "Tracing network_latency needs [network/latency_histograms] enabled = true");
+
+   _latencyTraceEnabled = new bool[NUM_STATIC_NETWORKS];
+   _latencyTraceFiles = new TraceFile[NUM_STATIC_NETWORKS];
+   // Totals at the previous sample, to compute the percentiles of each interval
+   _latencyTraceHistograms = new LatencyHistogram[NUM_PACKET_TYPES * NetworkModel::NUM_LATENCY_HISTOGRAM_TYPES];
+   _latencyTraceNumSamples = 0;
+
+   parseNetworkList("statistics_trace/network_latency/enabled_networks", _latencyTraceEnabled);
+
+   for (SInt32 network_id = 0; network_id < NUM_STATIC_NETWORKS; network_id ++)
+   {
+      if (_latencyTraceEnabled[network_id])
+      {
+         string output_dir;
+         try
+         {
+            output_dir = Sim()->getCfg()->getString("general/output_dir");
+         }
+         catch (...)
+         {
+            LOG_PRINT_ERROR("Could not read general/output_dir from the cfg file");
+         }
+
+         string filename = output_dir + "/network_latency_" + g_static_network_name_list[network_id] + ".dat";
+         _latencyTraceFiles[network_id].open(filename.c_str());
+      }
+   }
+}
+
+void Network::closeLatencyTraceFiles()
+{
+   for (SInt32 network_id = 0; network_id < NUM_STATIC_NETWORKS; network_id ++)
+   {
+      if (_latencyTraceEnabled[network_id])
+         _latencyTraceFiles[network_id].close();
+   }
+
+   delete [] _latencyTraceHistograms;
+   delete [] _latencyTraceFiles;
+   delete [] _latencyTraceEnabled;
+}
+
+void Network::outputLatencySummary()
+{
+   // One line per packet type with traffic in the interval:
+   // time (in ns), packet_type, num_packets, then [p50, p90, p99, p99.9] of the
+   // packet latency, zero load delay and contention delay (in clock cycles)
+   SInt32 total_tiles = (SInt32) Config::getSingleton()->getTotalTiles();
+   _latencyTraceNumSamples ++;
+   UInt64 sample_time = _latencyTraceNumSamples * Sim()->getStatisticsManager()->getSamplingInterval();
+   
+   for (SInt32 packet_type = 0; packet_type < NUM_PACKET_TYPES; packet_type ++)
+   {
+      SInt32 network_id = g_type_to_static_network_map[packet_type];
+      if (!_latencyTraceEnabled[network_id])
+         continue;
+
+      LatencyHistogram interval_histograms[NetworkModel::NUM_LATENCY_HISTOGRAM_TYPES];
+      for (SInt32 i = 0; i < NetworkModel::NUM_LATENCY_HISTOGRAM_TYPES; i++)
+      {
+         LatencyHistogram total_histogram;
+         for (SInt32 tile_id = 0; tile_id < total_tiles; tile_id ++)
+         {
+            Tile* tile = Sim()->getTileManager()->getTileFromID(tile_id);
+            assert(tile);
+            NetworkModel* network_model = tile->getNetwork()->getNetworkModel(network_id);
+            if (network_model == NULL)
+               continue;
+            const LatencyHistogram* histogram = network_model->getLatencyHistogram(
+                  (PacketType) packet_type, (NetworkModel::LatencyHistogramType) i);
+            if (histogram)
+               total_histogram.merge(*histogram);
+         }
+
+         LatencyHistogram& last_histogram = _latencyTraceHistograms[packet_type * NetworkModel::NUM_LATENCY_HISTOGRAM_TYPES + i];
+         interval_histograms[i] = total_histogram;
+         interval_histograms[i].subtract(last_histogram);
+         last_histogram = total_histogram;
+      }
+
+      if (interval_histograms[NetworkModel::PACKET_LATENCY].getCount() == 0)
+         continue;
+
+      TraceFile& out = _latencyTraceFiles[network_id];
+      out << sample_time << ", " << g_packet_type_name_list[packet_type] << ", "
+          << interval_histograms[NetworkModel::PACKET_LATENCY].getCount();
+      for (SInt32 i = 0; i < NetworkModel::NUM_LATENCY_HISTOGRAM_TYPES; i++)
+      {
+         out << ", ";
+         NetworkModel::outputLatencyPercentiles(out, interval_histograms[i]);
+      }
+      out << endl;
+   }
+}
+
 // -- NetPacket
 
 NetPacket::NetPacket()
@@ -649,6 +1179,8 @@ NetPacket::NetPacket()
    , data(0)
    , zero_load_delay(0)
    , contention_delay(0)
+   , multicast_length(0)
+   , multicast_receivers(NULL)
 {
 }
 
@@ -661,6 +1193,8 @@ NetPacket::NetPacket(UInt64 t, PacketType ty, SInt32 s,
    , data(d)
    , zero_load_delay(0)
    , contention_delay(0)
+   , multicast_length(0)
+   , multicast_receivers(NULL)
 {
    sender = Tile::getMainCoreId(s);
    receiver = Tile::getMainCoreId(r);
@@ -678,22 +1212,20 @@ NetPacket::NetPacket(UInt64 t, PacketType ty, core_id_t s,
    , data(d)
    , zero_load_delay(0)
    , contention_delay(0)
+   , multicast_length(0)
+   , multicast_receivers(NULL)
 {
 }
 
+// The payload is not copied, it points into the buffer, which is
+// still owned by the caller
 NetPacket::NetPacket(Byte *buffer)
 {
    memcpy(this, buffer, sizeof(*this));
 
    // LOG_ASSERT_ERROR(length > 0, "type(%u), sender(%i), receiver(%i), length(%u)", type, sender, receiver, length);
-   if (length > 0)
-   {
-      Byte* data_buffer = new Byte[length];
-      memcpy(data_buffer, buffer + sizeof(*this), length);
-      data = data_buffer;
-   }
-
-   delete [] buffer;
+   data = (length > 0) ? (buffer + sizeof(*this)) : NULL;
+   multicast_receivers = (multicast_length > 0) ? (buffer + sizeof(*this) + length) : NULL;
 }
 
 // This implementation is slightly wasteful because there is no need
@@ -701,7 +1233,7 @@ NetPacket::NetPacket(Byte *buffer)
 // but I don't see this as a major issue.
 UInt32 NetPacket::bufferSize() const
 {
-   return (sizeof(*this) + length);
+   return (sizeof(*this) + length + multicast_length);
 }
 
 Byte* NetPacket::makeBuffer() const
@@ -713,6 +1245,224 @@ Byte* NetPacket::makeBuffer() const
 
    memcpy(buffer, this, sizeof(*this));
    memcpy(buffer + sizeof(*this), data, length);
+   memcpy(buffer + sizeof(*this) + length, multicast_receivers, multicast_length);
 
    return buffer;
 }
+
+Byte* NetPacket::makeMessageBuffer() const
+{
+   UInt32 size = bufferSize();
+   Byte *buffer = MessageBuffer::allocate(size);
+
+   memcpy(buffer, this, sizeof(*this));
+   memcpy(buffer + sizeof(*this), data, length);
+   memcpy(buffer + sizeof(*this) + length, multicast_receivers, multicast_length);
+
+   return buffer;
+}
+
+void NetPacket::setMulticastReceivers(const vector<tile_id_t>& receivers, vector<Byte>& bitmap)
+{
+   assert(TILE_ID(receiver) == BROADCAST);
+   assert(!receivers.empty());
+
+   bitmap.assign((Config::getSingleton()->getTotalTiles() + 7) / 8, 0);
+   for (vector<tile_id_t>::const_iterator it = receivers.begin(); it != receivers.end(); it++)
+   {
+      assert((*it >= 0) && (*it < (tile_id_t) Config::getSingleton()->getTotalTiles()));
+      bitmap[*it >> 3] |= (1 << (*it & 7));
+   }
+
+   multicast_length = bitmap.size();
+   multicast_receivers = &bitmap[0];
+}
+
+void NetPacket::getMulticastReceivers(vector<tile_id_t>& receivers) const
+{
+   receivers.clear();
+   for (UInt32 i = 0; i < multicast_length; i++)
+   {
+      for (UInt32 bits = multicast_receivers[i]; bits != 0; bits &= (bits - 1))
+         receivers.push_back(8*i + __builtin_ctz(bits));
+   }
+}
+
+bool NetPacket::isMulticastReceiver(tile_id_t tile_id) const
+{
+   assert(isMulticast());
+   assert((tile_id >= 0) && ((UInt32) (tile_id >> 3) < multicast_length));
+   return (multicast_receivers[tile_id >> 3] >> (tile_id & 7)) & 1;
+}
+
+void NetPacket::clearMulticastReceivers()
+{
+   multicast_length = 0;
+   multicast_receivers = NULL;
+}
+
+// -- NetQueue
+
+NetQueue::NetQueue()
+   : _bucket_tables(NUM_PACKET_TYPES * NUM_RECEIVERS)
+   , _nextSequenceNum(0)
+   , _size(0)
+{
+   _numMod = Config::getSingleton()->getTotalTiles();
+   _deterministic = Config::getSingleton()->isDeterministic();
+}
+
+NetQueue::~NetQueue()
+{
+   for (vector<BucketTable>::iterator table_it = _bucket_tables.begin(); table_it != _bucket_tables.end(); table_it++)
+   {
+      for (vector<Bucket*>::iterator it = table_it->_buckets.begin(); it != table_it->_buckets.end(); it++)
+         delete *it;
+   }
+}
+
+NetQueue::BucketTable& NetQueue::getBucketTable(PacketType type, core_id_t receiver)
+{
+   // A broadcast matches any core on the tile, so ignore the core type
+   UInt32 receiver_index = (receiver.tile_id == NetPacket::BROADCAST) ? 0 : (1 + receiver.core_type);
+   assert(receiver_index < NUM_RECEIVERS);
+   return _bucket_tables[type * NUM_RECEIVERS + receiver_index];
+}
+
+SInt32 NetQueue::getSenderIndex(core_id_t sender) const
+{
+   if ((sender.tile_id < 0) || (sender.tile_id >= _numMod) || ((UInt32) sender.core_type >= NUM_CORE_TYPES))
+      return -1;
+   return sender.tile_id * NUM_CORE_TYPES + sender.core_type;
+}
+
+void NetQueue::push(const NetPacket& packet)
+{
+   assert(0 <= packet.type && packet.type < NUM_PACKET_TYPES);
+   SInt32 sender_index = getSenderIndex(packet.sender);
+   LOG_ASSERT_ERROR(sender_index >= 0, "Invalid sender(%i, %i)", packet.sender.tile_id, packet.sender.core_type);
+
+   BucketTable& table = getBucketTable(packet.type, packet.receiver);
+   if (table._buckets.empty())
+      table._buckets.resize(_numMod * NUM_CORE_TYPES, NULL);
+
+   Bucket* bucket = table._buckets[sender_index];
+   if (bucket == NULL)
+   {
+      bucket = new Bucket();
+      bucket->_active_index = -1;
+      table._buckets[sender_index] = bucket;
+   }
+   if (bucket->_active_index < 0)
+   {
+      bucket->_active_index = table._active_buckets.size();
+      table._active_buckets.push_back(bucket);
+   }
+
+   bucket->_packets.push_back(make_pair(_nextSequenceNum ++, packet));
+   _size ++;
+}
+
+bool NetQueue::isEarlier(const Bucket& a, const Bucket& b) const
+{
+   const pair<UInt64, NetPacket>& packet_a = a._packets.front();
+   const pair<UInt64, NetPacket>& packet_b = b._packets.front();
+   if (_deterministic)
+   {
+      if (packet_a.second.time != packet_b.second.time)
+         return (packet_a.second.time < packet_b.second.time);
+      if (packet_a.second.sender.tile_id != packet_b.second.sender.tile_id)
+         return (packet_a.second.sender.tile_id < packet_b.second.sender.tile_id);
+   }
+   return (packet_a.first < packet_b.first);
+}
+
+void NetQueue::findEarliest(BucketTable& table, const NetMatch& match,
+                            BucketTable*& earliest_table, Bucket*& earliest)
+{
+   if (table._active_buckets.empty())
+      return;
+
+   if (!match.senders.empty())
+   {
+      for (vector<core_id_t>::const_iterator it = match.senders.begin(); it != match.senders.end(); it++)
+      {
+         SInt32 sender_index = getSenderIndex(*it);
+         if (sender_index < 0)
+            continue;
+         Bucket* bucket = table._buckets[sender_index];
+         if ((bucket == NULL) || (bucket->_active_index < 0))
+            continue;
+         if ((earliest == NULL) || isEarlier(*bucket, *earliest))
+         {
+            earliest_table = &table;
+            earliest = bucket;
+         }
+      }
+   }
+   else
+   {
+      // Any sender: look at all the non-empty buckets of this receiver.
+      // Only the main cores of the tiles in the simulation are valid senders.
+      for (vector<Bucket*>::iterator it = table._active_buckets.begin(); it != table._active_buckets.end(); it++)
+      {
+         Bucket* bucket = *it;
+         if (bucket->_packets.front().second.sender.core_type != MAIN_CORE_TYPE)
+            continue;
+         if ((earliest == NULL) || isEarlier(*bucket, *earliest))
+         {
+            earliest_table = &table;
+            earliest = bucket;
+         }
+      }
+   }
+}
+
+bool NetQueue::pop(const NetMatch& match, core_id_t receiver, NetPacket& packet, UInt64 max_time)
+{
+   if (_size == 0)
+      return false;
+
+   BucketTable* earliest_table = NULL;
+   Bucket* earliest = NULL;
+
+   core_id_t broadcast_receiver = (core_id_t) {NetPacket::BROADCAST, 0};
+
+   if (!match.types.empty())
+   {
+      for (vector<PacketType>::const_iterator it = match.types.begin(); it != match.types.end(); it++)
+      {
+         findEarliest(getBucketTable(*it, receiver), match, earliest_table, earliest);
+         findEarliest(getBucketTable(*it, broadcast_receiver), match, earliest_table, earliest);
+      }
+   }
+   else
+   {
+      for (SInt32 type = 0; type < NUM_PACKET_TYPES; type++)
+      {
+         findEarliest(getBucketTable((PacketType) type, receiver), match, earliest_table, earliest);
+         findEarliest(getBucketTable((PacketType) type, broadcast_receiver), match, earliest_table, earliest);
+      }
+   }
+
+   if (earliest == NULL)
+      return false;
+
+   if (earliest->_packets.front().second.time > max_time)
+      return false;
+   packet = earliest->_packets.front().second;
+   earliest->_packets.pop_front();
+   if (earliest->_packets.empty())
+   {
+      // Swap it out of the non-empty buckets
+      vector<Bucket*>& active_buckets = earliest_table->_active_buckets;
+      Bucket* last = active_buckets.back();
+      active_buckets[earliest->_active_index] = last;
+      last->_active_index = earliest->_active_index;
+      active_buckets.pop_back();
+      earliest->_active_index = -1;
+   }
+   _size --;
+
+   return true;
+}
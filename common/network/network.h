@@ -5,20 +5,30 @@
 #include <fstream>
 #include <vector>
 #include <list>
+#include <deque>
+#include <map>
 using std::ostream;
 using std::ofstream;
 using std::vector;
 using std::list;
+using std::deque;
+using std::map;
+using std::pair;
 
 #include "packet_type.h"
 #include "fixed_types.h"
 #include "cond.h"
+#include "trace_file.h"
 #include "semaphore.h"
 #include "transport.h"
+#include "timing_wheel.h"
 
 class Tile;
 class Network;
 class NetworkModel;
+class LatencyHistogram;
+class EventTracer;
+class NetworkTraceWriter;
 
 // -- Network Packets -- //
 
@@ -39,6 +49,11 @@ public:
    UInt64 zero_load_delay;
    UInt64 contention_delay;
 
+   // A multicast is sent to BROADCAST, with a bitmap of its receiver
+   // tiles carried after the payload
+   UInt32 multicast_length;
+   const Byte *multicast_receivers;
+
    NetPacket();
    explicit NetPacket(Byte*);
    NetPacket(UInt64 time, PacketType type, core_id_t sender, 
@@ -48,12 +63,20 @@ public:
 
    UInt32 bufferSize() const;
    Byte *makeBuffer() const;
+   // Same as makeBuffer(), but allocates a (pooled) MessageBuffer
+   Byte *makeMessageBuffer() const;
+
+   // Makes the packet a multicast to the receivers. The bitmap holds the
+   // receivers and must live as long as the packet
+   void setMulticastReceivers(const vector<tile_id_t>& receivers, vector<Byte>& bitmap);
+   void getMulticastReceivers(vector<tile_id_t>& receivers) const;
+   bool isMulticast() const { return (multicast_length > 0); }
+   bool isMulticastReceiver(tile_id_t tile_id) const;
+   void clearMulticastReceivers();
 
    static const SInt32 BROADCAST = 0xDEADBABE;
 };
 
-typedef list<NetPacket> NetQueue;
-
 // -- Network Matches -- //
 
 class NetMatch
@@ -65,6 +88,74 @@ public:
    core_id_t receiver;
 };
 
+// -- Network Receive Queue -- //
+
+// Packets waiting to be picked up by netRecv(). The packets are
+// bucketed by (type, receiver, sender) and every packet is tagged
+// with its arrival order, so a receive for a given sender and type
+// only looks at the front of two buckets (the one for the receiver
+// and the one for broadcasts) instead of scanning the whole queue.
+// The queue of a tile only holds its packets and the broadcasts, so
+// the buckets of a type and receiver are a vector indexed by sender,
+// and the non-empty ones are also kept in a list for the receives from
+// any sender.
+// Among all the matching packets, the one that arrived first is
+// returned, or in a deterministic run (general/deterministic) the one
+// of the earliest time, then of the lowest sender tile id, whatever the
+// order in which the host delivered them.
+
+class NetQueue
+{
+public:
+   NetQueue();
+   ~NetQueue();
+
+   void push(const NetPacket& packet);
+   // Only a packet sent by 'max_time' is returned, the others stay queued
+   bool pop(const NetMatch& match, core_id_t receiver, NetPacket& packet,
+            UInt64 max_time = UINT64_MAX_);
+
+   bool empty() const { return (_size == 0); }
+   UInt32 size() const { return _size; }
+
+private:
+   // core_type_t only has MAIN_CORE_TYPE
+   static const UInt32 NUM_CORE_TYPES = MAIN_CORE_TYPE + 1;
+   // Broadcasts, then one receiver per core type of the tile
+   static const UInt32 NUM_RECEIVERS = NUM_CORE_TYPES + 1;
+
+   struct Bucket
+   {
+      deque<pair<UInt64, NetPacket> > _packets;
+      // Position in the non-empty buckets of its table, -1 if empty
+      SInt32 _active_index;
+   };
+
+   // The buckets of a (type, receiver)
+   struct BucketTable
+   {
+      // Indexed by sender, NULL until the sender's first packet. An
+      // emptied bucket is kept for the next packets of the sender
+      vector<Bucket*> _buckets;
+      vector<Bucket*> _active_buckets;
+   };
+
+   BucketTable& getBucketTable(PacketType type, core_id_t receiver);
+   // -1 if not a valid sender
+   SInt32 getSenderIndex(core_id_t sender) const;
+   // The front packet of bucket a is returned before that of bucket b
+   bool isEarlier(const Bucket& a, const Bucket& b) const;
+   void findEarliest(BucketTable& table, const NetMatch& match,
+                     BucketTable*& earliest_table, Bucket*& earliest);
+
+   // Indexed by type * NUM_RECEIVERS + receiver
+   vector<BucketTable> _bucket_tables;
+   UInt64 _nextSequenceNum;
+   volatile UInt32 _size;
+   SInt32 _numMod;
+   bool _deterministic;
+};
+
 // -- Network -- //
 
 // This is the managing class that interacts with the physical
@@ -88,7 +179,7 @@ public:
 
    void unregisterCallback(PacketType type);
 
-   void outputSummary(ostream &out) const;
+   void outputSummary(ostream &out);
 
    void netPullFromTransport();
 
@@ -96,6 +187,14 @@ public:
 
    SInt32 netSend(NetPacket& packet);
    NetPacket netRecv(const NetMatch &match);
+   // Does not wait: false if no matching packet has arrived by the current
+   // time of the core
+   bool netTryRecv(const NetMatch &match, NetPacket &packet);
+   // Models a unicast to a tile of this process along its route, through the
+   // models of the tiles on the way, as if it were sent, but does not deliver
+   // it. Returns the time it is received (in core cycles of the receiver).
+   // For the msgs that the sender hands to the receiver itself
+   UInt64 netModelSend(NetPacket& packet);
 
    // -- Wrappers -- //
 
@@ -107,22 +206,58 @@ public:
 
    void enableModels();
    void disableModels();
+   // The core of the tile changed its frequency
+   void updateInternalVariablesOnFrequencyChange(volatile float core_frequency);
    
    // -- Network Injection/Ejection Rate Trace -- //
    static void openUtilizationTraceFiles();
    static void closeUtilizationTraceFiles();
    static void outputUtilizationSummary();
 
+   // -- Network Latency Percentiles Trace -- //
+   static void openLatencyTraceFiles();
+   static void closeLatencyTraceFiles();
+   static void outputLatencySummary();
+
+   // -- Packets sent to each tile on the user and memory networks -- //
+   UInt64 getNumPacketsSentTo(tile_id_t tile_id) const { return _numPacketsSentTo[tile_id]; }
+
    // -- Network Models -- //
+   // NULL if the network is not active, or if the model is created on
+   // first use and no packet went through it
+   // -- Packets waiting to be received (in the transport and the network
+   // queue), read without the locks for monitoring -- //
+   UInt32 getNumPendingPackets() const { return _transport->getQueueDepth() + _netQueue.size(); }
+
    NetworkModel* getNetworkModel(SInt32 network_id) { return _models[network_id]; }
+   // The static network whose model carries the packets of 'network_id'
+   // (itself unless it is in a group of network/shared_networks)
+   SInt32 getPhysicalNetworkId(SInt32 network_id) const { return _physicalNetworks[network_id]; }
    NetworkModel* getNetworkModelFromPacketType(PacketType packet_type);
+   UInt32 getNumModelsCreated() const;
 
 private:
    NetworkModel * _models[NUM_STATIC_NETWORKS];
+   // network/shared_networks: the networks of a group share the model of
+   // the first one, their packets contend for the same routers and links
+   SInt32 _physicalNetworks[NUM_STATIC_NETWORKS];
+   // network/active_networks
+   bool _activeNetworks[NUM_STATIC_NETWORKS];
+   // general/memory_mode = scale: the models are created on first use
+   Lock _modelsLock;
+   bool _modelsEnabled;
+   // Frequency of the core of the tile, the models convert the packet times
+   // from and to its clock
+   volatile float _coreFrequency;
+
+   NetworkModel* createNetworkModel(SInt32 network_id);
+   void parseSharedNetworks();
 
    NetworkCallback *_callbacks;
    void **_callbackObjs;
 
+   UInt64 *_numPacketsSentTo;
+
    Tile *_tile;
    Transport::Node *_transport;
 
@@ -135,15 +270,88 @@ private:
    
    // -- Network Injection/Ejection Rate Trace -- //
    static bool* _utilizationTraceEnabled;
-   static ofstream* _utilizationTraceFiles;
+   static TraceFile* _utilizationTraceFiles;
+
+   // -- Network Latency Percentiles Trace -- //
+   static bool* _latencyTraceEnabled;
+   static TraceFile* _latencyTraceFiles;
+   static LatencyHistogram* _latencyTraceHistograms;
+   static UInt64 _latencyTraceNumSamples;
 
    // Is shortCut available through shared memory
    bool _sharedMemoryShortcutEnabled;
 
-   SInt32 forwardPacket(const NetPacket& packet);
+   // -- Timestamp Ordered Delivery -- //
+   // The packets received in one pull are delivered in timestamp order.
+   // The payload points into the received buffer, released after delivery
+   struct ScheduledPacket
+   {
+      NetPacket packet;
+      Byte *buffer;
+      UInt64 sequence_num;
+   };
+   // Deterministic run: the packets of a batch by time, then sender tile
+   // id (the packets of one sender keep their order)
+   struct SenderLess
+   {
+      bool operator()(const pair<UInt64, ScheduledPacket>& a, const pair<UInt64, ScheduledPacket>& b) const
+      {
+         if (a.first != b.first)
+            return (a.first < b.first);
+         return (a.second.packet.sender.tile_id < b.second.packet.sender.tile_id);
+      }
+   };
+   TimingWheel<ScheduledPacket>* _deliveryWheel;
+   UInt64 _numScheduledPackets;
+   UInt64 _numDeliveryBatches;
+   // Packets delivered after a packet received later
+   UInt64 _numReorderedPackets;
+
+   // Receiver side of a packet that has reached its tile: the model
+   // completes its latency, and the time is converted to core cycles
+   void processReceivedPacket(NetPacket& packet, NetworkModel* model);
+   // Runs the callback of a received packet, or queues it for netRecv()
+   void deliverPacket(NetPacket& packet);
+
+   // -- Direct Delivery (network/direct_delivery, off by default) -- //
+   // A unicast to a tile of this process that has no callback for its type,
+   // on a magic network or one whose model is disabled, is processed by the
+   // receiving network and queued there by the sender, without the
+   // transport. The packets with a callback still go through the transport,
+   // their callbacks run on the thread of the receiver.
+   //   The receive lock serializes the processing of the received packets
+   // (model, traces, clock skew client) of the senders and of the pull.
+   // The packets between two tiles stay in order as long as they take the
+   // same path: a magic network always delivers directly, and the other
+   // networks only until their models are enabled the first time, since a
+   // direct packet sent after the models are disabled again could overtake
+   // the ones still in the transport. A callback registered or removed
+   // while packets of its type are in flight may also reorder them
+   bool _directDeliveryEnabled;
+   bool _magicNetworks[NUM_STATIC_NETWORKS];
+   volatile bool _directDeliveryOnDisabledModels;
+   Lock _receiveLock;
+   UInt64 _numDirectlyDeliveredPackets;
+   // Returns false if the packet has to go through the transport
+   bool deliverDirectly(NetPacket& packet, NetworkModel* model);
+   void deliverScheduledPackets();
+   // Span of a received packet in the event trace, from its send time
+   // (packet time in network cycles)
+   void tracePacket(EventTracer* event_tracer, NetworkModel* model, const NetPacket& packet);
+
+   // -- Packet Trace ([network_trace]) -- //
+   // NULL for the networks that are not recorded
+   NetworkTraceWriter* _traceWriters[NUM_STATIC_NETWORKS];
+   // Records a sent packet (time in core cycles), once per application tile receiving it
+   void writePacketTrace(NetworkTraceWriter* trace_writer, const NetPacket& packet);
+
+   SInt32 forwardPacket(const NetPacket& packet, Byte *buffer = NULL);
+   // Unicasts the packet to every receiver, for models without a broadcast tree
+   SInt32 forwardPacketToReceivers(const NetPacket& packet, const vector<tile_id_t>& receivers);
    
-   // -- Network Injection/Ejection Rate Trace -- //
-   static void computeTraceEnabledNetworks();
+   // -- Network Lists (network/active_networks, traces) -- //
+   // Which networks the list of names in 'key' has ('default_list' if not set, else the key is required)
+   static void parseNetworkList(const std::string& key, bool* listed, const char* default_list = NULL);
 };
 
 #endif // NETWORK_H
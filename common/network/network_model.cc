@@ -1,4 +1,6 @@
 #include <cassert>
+#include <cmath>
+#include <sstream>
 using namespace std;
 
 #include "network.h"
@@ -8,12 +10,21 @@ using namespace std;
 #include "network_model_emesh_hop_counter.h"
 #include "network_model_emesh_hop_by_hop.h"
 #include "network_model_atac.h"
+#include "network_model_torus.h"
+#include "network_model_cmesh.h"
+#include "network_model_flattened_butterfly.h"
 #include "memory_manager.h"
+#include "inter_socket_network.h"
 #include "simulator.h"
+#include "stats_registry.h"
+#include "statistics_manager.h"
 #include "config.h"
 #include "clock_converter.h"
 #include "log.h"
 
+bool NetworkModel::_latency_histograms_enabled = false;
+NetworkModel::SwitchingMode NetworkModel::_switching_mode = NetworkModel::WORMHOLE;
+
 NetworkModel::NetworkModel(Network *network, SInt32 network_id):
    _network(network),
    _network_id(network_id),
@@ -22,6 +33,14 @@ NetworkModel::NetworkModel(Network *network, SInt32 network_id):
    assert(network_id >= 0 && network_id < NUM_STATIC_NETWORKS);
    _network_name = g_static_network_name_list[network_id];
 
+   _num_virtual_channel_classes = 0;
+   for (SInt32 i = 0; i < NUM_STATIC_NETWORKS; i++)
+   {
+      _virtual_channel_class[i] = 0;
+      if (network->getPhysicalNetworkId(i) == network_id)
+         _virtual_channel_class[i] = _num_virtual_channel_classes ++;
+   }
+
    // Get the Tile ID
    _tile_id = getNetwork()->getTile()->getId();
    // Get the Tile Width
@@ -33,11 +52,28 @@ NetworkModel::NetworkModel(Network *network, SInt32 network_id):
    {
       LOG_PRINT_ERROR("Could not read tile_width from the cfg file");
    }
+   try
+   {
+      _switching_mode = parseSwitchingMode(Sim()->getCfg()->getString("network/switching", "wormhole"));
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read network/switching from the cfg file");
+   }
 
    // Initialize Event Counters
    initializeEventCounters();
-   // Trace of Injection/Ejection Rate
-   initializeCurrentUtilizationStatistics();
+   registerStatistics();
+
+   _latency_histograms_enabled = areLatencyHistogramsEnabled();
+   for (SInt32 i = 0; i < NUM_PACKET_TYPES; i++)
+      _latency_histograms[i] = NULL;
+}
+
+NetworkModel::~NetworkModel()
+{
+   for (SInt32 i = 0; i < NUM_PACKET_TYPES; i++)
+      delete [] _latency_histograms[i];
 }
 
 NetworkModel*
@@ -57,12 +93,27 @@ NetworkModel::createModel(Network *net, SInt32 network_id, UInt32 model_type)
    case NETWORK_ATAC:
       return new NetworkModelAtac(net, network_id);
 
+   case NETWORK_TORUS:
+      return new NetworkModelTorus(net, network_id);
+
+   case NETWORK_CMESH:
+      return new NetworkModelCMesh(net, network_id);
+
+   case NETWORK_FLATTENED_BUTTERFLY:
+      return new NetworkModelFlattenedButterfly(net, network_id);
+
    default:
       LOG_PRINT_ERROR("Unrecognized Network Model(%u)", model_type);
       return NULL;
    }
 }
 
+SInt32
+NetworkModel::getVirtualChannelClass(const NetPacket& pkt)
+{
+   return _virtual_channel_class[g_type_to_static_network_map[pkt.type]];
+}
+
 bool
 NetworkModel::isPacketReadyToBeReceived(const NetPacket& pkt)
 {
@@ -106,6 +157,94 @@ NetworkModel::__routePacket(const NetPacket& pkt, queue<Hop>& next_hops)
 
    // Call the routePacket() of the network model
    routePacket(pkt, next_hops);
+
+   if ((_switching_mode == STORE_AND_FORWARD) && isModelEnabled(pkt))
+      addStoreAndForwardDelay(pkt, next_hops);
+}
+
+void
+NetworkModel::addStoreAndForwardDelay(const NetPacket& pkt, queue<Hop>& next_hops)
+{
+   UInt64 num_flits = computeNumFlits(getModeledLength(pkt));
+   for (UInt32 i = 0; i < next_hops.size(); i++)
+   {
+      Hop hop = next_hops.front();
+      next_hops.pop();
+      if (hop._next_node_type != RECEIVE_TILE)
+      {
+         hop._time += num_flits;
+         hop._zero_load_delay += num_flits;
+      }
+      next_hops.push(hop);
+   }
+}
+
+void
+NetworkModel::__routePacketToReceivers(const NetPacket& pkt, const vector<tile_id_t>& receivers, vector<Hop>& hops)
+{
+   ScopedLock sl(_lock);
+
+   tile_id_t pkt_sender = TILE_ID(pkt.sender);
+
+   LOG_ASSERT_ERROR(hasSingleHopRoutes(), "name(%s) does not support routing to many receivers", _network_name.c_str());
+   LOG_ASSERT_ERROR(pkt.node_type == SEND_TILE, "node_type(%i)", pkt.node_type);
+   LOG_ASSERT_ERROR(pkt_sender == _tile_id, "pkt_sender(%i), _tile_id(%i), name(%s)", pkt_sender, _tile_id, _network_name.c_str());
+
+   // Same as processCornerCases(): these are delivered without being modeled
+   vector<tile_id_t> modeled_receivers;
+   modeled_receivers.reserve(receivers.size());
+   for (vector<tile_id_t>::const_iterator it = receivers.begin(); it != receivers.end(); it++)
+   {
+      tile_id_t receiver = *it;
+      if ( (receiver != pkt_sender) && (!isSystemTile(pkt_sender)) && (!isSystemTile(receiver)) )
+      {
+         LOG_ASSERT_ERROR(isApplicationTile(pkt_sender) && isApplicationTile(receiver),
+                          "pkt_sender(%i), pkt_receiver(%i)", pkt_sender, receiver);
+         modeled_receivers.push_back(receiver);
+      }
+   }
+
+   // The modeled length does not depend on the receiver
+   SInt32 num_flits = 0;
+   if (!modeled_receivers.empty())
+   {
+      UInt32 packet_length = getModeledLength(pkt);
+      num_flits = computeNumFlits(packet_length);
+      if (isModelEnabled(pkt))
+         updateSendCounters(packet_length, num_flits, modeled_receivers.size());
+   }
+
+   vector<Hop> modeled_hops;
+   modeled_hops.reserve(modeled_receivers.size());
+   routePacketToReceivers(pkt, num_flits, modeled_receivers, modeled_hops);
+   assert(modeled_hops.size() == modeled_receivers.size());
+
+   // Put the hops back in the order of the receivers
+   hops.reserve(receivers.size());
+   vector<Hop>::iterator modeled_hop = modeled_hops.begin();
+   for (vector<tile_id_t>::const_iterator it = receivers.begin(); it != receivers.end(); it++)
+   {
+      if ( (modeled_hop != modeled_hops.end()) && (modeled_hop->_next_tile_id == *it) )
+         hops.push_back(*(modeled_hop++));
+      else
+         hops.push_back(Hop(pkt, *it, RECEIVE_TILE));
+   }
+}
+
+void
+NetworkModel::routePacketToReceivers(const NetPacket& pkt, SInt32 num_flits,
+                                     const vector<tile_id_t>& receivers, vector<Hop>& hops)
+{
+   NetPacket receiver_pkt = pkt;
+   for (vector<tile_id_t>::const_iterator it = receivers.begin(); it != receivers.end(); it++)
+   {
+      receiver_pkt.receiver = CORE_ID(*it);
+
+      queue<Hop> next_hops;
+      routePacket(receiver_pkt, next_hops);
+      LOG_ASSERT_ERROR(next_hops.size() == 1, "Route to receiver(%i) has %u hops", *it, (UInt32) next_hops.size());
+      hops.push_back(next_hops.front());
+   }
 }
 
 void
@@ -128,6 +267,23 @@ NetworkModel::__processReceivedPacket(NetPacket& pkt)
    // Do modifications of packet time
    processReceivedPacket(pkt);
 
+   // From a tile of another socket
+   InterSocketNetwork* inter_socket_network = Sim()->getInterSocketNetwork();
+   UInt32 sender_socket = Config::getSingleton()->getSocketId(pkt_sender);
+   UInt32 receiver_socket = Config::getSingleton()->getSocketId(_tile_id);
+   if (inter_socket_network && (sender_socket != receiver_socket))
+   {
+      // In ns on the links, in cycles of this network in the packet
+      UInt64 queue_delay = 0;
+      UInt64 delay = inter_socket_network->computeDelay(sender_socket, receiver_socket, (UInt64) (pkt.time / _frequency),
+                                                        (getModeledLength(pkt) + 7) / 8, queue_delay);
+      UInt64 delay_cycles = (UInt64) ceil(delay * _frequency);
+      UInt64 queue_delay_cycles = (UInt64) ceil(queue_delay * _frequency);
+      pkt.time += delay_cycles;
+      pkt.zero_load_delay += delay_cycles - std::min(queue_delay_cycles, delay_cycles);
+      pkt.contention_delay += std::min(queue_delay_cycles, delay_cycles);
+   }
+
    // Update Receive Counters
    updateReceiveCounters(pkt);
 }
@@ -181,8 +337,10 @@ NetworkModel::getModeledLength(const NetPacket& pkt) // In bits
    if ((pkt.type == SHARED_MEM_1) || (pkt.type == SHARED_MEM_2))
    {
       // sender + receiver + size of shmem_msg
-      // log2(core_id) for sender and receiver
-      UInt32 metadata_size = 2 * Config::getSingleton()->getTileIDLength();
+      // log2(core_id) for sender and receiver, a bit per tile for the receivers of a multicast
+      UInt32 metadata_size = Config::getSingleton()->getTileIDLength() +
+                             (pkt.isMulticast() ? Config::getSingleton()->getTotalTiles() :
+                                                  Config::getSingleton()->getTileIDLength());
       UInt32 data_size = getNetwork()->getTile()->getMemoryManager()->getModeledLength(pkt.data);
       return metadata_size + data_size;
    }
@@ -229,20 +387,24 @@ NetworkModel::updateSendCounters(const NetPacket& packet)
    UInt32 packet_length = getModeledLength(packet); // In bits
    SInt32 num_flits = computeNumFlits(packet_length);
    
-   _total_packets_sent ++;
-   _total_flits_sent += num_flits;
-   _total_bits_sent += packet_length;
-   _total_flits_sent_in_current_interval += num_flits;
+   updateSendCounters(packet_length, num_flits, 1);
 
    if (receiver == NetPacket::BROADCAST)
    {
       _total_packets_broadcasted ++;
       _total_flits_broadcasted += num_flits;
       _total_bits_broadcasted += packet_length;
-      _total_flits_broadcasted_in_current_interval += num_flits;
    }
 }
 
+void
+NetworkModel::updateSendCounters(UInt32 packet_length, SInt32 num_flits, UInt64 num_packets)
+{
+   _total_packets_sent += num_packets;
+   _total_flits_sent += num_flits * num_packets;
+   _total_bits_sent += packet_length * num_packets;
+}
+
 void
 NetworkModel::updateReceiveCounters(const NetPacket& packet)
 {
@@ -256,12 +418,126 @@ NetworkModel::updateReceiveCounters(const NetPacket& packet)
    _total_packets_received ++;
    _total_flits_received += num_flits;
    _total_bits_received += packet_length;
-   _total_flits_received_in_current_interval += num_flits;
 
    UInt64 packet_latency = packet.zero_load_delay + packet.contention_delay;
    UInt64 contention_delay = packet.contention_delay;
    _total_packet_latency += packet_latency;
    _total_contention_delay += contention_delay;
+
+   if (_latency_histograms_enabled)
+      updateLatencyHistograms(packet);
+}
+
+bool
+NetworkModel::areLatencyHistogramsEnabled()
+{
+   return Sim()->getCfg()->getBool("network/latency_histograms/enabled", false);
+}
+
+void
+NetworkModel::updateLatencyHistograms(const NetPacket& packet)
+{
+   // Called with the model lock held, so each histogram has a single writer
+   LatencyHistogram* histograms = _latency_histograms[packet.type];
+   if (histograms == NULL)
+   {
+      histograms = new LatencyHistogram[NUM_LATENCY_HISTOGRAM_TYPES];
+      // Make sure the histograms are cleared before they are published
+      // to readers (the statistics trace)
+      __sync_synchronize();
+      _latency_histograms[packet.type] = histograms;
+   }
+
+   histograms[PACKET_LATENCY].add(packet.zero_load_delay + packet.contention_delay);
+   histograms[ZERO_LOAD_DELAY].add(packet.zero_load_delay);
+   histograms[CONTENTION_DELAY].add(packet.contention_delay);
+}
+
+const LatencyHistogram*
+NetworkModel::getLatencyHistogram(PacketType packet_type, LatencyHistogramType histogram_type)
+{
+   LatencyHistogram* histograms = _latency_histograms[packet_type];
+   return (histograms != NULL) ? &histograms[histogram_type] : NULL;
+}
+
+void
+NetworkModel::outputLatencyPercentiles(ostream& out, const LatencyHistogram& histogram)
+{
+   out << histogram.getPercentile(50) << ", "
+       << histogram.getPercentile(90) << ", "
+       << histogram.getPercentile(99) << ", "
+       << histogram.getPercentile(99.9);
+}
+
+void
+NetworkModel::outputLatencyHistogramSummary(ostream& out)
+{
+   out << "    Latency Percentiles [p50, p90, p99, p99.9] (in clock cycles): " << endl;
+   for (SInt32 i = 0; i < NUM_PACKET_TYPES; i++)
+   {
+      LatencyHistogram* histograms = _latency_histograms[i];
+      if (histograms == NULL)
+         continue;
+
+      out << "      " << g_packet_type_name_list[i] << " (" << histograms[PACKET_LATENCY].getCount() << " packets)" << endl;
+      out << "        Packet Latency: ";
+      outputLatencyPercentiles(out, histograms[PACKET_LATENCY]);
+      out << endl;
+      out << "        Zero Load Delay: ";
+      outputLatencyPercentiles(out, histograms[ZERO_LOAD_DELAY]);
+      out << endl;
+      out << "        Contention Delay: ";
+      outputLatencyPercentiles(out, histograms[CONTENTION_DELAY]);
+      out << endl;
+   }
+}
+
+void
+NetworkModel::setCoreFrequency(volatile float core_frequency)
+{
+   _from_core_cycles.setFrequencies(core_frequency, _frequency);
+   _to_core_cycles.setFrequencies(_frequency, core_frequency);
+}
+
+void
+NetworkModel::registerStatistics()
+{
+   // Injection/ejection rate of the statistics trace
+   StatisticsManager* statistics_manager = Sim()->getStatisticsManager();
+   if (statistics_manager)
+   {
+      statistics_manager->registerCounter(_tile_id,
+            (StatisticsManager::Counter) (StatisticsManager::NETWORK_FLITS_SENT + _network_id), &_total_flits_sent);
+      statistics_manager->registerCounter(_tile_id,
+            (StatisticsManager::Counter) (StatisticsManager::NETWORK_FLITS_BROADCASTED + _network_id), &_total_flits_broadcasted);
+      statistics_manager->registerCounter(_tile_id,
+            (StatisticsManager::Counter) (StatisticsManager::NETWORK_FLITS_RECEIVED + _network_id), &_total_flits_received);
+   }
+
+   StatsRegistry* stats = Sim()->getStatsRegistry();
+   if (!stats)
+      return;
+
+   string prefix = "Network " + _network_name + "/";
+   stats->registerCounter(_tile_id, prefix + "Total Packets Sent", &_total_packets_sent);
+   stats->registerCounter(_tile_id, prefix + "Total Flits Sent", &_total_flits_sent);
+   stats->registerCounter(_tile_id, prefix + "Total Bits Sent", &_total_bits_sent);
+   stats->registerCounter(_tile_id, prefix + "Total Packets Broadcasted", &_total_packets_broadcasted);
+   stats->registerCounter(_tile_id, prefix + "Total Flits Broadcasted", &_total_flits_broadcasted);
+   stats->registerCounter(_tile_id, prefix + "Total Bits Broadcasted", &_total_bits_broadcasted);
+   stats->registerCounter(_tile_id, prefix + "Total Packets Received", &_total_packets_received);
+   stats->registerCounter(_tile_id, prefix + "Total Flits Received", &_total_flits_received);
+   stats->registerCounter(_tile_id, prefix + "Total Bits Received", &_total_bits_received);
+   stats->registerCounter(_tile_id, prefix + "Total Packet Latency", &_total_packet_latency);
+   stats->registerCounter(_tile_id, prefix + "Total Contention Delay", &_total_contention_delay);
+}
+
+string
+NetworkModel::getPowerModelCounterPrefix(const string& component)
+{
+   ostringstream prefix;
+   prefix << "Network " << _network_name << "/" << component << " " << (_num_power_models[component] ++) << "/";
+   return prefix.str();
 }
 
 void
@@ -302,6 +578,9 @@ NetworkModel::outputSummary(ostream& out)
       out << "    Average Contention Delay (in clock cycles): 0" << endl;
       out << "    Average Contention Delay (in ns): 0" << endl;
    }
+
+   if (_latency_histograms_enabled)
+      outputLatencyHistogramSummary(out);
 }
 
 UInt32 
@@ -319,10 +598,27 @@ NetworkModel::parseNetworkType(string str)
       return NETWORK_ECLOS;
    else if (str == "atac")
       return NETWORK_ATAC;
+   else if (str == "torus")
+      return NETWORK_TORUS;
+   else if (str == "cmesh")
+      return NETWORK_CMESH;
+   else if (str == "flattened_butterfly")
+      return NETWORK_FLATTENED_BUTTERFLY;
    else
       return (UInt32)-1;
 }
 
+NetworkModel::SwitchingMode
+NetworkModel::parseSwitchingMode(string str)
+{
+   if (str == "wormhole")
+      return WORMHOLE;
+   else if (str == "store_and_forward")
+      return STORE_AND_FORWARD;
+   LOG_PRINT_ERROR("Unrecognized network/switching(%s)", str.c_str());
+   return NUM_SWITCHING_MODES;
+}
+
 bool
 NetworkModel::isTileCountPermissible(UInt32 network_type, SInt32 tile_count)
 {
@@ -337,6 +633,15 @@ NetworkModel::isTileCountPermissible(UInt32 network_type, SInt32 tile_count)
 
       case NETWORK_ATAC:
          return NetworkModelAtac::isTileCountPermissible(tile_count);
+
+      case NETWORK_TORUS:
+         return NetworkModelTorus::isTileCountPermissible(tile_count);
+
+      case NETWORK_CMESH:
+         return NetworkModelCMesh::isTileCountPermissible(tile_count);
+
+      case NETWORK_FLATTENED_BUTTERFLY:
+         return NetworkModelFlattenedButterfly::isTileCountPermissible(tile_count);
       
       default:
          fprintf(stderr, "*ERROR* Unrecognized network type(%u)\n", network_type);
@@ -345,13 +650,51 @@ NetworkModel::isTileCountPermissible(UInt32 network_type, SInt32 tile_count)
    }
 }
 
-pair<bool, vector<tile_id_t> > 
+pair<bool, vector<tile_id_t> >
 NetworkModel::computeMemoryControllerPositions(UInt32 network_type, SInt32 num_memory_controllers, SInt32 tile_count)
+{
+   pair<bool, vector<tile_id_t> > positions = computeChipMemoryControllerPositions(network_type, num_memory_controllers, tile_count);
+   UInt32 num_sockets = Config::getSingleton()->getNumSockets();
+   if (num_sockets == 1)
+      return positions;
+
+   // Each socket has its own memory: the same number of controllers in
+   // every socket. If the placement of the network does not give that, the
+   // controllers of a socket are spread evenly over its tiles
+   LOG_ASSERT_ERROR((num_memory_controllers % num_sockets) == 0,
+                    "Num Memory Controllers(%i) must be a multiple of socket/num_sockets(%u)",
+                    num_memory_controllers, num_sockets);
+   SInt32 controllers_per_socket = num_memory_controllers / num_sockets;
+   SInt32 tiles_per_socket = tile_count / num_sockets;
+
+   vector<SInt32> num_socket_controllers(num_sockets, 0);
+   for (UInt32 i = 0; i < positions.second.size(); i++)
+      num_socket_controllers[Config::getSingleton()->getSocketId(positions.second[i])] ++;
+   bool balanced = true;
+   for (UInt32 s = 0; s < num_sockets; s++)
+      balanced = balanced && (num_socket_controllers[s] == controllers_per_socket);
+   if (balanced)
+      return positions;
+
+   vector<tile_id_t> tile_list_with_memory_controllers;
+   for (UInt32 s = 0; s < num_sockets; s++)
+   {
+      for (SInt32 i = 0; i < controllers_per_socket; i++)
+         tile_list_with_memory_controllers.push_back(s * tiles_per_socket + (i * tiles_per_socket) / controllers_per_socket);
+   }
+   return make_pair(false, tile_list_with_memory_controllers);
+}
+
+pair<bool, vector<tile_id_t> >
+NetworkModel::computeChipMemoryControllerPositions(UInt32 network_type, SInt32 num_memory_controllers, SInt32 tile_count)
 {
    switch(network_type)
    {
       case NETWORK_MAGIC:
       case NETWORK_EMESH_HOP_COUNTER:
+      case NETWORK_TORUS:
+      case NETWORK_CMESH:
+      case NETWORK_FLATTENED_BUTTERFLY:
          {
             SInt32 spacing_between_memory_controllers = tile_count / num_memory_controllers;
             vector<tile_id_t> tile_list_with_memory_controllers;
@@ -377,6 +720,21 @@ NetworkModel::computeMemoryControllerPositions(UInt32 network_type, SInt32 num_m
    }
 }
 
+pair<bool, vector<tile_id_t> >
+NetworkModel::optimizeMemoryControllerPositions(UInt32 network_type, const vector<UInt64>& traffic,
+                                                const vector<tile_id_t>& initial_positions,
+                                                double link_load_weight)
+{
+   switch(network_type)
+   {
+      case NETWORK_EMESH_HOP_BY_HOP:
+         return NetworkModelEMeshHopByHop::optimizeMemoryControllerPositions(traffic, initial_positions, link_load_weight);
+
+      default:
+         return make_pair(false, initial_positions);
+   }
+}
+
 pair<bool, vector<Config::TileList> >
 NetworkModel::computeProcessToTileMapping(UInt32 network_type)
 {
@@ -384,6 +742,9 @@ NetworkModel::computeProcessToTileMapping(UInt32 network_type)
    {
       case NETWORK_MAGIC:
       case NETWORK_EMESH_HOP_COUNTER:
+      case NETWORK_TORUS:
+      case NETWORK_CMESH:
+      case NETWORK_FLATTENED_BUTTERFLY:
          return make_pair(false, vector<vector<tile_id_t> >());
 
       case NETWORK_EMESH_HOP_BY_HOP:
@@ -418,7 +779,8 @@ NetworkModel::processCornerCases(const NetPacket& pkt, queue<Hop>& next_hops)
       {
          for (tile_id_t i = 0; i < (tile_id_t) Config::getSingleton()->getTotalTiles(); i++)
          {
-            next_hops.push(Hop(pkt, i, RECEIVE_TILE));
+            if (!pkt.isMulticast() || pkt.isMulticastReceiver(i))
+               next_hops.push(Hop(pkt, i, RECEIVE_TILE));
          }
       }
       else // (pkt_receiver != NetPacket::BROADCAST)
@@ -444,7 +806,8 @@ NetworkModel::processCornerCases(const NetPacket& pkt, queue<Hop>& next_hops)
                         i < (tile_id_t) Config::getSingleton()->getTotalTiles();
                         i++)
          {
-            next_hops.push(Hop(pkt, i, RECEIVE_TILE));
+            if (!pkt.isMulticast() || pkt.isMulticastReceiver(i))
+               next_hops.push(Hop(pkt, i, RECEIVE_TILE));
          }
       }
 
@@ -456,24 +819,6 @@ NetworkModel::processCornerCases(const NetPacket& pkt, queue<Hop>& next_hops)
    return true;
 }
 
-void
-NetworkModel::initializeCurrentUtilizationStatistics()
-{
-   _total_flits_sent_in_current_interval = 0;
-   _total_flits_broadcasted_in_current_interval = 0;
-   _total_flits_received_in_current_interval = 0;
-}
-
-void
-NetworkModel::popCurrentUtilizationStatistics(UInt64& flits_sent, UInt64& flits_broadcasted, UInt64& flits_received)
-{
-   flits_sent = _total_flits_sent_in_current_interval;
-   flits_broadcasted = _total_flits_broadcasted_in_current_interval;
-   flits_received = _total_flits_received_in_current_interval;
-   
-   initializeCurrentUtilizationStatistics();
-}
-
 NetworkModel::Hop::Hop(const NetPacket& pkt, tile_id_t next_tile_id, SInt32 next_node_type,
                        UInt64 zero_load_delay, UInt64 contention_delay)
    : _next_tile_id(next_tile_id)
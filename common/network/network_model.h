@@ -7,6 +7,7 @@ class Network;
 #include <vector>
 #include <queue>
 #include <string>
+#include <map>
 using std::queue;
 using std::vector;
 using std::string;
@@ -16,6 +17,8 @@ using std::pair;
 #include "config.h"
 #include "packet_type.h"
 #include "fixed_types.h"
+#include "latency_histogram.h"
+#include "clock_converter.h"
 
 #define CORE_ID(x)         ((core_id_t) {x, MAIN_CORE_TYPE})
 #define TILE_ID(x)         (x.tile_id)
@@ -36,7 +39,7 @@ class NetworkModel
 {
 public:
    NetworkModel(Network *network, SInt32 network_id);
-   virtual ~NetworkModel() { }
+   virtual ~NetworkModel();
 
    class Hop
    {
@@ -58,10 +61,22 @@ public:
    };
 
    volatile float getFrequency() { return _frequency; }
+   // Conversions between the clocks of the core of the tile and the network
+   void setCoreFrequency(volatile float core_frequency);
+   UInt64 convertFromCoreCycles(UInt64 cycle_count) const { return _from_core_cycles.convert(cycle_count); }
+   UInt64 convertToCoreCycles(UInt64 cycle_count) const   { return _to_core_cycles.convert(cycle_count); }
    bool hasBroadcastCapability() { return _has_broadcast_capability; }
 
    bool isPacketReadyToBeReceived(const NetPacket& pkt);
    void __routePacket(const NetPacket &pkt, queue<Hop> &next_hops);
+   // Routes a unicast copy of the packet to each of the receivers in one
+   // pass, e.g., for broadcasts on models without a broadcast tree.
+   // The modeled length is computed and the send counters are updated
+   // once, under a single lock. hops[i] is the hop to receivers[i].
+   // Only for models whose routes are a single hop (see hasSingleHopRoutes())
+   void __routePacketToReceivers(const NetPacket &pkt, const vector<tile_id_t>& receivers, vector<Hop>& hops);
+   // Does every route go straight to the RECEIVE_TILE?
+   virtual bool hasSingleHopRoutes() { return false; }
    void __processReceivedPacket(NetPacket &pkt);
 
    virtual void outputSummary(std::ostream &out) = 0;
@@ -73,13 +88,47 @@ public:
    static UInt32 parseNetworkType(string str);
 
    static bool isTileCountPermissible(UInt32 network_type, SInt32 tile_count);
+   // With several sockets ([socket] num_sockets), each socket gets the same
+   // number of controllers
    static pair<bool, vector<tile_id_t> > computeMemoryControllerPositions(UInt32 network_type, SInt32 num_memory_controllers, SInt32 total_tiles);
+   // Moves the memory controllers from 'initial_positions' closer to the tiles with the
+   // most DRAM traffic ('traffic' has one entry per application tile). Returns false if
+   // the network has no placement search
+   static pair<bool, vector<tile_id_t> > optimizeMemoryControllerPositions(UInt32 network_type, const vector<UInt64>& traffic,
+                                                                           const vector<tile_id_t>& initial_positions,
+                                                                           double link_load_weight);
    static pair<bool, vector<Config::TileList> > computeProcessToTileMapping(UInt32 network_type);
 
    // SEND_TILE, RECEIVE_TILE
    static const SInt32 SEND_TILE = 0;
    static const SInt32 RECEIVE_TILE = 1;
 
+   // Tile the model belongs to
+   tile_id_t getTileId() { return _tile_id; }
+   // Prefix of the event counters of the next power model of a component
+   // in the stats file (e.g. "Network user/Router 2/"), numbered in the
+   // order the models are built
+   string getPowerModelCounterPrefix(const string& component);
+
+   // Switching (network/switching). The delay of a packet is computed in
+   // closed form over its path: with wormhole switching, the head flit pays
+   // the router and link delays of every hop and the body flits follow it,
+   // so the serialization (a cycle per flit) is paid once, at the receiver.
+   // With store-and-forward switching, every router receives the whole
+   // packet before forwarding it, and pays the serialization again
+   enum SwitchingMode
+   {
+      WORMHOLE = 0,
+      STORE_AND_FORWARD,
+      NUM_SWITCHING_MODES
+   };
+   static SwitchingMode getSwitchingMode() { return _switching_mode; }
+
+   // The static networks that share the model (network/shared_networks)
+   // are the classes of the virtual channels of its routers
+   SInt32 getNumVirtualChannelClasses() { return _num_virtual_channel_classes; }
+   SInt32 getVirtualChannelClass(const NetPacket& pkt);
+
    // Is Model Enabled
    bool isModelEnabled(const NetPacket& pkt);
    // Get Modeled Length (in bits)
@@ -87,8 +136,19 @@ public:
    // Compute Number of Flits
    SInt32 computeNumFlits(UInt32 pkt_length);
 
-   // Tracing Network Injection/Ejection Rate
-   void popCurrentUtilizationStatistics(UInt64& total_flits_sent, UInt64& total_flits_broadcasted, UInt64& total_flits_received);
+   // Latency Histograms (in clock cycles) of received packets.
+   // Zero-load and contention delay are kept separate.
+   enum LatencyHistogramType
+   {
+      PACKET_LATENCY = 0,
+      ZERO_LOAD_DELAY,
+      CONTENTION_DELAY,
+      NUM_LATENCY_HISTOGRAM_TYPES
+   };
+   static bool areLatencyHistogramsEnabled();
+   // Returns NULL if no packet of that type has been received
+   const LatencyHistogram* getLatencyHistogram(PacketType packet_type, LatencyHistogramType histogram_type);
+   static void outputLatencyPercentiles(std::ostream& out, const LatencyHistogram& histogram);
 
 protected:
    class NextDest
@@ -124,6 +184,13 @@ protected:
    // Is System Tile - Thread Spawner or MCP
    bool isSystemTile(tile_id_t tile_id);
 
+   // Serialization delay (in cycles) of a packet of num_flits at the
+   // num_routers routers of its path, 0 with wormhole switching. The
+   // models whose hops are routers get it added by __routePacket(), the
+   // ones that route over the whole path in one hop add it themselves
+   UInt64 computeStoreAndForwardDelay(SInt32 num_flits, UInt32 num_routers)
+   { return (_switching_mode == STORE_AND_FORWARD) ? (((UInt64) num_flits) * num_routers) : 0; }
+
 private:
    Network *_network;
    
@@ -131,9 +198,16 @@ private:
    string _network_name;
    bool _enabled;
 
+   SInt32 _num_virtual_channel_classes;
+   SInt32 _virtual_channel_class[NUM_STATIC_NETWORKS];
+
    // Lock
    Lock _lock;
 
+   // Core to network cycles and back
+   CycleCountConverter _from_core_cycles;
+   CycleCountConverter _to_core_cycles;
+
    // Event Counters
    UInt64 _total_packets_sent;
    UInt64 _total_flits_sent;
@@ -150,12 +224,26 @@ private:
    UInt64 _total_packet_latency;
    UInt64 _total_contention_delay;
 
-   // For getting a trace of network injection/ejection rate
-   UInt64 _total_flits_sent_in_current_interval;
-   UInt64 _total_flits_broadcasted_in_current_interval;
-   UInt64 _total_flits_received_in_current_interval;
+   // Power models built, by component
+   std::map<string, UInt32> _num_power_models;
+
+   static SwitchingMode _switching_mode;
+   // Placement of the network over all the tiles, as if on one chip
+   static pair<bool, vector<tile_id_t> > computeChipMemoryControllerPositions(UInt32 network_type, SInt32 num_memory_controllers,
+                                                                              SInt32 total_tiles);
+   static SwitchingMode parseSwitchingMode(string str);
+   // Store-and-forward: the hops to a router are delayed by the serialization
+   void addStoreAndForwardDelay(const NetPacket& pkt, queue<Hop>& next_hops);
+
+   // Latency Histograms, created when the first packet of a type is received
+   static bool _latency_histograms_enabled;
+   LatencyHistogram* _latency_histograms[NUM_PACKET_TYPES];
 
    virtual void routePacket(const NetPacket &pkt, queue<Hop> &next_hops) = 0;
+   // Modeled receivers of __routePacketToReceivers(). By default calls
+   // routePacket() for each receiver
+   virtual void routePacketToReceivers(const NetPacket &pkt, SInt32 num_flits,
+                                       const vector<tile_id_t>& receivers, vector<Hop>& hops);
    virtual void processReceivedPacket(NetPacket &pkt);
   
    // Process Corner Cases
@@ -163,12 +251,15 @@ private:
 
    // Update Send & Receive Counters
    void updateSendCounters(const NetPacket& packet);
+   void updateSendCounters(UInt32 packet_length, SInt32 num_flits, UInt64 num_packets);
    void updateReceiveCounters(const NetPacket& packet);
+   void updateLatencyHistograms(const NetPacket& packet);
+   void outputLatencyHistogramSummary(std::ostream& out);
 
    // Initialize Event Counters
    void initializeEventCounters();
-   // Trace of Injection/Ejection Rate
-   void initializeCurrentUtilizationStatistics();
+   // Counters of the stats file and the statistics trace
+   void registerStatistics();
 };
 
 #endif // NETWORK_MODEL_H
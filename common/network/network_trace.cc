@@ -0,0 +1,201 @@
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <sstream>
+
+#include "network_trace.h"
+#include "log.h"
+
+string
+NetworkTrace::getFileName(string directory, SInt32 network_id, tile_id_t tile_id)
+{
+   std::ostringstream filename;
+   filename << directory << "/network_trace." << g_static_network_name_list[network_id] << "." << tile_id;
+   return filename.str();
+}
+
+// NetworkTraceWriter
+
+NetworkTraceWriter::NetworkTraceWriter(string filename, tile_id_t tile_id, SInt32 network_id,
+                                       SInt32 num_tiles, UInt64 dependency_window)
+   : m_last_time(0)
+   , m_dependency_window(dependency_window)
+   , m_num_packets_received_from(num_tiles, 0)
+   , m_last_received_sender(INVALID_TILE_ID)
+   , m_last_received_time(0)
+{
+   m_file = fopen(filename.c_str(), "wb");
+   LOG_ASSERT_ERROR(m_file, "Could not open network trace(%s)", filename.c_str());
+
+   UInt32 header[4] = { NetworkTrace::MAGIC, NetworkTrace::VERSION, (UInt32) tile_id, (UInt32) network_id };
+   fwrite(header, sizeof(header), 1, m_file);
+}
+
+NetworkTraceWriter::~NetworkTraceWriter()
+{
+   fclose(m_file);
+}
+
+void
+NetworkTraceWriter::recordReceive(tile_id_t sender, UInt64 time)
+{
+   if (m_dependency_window == 0)
+      return;
+
+   ScopedLock sl(m_lock);
+   m_num_packets_received_from[sender] ++;
+   m_last_received_sender = sender;
+   m_last_received_time = time;
+}
+
+void
+NetworkTraceWriter::writePacket(UInt64 time, PacketType type, tile_id_t receiver, UInt32 length)
+{
+   ScopedLock sl(m_lock);
+
+   writeSigned((SInt64) (time - m_last_time));
+   m_last_time = time;
+   writeUnsigned(receiver);
+   writeByte(type);
+   writeUnsigned(length);
+
+   // Sender + 1 of the packet it depends on, 0 if none
+   if ( (m_last_received_sender != INVALID_TILE_ID) && (time >= m_last_received_time) &&
+        (time - m_last_received_time < m_dependency_window) )
+   {
+      writeUnsigned(m_last_received_sender + 1);
+      writeUnsigned(m_num_packets_received_from[m_last_received_sender] - 1);
+      writeUnsigned(time - m_last_received_time);
+      // A received packet is the dependency of one packet only
+      m_last_received_sender = INVALID_TILE_ID;
+   }
+   else
+   {
+      writeUnsigned(0);
+   }
+}
+
+void
+NetworkTraceWriter::writeByte(UInt8 value)
+{
+   putc(value, m_file);
+}
+
+void
+NetworkTraceWriter::writeUnsigned(UInt64 value)
+{
+   while (value >= 0x80)
+   {
+      writeByte((value & 0x7f) | 0x80);
+      value >>= 7;
+   }
+   writeByte(value);
+}
+
+void
+NetworkTraceWriter::writeSigned(SInt64 value)
+{
+   // Zigzag: small negative values are small too
+   writeUnsigned((((UInt64) value) << 1) ^ ((UInt64) (value >> 63)));
+}
+
+// NetworkTraceReader
+
+NetworkTraceReader::NetworkTraceReader(string filename)
+   : m_filename(filename)
+   , m_data(NULL)
+   , m_size(0)
+   , m_position(0)
+   , m_tile_id(INVALID_TILE_ID)
+   , m_network_id(-1)
+   , m_last_time(0)
+{
+   int fd = open(filename.c_str(), O_RDONLY);
+   LOG_ASSERT_ERROR(fd >= 0, "Could not open network trace(%s)", filename.c_str());
+
+   struct stat file_stat;
+   fstat(fd, &file_stat);
+   m_size = file_stat.st_size;
+
+   UInt32 header[4];
+   LOG_ASSERT_ERROR(m_size >= sizeof(header), "Network trace(%s) is truncated", filename.c_str());
+
+   void* data = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   LOG_ASSERT_ERROR(data != MAP_FAILED, "Could not map network trace(%s)", filename.c_str());
+   close(fd);
+   m_data = (const UInt8*) data;
+
+   memcpy(header, m_data, sizeof(header));
+   LOG_ASSERT_ERROR(header[0] == NetworkTrace::MAGIC, "%s is not a network trace", filename.c_str());
+   LOG_ASSERT_ERROR(header[1] == NetworkTrace::VERSION, "Network trace(%s) has version(%u), expected(%u)",
+                    filename.c_str(), header[1], NetworkTrace::VERSION);
+   m_tile_id = (tile_id_t) header[2];
+   m_network_id = (SInt32) header[3];
+   m_position = sizeof(header);
+}
+
+NetworkTraceReader::~NetworkTraceReader()
+{
+   munmap((void*) m_data, m_size);
+}
+
+bool
+NetworkTraceReader::readRecord(Record& record)
+{
+   if (m_position == m_size)
+      return false;
+
+   m_last_time += (UInt64) readSigned();
+   record.time = m_last_time;
+   record.receiver = (tile_id_t) readUnsigned();
+   record.type = (PacketType) readByte();
+   LOG_ASSERT_ERROR(record.type < NUM_PACKET_TYPES, "Network trace(%s) has packet type(%u)",
+                    m_filename.c_str(), record.type);
+   record.length = (UInt32) readUnsigned();
+
+   UInt64 dependency_sender = readUnsigned();
+   if (dependency_sender > 0)
+   {
+      record.dependency_sender = (tile_id_t) (dependency_sender - 1);
+      record.dependency_index = readUnsigned();
+      record.dependency_gap = readUnsigned();
+   }
+   else
+   {
+      record.dependency_sender = INVALID_TILE_ID;
+      record.dependency_index = 0;
+      record.dependency_gap = 0;
+   }
+   return true;
+}
+
+UInt8
+NetworkTraceReader::readByte()
+{
+   LOG_ASSERT_ERROR(m_position < m_size, "Network trace(%s) is truncated", m_filename.c_str());
+   return m_data[m_position ++];
+}
+
+UInt64
+NetworkTraceReader::readUnsigned()
+{
+   UInt64 value = 0;
+   UInt32 shift = 0;
+   UInt8 byte;
+   do
+   {
+      byte = readByte();
+      value |= ((UInt64) (byte & 0x7f)) << shift;
+      shift += 7;
+   } while (byte & 0x80);
+   return value;
+}
+
+SInt64
+NetworkTraceReader::readSigned()
+{
+   UInt64 value = readUnsigned();
+   return (SInt64) ((value >> 1) ^ (~(value & 1) + 1));
+}
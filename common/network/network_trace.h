@@ -0,0 +1,112 @@
+#ifndef NETWORK_TRACE_H
+#define NETWORK_TRACE_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "fixed_types.h"
+#include "packet_type.h"
+#include "lock.h"
+
+using std::string;
+
+/*
+  Packet trace of a static network on a tile ([network_trace] enabled =
+  true): every packet the tile sends on the network through netSend, with
+  its time (in core cycles), type, receiver and length. It is replayed on
+  any network model by tools/network_replay.
+
+  A broadcast or multicast is recorded as a packet per receiving
+  application tile, and the packets to the tile itself or to the system
+  tiles are left out.
+    With dependency tracking (dependency_window > 0), a packet sent less
+  than dependency_window cycles after the tile received a packet on the same
+  network (a reply to a request, mostly) depends on it: the record has the
+  sender of that packet, its index among the packets received from that
+  sender and the gap between its arrival and the send. The packets between
+  two tiles are received in the order they are sent, so the index is also
+  the one of the packet in the trace of the sender.
+
+  A trace is a header followed by records. A record has its fields encoded
+  as LEB128 varints, the time as a zigzag delta from the previous record.
+  The reader maps the whole file.
+ */
+class NetworkTrace
+{
+public:
+   static const UInt32 MAGIC = 0x52544e47;   // "GNTR"
+   static const UInt32 VERSION = 1;
+
+   static string getFileName(string directory, SInt32 network_id, tile_id_t tile_id);
+};
+
+class NetworkTraceWriter
+{
+public:
+   // 'dependency_window' in core cycles, 0 to track no dependencies
+   NetworkTraceWriter(string filename, tile_id_t tile_id, SInt32 network_id,
+                      SInt32 num_tiles, UInt64 dependency_window);
+   ~NetworkTraceWriter();
+
+   // A packet received by the tile, at its arrival time (in core cycles)
+   void recordReceive(tile_id_t sender, UInt64 time);
+   // A packet sent by the tile, at its send time (in core cycles)
+   void writePacket(UInt64 time, PacketType type, tile_id_t receiver, UInt32 length);
+
+private:
+   void writeByte(UInt8 value);
+   void writeUnsigned(UInt64 value);
+   void writeSigned(SInt64 value);
+
+   // Packets are sent and received by both the app and the sim threads
+   Lock m_lock;
+   FILE* m_file;
+   UInt64 m_last_time;
+
+   // Dependency tracking: packets received from each tile, and the last one
+   UInt64 m_dependency_window;
+   std::vector<UInt64> m_num_packets_received_from;
+   tile_id_t m_last_received_sender;
+   UInt64 m_last_received_time;
+};
+
+class NetworkTraceReader
+{
+public:
+   struct Record
+   {
+      UInt64 time;
+      PacketType type;
+      tile_id_t receiver;
+      UInt32 length;
+      // INVALID_TILE_ID if the packet depends on no received packet
+      tile_id_t dependency_sender;
+      UInt64 dependency_index;
+      UInt64 dependency_gap;
+   };
+
+   NetworkTraceReader(string filename);
+   ~NetworkTraceReader();
+
+   tile_id_t getTileId() const { return m_tile_id; }
+   SInt32 getNetworkId() const { return m_network_id; }
+
+   // Returns false at the end of the trace
+   bool readRecord(Record& record);
+
+private:
+   UInt8 readByte();
+   UInt64 readUnsigned();
+   SInt64 readSigned();
+
+   string m_filename;
+   const UInt8* m_data;
+   UInt64 m_size;
+   UInt64 m_position;
+   tile_id_t m_tile_id;
+   SInt32 m_network_id;
+   UInt64 m_last_time;
+};
+
+#endif
@@ -9,6 +9,9 @@ enum NetworkType
    NETWORK_EMESH_HOP_BY_HOP,
    NETWORK_ECLOS,
    NETWORK_ATAC,
+   NETWORK_TORUS,
+   NETWORK_CMESH,
+   NETWORK_FLATTENED_BUTTERFLY,
    NUM_NETWORK_TYPES
 };
 
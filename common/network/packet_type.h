@@ -28,9 +28,49 @@ enum PacketType
    SYSTEM_INITIALIZATION_ACK,
    SYSTEM_INITIALIZATION_FINI,
    CLOCK_SKEW_MINIMIZATION,
+   SYNC_SERVER_REQUEST_TYPE,
+   SYNC_SERVER_RESPONSE_TYPE,
+   BARRIER_RELEASE_TYPE,
+   FUTEX_SERVER_REQUEST_TYPE,
+   FUTEX_SERVER_RESPONSE_TYPE,
+   TLB_SHOOTDOWN_TYPE,
    NUM_PACKET_TYPES
 };
 
+// This gives the list of names for the packet types
+static std::string g_packet_type_name_list[] __attribute__((unused)) =
+{
+   "invalid",
+   "user_1",
+   "user_2",
+   "shared_mem_1",
+   "shared_mem_2",
+   "sim_thread_terminate_threads",
+   "mcp_request",
+   "mcp_response",
+   "mcp_utilization_update",
+   "mcp_system",
+   "mcp_system_response",
+   "mcp_thread_spawn_reply_from_master",
+   "mcp_thread_yield_reply_from_master",
+   "mcp_thread_exit_reply_from_master",
+   "mcp_thread_getaffinity_reply_from_master",
+   "mcp_thread_query_index_reply_from_master",
+   "mcp_thread_join_reply",
+   "lcp_comm_id_update_reply",
+   "lcp_toggle_performance_counters_ack",
+   "system_initialization_notify",
+   "system_initialization_ack",
+   "system_initialization_fini",
+   "clock_skew_minimization",
+   "sync_server_request",
+   "sync_server_response",
+   "barrier_release",
+   "futex_server_request",
+   "futex_server_response",
+   "tlb_shootdown"
+};
+
 // This defines the different static network types
 enum EStaticNetwork
 {
@@ -78,7 +118,13 @@ static EStaticNetwork g_type_to_static_network_map[] __attribute__((unused)) =
    STATIC_NETWORK_SYSTEM,        // SYSTEM_INITIALIZATION_NOTIFY
    STATIC_NETWORK_SYSTEM,        // SYSTEM_INITIALIZATION_ACK
    STATIC_NETWORK_SYSTEM,        // SYSTEM_INITIALIZATION_FINI
-   STATIC_NETWORK_SYSTEM         // CLOCK_SKEW_MINIMIZATION
+   STATIC_NETWORK_SYSTEM,        // CLOCK_SKEW_MINIMIZATION
+   STATIC_NETWORK_USER_1,        // SYNC_SERVER_REQ
+   STATIC_NETWORK_USER_1,        // SYNC_SERVER_RESP
+   STATIC_NETWORK_SYSTEM,        // BARRIER_RELEASE
+   STATIC_NETWORK_USER_1,        // FUTEX_SERVER_REQ
+   STATIC_NETWORK_USER_1,        // FUTEX_SERVER_RESP
+   STATIC_NETWORK_USER_1         // TLB_SHOOTDOWN
 };
 
 #endif
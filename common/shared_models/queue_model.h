@@ -11,7 +11,9 @@ public:
    {
       BASIC = 0,
       HISTORY_LIST,
-      HISTORY_TREE
+      HISTORY_TREE,
+      HISTORY_LIST_FAST,
+      WINDOWED
    };
 
    QueueModel(Type type);
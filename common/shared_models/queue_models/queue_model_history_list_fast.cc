@@ -0,0 +1,214 @@
+#define __STDC_LIMIT_MACROS
+#include <stdint.h>
+
+#include "simulator.h"
+#include "config.h"
+#include "queue_model_history_list_fast.h"
+#include "log.h"
+
+QueueModelHistoryListFast::QueueModelHistoryListFast(UInt64 min_processing_time)
+   : QueueModel(HISTORY_LIST_FAST)
+   , _head(0)
+   , _size(0)
+   , _min_processing_time(min_processing_time)
+   , _total_requests_using_analytical_model(0)
+{
+   try
+   {
+      _max_free_interval_list_size = Sim()->getCfg()->getInt("queue_model/history_list/max_list_size");
+      _analytical_model_enabled = Sim()->getCfg()->getBool("queue_model/history_list/analytical_model_enabled");
+      _interleaving_enabled = Sim()->getCfg()->getBool("queue_model/history_list/interleaving_enabled");
+   }
+   catch(...)
+   {
+      LOG_PRINT_ERROR("Could not read parameters from cfg");
+   }
+   LOG_ASSERT_ERROR(_max_free_interval_list_size >= 1, "queue_model/history_list/max_list_size must be >= 1");
+
+   // A request splits at most one interval in two before the oldest is dropped
+   UInt32 capacity = 1;
+   while (capacity < (_max_free_interval_list_size + 1))
+      capacity <<= 1;
+   _intervals.resize(capacity);
+   _mask = capacity - 1;
+
+   insert(0, 0, UINT64_MAX);
+   _queue_model_m_g_1 = new QueueModelMG1();
+}
+
+QueueModelHistoryListFast::~QueueModelHistoryListFast()
+{
+   delete _queue_model_m_g_1;
+}
+
+UInt64
+QueueModelHistoryListFast::computeQueueDelay(UInt64 pkt_time, UInt64 processing_time, tile_id_t requester)
+{
+   LOG_ASSERT_ERROR(_size >= 1, "Free Interval list size < 1");
+
+   UInt64 queue_delay;
+
+   // Check if it is an old packet
+   // If yes, use analytical model
+   // If not, use the history list based queue model
+   if (_analytical_model_enabled && ((pkt_time + processing_time) < at(0).start))
+   {
+      // Increment the number of requests that use the analytical model
+      _total_requests_using_analytical_model ++;
+      queue_delay = _queue_model_m_g_1->computeQueueDelay(pkt_time, processing_time, requester);
+   }
+   else
+   {
+      queue_delay = computeUsingHistoryList(pkt_time, processing_time);
+   }
+
+   _queue_model_m_g_1->updateQueue(pkt_time, processing_time, queue_delay);
+
+   // Update Utilization Counters
+   updateQueueUtilizationCounters(pkt_time, processing_time, queue_delay);
+
+   return queue_delay;
+}
+
+UInt64
+QueueModelHistoryListFast::computeUsingHistoryList(UInt64 pkt_time, UInt64 processing_time)
+{
+   LOG_ASSERT_ERROR(_size <= _max_free_interval_list_size,
+         "Free Interval list size(%u) > %u", _size, _max_free_interval_list_size);
+   UInt64 queue_delay = 0;
+
+   // The intervals that end before the packet can hold no part of it, the
+   // list scan of QueueModelHistoryList goes past them unchanged
+   UInt32 index = findFirstEndingAtOrAfter(pkt_time);
+   while (index < _size)
+   {
+      Interval interval = at(index);
+
+      if ((pkt_time >= interval.start) && ((pkt_time + processing_time) <= interval.end))
+      {
+         // No additional queue delay
+         // The interval is replaced by what is left on either side of the packet
+         bool keep_before = ((pkt_time - interval.start) >= _min_processing_time);
+         bool keep_after = ((interval.end - (pkt_time + processing_time)) >= _min_processing_time);
+         if (keep_before)
+         {
+            at(index).end = pkt_time;
+            if (keep_after)
+               insert(index + 1, pkt_time + processing_time, interval.end);
+         }
+         else if (keep_after)
+         {
+            at(index).start = pkt_time + processing_time;
+         }
+         else
+         {
+            erase(index);
+         }
+         break;
+      }
+      else if ((pkt_time < interval.start) && ((interval.start + processing_time) <= interval.end))
+      {
+         // Add additional queue delay
+         queue_delay += (interval.start - pkt_time);
+         if ((interval.end - (interval.start + processing_time)) >= _min_processing_time)
+            at(index).start = interval.start + processing_time;
+         else
+            erase(index);
+         break;
+      }
+      else if (_interleaving_enabled)
+      {
+         if ((pkt_time >= interval.start) && (pkt_time < interval.end))
+         {
+            if ((pkt_time - interval.start) >= _min_processing_time)
+            {
+               at(index).end = pkt_time;
+               index ++;
+            }
+            else
+            {
+               erase(index);
+            }
+
+            // Adjust times (as QueueModelHistoryList does)
+            pkt_time = interval.end;
+            processing_time -= (interval.end - pkt_time);
+            continue;
+         }
+         else if (pkt_time < interval.start)
+         {
+            erase(index);
+            // Add additional queue delay
+            queue_delay += (interval.start - pkt_time);
+
+            // Adjust times
+            pkt_time = interval.end;
+            processing_time -= (interval.end - interval.start);
+            continue;
+         }
+      }
+      index ++;
+   }
+
+   if (_size > _max_free_interval_list_size)
+      erase(0);
+
+   LOG_PRINT("HistoryListFast: pkt_time(%llu), processing_time(%llu), queue_delay(%llu)", pkt_time, processing_time, queue_delay);
+
+   return queue_delay;
+}
+
+UInt32
+QueueModelHistoryListFast::findFirstEndingAtOrAfter(UInt64 time)
+{
+   // The intervals are disjoint and sorted, so are their ends
+   UInt32 low = 0;
+   UInt32 high = _size;
+   while (low < high)
+   {
+      UInt32 middle = low + (high - low) / 2;
+      if (at(middle).end < time)
+         low = middle + 1;
+      else
+         high = middle;
+   }
+   return low;
+}
+
+void
+QueueModelHistoryListFast::insert(UInt32 index, UInt64 start, UInt64 end)
+{
+   LOG_ASSERT_ERROR(_size < _intervals.size(), "Free interval array full(%u)", _size);
+
+   if (index >= (_size - index))
+   {
+      for (UInt32 i = _size; i > index; i--)
+         at(i) = at(i-1);
+   }
+   else
+   {
+      _head = (_head - 1) & _mask;
+      for (UInt32 i = 0; i < index; i++)
+         at(i) = at(i+1);
+   }
+   at(index).start = start;
+   at(index).end = end;
+   _size ++;
+}
+
+void
+QueueModelHistoryListFast::erase(UInt32 index)
+{
+   if (index < (_size - 1 - index))
+   {
+      for (UInt32 i = index; i > 0; i--)
+         at(i) = at(i-1);
+      _head = (_head + 1) & _mask;
+   }
+   else
+   {
+      for (UInt32 i = index; (i + 1) < _size; i++)
+         at(i) = at(i+1);
+   }
+   _size --;
+}
@@ -0,0 +1,60 @@
+#ifndef __QUEUE_MODEL_HISTORY_LIST_FAST_H__
+#define __QUEUE_MODEL_HISTORY_LIST_FAST_H__
+
+#include <vector>
+
+#include "queue_model.h"
+#include "queue_model_m_g_1.h"
+#include "fixed_types.h"
+
+/*
+  Same model (and delays) as QueueModelHistoryList, with the free intervals
+  in a circular array sorted by time instead of a std::list. The search
+  starts at the first interval that does not end before the packet (binary
+  search), an interval is inserted or erased by moving the elements on its
+  shorter side, and the oldest one is dropped in place. Nothing is
+  allocated per request.
+ */
+class QueueModelHistoryListFast : public QueueModel
+{
+public:
+   QueueModelHistoryListFast(UInt64 min_processing_time);
+   ~QueueModelHistoryListFast();
+
+   UInt64 computeQueueDelay(UInt64 pkt_time, UInt64 processing_time, tile_id_t requester = INVALID_TILE_ID);
+   UInt64 getTotalRequestsUsingAnalyticalModel() { return _total_requests_using_analytical_model; }
+
+private:
+   struct Interval
+   {
+      UInt64 start;
+      UInt64 end;
+   };
+
+   QueueModelMG1* _queue_model_m_g_1;
+
+   // Circular array, power of 2 entries
+   std::vector<Interval> _intervals;
+   UInt32 _mask;
+   UInt32 _head;
+   UInt32 _size;
+
+   // Is analytical model used ?
+   bool _analytical_model_enabled;
+
+   UInt64 _min_processing_time;
+   UInt32 _max_free_interval_list_size;
+   bool _interleaving_enabled;
+
+   // Performance Counters
+   UInt64 _total_requests_using_analytical_model;
+
+   Interval& at(UInt32 index) { return _intervals[(_head + index) & _mask]; }
+   UInt32 findFirstEndingAtOrAfter(UInt64 time);
+   void insert(UInt32 index, UInt64 start, UInt64 end);
+   void erase(UInt32 index);
+
+   UInt64 computeUsingHistoryList(UInt64 pkt_time, UInt64 processing_time);
+};
+
+#endif /* __QUEUE_MODEL_HISTORY_LIST_FAST_H__ */
@@ -8,8 +8,6 @@
 #include "queue_model_history_tree.h"
 #include "log.h"
 
-#define PAIR(x_,y_)  (make_pair<UInt64,UInt64>(x_,y_))
-
 QueueModelHistoryTree::QueueModelHistoryTree(UInt64 min_processing_time)
    : QueueModel(HISTORY_TREE)
    , _min_processing_time(min_processing_time)
@@ -24,10 +22,11 @@ QueueModelHistoryTree::QueueModelHistoryTree(UInt64 min_processing_time)
       LOG_PRINT_ERROR("Could not read queue_model/history_tree parameters from the cfg file");
    }
   
-   allocateMemory();
+   // The last interval, up to UINT64_MAX, is never pruned
+   LOG_ASSERT_ERROR(_max_free_interval_size >= 2, "queue_model/history_tree/max_list_size must be >= 2");
 
-   IntervalTree::Node* start_node = allocateNode(PAIR(0,UINT64_MAX)); 
-   _interval_tree = new IntervalTree(start_node);
+   _interval_tree = new IntervalTree(_max_free_interval_size);
+   _interval_tree->insert(0, 0, UINT64_MAX);
    _queue_model_m_g_1 = new QueueModelMG1();
 
    _total_requests_using_analytical_model = 0;
@@ -37,7 +36,6 @@ QueueModelHistoryTree::~QueueModelHistoryTree()
 {
    delete _queue_model_m_g_1;
    delete _interval_tree;
-   releaseMemory();
 }
 
 UInt64
@@ -47,69 +45,51 @@ QueueModelHistoryTree::computeQueueDelay(UInt64 pkt_time, UInt64 processing_time
   
    UInt64 queue_delay = UINT64_MAX;
 
-   IntervalTree::Node* min_node = _interval_tree->search(PAIR(0,1));
    // Prune the Tree when it grows too large
    if (_interval_tree->size() >= ((UInt32) _max_free_interval_size))
    {
-      // Remove the node with the minimum key
-      releaseNode(_interval_tree->remove(min_node));
+      // Remove the oldest interval
+      _interval_tree->remove(0);
    }
   
-   // Check if we need to use Analytical Model - Get the min_node again 
-   min_node = _interval_tree->search(PAIR(0,1)); 
-   if ( _analytical_model_enabled && (min_node->interval.first > (pkt_time + processing_time)) )
+   // Check if we need to use Analytical Model
+   if ( _analytical_model_enabled && (_interval_tree->getStart(0) > (pkt_time + processing_time)) )
    {
       _total_requests_using_analytical_model ++;
       queue_delay = _queue_model_m_g_1->computeQueueDelay(pkt_time, processing_time, requester);
    }
    else
    {
-      IntervalTree::Node* node = _interval_tree->search(PAIR(pkt_time, pkt_time + processing_time));
-      if (!node)
-      {
-         _interval_tree->inOrderTraversal();
-         LOG_PRINT_ERROR("node = (NULL)");
-      }
+      UInt32 index = _interval_tree->search(pkt_time, processing_time);
+      UInt64 interval_start = _interval_tree->getStart(index);
+      UInt64 interval_end = _interval_tree->getEnd(index);
 
-      assert((pkt_time + processing_time) <= node->interval.second);
+      assert((pkt_time + processing_time) <= interval_end);
 
-      if (pkt_time >= node->interval.first)
+      if (pkt_time >= interval_start)
       {
          queue_delay = 0;
-         if ((pkt_time - node->interval.first) >= _min_processing_time)
+         if ((pkt_time - interval_start) >= _min_processing_time)
          {
-            if ((node->interval.second - (pkt_time + processing_time)) >= _min_processing_time)
-            {
-               IntervalTree::Node* next_node = allocateNode(PAIR(pkt_time + processing_time, node->interval.second));
-               _interval_tree->insert(next_node);
-            }
-            node->interval.second = pkt_time;
+            if ((interval_end - (pkt_time + processing_time)) >= _min_processing_time)
+               _interval_tree->insert(index + 1, pkt_time + processing_time, interval_end);
+            _interval_tree->setEnd(index, pkt_time);
          }
-         else // ((pkt_time - node->interval.first) < _min_processing_time)
+         else // ((pkt_time - interval_start) < _min_processing_time)
          {
-            if ((node->interval.second - (pkt_time + processing_time)) >= _min_processing_time)
-            {
-               node->interval.first = pkt_time + processing_time;
-               node->key = node->interval.first;
-            }
+            if ((interval_end - (pkt_time + processing_time)) >= _min_processing_time)
+               _interval_tree->setStart(index, pkt_time + processing_time);
             else
-            {
-               releaseNode(_interval_tree->remove(node));
-            }
+               _interval_tree->remove(index);
          }
       }
-      else // (pkt_time < node->interval.first)
+      else // (pkt_time < interval_start)
       {
-         queue_delay = node->interval.first - pkt_time;
-         if ((node->interval.second - (node->interval.first + processing_time)) >= _min_processing_time)
-         {
-            node->interval.first = node->interval.first + processing_time;
-            node->key = node->interval.first;
-         }
+         queue_delay = interval_start - pkt_time;
+         if ((interval_end - (interval_start + processing_time)) >= _min_processing_time)
+            _interval_tree->setStart(index, interval_start + processing_time);
          else
-         {
-            releaseNode(_interval_tree->remove(node));
-         }
+            _interval_tree->remove(index);
       }
    }
    
@@ -124,47 +104,3 @@ QueueModelHistoryTree::computeQueueDelay(UInt64 pkt_time, UInt64 processing_time
 
    return queue_delay;
 }
-
-void
-QueueModelHistoryTree::allocateMemory()
-{
-   _memory_blocks = new IntervalTree::Node[_max_free_interval_size];
-   _free_memory_block_list = new SInt32[_max_free_interval_size];
-   for (SInt32 i = 0; i < _max_free_interval_size; i++)
-      _free_memory_block_list[i] = i;
-   _free_memory_block_list_tail = _max_free_interval_size - 1;
-}
-
-void
-QueueModelHistoryTree::releaseMemory()
-{
-   delete [] _free_memory_block_list;
-   delete [] _memory_blocks;
-}
-
-IntervalTree::Node*
-QueueModelHistoryTree::allocateNode(pair<UInt64,UInt64> interval)
-{
-   LOG_ASSERT_ERROR(_free_memory_block_list_tail >= 0,
-      "_free_memory_block_list_tail(%i)", _free_memory_block_list_tail);
-   
-   SInt32 free_index = _free_memory_block_list[_free_memory_block_list_tail];
-   IntervalTree::Node* node = &_memory_blocks[free_index];
-   node->initialize(PAIR(interval.first, interval.second));
-   _free_memory_block_list_tail --;
-
-   return node;
-}
-
-void
-QueueModelHistoryTree::releaseNode(IntervalTree::Node* node)
-{
-   SInt32 index = (SInt32) (node - _memory_blocks);
-   // LOG_PRINT_WARNING("index(%i)", index);
-   assert((index >= 0) && (index < _max_free_interval_size));
-
-   _free_memory_block_list_tail ++;
-   LOG_ASSERT_ERROR(_free_memory_block_list_tail < _max_free_interval_size, \
-         "_free_memory_block_list_tail(%i)", _free_memory_block_list_tail);
-   _free_memory_block_list[_free_memory_block_list_tail] = index;
-}
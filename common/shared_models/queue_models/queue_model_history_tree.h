@@ -15,11 +15,6 @@ public:
    UInt64 getTotalRequestsUsingAnalyticalModel() { return _total_requests_using_analytical_model; }
 
 private:
-   void allocateMemory();
-   void releaseMemory();
-   IntervalTree::Node* allocateNode(pair<UInt64,UInt64> interval);
-   void releaseNode(IntervalTree::Node* node);
-
    // Private Fields
    QueueModelMG1* _queue_model_m_g_1;
    IntervalTree* _interval_tree;
@@ -29,10 +24,6 @@ private:
    
    UInt64 _min_processing_time;
    SInt32 _max_free_interval_size;
-   
-   IntervalTree::Node* _memory_blocks;
-   SInt32* _free_memory_block_list;
-   SInt32 _free_memory_block_list_tail;
 
    // Queue Counters
    UInt64 _total_requests_using_analytical_model;
@@ -0,0 +1,111 @@
+#include <cmath>
+
+#include "simulator.h"
+#include "config.h"
+#include "queue_model_windowed.h"
+#include "utils.h"
+#include "log.h"
+
+QueueModelWindowed::QueueModelWindowed(UInt64 min_processing_time)
+   : QueueModel(WINDOWED)
+   , _min_processing_time(min_processing_time)
+   , _mean_inter_arrival_time(0.0)
+   , _mean_service_time(0.0)
+   , _mean_service_time_square(0.0)
+   , _newest_arrival_time(0)
+   , _num_arrivals(0)
+   , _history_model(NULL)
+   , _total_requests_using_analytical_model(0)
+{
+   UInt32 window_size = 0;
+   std::string moving_avg_type_str;
+   try
+   {
+      window_size = Sim()->getCfg()->getInt("queue_model/windowed/window_size", 32);
+      moving_avg_type_str = Sim()->getCfg()->getString("queue_model/windowed/moving_avg_type", "arithmetic_mean");
+      _history_threshold = Sim()->getCfg()->getFloat("queue_model/windowed/history_threshold", 0.8);
+      _history_model_type = Sim()->getCfg()->getString("queue_model/windowed/history_model_type", "history_tree");
+   }
+   catch(...)
+   {
+      LOG_PRINT_ERROR("Could not read queue_model/windowed parameters from the cfg file");
+   }
+   LOG_ASSERT_ERROR(window_size >= 1, "queue_model/windowed/window_size must be >= 1");
+   LOG_ASSERT_ERROR(_history_model_type != "windowed", "queue_model/windowed/history_model_type cannot be windowed");
+
+   _inter_arrival_time = MovingAverage<double>::createAvgType(moving_avg_type_str, window_size);
+   _service_time = MovingAverage<double>::createAvgType(moving_avg_type_str, window_size);
+   _service_time_square = MovingAverage<double>::createAvgType(moving_avg_type_str, window_size);
+   LOG_ASSERT_ERROR(_inter_arrival_time && _service_time && _service_time_square,
+                    "Unrecognized queue_model/windowed/moving_avg_type(%s)", moving_avg_type_str.c_str());
+}
+
+QueueModelWindowed::~QueueModelWindowed()
+{
+   delete _history_model;
+   delete _service_time_square;
+   delete _service_time;
+   delete _inter_arrival_time;
+}
+
+UInt64
+QueueModelWindowed::computeQueueDelay(UInt64 pkt_time, UInt64 processing_time, tile_id_t requester)
+{
+   // Utilization estimated from the packets before this one
+   double utilization = 0.0;
+   if (_num_arrivals >= 2)
+   {
+      utilization = (_mean_inter_arrival_time > 0.0) ? (_mean_service_time / _mean_inter_arrival_time) : 1.0;
+      utilization = getMin<double>(utilization, 1.0);
+      if ((_history_model == NULL) && (utilization >= _history_threshold))
+      {
+         LOG_PRINT("Utilization(%g) >= Threshold(%g): Allocating a %s model",
+                   utilization, _history_threshold, _history_model_type.c_str());
+         _history_model = QueueModel::create(_history_model_type, _min_processing_time);
+      }
+   }
+
+   UInt64 queue_delay;
+   // The history model keeps track of every packet once allocated
+   UInt64 history_delay = _history_model ? _history_model->computeQueueDelay(pkt_time, processing_time, requester) : 0;
+   if (_history_model && (utilization >= _history_threshold))
+   {
+      queue_delay = history_delay;
+   }
+   else
+   {
+      _total_requests_using_analytical_model ++;
+      queue_delay = computeAnalyticalDelay(utilization);
+   }
+
+   // Update the moving averages
+   if (_num_arrivals > 0)
+   {
+      UInt64 inter_arrival_time = (pkt_time > _newest_arrival_time) ? (pkt_time - _newest_arrival_time) : 0;
+      _mean_inter_arrival_time = _inter_arrival_time->compute((double) inter_arrival_time);
+   }
+   _newest_arrival_time = getMax<UInt64>(_newest_arrival_time, pkt_time);
+   _mean_service_time = _service_time->compute((double) processing_time);
+   _mean_service_time_square = _service_time_square->compute(((double) processing_time) * processing_time);
+   _num_arrivals ++;
+
+   LOG_PRINT("Windowed: pkt_time(%llu), processing_time(%llu), utilization(%g), queue_delay(%llu)",
+             pkt_time, processing_time, utilization, queue_delay);
+
+   // Update Utilization Counters
+   updateQueueUtilizationCounters(pkt_time, processing_time, queue_delay);
+
+   return queue_delay;
+}
+
+UInt64
+QueueModelWindowed::computeAnalyticalDelay(double utilization)
+{
+   if ((utilization <= 0.0) || (_mean_service_time <= 0.0))
+      return 0;
+
+   // Pollaczek-Khinchine: W = (lambda * E[S^2]) / (2 * (1 - rho)), lambda = rho / E[S]
+   if (utilization > 0.999)
+      utilization = 0.999;
+   return (UInt64) ceil((utilization * _mean_service_time_square) / (2.0 * _mean_service_time * (1.0 - utilization)));
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+
+#include "queue_model.h"
+#include "moving_average.h"
+#include "fixed_types.h"
+
+/*
+  Analytical (M/G/1, Pollaczek-Khinchine) queue model whose arrival rate and
+  service time moments are moving averages over the last packets, so the
+  state of a port does not grow with the traffic. A history model
+  (queue_model/windowed/history_model_type) is only allocated the first
+  time the estimated utilization passes history_threshold; from then on it
+  sees every packet and gives the delays while the utilization stays above
+  the threshold.
+ */
+class QueueModelWindowed : public QueueModel
+{
+public:
+   QueueModelWindowed(UInt64 min_processing_time);
+   ~QueueModelWindowed();
+
+   UInt64 computeQueueDelay(UInt64 pkt_time, UInt64 processing_time, tile_id_t requester = INVALID_TILE_ID);
+   UInt64 getTotalRequestsUsingAnalyticalModel() { return _total_requests_using_analytical_model; }
+
+private:
+   UInt64 computeAnalyticalDelay(double utilization);
+
+   UInt64 _min_processing_time;
+
+   MovingAverage<double>* _inter_arrival_time;
+   MovingAverage<double>* _service_time;
+   MovingAverage<double>* _service_time_square;
+   double _mean_inter_arrival_time;
+   double _mean_service_time;
+   double _mean_service_time_square;
+   UInt64 _newest_arrival_time;
+   UInt64 _num_arrivals;
+
+   double _history_threshold;
+   std::string _history_model_type;
+   QueueModel* _history_model;
+
+   // Performance Counters
+   UInt64 _total_requests_using_analytical_model;
+};
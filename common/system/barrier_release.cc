@@ -0,0 +1,144 @@
+#include <cmath>
+#include <algorithm>
+
+#include "barrier_release.h"
+#include "packetize.h"
+#include "config.h"
+#include "tile.h"
+#include "log.h"
+
+BarrierRelease::Mode
+BarrierRelease::parseMode(string mode)
+{
+   if (mode == "central")
+      return CENTRAL;
+   else if (mode == "tree")
+      return TREE;
+   else if (mode == "dissemination")
+      return DISSEMINATION;
+   else
+   {
+      LOG_PRINT_ERROR("Unrecognized barrier release mode(%s)", mode.c_str());
+      return NUM_MODES;
+   }
+}
+
+void
+BarrierRelease::release(Network* network, Mode mode, const std::vector<tile_id_t>& receivers,
+                        PacketType type, const void* data, UInt32 length)
+{
+   if (mode == CENTRAL)
+   {
+      for (UInt32 i = 0; i < receivers.size(); i++)
+         releaseTile(network, receivers[i], 1, type, data, length);
+      return;
+   }
+
+   std::vector<tile_id_t> sorted_receivers = receivers;
+   std::sort(sorted_receivers.begin(), sorted_receivers.end());
+
+   ReceiverList receiver_list;
+   for (UInt32 i = 0; i < sorted_receivers.size(); i++)
+   {
+      if (receiver_list.empty() || (receiver_list.back().first != sorted_receivers[i]))
+         receiver_list.push_back(std::make_pair(sorted_receivers[i], (UInt32) 0));
+      receiver_list.back().second ++;
+   }
+
+   distribute(network, mode, receiver_list, type, data, length);
+}
+
+void
+BarrierRelease::distribute(Network* network, Mode mode, ReceiverList& receivers,
+                           PacketType type, const void* data, UInt32 length)
+{
+   if (mode == TREE)
+   {
+      // The first receiver of every row releases its row
+      SInt32 mesh_width = (SInt32) floor(sqrt((double) Config::getSingleton()->getApplicationTiles()));
+      ReceiverList::const_iterator row_begin = receivers.begin();
+      while (row_begin != receivers.end())
+      {
+         ReceiverList::const_iterator row_end = row_begin;
+         while ((row_end != receivers.end()) && ((row_end->first / mesh_width) == (row_begin->first / mesh_width)))
+            row_end ++;
+         forward(network, mode, row_begin, row_end, type, data, length);
+         row_begin = row_end;
+      }
+   }
+   else // DISSEMINATION
+   {
+      // The upper half goes to its first receiver, which does the same with it
+      while (!receivers.empty())
+      {
+         UInt32 middle = receivers.size() / 2;
+         forward(network, mode, receivers.begin() + middle, receivers.end(), type, data, length);
+         receivers.resize(middle);
+      }
+   }
+}
+
+void
+BarrierRelease::forward(Network* network, Mode mode, ReceiverList::const_iterator begin, ReceiverList::const_iterator end,
+                        PacketType type, const void* data, UInt32 length)
+{
+   UnstructuredBuffer buffer;
+   buffer << (SInt32) mode << (SInt32) type << length;
+   buffer << make_pair(data, (int) length);
+   buffer << (UInt32) (end - begin);
+   for (ReceiverList::const_iterator it = begin; it != end; it++)
+      buffer << it->first << it->second;
+
+   network->netSend(Tile::getMainCoreId(begin->first), BARRIER_RELEASE_TYPE, buffer.getBuffer(), buffer.size());
+}
+
+void
+BarrierRelease::releaseTile(Network* network, tile_id_t tile_id, UInt32 num_threads,
+                            PacketType type, const void* data, UInt32 length)
+{
+   for (UInt32 i = 0; i < num_threads; i++)
+      network->netSend(Tile::getMainCoreId(tile_id), type, data, length);
+}
+
+void
+BarrierRelease::networkCallback(void* obj, NetPacket packet)
+{
+   Network* network = (Network*) obj;
+
+   UnstructuredBuffer buffer;
+   buffer << make_pair(packet.data, packet.length);
+
+   SInt32 mode;
+   SInt32 type;
+   UInt32 length;
+   buffer >> mode >> type >> length;
+
+   Byte* data = new Byte[length];
+   buffer >> make_pair((void*) data, (int) length);
+
+   UInt32 num_receivers;
+   buffer >> num_receivers;
+   ReceiverList receivers(num_receivers);
+   for (UInt32 i = 0; i < num_receivers; i++)
+      buffer >> receivers[i].first >> receivers[i].second;
+
+   // This tile is the first receiver
+   LOG_ASSERT_ERROR(!receivers.empty() && (receivers[0].first == packet.receiver.tile_id),
+                    "Barrier release for tile(%i) forwarded to tile(%i)",
+                    receivers.empty() ? INVALID_TILE_ID : receivers[0].first, packet.receiver.tile_id);
+   releaseTile(network, receivers[0].first, receivers[0].second, (PacketType) type, data, length);
+   receivers.erase(receivers.begin());
+
+   if (mode == TREE)
+   {
+      // The rest of the row
+      for (UInt32 i = 0; i < receivers.size(); i++)
+         releaseTile(network, receivers[i].first, receivers[i].second, (PacketType) type, data, length);
+   }
+   else
+   {
+      distribute(network, (Mode) mode, receivers, (PacketType) type, data, length);
+   }
+
+   delete [] data;
+}
@@ -0,0 +1,55 @@
+#ifndef BARRIER_RELEASE_H
+#define BARRIER_RELEASE_H
+
+#include <vector>
+#include <string>
+using std::string;
+
+#include "fixed_types.h"
+#include "network.h"
+
+/*
+  Delivers the release of a barrier (the application barriers of the sync
+  servers and the lax_barrier clock skew barrier) to the threads waiting on
+  it. With 'central', the server sends one message to every thread. With
+  'tree', it sends one message to the first waiting tile of every mesh row,
+  which then releases the rest of its row. With 'dissemination', every
+  tile that gets the release passes on half of the tiles it is responsible
+  for, so the release fans out in log2(N) rounds. The forwarding is done
+  by the sim threads of the tiles, so it does not depend on their threads
+  being at the barrier.
+ */
+class BarrierRelease
+{
+public:
+   enum Mode
+   {
+      CENTRAL = 0,
+      TREE,
+      DISSEMINATION,
+      NUM_MODES
+   };
+
+   static Mode parseMode(string mode);
+
+   // Sends a 'type' packet with the 'length' bytes of 'data' to each of the
+   // 'receivers'. A tile appears once for every thread on it to release
+   static void release(Network* network, Mode mode, const std::vector<tile_id_t>& receivers,
+                       PacketType type, const void* data, UInt32 length);
+
+   // BARRIER_RELEASE_TYPE packets of the tile network 'obj'
+   static void networkCallback(void* obj, NetPacket packet);
+
+private:
+   // (tile, number of threads to release on it), sorted by tile
+   typedef std::vector< std::pair<tile_id_t, UInt32> > ReceiverList;
+
+   static void releaseTile(Network* network, tile_id_t tile_id, UInt32 num_threads,
+                           PacketType type, const void* data, UInt32 length);
+   static void distribute(Network* network, Mode mode, ReceiverList& receivers,
+                          PacketType type, const void* data, UInt32 length);
+   static void forward(Network* network, Mode mode, ReceiverList::const_iterator begin, ReceiverList::const_iterator end,
+                       PacketType type, const void* data, UInt32 length);
+};
+
+#endif // BARRIER_RELEASE_H
@@ -7,6 +7,8 @@
 #include "lax_barrier_sync_client.h"
 #include "lax_barrier_sync_server.h"
 #include "lax_p2p_sync_client.h"
+#include "lax_adaptive_sync_client.h"
+#include "lax_adaptive_sync_server.h"
 
 #include "log.h"
 
@@ -27,6 +29,8 @@ ClockSkewMinimizationObject::parseScheme(std::string scheme)
       return LAX_BARRIER;
    else if (scheme == "lax_p2p")
       return LAX_P2P;
+   else if (scheme == "lax_adaptive")
+      return LAX_ADAPTIVE;
    else
    {
       LOG_PRINT_ERROR("Unrecognized clock skew minimization scheme: %s", scheme.c_str());
@@ -50,6 +54,9 @@ ClockSkewMinimizationClient::create(std::string scheme_str, Core* core)
       case LAX_P2P:
          return new LaxP2PSyncClient(core);
 
+      case LAX_ADAPTIVE:
+         return new LaxAdaptiveSyncClient(core);
+
       default:
          LOG_PRINT_ERROR("Unrecognized scheme: %u", scheme);
          return (ClockSkewMinimizationClient*) NULL;
@@ -66,6 +73,7 @@ ClockSkewMinimizationManager::create(std::string scheme_str)
       case LAX:
       case LAX_BARRIER:
       case LAX_P2P:
+      case LAX_ADAPTIVE:
          return (ClockSkewMinimizationManager*) NULL;
 
       default:
@@ -90,6 +98,9 @@ ClockSkewMinimizationServer::create(std::string scheme_str, Network& network, Un
       case LAX_P2P:
          return (ClockSkewMinimizationServer*) NULL;
 
+      case LAX_ADAPTIVE:
+         return new LaxAdaptiveSyncServer(network, recv_buff);
+
       default:
          LOG_PRINT_ERROR("Unrecognized scheme: %u", scheme);
          return (ClockSkewMinimizationServer*) NULL;
@@ -18,6 +18,7 @@ public:
       LAX = 0,
       LAX_BARRIER,
       LAX_P2P,
+      LAX_ADAPTIVE,
       NUM_SCHEMES
    };
 
@@ -39,6 +40,9 @@ public:
    virtual void disable() = 0;
    virtual void synchronize(UInt64 cycle_count = 0) = 0;
    virtual void netProcessSyncMsg(const NetPacket& recv_pkt) = 0;
+   // A packet from another application tile was received at 'packet_time'
+   // (in cycles of this core). Called in the sim thread of the tile
+   virtual void netObservePacketTime(UInt64 packet_time) {}
 };
 
 class ClockSkewMinimizationManager : public ClockSkewMinimizationObject
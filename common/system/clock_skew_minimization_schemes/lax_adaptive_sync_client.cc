@@ -0,0 +1,68 @@
+#include <sys/time.h>
+
+#include "lax_adaptive_sync_client.h"
+#include "core.h"
+#include "core_model.h"
+#include "clock_converter.h"
+#include "packetize.h"
+#include "log.h"
+
+LaxAdaptiveSyncClient::LaxAdaptiveSyncClient(Core* core)
+   : LaxBarrierSyncClient(core, "lax_adaptive")
+   , m_max_skew(0)
+   , m_wait_start_time(0)
+   , m_last_wait_time(0)
+{
+   m_last_release_time = getWallClockTime();
+}
+
+LaxAdaptiveSyncClient::~LaxAdaptiveSyncClient()
+{}
+
+void
+LaxAdaptiveSyncClient::netObservePacketTime(UInt64 packet_time)
+{
+   UInt64 local_time = m_core->getPerformanceModel()->getCycleCount();
+   UInt64 skew = (packet_time > local_time) ? (packet_time - local_time) : (local_time - packet_time);
+   if (skew > m_max_skew)
+      m_max_skew = skew;
+}
+
+void
+LaxAdaptiveSyncClient::writeSyncInfo(UnstructuredBuffer& send_buff)
+{
+   // Skew in ns, like the local time that follows
+   UInt64 max_skew = convertCycleCount(m_max_skew, m_core->getPerformanceModel()->getFrequency(), 1.0);
+   m_max_skew = 0;
+
+   // The wait at the last barrier out of the last period
+   m_wait_start_time = getWallClockTime();
+   UInt64 run_time = m_wait_start_time - m_last_release_time;
+   double wait_fraction = ((m_last_wait_time + run_time) > 0)
+                          ? ((double) m_last_wait_time) / (m_last_wait_time + run_time)
+                          : 0.0;
+
+   send_buff << max_skew << wait_fraction;
+}
+
+void
+LaxAdaptiveSyncClient::processRelease(UnstructuredBuffer& recv_buff, UInt64 curr_time)
+{
+   m_last_release_time = getWallClockTime();
+   m_last_wait_time = m_last_release_time - m_wait_start_time;
+
+   // The barriers are no longer on multiples of the quantum
+   UInt64 next_barrier_time;
+   recv_buff >> next_barrier_time;
+   LOG_ASSERT_ERROR(next_barrier_time > curr_time, "Released at time(%llu) with the next barrier at time(%llu)",
+                    curr_time, next_barrier_time);
+   m_next_sync_time = next_barrier_time;
+}
+
+UInt64
+LaxAdaptiveSyncClient::getWallClockTime()
+{
+   timeval t;
+   gettimeofday(&t, NULL);
+   return (((UInt64) t.tv_sec) * 1000000 + t.tv_usec);
+}
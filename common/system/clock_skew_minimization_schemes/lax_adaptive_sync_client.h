@@ -0,0 +1,36 @@
+#pragma once
+
+#include "lax_barrier_sync_client.h"
+
+/*
+  Client of the lax_adaptive scheme: a lax_barrier client that also reports
+  to the server, at every barrier, the largest skew it saw between the time
+  of the packets from the other application tiles and its own clock, and
+  the fraction of host time it spent waiting at the last barrier. The server
+  sets the next barrier time from these.
+ */
+class LaxAdaptiveSyncClient : public LaxBarrierSyncClient
+{
+public:
+   LaxAdaptiveSyncClient(Core* core);
+   ~LaxAdaptiveSyncClient();
+
+   void netObservePacketTime(UInt64 packet_time);
+
+private:
+   void writeSyncInfo(UnstructuredBuffer& send_buff);
+   void processRelease(UnstructuredBuffer& recv_buff, UInt64 curr_time);
+
+   static UInt64 getWallClockTime();
+
+   // Written by the sim thread (and by the senders of the packets delivered
+   // directly, under the receive lock of the network) and reset by the app
+   // thread at the barriers: an update lost in between is only missed for
+   // one quantum
+   volatile UInt64 m_max_skew;
+
+   // In microseconds
+   UInt64 m_last_release_time;
+   UInt64 m_wait_start_time;
+   UInt64 m_last_wait_time;
+};
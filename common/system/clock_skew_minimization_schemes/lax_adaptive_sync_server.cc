@@ -0,0 +1,94 @@
+#include <algorithm>
+
+#include "lax_adaptive_sync_server.h"
+#include "lax_barrier_sync_client.h"
+#include "simulator.h"
+#include "config.h"
+#include "log.h"
+
+LaxAdaptiveSyncServer::LaxAdaptiveSyncServer(Network &network, UnstructuredBuffer &recv_buff)
+   : LaxBarrierSyncServer(network, recv_buff, "lax_adaptive")
+   , m_max_skew(0)
+   , m_total_wait_fraction(0.0)
+   , m_num_reports(0)
+   , m_num_barriers(0)
+   , m_num_grown(0)
+   , m_num_shrunk(0)
+{
+   try
+   {
+      m_min_interval = (UInt64) Sim()->getCfg()->getInt("clock_skew_minimization/lax_adaptive/min_quantum");
+      m_max_interval = (UInt64) Sim()->getCfg()->getInt("clock_skew_minimization/lax_adaptive/max_quantum");
+      m_skew_bound = (UInt64) Sim()->getCfg()->getInt("clock_skew_minimization/lax_adaptive/skew_bound");
+      m_wait_fraction_threshold = Sim()->getCfg()->getFloat("clock_skew_minimization/lax_adaptive/wait_fraction_threshold");
+      m_grow_factor = Sim()->getCfg()->getFloat("clock_skew_minimization/lax_adaptive/grow_factor");
+      m_shrink_factor = Sim()->getCfg()->getFloat("clock_skew_minimization/lax_adaptive/shrink_factor");
+   }
+   catch(...)
+   {
+      LOG_PRINT_ERROR("Error Reading 'clock_skew_minimization/lax_adaptive' parameters from the config file");
+   }
+
+   LOG_ASSERT_ERROR(m_min_interval > 0 && m_min_interval <= m_barrier_interval && m_barrier_interval <= m_max_interval,
+                    "Need 0 < min_quantum(%llu) <= quantum(%llu) <= max_quantum(%llu)",
+                    m_min_interval, m_barrier_interval, m_max_interval);
+   LOG_ASSERT_ERROR(m_grow_factor >= 1.0, "grow_factor(%f) must be >= 1", m_grow_factor);
+   LOG_ASSERT_ERROR(m_shrink_factor > 0.0 && m_shrink_factor <= 1.0, "shrink_factor(%f) must be in (0,1]", m_shrink_factor);
+}
+
+LaxAdaptiveSyncServer::~LaxAdaptiveSyncServer()
+{
+   LOG_PRINT("Barriers(%llu), Quantum Grown(%llu), Quantum Shrunk(%llu), Final Quantum(%llu)",
+             m_num_barriers, m_num_grown, m_num_shrunk, m_barrier_interval);
+}
+
+void
+LaxAdaptiveSyncServer::processSyncMsg(core_id_t core_id)
+{
+   UInt64 skew;
+   double wait_fraction;
+   m_recv_buff >> skew >> wait_fraction;
+
+   m_max_skew = std::max(m_max_skew, skew);
+   m_total_wait_fraction += wait_fraction;
+   m_num_reports ++;
+
+   barrierWait(core_id);
+}
+
+void
+LaxAdaptiveSyncServer::adaptInterval()
+{
+   m_num_barriers ++;
+
+   double wait_fraction = (m_num_reports > 0) ? (m_total_wait_fraction / m_num_reports) : 0.0;
+   UInt64 interval = m_barrier_interval;
+
+   if (m_max_skew > m_skew_bound)
+   {
+      interval = std::max(m_min_interval, (UInt64) (m_barrier_interval * m_shrink_factor));
+      if (interval < m_barrier_interval)
+         m_num_shrunk ++;
+   }
+   else if ((2 * m_max_skew <= m_skew_bound) && (wait_fraction > m_wait_fraction_threshold))
+   {
+      interval = std::min(m_max_interval, (UInt64) (m_barrier_interval * m_grow_factor));
+      if (interval > m_barrier_interval)
+         m_num_grown ++;
+   }
+
+   LOG_PRINT("Barrier(%llu): max_skew(%llu), wait_fraction(%f), quantum(%llu) -> (%llu)",
+             m_next_barrier_time, m_max_skew, wait_fraction, m_barrier_interval, interval);
+
+   m_barrier_interval = interval;
+   m_max_skew = 0;
+   m_total_wait_fraction = 0.0;
+   m_num_reports = 0;
+}
+
+void
+LaxAdaptiveSyncServer::writeRelease(UnstructuredBuffer &reply)
+{
+   LaxBarrierSyncServer::writeRelease(reply);
+   reply << m_next_barrier_time;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+
+#include "lax_barrier_sync_server.h"
+
+/*
+  Server of the lax_adaptive scheme: a lax_barrier server that sets the
+  quantum of every barrier from what the clients report. The quantum shrinks
+  (by shrink_factor) while the largest skew between the tiles is above
+  skew_bound, and grows (by grow_factor) while the skew is below half of it
+  and the tiles spend more than wait_fraction_threshold of their time
+  waiting at the barriers, within [min_quantum, max_quantum].
+ */
+class LaxAdaptiveSyncServer : public LaxBarrierSyncServer
+{
+public:
+   LaxAdaptiveSyncServer(Network &network, UnstructuredBuffer &recv_buff);
+   ~LaxAdaptiveSyncServer();
+
+   void processSyncMsg(core_id_t core_id);
+
+private:
+   void adaptInterval();
+   void writeRelease(UnstructuredBuffer &reply);
+
+   UInt64 m_min_interval;
+   UInt64 m_max_interval;
+   UInt64 m_skew_bound;
+   double m_wait_fraction_threshold;
+   double m_grow_factor;
+   double m_shrink_factor;
+
+   // Since the last barrier
+   UInt64 m_max_skew;
+   double m_total_wait_fraction;
+   UInt32 m_num_reports;
+
+   UInt64 m_num_barriers;
+   UInt64 m_num_grown;
+   UInt64 m_num_shrunk;
+};
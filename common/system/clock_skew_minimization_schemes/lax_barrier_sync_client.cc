@@ -13,16 +13,17 @@
 #include "clock_converter.h"
 #include "fxsupport.h"
 
-LaxBarrierSyncClient::LaxBarrierSyncClient(Core* core):
+LaxBarrierSyncClient::LaxBarrierSyncClient(Core* core, std::string scheme):
    m_core(core)
 {
    try
    {
-      m_barrier_interval = (UInt64) Sim()->getCfg()->getInt("clock_skew_minimization/lax_barrier/quantum"); 
+      m_barrier_interval = (UInt64) Sim()->getCfg()->getInt("clock_skew_minimization/" + scheme + "/quantum"); 
+      m_release_mode = BarrierRelease::parseMode(Sim()->getCfg()->getString("clock_skew_minimization/" + scheme + "/release", "central"));
    }
    catch(...)
    {
-      LOG_PRINT_ERROR("Error Reading 'clock_skew_minimization/barrier/quantum' from the config file");
+      LOG_PRINT_ERROR("Error Reading 'clock_skew_minimization/%s/quantum' from the config file", scheme.c_str());
    }
    m_next_sync_time = m_barrier_interval;
 }
@@ -50,15 +51,21 @@ LaxBarrierSyncClient::synchronize(UInt64 cycle_count)
       // Send 'SIM_BARRIER_WAIT' request
       int msg_type = MCP_MESSAGE_CLOCK_SKEW_MINIMIZATION;
 
-      m_send_buff << msg_type << curr_time;
+      m_send_buff << msg_type;
+      writeSyncInfo(m_send_buff);
+      m_send_buff << curr_time;
       m_core->getNetwork()->netSend(Config::getSingleton()->getMCPCoreId(), MCP_SYSTEM_TYPE, m_send_buff.getBuffer(), m_send_buff.size());
 
       LOG_PRINT("Core(%i, %i), curr_time(%llu), m_next_sync_time(%llu) sent SIM_BARRIER_WAIT", m_core->getId().tile_id, m_core->getId().core_type, curr_time, m_next_sync_time);
 
       // Receive 'BARRIER_RELEASE' response
+      // The release may be passed on by another tile
       NetPacket recv_pkt;
-      recv_pkt = m_core->getNetwork()->netRecv(Config::getSingleton()->getMCPCoreId(), m_core->getId(), MCP_SYSTEM_RESPONSE_TYPE);
-      assert(recv_pkt.length == sizeof(int));
+      if (m_release_mode == BarrierRelease::CENTRAL)
+         recv_pkt = m_core->getNetwork()->netRecv(Config::getSingleton()->getMCPCoreId(), m_core->getId(), MCP_SYSTEM_RESPONSE_TYPE);
+      else
+         recv_pkt = m_core->getNetwork()->netRecvType(MCP_SYSTEM_RESPONSE_TYPE, m_core->getId());
+      assert(recv_pkt.length >= sizeof(int));
 
       unsigned int dummy;
       m_recv_buff << make_pair(recv_pkt.data, recv_pkt.length);
@@ -67,10 +74,16 @@ LaxBarrierSyncClient::synchronize(UInt64 cycle_count)
 
       LOG_PRINT("Tile(%i) received SIM_BARRIER_RELEASE", m_core->getTile()->getId());
 
-      // Update 'm_next_sync_time'
-      m_next_sync_time = ((curr_time / m_barrier_interval) * m_barrier_interval) + m_barrier_interval;
+      processRelease(m_recv_buff, curr_time);
 
       // Delete the data buffer
       delete [] (Byte*) recv_pkt.data;
    }
 }
+
+void
+LaxBarrierSyncClient::processRelease(UnstructuredBuffer& recv_buff, UInt64 curr_time)
+{
+   // Update 'm_next_sync_time'
+   m_next_sync_time = ((curr_time / m_barrier_interval) * m_barrier_interval) + m_barrier_interval;
+}
@@ -1,25 +1,34 @@
 #pragma once
 
 #include <cassert>
+#include <string>
 
 #include "clock_skew_minimization_object.h"
 #include "fixed_types.h"
 #include "packetize.h"
+#include "barrier_release.h"
 
 // Forward Decls
 class Core;
 
 class LaxBarrierSyncClient : public ClockSkewMinimizationClient
 {
-private:
+protected:
    Core* m_core;
 
    UInt64 m_barrier_interval;
    UInt64 m_next_sync_time;
+   BarrierRelease::Mode m_release_mode;
+
+   // Fields sent to the server ahead of the local time
+   virtual void writeSyncInfo(UnstructuredBuffer& send_buff) {}
+   // The rest of the release, sets the next sync time
+   virtual void processRelease(UnstructuredBuffer& recv_buff, UInt64 curr_time);
 
 public:
-   LaxBarrierSyncClient(Core* core);
-   ~LaxBarrierSyncClient();
+   // The parameters are read from [clock_skew_minimization/<scheme>]
+   LaxBarrierSyncClient(Core* core, std::string scheme = "lax_barrier");
+   virtual ~LaxBarrierSyncClient();
 
    void enable() {}
    void disable() {}
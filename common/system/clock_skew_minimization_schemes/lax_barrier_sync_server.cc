@@ -1,3 +1,6 @@
+#include <sys/time.h>
+#include <algorithm>
+
 #include "lax_barrier_sync_client.h"
 #include "lax_barrier_sync_server.h"
 #include "simulator.h"
@@ -9,18 +12,27 @@
 #include "statistics_thread.h"
 #include "log.h"
 
-LaxBarrierSyncServer::LaxBarrierSyncServer(Network &network, UnstructuredBuffer &recv_buff):
+LaxBarrierSyncServer::LaxBarrierSyncServer(Network &network, UnstructuredBuffer &recv_buff, std::string scheme):
    m_network(network),
    m_recv_buff(recv_buff)
 {
    m_thread_manager = Sim()->getThreadManager();
    try
    {
-      m_barrier_interval = (UInt64) Sim()->getCfg()->getInt("clock_skew_minimization/lax_barrier/quantum"); 
+      m_barrier_interval = (UInt64) Sim()->getCfg()->getInt("clock_skew_minimization/" + scheme + "/quantum"); 
+      m_release_mode = BarrierRelease::parseMode(Sim()->getCfg()->getString("clock_skew_minimization/" + scheme + "/release", "central"));
    }
    catch(...)
    {
-      LOG_PRINT_ERROR("Error Reading 'clock_skew_minimization/barrier/quantum' from the config file");
+      LOG_PRINT_ERROR("Error Reading 'clock_skew_minimization/%s/quantum' from the config file", scheme.c_str());
+   }
+   try
+   {
+      m_load_report_filename = Sim()->getCfg()->getString("clock_skew_minimization/load_report_file", "");
+   }
+   catch(...)
+   {
+      LOG_PRINT_ERROR("Error Reading 'clock_skew_minimization/load_report_file' from the config file");
    }
 
    m_next_barrier_time = m_barrier_interval;
@@ -33,10 +45,24 @@ LaxBarrierSyncServer::LaxBarrierSyncServer(Network &network, UnstructuredBuffer
       m_local_clock_list[i] = 0;
       m_barrier_acquire_list[i] = false;
    }
+
+   m_num_quanta = 0;
+   if (m_load_report_filename != "")
+   {
+      UInt32 num_processes = Config::getSingleton()->getProcessCount();
+      m_release_host_time = getHostTime();
+      m_tile_busy_time.resize(m_num_application_tiles, 0);
+      m_quantum_busy_time.resize(m_num_application_tiles, 0);
+      m_process_wait_time.resize(num_processes, 0);
+      m_process_num_bottlenecks.resize(num_processes, 0);
+   }
 }
 
 LaxBarrierSyncServer::~LaxBarrierSyncServer()
-{}
+{
+   if (m_load_report_filename != "")
+      writeLoadReport();
+}
 
 void
 LaxBarrierSyncServer::processSyncMsg(core_id_t core_id)
@@ -67,9 +93,10 @@ LaxBarrierSyncServer::barrierWait(core_id_t core_id)
    {
       LOG_PRINT("Sent 'SIM_BARRIER_RELEASE' immediately time(%llu), m_next_barrier_time(%llu)", time, m_next_barrier_time);
       // LOG_PRINT_WARNING("tile_id(%i), local_clock(%llu), m_next_barrier_time(%llu), m_barrier_interval(%llu)", tile_id, time, m_next_barrier_time, m_barrier_interval);
-      unsigned int reply = LaxBarrierSyncClient::BARRIER_RELEASE;
+      UnstructuredBuffer reply;
+      writeRelease(reply);
 
-      m_network.netSend(core_id, MCP_SYSTEM_RESPONSE_TYPE, (char*) &reply, sizeof(reply));
+      m_network.netSend(core_id, MCP_SYSTEM_RESPONSE_TYPE, reply.getBuffer(), reply.size());
       return;
    }
 
@@ -77,6 +104,8 @@ LaxBarrierSyncServer::barrierWait(core_id_t core_id)
    {
       m_local_clock_list[core_id.tile_id] = time;
       m_barrier_acquire_list[core_id.tile_id] = true;
+      if (m_load_report_filename != "")
+         m_quantum_busy_time[core_id.tile_id] = getHostTime() - m_release_host_time;
    }
    else
       LOG_ASSERT_ERROR(false, "Invalid core type!");
@@ -127,6 +156,11 @@ LaxBarrierSyncServer::barrierRelease()
    // time till a thread can be resumed. Then only, will we have 
    // forward progress
 
+   adaptInterval();
+   if (m_load_report_filename != "")
+      updateLoad();
+
+   std::vector<tile_id_t> released_tiles;
    bool thread_resumed = false;
    while (!thread_resumed)
    {
@@ -142,9 +176,7 @@ LaxBarrierSyncServer::barrierRelease()
             {
                LOG_ASSERT_ERROR(m_thread_manager->isCoreRunning(tile_id) != INVALID_THREAD_ID || m_thread_manager->isCoreInitializing(tile_id) != INVALID_THREAD_ID, "(%i) has acquired barrier, local_clock(%i), m_next_barrier_time(%llu), but not initializing or running", tile_id, m_local_clock_list[tile_id], m_next_barrier_time);
 
-               unsigned int reply = LaxBarrierSyncClient::BARRIER_RELEASE;
-
-               m_network.netSend(Tile::getMainCoreId(tile_id), MCP_SYSTEM_RESPONSE_TYPE, (char*) &reply, sizeof(reply));
+               released_tiles.push_back(tile_id);
 
                m_barrier_acquire_list[tile_id] = false;
 
@@ -154,7 +186,79 @@ LaxBarrierSyncServer::barrierRelease()
       }
    }
 
+   UnstructuredBuffer reply;
+   writeRelease(reply);
+   BarrierRelease::release(&m_network, m_release_mode, released_tiles, MCP_SYSTEM_RESPONSE_TYPE, reply.getBuffer(), reply.size());
+
    // Notify Statistics thread about the global time
    if (Sim()->getStatisticsThread())
       Sim()->getStatisticsThread()->notify(m_next_barrier_time);
 }
+
+void
+LaxBarrierSyncServer::writeRelease(UnstructuredBuffer &reply)
+{
+   unsigned int release = LaxBarrierSyncClient::BARRIER_RELEASE;
+   reply << release;
+}
+
+void
+LaxBarrierSyncServer::updateLoad()
+{
+   // A process is busy until the last of its tiles arrives; the tiles that
+   // did not run in the quantum count for nothing
+   UInt64 now = getHostTime();
+   std::vector<UInt64> process_busy_time(m_process_wait_time.size(), 0);
+   for (tile_id_t tile_id = 0; tile_id < (tile_id_t) m_num_application_tiles; tile_id++)
+   {
+      UInt32 process_num = Config::getSingleton()->getProcessNumForTile(tile_id);
+      m_tile_busy_time[tile_id] += m_quantum_busy_time[tile_id];
+      process_busy_time[process_num] = std::max(process_busy_time[process_num], m_quantum_busy_time[tile_id]);
+      m_quantum_busy_time[tile_id] = 0;
+   }
+
+   UInt64 quantum_time = now - m_release_host_time;
+   UInt32 bottleneck = std::max_element(process_busy_time.begin(), process_busy_time.end()) - process_busy_time.begin();
+   m_process_num_bottlenecks[bottleneck] ++;
+   for (UInt32 i = 0; i < m_process_wait_time.size(); i++)
+      m_process_wait_time[i] += quantum_time - std::min(quantum_time, process_busy_time[i]);
+
+   m_num_quanta ++;
+   m_release_host_time = now;
+}
+
+void
+LaxBarrierSyncServer::writeLoadReport()
+{
+   std::string filename = Config::getSingleton()->formatOutputFileName(m_load_report_filename);
+   FILE* file = fopen(filename.c_str(), "w");
+   if (!file)
+   {
+      LOG_PRINT_WARNING("Could not open the load report file(%s)", filename.c_str());
+      return;
+   }
+
+   fprintf(file, "# Host time (in us) simulated by every tile and waited by every process at the barriers, %llu quanta\n",
+           (unsigned long long) m_num_quanta);
+   fprintf(file, "# tile <tile_id> <process> <busy_time>\n");
+   for (tile_id_t tile_id = 0; tile_id < (tile_id_t) m_num_application_tiles; tile_id++)
+   {
+      fprintf(file, "tile %i %u %llu\n", tile_id, Config::getSingleton()->getProcessNumForTile(tile_id),
+              (unsigned long long) m_tile_busy_time[tile_id]);
+   }
+   fprintf(file, "# process <process> <wait_time> <quanta_as_bottleneck>\n");
+   for (UInt32 i = 0; i < m_process_wait_time.size(); i++)
+   {
+      fprintf(file, "process %u %llu %llu\n", i, (unsigned long long) m_process_wait_time[i],
+              (unsigned long long) m_process_num_bottlenecks[i]);
+   }
+   fclose(file);
+}
+
+UInt64
+LaxBarrierSyncServer::getHostTime()
+{
+   timeval t;
+   gettimeofday(&t, NULL);
+   return (((UInt64) t.tv_sec) * 1000000 + t.tv_usec);
+}
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <vector>
+#include <string>
 
+#include "clock_skew_minimization_object.h"
 #include "fixed_types.h"
 #include "packetize.h"
+#include "barrier_release.h"
 
 // Forward Decls
 class ThreadManager;
@@ -11,21 +14,44 @@ class Network;
 
 class LaxBarrierSyncServer : public ClockSkewMinimizationServer
 {
-private:
+protected:
    Network &m_network;
    UnstructuredBuffer &m_recv_buff;
    ThreadManager* m_thread_manager;
 
    UInt64 m_barrier_interval;
+   BarrierRelease::Mode m_release_mode;
    UInt64 m_next_barrier_time;
    std::vector<UInt64> m_local_clock_list;
    std::vector<bool> m_barrier_acquire_list;
    
    UInt32 m_num_application_tiles;
 
+   // Load report ([clock_skew_minimization] load_report_file): the host
+   // time (in us) each tile simulates between the release of a barrier and
+   // its arrival at the next one, and the time each process then waits for
+   // the slowest one
+   std::string m_load_report_filename;
+   UInt64 m_release_host_time;
+   std::vector<UInt64> m_tile_busy_time;
+   std::vector<UInt64> m_quantum_busy_time;
+   std::vector<UInt64> m_process_wait_time;
+   std::vector<UInt64> m_process_num_bottlenecks;
+   UInt64 m_num_quanta;
+
+   void updateLoad();
+   void writeLoadReport();
+   static UInt64 getHostTime();
+
+   // The barrier is reached, before the next barrier time is advanced
+   virtual void adaptInterval() {}
+   // The release sent to the tiles
+   virtual void writeRelease(UnstructuredBuffer &reply);
+
 public:
-   LaxBarrierSyncServer(Network &network, UnstructuredBuffer &recv_buff);
-   ~LaxBarrierSyncServer();
+   // The parameters are read from [clock_skew_minimization/<scheme>]
+   LaxBarrierSyncServer(Network &network, UnstructuredBuffer &recv_buff, std::string scheme = "lax_barrier");
+   virtual ~LaxBarrierSyncServer();
 
    void processSyncMsg(core_id_t core_id);
    void signal();
@@ -16,22 +16,29 @@ LaxP2PSyncClient::LaxP2PSyncClient(Core* core):
    _last_sync_time(0),
    _quantum(0),
    _slack(0),
-   _sleep_fraction(0.0)
+   _sleep_fraction(0.0),
+   _ack_mailbox(2),
+   _max_wait_time(0)
 {
    LOG_ASSERT_ERROR(Sim()->getConfig()->getApplicationTiles() >= 3, 
          "Number of Cores must be >= 3 if 'random_pairs' scheme is used");
 
+   std::string peer_selection;
    try
    {
       _slack = (UInt64) Sim()->getCfg()->getInt("clock_skew_minimization/lax_p2p/slack");
       _quantum = (UInt64) Sim()->getCfg()->getInt("clock_skew_minimization/lax_p2p/quantum");
       _sleep_fraction = Sim()->getCfg()->getFloat("clock_skew_minimization/lax_p2p/sleep_fraction");
+      peer_selection = Sim()->getCfg()->getString("clock_skew_minimization/lax_p2p/peer_selection", "random");
    }
    catch(...)
    {
       LOG_PRINT_ERROR("Could not read clock_skew_minimization/random_pairs variables from config file");
    }
 
+   _peer_selection = parsePeerSelection(peer_selection);
+   _last_num_packets_sent.resize(Config::getSingleton()->getApplicationTiles(), 0);
+
    gettimeofday(&_start_wall_clock_time, NULL);
    _rand_num.seed(1);
 
@@ -44,6 +51,20 @@ LaxP2PSyncClient::~LaxP2PSyncClient()
    _core->getNetwork()->unregisterCallback(CLOCK_SKEW_MINIMIZATION);
 }
 
+LaxP2PSyncClient::PeerSelection
+LaxP2PSyncClient::parsePeerSelection(std::string peer_selection)
+{
+   if (peer_selection == "random")
+      return RANDOM;
+   else if (peer_selection == "communication")
+      return COMMUNICATION;
+   else
+   {
+      LOG_PRINT_ERROR("Unrecognized lax_p2p peer selection(%s)", peer_selection.c_str());
+      return NUM_PEER_SELECTIONS;
+   }
+}
+
 void 
 LaxP2PSyncClient::enable()
 {
@@ -51,7 +72,7 @@ LaxP2PSyncClient::enable()
   
    assert(_last_sync_time == 0); 
    gettimeofday(&_start_wall_clock_time, NULL);
-   assert(_msg_queue.empty());
+   assert(_ack_mailbox.empty());
 }
 
 void
@@ -80,13 +101,13 @@ LaxP2PSyncClient::netProcessSyncMsg(const NetPacket& recv_pkt)
          "SyncMsg[sender(%i, %i), msg_type(%u), time(%llu)]",
          recv_pkt.sender.tile_id, recv_pkt.sender.core_type, msg_type, time);
 
-   _lock.acquire();
-
    // SyncMsg
    //  - sender
    //  - type (REQ,ACK,WAIT)
    //  - time
    // Called by the Network thread
+   // The state is read without a lock: a WAIT generated as the tile goes to
+   // sleep is only used at its next synchronization
    Core::State core_state = _core->getState();
    if (core_state == Core::RUNNING)
    {
@@ -100,8 +121,12 @@ LaxP2PSyncClient::netProcessSyncMsg(const NetPacket& recv_pkt)
       else if (sync_msg.type == SyncMsg::ACK)
       {
          // sync_msg.type == SyncMsg::ACK with '0' or non-zero wait time
-         _msg_queue.push_back(sync_msg);
+         __attribute__((unused)) bool pushed = _ack_mailbox.tryPush(sync_msg);
+         LOG_ASSERT_ERROR(pushed, "Tile(%i) received an ACK with one already pending", _core->getTileId());
+
+         _lock.acquire();
          _cond.signal();
+         _lock.release();
       }
       else
       {
@@ -127,8 +152,6 @@ LaxP2PSyncClient::netProcessSyncMsg(const NetPacket& recv_pkt)
       send_buf << (UInt32) SyncMsg::ACK << (UInt64) 0;
       _core->getNetwork()->netSend(sync_msg.sender, CLOCK_SKEW_MINIMIZATION, send_buf.getBuffer(), send_buf.size());
    }
-
-   _lock.release();
 }
 
 void
@@ -165,8 +188,7 @@ LaxP2PSyncClient::processSyncReq(const SyncMsg& sync_msg, bool sleeping)
                "[>]: curr_time(%llu), sync_msg[sender(%i, %i), msg_type(%u), time(%llu)]", 
                curr_time, sync_msg.sender.tile_id, sync_msg.sender.core_type, sync_msg.type, sync_msg.time);
 
-         SyncMsg wait_msg(_core->getId(), SyncMsg::WAIT, curr_time - sync_msg.time);
-         _msg_queue.push_back(wait_msg);
+         addWait(curr_time - sync_msg.time);
       }
    }
    else if ((curr_time <= (sync_msg.time + _slack)) && (curr_time >= (sync_msg.time - _slack)))
@@ -221,38 +243,37 @@ LaxP2PSyncClient::synchronize(UInt64 cycle_count)
       LOG_PRINT("Tile(%i): Starting Synchronization: curr_time(%llu), _last_sync_time(%llu)",
             _core->getTileId(), curr_time, _last_sync_time);
 
-      _lock.acquire();
-
       _last_sync_time = (curr_time / _quantum) * _quantum;
 
       LOG_ASSERT_ERROR(_last_sync_time < MAX_TIME,
             "_last_sync_time(%llu)", _last_sync_time);
 
       // Send SyncMsg to another tile
-      sendRandomSyncMsg(curr_time);
+      sendSyncMsg(curr_time);
 
-      // Wait for Acknowledgement and other Wait messages
-      _cond.wait(_lock);
+      // Wait for Acknowledgement
+      SyncMsg ack;
+      _lock.acquire();
+      while (!_ack_mailbox.tryPop(ack))
+         _cond.wait(_lock);
+      _lock.release();
 
-      UInt64 wait_time = userProcessSyncMsgList();
+      UInt64 wait_time = userProcessSyncMsg(ack);
 
       LOG_PRINT("Wait Time (%llu)", wait_time);
 
       gotoSleep(wait_time);
-      
-      _lock.release();
 
    }
 }
 
 void
-LaxP2PSyncClient::sendRandomSyncMsg(UInt64 curr_time)
+LaxP2PSyncClient::sendSyncMsg(UInt64 curr_time)
 {
    LOG_ASSERT_ERROR(curr_time < MAX_TIME, "curr_time(%llu)", curr_time);
 
    UInt32 num_app_cores = Config::getSingleton()->getApplicationTiles();
-   SInt32 offset = 1 + (SInt32) _rand_num.next((Random::value_t) ((num_app_cores - 1) / 2));
-   tile_id_t receiver = (_core->getTileId() + offset) % num_app_cores;
+   tile_id_t receiver = selectPeer();
 
    LOG_ASSERT_ERROR((receiver >= 0) && (receiver < (tile_id_t) num_app_cores), 
          "receiver(%i)", receiver);
@@ -265,34 +286,68 @@ LaxP2PSyncClient::sendRandomSyncMsg(UInt64 curr_time)
    _core->getNetwork()->netSend(Tile::getMainCoreId(receiver), CLOCK_SKEW_MINIMIZATION, send_buf.getBuffer(), send_buf.size());
 }
 
-UInt64
-LaxP2PSyncClient::userProcessSyncMsgList()
+tile_id_t
+LaxP2PSyncClient::selectPeer()
 {
-   bool ack_present = false;
-   UInt64 max_wait_time = 0;
+   UInt32 num_app_cores = Config::getSingleton()->getApplicationTiles();
 
-   std::list<SyncMsg>::iterator it;
-   for (it = _msg_queue.begin(); it != _msg_queue.end(); it++)
+   if (_peer_selection == COMMUNICATION)
    {
-      LOG_PRINT("Tile(%i) Process Sync Msg List: SyncMsg[sender(%i), type(%u), wait_time(%llu)]", 
-            _core->getTileId(), (*it).sender, (*it).type, (*it).time);
-      
-      LOG_ASSERT_ERROR((*it).time < MAX_TIME,
-            "sync_msg[sender(%i), msg_type(%u), time(%llu)]",
-            (*it).sender, (*it).type, (*it).time);
-
-      assert(((*it).type == SyncMsg::WAIT) || ((*it).type == SyncMsg::ACK));
+      // The tile this one sent the most packets to since the last synchronization.
+      // Tiles that do not communicate do not need to be kept close
+      tile_id_t peer = INVALID_TILE_ID;
+      UInt64 max_num_packets = 0;
+      for (tile_id_t tile_id = 0; tile_id < (tile_id_t) num_app_cores; tile_id++)
+      {
+         UInt64 num_packets_sent = _core->getNetwork()->getNumPacketsSentTo(tile_id);
+         UInt64 num_packets = num_packets_sent - _last_num_packets_sent[tile_id];
+         _last_num_packets_sent[tile_id] = num_packets_sent;
+
+         if ((tile_id != _core->getTileId()) && (num_packets > max_num_packets))
+         {
+            peer = tile_id;
+            max_num_packets = num_packets;
+         }
+      }
 
-      if ((*it).time >= max_wait_time)
-         max_wait_time = (*it).time;
-      if ((*it).type == SyncMsg::ACK)
-         ack_present = true;
+      if (peer != INVALID_TILE_ID)
+         return peer;
+      // No communication: pick a random tile
    }
+
+   SInt32 offset = 1 + (SInt32) _rand_num.next((Random::value_t) ((num_app_cores - 1) / 2));
+   return (_core->getTileId() + offset) % num_app_cores;
+}
+
+UInt64
+LaxP2PSyncClient::userProcessSyncMsg(const SyncMsg& ack)
+{
+   LOG_PRINT("Tile(%i) Process Sync Msg: SyncMsg[sender(%i), type(%u), wait_time(%llu)]", 
+         _core->getTileId(), ack.sender, ack.type, ack.time);
    
-   assert(ack_present);
-   _msg_queue.clear();
+   LOG_ASSERT_ERROR(ack.time < MAX_TIME,
+         "sync_msg[sender(%i), msg_type(%u), time(%llu)]",
+         ack.sender, ack.type, ack.time);
+
+   assert(ack.type == SyncMsg::ACK);
+
+   // Take the WAITs generated since the last synchronization
+   UInt64 max_wait_time = __sync_lock_test_and_set(&_max_wait_time, 0);
 
-   return max_wait_time;
+   return (ack.time > max_wait_time) ? ack.time : max_wait_time;
+}
+
+void
+LaxP2PSyncClient::addWait(UInt64 wait_time)
+{
+   UInt64 max_wait_time = _max_wait_time;
+   while (wait_time > max_wait_time)
+   {
+      UInt64 prev_wait_time = __sync_val_compare_and_swap(&_max_wait_time, max_wait_time, wait_time);
+      if (prev_wait_time == max_wait_time)
+         break;
+      max_wait_time = prev_wait_time;
+   }
 }
 
 void
@@ -324,12 +379,8 @@ LaxP2PSyncClient::gotoSleep(const UInt64 sleep_time)
          sleep_wall_clock_time = 1000000;
       }
      
-      _lock.release();
-
       assert(usleep(sleep_wall_clock_time) == 0);
 
-      _lock.acquire();
-
       // Set the CoreState to 'RUNNING'
       _core->setState(Core::RUNNING);
       
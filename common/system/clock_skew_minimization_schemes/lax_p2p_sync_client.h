@@ -1,13 +1,14 @@
 #pragma once
 
 #include <sys/time.h>
-#include <list>
+#include <vector>
 
 #include "clock_skew_minimization_object.h"
 #include "tile.h"
 #include "lock.h"
 #include "cond.h"
 #include "random.h"
+#include "spsc_ring.h"
 #include "fixed_types.h"
 
 class LaxP2PSyncClient : public ClockSkewMinimizationClient
@@ -29,6 +30,7 @@ public:
       MsgType type;
       UInt64 time;
    
+      SyncMsg() {}
       SyncMsg(core_id_t sender, MsgType type, UInt64 time)
       {
          this->sender = sender;
@@ -49,23 +51,42 @@ private:
 
    struct timeval _start_wall_clock_time;
 
-   std::list<SyncMsg> _msg_queue;
+   enum PeerSelection
+   {
+      RANDOM = 0,
+      COMMUNICATION,
+      NUM_PEER_SELECTIONS
+   };
+
+   // The ACK of the SyncReq of the user thread, pushed by the network
+   // thread. The lock is only taken to wait for it
+   SPSCRing<SyncMsg> _ack_mailbox;
    Lock _lock;
    ConditionVariable _cond;
+   // The longest WAIT since the last synchronization
+   volatile UInt64 _max_wait_time;
+
+   PeerSelection _peer_selection;
    Random _rand_num;
+   // The packets sent to each application tile at the last synchronization
+   std::vector<UInt64> _last_num_packets_sent;
 
    bool _enabled;
 
    static UInt64 MAX_TIME;
 
+   static PeerSelection parsePeerSelection(std::string peer_selection);
+
    // Called by user thread
-   UInt64 userProcessSyncMsgList(void);
-   void sendRandomSyncMsg(UInt64 curr_time);
+   UInt64 userProcessSyncMsg(const SyncMsg& ack);
+   void sendSyncMsg(UInt64 curr_time);
+   tile_id_t selectPeer(void);
    void gotoSleep(const UInt64 sleep_time);
    UInt64 getElapsedWallClockTime(void);
   
    // Called by network thread 
    void processSyncReq(const SyncMsg& sync_msg, bool sleeping);
+   void addWait(UInt64 wait_time);
    
 
 public:
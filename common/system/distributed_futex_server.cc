@@ -0,0 +1,369 @@
+#include <linux/futex.h>
+#include <errno.h>
+#include <vector>
+#include <algorithm>
+
+#include "distributed_futex_server.h"
+#include "message_types.h"
+#include "simulator.h"
+#include "thread_manager.h"
+#include "config.h"
+#include "tile.h"
+#include "core.h"
+#include "log.h"
+
+DistributedFutexServer::DistributedFutexServer(Tile* tile)
+   : m_network(tile->getNetwork())
+{
+   // The futex words are read and updated in the address space of the
+   // application, and the waiters are stalled and resumed in the thread
+   // manager of the master process
+   LOG_ASSERT_ERROR(Config::getSingleton()->getSimulationMode() == Config::LITE,
+                    "Distributed futex servers only work in lite mode");
+   LOG_ASSERT_ERROR(Config::getSingleton()->getProcessCount() == 1,
+                    "Distributed futex servers only work with a single process");
+
+   m_network->registerCallback(FUTEX_SERVER_REQUEST_TYPE, networkCallback, this);
+}
+
+DistributedFutexServer::~DistributedFutexServer()
+{
+   m_network->unregisterCallback(FUTEX_SERVER_REQUEST_TYPE);
+
+   for (FutexMap::iterator it = m_futexes.begin(); it != m_futexes.end(); it++)
+   {
+      while (!it->second.empty())
+      {
+         LOG_PRINT_WARNING("Core (%i,%i) still waiting on futex(%#lx) at end of simulation",
+                           it->second.front().core_id.tile_id, it->second.front().core_id.core_type, it->first);
+         it->second.pop();
+      }
+   }
+}
+
+bool
+DistributedFutexServer::isEnabled()
+{
+   try
+   {
+      return Sim()->getCfg()->getBool("sync_server/distributed_futexes", false);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read sync_server/distributed_futexes from the cfg file");
+      return false;
+   }
+}
+
+core_id_t
+DistributedFutexServer::getHome(IntPtr address)
+{
+   // The futex words are 4 bytes apart at best, and the ones of the
+   // objects of an array often a few cache lines apart
+   UInt64 word = ((UInt64) address) >> 2;
+   word ^= (word >> 7) ^ (word >> 17);
+   return Tile::getMainCoreId((tile_id_t) (word % Config::getSingleton()->getApplicationTiles()));
+}
+
+void
+DistributedFutexServer::networkCallback(void* obj, NetPacket packet)
+{
+   DistributedFutexServer* futex_server = (DistributedFutexServer*) obj;
+   futex_server->processPacket(packet);
+}
+
+void
+DistributedFutexServer::processPacket(NetPacket& packet)
+{
+   // The packet data belongs to the network
+   m_recv_buffer.clear();
+   m_recv_buffer << make_pair(packet.data, packet.length);
+
+   int msg_type;
+   m_recv_buffer >> msg_type;
+
+   switch (msg_type)
+   {
+   case MCP_MESSAGE_FUTEX:
+      {
+         int *addr1;
+         int op;
+         int val1;
+         void *timeout;
+         int *addr2;
+         int val3;
+
+         m_recv_buffer >> addr1 >> op >> val1 >> timeout >> addr2 >> val3;
+
+         LOG_PRINT("Futex: requester(%i,%i), addr1(%p), op(%#x), val1(%i), timeout(%p), addr2(%p), val3(%i), time(%llu)",
+                   packet.sender.tile_id, packet.sender.core_type, addr1, op, val1, timeout, addr2, val3, packet.time);
+
+         // The time-outs are not modeled, the val2 argument is passed in place of it
+         int val2 = (long int) timeout;
+         switch (op & ~FUTEX_PRIVATE_FLAG)
+         {
+         case FUTEX_WAIT:
+            LOG_ASSERT_ERROR(timeout == NULL, "timeout = %p", timeout);
+            futexWait(packet.sender, addr1, val1, packet.time);
+            break;
+         case FUTEX_WAKE:
+            futexWake(packet.sender, addr1, val1, packet.time);
+            break;
+         case FUTEX_WAKE_OP:
+            futexWakeOp(packet.sender, addr1, val1, val2, addr2, val3, packet.time);
+            break;
+         case FUTEX_CMP_REQUEUE:
+            futexCmpRequeue(packet.sender, addr1, val1, val2, addr2, val3, packet.time);
+            break;
+         default:
+            LOG_PRINT_ERROR("Futex syscall: Unhandled op(%#x)", op);
+            break;
+         }
+      }
+      break;
+
+   case MCP_MESSAGE_FUTEX_WAKE_FORWARD:
+      wakeForward(packet);
+      break;
+
+   case MCP_MESSAGE_FUTEX_REQUEUE_FORWARD:
+      requeueForward(packet);
+      break;
+
+   default:
+      LOG_PRINT_ERROR("Unhandled futex server message type: %i from %i", msg_type, packet.sender.tile_id);
+   }
+}
+
+void
+DistributedFutexServer::futexWait(core_id_t requester, int* addr, int val, UInt64 time)
+{
+   int curr_val = *((volatile int*) addr);
+   if (curr_val != val)
+   {
+      sendResponse(requester, -(int) EWOULDBLOCK, time);
+      return;
+   }
+
+   Sim()->getThreadManager()->stallThread(requester);
+   m_futexes[(IntPtr) addr].push(Waiter(requester, time));
+}
+
+void
+DistributedFutexServer::futexWake(core_id_t requester, int* addr, int val, UInt64 time)
+{
+   int num_procs_woken_up = wakeWaiters(addr, val, time);
+   sendResponse(requester, num_procs_woken_up, time);
+}
+
+void
+DistributedFutexServer::futexWakeOp(core_id_t requester, int* addr1, int val1, int val2, int* addr2, int val3, UInt64 time)
+{
+   int OP = (val3 >> 28) & 0xf;
+   int CMP = (val3 >> 24) & 0xf;
+   int OPARG = (val3 >> 12) & 0xfff;
+   int CMPARG = (val3) & 0xfff;
+
+   if (OP & FUTEX_OP_OPARG_SHIFT)
+   {
+      OPARG = 1 << OPARG;
+      OP &= ~FUTEX_OP_OPARG_SHIFT;
+   }
+
+   // The word may be updated by the application at the same time
+   int oldval;
+   int newval;
+   do
+   {
+      oldval = *((volatile int*) addr2);
+      switch (OP)
+      {
+      case FUTEX_OP_SET:
+         newval = OPARG;
+         break;
+      case FUTEX_OP_ADD:
+         newval = oldval + OPARG;
+         break;
+      case FUTEX_OP_OR:
+         newval = oldval | OPARG;
+         break;
+      case FUTEX_OP_ANDN:
+         newval = oldval & (~OPARG);
+         break;
+      case FUTEX_OP_XOR:
+         newval = oldval ^ OPARG;
+         break;
+      default:
+         LOG_PRINT_ERROR("Futex syscall: FUTEX_WAKE_OP: Unhandled OP(%i)", OP);
+         newval = oldval;
+         break;
+      }
+   } while (__sync_val_compare_and_swap(addr2, oldval, newval) != oldval);
+
+   int num_procs_woken_up = wakeWaiters(addr1, val1, time);
+
+   bool condition = false;
+   switch (CMP)
+   {
+   case FUTEX_OP_CMP_EQ:
+      condition = (oldval == CMPARG);
+      break;
+   case FUTEX_OP_CMP_NE:
+      condition = (oldval != CMPARG);
+      break;
+   case FUTEX_OP_CMP_LT:
+      condition = (oldval < CMPARG);
+      break;
+   case FUTEX_OP_CMP_LE:
+      condition = (oldval <= CMPARG);
+      break;
+   case FUTEX_OP_CMP_GT:
+      condition = (oldval > CMPARG);
+      break;
+   case FUTEX_OP_CMP_GE:
+      condition = (oldval >= CMPARG);
+      break;
+   default:
+      LOG_PRINT_ERROR("Futex syscall: FUTEX_WAKE_OP: Unhandled CMP(%i)", CMP);
+      break;
+   }
+
+   core_id_t home = getHome((IntPtr) addr2);
+   if (!condition)
+   {
+      sendResponse(requester, num_procs_woken_up, time);
+   }
+   else if (home.tile_id == m_network->getTile()->getId())
+   {
+      num_procs_woken_up += wakeWaiters(addr2, val2, time);
+      sendResponse(requester, num_procs_woken_up, time);
+   }
+   else
+   {
+      // The home of the second word wakes its waiters and replies
+      int msg_type = MCP_MESSAGE_FUTEX_WAKE_FORWARD;
+      m_send_buffer.clear();
+      m_send_buffer << msg_type << requester << addr2 << val2 << num_procs_woken_up;
+
+      NetPacket packet(time, FUTEX_SERVER_REQUEST_TYPE, m_network->getTile()->getCore()->getId(),
+                       home, m_send_buffer.size(), m_send_buffer.getBuffer());
+      m_network->netSend(packet);
+   }
+}
+
+void
+DistributedFutexServer::futexCmpRequeue(core_id_t requester, int* addr1, int val1, int val2, int* addr2, int val3, UInt64 time)
+{
+   int curr_val = *((volatile int*) addr1);
+   if (curr_val != val3)
+   {
+      sendResponse(requester, -(int) EWOULDBLOCK, time);
+      return;
+   }
+
+   int num_procs_woken_up_or_requeued = wakeWaiters(addr1, val1, time);
+
+   // The requeued waiters stay stalled
+   WaiterQueue& waiters = m_futexes[(IntPtr) addr1];
+   std::vector<Waiter> requeued_waiters;
+   while (!waiters.empty() && ((SInt32) requeued_waiters.size() < val2))
+   {
+      requeued_waiters.push_back(waiters.front());
+      waiters.pop();
+   }
+   if (waiters.empty())
+      m_futexes.erase((IntPtr) addr1);
+   num_procs_woken_up_or_requeued += requeued_waiters.size();
+
+   core_id_t home = getHome((IntPtr) addr2);
+   if (home.tile_id == m_network->getTile()->getId())
+   {
+      WaiterQueue& requeue_waiters = m_futexes[(IntPtr) addr2];
+      for (UInt32 i = 0; i < requeued_waiters.size(); i++)
+         requeue_waiters.push(requeued_waiters[i]);
+      sendResponse(requester, num_procs_woken_up_or_requeued, time);
+   }
+   else
+   {
+      // The home of the second word queues the waiters and replies
+      int msg_type = MCP_MESSAGE_FUTEX_REQUEUE_FORWARD;
+      UInt32 num_requeued_waiters = requeued_waiters.size();
+      m_send_buffer.clear();
+      m_send_buffer << msg_type << requester << addr2 << num_procs_woken_up_or_requeued << num_requeued_waiters;
+      for (UInt32 i = 0; i < num_requeued_waiters; i++)
+         m_send_buffer << requeued_waiters[i].core_id << requeued_waiters[i].time;
+
+      NetPacket packet(time, FUTEX_SERVER_REQUEST_TYPE, m_network->getTile()->getCore()->getId(),
+                       home, m_send_buffer.size(), m_send_buffer.getBuffer());
+      m_network->netSend(packet);
+   }
+}
+
+void
+DistributedFutexServer::wakeForward(NetPacket& packet)
+{
+   core_id_t requester;
+   int* addr;
+   int val;
+   int num_procs_woken_up;
+   m_recv_buffer >> requester >> addr >> val >> num_procs_woken_up;
+
+   num_procs_woken_up += wakeWaiters(addr, val, packet.time);
+   sendResponse(requester, num_procs_woken_up, packet.time);
+}
+
+void
+DistributedFutexServer::requeueForward(NetPacket& packet)
+{
+   core_id_t requester;
+   int* addr;
+   int num_procs_woken_up_or_requeued;
+   UInt32 num_requeued_waiters;
+   m_recv_buffer >> requester >> addr >> num_procs_woken_up_or_requeued >> num_requeued_waiters;
+
+   WaiterQueue& waiters = m_futexes[(IntPtr) addr];
+   for (UInt32 i = 0; i < num_requeued_waiters; i++)
+   {
+      core_id_t core_id;
+      UInt64 time;
+      m_recv_buffer >> core_id >> time;
+      waiters.push(Waiter(core_id, time));
+   }
+
+   sendResponse(requester, num_procs_woken_up_or_requeued, packet.time);
+}
+
+int
+DistributedFutexServer::wakeWaiters(int* addr, int val, UInt64 time)
+{
+   FutexMap::iterator it = m_futexes.find((IntPtr) addr);
+   if (it == m_futexes.end())
+      return 0;
+
+   WaiterQueue& waiters = it->second;
+   int num_procs_woken_up = 0;
+   while (!waiters.empty() && (num_procs_woken_up < val))
+   {
+      Waiter waiter = waiters.front();
+      waiters.pop();
+      num_procs_woken_up ++;
+
+      // A waiter is not woken before its wait reached the home
+      Sim()->getThreadManager()->resumeThread(waiter.core_id);
+      sendResponse(waiter.core_id, 0, std::max(time, waiter.time));
+      LOG_PRINT("Woke Up (%i,%i)", waiter.core_id.tile_id, waiter.core_id.core_type);
+   }
+
+   if (waiters.empty())
+      m_futexes.erase(it);
+
+   return num_procs_woken_up;
+}
+
+void
+DistributedFutexServer::sendResponse(core_id_t requester, int ret_val, UInt64 time)
+{
+   NetPacket packet(time, FUTEX_SERVER_RESPONSE_TYPE, m_network->getTile()->getCore()->getId(),
+                    requester, sizeof(ret_val), &ret_val);
+   m_network->netSend(packet);
+}
@@ -0,0 +1,64 @@
+#ifndef DISTRIBUTED_FUTEX_SERVER_H
+#define DISTRIBUTED_FUTEX_SERVER_H
+
+#include <map>
+#include <queue>
+
+#include "packetize.h"
+#include "network.h"
+#include "fixed_types.h"
+
+class Tile;
+
+/*
+  Futex server of an application tile (sync_server/distributed_futexes =
+  true). Each futex word is homed on an application tile by the hash of its
+  address, and its waiter queue is kept in the sim thread of that tile
+  instead of on the MCP. A waiter is woken at the (simulated) time the wake
+  reached the home, and the replies travel back over the network, so the
+  wake latency is the one of the network model. The FUTEX_WAKE_OP and
+  FUTEX_CMP_REQUEUE ops on two words on different homes are passed on from
+  the home of the first word to the home of the second, which replies.
+  The futex words are read natively (lite mode, one process).
+ */
+class DistributedFutexServer
+{
+public:
+   DistributedFutexServer(Tile* tile);
+   ~DistributedFutexServer();
+
+   static bool isEnabled();
+   static core_id_t getHome(IntPtr address);
+
+private:
+   struct Waiter
+   {
+      Waiter(core_id_t core_id_, UInt64 time_)
+         : core_id(core_id_), time(time_) {}
+      core_id_t core_id;
+      // When the wait reached the home
+      UInt64 time;
+   };
+   typedef std::queue<Waiter> WaiterQueue;
+   typedef std::map<IntPtr, WaiterQueue> FutexMap;
+
+   static void networkCallback(void* obj, NetPacket packet);
+   void processPacket(NetPacket& packet);
+
+   void futexWait(core_id_t requester, int* addr, int val, UInt64 time);
+   void futexWake(core_id_t requester, int* addr, int val, UInt64 time);
+   void futexWakeOp(core_id_t requester, int* addr1, int val1, int val2, int* addr2, int val3, UInt64 time);
+   void futexCmpRequeue(core_id_t requester, int* addr1, int val1, int val2, int* addr2, int val3, UInt64 time);
+   void wakeForward(NetPacket& packet);
+   void requeueForward(NetPacket& packet);
+
+   int wakeWaiters(int* addr, int val, UInt64 time);
+   void sendResponse(core_id_t requester, int ret_val, UInt64 time);
+
+   Network* m_network;
+   UnstructuredBuffer m_recv_buffer;
+   UnstructuredBuffer m_send_buffer;
+   FutexMap m_futexes;
+};
+
+#endif // DISTRIBUTED_FUTEX_SERVER_H
@@ -0,0 +1,108 @@
+#include "distributed_sync_server.h"
+#include "message_types.h"
+#include "simulator.h"
+#include "config.h"
+#include "tile.h"
+#include "log.h"
+
+DistributedSyncServer::DistributedSyncServer(Tile* tile)
+   : m_network(tile->getNetwork())
+   , m_sync_server(*m_network, m_recv_buffer, SYNC_SERVER_RESPONSE_TYPE,
+                   tile->getId(), Config::getSingleton()->getApplicationTiles())
+{
+   // The servers stall and resume the threads in the thread manager of the
+   // master process. The barrier clock skew servers are driven by those
+   // and only run in the MCP thread
+   LOG_ASSERT_ERROR(Config::getSingleton()->getProcessCount() == 1,
+                    "Distributed sync servers only work with a single process");
+   std::string clock_skew_scheme = Sim()->getCfg()->getString("clock_skew_minimization/scheme");
+   LOG_ASSERT_ERROR(clock_skew_scheme != "lax_barrier" && clock_skew_scheme != "lax_adaptive",
+                    "Distributed sync servers do not work with the %s clock skew minimization scheme",
+                    clock_skew_scheme.c_str());
+
+   m_network->registerCallback(SYNC_SERVER_REQUEST_TYPE, networkCallback, this);
+}
+
+DistributedSyncServer::~DistributedSyncServer()
+{
+   m_network->unregisterCallback(SYNC_SERVER_REQUEST_TYPE);
+}
+
+bool
+DistributedSyncServer::isEnabled()
+{
+   try
+   {
+      return Sim()->getCfg()->getBool("sync_server/distributed", false);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read sync_server/distributed from the cfg file");
+      return false;
+   }
+}
+
+void
+DistributedSyncServer::networkCallback(void* obj, NetPacket packet)
+{
+   DistributedSyncServer* sync_server = (DistributedSyncServer*) obj;
+   sync_server->processPacket(packet);
+}
+
+void
+DistributedSyncServer::processPacket(NetPacket& packet)
+{
+   // The packet data belongs to the network
+   m_recv_buffer.clear();
+   m_recv_buffer << make_pair(packet.data, packet.length);
+
+   int msg_type;
+   m_recv_buffer >> msg_type;
+
+   LOG_PRINT("Sync server message type(%i), sender(%i,%i)", (SInt32) msg_type, packet.sender.tile_id, packet.sender.core_type);
+
+   switch (msg_type)
+   {
+   case MCP_MESSAGE_MUTEX_INIT:
+      m_sync_server.mutexInit(packet.sender);
+      break;
+   case MCP_MESSAGE_MUTEX_LOCK:
+      m_sync_server.mutexLock(packet.sender);
+      break;
+   case MCP_MESSAGE_MUTEX_UNLOCK:
+      m_sync_server.mutexUnlock(packet.sender);
+      break;
+   case MCP_MESSAGE_MUTEX_INFLATE:
+      m_sync_server.mutexInflate(packet.sender);
+      break;
+   case MCP_MESSAGE_MUTEX_LOCK_FORWARD:
+      m_sync_server.mutexLockForward(packet.sender);
+      break;
+   case MCP_MESSAGE_MUTEX_UNLOCK_FORWARD:
+      m_sync_server.mutexUnlockForward(packet.sender);
+      break;
+
+   case MCP_MESSAGE_COND_INIT:
+      m_sync_server.condInit(packet.sender);
+      break;
+   case MCP_MESSAGE_COND_WAIT:
+      m_sync_server.condWait(packet.sender);
+      break;
+   case MCP_MESSAGE_COND_SIGNAL:
+      m_sync_server.condSignal(packet.sender);
+      break;
+   case MCP_MESSAGE_COND_BROADCAST:
+      m_sync_server.condBroadcast(packet.sender);
+      break;
+
+   case MCP_MESSAGE_BARRIER_INIT:
+      m_sync_server.barrierInit(packet.sender);
+      break;
+   case MCP_MESSAGE_BARRIER_WAIT:
+      m_sync_server.barrierWait(packet.sender);
+      break;
+
+   default:
+      LOG_PRINT_ERROR("Unhandled sync server message type: %i from %i", msg_type, packet.sender.tile_id);
+   }
+}
@@ -0,0 +1,34 @@
+#ifndef DISTRIBUTED_SYNC_SERVER_H
+#define DISTRIBUTED_SYNC_SERVER_H
+
+#include "sync_server.h"
+#include "packetize.h"
+#include "fixed_types.h"
+
+class Tile;
+
+/*
+  Sync server of an application tile (sync_server/distributed = true).
+  The mutexes, condition variables and barriers are homed on the
+  application tiles by their id (id % num application tiles) instead of
+  all on the MCP, and the requests are handled in the sim thread of their
+  home tile. The MCP is left with the syscalls and the thread management.
+ */
+class DistributedSyncServer
+{
+public:
+   DistributedSyncServer(Tile* tile);
+   ~DistributedSyncServer();
+
+   static bool isEnabled();
+
+private:
+   static void networkCallback(void* obj, NetPacket packet);
+   void processPacket(NetPacket& packet);
+
+   Network* m_network;
+   UnstructuredBuffer m_recv_buffer;
+   SyncServer m_sync_server;
+};
+
+#endif // DISTRIBUTED_SYNC_SERVER_H
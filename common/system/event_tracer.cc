@@ -0,0 +1,185 @@
+#include <stdio.h>
+
+#include "event_tracer.h"
+#include "simulator.h"
+#include "config.h"
+#include "tls.h"
+#include "utils.h"
+#include "log.h"
+
+using namespace std;
+
+EventTracer::EventTracer()
+   : m_max_spans_per_thread(0)
+   , m_buffers_tls(TLS::create())
+{
+   for (UInt32 i = 0; i < NUM_CATEGORIES; i++)
+      m_enabled[i] = false;
+
+   string categories_line;
+   try
+   {
+      categories_line = Sim()->getCfg()->getString("event_trace/categories", "cache, directory, network, sync");
+      m_max_spans_per_thread = Sim()->getCfg()->getInt("event_trace/max_spans_per_thread", 1000000);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read event_trace information from the cfg file");
+   }
+
+   vector<string> categories;
+   splitIntoTokens(categories_line, categories, ", ");
+   for (vector<string>::iterator it = categories.begin(); it != categories.end(); it++)
+   {
+      Category category = parseCategory(*it);
+      LOG_ASSERT_ERROR(category != NUM_CATEGORIES, "Unrecognized event trace category(%s)", it->c_str());
+      m_enabled[category] = true;
+   }
+}
+
+EventTracer::~EventTracer()
+{
+   for (UInt32 i = 0; i < m_buffers.size(); i++)
+      delete m_buffers[i];
+   delete m_buffers_tls;
+}
+
+bool
+EventTracer::isEnabled()
+{
+   try
+   {
+      return Sim()->getCfg()->getBool("event_trace/enabled", false);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read event_trace/enabled from the cfg file");
+      return false;
+   }
+}
+
+EventTracer::Category
+EventTracer::parseCategory(const string& category)
+{
+   for (UInt32 i = 0; i < NUM_CATEGORIES; i++)
+   {
+      if (category == getCategoryName((Category) i))
+         return (Category) i;
+   }
+   return NUM_CATEGORIES;
+}
+
+const char*
+EventTracer::getCategoryName(Category category)
+{
+   switch (category)
+   {
+   case CACHE:
+      return "cache";
+   case DIRECTORY:
+      return "directory";
+   case NETWORK:
+      return "network";
+   case SYNC:
+      return "sync";
+   default:
+      LOG_PRINT_ERROR("Unrecognized event trace category(%u)", category);
+      return NULL;
+   }
+}
+
+EventTracer::Buffer*
+EventTracer::getBuffer()
+{
+   Buffer* buffer = m_buffers_tls->get<Buffer>();
+   if (buffer)
+      return buffer;
+
+   // The buffers outlive the threads, until the trace is written
+   buffer = new Buffer();
+   buffer->num_dropped = 0;
+   m_buffers_tls->set(buffer);
+
+   ScopedLock sl(m_buffers_lock);
+   m_buffers.push_back(buffer);
+   return buffer;
+}
+
+void
+EventTracer::record(Category category, const char* name, tile_id_t tile_id,
+                    UInt64 start_time, UInt64 end_time, UInt64 arg)
+{
+   Buffer* buffer = getBuffer();
+   if (buffer->spans.size() >= m_max_spans_per_thread)
+   {
+      buffer->num_dropped ++;
+      return;
+   }
+
+   Span span;
+   span.name = name;
+   span.start_time = start_time;
+   span.duration = (end_time > start_time) ? (end_time - start_time) : 0;
+   span.arg = arg;
+   span.tile_id = tile_id;
+   span.category = category;
+   buffer->spans.push_back(span);
+}
+
+void
+EventTracer::output()
+{
+   SInt32 process_num = Config::getSingleton()->getCurrentProcessNum();
+   char filename[64];
+   snprintf(filename, sizeof(filename), "event_trace.%d.json", process_num);
+   string path = Config::getSingleton()->formatOutputFileName(filename);
+
+   FILE* file = fopen(path.c_str(), "w");
+   LOG_ASSERT_ERROR(file, "Could not open event trace file(%s)", path.c_str());
+
+   // Timestamps are in us, with ns as the fraction
+   fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+   fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"Process %d\"}}",
+           process_num, process_num);
+
+   vector<bool> tile_named(Config::getSingleton()->getTotalTiles(), false);
+   UInt64 num_dropped = 0;
+
+   ScopedLock sl(m_buffers_lock);
+   for (UInt32 i = 0; i < m_buffers.size(); i++)
+   {
+      const vector<Span>& spans = m_buffers[i]->spans;
+      num_dropped += m_buffers[i]->num_dropped;
+
+      for (UInt32 j = 0; j < spans.size(); j++)
+      {
+         const Span& span = spans[j];
+         if ((span.tile_id >= 0) && ((UInt32) span.tile_id < tile_named.size()) && !tile_named[span.tile_id])
+         {
+            tile_named[span.tile_id] = true;
+            fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"Tile %d\"}}",
+                    process_num, span.tile_id, span.tile_id);
+         }
+
+         fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+                       "\"ts\":%llu.%03llu,\"dur\":%llu.%03llu,",
+                 span.name, getCategoryName((Category) span.category), process_num, span.tile_id,
+                 (unsigned long long) (span.start_time / 1000), (unsigned long long) (span.start_time % 1000),
+                 (unsigned long long) (span.duration / 1000), (unsigned long long) (span.duration % 1000));
+
+         if (span.category == NETWORK)
+            fprintf(file, "\"args\":{\"contention_ns\":%llu}}", (unsigned long long) span.arg);
+         else if (span.category == SYNC)
+            fprintf(file, "\"args\":{}}");
+         else
+            fprintf(file, "\"args\":{\"address\":\"0x%llx\"}}", (unsigned long long) span.arg);
+      }
+   }
+
+   fprintf(file, "\n]}\n");
+   fclose(file);
+
+   if (num_dropped > 0)
+      LOG_PRINT_WARNING("Event trace: %llu spans dropped, increase [event_trace] max_spans_per_thread",
+                        (unsigned long long) num_dropped);
+}
@@ -0,0 +1,75 @@
+#ifndef EVENT_TRACER_H
+#define EVENT_TRACER_H
+
+#include <vector>
+#include <string>
+
+#include "fixed_types.h"
+#include "lock.h"
+
+class TLS;
+
+/*
+  Trace of spans in simulated time ([event_trace]): cache misses (issue to
+  fill), directory transactions (arrival to completion), network packets
+  (send to receive) and sync waits, in the Chrome trace event format
+  (event_trace.<process>.json, opens in chrome://tracing and Perfetto).
+  Each tile is a thread of the trace. The spans go to a buffer of the host
+  thread that records them and are only gathered at the end of the run.
+ */
+class EventTracer
+{
+public:
+   enum Category
+   {
+      CACHE = 0,
+      DIRECTORY,
+      NETWORK,
+      SYNC,
+      NUM_CATEGORIES
+   };
+
+   EventTracer();
+   ~EventTracer();
+
+   static bool isEnabled();
+   bool isEnabled(Category category) const { return m_enabled[category]; }
+
+   // A span from start to end (in ns); the name must be a constant string.
+   // The argument is an address (cache, directory) or the contention delay
+   // (network, in ns)
+   void record(Category category, const char* name, tile_id_t tile_id,
+               UInt64 start_time, UInt64 end_time, UInt64 arg = 0);
+
+   void output();
+
+private:
+   struct Span
+   {
+      const char* name;
+      UInt64 start_time;
+      UInt64 duration;
+      UInt64 arg;
+      tile_id_t tile_id;
+      UInt8 category;
+   };
+
+   struct Buffer
+   {
+      std::vector<Span> spans;
+      UInt64 num_dropped;
+   };
+
+   Buffer* getBuffer();
+   static const char* getCategoryName(Category category);
+   static Category parseCategory(const std::string& category);
+
+   bool m_enabled[NUM_CATEGORIES];
+   UInt32 m_max_spans_per_thread;
+
+   TLS* m_buffers_tls;
+   std::vector<Buffer*> m_buffers;
+   Lock m_buffers_lock;
+};
+
+#endif // EVENT_TRACER_H
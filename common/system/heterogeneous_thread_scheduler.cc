@@ -0,0 +1,207 @@
+#include <algorithm>
+#include "heterogeneous_thread_scheduler.h"
+#include "thread_manager.h"
+#include "tile_manager.h"
+#include "simulator.h"
+#include "config.h"
+#include "tile.h"
+#include "log.h"
+
+HeterogeneousThreadScheduler::HeterogeneousThreadScheduler(ThreadManager* thread_manager, TileManager* tile_manager)
+   : WorkStealingThreadScheduler(thread_manager, tile_manager)
+   , m_num_big_tiles(0)
+   , m_speed_ratio(1.0)
+   , m_migration_cost(0)
+   , m_steal_filter(ANY_THREAD)
+   , m_total_migration_cost(0)
+{
+   try
+   {
+      m_migration_cost = Sim()->getCfg()->getInt("thread_scheduling/heterogeneous/migration_cost", 1000);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read thread_scheduling/heterogeneous/migration_cost from the cfg file");
+   }
+
+   Config* config = Config::getSingleton();
+
+   std::vector<double> speed(m_total_tiles, 0.0);
+   double max_speed = 0.0;
+   double min_speed = 0.0;
+   for (tile_id_t i = 0; i < (tile_id_t) m_total_tiles; i++)
+   {
+      if (!config->isApplicationTile(i))
+         continue;
+      speed[i] = config->getCoreFrequency(Tile::getMainCoreId(i)) * getCoreTypeSpeed(config->getCoreType(i));
+      max_speed = std::max(max_speed, speed[i]);
+      min_speed = (min_speed == 0.0) ? speed[i] : std::min(min_speed, speed[i]);
+   }
+   if (min_speed > 0.0)
+      m_speed_ratio = max_speed / min_speed;
+
+   m_tile_class.resize(m_total_tiles, LITTLE);
+   for (UInt32 i = 0; i < m_total_tiles; i++)
+   {
+      if (config->isApplicationTile(i) && (speed[i] == max_speed))
+      {
+         m_tile_class[i] = BIG;
+         m_num_big_tiles ++;
+      }
+   }
+
+   m_last_instruction_count.resize(m_total_tiles, 0);
+   m_last_memory_stall_cycles.resize(m_total_tiles, 0);
+   for (UInt32 i = 0; i < NUM_TILE_CLASSES; i++)
+      m_num_moves[i] = 0;
+}
+
+HeterogeneousThreadScheduler::~HeterogeneousThreadScheduler()
+{
+}
+
+double HeterogeneousThreadScheduler::getCoreTypeSpeed(std::string core_type)
+{
+   // Instructions per cycle of the core types relative to each other (the
+   // out-of-order cores issue several instructions per cycle)
+   if (core_type == "ooo" || core_type == "interval")
+      return 2.0;
+   return 1.0;
+}
+
+double HeterogeneousThreadScheduler::getSpeedup(thread_func_t func)
+{
+   std::map<thread_func_t, Profile>::iterator it = m_profiles.find(func);
+   if (it == m_profiles.end())
+      return getAverageSpeedup();
+   const Profile& profile = it->second;
+
+   if (profile.run_time[BIG] > 0 && profile.run_time[LITTLE] > 0 && profile.instructions[LITTLE] > 0)
+   {
+      return ((double) profile.instructions[BIG] / profile.run_time[BIG]) /
+             ((double) profile.instructions[LITTLE] / profile.run_time[LITTLE]);
+   }
+
+   // The memory stalls take as long on either class
+   UInt64 run_time = profile.run_time[BIG] + profile.run_time[LITTLE];
+   UInt64 memory_stall_time = profile.memory_stall_time[BIG] + profile.memory_stall_time[LITTLE];
+   if (run_time == 0)
+      return getAverageSpeedup();
+   double memory_fraction = std::min(1.0, ((double) memory_stall_time) / run_time);
+   return 1.0 + (1.0 - memory_fraction) * (m_speed_ratio - 1.0);
+}
+
+void HeterogeneousThreadScheduler::masterOnThreadRun(core_id_t core_id, const ThreadSpawnRequest* req, UInt64 time,
+                                                     UInt64 instruction_count, UInt64 memory_stall_cycles)
+{
+   tile_id_t tile_id = core_id.tile_id;
+
+   // The threads of a tile run one after the other
+   UInt64 instructions = instruction_count - m_last_instruction_count[tile_id];
+   // The stall cycles are rescaled when the frequency of the tile changes
+   UInt64 memory_stall_delta = (memory_stall_cycles > m_last_memory_stall_cycles[tile_id]) ?
+                               (memory_stall_cycles - m_last_memory_stall_cycles[tile_id]) : 0;
+   m_last_instruction_count[tile_id] = instruction_count;
+   m_last_memory_stall_cycles[tile_id] = memory_stall_cycles;
+
+   // The thread started at the time of its request
+   if (time <= req->time)
+      return;
+
+   std::map<thread_func_t, Profile>::iterator it = m_profiles.find(req->func);
+   if (it == m_profiles.end())
+   {
+      Profile empty_profile;
+      for (UInt32 i = 0; i < NUM_TILE_CLASSES; i++)
+      {
+         empty_profile.instructions[i] = 0;
+         empty_profile.run_time[i] = 0;
+         empty_profile.memory_stall_time[i] = 0;
+      }
+      it = m_profiles.insert(std::make_pair(req->func, empty_profile)).first;
+   }
+
+   TileClass tile_class = m_tile_class[tile_id];
+   float frequency = Config::getSingleton()->getCoreFrequency(core_id);
+   it->second.instructions[tile_class] += instructions;
+   it->second.run_time[tile_class] += time - req->time;
+   it->second.memory_stall_time[tile_class] += (UInt64) (memory_stall_delta / frequency);
+}
+
+void HeterogeneousThreadScheduler::masterOnCoreIdle(core_id_t core_id)
+{
+   if (!isStealableTile(core_id.tile_id))
+      return;
+
+   std::vector<tile_id_t> victims;
+   getVictimTiles(core_id.tile_id, victims);
+
+   bool is_big = (m_tile_class[core_id.tile_id] == BIG);
+   StealFilter filters[] = { is_big ? BIG_SPEEDUP : SMALL_SPEEDUP, ANY_THREAD };
+   for (UInt32 f = 0; f < 2; f++)
+   {
+      m_steal_filter = filters[f];
+      for (UInt32 i = 0; i < victims.size(); i++)
+      {
+         if (!is_big && m_steal_filter == ANY_THREAD && m_tile_class[victims[i]] == BIG)
+            continue;
+         if (stealThread(Tile::getMainCoreId(victims[i]), core_id))
+         {
+            m_steal_filter = ANY_THREAD;
+            return;
+         }
+      }
+   }
+   m_steal_filter = ANY_THREAD;
+}
+
+bool HeterogeneousThreadScheduler::isStealableThread(const ThreadSpawnRequest* req, core_id_t src_core_id, core_id_t dst_core_id)
+{
+   switch (m_steal_filter)
+   {
+   case BIG_SPEEDUP:
+      return getSpeedup(req->func) >= getAverageSpeedup();
+   case SMALL_SPEEDUP:
+      return getSpeedup(req->func) < getAverageSpeedup();
+   default:
+      return true;
+   }
+}
+
+void HeterogeneousThreadScheduler::onThreadStolen(ThreadSpawnRequest* req, core_id_t src_core_id, core_id_t dst_core_id)
+{
+   req->time += m_migration_cost;
+   m_total_migration_cost += m_migration_cost;
+   m_num_moves[m_tile_class[dst_core_id.tile_id]] ++;
+}
+
+void HeterogeneousThreadScheduler::outputSchemeSummary(std::ostream& os)
+{
+   WorkStealingThreadScheduler::outputSchemeSummary(os);
+
+   UInt64 instructions[NUM_TILE_CLASSES] = { 0, 0 };
+   UInt64 run_time[NUM_TILE_CLASSES] = { 0, 0 };
+   for (std::map<thread_func_t, Profile>::iterator it = m_profiles.begin(); it != m_profiles.end(); it++)
+   {
+      for (UInt32 i = 0; i < NUM_TILE_CLASSES; i++)
+      {
+         instructions[i] += it->second.instructions[i];
+         run_time[i] += it->second.run_time[i];
+      }
+   }
+
+   os << "    Big Tiles: " << m_num_big_tiles << endl;
+   os << "    Speed Ratio of the Big Tiles: " << m_speed_ratio << endl;
+   os << "    Threads Moved to Big Tiles: " << m_num_moves[BIG] << endl;
+   os << "    Threads Moved to Little Tiles: " << m_num_moves[LITTLE] << endl;
+   os << "    Total Migration Cost (in ns): " << m_total_migration_cost << endl;
+   os << "    Thread Functions Profiled: " << m_profiles.size() << endl;
+   os << "    Instructions per ns on Big Tiles: ";
+   if (run_time[BIG] > 0)
+      os << ((double) instructions[BIG]) / run_time[BIG];
+   os << endl;
+   os << "    Instructions per ns on Little Tiles: ";
+   if (run_time[LITTLE] > 0)
+      os << ((double) instructions[LITTLE]) / run_time[LITTLE];
+   os << endl;
+}
@@ -0,0 +1,91 @@
+#ifndef HETEROGENEOUS_THREAD_SCHEDULER_H
+#define HETEROGENEOUS_THREAD_SCHEDULER_H
+
+#include <map>
+#include <string>
+
+#include "work_stealing_thread_scheduler.h"
+
+class ThreadManager;
+class TileManager;
+
+/*
+  Work stealing on a chip with tiles of different speeds ([core] model_list).
+  The tiles of the highest speed (frequency x speed of the core type) are the
+  big tiles, the others the little ones.
+
+  The runs of the threads are profiled by their start function: when a
+  thread exits, its instructions per ns and the fraction of its time stalled
+  on memory (from the counters of the core model of its tile) are added to
+  the profile of its function on the class of its tile. The speedup of a
+  function on a big tile is the ratio of its instructions per ns on the two
+  classes once it ran on both, or else the speed ratio of the tiles applied
+  to the part of its time not stalled on memory.
+
+  A big tile that runs out of threads steals the waiting threads that gain
+  at least the average speedup first (the threads of unknown functions
+  included), then any thread; a little tile steals the other threads first,
+  then any thread waiting on a little tile (the threads that gain from a big
+  tile wait for one). A stolen thread starts migration_cost ns later, for
+  the transfer of its context; its cache warmup is the one of a cold start
+  on the new tile. The running threads are never moved.
+ */
+class HeterogeneousThreadScheduler : public WorkStealingThreadScheduler
+{
+public:
+   HeterogeneousThreadScheduler(ThreadManager *thread_manager, TileManager *tile_manager);
+   ~HeterogeneousThreadScheduler();
+
+protected:
+   virtual void masterOnCoreIdle(core_id_t core_id);
+   virtual void masterOnThreadRun(core_id_t core_id, const ThreadSpawnRequest* req, UInt64 time,
+                                  UInt64 instruction_count, UInt64 memory_stall_cycles);
+   virtual bool isStealableThread(const ThreadSpawnRequest* req, core_id_t src_core_id, core_id_t dst_core_id);
+   virtual void onThreadStolen(ThreadSpawnRequest* req, core_id_t src_core_id, core_id_t dst_core_id);
+   virtual void outputSchemeSummary(std::ostream& os);
+
+private:
+   enum TileClass
+   {
+      BIG = 0,
+      LITTLE,
+      NUM_TILE_CLASSES
+   };
+   enum StealFilter
+   {
+      ANY_THREAD = 0,
+      BIG_SPEEDUP,
+      SMALL_SPEEDUP
+   };
+
+   // Runs of the threads of a function on each class of tiles
+   struct Profile
+   {
+      UInt64 instructions[NUM_TILE_CLASSES];
+      UInt64 run_time[NUM_TILE_CLASSES];           // In ns
+      UInt64 memory_stall_time[NUM_TILE_CLASSES];  // In ns
+   };
+
+   static double getCoreTypeSpeed(std::string core_type);
+   double getSpeedup(thread_func_t func);
+   double getAverageSpeedup() { return (1.0 + m_speed_ratio) / 2; }
+
+   std::vector<TileClass> m_tile_class;
+   UInt32 m_num_big_tiles;
+   // Speed of the big tiles over the one of the slowest little tile
+   double m_speed_ratio;
+   UInt64 m_migration_cost;
+
+   std::map<thread_func_t, Profile> m_profiles;
+   // Counters of the core model of each tile at its last thread exit
+   std::vector<UInt64> m_last_instruction_count;
+   std::vector<UInt64> m_last_memory_stall_cycles;
+
+   // Threads the current steal may take
+   StealFilter m_steal_filter;
+
+   UInt64 m_num_moves[NUM_TILE_CLASSES];
+   UInt64 m_total_migration_cost;
+};
+
+#endif // HETEROGENEOUS_THREAD_SCHEDULER_H
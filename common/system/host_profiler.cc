@@ -0,0 +1,302 @@
+#include <iomanip>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "host_profiler.h"
+#include "simulator.h"
+#include "tile_manager.h"
+#include "tls.h"
+#include "log.h"
+
+HostProfiler::Counters::Counters(SInt32 tile_id_, const char* thread_type_)
+   : tile_id(tile_id_)
+   , thread_type(thread_type_)
+{
+   for (UInt32 i = 0; i < NUM_CATEGORIES; i++)
+   {
+      cycles[i] = 0;
+      count[i] = 0;
+      for (UInt32 j = 0; j < NUM_EVENTS; j++)
+         events[i][j] = 0;
+   }
+   for (UInt32 j = 0; j < NUM_EVENTS; j++)
+      perf_fds[j] = -1;
+}
+
+HostProfiler::HostProfiler()
+   : m_counters_tls(TLS::create())
+   , m_perf_events_enabled(false)
+   , m_start_tsc(rdtsc())
+   , m_code_cache_stats_valid(false)
+   , m_code_memory(0)
+   , m_num_traces(0)
+   , m_num_flushes(0)
+{
+   try
+   {
+      m_perf_events_enabled = Sim()->getCfg()->getBool("host_profiler/perf_events", false);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read host_profiler/perf_events from the cfg file");
+   }
+}
+
+HostProfiler::~HostProfiler()
+{
+   for (UInt32 i = 0; i < m_threads.size(); i++)
+   {
+      for (UInt32 j = 0; j < NUM_EVENTS; j++)
+      {
+         if (m_threads[i]->perf_fds[j] >= 0)
+            close(m_threads[i]->perf_fds[j]);
+      }
+      delete m_threads[i];
+   }
+   delete m_counters_tls;
+}
+
+bool
+HostProfiler::isEnabled()
+{
+   try
+   {
+      return Sim()->getCfg()->getBool("host_profiler/enabled", false);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read host_profiler/enabled from the cfg file");
+      return false;
+   }
+}
+
+HostProfiler::Counters*
+HostProfiler::getCounters()
+{
+   Counters* counters = m_counters_tls->get<Counters>();
+   return counters ? counters : registerThread();
+}
+
+HostProfiler::Counters*
+HostProfiler::registerThread()
+{
+   // The counters outlive the thread, until the summary
+   TileManager* tile_manager = Sim()->getTileManager();
+   const char* thread_type = "other";
+   if (tile_manager->amiAppThread())
+      thread_type = "app";
+   else if (tile_manager->amiSimThread())
+      thread_type = "sim";
+
+   Counters* counters = new Counters(tile_manager->getCurrentTileID(), thread_type);
+   m_counters_tls->set(counters);
+   if (m_perf_events_enabled)
+      openPerfEvents(counters);
+
+   ScopedLock sl(m_threads_lock);
+   m_threads.push_back(counters);
+   return counters;
+}
+
+void
+HostProfiler::openPerfEvents(Counters* counters)
+{
+   static const UInt32 types[NUM_EVENTS] =
+      { PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_SOFTWARE };
+   static const UInt64 configs[NUM_EVENTS] =
+      { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_SW_CONTEXT_SWITCHES };
+
+   // One group for the calling thread, on any host core, read at once
+   for (UInt32 i = 0; i < NUM_EVENTS; i++)
+   {
+      struct perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = types[i];
+      attr.config = configs[i];
+      attr.read_format = PERF_FORMAT_GROUP;
+      // The simulator's own code only; context switches are in the kernel
+      attr.exclude_kernel = (types[i] == PERF_TYPE_HARDWARE);
+      attr.exclude_hv = 1;
+
+      int fd = syscall(__NR_perf_event_open, &attr, 0, -1, counters->perf_fds[0], 0);
+      if (fd < 0)
+      {
+         LOG_PRINT_WARNING("Could not open host counter %s (errno %d), see /proc/sys/kernel/perf_event_paranoid",
+                           getEventName((Event) i), errno);
+         for (UInt32 j = 0; j < i; j++)
+         {
+            close(counters->perf_fds[j]);
+            counters->perf_fds[j] = -1;
+         }
+         return;
+      }
+      counters->perf_fds[i] = fd;
+   }
+}
+
+void
+HostProfiler::readEvents(UInt64* values)
+{
+   Counters* counters = getCounters();
+
+   struct
+   {
+      UInt64 nr;
+      UInt64 values[NUM_EVENTS];
+   } group;
+
+   if ((counters->perf_fds[0] < 0) ||
+       (read(counters->perf_fds[0], &group, sizeof(group)) != (ssize_t) sizeof(group)))
+   {
+      for (UInt32 i = 0; i < NUM_EVENTS; i++)
+         values[i] = 0;
+      return;
+   }
+   for (UInt32 i = 0; i < NUM_EVENTS; i++)
+      values[i] = group.values[i];
+}
+
+void
+HostProfiler::recordEvents(Category category, const UInt64* start_values)
+{
+   UInt64 values[NUM_EVENTS];
+   readEvents(values);
+
+   Counters* counters = getCounters();
+   for (UInt32 i = 0; i < NUM_EVENTS; i++)
+   {
+      if (values[i] >= start_values[i])
+         counters->events[category][i] += values[i] - start_values[i];
+   }
+}
+
+void
+HostProfiler::setCodeCacheStats(UInt64 code_memory, UInt64 num_traces, UInt64 num_flushes)
+{
+   m_code_cache_stats_valid = true;
+   m_code_memory = code_memory;
+   m_num_traces = num_traces;
+   m_num_flushes = num_flushes;
+}
+
+const char*
+HostProfiler::getCategoryName(Category category)
+{
+   switch (category)
+   {
+   case INSTRUMENTATION:
+      return "Instrumentation";
+   case BASIC_BLOCK:
+      return "Basic Block";
+   case BRANCH:
+      return "Branch";
+   case MEMORY_REDIRECT:
+      return "Memory Redirect";
+   case LITE_MEMORY:
+      return "Lite Memory";
+   case SYSCALL:
+      return "Syscall";
+   case COHERENCE:
+      return "Coherence";
+   case NETWORK_CALLBACK:
+      return "Network Callback";
+   case SYNC:
+      return "Sync";
+   default:
+      LOG_PRINT_ERROR("Unrecognized host profiler category(%u)", (UInt32) category);
+      return "";
+   }
+}
+
+const char*
+HostProfiler::getEventName(Event event)
+{
+   switch (event)
+   {
+   case HOST_CORE_CYCLES:
+      return "Core Cycles";
+   case HOST_INSTRUCTIONS:
+      return "Instructions";
+   case HOST_LLC_MISSES:
+      return "LLC Misses";
+   case HOST_CONTEXT_SWITCHES:
+      return "Context Switches";
+   default:
+      LOG_PRINT_ERROR("Unrecognized host profiler event(%u)", (UInt32) event);
+      return "";
+   }
+}
+
+void
+HostProfiler::outputSummary(std::ostream& os)
+{
+   ScopedLock sl(m_threads_lock);
+
+   UInt64 total_cycles[NUM_CATEGORIES];
+   UInt64 total_count[NUM_CATEGORIES];
+   UInt64 total_events[NUM_CATEGORIES][NUM_EVENTS];
+   for (UInt32 i = 0; i < NUM_CATEGORIES; i++)
+   {
+      total_cycles[i] = 0;
+      total_count[i] = 0;
+      for (UInt32 j = 0; j < NUM_EVENTS; j++)
+         total_events[i][j] = 0;
+   }
+   for (UInt32 t = 0; t < m_threads.size(); t++)
+   {
+      for (UInt32 i = 0; i < NUM_CATEGORIES; i++)
+      {
+         total_cycles[i] += m_threads[t]->cycles[i];
+         total_count[i] += m_threads[t]->count[i];
+         for (UInt32 j = 0; j < NUM_EVENTS; j++)
+            total_events[i][j] += m_threads[t]->events[i][j];
+      }
+   }
+
+   os << "Host Profile Summary: " << std::endl;
+   os << "    Elapsed Host Cycles: " << (rdtsc() - m_start_tsc) << std::endl;
+   os << "    Profiled Threads: " << m_threads.size() << std::endl;
+   if (m_code_cache_stats_valid)
+   {
+      os << "    Code Cache Memory (in bytes): " << m_code_memory << std::endl;
+      os << "    Code Cache Traces: " << m_num_traces << std::endl;
+      os << "    Code Cache Flushes: " << m_num_flushes << std::endl;
+   }
+
+   for (UInt32 i = 0; i < NUM_CATEGORIES; i++)
+   {
+      if (total_count[i] == 0)
+         continue;
+      os << "    " << getCategoryName((Category) i) << " Host Cycles: " << total_cycles[i] << std::endl;
+      os << "    " << getCategoryName((Category) i) << " Calls: " << total_count[i] << std::endl;
+      os << "    " << getCategoryName((Category) i) << " Host Cycles per Call: "
+         << std::fixed << std::setprecision(1) << ((double) total_cycles[i] / total_count[i]) << std::endl;
+      if (m_perf_events_enabled)
+      {
+         UInt64* events = total_events[i];
+         for (UInt32 j = 0; j < NUM_EVENTS; j++)
+            os << "    " << getCategoryName((Category) i) << " Host " << getEventName((Event) j) << ": " << events[j] << std::endl;
+         os << "    " << getCategoryName((Category) i) << " Host IPC: " << std::setprecision(2)
+            << ((events[HOST_CORE_CYCLES] > 0) ? ((double) events[HOST_INSTRUCTIONS] / events[HOST_CORE_CYCLES]) : 0.0) << std::endl;
+         os << "    " << getCategoryName((Category) i) << " Host LLC Misses per 1000 Instructions: " << std::setprecision(2)
+            << ((events[HOST_INSTRUCTIONS] > 0) ? (1000.0 * events[HOST_LLC_MISSES] / events[HOST_INSTRUCTIONS]) : 0.0) << std::endl;
+      }
+   }
+
+   for (UInt32 t = 0; t < m_threads.size(); t++)
+   {
+      Counters* counters = m_threads[t];
+      os << "    Thread " << t << " (" << counters->thread_type << ", tile " << counters->tile_id << "):" << std::endl;
+      for (UInt32 i = 0; i < NUM_CATEGORIES; i++)
+      {
+         if (counters->count[i] == 0)
+            continue;
+         os << "      " << getCategoryName((Category) i) << " Host Cycles: " << counters->cycles[i]
+            << ", Calls: " << counters->count[i] << std::endl;
+      }
+   }
+}
@@ -0,0 +1,148 @@
+#ifndef HOST_PROFILER_H
+#define HOST_PROFILER_H
+
+#include <vector>
+#include <ostream>
+
+#include "fixed_types.h"
+#include "lock.h"
+
+class TLS;
+
+/*
+  Self-profiler of the simulator ([host_profiler]). Each host thread counts
+  the host cycles (TSC) it spends in the analysis routines and in the sim
+  thread callbacks, by class, and the summary in sim.out tells where the
+  host time of a run goes: what is not counted is Pin itself (the JIT and
+  the translated application code) or waiting. The times are inclusive: the
+  basic block time contains the core model, a memory access is counted
+  again under coherence when its tile's sim thread handles the messages.
+  The counters of a thread are only touched by that thread.
+
+  With perf_events = true, every thread also opens host hardware counters
+  (perf_event: core cycles, instructions and last-level cache misses in
+  user space, and context switches) and the same scopes attribute them to
+  the categories, for the host IPC and LLC misses of each subsystem. Each
+  scope then reads the counters twice (one syscall each), so the profile is
+  for finding cache-unfriendly simulator code, not for timing runs.
+ */
+class HostProfiler
+{
+public:
+   enum Category
+   {
+      INSTRUMENTATION = 0,    // Instrumentation callbacks at JIT time
+      BASIC_BLOCK,            // handleBasicBlock (core model)
+      BRANCH,                 // handleBranch
+      MEMORY_REDIRECT,        // Memory accesses of the full mode (memOp)
+      LITE_MEMORY,            // Memory accesses of the lite mode
+      SYSCALL,                // Syscall model (to the MCP and back)
+      COHERENCE,              // Sim thread: shared memory packets
+      NETWORK_CALLBACK,       // Sim thread: any other packet
+      SYNC,                   // Mutexes, condition variables and barriers (with the waits)
+      NUM_CATEGORIES
+   };
+
+   // Host hardware counters (perf_events)
+   enum Event
+   {
+      HOST_CORE_CYCLES = 0,
+      HOST_INSTRUCTIONS,
+      HOST_LLC_MISSES,
+      HOST_CONTEXT_SWITCHES,
+      NUM_EVENTS
+   };
+
+   HostProfiler();
+   ~HostProfiler();
+
+   static bool isEnabled();
+
+   static UInt64 rdtsc()
+   {
+      UInt32 lo, hi;
+      __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+      return ((UInt64) hi << 32) | lo;
+   }
+
+   void record(Category category, UInt64 cycles)
+   {
+      Counters* counters = getCounters();
+      counters->cycles[category] += cycles;
+      counters->count[category] ++;
+   }
+
+   bool arePerfEventsEnabled() const { return m_perf_events_enabled; }
+   // Current values of the hardware counters of this thread (0 if they
+   // could not be opened)
+   void readEvents(UInt64* values);
+   void recordEvents(Category category, const UInt64* start_values);
+
+   // Code cache at the end of the run, set by the front-end
+   void setCodeCacheStats(UInt64 code_memory, UInt64 num_traces, UInt64 num_flushes);
+
+   void outputSummary(std::ostream& os);
+
+   // Counts the host cycles of a scope; nothing if not profiling
+   class Scope
+   {
+   public:
+      Scope(HostProfiler* profiler, Category category)
+         : m_profiler(profiler)
+         , m_category(category)
+         , m_start(profiler ? rdtsc() : 0)
+      {
+         if (m_profiler && m_profiler->arePerfEventsEnabled())
+            m_profiler->readEvents(m_start_events);
+      }
+      ~Scope()
+      {
+         if (m_profiler)
+         {
+            m_profiler->record(m_category, rdtsc() - m_start);
+            if (m_profiler->arePerfEventsEnabled())
+               m_profiler->recordEvents(m_category, m_start_events);
+         }
+      }
+
+   private:
+      HostProfiler* m_profiler;
+      Category m_category;
+      UInt64 m_start;
+      UInt64 m_start_events[NUM_EVENTS];
+   };
+
+private:
+   struct Counters
+   {
+      Counters(SInt32 tile_id_, const char* thread_type_);
+      SInt32 tile_id;
+      const char* thread_type;
+      UInt64 cycles[NUM_CATEGORIES];
+      UInt64 count[NUM_CATEGORIES];
+      // perf_event group of the thread, the first is the leader (-1 if none)
+      int perf_fds[NUM_EVENTS];
+      UInt64 events[NUM_CATEGORIES][NUM_EVENTS];
+   };
+
+   Counters* getCounters();
+   Counters* registerThread();
+   void openPerfEvents(Counters* counters);
+
+   static const char* getCategoryName(Category category);
+   static const char* getEventName(Event event);
+
+   TLS* m_counters_tls;
+   // All the threads that recorded something, in order of first record
+   std::vector<Counters*> m_threads;
+   Lock m_threads_lock;
+
+   bool m_perf_events_enabled;
+   UInt64 m_start_tsc;
+   bool m_code_cache_stats_valid;
+   UInt64 m_code_memory;
+   UInt64 m_num_traces;
+   UInt64 m_num_flushes;
+};
+
+#endif // HOST_PROFILER_H
@@ -0,0 +1,270 @@
+#include <sched.h>
+#include <stdio.h>
+#include <algorithm>
+
+#include "host_resource_manager.h"
+#include "simulator.h"
+#include "config.h"
+#include "tile_manager.h"
+#include "tile.h"
+#include "clock_converter.h"
+#include "host_memory.h"
+#include "log.h"
+
+HostResourceManager::HostResourceManager()
+{
+   try
+   {
+      m_pin_threads = Sim()->getCfg()->getBool("host_resources/pin_threads", false);
+      m_balance_progress = Sim()->getCfg()->getBool("host_resources/balance_progress", false);
+      m_numa_placement = Sim()->getCfg()->getBool("host_resources/numa_placement", false);
+      m_huge_pages = Sim()->getCfg()->getBool("host_resources/huge_pages", false);
+      m_check_interval = Sim()->getCfg()->getInt("host_resources/check_interval", 1000);
+      m_max_lead = Sim()->getCfg()->getInt("host_resources/max_lead", 10000);
+      m_max_yields = Sim()->getCfg()->getInt("host_resources/max_yields", 100);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read host_resources parameters from the cfg file");
+   }
+
+   LOG_ASSERT_ERROR(m_check_interval > 0, "host_resources/check_interval must be > 0");
+
+   UInt32 total_tiles = Config::getSingleton()->getTotalTiles();
+   m_progress = new volatile UInt64[total_tiles];
+   for (UInt32 i = 0; i < total_tiles; i++)
+      m_progress[i] = 0;
+   m_next_check.resize(total_tiles, 0);
+   m_num_yields.resize(total_tiles, 0);
+
+   readHostNodes();
+
+   HostMemory::setHugePagesEnabled(m_huge_pages);
+}
+
+HostResourceManager::~HostResourceManager()
+{
+   delete [] m_progress;
+}
+
+bool
+HostResourceManager::isEnabled()
+{
+   try
+   {
+      return (Sim()->getCfg()->getBool("host_resources/pin_threads", false) ||
+              Sim()->getCfg()->getBool("host_resources/balance_progress", false) ||
+              Sim()->getCfg()->getBool("host_resources/numa_placement", false) ||
+              Sim()->getCfg()->getBool("host_resources/huge_pages", false));
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read host_resources parameters from the cfg file");
+      return false;
+   }
+}
+
+void
+HostResourceManager::readHostNodes()
+{
+   cpu_set_t allowed;
+   CPU_ZERO(&allowed);
+   if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+   {
+      LOG_PRINT_WARNING("Could not read the affinity mask of the process, not pinning threads");
+      m_pin_threads = false;
+      m_numa_placement = false;
+      return;
+   }
+
+   // The cpulist of a node looks like "0-7,16-23"
+   for (UInt32 node = 0; ; node++)
+   {
+      char filename[64];
+      snprintf(filename, sizeof(filename), "/sys/devices/system/node/node%u/cpulist", node);
+      FILE* file = fopen(filename, "r");
+      if (!file)
+         break;
+
+      std::vector<SInt32> cpus;
+      int first, last;
+      while (fscanf(file, "%d", &first) == 1)
+      {
+         last = first;
+         int c = fgetc(file);
+         if (c == '-')
+         {
+            if (fscanf(file, "%d", &last) != 1)
+               break;
+            c = fgetc(file);
+         }
+         for (int cpu = first; cpu <= last; cpu++)
+         {
+            if ((cpu < CPU_SETSIZE) && CPU_ISSET(cpu, &allowed))
+               cpus.push_back(cpu);
+         }
+         if (c != ',')
+            break;
+      }
+      fclose(file);
+
+      if (!cpus.empty())
+      {
+         m_node_cpus.push_back(cpus);
+         m_node_ids.push_back(node);
+      }
+   }
+
+   // No NUMA information: a single node with all the cores we may run on
+   if (m_node_cpus.empty())
+   {
+      std::vector<SInt32> cpus;
+      for (SInt32 cpu = 0; cpu < CPU_SETSIZE; cpu++)
+      {
+         if (CPU_ISSET(cpu, &allowed))
+            cpus.push_back(cpu);
+      }
+      m_node_cpus.push_back(cpus);
+      m_node_ids.push_back(-1);
+   }
+
+   LOG_PRINT("Host has %u NUMA node(s)", (UInt32) m_node_cpus.size());
+}
+
+UInt32
+HostResourceManager::getNode(UInt32 tile_index)
+{
+   UInt32 num_local_tiles = Config::getSingleton()->getNumLocalTiles();
+   return ((UInt64) tile_index * m_node_cpus.size()) / num_local_tiles;
+}
+
+SInt32
+HostResourceManager::getNodeCpu(UInt32 tile_index, UInt32 offset)
+{
+   // The app and sim threads of the k-th tile of a node go to consecutive cores
+   UInt32 num_local_tiles = Config::getSingleton()->getNumLocalTiles();
+   UInt32 node = getNode(tile_index);
+   UInt32 first_tile_index = ((UInt64) node * num_local_tiles + m_node_cpus.size() - 1) / m_node_cpus.size();
+   const std::vector<SInt32>& cpus = m_node_cpus[node];
+   return cpus[(2 * (tile_index - first_tile_index) + offset) % cpus.size()];
+}
+
+void
+HostResourceManager::pinCurrentThread(const std::vector<SInt32>& cpus)
+{
+   cpu_set_t cpu_set;
+   CPU_ZERO(&cpu_set);
+   for (UInt32 i = 0; i < cpus.size(); i++)
+      CPU_SET(cpus[i], &cpu_set);
+
+   // pid 0 is the calling thread
+   if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) != 0)
+      LOG_PRINT_WARNING("Could not pin thread to %u host core(s)", (UInt32) cpus.size());
+}
+
+void
+HostResourceManager::pinAppThread(UInt32 tile_index)
+{
+   if (!m_pin_threads)
+      return;
+   pinCurrentThread(std::vector<SInt32>(1, getNodeCpu(tile_index, 0)));
+}
+
+void
+HostResourceManager::pinSimThread(UInt32 tile_index)
+{
+   if (!m_pin_threads)
+      return;
+   pinCurrentThread(std::vector<SInt32>(1, getNodeCpu(tile_index, 1)));
+}
+
+void
+HostResourceManager::pinSimPoolThread(UInt32 worker_index)
+{
+   if (!m_pin_threads)
+      return;
+   // A pool thread serves tiles all over the process: any core of its node
+   pinCurrentThread(m_node_cpus[worker_index % m_node_cpus.size()]);
+}
+
+void
+HostResourceManager::bindTileMemory(UInt32 tile_index)
+{
+   if (!m_numa_placement)
+      return;
+   // Where the threads of the tile are pinned
+   SInt32 node_id = m_node_ids[getNode(tile_index)];
+   if (node_id >= 0)
+      HostMemory::setPreferredNode(node_id);
+}
+
+void
+HostResourceManager::unbindTileMemory()
+{
+   if (!m_numa_placement)
+      return;
+   HostMemory::setPreferredNode(-1);
+}
+
+void
+HostResourceManager::checkProgress(Core* core, UInt64 cycle_count)
+{
+   tile_id_t tile_id = core->getTileId();
+   volatile float frequency = core->getPerformanceModel()->getFrequency();
+
+   m_progress[tile_id] = convertCycleCount(cycle_count, frequency, 1.0);
+   m_next_check[tile_id] = cycle_count + (UInt64) (m_check_interval * frequency);
+
+   // Give the host core to the laggards while too far ahead
+   for (UInt32 i = 0; i < m_max_yields; i++)
+   {
+      UInt64 min_progress = getMinProgress();
+      if ((min_progress == UINT64_MAX_) || (m_progress[tile_id] <= min_progress + m_max_lead))
+         break;
+      sched_yield();
+      m_num_yields[tile_id] ++;
+   }
+}
+
+UInt64
+HostResourceManager::getMinProgress()
+{
+   // Over the running application tiles of the process: the others do not
+   // need host time
+   UInt64 min_progress = UINT64_MAX_;
+   UInt32 application_tiles = Config::getSingleton()->getApplicationTiles();
+   const Config::TileList& tile_list = Config::getSingleton()->getTileListForCurrentProcess();
+   for (Config::TileList::const_iterator it = tile_list.begin(); it != tile_list.end(); it++)
+   {
+      if ((UInt32) (*it) >= application_tiles)
+         continue;
+      Core* core = Sim()->getTileManager()->getTileFromID(*it)->getCore();
+      // Not reported yet
+      if ((core->getState() != Core::RUNNING) || (m_progress[*it] == 0))
+         continue;
+      UInt64 progress = m_progress[*it];
+      min_progress = std::min(min_progress, progress);
+   }
+   return min_progress;
+}
+
+void
+HostResourceManager::outputSummary(std::ostream& os)
+{
+   UInt64 total_yields = 0;
+   UInt64 max_yields = 0;
+   for (UInt32 i = 0; i < m_num_yields.size(); i++)
+   {
+      total_yields += m_num_yields[i];
+      max_yields = std::max(max_yields, m_num_yields[i]);
+   }
+
+   os << "Host Resource Summary: " << std::endl;
+   os << "    Host NUMA Nodes: " << m_node_cpus.size() << std::endl;
+   os << "    Threads Pinned: " << (m_pin_threads ? "true" : "false") << std::endl;
+   os << "    NUMA Placement: " << (m_numa_placement ? "true" : "false") << std::endl;
+   os << "    Huge Pages: " << (m_huge_pages ? "true" : "false") << std::endl;
+   os << "    Progress Balancing: " << (m_balance_progress ? "true" : "false") << std::endl;
+   os << "    Progress Balancing Yields: " << total_yields << std::endl;
+   os << "    Max Progress Balancing Yields per Tile: " << max_yields << std::endl;
+}
@@ -0,0 +1,83 @@
+#ifndef HOST_RESOURCE_MANAGER_H
+#define HOST_RESOURCE_MANAGER_H
+
+#include <vector>
+#include <ostream>
+
+#include "fixed_types.h"
+#include "core.h"
+#include "core_model.h"
+
+/*
+  Placement of the simulator's threads on the host ([host_resources]).
+  With 'pin_threads', the app and sim threads of the local tiles are pinned
+  to host cores, the tiles split over the NUMA nodes in blocks of
+  consecutive tiles (mesh neighbours mostly share a node), and the sim pool
+  threads to the cores of a node. With 'balance_progress', the app thread of
+  a tile that has run more than 'max_lead' ns of simulated time ahead of the
+  slowest running local tile yields its host core for a while, so that the
+  laggards get the host time when there are more tiles than host cores.
+  With 'numa_placement', the state of a tile is built with the memory
+  preferred on the node its threads are pinned to, and with 'huge_pages' the
+  large arrays of the tiles (HostMemory::allocateArray) are backed by
+  transparent huge pages.
+ */
+class HostResourceManager
+{
+public:
+   HostResourceManager();
+   ~HostResourceManager();
+
+   static bool isEnabled();
+
+   // Called by the threads themselves, with the index of the tile in the process
+   void pinAppThread(UInt32 tile_index);
+   void pinSimThread(UInt32 tile_index);
+   void pinSimPoolThread(UInt32 worker_index);
+
+   // Around the construction of a tile, by the thread that builds it
+   void bindTileMemory(UInt32 tile_index);
+   void unbindTileMemory();
+
+   // Called by the app thread of the core, often
+   void balanceProgress(Core* core)
+   {
+      if (!m_balance_progress)
+         return;
+      UInt64 cycle_count = core->getPerformanceModel()->getCycleCount();
+      if (cycle_count < m_next_check[core->getTileId()])
+         return;
+      checkProgress(core, cycle_count);
+   }
+
+   void outputSummary(std::ostream& os);
+
+private:
+   void readHostNodes();
+   UInt32 getNode(UInt32 tile_index);
+   SInt32 getNodeCpu(UInt32 tile_index, UInt32 offset);
+   void pinCurrentThread(const std::vector<SInt32>& cpus);
+
+   void checkProgress(Core* core, UInt64 cycle_count);
+   UInt64 getMinProgress();
+
+   bool m_pin_threads;
+   bool m_balance_progress;
+   bool m_numa_placement;
+   bool m_huge_pages;
+   UInt64 m_check_interval;
+   UInt64 m_max_lead;
+   UInt32 m_max_yields;
+
+   // Host cores of each NUMA node, within the affinity mask of the process
+   std::vector< std::vector<SInt32> > m_node_cpus;
+   // Host node number of each of them, -1 without NUMA information
+   std::vector<SInt32> m_node_ids;
+
+   // Per tile, in ns of simulated time (and the tile's cycles for the next check)
+   volatile UInt64* m_progress;
+   std::vector<UInt64> m_next_check;
+   std::vector<UInt64> m_num_yields;
+};
+
+#endif // HOST_RESOURCE_MANAGER_H
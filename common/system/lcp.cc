@@ -6,6 +6,7 @@
 #include "tile_manager.h"
 #include "performance_counter_manager.h"
 #include "clock_skew_minimization_object.h"
+#include "message_buffer.h"
 
 #include "log.h"
 
@@ -87,7 +88,7 @@ void LCP::processPacket()
       break;
    }
 
-   delete [] pkt;
+   MessageBuffer::release(pkt);
 }
 
 void LCP::finish()
@@ -21,17 +21,32 @@ MCP::MCP(Network & network)
    , m_scratch(new char[m_MCP_SERVER_MAX_BUFF])
    , m_vm_manager()
    , m_syscall_server(m_network, m_send_buff, m_recv_buff, m_MCP_SERVER_MAX_BUFF, m_scratch)
+   , m_syscall_worker_pool(NULL)
    , m_sync_server(m_network, m_recv_buff)
    , m_clock_skew_minimization_server(NULL)
    , m_network_model_analytical_server(m_network, m_recv_buff)
 {
    m_clock_skew_minimization_server = ClockSkewMinimizationServer::create(Sim()->getCfg()->getString("clock_skew_minimization/scheme"), m_network, m_recv_buff);
+
+   UInt32 num_syscall_workers = 0;
+   try
+   {
+      num_syscall_workers = Sim()->getCfg()->getInt("mcp/syscall_workers", 0);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read mcp/syscall_workers from the cfg file");
+   }
+   if (num_syscall_workers > 0)
+      m_syscall_worker_pool = new SyscallWorkerPool(m_network, num_syscall_workers, m_MCP_SERVER_MAX_BUFF);
 }
 
 MCP::~MCP()
 {
    if (m_clock_skew_minimization_server)
       delete m_clock_skew_minimization_server;
+   if (m_syscall_worker_pool)
+      delete m_syscall_worker_pool;
    delete [] m_scratch;
 }
 
@@ -58,10 +73,18 @@ void MCP::processPacket()
    switch (msg_type)
    {
    case MCP_MESSAGE_SYS_CALL:
+      if (m_syscall_worker_pool && m_syscall_worker_pool->dispatch(recv_pkt))
+      {
+         // The worker replies and frees the request
+         LOG_PRINT("Passed syscall from (%i,%i) on to a worker", recv_pkt.sender.tile_id, recv_pkt.sender.core_type);
+         return;
+      }
       m_syscall_server.handleSyscall(recv_pkt.sender);
       break;
    case MCP_MESSAGE_QUIT:
       LOG_PRINT("Quit message received.");
+      if (m_syscall_worker_pool)
+         m_syscall_worker_pool->finish();
       m_finished = true;
       break;
 
@@ -74,6 +97,9 @@ void MCP::processPacket()
    case MCP_MESSAGE_MUTEX_UNLOCK:
       m_sync_server.mutexUnlock(recv_pkt.sender);
       break;
+   case MCP_MESSAGE_MUTEX_INFLATE:
+      m_sync_server.mutexInflate(recv_pkt.sender);
+      break;
 
    case MCP_MESSAGE_COND_INIT:
       m_sync_server.condInit(recv_pkt.sender);
@@ -100,6 +126,7 @@ void MCP::processPacket()
       break;
 
    case MCP_MESSAGE_THREAD_SPAWN_REQUEST_FROM_REQUESTER:
+   case MCP_MESSAGE_THREAD_SPAWN_ASYNC_REQUEST_FROM_REQUESTER:
       Sim()->getThreadManager()->masterSpawnThread((ThreadSpawnRequest*)recv_pkt.data);
       break;
    case MCP_MESSAGE_THREAD_SPAWN_REPLY_FROM_SLAVE:
@@ -138,11 +165,12 @@ void MCP::processPacket()
 
       break;
    case MCP_MESSAGE_THREAD_EXIT:
-      Sim()->getThreadManager()->masterOnThreadExit(  *(tile_id_t*)((Byte*)recv_pkt.data+sizeof(msg_type)), 
-                                                      *(UInt32*)((Byte*)recv_pkt.data+sizeof(msg_type)+sizeof(tile_id_t)), 
-                                                      *(SInt32*)((Byte*)recv_pkt.data+sizeof(msg_type)+sizeof(tile_id_t)+sizeof(UInt32)), 
-                                                      recv_pkt.time);
+   {
+      ThreadExitRequest* req = (ThreadExitRequest*) recv_pkt.data;
+      Sim()->getThreadManager()->masterOnThreadExit(req->core_id.tile_id, req->core_id.core_type, req->thread_idx,
+                                                    recv_pkt.time, req->instruction_count, req->memory_stall_cycles);
       break;
+   }
 
    case MCP_MESSAGE_THREAD_JOIN_REQUEST:
       Sim()->getThreadManager()->masterJoinThread((ThreadJoinRequest*)recv_pkt.data, recv_pkt.time);
@@ -186,6 +214,9 @@ void MCP::run()
    Sim()->getTileManager()->initializeThread(mcp_core_id);
    Sim()->getTileManager()->initializeCommId(mcp_core_id.tile_id);
 
+   if (m_syscall_worker_pool)
+      m_syscall_worker_pool->spawn();
+
    while (!finished())
    {
       processPacket();
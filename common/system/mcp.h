@@ -6,6 +6,7 @@
 #include "network.h"
 #include "vm_manager.h"
 #include "syscall_server.h"
+#include "syscall_worker_pool.h"
 #include "sync_server.h"
 #include "clock_skew_minimization_object.h"
 #include "fixed_types.h"
@@ -24,7 +25,10 @@ class MCP : public Runnable
       Boolean finished() { return m_finished; };
 
       VMManager* getVMManager() { return &m_vm_manager; }
+      Network* getNetwork() { return &m_network; }
       ClockSkewMinimizationServer* getClockSkewMinimizationServer() { return m_clock_skew_minimization_server; }
+      // Requests waiting to be handled (metrics server)
+      UInt32 getBacklog() const { return m_network.getNumPendingPackets(); }
 
    private:
       Boolean m_finished;
@@ -36,6 +40,7 @@ class MCP : public Runnable
 
       VMManager m_vm_manager;
       SyscallServer m_syscall_server;
+      SyscallWorkerPool* m_syscall_worker_pool;
       SyncServer m_sync_server;
       ClockSkewMinimizationServer* m_clock_skew_minimization_server;
       NetworkModelAnalyticalServer m_network_model_analytical_server;
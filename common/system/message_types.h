@@ -9,6 +9,8 @@ typedef enum
    MCP_MESSAGE_MUTEX_INIT,
    MCP_MESSAGE_MUTEX_LOCK,
    MCP_MESSAGE_MUTEX_UNLOCK,
+   // A contended fast mutex (sync_server/fast_mutex) goes to the server
+   MCP_MESSAGE_MUTEX_INFLATE,
    MCP_MESSAGE_COND_INIT,
    MCP_MESSAGE_COND_WAIT,
    MCP_MESSAGE_COND_SIGNAL,
@@ -17,6 +19,7 @@ typedef enum
    MCP_MESSAGE_BARRIER_WAIT,
    MCP_MESSAGE_UTILIZATION_UPDATE,
    MCP_MESSAGE_THREAD_SPAWN_REQUEST_FROM_REQUESTER,
+   MCP_MESSAGE_THREAD_SPAWN_ASYNC_REQUEST_FROM_REQUESTER,
    MCP_MESSAGE_THREAD_SPAWN_REPLY_FROM_SLAVE,
    MCP_MESSAGE_THREAD_YIELD_REQUEST,
    MCP_MESSAGE_THREAD_MIGRATE_REQUEST_FROM_REQUESTER,
@@ -29,7 +32,14 @@ typedef enum
    MCP_MESSAGE_THREAD_START,
    MCP_MESSAGE_THREAD_EXIT,
    MCP_MESSAGE_THREAD_JOIN_REQUEST,
-   MCP_MESSAGE_CLOCK_SKEW_MINIMIZATION
+   MCP_MESSAGE_CLOCK_SKEW_MINIMIZATION,
+   // Between the distributed sync servers
+   MCP_MESSAGE_MUTEX_LOCK_FORWARD,
+   MCP_MESSAGE_MUTEX_UNLOCK_FORWARD,
+   // To and between the distributed futex servers
+   MCP_MESSAGE_FUTEX,
+   MCP_MESSAGE_FUTEX_WAKE_FORWARD,
+   MCP_MESSAGE_FUTEX_REQUEUE_FORWARD
 } MCPMessageTypes;
 
 typedef enum
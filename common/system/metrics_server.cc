@@ -0,0 +1,253 @@
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <sstream>
+#include <algorithm>
+
+#include "metrics_server.h"
+#include "simulator.h"
+#include "tile_manager.h"
+#include "tile.h"
+#include "network.h"
+#include "transport.h"
+#include "mcp.h"
+#include "config.h"
+#include "log.h"
+
+using namespace std;
+
+// The server thread checks for the end of the simulation this often (in ms)
+static const SInt32 POLL_TIMEOUT = 100;
+
+static UInt64 getTime()
+{
+   timeval t;
+   gettimeofday(&t, NULL);
+   return ((UInt64) t.tv_sec) * 1000000 + t.tv_usec;
+}
+
+MetricsServer::MetricsServer()
+   : m_socket(-1)
+   , m_thread(NULL)
+   , m_finished(false)
+   , m_exited(true)
+   , m_start_time(getTime())
+   , m_last_snapshot_time(m_start_time)
+   , m_last_snapshot_instructions(0)
+{
+   try
+   {
+      m_socket_path = Sim()->getCfg()->getString("metrics_server/socket", "");
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read metrics_server/socket from the cfg file");
+   }
+
+   ostringstream filename;
+   filename << "metrics." << Config::getSingleton()->getCurrentProcessNum() << ".sock";
+   if (m_socket_path == "")
+      m_socket_path = Config::getSingleton()->formatOutputFileName(filename.str());
+   else
+      m_socket_path += "/" + filename.str();
+
+   CoreCounters counters;
+   counters.cycle_count = NULL;
+   counters.instruction_count = NULL;
+   counters.frequency = NULL;
+   m_cores.resize(Config::getSingleton()->getTotalTiles(), counters);
+}
+
+MetricsServer::~MetricsServer()
+{
+   delete m_thread;
+}
+
+bool
+MetricsServer::isEnabled()
+{
+   try
+   {
+      return Sim()->getCfg()->getBool("metrics_server/enabled", false);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read metrics_server/enabled from the cfg file");
+      return false;
+   }
+}
+
+void
+MetricsServer::registerCore(tile_id_t tile_id, const UInt64* cycle_count, const UInt64* instruction_count,
+                            const volatile float* frequency)
+{
+   LOG_ASSERT_ERROR((tile_id >= 0) && ((UInt32) tile_id < m_cores.size()), "Invalid tile id(%i)", tile_id);
+   m_cores[tile_id].cycle_count = cycle_count;
+   m_cores[tile_id].instruction_count = instruction_count;
+   m_cores[tile_id].frequency = frequency;
+}
+
+void
+MetricsServer::start()
+{
+   sockaddr_un address;
+   memset(&address, 0, sizeof(address));
+   address.sun_family = AF_UNIX;
+   LOG_ASSERT_ERROR(m_socket_path.length() < sizeof(address.sun_path),
+                    "Metrics socket path too long(%s), set metrics_server/socket to a shorter directory",
+                    m_socket_path.c_str());
+   strncpy(address.sun_path, m_socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+   // A socket left by an earlier run in the same directory
+   unlink(m_socket_path.c_str());
+
+   m_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+   LOG_ASSERT_ERROR(m_socket >= 0, "Could not create the metrics socket: %s", strerror(errno));
+   SInt32 err = bind(m_socket, (sockaddr*) &address, sizeof(address));
+   LOG_ASSERT_ERROR(err == 0, "Could not bind the metrics socket(%s): %s", m_socket_path.c_str(), strerror(errno));
+   err = listen(m_socket, 8);
+   LOG_ASSERT_ERROR(err == 0, "Could not listen on the metrics socket: %s", strerror(errno));
+
+   LOG_PRINT("Metrics server listening on %s", m_socket_path.c_str());
+
+   m_exited = false;
+   m_thread = Thread::create(this);
+   m_thread->run();
+}
+
+void
+MetricsServer::finish()
+{
+   if (m_socket < 0)
+      return;
+
+   m_finished = true;
+   // Wait till the thread exits
+   while (!m_exited)
+      sched_yield();
+
+   close(m_socket);
+   m_socket = -1;
+   unlink(m_socket_path.c_str());
+}
+
+void
+MetricsServer::run()
+{
+   LOG_PRINT("Metrics server thread starting...");
+
+   while (!m_finished)
+   {
+      pollfd fd;
+      fd.fd = m_socket;
+      fd.events = POLLIN;
+      fd.revents = 0;
+      if (poll(&fd, 1, POLL_TIMEOUT) <= 0)
+         continue;
+
+      SInt32 client = accept(m_socket, NULL, NULL);
+      if (client < 0)
+         continue;
+      writeSnapshot(client);
+      close(client);
+   }
+
+   LOG_PRINT("Metrics server thread exiting");
+   m_exited = true;
+}
+
+void
+MetricsServer::writeSnapshot(SInt32 client)
+{
+   UInt64 time = getTime();
+   ostringstream os;
+
+   os << "# TYPE graphite_uptime_seconds gauge" << endl;
+   os << "graphite_uptime_seconds " << ((time - m_start_time) / 1000000) << endl;
+
+   // Simulated time, cycles and instructions of the local tiles
+   const Config::TileList& local_tiles = Config::getSingleton()->getTileListForCurrentProcess();
+   UInt64 total_instructions = 0;
+   UInt64 min_time = UINT64_MAX_;
+   UInt64 max_time = 0;
+
+   os << "# TYPE graphite_tile_simulated_time_ns gauge" << endl;
+   for (UInt32 i = 0; i < local_tiles.size(); i++)
+   {
+      const CoreCounters& counters = m_cores[local_tiles[i]];
+      if (counters.cycle_count == NULL)
+         continue;
+      // The frequency in GHz: cycles / frequency is in ns
+      UInt64 cycle_count = *counters.cycle_count;
+      float frequency = *counters.frequency;
+      UInt64 simulated_time = (frequency > 0) ? (UInt64) (cycle_count / frequency) : 0;
+      total_instructions += *counters.instruction_count;
+      min_time = std::min(min_time, simulated_time);
+      max_time = std::max(max_time, simulated_time);
+      os << "graphite_tile_simulated_time_ns{tile=\"" << local_tiles[i] << "\"} " << simulated_time << endl;
+   }
+   os << "# TYPE graphite_tile_cycles counter" << endl;
+   for (UInt32 i = 0; i < local_tiles.size(); i++)
+   {
+      const CoreCounters& counters = m_cores[local_tiles[i]];
+      if (counters.cycle_count)
+         os << "graphite_tile_cycles{tile=\"" << local_tiles[i] << "\"} " << *counters.cycle_count << endl;
+   }
+   os << "# TYPE graphite_tile_instructions counter" << endl;
+   for (UInt32 i = 0; i < local_tiles.size(); i++)
+   {
+      const CoreCounters& counters = m_cores[local_tiles[i]];
+      if (counters.instruction_count)
+         os << "graphite_tile_instructions{tile=\"" << local_tiles[i] << "\"} " << *counters.instruction_count << endl;
+   }
+
+   // Difference between the most and least advanced tiles
+   os << "# TYPE graphite_simulated_time_skew_ns gauge" << endl;
+   os << "graphite_simulated_time_skew_ns " << ((max_time >= min_time) ? (max_time - min_time) : 0) << endl;
+
+   // Instructions per us are millions of instructions per s
+   os << "# TYPE graphite_instructions counter" << endl;
+   os << "graphite_instructions " << total_instructions << endl;
+   os << "# TYPE graphite_host_mips gauge" << endl;
+   os << "graphite_host_mips " << ((double) total_instructions / std::max(time - m_start_time, (UInt64) 1)) << endl;
+   os << "# TYPE graphite_host_mips_recent gauge" << endl;
+   os << "graphite_host_mips_recent "
+      << ((double) (total_instructions - std::min(total_instructions, m_last_snapshot_instructions)) /
+          std::max(time - m_last_snapshot_time, (UInt64) 1)) << endl;
+   m_last_snapshot_time = time;
+   m_last_snapshot_instructions = total_instructions;
+
+   // Messages waiting to be received, by tile
+   TileManager* tile_manager = Sim()->getTileManager();
+   os << "# TYPE graphite_transport_queue_depth gauge" << endl;
+   for (UInt32 i = 0; i < local_tiles.size(); i++)
+   {
+      Tile* tile = tile_manager->getTileFromID(local_tiles[i]);
+      os << "graphite_transport_queue_depth{tile=\"" << local_tiles[i] << "\"} "
+         << tile->getNetwork()->getTransport()->getQueueDepth() << endl;
+   }
+
+   // Requests waiting for the MCP, in the process that runs it
+   if (Sim()->getMCP())
+   {
+      os << "# TYPE graphite_mcp_backlog gauge" << endl;
+      os << "graphite_mcp_backlog " << Sim()->getMCP()->getBacklog() << endl;
+   }
+
+   string snapshot = os.str();
+   const char* data = snapshot.c_str();
+   size_t length = snapshot.length();
+   while (length > 0)
+   {
+      ssize_t written = send(client, data, length, MSG_NOSIGNAL);
+      if (written <= 0)
+         break;
+      data += written;
+      length -= written;
+   }
+}
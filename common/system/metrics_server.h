@@ -0,0 +1,66 @@
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <string>
+#include <vector>
+
+#include "fixed_types.h"
+#include "thread.h"
+
+/*
+  Live metrics of a running simulation ([metrics_server]). Each process
+  listens on a UNIX socket and answers every connection with a snapshot of
+  its counters in the Prometheus text format, then closes it, e.g.
+     socat - UNIX-CONNECT:results/latest/metrics.0.sock
+
+  The snapshot has the simulated time, cycles and instructions of each local
+  tile, the host MIPS of the process (since the start and since the previous
+  snapshot), the messages waiting in the transport queue of each tile and
+  the requests waiting for the MCP. The skew between the tiles and a run
+  that stopped making progress are visible from outside without stopping it.
+
+  The models publish the addresses of their counters once, when they are
+  built; the server thread only reads them, so the tiles never lock or wait
+  for it. The values of a snapshot are not taken at one instant.
+ */
+class MetricsServer : public Runnable
+{
+public:
+   MetricsServer();
+   ~MetricsServer();
+
+   static bool isEnabled();
+
+   // Counters of the core model of a tile
+   void registerCore(tile_id_t tile_id, const UInt64* cycle_count, const UInt64* instruction_count,
+                     const volatile float* frequency);
+
+   void start();
+   void finish();
+
+private:
+   struct CoreCounters
+   {
+      const volatile UInt64* cycle_count;
+      const volatile UInt64* instruction_count;
+      const volatile float* frequency;
+   };
+
+   void run();
+   void writeSnapshot(SInt32 client);
+
+   std::string m_socket_path;
+   SInt32 m_socket;
+   Thread* m_thread;
+   volatile bool m_finished;
+   volatile bool m_exited;
+
+   // Indexed by tile id, only the local tiles are set
+   std::vector<CoreCounters> m_cores;
+
+   UInt64 m_start_time;
+   UInt64 m_last_snapshot_time;
+   UInt64 m_last_snapshot_instructions;
+};
+
+#endif // METRICS_SERVER_H
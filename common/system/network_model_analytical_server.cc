@@ -10,7 +10,9 @@
 
 NetworkModelAnalyticalServer::NetworkModelAnalyticalServer(Network &network,
       UnstructuredBuffer &recv_buffer)
-      : _network(network),
+      : _total_utilization(0.0),
+      _num_updates(0),
+      _network(network),
       _recv_buffer(recv_buffer)
 {
    int num_tiles = Config::getSingleton()->getTotalTiles();
@@ -40,15 +42,19 @@ void NetworkModelAnalyticalServer::update(tile_id_t tile_id)
    msg = (UtilizationMessage*)_recv_buffer.getBuffer();
    assert(msg->vpmodel != NULL);
 
+   _total_utilization += msg->ut - _local_utilizations[tile_id];
    _local_utilizations[tile_id] = msg->ut;
 
-   // compute global utilization
-   double global_utilization = 0.0;
-   for (size_t i = 0; i < _local_utilizations.size(); i++)
+   if (++_num_updates == _local_utilizations.size())
    {
-      global_utilization += _local_utilizations[i];
+      _num_updates = 0;
+      _total_utilization = 0.0;
+      for (size_t i = 0; i < _local_utilizations.size(); i++)
+         _total_utilization += _local_utilizations[i];
    }
-   global_utilization /= _local_utilizations.size();
+
+   // compute global utilization
+   double global_utilization = _total_utilization / _local_utilizations.size();
    //  assert(0 <= global_utilization && global_utilization <= 1);
    if (global_utilization < 0 || global_utilization > 1)
    {
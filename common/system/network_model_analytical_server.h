@@ -17,6 +17,11 @@ class NetworkModelAnalyticalServer
 
    private:
       std::vector<double> _local_utilizations;
+      // Sum of _local_utilizations, kept up to date on every update. It is
+      // summed again every _local_utilizations.size() updates, so the
+      // rounding errors of the updates do not accumulate
+      double _total_utilization;
+      UInt32 _num_updates;
 
       Network & _network;
       UnstructuredBuffer & _recv_buffer;
@@ -0,0 +1,244 @@
+#include <cmath>
+
+#include "sampling_manager.h"
+#include "simulator.h"
+#include "config.h"
+#include "tile_manager.h"
+#include "tile.h"
+#include "core.h"
+#include "core_model.h"
+#include "memory_manager.h"
+#include "cache.h"
+#include "log.h"
+
+SamplingManager::SamplingManager()
+   : m_started(false)
+   , m_phase(FAST_FORWARD)
+   , m_main_core(NULL)
+   , m_num_instructions(0)
+   , m_next_phase_change(UINT64_MAX_)
+   , m_next_period_start(0)
+{
+   string schedule;
+   UInt32 seed = 0;
+   try
+   {
+      schedule = Sim()->getCfg()->getString("sampling/schedule", "periodic");
+      m_period = Sim()->getCfg()->getInt("sampling/period", 10000000);
+      m_warmup_window = Sim()->getCfg()->getInt("sampling/warmup_window", 100000);
+      m_detailed_window = Sim()->getCfg()->getInt("sampling/detailed_window", 100000);
+      seed = Sim()->getCfg()->getInt("sampling/seed", 1);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read sampling parameters from the cfg file");
+   }
+
+   m_schedule = parseSchedule(schedule);
+   m_random.seed(seed);
+
+   LOG_ASSERT_ERROR(m_detailed_window > 0, "sampling/detailed_window must be > 0");
+   LOG_ASSERT_ERROR(m_period >= (m_warmup_window + m_detailed_window),
+                    "sampling/period(%llu) must be at least sampling/warmup_window(%llu) + sampling/detailed_window(%llu)",
+                    m_period, m_warmup_window, m_detailed_window);
+   // The schedule follows the main thread and switches the models of all the tiles
+   LOG_ASSERT_ERROR(Config::getSingleton()->getProcessCount() == 1,
+                    "Sampled simulation only works with a single process");
+   LOG_ASSERT_ERROR(!Sim()->getCfg()->getBool("general/trigger_models_within_application", false),
+                    "Sampled simulation enables the models itself, general/trigger_models_within_application must be false");
+}
+
+SamplingManager::~SamplingManager()
+{}
+
+SamplingManager::Schedule
+SamplingManager::parseSchedule(string schedule)
+{
+   if (schedule == "periodic")
+      return PERIODIC;
+   else if (schedule == "random")
+      return RANDOM;
+   else
+   {
+      LOG_PRINT_ERROR("Unrecognized sampling schedule(%s)", schedule.c_str());
+      return NUM_SCHEDULES;
+   }
+}
+
+void
+SamplingManager::start()
+{
+   m_main_core = Sim()->getTileManager()->getCurrentCore();
+   LOG_ASSERT_ERROR(m_main_core, "Sampling must be started by the main thread");
+
+   m_started = true;
+   m_phase = FAST_FORWARD;
+   m_num_instructions = 0;
+   m_next_period_start = 0;
+   scheduleWindow();
+}
+
+void
+SamplingManager::stop()
+{
+   // A window that is not over is not measured
+   if (m_phase != FAST_FORWARD)
+      Sim()->disableModels();
+
+   m_started = false;
+   m_phase = FAST_FORWARD;
+   m_next_phase_change = UINT64_MAX_;
+}
+
+void
+SamplingManager::scheduleWindow()
+{
+   // One window in every period: at its end with the periodic schedule (so
+   // the first period is fast-forwarded) and anywhere in it with the random one
+   UInt64 latest_offset = m_period - m_warmup_window - m_detailed_window;
+   UInt64 offset = latest_offset;
+   if (m_schedule == RANDOM)
+   {
+      UInt64 random = (((UInt64) m_random.next(65536)) << 16) | m_random.next(65536);
+      offset = random % (latest_offset + 1);
+   }
+
+   m_next_phase_change = m_next_period_start + offset;
+   m_next_period_start += m_period;
+}
+
+bool
+SamplingManager::changePhase()
+{
+   switch (m_phase)
+   {
+   case FAST_FORWARD:
+      Sim()->enableModels();
+      if (m_warmup_window > 0)
+      {
+         m_phase = DETAILED_WARMUP;
+         m_next_phase_change = m_num_instructions + m_warmup_window;
+      }
+      else
+      {
+         startMeasurement();
+      }
+      return true;
+
+   case DETAILED_WARMUP:
+      startMeasurement();
+      return false;
+
+   case MEASUREMENT:
+      endMeasurement();
+      Sim()->disableModels();
+      m_phase = FAST_FORWARD;
+      scheduleWindow();
+      return true;
+
+   default:
+      LOG_PRINT_ERROR("Unrecognized sampling phase(%u)", m_phase);
+      return false;
+   }
+}
+
+void
+SamplingManager::startMeasurement()
+{
+   m_phase = MEASUREMENT;
+   m_next_phase_change = m_num_instructions + m_detailed_window;
+   takeSnapshot(m_snapshot);
+}
+
+void
+SamplingManager::endMeasurement()
+{
+   Snapshot snapshot;
+   takeSnapshot(snapshot);
+
+   UInt64 cycles = snapshot.cycle_count - m_snapshot.cycle_count;
+   UInt64 instructions = snapshot.instruction_count - m_snapshot.instruction_count;
+   UInt64 l1_dcache_accesses = snapshot.l1_dcache_accesses - m_snapshot.l1_dcache_accesses;
+   UInt64 l2_cache_accesses = snapshot.l2_cache_accesses - m_snapshot.l2_cache_accesses;
+
+   if (cycles > 0)
+      m_ipc_samples.push_back(((double) instructions) / cycles);
+   if (l1_dcache_accesses > 0)
+      m_l1_dcache_miss_rate_samples.push_back(100.0 * (snapshot.l1_dcache_misses - m_snapshot.l1_dcache_misses) / l1_dcache_accesses);
+   if (l2_cache_accesses > 0)
+      m_l2_cache_miss_rate_samples.push_back(100.0 * (snapshot.l2_cache_misses - m_snapshot.l2_cache_misses) / l2_cache_accesses);
+}
+
+void
+SamplingManager::takeSnapshot(Snapshot& snapshot)
+{
+   // The window lasts as long as the main thread's core runs it and
+   // includes the instructions that all the cores executed in that time.
+   // The counters of the other cores are read as they are
+   snapshot.cycle_count = m_main_core->getPerformanceModel()->getCycleCount();
+   snapshot.instruction_count = 0;
+   snapshot.l1_dcache_accesses = 0;
+   snapshot.l1_dcache_misses = 0;
+   snapshot.l2_cache_accesses = 0;
+   snapshot.l2_cache_misses = 0;
+
+   for (UInt32 i = 0; i < Config::getSingleton()->getNumLocalTiles(); i++)
+   {
+      Tile* tile = Sim()->getTileManager()->getTileFromIndex(i);
+
+      CoreModel* core_model = tile->getCore()->getPerformanceModel();
+      if (core_model)
+         snapshot.instruction_count += core_model->getInstructionCount();
+
+      MemoryManager* memory_manager = tile->getMemoryManager();
+      if (memory_manager)
+      {
+         Cache* l1_dcache = memory_manager->getL1DCache();
+         snapshot.l1_dcache_accesses += l1_dcache->getNumAccesses();
+         snapshot.l1_dcache_misses += l1_dcache->getNumMisses();
+
+         Cache* l2_cache = memory_manager->getL2Cache();
+         snapshot.l2_cache_accesses += l2_cache->getNumAccesses();
+         snapshot.l2_cache_misses += l2_cache->getNumMisses();
+      }
+   }
+}
+
+void
+SamplingManager::outputStatistic(std::ostream& os, string name, const std::vector<double>& samples)
+{
+   if (samples.empty())
+   {
+      os << "    " << name << ": NA" << endl;
+      return;
+   }
+
+   double sum = 0.0;
+   for (UInt32 i = 0; i < samples.size(); i++)
+      sum += samples[i];
+   double mean = sum / samples.size();
+
+   // 95% confidence interval of the mean (normal approximation)
+   double confidence_interval = 0.0;
+   if (samples.size() > 1)
+   {
+      double sum_of_squares = 0.0;
+      for (UInt32 i = 0; i < samples.size(); i++)
+         sum_of_squares += (samples[i] - mean) * (samples[i] - mean);
+      double standard_deviation = sqrt(sum_of_squares / (samples.size() - 1));
+      confidence_interval = 1.96 * standard_deviation / sqrt((double) samples.size());
+   }
+
+   os << "    " << name << ": " << mean << " +/- " << confidence_interval << endl;
+}
+
+void
+SamplingManager::outputSummary(std::ostream& os)
+{
+   os << "Sampling Summary: " << endl;
+   os << "    Schedule: " << ((m_schedule == PERIODIC) ? "periodic" : "random") << endl;
+   os << "    Measured Windows: " << m_ipc_samples.size() << endl;
+   outputStatistic(os, "IPC", m_ipc_samples);
+   outputStatistic(os, "L1-D Cache Miss Rate (%)", m_l1_dcache_miss_rate_samples);
+   outputStatistic(os, "L2 Cache Miss Rate (%)", m_l2_cache_miss_rate_samples);
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <ostream>
+using std::string;
+
+#include "fixed_types.h"
+#include "random.h"
+
+class Core;
+
+/*
+  Sampled simulation (SMARTS): the application runs functionally with the
+  performance models disabled, which still accesses the caches so that they
+  stay warm, and the models are only enabled for short detailed windows on a
+  periodic or random schedule. Every detailed window starts with a few
+  instructions of detailed warming (the pipeline and the other timing state)
+  before it is measured. The schedule follows the instruction count of the
+  main thread, and the mean IPC and cache miss rates of the measured windows
+  are reported with their 95% confidence intervals.
+ */
+class SamplingManager
+{
+public:
+   enum Schedule
+   {
+      PERIODIC = 0,
+      RANDOM,
+      NUM_SCHEDULES
+   };
+
+   SamplingManager();
+   ~SamplingManager();
+
+   // Around main(), in place of enabling and disabling the models
+   void start();
+   void stop();
+
+   // The main thread executed 'num_instructions' more instructions. Returns
+   // true if the performance models were switched on or off, the
+   // instrumentation must then be redone for the new phase
+   bool countInstructions(UInt32 num_instructions)
+   {
+      m_num_instructions += num_instructions;
+      if (m_num_instructions < m_next_phase_change)
+         return false;
+      return changePhase();
+   }
+
+   // Are the performance models instrumented
+   bool isDetailed() const { return (m_phase != FAST_FORWARD); }
+   // Are the memory accesses only used to warm up the caches
+   bool isWarmingCaches() const { return m_started && (m_phase == FAST_FORWARD); }
+
+   void outputSummary(std::ostream& os);
+
+private:
+   enum Phase
+   {
+      FAST_FORWARD = 0,
+      DETAILED_WARMUP,
+      MEASUREMENT
+   };
+
+   // Counters at the start of the measurement of a window
+   struct Snapshot
+   {
+      UInt64 cycle_count;
+      UInt64 instruction_count;
+      UInt64 l1_dcache_accesses;
+      UInt64 l1_dcache_misses;
+      UInt64 l2_cache_accesses;
+      UInt64 l2_cache_misses;
+   };
+
+   bool changePhase();
+   void scheduleWindow();
+   void startMeasurement();
+   void endMeasurement();
+   void takeSnapshot(Snapshot& snapshot);
+
+   static Schedule parseSchedule(string schedule);
+   static void outputStatistic(std::ostream& os, string name, const std::vector<double>& samples);
+
+   Schedule m_schedule;
+   UInt64 m_period;
+   UInt64 m_warmup_window;
+   UInt64 m_detailed_window;
+   Random m_random;
+
+   bool m_started;
+   Phase m_phase;
+   Core* m_main_core;
+   UInt64 m_num_instructions;
+   UInt64 m_next_phase_change;
+   UInt64 m_next_period_start;
+
+   Snapshot m_snapshot;
+   std::vector<double> m_ipc_samples;
+   std::vector<double> m_l1_dcache_miss_rate_samples;
+   std::vector<double> m_l2_cache_miss_rate_samples;
+};
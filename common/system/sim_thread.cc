@@ -4,6 +4,7 @@
 #include "simulator.h"
 #include "tile.h"
 #include "sim_thread_manager.h"
+#include "host_resource_manager.h"
 
 SimThread::SimThread()
    : m_thread(NULL)
@@ -18,6 +19,8 @@ SimThread::~SimThread()
 void SimThread::run()
 {
    tile_id_t tile_id = Sim()->getTileManager()->registerSimThread();
+   if (Sim()->getHostResourceManager())
+      Sim()->getHostResourceManager()->pinSimThread(Sim()->getTileManager()->getTileIndexFromID(tile_id));
 
    LOG_PRINT("Sim thread starting...");
 
@@ -9,7 +9,9 @@
 #include "mcp.h"
 
 SimThreadManager::SimThreadManager()
-   : m_active_threads(0)
+   : m_sim_threads(NULL)
+   , m_sim_thread_pool(NULL)
+   , m_active_threads(0)
 {
 }
 
@@ -17,10 +19,22 @@ SimThreadManager::~SimThreadManager()
 {
    LOG_ASSERT_WARNING(m_active_threads == 0,
                       "Threads still active when SimThreadManager exits.");
+
+   delete m_sim_thread_pool;
 }
 
 void SimThreadManager::spawnSimThreads()
 {
+   // Number of threads shared by all the local tiles, 0 for one sim
+   // thread per tile
+   UInt32 pool_size = Sim()->getCfg()->getInt("sim_thread/pool/size", 0);
+   if (pool_size > 0)
+   {
+      m_sim_thread_pool = new SimThreadPool(pool_size);
+      m_sim_thread_pool->spawn();
+      return;
+   }
+
    UInt32 num_sim_threads = Config::getSingleton()->getNumLocalTiles();
 
    LOG_PRINT("Starting %d threads on proc: %d.", num_sim_threads, Config::getSingleton()->getCurrentProcessNum());
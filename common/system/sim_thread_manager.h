@@ -2,6 +2,7 @@
 #define SIM_THREAD_MANAGER_H
 
 #include "sim_thread.h"
+#include "sim_thread_pool.h"
 
 class SimThreadManager
 {
@@ -17,6 +18,8 @@ public:
    
 private:
    SimThread *m_sim_threads;
+   // Used instead of m_sim_threads when [sim_thread/pool] is enabled
+   SimThreadPool *m_sim_thread_pool;
 
    Lock m_active_threads_lock;
    UInt32 m_active_threads;
@@ -0,0 +1,207 @@
+#include "sim_thread_pool.h"
+#include "sim_thread_manager.h"
+#include "tile_manager.h"
+#include "simulator.h"
+#include "config.h"
+#include "tile.h"
+#include "log.h"
+#include "host_resource_manager.h"
+#include "transport.h"
+
+SimThreadPool::SimThreadPool(UInt32 num_threads)
+   : m_num_threads(num_threads)
+   , m_num_idle_workers(0)
+   , m_num_wakeups(0)
+{
+   m_num_tiles = Config::getSingleton()->getNumLocalTiles();
+   LOG_ASSERT_ERROR(m_num_threads > 0, "Sim thread pool needs at least one thread");
+   if (m_num_threads > m_num_tiles)
+      m_num_threads = m_num_tiles;
+
+   try
+   {
+      m_spin_count = Sim()->getCfg()->getInt("sim_thread/pool/spin_count", 1000);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read sim_thread/pool parameters from the cfg file");
+   }
+
+   m_tile_states = new TileState[m_num_tiles];
+   for (UInt32 i = 0; i < m_num_tiles; i++)
+   {
+      TileState &state = m_tile_states[i];
+      state.m_tile_index = i;
+      state.m_network = Sim()->getTileManager()->getTileFromIndex(i)->getNetwork();
+
+      // Turn off cont when we receive a quit message.
+      // Registered up-front since any thread may handle the tile
+      state.m_network->registerCallback(SIM_THREAD_TERMINATE_THREADS,
+                                        terminateFunc,
+                                        &state.m_cont);
+   }
+   m_num_active_tiles = m_num_tiles;
+
+   m_workers = new Worker[m_num_threads];
+}
+
+SimThreadPool::~SimThreadPool()
+{
+   Transport::setArrivalCallback(NULL, NULL);
+   delete [] m_workers;
+   delete [] m_tile_states;
+}
+
+void SimThreadPool::spawn()
+{
+   LOG_PRINT("Starting %u pool threads for %u tiles", m_num_threads, m_num_tiles);
+
+   Transport::setArrivalCallback(arrivalFunc, this);
+
+   for (UInt32 i = 0; i < m_num_threads; i++)
+   {
+      m_workers[i].m_pool = this;
+      m_workers[i].m_index = i;
+      m_workers[i].m_thread = Thread::create(&m_workers[i]);
+      m_workers[i].m_thread->run();
+   }
+}
+
+bool SimThreadPool::processTile(TileState &state)
+{
+   if (state.m_terminated)
+      return false;
+
+   Transport::Node *node = state.m_network->getTransport();
+   if (!node->query())
+      return false;
+
+   // Somebody else is handling this tile
+   if (!__sync_bool_compare_and_swap(&state.m_busy, 0, 1))
+      return false;
+
+   // Check again, the previous owner may have drained the tile
+   bool worked = false;
+   if (!state.m_terminated && node->query())
+   {
+      Sim()->getTileManager()->setCurrentSimTile(state.m_tile_index);
+      state.m_network->netPullFromTransport();
+      worked = true;
+
+      if (!state.m_cont)
+      {
+         state.m_terminated = true;
+         if (__sync_sub_and_fetch(&m_num_active_tiles, 1) == 0)
+         {
+            // Let the sleeping threads exit
+            m_idle_lock.acquire();
+            m_idle_cond.broadcast();
+            m_idle_lock.release();
+         }
+      }
+   }
+
+   __sync_synchronize();
+   state.m_busy = 0;
+
+   return worked;
+}
+
+void SimThreadPool::workerRun(UInt32 worker_index)
+{
+   Sim()->getTileManager()->registerSimPoolThread();
+   if (Sim()->getHostResourceManager())
+      Sim()->getHostResourceManager()->pinSimPoolThread(worker_index);
+
+   LOG_PRINT("Sim pool thread %u starting...", worker_index);
+
+   Sim()->getSimThreadManager()->simThreadStartCallback();
+
+   UInt32 idle_rounds = 0;
+   while (m_num_active_tiles > 0)
+   {
+      bool worked = false;
+
+      // Own tiles first
+      for (UInt32 i = worker_index; i < m_num_tiles; i += m_num_threads)
+         worked = processTile(m_tile_states[i]) || worked;
+
+      // Then steal from the others, starting next to our own tiles so
+      // that idle threads do not all go after the same tile
+      for (UInt32 k = 1; (!worked) && (k < m_num_tiles); k++)
+      {
+         UInt32 i = (worker_index + k) % m_num_tiles;
+         if ((i % m_num_threads) != worker_index)
+            worked = processTile(m_tile_states[i]);
+      }
+
+      // Idle threads poll for a while, then sleep until a message arrives
+      if (worked)
+         idle_rounds = 0;
+      else if (++idle_rounds >= m_spin_count)
+      {
+         waitForWork();
+         idle_rounds = 0;
+      }
+      else
+         __asm__ __volatile__ ("pause");
+   }
+
+   Sim()->getSimThreadManager()->simThreadExitCallback();
+
+   LOG_PRINT("Sim pool thread %u exiting", worker_index);
+}
+
+void SimThreadPool::waitForWork()
+{
+   m_idle_lock.acquire();
+
+   // Counted as idle before the tiles are checked, and the arrivals check
+   // the count after queuing, so one of the two sees the other
+   m_num_idle_workers ++;
+   __sync_synchronize();
+
+   UInt64 num_wakeups = m_num_wakeups;
+   if (!hasPendingWork())
+   {
+      while ((num_wakeups == m_num_wakeups) && (m_num_active_tiles > 0))
+         m_idle_cond.wait(m_idle_lock);
+   }
+
+   m_num_idle_workers --;
+   m_idle_lock.release();
+}
+
+bool SimThreadPool::hasPendingWork()
+{
+   for (UInt32 i = 0; i < m_num_tiles; i++)
+   {
+      TileState &state = m_tile_states[i];
+      if (!state.m_terminated && state.m_network->getTransport()->query())
+         return true;
+   }
+   return false;
+}
+
+void SimThreadPool::wakeIdleWorker()
+{
+   __sync_synchronize();
+   if (m_num_idle_workers == 0)
+      return;
+
+   m_idle_lock.acquire();
+   m_num_wakeups ++;
+   m_idle_cond.signal();
+   m_idle_lock.release();
+}
+
+void SimThreadPool::arrivalFunc(void *vp)
+{
+   ((SimThreadPool*) vp)->wakeIdleWorker();
+}
+
+void SimThreadPool::terminateFunc(void *vp, NetPacket pkt)
+{
+   bool *pcont = (bool*) vp;
+   *pcont = false;
+}
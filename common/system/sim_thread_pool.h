@@ -0,0 +1,88 @@
+#ifndef SIM_THREAD_POOL_H
+#define SIM_THREAD_POOL_H
+
+#include "thread.h"
+#include "lock.h"
+#include "cond.h"
+#include "fixed_types.h"
+#include "network.h"
+
+// A fixed number of sim threads shared by all the local tiles, instead
+// of one dedicated sim thread per tile. Each thread first polls the
+// tiles it is assigned to and then steals work from the others, so
+// idle host cores pick up the message handling of busy tiles. A thread
+// that finds no work for a while sleeps until a message arrives.
+//   A tile's transport node serves as its work queue, and a tile is
+// only ever handled by one thread at a time, so callbacks see the same
+// per-tile serialization as with dedicated sim threads.
+
+class SimThreadPool
+{
+public:
+   SimThreadPool(UInt32 num_threads);
+   ~SimThreadPool();
+
+   void spawn();
+
+private:
+   class TileState
+   {
+   public:
+      TileState()
+         : m_network(NULL), m_busy(0), m_cont(true), m_terminated(false) {}
+
+      Network *m_network;
+      UInt32 m_tile_index;
+      // Owner of the tile, taken with a compare-and-swap
+      volatile SInt32 m_busy;
+      // Turned off when the tile receives a quit message
+      bool m_cont;
+      bool m_terminated;
+   };
+
+   class Worker : public Runnable
+   {
+   public:
+      Worker() : m_pool(NULL), m_index(0), m_thread(NULL) {}
+      ~Worker() { delete m_thread; }
+
+      void run() { m_pool->workerRun(m_index); }
+
+      SimThreadPool *m_pool;
+      UInt32 m_index;
+      Thread *m_thread;
+   };
+
+   // Handles the pending messages of a tile, if no other thread is
+   // doing so. Returns true if any work was done.
+   bool processTile(TileState &state);
+   void workerRun(UInt32 worker_index);
+
+   // Sleeps until a message arrives or the last tile terminates, unless
+   // there is a pending message already
+   void waitForWork();
+   bool hasPendingWork();
+   void wakeIdleWorker();
+
+   static void terminateFunc(void *vp, NetPacket pkt);
+   static void arrivalFunc(void *vp);
+
+   UInt32 m_num_threads;
+   UInt32 m_num_tiles;
+   UInt32 m_spin_count;
+
+   TileState *m_tile_states;
+   Worker *m_workers;
+
+   // Local tiles that have not received their quit message
+   volatile SInt32 m_num_active_tiles;
+
+   // The idle threads sleep on the cond, the arrivals only take the lock
+   // when there is one
+   Lock m_idle_lock;
+   ConditionVariable m_idle_cond;
+   volatile UInt32 m_num_idle_workers;
+   volatile UInt64 m_num_wakeups;
+};
+
+#endif // SIM_THREAD_POOL_H
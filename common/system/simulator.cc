@@ -8,6 +8,8 @@
 #include "mcp.h"
 #include "tile.h"
 #include "tile_manager.h"
+#include "core.h"
+#include "syscall_model.h"
 #include "thread_manager.h"
 #include "thread_scheduler.h"
 #include "performance_counter_manager.h"
@@ -15,6 +17,16 @@
 #include "clock_skew_minimization_object.h"
 #include "statistics_manager.h"
 #include "statistics_thread.h"
+#include "sampling_manager.h"
+#include "host_resource_manager.h"
+#include "host_profiler.h"
+#include "stats_registry.h"
+#include "event_tracer.h"
+#include "sharing_detector.h"
+#include "data_profiler.h"
+#include "metrics_server.h"
+#include "inter_socket_network.h"
+#include "host_memory.h"
 #include "fxsupport.h"
 #include "contrib/dsent/dsent_contrib.h"
 #include "mcpat_cache.h"
@@ -40,6 +52,8 @@ void Simulator::allocate()
 void Simulator::setConfig(config::Config *cfg)
 {
    m_config_file = cfg;
+   // Every key is in by now (cfg file and command line), the tiles only read it
+   m_config_file->compile();
 }
 
 void Simulator::release()
@@ -70,6 +84,15 @@ Simulator::Simulator()
    , m_clock_skew_minimization_manager(NULL)
    , m_statistics_manager(NULL)
    , m_statistics_thread(NULL)
+   , m_sampling_manager(NULL)
+   , m_host_resource_manager(NULL)
+   , m_host_profiler(NULL)
+   , m_stats_registry(NULL)
+   , m_event_tracer(NULL)
+   , m_sharing_detector(NULL)
+   , m_data_profiler(NULL)
+   , m_metrics_server(NULL)
+   , m_inter_socket_network(NULL)
    , m_finished(false)
    , m_boot_time(getTime())
    , m_start_time(0)
@@ -93,7 +116,9 @@ void Simulator::start()
    if (Config::getSingleton()->getEnablePowerModeling())
    { 
       string dsent_path = m_graphite_home + "/contrib/dsent";
-      dsent_contrib::DSENTInterface::allocate(dsent_path, getCfg()->getInt("general/technology_node"));
+      // The router and link evaluations are also kept in DSENT_cache_file, across runs
+      dsent_contrib::DSENTInterface::allocate(dsent_path, getCfg()->getInt("general/technology_node"),
+                                              getModelCacheFile("general/DSENT_cache_file", "dsent.cache"));
   }
   
    // McPAT for cache power and area modeling
@@ -102,7 +127,33 @@ void Simulator::start()
       McPATCache::allocate();
    }
  
+   // Named counters, registered by the models of the tiles as they are built
+   if (StatsRegistry::isEnabled())
+      m_stats_registry = new StatsRegistry();
+   // Spans in simulated time, recorded by the models as they run
+   if (EventTracer::isEnabled())
+      m_event_tracer = new EventTracer();
+   // Lines written by several tiles
+   if (SharingDetector::isEnabled())
+      m_sharing_detector = new SharingDetector();
+   // Misses and coherence traffic by allocation site
+   if (DataProfiler::isEnabled())
+      m_data_profiler = new DataProfiler();
+   if (m_config_file->getBool("statistics_trace/enabled"))
+      m_statistics_manager = new StatisticsManager();
+   // Live metrics, read from the counters the tiles publish as they are built
+   if (MetricsServer::isEnabled())
+      m_metrics_server = new MetricsServer();
+
+   // Links between the sockets, used by the network models of the tiles
+   if (m_config.getNumSockets() > 1)
+      m_inter_socket_network = new InterSocketNetwork();
+
    m_transport = Transport::create();
+   // Placement of the threads on the host cores, and of the tiles' state
+   // in the host memory as they are built
+   if (HostResourceManager::isEnabled())
+      m_host_resource_manager = new HostResourceManager();
    m_tile_manager = new TileManager();
    m_thread_manager = new ThreadManager(m_tile_manager);
    m_thread_scheduler = ThreadScheduler::create(m_thread_manager, m_tile_manager);
@@ -110,14 +161,22 @@ void Simulator::start()
    m_sim_thread_manager = new SimThreadManager();
    m_clock_skew_minimization_manager = ClockSkewMinimizationManager::create(getCfg()->getString("clock_skew_minimization/scheme"));
    
-   // For periodically measuring statistics
-   if (m_config_file->getBool("statistics_trace/enabled"))
+   // For periodically measuring statistics (the thread is started once
+   // the tiles have registered their counters)
+   if (m_statistics_manager)
    {
-      m_statistics_manager = new StatisticsManager();
       m_statistics_thread = new StatisticsThread(m_statistics_manager);
       m_statistics_thread->start();
    }
 
+   // Sampled simulation (detailed windows between functional fast-forwarding)
+   if (m_config_file->getBool("sampling/enabled", false))
+      m_sampling_manager = new SamplingManager();
+
+   // Host cycles spent in the analysis routines and the sim thread callbacks
+   if (HostProfiler::isEnabled())
+      m_host_profiler = new HostProfiler();
+
    // Save floating-point registers on context switch from user space to pin space
    Fxsupport::allocate();
 
@@ -129,15 +188,55 @@ void Simulator::start()
    m_lcp_thread = Thread::create(m_lcp);
    m_lcp_thread->run();
 
+   if (m_metrics_server)
+      m_metrics_server->start();
+
    Instruction::initializeStaticInstructionModel();
 }
 
+string Simulator::getModelCacheFile(string key, string name)
+{
+   string file;
+   string warm_cache_dir;
+   try
+   {
+      file = getCfg()->getString(key, "");
+      warm_cache_dir = getCfg()->getString("general/warm_cache_dir", "");
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read %s or general/warm_cache_dir from the cfg file", key.c_str());
+   }
+   if (file != "")
+      return file;
+
+   // Set by the spawn daemon (tools/carbon_simd.py) for the runs it starts
+   if (warm_cache_dir == "")
+   {
+      char* warm_cache_dir_str = getenv("CARBON_WARM_CACHE_DIR");
+      if (warm_cache_dir_str)
+         warm_cache_dir = warm_cache_dir_str;
+   }
+   if (warm_cache_dir == "")
+      return "";
+   return warm_cache_dir + "/" + name;
+}
+
 Simulator::~Simulator()
 {
    m_shutdown_time = getTime();
 
    LOG_PRINT("Simulator dtor starting...");
 
+   // The main thread does not exit through the thread manager
+   Core* core = m_tile_manager->getCurrentCore();
+   if (core)
+      core->getSyscallMdl()->flushWrites();
+
+   // Before the MCP and the tiles it reads go away
+   if (m_metrics_server)
+      m_metrics_server->finish();
+
    broadcastFinish();
 
    endMCP();
@@ -151,6 +250,14 @@ Simulator::~Simulator()
 
    m_lcp->finish();
 
+   // Each process writes the spans of its own tiles
+   if (m_event_tracer)
+      m_event_tracer->output();
+   if (m_sharing_detector)
+      m_sharing_detector->output();
+   if (m_data_profiler)
+      m_data_profiler->output();
+
    if (Config::getSingleton()->getCurrentProcessNum() == 0)
    {
       ofstream os(Config::getSingleton()->getOutputFileName().c_str());
@@ -163,6 +270,23 @@ Simulator::~Simulator()
          << "shutdown time\t" << (m_shutdown_time - m_boot_time) << endl;
 
       m_tile_manager->outputSummary(os);
+      m_thread_scheduler->outputSummary(os);
+      if (m_inter_socket_network)
+         m_inter_socket_network->outputSummary(os);
+      if (m_sampling_manager)
+         m_sampling_manager->outputSummary(os);
+      if (m_host_resource_manager)
+         m_host_resource_manager->outputSummary(os);
+      if (m_host_profiler)
+         m_host_profiler->outputSummary(os);
+      if (Config::getSingleton()->isMemoryReportEnabled())
+      {
+         os << "Host Memory Summary:" << endl;
+         os << "    Memory Mode: " << (Config::getSingleton()->isScaleMemoryMode() ? "scale" : "normal") << endl;
+         os << "    Heap In Use (in MB): " << (HostMemory::getHeapBytesInUse() >> 20) << endl;
+         os << "    Resident (in MB): " << (HostMemory::getResidentBytes() >> 20) << endl;
+         os << "    Peak Resident (in MB): " << (HostMemory::getPeakResidentBytes() >> 20) << endl;
+      }
       os.close();
    }
    else
@@ -184,6 +308,15 @@ Simulator::~Simulator()
       delete m_statistics_manager;
    }
   
+   if (m_sampling_manager)
+      delete m_sampling_manager;
+
+   if (m_host_resource_manager)
+      delete m_host_resource_manager;
+
+   if (m_host_profiler)
+      delete m_host_profiler;
+
    // Clock Skew Manager 
    if (m_clock_skew_minimization_manager)
       delete m_clock_skew_minimization_manager;
@@ -196,6 +329,20 @@ Simulator::~Simulator()
    m_tile_manager = NULL;
    delete m_transport;
 
+   // After the tiles, whose models registered their counters
+   delete m_stats_registry;
+   m_stats_registry = NULL;
+   delete m_event_tracer;
+   m_event_tracer = NULL;
+   delete m_sharing_detector;
+   m_sharing_detector = NULL;
+   delete m_data_profiler;
+   m_data_profiler = NULL;
+   delete m_metrics_server;
+   m_metrics_server = NULL;
+   delete m_inter_socket_network;
+   m_inter_socket_network = NULL;
+
    // Release McPAT cache object
    if (Config::getSingleton()->getEnablePowerModeling() || Config::getSingleton()->getEnableAreaModeling())
       McPATCache::release();
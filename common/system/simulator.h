@@ -17,6 +17,15 @@ class SimThreadManager;
 class ClockSkewMinimizationManager;
 class StatisticsManager;
 class StatisticsThread;
+class SamplingManager;
+class HostResourceManager;
+class HostProfiler;
+class StatsRegistry;
+class EventTracer;
+class SharingDetector;
+class DataProfiler;
+class MetricsServer;
+class InterSocketNetwork;
 
 class Simulator
 {
@@ -41,6 +50,16 @@ public:
    ClockSkewMinimizationManager *getClockSkewMinimizationManager() { return m_clock_skew_minimization_manager; }
    StatisticsManager *getStatisticsManager() { return m_statistics_manager; } 
    StatisticsThread *getStatisticsThread() { return m_statistics_thread; } 
+   SamplingManager *getSamplingManager() { return m_sampling_manager; }
+   HostResourceManager *getHostResourceManager() { return m_host_resource_manager; }
+   HostProfiler *getHostProfiler() { return m_host_profiler; }
+   StatsRegistry *getStatsRegistry() { return m_stats_registry; }
+   EventTracer *getEventTracer() { return m_event_tracer; }
+   SharingDetector *getSharingDetector() { return m_sharing_detector; }
+   DataProfiler *getDataProfiler() { return m_data_profiler; }
+   MetricsServer *getMetricsServer() { return m_metrics_server; }
+   // NULL with a single socket
+   InterSocketNetwork *getInterSocketNetwork() { return m_inter_socket_network; }
    Config *getConfig() { return &m_config; }
    config::Config *getCfg() { return m_config_file; }
 
@@ -49,6 +68,9 @@ public:
    bool finished();
 
    std::string getGraphiteHome() { return m_graphite_home; }
+   // File of the model results kept across runs: the one of the cfg 'key',
+   // or else 'name' in the warm cache directory, if any ("" if none)
+   std::string getModelCacheFile(std::string key, std::string name);
 
    void enableModels();
    void disableModels();
@@ -86,6 +108,15 @@ private:
    ClockSkewMinimizationManager *m_clock_skew_minimization_manager;
    StatisticsManager *m_statistics_manager;
    StatisticsThread *m_statistics_thread;
+   SamplingManager *m_sampling_manager;
+   HostResourceManager *m_host_resource_manager;
+   HostProfiler *m_host_profiler;
+   StatsRegistry *m_stats_registry;
+   EventTracer *m_event_tracer;
+   SharingDetector *m_sharing_detector;
+   DataProfiler *m_data_profiler;
+   MetricsServer *m_metrics_server;
+   InterSocketNetwork *m_inter_socket_network;
 
    static Simulator *m_singleton;
 
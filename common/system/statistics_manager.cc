@@ -1,13 +1,48 @@
+#include <sstream>
+
 #include "statistics_manager.h"
 #include "simulator.h"
+#include "tile_manager.h"
 #include "config.h"
 #include "memory_manager.h"
 #include "network.h"
+#include "cache_power_model.h"
+#include "router_power_model.h"
+#include "link_power_model.h"
+#include "thermal_model.h"
+#include "reuse_distance_profiler.h"
 #include "utils.h"
 #include "log.h"
 
+using namespace std;
+
+StatisticsManager::TileCounters::TileCounters()
+{
+   for (SInt32 i = 0; i < NUM_COUNTERS; i++)
+   {
+      address[i] = NULL;
+      multiplier[i] = 1;
+      epoch[0][i] = 0;
+      epoch[1][i] = 0;
+   }
+   frequency = NULL;
+   reuse_distance_profiler = NULL;
+   for (SInt32 i = 0; i < NUM_POWER_COMPONENTS; i++)
+   {
+      energy[0][i] = 0;
+      energy[1][i] = 0;
+   }
+}
+
 StatisticsManager::StatisticsManager()
+   : _tile_counters(Config::getSingleton()->getTotalTiles())
+   , _current_epoch(0)
+   , _reuse_distance_line_size(0)
+   , _thermal_model(NULL)
 {
+   for (SInt32 i = 0; i < NUM_STATISTIC_TYPES; i++)
+      _statistic_enabled[i] = false;
+
    string enabled_statistics_line;
    try
    {
@@ -25,6 +60,7 @@ StatisticsManager::StatisticsManager()
    for (vector<string>::iterator it = enabled_statistics.begin(); it != enabled_statistics.end(); it ++)
    {
       StatisticType type = parseType(*it);
+      LOG_ASSERT_ERROR(type != NUM_STATISTIC_TYPES, "Unrecognized statistic(%s)", it->c_str());
       _statistic_enabled[type] = true;
    }
   
@@ -36,6 +72,7 @@ StatisticsManager::~StatisticsManager()
 {
    // Close trace files
    closeTraceFiles();
+   delete _thermal_model;
 }
 
 void
@@ -55,6 +92,51 @@ StatisticsManager::openTraceFiles()
             Network::openUtilizationTraceFiles();
             break;
 
+         case NETWORK_LATENCY:
+            Network::openLatencyTraceFiles();
+            break;
+
+         case IPC:
+            _ipc_trace_file.open(Config::getSingleton()->formatOutputFileName("ipc.dat").c_str());
+            break;
+
+         case CACHE_MISS_RATE:
+            _cache_miss_rate_trace_file.open(Config::getSingleton()->formatOutputFileName("cache_miss_rate.dat").c_str());
+            break;
+
+         case POWER:
+            LOG_ASSERT_ERROR(Config::getSingleton()->getEnablePowerModeling(),
+                             "The power trace needs [general/enable_power_modeling] = true");
+            {
+               ostringstream filename;
+               filename << "power." << Config::getSingleton()->getCurrentProcessNum() << ".dat";
+               _power_trace_file.open(Config::getSingleton()->formatOutputFileName(filename.str()).c_str());
+            }
+            break;
+
+         case TEMPERATURE:
+            LOG_ASSERT_ERROR(Config::getSingleton()->getEnablePowerModeling(),
+                             "The temperature trace needs [general/enable_power_modeling] = true");
+            // The neighbors of a tile may be in any process
+            LOG_ASSERT_ERROR(Config::getSingleton()->getProcessCount() == 1,
+                             "The temperature trace needs a single process, not (%u)",
+                             Config::getSingleton()->getProcessCount());
+            _thermal_model = new ThermalModel();
+            _temperature_trace_file.open(Config::getSingleton()->formatOutputFileName("temperature.dat").c_str());
+            break;
+
+         case REUSE_DISTANCE:
+            _reuse_distance_trace_file.open(Config::getSingleton()->formatOutputFileName("reuse_distance.dat").c_str());
+            break;
+
+         case CPI_STACK:
+            _cpi_stack_trace_file.open(Config::getSingleton()->formatOutputFileName("cpi_stack.dat").c_str());
+            _cpi_stack_trace_file << "#";
+            for (UInt32 c = 0; c < CpiStack::NUM_COMPONENTS; c++)
+               _cpi_stack_trace_file << " <" << CpiStack::getName(c) << ">";
+            _cpi_stack_trace_file << " of the application tiles, then of each of them" << endl;
+            break;
+
          default:
             LOG_PRINT_ERROR("Unrecognized Statistic Type(%i)", i);
             break;
@@ -80,6 +162,34 @@ StatisticsManager::closeTraceFiles()
             Network::closeUtilizationTraceFiles();
             break;
 
+         case NETWORK_LATENCY:
+            Network::closeLatencyTraceFiles();
+            break;
+
+         case IPC:
+            _ipc_trace_file.close();
+            break;
+
+         case CACHE_MISS_RATE:
+            _cache_miss_rate_trace_file.close();
+            break;
+
+         case POWER:
+            _power_trace_file.close();
+            break;
+
+         case TEMPERATURE:
+            _temperature_trace_file.close();
+            break;
+
+         case REUSE_DISTANCE:
+            _reuse_distance_trace_file.close();
+            break;
+
+         case CPI_STACK:
+            _cpi_stack_trace_file.close();
+            break;
+
          default:
             LOG_PRINT_ERROR("Unrecognized Statistic Type(%i)", i);
             break;
@@ -89,8 +199,10 @@ StatisticsManager::closeTraceFiles()
 }
 
 void
-StatisticsManager::outputPeriodicSummary()
+StatisticsManager::outputPeriodicSummary(UInt64 time)
 {
+   sampleCounters();
+
    for (SInt32 i = 0; i < NUM_STATISTIC_TYPES; i++)
    {
       if (_statistic_enabled[i])
@@ -105,6 +217,34 @@ StatisticsManager::outputPeriodicSummary()
             Network::outputUtilizationSummary();
             break;
 
+         case NETWORK_LATENCY:
+            Network::outputLatencySummary();
+            break;
+
+         case IPC:
+            outputIPCSummary();
+            break;
+
+         case CACHE_MISS_RATE:
+            outputCacheMissRateSummary();
+            break;
+
+         case POWER:
+            outputPowerSummary(time);
+            break;
+
+         case TEMPERATURE:
+            outputTemperatureSummary(time);
+            break;
+
+         case REUSE_DISTANCE:
+            outputReuseDistanceSummary(time);
+            break;
+
+         case CPI_STACK:
+            outputCpiStackSummary();
+            break;
+
          default:
             LOG_PRINT_ERROR("Unrecognized Statistic Type(%i)", i);
             break;
@@ -113,6 +253,317 @@ StatisticsManager::outputPeriodicSummary()
    }
 }
    
+void
+StatisticsManager::registerCounter(tile_id_t tile_id, Counter counter, const UInt64* address, UInt64 multiplier)
+{
+   // Each tile only touches its own entry
+   TileCounters& tile_counters = _tile_counters[tile_id];
+   tile_counters.address[counter] = address;
+   tile_counters.multiplier[counter] = multiplier;
+}
+
+void
+StatisticsManager::sampleCounters()
+{
+   // The models keep updating their counters while they are read, a sample
+   // may be off by what happens meanwhile but nothing is lost
+   _current_epoch = 1 - _current_epoch;
+
+   const Config::TileList& tile_list = Config::getSingleton()->getTileListForCurrentProcess();
+   for (UInt32 i = 0; i < tile_list.size(); i++)
+   {
+      TileCounters& tile_counters = _tile_counters[tile_list[i]];
+      UInt64* epoch = tile_counters.epoch[_current_epoch];
+      for (SInt32 c = 0; c < NUM_COUNTERS; c++)
+      {
+         const volatile UInt64* address = tile_counters.address[c];
+         epoch[c] = address ? (*address * tile_counters.multiplier[c]) : 0;
+      }
+      if (_statistic_enabled[POWER] || _statistic_enabled[TEMPERATURE])
+         sampleEnergy(tile_counters, tile_counters.energy[_current_epoch]);
+      if (tile_counters.reuse_distance_profiler)
+      {
+         ReuseDistanceProfiler* profiler = tile_counters.reuse_distance_profiler;
+         std::vector<UInt64>& reuse_distance = tile_counters.reuse_distance[_current_epoch];
+         const volatile UInt64* histogram = profiler->getHistogram();
+         for (UInt32 b = 0; b < ReuseDistanceProfiler::NUM_BUCKETS; b++)
+            reuse_distance[b] = histogram[b];
+         reuse_distance[ReuseDistanceProfiler::NUM_BUCKETS] = profiler->getNumAccesses();
+      }
+   }
+}
+
+UInt64
+StatisticsManager::getCounterDelta(tile_id_t tile_id, Counter counter)
+{
+   const TileCounters& tile_counters = _tile_counters[tile_id];
+   UInt64 current = tile_counters.epoch[_current_epoch][counter];
+   UInt64 previous = tile_counters.epoch[1 - _current_epoch][counter];
+   // The counters are reset when the models are (re)enabled
+   return (current >= previous) ? (current - previous) : current;
+}
+
+void
+StatisticsManager::outputIPCSummary()
+{
+   // Total IPC of the application tiles, then the IPC of each of them
+   const Config::TileList& tile_list = Config::getSingleton()->getTileListForCurrentProcess();
+   UInt64 total_instructions = 0;
+   UInt64 total_cycles = 0;
+   stringstream tile_ipcs;
+
+   for (UInt32 i = 0; i < tile_list.size(); i++)
+   {
+      tile_id_t tile_id = tile_list[i];
+      if (tile_id >= (tile_id_t) Config::getSingleton()->getApplicationTiles())
+         continue;
+
+      UInt64 instructions = getCounterDelta(tile_id, INSTRUCTIONS);
+      UInt64 cycles = getCounterDelta(tile_id, CYCLES);
+      total_instructions += instructions;
+      total_cycles += cycles;
+      tile_ipcs << ", " << ((cycles > 0) ? ((double) instructions / cycles) : 0.0);
+   }
+
+   _ipc_trace_file << ((total_cycles > 0) ? ((double) total_instructions / total_cycles) : 0.0)
+                   << tile_ipcs.str() << endl;
+}
+
+void
+StatisticsManager::outputCacheMissRateSummary()
+{
+   // L1-D and L2 miss rates over all the local tiles
+   const Config::TileList& tile_list = Config::getSingleton()->getTileListForCurrentProcess();
+   UInt64 l1_dcache_accesses = 0, l1_dcache_misses = 0;
+   UInt64 l2_cache_accesses = 0, l2_cache_misses = 0;
+
+   for (UInt32 i = 0; i < tile_list.size(); i++)
+   {
+      l1_dcache_accesses += getCounterDelta(tile_list[i], L1_DCACHE_ACCESSES);
+      l1_dcache_misses += getCounterDelta(tile_list[i], L1_DCACHE_MISSES);
+      l2_cache_accesses += getCounterDelta(tile_list[i], L2_CACHE_ACCESSES);
+      l2_cache_misses += getCounterDelta(tile_list[i], L2_CACHE_MISSES);
+   }
+
+   _cache_miss_rate_trace_file << ((l1_dcache_accesses > 0) ? ((double) l1_dcache_misses / l1_dcache_accesses) : 0.0) << ", "
+                               << ((l2_cache_accesses > 0) ? ((double) l2_cache_misses / l2_cache_accesses) : 0.0) << endl;
+}
+
+void
+StatisticsManager::outputCpiStackSummary()
+{
+   // CPI stack of the application tiles over the interval (their cycles over
+   // their instructions), then the CPI stack of each of them
+   const Config::TileList& tile_list = Config::getSingleton()->getTileListForCurrentProcess();
+   UInt64 total_instructions = 0;
+   UInt64 total_cycles[CpiStack::NUM_COMPONENTS] = { 0 };
+   stringstream tile_stacks;
+
+   for (UInt32 i = 0; i < tile_list.size(); i++)
+   {
+      tile_id_t tile_id = tile_list[i];
+      if (tile_id >= (tile_id_t) Config::getSingleton()->getApplicationTiles())
+         continue;
+
+      UInt64 instructions = getCounterDelta(tile_id, INSTRUCTIONS);
+      total_instructions += instructions;
+      for (UInt32 c = 0; c < CpiStack::NUM_COMPONENTS; c++)
+      {
+         UInt64 cycles = getCounterDelta(tile_id, (Counter) (CPI_STACK_CYCLES + c));
+         total_cycles[c] += cycles;
+         tile_stacks << ", " << ((instructions > 0) ? ((double) cycles / instructions) : 0.0);
+      }
+   }
+
+   for (UInt32 c = 0; c < CpiStack::NUM_COMPONENTS; c++)
+   {
+      _cpi_stack_trace_file << ((c > 0) ? ", " : "")
+                            << ((total_instructions > 0) ? ((double) total_cycles[c] / total_instructions) : 0.0);
+   }
+   _cpi_stack_trace_file << tile_stacks.str() << endl;
+}
+
+void
+StatisticsManager::registerReuseDistanceProfiler(tile_id_t tile_id, ReuseDistanceProfiler* profiler, UInt32 line_size)
+{
+   // Only traced if enabled, the profiler is still used for the summary
+   if (!_statistic_enabled[REUSE_DISTANCE])
+      return;
+   TileCounters& tile_counters = _tile_counters[tile_id];
+   tile_counters.reuse_distance_profiler = profiler;
+   tile_counters.reuse_distance[0].resize(ReuseDistanceProfiler::NUM_BUCKETS + 1, 0);
+   tile_counters.reuse_distance[1].resize(ReuseDistanceProfiler::NUM_BUCKETS + 1, 0);
+   _reuse_distance_line_size = line_size;
+}
+
+void
+StatisticsManager::outputReuseDistanceSummary(UInt64 time)
+{
+   // Miss rate of the L2 caches of the local tiles over the interval, as
+   // fully associative LRU caches of 16 KB to 64 MB, from their reuse
+   // distances
+   static const UInt64 min_size = 16 * 1024;
+   static const UInt64 max_size = 64 * 1024 * 1024;
+   if (_reuse_distance_line_size == 0)
+      return;
+
+   std::vector<UInt64> deltas(ReuseDistanceProfiler::NUM_BUCKETS + 1, 0);
+   const Config::TileList& tile_list = Config::getSingleton()->getTileListForCurrentProcess();
+   for (UInt32 i = 0; i < tile_list.size(); i++)
+   {
+      const TileCounters& tile_counters = _tile_counters[tile_list[i]];
+      if (!tile_counters.reuse_distance_profiler)
+         continue;
+      const std::vector<UInt64>& current = tile_counters.reuse_distance[_current_epoch];
+      const std::vector<UInt64>& previous = tile_counters.reuse_distance[1 - _current_epoch];
+      for (UInt32 b = 0; b <= ReuseDistanceProfiler::NUM_BUCKETS; b++)
+         deltas[b] += (current[b] >= previous[b]) ? (current[b] - previous[b]) : current[b];
+   }
+
+   // The first line has the sizes (in KB)
+   if (_reuse_distance_trace_file.tellp() == 0)
+   {
+      _reuse_distance_trace_file << "# time (ns), L2 miss rate at";
+      for (UInt64 size = min_size; size <= max_size; size *= 2)
+         _reuse_distance_trace_file << " " << (size / 1024) << "KB";
+      _reuse_distance_trace_file << endl;
+   }
+
+   UInt64 num_accesses = deltas[ReuseDistanceProfiler::NUM_BUCKETS];
+   _reuse_distance_trace_file << time;
+   UInt64 num_hits = 0;
+   UInt32 bucket = 0;
+   for (UInt64 size = min_size; size <= max_size; size *= 2)
+   {
+      // Hits at distances below size / line_size
+      UInt32 size_log2 = floorLog2(size / _reuse_distance_line_size);
+      for (; (bucket <= size_log2) && (bucket < ReuseDistanceProfiler::NUM_BUCKETS); bucket++)
+         num_hits += deltas[bucket];
+      _reuse_distance_trace_file << ", " << ((num_accesses > 0) ? ((double) (num_accesses - std::min(num_hits, num_accesses)) / num_accesses) : 0.0);
+   }
+   _reuse_distance_trace_file << endl;
+}
+
+void
+StatisticsManager::registerFrequency(tile_id_t tile_id, const volatile float* frequency)
+{
+   _tile_counters[tile_id].frequency = frequency;
+}
+
+void
+StatisticsManager::registerPowerModel(tile_id_t tile_id, CachePowerModel* power_model)
+{
+   _tile_counters[tile_id].cache_power_models.push_back(power_model);
+}
+
+void
+StatisticsManager::registerPowerModel(tile_id_t tile_id, RouterPowerModel* power_model)
+{
+   _tile_counters[tile_id].router_power_models.push_back(power_model);
+}
+
+void
+StatisticsManager::registerPowerModel(tile_id_t tile_id, LinkPowerModel* power_model, UInt32 num_links)
+{
+   _tile_counters[tile_id].link_power_models.push_back(make_pair(power_model, num_links));
+}
+
+void
+StatisticsManager::sampleEnergy(TileCounters& tile_counters, double* energy)
+{
+   // The power models turn their event counters into energy when read
+   for (SInt32 i = 0; i < NUM_POWER_COMPONENTS; i++)
+      energy[i] = 0;
+   for (UInt32 i = 0; i < tile_counters.cache_power_models.size(); i++)
+      energy[CACHE_POWER] += tile_counters.cache_power_models[i]->getTotalDynamicEnergy();
+   for (UInt32 i = 0; i < tile_counters.router_power_models.size(); i++)
+      energy[ROUTER_POWER] += tile_counters.router_power_models[i]->getDynamicEnergy();
+   for (UInt32 i = 0; i < tile_counters.link_power_models.size(); i++)
+      energy[LINK_POWER] += tile_counters.link_power_models[i].first->getDynamicEnergy();
+}
+
+double
+StatisticsManager::getStaticPower(const TileCounters& tile_counters, PowerComponent component)
+{
+   double static_power = 0;
+   switch (component)
+   {
+   case CACHE_POWER:
+      for (UInt32 i = 0; i < tile_counters.cache_power_models.size(); i++)
+         static_power += tile_counters.cache_power_models[i]->getTotalStaticPower();
+      break;
+
+   case ROUTER_POWER:
+      for (UInt32 i = 0; i < tile_counters.router_power_models.size(); i++)
+         static_power += tile_counters.router_power_models[i]->getStaticPower();
+      break;
+
+   case LINK_POWER:
+      for (UInt32 i = 0; i < tile_counters.link_power_models.size(); i++)
+         static_power += tile_counters.link_power_models[i].first->getStaticPower() * tile_counters.link_power_models[i].second;
+      break;
+
+   default:
+      LOG_PRINT_ERROR("Unrecognized Power Component(%i)", component);
+      break;
+   }
+   return static_power;
+}
+
+double
+StatisticsManager::getPower(tile_id_t tile_id, PowerComponent component)
+{
+   // The energy of the models is taken at their frequency when built: under
+   // DVFS the power follows the events of the interval. The static power
+   // follows the temperature of the tile, if modeled
+   const TileCounters& tile_counters = _tile_counters[tile_id];
+   double dynamic_energy = tile_counters.energy[_current_epoch][component] - tile_counters.energy[1 - _current_epoch][component];
+   if (dynamic_energy < 0)
+      dynamic_energy = 0;
+   double static_power = getStaticPower(tile_counters, component);
+   if (_thermal_model && ((UInt32) tile_id < _thermal_model->getNumTiles()))
+      static_power *= _thermal_model->getLeakageFactor(tile_id);
+   return static_power + dynamic_energy / (_sampling_interval * 1e-9);
+}
+
+void
+StatisticsManager::outputPowerSummary(UInt64 time)
+{
+   // Time (in ns), then for each local tile the frequency of its core (in
+   // GHz) and the average power of its caches, routers and links over the
+   // interval (in W)
+   const Config::TileList& tile_list = Config::getSingleton()->getTileListForCurrentProcess();
+
+   _power_trace_file << time;
+   for (UInt32 i = 0; i < tile_list.size(); i++)
+   {
+      const TileCounters& tile_counters = _tile_counters[tile_list[i]];
+      _power_trace_file << ", " << (tile_counters.frequency ? *tile_counters.frequency : 0.0);
+      for (SInt32 c = 0; c < NUM_POWER_COMPONENTS; c++)
+         _power_trace_file << ", " << getPower(tile_list[i], (PowerComponent) c);
+   }
+   _power_trace_file << endl;
+}
+
+void
+StatisticsManager::outputTemperatureSummary(UInt64 time)
+{
+   // Time (in ns), then the temperature of each application tile (in C),
+   // row by row of the layout of the thermal model
+   vector<double> power(_thermal_model->getNumTiles(), 0.0);
+   for (UInt32 i = 0; i < power.size(); i++)
+   {
+      for (SInt32 c = 0; c < NUM_POWER_COMPONENTS; c++)
+         power[i] += getPower(i, (PowerComponent) c);
+   }
+   _thermal_model->update(power, _sampling_interval * 1e-9);
+
+   _temperature_trace_file << time;
+   for (UInt32 i = 0; i < power.size(); i++)
+      _temperature_trace_file << ", " << _thermal_model->getTemperature(i);
+   _temperature_trace_file << endl;
+}
+
 StatisticsManager::StatisticType
 StatisticsManager::parseType(string type)
 {
@@ -120,6 +571,20 @@ StatisticsManager::parseType(string type)
       return CACHE_LINE_REPLICATION;
    else if (type == "network_utilization")
       return NETWORK_UTILIZATION;
+   else if (type == "network_latency")
+      return NETWORK_LATENCY;
+   else if (type == "ipc")
+      return IPC;
+   else if (type == "cache_miss_rate")
+      return CACHE_MISS_RATE;
+   else if (type == "power")
+      return POWER;
+   else if (type == "temperature")
+      return TEMPERATURE;
+   else if (type == "reuse_distance")
+      return REUSE_DISTANCE;
+   else if (type == "cpi_stack")
+      return CPI_STACK;
    else
       return NUM_STATISTIC_TYPES;
 }
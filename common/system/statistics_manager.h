@@ -1,8 +1,19 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <fstream>
 using std::string;
 #include "fixed_types.h"
+#include "packet_type.h"
+#include "cpi_stack.h"
+#include "trace_file.h"
+
+class CachePowerModel;
+class RouterPowerModel;
+class LinkPowerModel;
+class ThermalModel;
+class ReuseDistanceProfiler;
 
 class StatisticsManager
 {
@@ -11,19 +22,119 @@ public:
    {
       CACHE_LINE_REPLICATION = 0,
       NETWORK_UTILIZATION,
+      NETWORK_LATENCY,
+      IPC,
+      CACHE_MISS_RATE,
+      POWER,
+      TEMPERATURE,
+      REUSE_DISTANCE,
+      CPI_STACK,
       NUM_STATISTIC_TYPES
    };
 
+   // Running counters of the tiles that the samples are taken from
+   enum Counter
+   {
+      INSTRUCTIONS = 0,
+      CYCLES,
+      L1_DCACHE_ACCESSES,
+      L1_DCACHE_MISSES,
+      L2_CACHE_ACCESSES,
+      L2_CACHE_MISSES,
+      // One per static network
+      NETWORK_FLITS_SENT,
+      NETWORK_FLITS_BROADCASTED = NETWORK_FLITS_SENT + NUM_STATIC_NETWORKS,
+      NETWORK_FLITS_RECEIVED = NETWORK_FLITS_BROADCASTED + NUM_STATIC_NETWORKS,
+      // One per CpiStack::Component (in cycles)
+      CPI_STACK_CYCLES = NETWORK_FLITS_RECEIVED + NUM_STATIC_NETWORKS,
+      NUM_COUNTERS = CPI_STACK_CYCLES + CpiStack::NUM_COMPONENTS
+   };
+
+   // Components of the power of a tile in the power trace
+   enum PowerComponent
+   {
+      CACHE_POWER = 0,
+      ROUTER_POWER,
+      LINK_POWER,
+      NUM_POWER_COMPONENTS
+   };
+
    StatisticsManager();
    ~StatisticsManager();
-   void outputPeriodicSummary();
+   // Sample at 'time' (in ns)
+   void outputPeriodicSummary(UInt64 time);
    UInt64 getSamplingInterval() { return _sampling_interval; }
 
+   // A model publishes the address of a running counter once. The counter is
+   // only written by the model; the statistics thread reads it at every
+   // sample, so the tiles are never stopped or locked (value * multiplier)
+   void registerCounter(tile_id_t tile_id, Counter counter, const UInt64* address, UInt64 multiplier = 1);
+   // Increase of a counter of a local tile over the last sampling interval
+   UInt64 getCounterDelta(tile_id_t tile_id, Counter counter);
+
+   // Frequency of the core of a tile (in GHz), written in the power trace
+   void registerFrequency(tile_id_t tile_id, const volatile float* frequency);
+   // The power models of a tile, their energy is read at every sample like
+   // the counters. A link model may stand for several links of the tile,
+   // its static power is counted num_links times
+   void registerPowerModel(tile_id_t tile_id, CachePowerModel* power_model);
+   void registerPowerModel(tile_id_t tile_id, RouterPowerModel* power_model);
+   void registerPowerModel(tile_id_t tile_id, LinkPowerModel* power_model, UInt32 num_links = 1);
+
+   // The reuse distance profiler of the L2 cache of a tile, its histogram
+   // is read at every sample like the counters
+   void registerReuseDistanceProfiler(tile_id_t tile_id, ReuseDistanceProfiler* profiler, UInt32 line_size);
+
+   // NULL unless the temperature is traced
+   ThermalModel* getThermalModel() { return _thermal_model; }
+
 private:
+   // Counters of a tile, read into two epoch buffers used in turn: the
+   // buffer of the previous sample is kept to compute the increases
+   struct TileCounters
+   {
+      TileCounters();
+      const volatile UInt64* address[NUM_COUNTERS];
+      UInt64 multiplier[NUM_COUNTERS];
+      UInt64 epoch[2][NUM_COUNTERS];
+
+      const volatile float* frequency;
+      std::vector<CachePowerModel*> cache_power_models;
+      std::vector<RouterPowerModel*> router_power_models;
+      std::vector<std::pair<LinkPowerModel*, UInt32> > link_power_models;
+      // Dynamic energy (in J), in the same epochs as the counters
+      double energy[2][NUM_POWER_COMPONENTS];
+      // Reuse distance histogram, then the accesses, in the same epochs
+      ReuseDistanceProfiler* reuse_distance_profiler;
+      std::vector<UInt64> reuse_distance[2];
+   };
+
    bool _statistic_enabled[NUM_STATISTIC_TYPES];
    UInt64 _sampling_interval;
 
+   std::vector<TileCounters> _tile_counters;
+   UInt32 _current_epoch;
+   TraceFile _ipc_trace_file;
+   TraceFile _cache_miss_rate_trace_file;
+   TraceFile _power_trace_file;
+   TraceFile _temperature_trace_file;
+   TraceFile _reuse_distance_trace_file;
+   TraceFile _cpi_stack_trace_file;
+   UInt32 _reuse_distance_line_size;
+   ThermalModel* _thermal_model;
+
    void openTraceFiles();
    void closeTraceFiles();
+   void sampleCounters();
+   void outputIPCSummary();
+   void outputCacheMissRateSummary();
+   void outputCpiStackSummary();
+   void sampleEnergy(TileCounters& tile_counters, double* energy);
+   double getStaticPower(const TileCounters& tile_counters, PowerComponent component);
+   // Average power of a component of a tile over the last sampling interval
+   double getPower(tile_id_t tile_id, PowerComponent component);
+   void outputPowerSummary(UInt64 time);
+   void outputTemperatureSummary(UInt64 time);
+   void outputReuseDistanceSummary(UInt64 time);
    StatisticType parseType(string type);
 };
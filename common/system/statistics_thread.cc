@@ -35,7 +35,7 @@ StatisticsThread::run()
       {
          assert(_flag);
          // Call statistics manager
-         _statistics_manager->outputPeriodicSummary();
+         _statistics_manager->outputPeriodicSummary(_time);
          _flag = false;
       }
    }
@@ -0,0 +1,251 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "stats_registry.h"
+#include "simulator.h"
+#include "config.h"
+#include "log.h"
+
+using namespace std;
+
+const UInt32 StatsRegistry::VERSION;
+
+StatsRegistry::StatsRegistry()
+{
+}
+
+StatsRegistry::~StatsRegistry()
+{
+}
+
+string
+StatsRegistry::getFileName()
+{
+   try
+   {
+      return Sim()->getCfg()->getString("general/stats_file", "");
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read general/stats_file from the cfg file");
+      return "";
+   }
+}
+
+bool
+StatsRegistry::isEnabled()
+{
+   return !getFileName().empty();
+}
+
+void
+StatsRegistry::registerCounter(tile_id_t tile_id, const string& name, const UInt64* counter, UInt64 multiplier)
+{
+   add(tile_id, Counter(name, UINT64, counter, multiplier));
+}
+
+void
+StatsRegistry::registerCounter(tile_id_t tile_id, const string& name, const double* counter)
+{
+   add(tile_id, Counter(name, DOUBLE, counter, 1));
+}
+
+void
+StatsRegistry::add(tile_id_t tile_id, const Counter& counter)
+{
+   ScopedLock sl(m_lock);
+   m_counters[tile_id].push_back(counter);
+}
+
+static void appendBytes(string& str, const void* data, UInt32 length)
+{
+   str.append((const char*) data, length);
+}
+
+string
+StatsRegistry::pack(tile_id_t tile_id)
+{
+   ScopedLock sl(m_lock);
+
+   string packed;
+   const vector<Counter>& counters = m_counters[tile_id];
+   UInt32 num_counters = counters.size();
+   appendBytes(packed, &num_counters, sizeof(num_counters));
+
+   for (UInt32 i = 0; i < num_counters; i++)
+   {
+      const Counter& counter = counters[i];
+      UInt8 type = counter.type;
+      UInt32 length = counter.name.length();
+      appendBytes(packed, &type, sizeof(type));
+      appendBytes(packed, &length, sizeof(length));
+      appendBytes(packed, counter.name.data(), length);
+
+      if (counter.type == UINT64)
+      {
+         UInt64 value = *((const UInt64*) counter.address) * counter.multiplier;
+         appendBytes(packed, &value, sizeof(value));
+      }
+      else
+      {
+         double value = *((const double*) counter.address);
+         appendBytes(packed, &value, sizeof(value));
+      }
+   }
+   return packed;
+}
+
+void
+StatsRegistry::getCounterNames(tile_id_t tile_id, vector<string>& names)
+{
+   ScopedLock sl(m_lock);
+
+   const vector<Counter>& counters = m_counters[tile_id];
+   names.resize(counters.size());
+   for (UInt32 i = 0; i < counters.size(); i++)
+      names[i] = counters[i].name;
+}
+
+void
+StatsRegistry::getCounterValues(tile_id_t tile_id, vector<double>& values)
+{
+   ScopedLock sl(m_lock);
+
+   const vector<Counter>& counters = m_counters[tile_id];
+   values.resize(counters.size());
+   for (UInt32 i = 0; i < counters.size(); i++)
+   {
+      const Counter& counter = counters[i];
+      if (counter.type == UINT64)
+         values[i] = (double) (*((const UInt64*) counter.address) * counter.multiplier);
+      else
+         values[i] = *((const double*) counter.address);
+   }
+}
+
+UInt32
+StatsRegistry::load(const string& filename)
+{
+   FILE* file = fopen(filename.c_str(), "r");
+   LOG_ASSERT_ERROR(file, "Could not open stats file(%s)", filename.c_str());
+
+   char magic[4];
+   UInt32 version = 0;
+   UInt32 num_tiles = 0;
+   UInt32 num_counters = 0;
+   bool valid = (fread(magic, 1, 4, file) == 4) && (memcmp(magic, "GSTA", 4) == 0) &&
+                (fread(&version, sizeof(version), 1, file) == 1) && (version == VERSION) &&
+                (fread(&num_tiles, sizeof(num_tiles), 1, file) == 1) &&
+                (fread(&num_counters, sizeof(num_counters), 1, file) == 1);
+   LOG_ASSERT_ERROR(valid, "Not a stats file(%s)", filename.c_str());
+   LOG_ASSERT_ERROR(num_tiles == Config::getSingleton()->getTotalTiles(),
+                    "Stats file(%s) of %u tiles, this run has %u", filename.c_str(), num_tiles,
+                    Config::getSingleton()->getTotalTiles());
+
+   map<string, UInt32> columns;
+   vector<UInt8> types(num_counters);
+   for (UInt32 i = 0; i < num_counters; i++)
+   {
+      UInt32 length = 0;
+      valid = (fread(&types[i], sizeof(types[i]), 1, file) == 1) &&
+              (fread(&length, sizeof(length), 1, file) == 1);
+      string name(length, '\0');
+      valid = valid && ((length == 0) || (fread(&name[0], 1, length, file) == length));
+      LOG_ASSERT_ERROR(valid, "Truncated stats file(%s)", filename.c_str());
+      columns[name] = i;
+   }
+   vector<UInt64> values((size_t) num_counters * num_tiles);
+   valid = (values.size() == 0) || (fread(&values[0], sizeof(UInt64), values.size(), file) == values.size());
+   LOG_ASSERT_ERROR(valid, "Truncated stats file(%s)", filename.c_str());
+   fclose(file);
+
+   ScopedLock sl(m_lock);
+
+   UInt32 num_loaded = 0;
+   for (map<tile_id_t, vector<Counter> >::iterator it = m_counters.begin(); it != m_counters.end(); it++)
+   {
+      tile_id_t tile_id = it->first;
+      LOG_ASSERT_ERROR((tile_id >= 0) && ((UInt32) tile_id < num_tiles), "Invalid tile id(%i)", tile_id);
+      for (UInt32 i = 0; i < it->second.size(); i++)
+      {
+         const Counter& counter = it->second[i];
+         map<string, UInt32>::iterator column = columns.find(counter.name);
+         if (column == columns.end())
+            continue;
+         LOG_ASSERT_ERROR(types[column->second] == counter.type, "Counter(%s) of another type in the stats file",
+                          counter.name.c_str());
+
+         // The models own the counters, only the registry sees them as const
+         UInt64 value = values[(size_t) column->second * num_tiles + tile_id];
+         if (counter.type == UINT64)
+            *((UInt64*) counter.address) = value / counter.multiplier;
+         else
+            memcpy((void*) counter.address, &value, sizeof(value));
+         num_loaded ++;
+      }
+   }
+   return num_loaded;
+}
+
+void
+StatsRegistry::write(const string& filename, const vector<string>& packed_tiles)
+{
+   UInt32 num_tiles = packed_tiles.size();
+
+   // Columns in the order the counters first appear (tile 0 first)
+   vector<string> names;
+   vector<UInt8> types;
+   map<string, UInt32> columns;
+   vector<vector<UInt64> > values;
+
+   for (UInt32 t = 0; t < num_tiles; t++)
+   {
+      const char* p = packed_tiles[t].data();
+      UInt32 num_counters;
+      memcpy(&num_counters, p, sizeof(num_counters)); p += sizeof(num_counters);
+
+      for (UInt32 i = 0; i < num_counters; i++)
+      {
+         UInt8 type;
+         UInt32 length;
+         UInt64 value;
+         memcpy(&type, p, sizeof(type)); p += sizeof(type);
+         memcpy(&length, p, sizeof(length)); p += sizeof(length);
+         string name(p, length); p += length;
+         memcpy(&value, p, sizeof(value)); p += sizeof(value);
+
+         map<string, UInt32>::iterator it = columns.find(name);
+         if (it == columns.end())
+         {
+            it = columns.insert(make_pair(name, (UInt32) names.size())).first;
+            names.push_back(name);
+            types.push_back(type);
+            values.push_back(vector<UInt64>(num_tiles, 0));
+         }
+         LOG_ASSERT_ERROR(types[it->second] == type, "Counter(%s) registered with two types", name.c_str());
+         values[it->second][t] = value;
+      }
+   }
+
+   FILE* file = fopen(filename.c_str(), "w");
+   LOG_ASSERT_ERROR(file, "Could not open stats file(%s)", filename.c_str());
+
+   UInt32 num_counters = names.size();
+   fwrite("GSTA", 1, 4, file);
+   fwrite(&VERSION, sizeof(VERSION), 1, file);
+   fwrite(&num_tiles, sizeof(num_tiles), 1, file);
+   fwrite(&num_counters, sizeof(num_counters), 1, file);
+
+   for (UInt32 i = 0; i < num_counters; i++)
+   {
+      UInt32 length = names[i].length();
+      fwrite(&types[i], sizeof(types[i]), 1, file);
+      fwrite(&length, sizeof(length), 1, file);
+      fwrite(names[i].data(), 1, length, file);
+   }
+
+   for (UInt32 i = 0; i < num_counters; i++)
+      fwrite(&values[i][0], sizeof(UInt64), num_tiles, file);
+
+   fclose(file);
+}
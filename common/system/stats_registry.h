@@ -0,0 +1,81 @@
+#ifndef STATS_REGISTRY_H
+#define STATS_REGISTRY_H
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "fixed_types.h"
+#include "lock.h"
+
+/*
+  Named counters of the tiles ([general] stats_file). A model registers the
+  address of each of its counters once, when it is built, and the counters
+  are only read at the end of the run: process 0 writes them next to sim.out
+  as one binary matrix, a column per counter and a row per tile, which
+  tools/read_stats.py loads without parsing text. A tile without some
+  counter (e.g. a network model that was never created) reads 0 there.
+
+  The file also holds the raw event counters of the power models, so it can
+  be loaded back into the models of a run with the same tiles and timing
+  parameters (load(), tools/power_sweep) to recompute their power and area
+  with other power parameters without simulating again.
+
+  File layout (native byte order):
+     "GSTA", UInt32 version, UInt32 num_tiles, UInt32 num_counters
+     num_counters x (UInt8 type, UInt32 name length, name)
+     num_counters x num_tiles x 8 bytes (UInt64 or double), by counter
+ */
+class StatsRegistry
+{
+public:
+   enum CounterType
+   {
+      UINT64 = 0,
+      DOUBLE,
+   };
+
+   StatsRegistry();
+   ~StatsRegistry();
+
+   static bool isEnabled();
+   static std::string getFileName();
+
+   // The value written is *counter * multiplier (e.g. sampled sets)
+   void registerCounter(tile_id_t tile_id, const std::string& name, const UInt64* counter, UInt64 multiplier = 1);
+   void registerCounter(tile_id_t tile_id, const std::string& name, const double* counter);
+
+   // Current values of the counters of a tile, to be sent to process 0
+   std::string pack(tile_id_t tile_id);
+   // Names and current values of the counters of a local tile, in the order
+   // they were registered (later registrations are appended)
+   void getCounterNames(tile_id_t tile_id, std::vector<std::string>& names);
+   void getCounterValues(tile_id_t tile_id, std::vector<double>& values);
+   // Matrix of the packed values of all the tiles (process 0)
+   static void write(const std::string& filename, const std::vector<std::string>& packed_tiles);
+   // Set the registered counters of the local tiles to their values in a
+   // stats file. Counters missing from the file are left as they are;
+   // returns the number of counters set
+   UInt32 load(const std::string& filename);
+
+   static const UInt32 VERSION = 1;
+
+private:
+   struct Counter
+   {
+      Counter(const std::string& name_, CounterType type_, const void* address_, UInt64 multiplier_)
+         : name(name_), type(type_), address(address_), multiplier(multiplier_) {}
+      std::string name;
+      CounterType type;
+      const void* address;
+      UInt64 multiplier;
+   };
+
+   void add(tile_id_t tile_id, const Counter& counter);
+
+   // Models of a tile may be created from several threads
+   std::map<tile_id_t, std::vector<Counter> > m_counters;
+   Lock m_lock;
+};
+
+#endif // STATS_REGISTRY_H
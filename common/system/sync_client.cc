@@ -4,27 +4,77 @@
 #include "tile.h"
 #include "packetize.h"
 #include "mcp.h"
+#include "distributed_sync_server.h"
+#include "barrier_release.h"
 #include "clock_converter.h"
 #include "fxsupport.h"
 
 #include "simulator.h"
+#include "host_profiler.h"
+#include "event_tracer.h"
 #include "thread_scheduler.h"
 #include "thread_manager.h"
 
 #include <iostream>
+#include <sched.h>
 
 using namespace std;
 
+// The words of the fast mutexes, by id, allocated in chunks as the ids are
+// used. Shared by the tiles of the process and never freed
+static const UInt32 FAST_MUTEX_CHUNK_SIZE = 1024;
+static const UInt32 NUM_FAST_MUTEX_CHUNKS = 1024;
+static volatile SInt32* volatile fast_mutex_words[NUM_FAST_MUTEX_CHUNKS];
+
 SyncClient::SyncClient(Core *core)
       : m_core(core)
       , m_network(core->getTile()->getNetwork())
+      , m_distributed(DistributedSyncServer::isEnabled())
+      , m_num_homes(Config::getSingleton()->getApplicationTiles())
+      , m_num_inits(0)
+      , m_request_type(m_distributed ? SYNC_SERVER_REQUEST_TYPE : MCP_REQUEST_TYPE)
+      , m_response_type(m_distributed ? SYNC_SERVER_RESPONSE_TYPE : MCP_RESPONSE_TYPE)
+      , m_central_barrier_release(BarrierRelease::parseMode(Sim()->getCfg()->getString("sync_server/barrier_release", "central"))
+                                  == BarrierRelease::CENTRAL)
+      , m_fast_mutex(false)
 {
+   try
+   {
+      m_fast_mutex = Sim()->getCfg()->getBool("sync_server/fast_mutex", false);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read sync_server/fast_mutex from the cfg file");
+   }
+   // The words are in host memory, and the host decides who gets a free mutex
+   if (m_fast_mutex &&
+       ((Config::getSingleton()->getProcessCount() > 1) || Config::getSingleton()->isDeterministic()))
+   {
+      if (m_core->getId().tile_id == 0)
+         LOG_PRINT_WARNING("sync_server/fast_mutex needs one process and a non-deterministic run, disabled");
+      m_fast_mutex = false;
+   }
 }
 
 SyncClient::~SyncClient()
 {
 }
 
+core_id_t SyncClient::getServer(SInt32 id)
+{
+   if (!m_distributed)
+      return Config::getSingleton()->getMCPCoreId();
+   return Tile::getMainCoreId((UInt32) id % m_num_homes);
+}
+
+core_id_t SyncClient::getInitServer()
+{
+   if (!m_distributed)
+      return Config::getSingleton()->getMCPCoreId();
+   // The new objects are spread over the homes, starting with this tile
+   return Tile::getMainCoreId((m_core->getId().tile_id + m_num_inits ++) % m_num_homes);
+}
+
 void SyncClient::mutexInit(carbon_mutex_t *mux)
 {
    // Reset the buffers for the new transmission
@@ -35,10 +85,11 @@ void SyncClient::mutexInit(carbon_mutex_t *mux)
 
    m_send_buff << msg_type;
 
-   m_network->netSend(Config::getSingleton()->getMCPCoreId(), MCP_REQUEST_TYPE, m_send_buff.getBuffer(), m_send_buff.size());
+   core_id_t server = getInitServer();
+   m_network->netSend(server, m_request_type, m_send_buff.getBuffer(), m_send_buff.size());
 
    NetPacket recv_pkt;
-   recv_pkt = m_network->netRecv(Config::getSingleton()->getMCPCoreId(), m_core->getId(), MCP_RESPONSE_TYPE);
+   recv_pkt = m_network->netRecv(server, m_core->getId(), m_response_type);
    assert(recv_pkt.length == sizeof(carbon_mutex_t));
 
    *mux = *((carbon_mutex_t*)recv_pkt.data);
@@ -48,9 +99,15 @@ void SyncClient::mutexInit(carbon_mutex_t *mux)
 
 void SyncClient::mutexLock(carbon_mutex_t *mux)
 {
+   HostProfiler::Scope profile(Sim()->getHostProfiler(), HostProfiler::SYNC);
+
    // Save/Restore Floating Point state
    FloatingPointHandler floating_point_handler;
 
+   volatile SInt32* word = getFastMutexWord(*mux);
+   if (word && lockFastMutex(mux, word))
+      return;
+
    // Reset the buffers for the new transmission
    m_recv_buff.clear();
    m_send_buff.clear();
@@ -64,13 +121,14 @@ void SyncClient::mutexLock(carbon_mutex_t *mux)
    m_send_buff << msg_type << *mux << start_time;
 
    LOG_PRINT("mutexLock(): mux(%u), start_time(%llu)", *mux, start_time);
-   m_network->netSend(Config::getSingleton()->getMCPCoreId(), MCP_REQUEST_TYPE, m_send_buff.getBuffer(), m_send_buff.size());
+   core_id_t server = getServer(*mux);
+   m_network->netSend(server, m_request_type, m_send_buff.getBuffer(), m_send_buff.size());
 
    // Set the CoreState to 'STALLED'
    m_core->setState(Core::STALLED);
 
    NetPacket recv_pkt;
-   recv_pkt = m_network->netRecv(Config::getSingleton()->getMCPCoreId(), m_core->getId(), MCP_RESPONSE_TYPE);
+   recv_pkt = m_network->netRecv(server, m_core->getId(), m_response_type);
    assert(recv_pkt.length == sizeof(unsigned int) + sizeof(UInt64));
 
    // Set the CoreState to 'RUNNING'
@@ -84,23 +142,30 @@ void SyncClient::mutexLock(carbon_mutex_t *mux)
 
    m_recv_buff >> time;
 
-   if (time > start_time)
-   {
-      // Global Clock to Core Clock
-      UInt64 cycles_elapsed = convertCycleCount(time - start_time,
-            1.0, m_core->getPerformanceModel()->getFrequency());
-
-      m_core->getPerformanceModel()->queueDynamicInstruction(new SyncInstruction(cycles_elapsed));
-   }
+   m_core->wakeUp(start_time, time);
+   traceWait("mutex_lock", start_time, time);
 
    delete [](Byte*) recv_pkt.data;
 }
 
+void SyncClient::traceWait(const char* name, UInt64 start_time, UInt64 time)
+{
+   EventTracer* event_tracer = Sim()->getEventTracer();
+   if (event_tracer && event_tracer->isEnabled(EventTracer::SYNC) && (time > start_time))
+      event_tracer->record(EventTracer::SYNC, name, m_core->getTile()->getId(), start_time, time);
+}
+
 void SyncClient::mutexUnlock(carbon_mutex_t *mux)
 {
+   HostProfiler::Scope profile(Sim()->getHostProfiler(), HostProfiler::SYNC);
+
    // Save/Restore Floating Point state
    FloatingPointHandler floating_point_handler;
 
+   volatile SInt32* word = getFastMutexWord(*mux);
+   if (word && unlockFastMutex(mux, word))
+      return;
+
    // Reset the buffers for the new transmission
    m_recv_buff.clear();
    m_send_buff.clear();
@@ -114,10 +179,11 @@ void SyncClient::mutexUnlock(carbon_mutex_t *mux)
    m_send_buff << msg_type << *mux << start_time;
 
    LOG_PRINT("mutexUnlock(): mux(%u), start_time(%llu)", *mux, start_time);
-   m_network->netSend(Config::getSingleton()->getMCPCoreId(), MCP_REQUEST_TYPE, m_send_buff.getBuffer(), m_send_buff.size());
+   core_id_t server = getServer(*mux);
+   m_network->netSend(server, m_request_type, m_send_buff.getBuffer(), m_send_buff.size());
 
    NetPacket recv_pkt;
-   recv_pkt = m_network->netRecv(Config::getSingleton()->getMCPCoreId(), m_core->getId(), MCP_RESPONSE_TYPE);
+   recv_pkt = m_network->netRecv(server, m_core->getId(), m_response_type);
    assert(recv_pkt.length == sizeof(unsigned int));
 
    unsigned int dummy;
@@ -128,6 +194,122 @@ void SyncClient::mutexUnlock(carbon_mutex_t *mux)
    delete [](Byte*) recv_pkt.data;
 }
 
+volatile SInt32* SyncClient::getFastMutexWord(carbon_mutex_t mux)
+{
+   if (!m_fast_mutex || (mux < 0) || ((UInt32) mux >= FAST_MUTEX_CHUNK_SIZE * NUM_FAST_MUTEX_CHUNKS))
+      return NULL;
+
+   UInt32 chunk = (UInt32) mux / FAST_MUTEX_CHUNK_SIZE;
+   if (!fast_mutex_words[chunk])
+   {
+      SInt32* words = new SInt32[FAST_MUTEX_CHUNK_SIZE]();
+      if (!__sync_bool_compare_and_swap(&fast_mutex_words[chunk], NULL, words))
+         delete [] words;
+   }
+   return &fast_mutex_words[chunk][(UInt32) mux % FAST_MUTEX_CHUNK_SIZE];
+}
+
+bool SyncClient::lockFastMutex(carbon_mutex_t *mux, volatile SInt32* word)
+{
+   modelFastMutexAccess(mux);
+
+   SInt32 owner = m_core->getId().tile_id + 1;
+   while (true)
+   {
+      SInt32 state = *word;
+      if (state == FAST_MUTEX_FREE)
+      {
+         if (__sync_bool_compare_and_swap(word, FAST_MUTEX_FREE, owner))
+            return true;
+      }
+      else if (state == FAST_MUTEX_INFLATED)
+      {
+         return false;
+      }
+      else if (state == FAST_MUTEX_INFLATING)
+      {
+         sched_yield();
+      }
+      else if (inflateFastMutex(mux, word, state))
+      {
+         // Waits on the server for the owner to unlock it
+         return false;
+      }
+   }
+}
+
+bool SyncClient::unlockFastMutex(carbon_mutex_t *mux, volatile SInt32* word)
+{
+   modelFastMutexAccess(mux);
+
+   SInt32 owner = m_core->getId().tile_id + 1;
+   while (true)
+   {
+      SInt32 state = *word;
+      if (state == FAST_MUTEX_INFLATED)
+         return false;
+      if (state == FAST_MUTEX_INFLATING)
+      {
+         // The server must know the owner before it gets the unlock
+         sched_yield();
+         continue;
+      }
+      LOG_ASSERT_ERROR(state == owner, "Mutex(%i) unlocked by tile(%i), state(%i)", *mux, owner - 1, state);
+      if (__sync_bool_compare_and_swap(word, owner, FAST_MUTEX_FREE))
+         return true;
+   }
+}
+
+bool SyncClient::inflateFastMutex(carbon_mutex_t *mux, volatile SInt32* word, SInt32 owner)
+{
+   SInt32 state = *word;
+   if (state == FAST_MUTEX_INFLATED)
+      return true;
+   if ((state != owner) || !__sync_bool_compare_and_swap(word, owner, FAST_MUTEX_INFLATING))
+   {
+      sched_yield();
+      return false;
+   }
+
+   m_recv_buff.clear();
+   m_send_buff.clear();
+
+   int msg_type = MCP_MESSAGE_MUTEX_INFLATE;
+
+   // Core Clock to Global Clock
+   UInt64 start_time = convertCycleCount(m_core->getPerformanceModel()->getCycleCount(),
+         m_core->getPerformanceModel()->getFrequency(), 1.0);
+
+   m_send_buff << msg_type << *mux << Tile::getMainCoreId(owner - 1) << start_time;
+
+   LOG_PRINT("mutexInflate(): mux(%u), owner(%i), start_time(%llu)", *mux, owner - 1, start_time);
+   core_id_t server = getServer(*mux);
+   m_network->netSend(server, m_request_type, m_send_buff.getBuffer(), m_send_buff.size());
+
+   NetPacket recv_pkt;
+   recv_pkt = m_network->netRecv(server, m_core->getId(), m_response_type);
+   assert(recv_pkt.length == sizeof(unsigned int));
+   assert(*((unsigned int*) recv_pkt.data) == MUTEX_INFLATE_RESPONSE);
+   delete [](Byte*) recv_pkt.data;
+
+   __sync_synchronize();
+   *word = FAST_MUTEX_INFLATED;
+   return true;
+}
+
+void SyncClient::modelFastMutexAccess(carbon_mutex_t *mux)
+{
+   if (!Config::getSingleton()->isSimulatingSharedMemory())
+      return;
+
+   // An atomic read-modify-write of the line, the data is written back as is
+   carbon_mutex_t value;
+   UInt64 latency = m_core->accessMemory(Core::LOCK, Core::READ_EX, (IntPtr) mux, (char*) &value, sizeof(value)).second;
+   latency += m_core->accessMemory(Core::UNLOCK, Core::WRITE, (IntPtr) mux, (char*) &value, sizeof(value)).second;
+   if (latency > 0)
+      m_core->getPerformanceModel()->queueDynamicInstruction(new SyncInstruction(latency));
+}
+
 void SyncClient::condInit(carbon_cond_t *cond)
 {
    // Save/Restore Floating Point state
@@ -145,10 +327,11 @@ void SyncClient::condInit(carbon_cond_t *cond)
 
    m_send_buff << msg_type << *cond << start_time;
 
-   m_network->netSend(Config::getSingleton()->getMCPCoreId(), MCP_REQUEST_TYPE, m_send_buff.getBuffer(), m_send_buff.size());
+   core_id_t server = getInitServer();
+   m_network->netSend(server, m_request_type, m_send_buff.getBuffer(), m_send_buff.size());
 
    NetPacket recv_pkt;
-   recv_pkt = m_network->netRecv(Config::getSingleton()->getMCPCoreId(), m_core->getId(), MCP_RESPONSE_TYPE);
+   recv_pkt = m_network->netRecv(server, m_core->getId(), m_response_type);
    assert(recv_pkt.length == sizeof(carbon_cond_t));
 
    *cond = *((carbon_cond_t*)recv_pkt.data);
@@ -158,9 +341,16 @@ void SyncClient::condInit(carbon_cond_t *cond)
 
 void SyncClient::condWait(carbon_cond_t *cond, carbon_mutex_t *mux)
 {
+   HostProfiler::Scope profile(Sim()->getHostProfiler(), HostProfiler::SYNC);
+
    // Save/Restore Floating Point state
    FloatingPointHandler floating_point_handler;
 
+   // The server unlocks the mutex for the waiter and locks it again
+   volatile SInt32* word = getFastMutexWord(*mux);
+   while (word && !inflateFastMutex(mux, word, m_core->getId().tile_id + 1))
+      LOG_ASSERT_ERROR(*word != FAST_MUTEX_FREE, "condWait(): mux(%i) is not locked", *mux);
+
    // Reset the buffers for the new transmission
    m_recv_buff.clear();
    m_send_buff.clear();
@@ -174,13 +364,16 @@ void SyncClient::condWait(carbon_cond_t *cond, carbon_mutex_t *mux)
    m_send_buff << msg_type << *cond << *mux << start_time;
 
    LOG_PRINT("condWait(): cond(%u), mux(%u), start_time(%llu)", *cond, *mux, start_time);
-   m_network->netSend(Config::getSingleton()->getMCPCoreId(), MCP_REQUEST_TYPE, m_send_buff.getBuffer(), m_send_buff.size());
+   core_id_t server = getServer(*cond);
+   // The waiter gets the lock back from the server of the mutex
+   core_id_t mutex_server = getServer(*mux);
+   m_network->netSend(server, m_request_type, m_send_buff.getBuffer(), m_send_buff.size());
 
    // Set the CoreState to 'STALLED'
    m_core->setState(Core::STALLED);
 
    NetPacket recv_pkt;
-   recv_pkt = m_network->netRecv(Config::getSingleton()->getMCPCoreId(), m_core->getId(), MCP_RESPONSE_TYPE);
+   recv_pkt = m_network->netRecv(mutex_server, m_core->getId(), m_response_type);
    assert(recv_pkt.length == sizeof(unsigned int) + sizeof(UInt64));
 
    // Set the CoreState to 'RUNNING'
@@ -194,20 +387,16 @@ void SyncClient::condWait(carbon_cond_t *cond, carbon_mutex_t *mux)
    UInt64 time;
    m_recv_buff >> time;
 
-   if (time > start_time)
-   {
-      // Global Clock to Core Clock
-      UInt64 cycles_elapsed = convertCycleCount(time  - start_time, \
-            1.0, m_core->getPerformanceModel()->getFrequency());
-
-      m_core->getPerformanceModel()->queueDynamicInstruction(new SyncInstruction(cycles_elapsed));
-   }
+   m_core->wakeUp(start_time, time);
+   traceWait("cond_wait", start_time, time);
 
    delete [](Byte*) recv_pkt.data;
 }
 
 void SyncClient::condSignal(carbon_cond_t *cond)
 {
+   HostProfiler::Scope profile(Sim()->getHostProfiler(), HostProfiler::SYNC);
+
    // Save/Restore Floating Point state
    FloatingPointHandler floating_point_handler;
 
@@ -224,10 +413,11 @@ void SyncClient::condSignal(carbon_cond_t *cond)
    m_send_buff << msg_type << *cond << start_time;
 
    LOG_PRINT("condSignal(): cond(%u), start_time(%llu)", *cond, start_time);
-   m_network->netSend(Config::getSingleton()->getMCPCoreId(), MCP_REQUEST_TYPE, m_send_buff.getBuffer(), m_send_buff.size());
+   core_id_t server = getServer(*cond);
+   m_network->netSend(server, m_request_type, m_send_buff.getBuffer(), m_send_buff.size());
 
    NetPacket recv_pkt;
-   recv_pkt = m_network->netRecv(Config::getSingleton()->getMCPCoreId(), m_core->getId(), MCP_RESPONSE_TYPE);
+   recv_pkt = m_network->netRecv(server, m_core->getId(), m_response_type);
    assert(recv_pkt.length == sizeof(unsigned int));
 
    unsigned int dummy;
@@ -240,6 +430,8 @@ void SyncClient::condSignal(carbon_cond_t *cond)
 
 void SyncClient::condBroadcast(carbon_cond_t *cond)
 {
+   HostProfiler::Scope profile(Sim()->getHostProfiler(), HostProfiler::SYNC);
+
    // Save/Restore Floating Point state
    FloatingPointHandler floating_point_handler;
 
@@ -256,10 +448,11 @@ void SyncClient::condBroadcast(carbon_cond_t *cond)
    m_send_buff << msg_type << *cond << start_time;
 
    LOG_PRINT("condBroadcast(): cond(%u), start_time(%llu)", *cond, start_time);
-   m_network->netSend(Config::getSingleton()->getMCPCoreId(), MCP_REQUEST_TYPE, m_send_buff.getBuffer(), m_send_buff.size());
+   core_id_t server = getServer(*cond);
+   m_network->netSend(server, m_request_type, m_send_buff.getBuffer(), m_send_buff.size());
 
    NetPacket recv_pkt;
-   recv_pkt = m_network->netRecv(Config::getSingleton()->getMCPCoreId(), m_core->getId(), MCP_RESPONSE_TYPE);
+   recv_pkt = m_network->netRecv(server, m_core->getId(), m_response_type);
    assert(recv_pkt.length == sizeof(unsigned int));
 
    unsigned int dummy;
@@ -287,10 +480,11 @@ void SyncClient::barrierInit(carbon_barrier_t *barrier, UInt32 count)
 
    m_send_buff << msg_type << count << start_time;
 
-   m_network->netSend(Config::getSingleton()->getMCPCoreId(), MCP_REQUEST_TYPE, m_send_buff.getBuffer(), m_send_buff.size());
+   core_id_t server = getInitServer();
+   m_network->netSend(server, m_request_type, m_send_buff.getBuffer(), m_send_buff.size());
 
    NetPacket recv_pkt;
-   recv_pkt = m_network->netRecv(Config::getSingleton()->getMCPCoreId(), m_core->getId(), MCP_RESPONSE_TYPE);
+   recv_pkt = m_network->netRecv(server, m_core->getId(), m_response_type);
    assert(recv_pkt.length == sizeof(carbon_barrier_t));
 
    *barrier = *((carbon_barrier_t*)recv_pkt.data);
@@ -300,6 +494,8 @@ void SyncClient::barrierInit(carbon_barrier_t *barrier, UInt32 count)
 
 void SyncClient::barrierWait(carbon_barrier_t *barrier)
 {
+   HostProfiler::Scope profile(Sim()->getHostProfiler(), HostProfiler::SYNC);
+
    // Save/Restore Floating Point state
    FloatingPointHandler floating_point_handler;
 
@@ -316,7 +512,8 @@ void SyncClient::barrierWait(carbon_barrier_t *barrier)
    m_send_buff << msg_type << *barrier << start_time;
 
    LOG_PRINT("barrierWait(): barrier(%u), start_time(%llu)", *barrier, start_time);
-   m_network->netSend(Config::getSingleton()->getMCPCoreId(), MCP_REQUEST_TYPE, m_send_buff.getBuffer(), m_send_buff.size());
+   core_id_t server = getServer(*barrier);
+   m_network->netSend(server, m_request_type, m_send_buff.getBuffer(), m_send_buff.size());
 
    ThreadScheduler * thread_scheduler = Sim()->getThreadScheduler();
    assert(thread_scheduler);
@@ -326,8 +523,12 @@ void SyncClient::barrierWait(carbon_barrier_t *barrier)
    // Set the CoreState to 'STALLED'
    m_core->setState(Core::STALLED);
 
+   // The release may be passed on by another tile
    NetPacket recv_pkt;
-   recv_pkt = m_network->netRecv(Config::getSingleton()->getMCPCoreId(), m_core->getId(), MCP_RESPONSE_TYPE);
+   if (m_central_barrier_release)
+      recv_pkt = m_network->netRecv(server, m_core->getId(), m_response_type);
+   else
+      recv_pkt = m_network->netRecvType(m_response_type, m_core->getId());
    assert(recv_pkt.length == sizeof(unsigned int) + sizeof(UInt64));
 
 
@@ -346,14 +547,8 @@ void SyncClient::barrierWait(carbon_barrier_t *barrier)
    UInt64 time;
    m_recv_buff >> time;
 
-   if (time > start_time)
-   {
-      // Global Clock to Core Clock
-      UInt64 cycles_elapsed = convertCycleCount(time - start_time, \
-            1.0, m_core->getPerformanceModel()->getFrequency());
-
-      m_core->getPerformanceModel()->queueDynamicInstruction(new SyncInstruction(cycles_elapsed));
-   }
+   m_core->wakeUp(start_time, time);
+   traceWait("barrier_wait", start_time, time);
 
    delete [](Byte*) recv_pkt.data;
 }
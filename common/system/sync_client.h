@@ -3,6 +3,8 @@
 
 #include "sync_api.h"
 #include "packetize.h"
+#include "packet_type.h"
+#include "fixed_types.h"
 
 class Core;
 class Network;
@@ -41,13 +43,53 @@ class SyncClient
       static const unsigned int COND_SIGNAL_RESPONSE  = 0xBEEFCAFE;
       static const unsigned int COND_BROADCAST_RESPONSE = 0xDEADCAFE;
       static const unsigned int BARRIER_WAIT_RESPONSE  = 0xCACACAFE;
+      static const unsigned int MUTEX_INFLATE_RESPONSE = 0xCAFEF00D;
 
    private:
+      // The server of a sync object: the MCP, or its home tile with the
+      // distributed servers (sync_server/distributed)
+      core_id_t getServer(SInt32 id);
+      core_id_t getInitServer();
+      // Span of a wait in the event trace (global clock, in ns)
+      void traceWait(const char* name, UInt64 start_time, UInt64 time);
+
+      /* Fast mutexes (sync_server/fast_mutex): like a futex, a mutex is
+         locked and unlocked by a compare-and-swap on a word of the host
+         process, without a message to its server, as long as it is not
+         contended. Its state: free, locked by tile (id + 1), or inflated.
+         The first thread that finds it locked hands it over to the server,
+         locked by its owner, and it stays with the server from then on
+         (as a thin lock that inflates). The cost of the lock is the atomic
+         access of the line of the mutex variable in the simulated memory.
+         Single process runs, not deterministic ones
+      */
+      enum FastMutexState
+      {
+         FAST_MUTEX_FREE = 0,
+         FAST_MUTEX_INFLATED = -1,
+         FAST_MUTEX_INFLATING = -2
+      };
+      // NULL if the mutex has no fast path
+      volatile SInt32* getFastMutexWord(carbon_mutex_t mux);
+      bool lockFastMutex(carbon_mutex_t *mux, volatile SInt32* word);
+      bool unlockFastMutex(carbon_mutex_t *mux, volatile SInt32* word);
+      // Hands the mutex, locked by 'owner' (tile id + 1), over to the server
+      bool inflateFastMutex(carbon_mutex_t *mux, volatile SInt32* word, SInt32 owner);
+      void modelFastMutexAccess(carbon_mutex_t *mux);
+
       Core *m_core;
       Network *m_network;
       UnstructuredBuffer m_send_buff;
       UnstructuredBuffer m_recv_buff;
 
+      bool m_distributed;
+      UInt32 m_num_homes;
+      UInt32 m_num_inits;
+      PacketType m_request_type;
+      PacketType m_response_type;
+      bool m_central_barrier_release;
+      bool m_fast_mutex;
+
 };
 
 #endif
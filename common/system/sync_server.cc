@@ -1,9 +1,13 @@
+#include <algorithm>
+
 #include "sync_server.h"
 #include "sync_client.h"
 #include "simulator.h"
 #include "thread_manager.h"
 #include "tile_manager.h"
 #include "thread_scheduler.h"
+#include "tile.h"
+#include "config.h"
 
 using namespace std;
 
@@ -24,7 +28,7 @@ SimMutex::~SimMutex()
    assert(m_waiting.empty());
 }
 
-bool SimMutex::lock(core_id_t core_id)
+bool SimMutex::lock(core_id_t core_id, UInt64 time)
 {
    if (m_owner.tile_id == INVALID_TILE_ID)
    {
@@ -34,7 +38,10 @@ bool SimMutex::lock(core_id_t core_id)
    else
    {
       Sim()->getThreadManager()->stallThread(core_id);
-      m_waiting.push(core_id);
+      Waiter waiter;
+      waiter.core_id = core_id;
+      waiter.time = time;
+      m_waiting.push_back(waiter);
       return false;
    }
 }
@@ -49,8 +56,18 @@ core_id_t SimMutex::unlock(core_id_t core_id)
    }
    else
    {
-      m_owner =  m_waiting.front();
-      m_waiting.pop();
+      ThreadQueue::iterator next = m_waiting.begin();
+      if (Config::getSingleton()->isDeterministic())
+      {
+         for (ThreadQueue::iterator it = m_waiting.begin(); it != m_waiting.end(); it++)
+         {
+            if ((it->time < next->time) ||
+                ((it->time == next->time) && (it->core_id.tile_id < next->core_id.tile_id)))
+               next = it;
+         }
+      }
+      m_owner = next->core_id;
+      m_waiting.erase(next);
       Sim()->getThreadManager()->resumeThread(m_owner);
    }
    return m_owner;
@@ -64,58 +81,52 @@ SimCond::~SimCond()
    assert(m_waiting.empty());
 }
 
-core_id_t SimCond::wait(core_id_t core_id, UInt64 time, StableIterator<SimMutex> & simMux)
+void SimCond::wait(core_id_t core_id, UInt64 time, carbon_mutex_t mutex)
 {
    Sim()->getThreadManager()->stallThread(core_id);
 
    // If we don't have any later signals, then put this request in the queue
-   m_waiting.push_back(CondWaiter(core_id, simMux, time));
-   return simMux->unlock(core_id);
+   m_waiting.push_back(CondWaiter(core_id, mutex, time));
 }
 
-core_id_t SimCond::signal(core_id_t core_id, UInt64 time)
+bool SimCond::signal(core_id_t core_id, UInt64 time, CondWaiter &woken)
 {
-   // If there is a list of threads waiting, wake up one of them
-   if (!m_waiting.empty())
-   {
-      CondWaiter woken = *(m_waiting.begin());
-      m_waiting.erase(m_waiting.begin());
-
-      Sim()->getThreadManager()->resumeThread(woken.m_core_id);
-
-      if (woken.m_mutex->lock(woken.m_core_id))
-      {
-         // Woken up thread is able to grab lock immediately
-         return woken.m_core_id;
-      }
-      else
-      {
-         // Woken up thread is *NOT* able to grab lock immediately
-         return INVALID_CORE_ID;
-      }
-   }
-
    // There are *NO* threads waiting on the condition variable
-   return INVALID_CORE_ID;
+   if (m_waiting.empty())
+      return false;
+
+   // If there is a list of threads waiting, wake up one of them
+   ThreadQueue::iterator next = m_waiting.begin();
+   if (Config::getSingleton()->isDeterministic())
+      next = std::min_element(m_waiting.begin(), m_waiting.end(), isEarlier);
+   woken = *next;
+   m_waiting.erase(next);
+
+   Sim()->getThreadManager()->resumeThread(woken.m_core_id);
+   return true;
 }
 
 void SimCond::broadcast(core_id_t core_id, UInt64 time, WakeupList &woken_list)
 {
    for (ThreadQueue::iterator i = m_waiting.begin(); i != m_waiting.end(); i++)
    {
-      CondWaiter woken = *(i);
-
-      Sim()->getThreadManager()->resumeThread(woken.m_core_id);
-
-      if (woken.m_mutex->lock(woken.m_core_id))
-      {
-         // Woken up thread is able to grab lock immediately
-         woken_list.push_back(woken.m_core_id);
-      }
+      Sim()->getThreadManager()->resumeThread(i->m_core_id);
+      woken_list.push_back(*i);
    }
 
    // All waiting threads have been woken up from the CondVar queue
    m_waiting.clear();
+
+   // They lock the mutex again in this order
+   if (Config::getSingleton()->isDeterministic())
+      std::stable_sort(woken_list.begin(), woken_list.end(), isEarlier);
+}
+
+bool SimCond::isEarlier(const CondWaiter& a, const CondWaiter& b)
+{
+   if (a.m_arrival_time != b.m_arrival_time)
+      return (a.m_arrival_time < b.m_arrival_time);
+   return (a.m_core_id.tile_id < b.m_core_id.tile_id);
 }
 
 // -- SimBarrier -- //
@@ -166,41 +177,53 @@ void SimBarrier::wait(core_id_t core_id, UInt64 time, WakeupList &woken_list)
 
 // -- SyncServer -- //
 
-SyncServer::SyncServer(Network &network, UnstructuredBuffer &recv_buffer)
+SyncServer::SyncServer(Network &network, UnstructuredBuffer &recv_buffer,
+                       PacketType response_type, UInt32 home, UInt32 num_homes)
       : m_network(network),
-      m_recv_buffer(recv_buffer)
-{ }
+      m_recv_buffer(recv_buffer),
+      m_response_type(response_type),
+      m_barrier_release_mode(BarrierRelease::CENTRAL),
+      m_home(home),
+      m_num_homes(num_homes)
+{
+   try
+   {
+      m_barrier_release_mode = BarrierRelease::parseMode(Sim()->getCfg()->getString("sync_server/barrier_release", "central"));
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read sync_server/barrier_release from the cfg file");
+   }
+}
 
 SyncServer::~SyncServer()
 { }
 
-void SyncServer::mutexInit(core_id_t core_id)
+UInt32 SyncServer::getIndex(SInt32 id)
 {
-   m_mutexes.push_back(SimMutex());
-   UInt32 mux = (UInt32)m_mutexes.size()-1;
-
-   m_network.netSend(core_id, MCP_RESPONSE_TYPE, (char*)&mux, sizeof(mux));
+   LOG_ASSERT_ERROR((id >= 0) && (((UInt32) id % m_num_homes) == m_home),
+                    "Sync object(%i) is not homed on server(%u)", id, m_home);
+   return (UInt32) id / m_num_homes;
 }
 
-void SyncServer::mutexLock(core_id_t core_id)
+void SyncServer::lockMutex(carbon_mutex_t mux, core_id_t core_id, UInt64 time)
 {
-   carbon_mutex_t mux;
-   m_recv_buffer >> mux;
-
-   UInt64 time;
-   m_recv_buffer >> time;
-
-   LOG_ASSERT_ERROR((size_t)mux < m_mutexes.size(), "mux(%i), total muxes(%u)", mux, m_mutexes.size());
+   if (((UInt32) mux % m_num_homes) != m_home)
+   {
+      forwardMutexRequest(MCP_MESSAGE_MUTEX_LOCK_FORWARD, mux, core_id, time);
+      return;
+   }
 
-   SimMutex *psimmux = &m_mutexes[mux];
+   UInt32 index = getIndex(mux);
+   LOG_ASSERT_ERROR(index < m_mutexes.size(), "mux(%i), total muxes(%u)", mux, m_mutexes.size());
 
-   if (psimmux->lock(core_id))
+   if (m_mutexes[index].lock(core_id, time))
    {
       // notify the owner
       Reply r;
       r.dummy = SyncClient::MUTEX_LOCK_RESPONSE;
       r.time = time;
-      m_network.netSend(core_id, MCP_RESPONSE_TYPE, (char*)&r, sizeof(r));
+      m_network.netSend(core_id, m_response_type, (char*)&r, sizeof(r));
    }
    else
    {
@@ -208,19 +231,18 @@ void SyncServer::mutexLock(core_id_t core_id)
    }
 }
 
-void SyncServer::mutexUnlock(core_id_t core_id)
+void SyncServer::unlockMutex(carbon_mutex_t mux, core_id_t core_id, UInt64 time)
 {
-   carbon_mutex_t mux;
-   m_recv_buffer >> mux;
-
-   UInt64 time;
-   m_recv_buffer >> time;
-
-   assert((size_t)mux < m_mutexes.size());
+   if (((UInt32) mux % m_num_homes) != m_home)
+   {
+      forwardMutexRequest(MCP_MESSAGE_MUTEX_UNLOCK_FORWARD, mux, core_id, time);
+      return;
+   }
 
-   SimMutex *psimmux = &m_mutexes[mux];
+   UInt32 index = getIndex(mux);
+   LOG_ASSERT_ERROR(index < m_mutexes.size(), "mux(%i), total muxes(%u)", mux, m_mutexes.size());
 
-   core_id_t new_owner = psimmux->unlock(core_id);
+   core_id_t new_owner = m_mutexes[index].unlock(core_id);
 
    if (new_owner.tile_id != INVALID_TILE_ID)
    {
@@ -228,24 +250,101 @@ void SyncServer::mutexUnlock(core_id_t core_id)
       Reply r;
       r.dummy = SyncClient::MUTEX_LOCK_RESPONSE;
       r.time = time;
-      m_network.netSend(new_owner, MCP_RESPONSE_TYPE, (char*)&r, sizeof(r));
-   }
-   else
-   {
-      // nothing...
+      m_network.netSend(new_owner, m_response_type, (char*)&r, sizeof(r));
    }
+}
+
+void SyncServer::forwardMutexRequest(SInt32 msg_type, carbon_mutex_t mux, core_id_t core_id, UInt64 time)
+{
+   // Messages between two servers are delivered in order, so the unlock of a
+   // waiter always reaches the mutex before it is locked again for it
+   m_send_buffer.clear();
+   m_send_buffer << msg_type << mux << core_id << time;
+
+   core_id_t mutex_server = Tile::getMainCoreId((UInt32) mux % m_num_homes);
+   m_network.netSend(mutex_server, SYNC_SERVER_REQUEST_TYPE, m_send_buffer.getBuffer(), m_send_buffer.size());
+}
+
+void SyncServer::mutexInit(core_id_t core_id)
+{
+   m_mutexes.push_back(SimMutex());
+   carbon_mutex_t mux = getId(m_mutexes.size()-1);
+
+   m_network.netSend(core_id, m_response_type, (char*)&mux, sizeof(mux));
+}
+
+void SyncServer::mutexLock(core_id_t core_id)
+{
+   carbon_mutex_t mux;
+   m_recv_buffer >> mux;
+
+   UInt64 time;
+   m_recv_buffer >> time;
+
+   lockMutex(mux, core_id, time);
+}
+
+void SyncServer::mutexUnlock(core_id_t core_id)
+{
+   carbon_mutex_t mux;
+   m_recv_buffer >> mux;
+
+   UInt64 time;
+   m_recv_buffer >> time;
+
+   unlockMutex(mux, core_id, time);
 
    UInt32 dummy = SyncClient::MUTEX_UNLOCK_RESPONSE;
-   m_network.netSend(core_id, MCP_RESPONSE_TYPE, (char*)&dummy, sizeof(dummy));
+   m_network.netSend(core_id, m_response_type, (char*)&dummy, sizeof(dummy));
+}
+
+void SyncServer::mutexInflate(core_id_t core_id)
+{
+   carbon_mutex_t mux;
+   core_id_t owner;
+   UInt64 time;
+   m_recv_buffer >> mux >> owner >> time;
+
+   // Sent to the home of the mutex
+   UInt32 index = getIndex(mux);
+   LOG_ASSERT_ERROR(index < m_mutexes.size(), "mux(%i), total muxes(%u)", mux, m_mutexes.size());
+
+   // Free on the server until then
+   bool locked = m_mutexes[index].lock(owner, time);
+   LOG_ASSERT_ERROR(locked, "mux(%i) inflated while held on the server", mux);
+
+   UInt32 dummy = SyncClient::MUTEX_INFLATE_RESPONSE;
+   m_network.netSend(core_id, m_response_type, (char*)&dummy, sizeof(dummy));
+}
+
+void SyncServer::mutexLockForward(core_id_t sender)
+{
+   carbon_mutex_t mux;
+   core_id_t core_id;
+   UInt64 time;
+   m_recv_buffer >> mux >> core_id >> time;
+
+   lockMutex(mux, core_id, time);
+}
+
+void SyncServer::mutexUnlockForward(core_id_t sender)
+{
+   carbon_mutex_t mux;
+   core_id_t core_id;
+   UInt64 time;
+   m_recv_buffer >> mux >> core_id >> time;
+
+   // The waiter is not sent MUTEX_UNLOCK_RESPONSE, it waits for the lock
+   unlockMutex(mux, core_id, time);
 }
 
 // -- Condition Variable Stuffs -- //
 void SyncServer::condInit(core_id_t core_id)
 {
    m_conds.push_back(SimCond());
-   UInt32 cond = (UInt32)m_conds.size()-1;
+   carbon_cond_t cond = getId(m_conds.size()-1);
 
-   m_network.netSend(core_id, MCP_RESPONSE_TYPE, (char*)&cond, sizeof(cond));
+   m_network.netSend(core_id, m_response_type, (char*)&cond, sizeof(cond));
 }
 
 void SyncServer::condWait(core_id_t core_id)
@@ -258,23 +357,13 @@ void SyncServer::condWait(core_id_t core_id)
    UInt64 time;
    m_recv_buffer >> time;
 
-   assert((size_t)mux < m_mutexes.size());
-   assert((size_t)cond < m_conds.size());
-
-   SimCond *psimcond = &m_conds[cond];
+   UInt32 index = getIndex(cond);
+   assert(index < m_conds.size());
 
-   StableIterator<SimMutex> it(m_mutexes, mux);
-   core_id_t new_mutex_owner = psimcond->wait(core_id, time, it);
+   m_conds[index].wait(core_id, time, mux);
 
-   if (new_mutex_owner.tile_id != INVALID_TILE_ID)
-   {
-      // wake up the new owner
-      Reply r;
-
-      r.dummy = SyncClient::MUTEX_LOCK_RESPONSE;
-      r.time = time;
-      m_network.netSend(new_mutex_owner, MCP_RESPONSE_TYPE, (char*)&r, sizeof(r));
-   }
+   // The new owner of the mutex is woken up
+   unlockMutex(mux, core_id, time);
 }
 
 
@@ -286,29 +375,20 @@ void SyncServer::condSignal(core_id_t core_id)
    UInt64 time;
    m_recv_buffer >> time;
 
-   assert((size_t)cond < m_conds.size());
-
-   SimCond *psimcond = &m_conds[cond];
+   UInt32 index = getIndex(cond);
+   assert(index < m_conds.size());
 
-   core_id_t woken = psimcond->signal(core_id, time);
-
-   if (woken.tile_id != INVALID_TILE_ID)
+   SimCond::CondWaiter woken(INVALID_CORE_ID, 0, 0);
+   if (m_conds[index].signal(core_id, time, woken))
    {
-      // wake up the new owner
+      // The woken up thread is sent MUTEX_LOCK_RESPONSE once it has the lock
       // (note: COND_WAIT_RESPONSE == MUTEX_LOCK_RESPONSE, see header)
-      Reply r;
-      r.dummy = SyncClient::MUTEX_LOCK_RESPONSE;
-      r.time = time;
-      m_network.netSend(woken, MCP_RESPONSE_TYPE, (char*)&r, sizeof(r));
-   }
-   else
-   {
-      // nothing...
+      lockMutex(woken.m_mutex, woken.m_core_id, time);
    }
 
    // Alert the signaler
    UInt32 dummy = SyncClient::COND_SIGNAL_RESPONSE;
-   m_network.netSend(core_id, MCP_RESPONSE_TYPE, (char*)&dummy, sizeof(dummy));
+   m_network.netSend(core_id, m_response_type, (char*)&dummy, sizeof(dummy));
 }
 
 void SyncServer::condBroadcast(core_id_t core_id)
@@ -319,28 +399,23 @@ void SyncServer::condBroadcast(core_id_t core_id)
    UInt64 time;
    m_recv_buffer >> time;
 
-   assert((size_t)cond < m_conds.size());
-
-   SimCond *psimcond = &m_conds[cond];
+   UInt32 index = getIndex(cond);
+   assert(index < m_conds.size());
 
    SimCond::WakeupList woken_list;
-   psimcond->broadcast(core_id, time, woken_list);
+   m_conds[index].broadcast(core_id, time, woken_list);
 
    for (SimCond::WakeupList::iterator it = woken_list.begin(); it != woken_list.end(); it++)
    {
-      assert((*it).tile_id != INVALID_TILE_ID);
+      assert(it->m_core_id.tile_id != INVALID_TILE_ID);
 
-      // wake up the new owner
       // (note: COND_WAIT_RESPONSE == MUTEX_LOCK_RESPONSE, see header)
-      Reply r;
-      r.dummy = SyncClient::MUTEX_LOCK_RESPONSE;
-      r.time = time;
-      m_network.netSend((*it), MCP_RESPONSE_TYPE, (char*)&r, sizeof(r));
+      lockMutex(it->m_mutex, it->m_core_id, time);
    }
 
    // Alert the signaler
    UInt32 dummy = SyncClient::COND_BROADCAST_RESPONSE;
-   m_network.netSend(core_id, MCP_RESPONSE_TYPE, (char*)&dummy, sizeof(dummy));
+   m_network.netSend(core_id, m_response_type, (char*)&dummy, sizeof(dummy));
 }
 
 void SyncServer::barrierInit(core_id_t core_id)
@@ -349,9 +424,9 @@ void SyncServer::barrierInit(core_id_t core_id)
    m_recv_buffer >> count;
 
    m_barriers.push_back(SimBarrier(count));
-   UInt32 barrier = (UInt32)m_barriers.size()-1;
+   carbon_barrier_t barrier = getId(m_barriers.size()-1);
 
-   m_network.netSend(core_id, MCP_RESPONSE_TYPE, (char*)&barrier, sizeof(barrier));
+   m_network.netSend(core_id, m_response_type, (char*)&barrier, sizeof(barrier));
 }
 
 void SyncServer::barrierWait(core_id_t core_id)
@@ -362,22 +437,26 @@ void SyncServer::barrierWait(core_id_t core_id)
    UInt64 time;
    m_recv_buffer >> time;
 
-   LOG_ASSERT_ERROR(barrier < (carbon_barrier_t) m_barriers.size(), "barrier = %i, m_barriers.size()= %u", barrier, m_barriers.size());
+   UInt32 index = getIndex(barrier);
+   LOG_ASSERT_ERROR(index < m_barriers.size(), "barrier = %i, m_barriers.size()= %u", barrier, m_barriers.size());
 
-   SimBarrier *psimbarrier = &m_barriers[barrier];
+   SimBarrier *psimbarrier = &m_barriers[index];
 
    SimBarrier::WakeupList woken_list;
    psimbarrier->wait(core_id, time, woken_list);
 
-   UInt64 max_time = psimbarrier->getMaxTime();
+   if (woken_list.empty())
+      return;
 
+   std::vector<tile_id_t> woken_tiles;
    for (SimBarrier::WakeupList::iterator it = woken_list.begin(); it != woken_list.end(); it++)
    {
       assert((*it).tile_id != INVALID_TILE_ID);
-      Reply r;
-      r.dummy = SyncClient::BARRIER_WAIT_RESPONSE;
-      r.time = max_time;
-      core_id_t core_id = (*it);
-      m_network.netSend(core_id, MCP_RESPONSE_TYPE, (char*)&r, sizeof(r));
+      woken_tiles.push_back((*it).tile_id);
    }
+
+   Reply r;
+   r.dummy = SyncClient::BARRIER_WAIT_RESPONSE;
+   r.time = psimbarrier->getMaxTime();
+   BarrierRelease::release(&m_network, m_barrier_release_mode, woken_tiles, m_response_type, (char*)&r, sizeof(r));
 }
@@ -2,6 +2,7 @@
 #define SYNC_SERVER_H
 
 #include <queue>
+#include <deque>
 #include <vector>
 #include <limits.h>
 #include <string.h>
@@ -10,7 +11,7 @@
 #include "transport.h"
 #include "network.h"
 #include "packetize.h"
-#include "stable_iterator.h"
+#include "barrier_release.h"
 
 class SimMutex
 {
@@ -21,14 +22,21 @@ class SimMutex
       ~SimMutex();
 
       // returns true if this thread now owns the lock
-      bool lock(core_id_t core_id);
+      bool lock(core_id_t core_id, UInt64 time);
 
       // returns the next owner of the lock so that it can be signaled by
-      // the server
+      // the server: the first waiter, or in a deterministic run
+      // (general/deterministic) the one of the earliest lock time, then
+      // of the lowest tile id
       core_id_t unlock(core_id_t core_id);
 
    private:
-      typedef std::queue<core_id_t> ThreadQueue;
+      struct Waiter
+      {
+         core_id_t core_id;
+         UInt64 time;
+      };
+      typedef std::deque<Waiter> ThreadQueue;
 
       ThreadQueue m_waiting;
       core_id_t m_owner;
@@ -38,29 +46,36 @@ class SimCond
 {
 
    public:
-      typedef std::vector<core_id_t> WakeupList;
-
-      SimCond();
-      ~SimCond();
-
-      // returns the thread that gets woken up when the mux is unlocked
-      core_id_t wait(core_id_t core_id, UInt64 time, StableIterator<SimMutex> & it);
-      core_id_t signal(core_id_t core_id, UInt64 time);
-      void broadcast(core_id_t core_id, UInt64 time, WakeupList &woken);
-
-   private:
       class CondWaiter
       {
          public:
-            CondWaiter(core_id_t core_id, StableIterator<SimMutex> mutex, UInt64 time)
+            CondWaiter(core_id_t core_id, carbon_mutex_t mutex, UInt64 time)
                   : m_core_id(core_id), m_mutex(mutex), m_arrival_time(time) {}
             core_id_t m_core_id;
-            StableIterator<SimMutex> m_mutex;
+            // The mutex may be homed on another server
+            carbon_mutex_t m_mutex;
             UInt64 m_arrival_time;
       };
 
+      typedef std::vector<CondWaiter> WakeupList;
+
+      SimCond();
+      ~SimCond();
+
+      // The server then unlocks the mutex for the waiter and locks it again
+      // for the threads that are woken up
+      void wait(core_id_t core_id, UInt64 time, carbon_mutex_t mutex);
+      // returns false if there was no thread waiting. The waiters are
+      // woken in order of arrival, or in a deterministic run of wait time,
+      // then tile id
+      bool signal(core_id_t core_id, UInt64 time, CondWaiter &woken);
+      void broadcast(core_id_t core_id, UInt64 time, WakeupList &woken);
+
+   private:
       typedef std::vector< CondWaiter > ThreadQueue;
       ThreadQueue m_waiting;
+
+      static bool isEarlier(const CondWaiter& a, const CondWaiter& b);
 };
 
 class SimBarrier
@@ -96,7 +111,11 @@ class SyncServer
       // FIXME: This should be better organized -- too much redundant crap
 
    public:
-      SyncServer(Network &network, UnstructuredBuffer &recv_buffer);
+      // The MCP serves all the sync objects. With distributed servers
+      // (sync_server/distributed), application tile 'home' serves the objects
+      // with (id % num_homes) == home, and replies with 'response_type'
+      SyncServer(Network &network, UnstructuredBuffer &recv_buffer,
+                 PacketType response_type = MCP_RESPONSE_TYPE, UInt32 home = 0, UInt32 num_homes = 1);
       ~SyncServer();
 
       // Remaining parameters to these functions are stored
@@ -104,6 +123,9 @@ class SyncServer
       void mutexInit(core_id_t core_id);
       void mutexLock(core_id_t core_id);
       void mutexUnlock(core_id_t core_id);
+      // The fast path of a mutex was contended (sync_server/fast_mutex): the
+      // server takes it over, held by the tile that locked it
+      void mutexInflate(core_id_t core_id);
 
       void condInit(core_id_t core_id);
       void condWait(core_id_t core_id);
@@ -113,9 +135,29 @@ class SyncServer
       void barrierInit(core_id_t);
       void barrierWait(core_id_t);
 
+      // Sent by the server of a condition variable to the server of its
+      // mutex, on behalf of a waiter
+      void mutexLockForward(core_id_t sender);
+      void mutexUnlockForward(core_id_t sender);
+
    private:
+      // Ids are (index * num_homes + home)
+      SInt32 getId(UInt32 index) { return (SInt32) (index * m_num_homes + m_home); }
+      UInt32 getIndex(SInt32 id);
+
+      // Locks/unlocks 'mux' for 'core_id', wherever it is homed. The thread
+      // that gets the lock is sent MUTEX_LOCK_RESPONSE
+      void lockMutex(carbon_mutex_t mux, core_id_t core_id, UInt64 time);
+      void unlockMutex(carbon_mutex_t mux, core_id_t core_id, UInt64 time);
+      void forwardMutexRequest(SInt32 msg_type, carbon_mutex_t mux, core_id_t core_id, UInt64 time);
+
       Network &m_network;
       UnstructuredBuffer &m_recv_buffer;
+      UnstructuredBuffer m_send_buffer;
+      PacketType m_response_type;
+      BarrierRelease::Mode m_barrier_release_mode;
+      UInt32 m_home;
+      UInt32 m_num_homes;
 };
 
 #endif // SYNC_SERVER_H
@@ -256,31 +256,25 @@ void SyscallServer::marshallWriteCall(core_id_t core_id)
    */
 
    int fd;
-   char *buf = (char *) m_scratch;
    size_t count;
 
    m_recv_buff >> fd >> count;
 
-   if (count > m_SYSCALL_SERVER_MAX_BUFF)
-      buf = new char[count];
-
    // All data is always passed in the message, even if shared memory is available
    // I think this is a reasonable model and is definitely one less thing to keep
    // track of when you switch between shared-memory/no shared-memory
-   m_recv_buff >> make_pair(buf, count);
+   // It is written from the message itself
+   const void *buf = m_recv_buff.getView(count);
+   assert(buf);
 
    // Actually do the write call
-   int bytes = syscall(SYS_write, fd, (void *) buf, count);
+   int bytes = syscall(SYS_write, fd, buf, count);
 
    m_send_buff << bytes;
 
    LOG_PRINT("Write(%i,%i) returns %i", fd, count, bytes);
 
    m_network.netSend(core_id, MCP_RESPONSE_TYPE, m_send_buff.getBuffer(), m_send_buff.size());
-
-   if (count > m_SYSCALL_SERVER_MAX_BUFF)
-      delete[] buf;
-
 }
 
 void SyscallServer::marshallWritevCall(core_id_t core_id)
@@ -302,26 +296,20 @@ void SyscallServer::marshallWritevCall(core_id_t core_id)
 
    int fd;
    UInt64 count;
-   char *buf = (char*) m_scratch;
 
    m_recv_buff >> fd >> count;
 
-   if(count > m_SYSCALL_SERVER_MAX_BUFF)
-      buf = new char[count];
-
-   m_recv_buff >> make_pair(buf, count);
+   const void *buf = m_recv_buff.getView(count);
+   assert(buf);
 
    // Write data to the file
    // Since we have already gathered data from all the various iovec's 
    // passed to the writev syscall, this is just a write syscall
-   IntPtr bytes = syscall(SYS_write, fd, (void*) buf, count);
+   IntPtr bytes = syscall(SYS_write, fd, buf, count);
 
    m_send_buff << bytes;
 
    m_network.netSend(core_id, MCP_RESPONSE_TYPE, m_send_buff.getBuffer(), m_send_buff.size());
-
-   if(count > m_SYSCALL_SERVER_MAX_BUFF)
-      delete[] buf;
 }
 
 void SyscallServer::marshallCloseCall(core_id_t core_id)
@@ -512,6 +500,7 @@ void SyscallServer::marshallMmapCall(core_id_t core_id)
    int flags;
    int fd;
    off_t pgoffset;
+   bool delegated;
 
    m_recv_buff.get(addr);
    m_recv_buff.get(length);
@@ -519,11 +508,14 @@ void SyscallServer::marshallMmapCall(core_id_t core_id)
    m_recv_buff.get(flags);
    m_recv_buff.get(fd);
    m_recv_buff.get(pgoffset);
+   m_recv_buff.get(delegated);
 
    void *start;
-   start = Sim()->getMCP()->getVMManager()->mmap(addr, length, prot, flags, fd, pgoffset);
+   UInt64 recycled_length;
+   start = Sim()->getMCP()->getVMManager()->mmap(addr, length, prot, flags, fd, pgoffset, delegated, recycled_length);
 
    m_send_buff.put(start);
+   m_send_buff.put(recycled_length);
 
    m_network.netSend(core_id, MCP_RESPONSE_TYPE, m_send_buff.getBuffer(), m_send_buff.size());
 }
@@ -0,0 +1,150 @@
+#include <sys/syscall.h>
+#include <sched.h>
+
+#include "syscall_worker_pool.h"
+#include "message_types.h"
+#include "log.h"
+
+SyscallWorkerPool::SyscallWorkerPool(Network &network, UInt32 num_workers, UInt32 max_buff)
+   : m_num_workers(num_workers)
+{
+   LOG_ASSERT_ERROR(m_num_workers > 0, "Syscall worker pool needs at least one worker");
+
+   m_workers = new Worker*[m_num_workers];
+   for (UInt32 i = 0; i < m_num_workers; i++)
+      m_workers[i] = new Worker(network, max_buff);
+}
+
+SyscallWorkerPool::~SyscallWorkerPool()
+{
+   for (UInt32 i = 0; i < m_num_workers; i++)
+      delete m_workers[i];
+   delete [] m_workers;
+}
+
+void SyscallWorkerPool::spawn()
+{
+   LOG_PRINT("Starting %u syscall workers", m_num_workers);
+
+   for (UInt32 i = 0; i < m_num_workers; i++)
+   {
+      m_workers[i]->m_thread = Thread::create(m_workers[i]);
+      m_workers[i]->m_thread->run();
+   }
+}
+
+void SyscallWorkerPool::finish()
+{
+   Request stop;
+   stop.sender = INVALID_CORE_ID;
+   stop.data = NULL;
+   stop.length = 0;
+
+   for (UInt32 i = 0; i < m_num_workers; i++)
+      m_workers[i]->push(stop);
+
+   for (UInt32 i = 0; i < m_num_workers; i++)
+   {
+      while (!m_workers[i]->m_finished)
+         sched_yield();
+   }
+
+   LOG_PRINT("Syscall workers finished");
+}
+
+bool SyscallWorkerPool::dispatch(const NetPacket &packet)
+{
+   // MSG_TYPE(int) SYSCALL_NUMBER(IntPtr) ARGUMENTS...
+   const Byte *arguments = (const Byte*) packet.data + sizeof(int) + sizeof(IntPtr);
+   IntPtr syscall_number = *(const IntPtr*) ((const Byte*) packet.data + sizeof(int));
+
+   UInt32 key;
+   switch (syscall_number)
+   {
+   // The file descriptor is the first argument
+   case SYS_read:
+   case SYS_write:
+   case SYS_writev:
+   case SYS_close:
+   case SYS_lseek:
+   case SYS_fstat:
+   case SYS_ioctl:
+   case SYS_readahead:
+      key = (UInt32) *(const int*) arguments;
+      break;
+
+   case SYS_open:
+   case SYS_access:
+   case SYS_stat:
+   case SYS_lstat:
+   case SYS_getpid:
+   case SYS_pipe:
+   case SYS_rmdir:
+   case SYS_unlink:
+   case SYS_getcwd:
+      key = (UInt32) packet.sender.tile_id;
+      break;
+
+   default:
+      return false;
+   }
+
+   Request request;
+   request.sender = packet.sender;
+   request.data = (Byte*) packet.data;
+   request.length = packet.length;
+   m_workers[key % m_num_workers]->push(request);
+   return true;
+}
+
+// Worker
+
+SyscallWorkerPool::Worker::Worker(Network &network, UInt32 max_buff)
+   : m_thread(NULL)
+   , m_finished(false)
+   , m_scratch(new char[max_buff])
+   , m_syscall_server(network, m_send_buff, m_recv_buff, max_buff, m_scratch)
+{}
+
+SyscallWorkerPool::Worker::~Worker()
+{
+   delete m_thread;
+   delete [] m_scratch;
+}
+
+void SyscallWorkerPool::Worker::push(const Request &request)
+{
+   m_lock.acquire();
+   m_requests.push(request);
+   m_cond.signal();
+   m_lock.release();
+}
+
+void SyscallWorkerPool::Worker::run()
+{
+   while (true)
+   {
+      m_lock.acquire();
+      while (m_requests.empty())
+         m_cond.wait(m_lock);
+      Request request = m_requests.front();
+      m_requests.pop();
+      m_lock.release();
+
+      if (request.data == NULL)
+         break;
+
+      m_send_buff.clear();
+      m_recv_buff.clear();
+      m_recv_buff << std::make_pair(request.data, request.length);
+
+      int msg_type;
+      m_recv_buff >> msg_type;
+      m_syscall_server.handleSyscall(request.sender);
+
+      delete [] request.data;
+   }
+
+   __sync_synchronize();
+   m_finished = true;
+}
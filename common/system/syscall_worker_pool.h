@@ -0,0 +1,71 @@
+#ifndef SYSCALL_WORKER_POOL_H
+#define SYSCALL_WORKER_POOL_H
+
+#include <queue>
+
+#include "thread.h"
+#include "lock.h"
+#include "cond.h"
+#include "packetize.h"
+#include "network.h"
+#include "syscall_server.h"
+#include "fixed_types.h"
+
+// Worker threads for the MCP requests that are syscalls only passed on to
+// the host kernel (file I/O and the like), so that a slow one does not hold
+// up the others or the rest of the MCP requests. The syscalls on a file
+// descriptor all go to the same worker, in the order the MCP received them,
+// and the others go to the worker of their requester. The syscalls that
+// use the state of the MCP (memory management, futexes, affinity) still
+// run in the MCP thread.
+
+class SyscallWorkerPool
+{
+public:
+   SyscallWorkerPool(Network &network, UInt32 num_workers, UInt32 max_buff);
+   ~SyscallWorkerPool();
+
+   void spawn();
+   // Returns once the workers are done with their requests
+   void finish();
+
+   // Returns true if a worker took the request. 'packet' is a
+   // MCP_MESSAGE_SYS_CALL and its data then belongs to the pool
+   bool dispatch(const NetPacket &packet);
+
+private:
+   struct Request
+   {
+      core_id_t sender;
+      Byte *data;       // NULL to stop the worker
+      UInt32 length;
+   };
+
+   class Worker : public Runnable
+   {
+   public:
+      Worker(Network &network, UInt32 max_buff);
+      ~Worker();
+
+      void run();
+      void push(const Request &request);
+
+      Thread *m_thread;
+      volatile bool m_finished;
+
+   private:
+      std::queue<Request> m_requests;
+      Lock m_lock;
+      ConditionVariable m_cond;
+
+      UnstructuredBuffer m_send_buff;
+      UnstructuredBuffer m_recv_buff;
+      char *m_scratch;
+      SyscallServer m_syscall_server;
+   };
+
+   UInt32 m_num_workers;
+   Worker **m_workers;
+};
+
+#endif // SYSCALL_WORKER_POOL_H
@@ -0,0 +1,124 @@
+#include <cmath>
+
+#include "thermal_model.h"
+#include "simulator.h"
+#include "config.h"
+#include "log.h"
+
+using namespace std;
+
+// Volumetric heat capacity of silicon (in J/(m^3 K))
+static const double SILICON_HEAT_CAPACITY = 1.75e6;
+
+const double ThermalModel::CONVERGENCE_THRESHOLD = 1e-3;
+const UInt32 ThermalModel::MAX_ITERATIONS;
+
+ThermalModel::ThermalModel()
+   : _num_tiles(Config::getSingleton()->getApplicationTiles())
+{
+   double tile_width = 0;
+   double die_thickness = 0;
+   double silicon_conductivity = 0;
+   double package_resistance = 0;
+   try
+   {
+      tile_width = Sim()->getCfg()->getFloat("general/tile_width");
+      _ambient_temperature = Sim()->getCfg()->getFloat("thermal_model/ambient_temperature", 45.0);
+      die_thickness = Sim()->getCfg()->getFloat("thermal_model/die_thickness", 0.15);
+      silicon_conductivity = Sim()->getCfg()->getFloat("thermal_model/silicon_conductivity", 100.0);
+      package_resistance = Sim()->getCfg()->getFloat("thermal_model/package_resistance", 30.0);
+      _leakage_temperature_coefficient = Sim()->getCfg()->getFloat("thermal_model/leakage_temperature_coefficient", 0.0);
+      _leakage_reference_temperature = Sim()->getCfg()->getFloat("thermal_model/leakage_reference_temperature", 85.0);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read [thermal_model] parameters from the cfg file");
+   }
+   LOG_ASSERT_ERROR((tile_width > 0) && (die_thickness > 0) && (silicon_conductivity > 0) && (package_resistance > 0),
+                    "Invalid thermal model parameters: tile_width(%f mm), die_thickness(%f mm), "
+                    "silicon_conductivity(%f W/(m K)), package_resistance(%f K mm^2/W)",
+                    tile_width, die_thickness, silicon_conductivity, package_resistance);
+
+   _width = (UInt32) floor(sqrt((double) _num_tiles));
+   _height = (_num_tiles + _width - 1) / _width;
+
+   // Tile of tile_width x tile_width mm, die_thickness mm thick
+   double area = (tile_width * 1e-3) * (tile_width * 1e-3);
+   _capacitance = SILICON_HEAT_CAPACITY * area * (die_thickness * 1e-3);
+   _vertical_resistance = package_resistance / (tile_width * tile_width);
+   // Across a square of silicon: length / (conductivity * thickness * width)
+   _lateral_resistance = 1.0 / (silicon_conductivity * die_thickness * 1e-3);
+
+   LOG_PRINT("Thermal model: %ux%u tiles, C(%g J/K), R vertical(%g K/W), R lateral(%g K/W)",
+             _width, _height, _capacitance, _vertical_resistance, _lateral_resistance);
+
+   _temperatures = new float[_num_tiles];
+   _solution.resize(_num_tiles, _ambient_temperature);
+   for (UInt32 i = 0; i < _num_tiles; i++)
+      _temperatures[i] = _ambient_temperature;
+}
+
+ThermalModel::~ThermalModel()
+{
+   delete [] _temperatures;
+}
+
+void
+ThermalModel::update(const vector<double>& power, double interval)
+{
+   LOG_ASSERT_ERROR(power.size() == _num_tiles, "Power of %u tiles, expected %u", (UInt32) power.size(), _num_tiles);
+
+   // Backward Euler:
+   //   C (T' - T) / dt = P - (T' - Ta) / Rv - sum over the neighbors n of (T' - T'n) / Rl
+   // The previous temperatures are the first guess, they change little
+   // over an interval
+   double capacitance_per_interval = _capacitance / interval;
+   for (UInt32 iteration = 0; iteration < MAX_ITERATIONS; iteration++)
+   {
+      double max_change = 0;
+      for (UInt32 i = 0; i < _num_tiles; i++)
+      {
+         UInt32 x = i % _width;
+         UInt32 y = i / _width;
+         double conductance = capacitance_per_interval + (1.0 / _vertical_resistance);
+         double heat = (capacitance_per_interval * _temperatures[i]) + power[i] +
+                       (_ambient_temperature / _vertical_resistance);
+
+         tile_id_t neighbors[4] = { (x > 0) ? (SInt32) (i - 1) : INVALID_TILE_ID,
+                                    (x + 1 < _width) ? (SInt32) (i + 1) : INVALID_TILE_ID,
+                                    (y > 0) ? (SInt32) (i - _width) : INVALID_TILE_ID,
+                                    (y + 1 < _height) ? (SInt32) (i + _width) : INVALID_TILE_ID };
+         for (UInt32 n = 0; n < 4; n++)
+         {
+            if ((neighbors[n] == INVALID_TILE_ID) || ((UInt32) neighbors[n] >= _num_tiles))
+               continue;
+            conductance += 1.0 / _lateral_resistance;
+            heat += _solution[neighbors[n]] / _lateral_resistance;
+         }
+
+         double temperature = heat / conductance;
+         max_change = max(max_change, fabs(temperature - _solution[i]));
+         _solution[i] = temperature;
+      }
+      if (max_change < CONVERGENCE_THRESHOLD)
+         break;
+   }
+
+   for (UInt32 i = 0; i < _num_tiles; i++)
+      _temperatures[i] = _solution[i];
+}
+
+float
+ThermalModel::getTemperature(tile_id_t tile_id) const
+{
+   LOG_ASSERT_ERROR((tile_id >= 0) && ((UInt32) tile_id < _num_tiles), "Invalid tile id(%i)", tile_id);
+   return _temperatures[tile_id];
+}
+
+double
+ThermalModel::getLeakageFactor(tile_id_t tile_id) const
+{
+   if (_leakage_temperature_coefficient == 0)
+      return 1.0;
+   return exp(_leakage_temperature_coefficient * (getTemperature(tile_id) - _leakage_reference_temperature));
+}
@@ -0,0 +1,62 @@
+#ifndef THERMAL_MODEL_H
+#define THERMAL_MODEL_H
+
+#include <vector>
+
+#include "fixed_types.h"
+
+/*
+  Compact thermal model of the application tiles ([thermal_model]), driven by
+  the power of the statistics trace (the 'temperature' statistic).
+
+  The tiles are laid out as the mesh networks do (floor(sqrt(tiles)) wide)
+  and each one is a single thermal node: a square of general/tile_width with
+  the heat capacity of its silicon, a resistance to the ambient through the
+  package and a lateral resistance to each neighbor. At every sample the
+  temperatures are advanced over the interval with backward Euler, solved
+  with a few Gauss-Seidel sweeps that start from the previous temperatures,
+  so a sample costs a handful of passes over the tiles.
+
+  The temperatures can scale the static power of the tiles (exponentially,
+  with leakage_temperature_coefficient, 0 to leave it as modeled).
+ */
+class ThermalModel
+{
+public:
+   ThermalModel();
+   ~ThermalModel();
+
+   UInt32 getNumTiles() const { return _num_tiles; }
+
+   // Advance the temperatures by 'interval' (in s), with the power (in W)
+   // of each application tile over it
+   void update(const std::vector<double>& power, double interval);
+
+   // Temperature of a tile (in C), read by the application threads
+   float getTemperature(tile_id_t tile_id) const;
+   // Factor of the static power of a tile at its temperature
+   double getLeakageFactor(tile_id_t tile_id) const;
+
+private:
+   // Layout
+   UInt32 _num_tiles;
+   UInt32 _width;
+   UInt32 _height;
+
+   // Parameters (in C, J/K and K/W)
+   double _ambient_temperature;
+   double _capacitance;
+   double _vertical_resistance;
+   double _lateral_resistance;
+   double _leakage_temperature_coefficient;
+   double _leakage_reference_temperature;
+
+   // The sweeps stop when no temperature changes by more than this
+   static const double CONVERGENCE_THRESHOLD;
+   static const UInt32 MAX_ITERATIONS = 20;
+
+   volatile float* _temperatures;
+   std::vector<double> _solution;
+};
+
+#endif // THERMAL_MODEL_H
@@ -12,6 +12,8 @@
 #include "message_types.h"
 #include "tile.h"
 #include "core.h"
+#include "syscall_model.h"
+#include "instruction_trace.h"
 #include "thread.h"
 #include "packetize.h"
 #include "clock_converter.h"
@@ -29,6 +31,18 @@ ThreadManager::ThreadManager(TileManager *tile_manager)
 
    m_tid_counter = 0;
 
+   try
+   {
+      m_async_spawn = Sim()->getCfg()->getBool("thread_scheduling/async_spawn", false);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read thread_scheduling/async_spawn from the cfg file");
+   }
+   // The tids are handed out from the master's counter
+   LOG_ASSERT_ERROR(!m_async_spawn || config->getSimulationMode() == Config::LITE,
+                    "thread_scheduling/async_spawn only works in lite mode");
+
    // Set the thread-spawner and MCP tiles to running.
    if (m_master)
    {
@@ -150,8 +164,15 @@ void ThreadManager::onThreadExit()
    Tile* tile = core->getTile();
    thread_id_t thread_idx = m_tile_manager->getCurrentThreadIndex();
 
+   // The thread's instructions are all modeled before the counters are read
+   core->getPerformanceModel()->synchronize();
+
    // send message to master process to update thread state
-   SInt32 msg[] = { MCP_MESSAGE_THREAD_EXIT, m_tile_manager->getCurrentCoreID().tile_id, m_tile_manager->getCurrentCoreID().core_type, thread_idx};
+   ThreadExitRequest req = { MCP_MESSAGE_THREAD_EXIT,
+                             m_tile_manager->getCurrentCoreID(),
+                             thread_idx,
+                             core->getPerformanceModel()->getInstructionCount(),
+                             core->getPerformanceModel()->getMemoryStallCycles() };
 
    LOG_PRINT("onThreadExit -- send message to master ThreadManager; thread %i on {%d, %d} at time %llu",
              thread_idx,
@@ -159,17 +180,24 @@ void ThreadManager::onThreadExit()
              core->getPerformanceModel()->getCycleCount());
    Network *net = tile->getNetwork();
 
+   // The writes held back by the thread go out before it is gone
+   core->getSyscallMdl()->flushWrites();
+
    // Recompute Average Frequency
    core->getPerformanceModel()->recomputeAverageFrequency();
 
    // update global thread state
    net->netSend(Config::getSingleton()->getMCPCoreId(),
                 MCP_REQUEST_TYPE,
-                msg,
-                sizeof(SInt32) + sizeof(core_id_t) + sizeof(thread_id_t));
+                &req,
+                sizeof(req));
 
    m_thread_scheduler->onThreadExit();
 
+   // The next thread on the tile continues the instruction stream trace
+   if (core->getPerformanceModel()->getTraceWriter())
+      core->getPerformanceModel()->getTraceWriter()->writeThreadExit();
+
    // Set the CoreState to 'IDLE'
    core->setState(Core::IDLE);
 
@@ -186,7 +214,8 @@ void ThreadManager::onThreadExit()
    LOG_PRINT("Finished ThreadManager::onThreadExit: thread %i {%d, %d}", thread_idx, core->getId().tile_id, core->getId().core_type);
 }
 
-void ThreadManager::masterOnThreadExit(tile_id_t tile_id, UInt32 core_type, SInt32 thread_idx,  UInt64 time)
+void ThreadManager::masterOnThreadExit(tile_id_t tile_id, UInt32 core_type, SInt32 thread_idx,  UInt64 time,
+                                       UInt64 instruction_count, UInt64 memory_stall_cycles)
 {
    LOG_ASSERT_ERROR(m_master, "masterOnThreadExit should only be called on master.");
    LOG_PRINT("masterOnThreadExit : thread %i {%d, %d}", thread_idx, tile_id, core_type);
@@ -200,7 +229,7 @@ void ThreadManager::masterOnThreadExit(tile_id_t tile_id, UInt32 core_type, SInt
 
    wakeUpWaiter((core_id_t) {tile_id, core_type}, thread_idx, time);
 
-   m_thread_scheduler->masterOnThreadExit((core_id_t) {tile_id, core_type}, thread_idx);
+   m_thread_scheduler->masterOnThreadExit((core_id_t) {tile_id, core_type}, thread_idx, time, instruction_count, memory_stall_cycles);
 
    if (Config::getSingleton()->getSimulationMode() == Config::FULL)
       slaveTerminateThreadSpawnerAck(tile_id);
@@ -233,8 +262,6 @@ SInt32 ThreadManager::spawnThread(tile_id_t tile_id, thread_func_t func, void *a
    // Tile Clock to Global Clock
    UInt64 global_cycle_count = convertCycleCount(core->getPerformanceModel()->getCycleCount(),
          core->getPerformanceModel()->getFrequency(), 1.0);
-   
-   core->setState(Core::STALLED);
 
    core_id_t dest_core = INVALID_CORE_ID;
 
@@ -242,6 +269,25 @@ SInt32 ThreadManager::spawnThread(tile_id_t tile_id, thread_func_t func, void *a
    if (tile_id != INVALID_TILE_ID)
       dest_core = Tile::getMainCoreId(tile_id);
 
+   if (m_async_spawn)
+   {
+      // The master places and starts the thread on its own, the spawner only needs the tid. Requests
+      // from one tile are handled in order, so a later join from this tile finds the thread
+      ThreadSpawnRequest req = { MCP_MESSAGE_THREAD_SPAWN_ASYNC_REQUEST_FROM_REQUESTER,
+                                 func, arg, core->getId(), thread_index, dest_core, INVALID_THREAD_ID, reserveThreadId(),
+                                 global_cycle_count };
+
+      net->netSend(Config::getSingleton()->getMCPCoreId(),
+                   MCP_REQUEST_TYPE,
+                   &req,
+                   sizeof(req));
+
+      LOG_PRINT("Thread %i spawned asynchronously", req.destination_tid);
+      return req.destination_tid;
+   }
+
+   core->setState(Core::STALLED);
+
    ThreadSpawnRequest req = { MCP_MESSAGE_THREAD_SPAWN_REQUEST_FROM_REQUESTER,
                              func, arg, core->getId(), thread_index, dest_core, INVALID_THREAD_ID, INVALID_THREAD_ID,
                               global_cycle_count };
@@ -281,7 +327,9 @@ void ThreadManager::masterSpawnThread(ThreadSpawnRequest *req)
    Config * config = Config::getSingleton();
    tile_id_t target_tile = req->requester.tile_id;
    UInt32 num_application_tiles = config->getApplicationTiles();;
-   stallThread(req->requester, req->requester_tidx);
+   bool is_async = (req->msg_type == MCP_MESSAGE_THREAD_SPAWN_ASYNC_REQUEST_FROM_REQUESTER);
+   if (!is_async)
+      stallThread(req->requester, req->requester_tidx);
 
    if (req->destination.tile_id == INVALID_TILE_ID)
    {
@@ -315,11 +363,15 @@ void ThreadManager::masterSpawnThread(ThreadSpawnRequest *req)
    LOG_ASSERT_ERROR(req->destination.tile_id != INVALID_TILE_ID, "No cores available for spawnThread request.");
    LOG_ASSERT_ERROR(req->destination_tidx != INVALID_THREAD_ID, "No threads available on destination core for spawnThread request.");
 
-   req->destination_tid = this->getNewThreadId(req->destination, req->destination_tidx);
+   req->destination_tid = this->getNewThreadId(req->destination, req->destination_tidx, is_async ? req->destination_tid : INVALID_THREAD_ID);
    LOG_ASSERT_ERROR(req->destination_tid != INVALID_THREAD_ID, "Problem generating new thread id.");
 
    m_thread_scheduler->masterScheduleThread(req);
 
+   // The spawner did not wait
+   if (is_async)
+      return;
+
    // Tell the spawning thread we are finished.
    LOG_PRINT("masterSpawnThread -- send ack to master; req : { %p, %p, {%i, %i}, %i, {%i, %i}, %i , %i}",
              req->func, req->arg, req->requester.tile_id, req->requester.core_type, req->requester_tidx,
@@ -580,12 +632,24 @@ void ThreadManager::updateTerminateThreadSpawner()
    ++m_thread_spawners_terminated;
 }
 
-thread_id_t ThreadManager::getNewThreadId(core_id_t core_id, thread_id_t thread_index)
+thread_id_t ThreadManager::reserveThreadId()
 {
-   m_tid_counter_lock.acquire();
+   ScopedLock sl(m_tid_counter_lock);
 
    m_tid_counter++;
-   thread_id_t new_thread_id = m_tid_counter;
+   return m_tid_counter;
+}
+
+thread_id_t ThreadManager::getNewThreadId(core_id_t core_id, thread_id_t thread_index, thread_id_t reserved_thread_id)
+{
+   m_tid_counter_lock.acquire();
+
+   thread_id_t new_thread_id = reserved_thread_id;
+   if (new_thread_id == INVALID_THREAD_ID)
+   {
+      m_tid_counter++;
+      new_thread_id = m_tid_counter;
+   }
 
    if (m_tid_to_core_map.size() <= (UInt32) new_thread_id)
       m_tid_to_core_map.resize(2 * new_thread_id);
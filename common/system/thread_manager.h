@@ -102,6 +102,7 @@ public:
    void queryThreadIndex(thread_id_t thread_id, core_id_t &core_id, thread_id_t &thread_idx, thread_id_t &next_tidx);
 
    friend class ThreadScheduler;
+   friend class WorkStealingThreadScheduler;
    void setThreadScheduler(ThreadScheduler* thread_scheduler) {m_thread_scheduler = thread_scheduler;}
 
 private:
@@ -115,7 +116,8 @@ private:
 
 
    void masterOnThreadStart(tile_id_t tile_id, UInt32 core_type, SInt32 thread_idx);
-   void masterOnThreadExit(tile_id_t tile_id, UInt32 core_type, SInt32 thread_idx, UInt64 time);
+   void masterOnThreadExit(tile_id_t tile_id, UInt32 core_type, SInt32 thread_idx, UInt64 time,
+                           UInt64 instruction_count, UInt64 memory_stall_cycles);
 
    void slaveTerminateThreadSpawnerAck (tile_id_t);
    void slaveTerminateThreadSpawner ();
@@ -127,7 +129,8 @@ private:
 
    void insertThreadSpawnRequest (ThreadSpawnRequest *req);
 
-   thread_id_t getNewThreadId(core_id_t core_id, thread_id_t thread_index);
+   thread_id_t reserveThreadId();
+   thread_id_t getNewThreadId(core_id_t core_id, thread_id_t thread_index, thread_id_t reserved_thread_id = INVALID_THREAD_ID);
    void lookupThreadIndex(thread_id_t thread_id, core_id_t &core_id, thread_id_t &thread_idx);
    void setThreadIndex(thread_id_t thread_id, core_id_t core_id, thread_id_t thread_idx);
    UInt32 getNumScheduledThreads(core_id_t core_id);
@@ -135,6 +138,9 @@ private:
    void masterQueryThreadIndex(tile_id_t req_tile_id, UInt32 req_core_type, thread_id_t thread_id);
 
 
+   // The spawner takes the new thread's tid itself and does not wait for the master (lite mode)
+   bool m_async_spawn;
+
    thread_id_t m_tid_counter;
    Lock m_tid_counter_lock;
    Lock m_tid_map_lock;
@@ -1,8 +1,11 @@
 #include <sys/syscall.h>
+#include <algorithm>
 #include <time.h>
 #include "thread_scheduler.h"
 #include "thread_manager.h"
 #include "round_robin_thread_scheduler.h"
+#include "work_stealing_thread_scheduler.h"
+#include "heterogeneous_thread_scheduler.h"
 #include "tile_manager.h"
 #include "config.h"
 #include "log.h"
@@ -13,15 +16,30 @@
 #include "tile.h"
 #include "core.h"
 #include "thread.h"
+#include "clock_converter.h"
 
 ThreadScheduler* ThreadScheduler::create(ThreadManager *thread_manager, TileManager *tile_manager)
 {
-   // WARNING: Do not change this parameter. Hard-coded until multi-threading bug is fixed
-   std::string scheme = "none"; // Sim()->getCfg()->getString("thread_scheduling/scheme");
+   std::string scheme = "none";
+   try
+   {
+      scheme = Sim()->getCfg()->getString("thread_scheduling/scheme", "none");
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read thread_scheduling/scheme from the cfg file");
+   }
    ThreadScheduler* thread_scheduler = NULL;
 
    if (scheme == "round_robin") {
-      thread_scheduler = new RoundRobinThreadScheduler(thread_manager, tile_manager);
+      // WARNING: Preempts running threads, disabled until multi-threading bug is fixed
+      LOG_PRINT_ERROR("The round_robin thread scheduling scheme is disabled until the multi-threading bug is fixed");
+   }
+   else if (scheme == "work_stealing") {
+      thread_scheduler = new WorkStealingThreadScheduler(thread_manager, tile_manager);
+   }
+   else if (scheme == "heterogeneous") {
+      thread_scheduler = new HeterogeneousThreadScheduler(thread_manager, tile_manager);
    }
    else if (scheme == "none") {
       thread_scheduler = new ThreadScheduler(thread_manager, tile_manager);
@@ -65,10 +83,28 @@ ThreadScheduler::ThreadScheduler(ThreadManager *thread_manager, TileManager *til
    m_thread_migration_enabled = true;
    m_thread_preemption_enabled = true;
 
-   // WARNING: Do not change this parameter. Hard-coded until multi-threading bug is fixed
+   m_scheme = Sim()->getCfg()->getString("thread_scheduling/scheme", "none");
+
+   // WARNING: Do not change these parameters. Preemptive scheduling is hard-coded off until
+   // multi-threading bug is fixed, work_stealing only moves threads that have not started yet
    m_thread_switch_quantum = 100; // (UInt64) Sim()->getCfg()->getInt("thread_scheduling/quantum"); 
-   std::string scheme = "none"; // Sim()->getCfg()->getString("thread_scheduling/scheme");
-   m_enabled = (scheme != "none");
+   m_enabled = false;
+
+   m_deterministic = config->isDeterministic();
+   if (m_deterministic)
+   {
+      try
+      {
+         m_thread_switch_quantum = (UInt64) Sim()->getCfg()->getInt("thread_scheduling/deterministic_quantum", 1000000);
+      }
+      catch (...)
+      {
+         LOG_PRINT_ERROR("Could not read thread_scheduling/deterministic_quantum from the cfg file");
+      }
+   }
+
+   m_num_migrations = 0;
+   m_num_threads_started.resize(m_total_tiles, 0);
 }
 
 ThreadScheduler::~ThreadScheduler()
@@ -97,7 +133,7 @@ void ThreadScheduler::onThreadExit()
    }
 }
 
-void ThreadScheduler::masterOnThreadExit(core_id_t core_id, SInt32 thread_idx)
+void ThreadScheduler::masterOnThreadExit(core_id_t core_id, SInt32 thread_idx, UInt64 time, UInt64 instruction_count, UInt64 memory_stall_cycles)
 {
    LOG_ASSERT_ERROR(m_master, "onThreadExit should only be called on master.");
    LOG_PRINT("In ThreadScheduler::masterOnThreadExit thread %i on {%i, %i}", thread_idx, core_id.tile_id, core_id.core_type); 
@@ -106,7 +142,11 @@ void ThreadScheduler::masterOnThreadExit(core_id_t core_id, SInt32 thread_idx)
    assert(m_thread_manager->isCoreRunning(core_id) == INVALID_THREAD_ID);
    if (core_id.tile_id != Sim()->getConfig()->getCurrentThreadSpawnerTileNum() && core_id.tile_id != Sim()->getConfig()->getMCPTileNum())
       if (!m_waiter_queue[core_id.tile_id].empty())
+      {
+         if (m_waiter_queue[core_id.tile_id].front()->destination_tidx == thread_idx)
+            masterOnThreadRun(core_id, m_waiter_queue[core_id.tile_id].front(), time, instruction_count, memory_stall_cycles);
          m_waiter_queue[core_id.tile_id].pop(); 
+      }
 
    thread_id_t next_tidx = INVALID_THREAD_ID; 
    if (!m_waiter_queue[core_id.tile_id].empty())
@@ -141,6 +181,9 @@ void ThreadScheduler::masterOnThreadExit(core_id_t core_id, SInt32 thread_idx)
 
    m_core_lock[core_id.tile_id].release();
 
+   if (next_tidx == INVALID_THREAD_ID)
+      masterOnCoreIdle(core_id);
+
    LOG_PRINT("Done ThreadScheduler::masterOnThreadExit lock for thread %i on {%i, %i}", thread_idx, core_id.tile_id, core_id.core_type); 
 }
 
@@ -209,7 +252,8 @@ void ThreadScheduler::masterStartThread(core_id_t core_id)
    // Grab the thread states on destination tile.
    std::vector< std::vector<ThreadManager::ThreadState> > thread_state = m_thread_manager->getThreadState();
 
-   m_last_start_time[req->destination.tile_id][req->destination_tidx] = (UInt32) time(NULL);
+   m_last_start_time[req->destination.tile_id][req->destination_tidx] = m_deterministic ? req->time : (UInt64) time(NULL);
+   m_num_threads_started[req->destination.tile_id] ++;
 
    // Spawn the thread by calling LCP on correct process.
    LOG_ASSERT_ERROR(thread_state[req->destination.tile_id][req->destination_tidx].status == Core::INITIALIZING || thread_state[req->destination.tile_id][req->destination_tidx].status == Core::STALLED, "Haven't made this work for starting waiting threads yet, current status %i", thread_state[req->destination.tile_id][req->destination_tidx].status);
@@ -233,14 +277,18 @@ void ThreadScheduler::masterStartThread(core_id_t core_id)
       // Insert the request in the thread request queue and the thread request map
       m_thread_manager->insertThreadSpawnRequest(req_cpy);
       m_thread_manager->m_thread_spawn_sem.signal();
-         
-      SInt32 msg[] = { req->destination.tile_id, req->destination.core_type, req->destination_tidx};
 
-      Core *core = m_tile_manager->getCurrentCore();
-      core->getNetwork()->netSend(req->requester, 
-                                  MCP_THREAD_SPAWN_REPLY_FROM_MASTER_TYPE,
-                                  msg,
-                                  sizeof(req->destination.tile_id)+sizeof(req->destination.core_type)+sizeof(req->destination_tidx));
+      // Nobody waits for a thread spawned asynchronously
+      if (req->msg_type != MCP_MESSAGE_THREAD_SPAWN_ASYNC_REQUEST_FROM_REQUESTER)
+      {
+         SInt32 msg[] = { req->destination.tile_id, req->destination.core_type, req->destination_tidx};
+
+         Core *core = m_tile_manager->getCurrentCore();
+         core->getNetwork()->netSend(req->requester, 
+                                     MCP_THREAD_SPAWN_REPLY_FROM_MASTER_TYPE,
+                                     msg,
+                                     sizeof(req->destination.tile_id)+sizeof(req->destination.core_type)+sizeof(req->destination_tidx));
+      }
    }
 
 }
@@ -330,6 +378,7 @@ void ThreadScheduler::masterMigrateThread(thread_id_t src_thread_idx, core_id_t
          migrating_thread_req->destination_tidx = dst_thread_idx;
 
          m_waiter_queue[dst_core_id.tile_id].push(migrating_thread_req);
+         m_num_migrations ++;
 
          // Start thread if it is startable.
          thread_id_t running_thread = m_thread_manager->isCoreRunning(dst_core_id);
@@ -637,14 +686,14 @@ void ThreadScheduler::yieldThread(bool is_pre_emptive)
    if (core_id.tile_id == 0 && Tile::isMainCore(core_id))
       return;
 
-   UInt32 current_time = (UInt32) time(NULL);
-   LOG_PRINT("In ThreadScheduler::yieldThread() for thread %i on %i, time active(%i) enabled_preempt(%i)", thread_idx, core_id.tile_id, current_time - m_last_start_time[core_id.tile_id][thread_idx], m_thread_preemption_enabled);
+   UInt64 current_time = getSchedulingTime();
+   LOG_PRINT("In ThreadScheduler::yieldThread() for thread %i on %i, time active(%llu) enabled_preempt(%i)", thread_idx, core_id.tile_id, current_time - m_last_start_time[core_id.tile_id][thread_idx], m_thread_preemption_enabled);
    bool ignore_timer = !is_pre_emptive;
    if (current_time - m_last_start_time[core_id.tile_id][thread_idx] >= m_thread_switch_quantum || ignore_timer)
    {
       if(!ignore_timer) {
          if (m_thread_preemption_enabled == false) {return;}
-         LOG_PRINT("ThreadScheduler::yieldThread counter reached %i, yielding thread %i on tile %i.", current_time - m_last_start_time[core_id.tile_id][thread_idx], thread_idx, core_id.tile_id);
+         LOG_PRINT("ThreadScheduler::yieldThread counter reached %llu, yielding thread %i on tile %i.", current_time - m_last_start_time[core_id.tile_id][thread_idx], thread_idx, core_id.tile_id);
       }
       else {
          LOG_PRINT("ThreadScheduler::yieldThread called with with ignore_timer, yielding thread %i on tile %i.", thread_idx, core_id.tile_id);
@@ -730,7 +779,7 @@ void ThreadScheduler::yieldThread(bool is_pre_emptive)
       }
 
       m_tile_manager->getCurrentCore()->setState(Core::RUNNING);
-      m_last_start_time[dst_core_id.tile_id][dst_thread_idx] = (UInt32) time(NULL);
+      m_last_start_time[dst_core_id.tile_id][dst_thread_idx] = getSchedulingTime();
 
       LOG_PRINT("Resuming thread %i on {%i, %i}", dst_thread_idx, dst_core_id.tile_id, dst_core_id.core_type);
    }
@@ -738,6 +787,14 @@ void ThreadScheduler::yieldThread(bool is_pre_emptive)
    m_core_lock[dst_core_id.tile_id].release();
 }
 
+UInt64 ThreadScheduler::getSchedulingTime()
+{
+   if (!m_deterministic)
+      return (UInt64) time(NULL);
+   Core* core = m_tile_manager->getCurrentCore();
+   return convertCycleCount(core->getPerformanceModel()->getCycleCount(), core->getPerformanceModel()->getFrequency(), 1.0);
+}
+
 void ThreadScheduler::masterYieldThread(ThreadYieldRequest* req)
 {
    LOG_ASSERT_ERROR(m_master, "ThreadScheduler::masterYieldThread should only be called on master.");
@@ -815,3 +872,28 @@ void ThreadScheduler::requeueThread(core_id_t core_id)
 {
    LOG_PRINT_ERROR("No scheme was set for requeuing threads!");
 }
+
+void ThreadScheduler::outputSummary(std::ostream& os)
+{
+   LOG_ASSERT_ERROR(m_master, "outputSummary should only be called on master.");
+
+   // Load balance over the tiles that run application threads
+   UInt64 total_threads_started = 0;
+   UInt64 max_threads_started = 0;
+   UInt32 num_tiles = 0;
+   for (UInt32 i = 0; i < m_total_tiles; i++)
+   {
+      if (!Config::getSingleton()->isApplicationTile(i))
+         continue;
+      total_threads_started += m_num_threads_started[i];
+      max_threads_started = std::max(max_threads_started, m_num_threads_started[i]);
+      num_tiles ++;
+   }
+
+   os << "Thread Scheduler Summary: " << endl;
+   os << "    Scheme: " << m_scheme << endl;
+   os << "    Thread Migrations: " << m_num_migrations << endl;
+   outputSchemeSummary(os);
+   os << "    Max Threads Started per Tile: " << max_threads_started << endl;
+   os << "    Average Threads Started per Tile: " << ((num_tiles > 0) ? ((double) total_threads_started) / num_tiles : 0.0) << endl;
+}
@@ -5,6 +5,8 @@
 #include <bitset>
 #include <queue>
 #include <map>
+#include <string>
+#include <ostream>
 //#include <sched.h>
 
 #include "cond.h"
@@ -24,14 +26,14 @@ protected:
    ThreadScheduler(ThreadManager*, TileManager*);
 
 public:
-   ~ThreadScheduler();
+   virtual ~ThreadScheduler();
    static ThreadScheduler* create(ThreadManager*, TileManager*);
 
    void masterScheduleThread(ThreadSpawnRequest *req);
    void masterStartThread(core_id_t core_id);
 
    void onThreadExit();
-   void masterOnThreadExit(core_id_t core_id, SInt32 thread_idx);
+   void masterOnThreadExit(core_id_t core_id, SInt32 thread_idx, UInt64 time, UInt64 instruction_count, UInt64 memory_stall_cycles);
 
    void disablePreemptiveScheduling(){m_thread_preemption_enabled = false; m_thread_migration_enabled = false;}
    void enablePreemptiveScheduling(){m_thread_preemption_enabled = true; m_thread_migration_enabled = true;}
@@ -54,13 +56,32 @@ public:
 
    thread_id_t getNextThreadIdx(core_id_t core_id);
 
+   void outputSummary(std::ostream& os);
+
 protected:
 
    friend class LCP;
    friend class MCP;
 
    bool masterCheckAffinityAndMigrate(core_id_t core_id, thread_id_t thread_idx, core_id_t &dst_core_id, thread_id_t &dst_thread_idx);
+
+   // Called on master (with no core lock held) when a thread exits and
+   // leaves its core with nothing to run
+   virtual void masterOnCoreIdle(core_id_t core_id) {}
+   // Called on master (with the core lock held) when the thread of 'req'
+   // exits at 'time' (in ns), with the counters of the core model of its
+   // tile (totals over all the threads the tile ran)
+   virtual void masterOnThreadRun(core_id_t core_id, const ThreadSpawnRequest* req, UInt64 time,
+                                  UInt64 instruction_count, UInt64 memory_stall_cycles) {}
+   virtual void outputSchemeSummary(std::ostream& os) {}
+
+   // The time a thread has been running is measured in seconds of host
+   // time, or in ns of simulated time in a deterministic run
+   // (general/deterministic)
+   UInt64 getSchedulingTime();
+
    bool m_master;
+   std::string m_scheme;
 
    UInt32 m_total_tiles;
    UInt32 m_threads_per_core;
@@ -76,12 +97,16 @@ protected:
 
    std::vector< std::queue<ThreadSpawnRequest*> > m_waiter_queue;
 
-   std::vector< std::vector<UInt32> > m_last_start_time;
+   std::vector< std::vector<UInt64> > m_last_start_time;
 
    bool m_thread_migration_enabled;
    bool m_thread_preemption_enabled;
-   UInt32 m_thread_switch_quantum;
+   UInt64 m_thread_switch_quantum;
+   bool m_deterministic;
    bool m_enabled;
+
+   UInt64 m_num_migrations;
+   std::vector<UInt64> m_num_threads_started;
 };
 
 #endif // THREAD_SCHEDULER_SERVER_H
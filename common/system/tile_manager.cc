@@ -14,6 +14,10 @@
 #include "config.h"
 #include "packetize.h"
 #include "message_types.h"
+#include "simulator.h"
+#include "host_resource_manager.h"
+#include "semaphore.h"
+#include "thread.h"
 
 #include "log.h"
 
@@ -39,7 +43,16 @@ TileManager::TileManager()
 
    for (UInt32 i = 0; i < num_local_tiles; i++)
    {
-      m_tiles.push_back(new Tile(local_tiles.at(i)));
+      tile_id_t tile_id = local_tiles.at(i);
+      if (tile_id >= (tile_id_t) m_tile_index_map.size())
+         m_tile_index_map.resize(tile_id + 1, -1);
+      m_tile_index_map[tile_id] = i;
+   }
+
+   constructTiles(local_tiles);
+
+   for (UInt32 i = 0; i < num_local_tiles; i++)
+   {
       m_initialized_cores.push_back(false);
       m_num_initialized_threads.push_back(0);
 
@@ -51,6 +64,98 @@ TileManager::TileManager()
    LOG_PRINT("Finished TileManager Constructor.");
 }
 
+struct TileManager::TileConstruction
+{
+   TileConstruction(const vector<tile_id_t>& local_tiles, vector<Tile*>& tiles)
+      : m_local_tiles(local_tiles)
+      , m_tiles(tiles)
+      , m_next_index(0)
+   {}
+
+   const vector<tile_id_t>& m_local_tiles;
+   vector<Tile*>& m_tiles;
+   volatile UInt32 m_next_index;
+   Semaphore m_done;
+};
+
+void TileManager::constructTiles(const vector<tile_id_t>& local_tiles)
+{
+   UInt32 num_threads = 1;
+   try
+   {
+      num_threads = Sim()->getCfg()->getInt("general/tile_construction_threads", 1);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read general/tile_construction_threads from the cfg file");
+   }
+   LOG_ASSERT_ERROR(num_threads >= 1, "general/tile_construction_threads(%u) must be at least 1", num_threads);
+
+   // The power/area models and the memory report measure the tiles with
+   // process-wide state, these tiles are built one at a time
+   if (Config::getSingleton()->getEnablePowerModeling() ||
+       Config::getSingleton()->getEnableAreaModeling() ||
+       Config::getSingleton()->isMemoryReportEnabled())
+   {
+      num_threads = 1;
+   }
+
+   m_tiles.assign(local_tiles.size(), (Tile*) NULL);
+   if (local_tiles.empty())
+      return;
+
+   // The first tile sets up the state shared by the tiles (e.g. the static
+   // parameters of the network and memory models) before the others are built
+   m_tiles[0] = constructTile(local_tiles.at(0), 0);
+
+   TileConstruction construction(local_tiles, m_tiles);
+   construction.m_next_index = 1;
+
+   num_threads = std::min(num_threads, (UInt32) local_tiles.size() - 1);
+   vector<Thread*> threads;
+   for (UInt32 i = 1; i < num_threads; i++)
+   {
+      threads.push_back(Thread::create(constructTilesThreadFunc, &construction));
+      threads.back()->run();
+   }
+
+   constructTilesThreadFunc(&construction);
+
+   // The workers and this thread
+   for (UInt32 i = 0; i < threads.size() + 1; i++)
+      construction.m_done.wait();
+   for (UInt32 i = 0; i < threads.size(); i++)
+      delete threads[i];
+
+   LOG_PRINT("Built %u tiles with %u threads", (UInt32) local_tiles.size(), (UInt32) threads.size() + 1);
+}
+
+void TileManager::constructTilesThreadFunc(void* vp)
+{
+   TileConstruction* construction = (TileConstruction*) vp;
+   while (true)
+   {
+      UInt32 index = __sync_fetch_and_add(&construction->m_next_index, 1);
+      if (index >= construction->m_local_tiles.size())
+         break;
+      construction->m_tiles[index] = constructTile(construction->m_local_tiles.at(index), index);
+   }
+   construction->m_done.signal();
+}
+
+Tile* TileManager::constructTile(tile_id_t tile_id, UInt32 tile_index)
+{
+   HostResourceManager* host_resource_manager = Sim()->getHostResourceManager();
+   if (host_resource_manager)
+      host_resource_manager->bindTileMemory(tile_index);
+
+   Tile* tile = new Tile(tile_id);
+
+   if (host_resource_manager)
+      host_resource_manager->unbindTileMemory();
+   return tile;
+}
+
 TileManager::~TileManager()
 {
    for (std::vector<Tile *>::iterator i = m_tiles.begin(); i != m_tiles.end(); i++)
@@ -160,6 +265,9 @@ void TileManager::doInitializeThread(UInt32 tile_index, UInt32 thread_index, SIn
     LOG_ASSERT_ERROR(m_tile_tls->get() == (void*)(m_tiles.at(tile_index)),
                      "TLS appears to be broken. %p != %p",
                      m_tile_tls->get(), (void*)(m_tiles.at(tile_index)));
+
+    if (Sim()->getHostResourceManager())
+       Sim()->getHostResourceManager()->pinAppThread(tile_index);
 }
 
 void TileManager::updateTLS(UInt32 tile_index, UInt32 thread_index, SInt32 thread_id)
@@ -231,25 +339,9 @@ UInt32 TileManager::getCurrentTileIndex()
 
 Tile *TileManager::getTileFromID(tile_id_t id)
 {
-   Tile *tile = NULL;
-   // Look up the index from the tile list
-   // FIXME: make this more cached
-   const Config::TileList & tiles(Config::getSingleton()->getTileListForProcess(Config::getSingleton()->getCurrentProcessNum()));
-   UInt32 idx = 0;
-   for (Config::TLCI i = tiles.begin(); i != tiles.end(); i++)
-   {
-      if (*i == id)
-      {
-         tile = m_tiles.at(idx);
-         break;
-      }
-
-      idx++;
-   }
-
-   LOG_ASSERT_ERROR(!tile || idx < Config::getSingleton()->getNumLocalTiles(), "Illegal index in getTileFromID!");
-
-   return tile;
+   // The network model shortcut calls this once per hop, so it has to be cheap
+   SInt32 idx = lookupTileIndex(id);
+   return (idx >= 0) ? m_tiles[idx] : NULL;
 }
 
 Tile *TileManager::getTileFromIndex(UInt32 index)
@@ -261,17 +353,9 @@ Tile *TileManager::getTileFromIndex(UInt32 index)
 
 UInt32 TileManager::getTileIndexFromID(tile_id_t tile_id)
 {
-   // Look up the index from the tile list
-   // FIXME: make this more cached
-   const Config::TileList & tiles(Config::getSingleton()->getTileListForProcess(Config::getSingleton()->getCurrentProcessNum()));
-   UInt32 idx = 0;
-   for (Config::TLCI i = tiles.begin(); i != tiles.end(); i++)
-   {
-      if (*i == tile_id)
-         return idx;
-
-      idx++;
-   }
+   SInt32 idx = lookupTileIndex(tile_id);
+   if (idx >= 0)
+      return idx;
 
    LOG_ASSERT_ERROR(false, "Tile lookup failed for tile id: %d!", tile_id);
    return INVALID_TILE_ID;
@@ -279,25 +363,8 @@ UInt32 TileManager::getTileIndexFromID(tile_id_t tile_id)
 
 Core *TileManager::getCoreFromID(core_id_t id)
 {
-   Tile *tile = NULL;
-   tile_id_t tile_id = id.tile_id;
-
-   // Look up the index from the tile list
-   // FIXME: make this more cached
-   const Config::TileList & tiles(Config::getSingleton()->getTileListForProcess(Config::getSingleton()->getCurrentProcessNum()));
-   UInt32 idx = 0;
-   for (Config::TLCI i = tiles.begin(); i != tiles.end(); i++)
-   {
-      if (*i == tile_id)
-      {
-         tile = m_tiles.at(idx);
-         break;
-      }
+   Tile *tile = getTileFromID(id.tile_id);
 
-      idx++;
-   }
-
-   LOG_ASSERT_ERROR(!tile || idx < Config::getSingleton()->getNumLocalTiles(), "Illegal index in getTileFromID!");
    LOG_ASSERT_ERROR(id.core_type == MAIN_CORE_TYPE, "id.core_type(%u)", id.core_type);
 
    return tile->getCore();
@@ -341,6 +408,29 @@ tile_id_t TileManager::registerSimThread()
     return tile->getId();
 }
 
+void TileManager::registerTimingThread(tile_id_t tile_id)
+{
+    LOG_ASSERT_ERROR(getCurrentTile() == NULL, "registerTimingThread - Initialized thread twice");
+
+    UInt32 tile_index = getTileIndexFromID(tile_id);
+    m_tile_tls->insert(m_tiles.at(tile_index));
+    m_tile_index_tls->insertInt(tile_index);
+    m_thread_type_tls->insertInt(TIMING_THREAD);
+}
+
+void TileManager::registerSimPoolThread()
+{
+    LOG_ASSERT_ERROR(getCurrentTile() == NULL, "registerSimPoolThread - Initialized thread twice");
+
+    m_thread_type_tls->insertInt(SIM_THREAD);
+}
+
+void TileManager::setCurrentSimTile(UInt32 tile_index)
+{
+    m_tile_tls->set(m_tiles[tile_index]);
+    m_tile_index_tls->setInt(tile_index);
+}
+
 bool TileManager::amiSimThread()
 {
     return m_thread_type_tls ? (m_thread_type_tls->getInt() == SIM_THREAD) : false;
@@ -24,6 +24,13 @@ public:
    void initializeThread(core_id_t core_id, thread_id_t thread_index = 0, thread_id_t thread_id = 0);
    void terminateThread();
    tile_id_t registerSimThread();
+   // Sim threads of a SimThreadPool serve many tiles, and switch the
+   // current tile to the one whose messages they are handling
+   void registerSimPoolThread();
+   void setCurrentSimTile(UInt32 tile_index);
+   // The timing thread of a core model (core/timing_thread/enabled) runs
+   // on behalf of the tile, but it is not an app thread
+   void registerTimingThread(tile_id_t tile_id);
 
    core_id_t getCurrentCoreID(); // id of currently active core (or INVALID_CORE_ID)
    tile_id_t getCurrentTileID(); // id of currently active core (or INVALID_TILE_ID)
@@ -52,6 +59,13 @@ private:
 
    void doInitializeThread(UInt32 tile_index, UInt32 thread_index, SInt32 thread_id);
 
+   // Tiles built by several host threads (general/tile_construction_threads)
+   struct TileConstruction;
+   void constructTiles(const std::vector<tile_id_t>& local_tiles);
+   static void constructTilesThreadFunc(void* vp);
+   // Builds the tile with its memory on the host node of its threads
+   static Tile* constructTile(tile_id_t tile_id, UInt32 tile_index);
+
    UInt32 *tid_map;
    TLS *m_tile_tls;
    TLS *m_tile_index_tls;
@@ -62,7 +76,8 @@ private:
    enum ThreadType {
        INVALID,
        APP_THREAD,
-       SIM_THREAD
+       SIM_THREAD,
+       TIMING_THREAD
    };
 
    bool** m_initialized_threads;
@@ -78,7 +93,15 @@ private:
    Lock m_num_registered_sim_threads_lock;
 
    std::vector<Tile*> m_tiles;
+   // Index into m_tiles for every tile id, -1 for tiles of other processes
+   std::vector<SInt32> m_tile_index_map;
    UInt32 m_max_threads_per_core;
+
+   SInt32 lookupTileIndex(tile_id_t tile_id)
+   {
+      return ((tile_id >= 0) && (tile_id < (tile_id_t) m_tile_index_map.size())) ?
+             m_tile_index_map[tile_id] : -1;
+   }
 };
 
 #endif
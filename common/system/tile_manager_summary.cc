@@ -2,12 +2,19 @@
 #include <string>
 #include <sstream>
 #include <algorithm>
+#include <cstdlib>
+#include <sched.h>
+#include <unistd.h>
 #include "log.h"
 #include "simulator.h"
 #include "config.h"
 #include "transport.h"
+#include "message_buffer.h"
 #include "tile.h"
 #include "tile_manager.h"
+#include "stats_registry.h"
+#include "cpi_stack.h"
+#include "thread.h"
 
 using namespace std;
 
@@ -17,7 +24,7 @@ using namespace std;
 // zero. This process then formats the output to look pretty. Only
 // process zero writes to the output stream passed in.
 
-static void gatherSummaries(vector<string> &summaries)
+static void gatherSummaries(vector<string> &summaries, vector<string> &stats)
 {
    Config *cfg = Config::getSingleton();
    Transport::Node *global_node = Transport::getSingleton()->getGlobalNode();
@@ -41,11 +48,20 @@ static void gatherSummaries(vector<string> &summaries)
 
          buf = global_node->recv();
          assert(*((tile_id_t*)buf) == tl[t]);
-         delete [] buf;
+         MessageBuffer::release(buf);
 
          buf = global_node->recv();
          summaries[tl[t]] = string((char*)buf);
-         delete [] buf;
+         MessageBuffer::release(buf);
+
+         if (Sim()->getStatsRegistry())
+         {
+            // UInt32 length, then the packed counters
+            buf = global_node->recv();
+            UInt32 length = *((UInt32*)buf);
+            stats[tl[t]] = string((char*)buf + sizeof(length), length);
+            MessageBuffer::release(buf);
+         }
       }
    }
 
@@ -57,6 +73,83 @@ static void gatherSummaries(vector<string> &summaries)
    LOG_PRINT("Done collecting.");
 }
 
+// Renders the summaries (and packs the counters) of the local tiles, each
+// into its own string. The workers take the tiles in turn from a shared
+// index, the results are sent in tile order once they are all done
+class SummaryWorker : public Runnable
+{
+public:
+   SummaryWorker()
+      : m_tiles(NULL), m_summaries(NULL), m_stats(NULL), m_next_tile(NULL), m_finished(false)
+   {}
+
+   void run()
+   {
+      while (true)
+      {
+         UInt32 i = __sync_fetch_and_add(m_next_tile, 1);
+         if (i >= m_tiles->size())
+            break;
+
+         LOG_PRINT("Output summary tile %i", (*m_tiles)[i]->getId());
+         stringstream ss;
+         (*m_tiles)[i]->outputSummary(ss);
+         (*m_summaries)[i] = ss.str();
+         if (Sim()->getStatsRegistry())
+            (*m_stats)[i] = Sim()->getStatsRegistry()->pack((*m_tiles)[i]->getId());
+      }
+      m_finished = true;
+   }
+
+   const vector<Tile*>* m_tiles;
+   vector<string>* m_summaries;
+   vector<string>* m_stats;
+   volatile UInt32* m_next_tile;
+   volatile bool m_finished;
+};
+
+static void renderSummaries(const vector<Tile*> &tiles, vector<string> &summaries, vector<string> &stats)
+{
+   SInt32 num_threads = 0;
+   try
+   {
+      num_threads = Sim()->getCfg()->getInt("general/summary_threads", 0);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read general/summary_threads from the cfg file");
+   }
+   if (num_threads <= 0)
+      num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+   num_threads = max<SInt32>(1, min<SInt32>(num_threads, tiles.size()));
+
+   volatile UInt32 next_tile = 0;
+   vector<SummaryWorker> workers(num_threads);
+   vector<Thread*> threads(num_threads, (Thread*) NULL);
+   for (SInt32 i = 0; i < num_threads; i++)
+   {
+      workers[i].m_tiles = &tiles;
+      workers[i].m_summaries = &summaries;
+      workers[i].m_stats = &stats;
+      workers[i].m_next_tile = &next_tile;
+   }
+
+   // This thread is one of the workers
+   for (SInt32 i = 1; i < num_threads; i++)
+   {
+      threads[i] = Thread::create(&workers[i]);
+      threads[i]->run();
+   }
+   workers[0].run();
+
+   for (SInt32 i = 1; i < num_threads; i++)
+   {
+      while (!workers[i].m_finished)
+         sched_yield();
+      delete threads[i];
+   }
+}
+
 class Table
 {
 public:
@@ -194,6 +287,42 @@ void addTileSummary(Table &table, tile_id_t tile, const string &summary)
    }
 }
 
+// CPI stack of the chip: the CPI stacks of the cores in the core model
+// summaries, weighted by their instructions
+string formatChipCpiStack(const Table &table)
+{
+   unsigned int instructions_row = 0;
+   unsigned int stack_row = 0;
+   for (unsigned int r = 1; r < table.rows(); r++)
+   {
+      if ((instructions_row == 0) && (table.at(r,0) == "    Total Instructions"))
+         instructions_row = r;
+      else if ((stack_row == 0) && (table.at(r,0) == "    CPI Stack"))
+         stack_row = r;
+   }
+   if ((instructions_row == 0) || (stack_row == 0) || (stack_row + CpiStack::NUM_COMPONENTS >= table.rows()))
+      return "";
+
+   double total_instructions = 0;
+   vector<double> total_cycles(CpiStack::NUM_COMPONENTS, 0);
+   for (unsigned int c = 1; c < table.cols(); c++)
+   {
+      double instructions = atof(table.at(instructions_row, c).c_str());
+      total_instructions += instructions;
+      for (UInt32 i = 0; i < CpiStack::NUM_COMPONENTS; i++)
+         total_cycles[i] += atof(table.at(stack_row + 1 + i, c).c_str()) * instructions;
+   }
+
+   stringstream out;
+   out << "Chip CPI Stack:" << endl;
+   for (UInt32 i = 0; i < CpiStack::NUM_COMPONENTS; i++)
+   {
+      out << "    " << CpiStack::getName(i) << ": "
+          << ((total_instructions > 0) ? (total_cycles[i] / total_instructions) : 0.0) << endl;
+   }
+   return out.str();
+}
+
 string formatSummaries(const vector<string> &summaries)
 {
    // assume that each tile outputs the same information
@@ -213,7 +342,7 @@ string formatSummaries(const vector<string> &summaries)
       addTileSummary(table, i, summaries[i]);
    }
 
-   return table.flatten();
+   return table.flatten() + formatChipCpiStack(table);
 }
 
 void TileManager::outputSummary(ostream &os)
@@ -233,19 +362,28 @@ void TileManager::outputSummary(ostream &os)
    {
       Byte *buf = global_node->recv();
       assert(*((UInt32*)buf) == cfg->getCurrentProcessNum());
-      delete [] buf;
+      MessageBuffer::release(buf);
    }
 
    // send each summary
    const Config::TileList &tl = cfg->getTileListForProcess(cfg->getCurrentProcessNum());
 
+   vector<string> local_summaries(tl.size());
+   vector<string> local_stats(tl.size());
+   renderSummaries(m_tiles, local_summaries, local_stats);
+
    for (UInt32 i = 0; i < tl.size(); i++)
    {
-      LOG_PRINT("Output summary tile %i", tl[i]);
-      stringstream ss;
-      m_tiles[i]->outputSummary(ss);
       global_node->globalSend(0, &tl[i], sizeof(tl[i]));
-      global_node->globalSend(0, ss.str().c_str(), ss.str().length()+1);
+      global_node->globalSend(0, local_summaries[i].c_str(), local_summaries[i].length()+1);
+
+      if (Sim()->getStatsRegistry())
+      {
+         string& packed = local_stats[i];
+         UInt32 length = packed.length();
+         packed.insert(0, (const char*) &length, sizeof(length));
+         global_node->globalSend(0, packed.data(), packed.length());
+      }
    }
 
    // format (only done on proc 0)
@@ -253,12 +391,16 @@ void TileManager::outputSummary(ostream &os)
       return;
 
    vector<string> summaries(cfg->getTotalTiles());
+   vector<string> stats(cfg->getTotalTiles());
    string formatted;
 
-   gatherSummaries(summaries);
+   gatherSummaries(summaries, stats);
    formatted = formatSummaries(summaries);
 
    os << formatted;                   
 
+   if (Sim()->getStatsRegistry())
+      StatsRegistry::write(cfg->formatOutputFileName(StatsRegistry::getFileName()), stats);
+
    LOG_PRINT("Finished outputSummary");
 }
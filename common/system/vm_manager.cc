@@ -1,5 +1,10 @@
+#include <errno.h>
+#include <algorithm>
+
 #include "vm_manager.h"
 #include "simulator.h"
+#include "mcp.h"
+#include "mmu.h"
 #include <boost/lexical_cast.hpp>
 #include "log.h"
 
@@ -41,6 +46,32 @@ VMManager::VMManager()
    LOG_ASSERT_ERROR(m_start_dynamic_segment > m_end_stack_segment,
        "Problem with Application Stack: end_stack_segment(0x%x), start_dynamic_segment(0x%x)",
        m_end_stack_segment, m_start_dynamic_segment);
+
+   try
+   {
+      m_allocation_policy = parseAllocationPolicy(Sim()->getCfg()->getString("vm_manager/allocation_policy", "first_fit"));
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read vm_manager/allocation_policy from the cfg file");
+   }
+
+   m_page_size = getpagesize();
+   insertFreeRange(m_end_stack_segment, m_end_dynamic_segment);
+}
+
+VMManager::AllocationPolicy
+VMManager::parseAllocationPolicy(std::string policy)
+{
+   if (policy == "first_fit")
+      return FIRST_FIT;
+   else if (policy == "best_fit")
+      return BEST_FIT;
+   else
+   {
+      LOG_PRINT_ERROR("Unrecognized VM allocation policy(%s)", policy.c_str());
+      return NUM_ALLOCATION_POLICIES;
+   }
 }
 
 VMManager::~VMManager()
@@ -71,10 +102,11 @@ void *VMManager::brk(void *end_data_segment)
    return ((void*) m_end_data_segment);
 }
 
-void *VMManager::mmap(void *start, size_t length, int prot, int flags, int fd, off_t offset)
+void *VMManager::mmap(void *start, size_t length, int prot, int flags, int fd, off_t offset,
+                      bool delegated, UInt64 &recycled_length)
 {
-   LOG_PRINT("VMManager: mmap(start = %p, length = 0x%x, flags = 0x%x, fd = %i, offset = %u)",
-         start, length, flags, fd, flags);
+   LOG_PRINT("VMManager: mmap(start = %p, length = 0x%x, flags = 0x%x, fd = %i, offset = %u, delegated = %i)",
+         start, length, flags, fd, flags, delegated);
 
    LOG_ASSERT_ERROR(fd == -1, 
          "Mmap() system call, received valid file descriptor. Not currently supported");
@@ -84,15 +116,34 @@ void *VMManager::mmap(void *start, size_t length, int prot, int flags, int fd, o
          "Mmap() system call, MAP_FIXED should NOT be set in flags");
    LOG_ASSERT_ERROR((flags & MAP_PRIVATE) == MAP_PRIVATE,
          "Mmap() system call, MAP_PRIVATE should be set in flags");
-   
-   LOG_ASSERT_ERROR(m_end_stack_segment < (m_start_dynamic_segment - length),
-         "Mmap() system call: No more memory to allocate! end_stack_segment(0x%x), start_dynamic_segment(0x%x)",
-         m_end_stack_segment, m_start_dynamic_segment - length);
 
-   m_start_dynamic_segment -= length;
+   recycled_length = 0;
+   if (length == 0)
+      return (void*) -EINVAL;
+
+   IntPtr mapped_length = (length + m_page_size - 1) & ~(m_page_size - 1);
+   RangeMap::iterator it = findFreeRange(mapped_length);
+   LOG_ASSERT_ERROR(it != m_free_ranges.end(),
+         "Mmap() system call: No more memory to allocate! length(0x%x), end_stack_segment(0x%x), free ranges(%u)",
+         mapped_length, m_end_stack_segment, (UInt32) m_free_ranges.size());
+
+   // From the top of the range
+   IntPtr range_start = it->first;
+   IntPtr end = it->second;
+   IntPtr mapped_start = end - mapped_length;
+   eraseFreeRange(it);
+   if (mapped_start > range_start)
+      insertFreeRange(range_start, mapped_start);
 
-   LOG_PRINT("VMManager: mmap() returned %p", (void*) m_start_dynamic_segment);
-   return ((void*) m_start_dynamic_segment);
+   if (end > m_start_dynamic_segment)
+      recycled_length = end - std::max(mapped_start, m_start_dynamic_segment);
+   m_start_dynamic_segment = std::min(m_start_dynamic_segment, mapped_start);
+
+   if (delegated)
+      m_delegated_chunks[mapped_start] = end;
+
+   LOG_PRINT("VMManager: mmap() returned %p", (void*) mapped_start);
+   return ((void*) mapped_start);
 }
 
 int VMManager::munmap(void *start, size_t length)
@@ -100,11 +151,109 @@ int VMManager::munmap(void *start, size_t length)
    LOG_PRINT("VMManager: munmap(start = %p, length = 0x%x",
          start, length);
 
-   // Ignore for now
-   LOG_ASSERT_ERROR(m_start_dynamic_segment <= ((IntPtr) start),
-         "Munmap() system call, start(0x%x), start_dynamic_segment(0x%x)",
-         (IntPtr) start, m_start_dynamic_segment);
+   IntPtr unmapped_start = (IntPtr) start;
+   if ((length == 0) || ((unmapped_start & (m_page_size - 1)) != 0))
+      return -EINVAL;
+   IntPtr unmapped_end = unmapped_start + ((length + m_page_size - 1) & ~(m_page_size - 1));
+
+   LOG_ASSERT_ERROR((m_start_dynamic_segment <= unmapped_start) && (unmapped_end <= m_end_dynamic_segment),
+         "Munmap() system call, start(0x%x), length(0x%x), start_dynamic_segment(0x%x), end_dynamic_segment(0x%x)",
+         unmapped_start, length, m_start_dynamic_segment, m_end_dynamic_segment);
+
+   // The pages of the delegated chunks stay with their tiles
+   RangeMap::iterator it = m_delegated_chunks.upper_bound(unmapped_start);
+   if (it != m_delegated_chunks.begin())
+   {
+      RangeMap::iterator prev_it = it;
+      prev_it --;
+      if (prev_it->second > unmapped_start)
+         it = prev_it;
+   }
+
+   IntPtr addr = unmapped_start;
+   while (addr < unmapped_end)
+   {
+      if ((it == m_delegated_chunks.end()) || (it->first >= unmapped_end))
+      {
+         releaseRange(addr, unmapped_end);
+         break;
+      }
+      if (it->first > addr)
+         releaseRange(addr, it->first);
+      addr = std::max(addr, it->second);
+      it ++;
+   }
+
+   // The translations of the range are dropped from the TLBs of the tiles
+   if (MMU::isEnabled())
+      MMU::sendShootdown(Sim()->getMCP()->getNetwork(), unmapped_start, unmapped_end);
 
    LOG_PRINT("VMManager: munmap() returned 0");
    return 0;
 }
+
+VMManager::RangeMap::iterator
+VMManager::findFreeRange(IntPtr length)
+{
+   switch (m_allocation_policy)
+   {
+   case FIRST_FIT:
+      {
+         // The highest range that fits, as the segment grows down
+         RangeMap::iterator it = m_free_ranges.end();
+         while (it != m_free_ranges.begin())
+         {
+            it --;
+            if (it->second - it->first >= length)
+               return it;
+         }
+         return m_free_ranges.end();
+      }
+
+   case BEST_FIT:
+      {
+         RangeSizeSet::iterator it = m_free_range_sizes.lower_bound(std::make_pair(length, (IntPtr) 0));
+         if (it == m_free_range_sizes.end())
+            return m_free_ranges.end();
+         return m_free_ranges.find(it->second);
+      }
+
+   default:
+      LOG_PRINT_ERROR("Unrecognized VM allocation policy(%u)", m_allocation_policy);
+      return m_free_ranges.end();
+   }
+}
+
+void VMManager::insertFreeRange(IntPtr start, IntPtr end)
+{
+   m_free_ranges[start] = end;
+   m_free_range_sizes.insert(std::make_pair(end - start, start));
+}
+
+void VMManager::eraseFreeRange(RangeMap::iterator it)
+{
+   m_free_range_sizes.erase(std::make_pair(it->second - it->first, it->first));
+   m_free_ranges.erase(it);
+}
+
+void VMManager::releaseRange(IntPtr start, IntPtr end)
+{
+   // Merged with the free ranges it touches (pages unmapped twice included)
+   RangeMap::iterator it = m_free_ranges.upper_bound(start);
+   if (it != m_free_ranges.begin())
+   {
+      RangeMap::iterator prev_it = it;
+      prev_it --;
+      if (prev_it->second >= start)
+         it = prev_it;
+   }
+
+   while ((it != m_free_ranges.end()) && (it->first <= end))
+   {
+      start = std::min(start, it->first);
+      end = std::max(end, it->second);
+      eraseFreeRange(it++);
+   }
+
+   insertFreeRange(start, end);
+}
@@ -3,29 +3,70 @@
 
 #include <unistd.h>
 #include <sys/mman.h>
+#include <map>
+#include <set>
+#include <string>
 
 #include "fixed_types.h"
 
+// The address space of the application (full mode). The anonymous mmaps
+// are carved out of the free ranges of the dynamic segment (between the
+// stacks and 0xf000000000), top down, by first fit (the highest range that
+// fits) or best fit (the smallest one), and munmap gives the pages back.
+// A tile may take a chunk of the segment for itself ('delegated') to serve
+// its small mmaps locally: a munmap leaves the chunks alone.
+
 class VMManager
 {
    public:
+      enum AllocationPolicy
+      {
+         FIRST_FIT = 0,
+         BEST_FIT,
+         NUM_ALLOCATION_POLICIES
+      };
+
       VMManager();
       ~VMManager();
 
       void *brk(void *end_data_segment);
-      void *mmap(void *start, size_t length, int prot, int flags, int fd, off_t offset);
+      // 'recycled_length' is the length at the top of the region that was
+      // mapped before, and must be cleared by the caller
+      void *mmap(void *start, size_t length, int prot, int flags, int fd, off_t offset,
+                 bool delegated, UInt64 &recycled_length);
       void *mmap2(void *start, size_t length, int prot, int flags, int fd, off_t offset);
       int munmap(void *start, size_t length);
 
+      static AllocationPolicy parseAllocationPolicy(std::string policy);
+
    private:
+      // start -> end
+      typedef std::map<IntPtr, IntPtr> RangeMap;
+      // (size, start)
+      typedef std::set<std::pair<IntPtr, IntPtr> > RangeSizeSet;
+
+      RangeMap::iterator findFreeRange(IntPtr length);
+      void insertFreeRange(IntPtr start, IntPtr end);
+      void eraseFreeRange(RangeMap::iterator it);
+      void releaseRange(IntPtr start, IntPtr end);
+
       IntPtr m_start_data_segment;
       IntPtr m_end_data_segment;
       
       IntPtr m_start_stack_segment;
       IntPtr m_end_stack_segment;
 
+      // Lowest address mapped so far: the memory above it may hold the data
+      // of unmapped regions
       IntPtr m_start_dynamic_segment;
       IntPtr m_end_dynamic_segment;
+
+      AllocationPolicy m_allocation_policy;
+      IntPtr m_page_size;
+
+      RangeMap m_free_ranges;
+      RangeSizeSet m_free_range_sizes;
+      RangeMap m_delegated_chunks;
 };
 
 #endif /* __VM_MANAGER_H__ */
@@ -0,0 +1,174 @@
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include "work_stealing_thread_scheduler.h"
+#include "thread_manager.h"
+#include "tile_manager.h"
+#include "simulator.h"
+#include "config.h"
+#include "tile.h"
+#include "log.h"
+
+WorkStealingThreadScheduler::WorkStealingThreadScheduler(ThreadManager* thread_manager, TileManager* tile_manager) 
+: ThreadScheduler(thread_manager, tile_manager)
+, m_num_steals(0)
+{
+   // The application tiles are laid out on a mesh as in the network models
+   m_mesh_width = (SInt32) floor(sqrt((double) Config::getSingleton()->getApplicationTiles()));
+   if (m_mesh_width < 1)
+      m_mesh_width = 1;
+}
+
+WorkStealingThreadScheduler::~WorkStealingThreadScheduler()
+{
+}
+
+void WorkStealingThreadScheduler::requeueThread(core_id_t core_id)
+{
+   // Same as round robin on a tile
+   ThreadSpawnRequest *req_cpy;
+   req_cpy = m_waiter_queue[core_id.tile_id].front();
+   m_waiter_queue[core_id.tile_id].pop();
+   m_waiter_queue[core_id.tile_id].push(req_cpy);
+}
+
+bool WorkStealingThreadScheduler::isStealableTile(tile_id_t tile_id)
+{
+   // The thread spawner tile queues no threads and the main thread stays on tile 0
+   return (tile_id != 0 &&
+           tile_id != Sim()->getConfig()->getCurrentThreadSpawnerTileNum() &&
+           tile_id != Sim()->getConfig()->getMCPTileNum() &&
+           Config::getSingleton()->isApplicationTile(tile_id));
+}
+
+SInt32 WorkStealingThreadScheduler::getDistance(tile_id_t tile_id_1, tile_id_t tile_id_2)
+{
+   return abs(tile_id_1 % m_mesh_width - tile_id_2 % m_mesh_width) +
+          abs(tile_id_1 / m_mesh_width - tile_id_2 / m_mesh_width);
+}
+
+void WorkStealingThreadScheduler::getVictimTiles(tile_id_t tile_id, std::vector<tile_id_t>& victims)
+{
+   // Nearest victims first
+   std::vector< std::pair<SInt32, tile_id_t> > distances;
+   for (tile_id_t i = 0; i < (tile_id_t) m_total_tiles; i++)
+   {
+      if (i == tile_id || !isStealableTile(i))
+         continue;
+      distances.push_back(std::make_pair(getDistance(tile_id, i), i));
+   }
+   std::sort(distances.begin(), distances.end());
+
+   victims.clear();
+   for (UInt32 i = 0; i < distances.size(); i++)
+      victims.push_back(distances[i].second);
+}
+
+void WorkStealingThreadScheduler::masterOnCoreIdle(core_id_t core_id)
+{
+   if (!isStealableTile(core_id.tile_id))
+      return;
+
+   std::vector<tile_id_t> victims;
+   getVictimTiles(core_id.tile_id, victims);
+   for (UInt32 i = 0; i < victims.size(); i++)
+   {
+      if (stealThread(Tile::getMainCoreId(victims[i]), core_id))
+         return;
+   }
+}
+
+bool WorkStealingThreadScheduler::stealThread(core_id_t src_core_id, core_id_t dst_core_id)
+{
+   // Locks are always taken in tile order
+   core_id_t first_core_id = (src_core_id.tile_id < dst_core_id.tile_id) ? src_core_id : dst_core_id;
+   core_id_t second_core_id = (src_core_id.tile_id < dst_core_id.tile_id) ? dst_core_id : src_core_id;
+   m_core_lock[first_core_id.tile_id].acquire();
+   m_core_lock[second_core_id.tile_id].acquire();
+
+   // The thread at the front of the source queue is the one on the core
+   std::queue<ThreadSpawnRequest*>& src_queue = m_waiter_queue[src_core_id.tile_id];
+   std::queue<ThreadSpawnRequest*>& dst_queue = m_waiter_queue[dst_core_id.tile_id];
+
+   thread_id_t dst_thread_idx = INVALID_THREAD_ID;
+   if (src_queue.size() > 1 && dst_queue.empty() &&
+       m_thread_manager->isCoreRunning(dst_core_id) == INVALID_THREAD_ID &&
+       !m_thread_manager->isCoreInitializing(dst_core_id))
+   {
+      dst_thread_idx = m_thread_manager->getIdleThread(dst_core_id);
+   }
+
+   ThreadSpawnRequest *stolen_thread_req = NULL;
+   if (dst_thread_idx != INVALID_THREAD_ID)
+   {
+      size_t setsize = CPU_ALLOC_SIZE(m_total_tiles);
+      cpu_set_t* set = CPU_ALLOC(m_total_tiles);
+      cpu_set_t* zero_set = CPU_ALLOC(m_total_tiles);
+      CPU_ZERO_S(setsize, zero_set);
+
+      // Take the first thread that has not started yet and may run on the destination tile,
+      // rotating the queue back to its order
+      UInt32 waiter_queue_size = src_queue.size();
+      for (UInt32 i = 0; i < waiter_queue_size; i++)
+      {
+         ThreadSpawnRequest *req_cpy = src_queue.front();
+         src_queue.pop();
+
+         bool is_stealable = false;
+         if (i > 0 && stolen_thread_req == NULL &&
+             m_thread_manager->getThreadState(src_core_id.tile_id, req_cpy->destination_tidx) == Core::INITIALIZING)
+         {
+            m_thread_manager->getThreadAffinity(src_core_id.tile_id, req_cpy->destination_tidx, set);
+            is_stealable = ((CPU_EQUAL_S(setsize, zero_set, set) != 0) ||
+                            (CPU_ISSET_S(dst_core_id.tile_id, setsize, set) != 0)) &&
+                           isStealableThread(req_cpy, src_core_id, dst_core_id);
+         }
+
+         if (is_stealable)
+            stolen_thread_req = req_cpy;
+         else
+            src_queue.push(req_cpy);
+      }
+
+      CPU_FREE(set);
+      CPU_FREE(zero_set);
+   }
+
+   if (stolen_thread_req != NULL)
+   {
+      thread_id_t src_thread_idx = stolen_thread_req->destination_tidx;
+      LOG_PRINT("WorkStealingThreadScheduler: {%i, %i} steals thread %i from {%i, %i}", dst_core_id.tile_id, dst_core_id.core_type, src_thread_idx, src_core_id.tile_id, src_core_id.core_type);
+      onThreadStolen(stolen_thread_req, src_core_id, dst_core_id);
+
+      stolen_thread_req->destination.tile_id = dst_core_id.tile_id;
+      stolen_thread_req->destination.core_type = dst_core_id.core_type;
+      stolen_thread_req->destination_tidx = dst_thread_idx;
+      dst_queue.push(stolen_thread_req);
+
+      // Swap the thread states so that each affinity mask stays owned by one thread slot.
+      // The source core keeps running its own thread
+      std::vector< std::vector<ThreadManager::ThreadState> > thread_state = m_thread_manager->getThreadState();
+      ThreadManager::ThreadState src_thread_state = thread_state[src_core_id.tile_id][src_thread_idx];
+      ThreadManager::ThreadState dst_thread_state = thread_state[dst_core_id.tile_id][dst_thread_idx];
+
+      m_thread_manager->setThreadIndex(src_thread_state.thread_id, dst_core_id, dst_thread_idx);
+      m_thread_manager->setThreadState(dst_core_id.tile_id, dst_thread_idx, src_thread_state);
+      m_thread_manager->setThreadState(src_core_id.tile_id, src_thread_idx, dst_thread_state);
+
+      m_local_next_tidx[dst_core_id.tile_id] = dst_thread_idx;
+      this->masterStartThread(dst_core_id);
+
+      m_num_steals ++;
+   }
+
+   m_core_lock[second_core_id.tile_id].release();
+   m_core_lock[first_core_id.tile_id].release();
+
+   return (stolen_thread_req != NULL);
+}
+
+void WorkStealingThreadScheduler::outputSchemeSummary(std::ostream& os)
+{
+   os << "    Thread Steals: " << m_num_steals << endl;
+}
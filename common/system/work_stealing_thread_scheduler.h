@@ -0,0 +1,45 @@
+#ifndef WORK_STEALING_THREAD_SCHEDULER_H
+#define WORK_STEALING_THREAD_SCHEDULER_H
+
+#include "thread_scheduler.h"
+
+class ThreadManager;
+class TileManager;
+
+/*
+  Threads are queued on the tile they were spawned on as with the other
+  schemes, and a tile whose last thread exits steals a thread that has not
+  started yet from the nearest tile (in mesh hops) that has more than one
+  thread queued, as long as the thread's affinity mask allows it. The running
+  threads are never moved.
+ */
+class WorkStealingThreadScheduler : public ThreadScheduler
+{
+public:
+   WorkStealingThreadScheduler(ThreadManager *thread_manager, TileManager *tile_manager);
+   ~WorkStealingThreadScheduler();
+
+   virtual void requeueThread(core_id_t core_id);
+
+protected:
+   virtual void masterOnCoreIdle(core_id_t core_id);
+   virtual void outputSchemeSummary(std::ostream& os);
+
+   // Whether the thread of 'req', that has not started and may run on the
+   // destination tile, can be stolen, and what to do with its request when
+   // it is (before it is started on the destination tile)
+   virtual bool isStealableThread(const ThreadSpawnRequest* req, core_id_t src_core_id, core_id_t dst_core_id) { return true; }
+   virtual void onThreadStolen(ThreadSpawnRequest* req, core_id_t src_core_id, core_id_t dst_core_id) {}
+
+   bool isStealableTile(tile_id_t tile_id);
+   // The tiles a thread can be stolen from by 'tile_id', nearest first
+   void getVictimTiles(tile_id_t tile_id, std::vector<tile_id_t>& victims);
+   SInt32 getDistance(tile_id_t tile_id_1, tile_id_t tile_id_2);
+   bool stealThread(core_id_t src_core_id, core_id_t dst_core_id);
+
+private:
+   SInt32 m_mesh_width;
+   UInt64 m_num_steals;
+};
+
+#endif // WORK_STEALING_THREAD_SCHEDULER_H
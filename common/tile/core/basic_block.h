@@ -3,14 +3,28 @@
 
 #include <vector>
 
-class Instruction;
+#include "instruction.h"
 
 class BasicBlock : public std::vector<Instruction*>
 {
 public:
+   // What the core models need to charge the whole block at once, computed
+   // once by summarize() when the block is instrumented. Only blocks of
+   // static instructions, with a conditional branch (if any) at the end,
+   // can be summarized
+   struct Summary
+   {
+      bool valid;
+      UInt64 static_cost;           // all instructions but the branch
+      UInt32 num_memory_operands;
+      bool ends_with_branch;
+   };
+
    BasicBlock(bool dynamic = false) 
       : m_dynamic(dynamic)
-      {}
+      {
+         m_summary.valid = false;
+      }
 
    ~BasicBlock()
       {
@@ -26,8 +40,49 @@ public:
 
    bool isDynamic() { return m_dynamic; }
 
+   void summarize()
+      {
+         m_summary.valid = !m_dynamic && !empty();
+         m_summary.static_cost = 0;
+         m_summary.num_memory_operands = 0;
+         m_summary.ends_with_branch = false;
+
+         for (unsigned int i = 0; i < size(); i++)
+         {
+            Instruction* ins = (*this)[i];
+            switch (ins->getType())
+            {
+            case INST_BRANCH:
+               if (i == (size() - 1))
+                  m_summary.ends_with_branch = true;
+               else
+                  m_summary.valid = false;
+               break;
+            case INST_DYNAMIC_MISC:
+            case INST_RECV:
+            case INST_SYNC:
+            case INST_SPAWN:
+               m_summary.valid = false;
+               break;
+            default:
+               m_summary.static_cost += ins->getCost();
+               break;
+            }
+
+            const OperandList& ops = ins->getOperands();
+            for (unsigned int j = 0; j < ops.size(); j++)
+            {
+               if (ops[j].m_type == Operand::MEMORY)
+                  m_summary.num_memory_operands ++;
+            }
+         }
+      }
+
+   const Summary& getSummary() const { return m_summary; }
+
 private:
    bool m_dynamic;
+   Summary m_summary;
 };
 
 #endif
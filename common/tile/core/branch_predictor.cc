@@ -1,6 +1,12 @@
 #include "simulator.h"
 #include "branch_predictor.h"
+#include "checkpoint.h"
 #include "one_bit_branch_predictor.h"
+#include "bimodal_branch_predictor.h"
+#include "gshare_branch_predictor.h"
+#include "tournament_branch_predictor.h"
+#include "tage_branch_predictor.h"
+#include "perceptron_branch_predictor.h"
 
 BranchPredictor::BranchPredictor()
 {
@@ -31,6 +37,27 @@ BranchPredictor* BranchPredictor::create()
          UInt32 size = cfg->getInt("branch_predictor/size");
          return new OneBitBranchPredictor(size);
       }
+      else if (type == "bimodal")
+      {
+         UInt32 size = cfg->getInt("branch_predictor/size");
+         UInt32 btb_size = cfg->getInt("branch_predictor/btb_size", 0);
+         return new BimodalBranchPredictor(size, btb_size);
+      }
+      else if ((type == "gshare") || (type == "tournament") || (type == "tage") || (type == "perceptron"))
+      {
+         UInt32 size = cfg->getInt("branch_predictor/size");
+         UInt32 history_length = cfg->getInt("branch_predictor/history_length", 16);
+         UInt32 btb_size = cfg->getInt("branch_predictor/btb_size", 0);
+
+         if (type == "gshare")
+            return new GShareBranchPredictor(size, history_length, btb_size);
+         else if (type == "tournament")
+            return new TournamentBranchPredictor(size, history_length, btb_size);
+         else if (type == "tage")
+            return new TAGEBranchPredictor(size, history_length, btb_size);
+         else
+            return new PerceptronBranchPredictor(size, history_length, btb_size);
+      }
       else
       {
          LOG_PRINT_ERROR("Invalid branch predictor type.");
@@ -65,7 +92,23 @@ void BranchPredictor::initializeCounters()
 
 void BranchPredictor::outputSummary(std::ostream &os)
 {
+   UInt64 num_predictions = m_correct_predictions + m_incorrect_predictions;
+   float accuracy = (num_predictions > 0) ? (100.0 * m_correct_predictions / num_predictions) : 0.0;
+
    os << "  Branch predictor stats:" << endl
       << "    num correct: " << m_correct_predictions << endl
-      << "    num incorrect: " << m_incorrect_predictions << endl;
+      << "    num incorrect: " << m_incorrect_predictions << endl
+      << "    accuracy (%): " << accuracy << endl;
+}
+
+void BranchPredictor::saveState(CheckpointWriter& writer)
+{
+   writer.beginSection("Branch Predictor");
+   writer << m_correct_predictions << m_incorrect_predictions;
+}
+
+void BranchPredictor::restoreState(CheckpointReader& reader)
+{
+   reader.beginSection("Branch Predictor");
+   reader >> m_correct_predictions >> m_incorrect_predictions;
 }
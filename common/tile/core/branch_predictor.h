@@ -5,6 +5,9 @@
 
 #include "fixed_types.h"
 
+class CheckpointWriter;
+class CheckpointReader;
+
 class BranchPredictor
 {
 public:
@@ -18,6 +21,10 @@ public:
    static BranchPredictor* create();
 
    virtual void outputSummary(std::ostream &os);
+
+   // The prediction counters (not the tables) in the checkpoint of the core
+   void saveState(CheckpointWriter& writer);
+   void restoreState(CheckpointReader& reader);
    UInt64 getNumCorrectPredictions() { return m_correct_predictions; }
    UInt64 getNumIncorrectPredictions() { return m_incorrect_predictions; }
 
@@ -0,0 +1,29 @@
+#include "bimodal_branch_predictor.h"
+
+using std::endl;
+
+BimodalBranchPredictor::BimodalBranchPredictor(UInt32 size, UInt32 btb_size)
+   : TableBranchPredictor(btb_size)
+   , m_counters(size, 1)
+{
+}
+
+BimodalBranchPredictor::~BimodalBranchPredictor()
+{
+}
+
+bool BimodalBranchPredictor::predictDirection(IntPtr ip)
+{
+   return m_counters.isSet(ip);
+}
+
+void BimodalBranchPredictor::updateDirection(IntPtr ip, bool taken)
+{
+   m_counters.update(ip, taken);
+}
+
+void BimodalBranchPredictor::outputSummary(std::ostream &os)
+{
+   TableBranchPredictor::outputSummary(os);
+   os << "    type: bimodal (" << m_counters.size() << ")" << endl;
+}
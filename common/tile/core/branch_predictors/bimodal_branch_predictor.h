@@ -0,0 +1,23 @@
+#ifndef BIMODAL_BRANCH_PREDICTOR_H
+#define BIMODAL_BRANCH_PREDICTOR_H
+
+#include "table_branch_predictor.h"
+#include "counter_table.h"
+
+// 2-bit counters indexed by the branch address
+class BimodalBranchPredictor : public TableBranchPredictor
+{
+public:
+   BimodalBranchPredictor(UInt32 size, UInt32 btb_size);
+   ~BimodalBranchPredictor();
+
+   void outputSummary(std::ostream &os);
+
+private:
+   bool predictDirection(IntPtr ip);
+   void updateDirection(IntPtr ip, bool taken);
+
+   CounterTable<2> m_counters;
+};
+
+#endif
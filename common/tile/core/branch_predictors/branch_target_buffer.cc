@@ -0,0 +1,43 @@
+#include "branch_target_buffer.h"
+#include "utils.h"
+#include "log.h"
+
+using std::endl;
+
+BranchTargetBuffer::BranchTargetBuffer(UInt32 num_entries)
+   : m_ips(num_entries, 0)
+   , m_targets(num_entries, 0)
+   , m_mask(num_entries - 1)
+   , m_num_hits(0)
+   , m_num_misses(0)
+{
+   LOG_ASSERT_ERROR(isPower2(num_entries), "BTB size(%u) must be a power of 2", num_entries);
+}
+
+BranchTargetBuffer::~BranchTargetBuffer()
+{}
+
+bool BranchTargetBuffer::lookup(IntPtr ip, IntPtr target)
+{
+   UInt32 index = ip & m_mask;
+   if ((m_ips[index] == ip) && (m_targets[index] == target))
+   {
+      m_num_hits ++;
+      return true;
+   }
+   m_num_misses ++;
+   return false;
+}
+
+void BranchTargetBuffer::update(IntPtr ip, IntPtr target)
+{
+   UInt32 index = ip & m_mask;
+   m_ips[index] = ip;
+   m_targets[index] = target;
+}
+
+void BranchTargetBuffer::outputSummary(std::ostream &os)
+{
+   os << "    btb (" << m_ips.size() << ") hits: " << m_num_hits << endl
+      << "    btb (" << m_ips.size() << ") misses: " << m_num_misses << endl;
+}
@@ -0,0 +1,31 @@
+#ifndef BRANCH_TARGET_BUFFER_H
+#define BRANCH_TARGET_BUFFER_H
+
+#include <vector>
+#include <iostream>
+
+#include "fixed_types.h"
+
+// Direct-mapped. A branch predicted taken is fetched from its target only
+// if the BTB has it, otherwise the fetch falls through
+class BranchTargetBuffer
+{
+public:
+   BranchTargetBuffer(UInt32 num_entries);
+   ~BranchTargetBuffer();
+
+   bool lookup(IntPtr ip, IntPtr target);
+   void update(IntPtr ip, IntPtr target);
+
+   void outputSummary(std::ostream &os);
+
+private:
+   std::vector<IntPtr> m_ips;
+   std::vector<IntPtr> m_targets;
+   UInt32 m_mask;
+
+   UInt64 m_num_hits;
+   UInt64 m_num_misses;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef COUNTER_TABLE_H
+#define COUNTER_TABLE_H
+
+#include <vector>
+
+#include "fixed_types.h"
+#include "utils.h"
+#include "log.h"
+
+// Table of saturating counters of BITS bits each, packed in 64-bit words.
+// The number of counters must be a power of 2, indices wrap around
+template <UInt32 BITS>
+class CounterTable
+{
+public:
+   static const UInt32 MAX_VALUE = (1 << BITS) - 1;
+
+   CounterTable(UInt32 num_counters, UInt32 initial_value)
+      : m_words((num_counters + COUNTERS_PER_WORD - 1) / COUNTERS_PER_WORD, 0)
+      , m_mask(num_counters - 1)
+   {
+      LOG_ASSERT_ERROR(isPower2(num_counters), "Number of counters(%u) must be a power of 2", num_counters);
+      for (UInt32 i = 0; i < num_counters; i++)
+         set(i, initial_value);
+   }
+
+   UInt32 size() const { return m_mask + 1; }
+
+   UInt32 get(UInt32 index) const
+   {
+      index &= m_mask;
+      return (m_words[index / COUNTERS_PER_WORD] >> ((index % COUNTERS_PER_WORD) * BITS)) & MAX_VALUE;
+   }
+
+   void set(UInt32 index, UInt32 value)
+   {
+      index &= m_mask;
+      UInt32 shift = (index % COUNTERS_PER_WORD) * BITS;
+      UInt64& word = m_words[index / COUNTERS_PER_WORD];
+      word = (word & ~((UInt64) MAX_VALUE << shift)) | ((UInt64) value << shift);
+   }
+
+   // Counts up (down) until it saturates
+   void update(UInt32 index, bool up)
+   {
+      UInt32 value = get(index);
+      if (up && (value < MAX_VALUE))
+         set(index, value + 1);
+      else if (!up && (value > 0))
+         set(index, value - 1);
+   }
+
+   // The counter is in its upper half (e.g., predicts taken)
+   bool isSet(UInt32 index) const { return (get(index) > (MAX_VALUE >> 1)); }
+
+private:
+   static const UInt32 COUNTERS_PER_WORD = 64 / BITS;
+
+   std::vector<UInt64> m_words;
+   UInt32 m_mask;
+};
+
+#endif
@@ -0,0 +1,32 @@
+#include "gshare_branch_predictor.h"
+
+using std::endl;
+
+GShareBranchPredictor::GShareBranchPredictor(UInt32 size, UInt32 history_length, UInt32 btb_size)
+   : TableBranchPredictor(btb_size)
+   , m_counters(size, 1)
+   , m_history_length(history_length)
+{
+   LOG_ASSERT_ERROR(history_length <= 64, "History length(%u) must be <= 64", history_length);
+   m_history_mask = (history_length == 64) ? ~((UInt64) 0) : (((UInt64) 1 << history_length) - 1);
+}
+
+GShareBranchPredictor::~GShareBranchPredictor()
+{
+}
+
+bool GShareBranchPredictor::predictDirection(IntPtr ip)
+{
+   return m_counters.isSet(getIndex(ip));
+}
+
+void GShareBranchPredictor::updateDirection(IntPtr ip, bool taken)
+{
+   m_counters.update(getIndex(ip), taken);
+}
+
+void GShareBranchPredictor::outputSummary(std::ostream &os)
+{
+   TableBranchPredictor::outputSummary(os);
+   os << "    type: gshare (" << m_counters.size() << ", history " << m_history_length << ")" << endl;
+}
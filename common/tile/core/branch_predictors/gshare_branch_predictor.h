@@ -0,0 +1,28 @@
+#ifndef GSHARE_BRANCH_PREDICTOR_H
+#define GSHARE_BRANCH_PREDICTOR_H
+
+#include "table_branch_predictor.h"
+#include "counter_table.h"
+
+// 2-bit counters indexed by the branch address xor the global history
+class GShareBranchPredictor : public TableBranchPredictor
+{
+public:
+   GShareBranchPredictor(UInt32 size, UInt32 history_length, UInt32 btb_size);
+   ~GShareBranchPredictor();
+
+   void outputSummary(std::ostream &os);
+
+private:
+   bool predictDirection(IntPtr ip);
+   void updateDirection(IntPtr ip, bool taken);
+
+   UInt32 getIndex(IntPtr ip) const
+   { return (UInt32) (ip ^ (getGlobalHistory() & m_history_mask)); }
+
+   CounterTable<2> m_counters;
+   UInt32 m_history_length;
+   UInt64 m_history_mask;
+};
+
+#endif
@@ -0,0 +1,64 @@
+#include "perceptron_branch_predictor.h"
+#include "utils.h"
+#include "log.h"
+
+using std::endl;
+
+PerceptronBranchPredictor::PerceptronBranchPredictor(UInt32 size, UInt32 history_length, UInt32 btb_size)
+   : TableBranchPredictor(btb_size)
+   , m_weights(size * (history_length + 1), 0)
+   , m_num_perceptrons(size)
+   , m_history_length(history_length)
+   // Best training threshold for the history length (Jimenez and Lin)
+   , m_threshold((SInt32) (1.93 * history_length + 14))
+{
+   LOG_ASSERT_ERROR(isPower2(size), "Number of perceptrons(%u) must be a power of 2", size);
+   LOG_ASSERT_ERROR(history_length <= 64, "History length(%u) must be <= 64", history_length);
+}
+
+PerceptronBranchPredictor::~PerceptronBranchPredictor()
+{
+}
+
+SInt32 PerceptronBranchPredictor::getOutput(IntPtr ip) const
+{
+   const SInt8* weights = &m_weights[(ip & (m_num_perceptrons - 1)) * (m_history_length + 1)];
+   UInt64 history = getGlobalHistory();
+
+   SInt32 output = weights[0];
+   for (UInt32 i = 0; i < m_history_length; i++, history >>= 1)
+      output += (history & 1) ? weights[i + 1] : -weights[i + 1];
+   return output;
+}
+
+bool PerceptronBranchPredictor::predictDirection(IntPtr ip)
+{
+   return (getOutput(ip) >= 0);
+}
+
+void PerceptronBranchPredictor::updateDirection(IntPtr ip, bool taken)
+{
+   // Correct, and confident enough
+   SInt32 output = getOutput(ip);
+   if (((output >= 0) == taken) && ((output <= -m_threshold) || (output >= m_threshold)))
+      return;
+
+   SInt8* weights = &m_weights[(ip & (m_num_perceptrons - 1)) * (m_history_length + 1)];
+   UInt64 history = getGlobalHistory();
+
+   for (UInt32 i = 0; i <= m_history_length; i++)
+   {
+      // The bias agrees with the outcome, the weights with the outcome xnor the history
+      bool agree = (i == 0) ? taken : (taken == (bool) ((history >> (i - 1)) & 1));
+      if (agree && (weights[i] < 127))
+         weights[i] ++;
+      else if (!agree && (weights[i] > -128))
+         weights[i] --;
+   }
+}
+
+void PerceptronBranchPredictor::outputSummary(std::ostream &os)
+{
+   TableBranchPredictor::outputSummary(os);
+   os << "    type: perceptron (" << m_num_perceptrons << ", history " << m_history_length << ")" << endl;
+}
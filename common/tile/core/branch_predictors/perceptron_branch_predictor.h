@@ -0,0 +1,31 @@
+#ifndef PERCEPTRON_BRANCH_PREDICTOR_H
+#define PERCEPTRON_BRANCH_PREDICTOR_H
+
+#include <vector>
+
+#include "table_branch_predictor.h"
+
+// Perceptrons (8-bit weights over the global history) indexed by the
+// branch address. Trained on a misprediction or a low-confidence output
+class PerceptronBranchPredictor : public TableBranchPredictor
+{
+public:
+   PerceptronBranchPredictor(UInt32 size, UInt32 history_length, UInt32 btb_size);
+   ~PerceptronBranchPredictor();
+
+   void outputSummary(std::ostream &os);
+
+private:
+   bool predictDirection(IntPtr ip);
+   void updateDirection(IntPtr ip, bool taken);
+
+   SInt32 getOutput(IntPtr ip) const;
+
+   // Perceptron i: bias, then one weight per history bit
+   std::vector<SInt8> m_weights;
+   UInt32 m_num_perceptrons;
+   UInt32 m_history_length;
+   SInt32 m_threshold;
+};
+
+#endif
@@ -0,0 +1,39 @@
+#include "table_branch_predictor.h"
+
+TableBranchPredictor::TableBranchPredictor(UInt32 btb_size)
+   : m_btb(NULL)
+   , m_global_history(0)
+{
+   if (btb_size > 0)
+      m_btb = new BranchTargetBuffer(btb_size);
+}
+
+TableBranchPredictor::~TableBranchPredictor()
+{
+   delete m_btb;
+}
+
+bool TableBranchPredictor::predict(IntPtr ip, IntPtr target)
+{
+   if (!predictDirection(ip))
+      return false;
+   return (m_btb == NULL) || m_btb->lookup(ip, target);
+}
+
+void TableBranchPredictor::update(bool predicted, bool actual, IntPtr ip, IntPtr target)
+{
+   updateCounters(predicted, actual);
+
+   updateDirection(ip, actual);
+   m_global_history = (m_global_history << 1) | (actual ? 1 : 0);
+
+   if (actual && m_btb)
+      m_btb->update(ip, target);
+}
+
+void TableBranchPredictor::outputSummary(std::ostream &os)
+{
+   BranchPredictor::outputSummary(os);
+   if (m_btb)
+      m_btb->outputSummary(os);
+}
@@ -0,0 +1,33 @@
+#ifndef TABLE_BRANCH_PREDICTOR_H
+#define TABLE_BRANCH_PREDICTOR_H
+
+#include "branch_predictor.h"
+#include "branch_target_buffer.h"
+
+// Base of the table-based predictors: they predict the direction of a
+// branch, from its address and the global history (most recent outcome in
+// bit 0), and the BTB (if any) provides the target of the taken branches
+class TableBranchPredictor : public BranchPredictor
+{
+public:
+   TableBranchPredictor(UInt32 btb_size);
+   ~TableBranchPredictor();
+
+   bool predict(IntPtr ip, IntPtr target);
+   void update(bool predicted, bool actual, IntPtr ip, IntPtr target);
+
+   void outputSummary(std::ostream &os);
+
+protected:
+   virtual bool predictDirection(IntPtr ip) = 0;
+   // Called before the outcome is added to the global history
+   virtual void updateDirection(IntPtr ip, bool taken) = 0;
+
+   UInt64 getGlobalHistory() const { return m_global_history; }
+
+private:
+   BranchTargetBuffer* m_btb;
+   UInt64 m_global_history;
+};
+
+#endif
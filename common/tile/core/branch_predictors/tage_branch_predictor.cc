@@ -0,0 +1,134 @@
+#include "tage_branch_predictor.h"
+
+using std::endl;
+
+TAGEBranchPredictor::TAGEBranchPredictor(UInt32 size, UInt32 history_length, UInt32 btb_size)
+   : TableBranchPredictor(btb_size)
+   , m_base_counters(size, 1)
+   , m_num_updates(0)
+{
+   LOG_ASSERT_ERROR(history_length <= 64, "History length(%u) must be <= 64", history_length);
+
+   // The tagged tables together are as big as the base one
+   m_num_tagged_entries = (size / NUM_TAGGED_TABLES > 16) ? (size / NUM_TAGGED_TABLES) : 16;
+   m_index_bits = floorLog2(m_num_tagged_entries);
+
+   for (UInt32 i = 0; i < NUM_TAGGED_TABLES; i++)
+   {
+      m_counters.push_back(CounterTable<3>(m_num_tagged_entries, 3));
+      m_useful_counters.push_back(CounterTable<2>(m_num_tagged_entries, 0));
+      m_tags.push_back(std::vector<UInt16>(m_num_tagged_entries, 0));
+
+      UInt32 length = history_length >> (NUM_TAGGED_TABLES - 1 - i);
+      m_history_lengths[i] = (length > 0) ? length : 1;
+   }
+
+   m_lookup.valid = false;
+}
+
+TAGEBranchPredictor::~TAGEBranchPredictor()
+{
+}
+
+UInt32 TAGEBranchPredictor::foldHistory(UInt32 history_length, UInt32 num_bits) const
+{
+   UInt64 history = getGlobalHistory();
+   if (history_length < 64)
+      history &= (((UInt64) 1 << history_length) - 1);
+
+   UInt64 folded_history = 0;
+   for ( ; history != 0; history >>= num_bits)
+      folded_history ^= history;
+   return (UInt32) (folded_history & ((1 << num_bits) - 1));
+}
+
+void TAGEBranchPredictor::lookup(IntPtr ip)
+{
+   m_lookup.valid = true;
+   m_lookup.ip = ip;
+   m_lookup.provider = -1;
+
+   bool base_prediction = m_base_counters.isSet(ip);
+   m_lookup.provider_prediction = base_prediction;
+   m_lookup.alternate_prediction = base_prediction;
+
+   for (UInt32 i = 0; i < NUM_TAGGED_TABLES; i++)
+   {
+      UInt32 length = m_history_lengths[i];
+      m_lookup.indices[i] = (ip ^ (ip >> m_index_bits) ^ foldHistory(length, m_index_bits)) & (m_num_tagged_entries - 1);
+      m_lookup.tags[i] = (ip ^ foldHistory(length, TAG_BITS) ^ (foldHistory(length, TAG_BITS - 1) << 1)) & ((1 << TAG_BITS) - 1);
+
+      if (m_tags[i][m_lookup.indices[i]] == m_lookup.tags[i])
+      {
+         // Longer histories come later
+         m_lookup.alternate_prediction = m_lookup.provider_prediction;
+         m_lookup.provider_prediction = m_counters[i].isSet(m_lookup.indices[i]);
+         m_lookup.provider = i;
+      }
+   }
+}
+
+bool TAGEBranchPredictor::predictDirection(IntPtr ip)
+{
+   lookup(ip);
+   return m_lookup.provider_prediction;
+}
+
+void TAGEBranchPredictor::updateDirection(IntPtr ip, bool taken)
+{
+   if (!m_lookup.valid || (m_lookup.ip != ip))
+      lookup(ip);
+
+   SInt32 provider = m_lookup.provider;
+   if (provider >= 0)
+   {
+      UInt32 index = m_lookup.indices[provider];
+      if (m_lookup.provider_prediction != m_lookup.alternate_prediction)
+         m_useful_counters[provider].update(index, (m_lookup.provider_prediction == taken));
+      m_counters[provider].update(index, taken);
+   }
+   else
+   {
+      m_base_counters.update(ip, taken);
+   }
+
+   // Mispredicted, try a longer history
+   if ((m_lookup.provider_prediction != taken) && (provider < (SInt32) NUM_TAGGED_TABLES - 1))
+   {
+      bool allocated = false;
+      for (UInt32 i = provider + 1; i < NUM_TAGGED_TABLES; i++)
+      {
+         UInt32 index = m_lookup.indices[i];
+         if (m_useful_counters[i].get(index) == 0)
+         {
+            m_tags[i][index] = m_lookup.tags[i];
+            m_counters[i].set(index, taken ? 4 : 3);
+            allocated = true;
+            break;
+         }
+      }
+      if (!allocated)
+      {
+         for (UInt32 i = provider + 1; i < NUM_TAGGED_TABLES; i++)
+            m_useful_counters[i].update(m_lookup.indices[i], false);
+      }
+   }
+
+   m_num_updates ++;
+   if ((m_num_updates % USEFUL_RESET_PERIOD) == 0)
+   {
+      for (UInt32 i = 0; i < NUM_TAGGED_TABLES; i++)
+         for (UInt32 j = 0; j < m_num_tagged_entries; j++)
+            m_useful_counters[i].set(j, 0);
+   }
+
+   // The global history changes next
+   m_lookup.valid = false;
+}
+
+void TAGEBranchPredictor::outputSummary(std::ostream &os)
+{
+   TableBranchPredictor::outputSummary(os);
+   os << "    type: tage (" << m_base_counters.size() << " + " << NUM_TAGGED_TABLES << "x" << m_num_tagged_entries
+      << ", history " << m_history_lengths[NUM_TAGGED_TABLES - 1] << ")" << endl;
+}
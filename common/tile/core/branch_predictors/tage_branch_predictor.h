@@ -0,0 +1,57 @@
+#ifndef TAGE_BRANCH_PREDICTOR_H
+#define TAGE_BRANCH_PREDICTOR_H
+
+#include <vector>
+
+#include "table_branch_predictor.h"
+#include "counter_table.h"
+
+// TAGE-lite: a bimodal base predictor and a few tagged tables indexed by
+// the branch address and geometrically longer parts of the global history.
+// The hit with the longest history provides the prediction. A misprediction
+// allocates an entry in a table with a longer history
+class TAGEBranchPredictor : public TableBranchPredictor
+{
+public:
+   TAGEBranchPredictor(UInt32 size, UInt32 history_length, UInt32 btb_size);
+   ~TAGEBranchPredictor();
+
+   void outputSummary(std::ostream &os);
+
+private:
+   static const UInt32 NUM_TAGGED_TABLES = 4;
+   static const UInt32 TAG_BITS = 9;
+   // The useful counters are cleared every so many updates
+   static const UInt64 USEFUL_RESET_PERIOD = 256 * 1024;
+
+   struct Lookup
+   {
+      bool valid;
+      IntPtr ip;
+      UInt32 indices[NUM_TAGGED_TABLES];
+      UInt32 tags[NUM_TAGGED_TABLES];
+      SInt32 provider;     // -1: the base predictor
+      bool provider_prediction;
+      bool alternate_prediction;
+   };
+
+   bool predictDirection(IntPtr ip);
+   void updateDirection(IntPtr ip, bool taken);
+
+   void lookup(IntPtr ip);
+   UInt32 foldHistory(UInt32 history_length, UInt32 num_bits) const;
+
+   CounterTable<2> m_base_counters;
+   std::vector<CounterTable<3> > m_counters;
+   std::vector<CounterTable<2> > m_useful_counters;
+   std::vector<std::vector<UInt16> > m_tags;
+
+   UInt32 m_num_tagged_entries;
+   UInt32 m_index_bits;
+   UInt32 m_history_lengths[NUM_TAGGED_TABLES];
+
+   Lookup m_lookup;
+   UInt64 m_num_updates;
+};
+
+#endif
@@ -0,0 +1,46 @@
+#include "tournament_branch_predictor.h"
+
+using std::endl;
+
+TournamentBranchPredictor::TournamentBranchPredictor(UInt32 size, UInt32 history_length, UInt32 btb_size)
+   : TableBranchPredictor(btb_size)
+   , m_bimodal_counters(size, 1)
+   , m_gshare_counters(size, 1)
+   , m_choice_counters(size, 1)
+   , m_history_length(history_length)
+{
+   LOG_ASSERT_ERROR(history_length <= 64, "History length(%u) must be <= 64", history_length);
+   m_history_mask = (history_length == 64) ? ~((UInt64) 0) : (((UInt64) 1 << history_length) - 1);
+}
+
+TournamentBranchPredictor::~TournamentBranchPredictor()
+{
+}
+
+bool TournamentBranchPredictor::predictDirection(IntPtr ip)
+{
+   if (m_choice_counters.isSet(ip))
+      return m_gshare_counters.isSet(getGShareIndex(ip));
+   else
+      return m_bimodal_counters.isSet(ip);
+}
+
+void TournamentBranchPredictor::updateDirection(IntPtr ip, bool taken)
+{
+   UInt32 gshare_index = getGShareIndex(ip);
+   bool bimodal_prediction = m_bimodal_counters.isSet(ip);
+   bool gshare_prediction = m_gshare_counters.isSet(gshare_index);
+
+   // Move towards the one that was right
+   if (bimodal_prediction != gshare_prediction)
+      m_choice_counters.update(ip, (gshare_prediction == taken));
+
+   m_bimodal_counters.update(ip, taken);
+   m_gshare_counters.update(gshare_index, taken);
+}
+
+void TournamentBranchPredictor::outputSummary(std::ostream &os)
+{
+   TableBranchPredictor::outputSummary(os);
+   os << "    type: tournament (" << m_bimodal_counters.size() << ", history " << m_history_length << ")" << endl;
+}
@@ -0,0 +1,32 @@
+#ifndef TOURNAMENT_BRANCH_PREDICTOR_H
+#define TOURNAMENT_BRANCH_PREDICTOR_H
+
+#include "table_branch_predictor.h"
+#include "counter_table.h"
+
+// A bimodal and a gshare predictor, and 2-bit counters (indexed by the
+// branch address) that choose between them
+class TournamentBranchPredictor : public TableBranchPredictor
+{
+public:
+   TournamentBranchPredictor(UInt32 size, UInt32 history_length, UInt32 btb_size);
+   ~TournamentBranchPredictor();
+
+   void outputSummary(std::ostream &os);
+
+private:
+   bool predictDirection(IntPtr ip);
+   void updateDirection(IntPtr ip, bool taken);
+
+   UInt32 getGShareIndex(IntPtr ip) const
+   { return (UInt32) (ip ^ (getGlobalHistory() & m_history_mask)); }
+
+   CounterTable<2> m_bimodal_counters;
+   CounterTable<2> m_gshare_counters;
+   // Set: use the gshare prediction
+   CounterTable<2> m_choice_counters;
+   UInt32 m_history_length;
+   UInt64 m_history_mask;
+};
+
+#endif
@@ -9,16 +9,25 @@
 #include "pin_memory_manager.h"
 #include "clock_skew_minimization_object.h"
 #include "core_model.h"
+#include "idle_state_model.h"
+#include "clock_converter.h"
 #include "simulator.h"
 #include "log.h"
+#include <boost/lexical_cast.hpp>
 
 using namespace std;
 
 Core::Core(Tile *tile, core_type_t core_type)
    : m_tile(tile)
    , m_core_id((core_id_t) {tile->getId(), core_type})
+   , m_mmu(NULL)
+   , m_spin_detector(NULL)
+   , m_idle_state_model(NULL)
    , m_core_state(IDLE)
    , m_pin_memory_manager(NULL)
+   , m_host_stack_begin(0)
+   , m_host_stack_end(0)
+   , m_instruction_address(0)
 {
    m_network = m_tile->getNetwork();
    m_shmem_perf_model = m_tile->getShmemPerfModel();
@@ -32,6 +41,43 @@ Core::Core(Tile *tile, core_type_t core_type)
     
    if (Config::getSingleton()->isSimulatingSharedMemory())
       m_pin_memory_manager = new PinMemoryManager(this);
+
+   initializeHostStack();
+}
+
+void Core::initializeHostStack()
+{
+   bool direct_host_access = false;
+   IntPtr stack_base = 0;
+   UInt32 stack_size_per_core = 0;
+   try
+   {
+      direct_host_access = Sim()->getCfg()->getBool("stack/direct_host_access", false);
+      stack_base = boost::lexical_cast <IntPtr> (Sim()->getCfg()->get("stack/stack_base"));
+      stack_size_per_core = boost::lexical_cast <UInt32> (Sim()->getCfg()->get("stack/stack_size_per_core"));
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Error reading stack parameters from the config file");
+   }
+
+   if (!direct_host_access)
+      return;
+
+   // All the threads that may touch a stack must see the same host memory
+   if ((Config::getSingleton()->getSimulationMode() != Config::FULL) ||
+       (Config::getSingleton()->getProcessCount() > 1) ||
+       !Config::getSingleton()->isSimulatingSharedMemory())
+   {
+      if (m_core_id.tile_id == 0)
+         LOG_PRINT_WARNING("stack/direct_host_access needs full mode with shared memory and one process, disabled");
+      return;
+   }
+
+   // The stacks of all the tiles, as laid out by PinConfig
+   m_host_stack_begin = stack_base;
+   m_host_stack_end = stack_base + ((IntPtr) Config::getSingleton()->getTotalTiles()) *
+                                   Config::getSingleton()->getNumCoresPerTile() * stack_size_per_core;
 }
 
 Core::~Core()
@@ -90,6 +136,29 @@ int Core::coreRecvW(int sender, int receiver, char* buffer, int size, carbon_net
    return (unsigned)size == packet.length ? 0 : -1;
 }
 
+int Core::coreRecvNB(int sender, int receiver, char* buffer, int size, carbon_network_t net_type, bool& received)
+{
+   NetMatch match;
+   if (sender != CAPI_ENDPOINT_ANY)
+      match.senders.push_back((core_id_t) {sender, getCoreType()});
+   match.types.push_back(getPktTypeFromUserNetType(net_type));
+   match.receiver = m_core_id;
+
+   NetPacket packet;
+   received = m_tile->getNetwork()->netTryRecv(match, packet);
+   if (!received)
+      return 0;
+
+   LOG_PRINT("Got packet: from {%i, %i}, to {%i, %i}, type %i, len %i", packet.sender.tile_id, packet.sender.core_type, packet.receiver.tile_id, packet.receiver.core_type, (SInt32)packet.type, packet.length);
+
+   LOG_ASSERT_ERROR((unsigned)size == packet.length, "Tile: User thread requested packet of size: %d, got a packet from %d of size: %d", size, sender, packet.length);
+
+   memcpy(buffer, packet.data, size);
+   delete [](Byte*)packet.data;
+
+   return (unsigned)size == packet.length ? 0 : -1;
+}
+
 PacketType Core::getPktTypeFromUserNetType(carbon_network_t net_type)
 {
    switch(net_type)
@@ -113,6 +182,21 @@ Core::getState()
    return m_core_state;
 }
 
+void
+Core::wakeUp(UInt64 start_time, UInt64 time)
+{
+   if (time <= start_time)
+      return;
+
+   UInt64 wait_time = time - start_time;
+   if (m_idle_state_model)
+      wait_time += m_idle_state_model->wakeUp(wait_time);
+
+   // Global Clock to Core Clock
+   UInt64 cycles_elapsed = convertCycleCount(wait_time, 1.0, m_core_model->getFrequency());
+   m_core_model->queueDynamicInstruction(new SyncInstruction(cycles_elapsed));
+}
+
 void
 Core::setState(State core_state)
 {
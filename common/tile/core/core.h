@@ -12,6 +12,9 @@ class SyscallMdl;
 class SyncClient;
 class ClockSkewMinimizationClient;
 class PinMemoryManager;
+class MMU;
+class SpinDetector;
+class IdleStateModel;
 
 #include "mem_component.h"
 #include "fixed_types.h"
@@ -57,6 +60,8 @@ public:
 
    int coreSendW(int sender, int receiver, char *buffer, int size, carbon_network_t net_type);
    int coreRecvW(int sender, int receiver, char *buffer, int size, carbon_network_t net_type);
+   // Does not wait for the message, 'received' tells whether it had arrived
+   int coreRecvNB(int sender, int receiver, char *buffer, int size, carbon_network_t net_type, bool& received);
    
    virtual UInt64 readInstructionMemory(IntPtr address, UInt32 instruction_size) = 0;
 
@@ -71,6 +76,13 @@ public:
    virtual pair<UInt32, UInt64> accessMemory(lock_signal_t lock_signal, mem_op_t mem_op_type, IntPtr address,
                                              char* data_buffer, UInt32 data_size, bool push_info = false) = 0;
 
+   // Bulk copy or set of [address, address + size) in the L1-D, modeled as a
+   // block transfer: the lines are requested 'max_lines_in_flight' at a time
+   // from 'time' (the cycle count if 0). The data is not moved. Returns the
+   // number of misses and the latency
+   virtual pair<UInt32, UInt64> initiateBlockTransfer(mem_op_t mem_op_type, IntPtr address, UInt64 size,
+                                                      UInt32 max_lines_in_flight, UInt64 time = 0) = 0;
+
    core_id_t getId()                         { return m_core_id; }
    Tile *getTile()                           { return m_tile; }
    tile_id_t getTileId()                     { return m_core_id.tile_id; }
@@ -83,10 +95,31 @@ public:
    Network* getNetwork()                     { return m_network; }
    ShmemPerfModel* getShmemPerfModel()       { return m_shmem_perf_model; }
    MemoryManager *getMemoryManager()         { return m_memory_manager; }
+   // NULL unless mmu/enabled
+   MMU* getMMU()                             { return m_mmu; }
+   // NULL unless core/spin_detection/enabled
+   SpinDetector* getSpinDetector()           { return m_spin_detector; }
+   // NULL unless core/idle_states/enabled
+   IdleStateModel* getIdleStateModel()       { return m_idle_state_model; }
 
    State getState();
    void setState(State core_state);
 
+   // The thread was stalled from 'start_time' until another tile woke it up
+   // at 'time' (in ns): the clock jumps to 'time', plus the wake-up latency
+   // of the idle state of the core
+   void wakeUp(UInt64 start_time, UInt64 time);
+
+   // Full mode with stack/direct_host_access: the data of the thread stacks
+   // stays in host memory, the caches only model the timing of the accesses
+   bool isHostStackAccess(IntPtr address, UInt32 size)
+   { return (address >= m_host_stack_begin) && (address + size <= m_host_stack_end); }
+
+   // Address of the instruction whose memory operands are being accessed,
+   // set by the Pin routines around the access (0 for the other accesses)
+   void setInstructionAddress(IntPtr address) { m_instruction_address = address; }
+   IntPtr getInstructionAddress()            { return m_instruction_address; }
+
 protected:
    Tile *m_tile;
    core_id_t m_core_id;
@@ -97,13 +130,24 @@ protected:
    Network* m_network;
    ShmemPerfModel* m_shmem_perf_model;
    MemoryManager* m_memory_manager;
+   MMU* m_mmu;
+   SpinDetector* m_spin_detector;
+   IdleStateModel* m_idle_state_model;
 
    State m_core_state;
    Lock m_core_state_lock;
 
    PinMemoryManager *m_pin_memory_manager;
+
+   IntPtr m_host_stack_begin;
+   IntPtr m_host_stack_end;
+
+   IntPtr m_instruction_address;
    
    PacketType getPktTypeFromUserNetType(carbon_network_t net_type);
+
+private:
+   void initializeHostStack();
 };
 
 #endif
@@ -1,14 +1,26 @@
+#include <sstream>
+
 #include "tile.h"
 #include "core.h"
 #include "core_model.h"
 #include "simple_core_model.h"
 #include "iocoom_core_model.h"
+#include "ooo_core_model.h"
+#include "interval_core_model.h"
 #include "branch_predictor.h"
+#include "instruction_trace.h"
+#include "memory_stall_profile.h"
+#include "phase_detector.h"
 #include "simulator.h"
+#include "stats_registry.h"
+#include "statistics_manager.h"
+#include "metrics_server.h"
 #include "tile_manager.h"
 #include "config.h"
 #include "fxsupport.h"
 #include "utils.h"
+#include "checkpoint.h"
+#include "log.h"
 
 CoreModel* CoreModel::create(Core* core)
 {
@@ -19,6 +31,10 @@ CoreModel* CoreModel::create(Core* core)
       return new IOCOOMCoreModel(core, frequency);
    else if (core_model == "simple")
       return new SimpleCoreModel(core, frequency);
+   else if (core_model == "ooo")
+      return new OOOCoreModel(core, frequency);
+   else if (core_model == "interval")
+      return new IntervalCoreModel(core, frequency);
    else
    {
       LOG_PRINT_ERROR("Invalid perf model type: %s", core_model.c_str());
@@ -36,23 +52,110 @@ CoreModel::CoreModel(Core *core, float frequency)
    , m_total_time(0)
    , m_checkpointed_cycle_count(0)
    , m_enabled(false)
+   , m_dynamic_info_ring(NULL)
    , m_current_ins_index(0)
+   , m_timing_thread_enabled(false)
+   , m_timing_ring_size(0)
+   , m_timing_ring(NULL)
+   , m_timing_thread(NULL)
+   , m_timing_thread_exit(false)
+   , m_timing_thread_done(false)
+   , m_num_timing_records_pushed(0)
+   , m_num_timing_records_processed(0)
+   , m_timing_thread_sleeping(false)
+   , m_num_timing_waiters(0)
    , m_bp(0)
+   , m_trace_writer(NULL)
+   , m_stall_profile(NULL)
+   , m_phase_detector(NULL)
 {
+   UInt32 dynamic_info_ring_size = 0;
+   bool record_trace = false;
+   bool stall_profile = false;
+   bool phase_detection = false;
+   try
+   {
+      dynamic_info_ring_size = Sim()->getCfg()->getInt("core/dynamic_info_ring_size", 8192);
+      m_timing_thread_enabled = Sim()->getCfg()->getBool("core/timing_thread/enabled", false);
+      m_timing_ring_size = Sim()->getCfg()->getInt("core/timing_thread/ring_size", 4096);
+      record_trace = Sim()->getCfg()->getBool("trace_record/enabled", false);
+      stall_profile = Sim()->getCfg()->getBool("core/stall_profile", false);
+      phase_detection = Sim()->getCfg()->getBool("core/phase_detection/enabled", false);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read [core/timing_thread] parameters from the cfg file");
+   }
+
+   m_dynamic_info_ring = new SPSCRing<DynamicInstructionInfo>(dynamic_info_ring_size);
+
    // Create Branch Predictor
    m_bp = BranchPredictor::create();
 
    // Initialize Pipeline Stall Counters
    initializePipelineStallCounters();
+
+   // Only the application tiles run (recorded) threads
+   tile_id_t tile_id = m_core->getTile()->getId();
+
+   // IPC of the statistics trace
+   if (Sim()->getStatisticsManager())
+   {
+      Sim()->getStatisticsManager()->registerCounter(tile_id, StatisticsManager::INSTRUCTIONS, &m_instruction_count);
+      Sim()->getStatisticsManager()->registerCounter(tile_id, StatisticsManager::CYCLES, &m_cycle_count);
+      Sim()->getStatisticsManager()->registerFrequency(tile_id, &m_frequency);
+      for (UInt32 i = 0; i < CpiStack::NUM_COMPONENTS; i++)
+      {
+         Sim()->getStatisticsManager()->registerCounter(tile_id, (StatisticsManager::Counter) (StatisticsManager::CPI_STACK_CYCLES + i),
+                                                        &m_cpi_stack[i]);
+      }
+   }
+
+   // Simulated time and instructions of the live metrics
+   if (Sim()->getMetricsServer())
+      Sim()->getMetricsServer()->registerCore(tile_id, &m_cycle_count, &m_instruction_count, &m_frequency);
+
+   StatsRegistry* stats = Sim()->getStatsRegistry();
+   if (stats)
+   {
+      stats->registerCounter(tile_id, "Core Model/Total Instructions", &m_instruction_count);
+      stats->registerCounter(tile_id, "Core Model/Total Cycles", &m_cycle_count);
+      stats->registerCounter(tile_id, "Core Model/Total Recv Instructions", &m_total_recv_instructions);
+      stats->registerCounter(tile_id, "Core Model/Total Sync Instructions", &m_total_sync_instructions);
+      stats->registerCounter(tile_id, "Core Model/Total Memory Stall Cycles", &m_total_memory_stall_cycles);
+      stats->registerCounter(tile_id, "Core Model/Total Execution Unit Stall Cycles", &m_total_execution_unit_stall_cycles);
+      stats->registerCounter(tile_id, "Core Model/Total Recv Instruction Stall Cycles", &m_total_recv_instruction_stall_cycles);
+      stats->registerCounter(tile_id, "Core Model/Total Sync Instruction Stall Cycles", &m_total_sync_instruction_stall_cycles);
+      for (UInt32 i = 0; i < CpiStack::NUM_COMPONENTS; i++)
+         stats->registerCounter(tile_id, string("Core Model/CPI Stack/") + CpiStack::getName(i), &m_cpi_stack[i]);
+   }
+   if (record_trace && (tile_id < (tile_id_t) Config::getSingleton()->getApplicationTiles()))
+   {
+      string filename = Config::getSingleton()->formatOutputFileName(InstructionTrace::getFileName(".", tile_id));
+      m_trace_writer = new InstructionTraceWriter(filename, tile_id);
+   }
+   if (stall_profile && (tile_id < (tile_id_t) Config::getSingleton()->getApplicationTiles()))
+      m_stall_profile = new MemoryStallProfile();
+   if (phase_detection && (tile_id < (tile_id_t) Config::getSingleton()->getApplicationTiles()))
+      m_phase_detector = new PhaseDetector(tile_id, &m_instruction_count, &m_cycle_count, m_cpi_stack);
 }
 
 CoreModel::~CoreModel()
 {
+   stopTimingThread();
+   delete m_dynamic_info_ring;
    delete m_bp; m_bp = 0;
+   delete m_trace_writer;
+   delete m_stall_profile;
+   delete m_phase_detector;
 }
 
 void CoreModel::outputSummary(ostream& os)
 {
+   // The app threads are done, model what they left in the ring
+   if (m_timing_thread_enabled)
+      waitForTimingThread(true);
+
    os << "Core Model Summary:" << endl;
    os << "    Total Instructions: " << m_instruction_count << endl;
    os << "    Completion Time (in ns): " << (UInt64) ((double) m_cycle_count / m_frequency) << endl;
@@ -65,9 +168,69 @@ void CoreModel::outputSummary(ostream& os)
    os << "    Total Recv Instruction Stall Time (in ns): " << (UInt64) ((double) m_total_recv_instruction_stall_cycles / m_frequency) << endl;
    os << "    Total Sync Instruction Stall Time (in ns): " << (UInt64) ((double) m_total_sync_instruction_stall_cycles / m_frequency) << endl;
 
+   // Cycles per instruction of each component
+   double num_instructions = (m_instruction_count > 0) ? (double) m_instruction_count : 1.0;
+   os << "    CPI Stack:" << endl;
+   for (UInt32 i = 0; i < CpiStack::NUM_COMPONENTS; i++)
+      os << "      " << CpiStack::getName(i) << ": " << (double) m_cpi_stack[i] / num_instructions << endl;
+
    // Branch Predictor Summary
    if (m_bp)
+   {
       m_bp->outputSummary(os);
+      float mpki = (m_instruction_count > 0) ? (1000.0 * m_bp->getNumIncorrectPredictions() / m_instruction_count) : 0.0;
+      os << "    mispredictions per 1000 instructions: " << mpki << endl;
+   }
+
+   if (m_stall_profile)
+   {
+      ostringstream filename;
+      filename << "stall_profile." << m_core->getTile()->getId() << ".dat";
+      m_stall_profile->write(Config::getSingleton()->formatOutputFileName(filename.str()));
+      os << "    Stall Profile Addresses: " << m_stall_profile->getNumAddresses() << endl;
+   }
+
+   if (m_phase_detector)
+   {
+      m_phase_detector->outputSummary(os);
+      m_phase_detector->write("phases");
+   }
+}
+
+void CoreModel::saveState(CheckpointWriter& writer)
+{
+   // What the timing thread has not modeled yet would be lost
+   if (m_timing_thread_enabled)
+      waitForTimingThread(true);
+
+   writer.beginSection("Core Model");
+   writer << m_cycle_count << m_instruction_count << (double) m_average_frequency << m_total_time
+          << m_checkpointed_cycle_count;
+   writer << m_total_recv_instructions << m_total_sync_instructions
+          << m_total_recv_instruction_stall_cycles << m_total_sync_instruction_stall_cycles
+          << m_total_memory_stall_cycles << m_total_execution_unit_stall_cycles;
+   for (UInt32 i = 0; i < CpiStack::NUM_COMPONENTS; i++)
+      writer << m_cpi_stack[i];
+   writer << m_cpi_stack_cycle_count << m_cpi_stack_mispredictions;
+   if (m_bp)
+      m_bp->saveState(writer);
+}
+
+void CoreModel::restoreState(CheckpointReader& reader)
+{
+   reader.beginSection("Core Model");
+   double average_frequency;
+   reader >> m_cycle_count >> m_instruction_count >> average_frequency >> m_total_time
+          >> m_checkpointed_cycle_count;
+   m_average_frequency = average_frequency;
+   reader >> m_total_recv_instructions >> m_total_sync_instructions
+          >> m_total_recv_instruction_stall_cycles >> m_total_sync_instruction_stall_cycles
+          >> m_total_memory_stall_cycles >> m_total_execution_unit_stall_cycles;
+   for (UInt32 i = 0; i < CpiStack::NUM_COMPONENTS; i++)
+      reader >> m_cpi_stack[i];
+   reader >> m_cpi_stack_cycle_count >> m_cpi_stack_mispredictions;
+   if (m_bp)
+      m_bp->restoreState(reader);
 }
 
 void CoreModel::enable()
@@ -77,6 +240,11 @@ void CoreModel::enable()
    if (m_core->getTile()->getId() >= (tile_id_t) Config::getSingleton()->getApplicationTiles())
       return;
 
+   // The timing thread registers itself with the tile manager, so it is
+   // started once the simulator is up
+   if (m_timing_thread_enabled && !m_timing_thread)
+      startTimingThread();
+
    m_enabled = true;
    LOG_PRINT("enable() end");
 }
@@ -90,6 +258,7 @@ void CoreModel::disable()
 // 1) Whenever frequency is changed
 void CoreModel::updateInternalVariablesOnFrequencyChange(volatile float frequency)
 {
+   synchronize();
    recomputeAverageFrequency();
    
    volatile float old_frequency = m_frequency;
@@ -104,6 +273,9 @@ void CoreModel::updateInternalVariablesOnFrequencyChange(volatile float frequenc
    m_total_execution_unit_stall_cycles = (UInt64) (((double) m_total_execution_unit_stall_cycles / old_frequency) * new_frequency);
    m_total_recv_instruction_stall_cycles = (UInt64) (((double) m_total_recv_instruction_stall_cycles / old_frequency) * new_frequency);
    m_total_sync_instruction_stall_cycles = (UInt64) (((double) m_total_sync_instruction_stall_cycles / old_frequency) * new_frequency);
+   for (UInt32 i = 0; i < CpiStack::NUM_COMPONENTS; i++)
+      m_cpi_stack[i] = (UInt64) (((double) m_cpi_stack[i] / old_frequency) * new_frequency);
+   m_cpi_stack_cycle_count = (UInt64) (((double) m_cpi_stack_cycle_count / old_frequency) * new_frequency);
 }
 
 // This function is called:
@@ -112,6 +284,8 @@ void CoreModel::setCycleCount(UInt64 cycle_count)
 {
    m_checkpointed_cycle_count = cycle_count;
    m_cycle_count = cycle_count;
+   // The time skipped is not charged to the CPI stack
+   m_cpi_stack_cycle_count = cycle_count;
 }
 
 // This function is called:
@@ -119,6 +293,7 @@ void CoreModel::setCycleCount(UInt64 cycle_count)
 // 2) Whenever frequency is changed
 void CoreModel::recomputeAverageFrequency()
 {
+   synchronize();
    volatile double cycles_elapsed = (double) (m_cycle_count - m_checkpointed_cycle_count);
    volatile double total_cycles_executed = (m_average_frequency * m_total_time) + cycles_elapsed;
    volatile double total_time_taken = m_total_time + (cycles_elapsed / m_frequency);
@@ -135,20 +310,32 @@ void CoreModel::initializePipelineStallCounters()
    m_total_sync_instruction_stall_cycles = 0;
    m_total_memory_stall_cycles = 0;
    m_total_execution_unit_stall_cycles = 0;
+
+   for (UInt32 i = 0; i < CpiStack::NUM_COMPONENTS; i++)
+      m_cpi_stack[i] = 0;
+   m_cpi_stack_cycle_count = 0;
+   m_cpi_stack_mispredictions = 0;
+   m_pending_memory_component = CpiStack::BASE;
+   m_memory_component = CpiStack::L1_DCACHE;
 }
 
-void CoreModel::updatePipelineStallCounters(Instruction* i, UInt64 memory_stall_cycles, UInt64 execution_unit_stall_cycles)
+void CoreModel::updatePipelineStallCounters(Instruction* i, UInt64 memory_stall_cycles, UInt64 execution_unit_stall_cycles,
+                                            UInt64 icache_stall_cycles)
 {
+   UInt64 recv_cycles = 0;
+   UInt64 sync_cycles = 0;
    switch (i->getType())
    {
       case INST_RECV:
+         recv_cycles = i->getCost();
          m_total_recv_instructions ++;
-         m_total_recv_instruction_stall_cycles += i->getCost();
+         m_total_recv_instruction_stall_cycles += recv_cycles;
          break;
 
       case INST_SYNC:
+         sync_cycles = i->getCost();
          m_total_sync_instructions ++;
-         m_total_sync_instruction_stall_cycles += i->getCost();
+         m_total_sync_instruction_stall_cycles += sync_cycles;
          break;
 
       default:
@@ -157,6 +344,56 @@ void CoreModel::updatePipelineStallCounters(Instruction* i, UInt64 memory_stall_
    
    m_total_memory_stall_cycles += memory_stall_cycles;
    m_total_execution_unit_stall_cycles += execution_unit_stall_cycles;
+   updateCpiStack(recv_cycles, sync_cycles, icache_stall_cycles, memory_stall_cycles);
+   updateMemoryStallProfile(i->getAddress(), memory_stall_cycles);
+}
+
+void CoreModel::updatePipelineStallCounters(UInt64 memory_stall_cycles, UInt64 execution_unit_stall_cycles,
+                                            UInt64 icache_stall_cycles)
+{
+   m_total_memory_stall_cycles += memory_stall_cycles;
+   m_total_execution_unit_stall_cycles += execution_unit_stall_cycles;
+   updateCpiStack(0, 0, icache_stall_cycles, memory_stall_cycles);
+}
+
+void CoreModel::updateCpiStack(UInt64 recv_cycles, UInt64 sync_cycles, UInt64 icache_stall_cycles, UInt64 memory_stall_cycles)
+{
+   // The cycles since the last update (the stalls of the models may overlap
+   // them), the stalls are charged first and the rest is base
+   UInt64 remaining_cycles = (m_cycle_count > m_cpi_stack_cycle_count) ? (m_cycle_count - m_cpi_stack_cycle_count) : 0;
+   m_cpi_stack_cycle_count = m_cycle_count;
+
+   chargeCpiStack(CpiStack::RECV, recv_cycles, remaining_cycles);
+   chargeCpiStack(CpiStack::SYNC, sync_cycles, remaining_cycles);
+   chargeCpiStack(CpiStack::L1_ICACHE, icache_stall_cycles, remaining_cycles);
+
+   // A correct prediction costs one cycle, a misprediction the penalty
+   if (m_bp)
+   {
+      UInt64 mispredictions = m_bp->getNumIncorrectPredictions();
+      UInt64 penalty = m_bp->getMispredictPenalty();
+      if ((mispredictions > m_cpi_stack_mispredictions) && (penalty > 1))
+         chargeCpiStack(CpiStack::BRANCH, (mispredictions - m_cpi_stack_mispredictions) * (penalty - 1), remaining_cycles);
+      m_cpi_stack_mispredictions = mispredictions;
+   }
+
+   // The data stalls of an instruction without memory accesses (e.g. waiting
+   // for the register of a load) go to the level of the last one
+   if (m_pending_memory_component != CpiStack::BASE)
+   {
+      m_memory_component = m_pending_memory_component;
+      m_pending_memory_component = CpiStack::BASE;
+   }
+   if (memory_stall_cycles > icache_stall_cycles)
+      chargeCpiStack(m_memory_component, memory_stall_cycles - icache_stall_cycles, remaining_cycles);
+
+   m_cpi_stack[CpiStack::BASE] += remaining_cycles;
+}
+
+void CoreModel::updateMemoryStallProfile(IntPtr address, UInt64 memory_stall_cycles)
+{
+   if (m_stall_profile)
+      m_stall_profile->update(address, memory_stall_cycles);
 }
 
 void CoreModel::queueDynamicInstruction(Instruction *i)
@@ -169,6 +406,16 @@ void CoreModel::queueDynamicInstruction(Instruction *i)
 
    BasicBlock *bb = new BasicBlock(true);
    bb->push_back(i);
+
+   if (m_timing_thread_enabled)
+   {
+      TimingRecord record;
+      record.type = TimingRecord::DYNAMIC_INSTRUCTION;
+      record.basic_block = bb;
+      pushTimingRecord(record);
+      return;
+   }
+
    ScopedLock sl(m_basic_block_queue_lock);
    m_basic_block_queue.push(bb);
 }
@@ -178,11 +425,32 @@ void CoreModel::queueBasicBlock(BasicBlock *basic_block)
    if (!m_enabled || !Config::getSingleton()->getEnablePerformanceModeling())
       return;
 
+   if (m_trace_writer)
+      m_trace_writer->writeBasicBlock(basic_block);
+
+   if (m_timing_thread_enabled)
+   {
+      TimingRecord record;
+      record.type = TimingRecord::BASIC_BLOCK;
+      record.basic_block = basic_block;
+      pushTimingRecord(record);
+      return;
+   }
+
    ScopedLock sl(m_basic_block_queue_lock);
    m_basic_block_queue.push(basic_block);
 }
 
 void CoreModel::iterate()
+{
+   // The timing thread models the basic blocks as they come
+   if (m_timing_thread_enabled)
+      return;
+
+   processBasicBlockQueue();
+}
+
+void CoreModel::processBasicBlockQueue()
 {
    // Because we will sometimes not have info available (we will throw
    // a DynamicInstructionInfoNotAvailable), we need to be able to
@@ -199,6 +467,9 @@ void CoreModel::iterate()
 
       try
       {
+         if ((m_current_ins_index == 0) && handleBasicBlockSummary(current_bb))
+            m_current_ins_index = current_bb->size();
+
          for( ; m_current_ins_index < current_bb->size(); m_current_ins_index++)
          {
             try
@@ -211,6 +482,9 @@ void CoreModel::iterate()
             }
          }
 
+         if (m_phase_detector)
+            m_phase_detector->addBasicBlock(current_bb);
+
          if (current_bb->isDynamic())
             delete current_bb;
 
@@ -231,8 +505,30 @@ void CoreModel::pushDynamicInstructionInfo(DynamicInstructionInfo &i)
       return;
 
    LOG_PRINT("Push Info(%u)", i.type);
-   ScopedLock sl(m_dynamic_info_queue_lock);
-   m_dynamic_info_queue.push(i);
+
+   // The memory accesses are recorded with their size by the core
+   if (m_trace_writer)
+   {
+      if (i.type == DynamicInstructionInfo::BRANCH)
+         m_trace_writer->writeBranch(i.branch_info.taken, i.branch_info.target);
+      else if (i.type == DynamicInstructionInfo::STRING)
+         m_trace_writer->writeString(i.string_info.num_ops);
+   }
+
+   if (m_timing_thread_enabled)
+   {
+      TimingRecord record;
+      record.type = TimingRecord::DYNAMIC_INSTRUCTION_INFO;
+      record.basic_block = NULL;
+      record.info = i;
+      pushTimingRecord(record);
+      return;
+   }
+
+   // The info of the instructions of at most a few basic blocks is pending
+   // (until the next one starts), a full ring means it is never consumed
+   if (!m_dynamic_info_ring->tryPush(i))
+      LOG_PRINT_ERROR("Dynamic info queue is growing too big.");
 }
 
 void CoreModel::popDynamicInstructionInfo()
@@ -240,35 +536,200 @@ void CoreModel::popDynamicInstructionInfo()
    if (!m_enabled || !Config::getSingleton()->getEnablePerformanceModeling())
       return;
 
-   ScopedLock sl(m_dynamic_info_queue_lock);
-   LOG_ASSERT_ERROR(m_dynamic_info_queue.size() > 0,
-                    "Expected some dynamic info to be available.");
-   LOG_ASSERT_ERROR(m_dynamic_info_queue.size() < 5000,
-                    "Dynamic info queue is growing too big.");
-   LOG_PRINT("Pop Info(%u)", m_dynamic_info_queue.front().type);
-   m_dynamic_info_queue.pop();
+   DynamicInstructionInfo* info = m_dynamic_info_ring->front();
+   LOG_ASSERT_ERROR(info, "Expected some dynamic info to be available.");
+   LOG_PRINT("Pop Info(%u)", info->type);
+   if ((info->type == DynamicInstructionInfo::MEMORY_READ) || (info->type == DynamicInstructionInfo::MEMORY_WRITE))
+   {
+      CpiStack::Component memory_component = CpiStack::getMemoryComponent(*info);
+      if (memory_component > m_pending_memory_component)
+         m_pending_memory_component = memory_component;
+      if (m_stall_profile)
+         m_stall_profile->addMemoryInfo(*info);
+   }
+   m_dynamic_info_ring->pop();
 }
 
 DynamicInstructionInfo& CoreModel::getDynamicInstructionInfo()
 {
-   ScopedLock sl(m_dynamic_info_queue_lock);
-
    // Information is needed to model the instruction, but isn't
    // available. This is handled in iterate() by returning early and
    // continuing from that instruction later.
 
    // FIXME: Note this assumes that either none of the info for an
    // instruction is available or all of it! This works for
-   // performance modeling in the same thread as functional modeling,
-   // but it WILL NOT work if performance modeling is moved to a
-   // separate thread!
+   // performance modeling in the same thread as functional modeling.
+   // The timing thread keeps it true by modeling the queue only when
+   // the next basic block starts, like the app thread does.
 
-   if (m_dynamic_info_queue.empty())
+   DynamicInstructionInfo* info = m_dynamic_info_ring->front();
+   if (!info)
       throw DynamicInstructionInfoNotAvailableException();
 
-   LOG_ASSERT_ERROR(m_dynamic_info_queue.size() < 5000,
-                    "Dynamic info queue is growing too big.");
+   LOG_PRINT("Get Info(%u)", info->type);
+   return *info;
+}
+
+// Timing Thread
+
+void CoreModel::timingThreadFunc(void* vp)
+{
+   CoreModel* core_model = (CoreModel*) vp;
+
+   // The instructions look up their core model through the current tile
+   Sim()->getTileManager()->registerTimingThread(core_model->m_core->getTile()->getId());
+   LOG_PRINT("Timing thread starting...");
+
+   while (true)
+   {
+      TimingRecord record;
+      if (core_model->m_timing_ring->tryPop(record))
+      {
+         core_model->processTimingRecord(record);
+         // Make the modeling visible before the record counts as processed
+         __sync_synchronize();
+         core_model->m_num_timing_records_processed ++;
+         core_model->wakeTimingWaiters();
+      }
+      else
+      {
+         // Sleep until a record is pushed. The flag is set before the ring is
+         // checked again, and pushTimingRecord() checks it after publishing
+         // the record, so one of the two sees the other
+         core_model->m_timing_lock.acquire();
+         core_model->m_timing_thread_sleeping = true;
+         __sync_synchronize();
+         while (core_model->m_timing_ring->empty() && !core_model->m_timing_thread_exit)
+            core_model->m_timing_record_cond.wait(core_model->m_timing_lock);
+         core_model->m_timing_thread_sleeping = false;
+         // Woken up with an empty ring only to exit
+         bool done = core_model->m_timing_ring->empty();
+         core_model->m_timing_lock.release();
+
+         if (done)
+            break;
+      }
+   }
+
+   LOG_PRINT("Timing thread exiting");
+   core_model->m_timing_lock.acquire();
+   core_model->m_timing_thread_done = true;
+   core_model->m_timing_progress_cond.broadcast();
+   core_model->m_timing_lock.release();
+}
+
+void CoreModel::startTimingThread()
+{
+   m_timing_ring = new SPSCRing<TimingRecord>(m_timing_ring_size);
+   m_timing_thread = Thread::create(timingThreadFunc, this);
+   m_timing_thread->run();
+}
+
+void CoreModel::stopTimingThread()
+{
+   if (!m_timing_thread)
+      return;
+
+   m_timing_lock.acquire();
+   m_timing_thread_exit = true;
+   m_timing_record_cond.signal();
+   while (!m_timing_thread_done)
+      m_timing_progress_cond.wait(m_timing_lock);
+   m_timing_lock.release();
+
+   delete m_timing_thread;
+   m_timing_thread = NULL;
+   delete m_timing_ring;
+   m_timing_ring = NULL;
+}
+
+void CoreModel::pushTimingRecord(const TimingRecord& record)
+{
+   LOG_ASSERT_ERROR(m_timing_ring, "Timing thread not started");
+
+   if (!m_timing_ring->tryPush(record))
+   {
+      // Sleep until the timing thread frees a slot
+      m_timing_lock.acquire();
+      m_num_timing_waiters ++;
+      __sync_synchronize();
+      while (!m_timing_ring->tryPush(record))
+         m_timing_progress_cond.wait(m_timing_lock);
+      m_num_timing_waiters --;
+      m_timing_lock.release();
+   }
+   m_num_timing_records_pushed ++;
+
+   __sync_synchronize();
+   if (m_timing_thread_sleeping)
+   {
+      m_timing_lock.acquire();
+      m_timing_record_cond.signal();
+      m_timing_lock.release();
+   }
+}
 
-   LOG_PRINT("Get Info(%u)", m_dynamic_info_queue.front().type);
-   return m_dynamic_info_queue.front();
+void CoreModel::wakeTimingWaiters()
+{
+   __sync_synchronize();
+   if (m_num_timing_waiters > 0)
+   {
+      m_timing_lock.acquire();
+      m_timing_progress_cond.broadcast();
+      m_timing_lock.release();
+   }
+}
+
+void CoreModel::processTimingRecord(const TimingRecord& record)
+{
+   switch (record.type)
+   {
+   case TimingRecord::BASIC_BLOCK:
+      {
+         ScopedLock sl(m_basic_block_queue_lock);
+         m_basic_block_queue.push(record.basic_block);
+      }
+      processBasicBlockQueue();
+      break;
+
+   case TimingRecord::DYNAMIC_INSTRUCTION:
+      {
+         ScopedLock sl(m_basic_block_queue_lock);
+         m_basic_block_queue.push(record.basic_block);
+      }
+      break;
+
+   case TimingRecord::DYNAMIC_INSTRUCTION_INFO:
+      if (!m_dynamic_info_ring->tryPush(record.info))
+         LOG_PRINT_ERROR("Dynamic info queue is growing too big.");
+      break;
+
+   default:
+      LOG_PRINT_ERROR("Unrecognized timing record type(%u)", record.type);
+      break;
+   }
+}
+
+void CoreModel::waitForTimingThread(bool any_thread)
+{
+   // Only the app thread of the core pushes records, the timing thread
+   // itself and the other threads read whatever time has been modeled
+   if (!m_timing_thread)
+      return;
+   if (!any_thread &&
+       (!Sim()->getTileManager()->amiAppThread() || (Sim()->getTileManager()->getCurrentCore() != m_core)))
+      return;
+
+   if (m_num_timing_records_processed != m_num_timing_records_pushed)
+   {
+      // Sleep until the timing thread has processed the records pushed so far
+      m_timing_lock.acquire();
+      m_num_timing_waiters ++;
+      __sync_synchronize();
+      while (m_num_timing_records_processed != m_num_timing_records_pushed)
+         m_timing_progress_cond.wait(m_timing_lock);
+      m_num_timing_waiters --;
+      m_timing_lock.release();
+   }
+   __sync_synchronize();
 }
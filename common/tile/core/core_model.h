@@ -9,12 +9,21 @@
 // Forward Decls
 class Core;
 class BranchPredictor;
+class InstructionTraceWriter;
+class CheckpointWriter;
+class CheckpointReader;
+class MemoryStallProfile;
+class PhaseDetector;
 
 #include "instruction.h"
 #include "basic_block.h"
 #include "fixed_types.h"
 #include "lock.h"
+#include "cond.h"
+#include "thread.h"
+#include "spsc_ring.h"
 #include "dynamic_instruction_info.h"
+#include "cpi_stack.h"
 
 class CoreModel
 {
@@ -31,8 +40,10 @@ public:
    virtual void updateInternalVariablesOnFrequencyChange(volatile float frequency);
    void recomputeAverageFrequency(); 
 
-   UInt64 getCycleCount() { return m_cycle_count; }
+   UInt64 getCycleCount() { synchronize(); return m_cycle_count; }
    void setCycleCount(UInt64 cycle_count);
+   UInt64 getInstructionCount() { return m_instruction_count; }
+   UInt64 getMemoryStallCycles() { return m_total_memory_stall_cycles; }
 
    void pushDynamicInstructionInfo(DynamicInstructionInfo &i);
    void popDynamicInstructionInfo();
@@ -41,6 +52,10 @@ public:
    static CoreModel *create(Core* core);
 
    BranchPredictor *getBranchPredictor() { return m_bp; }
+   // NULL unless the instruction stream is recorded (trace_record/enabled)
+   InstructionTraceWriter *getTraceWriter() { return m_trace_writer; }
+   // Memory stalls by instruction address (core/stall_profile)
+   bool isStallProfileEnabled() { return m_stall_profile != NULL; }
 
    void enable();
    void disable();
@@ -48,6 +63,23 @@ public:
 
    virtual void outputSummary(std::ostream &os) = 0;
 
+   // The clock and the counters of the core in the checkpoint of the tile,
+   // the models add the counters of their summary. The pipeline state and
+   // the branch predictor tables are not saved
+   virtual void saveState(CheckpointWriter& writer);
+   virtual void restoreState(CheckpointReader& reader);
+
+   // With a timing thread (core/timing_thread/enabled), the app thread only
+   // queues the basic blocks and the dynamic info, and the timing thread
+   // models them. The app thread waits for the timing thread to catch up
+   // before it reads the cycle count or accesses memory, so the instructions
+   // see the same times as when they are modeled inline
+   void synchronize()
+   {
+      if (m_timing_thread_enabled)
+         waitForTimingThread(false);
+   }
+
    class AbortInstructionException { };
 
 
@@ -78,16 +110,70 @@ protected:
    
    volatile float m_frequency;
 
-   void updatePipelineStallCounters(Instruction* i, UInt64 memory_stall_cycles, UInt64 execution_unit_stall_cycles);
+   // 'icache_stall_cycles' are the memory stall cycles spent fetching the
+   // instructions from the L1-I cache (the rest are data accesses)
+   void updatePipelineStallCounters(Instruction* i, UInt64 memory_stall_cycles, UInt64 execution_unit_stall_cycles,
+                                    UInt64 icache_stall_cycles = 0);
+   void updatePipelineStallCounters(UInt64 memory_stall_cycles, UInt64 execution_unit_stall_cycles,
+                                    UInt64 icache_stall_cycles = 0);
+   // For the models that charge the instructions without an Instruction
+   // (summarized basic blocks: the address of the block)
+   void updateMemoryStallProfile(IntPtr address, UInt64 memory_stall_cycles);
+
+   UInt64 getNumDynamicInstructionInfos() { return m_dynamic_info_ring->size(); }
+
+   // The basic block being modeled and the index in it of the instruction
+   // given to handleInstruction() (NULL outside of it)
+   BasicBlock* getCurrentBasicBlock(UInt32& ins_index)
+   {
+      ins_index = m_current_ins_index;
+      return m_basic_block_queue.empty() ? NULL : m_basic_block_queue.front();
+   }
 
 private:
 
    class DynamicInstructionInfoNotAvailableException { };
 
+   struct TimingRecord
+   {
+      enum Type
+      {
+         BASIC_BLOCK = 0,        // queued, then the queue is modeled (iterate())
+         DYNAMIC_INSTRUCTION,    // queued only
+         DYNAMIC_INSTRUCTION_INFO
+      } type;
+      BasicBlock* basic_block;
+      DynamicInstructionInfo info;
+   };
+
    virtual void handleInstruction(Instruction *instruction) = 0;
+   // Models all the instructions of a summarized basic block at once,
+   // returns false to have them modeled one at a time instead
+   virtual bool handleBasicBlockSummary(BasicBlock *basic_block) { return false; }
+
+   void processBasicBlockQueue();
+
+   // Timing Thread
+   static void timingThreadFunc(void* vp);
+   void startTimingThread();
+   void stopTimingThread();
+   void pushTimingRecord(const TimingRecord& record);
+   void wakeTimingWaiters();
+   void processTimingRecord(const TimingRecord& record);
+   // 'any_thread' also waits when called from another thread than the app
+   // thread of the core
+   void waitForTimingThread(bool any_thread);
 
    // Pipeline Stall Counters
    void initializePipelineStallCounters();
+   // Charges the cycles since the last update to the CPI stack
+   void updateCpiStack(UInt64 recv_cycles, UInt64 sync_cycles, UInt64 icache_stall_cycles, UInt64 memory_stall_cycles);
+   void chargeCpiStack(CpiStack::Component component, UInt64 cycles, UInt64& remaining_cycles)
+   {
+      UInt64 charged = (cycles < remaining_cycles) ? cycles : remaining_cycles;
+      m_cpi_stack[component] += charged;
+      remaining_cycles -= charged;
+   }
 
    Core* m_core;
 
@@ -100,12 +186,36 @@ private:
    BasicBlockQueue m_basic_block_queue;
    Lock m_basic_block_queue_lock;
 
-   DynamicInstructionInfoQueue m_dynamic_info_queue;
-   Lock m_dynamic_info_queue_lock;
+   // Pushed by the thread that runs the functional model, popped by the one
+   // that models the instructions (the same one unless there is a timing thread)
+   SPSCRing<DynamicInstructionInfo>* m_dynamic_info_ring;
 
    UInt32 m_current_ins_index;
 
+   // Timing Thread
+   bool m_timing_thread_enabled;
+   UInt32 m_timing_ring_size;
+   SPSCRing<TimingRecord>* m_timing_ring;
+   Thread* m_timing_thread;
+   volatile bool m_timing_thread_exit;
+   volatile bool m_timing_thread_done;
+   // Written by the app thread and the timing thread respectively
+   volatile UInt64 m_num_timing_records_pushed;
+   volatile UInt64 m_num_timing_records_processed;
+   // The ring is lock-free, the lock is only taken to sleep and to wake up.
+   // The timing thread sleeps on the record cond while the ring is empty,
+   // the threads waiting for free slots or for the records to be processed
+   // sleep on the progress cond
+   Lock m_timing_lock;
+   ConditionVariable m_timing_record_cond;
+   ConditionVariable m_timing_progress_cond;
+   volatile bool m_timing_thread_sleeping;
+   volatile UInt32 m_num_timing_waiters;
+
    BranchPredictor *m_bp;
+   InstructionTraceWriter *m_trace_writer;
+   MemoryStallProfile *m_stall_profile;
+   PhaseDetector *m_phase_detector;
 
    // Pipeline Stall Counters
    UInt64 m_total_recv_instructions;
@@ -114,6 +224,16 @@ private:
    UInt64 m_total_sync_instruction_stall_cycles;
    UInt64 m_total_memory_stall_cycles;
    UInt64 m_total_execution_unit_stall_cycles;
+
+   // CPI Stack (in cycles)
+   UInt64 m_cpi_stack[CpiStack::NUM_COMPONENTS];
+   // Cycle count and branch mispredictions at the last update
+   UInt64 m_cpi_stack_cycle_count;
+   UInt64 m_cpi_stack_mispredictions;
+   // Deepest level of the memory accesses of the instruction being modeled
+   // (BASE if none), and of the last instruction that accessed memory
+   CpiStack::Component m_pending_memory_component;
+   CpiStack::Component m_memory_component;
 };
 
 #endif
@@ -0,0 +1,60 @@
+#ifndef CPI_STACK_H
+#define CPI_STACK_H
+
+#include "fixed_types.h"
+#include "dynamic_instruction_info.h"
+
+/*
+  Components of the CPI stack of a core. The core model charges the cycles
+  between two modeled instructions (or summarized basic blocks) to them from
+  the stall cycles it already counts: the recv and sync instructions, the
+  L1-I stalls, the mispredicted branches (penalty - 1 cycles each, from the
+  counters of the branch predictor), then the other memory stalls to the
+  level that served the memory accesses of the instruction (of the last one
+  that accessed memory if it had none). The rest is base, which includes the
+  dependences and structural hazards of the pipeline.
+
+  The level of an access is where its L1 miss was served: the L2 of the
+  tile, a remote cache (a sharing miss of the L2, needs track_miss_types on
+  the L2) or DRAM (the other L2 misses). With a shared L2 (pr_l1_sh_l2_msi)
+  all the L1 misses are charged to the L2.
+ */
+class CpiStack
+{
+public:
+   enum Component
+   {
+      BASE = 0,
+      BRANCH,
+      L1_ICACHE,
+      L1_DCACHE,
+      L2_CACHE,
+      REMOTE,
+      DRAM,
+      SYNC,
+      RECV,
+      NUM_COMPONENTS
+   };
+
+   static const char* getName(UInt32 component)
+   {
+      static const char* names[NUM_COMPONENTS] =
+         { "Base", "Branch", "L1-I Cache", "L1-D Cache", "L2 Cache", "Remote Cache", "DRAM", "Sync", "Recv" };
+      return (component < NUM_COMPONENTS) ? names[component] : "Unknown";
+   }
+
+   // Cache::SHARING_MISS
+   static const UInt8 SHARING_MISS = 2;
+
+   // Level of a memory access
+   static Component getMemoryComponent(const DynamicInstructionInfo& info)
+   {
+      if (info.memory_info.num_misses == 0)
+         return L1_DCACHE;
+      if (info.memory_info.num_l2_misses == 0)
+         return L2_CACHE;
+      return (info.memory_info.miss_type == SHARING_MISS) ? REMOTE : DRAM;
+   }
+};
+
+#endif // CPI_STACK_H
@@ -21,6 +21,12 @@ struct DynamicInstructionInfo
          UInt64 latency;
          IntPtr addr;
          UInt32 num_misses;
+         // Of the misses, those that also missed in the L2 of the tile, and
+         // the Cache::MissType of the last miss (not a type if unknown)
+         UInt32 num_l2_misses;
+         UInt8 miss_type;
+         // Access of a LOCK-prefixed (atomic) instruction
+         bool locked;
       } memory_info;
 
       // STRING
@@ -49,13 +55,17 @@ struct DynamicInstructionInfo
       memory_info = rhs.memory_info; // "use bigger one"
    }
 
-   static DynamicInstructionInfo createMemoryInfo(UInt64 l, IntPtr a, Operand::Direction dir, UInt32 num_misses)
+   static DynamicInstructionInfo createMemoryInfo(UInt64 l, IntPtr a, Operand::Direction dir, UInt32 num_misses,
+                                                  UInt32 num_l2_misses = 0, UInt8 miss_type = 0xff, bool locked = false)
    {
       DynamicInstructionInfo i;
       i.type = (dir == Operand::READ) ? MEMORY_READ : MEMORY_WRITE;
       i.memory_info.latency = l;
       i.memory_info.addr = a;
       i.memory_info.num_misses = num_misses;
+      i.memory_info.num_l2_misses = num_l2_misses;
+      i.memory_info.miss_type = miss_type;
+      i.memory_info.locked = locked;
       return i;
    }
 
@@ -0,0 +1,69 @@
+#include "idle_state_model.h"
+#include "simulator.h"
+#include "config.h"
+#include "log.h"
+
+using namespace std;
+
+IdleStateModel::IdleStateModel(tile_id_t tile_id)
+   : m_tile_id(tile_id)
+   , m_num_waits(0)
+   , m_num_sleeps(0)
+   , m_total_idle_time(0)
+   , m_total_sleep_time(0)
+{
+   try
+   {
+      m_min_idle_time = Sim()->getCfg()->getInt("core/idle_states/min_idle_time", 1000);
+      m_wake_latency = Sim()->getCfg()->getInt("core/idle_states/wake_latency", 100);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read [core/idle_states] parameters from the cfg file");
+   }
+}
+
+IdleStateModel::~IdleStateModel()
+{}
+
+IdleStateModel*
+IdleStateModel::create(tile_id_t tile_id)
+{
+   bool enabled = false;
+   try
+   {
+      enabled = Sim()->getCfg()->getBool("core/idle_states/enabled", false);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read core/idle_states/enabled from the cfg file");
+   }
+   if (!enabled || !Config::getSingleton()->isApplicationTile(tile_id))
+      return NULL;
+   return new IdleStateModel(tile_id);
+}
+
+UInt64
+IdleStateModel::wakeUp(UInt64 idle_time)
+{
+   m_num_waits ++;
+   m_total_idle_time += idle_time;
+   if (idle_time < m_min_idle_time)
+      return 0;
+
+   LOG_PRINT("Tile(%i) slept for %llu ns", m_tile_id, idle_time);
+   m_num_sleeps ++;
+   m_total_sleep_time += idle_time;
+   return m_wake_latency;
+}
+
+void
+IdleStateModel::outputSummary(ostream& os)
+{
+   os << "  Idle States:" << endl;
+   os << "    Waits: " << m_num_waits << endl;
+   os << "    Sleeps: " << m_num_sleeps << endl;
+   os << "    Idle Time (in ns): " << m_total_idle_time << endl;
+   os << "    Sleep Time (in ns): " << m_total_sleep_time << endl;
+   os << "    Wake-up Latency (in ns): " << m_num_sleeps * m_wake_latency << endl;
+}
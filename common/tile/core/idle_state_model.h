@@ -0,0 +1,43 @@
+#ifndef IDLE_STATE_MODEL_H
+#define IDLE_STATE_MODEL_H
+
+#include <ostream>
+
+#include "fixed_types.h"
+
+/*
+  Sleep state of an application tile whose thread waits for another tile
+  ([core/idle_states]): a mutex, cond or barrier of the SyncServer, or a
+  futex wait. The thread is stalled by the ThreadManager while it waits, so
+  the tile takes no part in the lax_barrier synchronization and acks the
+  lax_p2p requests at once. On wakeup the core clock jumps to the time of
+  the waker; a wait of at least 'min_idle_time' puts the core to sleep and
+  adds 'wake_latency' to it. Only called by the app thread of the tile.
+ */
+class IdleStateModel
+{
+public:
+   IdleStateModel(tile_id_t tile_id);
+   ~IdleStateModel();
+
+   // NULL unless core/idle_states/enabled
+   static IdleStateModel* create(tile_id_t tile_id);
+
+   // The thread waited for 'idle_time' (in ns), returns the wake-up latency
+   // (in ns) added to the wait
+   UInt64 wakeUp(UInt64 idle_time);
+
+   void outputSummary(std::ostream& os);
+
+private:
+   tile_id_t m_tile_id;
+   UInt64 m_min_idle_time;
+   UInt64 m_wake_latency;
+
+   UInt64 m_num_waits;
+   UInt64 m_num_sleeps;
+   UInt64 m_total_idle_time;
+   UInt64 m_total_sleep_time;
+};
+
+#endif
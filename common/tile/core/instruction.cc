@@ -4,16 +4,46 @@
 #include "tile.h"
 #include "core_model.h"
 #include "branch_predictor.h"
+#include "mcpat_core_interface.h"
+
+// OperandList
+
+OperandList::OperandList(const OperandList &src)
+   : m_size(0)
+   , m_overflow(NULL)
+{
+   *this = src;
+}
+
+OperandList& OperandList::operator=(const OperandList &src)
+{
+   if (this == &src)
+      return *this;
+
+   clear();
+   for (UInt32 i = 0; i < src.size(); i++)
+      push_back(src[i]);
+   return *this;
+}
+
+void OperandList::clear()
+{
+   delete m_overflow;
+   m_overflow = NULL;
+   m_size = 0;
+}
 
 // Instruction
 
 Instruction::StaticInstructionCosts Instruction::m_instruction_costs;
+Instruction::StaticInstructionCosts Instruction::m_instruction_occupancies;
 
 Instruction::Instruction(InstructionType type, UInt64 opcode, OperandList &operands)
    : m_type(type)
    , m_opcode(opcode)
    , m_address(0)
    , m_size(0)
+   , m_mcpat_events(NULL)
    , m_operands(operands)
 {
 }
@@ -23,9 +53,15 @@ Instruction::Instruction(InstructionType type)
    , m_opcode(0)
    , m_address(0)
    , m_size(0)
+   , m_mcpat_events(NULL)
 {
 }
 
+Instruction::~Instruction()
+{
+   delete m_mcpat_events;
+}
+
 UInt64 Instruction::getCost()
 {
    LOG_ASSERT_ERROR(m_type < MAX_INSTRUCTION_COUNT, "Unknown instruction type: %d", m_type);
@@ -62,15 +98,38 @@ bool Instruction::isSimpleMemoryLoad() const
 void Instruction::initializeStaticInstructionModel()
 {
    m_instruction_costs.resize(MAX_INSTRUCTION_COUNT);
+   m_instruction_occupancies.resize(MAX_INSTRUCTION_COUNT);
    for(unsigned int i = 0; i < MAX_INSTRUCTION_COUNT; i++)
    {
        char key_name [1024];
        snprintf(key_name, 1024, "core/static_instruction_costs/%s", INSTRUCTION_NAMES[i]);
        UInt32 instruction_cost = Sim()->getCfg()->getInt(key_name, 0);
        m_instruction_costs[i] = instruction_cost;
+
+       snprintf(key_name, 1024, "core/static_instruction_occupancy/%s", INSTRUCTION_NAMES[i]);
+       m_instruction_occupancies[i] = Sim()->getCfg()->getInt(key_name, 0);
    }
 }
 
+InstructionType Instruction::getVectorInstructionType(InstructionType type_128, UInt32 width)
+{
+   LOG_ASSERT_ERROR(isVectorInstructionType(type_128) && (((type_128 - INST_VINT_128) % NUM_VECTOR_WIDTHS) == 0),
+                    "Not a 128-bit vector instruction type(%u)", type_128);
+   if (width > 256)
+      return (InstructionType) (type_128 + 2);
+   else if (width > 128)
+      return (InstructionType) (type_128 + 1);
+   else
+      return type_128;
+}
+
+InstructionType Instruction::getFunctionalUnit(InstructionType type)
+{
+   if (!isVectorInstructionType(type))
+      return type;
+   return (InstructionType) (type - ((type - INST_VINT_128) % NUM_VECTOR_WIDTHS));
+}
+
 // DynamicInstruction
 
 DynamicInstruction::DynamicInstruction(UInt64 cost, InstructionType type)
@@ -5,6 +5,8 @@
 #include <vector>
 #include "fixed_types.h"
 
+struct McPATInstructionEvents;
+
 enum InstructionType
 {
    INST_GENERIC,
@@ -23,11 +25,33 @@ enum InstructionType
    INST_SPAWN,
    INST_STRING,
    INST_BRANCH,
+   // Vector (SSE/AVX) operations, one type per width (128, 256, 512 bits)
+   INST_VINT_128,       // integer add/sub/logical/compare/shift
+   INST_VINT_256,
+   INST_VINT_512,
+   INST_VIMUL_128,      // integer multiply
+   INST_VIMUL_256,
+   INST_VIMUL_512,
+   INST_VFADD_128,      // fp add/sub/min/max/compare/convert
+   INST_VFADD_256,
+   INST_VFADD_512,
+   INST_VFMUL_128,      // fp multiply, fused multiply-add
+   INST_VFMUL_256,
+   INST_VFMUL_512,
+   INST_VFDIV_128,      // fp divide/square root
+   INST_VFDIV_256,
+   INST_VFDIV_512,
+   INST_VSHUFFLE_128,   // shuffle/permute/blend/unpack/insert/extract/broadcast
+   INST_VSHUFFLE_256,
+   INST_VSHUFFLE_512,
    MAX_INSTRUCTION_COUNT
 };
 
 __attribute__ ((unused)) static const char * INSTRUCTION_NAMES [] = 
-{"generic","add","sub","mul","div","fadd","fsub","fmul","fdiv","jmp","dynamic_misc","recv","sync","spawn","string","branch"};
+{"generic","add","sub","mul","div","fadd","fsub","fmul","fdiv","jmp","dynamic_misc","recv","sync","spawn","string","branch",
+ "vint_128","vint_256","vint_512","vimul_128","vimul_256","vimul_512",
+ "vfadd_128","vfadd_256","vfadd_512","vfmul_128","vfmul_256","vfmul_512",
+ "vfdiv_128","vfdiv_256","vfdiv_512","vshuffle_128","vshuffle_256","vshuffle_512"};
 
 class Operand
 {
@@ -47,20 +71,65 @@ public:
 
    typedef UInt64 Value;
 
+   Operand()
+      : m_value(0), m_type(REG), m_direction(READ) {}
+
    Operand(const Operand &src)
-      : m_type(src.m_type), m_value(src.m_value), m_direction(src.m_direction) {}
+      : m_value(src.m_value), m_type(src.m_type), m_direction(src.m_direction) {}
 
    Operand(Type type, Value value = 0, Direction direction = READ)
-      : m_type(type), m_value(value), m_direction(direction) {}
+      : m_value(value), m_type(type), m_direction(direction) {}
 
-   Type m_type;
+   // The value first, so that an operand takes 16 bytes
    Value m_value;
+   Type m_type;
    Direction m_direction;
 
    void print(std::ostringstream& out) const;
 };
 
-typedef std::vector<Operand> OperandList;
+// The operands of an instruction: the first few are kept in the list
+// itself, so that an instruction and its operands are a single object,
+// the others (instructions with many implicit registers) on the heap
+class OperandList
+{
+public:
+   OperandList()
+      : m_size(0), m_overflow(NULL) {}
+   OperandList(const OperandList &src);
+   ~OperandList() { delete m_overflow; }
+
+   OperandList& operator=(const OperandList &src);
+
+   void push_back(const Operand &operand)
+   {
+      if (m_size < NUM_INLINE_OPERANDS)
+         m_inline[m_size] = operand;
+      else
+      {
+         if (m_overflow == NULL)
+            m_overflow = new std::vector<Operand>();
+         m_overflow->push_back(operand);
+      }
+      m_size ++;
+   }
+
+   UInt32 size() const { return m_size; }
+   bool empty() const { return (m_size == 0); }
+   void clear();
+
+   const Operand& operator[](UInt32 i) const
+   { return (i < NUM_INLINE_OPERANDS) ? m_inline[i] : (*m_overflow)[i - NUM_INLINE_OPERANDS]; }
+   Operand& operator[](UInt32 i)
+   { return (i < NUM_INLINE_OPERANDS) ? m_inline[i] : (*m_overflow)[i - NUM_INLINE_OPERANDS]; }
+
+private:
+   static const UInt32 NUM_INLINE_OPERANDS = 6;
+
+   Operand m_inline[NUM_INLINE_OPERANDS];
+   UInt32 m_size;
+   std::vector<Operand>* m_overflow;
+};
 
 class Instruction
 {
@@ -71,11 +140,24 @@ public:
 
    Instruction(InstructionType type);
 
-   virtual ~Instruction() { };
+   virtual ~Instruction();
    virtual UInt64 getCost();
+   // Cycles the functional unit of the instruction is busy for, before it
+   // takes the next one ([core/static_instruction_occupancy], 0: none)
+   UInt64 getOccupancy() const
+   { return m_instruction_occupancies[m_type]; }
+   // The widths of a vector operation share a functional unit
+   InstructionType getFunctionalUnit() const
+   { return getFunctionalUnit(m_type); }
 
    static void initializeStaticInstructionModel();
 
+   // 'type_128' of a vector operation of 'width' bits
+   static InstructionType getVectorInstructionType(InstructionType type_128, UInt32 width);
+   static bool isVectorInstructionType(InstructionType type)
+   { return ((type >= INST_VINT_128) && (type < MAX_INSTRUCTION_COUNT)); }
+   static InstructionType getFunctionalUnit(InstructionType type);
+
    InstructionType getType()
    { return m_type; }
    UInt64 getOpcode() const
@@ -98,9 +180,20 @@ public:
 
    void print() const;
 
+   // Events of an execution of the instruction for the McPAT core model,
+   // NULL until its first execution (see McPATCoreInterface)
+   McPATInstructionEvents* getMcPATEvents() const
+   { return m_mcpat_events; }
+   // Returns false if they were already set
+   bool setMcPATEvents(McPATInstructionEvents* events)
+   { return __sync_bool_compare_and_swap(&m_mcpat_events, (McPATInstructionEvents*) NULL, events); }
+
 private:
    typedef std::vector<unsigned int> StaticInstructionCosts;
    static StaticInstructionCosts m_instruction_costs;
+   static StaticInstructionCosts m_instruction_occupancies;
+
+   static const UInt32 NUM_VECTOR_WIDTHS = 3;
 
    InstructionType m_type;
    UInt64 m_opcode;
@@ -108,6 +201,9 @@ private:
    IntPtr m_address;
    UInt32 m_size;
 
+   // The basic blocks are shared by the cores
+   McPATInstructionEvents* volatile m_mcpat_events;
+
 protected:
    OperandList m_operands;
 };
@@ -0,0 +1,51 @@
+#include "instruction_arena.h"
+#include "utils.h"
+#include "log.h"
+
+InstructionArena::InstructionArena(UInt32 chunk_size)
+   : m_chunk_size(chunk_size)
+   , m_next(NULL)
+   , m_remaining(0)
+   , m_num_generations(1)
+   , m_total_bytes_allocated(0)
+{
+   LOG_ASSERT_ERROR(m_chunk_size >= ALIGNMENT, "Chunk size(%u) is smaller than the alignment(%u)",
+                    m_chunk_size, ALIGNMENT);
+}
+
+InstructionArena::~InstructionArena()
+{
+   for (UInt32 i = 0; i < m_chunks.size(); i++)
+      delete [] m_chunks[i];
+}
+
+void* InstructionArena::allocate(size_t size)
+{
+   size = (size + ALIGNMENT - 1) & ~((size_t) ALIGNMENT - 1);
+   if (size > m_remaining)
+      allocateChunk(size);
+
+   void* storage = m_next;
+   m_next += size;
+   m_remaining -= size;
+   m_total_bytes_allocated += size;
+   return storage;
+}
+
+void InstructionArena::newGeneration()
+{
+   // The next allocation takes a new chunk
+   m_remaining = 0;
+   m_num_generations ++;
+}
+
+void InstructionArena::allocateChunk(size_t min_size)
+{
+   size_t chunk_size = getMax<size_t>(m_chunk_size, min_size);
+   // new [] is only aligned to the largest fundamental type
+   Byte* chunk = new Byte[chunk_size + ALIGNMENT];
+   m_chunks.push_back(chunk);
+
+   m_next = (Byte*) ((((IntPtr) chunk) + ALIGNMENT - 1) & ~((IntPtr) ALIGNMENT - 1));
+   m_remaining = chunk_size;
+}
@@ -0,0 +1,52 @@
+#ifndef INSTRUCTION_ARENA_H
+#define INSTRUCTION_ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+#include "fixed_types.h"
+
+/*
+  Storage for the basic blocks and instructions created when code is
+  instrumented (or read from an instruction trace). The objects are placed
+  one after the other in large chunks, in the order they are created, so
+  that the instructions of a basic block are next to each other:
+     Instruction* ins = new (arena.allocate(sizeof(GenericInstruction))) GenericInstruction(...);
+  The storage is only freed with the arena, and the owner of the arena
+  destroys the objects (if it needs to) before it.
+
+  newGeneration() starts a new chunk, for the code instrumented after a
+  flush of the Pin code cache: the blocks of the new traces are not mixed
+  with the blocks of the flushed ones.
+
+  Not thread-safe: Pin instruments one trace at a time.
+ */
+class InstructionArena
+{
+public:
+   InstructionArena(UInt32 chunk_size = DEFAULT_CHUNK_SIZE);
+   ~InstructionArena();
+
+   // Aligned to 16 bytes
+   void* allocate(size_t size);
+   void newGeneration();
+
+   UInt32 getNumGenerations() const { return m_num_generations; }
+   UInt64 getTotalBytesAllocated() const { return m_total_bytes_allocated; }
+
+private:
+   static const UInt32 DEFAULT_CHUNK_SIZE = 1 << 16;
+   static const UInt32 ALIGNMENT = 16;
+
+   void allocateChunk(size_t min_size);
+
+   UInt32 m_chunk_size;
+   std::vector<Byte*> m_chunks;
+   Byte* m_next;
+   size_t m_remaining;
+
+   UInt32 m_num_generations;
+   UInt64 m_total_bytes_allocated;
+};
+
+#endif
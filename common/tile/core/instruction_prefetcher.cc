@@ -0,0 +1,204 @@
+#include "instruction_prefetcher.h"
+#include "core.h"
+#include "tile.h"
+#include "memory_manager.h"
+#include "cache.h"
+#include "simulator.h"
+#include "stats_registry.h"
+#include "utils.h"
+#include "log.h"
+
+using namespace std;
+
+InstructionPrefetcher::InstructionPrefetcher(Core* core, Type type, UInt32 degree, UInt32 buffer_size,
+                                             UInt32 lookahead, UInt32 table_size)
+   : _core(core)
+   , _type(type)
+   , _degree(degree)
+   , _lookahead(lookahead)
+   , _log_line_size(0)
+   , _next_buffer_entry(0)
+   , _last_fetch_line_num(INVALID_ADDRESS)
+   , _last_block_address(INVALID_ADDRESS)
+   , _total_prefetches(0)
+   , _total_useful_prefetches(0)
+   , _total_late_prefetches(0)
+   , _total_useless_prefetches(0)
+   , _total_late_cycles(0)
+   , _total_uncovered_misses(0)
+{
+   LOG_ASSERT_ERROR(buffer_size > 0, "L1-I prefetch buffer size(%u) must be > 0", buffer_size);
+   LOG_ASSERT_ERROR((type != FETCH_DIRECTED) || (table_size > 0), "L1-I prefetcher table size(%u) must be > 0", table_size);
+
+   BufferEntry empty_entry = { 0, 0, false };
+   _buffer.resize(buffer_size, empty_entry);
+   if (_type == FETCH_DIRECTED)
+   {
+      SuccessorEntry empty_successor = { INVALID_ADDRESS, INVALID_ADDRESS };
+      _successors.resize(table_size, empty_successor);
+   }
+
+   StatsRegistry* stats = Sim()->getStatsRegistry();
+   if (stats)
+   {
+      tile_id_t tile_id = _core->getTile()->getId();
+      stats->registerCounter(tile_id, "Core Model/L1-I Prefetcher/Prefetches", &_total_prefetches);
+      stats->registerCounter(tile_id, "Core Model/L1-I Prefetcher/Useful Prefetches", &_total_useful_prefetches);
+      stats->registerCounter(tile_id, "Core Model/L1-I Prefetcher/Late Prefetches", &_total_late_prefetches);
+      stats->registerCounter(tile_id, "Core Model/L1-I Prefetcher/Useless Prefetches", &_total_useless_prefetches);
+      stats->registerCounter(tile_id, "Core Model/L1-I Prefetcher/Uncovered Misses", &_total_uncovered_misses);
+   }
+}
+
+InstructionPrefetcher::~InstructionPrefetcher()
+{}
+
+InstructionPrefetcher*
+InstructionPrefetcher::create(Core* core, string type_str, UInt32 degree, UInt32 buffer_size,
+                              UInt32 lookahead, UInt32 table_size)
+{
+   Type type = parse(type_str);
+   if (type == NONE)
+      return NULL;
+   return new InstructionPrefetcher(core, type, degree, buffer_size, lookahead, table_size);
+}
+
+InstructionPrefetcher::Type
+InstructionPrefetcher::parse(string type_str)
+{
+   if (type_str == "none")
+      return NONE;
+   else if (type_str == "next_line")
+      return NEXT_LINE;
+   else if (type_str == "fetch_directed")
+      return FETCH_DIRECTED;
+   else
+   {
+      LOG_PRINT_ERROR("Unrecognized L1-I prefetcher type(%s)", type_str.c_str());
+      return NUM_TYPES;
+   }
+}
+
+UInt64
+InstructionPrefetcher::fetch(IntPtr address, UInt32 size, bool block_start, UInt64 time)
+{
+   if (_log_line_size == 0)
+      _log_line_size = floorLog2(_core->getMemoryManager()->getCacheLineSize());
+
+   IntPtr first_line_num = address >> _log_line_size;
+   IntPtr last_line_num = (address + size - 1) >> _log_line_size;
+
+   // The lines of the fetch that were prefetched arrive at their time
+   UInt64 ready_latency = 0;
+   bool prefetched = false;
+   for (IntPtr line_num = first_line_num; line_num <= last_line_num; line_num++)
+   {
+      BufferEntry* entry = findBufferEntry(line_num);
+      if (!entry)
+         continue;
+      prefetched = true;
+      _total_useful_prefetches ++;
+      if (entry->ready_time > time)
+      {
+         _total_late_prefetches ++;
+         _total_late_cycles += entry->ready_time - time;
+         ready_latency = max<UInt64>(ready_latency, entry->ready_time - time);
+      }
+      entry->valid = false;
+   }
+
+   UInt64 latency = _core->readInstructionMemory(address, size);
+   if (!prefetched && _core->getMemoryManager()->getL1ICache()->lastAccessMissed())
+      _total_uncovered_misses ++;
+   latency = max<UInt64>(latency, ready_latency);
+
+   if (_type == NEXT_LINE)
+   {
+      if (last_line_num != _last_fetch_line_num)
+      {
+         for (UInt32 i = 1; i <= _degree; i++)
+            prefetch(last_line_num + i, address, time);
+      }
+      _last_fetch_line_num = last_line_num;
+   }
+   else if (block_start)
+   {
+      // This block followed the previous one
+      if (_last_block_address != INVALID_ADDRESS)
+      {
+         SuccessorEntry& entry = getSuccessorEntry(_last_block_address);
+         entry.block_address = _last_block_address;
+         entry.successor_address = address;
+      }
+      _last_block_address = address;
+
+      // Run ahead along the predicted blocks
+      IntPtr block_address = address;
+      for (UInt32 d = 0; d < _lookahead; d++)
+      {
+         SuccessorEntry& entry = getSuccessorEntry(block_address);
+         if ((entry.block_address != block_address) || (entry.successor_address == block_address))
+            break;
+         block_address = entry.successor_address;
+         IntPtr block_line_num = block_address >> _log_line_size;
+         for (UInt32 i = 0; i < _degree; i++)
+            prefetch(block_line_num + i, block_address, time);
+      }
+   }
+
+   return latency;
+}
+
+void
+InstructionPrefetcher::prefetch(IntPtr line_num, IntPtr trigger_address, UInt64 time)
+{
+   IntPtr line_address = line_num << _log_line_size;
+   if ((line_address >> LOG_PAGE_SIZE) != (trigger_address >> LOG_PAGE_SIZE))
+      return;
+   if (findBufferEntry(line_num) || _core->getMemoryManager()->getL1ICache()->probeCacheLine(line_address, NULL, 0))
+      return;
+
+   BufferEntry& entry = _buffer[_next_buffer_entry];
+   _next_buffer_entry = (_next_buffer_entry + 1) % _buffer.size();
+   if (entry.valid)
+      _total_useless_prefetches ++;
+
+   entry.line_num = line_num;
+   entry.ready_time = time + _core->readInstructionMemory(line_address, 1);
+   entry.valid = true;
+   _total_prefetches ++;
+}
+
+InstructionPrefetcher::BufferEntry*
+InstructionPrefetcher::findBufferEntry(IntPtr line_num)
+{
+   for (UInt32 i = 0; i < _buffer.size(); i++)
+   {
+      if (_buffer[i].valid && (_buffer[i].line_num == line_num))
+         return &_buffer[i];
+   }
+   return NULL;
+}
+
+void
+InstructionPrefetcher::outputSummary(ostream& os)
+{
+   os << "    L1-I Prefetcher:" << endl;
+   os << "      Prefetches: " << _total_prefetches << endl;
+   os << "      Useful Prefetches: " << _total_useful_prefetches << endl;
+   os << "      Late Prefetches: " << _total_late_prefetches << endl;
+   os << "      Useless Prefetches: " << _total_useless_prefetches << endl;
+   os << "      Average Late Cycles: ";
+   if (_total_late_prefetches > 0)
+      os << ((double) _total_late_cycles) / _total_late_prefetches;
+   os << endl;
+   // Misses of the L1-I removed by the prefetcher
+   os << "      Coverage (%): ";
+   if ((_total_useful_prefetches + _total_uncovered_misses) > 0)
+      os << 100.0 * _total_useful_prefetches / (_total_useful_prefetches + _total_uncovered_misses);
+   os << endl;
+   os << "      Accuracy (%): ";
+   if (_total_prefetches > 0)
+      os << 100.0 * _total_useful_prefetches / _total_prefetches;
+   os << endl;
+}
@@ -0,0 +1,96 @@
+#ifndef INSTRUCTION_PREFETCHER_H
+#define INSTRUCTION_PREFETCHER_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "fixed_types.h"
+
+class Core;
+
+/*
+  L1-I prefetcher of a core model, which fetches the instructions through it.
+   - next_line: the fetch of a line other than the last one fetched
+     prefetches the 'degree' lines after it
+   - fetch_directed: the fetch of the first instruction of a basic block
+     prefetches the first 'degree' lines of the blocks predicted to run
+     after it, up to 'lookahead' blocks ahead. The prediction is the block
+     that followed the last time (a BTB of the basic block successors,
+     'table_size' entries, trained with the blocks the core runs)
+  Prefetches never cross a page, and skip the lines present in the L1-I.
+
+  A prefetch is sent to the L1-I right away and fills it; the lines in
+  flight are kept in a prefetch buffer of 'buffer_size' entries with the
+  time they arrive. A fetch of a line of the buffer waits for it if it is
+  late, the lines pushed out of the buffer unused are useless prefetches.
+  The prefetches are counted in the L1-I statistics like the fetches.
+ */
+class InstructionPrefetcher
+{
+public:
+   enum Type
+   {
+      NONE = 0,
+      NEXT_LINE,
+      FETCH_DIRECTED,
+      NUM_TYPES
+   };
+
+   InstructionPrefetcher(Core* core, Type type, UInt32 degree, UInt32 buffer_size, UInt32 lookahead, UInt32 table_size);
+   ~InstructionPrefetcher();
+
+   // Returns NULL if type_str is "none"
+   static InstructionPrefetcher* create(Core* core, std::string type_str, UInt32 degree, UInt32 buffer_size,
+                                        UInt32 lookahead, UInt32 table_size);
+   static Type parse(std::string type_str);
+
+   // Fetches the instruction at 'address' at 'time' (in cycles of the
+   // core), 'block_start' if it is the first one of a basic block.
+   // Returns the latency of the fetch
+   UInt64 fetch(IntPtr address, UInt32 size, bool block_start, UInt64 time);
+
+   void outputSummary(std::ostream& os);
+
+private:
+   static const UInt32 LOG_PAGE_SIZE = 12;
+
+   struct BufferEntry
+   {
+      IntPtr line_num;
+      UInt64 ready_time;
+      bool valid;
+   };
+   struct SuccessorEntry
+   {
+      IntPtr block_address;
+      IntPtr successor_address;
+   };
+
+   Core* _core;
+   Type _type;
+   UInt32 _degree;
+   UInt32 _lookahead;
+   UInt32 _log_line_size;
+
+   std::vector<BufferEntry> _buffer;
+   UInt32 _next_buffer_entry;
+   std::vector<SuccessorEntry> _successors;
+   IntPtr _last_fetch_line_num;
+   IntPtr _last_block_address;
+
+   UInt64 _total_prefetches;
+   UInt64 _total_useful_prefetches;
+   UInt64 _total_late_prefetches;
+   UInt64 _total_useless_prefetches;
+   UInt64 _total_late_cycles;
+   // Fetches that missed in the L1-I without a prefetch
+   UInt64 _total_uncovered_misses;
+
+   void prefetch(IntPtr line_num, IntPtr trigger_address, UInt64 time);
+   BufferEntry* findBufferEntry(IntPtr line_num);
+   SuccessorEntry& getSuccessorEntry(IntPtr block_address)
+   { return _successors[(block_address ^ (block_address >> 12)) % _successors.size()]; }
+};
+
+#endif // INSTRUCTION_PREFETCHER_H
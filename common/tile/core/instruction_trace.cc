@@ -0,0 +1,384 @@
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <sstream>
+#include <new>
+
+#include "instruction_trace.h"
+#include "log.h"
+
+string
+InstructionTrace::getFileName(string directory, tile_id_t tile_id)
+{
+   std::ostringstream filename;
+   filename << directory << "/instruction_trace." << tile_id;
+   return filename.str();
+}
+
+// InstructionTraceWriter
+
+InstructionTraceWriter::InstructionTraceWriter(string filename, tile_id_t tile_id)
+   : m_last_code_address(0)
+   , m_last_data_address(0)
+   , m_last_branch_target(0)
+{
+   m_file = fopen(filename.c_str(), "wb");
+   LOG_ASSERT_ERROR(m_file, "Could not open instruction trace(%s)", filename.c_str());
+
+   UInt32 header[3] = { InstructionTrace::MAGIC, InstructionTrace::VERSION, (UInt32) tile_id };
+   fwrite(header, sizeof(header), 1, m_file);
+}
+
+InstructionTraceWriter::~InstructionTraceWriter()
+{
+   fclose(m_file);
+}
+
+void
+InstructionTraceWriter::writeBasicBlock(BasicBlock* basic_block)
+{
+   writeByte(InstructionTrace::BASIC_BLOCK);
+
+   std::map<BasicBlock*, UInt32>::iterator it = m_basic_block_indices.find(basic_block);
+   if (it != m_basic_block_indices.end())
+   {
+      writeUnsigned(it->second);
+      return;
+   }
+
+   // The next index: defined here
+   UInt32 index = m_basic_block_indices.size();
+   m_basic_block_indices[basic_block] = index;
+   writeUnsigned(index);
+
+   writeUnsigned(basic_block->size());
+   for (UInt32 i = 0; i < basic_block->size(); i++)
+      writeInstruction((*basic_block)[i]);
+}
+
+void
+InstructionTraceWriter::writeInstruction(Instruction* instruction)
+{
+   writeByte(instruction->getType());
+   writeUnsigned(instruction->getOpcode());
+   writeAddress(instruction->getAddress(), m_last_code_address);
+   writeUnsigned(instruction->getSize());
+
+   const OperandList& operands = instruction->getOperands();
+   writeUnsigned(operands.size());
+   for (UInt32 i = 0; i < operands.size(); i++)
+   {
+      writeByte((operands[i].m_type << 1) | operands[i].m_direction);
+      writeUnsigned(operands[i].m_value);
+   }
+}
+
+void
+InstructionTraceWriter::writeMemoryAccess(Core::mem_op_t mem_op_type, Core::lock_signal_t lock_signal,
+                                          IntPtr address, UInt32 size)
+{
+   writeByte(InstructionTrace::MEMORY_ACCESS);
+   writeByte((mem_op_type << 2) | lock_signal);
+   writeAddress(address, m_last_data_address);
+   writeUnsigned(size);
+}
+
+void
+InstructionTraceWriter::writeBranch(bool taken, IntPtr target)
+{
+   writeByte(InstructionTrace::BRANCH);
+   writeByte(taken);
+   writeAddress(target, m_last_branch_target);
+}
+
+void
+InstructionTraceWriter::writeString(UInt32 num_ops)
+{
+   writeByte(InstructionTrace::STRING);
+   writeUnsigned(num_ops);
+}
+
+void
+InstructionTraceWriter::writeSync(InstructionTrace::SyncType sync_type, SInt32 id, SInt32 argument)
+{
+   writeByte(InstructionTrace::SYNC);
+   writeByte(sync_type);
+   writeSigned(id);
+   writeSigned(argument);
+}
+
+void
+InstructionTraceWriter::writeThreadSpawn(tile_id_t tile_id, SInt32 thread_id)
+{
+   writeByte(InstructionTrace::THREAD_SPAWN);
+   writeSigned(tile_id);
+   writeSigned(thread_id);
+}
+
+void
+InstructionTraceWriter::writeThreadJoin(SInt32 thread_id)
+{
+   writeByte(InstructionTrace::THREAD_JOIN);
+   writeSigned(thread_id);
+}
+
+void
+InstructionTraceWriter::writeThreadExit()
+{
+   writeByte(InstructionTrace::THREAD_EXIT);
+   // The next thread on the core may only start long after
+   fflush(m_file);
+}
+
+void
+InstructionTraceWriter::writeByte(UInt8 value)
+{
+   putc(value, m_file);
+}
+
+void
+InstructionTraceWriter::writeUnsigned(UInt64 value)
+{
+   while (value >= 0x80)
+   {
+      writeByte((value & 0x7f) | 0x80);
+      value >>= 7;
+   }
+   writeByte(value);
+}
+
+void
+InstructionTraceWriter::writeSigned(SInt64 value)
+{
+   // Zigzag: small negative values are small too
+   writeUnsigned((((UInt64) value) << 1) ^ ((UInt64) (value >> 63)));
+}
+
+void
+InstructionTraceWriter::writeAddress(IntPtr address, IntPtr& last_address)
+{
+   writeSigned((SInt64) (address - last_address));
+   last_address = address;
+}
+
+// InstructionTraceReader
+
+InstructionTraceReader::InstructionTraceReader(string filename, bool summarize_basic_blocks)
+   : m_filename(filename)
+   , m_summarize_basic_blocks(summarize_basic_blocks)
+   , m_data(NULL)
+   , m_size(0)
+   , m_position(0)
+   , m_tile_id(INVALID_TILE_ID)
+   , m_last_code_address(0)
+   , m_last_data_address(0)
+   , m_last_branch_target(0)
+{
+   int fd = open(filename.c_str(), O_RDONLY);
+   LOG_ASSERT_ERROR(fd >= 0, "Could not open instruction trace(%s)", filename.c_str());
+
+   struct stat file_stat;
+   fstat(fd, &file_stat);
+   m_size = file_stat.st_size;
+
+   UInt32 header[3];
+   LOG_ASSERT_ERROR(m_size >= sizeof(header), "Instruction trace(%s) is truncated", filename.c_str());
+
+   void* data = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   LOG_ASSERT_ERROR(data != MAP_FAILED, "Could not map instruction trace(%s)", filename.c_str());
+   close(fd);
+   m_data = (const UInt8*) data;
+
+   memcpy(header, m_data, sizeof(header));
+   LOG_ASSERT_ERROR(header[0] == InstructionTrace::MAGIC, "%s is not an instruction trace", filename.c_str());
+   LOG_ASSERT_ERROR(header[1] == InstructionTrace::VERSION, "Instruction trace(%s) has version(%u), expected(%u)",
+                    filename.c_str(), header[1], InstructionTrace::VERSION);
+   m_tile_id = (tile_id_t) header[2];
+   m_position = sizeof(header);
+}
+
+InstructionTraceReader::~InstructionTraceReader()
+{
+   for (UInt32 i = 0; i < m_basic_blocks.size(); i++)
+   {
+      BasicBlock* basic_block = m_basic_blocks[i];
+      for (UInt32 j = 0; j < basic_block->size(); j++)
+         (*basic_block)[j]->~Instruction();
+      basic_block->~BasicBlock();
+   }
+
+   munmap((void*) m_data, m_size);
+}
+
+bool
+InstructionTraceReader::readRecord(Record& record)
+{
+   if (m_position == m_size)
+      return false;
+
+   record.type = (InstructionTrace::RecordType) readByte();
+   switch (record.type)
+   {
+   case InstructionTrace::BASIC_BLOCK:
+      record.basic_block = readBasicBlock();
+      break;
+
+   case InstructionTrace::MEMORY_ACCESS:
+      {
+         UInt8 op = readByte();
+         record.mem_op_type = (Core::mem_op_t) (op >> 2);
+         record.lock_signal = (Core::lock_signal_t) (op & 0x3);
+         record.address = readAddress(m_last_data_address);
+         record.size = readUnsigned();
+      }
+      break;
+
+   case InstructionTrace::BRANCH:
+      record.taken = readByte();
+      record.address = readAddress(m_last_branch_target);
+      break;
+
+   case InstructionTrace::STRING:
+      record.size = readUnsigned();
+      break;
+
+   case InstructionTrace::SYNC:
+      record.sync_type = (InstructionTrace::SyncType) readByte();
+      record.id = readSigned();
+      record.argument = readSigned();
+      break;
+
+   case InstructionTrace::THREAD_SPAWN:
+      record.tile_id = readSigned();
+      record.id = readSigned();
+      break;
+
+   case InstructionTrace::THREAD_JOIN:
+      record.id = readSigned();
+      break;
+
+   case InstructionTrace::THREAD_EXIT:
+      break;
+
+   default:
+      LOG_PRINT_ERROR("Unrecognized record type(%u) in instruction trace(%s)", record.type, m_filename.c_str());
+      return false;
+   }
+
+   return true;
+}
+
+BasicBlock*
+InstructionTraceReader::readBasicBlock()
+{
+   UInt32 index = readUnsigned();
+   if (index < m_basic_blocks.size())
+      return m_basic_blocks[index];
+
+   LOG_ASSERT_ERROR(index == m_basic_blocks.size(), "Basic block(%u) is used before it is defined in instruction trace(%s)",
+                    index, m_filename.c_str());
+
+   BasicBlock* basic_block = new (m_arena.allocate(sizeof(BasicBlock))) BasicBlock();
+   UInt32 num_instructions = readUnsigned();
+   basic_block->reserve(num_instructions);
+   for (UInt32 i = 0; i < num_instructions; i++)
+      basic_block->push_back(readInstruction());
+
+   if (m_summarize_basic_blocks)
+      basic_block->summarize();
+
+   m_basic_blocks.push_back(basic_block);
+   return basic_block;
+}
+
+Instruction*
+InstructionTraceReader::readInstruction()
+{
+   InstructionType type = (InstructionType) readByte();
+   UInt64 opcode = readUnsigned();
+   IntPtr address = readAddress(m_last_code_address);
+   UInt32 size = readUnsigned();
+
+   OperandList operands;
+   UInt32 num_operands = readUnsigned();
+   for (UInt32 i = 0; i < num_operands; i++)
+   {
+      UInt8 operand = readByte();
+      Operand::Value value = readUnsigned();
+      operands.push_back(Operand((Operand::Type) (operand >> 1), value, (Operand::Direction) (operand & 0x1)));
+   }
+
+   Instruction* instruction;
+   switch (type)
+   {
+   case INST_BRANCH:
+      instruction = new (m_arena.allocate(sizeof(BranchInstruction))) BranchInstruction(opcode, operands);
+      break;
+   case INST_JMP:
+      instruction = new (m_arena.allocate(sizeof(JmpInstruction))) JmpInstruction(opcode, operands);
+      break;
+   case INST_ADD:
+   case INST_SUB:
+   case INST_MUL:
+   case INST_DIV:
+   case INST_FADD:
+   case INST_FSUB:
+   case INST_FMUL:
+   case INST_FDIV:
+      instruction = new (m_arena.allocate(sizeof(ArithInstruction))) ArithInstruction(type, opcode, operands);
+      break;
+   case INST_GENERIC:
+      instruction = new (m_arena.allocate(sizeof(GenericInstruction))) GenericInstruction(opcode, operands);
+      break;
+   default:
+      if (Instruction::isVectorInstructionType(type))
+      {
+         instruction = new (m_arena.allocate(sizeof(ArithInstruction))) ArithInstruction(type, opcode, operands);
+         break;
+      }
+      LOG_PRINT_ERROR("Unexpected instruction type(%u) in instruction trace(%s)", type, m_filename.c_str());
+      return NULL;
+   }
+
+   instruction->setAddress(address);
+   instruction->setSize(size);
+   return instruction;
+}
+
+UInt8
+InstructionTraceReader::readByte()
+{
+   LOG_ASSERT_ERROR(m_position < m_size, "Instruction trace(%s) is truncated", m_filename.c_str());
+   return m_data[m_position ++];
+}
+
+UInt64
+InstructionTraceReader::readUnsigned()
+{
+   UInt64 value = 0;
+   UInt32 shift = 0;
+   UInt8 byte;
+   do
+   {
+      byte = readByte();
+      value |= ((UInt64) (byte & 0x7f)) << shift;
+      shift += 7;
+   } while (byte & 0x80);
+   return value;
+}
+
+SInt64
+InstructionTraceReader::readSigned()
+{
+   UInt64 value = readUnsigned();
+   return (SInt64) ((value >> 1) ^ (~(value & 1) + 1));
+}
+
+IntPtr
+InstructionTraceReader::readAddress(IntPtr& last_address)
+{
+   last_address += (IntPtr) readSigned();
+   return last_address;
+}
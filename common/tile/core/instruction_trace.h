@@ -0,0 +1,147 @@
+#ifndef INSTRUCTION_TRACE_H
+#define INSTRUCTION_TRACE_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "fixed_types.h"
+#include "basic_block.h"
+#include "instruction_arena.h"
+#include "core.h"
+
+using std::string;
+
+/*
+  Instruction stream trace of a core ([trace_record] enabled = true), with
+  what its core model was given: the basic blocks, the memory accesses,
+  the branch outcomes, and also the synchronization and thread events of its
+  threads. It is replayed through the Carbon API without Pin
+  (tools/trace_replay), the memory accesses going through the memory system
+  again.
+
+  A trace is a header followed by records. A record is a type byte and
+  fields encoded as LEB128 varints, with the addresses stored as zigzag
+  deltas from the previous address of the same kind. A basic block is
+  defined in the trace the first time it is used and is referred to by its
+  index after that. The reader maps the whole file.
+ */
+class InstructionTrace
+{
+public:
+   enum RecordType
+   {
+      BASIC_BLOCK = 0,        // index (and the definition, the first time)
+      MEMORY_ACCESS,          // op type, lock signal, address, size
+      BRANCH,                 // taken, target
+      STRING,                 // num ops
+      SYNC,                   // sync type, id, argument
+      THREAD_SPAWN,           // tile id (INVALID_TILE_ID if any), thread id
+      THREAD_JOIN,            // thread id
+      THREAD_EXIT,
+      NUM_RECORD_TYPES
+   };
+
+   enum SyncType
+   {
+      MUTEX_INIT = 0,
+      MUTEX_LOCK,
+      MUTEX_UNLOCK,
+      COND_INIT,
+      COND_WAIT,              // argument: mutex id
+      COND_SIGNAL,
+      COND_BROADCAST,
+      BARRIER_INIT,           // argument: count
+      BARRIER_WAIT,
+      NUM_SYNC_TYPES
+   };
+
+   static const UInt32 MAGIC = 0x43525447;   // "GTRC"
+   static const UInt32 VERSION = 1;
+
+   static string getFileName(string directory, tile_id_t tile_id);
+};
+
+class InstructionTraceWriter
+{
+public:
+   InstructionTraceWriter(string filename, tile_id_t tile_id);
+   ~InstructionTraceWriter();
+
+   void writeBasicBlock(BasicBlock* basic_block);
+   void writeMemoryAccess(Core::mem_op_t mem_op_type, Core::lock_signal_t lock_signal,
+                          IntPtr address, UInt32 size);
+   void writeBranch(bool taken, IntPtr target);
+   void writeString(UInt32 num_ops);
+   void writeSync(InstructionTrace::SyncType sync_type, SInt32 id, SInt32 argument = 0);
+   void writeThreadSpawn(tile_id_t tile_id, SInt32 thread_id);
+   void writeThreadJoin(SInt32 thread_id);
+   void writeThreadExit();
+
+private:
+   void writeInstruction(Instruction* instruction);
+   void writeByte(UInt8 value);
+   void writeUnsigned(UInt64 value);
+   void writeSigned(SInt64 value);
+   void writeAddress(IntPtr address, IntPtr& last_address);
+
+   FILE* m_file;
+   std::map<BasicBlock*, UInt32> m_basic_block_indices;
+   IntPtr m_last_code_address;
+   IntPtr m_last_data_address;
+   IntPtr m_last_branch_target;
+};
+
+class InstructionTraceReader
+{
+public:
+   struct Record
+   {
+      InstructionTrace::RecordType type;
+      BasicBlock* basic_block;
+      Core::mem_op_t mem_op_type;
+      Core::lock_signal_t lock_signal;
+      IntPtr address;                        // memory access address, branch target
+      UInt32 size;                           // memory access size, string num ops
+      bool taken;
+      InstructionTrace::SyncType sync_type;
+      SInt32 id;                             // sync object/thread id
+      SInt32 argument;
+      tile_id_t tile_id;
+   };
+
+   // The basic blocks are summarized as the Pin frontend does it if
+   // 'summarize_basic_blocks' (core/basic_block_summaries)
+   InstructionTraceReader(string filename, bool summarize_basic_blocks);
+   ~InstructionTraceReader();
+
+   tile_id_t getTileId() const { return m_tile_id; }
+
+   // Returns false at the end of the trace
+   bool readRecord(Record& record);
+
+private:
+   BasicBlock* readBasicBlock();
+   Instruction* readInstruction();
+   UInt8 readByte();
+   UInt64 readUnsigned();
+   SInt64 readSigned();
+   IntPtr readAddress(IntPtr& last_address);
+
+   string m_filename;
+   bool m_summarize_basic_blocks;
+   const UInt8* m_data;
+   UInt64 m_size;
+   UInt64 m_position;
+   tile_id_t m_tile_id;
+
+   // The basic blocks and their instructions are in the arena
+   InstructionArena m_arena;
+   std::vector<BasicBlock*> m_basic_blocks;
+   IntPtr m_last_code_address;
+   IntPtr m_last_data_address;
+   IntPtr m_last_branch_target;
+};
+
+#endif
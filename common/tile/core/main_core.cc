@@ -1,3 +1,4 @@
+#include <string.h>
 #include "tile.h"
 #include "core.h"
 #include "main_core.h"
@@ -5,8 +6,15 @@
 #include "memory_manager.h"
 #include "pin_memory_manager.h"
 #include "core_model.h"
+#include "instruction_trace.h"
 #include "sync_client.h"
 #include "simulator.h"
+#include "event_tracer.h"
+#include "sharing_detector.h"
+#include "clock_converter.h"
+#include "mmu.h"
+#include "spin_detector.h"
+#include "idle_state_model.h"
 #include "log.h"
 #include "tile_manager.h"
 
@@ -14,10 +22,28 @@ using namespace std;
 
 MainCore::MainCore(Tile* tile)
    : Core(tile, MAIN_CORE_TYPE)
-{}
+{
+   try
+   {
+      m_overlap_line_accesses = Sim()->getCfg()->getBool("core/overlap_line_accesses", false);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read core/overlap_line_accesses from the cfg file");
+   }
+
+   if (MMU::isEnabled() && Config::getSingleton()->isApplicationTile(getId().tile_id))
+      m_mmu = new MMU(this);
+   m_spin_detector = SpinDetector::create(getId().tile_id);
+   m_idle_state_model = IdleStateModel::create(getId().tile_id);
+}
 
 MainCore::~MainCore()
-{}
+{
+   delete m_idle_state_model;
+   delete m_spin_detector;
+   delete m_mmu;
+}
 
 // accessMemory(lock_signal_t lock_signal, mem_op_t mem_op_type, IntPtr address, char* data_buffer, UInt32 data_size, bool push_info)
 //
@@ -35,9 +61,34 @@ MainCore::~MainCore()
 pair<UInt32, UInt64>
 MainCore::accessMemory(lock_signal_t lock_signal, mem_op_t mem_op_type, IntPtr address, char* data_buffer, UInt32 data_size, bool push_info)
 {
+   if (isHostStackAccess(address, data_size))
+      return accessHostStack(lock_signal, mem_op_type, address, data_buffer, data_size, push_info);
+
    return initiateMemoryAccess(MemComponent::L1_DCACHE, lock_signal, mem_op_type, address, (Byte*) data_buffer, data_size, push_info);
 }
 
+// The data of the stacks is in host memory (stack/direct_host_access), the
+// copy of the lines in the caches is stale and only the timing is used
+pair<UInt32, UInt64>
+MainCore::accessHostStack(lock_signal_t lock_signal, mem_op_t mem_op_type, IntPtr address, char* data_buffer, UInt32 data_size, bool push_info)
+{
+   if (mem_op_type == WRITE)
+   {
+      // The instructions write the stack in place, then the buffer is the stack itself.
+      // With UNLOCK, the data must be in place before the line is released
+      if (data_buffer != (char*) address)
+         memcpy((void*) address, data_buffer, data_size);
+      return initiateMemoryAccess(MemComponent::L1_DCACHE, lock_signal, mem_op_type, address, (Byte*) data_buffer, data_size, push_info);
+   }
+
+   LOG_ASSERT_ERROR(data_buffer != (char*) address, "Stack read(%#lx) into the stack itself", address);
+
+   // With LOCK, the host data is read once the line is held
+   pair<UInt32, UInt64> ret = initiateMemoryAccess(MemComponent::L1_DCACHE, lock_signal, mem_op_type, address, (Byte*) data_buffer, data_size, push_info);
+   memcpy(data_buffer, (void*) address, data_size);
+   return ret;
+}
+
 UInt64
 MainCore::readInstructionMemory(IntPtr address, UInt32 instruction_size)
 {
@@ -58,6 +109,14 @@ MainCore::initiateMemoryAccess(MemComponent::Type mem_component,
 {
    LOG_ASSERT_ERROR(Config::getSingleton()->isSimulatingSharedMemory(), "Shared Memory Disabled");
 
+   // The memory system serves one access of the core at a time, wait for the
+   // instruction fetches of the timing thread (if any)
+   m_core_model->synchronize();
+
+   // The accesses the core model is given are recorded (trace_record/enabled)
+   if (push_info && m_core_model->isEnabled() && m_core_model->getTraceWriter())
+      m_core_model->getTraceWriter()->writeMemoryAccess(mem_op_type, lock_signal, address, data_size);
+
    if (data_size == 0)
    {
       if (push_info)
@@ -68,14 +127,31 @@ MainCore::initiateMemoryAccess(MemComponent::Type mem_component,
       return make_pair<UInt32, UInt64>(0,0);
    }
 
+   // The accesses of each hardware thread are timed on its own cycle count
+   if (Sim()->getTileManager()->amiAppThread())
+      getShmemPerfModel()->setCurrentThread(Sim()->getTileManager()->getCurrentThreadIndex());
+
    // Setting the initial time
    UInt64 initial_time = (time == 0) ? getPerformanceModel()->getCycleCount() : time;
    UInt64 curr_time = initial_time;
 
+   // The pages are translated first, the page table accesses of a walk are not
+   if (m_mmu && !m_mmu->isWalking())
+      curr_time += m_mmu->translate(address, data_size, mem_component == MemComponent::L1_ICACHE, curr_time);
+
    LOG_PRINT("Time(%llu), %s - ADDR(%#lx), data_size(%u), START",
              initial_time, ((mem_op_type == READ) ? "READ" : "WRITE"), address, data_size);
 
    UInt32 num_misses = 0;
+   EventTracer* event_tracer = Sim()->getEventTracer();
+   bool trace_misses = event_tracer && event_tracer->isEnabled(EventTracer::CACHE);
+   // The level of the misses of the program (CPI stack and stall profile)
+   bool classify_misses = push_info;
+   UInt32 num_l2_misses = 0;
+   UInt8 miss_type = Cache::INVALID_MISS_TYPE;
+   // The data accesses of the program
+   SharingDetector* sharing_detector = (push_info && (mem_component == MemComponent::L1_DCACHE)) ?
+                                       Sim()->getSharingDetector() : NULL;
    UInt32 cache_line_size = getMemoryManager()->getCacheLineSize();
 
    IntPtr begin_addr = address;
@@ -84,6 +160,14 @@ MainCore::initiateMemoryAccess(MemComponent::Type mem_component,
    IntPtr end_addr_aligned = end_addr - (end_addr % cache_line_size);
    Byte *curr_data_buffer_head = (Byte*) data_buf;
 
+   // The lines of a plain access that spans several are issued together
+   // (string and vector instructions)
+   bool overlapped = m_overlap_line_accesses && (lock_signal == Core::NONE) &&
+                     ((end_addr - 1) / cache_line_size != begin_addr / cache_line_size);
+   vector<MemoryManager::LineAccess> lines;
+   if (overlapped)
+      lines.reserve((end_addr_aligned - begin_addr_aligned) / cache_line_size + 1);
+
    for (IntPtr curr_addr_aligned = begin_addr_aligned; curr_addr_aligned <= end_addr_aligned; curr_addr_aligned += cache_line_size)
    {
       // Access the cache one line at a time
@@ -114,10 +198,39 @@ MainCore::initiateMemoryAccess(MemComponent::Type mem_component,
          curr_size = cache_line_size - (curr_offset);
       }
 
+      if (m_spin_detector && push_info && (mem_component == MemComponent::L1_DCACHE))
+         m_spin_detector->addMemoryAccess(curr_addr_aligned, mem_op_type != Core::READ);
+
+      if (sharing_detector)
+      {
+         sharing_detector->recordAccess(getId().tile_id, curr_addr_aligned, cache_line_size, curr_offset, curr_size,
+                                        mem_op_type == Core::WRITE, getInstructionAddress());
+      }
+
+      if (overlapped)
+      {
+         MemoryManager::LineAccess line;
+         line.address = curr_addr_aligned;
+         line.offset = curr_offset;
+         line.data_buf = curr_data_buffer_head;
+         line.data_length = curr_size;
+         lines.push_back(line);
+         curr_data_buffer_head += curr_size;
+         continue;
+      }
+
       LOG_PRINT("Start coreInitiateMemoryAccess: ADDR(%#lx), offset(%u), curr_size(%u), core_id(%i, %i)",
                 curr_addr_aligned, curr_offset, curr_size, getId().tile_id, getId().core_type);
 
-      if (!getMemoryManager()->coreInitiateMemoryAccess(mem_component, lock_signal, mem_op_type, 
+      UInt64 line_start_time = curr_time;
+
+      // Plain reads that hit in the L1 cache may not need the memory manager
+      bool l1_hit = (lock_signal == Core::NONE) && (mem_op_type == Core::READ) &&
+                    getMemoryManager()->coreProbeL1Hit(mem_component, curr_addr_aligned, curr_offset,
+                                                       curr_data_buffer_head, curr_size, curr_time);
+
+      if (!l1_hit &&
+          !getMemoryManager()->coreInitiateMemoryAccess(mem_component, lock_signal, mem_op_type, 
                                                         curr_addr_aligned, curr_offset, 
                                                         curr_data_buffer_head, curr_size,
                                                         curr_time, push_info))
@@ -129,6 +242,10 @@ MainCore::initiateMemoryAccess(MemComponent::Type mem_component,
          // 'initiateSharedMemReq' reads the data 
          // from curr_data_buffer_head
          num_misses ++;
+         if (classify_misses)
+            classifyMiss(mem_component, num_l2_misses, miss_type);
+         if (trace_misses)
+            traceMiss(mem_component, curr_addr_aligned, line_start_time, curr_time);
       }
 
       LOG_PRINT("End InitiateSharedMemReq: ADDR(%#lx), offset(%u), curr_size(%u), core_id(%i,%i)",
@@ -138,6 +255,16 @@ MainCore::initiateMemoryAccess(MemComponent::Type mem_component,
       curr_data_buffer_head += curr_size;
    }
 
+   if (overlapped)
+   {
+      num_misses = getMemoryManager()->coreInitiateMemoryAccesses(mem_component, mem_op_type,
+                                                                  &lines[0], lines.size(),
+                                                                  curr_time, push_info);
+      // The misses of the lines overlap, one span for the access
+      if (trace_misses && (num_misses > 0))
+         traceMiss(mem_component, begin_addr_aligned, initial_time, curr_time);
+   }
+
    // Get the final cycle time
    UInt64 final_time = curr_time;
    LOG_ASSERT_ERROR(final_time >= initial_time, "final_time(%llu) < initial_time(%llu)", final_time, initial_time);
@@ -152,9 +279,107 @@ MainCore::initiateMemoryAccess(MemComponent::Type mem_component,
    
    if (push_info)
    {
-      DynamicInstructionInfo info = DynamicInstructionInfo::createMemoryInfo(memory_access_latency, address, (mem_op_type == WRITE) ? Operand::WRITE : Operand::READ, num_misses);
+      DynamicInstructionInfo info = DynamicInstructionInfo::createMemoryInfo(memory_access_latency, address, (mem_op_type == WRITE) ? Operand::WRITE : Operand::READ, num_misses,
+                                                                             num_l2_misses, miss_type, lock_signal != Core::NONE);
       m_core_model->pushDynamicInstructionInfo(info);
    }
 
    return make_pair<UInt32, UInt64>(num_misses, memory_access_latency);
 }
+
+pair<UInt32, UInt64>
+MainCore::initiateBlockTransfer(mem_op_t mem_op_type, IntPtr address, UInt64 size,
+                                UInt32 max_lines_in_flight, UInt64 time)
+{
+   LOG_ASSERT_ERROR(Config::getSingleton()->isSimulatingSharedMemory(), "Shared Memory Disabled");
+
+   m_core_model->synchronize();
+
+   if (size == 0)
+      return make_pair<UInt32, UInt64>(0,0);
+
+   if (Sim()->getTileManager()->amiAppThread())
+      getShmemPerfModel()->setCurrentThread(Sim()->getTileManager()->getCurrentThreadIndex());
+
+   UInt64 initial_time = (time == 0) ? getPerformanceModel()->getCycleCount() : time;
+   UInt64 curr_time = initial_time;
+
+   LOG_PRINT("Time(%llu), block %s - ADDR(%#lx), size(%llu), START",
+             initial_time, ((mem_op_type == READ) ? "READ" : "WRITE"), address, size);
+
+   UInt32 cache_line_size = getMemoryManager()->getCacheLineSize();
+   // Every line reads into (or writes from) the same buffer
+   Byte line_buf[cache_line_size];
+   vector<MemoryManager::LineAccess> lines;
+   lines.reserve(BLOCK_TRANSFER_CHUNK_SIZE / cache_line_size + 1);
+
+   UInt32 num_misses = 0;
+   IntPtr end_addr = address + size;
+   for (IntPtr chunk_addr = address; chunk_addr < end_addr; chunk_addr += BLOCK_TRANSFER_CHUNK_SIZE)
+   {
+      IntPtr chunk_end_addr = min<IntPtr>(end_addr, chunk_addr + BLOCK_TRANSFER_CHUNK_SIZE);
+
+      if (m_mmu && !m_mmu->isWalking())
+         curr_time += m_mmu->translate(chunk_addr, chunk_end_addr - chunk_addr, false, curr_time);
+
+      lines.clear();
+      IntPtr curr_addr = chunk_addr;
+      while (curr_addr < chunk_end_addr)
+      {
+         MemoryManager::LineAccess line;
+         line.offset = curr_addr % cache_line_size;
+         line.address = curr_addr - line.offset;
+         line.data_buf = line_buf;
+         line.data_length = min<IntPtr>(cache_line_size - line.offset, chunk_end_addr - curr_addr);
+         lines.push_back(line);
+         curr_addr += line.data_length;
+      }
+
+      num_misses += getMemoryManager()->coreInitiateMemoryAccesses(MemComponent::L1_DCACHE, mem_op_type,
+                                                                   &lines[0], lines.size(),
+                                                                   curr_time, true, max_lines_in_flight);
+   }
+
+   LOG_PRINT("Time(%llu), block %s - ADDR(%#lx), size(%llu), END",
+             curr_time, ((mem_op_type == READ) ? "READ" : "WRITE"), address, size);
+
+   UInt64 memory_access_latency = curr_time - initial_time;
+   getShmemPerfModel()->incrTotalMemoryAccessLatency(memory_access_latency);
+
+   return make_pair<UInt32, UInt64>(num_misses, memory_access_latency);
+}
+
+void
+MainCore::traceMiss(MemComponent::Type mem_component, IntPtr address, UInt64 issue_time, UInt64 fill_time)
+{
+   float frequency = getPerformanceModel()->getFrequency();
+   Sim()->getEventTracer()->record(EventTracer::CACHE,
+                                   (mem_component == MemComponent::L1_ICACHE) ? "L1-I miss" : "L1-D miss",
+                                   getId().tile_id,
+                                   convertCycleCount(issue_time, frequency, 1.0),
+                                   convertCycleCount(fill_time, frequency, 1.0),
+                                   address);
+}
+
+void
+MainCore::classifyMiss(MemComponent::Type mem_component, UInt32& num_l2_misses, UInt8& miss_type)
+{
+   MemoryManager* memory_manager = getMemoryManager();
+   Cache* l1_cache = (mem_component == MemComponent::L1_ICACHE) ? memory_manager->getL1ICache() : memory_manager->getL1DCache();
+   Cache::MissType type = l1_cache->getLastMissType();
+
+   // The misses of the L1 go through the L2 of the tile, unless the L2 is a
+   // slice of a shared L2 (accessed by the sim thread for any tile)
+   if (MemoryManager::getCachingProtocolType() != PR_L1_SH_L2_MSI)
+   {
+      Cache* l2_cache = memory_manager->getL2Cache();
+      if (l2_cache->lastAccessMissed())
+      {
+         num_l2_misses ++;
+         type = l2_cache->getLastMissType();
+      }
+   }
+
+   if (type < Cache::NUM_MISS_TYPES)
+      miss_type = type;
+}
@@ -20,6 +20,23 @@ public:
                                              Byte* data_buf, UInt32 data_size,
                                              bool push_info = false,
                                              UInt64 time = 0);
+   pair<UInt32, UInt64> initiateBlockTransfer(mem_op_t mem_op_type, IntPtr address, UInt64 size,
+                                              UInt32 max_lines_in_flight, UInt64 time = 0);
+
+private:
+   // Bytes of a block transfer whose pages are translated and lines issued
+   // together (the lines in flight drain between two chunks)
+   static const UInt32 BLOCK_TRANSFER_CHUNK_SIZE = 65536;
+
+   // core/overlap_line_accesses
+   bool m_overlap_line_accesses;
+
+   pair<UInt32, UInt64> accessHostStack(lock_signal_t lock_signal, mem_op_t mem_op_type, IntPtr address,
+                                        char* data_buffer, UInt32 data_size, bool push_info);
+   // Span of a miss in the event trace (times in core cycles)
+   void traceMiss(MemComponent::Type mem_component, IntPtr address, UInt64 issue_time, UInt64 fill_time);
+   // Where the line that just missed in the L1 was found, for the stall profile
+   void classifyMiss(MemComponent::Type mem_component, UInt32& num_l2_misses, UInt8& miss_type);
 };
 
 #endif
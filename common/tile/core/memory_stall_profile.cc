@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <algorithm>
+
+#include "memory_stall_profile.h"
+#include "log.h"
+
+using namespace std;
+
+const IntPtr MemoryStallProfile::EMPTY;
+const UInt32 MemoryStallProfile::INITIAL_SIZE;
+
+MemoryStallProfile::MemoryStallProfile()
+   : m_entries(INITIAL_SIZE)
+   , m_num_entries(0)
+{
+   for (UInt32 i = 0; i < m_entries.size(); i++)
+      clear(m_entries[i], EMPTY);
+   clear(m_pending, EMPTY);
+}
+
+MemoryStallProfile::~MemoryStallProfile()
+{}
+
+void
+MemoryStallProfile::clear(Entry& entry, IntPtr address)
+{
+   entry.address = address;
+   entry.count = 0;
+   entry.stall_cycles = 0;
+   entry.l1_misses = 0;
+   entry.l2_misses = 0;
+   for (UInt32 i = 0; i < NUM_MISS_TYPES; i++)
+      entry.miss_types[i] = 0;
+}
+
+static inline UInt32 hashAddress(IntPtr address)
+{
+   // Instruction addresses are close to each other, mix the bits
+   UInt64 h = (UInt64) address * 0x9e3779b97f4a7c15ULL;
+   return (UInt32) (h >> 32);
+}
+
+MemoryStallProfile::Entry*
+MemoryStallProfile::lookup(IntPtr address)
+{
+   UInt32 mask = m_entries.size() - 1;
+   for (UInt32 i = hashAddress(address) & mask; ; i = (i + 1) & mask)
+   {
+      Entry& entry = m_entries[i];
+      if (entry.address == address)
+         return &entry;
+      if (entry.address == EMPTY)
+      {
+         entry.address = address;
+         m_num_entries ++;
+         return &entry;
+      }
+   }
+}
+
+void
+MemoryStallProfile::grow()
+{
+   vector<Entry> old_entries(m_entries.size() * 2);
+   old_entries.swap(m_entries);
+   for (UInt32 i = 0; i < m_entries.size(); i++)
+      clear(m_entries[i], EMPTY);
+
+   m_num_entries = 0;
+   for (UInt32 i = 0; i < old_entries.size(); i++)
+   {
+      if (old_entries[i].address != EMPTY)
+         *lookup(old_entries[i].address) = old_entries[i];
+   }
+}
+
+void
+MemoryStallProfile::add(IntPtr address, UInt64 memory_stall_cycles)
+{
+   LOG_ASSERT_ERROR(address != EMPTY, "Invalid instruction address(%#lx)", address);
+
+   if (4 * (m_num_entries + 1) > 3 * m_entries.size())
+      grow();
+
+   Entry* entry = lookup(address);
+   entry->count ++;
+   entry->stall_cycles += memory_stall_cycles;
+   entry->l1_misses += m_pending.l1_misses;
+   entry->l2_misses += m_pending.l2_misses;
+   for (UInt32 i = 0; i < NUM_MISS_TYPES; i++)
+      entry->miss_types[i] += m_pending.miss_types[i];
+
+   clear(m_pending, EMPTY);
+}
+
+static bool compareStallCycles(const pair<UInt64, UInt32>& a, const pair<UInt64, UInt32>& b)
+{
+   return a.first > b.first;
+}
+
+void
+MemoryStallProfile::write(const string& filename) const
+{
+   vector<pair<UInt64, UInt32> > order;
+   order.reserve(m_num_entries);
+   for (UInt32 i = 0; i < m_entries.size(); i++)
+   {
+      if (m_entries[i].address != EMPTY)
+         order.push_back(make_pair(m_entries[i].stall_cycles, i));
+   }
+   sort(order.begin(), order.end(), compareStallCycles);
+
+   FILE* file = fopen(filename.c_str(), "w");
+   LOG_ASSERT_ERROR(file, "Could not open stall profile(%s)", filename.c_str());
+
+   fprintf(file, "# address count stall_cycles l1_misses l2_misses cold capacity sharing\n");
+   for (UInt32 i = 0; i < order.size(); i++)
+   {
+      const Entry& entry = m_entries[order[i].second];
+      fprintf(file, "%#llx %llu %llu %llu %llu %llu %llu %llu\n",
+              (unsigned long long) entry.address, (unsigned long long) entry.count,
+              (unsigned long long) entry.stall_cycles, (unsigned long long) entry.l1_misses,
+              (unsigned long long) entry.l2_misses, (unsigned long long) entry.miss_types[COLD_MISS],
+              (unsigned long long) entry.miss_types[CAPACITY_MISS],
+              (unsigned long long) entry.miss_types[SHARING_MISS]);
+   }
+   fclose(file);
+}
@@ -0,0 +1,82 @@
+#ifndef MEMORY_STALL_PROFILE_H
+#define MEMORY_STALL_PROFILE_H
+
+#include <string>
+#include <vector>
+
+#include "fixed_types.h"
+#include "dynamic_instruction_info.h"
+
+/*
+  Memory stall cycles and misses of a core by instruction address
+  (core/stall_profile). The core model adds the memory info of an
+  instruction as it consumes it, then the stall cycles of the instruction
+  once it is modeled: the instructions that neither stalled nor missed are
+  not looked up. The entries are in an open-addressed table (linear
+  probing) that doubles when it is 3/4 full.
+
+  Written as a flat profile, one line per address by decreasing stall
+  cycles, to be mapped to symbols (e.g. addr2line -f -e <binary>):
+     address count stall_cycles l1_misses l2_misses cold capacity sharing
+
+  Only used by the thread that models the instructions of the core.
+ */
+class MemoryStallProfile
+{
+public:
+   // Cache::MissType, in the same order
+   enum MissType
+   {
+      COLD_MISS = 0,
+      CAPACITY_MISS,
+      SHARING_MISS,
+      NUM_MISS_TYPES
+   };
+
+   MemoryStallProfile();
+   ~MemoryStallProfile();
+
+   // Memory info of the instruction being modeled
+   void addMemoryInfo(const DynamicInstructionInfo& info)
+   {
+      m_pending.l1_misses += info.memory_info.num_misses;
+      m_pending.l2_misses += info.memory_info.num_l2_misses;
+      if (info.memory_info.miss_type < NUM_MISS_TYPES)
+         m_pending.miss_types[info.memory_info.miss_type] ++;
+   }
+   // The instruction at 'address' is modeled
+   void update(IntPtr address, UInt64 memory_stall_cycles)
+   {
+      if ((memory_stall_cycles == 0) && (m_pending.l1_misses == 0))
+         return;
+      add(address, memory_stall_cycles);
+   }
+
+   UInt32 getNumAddresses() const { return m_num_entries; }
+   void write(const std::string& filename) const;
+
+private:
+   struct Entry
+   {
+      IntPtr address;
+      UInt64 count;
+      UInt64 stall_cycles;
+      UInt64 l1_misses;
+      UInt64 l2_misses;
+      UInt64 miss_types[NUM_MISS_TYPES];
+   };
+
+   static const IntPtr EMPTY = ~((IntPtr) 0);
+   static const UInt32 INITIAL_SIZE = 1024;
+
+   void add(IntPtr address, UInt64 memory_stall_cycles);
+   Entry* lookup(IntPtr address);
+   void grow();
+   static void clear(Entry& entry, IntPtr address);
+
+   std::vector<Entry> m_entries;
+   UInt32 m_num_entries;
+   Entry m_pending;
+};
+
+#endif // MEMORY_STALL_PROFILE_H
@@ -0,0 +1,232 @@
+#include "core.h"
+#include "interval_core_model.h"
+
+#include "log.h"
+#include "dynamic_instruction_info.h"
+#include "config.hpp"
+#include "simulator.h"
+#include "checkpoint.h"
+
+using std::endl;
+
+IntervalCoreModel::IntervalCoreModel(Core *core, float frequency)
+   : CoreModel(core, frequency)
+   , m_dispatch_width(1)
+   , m_num_rob_entries(1)
+   , m_num_dispatched_in_cycle(0)
+   , m_miss_window_end(0)
+   , m_miss_window_latency(0)
+{
+   try
+   {
+      m_dispatch_width = Sim()->getCfg()->getInt("core/interval/dispatch_width", 4);
+      m_num_rob_entries = Sim()->getCfg()->getInt("core/interval/num_rob_entries", 128);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read [core/interval] parameters from the cfg file");
+   }
+   LOG_ASSERT_ERROR(m_dispatch_width > 0, "Dispatch width must be > 0");
+
+   initializePipelineStallCounters();
+}
+
+IntervalCoreModel::~IntervalCoreModel()
+{}
+
+void IntervalCoreModel::initializePipelineStallCounters()
+{
+   m_total_l1icache_stall_cycles = 0;
+   m_total_branch_mispredict_stall_cycles = 0;
+   m_total_l1dcache_read_stall_cycles = 0;
+   m_total_overlapped_load_misses = 0;
+}
+
+void IntervalCoreModel::outputSummary(std::ostream &os)
+{
+   CoreModel::outputSummary(os);
+
+   os << "    Total L1-I Cache Stall Time (in ns): " << (UInt64) ((double) m_total_l1icache_stall_cycles / m_frequency) << endl;
+   os << "    Total Branch Misprediction Stall Time (in ns): " << (UInt64) ((double) m_total_branch_mispredict_stall_cycles / m_frequency) << endl;
+   os << "    Total L1-D Cache Read Stall Time (in ns): " << (UInt64) ((double) m_total_l1dcache_read_stall_cycles / m_frequency) << endl;
+   os << "    Total Overlapped Load Misses: " << m_total_overlapped_load_misses << endl;
+}
+
+void IntervalCoreModel::saveState(CheckpointWriter& writer)
+{
+   CoreModel::saveState(writer);
+   writer.beginSection("Interval Core Model");
+   writer << m_total_l1icache_stall_cycles << m_total_branch_mispredict_stall_cycles
+          << m_total_l1dcache_read_stall_cycles << m_total_overlapped_load_misses;
+}
+
+void IntervalCoreModel::restoreState(CheckpointReader& reader)
+{
+   CoreModel::restoreState(reader);
+   reader.beginSection("Interval Core Model");
+   reader >> m_total_l1icache_stall_cycles >> m_total_branch_mispredict_stall_cycles
+          >> m_total_l1dcache_read_stall_cycles >> m_total_overlapped_load_misses;
+}
+
+void IntervalCoreModel::updateInternalVariablesOnFrequencyChange(volatile float frequency)
+{
+   volatile float old_frequency = m_frequency;
+   volatile float new_frequency = frequency;
+
+   // Update Pipeline stall counters due to memory
+   m_total_l1icache_stall_cycles = (UInt64) (((double) m_total_l1icache_stall_cycles / old_frequency) * new_frequency);
+   m_total_branch_mispredict_stall_cycles = (UInt64) (((double) m_total_branch_mispredict_stall_cycles / old_frequency) * new_frequency);
+   m_total_l1dcache_read_stall_cycles = (UInt64) (((double) m_total_l1dcache_read_stall_cycles / old_frequency) * new_frequency);
+
+   CoreModel::updateInternalVariablesOnFrequencyChange(frequency);
+}
+
+void IntervalCoreModel::handleInstruction(Instruction *instruction)
+{
+   // Execute this first so that instructions have the opportunity to
+   // abort further processing (via AbortInstructionException)
+   UInt64 cost = instruction->getCost();
+
+   if (instruction->isDynamic())
+   {
+      m_cycle_count += cost;
+      m_instruction_count++;
+      updatePipelineStallCounters(instruction, 0, 0);
+      return;
+   }
+
+   UInt64 icache_stall_cycles = modelFetch(instruction);
+   UInt64 memory_stall_cycles = icache_stall_cycles;
+   UInt64 execution_unit_stall_cycles = 0;
+
+   const OperandList &ops = instruction->getOperands();
+   for (unsigned int i = 0; i < ops.size(); i++)
+   {
+      const Operand &o = ops[i];
+
+      if (o.m_type == Operand::MEMORY)
+      {
+         DynamicInstructionInfo &info = getDynamicInstructionInfo();
+
+         LOG_ASSERT_ERROR(info.type == ((o.m_direction == Operand::READ) ?
+                                        DynamicInstructionInfo::MEMORY_READ : DynamicInstructionInfo::MEMORY_WRITE),
+                          "Expected memory %s info, got: %d.",
+                          (o.m_direction == Operand::READ) ? "read" : "write", info.type);
+
+         memory_stall_cycles += modelMemoryAccess(info);
+         popDynamicInstructionInfo();
+      }
+   }
+
+   // The branch predictor gives the full cost of a misprediction
+   if ((instruction->getType() == INST_BRANCH) && (cost > 1))
+   {
+      execution_unit_stall_cycles += cost;
+      m_total_branch_mispredict_stall_cycles += cost;
+   }
+
+   m_cycle_count += (modelDispatch(1) + memory_stall_cycles + execution_unit_stall_cycles);
+   m_instruction_count++;
+
+   updatePipelineStallCounters(instruction, memory_stall_cycles, execution_unit_stall_cycles, icache_stall_cycles);
+}
+
+bool IntervalCoreModel::handleBasicBlockSummary(BasicBlock *basic_block)
+{
+   const BasicBlock::Summary& summary = basic_block->getSummary();
+   if (!summary.valid)
+      return false;
+
+   UInt32 num_infos = summary.num_memory_operands + (summary.ends_with_branch ? 1 : 0);
+   if (getNumDynamicInstructionInfos() < num_infos)
+      return false;
+
+   UInt64 memory_stall_cycles = 0;
+   UInt64 execution_unit_stall_cycles = 0;
+
+   UInt64 icache_stall_cycles = 0;
+   for (unsigned int i = 0; i < basic_block->size(); i++)
+      icache_stall_cycles += modelFetch(basic_block->at(i));
+   memory_stall_cycles += icache_stall_cycles;
+
+   for (unsigned int i = 0; i < summary.num_memory_operands; i++)
+   {
+      DynamicInstructionInfo &info = getDynamicInstructionInfo();
+      LOG_ASSERT_ERROR((info.type == DynamicInstructionInfo::MEMORY_READ) || (info.type == DynamicInstructionInfo::MEMORY_WRITE),
+                       "Expected memory info, got: %d.", info.type);
+
+      memory_stall_cycles += modelMemoryAccess(info);
+      popDynamicInstructionInfo();
+   }
+
+   if (summary.ends_with_branch)
+   {
+      UInt64 cost = basic_block->back()->getCost();
+      if (cost > 1)
+      {
+         execution_unit_stall_cycles += cost;
+         m_total_branch_mispredict_stall_cycles += cost;
+      }
+   }
+
+   m_cycle_count += (modelDispatch(basic_block->size()) + memory_stall_cycles + execution_unit_stall_cycles);
+   m_instruction_count += basic_block->size();
+
+   updatePipelineStallCounters(memory_stall_cycles, execution_unit_stall_cycles, icache_stall_cycles);
+   updateMemoryStallProfile(basic_block->front()->getAddress(), memory_stall_cycles);
+
+   return true;
+}
+
+UInt64 IntervalCoreModel::modelFetch(Instruction *instruction)
+{
+   // A hit in the L1-I cache is hidden by the front end
+   UInt64 instruction_memory_access_latency = modelICache(instruction->getAddress(), instruction->getSize());
+   UInt64 stall_cycles = (instruction_memory_access_latency > 1) ? (instruction_memory_access_latency - 1) : 0;
+
+   m_total_l1icache_stall_cycles += stall_cycles;
+   return stall_cycles;
+}
+
+UInt64 IntervalCoreModel::modelMemoryAccess(const DynamicInstructionInfo &info)
+{
+   // Stores retire from the store buffer, and the loads that hit are
+   // hidden by the out-of-order window
+   if ((info.type != DynamicInstructionInfo::MEMORY_READ) || (info.memory_info.num_misses == 0))
+      return 0;
+
+   UInt64 latency = info.memory_info.latency;
+   UInt64 stall_cycles;
+
+   if (m_instruction_count < m_miss_window_end)
+   {
+      // Issued while the previous miss was outstanding
+      stall_cycles = (latency > m_miss_window_latency) ? (latency - m_miss_window_latency) : 0;
+      if (latency > m_miss_window_latency)
+         m_miss_window_latency = latency;
+      m_total_overlapped_load_misses ++;
+   }
+   else
+   {
+      stall_cycles = latency;
+      m_miss_window_end = m_instruction_count + m_num_rob_entries;
+      m_miss_window_latency = latency;
+   }
+
+   m_total_l1dcache_read_stall_cycles += stall_cycles;
+   return stall_cycles;
+}
+
+UInt64 IntervalCoreModel::modelDispatch(UInt32 num_instructions)
+{
+   // 'dispatch_width' instructions per cycle
+   m_num_dispatched_in_cycle += num_instructions;
+   UInt64 cycles = m_num_dispatched_in_cycle / m_dispatch_width;
+   m_num_dispatched_in_cycle %= m_dispatch_width;
+   return cycles;
+}
+
+UInt64 IntervalCoreModel::modelICache(IntPtr ins_address, UInt32 ins_size)
+{
+   return getCore()->readInstructionMemory(ins_address, ins_size);
+}
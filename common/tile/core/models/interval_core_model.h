@@ -0,0 +1,53 @@
+#ifndef INTERVAL_CORE_MODEL_H
+#define INTERVAL_CORE_MODEL_H
+
+#include "core_model.h"
+/*
+  Interval core model.
+  The core runs at a fixed IPC ('dispatch_width') between miss events, and
+  only the events add cycles: L1-I misses and branch mispredictions stall
+  the front end, and a load that misses in the L1-D cache stalls the core
+  for its latency once the ROB fills up behind it. The loads that miss within
+  'num_rob_entries' instructions of it overlap with it. The static costs of
+  the instructions are folded into the base IPC.
+ */
+class IntervalCoreModel : public CoreModel
+{
+public:
+   IntervalCoreModel(Core* core, float frequency);
+   ~IntervalCoreModel();
+
+   void updateInternalVariablesOnFrequencyChange(volatile float frequency);
+   void outputSummary(std::ostream &os);
+   void saveState(CheckpointWriter& writer);
+   void restoreState(CheckpointReader& reader);
+
+private:
+   void handleInstruction(Instruction *instruction);
+   bool handleBasicBlockSummary(BasicBlock *basic_block);
+
+   UInt64 modelICache(IntPtr ins_address, UInt32 ins_size);
+   UInt64 modelFetch(Instruction *instruction);
+   UInt64 modelMemoryAccess(const DynamicInstructionInfo &info);
+   UInt64 modelDispatch(UInt32 num_instructions);
+
+   void initializePipelineStallCounters();
+
+   UInt32 m_dispatch_width;
+   UInt32 m_num_rob_entries;
+
+   // Instructions dispatched in the current cycle
+   UInt32 m_num_dispatched_in_cycle;
+
+   // The last long-latency load that was not hidden behind another one
+   UInt64 m_miss_window_end;
+   UInt64 m_miss_window_latency;
+
+   // Pipeline Stall Counters
+   UInt64 m_total_l1icache_stall_cycles;
+   UInt64 m_total_branch_mispredict_stall_cycles;
+   UInt64 m_total_l1dcache_read_stall_cycles;
+   UInt64 m_total_overlapped_load_misses;
+};
+
+#endif // INTERVAL_CORE_MODEL_H
@@ -1,3 +1,4 @@
+#include <algorithm>
 using namespace std;
 
 #include "core.h"
@@ -8,39 +9,70 @@ using namespace std;
 #include "config.hpp"
 #include "simulator.h"
 #include "branch_predictor.h"
+#include "memory_manager.h"
+#include "instruction_prefetcher.h"
 
 IOCOOMCoreModel::IOCOOMCoreModel(Core *core, float frequency)
    : CoreModel(core, frequency)
    , m_register_scoreboard(512)
    , m_register_wait_unit_list(512)
+   , m_functional_unit_scoreboard(MAX_INSTRUCTION_COUNT, 0)
+   , m_consistency_model(RELEASE_CONSISTENCY)
    , m_store_buffer(0)
    , m_load_buffer(0)
+   , m_icache_footprint(false)
+   , m_block_resident(false)
+   , m_block_start_line_removals(0)
+   , m_icache_line_size(0)
+   , m_icache_hit_latency(UINT64_MAX_)
+   , m_total_icache_probes_skipped(0)
+   , m_icache_prefetcher(NULL)
 {
    config::Config *cfg = Sim()->getCfg();
 
    try
    {
-      m_store_buffer = new StoreBuffer(cfg->getInt("core/iocoom/num_store_buffer_entries",1));
+      m_consistency_model = parseConsistencyModel(cfg->getString("core/iocoom/consistency_model", "rc"));
+      m_store_buffer = new StoreBuffer(cfg->getInt("core/iocoom/num_store_buffer_entries",1),
+                                       m_consistency_model == TOTAL_STORE_ORDER);
       m_load_buffer = new LoadBuffer(cfg->getInt("core/iocoom/num_outstanding_loads",3));
+      m_icache_footprint = cfg->getBool("core/iocoom/icache_footprint", false);
+      m_icache_prefetcher = InstructionPrefetcher::create(getCore(),
+                               cfg->getString("core/iocoom/icache_prefetcher/type", "none"),
+                               cfg->getInt("core/iocoom/icache_prefetcher/degree", 2),
+                               cfg->getInt("core/iocoom/icache_prefetcher/buffer_size", 16),
+                               cfg->getInt("core/iocoom/icache_prefetcher/lookahead", 2),
+                               cfg->getInt("core/iocoom/icache_prefetcher/table_size", 4096));
    }
    catch (...)
    {
       LOG_PRINT_ERROR("Config info not available.");
    }
+   // The footprint skips the fetches the prefetcher has to see
+   LOG_ASSERT_ERROR(!(m_icache_footprint && m_icache_prefetcher),
+                    "core/iocoom/icache_footprint and core/iocoom/icache_prefetcher can not be used together");
 
    initializeRegisterScoreboard();
    initializeRegisterWaitUnitList();
+
+   if (m_icache_footprint)
+   {
+      ResidentBlock none = { NULL, 0 };
+      m_resident_blocks.resize(NUM_RESIDENT_BLOCKS, none);
+   }
    
    // For Power and AreaModeling
    m_mcpat_core_interface = new McPATCoreInterface(
                             cfg->getInt("core/iocoom/num_outstanding_loads", 3),
                             cfg->getInt("core/iocoom/num_store_buffer_entries", 1));
+   m_mcpat_core_interface->registerEventCounters(getCore()->getTile()->getId());
 
    initializePipelineStallCounters();
 }
 
 IOCOOMCoreModel::~IOCOOMCoreModel()
 {
+   delete m_icache_prefetcher;
    delete m_mcpat_core_interface;
    delete m_load_buffer;
    delete m_store_buffer;
@@ -56,12 +88,55 @@ void IOCOOMCoreModel::initializePipelineStallCounters()
    m_total_l1dcache_write_stall_cycles = 0;
    m_total_intra_ins_execution_unit_stall_cycles = 0;
    m_total_inter_ins_execution_unit_stall_cycles = 0;
+   m_total_functional_unit_stall_cycles = 0;
+   m_total_store_completion_stall_cycles = 0;
+   m_total_fence_stall_cycles = 0;
+   m_total_forwarded_loads = 0;
+}
+
+IOCOOMCoreModel::ConsistencyModel IOCOOMCoreModel::parseConsistencyModel(string model)
+{
+   if (model == "sc")
+      return SEQUENTIAL_CONSISTENCY;
+   else if (model == "tso")
+      return TOTAL_STORE_ORDER;
+   else if (model == "rc")
+      return RELEASE_CONSISTENCY;
+   else
+   {
+      LOG_PRINT_ERROR("Unrecognized consistency model(%s)", model.c_str());
+      return NUM_CONSISTENCY_MODELS;
+   }
+}
+
+string IOCOOMCoreModel::getConsistencyModelName(ConsistencyModel model)
+{
+   switch (model)
+   {
+   case SEQUENTIAL_CONSISTENCY:
+      return "sc";
+   case TOTAL_STORE_ORDER:
+      return "tso";
+   case RELEASE_CONSISTENCY:
+      return "rc";
+   default:
+      LOG_PRINT_ERROR("Unrecognized consistency model(%u)", model);
+      return "";
+   }
 }
 
 void IOCOOMCoreModel::outputSummary(std::ostream &os)
 {
    CoreModel::outputSummary(os);
 
+   if (m_icache_footprint)
+      os << "    Total L1-I Cache Probes Skipped: " << m_total_icache_probes_skipped << endl;
+   if (m_icache_prefetcher)
+      m_icache_prefetcher->outputSummary(os);
+   os << "    Consistency Model: " << getConsistencyModelName(m_consistency_model) << endl;
+   os << "    Total Store Completion Stall Time (in ns): " << (UInt64) ((double) m_total_store_completion_stall_cycles / m_frequency) << endl;
+   os << "    Total Fence Stall Time (in ns): " << (UInt64) ((double) m_total_fence_stall_cycles / m_frequency) << endl;
+   os << "    Loads Forwarded from the Store Buffer: " << m_total_forwarded_loads << endl;
 //   os << "    Total Load Buffer Stall Time (in ns): " << (UInt64) ((double) m_total_load_buffer_stall_cycles / m_frequency) << endl;
 //   os << "    Total Store Buffer Stall Time (in ns): " << (UInt64) ((double) m_total_store_buffer_stall_cycles / m_frequency) << endl;
 //   os << "    Total L1-I Cache Stall Time (in ns): " << (UInt64) ((double) m_total_l1icache_stall_cycles / m_frequency) << endl;
@@ -70,6 +145,7 @@ void IOCOOMCoreModel::outputSummary(std::ostream &os)
 //   os << "    Total L1-D Cache Write Stall Time (in ns): " << (UInt64) ((double) m_total_l1dcache_write_stall_cycles / m_frequency) << endl;
 //   os << "    Total Intra Ins Execution Unit Stall Time (in ns): " << (UInt64) ((double) m_total_intra_ins_execution_unit_stall_cycles / m_frequency) << endl;
 //   os << "    Total Inter Ins Execution Unit Stall Time (in ns): " << (UInt64) ((double) m_total_inter_ins_execution_unit_stall_cycles / m_frequency) << endl;
+//   os << "    Total Functional Unit Stall Time (in ns): " << (UInt64) ((double) m_total_functional_unit_stall_cycles / m_frequency) << endl;
 }
 
 void IOCOOMCoreModel::updateInternalVariablesOnFrequencyChange(volatile float frequency)
@@ -86,6 +162,12 @@ void IOCOOMCoreModel::updateInternalVariablesOnFrequencyChange(volatile float fr
    m_total_l1dcache_write_stall_cycles = (UInt64) (((double) m_total_l1dcache_write_stall_cycles / old_frequency) * new_frequency);
    m_total_intra_ins_execution_unit_stall_cycles = (UInt64) (((double) m_total_intra_ins_execution_unit_stall_cycles / old_frequency) * new_frequency);
    m_total_inter_ins_execution_unit_stall_cycles = (UInt64) (((double) m_total_inter_ins_execution_unit_stall_cycles / old_frequency) * new_frequency);
+   m_total_functional_unit_stall_cycles = (UInt64) (((double) m_total_functional_unit_stall_cycles / old_frequency) * new_frequency);
+   m_total_store_completion_stall_cycles = (UInt64) (((double) m_total_store_completion_stall_cycles / old_frequency) * new_frequency);
+   m_total_fence_stall_cycles = (UInt64) (((double) m_total_fence_stall_cycles / old_frequency) * new_frequency);
+
+   // The hit latency is in cycles of the core
+   m_icache_hit_latency = UINT64_MAX_;
 
    CoreModel::updateInternalVariablesOnFrequencyChange(frequency);
 }
@@ -98,7 +180,7 @@ void IOCOOMCoreModel::handleInstruction(Instruction *instruction)
 
    // Model Instruction Fetch Stage
    UInt64 instruction_ready = m_cycle_count;
-   UInt64 instruction_memory_access_latency = modelICache(instruction->getAddress(), instruction->getSize());
+   UInt64 instruction_memory_access_latency = modelICache(instruction);
    instruction_ready += (instruction_memory_access_latency - 1);
 
    // Model instruction in the following steps:
@@ -198,9 +280,19 @@ void IOCOOMCoreModel::handleInstruction(Instruction *instruction)
    // Time when read operands (both register and memory) are ready
    UInt64 read_operands_ready = read_memory_operands_ready;
 
+   // An operation that is not fully pipelined (occupancy > 0) keeps its functional unit
+   // busy for 'occupancy' cycles, the next one on that unit waits for it
+   UInt64 execution_start = read_operands_ready;
+   UInt64 occupancy = instruction->getOccupancy();
+   if (occupancy > 0)
+   {
+      UInt64 &functional_unit_ready = m_functional_unit_scoreboard[instruction->getFunctionalUnit()];
+      execution_start = max<UInt64>(read_operands_ready, functional_unit_ready);
+      functional_unit_ready = execution_start + occupancy;
+   }
+
    // Calculate the completion time of instruction (after fetching read operands + execution unit)
-   // Assume that there is no structural hazard at the execution unit
-   UInt64 execution_unit_completion_time = read_operands_ready + cost;
+   UInt64 execution_unit_completion_time = execution_start + cost;
 
    // Time when write operands are ready
    UInt64 write_operands_ready = execution_unit_completion_time;
@@ -265,6 +357,7 @@ void IOCOOMCoreModel::handleInstruction(Instruction *instruction)
   
    UInt64 memory_stall_cycles = 0;
    UInt64 execution_unit_stall_cycles = 0;
+   UInt64 icache_stall_cycles = 0;
 
    // update cycle count with instruction cost
    // If it is a simple load instruction, execute the next instruction after load_buffer_ready,
@@ -277,8 +370,9 @@ void IOCOOMCoreModel::handleInstruction(Instruction *instruction)
    else // Static Instruction
    {
       // L1-I Cache
-      memory_stall_cycles += (instruction_ready - m_cycle_count);
-      m_total_l1icache_stall_cycles += (instruction_ready - m_cycle_count);
+      icache_stall_cycles = (instruction_ready - m_cycle_count);
+      memory_stall_cycles += icache_stall_cycles;
+      m_total_l1icache_stall_cycles += icache_stall_cycles;
 
       // Register Read Operands
       execution_unit_stall_cycles += (read_register_operands_ready_execution_unit_wait - instruction_ready);
@@ -312,6 +406,14 @@ void IOCOOMCoreModel::handleInstruction(Instruction *instruction)
             m_cycle_count = store_buffer_ready + 1;
          }
       }
+
+      // In order: the next instruction is issued after this one got its functional unit
+      if (m_cycle_count < (execution_start + 1))
+      {
+         execution_unit_stall_cycles += (execution_start + 1 - m_cycle_count);
+         m_total_functional_unit_stall_cycles += (execution_start + 1 - m_cycle_count);
+         m_cycle_count = execution_start + 1;
+      }
    }
 
    LOG_ASSERT_ERROR(write_info.empty(), "Some write info left over?");
@@ -320,7 +422,7 @@ void IOCOOMCoreModel::handleInstruction(Instruction *instruction)
    m_instruction_count++;
 
    // Update Common Pipeline Stall Counters
-   updatePipelineStallCounters(instruction, memory_stall_cycles, execution_unit_stall_cycles);
+   updatePipelineStallCounters(instruction, memory_stall_cycles, execution_unit_stall_cycles, icache_stall_cycles);
 
    // Update Event Counters
    m_mcpat_core_interface->updateEventCounters(instruction, m_cycle_count);
@@ -329,12 +431,24 @@ void IOCOOMCoreModel::handleInstruction(Instruction *instruction)
 pair<UInt64,UInt64>
 IOCOOMCoreModel::executeLoad(UInt64 time, const DynamicInstructionInfo &info)
 {
-   // similarly, a miss in the l1 with a completed entry in the store
-   // buffer is treated as an invalidation
-   StoreBuffer::Status status = m_store_buffer->isAddressAvailable(time, info.memory_info.addr);
+   // the load of a LOCK-prefixed instruction waits for the stores before
+   // it and reads the cache
+   if (info.memory_info.locked)
+   {
+      time = drainStoreBuffer(time);
+   }
+   else
+   {
+      // similarly, a miss in the l1 with a completed entry in the store
+      // buffer is treated as an invalidation
+      StoreBuffer::Status status = m_store_buffer->isAddressAvailable(time, info.memory_info.addr);
 
-   if (status == StoreBuffer::VALID)
-      return make_pair<UInt64,UInt64>(time,0);
+      if (status == StoreBuffer::VALID)
+      {
+         m_total_forwarded_loads ++;
+         return make_pair<UInt64,UInt64>(time,0);
+      }
+   }
 
    // a miss in the l1 forces a miss in the store buffer
    UInt64 latency = info.memory_info.latency;
@@ -346,12 +460,99 @@ UInt64 IOCOOMCoreModel::executeStore(UInt64 time, const DynamicInstructionInfo &
 {
    UInt64 latency = info.memory_info.latency;
 
+   // The store completes before the next instruction
+   if (info.memory_info.locked || (m_consistency_model == SEQUENTIAL_CONSISTENCY))
+   {
+      UInt64 start_time = drainStoreBuffer(time);
+      m_total_store_completion_stall_cycles += latency;
+      return start_time + latency;
+   }
+
    return m_store_buffer->executeStore(time, latency, info.memory_info.addr);
 }
 
-UInt64 IOCOOMCoreModel::modelICache(IntPtr ins_address, UInt32 ins_size)
+UInt64 IOCOOMCoreModel::drainStoreBuffer(UInt64 time)
+{
+   UInt64 drain_time = m_store_buffer->getDrainTime();
+   if (drain_time <= time)
+      return time;
+
+   m_total_fence_stall_cycles += (drain_time - time);
+   return drain_time;
+}
+
+UInt64 IOCOOMCoreModel::modelICache(Instruction* instruction)
 {
-   return getCore()->readInstructionMemory(ins_address, ins_size);
+   if (m_icache_footprint)
+   {
+      UInt32 ins_index;
+      BasicBlock* basic_block = getCurrentBasicBlock(ins_index);
+      if (basic_block && !basic_block->isDynamic() && (ins_index < basic_block->size()) &&
+          (basic_block->at(ins_index) == instruction))
+      {
+         return modelICacheFootprint(instruction, basic_block, ins_index);
+      }
+   }
+   else if (m_icache_prefetcher)
+   {
+      UInt32 ins_index;
+      BasicBlock* basic_block = getCurrentBasicBlock(ins_index);
+      bool block_start = basic_block && (ins_index == 0) && (basic_block->size() > 0) &&
+                         (basic_block->at(0) == instruction);
+      return m_icache_prefetcher->fetch(instruction->getAddress(), instruction->getSize(), block_start, m_cycle_count);
+   }
+   return getCore()->readInstructionMemory(instruction->getAddress(), instruction->getSize());
+}
+
+UInt64 IOCOOMCoreModel::modelICacheFootprint(Instruction* instruction, BasicBlock* basic_block, UInt32 ins_index)
+{
+   Cache* l1_icache = getCore()->getMemoryManager()->getL1ICache();
+   if (m_icache_line_size == 0)
+      m_icache_line_size = getCore()->getMemoryManager()->getCacheLineSize();
+
+   ResidentBlock& resident_block = m_resident_blocks[((IntPtr) basic_block / sizeof(BasicBlock)) % NUM_RESIDENT_BLOCKS];
+
+   // The lines of the block are still there if none left the L1-I since its
+   // last run (the removals are counted when the block starts: if its own
+   // fetches evicted anything, the next run probes again)
+   if (ins_index == 0)
+   {
+      m_block_start_line_removals = l1_icache->getNumLineRemovals();
+      m_block_resident = (resident_block.basic_block == basic_block) &&
+                         (resident_block.num_line_removals == m_block_start_line_removals) &&
+                         (m_icache_hit_latency != UINT64_MAX_);
+   }
+
+   bool probe = !m_block_resident;
+   if (probe && (ins_index > 0) && (m_icache_hit_latency != UINT64_MAX_))
+   {
+      // Lines the previous instruction of the block touched already
+      Instruction* previous = basic_block->at(ins_index - 1);
+      IntPtr first_line = instruction->getAddress() / m_icache_line_size;
+      IntPtr last_line = (instruction->getAddress() + instruction->getSize() - 1) / m_icache_line_size;
+      IntPtr previous_first_line = previous->getAddress() / m_icache_line_size;
+      IntPtr previous_last_line = (previous->getAddress() + previous->getSize() - 1) / m_icache_line_size;
+      probe = (first_line < previous_first_line) || (last_line > previous_last_line);
+   }
+
+   UInt64 latency;
+   if (probe)
+   {
+      latency = getCore()->readInstructionMemory(instruction->getAddress(), instruction->getSize());
+      m_icache_hit_latency = std::min(m_icache_hit_latency, latency);
+   }
+   else
+   {
+      latency = m_icache_hit_latency;
+      m_total_icache_probes_skipped ++;
+   }
+
+   if ((ins_index == (basic_block->size() - 1)) && !m_block_resident)
+   {
+      resident_block.basic_block = basic_block;
+      resident_block.num_line_removals = m_block_start_line_removals;
+   }
+   return latency;
 }
 
 void IOCOOMCoreModel::initializeRegisterScoreboard()
@@ -414,9 +615,12 @@ void IOCOOMCoreModel::LoadBuffer::initialize()
    }
 }
 
-IOCOOMCoreModel::StoreBuffer::StoreBuffer(unsigned int num_entries)
+IOCOOMCoreModel::StoreBuffer::StoreBuffer(unsigned int num_entries, bool in_order)
    : m_scoreboard(num_entries)
    , m_addresses(num_entries)
+   , m_in_order(in_order)
+   , m_next_entry(0)
+   , m_last_completion_time(0)
 {
    initialize();
 }
@@ -427,6 +631,18 @@ IOCOOMCoreModel::StoreBuffer::~StoreBuffer()
 
 UInt64 IOCOOMCoreModel::StoreBuffer::executeStore(UInt64 time, UInt64 occupancy, IntPtr addr)
 {
+   if (m_in_order)
+   {
+      // wait for the oldest store to leave its entry, then complete after
+      // the store before it (the misses of the buffered stores overlap)
+      UInt64 entry_time = max<UInt64>(time, m_scoreboard[m_next_entry]);
+      m_last_completion_time = max<UInt64>(entry_time + occupancy, m_last_completion_time);
+      m_scoreboard[m_next_entry] = m_last_completion_time;
+      m_addresses[m_next_entry] = addr;
+      m_next_entry = (m_next_entry + 1) % m_scoreboard.size();
+      return entry_time;
+   }
+
    // Note: basically identical to ExecutionUnit, except we need to
    // track addresses as well
 
@@ -479,6 +695,17 @@ IOCOOMCoreModel::StoreBuffer::Status IOCOOMCoreModel::StoreBuffer::isAddressAvai
    return NOT_FOUND;
 }
 
+UInt64 IOCOOMCoreModel::StoreBuffer::getDrainTime()
+{
+   UInt64 drain_time = 0;
+   for (unsigned int i = 0; i < m_scoreboard.size(); i++)
+   {
+      if (drain_time < m_scoreboard[i])
+         drain_time = m_scoreboard[i];
+   }
+   return drain_time;
+}
+
 void IOCOOMCoreModel::StoreBuffer::initialize()
 {
    for (unsigned int i = 0; i < m_scoreboard.size(); i++)
@@ -486,4 +713,6 @@ void IOCOOMCoreModel::StoreBuffer::initialize()
       m_scoreboard[i] = 0;
       m_addresses[i] = 0;
    }
+   m_next_entry = 0;
+   m_last_completion_time = 0;
 }
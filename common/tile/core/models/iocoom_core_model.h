@@ -7,6 +7,9 @@ using std::string;
 
 #include "core_model.h"
 #include "mcpat_core_interface.h"
+
+class InstructionPrefetcher;
+
 /*
   In-order core, out-of-order memory model.
   We use a simple scoreboard to keep track of registers.
@@ -23,6 +26,22 @@ public:
 
 private:
 
+   // Order of the stores of the core (core/iocoom/consistency_model)
+   //  - sc: every store completes before the next instruction
+   //  - tso: stores wait in a FIFO store buffer and complete in program
+   //    order, the loads read the stores of the buffer
+   //  - rc: stores to the same address coalesce in the store buffer, which
+   //    drains out of order, the loads read the stores of the buffer
+   // A LOCK-prefixed instruction is a fence: it waits for the store buffer
+   // to drain, and its store completes before the next instruction
+   enum ConsistencyModel
+   {
+      SEQUENTIAL_CONSISTENCY = 0,
+      TOTAL_STORE_ORDER,
+      RELEASE_CONSISTENCY,
+      NUM_CONSISTENCY_MODELS
+   };
+
    enum CoreUnit
    {
       INVALID_UNIT = 0,
@@ -33,9 +52,15 @@ private:
 
    void handleInstruction(Instruction *instruction);
 
-   UInt64 modelICache(IntPtr ins_address, UInt32 ins_size);
+   UInt64 modelICache(Instruction* instruction);
+   UInt64 modelICacheFootprint(Instruction* instruction, BasicBlock* basic_block, UInt32 ins_index);
    std::pair<UInt64,UInt64> executeLoad(UInt64 time, const DynamicInstructionInfo &);
    UInt64 executeStore(UInt64 time, const DynamicInstructionInfo &);
+   // Time the store buffer is drained for a fence issued at 'time'
+   UInt64 drainStoreBuffer(UInt64 time);
+
+   static ConsistencyModel parseConsistencyModel(string model);
+   static string getConsistencyModelName(ConsistencyModel model);
 
    void initializeRegisterScoreboard();
    void initializeRegisterWaitUnitList();
@@ -66,16 +91,24 @@ private:
          NOT_FOUND
       };
 
-      StoreBuffer(unsigned int num_entries);
+      // 'in_order': the entries are allocated and complete in program
+      // order, else a store to an address in the buffer coalesces with it
+      // and any completed entry is reused
+      StoreBuffer(unsigned int num_entries, bool in_order);
       ~StoreBuffer();
 
       /*
-        @return Time store finishes.
+        @return Time store enters the buffer.
         @param time Time store starts.
         @param addr Address of store.
       */
       UInt64 executeStore(UInt64 time, UInt64 occupancy, IntPtr addr);
 
+      /*
+        @return Time all the stores in the buffer are completed.
+      */
+      UInt64 getDrainTime();
+
       /*
         @return True if addr is in store buffer at given time.
         @param time Time to check for addr.
@@ -86,13 +119,20 @@ private:
    private:
       Scoreboard m_scoreboard;
       std::vector<IntPtr> m_addresses;
+      bool m_in_order;
+      // Next entry and completion time of the last store (in order)
+      unsigned int m_next_entry;
+      UInt64 m_last_completion_time;
       
       void initialize();
    };
 
    Scoreboard m_register_scoreboard;
    std::vector<CoreUnit> m_register_wait_unit_list;
+   // Time when the functional unit of each instruction type is free
+   Scoreboard m_functional_unit_scoreboard;
 
+   ConsistencyModel m_consistency_model;
    StoreBuffer *m_store_buffer;
    LoadBuffer *m_load_buffer;
 
@@ -105,9 +145,39 @@ private:
    UInt64 m_total_l1dcache_write_stall_cycles;
    UInt64 m_total_intra_ins_execution_unit_stall_cycles;
    UInt64 m_total_inter_ins_execution_unit_stall_cycles;
+   UInt64 m_total_functional_unit_stall_cycles;
+   // Of the store buffer stalls, the ones waiting for a store to complete
+   // (sc, LOCK-prefixed instructions); and the fence stalls for the store
+   // buffer to drain (on the loads and stores of LOCK-prefixed instructions)
+   UInt64 m_total_store_completion_stall_cycles;
+   UInt64 m_total_fence_stall_cycles;
+   UInt64 m_total_forwarded_loads;
    void initializePipelineStallCounters();
 
    McPATCoreInterface* m_mcpat_core_interface;
+
+   // I-cache footprint (core/iocoom/icache_footprint): the L1-I is probed
+   // by the instructions of a basic block that touch a line the earlier
+   // ones do not, and not at all when a block runs again while no line has
+   // left the L1-I since it last ran
+   struct ResidentBlock
+   {
+      BasicBlock* basic_block;
+      UInt64 num_line_removals;
+   };
+   static const UInt32 NUM_RESIDENT_BLOCKS = 1024;
+
+   bool m_icache_footprint;
+   std::vector<ResidentBlock> m_resident_blocks;
+   bool m_block_resident;
+   UInt64 m_block_start_line_removals;
+   UInt32 m_icache_line_size;
+   // Lowest latency of a probe: the one of a hit
+   UInt64 m_icache_hit_latency;
+   UInt64 m_total_icache_probes_skipped;
+
+   // NULL unless core/iocoom/icache_prefetcher/type is set
+   InstructionPrefetcher* m_icache_prefetcher;
 };
 
 #endif // IOCOOM_CORE_MODEL_H
@@ -0,0 +1,593 @@
+using namespace std;
+
+#include "tile.h"
+#include "core.h"
+#include "ooo_core_model.h"
+
+#include "log.h"
+#include "dynamic_instruction_info.h"
+#include "config.hpp"
+#include "simulator.h"
+#include "checkpoint.h"
+#include "branch_predictor.h"
+
+static UInt64 scaleCycles(UInt64 cycles, float old_frequency, float new_frequency)
+{
+   return (UInt64) (((double) cycles / old_frequency) * new_frequency);
+}
+
+OOOCoreModel::OOOCoreModel(Core *core, float frequency)
+   : CoreModel(core, frequency)
+   , m_width(1)
+   , m_violation_penalty(0)
+   , m_register_scoreboard(512)
+   , m_reorder_buffer(0)
+   , m_rename_registers(0)
+   , m_load_queue(0)
+   , m_issue_queue(0)
+   , m_store_queue(0)
+   , m_memory_dependence_predictor(0)
+{
+   config::Config *cfg = Sim()->getCfg();
+
+   UInt32 num_load_queue_entries = 0;
+   UInt32 num_store_queue_entries = 0;
+   try
+   {
+      m_width = cfg->getInt("core/ooo/width", 4);
+      m_violation_penalty = cfg->getInt("core/ooo/memory_dependence_violation_penalty", 10);
+      num_load_queue_entries = cfg->getInt("core/ooo/num_load_queue_entries", 48);
+      num_store_queue_entries = cfg->getInt("core/ooo/num_store_queue_entries", 32);
+
+      m_reorder_buffer = new Window(cfg->getInt("core/ooo/num_rob_entries", 128));
+      m_rename_registers = new Window(cfg->getInt("core/ooo/num_rename_registers", 96));
+      m_issue_queue = new IssueQueue(cfg->getInt("core/ooo/num_issue_queue_entries", 48));
+      m_memory_dependence_predictor = new MemoryDependencePredictor(
+            cfg->getInt("core/ooo/memory_dependence_predictor_size", 1024));
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Config info not available.");
+   }
+
+   LOG_ASSERT_ERROR(m_width > 0, "Core width must be > 0");
+   m_load_queue = new Window(num_load_queue_entries);
+   m_store_queue = new StoreQueue(num_store_queue_entries);
+
+   initializeRegisterScoreboard();
+   initializePipelineState();
+
+   // For Power and AreaModeling
+   m_mcpat_core_interface = new McPATCoreInterface(num_load_queue_entries, num_store_queue_entries);
+   m_mcpat_core_interface->registerEventCounters(getCore()->getTile()->getId());
+
+   initializePipelineStallCounters();
+}
+
+OOOCoreModel::~OOOCoreModel()
+{
+   delete m_mcpat_core_interface;
+   delete m_memory_dependence_predictor;
+   delete m_store_queue;
+   delete m_issue_queue;
+   delete m_load_queue;
+   delete m_rename_registers;
+   delete m_reorder_buffer;
+}
+
+void OOOCoreModel::initializePipelineStallCounters()
+{
+   m_total_base_cycles = 0;
+   m_total_l1icache_stall_cycles = 0;
+   m_total_branch_mispredict_stall_cycles = 0;
+   m_total_rob_memory_stall_cycles = 0;
+   m_total_rob_execution_stall_cycles = 0;
+   m_total_issue_queue_stall_cycles = 0;
+   m_total_load_queue_stall_cycles = 0;
+   m_total_store_queue_stall_cycles = 0;
+   m_total_rename_register_stall_cycles = 0;
+   m_total_dynamic_instruction_cycles = 0;
+
+   m_total_forwarded_loads = 0;
+   m_total_memory_dependence_violations = 0;
+}
+
+void OOOCoreModel::initializePipelineState()
+{
+   m_reorder_buffer->initialize();
+   m_rename_registers->initialize();
+   m_load_queue->initialize();
+   m_issue_queue->initialize();
+   m_store_queue->initialize();
+
+   m_fetch_time = m_cycle_count;
+   m_dispatch_time = m_cycle_count;
+   m_num_dispatched_in_cycle = 0;
+   m_commit_time = m_cycle_count;
+   m_num_committed_in_cycle = 0;
+}
+
+void OOOCoreModel::outputSummary(std::ostream &os)
+{
+   CoreModel::outputSummary(os);
+
+   // What held the dispatch of the instructions (per instruction)
+   double num_instructions = (m_instruction_count > 0) ? (double) m_instruction_count : 1.0;
+   os << "    Dispatch Stall Stack:" << endl;
+   os << "      Base: " << (double) m_total_base_cycles / num_instructions << endl;
+   os << "      L1-I Cache: " << (double) m_total_l1icache_stall_cycles / num_instructions << endl;
+   os << "      Branch Misprediction: " << (double) m_total_branch_mispredict_stall_cycles / num_instructions << endl;
+   os << "      ROB Full (Memory): " << (double) m_total_rob_memory_stall_cycles / num_instructions << endl;
+   os << "      ROB Full (Execution): " << (double) m_total_rob_execution_stall_cycles / num_instructions << endl;
+   os << "      Issue Queue Full: " << (double) m_total_issue_queue_stall_cycles / num_instructions << endl;
+   os << "      Load Queue Full: " << (double) m_total_load_queue_stall_cycles / num_instructions << endl;
+   os << "      Store Queue Full: " << (double) m_total_store_queue_stall_cycles / num_instructions << endl;
+   os << "      Rename Registers: " << (double) m_total_rename_register_stall_cycles / num_instructions << endl;
+   os << "      Dynamic Instructions: " << (double) m_total_dynamic_instruction_cycles / num_instructions << endl;
+   os << "    Forwarded Loads: " << m_total_forwarded_loads << endl;
+   os << "    Memory Dependence Violations: " << m_total_memory_dependence_violations << endl;
+}
+
+void OOOCoreModel::saveState(CheckpointWriter& writer)
+{
+   CoreModel::saveState(writer);
+   writer.beginSection("OOO Core Model");
+   writer << m_total_base_cycles << m_total_l1icache_stall_cycles << m_total_branch_mispredict_stall_cycles
+          << m_total_rob_memory_stall_cycles << m_total_rob_execution_stall_cycles
+          << m_total_issue_queue_stall_cycles << m_total_load_queue_stall_cycles
+          << m_total_store_queue_stall_cycles << m_total_rename_register_stall_cycles
+          << m_total_dynamic_instruction_cycles << m_total_forwarded_loads
+          << m_total_memory_dependence_violations;
+}
+
+void OOOCoreModel::restoreState(CheckpointReader& reader)
+{
+   CoreModel::restoreState(reader);
+   reader.beginSection("OOO Core Model");
+   reader >> m_total_base_cycles >> m_total_l1icache_stall_cycles >> m_total_branch_mispredict_stall_cycles
+          >> m_total_rob_memory_stall_cycles >> m_total_rob_execution_stall_cycles
+          >> m_total_issue_queue_stall_cycles >> m_total_load_queue_stall_cycles
+          >> m_total_store_queue_stall_cycles >> m_total_rename_register_stall_cycles
+          >> m_total_dynamic_instruction_cycles >> m_total_forwarded_loads
+          >> m_total_memory_dependence_violations;
+}
+
+void OOOCoreModel::updateInternalVariablesOnFrequencyChange(volatile float frequency)
+{
+   volatile float old_frequency = m_frequency;
+   volatile float new_frequency = frequency;
+
+   m_total_base_cycles = scaleCycles(m_total_base_cycles, old_frequency, new_frequency);
+   m_total_l1icache_stall_cycles = scaleCycles(m_total_l1icache_stall_cycles, old_frequency, new_frequency);
+   m_total_branch_mispredict_stall_cycles = scaleCycles(m_total_branch_mispredict_stall_cycles, old_frequency, new_frequency);
+   m_total_rob_memory_stall_cycles = scaleCycles(m_total_rob_memory_stall_cycles, old_frequency, new_frequency);
+   m_total_rob_execution_stall_cycles = scaleCycles(m_total_rob_execution_stall_cycles, old_frequency, new_frequency);
+   m_total_issue_queue_stall_cycles = scaleCycles(m_total_issue_queue_stall_cycles, old_frequency, new_frequency);
+   m_total_load_queue_stall_cycles = scaleCycles(m_total_load_queue_stall_cycles, old_frequency, new_frequency);
+   m_total_store_queue_stall_cycles = scaleCycles(m_total_store_queue_stall_cycles, old_frequency, new_frequency);
+   m_total_rename_register_stall_cycles = scaleCycles(m_total_rename_register_stall_cycles, old_frequency, new_frequency);
+   m_total_dynamic_instruction_cycles = scaleCycles(m_total_dynamic_instruction_cycles, old_frequency, new_frequency);
+
+   CoreModel::updateInternalVariablesOnFrequencyChange(frequency);
+
+   // The instructions in flight are taken as done, the pipeline starts
+   // again from the new cycle count
+   initializeRegisterScoreboard();
+   initializePipelineState();
+}
+
+void OOOCoreModel::handleInstruction(Instruction *instruction)
+{
+   // Execute this first so that instructions have the opportunity to
+   // abort further processing (via AbortInstructionException)
+   UInt64 cost = instruction->getCost();
+
+   if (instruction->isDynamic())
+   {
+      handleDynamicInstruction(instruction, cost);
+      return;
+   }
+
+   // Model Instruction Fetch Stage
+   // The front end is behind the last dispatch only after a branch misprediction
+   UInt64 fetch_time = max<UInt64>(m_fetch_time, m_cycle_count);
+   UInt64 branch_mispredict_stall_cycles = fetch_time - m_cycle_count;
+
+   UInt64 instruction_memory_access_latency = modelICache(instruction->getAddress(), instruction->getSize());
+   UInt64 l1icache_stall_cycles = (instruction_memory_access_latency > 0) ? (instruction_memory_access_latency - 1) : 0;
+   fetch_time += l1icache_stall_cycles;
+   m_fetch_time = fetch_time;
+
+   const OperandList &ops = instruction->getOperands();
+
+   UInt32 num_memory_reads = 0;
+   UInt32 num_memory_writes = 0;
+   bool has_register_write_operand = false;
+   for (unsigned int i = 0; i < ops.size(); i++)
+   {
+      const Operand &o = ops[i];
+      if (o.m_type == Operand::MEMORY)
+      {
+         if (o.m_direction == Operand::READ)
+            num_memory_reads ++;
+         else
+            num_memory_writes ++;
+      }
+      else if ((o.m_type == Operand::REG) && (o.m_direction == Operand::WRITE))
+      {
+         has_register_write_operand = true;
+      }
+   }
+
+   // Model Dispatch Stage
+   // Wait for a free entry in every structure the instruction needs, the
+   // stall is attributed to the structure that frees its entry the latest
+   UInt64 dispatch_time = fetch_time;
+
+   UInt64 rob_memory_stall_cycles = 0;
+   UInt64 rob_execution_stall_cycles = 0;
+   UInt64 load_queue_stall_cycles = 0;
+   UInt64 store_queue_stall_cycles = 0;
+   UInt64 rename_register_stall_cycles = 0;
+   UInt64 issue_queue_stall_cycles = 0;
+
+   // A full ROB is a memory stall if its oldest instruction waits for memory
+   if (m_reorder_buffer->getFreeTime() > dispatch_time)
+   {
+      if (m_reorder_buffer->isMemoryBound())
+         rob_memory_stall_cycles = m_reorder_buffer->getFreeTime() - dispatch_time;
+      else
+         rob_execution_stall_cycles = m_reorder_buffer->getFreeTime() - dispatch_time;
+      dispatch_time = m_reorder_buffer->getFreeTime();
+   }
+   if ((num_memory_reads > 0) && (m_load_queue->getFreeTime() > dispatch_time))
+   {
+      load_queue_stall_cycles = m_load_queue->getFreeTime() - dispatch_time;
+      dispatch_time = m_load_queue->getFreeTime();
+   }
+   if ((num_memory_writes > 0) && (m_store_queue->getFreeTime() > dispatch_time))
+   {
+      store_queue_stall_cycles = m_store_queue->getFreeTime() - dispatch_time;
+      dispatch_time = m_store_queue->getFreeTime();
+   }
+   if (has_register_write_operand && (m_rename_registers->getFreeTime() > dispatch_time))
+   {
+      rename_register_stall_cycles = m_rename_registers->getFreeTime() - dispatch_time;
+      dispatch_time = m_rename_registers->getFreeTime();
+   }
+   UInt64 issue_queue_free_time = m_issue_queue->getFreeTime(dispatch_time);
+   if (issue_queue_free_time > dispatch_time)
+   {
+      issue_queue_stall_cycles = issue_queue_free_time - dispatch_time;
+      dispatch_time = issue_queue_free_time;
+   }
+
+   UInt64 stalled_dispatch_time = dispatch_time;
+   dispatch_time = getSlot(dispatch_time, m_dispatch_time, m_num_dispatched_in_cycle);
+
+   // Model Issue & Execute Stages
+   // Renaming leaves only the RAW hazards
+   UInt64 read_register_operands_ready = dispatch_time;
+   for (unsigned int i = 0; i < ops.size(); i++)
+   {
+      const Operand &o = ops[i];
+
+      if ( (o.m_direction != Operand::READ) || (o.m_type != Operand::REG) )
+         continue;
+
+      LOG_ASSERT_ERROR(o.m_value < m_register_scoreboard.size(),
+                       "Register value out of range: %llu", o.m_value);
+
+      if (read_register_operands_ready < m_register_scoreboard[o.m_value])
+         read_register_operands_ready = m_register_scoreboard[o.m_value];
+   }
+
+   // buffer write operands to be updated after instruction executes
+   DynamicInstructionInfoQueue write_info;
+
+   // Loads issue once their address registers are ready, independent
+   // misses overlap
+   UInt64 read_memory_operands_ready = read_register_operands_ready;
+   for (unsigned int i = 0; i < ops.size(); i++)
+   {
+      const Operand &o = ops[i];
+
+      if (o.m_type != Operand::MEMORY)
+         continue;
+
+      DynamicInstructionInfo &info = getDynamicInstructionInfo();
+
+      if (o.m_direction == Operand::READ)
+      {
+         LOG_ASSERT_ERROR(info.type == DynamicInstructionInfo::MEMORY_READ,
+                          "Expected memory read info, got: %d.", info.type);
+
+         UInt64 load_completion_time = executeLoad(instruction->getAddress(), read_register_operands_ready, info);
+         if (read_memory_operands_ready < load_completion_time)
+            read_memory_operands_ready = load_completion_time;
+      }
+      else
+      {
+         LOG_ASSERT_ERROR(info.type == DynamicInstructionInfo::MEMORY_WRITE,
+                          "Expected memory write info, got: %d.", info.type);
+
+         write_info.push(info);
+      }
+
+      popDynamicInstructionInfo();
+   }
+
+   // A mispredicted branch redirects the front end once it is resolved
+   UInt64 execution_latency = cost;
+   if (instruction->getType() == INST_BRANCH)
+   {
+      if (cost > 1)
+         m_fetch_time = max<UInt64>(m_fetch_time, read_register_operands_ready + cost);
+      execution_latency = 1;
+   }
+
+   // Execution units are not a structural hazard
+   UInt64 completion_time = read_memory_operands_ready + execution_latency;
+
+   for (unsigned int i = 0; i < ops.size(); i++)
+   {
+      const Operand &o = ops[i];
+
+      if ( (o.m_direction == Operand::WRITE) && (o.m_type == Operand::REG) )
+         m_register_scoreboard[o.m_value] = completion_time;
+   }
+
+   // Model Commit Stage
+   UInt64 commit_time = getSlot(completion_time, m_commit_time, m_num_committed_in_cycle);
+
+   // Stores are written to the L1-D cache after they commit
+   while (!write_info.empty())
+   {
+      const DynamicInstructionInfo &info = write_info.front();
+      UInt64 store_release_time = max<UInt64>(commit_time, completion_time) + info.memory_info.latency;
+      m_store_queue->allocate(info.memory_info.addr, completion_time, store_release_time);
+      write_info.pop();
+   }
+
+   bool memory_bound = (read_memory_operands_ready > read_register_operands_ready);
+   m_reorder_buffer->allocate(commit_time, memory_bound);
+   m_issue_queue->allocate(dispatch_time, read_register_operands_ready);
+   if (num_memory_reads > 0)
+      m_load_queue->allocate(commit_time);
+   if (has_register_write_operand)
+      m_rename_registers->allocate(commit_time);
+
+   // Update the CPI stack
+   m_total_base_cycles += (dispatch_time - stalled_dispatch_time);
+   m_total_l1icache_stall_cycles += l1icache_stall_cycles;
+   m_total_branch_mispredict_stall_cycles += branch_mispredict_stall_cycles;
+   m_total_rob_memory_stall_cycles += rob_memory_stall_cycles;
+   m_total_rob_execution_stall_cycles += rob_execution_stall_cycles;
+   m_total_load_queue_stall_cycles += load_queue_stall_cycles;
+   m_total_store_queue_stall_cycles += store_queue_stall_cycles;
+   m_total_rename_register_stall_cycles += rename_register_stall_cycles;
+   m_total_issue_queue_stall_cycles += issue_queue_stall_cycles;
+
+   UInt64 memory_stall_cycles = l1icache_stall_cycles + rob_memory_stall_cycles +
+                                load_queue_stall_cycles + store_queue_stall_cycles;
+   UInt64 execution_unit_stall_cycles = branch_mispredict_stall_cycles + rob_execution_stall_cycles +
+                                        rename_register_stall_cycles + issue_queue_stall_cycles;
+
+   m_cycle_count = dispatch_time;
+
+   // Update Statistics
+   m_instruction_count++;
+
+   // Update Common Pipeline Stall Counters
+   updatePipelineStallCounters(instruction, memory_stall_cycles, execution_unit_stall_cycles, l1icache_stall_cycles);
+
+   // Update Event Counters
+   m_mcpat_core_interface->updateEventCounters(instruction, m_cycle_count);
+}
+
+void OOOCoreModel::handleDynamicInstruction(Instruction *instruction, UInt64 cost)
+{
+   // Dynamic instructions (recv, sync, ...) drain the pipeline: they start
+   // once all the older instructions commit
+   UInt64 start_time = max<UInt64>(m_cycle_count, max<UInt64>(m_commit_time, m_fetch_time));
+   UInt64 end_time = start_time + cost;
+
+   m_total_dynamic_instruction_cycles += (end_time - m_cycle_count);
+   m_cycle_count = end_time;
+
+   m_fetch_time = end_time;
+   m_dispatch_time = end_time;
+   m_num_dispatched_in_cycle = 0;
+   m_commit_time = end_time;
+   m_num_committed_in_cycle = 0;
+
+   m_instruction_count++;
+
+   updatePipelineStallCounters(instruction, 0, 0);
+   m_mcpat_core_interface->updateEventCounters(instruction, m_cycle_count);
+}
+
+UInt64 OOOCoreModel::executeLoad(IntPtr ins_address, UInt64 time, const DynamicInstructionInfo &info)
+{
+   UInt64 store_execute_time;
+   if (m_store_queue->findStore(info.memory_info.addr, time, store_execute_time))
+   {
+      // Forwarded from the store queue
+      if (store_execute_time <= time)
+      {
+         m_total_forwarded_loads ++;
+         return time;
+      }
+
+      // Predicted to depend on an older store, wait for its data
+      if (m_memory_dependence_predictor->isDependent(ins_address))
+      {
+         m_total_forwarded_loads ++;
+         return store_execute_time;
+      }
+
+      // Issued ahead of the store it depends on, replayed once the
+      // store executes
+      m_total_memory_dependence_violations ++;
+      m_memory_dependence_predictor->update(ins_address);
+      return store_execute_time + m_violation_penalty;
+   }
+
+   return time + info.memory_info.latency;
+}
+
+UInt64 OOOCoreModel::getSlot(UInt64 time, UInt64 &last_time, UInt32 &num_in_cycle)
+{
+   // At most 'width' instructions dispatch (commit) in a cycle, in order
+   if (time > last_time)
+   {
+      last_time = time;
+      num_in_cycle = 0;
+   }
+   if (num_in_cycle == m_width)
+   {
+      last_time ++;
+      num_in_cycle = 0;
+   }
+   num_in_cycle ++;
+   return last_time;
+}
+
+UInt64 OOOCoreModel::modelICache(IntPtr ins_address, UInt32 ins_size)
+{
+   return getCore()->readInstructionMemory(ins_address, ins_size);
+}
+
+void OOOCoreModel::initializeRegisterScoreboard()
+{
+   for (unsigned int i = 0; i < m_register_scoreboard.size(); i++)
+   {
+      m_register_scoreboard[i] = 0;
+   }
+}
+
+// Helper classes
+
+OOOCoreModel::Window::Window(unsigned int num_entries)
+   : m_scoreboard(num_entries)
+   , m_memory_bound(num_entries)
+   , m_next(0)
+{
+   LOG_ASSERT_ERROR(num_entries > 0, "Window must have at least one entry");
+   initialize();
+}
+
+OOOCoreModel::Window::~Window()
+{
+}
+
+void OOOCoreModel::Window::allocate(UInt64 release_time, bool memory_bound)
+{
+   m_scoreboard[m_next] = release_time;
+   m_memory_bound[m_next] = memory_bound;
+   m_next = (m_next + 1) % m_scoreboard.size();
+}
+
+void OOOCoreModel::Window::initialize()
+{
+   for (unsigned int i = 0; i < m_scoreboard.size(); i++)
+   {
+      m_scoreboard[i] = 0;
+      m_memory_bound[i] = false;
+   }
+   m_next = 0;
+}
+
+OOOCoreModel::IssueQueue::IssueQueue(unsigned int num_entries)
+   : m_num_entries(num_entries)
+{
+   LOG_ASSERT_ERROR(num_entries > 0, "Issue queue must have at least one entry");
+}
+
+OOOCoreModel::IssueQueue::~IssueQueue()
+{
+}
+
+UInt64 OOOCoreModel::IssueQueue::getFreeTime(UInt64 time)
+{
+   while (!m_issue_times.empty() && (m_issue_times.top() <= time))
+      m_issue_times.pop();
+
+   if (m_issue_times.size() < m_num_entries)
+      return time;
+   // Full until the earliest instruction in it issues
+   return m_issue_times.top();
+}
+
+void OOOCoreModel::IssueQueue::allocate(UInt64 dispatch_time, UInt64 issue_time)
+{
+   while (!m_issue_times.empty() && (m_issue_times.top() <= dispatch_time))
+      m_issue_times.pop();
+
+   assert(m_issue_times.size() < m_num_entries);
+   m_issue_times.push(issue_time);
+}
+
+void OOOCoreModel::IssueQueue::initialize()
+{
+   while (!m_issue_times.empty())
+      m_issue_times.pop();
+}
+
+OOOCoreModel::StoreQueue::StoreQueue(unsigned int num_entries)
+   : m_addresses(num_entries)
+   , m_execute_times(num_entries)
+   , m_release_times(num_entries)
+   , m_next(0)
+{
+   LOG_ASSERT_ERROR(num_entries > 0, "Store queue must have at least one entry");
+   initialize();
+}
+
+OOOCoreModel::StoreQueue::~StoreQueue()
+{
+}
+
+void OOOCoreModel::StoreQueue::allocate(IntPtr address, UInt64 execute_time, UInt64 release_time)
+{
+   m_addresses[m_next] = address;
+   m_execute_times[m_next] = execute_time;
+   m_release_times[m_next] = release_time;
+   m_next = (m_next + 1) % m_addresses.size();
+}
+
+bool OOOCoreModel::StoreQueue::findStore(IntPtr address, UInt64 time, UInt64& execute_time) const
+{
+   // youngest first
+   for (unsigned int i = 1; i <= m_addresses.size(); i++)
+   {
+      unsigned int entry = (m_next + m_addresses.size() - i) % m_addresses.size();
+      if ((m_addresses[entry] == address) && (m_release_times[entry] > time))
+      {
+         execute_time = m_execute_times[entry];
+         return true;
+      }
+   }
+   return false;
+}
+
+void OOOCoreModel::StoreQueue::initialize()
+{
+   for (unsigned int i = 0; i < m_addresses.size(); i++)
+   {
+      m_addresses[i] = 0;
+      m_execute_times[i] = 0;
+      m_release_times[i] = 0;
+   }
+   m_next = 0;
+}
+
+OOOCoreModel::MemoryDependencePredictor::MemoryDependencePredictor(unsigned int num_entries)
+   : m_load_addresses(num_entries, 0)
+{
+   LOG_ASSERT_ERROR(num_entries > 0, "Memory dependence predictor must have at least one entry");
+}
+
+OOOCoreModel::MemoryDependencePredictor::~MemoryDependencePredictor()
+{
+}
@@ -0,0 +1,159 @@
+#ifndef OOO_CORE_MODEL_H
+#define OOO_CORE_MODEL_H
+
+#include <vector>
+#include <queue>
+#include <functional>
+
+#include "core_model.h"
+#include "mcpat_core_interface.h"
+/*
+  Out-of-order core model.
+  The instructions are dispatched in order (up to 'width' per cycle) into
+  a reorder buffer, and issue as soon as their operands are ready. Renaming
+  removes the WAR and WAW hazards, so a register scoreboard tracks when the
+  latest value of every register is ready, and the rename registers, the
+  issue queue, the load queue and the store queue limit what can be in
+  flight. Loads issue ahead of the older stores: a memory dependence
+  predictor holds back the loads that conflicted with a store before.
+  Dispatch stalls are attributed to their cause (the CPI stack).
+  The cycle count is the dispatch time of the youngest instruction.
+ */
+class OOOCoreModel : public CoreModel
+{
+public:
+   OOOCoreModel(Core* core, float frequency);
+   ~OOOCoreModel();
+
+   void updateInternalVariablesOnFrequencyChange(volatile float frequency);
+   void outputSummary(std::ostream &os);
+   void saveState(CheckpointWriter& writer);
+   void restoreState(CheckpointReader& reader);
+
+private:
+
+   typedef std::vector<UInt64> Scoreboard;
+
+   // Entries that are allocated and released in program order (ROB, load
+   // queue, ...). An entry is free again at the release time of the
+   // instruction that had it 'num_entries' instructions earlier
+   class Window
+   {
+   public:
+      Window(unsigned int num_entries);
+      ~Window();
+
+      UInt64 getFreeTime() const { return m_scoreboard[m_next]; }
+      bool isMemoryBound() const { return m_memory_bound[m_next]; }
+      void allocate(UInt64 release_time, bool memory_bound = false);
+      void initialize();
+
+   private:
+      Scoreboard m_scoreboard;
+      std::vector<bool> m_memory_bound;
+      unsigned int m_next;
+   };
+
+   // The entries of the issue queue are released out of order (at issue)
+   class IssueQueue
+   {
+   public:
+      IssueQueue(unsigned int num_entries);
+      ~IssueQueue();
+
+      // Time an entry is free for an instruction dispatched at 'time'
+      UInt64 getFreeTime(UInt64 time);
+      void allocate(UInt64 dispatch_time, UInt64 issue_time);
+      void initialize();
+
+   private:
+      std::priority_queue<UInt64, std::vector<UInt64>, std::greater<UInt64> > m_issue_times;
+      unsigned int m_num_entries;
+   };
+
+   // Stores waiting to be written to the L1-D cache
+   class StoreQueue
+   {
+   public:
+      StoreQueue(unsigned int num_entries);
+      ~StoreQueue();
+
+      UInt64 getFreeTime() const { return m_release_times[m_next]; }
+      void allocate(IntPtr address, UInt64 execute_time, UInt64 release_time);
+      // Is a store to 'address' still in the queue at 'time' ? If so, the
+      // time the data of the youngest one is ready
+      bool findStore(IntPtr address, UInt64 time, UInt64& execute_time) const;
+      void initialize();
+
+   private:
+      std::vector<IntPtr> m_addresses;
+      Scoreboard m_execute_times;
+      Scoreboard m_release_times;
+      unsigned int m_next;
+   };
+
+   // Remembers the loads that were issued ahead of a store they depend on
+   class MemoryDependencePredictor
+   {
+   public:
+      MemoryDependencePredictor(unsigned int num_entries);
+      ~MemoryDependencePredictor();
+
+      bool isDependent(IntPtr load_address) const
+      { return (m_load_addresses[load_address % m_load_addresses.size()] == load_address); }
+      void update(IntPtr load_address)
+      { m_load_addresses[load_address % m_load_addresses.size()] = load_address; }
+
+   private:
+      std::vector<IntPtr> m_load_addresses;
+   };
+
+   void handleInstruction(Instruction *instruction);
+   void handleDynamicInstruction(Instruction *instruction, UInt64 cost);
+
+   UInt64 modelICache(IntPtr ins_address, UInt32 ins_size);
+   UInt64 executeLoad(IntPtr ins_address, UInt64 time, const DynamicInstructionInfo &info);
+   UInt64 getSlot(UInt64 time, UInt64 &last_time, UInt32 &num_in_cycle);
+
+   void initializeRegisterScoreboard();
+   void initializePipelineState();
+   void initializePipelineStallCounters();
+
+   UInt32 m_width;
+   UInt64 m_violation_penalty;
+
+   Scoreboard m_register_scoreboard;
+
+   Window* m_reorder_buffer;
+   Window* m_rename_registers;
+   Window* m_load_queue;
+   IssueQueue* m_issue_queue;
+   StoreQueue* m_store_queue;
+   MemoryDependencePredictor* m_memory_dependence_predictor;
+
+   // Front end (redirected by branch mispredictions), dispatch and commit
+   UInt64 m_fetch_time;
+   UInt64 m_dispatch_time;
+   UInt32 m_num_dispatched_in_cycle;
+   UInt64 m_commit_time;
+   UInt32 m_num_committed_in_cycle;
+
+   // CPI Stack (cycles)
+   UInt64 m_total_base_cycles;
+   UInt64 m_total_l1icache_stall_cycles;
+   UInt64 m_total_branch_mispredict_stall_cycles;
+   UInt64 m_total_rob_memory_stall_cycles;
+   UInt64 m_total_rob_execution_stall_cycles;
+   UInt64 m_total_issue_queue_stall_cycles;
+   UInt64 m_total_load_queue_stall_cycles;
+   UInt64 m_total_store_queue_stall_cycles;
+   UInt64 m_total_rename_register_stall_cycles;
+   UInt64 m_total_dynamic_instruction_cycles;
+
+   UInt64 m_total_forwarded_loads;
+   UInt64 m_total_memory_dependence_violations;
+
+   McPATCoreInterface* m_mcpat_core_interface;
+};
+
+#endif // OOO_CORE_MODEL_H
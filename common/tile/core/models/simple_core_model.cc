@@ -104,7 +104,66 @@ void SimpleCoreModel::handleInstruction(Instruction *instruction)
    m_instruction_count++;
 
    // Update Common Counters
-   updatePipelineStallCounters(instruction, memory_stall_cycles, execution_unit_stall_cycles);
+   updatePipelineStallCounters(instruction, memory_stall_cycles, execution_unit_stall_cycles, instruction_memory_access_latency);
+}
+
+bool SimpleCoreModel::handleBasicBlockSummary(BasicBlock *basic_block)
+{
+   const BasicBlock::Summary& summary = basic_block->getSummary();
+   if (!summary.valid)
+      return false;
+
+   // The block is modeled at once only if all its info is there, otherwise
+   // as far as it goes, one instruction at a time
+   UInt32 num_infos = summary.num_memory_operands + (summary.ends_with_branch ? 1 : 0);
+   if (getNumDynamicInstructionInfos() < num_infos)
+      return false;
+
+   UInt64 memory_stall_cycles = 0;
+   UInt64 icache_stall_cycles = 0;
+
+   // Instruction Memory Modeling, all the instructions are fetched at the
+   // time the block starts
+   for (unsigned int i = 0; i < basic_block->size(); i++)
+   {
+      Instruction* instruction = basic_block->at(i);
+      UInt64 instruction_memory_access_latency = modelICache(instruction->getAddress(), instruction->getSize());
+      icache_stall_cycles += instruction_memory_access_latency;
+      m_total_l1icache_stall_cycles += instruction_memory_access_latency;
+   }
+   memory_stall_cycles += icache_stall_cycles;
+
+   // The memory info comes in the order of the operands, the (conditional)
+   // branch is the last instruction and has none
+   for (unsigned int i = 0; i < summary.num_memory_operands; i++)
+   {
+      DynamicInstructionInfo &info = getDynamicInstructionInfo();
+
+      if (info.type == DynamicInstructionInfo::MEMORY_READ)
+         m_total_l1dcache_read_stall_cycles += info.memory_info.latency;
+      else if (info.type == DynamicInstructionInfo::MEMORY_WRITE)
+         m_total_l1dcache_write_stall_cycles += info.memory_info.latency;
+      else
+         LOG_PRINT_ERROR("Expected memory info, got: %d.", info.type);
+
+      memory_stall_cycles += info.memory_info.latency;
+      popDynamicInstructionInfo();
+   }
+
+   UInt64 execution_unit_stall_cycles = summary.static_cost;
+   if (summary.ends_with_branch)
+      execution_unit_stall_cycles += basic_block->back()->getCost();
+
+   m_cycle_count += (memory_stall_cycles + execution_unit_stall_cycles);
+
+   // update counters
+   m_instruction_count += basic_block->size();
+
+   // Update Common Counters
+   updatePipelineStallCounters(memory_stall_cycles, execution_unit_stall_cycles, icache_stall_cycles);
+   updateMemoryStallProfile(basic_block->front()->getAddress(), memory_stall_cycles);
+
+   return true;
 }
 
 UInt64 SimpleCoreModel::modelICache(IntPtr ins_address, UInt32 ins_size)
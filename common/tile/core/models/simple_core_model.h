@@ -14,6 +14,7 @@ public:
 
 private:
    void handleInstruction(Instruction *instruction);
+   bool handleBasicBlockSummary(BasicBlock *basic_block);
    
    UInt64 modelICache(IntPtr ins_address, UInt32 ins_size);
    void initializePipelineStallCounters();
@@ -0,0 +1,211 @@
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+
+#include "phase_detector.h"
+#include "simulator.h"
+#include "stats_registry.h"
+#include "config.h"
+#include "log.h"
+
+using namespace std;
+
+PhaseDetector::PhaseDetector(tile_id_t tile_id, const UInt64* instruction_count, const UInt64* cycle_count,
+                             const UInt64* cpi_stack)
+   : m_tile_id(tile_id)
+   , m_instruction_count(instruction_count)
+   , m_cycle_count(cycle_count)
+   , m_cpi_stack(cpi_stack)
+   , m_num_instructions(0)
+   , m_last_instruction_count(0)
+   , m_last_cycle_count(0)
+   , m_flushed(false)
+{
+   try
+   {
+      m_interval = Sim()->getCfg()->getInt("core/phase_detection/interval", 10000000);
+      m_dimensions = Sim()->getCfg()->getInt("core/phase_detection/dimensions", 16);
+      m_threshold = Sim()->getCfg()->getFloat("core/phase_detection/threshold", 0.1);
+      m_max_phases = Sim()->getCfg()->getInt("core/phase_detection/max_phases", 16);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read [core/phase_detection] parameters from the cfg file");
+   }
+   LOG_ASSERT_ERROR(m_interval > 0, "Phase detection interval must be > 0");
+   LOG_ASSERT_ERROR((m_dimensions > 0) && (m_dimensions <= 64), "Phase detection dimensions(%u) must be in [1,64]", m_dimensions);
+   LOG_ASSERT_ERROR(m_max_phases > 0, "Max phases must be > 0");
+
+   m_vector.resize(m_dimensions, 0);
+   m_interval_starts.push_back(0);
+   for (UInt32 i = 0; i < CpiStack::NUM_COMPONENTS; i++)
+      m_last_cpi_stack[i] = 0;
+}
+
+PhaseDetector::~PhaseDetector()
+{}
+
+double
+PhaseDetector::getDistance(const vector<double>& a, const vector<double>& b) const
+{
+   double distance = 0;
+   for (UInt32 i = 0; i < m_dimensions; i++)
+      distance += fabs(a[i] - b[i]);
+   return distance / m_dimensions;
+}
+
+void
+PhaseDetector::endInterval()
+{
+   vector<double> interval_vector(m_dimensions);
+   for (UInt32 i = 0; i < m_dimensions; i++)
+   {
+      interval_vector[i] = ((double) m_vector[i]) / m_num_instructions;
+      m_vector[i] = 0;
+   }
+   m_num_instructions = 0;
+
+   // Nearest phase
+   UInt32 phase = m_phases.size();
+   double min_distance = 0;
+   for (UInt32 i = 0; i < m_phases.size(); i++)
+   {
+      double distance = getDistance(interval_vector, m_phases[i].centroid);
+      if ((phase == m_phases.size()) || (distance < min_distance))
+      {
+         phase = i;
+         min_distance = distance;
+      }
+   }
+   if ((phase == m_phases.size()) || ((min_distance > m_threshold) && (m_phases.size() < m_max_phases)))
+   {
+      phase = m_phases.size();
+      Phase new_phase;
+      new_phase.centroid = interval_vector;
+      new_phase.num_intervals = 0;
+      new_phase.instructions = 0;
+      new_phase.cycles = 0;
+      for (UInt32 i = 0; i < CpiStack::NUM_COMPONENTS; i++)
+         new_phase.cpi_stack[i] = 0;
+      m_phases.push_back(new_phase);
+   }
+
+   Phase& p = m_phases[phase];
+   p.num_intervals ++;
+   for (UInt32 i = 0; i < m_dimensions; i++)
+      p.centroid[i] += (interval_vector[i] - p.centroid[i]) / p.num_intervals;
+
+   // What the counters counted in the interval (they are reset when the
+   // models are enabled again)
+   UInt64 instruction_count = *m_instruction_count;
+   UInt64 cycle_count = *m_cycle_count;
+   p.instructions += (instruction_count >= m_last_instruction_count) ? (instruction_count - m_last_instruction_count) : instruction_count;
+   p.cycles += (cycle_count >= m_last_cycle_count) ? (cycle_count - m_last_cycle_count) : cycle_count;
+   m_last_instruction_count = instruction_count;
+   m_last_cycle_count = cycle_count;
+   for (UInt32 i = 0; i < CpiStack::NUM_COMPONENTS; i++)
+   {
+      UInt64 cycles = m_cpi_stack[i];
+      p.cpi_stack[i] += (cycles >= m_last_cpi_stack[i]) ? (cycles - m_last_cpi_stack[i]) : cycles;
+      m_last_cpi_stack[i] = cycles;
+   }
+
+   StatsRegistry* stats = Sim()->getStatsRegistry();
+   if (stats)
+   {
+      vector<double> counters;
+      stats->getCounterValues(m_tile_id, counters);
+      m_last_counters.resize(counters.size(), 0);
+      p.counters.resize(counters.size(), 0);
+      for (UInt32 i = 0; i < counters.size(); i++)
+      {
+         p.counters[i] += (counters[i] >= m_last_counters[i]) ? (counters[i] - m_last_counters[i]) : counters[i];
+         m_last_counters[i] = counters[i];
+      }
+   }
+
+   m_interval_vectors.push_back(interval_vector);
+   m_interval_phases.push_back(phase);
+   m_interval_starts.push_back(instruction_count);
+}
+
+UInt32
+PhaseDetector::getRepresentativeInterval(UInt32 phase) const
+{
+   UInt32 representative = 0;
+   double min_distance = -1;
+   for (UInt32 i = 0; i < m_interval_phases.size(); i++)
+   {
+      if (m_interval_phases[i] != phase)
+         continue;
+      double distance = getDistance(m_interval_vectors[i], m_phases[phase].centroid);
+      if ((min_distance < 0) || (distance < min_distance))
+      {
+         representative = i;
+         min_distance = distance;
+      }
+   }
+   return representative;
+}
+
+void
+PhaseDetector::outputSummary(ostream& os)
+{
+   if (!m_flushed && (m_num_instructions > 0))
+      endInterval();
+   m_flushed = true;
+
+   os << "    Phases: " << m_phases.size() << " in " << m_interval_phases.size() << " intervals" << endl;
+   for (UInt32 i = 0; i < m_phases.size(); i++)
+   {
+      const Phase& p = m_phases[i];
+      os << "      Phase " << i << ": Intervals " << p.num_intervals
+         << ", IPC " << ((p.cycles > 0) ? ((double) p.instructions / p.cycles) : 0.0)
+         << ", Representative Interval " << getRepresentativeInterval(i) << endl;
+   }
+}
+
+void
+PhaseDetector::write(const string& prefix)
+{
+   ostringstream filename;
+   filename << prefix << "." << m_tile_id << ".csv";
+   FILE* file = fopen(Config::getSingleton()->formatOutputFileName(filename.str()).c_str(), "w");
+   LOG_ASSERT_ERROR(file, "Could not open %s", filename.str().c_str());
+
+   vector<string> names;
+   if (Sim()->getStatsRegistry())
+      Sim()->getStatsRegistry()->getCounterNames(m_tile_id, names);
+   fprintf(file, "phase,intervals,weight,representative_interval,representative_start,instructions,cycles,ipc");
+   for (UInt32 i = 0; i < CpiStack::NUM_COMPONENTS; i++)
+      fprintf(file, ",cpi_%s", CpiStack::getName(i));
+   for (UInt32 i = 0; i < names.size(); i++)
+      fprintf(file, ",%s", names[i].c_str());
+   fprintf(file, "\n");
+
+   for (UInt32 i = 0; i < m_phases.size(); i++)
+   {
+      const Phase& p = m_phases[i];
+      UInt32 representative = getRepresentativeInterval(i);
+      fprintf(file, "%u,%llu,%g,%u,%llu,%llu,%llu,%g", i, (unsigned long long) p.num_intervals,
+              ((double) p.num_intervals) / m_interval_phases.size(), representative,
+              (unsigned long long) m_interval_starts[representative],
+              (unsigned long long) p.instructions, (unsigned long long) p.cycles,
+              (p.cycles > 0) ? ((double) p.instructions / p.cycles) : 0.0);
+      for (UInt32 j = 0; j < CpiStack::NUM_COMPONENTS; j++)
+         fprintf(file, ",%g", (p.instructions > 0) ? ((double) p.cpi_stack[j] / p.instructions) : 0.0);
+      for (UInt32 j = 0; j < names.size(); j++)
+         fprintf(file, ",%g", (j < p.counters.size()) ? p.counters[j] : 0.0);
+      fprintf(file, "\n");
+   }
+   fclose(file);
+
+   ostringstream sequence_filename;
+   sequence_filename << prefix << "_sequence." << m_tile_id << ".dat";
+   file = fopen(Config::getSingleton()->formatOutputFileName(sequence_filename.str()).c_str(), "w");
+   LOG_ASSERT_ERROR(file, "Could not open %s", sequence_filename.str().c_str());
+   fprintf(file, "# <interval> <start instruction> <phase>\n");
+   for (UInt32 i = 0; i < m_interval_phases.size(); i++)
+      fprintf(file, "%u %llu %u\n", i, (unsigned long long) m_interval_starts[i], m_interval_phases[i]);
+   fclose(file);
+}
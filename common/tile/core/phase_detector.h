@@ -0,0 +1,113 @@
+#ifndef PHASE_DETECTOR_H
+#define PHASE_DETECTOR_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include "fixed_types.h"
+#include "basic_block.h"
+#include "cpi_stack.h"
+
+/*
+  Phases of the instruction stream of a core ([core/phase_detection]). The
+  basic blocks the core model processes are counted, by instructions, in a
+  basic block vector per interval of 'interval' instructions, projected on
+  'dimensions' random +1/-1 directions (a hash of the address of the
+  block) so that it takes no memory per block. At the end of an interval
+  the vector, divided by the instructions, goes to the nearest phase if its
+  mean distance per dimension to the centroid is below 'threshold' (the
+  centroid moves to the mean of the intervals of the phase), and starts a
+  new phase otherwise, up to 'max_phases'.
+
+  The counters of the tile (the stats registry, [general] stats_file, and
+  the instructions, cycles and CPI stack of the core) are read at the end
+  of every interval, and what they counted in it is added to its phase. Each phase
+  also has a representative interval, the one nearest to its centroid,
+  and a weight, its fraction of the intervals: simulating the
+  representative intervals in detail (SimPoint) stands for the whole run.
+
+  Only used by the thread that models the instructions of the core.
+ */
+class PhaseDetector
+{
+public:
+   PhaseDetector(tile_id_t tile_id, const UInt64* instruction_count, const UInt64* cycle_count,
+                 const UInt64* cpi_stack);
+   ~PhaseDetector();
+
+   // A basic block was modeled
+   void addBasicBlock(BasicBlock* basic_block)
+   {
+      if (basic_block->empty())
+         return;
+      UInt64 hash = getHash((*basic_block)[0]->getAddress());
+      SInt64 num_instructions = basic_block->size();
+      for (UInt32 i = 0; i < m_dimensions; i++)
+         m_vector[i] += ((hash >> i) & 1) ? num_instructions : -num_instructions;
+      m_num_instructions += num_instructions;
+      if (m_num_instructions >= m_interval)
+         endInterval();
+   }
+
+   UInt32 getNumPhases() const { return m_phases.size(); }
+
+   // The interval in progress is classified first
+   void outputSummary(std::ostream& os);
+   // <prefix>.<tile_id>.csv: the counters of every phase, and
+   // <prefix>_sequence.<tile_id>.dat: the phase of every interval
+   void write(const std::string& prefix);
+
+private:
+   struct Phase
+   {
+      std::vector<double> centroid;
+      UInt64 num_intervals;
+      UInt64 instructions;
+      UInt64 cycles;
+      UInt64 cpi_stack[CpiStack::NUM_COMPONENTS];
+      std::vector<double> counters;
+   };
+
+   tile_id_t m_tile_id;
+   UInt64 m_interval;
+   UInt32 m_dimensions;
+   double m_threshold;
+   UInt32 m_max_phases;
+
+   const UInt64* m_instruction_count;
+   const UInt64* m_cycle_count;
+   const UInt64* m_cpi_stack;
+
+   // The interval in progress
+   std::vector<SInt64> m_vector;
+   UInt64 m_num_instructions;
+
+   std::vector<Phase> m_phases;
+   // Of every interval: its projected vector, its phase and the instruction
+   // count of the core at its start
+   std::vector<std::vector<double> > m_interval_vectors;
+   std::vector<UInt32> m_interval_phases;
+   std::vector<UInt64> m_interval_starts;
+
+   // Counters at the end of the last interval
+   UInt64 m_last_instruction_count;
+   UInt64 m_last_cycle_count;
+   UInt64 m_last_cpi_stack[CpiStack::NUM_COMPONENTS];
+   std::vector<double> m_last_counters;
+   bool m_flushed;
+
+   static UInt64 getHash(IntPtr address)
+   {
+      // A 64-bit mix (splitmix64), one bit per dimension
+      UInt64 x = address + 0x9E3779B97F4A7C15ULL;
+      x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+      return x ^ (x >> 31);
+   }
+   double getDistance(const std::vector<double>& a, const std::vector<double>& b) const;
+   void endInterval();
+   UInt32 getRepresentativeInterval(UInt32 phase) const;
+};
+
+#endif
@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <limits.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "spin_detector.h"
+#include "simulator.h"
+#include "config.h"
+#include "log.h"
+
+using namespace std;
+
+SpinDetector::SpinDetector(tile_id_t tile_id)
+   : m_tile_id(tile_id)
+   , m_start_generation(0)
+   , m_generation(0)
+   , m_invalidation_time(0)
+   , m_num_spins(0)
+   , m_num_wakeups(0)
+   , m_num_timeouts(0)
+   , m_skipped_cycles(0)
+   , m_host_wait_time(0)
+{
+   try
+   {
+      m_min_iterations = Sim()->getCfg()->getInt("core/spin_detection/min_iterations", 16);
+      m_max_loop_blocks = Sim()->getCfg()->getInt("core/spin_detection/max_loop_blocks", 8);
+      m_timeout = Sim()->getCfg()->getInt("core/spin_detection/timeout", 1000);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read [core/spin_detection] parameters from the cfg file");
+   }
+   LOG_ASSERT_ERROR(m_min_iterations > 0, "Spin detection min_iterations must be > 0");
+   LOG_ASSERT_ERROR(m_max_loop_blocks > 0, "Spin detection max_loop_blocks must be > 0");
+   LOG_ASSERT_ERROR(m_timeout > 0, "Spin detection timeout must be > 0");
+
+   reset();
+}
+
+SpinDetector::~SpinDetector()
+{}
+
+SpinDetector*
+SpinDetector::create(tile_id_t tile_id)
+{
+   bool enabled = false;
+   try
+   {
+      enabled = Sim()->getCfg()->getBool("core/spin_detection/enabled", false);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read core/spin_detection/enabled from the cfg file");
+   }
+   if (!enabled || !Config::getSingleton()->isApplicationTile(tile_id))
+      return NULL;
+   return new SpinDetector(tile_id);
+}
+
+void
+SpinDetector::reset()
+{
+   m_head_block = 0;
+   m_num_blocks = 0;
+   m_num_iterations = 0;
+   m_lines.clear();
+   m_iteration_lines.clear();
+}
+
+void
+SpinDetector::startCandidate(IntPtr basic_block)
+{
+   m_head_block = basic_block;
+   m_num_blocks = 1;
+   m_num_iterations = 0;
+   m_lines.clear();
+   m_iteration_lines.clear();
+   m_start_generation = __sync_fetch_and_add(&m_generation, 0);
+}
+
+bool
+SpinDetector::addBasicBlock(IntPtr basic_block)
+{
+   if (basic_block != m_head_block)
+   {
+      if ((m_head_block == 0) || (++ m_num_blocks > m_max_loop_blocks))
+         startCandidate(basic_block);
+      return false;
+   }
+
+   // One more iteration, it must load the lines of the first one
+   sort(m_iteration_lines.begin(), m_iteration_lines.end());
+   if (m_iteration_lines.empty() ||
+       ((m_num_iterations > 0) && (m_iteration_lines != m_lines)))
+   {
+      startCandidate(basic_block);
+      return false;
+   }
+   if (m_num_iterations == 0)
+      m_lines.swap(m_iteration_lines);
+   m_iteration_lines.clear();
+   m_num_blocks = 1;
+   m_num_iterations ++;
+   return (m_num_iterations >= m_min_iterations);
+}
+
+void
+SpinDetector::addMemoryAccess(IntPtr line_address, bool is_write)
+{
+   if (m_head_block == 0)
+      return;
+   if (is_write)
+   {
+      reset();
+      return;
+   }
+   if (find(m_iteration_lines.begin(), m_iteration_lines.end(), line_address) == m_iteration_lines.end())
+      m_iteration_lines.push_back(line_address);
+}
+
+UInt64
+SpinDetector::wait(UInt64 cycle_count)
+{
+   m_num_spins ++;
+
+   struct timespec start;
+   clock_gettime(CLOCK_MONOTONIC, &start);
+
+   struct timespec timeout;
+   timeout.tv_sec = m_timeout / 1000000;
+   timeout.tv_nsec = (m_timeout % 1000000) * 1000;
+   // Returns at once if the generation has moved since the start of the candidate
+   syscall(SYS_futex, (void*) &m_generation, FUTEX_WAIT, m_start_generation, &timeout, NULL, 0);
+
+   struct timespec end;
+   clock_gettime(CLOCK_MONOTONIC, &end);
+   m_host_wait_time += (end.tv_sec - start.tv_sec) * 1000000000ULL + end.tv_nsec - start.tv_nsec;
+
+   UInt64 skipped_cycles = 0;
+   if (__sync_fetch_and_add(&m_generation, 0) != m_start_generation)
+   {
+      m_num_wakeups ++;
+      UInt64 invalidation_time = m_invalidation_time;
+      if (invalidation_time > cycle_count)
+         skipped_cycles = invalidation_time - cycle_count;
+   }
+   else
+   {
+      m_num_timeouts ++;
+   }
+   m_skipped_cycles += skipped_cycles;
+
+   // The loop runs until it sees the write, then starts over
+   reset();
+   return skipped_cycles;
+}
+
+void
+SpinDetector::notifyInvalidation(UInt64 time)
+{
+   m_invalidation_time = time;
+   __sync_fetch_and_add(&m_generation, 1);
+   syscall(SYS_futex, (void*) &m_generation, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+void
+SpinDetector::outputSummary(ostream& os)
+{
+   os << "  Spin Detection:" << endl;
+   os << "    Spin Loops Detected: " << m_num_spins << endl;
+   os << "    Woken by Invalidation: " << m_num_wakeups << endl;
+   os << "    Timeouts: " << m_num_timeouts << endl;
+   os << "    Skipped Cycles: " << m_skipped_cycles << endl;
+   os << "    Host Wait Time (in us): " << m_host_wait_time / 1000 << endl;
+}
@@ -0,0 +1,77 @@
+#ifndef SPIN_DETECTOR_H
+#define SPIN_DETECTOR_H
+
+#include <vector>
+#include <ostream>
+
+#include "fixed_types.h"
+
+/*
+  Spin loops of an application tile ([core/spin_detection]). An iteration
+  of a candidate loop ends when its first basic block runs again, after at
+  most 'max_loop_blocks' blocks. The loop is a spin loop if it has made
+  'min_iterations' iterations with no store, each loading the same lines
+  (a flag or a lock polled until another tile writes it).
+
+  The app thread then waits on the host until a line of the tile is
+  invalidated or flushed by the directory (the write of the other tile), or
+  for 'timeout' (in us, so that a spin that is not released by a write, an
+  eviction or a thread at a barrier, still makes progress). The core clock
+  jumps to the time of the invalidation, as a sync stall, instead of
+  modeling every iteration until then. Any invalidation of the tile since
+  the start of the candidate wakes the thread, a wakeup is never lost.
+
+  addBasicBlock() and addMemoryAccess() are only called by the app thread
+  of the tile, notifyInvalidation() by its sim thread.
+ */
+class SpinDetector
+{
+public:
+   SpinDetector(tile_id_t tile_id);
+   ~SpinDetector();
+
+   // NULL unless core/spin_detection/enabled
+   static SpinDetector* create(tile_id_t tile_id);
+
+   // A basic block starts, true if the loop it heads has become a spin loop
+   bool addBasicBlock(IntPtr basic_block);
+   void addMemoryAccess(IntPtr line_address, bool is_write);
+
+   // Suspends the app thread of a spin loop (see above), returns the cycles
+   // the clock at 'cycle_count' must skip
+   UInt64 wait(UInt64 cycle_count);
+
+   // A line of the tile was invalidated at 'time' (in core cycles)
+   void notifyInvalidation(UInt64 time);
+
+   void outputSummary(std::ostream& os);
+
+private:
+   tile_id_t m_tile_id;
+   UInt32 m_min_iterations;
+   UInt32 m_max_loop_blocks;
+   UInt64 m_timeout;
+
+   // The candidate loop
+   IntPtr m_head_block;
+   UInt32 m_num_blocks;
+   UInt32 m_num_iterations;
+   std::vector<IntPtr> m_lines;
+   std::vector<IntPtr> m_iteration_lines;
+   int m_start_generation;
+
+   // Futex word, incremented by every invalidation, and the time of the last one
+   volatile int m_generation;
+   volatile UInt64 m_invalidation_time;
+
+   UInt64 m_num_spins;
+   UInt64 m_num_wakeups;
+   UInt64 m_num_timeouts;
+   UInt64 m_skipped_cycles;
+   UInt64 m_host_wait_time;
+
+   void reset();
+   void startCandidate(IntPtr basic_block);
+};
+
+#endif
@@ -1,26 +1,149 @@
+#include <algorithm>
+
 #include "address_home_lookup.h"
+#include "simulator.h"
+#include "config.h"
+#include "utils.h"
 #include "log.h"
 
-AddressHomeLookup::AddressHomeLookup(UInt32 ahl_param, vector<tile_id_t>& tile_list, UInt32 cache_line_size):
+LockedHash AddressHomeLookup::_first_touch_page_table(1024);
+
+AddressHomeLookup::AddressHomeLookup(UInt32 ahl_param, vector<tile_id_t>& tile_list, UInt32 cache_line_size, tile_id_t tile_id):
    _ahl_param(ahl_param),
    _tile_list(tile_list),
-   _cache_line_size(cache_line_size)
+   _cache_line_size(cache_line_size),
+   _tile_id(tile_id)
 {
    LOG_ASSERT_ERROR((1 << _ahl_param) >= (SInt32) _cache_line_size,
                     "[1 << AHL param](%u) must be >= [Cache Block Size](%u)",
                     1 << _ahl_param, _cache_line_size);
    _total_modules = tile_list.size();
+
+   string type;
+   UInt32 page_size = 0;
+   try
+   {
+      type = Sim()->getCfg()->getString("address_home_lookup/type", "line_interleaved");
+      page_size = Sim()->getCfg()->getInt("address_home_lookup/page_size", 4096);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read address_home_lookup parameters from the cfg file");
+   }
+   _type = parseType(type);
+
+   LOG_ASSERT_ERROR(isPower2(page_size) && (page_size >= _cache_line_size),
+                    "address_home_lookup/page_size(%u) must be a power of 2 and >= [Cache Block Size](%u)",
+                    page_size, _cache_line_size);
+   _page_size_log2 = max<SInt32>(floorLog2(page_size), _ahl_param);
+
+   // Fold the line address in chunks as wide as the module number
+   _xor_fold_bits = max<SInt32>(ceilLog2(_total_modules), 1);
+   
+   if (_type == FIRST_TOUCH)
+   {
+      // The page table lives in this process
+      if (Config::getSingleton()->getProcessCount() > 1)
+      {
+         LOG_PRINT_WARNING("First-touch home lookup needs all tiles in one process, using page interleaving");
+         _type = PAGE_INTERLEAVED;
+      }
+      else
+      {
+         // Tiles that are not in the module list get a module picked from
+         // their id, in their socket if it has modules (the memory of a
+         // socket is local to it)
+         Config* config = Config::getSingleton();
+         vector<vector<UInt32> > socket_modules(config->getNumSockets());
+         for (UInt32 i = 0; i < _total_modules; i++)
+            socket_modules[config->getSocketId(_tile_list[i])].push_back(i);
+         _first_touch_module_num.resize(config->getTotalTiles());
+         for (UInt32 i = 0; i < _first_touch_module_num.size(); i++)
+         {
+            const vector<UInt32>& modules = socket_modules[config->getSocketId(i)];
+            _first_touch_module_num[i] = modules.empty() ? (i % _total_modules) : modules[i % modules.size()];
+         }
+         for (UInt32 i = 0; i < _total_modules; i++)
+            _first_touch_module_num[_tile_list[i]] = i;
+      }
+   }
 }
 
 AddressHomeLookup::~AddressHomeLookup()
 {}
 
+AddressHomeLookup::Type
+AddressHomeLookup::parseType(string type)
+{
+   if (type == "line_interleaved")
+      return LINE_INTERLEAVED;
+   else if (type == "page_interleaved")
+      return PAGE_INTERLEAVED;
+   else if (type == "xor_interleaved")
+      return XOR_INTERLEAVED;
+   else if (type == "first_touch")
+      return FIRST_TOUCH;
+   else
+   {
+      LOG_PRINT_ERROR("Unrecognized address home lookup type(%s)", type.c_str());
+      return NUM_TYPES;
+   }
+}
+
 tile_id_t
 AddressHomeLookup::getHome(IntPtr address) const
 {
-   SInt32 module_num = (address >> _ahl_param) % _total_modules;
+   SInt32 module_num = 0;
+   switch (_type)
+   {
+   case LINE_INTERLEAVED:
+      module_num = (address >> _ahl_param) % _total_modules;
+      break;
+
+   case PAGE_INTERLEAVED:
+      module_num = (address >> _page_size_log2) % _total_modules;
+      break;
+
+   case XOR_INTERLEAVED:
+      {
+         UInt64 block_num = address >> _ahl_param;
+         UInt64 hash = 0;
+         while (block_num != 0)
+         {
+            hash ^= block_num & ((1ULL << _xor_fold_bits) - 1);
+            block_num >>= _xor_fold_bits;
+         }
+         module_num = hash % _total_modules;
+      }
+      break;
+
+   case FIRST_TOUCH:
+      module_num = getFirstTouchModuleNum(address);
+      break;
+
+   default:
+      LOG_PRINT_ERROR("Unrecognized address home lookup type(%u)", _type);
+      break;
+   }
    LOG_ASSERT_ERROR(0 <= module_num && module_num < (SInt32) _total_modules, "module_num(%i), total_modules(%u)", module_num, _total_modules);
    
    LOG_PRINT("address(%#lx), module_num(%i)", address, module_num);
    return (_tile_list[module_num]);
 }
+
+UInt32
+AddressHomeLookup::getFirstTouchModuleNum(IntPtr address) const
+{
+   UInt64 page_num = address >> _page_size_log2;
+
+   pair<bool,UInt64> entry = _first_touch_page_table.find(page_num);
+   if (!entry.first)
+   {
+      // Another tile may have touched the page in between.
+      // The insert keeps the first value, so read it back
+      _first_touch_page_table.insert(page_num, _tile_id);
+      entry = _first_touch_page_table.find(page_num);
+      assert(entry.first);
+   }
+   return _first_touch_module_num[entry.second];
+}
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <vector>
+#include <string>
 using namespace std;
 
 #include "fixed_types.h"
+#include "locked_hash.h"
 
 /* 
  * TODO abstract MMU stuff to a configure file to allow
@@ -18,10 +20,32 @@ using namespace std;
  * Maybe allow the ability to have public and private memory space?
  */
 
+/*
+ * Mapping policies (address_home_lookup/type)
+ *  line_interleaved: consecutive cache lines go to consecutive modules
+ *  page_interleaved: consecutive pages go to consecutive modules
+ *  xor_interleaved:  lines are spread by XOR-folding the line address, so that
+ *                    power-of-2 strides do not all map to the same module
+ *  first_touch:      a page goes to the tile that first looks it up (or, if that
+ *                    tile is not in the module list, to a module of its socket picked
+ *                    from its id).
+ *                    The first-touch page table is shared by all the AHLs, so
+ *                    every tile sees the same home
+ */
+
 class AddressHomeLookup
 {
 public:
-   AddressHomeLookup(UInt32 ahl_param, vector<tile_id_t>& tile_list, UInt32 cache_line_size);
+   enum Type
+   {
+      LINE_INTERLEAVED = 0,
+      PAGE_INTERLEAVED,
+      XOR_INTERLEAVED,
+      FIRST_TOUCH,
+      NUM_TYPES
+   };
+
+   AddressHomeLookup(UInt32 ahl_param, vector<tile_id_t>& tile_list, UInt32 cache_line_size, tile_id_t tile_id);
    ~AddressHomeLookup();
    tile_id_t getHome(IntPtr address) const;
 
@@ -30,4 +54,17 @@ private:
    vector<tile_id_t> _tile_list;
    UInt32 _total_modules;
    UInt32 _cache_line_size;
+   tile_id_t _tile_id;
+
+   Type _type;
+   UInt32 _page_size_log2;
+   UInt32 _xor_fold_bits;
+
+   // Module of each tile when it is the first to touch a page
+   vector<UInt32> _first_touch_module_num;
+   // Page -> tile that first looked it up
+   static LockedHash _first_touch_page_table;
+
+   static Type parseType(string type);
+   UInt32 getFirstTouchModuleNum(IntPtr address) const;
 };
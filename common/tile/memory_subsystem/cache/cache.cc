@@ -1,9 +1,15 @@
+#include <algorithm>
+#include <typeinfo>
+
 #include "simulator.h"
+#include "stats_registry.h"
+#include "statistics_manager.h"
 #include "cache.h"
 #include "cache_set.h"
 #include "cache_line_info.h"
 #include "cache_replacement_policy.h"
 #include "cache_hash_fn.h"
+#include "host_memory.h"
 #include "utils.h"
 #include "log.h"
 
@@ -21,7 +27,8 @@ Cache::Cache(string name,
              CacheHashFn* hash_fn,
              UInt32 access_delay,
              float frequency,
-             bool track_miss_types)
+             bool track_miss_types,
+             CacheCompressor* compressor)
    : _enabled(false)
    , _name(name)
    , _cache_category(cache_category)
@@ -29,20 +36,49 @@ Cache::Cache(string name,
    , _cache_size(k_KILO * cache_size)
    , _associativity(associativity)
    , _line_size(line_size)
+   , _num_tag_ways(compressor ? (associativity * compressor->getTagFactor()) : associativity)
+   , _compressor(compressor)
+   , _total_fills(0)
+   , _total_compressed_fills(0)
+   , _total_fill_stored_bytes(0)
+   , _total_fill_set_lines(0)
+   , _total_evictions_for_space(0)
+   , _total_decompressions(0)
    , _replacement_policy(replacement_policy)
    , _hash_fn(hash_fn)
+   , _miss_type_tracker(NULL)
+   , _num_line_removals(0)
    , _power_model(NULL)
    , _area_model(NULL)
    , _track_miss_types(track_miss_types)
+   , _last_access_missed(false)
+   , _last_miss_type(INVALID_MISS_TYPE)
+   , _reuse_distance_profiler(NULL)
+   , _line_utilization_tracker(NULL)
+   , _data_profiler(Sim()->getDataProfiler())
+   , _data_profiler_index(0)
 {
    _num_sets = _cache_size / (_associativity * _line_size);
    _log_line_size = floorLog2(_line_size);
+   _modulo_set_index = (typeid(*_hash_fn) == typeid(CacheHashFn)) && isPower2(_num_sets);
+   _set_index_mask = _num_sets - 1;
+
+   _set_sampling_interval = Sim()->getCfg()->getInt("cache_statistics/set_sampling_interval", 1);
+   LOG_ASSERT_ERROR(isPower2(_set_sampling_interval),
+                    "Set sampling interval(%u) must be a power of 2", _set_sampling_interval);
+   // Sample at least one set
+   _set_sampling_interval = std::min(_set_sampling_interval, _num_sets);
+   _set_sampling_mask = _set_sampling_interval - 1;
    
+   // Timing-only caches keep no copy of the data
+   _store_data = !Config::getSingleton()->areCachesTimingOnly();
+   _caching_protocol_type = caching_protocol_type;
+   _cache_level = cache_level;
+   // The sets are allocated on first use (see getSet)
    _sets = new CacheSet*[_num_sets];
    for (UInt32 i = 0; i < _num_sets; i++)
-   {
-      _sets[i] = new CacheSet(i, caching_protocol_type, cache_level, _replacement_policy, _associativity, _line_size);
-   }
+      _sets[i] = NULL;
+   _line_data = _store_data ? (char*) HostMemory::allocateArray(getDataArraySize()) : NULL;
 
    if (Config::getSingleton()->getEnablePowerModeling())
    {
@@ -55,6 +91,44 @@ Cache::Cache(string name,
             associativity, access_delay, frequency);
    }
 
+   if (_track_miss_types)
+   {
+      UInt32 max_tracked_addresses = Sim()->getCfg()->getInt("miss_type_tracking/max_addresses", 0);
+      _miss_type_tracker = new MissTypeTracker(max_tracked_addresses);
+   }
+
+   bool reuse_distance_profiling = false;
+   float reuse_distance_sampling_rate = 0;
+   UInt32 reuse_distance_max_entries = 0;
+   try
+   {
+      reuse_distance_profiling = Sim()->getCfg()->getBool("cache_statistics/reuse_distance_profiling", false);
+      reuse_distance_sampling_rate = Sim()->getCfg()->getFloat("cache_statistics/reuse_distance_sampling_rate", 0.01);
+      reuse_distance_max_entries = Sim()->getCfg()->getInt("cache_statistics/reuse_distance_max_entries", 8192);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read [cache_statistics] reuse distance parameters from the cfg file");
+   }
+   if (reuse_distance_profiling && (_name == "L2"))
+      _reuse_distance_profiler = new ReuseDistanceProfiler(reuse_distance_sampling_rate, reuse_distance_max_entries);
+
+   string shadow_l2_caches;
+   try
+   {
+      shadow_l2_caches = Sim()->getCfg()->getString("cache_statistics/shadow_l2_caches", "");
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read [cache_statistics] shadow_l2_caches from the cfg file");
+   }
+   if (_name == "L2")
+      ShadowTagArray::create(shadow_l2_caches, _line_size, _shadow_tag_arrays);
+
+   _line_utilization_tracker = LineUtilizationTracker::create(_line_size);
+   if (_data_profiler)
+      _data_profiler_index = _data_profiler->registerCache(_name);
+
    // Initialize Cache Counters
    // Hit/miss counters
    initializeMissCounters();
@@ -68,9 +142,15 @@ Cache::Cache(string name,
 
 Cache::~Cache()
 {
-   for (SInt32 i = 0; i < (SInt32) _num_sets; i++)
+   for (UInt32 i = 0; i < _num_sets; i++)
       delete _sets[i];
    delete [] _sets;
+   HostMemory::freeArray(_line_data, getDataArraySize());
+   delete _miss_type_tracker;
+   delete _reuse_distance_profiler;
+   for (UInt32 i = 0; i < _shadow_tag_arrays.size(); i++)
+      delete _shadow_tag_arrays[i];
+   delete _line_utilization_tracker;
 }
 
 void
@@ -80,13 +160,14 @@ Cache::accessCacheLine(IntPtr address, AccessType access_type, Byte* buf, UInt32
              address, (access_type == 0) ? "LOAD": "STORE", num_bytes);
    assert((buf == NULL) == (num_bytes == 0));
 
-   CacheSet* set = getSet(address);
+   UInt32 set_num = getSetNum(address);
+   CacheSet* set = getSet(set_num);
    IntPtr tag = getTag(address);
    UInt32 line_offset = getLineOffset(address);
    UInt32 line_index = -1;
   
    // FIXME: This is an expensive operation. Remove if possible 
-   __attribute(__unused__) CacheLineInfo* cache_line_info = set->find(tag, &line_index);
+   CacheLineInfo* cache_line_info = set->find(tag, &line_index);
    LOG_ASSERT_ERROR(cache_line_info, "Address(%#lx)", address);
 
    if (access_type == LOAD)
@@ -94,7 +175,11 @@ Cache::accessCacheLine(IntPtr address, AccessType access_type, Byte* buf, UInt32
    else
       set->write_line(line_index, line_offset, buf, num_bytes);
 
-   if (_enabled)
+   // Whole lines are fills and writebacks, not accesses of the core
+   if (_line_utilization_tracker && (num_bytes > 0) && (num_bytes < _line_size))
+      cache_line_info->markWords(_line_utilization_tracker->getWordMask(line_offset, num_bytes));
+
+   if (_enabled && isSampledSet(set_num))
    {
       // Update data array reads/writes
       if (access_type == LOAD)
@@ -103,8 +188,7 @@ Cache::accessCacheLine(IntPtr address, AccessType access_type, Byte* buf, UInt32
          _data_array_writes ++;
  
       // Update dynamic energy counters
-      if (_power_model)
-         _power_model->updateDynamicEnergy();
+      updateDynamicEnergy();
    }
    LOG_PRINT("accessCacheLine: Address(%#lx), AccessType(%s), Num Bytes(%u) end",
              address, (access_type == 0) ? "LOAD": "STORE", num_bytes);
@@ -116,14 +200,39 @@ Cache::insertCacheLine(IntPtr inserted_address, CacheLineInfo* inserted_cache_li
 {
    LOG_PRINT("insertCacheLine: Address(%#lx) start", inserted_address);
 
-   CacheSet* set = getSet(inserted_address);
+   UInt32 set_num = getSetNum(inserted_address);
+   CacheSet* set = getSet(set_num);
+
+   bool sample_compression = _compressor && _enabled && isSampledSet(set_num);
+   if (sample_compression)
+      _total_fill_set_lines += set->getNumValidLines();
 
    // Write into the data array
    set->insert(inserted_cache_line_info, fill_buf,
                eviction, evicted_cache_line_info, writeback_buf);
+
+   if (sample_compression)
+   {
+      UInt32 line_index = 0;
+      set->find(getTag(inserted_address), &line_index);
+      UInt32 stored_size = set->getStoredSize(line_index);
+      _total_fills ++;
+      _total_fill_stored_bytes += stored_size;
+      if (stored_size < _line_size)
+         _total_compressed_fills ++;
+   }
   
    // Evicted address 
    *evicted_address = getAddressFromTag(evicted_cache_line_info->getTag());
+   if (*eviction)
+      _num_line_removals ++;
+
+   // Fast path for the sets that are not sampled
+   if (!isSampledSet(set_num))
+   {
+      LOG_PRINT("insertCacheLine: Address(%#lx) end", inserted_address);
+      return;
+   }
 
    // Update Cache Line State Counters and address set for the evicted line
    if (*eviction)
@@ -132,19 +241,22 @@ Cache::insertCacheLine(IntPtr inserted_address, CacheLineInfo* inserted_cache_li
       assert(*evicted_address != INVALID_ADDRESS);
 
       if (_track_miss_types)
-         _evicted_address_set.insert(*evicted_address);
+      {
+         UInt8 flags = _miss_type_tracker->getFlags(*evicted_address);
+         _miss_type_tracker->setFlags(*evicted_address, flags | MissTypeTracker::EVICTED);
+      }
 
       // Update exclusive/sharing counters
       updateCacheLineStateCounters(evicted_cache_line_info->getCState(), CacheState::INVALID);
-   }
 
-   // Clear the miss type tracking sets for this address
-   if (_track_miss_types)
-      clearMissTypeTrackingSets(inserted_address);
+      if (_enabled && _line_utilization_tracker)
+         _line_utilization_tracker->recordRemoval(evicted_cache_line_info->getCState(), evicted_cache_line_info->getWordBitmap());
+   }
 
-   // Add to fetched set for tracking miss type
+   // Clear the miss type tracking flags for this address
+   // and mark it as fetched
    if (_track_miss_types)
-      _fetched_address_set.insert(inserted_address);
+      markFetchedForMissTypeTracking(inserted_address);
 
    // Update exclusive/sharing counters
    updateCacheLineStateCounters(CacheState::INVALID, inserted_cache_line_info->getCState());
@@ -179,41 +291,120 @@ Cache::insertCacheLine(IntPtr inserted_address, CacheLineInfo* inserted_cache_li
       _data_array_writes ++;
 
       // Update dynamic energy counters
-      if (_power_model)
-         _power_model->updateDynamicEnergy();
+      updateDynamicEnergy();
    }
    
    LOG_PRINT("insertCacheLine: Address(%#lx) end", inserted_address);
 }
 
+bool
+Cache::evictCacheLineForSpace(IntPtr inserted_address, IntPtr* evicted_address,
+                              CacheLineInfo* evicted_cache_line_info, Byte* writeback_buf)
+{
+   if (!_compressor)
+      return false;
+
+   UInt32 set_num = getSetNum(inserted_address);
+   if (!getSet(set_num)->evictForSpace(getTag(inserted_address), evicted_cache_line_info, writeback_buf))
+      return false;
+
+   *evicted_address = getAddressFromTag(evicted_cache_line_info->getTag());
+   _num_line_removals ++;
+   LOG_PRINT("evictCacheLineForSpace: Address(%#lx) evicted for Address(%#lx)", *evicted_address, inserted_address);
+
+   if (!isSampledSet(set_num))
+      return true;
+
+   if (_track_miss_types)
+   {
+      UInt8 flags = _miss_type_tracker->getFlags(*evicted_address);
+      _miss_type_tracker->setFlags(*evicted_address, flags | MissTypeTracker::EVICTED);
+   }
+   updateCacheLineStateCounters(evicted_cache_line_info->getCState(), CacheState::INVALID);
+
+   if (_enabled)
+   {
+      if (_line_utilization_tracker)
+         _line_utilization_tracker->recordRemoval(evicted_cache_line_info->getCState(), evicted_cache_line_info->getWordBitmap());
+
+      _data_array_reads ++;
+      _total_evictions ++;
+      _total_evictions_for_space ++;
+      if ( (_write_policy == WRITE_BACK) && (CacheState(evicted_cache_line_info->getCState()).dirty()) )
+         _total_dirty_evictions ++;
+      updateDynamicEnergy();
+   }
+   return true;
+}
+
+UInt32
+Cache::getDecompressionLatency(IntPtr address)
+{
+   if (!_compressor)
+      return 0;
+
+   UInt32 set_num = getSetNum(address);
+   CacheSet* set = getSet(set_num);
+   UInt32 line_index = 0;
+   if (!set->find(getTag(address), &line_index) || (set->getStoredSize(line_index) == _line_size))
+      return 0;
+
+   if (_enabled && isSampledSet(set_num))
+      _total_decompressions ++;
+   return _compressor->getDecompressionLatency();
+}
+
+UInt32
+Cache::getCompressionLatency(IntPtr address)
+{
+   if (!_compressor)
+      return 0;
+
+   CacheSet* set = getSet(getSetNum(address));
+   UInt32 line_index = 0;
+   if (!set->find(getTag(address), &line_index) || (set->getStoredSize(line_index) == _line_size))
+      return 0;
+   return _compressor->getCompressionLatency();
+}
+
 // Single line cache access at address
 void
 Cache::getCacheLineInfo(IntPtr address, CacheLineInfo* cache_line_info)
 {
    LOG_PRINT("getCacheLineInfo: Address(%#lx) start", address);
 
-   CacheLineInfo* line_info = getCacheLineInfo(address);
+   UInt32 set_num = getSetNum(address);
+   CacheLineInfo* line_info = getSet(set_num)->find(getTag(address));
 
    // Assign it to the second argument in the function (copies it over) 
    if (line_info)
       cache_line_info->assign(line_info);
 
-   if (_enabled)
+   if (_enabled && isSampledSet(set_num))
    {
       // Update tag/data array reads/writes
       _tag_array_reads ++;
       // Update dynamic energy counters
-      if (_power_model)
-         _power_model->updateDynamicEnergy();
+      updateDynamicEnergy();
    }
 
    LOG_PRINT("getCacheLineInfo: Address(%#lx) end", address);
 }
 
+bool
+Cache::probeCacheLine(IntPtr address, Byte* buf, UInt32 num_bytes)
+{
+   // A set that was never used holds no line
+   CacheSet* set = _sets[getSetNum(address)];
+   if (set == NULL)
+      return false;
+   return set->probe(getTag(address), getLineOffset(address), buf, num_bytes);
+}
+
 CacheLineInfo*
 Cache::getCacheLineInfo(IntPtr address)
 {
-   CacheSet* set = getSet(address);
+   CacheSet* set = getSet(getSetNum(address));
    IntPtr tag = getTag(address);
 
    CacheLineInfo* line_info = set->find(tag);
@@ -225,26 +416,52 @@ void
 Cache::setCacheLineInfo(IntPtr address, CacheLineInfo* updated_cache_line_info)
 {
    LOG_PRINT("setCacheLineInfo: Address(%#lx) start", address);
-   CacheLineInfo* cache_line_info = getCacheLineInfo(address);
+   UInt32 set_num = getSetNum(address);
+   CacheSet* set = getSet(set_num);
+   UInt32 line_index = -1;
+   CacheLineInfo* cache_line_info = set->find(getTag(address), &line_index);
    LOG_ASSERT_ERROR(cache_line_info, "Address(%#lx)", address);
 
-   // Update exclusive/shared counters
-   updateCacheLineStateCounters(cache_line_info->getCState(), updated_cache_line_info->getCState());
-  
-   // Update _invalidated_address_set
-   if ( (updated_cache_line_info->getCState() == CacheState::INVALID) && (_track_miss_types) )
-      _invalidated_address_set.insert(address);
+   if (isSampledSet(set_num))
+   {
+      // Update exclusive/shared counters
+      updateCacheLineStateCounters(cache_line_info->getCState(), updated_cache_line_info->getCState());
+     
+      // Mark the address as invalidated
+      if ( (updated_cache_line_info->getCState() == CacheState::INVALID) && (_track_miss_types) )
+      {
+         UInt8 flags = _miss_type_tracker->getFlags(address);
+         _miss_type_tracker->setFlags(address, flags | MissTypeTracker::INVALIDATED);
+      }
+
+      if ( _enabled && _line_utilization_tracker && (updated_cache_line_info->getCState() == CacheState::INVALID) &&
+           (cache_line_info->getCState() != CacheState::INVALID) )
+      {
+         _line_utilization_tracker->recordRemoval(cache_line_info->getCState(), cache_line_info->getWordBitmap());
+      }
+   }
+
+   if (updated_cache_line_info->getCState() == CacheState::INVALID)
+   {
+      _num_line_removals ++;
+      if (_enabled && _data_profiler && (cache_line_info->getCState() != CacheState::INVALID))
+         _data_profiler->recordInvalidation(_data_profiler_lookup, _data_profiler_index, address);
+      if (cache_line_info->getCState() != CacheState::INVALID)
+      {
+         for (UInt32 i = 0; i < _shadow_tag_arrays.size(); i++)
+            _shadow_tag_arrays[i]->invalidate(address);
+      }
+   }
 
    // Update the cache line info   
-   cache_line_info->assign(updated_cache_line_info);
+   set->setCacheLineInfo(line_index, updated_cache_line_info);
    
-   if (_enabled)
+   if (_enabled && isSampledSet(set_num))
    {
       // Update tag/data array reads/writes
       _tag_array_writes ++;
       // Update dynamic energy counters
-      if (_power_model)
-         _power_model->updateDynamicEnergy();
+      updateDynamicEnergy();
    }
    LOG_PRINT("setCacheLineInfo: Address(%#lx) end", address);
 }
@@ -297,8 +514,18 @@ Cache::MissType
 Cache::updateMissCounters(IntPtr address, Core::mem_op_t mem_op_type, bool cache_miss)
 {
    MissType miss_type = INVALID_MISS_TYPE;
-   
+
+   // The profiler samples the lines itself, in all the sets
+   if (_enabled && _reuse_distance_profiler)
+      _reuse_distance_profiler->access(address >> _log_line_size);
+   // The shadows see all the sets too
    if (_enabled)
+   {
+      for (UInt32 i = 0; i < _shadow_tag_arrays.size(); i++)
+         _shadow_tag_arrays[i]->access(address, mem_op_type == Core::WRITE);
+   }
+   
+   if (_enabled && isSampledSet(getSetNum(address)))
    {
       _total_cache_accesses ++;
 
@@ -332,18 +559,25 @@ Cache::updateMissCounters(IntPtr address, Core::mem_op_t mem_op_type, bool cache
       }
    }
 
+   // All the sets, the miss type only in the sampled ones
+   if (_enabled && cache_miss && _data_profiler)
+      _data_profiler->recordCacheMiss(_data_profiler_lookup, _data_profiler_index, address, miss_type);
+
+   _last_access_missed = cache_miss;
+   _last_miss_type = miss_type;
    return miss_type;
 }
 
 Cache::MissType
 Cache::getMissType(IntPtr address) const
 {
-   // We maintain three address sets to keep track of miss types
-   if (_evicted_address_set.find(address) != _evicted_address_set.end())
+   // We maintain three flags per address to keep track of miss types
+   UInt8 flags = _miss_type_tracker->getFlags(address);
+   if (flags & MissTypeTracker::EVICTED)
       return CAPACITY_MISS;
-   else if (_invalidated_address_set.find(address) != _invalidated_address_set.end())
+   else if (flags & MissTypeTracker::INVALIDATED)
       return SHARING_MISS;
-   else if (_fetched_address_set.find(address) != _fetched_address_set.end())
+   else if (flags & MissTypeTracker::FETCHED)
       return SHARING_MISS;
    else
       return COLD_MISS;
@@ -371,11 +605,14 @@ Cache::updateMissTypeCounters(IntPtr address, MissType miss_type)
 }
 
 void
-Cache::clearMissTypeTrackingSets(IntPtr address)
+Cache::markFetchedForMissTypeTracking(IntPtr address)
 {
-   if (_evicted_address_set.erase(address));
-   else if (_invalidated_address_set.erase(address));
-   else if (_fetched_address_set.erase(address));
+   UInt8 flags = _miss_type_tracker->getFlags(address);
+   if (flags & MissTypeTracker::EVICTED)
+      flags &= ~MissTypeTracker::EVICTED;
+   else if (flags & MissTypeTracker::INVALIDATED)
+      flags &= ~MissTypeTracker::INVALIDATED;
+   _miss_type_tracker->setFlags(address, flags | MissTypeTracker::FETCHED);
 }
 
 void
@@ -388,7 +625,76 @@ Cache::updateCacheLineStateCounters(CacheState::Type old_cstate, CacheState::Typ
 void
 Cache::getCacheLineStateCounters(vector<UInt64>& cache_line_state_counters) const
 {
-   cache_line_state_counters = _cache_line_state_counters;
+   cache_line_state_counters.resize(_cache_line_state_counters.size());
+   for (UInt32 i = 0; i < _cache_line_state_counters.size(); i++)
+      cache_line_state_counters[i] = scale(_cache_line_state_counters[i]);
+}
+
+void
+Cache::updateDynamicEnergy()
+{
+   // Every access to a sampled set stands for one access to each of the
+   // sets it represents
+   if (_power_model)
+      _power_model->updateDynamicEnergy(_set_sampling_interval);
+}
+
+void
+Cache::registerStatistics(tile_id_t tile_id)
+{
+   // Miss rates of the statistics trace
+   StatisticsManager* statistics_manager = Sim()->getStatisticsManager();
+   if (statistics_manager && (_name == "L1-D"))
+   {
+      statistics_manager->registerCounter(tile_id, StatisticsManager::L1_DCACHE_ACCESSES, &_total_cache_accesses, _set_sampling_interval);
+      statistics_manager->registerCounter(tile_id, StatisticsManager::L1_DCACHE_MISSES, &_total_cache_misses, _set_sampling_interval);
+   }
+   else if (statistics_manager && (_name == "L2"))
+   {
+      statistics_manager->registerCounter(tile_id, StatisticsManager::L2_CACHE_ACCESSES, &_total_cache_accesses, _set_sampling_interval);
+      statistics_manager->registerCounter(tile_id, StatisticsManager::L2_CACHE_MISSES, &_total_cache_misses, _set_sampling_interval);
+   }
+   if (statistics_manager && _reuse_distance_profiler)
+      statistics_manager->registerReuseDistanceProfiler(tile_id, _reuse_distance_profiler, _line_size);
+   // Power trace
+   if (statistics_manager && _power_model)
+      statistics_manager->registerPowerModel(tile_id, _power_model);
+
+   StatsRegistry* stats = Sim()->getStatsRegistry();
+   if (!stats)
+      return;
+
+   string prefix = "Cache " + _name + "/";
+   stats->registerCounter(tile_id, prefix + "Cache Accesses", &_total_cache_accesses, _set_sampling_interval);
+   stats->registerCounter(tile_id, prefix + "Cache Misses", &_total_cache_misses, _set_sampling_interval);
+   stats->registerCounter(tile_id, prefix + "Read Accesses", &_total_read_accesses, _set_sampling_interval);
+   stats->registerCounter(tile_id, prefix + "Read Misses", &_total_read_misses, _set_sampling_interval);
+   stats->registerCounter(tile_id, prefix + "Write Accesses", &_total_write_accesses, _set_sampling_interval);
+   stats->registerCounter(tile_id, prefix + "Write Misses", &_total_write_misses, _set_sampling_interval);
+   stats->registerCounter(tile_id, prefix + "Evictions", &_total_evictions, _set_sampling_interval);
+   stats->registerCounter(tile_id, prefix + "Dirty Evictions", &_total_dirty_evictions, _set_sampling_interval);
+   if (_compressor)
+   {
+      stats->registerCounter(tile_id, prefix + "Compressed Fills", &_total_compressed_fills, _set_sampling_interval);
+      stats->registerCounter(tile_id, prefix + "Evictions for Space", &_total_evictions_for_space, _set_sampling_interval);
+      stats->registerCounter(tile_id, prefix + "Decompressions", &_total_decompressions, _set_sampling_interval);
+   }
+   if (_power_model)
+      _power_model->registerEventCounters(tile_id, prefix + "Power Model ");
+   if (_track_miss_types)
+   {
+      stats->registerCounter(tile_id, prefix + "Cold Misses", &_total_cold_misses, _set_sampling_interval);
+      stats->registerCounter(tile_id, prefix + "Capacity Misses", &_total_capacity_misses, _set_sampling_interval);
+      stats->registerCounter(tile_id, prefix + "Sharing Misses", &_total_sharing_misses, _set_sampling_interval);
+   }
+   for (UInt32 i = 0; i < _shadow_tag_arrays.size(); i++)
+   {
+      ShadowTagArray* shadow = _shadow_tag_arrays[i];
+      string shadow_prefix = prefix + "Shadow " + shadow->getName() + "/";
+      stats->registerCounter(tile_id, shadow_prefix + "Accesses", shadow->getNumAccessesCounter());
+      stats->registerCounter(tile_id, shadow_prefix + "Misses", shadow->getNumMissesCounter());
+      stats->registerCounter(tile_id, shadow_prefix + "Writebacks", shadow->getNumWritebacksCounter());
+   }
 }
 
 void
@@ -396,8 +702,10 @@ Cache::outputSummary(ostream& out)
 {
    // Cache Miss Summary
    out << "  Cache " << _name << ":\n";
-   out << "    Cache Accesses: " << _total_cache_accesses << endl;
-   out << "    Cache Misses: " << _total_cache_misses << endl;
+   if (_set_sampling_interval > 1)
+      out << "    Sampled Sets: " << (_num_sets / _set_sampling_interval) << " of " << _num_sets << endl;
+   out << "    Cache Accesses: " << scale(_total_cache_accesses) << endl;
+   out << "    Cache Misses: " << scale(_total_cache_misses) << endl;
    if (_total_cache_accesses > 0)
       out << "    Miss Rate (%): " << 100.0 * _total_cache_misses / _total_cache_accesses << endl;
    else
@@ -405,15 +713,15 @@ Cache::outputSummary(ostream& out)
    
    if (_cache_category != INSTRUCTION_CACHE)
    {
-      out << "      Read Accesses: " << _total_read_accesses << endl;
-      out << "      Read Misses: " << _total_read_misses << endl;
+      out << "      Read Accesses: " << scale(_total_read_accesses) << endl;
+      out << "      Read Misses: " << scale(_total_read_misses) << endl;
       if (_total_read_accesses > 0)
          out << "      Read Miss Rate (%): " << 100.0 * _total_read_misses / _total_read_accesses << endl;
       else
          out << "      Read Miss Rate (%): " << endl;
       
-      out << "      Write Accesses: " << _total_write_accesses << endl;
-      out << "      Write Misses: " << _total_write_misses << endl;
+      out << "      Write Accesses: " << scale(_total_write_accesses) << endl;
+      out << "      Write Misses: " << scale(_total_write_misses) << endl;
       if (_total_write_accesses > 0)
          out << "      Write Miss Rate (%): " << 100.0 * _total_write_misses / _total_write_accesses << endl;
       else
@@ -421,12 +729,51 @@ Cache::outputSummary(ostream& out)
    }
 
    // Evictions
-   out << "    Evictions: " << _total_evictions << endl;
+   out << "    Evictions: " << scale(_total_evictions) << endl;
    if (_write_policy == WRITE_BACK)
    {
-      out << "    Dirty Evictions: " << _total_dirty_evictions << endl;
+      out << "    Dirty Evictions: " << scale(_total_dirty_evictions) << endl;
    }
    
+   // Miss rate of a fully associative LRU cache from a quarter to 4 times
+   // the size of this one
+   if (_reuse_distance_profiler)
+   {
+      out << "    Miss Rate Curve (Sampling Rate " << _reuse_distance_profiler->getSamplingRate() << "):" << endl;
+      for (UInt32 size_log2 = 0; size_log2 < ReuseDistanceProfiler::NUM_BUCKETS; size_log2++)
+      {
+         UInt64 size = ((UInt64) _line_size) << size_log2;
+         if ((size < _cache_size / 4) || (size > ((UInt64) _cache_size) * 4))
+            continue;
+         UInt64 num_accesses = _reuse_distance_profiler->getNumAccesses();
+         out << "      Miss Rate at " << (size / k_KILO) << " KB (%): ";
+         if (num_accesses > 0)
+            out << 100.0 * (num_accesses - _reuse_distance_profiler->getNumHits(size_log2)) / num_accesses;
+         out << endl;
+      }
+   }
+
+   // Same accesses in the shadow tag arrays
+   if (!_shadow_tag_arrays.empty())
+   {
+      out << "    Shadow Caches:" << endl;
+      for (UInt32 i = 0; i < _shadow_tag_arrays.size(); i++)
+      {
+         ShadowTagArray* shadow = _shadow_tag_arrays[i];
+         out << "      " << shadow->getName() << " Miss Rate (%): ";
+         if (shadow->getNumAccesses() > 0)
+            out << 100.0 * shadow->getNumMisses() / shadow->getNumAccesses();
+         out << endl;
+         out << "      " << shadow->getName() << " Writebacks: " << shadow->getNumWritebacks() << endl;
+      }
+   }
+
+   if (_line_utilization_tracker)
+      _line_utilization_tracker->outputSummary(out, _set_sampling_interval);
+
+   if (_compressor)
+      outputCompressionSummary(out);
+
    // Output Power and Area Summaries
    if (_power_model)
       _power_model->outputSummary(out);
@@ -437,17 +784,93 @@ Cache::outputSummary(ostream& out)
    if (_track_miss_types)
    {
       out << "    Miss Types:" << endl;
-      out << "      Cold Misses: " << _total_cold_misses << endl;
-      out << "      Capacity Misses: " << _total_capacity_misses << endl;
-      out << "      Sharing Misses: " << _total_sharing_misses << endl;
+      out << "      Cold Misses: " << scale(_total_cold_misses) << endl;
+      out << "      Capacity Misses: " << scale(_total_capacity_misses) << endl;
+      out << "      Sharing Misses: " << scale(_total_sharing_misses) << endl;
    }
 
    // Cache Access Counters Summary
    out << "    Access Counters:" << endl;
-   out << "      Tag Array Reads: " << _tag_array_reads << endl;
-   out << "      Tag Array Writes: " << _tag_array_writes << endl;
-   out << "      Data Array Reads: " << _data_array_reads << endl;
-   out << "      Data Array Writes: " << _data_array_writes << endl;
+   out << "      Tag Array Reads: " << scale(_tag_array_reads) << endl;
+   out << "      Tag Array Writes: " << scale(_tag_array_writes) << endl;
+   out << "      Data Array Reads: " << scale(_data_array_reads) << endl;
+   out << "      Data Array Writes: " << scale(_data_array_writes) << endl;
+}
+
+void
+Cache::outputCompressionSummary(ostream& out)
+{
+   out << "    Compression:" << endl;
+   out << "      Tags per Set: " << _num_tag_ways << endl;
+   out << "      Fills: " << scale(_total_fills) << endl;
+   out << "      Compressed Fills: " << scale(_total_compressed_fills) << endl;
+   // Size of the lines filled over the size they take in the data array
+   out << "      Compression Ratio: ";
+   if (_total_fill_stored_bytes > 0)
+      out << ((double) _total_fills) * _line_size / _total_fill_stored_bytes;
+   out << endl;
+   // Lines held by the sets at the fills, against the same cache uncompressed
+   out << "      Average Lines per Set: ";
+   if (_total_fills > 0)
+      out << ((double) _total_fill_set_lines) / _total_fills;
+   out << endl;
+   out << "      Effective Capacity (KB): ";
+   if (_total_fills > 0)
+      out << ((double) _total_fill_set_lines) / _total_fills * _num_sets * _line_size / k_KILO;
+   out << endl;
+   out << "      Effective Capacity Gain: ";
+   if (_total_fills > 0)
+      out << ((double) _total_fill_set_lines) / _total_fills / _associativity;
+   out << endl;
+   out << "      Evictions for Space: " << scale(_total_evictions_for_space) << endl;
+   out << "      Decompressions: " << scale(_total_decompressions) << endl;
+}
+
+void
+Cache::saveState(CheckpointWriter& writer)
+{
+   writer.beginSection("Cache " + _name);
+   writer << _num_sets << _num_tag_ways << _line_size << (UInt8) _store_data;
+
+   for (UInt32 i = 0; i < _num_sets; i++)
+      getSet(i)->saveState(writer);
+   _replacement_policy->saveState(writer);
+}
+
+void
+Cache::restoreState(CheckpointReader& reader)
+{
+   reader.beginSection("Cache " + _name);
+   UInt32 num_sets, associativity, line_size;
+   UInt8 store_data;
+   reader >> num_sets >> associativity >> line_size >> store_data;
+   LOG_ASSERT_ERROR((num_sets == _num_sets) && (associativity == _num_tag_ways) && (line_size == _line_size),
+                    "Cache %s: checkpoint geometry(%u sets, %u ways, %u bytes), cache(%u sets, %u ways, %u bytes)",
+                    _name.c_str(), num_sets, associativity, line_size, _num_sets, _num_tag_ways, _line_size);
+   LOG_ASSERT_ERROR((bool) store_data == _store_data,
+                    "Cache %s: checkpoint and cache disagree on caching_protocol/timing_only", _name.c_str());
+
+   for (UInt32 i = 0; i < _num_sets; i++)
+      getSet(i)->restoreState(reader);
+   _replacement_policy->restoreState(reader);
+   _num_line_removals ++;
+
+   // Rebuild the line state counters and miss type flags of the restored lines
+   _cache_line_state_counters.assign(CacheState::NUM_STATES, 0);
+   for (UInt32 i = 0; i < _num_sets; i++)
+   {
+      if (!isSampledSet(i))
+         continue;
+      for (UInt32 j = 0; j < _num_tag_ways; j++)
+      {
+         CacheLineInfo* cache_line_info = _sets[i]->getCacheLineInfo(j);
+         if (cache_line_info->getCState() == CacheState::INVALID)
+            continue;
+         updateCacheLineStateCounters(CacheState::INVALID, cache_line_info->getCState());
+         if (_track_miss_types)
+            markFetchedForMissTypeTracking(getAddressFromTag(cache_line_info->getTag()));
+      }
+   }
 }
 
 // Utilities
@@ -457,11 +880,32 @@ Cache::getTag(IntPtr address) const
    return (address >> _log_line_size);
 }
 
+UInt32
+Cache::getSetNum(IntPtr address) const
+{
+   if (_modulo_set_index)
+      return (address >> _log_line_size) & _set_index_mask;
+   return _hash_fn->compute(address);
+}
+
 CacheSet*
-Cache::getSet(IntPtr address) const
+Cache::getSet(UInt32 set_num)
 {
-   UInt32 set_num = _hash_fn->compute(address);
-   return _sets[set_num];
+   CacheSet* set = _sets[set_num];
+   if (set)
+      return set;
+
+   // First use of the set. The application and simulation threads of the
+   // tile may race here: the set of the first one to publish it is kept
+   char* lines = _line_data ? (_line_data + (UInt64) set_num * _num_tag_ways * _line_size) : NULL;
+   set = new CacheSet(set_num, _caching_protocol_type, _cache_level, _replacement_policy,
+                      _associativity, _line_size, lines, _compressor);
+   if (!__sync_bool_compare_and_swap(&_sets[set_num], (CacheSet*) NULL, set))
+   {
+      delete set;
+      set = _sets[set_num];
+   }
+   return set;
 }
 
 UInt32
@@ -476,6 +920,14 @@ Cache::getAddressFromTag(IntPtr tag) const
    return tag << _log_line_size;
 }
 
+void
+Cache::markWords(IntPtr address, UInt32 num_bytes)
+{
+   CacheLineInfo* cache_line_info = getCacheLineInfo(address);
+   if (cache_line_info)
+      cache_line_info->markWords(_line_utilization_tracker->getWordMask(getLineOffset(address), num_bytes));
+}
+
 Cache::MissType
 Cache::parseMissType(string miss_type)
 {
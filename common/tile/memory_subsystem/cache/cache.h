@@ -16,6 +16,13 @@ using std::set;
 #include "fixed_types.h"
 #include "caching_protocol_type.h"
 #include "constants.h"
+#include "miss_type_tracker.h"
+#include "reuse_distance_profiler.h"
+#include "shadow_tag_array.h"
+#include "line_utilization_tracker.h"
+#include "data_profiler.h"
+#include "cache_compressor.h"
+#include "checkpoint.h"
 
 // Forwards Decls
 class CacheSet;
@@ -69,15 +76,37 @@ public:
          CacheHashFn* hash_fn,
          UInt32 access_delay,
          float frequency,
-         bool track_miss_types = false);
-   ~Cache();
+         bool track_miss_types = false,
+         CacheCompressor* compressor = NULL);
+   virtual ~Cache();
 
    // Cache operations
    void accessCacheLine(IntPtr address, AccessType access_type, Byte* buf = NULL, UInt32 num_bytes = 0);
    void insertCacheLine(IntPtr inserted_address, CacheLineInfo* inserted_cache_line_info, Byte* fill_buf,
                         bool* eviction, IntPtr* evicted_address, CacheLineInfo* evicted_cache_line_info, Byte* writeback_buf);
+   // Compressed cache: the lines that have to leave the set of the line
+   // inserted last to make room for its data, one per call (after the
+   // eviction of insertCacheLine()). Returns false when there are no more
+   bool evictCacheLineForSpace(IntPtr inserted_address, IntPtr* evicted_address,
+                               CacheLineInfo* evicted_cache_line_info, Byte* writeback_buf);
+   // Cycles to decompress the line at 'address' on a hit, and to compress
+   // it on a fill. 0 for the lines stored uncompressed
+   UInt32 getDecompressionLatency(IntPtr address);
+   UInt32 getCompressionLatency(IntPtr address);
    void getCacheLineInfo(IntPtr address, CacheLineInfo* cache_line_info);
+   // Reads a readable line without updating the replacement state or the
+   // counters, may be called without the lock of the cache (seqlock reader)
+   bool probeCacheLine(IntPtr address, Byte* buf, UInt32 num_bytes);
    void setCacheLineInfo(IntPtr address, CacheLineInfo* updated_cache_line_info);
+   // Marks the words of the access in the line for the line utilization
+   // statistics. The partial line accesses of accessCacheLine() are marked
+   // already, an inclusive cache is told about the accesses to its lines
+   // in the caches above it this way
+   void markAccessedWords(IntPtr address, UInt32 num_bytes)
+   {
+      if (_line_utilization_tracker)
+         markWords(address, num_bytes);
+   }
 
    // Get the tag associated with an address
    IntPtr getTag(IntPtr address) const;
@@ -91,15 +120,38 @@ public:
    MissType updateMissCounters(IntPtr address, Core::mem_op_t mem_op_type, bool cache_miss);
    // Get cache line state counters
    void getCacheLineStateCounters(vector<UInt64>& cache_line_state_counters) const;
+   // Accesses/misses from the core so far (of the sampled sets, if any)
+   UInt64 getNumAccesses() const
+   { return _total_cache_accesses; }
+   UInt64 getNumMisses() const
+   { return _total_cache_misses; }
+   // Lines evicted or invalidated so far (of all the sets): a line that
+   // was present is still present if this has not changed since
+   UInt64 getNumLineRemovals() const
+   { return _num_line_removals; }
+   // Outcome of the last updateMissCounters(), in any set (the type is only
+   // known with track_miss_types, in the sampled sets)
+   bool lastAccessMissed() const
+   { return _last_access_missed; }
+   MissType getLastMissType() const
+   { return _last_miss_type; }
 
    // Parse Miss Type
    static MissType parseMissType(string miss_type);
    
    void enable()     { _enabled = true; }
    void disable()    { _enabled = false; }
+   bool isEnabled()  { return _enabled; }
    void reset()      {}
    
    virtual void outputSummary(ostream& out);
+   // Counters of the stats file and the statistics trace
+   void registerStatistics(tile_id_t tile_id);
+
+   // Checkpointing of the tags, states, replacement state and data. A
+   // checkpoint can only be restored into a cache of the same geometry
+   void saveState(CheckpointWriter& writer);
+   void restoreState(CheckpointReader& reader);
 
 private:
    // Is enabled?
@@ -109,7 +161,15 @@ private:
    string _name;
    CacheCategory _cache_category;
    WritePolicy _write_policy;
-   CacheSet** _sets;
+   // Allocated on first use, so that the startup and the memory of the
+   // simulation track the sets actually touched
+   CacheSet* volatile* _sets;
+   // Data of all the sets, NULL if _store_data is false. Mapped up front but
+   // only made resident as the sets are touched, by the threads of the tile
+   char* _line_data;
+   CachingProtocolType _caching_protocol_type;
+   SInt32 _cache_level;
+   bool _store_data;
 
    // Cache params
    UInt32 _cache_size;
@@ -117,10 +177,26 @@ private:
    UInt32 _line_size;
    UInt32 _num_sets;
    UInt32 _log_line_size;
+   // Tags of a set, more than _associativity if the cache is compressed
+   UInt32 _num_tag_ways;
+
+   // Compression of the lines ([l2_cache/*] compression), NULL if none
+   CacheCompressor* _compressor;
+   UInt64 _total_fills;
+   UInt64 _total_compressed_fills;
+   UInt64 _total_fill_stored_bytes;
+   // Valid lines of the set at each fill, for the effective capacity
+   UInt64 _total_fill_set_lines;
+   UInt64 _total_evictions_for_space;
+   UInt64 _total_decompressions;
 
    // Computing replacement policy and hash function
    CacheReplacementPolicy* _replacement_policy;
    CacheHashFn* _hash_fn;
+   // The base CacheHashFn (line number modulo the number of sets) is
+   // computed here with a mask, without the virtual call
+   bool _modulo_set_index;
+   UInt32 _set_index_mask;
    
    // Cache hit/miss counters
    UInt64 _total_cache_accesses;
@@ -135,13 +211,13 @@ private:
    UInt64 _total_capacity_misses;
    UInt64 _total_sharing_misses;
    // State for tracking type of cache misses
-   set<IntPtr> _fetched_address_set;
-   set<IntPtr> _evicted_address_set;
-   set<IntPtr> _invalidated_address_set;
+   MissTypeTracker* _miss_type_tracker;
 
    // Evictions
    UInt64 _total_evictions;
    UInt64 _total_dirty_evictions;
+   // Read by the core without the lock of the memory manager
+   volatile UInt64 _num_line_removals;
    
    // Event counters for tracking tag/data array reads and writes
    UInt64 _tag_array_reads;
@@ -158,11 +234,43 @@ private:
 
    // Track miss types ?
    bool _track_miss_types;
+   bool _last_access_missed;
+   MissType _last_miss_type;
+
+   // Sampled reuse distances of the accesses from the core, for the miss
+   // rate curve of the L2 caches ([cache_statistics] reuse_distance_profiling)
+   ReuseDistanceProfiler* _reuse_distance_profiler;
+   // Tags of other geometries of the L2 caches fed the same accesses
+   // ([cache_statistics] shadow_l2_caches)
+   vector<ShadowTagArray*> _shadow_tag_arrays;
+   // Words used by the lines when they leave the cache ([cache_statistics] line_utilization)
+   LineUtilizationTracker* _line_utilization_tracker;
+
+   // Misses and invalidations by allocation site ([data_profiler])
+   DataProfiler* _data_profiler;
+   UInt32 _data_profiler_index;
+   DataProfiler::LookupCache _data_profiler_lookup;
+
+   // Set sampling: the statistics are only collected for one set out of
+   // every _set_sampling_interval and scaled up on output
+   UInt32 _set_sampling_interval;
+   UInt32 _set_sampling_mask;
   
    // Utilities
-   CacheSet* getSet(IntPtr address) const;
+   UInt32 getSetNum(IntPtr address) const;
+   CacheSet* getSet(UInt32 set_num);
+   UInt64 getDataArraySize() const
+   { return ((UInt64) _num_sets) * _num_tag_ways * _line_size; }
+   bool isSampledSet(UInt32 set_num) const
+   { return ((set_num & _set_sampling_mask) == 0); }
+   // Extrapolate a counter of the sampled sets to the whole cache
+   UInt64 scale(UInt64 counter) const
+   { return counter * _set_sampling_interval; }
+   void updateDynamicEnergy();
    UInt32 getLineOffset(IntPtr address) const;
    IntPtr getAddressFromTag(IntPtr tag) const;
+   void markWords(IntPtr address, UInt32 num_bytes);
+   void outputCompressionSummary(ostream& out);
 
    // Initialize Counters
    // Hit/miss counters
@@ -181,7 +289,7 @@ private:
    // Update miss type counters
    MissType getMissType(IntPtr address) const;
    void updateMissTypeCounters(IntPtr address, MissType miss_type);
-   void clearMissTypeTrackingSets(IntPtr address);
+   void markFetchedForMissTypeTracking(IntPtr address);
    
    // Update counters that record the state of cache lines
    void updateCacheLineStateCounters(CacheState::Type old_cstate, CacheState::Type new_cstate);
@@ -0,0 +1,182 @@
+#include <string.h>
+
+#include "cache_compressor.h"
+#include "utils.h"
+#include "log.h"
+
+CacheCompressor::CacheCompressor(Type type, UInt32 line_size, UInt32 tag_factor, UInt32 segment_size,
+                                 UInt32 compression_latency, UInt32 decompression_latency)
+   : _type(type)
+   , _line_size(line_size)
+   , _tag_factor(tag_factor)
+   , _segment_size(segment_size)
+   , _compression_latency(compression_latency)
+   , _decompression_latency(decompression_latency)
+{
+   LOG_ASSERT_ERROR(tag_factor >= 1, "Compression tag factor(%u) must be >= 1", tag_factor);
+   LOG_ASSERT_ERROR((segment_size > 0) && isPower2(segment_size) && (segment_size <= line_size),
+                    "Compression segment size(%u) must be a power of 2 <= the line size(%u)", segment_size, line_size);
+}
+
+CacheCompressor::~CacheCompressor()
+{}
+
+CacheCompressor*
+CacheCompressor::create(string type_str, UInt32 line_size, UInt32 tag_factor, UInt32 segment_size,
+                        UInt32 compression_latency, UInt32 decompression_latency)
+{
+   if (type_str == "none")
+      return (CacheCompressor*) NULL;
+   return new CacheCompressor(parse(type_str), line_size, tag_factor, segment_size,
+                              compression_latency, decompression_latency);
+}
+
+CacheCompressor::Type
+CacheCompressor::parse(string type_str)
+{
+   if (type_str == "bdi")
+      return BDI;
+   else if (type_str == "fpc")
+      return FPC;
+   else
+   {
+      LOG_PRINT_ERROR("Unrecognized Cache Compression(%s)", type_str.c_str());
+      return NUM_TYPES;
+   }
+}
+
+UInt32
+CacheCompressor::getStoredSize(const Byte* data_buf) const
+{
+   if (data_buf == NULL)
+      return _line_size;
+
+   UInt32 size = (_type == BDI) ? computeBDISize(data_buf, _line_size) : computeFPCSize(data_buf, _line_size);
+   size = (size + _segment_size - 1) / _segment_size * _segment_size;
+   if (size == 0)
+      return _segment_size;
+   return (size < _line_size) ? size : _line_size;
+}
+
+UInt32
+CacheCompressor::computeBDISize(const Byte* data_buf, UInt32 data_length)
+{
+   bool zero_data = true;
+   for (UInt32 i = 0; (i < data_length) && zero_data; i++)
+      zero_data = (data_buf[i] == 0);
+   if (zero_data)
+      return 0;
+
+   UInt32 size = data_length;
+   // Repeated value: a single base, no deltas
+   if (computeBaseDeltaSize(data_buf, data_length, 8, 0) > 0)
+      size = 8;
+   static const UInt32 num_configurations = 6;
+   static const UInt32 configurations[num_configurations][2] = { {8,1}, {8,2}, {8,4}, {4,1}, {4,2}, {2,1} };
+   for (UInt32 i = 0; i < num_configurations; i++)
+   {
+      UInt32 compressed_size = computeBaseDeltaSize(data_buf, data_length, configurations[i][0], configurations[i][1]);
+      if ((compressed_size > 0) && (compressed_size < size))
+         size = compressed_size;
+   }
+   return size;
+}
+
+// Sign extension of the low 'size' bytes of 'value'
+static SInt64 signExtend(UInt64 value, UInt32 size)
+{
+   UInt32 shift = 64 - size * 8;
+   return ((SInt64) (value << shift)) >> shift;
+}
+
+static bool fitsInDelta(SInt64 delta, UInt32 delta_size)
+{
+   if (delta_size == 0)
+      return (delta == 0);
+   SInt64 limit = ((SInt64) 1) << (delta_size * 8 - 1);
+   return ((delta >= -limit) && (delta < limit));
+}
+
+UInt32
+CacheCompressor::computeBaseDeltaSize(const Byte* data_buf, UInt32 data_length, UInt32 base_size, UInt32 delta_size)
+{
+   if ((data_length % base_size) != 0)
+      return 0;
+
+   // Each element is a delta from zero (immediate) or from the base, the
+   // first element that is not an immediate
+   UInt32 num_elements = data_length / base_size;
+   bool has_base = false;
+   UInt64 base = 0;
+   for (UInt32 i = 0; i < num_elements; i++)
+   {
+      UInt64 value = 0;
+      memcpy(&value, data_buf + i * base_size, base_size);
+      if ((delta_size > 0) && fitsInDelta(signExtend(value, base_size), delta_size))
+         continue;
+      if (!has_base)
+      {
+         base = value;
+         has_base = true;
+      }
+      if (!fitsInDelta(signExtend(value - base, base_size), delta_size))
+         return 0;
+   }
+   // Base, deltas and a bit per element for the base it is a delta from
+   return (base_size + num_elements * delta_size + (num_elements + 7) / 8);
+}
+
+UInt32
+CacheCompressor::computeFPCSize(const Byte* data_buf, UInt32 data_length)
+{
+   if ((data_length % 4) != 0)
+      return data_length;
+
+   static const UInt32 prefix_bits = 3;
+   static const UInt32 max_zero_run = 8;
+
+   UInt32 num_bits = 0;
+   UInt32 zero_run = 0;
+   for (UInt32 i = 0; i < data_length; i += 4)
+   {
+      UInt32 word = 0;
+      memcpy(&word, data_buf + i, 4);
+
+      // Runs of zero words, up to 8 words with a 3-bit length
+      if (word == 0)
+      {
+         if (zero_run == 0)
+            num_bits += prefix_bits + 3;
+         zero_run = (zero_run + 1) % max_zero_run;
+         continue;
+      }
+      zero_run = 0;
+
+      SInt64 value = signExtend(word, 4);
+      UInt32 upper_half = word >> 16;
+      UInt32 lower_half = word & 0xffff;
+      UInt32 data_bits;
+      // Sign-extended 4 bits, byte and halfword
+      if ((value >= -8) && (value < 8))
+         data_bits = 4;
+      else if (fitsInDelta(value, 1))
+         data_bits = 8;
+      else if (fitsInDelta(value, 2))
+         data_bits = 16;
+      // Halfword padded with a zero halfword
+      else if (lower_half == 0)
+         data_bits = 16;
+      // Two halfwords, each a sign-extended byte
+      else if (fitsInDelta(signExtend(upper_half, 2), 1) && fitsInDelta(signExtend(lower_half, 2), 1))
+         data_bits = 16;
+      // Word of repeated bytes
+      else if (word == (word & 0xff) * 0x01010101U)
+         data_bits = 8;
+      else
+         data_bits = 32;
+      num_bits += prefix_bits + data_bits;
+   }
+
+   UInt32 size = (num_bits + 7) / 8;
+   return (size < data_length) ? size : data_length;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <string>
+using std::string;
+
+#include "fixed_types.h"
+
+// Compression of the lines of a cache ([l2_cache/*] compression). The data
+// array of a compressed cache is split into segments of 'segment_size'
+// bytes, a line takes the segments of its compressed size. Each set has
+// 'tag_factor' times more tags than it has lines of data, so that it can
+// hold that many more lines when they compress (decoupled tags and data).
+//  - bdi: base-delta-immediate (and zero and repeated-value lines)
+//  - fpc: frequent pattern compression of the 32-bit words of the line
+// The sizes come from the data of the lines, a cache that keeps no data
+// (timing only) stores its lines uncompressed.
+class CacheCompressor
+{
+public:
+   enum Type
+   {
+      BDI = 0,
+      FPC,
+      NUM_TYPES
+   };
+
+   CacheCompressor(Type type, UInt32 line_size, UInt32 tag_factor, UInt32 segment_size,
+                   UInt32 compression_latency, UInt32 decompression_latency);
+   ~CacheCompressor();
+
+   // Returns NULL if type_str is "none"
+   static CacheCompressor* create(string type_str, UInt32 line_size, UInt32 tag_factor, UInt32 segment_size,
+                                  UInt32 compression_latency, UInt32 decompression_latency);
+   static Type parse(string type_str);
+
+   // Size (in bytes) of the line in the data array: its compressed size in
+   // whole segments, at least one and at most the line size
+   UInt32 getStoredSize(const Byte* data_buf) const;
+
+   UInt32 getTagFactor() const
+   { return _tag_factor; }
+   // In cycles of the cache
+   UInt32 getCompressionLatency() const
+   { return _compression_latency; }
+   UInt32 getDecompressionLatency() const
+   { return _decompression_latency; }
+
+   // Size (in bytes) of the data compressed with base-delta-immediate, 0
+   // for an all-zero line and data_length if it does not compress
+   static UInt32 computeBDISize(const Byte* data_buf, UInt32 data_length);
+   // Same, with frequent pattern compression (3-bit prefix per word)
+   static UInt32 computeFPCSize(const Byte* data_buf, UInt32 data_length);
+
+private:
+   Type _type;
+   UInt32 _line_size;
+   UInt32 _tag_factor;
+   UInt32 _segment_size;
+   UInt32 _compression_latency;
+   UInt32 _decompression_latency;
+
+   // Size (in bytes) of the data compressed with elements of base_size
+   // bytes and deltas of delta_size bytes, 0 if it does not compress that way
+   static UInt32 computeBaseDeltaSize(const Byte* data_buf, UInt32 data_length, UInt32 base_size, UInt32 delta_size);
+};
@@ -7,6 +7,7 @@
 CacheLineInfo::CacheLineInfo(IntPtr tag, CacheState::Type cstate)
    : _tag(tag)
    , _cstate(cstate)
+   , _word_bitmap(0)
 {}
 
 CacheLineInfo::~CacheLineInfo()
@@ -37,6 +38,7 @@ CacheLineInfo::invalidate()
 {
    _tag = ~0;
    _cstate = CacheState::INVALID;
+   _word_bitmap = 0;
 }
 
 void
@@ -44,4 +46,21 @@ CacheLineInfo::assign(CacheLineInfo* cache_line_info)
 {
    _tag = cache_line_info->getTag();
    _cstate = cache_line_info->getCState();
+   _word_bitmap = cache_line_info->getWordBitmap();
+}
+
+void
+CacheLineInfo::saveState(CheckpointWriter& writer)
+{
+   writer << (UInt64) _tag << (UInt32) _cstate;
+}
+
+void
+CacheLineInfo::restoreState(CheckpointReader& reader)
+{
+   UInt64 tag;
+   UInt32 cstate;
+   reader >> tag >> cstate;
+   _tag = tag;
+   _cstate = (CacheState::Type) cstate;
 }
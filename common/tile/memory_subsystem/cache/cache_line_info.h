@@ -4,6 +4,7 @@
 #include "cache.h"
 #include "cache_utils.h"
 #include "caching_protocol_type.h"
+#include "checkpoint.h"
 
 class CacheLineInfo
 {
@@ -18,6 +19,10 @@ public:
    virtual void invalidate();
    virtual void assign(CacheLineInfo* cache_line_info);
 
+   // Checkpointing
+   virtual void saveState(CheckpointWriter& writer);
+   virtual void restoreState(CheckpointReader& reader);
+
    bool isValid() const                        
    { return (_tag != ((IntPtr) ~0)); }
    IntPtr getTag() const                        
@@ -30,7 +35,15 @@ public:
    void setCState(CacheState::Type cstate)      
    { _cstate = cstate; }
 
+   // Words accessed by the core since the line was inserted, one bit per
+   // word ([cache_statistics] line_utilization). Not checkpointed
+   UInt64 getWordBitmap() const
+   { return _word_bitmap; }
+   void markWords(UInt64 word_mask)
+   { _word_bitmap |= word_mask; }
+
 protected:
    IntPtr _tag;
    CacheState::Type _cstate;
+   UInt64 _word_bitmap;
 };
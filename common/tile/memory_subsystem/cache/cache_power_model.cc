@@ -4,11 +4,14 @@ using namespace std;
 #include "cache_power_model.h"
 #include "mcpat_cache.h"
 #include "cache_info.h"
+#include "simulator.h"
+#include "stats_registry.h"
 #include "config.h"
 #include "log.h"
 
 CachePowerModel::CachePowerModel(string type, UInt32 size, UInt32 blocksize,
                                  UInt32 associativity, UInt32 delay, volatile float frequency)
+   : _num_accesses(0)
 {
    LOG_ASSERT_ERROR(Config::getSingleton()->getEnablePowerModeling(), "Power Modeling Disabled");
    CacheParams cache_params(type, size, blocksize, associativity, delay, frequency);
@@ -19,11 +22,19 @@ CachePowerModel::CachePowerModel(string type, UInt32 size, UInt32 blocksize,
    _total_static_power = cache_power._subthreshold_leakage_power + cache_power._gate_leakage_power;
 }
 
+void
+CachePowerModel::registerEventCounters(tile_id_t tile_id, const string& prefix)
+{
+   StatsRegistry* stats = Sim()->getStatsRegistry();
+   if (stats)
+      stats->registerCounter(tile_id, prefix + "Accesses", &_num_accesses);
+}
+
 void
 CachePowerModel::outputSummary(ostream& out)
 {
    out << "    Static Power (in W): " << _total_static_power << endl;
-   out << "    Dynamic Energy (in J): " << _total_dynamic_energy << endl;
+   out << "    Dynamic Energy (in J): " << getTotalDynamicEnergy() << endl;
 }
 
 void
@@ -10,15 +10,19 @@ class CachePowerModel
             UInt32 associativity, UInt32 delay, volatile float frequency);
       ~CachePowerModel() {}
 
-      void updateDynamicEnergy() { _total_dynamic_energy += _dynamic_energy; }
-      volatile double getTotalDynamicEnergy() { return _total_dynamic_energy; }
+      // Only the accesses are counted, the energy is computed when read
+      void updateDynamicEnergy(UInt32 num_accesses = 1) { _num_accesses += num_accesses; }
+      volatile double getTotalDynamicEnergy() { return _num_accesses * _dynamic_energy; }
       volatile double getTotalStaticPower() { return _total_static_power; }
 
+      // Event counters of the stats file, named prefix + counter
+      void registerEventCounters(tile_id_t tile_id, const std::string& prefix);
+
       void outputSummary(std::ostream& out);
       static void dummyOutputSummary(std::ostream& out);
 
    private:
-      volatile double _total_dynamic_energy;
+      UInt64 _num_accesses;
       volatile double _total_static_power;
       volatile double _dynamic_energy;
 };
@@ -1,6 +1,9 @@
 #include "cache_replacement_policy.h"
 #include "round_robin_replacement_policy.h"
 #include "lru_replacement_policy.h"
+#include "tree_plru_replacement_policy.h"
+#include "rrip_replacement_policy.h"
+#include "ship_replacement_policy.h"
 #include "cache_line_info.h"
 #include "log.h"
 
@@ -24,6 +27,14 @@ CacheReplacementPolicy::create(string policy_str, UInt32 cache_size, UInt32 asso
       return new RoundRobinReplacementPolicy(cache_size, associativity, cache_line_size);
    case LRU:
       return new LRUReplacementPolicy(cache_size, associativity, cache_line_size);
+   case TREE_PLRU:
+      return new TreePLRUReplacementPolicy(cache_size, associativity, cache_line_size);
+   case SRRIP:
+      return new RRIPReplacementPolicy(cache_size, associativity, cache_line_size, RRIPReplacementPolicy::STATIC);
+   case BRRIP:
+      return new RRIPReplacementPolicy(cache_size, associativity, cache_line_size, RRIPReplacementPolicy::BIMODAL);
+   case SHIP:
+      return new SHiPReplacementPolicy(cache_size, associativity, cache_line_size);
    default:
       LOG_PRINT_ERROR("Unrecognized Replacement Policy(%u)", policy);
       return (CacheReplacementPolicy*) NULL;
@@ -37,6 +48,14 @@ CacheReplacementPolicy::parse(string policy_str)
       return ROUND_ROBIN;
    if (policy_str == "lru")
       return LRU;
+   if (policy_str == "tree_plru")
+      return TREE_PLRU;
+   if (policy_str == "srrip")
+      return SRRIP;
+   if (policy_str == "brrip")
+      return BRRIP;
+   if (policy_str == "ship")
+      return SHIP;
    else
    {
       LOG_PRINT_ERROR("Unrecognized Cache Replacement Policy(%s)", policy_str.c_str());
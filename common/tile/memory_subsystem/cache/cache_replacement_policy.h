@@ -5,6 +5,7 @@ using std::string;
 
 #include "fixed_types.h"
 #include "caching_protocol_type.h"
+#include "checkpoint.h"
 
 class CacheLineInfo;
 
@@ -15,6 +16,10 @@ public:
    {
       ROUND_ROBIN = 0,
       LRU,
+      TREE_PLRU,
+      SRRIP,
+      BRRIP,
+      SHIP,
       NUM_TYPES
    };
 
@@ -26,6 +31,14 @@ public:
    
    virtual UInt32 getReplacementWay(CacheLineInfo** cache_line_info_array, UInt32 set_num) = 0;
    virtual void update(CacheLineInfo** cache_line_info_array, UInt32 set_num, UInt32 accessed_way) = 0;
+   // Called when a line is filled into 'inserted_way'. Policies that treat
+   // fills like hits need not override it.
+   virtual void insert(CacheLineInfo** cache_line_info_array, UInt32 set_num, UInt32 inserted_way)
+   { update(cache_line_info_array, set_num, inserted_way); }
+
+   // Checkpointing of the replacement state
+   virtual void saveState(CheckpointWriter& writer) = 0;
+   virtual void restoreState(CheckpointReader& reader) = 0;
 
 protected:
    UInt32 _num_sets;
@@ -1,23 +1,43 @@
 #include <cstring>
+#if defined(__SSE2__) && defined(__x86_64__)
+#include <emmintrin.h>
+#endif
 #include "cache_set.h"
 #include "cache.h"
 #include "log.h"
 
 CacheSet::CacheSet(UInt32 set_num, CachingProtocolType caching_protocol_type, SInt32 cache_level,
-                   CacheReplacementPolicy* replacement_policy, UInt32 associativity, UInt32 line_size)
-   : _set_num(set_num)
+                   CacheReplacementPolicy* replacement_policy, UInt32 associativity, UInt32 line_size,
+                   char* lines, CacheCompressor* compressor)
+   : _lines(lines)
+   , _set_num(set_num)
    , _replacement_policy(replacement_policy)
-   , _associativity(associativity)
+   , _associativity(compressor ? (associativity * compressor->getTagFactor()) : associativity)
    , _line_size(line_size)
+   , _compressor(compressor)
+   , _data_capacity(associativity * line_size)
+   , _data_size(0)
+   , _stored_sizes(NULL)
+   , _last_access_times(NULL)
+   , _num_accesses(0)
 {
    _cache_line_info_array = new CacheLineInfo*[_associativity];
+   _tags = new IntPtr[_associativity];
    for (UInt32 i = 0; i < _associativity; i++)
    {
       _cache_line_info_array[i] = CacheLineInfo::create(caching_protocol_type, cache_level);
+      _tags[i] = _cache_line_info_array[i]->getTag();
+   }
+   if (_compressor)
+   {
+      _stored_sizes = new UInt32[_associativity];
+      _last_access_times = new UInt64[_associativity];
+      for (UInt32 i = 0; i < _associativity; i++)
+      {
+         _stored_sizes[i] = 0;
+         _last_access_times[i] = 0;
+      }
    }
-   _lines = new char[_associativity * _line_size];
-   
-   memset(_lines, 0x00, _associativity * _line_size);
 }
 
 CacheSet::~CacheSet()
@@ -25,7 +45,9 @@ CacheSet::~CacheSet()
    for (UInt32 i = 0; i < _associativity; i++)
       delete _cache_line_info_array[i];
    delete [] _cache_line_info_array;
-   delete [] _lines;
+   delete [] _tags;
+   delete [] _stored_sizes;
+   delete [] _last_access_times;
 }
 
 void 
@@ -34,11 +56,12 @@ CacheSet::read_line(UInt32 line_index, UInt32 offset, Byte *out_buf, UInt32 byte
    assert(offset + bytes <= _line_size);
    assert((out_buf == NULL) == (bytes == 0));
 
-   if (out_buf != NULL)
+   if ((out_buf != NULL) && (_lines != NULL))
       memcpy((void*) out_buf, &_lines[line_index * _line_size + offset], bytes);
 
    // Update replacement policy
    _replacement_policy->update(_cache_line_info_array, _set_num, line_index);
+   touch(line_index);
 }
 
 void 
@@ -47,26 +70,110 @@ CacheSet::write_line(UInt32 line_index, UInt32 offset, Byte *in_buf, UInt32 byte
    assert(offset + bytes <= _line_size);
    assert((in_buf == NULL) == (bytes == 0));
 
-   if (in_buf != NULL)
+   if ((in_buf != NULL) && (_lines != NULL))
+   {
       memcpy(&_lines[line_index * _line_size + offset], (void*) in_buf, bytes);
+      if (_compressor)
+         updateStoredSize(line_index, (Byte*) &_lines[line_index * _line_size]);
+   }
 
    // Update replacement policy
    _replacement_policy->update(_cache_line_info_array, _set_num, line_index);
+   touch(line_index);
 }
 
 CacheLineInfo* 
 CacheSet::find(IntPtr tag, UInt32* line_index)
 {
-   for (SInt32 index = _associativity-1; index >= 0; index--)
+   SInt32 index = findWay(tag);
+   if (index < 0)
+      return NULL;
+
+   assert(_cache_line_info_array[index]->getTag() == tag);
+   if (line_index != NULL)
+      *line_index = index;
+   return (_cache_line_info_array[index]);
+}
+
+bool
+CacheSet::probe(IntPtr tag, UInt32 offset, Byte *out_buf, UInt32 bytes) const
+{
+   SInt32 index = findWay(tag);
+   if (index < 0)
+      return false;
+   if (!CacheState(_cache_line_info_array[index]->getCState()).readable())
+      return false;
+
+   if ((out_buf != NULL) && (_lines != NULL) && (offset + bytes <= _line_size))
+      memcpy((void*) out_buf, &_lines[index * _line_size + offset], bytes);
+   return true;
+}
+
+template <UInt32 ASSOCIATIVITY>
+SInt32
+CacheSet::findWayFixed(const IntPtr* tags, IntPtr tag)
+{
+   UInt32 match_mask = 0;
+   for (UInt32 way = 0; way < ASSOCIATIVITY; way++)
+      match_mask |= ((UInt32) (tags[way] == tag)) << way;
+   return match_mask ? (31 - __builtin_clz(match_mask)) : -1;
+}
+
+SInt32
+CacheSet::findWay(IntPtr tag) const
+{
+   switch (_associativity)
    {
-      if (_cache_line_info_array[index]->getTag() == tag)
-      {
-         if (line_index != NULL)
-            *line_index = index;
-         return (_cache_line_info_array[index]);
-      }
+   case 1:
+      return (_tags[0] == tag) ? 0 : -1;
+   case 2:
+      return findWayFixed<2>(_tags, tag);
+   case 4:
+      return findWayFixed<4>(_tags, tag);
+   case 8:
+      return findWayFixed<8>(_tags, tag);
+   case 16:
+      return findWayFixed<16>(_tags, tag);
+   default:
+      break;
+   }
+
+   // Ways are searched from the highest one down
+   SInt32 way = _associativity - 1;
+
+#if defined(__SSE2__) && defined(__x86_64__)
+   // Compare two ways at a time. SSE2 has no 64-bit compare, so compare
+   // the 32-bit halves and require both to match.
+   const __m128i key = _mm_set1_epi64x(tag);
+   for ( ; way >= 1; way -= 2)
+   {
+      __m128i tags = _mm_loadu_si128((const __m128i*) &_tags[way-1]);
+      __m128i eq = _mm_cmpeq_epi32(tags, key);
+      eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2,3,0,1)));
+      SInt32 mask = _mm_movemask_pd(_mm_castsi128_pd(eq));
+      if (mask)
+         return (mask & 2) ? way : (way-1);
    }
-   return NULL;
+#endif
+
+   for ( ; way >= 0; way--)
+   {
+      if (_tags[way] == tag)
+         return way;
+   }
+   return -1;
+}
+
+void
+CacheSet::setCacheLineInfo(UInt32 line_index, CacheLineInfo* updated_cache_line_info)
+{
+   assert(line_index < _associativity);
+   bool was_valid = _cache_line_info_array[line_index]->isValid();
+   _cache_line_info_array[line_index]->assign(updated_cache_line_info);
+   _tags[line_index] = _cache_line_info_array[line_index]->getTag();
+   // Invalidated (or revalidated)
+   if (_compressor && (was_valid != _cache_line_info_array[line_index]->isValid()))
+      updateStoredSize(line_index, _lines ? (Byte*) &_lines[line_index * _line_size] : NULL);
 }
 
 void 
@@ -85,7 +192,7 @@ CacheSet::insert(CacheLineInfo* inserted_cache_line_info, Byte* fill_buf,
    {
       *eviction = true;
       evicted_cache_line_info->assign(_cache_line_info_array[index]);
-      if (writeback_buf != NULL)
+      if ((writeback_buf != NULL) && (_lines != NULL))
          memcpy((void*) writeback_buf, &_lines[index * _line_size], _line_size);
    }
    else
@@ -95,9 +202,92 @@ CacheSet::insert(CacheLineInfo* inserted_cache_line_info, Byte* fill_buf,
    }
 
    _cache_line_info_array[index]->assign(inserted_cache_line_info);
-   if (fill_buf != NULL)
+   _tags[index] = _cache_line_info_array[index]->getTag();
+   if ((fill_buf != NULL) && (_lines != NULL))
       memcpy(&_lines[index * _line_size], (void*) fill_buf, _line_size);
+   if (_compressor)
+      updateStoredSize(index, _lines ? fill_buf : NULL);
 
    // Update replacement policy
-   _replacement_policy->update(_cache_line_info_array, _set_num, index);
+   _replacement_policy->insert(_cache_line_info_array, _set_num, index);
+   touch(index);
+}
+
+bool
+CacheSet::evictForSpace(IntPtr inserted_tag, CacheLineInfo* evicted_cache_line_info, Byte* writeback_buf)
+{
+   if (!_compressor || (_data_size <= _data_capacity))
+      return false;
+
+   SInt32 index = -1;
+   for (UInt32 i = 0; i < _associativity; i++)
+   {
+      if ( _cache_line_info_array[i]->isValid() && (_tags[i] != inserted_tag) &&
+           ((index < 0) || (_last_access_times[i] < _last_access_times[index])) )
+         index = i;
+   }
+   LOG_ASSERT_ERROR(index >= 0, "No line to evict for the data of tag(%#lx)", inserted_tag);
+
+   evicted_cache_line_info->assign(_cache_line_info_array[index]);
+   if ((writeback_buf != NULL) && (_lines != NULL))
+      memcpy((void*) writeback_buf, &_lines[index * _line_size], _line_size);
+
+   _cache_line_info_array[index]->invalidate();
+   _tags[index] = _cache_line_info_array[index]->getTag();
+   updateStoredSize(index, NULL);
+   return true;
+}
+
+void
+CacheSet::updateStoredSize(UInt32 line_index, const Byte* data_buf)
+{
+   UInt32 stored_size = 0;
+   if (_cache_line_info_array[line_index]->isValid())
+      stored_size = _compressor->getStoredSize(data_buf);
+   _data_size = _data_size - _stored_sizes[line_index] + stored_size;
+   _stored_sizes[line_index] = stored_size;
+}
+
+UInt32
+CacheSet::getNumValidLines() const
+{
+   UInt32 num_valid_lines = 0;
+   for (UInt32 i = 0; i < _associativity; i++)
+   {
+      if (_cache_line_info_array[i]->isValid())
+         num_valid_lines ++;
+   }
+   return num_valid_lines;
+}
+
+UInt32
+CacheSet::getDataSize() const
+{
+   return _compressor ? _data_size : (getNumValidLines() * _line_size);
+}
+
+void
+CacheSet::saveState(CheckpointWriter& writer)
+{
+   for (UInt32 i = 0; i < _associativity; i++)
+      _cache_line_info_array[i]->saveState(writer);
+   if (_lines != NULL)
+      writer.put(_lines, _associativity * _line_size);
+}
+
+void
+CacheSet::restoreState(CheckpointReader& reader)
+{
+   for (UInt32 i = 0; i < _associativity; i++)
+   {
+      _cache_line_info_array[i]->restoreState(reader);
+      _tags[i] = _cache_line_info_array[i]->getTag();
+   }
+   if (_lines != NULL)
+      reader.get(_lines, _associativity * _line_size);
+   if (_compressor)
+   {
+      for (UInt32 i = 0; i < _associativity; i++)
+         updateStoredSize(i, _lines ? (Byte*) &_lines[i * _line_size] : NULL);
+   }
 }
@@ -3,26 +3,86 @@
 #include "fixed_types.h"
 #include "cache_line_info.h"
 #include "cache_replacement_policy.h"
+#include "cache_compressor.h"
 
-// Everything related to cache sets
+// Everything related to cache sets. A compressed set (with a compressor)
+// has tag_factor tags per line of data: the ways are the tags, the data of
+// the valid lines takes their stored size out of associativity lines
 class CacheSet
 {
 public:
    CacheSet(UInt32 set_num, CachingProtocolType caching_protocol_type, SInt32 cache_level,
-            CacheReplacementPolicy* replacement_policy, UInt32 associativity, UInt32 line_size);
+            CacheReplacementPolicy* replacement_policy, UInt32 associativity, UInt32 line_size,
+            char* lines, CacheCompressor* compressor = NULL);
    ~CacheSet();
 
    void read_line(UInt32 line_index, UInt32 offset, Byte *out_buf, UInt32 bytes);
    void write_line(UInt32 line_index, UInt32 offset, Byte *in_buf, UInt32 bytes);
    CacheLineInfo* find(IntPtr tag, UInt32* line_index = NULL);
+   // Copies the data if the line is readable, without touching the
+   // replacement state (for lock-free probes, the caller validates)
+   bool probe(IntPtr tag, UInt32 offset, Byte *out_buf, UInt32 bytes) const;
+   // All changes to the line info of a set go through here (or insert())
+   // so that the tag array stays in sync
+   void setCacheLineInfo(UInt32 line_index, CacheLineInfo* updated_cache_line_info);
    void insert(CacheLineInfo* inserted_cache_line_info, Byte* fill_buf,
                bool* eviction, CacheLineInfo* evicted_cache_line_info, Byte* writeback_buf);
+   CacheLineInfo* getCacheLineInfo(UInt32 line_index) const
+   { return _cache_line_info_array[line_index]; }
+
+   // Compressed sets. insert() takes the way of the replacement policy, the
+   // data of the inserted line may then not fit: the least recently used
+   // other lines are evicted one at a time with evictForSpace() until it
+   // does. Returns false once the data fits (always without a compressor).
+   // A line that grows on a write keeps its room until the next fill
+   bool evictForSpace(IntPtr inserted_tag, CacheLineInfo* evicted_cache_line_info, Byte* writeback_buf);
+   UInt32 getStoredSize(UInt32 line_index) const
+   { return _compressor ? _stored_sizes[line_index] : _line_size; }
+   // Valid lines, and the bytes of the data array they take
+   UInt32 getNumValidLines() const;
+   UInt32 getDataSize() const;
+
+   // Checkpointing of the line info and data (the replacement state
+   // is saved by the cache)
+   void saveState(CheckpointWriter& writer);
+   void restoreState(CheckpointReader& reader);
 
 private:
    CacheLineInfo** _cache_line_info_array;
+   // Copy of the tags of _cache_line_info_array, contiguous so that a
+   // lookup compares the ways without dereferencing the line info
+   IntPtr* _tags;
+   // Data of the ways, in the data array of the cache. NULL if the set
+   // only models timing, then no data is copied
    char* _lines;
    UInt32 _set_num;
    CacheReplacementPolicy* _replacement_policy;
+   // Number of ways (tags)
    UInt32 _associativity;
    UInt32 _line_size;
+
+   // Compressed sets only
+   CacheCompressor* _compressor;
+   UInt32 _data_capacity;
+   UInt32 _data_size;
+   // Bytes of the data array taken by each way, 0 if it is invalid
+   UInt32* _stored_sizes;
+   // Recency of the ways, for the victims of evictForSpace()
+   UInt64* _last_access_times;
+   UInt64 _num_accesses;
+
+   void touch(UInt32 line_index)
+   {
+      if (_compressor)
+         _last_access_times[line_index] = ++ _num_accesses;
+   }
+   // Sets the stored size of a way from its valid bit and data
+   void updateStoredSize(UInt32 line_index, const Byte* data_buf);
+
+   // Returns the way holding 'tag', or -1
+   SInt32 findWay(IntPtr tag) const;
+   // Same, for the common associativities: the ways are compared without
+   // a loop-carried branch and the highest matching one is taken
+   template <UInt32 ASSOCIATIVITY>
+   static SInt32 findWayFixed(const IntPtr* tags, IntPtr tag);
 };
@@ -3,6 +3,7 @@
 #include "memory_manager.h"
 #include "simulator.h"
 #include "config.h"
+#include "statistics_manager.h"
 #include "log.h"
 #include "utils.h"
 
@@ -27,11 +28,13 @@ DirectoryCache::DirectoryCache(Tile* tile,
    , _directory_access_time_str(directory_access_time_str)
    , _power_model(NULL)
    , _area_model(NULL)
+   , _bank_model(NULL)
    , _enabled(false)
 {
    LOG_PRINT("Directory Cache ctor enter");
  
-   // Parse the directory type (full_map, limited_no_broadcast, limited_broadcast, ackwise, limitless) 
+   // Parse the directory type (full_map, limited_no_broadcast, limited_broadcast, ackwise, limitless,
+   // coarse_vector, hierarchical)
    _directory_type = DirectoryEntry::parseDirectoryType(directory_type_str);
 
    // Determine total number of directory entries (either automatically or user specified)
@@ -58,6 +61,10 @@ DirectoryCache::DirectoryCache(Tile* tile,
    {
       _power_model = new CachePowerModel("directory", _total_entries * directory_entry_size,
             directory_entry_size, _associativity, _directory_access_time, core_frequency);
+      // Power trace
+      if (Sim()->getStatisticsManager())
+         Sim()->getStatisticsManager()->registerPowerModel(_tile->getId(), _power_model);
+      _power_model->registerEventCounters(_tile->getId(), "Directory Cache/Power Model ");
    }
    if (Config::getSingleton()->getEnableAreaModeling())
    {
@@ -65,9 +72,15 @@ DirectoryCache::DirectoryCache(Tile* tile,
             directory_entry_size, _associativity, _directory_access_time, core_frequency);
    }
 
+   // A directory access only reads the tags (the entries) of its bank
+   _bank_model = CacheBankModel::create("dram_directory", "parallel", 0, _directory_access_time, _cache_line_size);
+
    _log_num_sets = floorLog2(_num_sets);
    _log_cache_line_size = floorLog2(_cache_line_size);
    _log_num_directory_slices = ceilLog2(_num_directory_slices); 
+
+   _directory_entry_table = new DirectoryEntryTable(_total_entries, _cache_line_size);
+   _set_num_valid_entries.resize(_num_sets, 0);
    
    initializeEventCounters();
 
@@ -76,7 +89,11 @@ DirectoryCache::DirectoryCache(Tile* tile,
 
 DirectoryCache::~DirectoryCache()
 {
+   delete _directory_entry_table;
+   for (vector<DirectoryEntry*>::iterator it = _free_directory_entry_list.begin(); it != _free_directory_entry_list.end(); it++)
+      delete (*it);
    delete _directory;
+   delete _bank_model;
 }
 
 void
@@ -104,40 +121,41 @@ DirectoryCache::getDirectoryEntry(IntPtr address)
    if (_enabled)
    {
       // Update Performance Model
-      getShmemPerfModel()->incrCycleCount(_directory_access_time);
+      getShmemPerfModel()->incrCycleCount(getAccessTime(address));
       // Update event & dynamic energy counters
       updateCounters();
    }
 
+   // Find the relevant directory entry
+   DirectoryEntry* directory_entry = _directory_entry_table->find(address);
+   if (directory_entry)
+   {
+      if (getShmemPerfModel())
+         getShmemPerfModel()->incrCycleCount(directory_entry->getLatency());
+      // Simple check for now. Make sophisticated later
+      return directory_entry;
+   }
+
    IntPtr tag;
    UInt32 set_index;
    
    // Assume that it always hit in the Dram Directory Cache for now
    splitAddress(address, tag, set_index);
-   
-   // Find the relevant directory entry
-   for (UInt32 i = 0; i < _associativity; i++)
-   {
-      DirectoryEntry* directory_entry = _directory->getDirectoryEntry(set_index * _associativity + i);
-
-      if (directory_entry->getAddress() == address)
-      {
-         if (getShmemPerfModel())
-            getShmemPerfModel()->incrCycleCount(directory_entry->getLatency());
-         // Simple check for now. Make sophisticated later
-         return directory_entry;
-      }
-   }
 
    // Find a free directory entry if one does not currently exist
-   for (UInt32 i = 0; i < _associativity; i++)
+   if (_set_num_valid_entries[set_index] < _associativity)
    {
-      DirectoryEntry* directory_entry = _directory->getDirectoryEntry(set_index * _associativity + i);
-      if (directory_entry->getAddress() == INVALID_ADDRESS)
+      for (UInt32 i = 0; i < _associativity; i++)
       {
-         // Simple check for now. Make sophisticated later
-         directory_entry->setAddress(address);
-         return directory_entry;
+         DirectoryEntry* directory_entry = _directory->getDirectoryEntry(set_index * _associativity + i);
+         if (directory_entry->getAddress() == INVALID_ADDRESS)
+         {
+            // Simple check for now. Make sophisticated later
+            directory_entry->setAddress(address);
+            _directory_entry_table->insert(address, directory_entry);
+            _set_num_valid_entries[set_index] ++;
+            return directory_entry;
+         }
       }
    }
 
@@ -177,7 +195,16 @@ DirectoryCache::replaceDirectoryEntry(IntPtr replaced_address, IntPtr address)
    splitAddress(replaced_address, tag, set_index);
 
    DirectoryEntry* replaced_directory_entry = NULL;
-   DirectoryEntry* new_directory_entry = DirectoryEntry::create(_caching_protocol_type, _directory_type, _max_hw_sharers, _max_num_sharers);
+   DirectoryEntry* new_directory_entry = NULL;
+   if (_free_directory_entry_list.empty())
+   {
+      new_directory_entry = DirectoryEntry::create(_caching_protocol_type, _directory_type, _max_hw_sharers, _max_num_sharers);
+   }
+   else
+   {
+      new_directory_entry = _free_directory_entry_list.back();
+      _free_directory_entry_list.pop_back();
+   }
    new_directory_entry->setAddress(address);
 
    for (UInt32 i = 0; i < _associativity; i++)
@@ -193,11 +220,13 @@ DirectoryCache::replaceDirectoryEntry(IntPtr replaced_address, IntPtr address)
 
    LOG_ASSERT_ERROR(replaced_directory_entry, "Could not find address(%#lx) to replace", replaced_address);
    _replaced_directory_entry_list.push_back(replaced_directory_entry);
+   _directory_entry_table->erase(replaced_address);
+   _directory_entry_table->insert(address, new_directory_entry);
 
    if (_enabled)
    {
       // Update Performance Model
-      getShmemPerfModel()->incrCycleCount(_directory_access_time);
+      getShmemPerfModel()->incrCycleCount(getAccessTime(address));
       // Update event & dynamic energy counters
       updateCounters();
       // Increment number of evictions
@@ -219,7 +248,8 @@ DirectoryCache::invalidateDirectoryEntry(IntPtr address)
    {
       if ((*it)->getAddress() == address)
       {
-         delete (*it);
+         (*it)->reset();
+         _free_directory_entry_list.push_back(*it);
          _replaced_directory_entry_list.erase(it);
 
          return;
@@ -345,6 +375,50 @@ DirectoryCache::computeSetIndex(IntPtr address)
    return (UInt32) set;
 }
 
+void
+DirectoryCache::saveState(CheckpointWriter& writer)
+{
+   LOG_ASSERT_ERROR(_replaced_directory_entry_list.empty(),
+                    "Directory entry replacements in progress at checkpoint");
+   writer.beginSection("Directory Cache");
+   writer << _num_sets << _associativity << (UInt32) _directory_type;
+   _directory->saveState(writer);
+}
+
+void
+DirectoryCache::restoreState(CheckpointReader& reader)
+{
+   LOG_ASSERT_ERROR(_replaced_directory_entry_list.empty(),
+                    "Directory entry replacements in progress at restore");
+   reader.beginSection("Directory Cache");
+   UInt32 num_sets, associativity, directory_type;
+   reader >> num_sets >> associativity >> directory_type;
+   LOG_ASSERT_ERROR((num_sets == _num_sets) && (associativity == _associativity) && (directory_type == (UInt32) _directory_type),
+                    "Directory cache: checkpoint geometry(%u sets, %u ways, type %u), directory(%u sets, %u ways, type %u)",
+                    num_sets, associativity, directory_type, _num_sets, _associativity, _directory_type);
+   _directory->restoreState(reader);
+   rebuildDirectoryEntryTable();
+}
+
+void
+DirectoryCache::rebuildDirectoryEntryTable()
+{
+   _directory_entry_table->clear();
+   for (UInt32 set_index = 0; set_index < _num_sets; set_index++)
+   {
+      _set_num_valid_entries[set_index] = 0;
+      for (UInt32 i = 0; i < _associativity; i++)
+      {
+         DirectoryEntry* directory_entry = _directory->getDirectoryEntry(set_index * _associativity + i);
+         if (directory_entry->getAddress() != INVALID_ADDRESS)
+         {
+            _directory_entry_table->insert(directory_entry->getAddress(), directory_entry);
+            _set_num_valid_entries[set_index] ++;
+         }
+      }
+   }
+}
+
 void
 DirectoryCache::outputSummary(ostream& out)
 {
@@ -352,12 +426,16 @@ DirectoryCache::outputSummary(ostream& out)
    out << "    Total Accesses: " << _total_directory_accesses << endl;
    out << "    Total Evictions: " << _total_evictions << endl;
    out << "    Total Back-Invalidations: " << _total_back_invalidations << endl;
+   if (_directory_type == COARSE_VECTOR)
+      out << "    Total Extra Invalidations: " << getTotalExtraInvalidations() << endl;
 
    // The power and area model summary
    if (Config::getSingleton()->getEnablePowerModeling())
       _power_model->outputSummary(out);
    if (Config::getSingleton()->getEnableAreaModeling())
       _area_model->outputSummary(out);
+   if (_bank_model)
+      _bank_model->outputSummary(out);
 }
 
 void
@@ -367,6 +445,8 @@ DirectoryCache::dummyOutputSummary(ostream& out, tile_id_t tile_id)
    out << "    Total Accesses: " << endl;
    out << "    Total Evictions: " << endl;
    out << "    Total Back-Invalidations: " << endl;
+   if (Sim()->getCfg()->getString("dram_directory/directory_type") == "coarse_vector")
+      out << "    Total Extra Invalidations: " << endl;
 
    // The power and area model summary
    if (Config::getSingleton()->getEnablePowerModeling())
@@ -375,6 +455,20 @@ DirectoryCache::dummyOutputSummary(ostream& out, tile_id_t tile_id)
       CacheAreaModel::dummyOutputSummary(out);
 }
 
+UInt64
+DirectoryCache::getTotalExtraInvalidations()
+{
+   // Kept by the entries, all of them live until the end of the simulation
+   UInt64 total_extra_invalidations = 0;
+   for (UInt32 i = 0; i < _total_entries; i++)
+      total_extra_invalidations += _directory->getDirectoryEntry(i)->getNumExtraInvalidations();
+   for (UInt32 i = 0; i < _replaced_directory_entry_list.size(); i++)
+      total_extra_invalidations += _replaced_directory_entry_list[i]->getNumExtraInvalidations();
+   for (UInt32 i = 0; i < _free_directory_entry_list.size(); i++)
+      total_extra_invalidations += _free_directory_entry_list[i]->getNumExtraInvalidations();
+   return total_extra_invalidations;
+}
+
 void
 DirectoryCache::printAutogenDirectorySizeAndAccessTime(ostream& out)
 {
@@ -409,3 +503,13 @@ DirectoryCache::getShmemPerfModel()
 {
    return _tile->getMemoryManager()->getShmemPerfModel();
 }
+
+UInt64
+DirectoryCache::getAccessTime(IntPtr address)
+{
+   if (!_bank_model)
+      return _directory_access_time;
+   UInt64 queue_delay = _bank_model->computeQueueDelay(address, CachePerfModel::ACCESS_CACHE_TAGS,
+                                                       getShmemPerfModel()->getCycleCount());
+   return _directory_access_time + queue_delay;
+}
@@ -12,6 +12,8 @@ using std::ostream;
 #include "directory_entry.h"
 #include "directory_type.h"
 #include "caching_protocol_type.h"
+#include "directory_entry_table.h"
+#include "cache_bank_model.h"
 
 class DirectoryCache
 {
@@ -35,20 +37,27 @@ public:
    void getReplacementCandidates(IntPtr address, vector<DirectoryEntry*>& replacement_candidate_list);
 
    void outputSummary(ostream& os);
+
+   // Checkpointing of the directory entries. A checkpoint can only be
+   // restored into a directory of the same size and type
+   void saveState(CheckpointWriter& writer);
+   void restoreState(CheckpointReader& reader);
    static void dummyOutputSummary(ostream& os, tile_id_t tile_id);
 
-   void enable() { _enabled = true; }
-   void disable() { _enabled = false; }
+   void enable() { _enabled = true; if (_bank_model) _bank_model->enable(); }
+   void disable() { _enabled = false; if (_bank_model) _bank_model->disable(); }
 
 private:
    Tile* _tile;
    Directory* _directory;
    vector<DirectoryEntry*> _replaced_directory_entry_list;
-   
-   map<IntPtr,UInt64> _address_map;
-   vector<map<IntPtr,UInt64> > _set_specific_address_map;
-   map<IntPtr,UInt64> _replaced_address_map;
-   vector<UInt64> _set_replacement_histogram;
+
+   // Address -> entry, for the entries in the directory (not the replaced ones)
+   DirectoryEntryTable* _directory_entry_table;
+   // Number of entries of each set that have been given an address
+   vector<UInt32> _set_num_valid_entries;
+   // Replaced entries that were invalidated, reused by later replacements
+   vector<DirectoryEntry*> _free_directory_entry_list;
 
    CachingProtocolType _caching_protocol_type;
    DirectoryType _directory_type;
@@ -75,6 +84,8 @@ private:
    // Dram Directory Cache Power and Area Models
    CachePowerModel* _power_model;
    CacheAreaModel* _area_model;
+   // Contention for the banks of the slice (NULL if not banked)
+   CacheBankModel* _bank_model;
 
    // Counters
    UInt64 _total_directory_accesses;
@@ -94,11 +105,16 @@ private:
    void splitAddress(IntPtr address, IntPtr& tag, UInt32& set_index);
 
    void updateCounters();
+   // Invalidations sent to tiles that were not sharers (coarse_vector)
+   UInt64 getTotalExtraInvalidations();
    IntPtr computeSetIndex(IntPtr address);
+   void rebuildDirectoryEntryTable();
   
    // Output auto-generated directory size and access time
    void printAutogenDirectorySizeAndAccessTime(ostream& out);
    static void dummyPrintAutogenDirectorySizeAndAccessTime(ostream& out);
 
    ShmemPerfModel* getShmemPerfModel();
+   // Access time plus the wait for the bank of 'address'
+   UInt64 getAccessTime(IntPtr address);
 };
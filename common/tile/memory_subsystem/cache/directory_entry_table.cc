@@ -0,0 +1,96 @@
+#include <stdlib.h>
+
+#include "directory_entry_table.h"
+#include "utils.h"
+#include "log.h"
+
+DirectoryEntryTable::DirectoryEntryTable(UInt32 max_entries, UInt32 cache_line_size)
+   : _max_entries(max_entries)
+   , _num_entries(0)
+{
+   _num_slots = 1 << ceilLog2(2 * _max_entries);
+   _slot_mask = _num_slots - 1;
+   _log_cache_line_size = floorLog2(cache_line_size);
+
+   __attribute(__unused__) SInt32 err = posix_memalign((void**) &_slots, 64, _num_slots * sizeof(Slot));
+   LOG_ASSERT_ERROR(err == 0, "Could not allocate directory entry table(%u slots)", _num_slots);
+   clear();
+}
+
+DirectoryEntryTable::~DirectoryEntryTable()
+{
+   free(_slots);
+}
+
+UInt32
+DirectoryEntryTable::getHomeSlot(IntPtr address) const
+{
+   // Fibonacci hashing of the line address
+   UInt64 line_address = address >> _log_cache_line_size;
+   return (UInt32) ((line_address * 0x9E3779B97F4A7C15ULL) >> 32) & _slot_mask;
+}
+
+DirectoryEntry*
+DirectoryEntryTable::find(IntPtr address) const
+{
+   for (UInt32 slot = getHomeSlot(address); _slots[slot].address != INVALID_ADDRESS; slot = (slot + 1) & _slot_mask)
+   {
+      if (_slots[slot].address == address)
+         return _slots[slot].directory_entry;
+   }
+   return (DirectoryEntry*) NULL;
+}
+
+void
+DirectoryEntryTable::insert(IntPtr address, DirectoryEntry* directory_entry)
+{
+   LOG_ASSERT_ERROR(_num_entries < _max_entries, "Directory entry table full(%u entries)", _max_entries);
+
+   UInt32 slot = getHomeSlot(address);
+   while (_slots[slot].address != INVALID_ADDRESS)
+   {
+      LOG_ASSERT_ERROR(_slots[slot].address != address, "Address(%#lx) already in directory entry table", address);
+      slot = (slot + 1) & _slot_mask;
+   }
+   _slots[slot].address = address;
+   _slots[slot].directory_entry = directory_entry;
+   _num_entries ++;
+}
+
+void
+DirectoryEntryTable::erase(IntPtr address)
+{
+   UInt32 slot = getHomeSlot(address);
+   while (_slots[slot].address != address)
+   {
+      LOG_ASSERT_ERROR(_slots[slot].address != INVALID_ADDRESS, "Address(%#lx) not in directory entry table", address);
+      slot = (slot + 1) & _slot_mask;
+   }
+
+   // Shift back the following slots that would no longer be reachable
+   UInt32 hole = slot;
+   for (UInt32 next = (hole + 1) & _slot_mask; _slots[next].address != INVALID_ADDRESS; next = (next + 1) & _slot_mask)
+   {
+      UInt32 home = getHomeSlot(_slots[next].address);
+      // Can the entry in 'next' be moved to the hole (is the hole between its home and 'next')?
+      if (((next - home) & _slot_mask) >= ((next - hole) & _slot_mask))
+      {
+         _slots[hole] = _slots[next];
+         hole = next;
+      }
+   }
+   _slots[hole].address = INVALID_ADDRESS;
+   _slots[hole].directory_entry = NULL;
+   _num_entries --;
+}
+
+void
+DirectoryEntryTable::clear()
+{
+   for (UInt32 i = 0; i < _num_slots; i++)
+   {
+      _slots[i].address = INVALID_ADDRESS;
+      _slots[i].directory_entry = NULL;
+   }
+   _num_entries = 0;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "fixed_types.h"
+
+class DirectoryEntry;
+
+// Open-addressed (linear probing) table from the address of a directory
+// entry to the entry. The table is a flat array of (address, entry) slots
+// aligned to cache lines, so a lookup usually touches a single line
+// instead of the entry objects of a whole set.
+//   The table is sized for a load factor of at most 1/2 and deletions
+// shift the following slots back, so there are no tombstones.
+
+class DirectoryEntryTable
+{
+public:
+   DirectoryEntryTable(UInt32 max_entries, UInt32 cache_line_size);
+   ~DirectoryEntryTable();
+
+   // NULL if the address is not in the table
+   DirectoryEntry* find(IntPtr address) const;
+   void insert(IntPtr address, DirectoryEntry* directory_entry);
+   void erase(IntPtr address);
+   void clear();
+
+   UInt32 size() const { return _num_entries; }
+
+private:
+   struct Slot
+   {
+      IntPtr address;
+      DirectoryEntry* directory_entry;
+   };
+
+   Slot* _slots;
+   UInt32 _num_slots;
+   UInt32 _slot_mask;
+   UInt32 _max_entries;
+   UInt32 _num_entries;
+   UInt32 _log_cache_line_size;
+
+   UInt32 getHomeSlot(IntPtr address) const;
+};
@@ -0,0 +1,117 @@
+#include "line_utilization_tracker.h"
+#include "simulator.h"
+#include "config.h"
+#include "utils.h"
+#include "log.h"
+
+using std::endl;
+
+LineUtilizationTracker::LineUtilizationTracker(UInt32 line_size, UInt32 word_size, UInt32 sub_line_size,
+                                               UInt32 word_level_threshold)
+   : _line_size(line_size)
+   , _word_size(word_size)
+   , _sub_line_size(sub_line_size)
+   , _word_level_threshold(word_level_threshold)
+   , _total_lines(0)
+   , _total_words_used(0)
+   , _total_sub_line_bytes(0)
+   , _total_adaptive_bytes(0)
+{
+   LOG_ASSERT_ERROR(isPower2(_word_size) && (_word_size <= _line_size) && (_line_size / _word_size <= 64),
+                    "Line utilization word size(%u) must be a power of 2, with at most 64 words per line(%u bytes)",
+                    _word_size, _line_size);
+   LOG_ASSERT_ERROR(isPower2(_sub_line_size) && (_sub_line_size >= _word_size) && (_sub_line_size <= _line_size),
+                    "Line utilization sub-line size(%u) must be a power of 2 between the word size(%u) and the line size(%u)",
+                    _sub_line_size, _word_size, _line_size);
+
+   _log_word_size = floorLog2(_word_size);
+   _words_per_line = _line_size / _word_size;
+   _words_per_sub_line = _sub_line_size / _word_size;
+   _words_used_histogram.resize(CacheState::NUM_STATES, vector<UInt64>(_words_per_line + 1, 0));
+}
+
+LineUtilizationTracker::~LineUtilizationTracker()
+{}
+
+LineUtilizationTracker*
+LineUtilizationTracker::create(UInt32 line_size)
+{
+   bool enabled = false;
+   UInt32 word_size = 0;
+   UInt32 sub_line_size = 0;
+   UInt32 word_level_threshold = 0;
+   try
+   {
+      enabled = Sim()->getCfg()->getBool("cache_statistics/line_utilization", false);
+      word_size = Sim()->getCfg()->getInt("cache_statistics/line_utilization_word_size", 8);
+      sub_line_size = Sim()->getCfg()->getInt("cache_statistics/line_utilization_sub_line_size", 16);
+      word_level_threshold = Sim()->getCfg()->getInt("cache_statistics/line_utilization_word_level_threshold", 2);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read [cache_statistics] line utilization parameters from the cfg file");
+   }
+   if (!enabled)
+      return NULL;
+   return new LineUtilizationTracker(line_size, word_size, sub_line_size, word_level_threshold);
+}
+
+void
+LineUtilizationTracker::recordRemoval(CacheState::Type cstate, UInt64 word_bitmap)
+{
+   UInt32 words_used = 0;
+   UInt32 sub_lines_used = 0;
+   for (UInt32 i = 0; i < _words_per_line; i += _words_per_sub_line)
+   {
+      bool sub_line_used = false;
+      for (UInt32 j = i; j < i + _words_per_sub_line; j++)
+      {
+         if (word_bitmap & (((UInt64) 1) << j))
+         {
+            words_used ++;
+            sub_line_used = true;
+         }
+      }
+      if (sub_line_used)
+         sub_lines_used ++;
+   }
+
+   _words_used_histogram[cstate][words_used] ++;
+   _total_lines ++;
+   _total_words_used += words_used;
+   _total_sub_line_bytes += sub_lines_used * _sub_line_size;
+   _total_adaptive_bytes += (words_used <= _word_level_threshold) ? (words_used * _word_size) : _line_size;
+}
+
+void
+LineUtilizationTracker::outputSummary(std::ostream& out, UInt32 scale)
+{
+   UInt64 fetched_bytes = _total_lines * _line_size;
+
+   out << "    Line Utilization (" << _word_size << "-Byte Words):" << endl;
+   out << "      Lines Removed: " << _total_lines * scale << endl;
+   if (_total_lines > 0)
+      out << "      Average Words Used: " << ((float) _total_words_used) / _total_lines << " of " << _words_per_line << endl;
+   else
+      out << "      Average Words Used: " << endl;
+   for (UInt32 cstate = 0; cstate < CacheState::NUM_STATES; cstate++)
+   {
+      UInt64 num_lines = 0;
+      for (UInt32 i = 0; i <= _words_per_line; i++)
+         num_lines += _words_used_histogram[cstate][i];
+      if (num_lines == 0)
+         continue;
+      out << "      Words Used Histogram (" << CacheState::getName((CacheState::Type) cstate) << "):";
+      for (UInt32 i = 0; i <= _words_per_line; i++)
+         out << " " << _words_used_histogram[cstate][i] * scale;
+      out << endl;
+   }
+   out << "      Fetched Bytes: " << fetched_bytes * scale << endl;
+   out << "      Sub-Line Fetch Bytes (" << _sub_line_size << "-Byte Sub-Lines): " << _total_sub_line_bytes * scale << endl;
+   out << "      Adaptive Fetch Bytes (Word-Level up to " << _word_level_threshold << " Words): "
+       << _total_adaptive_bytes * scale << endl;
+   if (fetched_bytes > 0)
+      out << "      Wasted Fetch Bandwidth (%): " << 100.0 * (fetched_bytes - _total_words_used * _word_size) / fetched_bytes << endl;
+   else
+      out << "      Wasted Fetch Bandwidth (%): " << endl;
+}
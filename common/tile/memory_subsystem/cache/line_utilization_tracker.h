@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+#include <ostream>
+using std::vector;
+
+#include "fixed_types.h"
+#include "cache_state.h"
+
+// Word-granularity utilization of the lines of a cache ([cache_statistics]
+// line_utilization). The words a line gets accessed are kept as a bitmap in
+// its CacheLineInfo; when the line is evicted or invalidated, the number of
+// words used is added to a histogram, overall and by the coherence state the
+// line was in.
+//   Adaptive line size study: the bytes the removed lines were fetched with
+// are compared with what fetching only the sub-lines that were used would
+// have moved, and with an adaptive scheme that moves the lines of at most
+// 'word_level_threshold' words word by word (a word-level protocol) and the
+// others as whole lines. Both are oracle estimates from the bitmaps, the
+// protocol still moves whole lines.
+
+class LineUtilizationTracker
+{
+public:
+   LineUtilizationTracker(UInt32 line_size, UInt32 word_size, UInt32 sub_line_size, UInt32 word_level_threshold);
+   ~LineUtilizationTracker();
+
+   // Reads the [cache_statistics] line_utilization parameters, NULL if disabled
+   static LineUtilizationTracker* create(UInt32 line_size);
+
+   // Bitmap of the words of a line touched by an access of 'num_bytes' at 'offset'
+   UInt64 getWordMask(UInt32 offset, UInt32 num_bytes) const
+   {
+      UInt32 first = offset >> _log_word_size;
+      UInt32 last = (offset + num_bytes - 1) >> _log_word_size;
+      UInt64 upper = (last == 63) ? ~((UInt64) 0) : ((((UInt64) 1) << (last + 1)) - 1);
+      return upper & ~((((UInt64) 1) << first) - 1);
+   }
+
+   // A line leaves the cache in 'cstate' with the words of 'word_bitmap' used
+   void recordRemoval(CacheState::Type cstate, UInt64 word_bitmap);
+
+   // The counters are of the sampled sets, multiplied by 'scale'
+   void outputSummary(std::ostream& out, UInt32 scale);
+
+private:
+   UInt32 _line_size;
+   UInt32 _word_size;
+   UInt32 _log_word_size;
+   UInt32 _words_per_line;
+   UInt32 _sub_line_size;
+   UInt32 _words_per_sub_line;
+   UInt32 _word_level_threshold;
+
+   // [cstate][words used]
+   vector< vector<UInt64> > _words_used_histogram;
+   UInt64 _total_lines;
+   UInt64 _total_words_used;
+   UInt64 _total_sub_line_bytes;
+   UInt64 _total_adaptive_bytes;
+};
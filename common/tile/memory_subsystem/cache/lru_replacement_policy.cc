@@ -48,3 +48,17 @@ LRUReplacementPolicy::update(CacheLineInfo** cache_line_info_array, UInt32 set_n
    }
    lru_bits[accessed_way] = 0;
 }
+
+void
+LRUReplacementPolicy::saveState(CheckpointWriter& writer)
+{
+   for (UInt32 set_num = 0; set_num < _num_sets; set_num ++)
+      writer.putVector(_lru_bits_vec[set_num]);
+}
+
+void
+LRUReplacementPolicy::restoreState(CheckpointReader& reader)
+{
+   for (UInt32 set_num = 0; set_num < _num_sets; set_num ++)
+      reader.getVector(_lru_bits_vec[set_num]);
+}
@@ -0,0 +1,140 @@
+#include "miss_type_tracker.h"
+#include "utils.h"
+#include "log.h"
+
+MissTypeTracker::MissTypeTracker(UInt32 max_entries)
+   : _num_entries(0)
+   , _max_entries(max_entries)
+   , _clock_hand(0)
+{
+   // Keep the load factor at or below 3/4
+   UInt32 capacity = INITIAL_CAPACITY;
+   if (_max_entries > 0)
+   {
+      LOG_ASSERT_ERROR(_max_entries <= (1U << 30), "Max Entries(%u) too large", _max_entries);
+      capacity = 1U << ceilLog2(_max_entries + _max_entries / 3 + 1);
+   }
+   allocate(capacity);
+}
+
+MissTypeTracker::~MissTypeTracker()
+{
+   delete [] _keys;
+   delete [] _flags;
+}
+
+void
+MissTypeTracker::allocate(UInt32 capacity)
+{
+   assert(isPower2(capacity));
+   _capacity = capacity;
+   _keys = new IntPtr[_capacity];
+   _flags = new UInt8[_capacity];
+   for (UInt32 i = 0; i < _capacity; i++)
+      _flags[i] = 0;
+}
+
+UInt32
+MissTypeTracker::findSlot(IntPtr address) const
+{
+   UInt32 slot = getHomeSlot(address);
+   while ((_flags[slot] != 0) && (_keys[slot] != address))
+      slot = (slot + 1) & (_capacity - 1);
+   return slot;
+}
+
+UInt8
+MissTypeTracker::getFlags(IntPtr address) const
+{
+   UInt32 slot = findSlot(address);
+   return _flags[slot];
+}
+
+void
+MissTypeTracker::setFlags(IntPtr address, UInt8 flags)
+{
+   UInt32 slot = findSlot(address);
+   if (_flags[slot] != 0)
+   {
+      if (flags != 0)
+         _flags[slot] = flags;
+      else
+         eraseSlot(slot);
+      return;
+   }
+
+   if (flags == 0)
+      return;
+
+   // New address
+   if ((_max_entries > 0) && (_num_entries == _max_entries))
+   {
+      evictEntry();
+      slot = findSlot(address);
+   }
+   else if ((_max_entries == 0) && (4 * (_num_entries + 1) > 3 * _capacity))
+   {
+      grow();
+      slot = findSlot(address);
+   }
+
+   _keys[slot] = address;
+   _flags[slot] = flags;
+   _num_entries ++;
+}
+
+void
+MissTypeTracker::eraseSlot(UInt32 slot)
+{
+   assert(_flags[slot] != 0);
+   _flags[slot] = 0;
+   _num_entries --;
+
+   // Move back the following entries of the cluster that can no longer
+   // be reached from their home slot
+   UInt32 mask = _capacity - 1;
+   UInt32 hole = slot;
+   for (UInt32 next = (slot + 1) & mask; _flags[next] != 0; next = (next + 1) & mask)
+   {
+      UInt32 home = getHomeSlot(_keys[next]);
+      // The entry may fill the hole if its home is not in (hole, next]
+      if (((next - home) & mask) >= ((next - hole) & mask))
+      {
+         _keys[hole] = _keys[next];
+         _flags[hole] = _flags[next];
+         _flags[next] = 0;
+         hole = next;
+      }
+   }
+}
+
+void
+MissTypeTracker::evictEntry()
+{
+   assert(_num_entries > 0);
+   while (_flags[_clock_hand] == 0)
+      _clock_hand = (_clock_hand + 1) & (_capacity - 1);
+   eraseSlot(_clock_hand);
+}
+
+void
+MissTypeTracker::grow()
+{
+   IntPtr* old_keys = _keys;
+   UInt8* old_flags = _flags;
+   UInt32 old_capacity = _capacity;
+
+   allocate(2 * old_capacity);
+   for (UInt32 i = 0; i < old_capacity; i++)
+   {
+      if (old_flags[i] != 0)
+      {
+         UInt32 slot = findSlot(old_keys[i]);
+         _keys[slot] = old_keys[i];
+         _flags[slot] = old_flags[i];
+      }
+   }
+
+   delete [] old_keys;
+   delete [] old_flags;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "fixed_types.h"
+
+// Per-address flags used to classify cache misses. Replaces one
+// std::set per event type with a single open-addressing hash table
+// (linear probing, backward-shift deletion), i.e., one probe sequence
+// and no allocation per access.
+//   With max_entries = 0 the table grows without bound and the
+// classification is exact. Otherwise, once max_entries addresses are
+// tracked, inserting a new address drops the entry under a clock hand
+// that sweeps the table. The next miss to a dropped address is then
+// classified as a cold miss.
+
+class MissTypeTracker
+{
+public:
+   enum Flag
+   {
+      FETCHED = 1 << 0,
+      EVICTED = 1 << 1,
+      INVALIDATED = 1 << 2
+   };
+
+   MissTypeTracker(UInt32 max_entries);
+   ~MissTypeTracker();
+
+   // Flags of 'address', 0 if it is not tracked
+   UInt8 getFlags(IntPtr address) const;
+   // Setting the flags to 0 stops tracking 'address'
+   void setFlags(IntPtr address, UInt8 flags);
+
+   UInt32 getNumEntries() const { return _num_entries; }
+
+private:
+   static const UInt32 INITIAL_CAPACITY = 1024;
+
+   IntPtr* _keys;
+   // 0 marks an empty slot
+   UInt8* _flags;
+   UInt32 _capacity;
+   UInt32 _num_entries;
+   UInt32 _max_entries;
+   UInt32 _clock_hand;
+
+   UInt32 getHomeSlot(IntPtr address) const
+   {
+      // Fibonacci hashing, the high bits of the product are well mixed
+      // even for line-aligned addresses
+      return (UInt32) (((UInt64) address * 0x9E3779B97F4A7C15ULL) >> 32) & (_capacity - 1);
+   }
+   // Slot holding 'address', or the empty slot where it belongs
+   UInt32 findSlot(IntPtr address) const;
+   void eraseSlot(UInt32 slot);
+   void evictEntry();
+   void allocate(UInt32 capacity);
+   void grow();
+};
@@ -0,0 +1,83 @@
+#include <algorithm>
+
+#include "mshr_file.h"
+#include "log.h"
+
+MSHRFile::MSHRFile(UInt32 num_entries)
+   : _num_entries(num_entries)
+   , _latest_completion_time(0)
+{
+   LOG_ASSERT_ERROR(_num_entries > 0, "Number of MSHRs must be > 0");
+   _entries.reserve(2 * _num_entries);
+}
+
+MSHRFile::~MSHRFile()
+{}
+
+void
+MSHRFile::release(UInt64 time)
+{
+   UInt32 i = 0;
+   while (i < _entries.size())
+   {
+      if (_entries[i].completion_time <= time)
+      {
+         _entries[i] = _entries.back();
+         _entries.pop_back();
+      }
+      else
+      {
+         i ++;
+      }
+   }
+}
+
+UInt64
+MSHRFile::getAllocationTime(UInt64 time)
+{
+   release(time);
+
+   UInt32 num_busy_entries = 0;
+   UInt64 earliest_completion_time = UINT64_MAX;
+   for (vector<Entry>::const_iterator it = _entries.begin(); it != _entries.end(); it++)
+   {
+      if ((*it).occupies_entry && ((*it).start_time <= time))
+      {
+         num_busy_entries ++;
+         earliest_completion_time = std::min(earliest_completion_time, (*it).completion_time);
+      }
+   }
+
+   return (num_busy_entries < _num_entries) ? time : earliest_completion_time;
+}
+
+void
+MSHRFile::allocate(IntPtr address, UInt64 start_time, UInt64 completion_time, bool occupies_entry)
+{
+   if (completion_time <= start_time)
+      return;
+
+   Entry entry;
+   entry.address = address;
+   entry.start_time = start_time;
+   entry.completion_time = completion_time;
+   entry.occupies_entry = occupies_entry;
+   _entries.push_back(entry);
+
+   _latest_completion_time = std::max(_latest_completion_time, completion_time);
+}
+
+UInt64
+MSHRFile::getCompletionTime(IntPtr address, UInt64 time) const
+{
+   if (_latest_completion_time <= time)
+      return 0;
+
+   UInt64 completion_time = 0;
+   for (vector<Entry>::const_iterator it = _entries.begin(); it != _entries.end(); it++)
+   {
+      if (((*it).address == address) && ((*it).start_time <= time) && ((*it).completion_time > time))
+         completion_time = std::max(completion_time, (*it).completion_time);
+   }
+   return completion_time;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+using std::vector;
+
+#include "fixed_types.h"
+
+// Miss Status Holding Registers of a non-blocking cache, kept as a
+// timing model only. The functional memory access is still performed
+// by the application thread one miss at a time, so an entry is recorded
+// once its miss completes, as the interval [start_time, completion_time)
+// during which it was held.
+//   A new miss (issued at a time no earlier than the previous ones) waits
+// until an entry is free. An access to a line that is filled later in
+// simulated time than the access itself is merged with the in-flight miss
+// and completes when that miss does.
+
+class MSHRFile
+{
+public:
+   MSHRFile(UInt32 num_entries);
+   ~MSHRFile();
+
+   // Earliest time at or after 'time' at which an entry is free
+   UInt64 getAllocationTime(UInt64 time);
+   // Record a miss to 'address'. Misses that do not occupy an entry
+   // (e.g., prefetches, which are bounded separately) are only used
+   // for merging
+   void allocate(IntPtr address, UInt64 start_time, UInt64 completion_time, bool occupies_entry = true);
+   // Completion time of the miss to 'address' that is in flight at 'time', 0 if none
+   UInt64 getCompletionTime(IntPtr address, UInt64 time) const;
+
+   UInt32 getNumEntries() const { return _num_entries; }
+
+private:
+   struct Entry
+   {
+      IntPtr address;
+      UInt64 start_time;
+      UInt64 completion_time;
+      bool occupies_entry;
+   };
+
+   UInt32 _num_entries;
+   vector<Entry> _entries;
+   // Used to skip the lookup when no miss is in flight
+   UInt64 _latest_completion_time;
+
+   // Drop the misses completed by 'time'
+   void release(UInt64 time);
+};
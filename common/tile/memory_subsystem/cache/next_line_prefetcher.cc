@@ -0,0 +1,21 @@
+#include "next_line_prefetcher.h"
+
+NextLinePrefetcher::NextLinePrefetcher(UInt32 cache_line_size, UInt32 prefetch_degree)
+   : Prefetcher(cache_line_size, prefetch_degree)
+{}
+
+NextLinePrefetcher::~NextLinePrefetcher()
+{}
+
+void
+NextLinePrefetcher::getPrefetchAddresses(IntPtr address, vector<IntPtr>& prefetch_addresses)
+{
+   SInt64 line_num = getLineNum(address);
+   for (UInt32 i = 1; i <= _prefetch_degree; i++)
+   {
+      IntPtr prefetch_address;
+      if (!getLineInPage(address, line_num + i, prefetch_address))
+         break;
+      prefetch_addresses.push_back(prefetch_address);
+   }
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "prefetcher.h"
+
+// Fetches the 'prefetch_degree' lines that follow the accessed one
+
+class NextLinePrefetcher : public Prefetcher
+{
+public:
+   NextLinePrefetcher(UInt32 cache_line_size, UInt32 prefetch_degree);
+   ~NextLinePrefetcher();
+
+   void getPrefetchAddresses(IntPtr address, vector<IntPtr>& prefetch_addresses);
+};
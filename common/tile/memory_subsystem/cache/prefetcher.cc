@@ -0,0 +1,62 @@
+#include "prefetcher.h"
+#include "next_line_prefetcher.h"
+#include "stride_prefetcher.h"
+#include "stream_prefetcher.h"
+#include "utils.h"
+#include "log.h"
+
+Prefetcher::Prefetcher(UInt32 cache_line_size, UInt32 prefetch_degree)
+   : _log_cache_line_size(floorLog2(cache_line_size))
+   , _prefetch_degree(prefetch_degree)
+{
+   LOG_ASSERT_ERROR(prefetch_degree > 0, "Prefetch Degree must be > 0");
+}
+
+Prefetcher::~Prefetcher()
+{}
+
+Prefetcher*
+Prefetcher::create(string type_str, UInt32 cache_line_size, UInt32 prefetch_degree)
+{
+   if (type_str == "none")
+      return (Prefetcher*) NULL;
+
+   Type type = parse(type_str);
+   switch (type)
+   {
+   case NEXT_LINE:
+      return new NextLinePrefetcher(cache_line_size, prefetch_degree);
+   case STRIDE:
+      return new StridePrefetcher(cache_line_size, prefetch_degree);
+   case STREAM:
+      return new StreamPrefetcher(cache_line_size, prefetch_degree);
+   default:
+      LOG_PRINT_ERROR("Unrecognized Prefetcher Type(%u)", type);
+      return (Prefetcher*) NULL;
+   }
+}
+
+Prefetcher::Type
+Prefetcher::parse(string type_str)
+{
+   if (type_str == "next_line")
+      return NEXT_LINE;
+   if (type_str == "stride")
+      return STRIDE;
+   if (type_str == "stream")
+      return STREAM;
+   else
+   {
+      LOG_PRINT_ERROR("Unrecognized Prefetcher Type(%s)", type_str.c_str());
+      return NUM_TYPES;
+   }
+}
+
+bool
+Prefetcher::getLineInPage(IntPtr address, SInt64 line_num, IntPtr& line_address) const
+{
+   if (line_num < 0)
+      return false;
+   line_address = ((IntPtr) line_num) << _log_cache_line_size;
+   return ((line_address >> LOG_PAGE_SIZE) == (address >> LOG_PAGE_SIZE));
+}
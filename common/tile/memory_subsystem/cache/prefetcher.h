@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+#include "fixed_types.h"
+
+// Hardware-style prefetchers. A prefetcher is trained on the demand
+// accesses seen by a cache controller (misses and first hits to
+// prefetched lines) and returns the lines to fetch ahead of them. The
+// controller filters out lines that are present or in flight and sends
+// the rest as regular coherence requests. Prefetches never cross a page.
+
+class Prefetcher
+{
+public:
+   enum Type
+   {
+      NEXT_LINE = 0,
+      STRIDE,
+      STREAM,
+      NUM_TYPES
+   };
+
+   Prefetcher(UInt32 cache_line_size, UInt32 prefetch_degree);
+   virtual ~Prefetcher();
+
+   // Returns NULL if type_str is "none"
+   static Prefetcher* create(string type_str, UInt32 cache_line_size, UInt32 prefetch_degree);
+   static Type parse(string type_str);
+
+   // 'address' is line-aligned. Appends to prefetch_addresses.
+   virtual void getPrefetchAddresses(IntPtr address, vector<IntPtr>& prefetch_addresses) = 0;
+
+protected:
+   static const UInt32 LOG_PAGE_SIZE = 12;
+
+   UInt32 _log_cache_line_size;
+   UInt32 _prefetch_degree;
+
+   IntPtr getLineNum(IntPtr address) const
+   { return address >> _log_cache_line_size; }
+   // Line 'line_num' as an address, if it is in the same page as 'address'
+   bool getLineInPage(IntPtr address, SInt64 line_num, IntPtr& line_address) const;
+};
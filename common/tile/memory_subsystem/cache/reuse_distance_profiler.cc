@@ -0,0 +1,89 @@
+#include <algorithm>
+
+#include "reuse_distance_profiler.h"
+#include "utils.h"
+#include "log.h"
+
+ReuseDistanceProfiler::ReuseDistanceProfiler(float sampling_rate, UInt32 max_entries)
+   : _threshold((UInt32) (sampling_rate * HASH_RANGE))
+   , _max_entries(max_entries)
+   , _num_accesses(0)
+{
+   LOG_ASSERT_ERROR((sampling_rate > 0) && (sampling_rate <= 1), "Sampling rate(%f) must be in (0,1]", sampling_rate);
+   LOG_ASSERT_ERROR(_max_entries > 0, "Max entries must be > 0");
+   _threshold = std::max<UInt32>(_threshold, 1);
+   _stack.reserve(_max_entries + 1);
+   for (UInt32 i = 0; i < NUM_BUCKETS; i++)
+      _histogram[i] = 0;
+}
+
+ReuseDistanceProfiler::~ReuseDistanceProfiler()
+{}
+
+void
+ReuseDistanceProfiler::access(IntPtr line_address)
+{
+   UInt32 hash = getHash(line_address);
+   if (hash >= _threshold)
+      return;
+
+   // Every sampled access stands for HASH_RANGE / threshold accesses
+   UInt64 weight = (HASH_RANGE + _threshold / 2) / _threshold;
+   _num_accesses += weight;
+
+   UInt32 position = 0;
+   while ((position < _stack.size()) && (_stack[position].line_address != line_address))
+      position ++;
+
+   if (position < _stack.size())
+   {
+      UInt64 distance = ((UInt64) position) * HASH_RANGE / _threshold;
+      UInt32 bucket = NUM_BUCKETS - 1;
+      if (distance == 0)
+         bucket = 0;
+      else if (distance < (1ULL << (NUM_BUCKETS - 2)))
+         bucket = floorLog2(distance) + 1;
+      _histogram[bucket] += weight;
+      _stack.erase(_stack.begin() + position);
+   }
+
+   Entry entry;
+   entry.line_address = line_address;
+   entry.hash = hash;
+   _stack.insert(_stack.begin(), entry);
+   if (_stack.size() > _max_entries)
+      lowerThreshold();
+}
+
+void
+ReuseDistanceProfiler::lowerThreshold()
+{
+   // The largest hash becomes the threshold, its lines are no longer sampled
+   UInt32 max_hash = 0;
+   for (UInt32 i = 0; i < _stack.size(); i++)
+      max_hash = std::max(max_hash, _stack[i].hash);
+   _threshold = std::max<UInt32>(max_hash, 1);
+
+   UInt32 num_entries = 0;
+   for (UInt32 i = 0; i < _stack.size(); i++)
+   {
+      if (_stack[i].hash < _threshold)
+         _stack[num_entries ++] = _stack[i];
+   }
+   _stack.resize(num_entries);
+}
+
+UInt64
+ReuseDistanceProfiler::getNumHits(UInt32 size_log2) const
+{
+   UInt64 num_hits = 0;
+   for (UInt32 i = 0; (i <= size_log2) && (i < NUM_BUCKETS); i++)
+      num_hits += _histogram[i];
+   return num_hits;
+}
+
+float
+ReuseDistanceProfiler::getSamplingRate() const
+{
+   return ((float) _threshold) / HASH_RANGE;
+}
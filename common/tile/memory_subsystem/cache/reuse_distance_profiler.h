@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+using std::vector;
+
+#include "fixed_types.h"
+
+// Sampled reuse distances of the lines accessed in a cache (SHARDS): a line
+// is sampled if the hash of its address is below a threshold, i.e. a fixed
+// fraction of the lines (sampling_rate) is followed, whatever the access
+// pattern. The sampled lines are kept in an LRU stack; the position of a
+// line in the stack, divided by the sampling rate, estimates the number of
+// distinct lines accessed since its last access. A fully associative LRU
+// cache of C lines hits the accesses of reuse distance below C, so the
+// histogram of the distances gives the miss rate of every cache size.
+//   At most max_entries lines are kept: beyond that, the threshold is
+// lowered to drop the lines of the largest hashes and the rate falls with
+// it (the accesses are weighted by the rate at the time they are counted).
+// The counters only grow, they are read while the cache is in use by the
+// statistics trace.
+
+class ReuseDistanceProfiler
+{
+public:
+   // Bucket 0 counts the distance 0, bucket i the distances in
+   // [2^(i-1), 2^i) lines
+   static const UInt32 NUM_BUCKETS = 32;
+
+   ReuseDistanceProfiler(float sampling_rate, UInt32 max_entries);
+   ~ReuseDistanceProfiler();
+
+   void access(IntPtr line_address);
+
+   // Weighted accesses, and those that hit in a fully associative LRU
+   // cache of 2^size_log2 lines
+   UInt64 getNumAccesses() const { return _num_accesses; }
+   UInt64 getNumHits(UInt32 size_log2) const;
+   const volatile UInt64* getHistogram() const { return _histogram; }
+   float getSamplingRate() const;
+
+private:
+   // 24-bit hashes, a line is sampled if its hash is below the threshold
+   static const UInt32 HASH_RANGE = 1 << 24;
+
+   struct Entry
+   {
+      IntPtr line_address;
+      UInt32 hash;
+   };
+
+   UInt32 _threshold;
+   UInt32 _max_entries;
+   // The sampled lines, the most recently used first
+   vector<Entry> _stack;
+
+   volatile UInt64 _num_accesses;
+   volatile UInt64 _histogram[NUM_BUCKETS];
+
+   static UInt32 getHash(IntPtr line_address)
+   {
+      return (UInt32) (((UInt64) line_address * 0x9E3779B97F4A7C15ULL) >> 40);
+   }
+   void lowerThreshold();
+};
@@ -25,3 +25,15 @@ RoundRobinReplacementPolicy::update(CacheLineInfo** cache_line_info_array, UInt3
 {
    return;
 }
+
+void
+RoundRobinReplacementPolicy::saveState(CheckpointWriter& writer)
+{
+   writer.putVector(_replacement_index_vec);
+}
+
+void
+RoundRobinReplacementPolicy::restoreState(CheckpointReader& reader)
+{
+   reader.getVector(_replacement_index_vec);
+}
@@ -0,0 +1,90 @@
+#include "rrip_replacement_policy.h"
+#include "cache_line_info.h"
+#include "log.h"
+
+RRIPReplacementPolicy::RRIPReplacementPolicy(UInt32 cache_size, UInt32 associativity, UInt32 cache_line_size,
+                                             InsertionPolicy insertion_policy)
+   : CacheReplacementPolicy(cache_size, associativity, cache_line_size)
+   , _insertion_policy(insertion_policy)
+   , _num_insertions(0)
+{
+   LOG_ASSERT_ERROR(_associativity * RRPV_BITS <= 64, "RRIP supports an associativity of up to %u, got %u",
+                    64 / RRPV_BITS, _associativity);
+
+   _low_bits_mask = 0;
+   for (UInt32 way = 0; way < _associativity; way++)
+      _low_bits_mask |= (1ULL << (RRPV_BITS * way));
+   // All lines start with a distant re-reference
+   _rrpv_vec.resize(_num_sets, _low_bits_mask * DISTANT_RRPV);
+}
+
+RRIPReplacementPolicy::~RRIPReplacementPolicy()
+{}
+
+UInt32
+RRIPReplacementPolicy::getReplacementWay(CacheLineInfo** cache_line_info_array, UInt32 set_num)
+{
+   // Fill invalid ways first, invalidations do not reset the RRPV
+   for (UInt32 i = 0; i < _associativity; i++)
+   {
+      if (!cache_line_info_array[i]->isValid())
+         return i;
+   }
+
+   UInt64& rrpv = _rrpv_vec[set_num];
+   // Ways whose RRPV is DISTANT_RRPV (both bits set)
+   UInt64 distant_ways = rrpv & (rrpv >> 1) & _low_bits_mask;
+   if (distant_ways == 0)
+   {
+      // Age all the lines until the oldest one is distant. No field
+      // overflows since the largest RRPV ends up at DISTANT_RRPV.
+      UInt32 age;
+      if ((rrpv >> 1) & _low_bits_mask)
+         age = DISTANT_RRPV - 2;
+      else if (rrpv & _low_bits_mask)
+         age = DISTANT_RRPV - 1;
+      else
+         age = DISTANT_RRPV;
+      rrpv += age * _low_bits_mask;
+      distant_ways = rrpv & (rrpv >> 1) & _low_bits_mask;
+   }
+   assert(distant_ways != 0);
+   return __builtin_ctzll(distant_ways) / RRPV_BITS;
+}
+
+void
+RRIPReplacementPolicy::update(CacheLineInfo** cache_line_info_array, UInt32 set_num, UInt32 accessed_way)
+{
+   // Hit priority: predict a near-immediate re-reference
+   setRRPV(set_num, accessed_way, 0);
+}
+
+void
+RRIPReplacementPolicy::insert(CacheLineInfo** cache_line_info_array, UInt32 set_num, UInt32 inserted_way)
+{
+   setRRPV(set_num, inserted_way, getInsertionRRPV(cache_line_info_array, set_num, inserted_way));
+}
+
+UInt32
+RRIPReplacementPolicy::getInsertionRRPV(CacheLineInfo** cache_line_info_array, UInt32 set_num, UInt32 inserted_way)
+{
+   if (_insertion_policy == STATIC)
+      return LONG_RRPV;
+
+   _num_insertions ++;
+   return ((_num_insertions % BIMODAL_THROTTLE) == 0) ? LONG_RRPV : DISTANT_RRPV;
+}
+
+void
+RRIPReplacementPolicy::saveState(CheckpointWriter& writer)
+{
+   writer.putVector(_rrpv_vec);
+   writer << _num_insertions;
+}
+
+void
+RRIPReplacementPolicy::restoreState(CheckpointReader& reader)
+{
+   reader.getVector(_rrpv_vec);
+   reader >> _num_insertions;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+using std::vector;
+
+#include "cache_replacement_policy.h"
+
+// Re-Reference Interval Prediction (Jaleel et al., ISCA 2010) with 2-bit
+// re-reference prediction values (RRPV), packed in one word per set.
+// Hits predict a near re-reference (RRPV 0). SRRIP inserts lines with a
+// long interval (RRPV 2), BRRIP inserts most of them with a distant one
+// (RRPV 3) so that scans do not thrash the cache. The victim is a line
+// with RRPV 3; if there is none, the whole set is aged in a single add.
+
+class RRIPReplacementPolicy : public CacheReplacementPolicy
+{
+public:
+   enum InsertionPolicy
+   {
+      STATIC,
+      BIMODAL
+   };
+
+   RRIPReplacementPolicy(UInt32 cache_size, UInt32 associativity, UInt32 cache_line_size,
+                         InsertionPolicy insertion_policy);
+   ~RRIPReplacementPolicy();
+
+   UInt32 getReplacementWay(CacheLineInfo** cache_line_info_array, UInt32 set_num);
+   void update(CacheLineInfo** cache_line_info_array, UInt32 set_num, UInt32 accessed_way);
+   void insert(CacheLineInfo** cache_line_info_array, UInt32 set_num, UInt32 inserted_way);
+   void saveState(CheckpointWriter& writer);
+   void restoreState(CheckpointReader& reader);
+
+protected:
+   static const UInt32 RRPV_BITS = 2;
+   static const UInt32 DISTANT_RRPV = (1 << RRPV_BITS) - 1;
+   static const UInt32 LONG_RRPV = DISTANT_RRPV - 1;
+   // BRRIP inserts one line in BIMODAL_THROTTLE with a long interval
+   static const UInt32 BIMODAL_THROTTLE = 32;
+
+   UInt32 getRRPV(UInt32 set_num, UInt32 way) const
+   { return (_rrpv_vec[set_num] >> (RRPV_BITS * way)) & DISTANT_RRPV; }
+   void setRRPV(UInt32 set_num, UInt32 way, UInt32 rrpv)
+   {
+      UInt32 shift = RRPV_BITS * way;
+      _rrpv_vec[set_num] = (_rrpv_vec[set_num] & ~((UInt64) DISTANT_RRPV << shift)) | ((UInt64) rrpv << shift);
+   }
+
+   virtual UInt32 getInsertionRRPV(CacheLineInfo** cache_line_info_array, UInt32 set_num, UInt32 inserted_way);
+
+private:
+   vector<UInt64> _rrpv_vec;
+   // Lowest bit of the RRPV of every way
+   UInt64 _low_bits_mask;
+   InsertionPolicy _insertion_policy;
+   UInt32 _num_insertions;
+};
@@ -0,0 +1,188 @@
+#include <sstream>
+
+#include "shadow_tag_array.h"
+#include "constants.h"
+#include "utils.h"
+#include "log.h"
+
+ShadowTagArray::ShadowTagArray(UInt32 cache_size, UInt32 associativity, UInt32 line_size,
+                               CacheReplacementPolicy::Type policy)
+   : _associativity(associativity)
+   , _log_line_size(floorLog2(line_size))
+   , _policy(policy)
+   , _num_insertions(0)
+   , _num_accesses(0)
+   , _num_misses(0)
+   , _num_writebacks(0)
+{
+   LOG_ASSERT_ERROR((associativity > 0) && (associativity <= 256), "Shadow cache associativity(%u) must be in [1,256]",
+                    associativity);
+   LOG_ASSERT_ERROR((policy == CacheReplacementPolicy::LRU) || (policy == CacheReplacementPolicy::ROUND_ROBIN) ||
+                    (policy == CacheReplacementPolicy::SRRIP) || (policy == CacheReplacementPolicy::BRRIP),
+                    "Shadow caches support the lru, round_robin, srrip and brrip policies, not (%u)", policy);
+
+   _num_sets = (k_KILO * cache_size) / (associativity * line_size);
+   LOG_ASSERT_ERROR(_num_sets > 0, "Shadow cache of %u KB smaller than a %u-way set", cache_size, associativity);
+
+   _tags.resize(_num_sets * _associativity, 0);
+   _states.resize(_num_sets * _associativity, (_policy == CacheReplacementPolicy::LRU) ? 0 : DISTANT_RRPV);
+   _dirty.resize(_num_sets * _associativity, 0);
+   if (_policy == CacheReplacementPolicy::ROUND_ROBIN)
+      _next_ways.resize(_num_sets, 0);
+
+   std::ostringstream name;
+   name << cache_size << " KB " << associativity << "-way";
+   switch (_policy)
+   {
+   case CacheReplacementPolicy::LRU:         name << " lru"; break;
+   case CacheReplacementPolicy::ROUND_ROBIN: name << " round_robin"; break;
+   case CacheReplacementPolicy::SRRIP:       name << " srrip"; break;
+   default:                                  name << " brrip"; break;
+   }
+   _name = name.str();
+}
+
+ShadowTagArray::~ShadowTagArray()
+{}
+
+void
+ShadowTagArray::create(const string& shadow_caches, UInt32 line_size, vector<ShadowTagArray*>& shadow_tag_arrays)
+{
+   vector<string> specs;
+   splitIntoTokens(shadow_caches, specs, ", ");
+   for (UInt32 i = 0; i < specs.size(); i++)
+   {
+      vector<string> fields;
+      splitIntoTokens(specs[i], fields, ":");
+      LOG_ASSERT_ERROR(fields.size() == 3, "Shadow cache(%s) must be <size in KB>:<associativity>:<replacement policy>",
+                       specs[i].c_str());
+      shadow_tag_arrays.push_back(new ShadowTagArray(convertFromString<UInt32>(fields[0]),
+                                                     convertFromString<UInt32>(fields[1]), line_size,
+                                                     CacheReplacementPolicy::parse(fields[2])));
+   }
+}
+
+bool
+ShadowTagArray::access(IntPtr address, bool write)
+{
+   IntPtr line_num = address >> _log_line_size;
+   UInt32 set_num = line_num % _num_sets;
+   IntPtr tag = line_num + 1;
+
+   _num_accesses ++;
+   UInt32 way = find(set_num, tag);
+   bool hit = (way < _associativity);
+   if (!hit)
+   {
+      _num_misses ++;
+      way = getReplacementWay(set_num);
+      UInt32 index = set_num * _associativity + way;
+      if ((_tags[index] != 0) && _dirty[index])
+         _num_writebacks ++;
+      _tags[index] = tag;
+      _dirty[index] = 0;
+   }
+   if (write)
+      _dirty[set_num * _associativity + way] = 1;
+   touch(set_num, way, !hit);
+   return hit;
+}
+
+void
+ShadowTagArray::invalidate(IntPtr address)
+{
+   IntPtr line_num = address >> _log_line_size;
+   UInt32 set_num = line_num % _num_sets;
+   UInt32 way = find(set_num, line_num + 1);
+   if (way == _associativity)
+      return;
+
+   // The protocol wrote the data back, if it was dirty
+   UInt32 index = set_num * _associativity + way;
+   _tags[index] = 0;
+   _dirty[index] = 0;
+   if (_policy != CacheReplacementPolicy::LRU)
+      _states[index] = DISTANT_RRPV;
+}
+
+UInt32
+ShadowTagArray::getReplacementWay(UInt32 set_num)
+{
+   IntPtr* tags = &_tags[set_num * _associativity];
+   UInt8* states = &_states[set_num * _associativity];
+
+   // An empty way first
+   for (UInt32 i = 0; i < _associativity; i++)
+   {
+      if (tags[i] == 0)
+         return i;
+   }
+
+   switch (_policy)
+   {
+   case CacheReplacementPolicy::LRU:
+      {
+         UInt32 way = 0;
+         for (UInt32 i = 1; i < _associativity; i++)
+            way = (states[i] > states[way]) ? i : way;
+         return way;
+      }
+
+   case CacheReplacementPolicy::ROUND_ROBIN:
+      {
+         UInt32 way = _next_ways[set_num];
+         _next_ways[set_num] = (way + 1) % _associativity;
+         return way;
+      }
+
+   default:
+      {
+         // Age the set so that its oldest line is distant
+         UInt8 max_rrpv = 0;
+         for (UInt32 i = 0; i < _associativity; i++)
+            max_rrpv = (states[i] > max_rrpv) ? states[i] : max_rrpv;
+         UInt8 aging = DISTANT_RRPV - max_rrpv;
+         UInt32 way = _associativity;
+         for (UInt32 i = 0; i < _associativity; i++)
+         {
+            states[i] += aging;
+            if ((way == _associativity) && (states[i] == DISTANT_RRPV))
+               way = i;
+         }
+         return way;
+      }
+   }
+}
+
+void
+ShadowTagArray::touch(UInt32 set_num, UInt32 way, bool insertion)
+{
+   UInt8* states = &_states[set_num * _associativity];
+
+   switch (_policy)
+   {
+   case CacheReplacementPolicy::LRU:
+      {
+         // Ages are kept distinct within a set, 0 is the most recent
+         UInt8 age = insertion ? (UInt8) (_associativity - 1) : states[way];
+         for (UInt32 i = 0; i < _associativity; i++)
+            states[i] += (states[i] < age) ? 1 : 0;
+         states[way] = 0;
+      }
+      break;
+
+   case CacheReplacementPolicy::ROUND_ROBIN:
+      break;
+
+   case CacheReplacementPolicy::SRRIP:
+      states[way] = insertion ? LONG_RRPV : 0;
+      break;
+
+   default:
+      if (insertion)
+         states[way] = ((_num_insertions++ % BIMODAL_THROTTLE) == 0) ? LONG_RRPV : DISTANT_RRPV;
+      else
+         states[way] = 0;
+      break;
+   }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+#include "fixed_types.h"
+#include "cache_replacement_policy.h"
+
+// Tags of a cache of another size, associativity or replacement policy
+// than a real one, fed the same accesses ([cache_statistics]
+// shadow_l2_caches). It keeps no data and takes no time: it only counts the
+// hits and misses (and the writebacks of the lines written) the real cache
+// would have had with that geometry, so one run gives a first-order sweep.
+// The lines invalidated by the coherence protocol in the real cache are
+// invalidated in the shadow too.
+//   The tags of a set are contiguous, a lookup compares all the ways in a
+// loop without early exit (vectorized by the compiler). The replacement
+// state is one byte per line: the LRU age, or the RRPV of SRRIP/BRRIP
+// (round robin keeps a pointer per set instead).
+
+class ShadowTagArray
+{
+public:
+   // cache_size in KB
+   ShadowTagArray(UInt32 cache_size, UInt32 associativity, UInt32 line_size, CacheReplacementPolicy::Type policy);
+   ~ShadowTagArray();
+
+   // A list of "<size in KB>:<associativity>:<replacement policy>"
+   static void create(const string& shadow_caches, UInt32 line_size, vector<ShadowTagArray*>& shadow_tag_arrays);
+
+   // Returns true on a hit
+   bool access(IntPtr address, bool write);
+   void invalidate(IntPtr address);
+
+   // e.g. "256 KB 8-way lru"
+   const string& getName() const { return _name; }
+   UInt64 getNumAccesses() const { return _num_accesses; }
+   UInt64 getNumMisses() const { return _num_misses; }
+   UInt64 getNumWritebacks() const { return _num_writebacks; }
+   const UInt64* getNumAccessesCounter() const { return &_num_accesses; }
+   const UInt64* getNumMissesCounter() const { return &_num_misses; }
+   const UInt64* getNumWritebacksCounter() const { return &_num_writebacks; }
+
+private:
+   static const UInt8 DISTANT_RRPV = 3;
+   static const UInt8 LONG_RRPV = 2;
+   static const UInt32 BIMODAL_THROTTLE = 32;
+
+   string _name;
+   UInt32 _num_sets;
+   UInt32 _associativity;
+   UInt32 _log_line_size;
+   CacheReplacementPolicy::Type _policy;
+
+   // The line number + 1 of each way, 0 if the way is empty
+   vector<IntPtr> _tags;
+   vector<UInt8> _states;
+   vector<UInt8> _dirty;
+   vector<UInt32> _next_ways;
+   UInt32 _num_insertions;
+
+   UInt64 _num_accesses;
+   UInt64 _num_misses;
+   UInt64 _num_writebacks;
+
+   UInt32 find(UInt32 set_num, IntPtr tag) const
+   {
+      const IntPtr* tags = &_tags[set_num * _associativity];
+      UInt32 way = _associativity;
+      for (UInt32 i = 0; i < _associativity; i++)
+         way = (tags[i] == tag) ? i : way;
+      return way;
+   }
+   UInt32 getReplacementWay(UInt32 set_num);
+   void touch(UInt32 set_num, UInt32 way, bool insertion);
+};
@@ -0,0 +1,86 @@
+#include "ship_replacement_policy.h"
+#include "cache_line_info.h"
+#include "utils.h"
+#include "log.h"
+
+SHiPReplacementPolicy::SHiPReplacementPolicy(UInt32 cache_size, UInt32 associativity, UInt32 cache_line_size)
+   : RRIPReplacementPolicy(cache_size, associativity, cache_line_size, STATIC)
+{
+   UInt32 log_line_size = floorLog2(cache_line_size);
+   _log_lines_per_region = (LOG_REGION_SIZE > log_line_size) ? (LOG_REGION_SIZE - log_line_size) : 0;
+
+   // Counters start weakly re-referenced so that SHiP starts as SRRIP
+   _counters.resize(1 << LOG_NUM_COUNTERS, 1);
+   _line_signatures.resize(_num_sets * _associativity, 0);
+   _line_reused.resize(_num_sets * _associativity, false);
+}
+
+SHiPReplacementPolicy::~SHiPReplacementPolicy()
+{}
+
+UInt32
+SHiPReplacementPolicy::getSignature(IntPtr tag) const
+{
+   UInt64 region = tag >> _log_lines_per_region;
+   return (UInt32) ((region * 0x9E3779B97F4A7C15ULL) >> (64 - LOG_NUM_COUNTERS));
+}
+
+UInt32
+SHiPReplacementPolicy::getReplacementWay(CacheLineInfo** cache_line_info_array, UInt32 set_num)
+{
+   UInt32 way = RRIPReplacementPolicy::getReplacementWay(cache_line_info_array, set_num);
+
+   // Train on the evicted line: it was never re-referenced
+   UInt32 line = set_num * _associativity + way;
+   if (cache_line_info_array[way]->isValid() && !_line_reused[line])
+   {
+      UInt8& counter = _counters[_line_signatures[line]];
+      if (counter > 0)
+         counter --;
+   }
+   return way;
+}
+
+void
+SHiPReplacementPolicy::update(CacheLineInfo** cache_line_info_array, UInt32 set_num, UInt32 accessed_way)
+{
+   RRIPReplacementPolicy::update(cache_line_info_array, set_num, accessed_way);
+
+   UInt32 line = set_num * _associativity + accessed_way;
+   if (!_line_reused[line])
+   {
+      _line_reused[line] = true;
+      UInt8& counter = _counters[_line_signatures[line]];
+      if (counter < MAX_COUNTER)
+         counter ++;
+   }
+}
+
+UInt32
+SHiPReplacementPolicy::getInsertionRRPV(CacheLineInfo** cache_line_info_array, UInt32 set_num, UInt32 inserted_way)
+{
+   UInt32 line = set_num * _associativity + inserted_way;
+   UInt32 signature = getSignature(cache_line_info_array[inserted_way]->getTag());
+   _line_signatures[line] = signature;
+   _line_reused[line] = false;
+
+   return (_counters[signature] == 0) ? DISTANT_RRPV : LONG_RRPV;
+}
+
+void
+SHiPReplacementPolicy::saveState(CheckpointWriter& writer)
+{
+   RRIPReplacementPolicy::saveState(writer);
+   writer.putVector(_counters);
+   writer.putVector(_line_signatures);
+   writer.putVector(_line_reused);
+}
+
+void
+SHiPReplacementPolicy::restoreState(CheckpointReader& reader)
+{
+   RRIPReplacementPolicy::restoreState(reader);
+   reader.getVector(_counters);
+   reader.getVector(_line_signatures);
+   reader.getVector(_line_reused);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+using std::vector;
+
+#include "rrip_replacement_policy.h"
+
+// Signature-based Hit Predictor (Wu et al., MICRO 2011) on top of SRRIP.
+// The cache is not told the PC of an access, so the signature is the
+// memory region of the line (SHiP-Mem). A table of saturating counters
+// learns whether lines of a region get re-referenced: lines of regions
+// whose counter is 0 are inserted with a distant re-reference, others
+// as in SRRIP.
+
+class SHiPReplacementPolicy : public RRIPReplacementPolicy
+{
+public:
+   SHiPReplacementPolicy(UInt32 cache_size, UInt32 associativity, UInt32 cache_line_size);
+   ~SHiPReplacementPolicy();
+
+   UInt32 getReplacementWay(CacheLineInfo** cache_line_info_array, UInt32 set_num);
+   void update(CacheLineInfo** cache_line_info_array, UInt32 set_num, UInt32 accessed_way);
+   void saveState(CheckpointWriter& writer);
+   void restoreState(CheckpointReader& reader);
+
+protected:
+   UInt32 getInsertionRRPV(CacheLineInfo** cache_line_info_array, UInt32 set_num, UInt32 inserted_way);
+
+private:
+   static const UInt32 LOG_REGION_SIZE = 14;
+   static const UInt32 LOG_NUM_COUNTERS = 14;
+   static const UInt8 MAX_COUNTER = 7;
+
+   // Signature History Counter Table
+   vector<UInt8> _counters;
+   // Signature of each line, and whether it was hit since its insertion
+   vector<UInt16> _line_signatures;
+   vector<bool> _line_reused;
+   UInt32 _log_lines_per_region;
+
+   UInt32 getSignature(IntPtr tag) const;
+};
@@ -0,0 +1,72 @@
+#include "stream_prefetcher.h"
+
+StreamPrefetcher::StreamPrefetcher(UInt32 cache_line_size, UInt32 prefetch_degree)
+   : Prefetcher(cache_line_size, prefetch_degree)
+   , _num_accesses(0)
+{}
+
+StreamPrefetcher::~StreamPrefetcher()
+{}
+
+StreamPrefetcher::Stream*
+StreamPrefetcher::findStream(SInt64 line_num)
+{
+   for (UInt32 i = 0; i < NUM_STREAMS; i++)
+   {
+      Stream& stream = _streams[i];
+      if (!stream._valid)
+         continue;
+
+      SInt64 distance = line_num - stream._last_line_num;
+      if (stream._direction == 0)
+      {
+         // Untrained, accept either direction
+         if ((distance != 0) && (distance >= -TRAINING_WINDOW) && (distance <= TRAINING_WINDOW))
+            return &stream;
+      }
+      else
+      {
+         distance *= stream._direction;
+         if ((distance > 0) && (distance <= TRAINING_WINDOW))
+            return &stream;
+      }
+   }
+   return (Stream*) NULL;
+}
+
+void
+StreamPrefetcher::getPrefetchAddresses(IntPtr address, vector<IntPtr>& prefetch_addresses)
+{
+   SInt64 line_num = getLineNum(address);
+   _num_accesses ++;
+
+   Stream* stream = findStream(line_num);
+   if (stream == NULL)
+   {
+      // Allocate the least recently used stream
+      stream = &_streams[0];
+      for (UInt32 i = 1; (i < NUM_STREAMS) && stream->_valid; i++)
+      {
+         if (!_streams[i]._valid || (_streams[i]._last_use < stream->_last_use))
+            stream = &_streams[i];
+      }
+      stream->_valid = true;
+      stream->_last_line_num = line_num;
+      stream->_direction = 0;
+      stream->_last_use = _num_accesses;
+      return;
+   }
+
+   if (stream->_direction == 0)
+      stream->_direction = (line_num > stream->_last_line_num) ? 1 : -1;
+   stream->_last_line_num = line_num;
+   stream->_last_use = _num_accesses;
+
+   for (UInt32 i = 1; i <= _prefetch_degree; i++)
+   {
+      IntPtr prefetch_address;
+      if (!getLineInPage(address, line_num + ((SInt64) i) * stream->_direction, prefetch_address))
+         break;
+      prefetch_addresses.push_back(prefetch_address);
+   }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "prefetcher.h"
+
+// Stream prefetcher, in the style of stream buffers but filling the
+// cache itself. A stream is allocated on a miss that no stream covers,
+// and gets a direction on the next miss within TRAINING_WINDOW lines of
+// it. From then on, each access within the window ahead of the stream
+// fetches the next 'prefetch_degree' lines and advances it. Streams are
+// replaced in LRU order.
+
+class StreamPrefetcher : public Prefetcher
+{
+public:
+   StreamPrefetcher(UInt32 cache_line_size, UInt32 prefetch_degree);
+   ~StreamPrefetcher();
+
+   void getPrefetchAddresses(IntPtr address, vector<IntPtr>& prefetch_addresses);
+
+private:
+   static const UInt32 NUM_STREAMS = 8;
+   static const SInt64 TRAINING_WINDOW = 16;
+
+   class Stream
+   {
+   public:
+      Stream() : _valid(false), _last_line_num(0), _direction(0), _last_use(0) {}
+
+      bool _valid;
+      SInt64 _last_line_num;
+      // 0 until the stream is trained, then +1 or -1
+      SInt32 _direction;
+      UInt64 _last_use;
+   };
+
+   Stream _streams[NUM_STREAMS];
+   UInt64 _num_accesses;
+
+   Stream* findStream(SInt64 line_num);
+};
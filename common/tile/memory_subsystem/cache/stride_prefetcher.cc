@@ -0,0 +1,56 @@
+#include "stride_prefetcher.h"
+
+StridePrefetcher::StridePrefetcher(UInt32 cache_line_size, UInt32 prefetch_degree)
+   : Prefetcher(cache_line_size, prefetch_degree)
+{}
+
+StridePrefetcher::~StridePrefetcher()
+{}
+
+void
+StridePrefetcher::getPrefetchAddresses(IntPtr address, vector<IntPtr>& prefetch_addresses)
+{
+   IntPtr page = address >> LOG_PAGE_SIZE;
+   SInt64 line_num = getLineNum(address);
+   Entry& entry = _entries[page % NUM_ENTRIES];
+
+   if (entry._page != page)
+   {
+      // Start following a new page
+      entry._page = page;
+      entry._last_line_num = line_num;
+      entry._stride = 0;
+      entry._confidence = 0;
+      return;
+   }
+
+   SInt64 stride = line_num - entry._last_line_num;
+   if (stride == 0)
+      return;
+   entry._last_line_num = line_num;
+
+   if (stride == entry._stride)
+   {
+      if (entry._confidence < MAX_CONFIDENCE)
+         entry._confidence ++;
+   }
+   else
+   {
+      if (entry._confidence > 0)
+         entry._confidence --;
+      if (entry._confidence == 0)
+         entry._stride = stride;
+      return;
+   }
+
+   if (entry._confidence < PREFETCH_CONFIDENCE)
+      return;
+
+   for (UInt32 i = 1; i <= _prefetch_degree; i++)
+   {
+      IntPtr prefetch_address;
+      if (!getLineInPage(address, line_num + i * stride, prefetch_address))
+         break;
+      prefetch_addresses.push_back(prefetch_address);
+   }
+}
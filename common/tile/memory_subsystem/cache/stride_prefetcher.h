@@ -0,0 +1,36 @@
+#pragma once
+
+#include "prefetcher.h"
+
+// Stride prefetcher. The controllers do not see the PC of an access, so
+// the reference prediction table is indexed by page instead: each entry
+// follows the last line accessed in a page and the stride between the
+// accesses. Once the same stride is seen twice in a row, the next
+// 'prefetch_degree' lines along it are fetched.
+
+class StridePrefetcher : public Prefetcher
+{
+public:
+   StridePrefetcher(UInt32 cache_line_size, UInt32 prefetch_degree);
+   ~StridePrefetcher();
+
+   void getPrefetchAddresses(IntPtr address, vector<IntPtr>& prefetch_addresses);
+
+private:
+   static const UInt32 NUM_ENTRIES = 64;
+   static const UInt32 MAX_CONFIDENCE = 3;
+   static const UInt32 PREFETCH_CONFIDENCE = 1;
+
+   class Entry
+   {
+   public:
+      Entry() : _page(INVALID_ADDRESS), _last_line_num(0), _stride(0), _confidence(0) {}
+
+      IntPtr _page;
+      SInt64 _last_line_num;
+      SInt64 _stride;
+      UInt32 _confidence;
+   };
+
+   Entry _entries[NUM_ENTRIES];
+};
@@ -0,0 +1,62 @@
+#include "tree_plru_replacement_policy.h"
+#include "cache_line_info.h"
+#include "utils.h"
+#include "log.h"
+
+TreePLRUReplacementPolicy::TreePLRUReplacementPolicy(UInt32 cache_size, UInt32 associativity, UInt32 cache_line_size)
+   : CacheReplacementPolicy(cache_size, associativity, cache_line_size)
+{
+   LOG_ASSERT_ERROR(isPower2(_associativity) && (_associativity <= 64),
+                    "Tree PLRU needs a power of 2 associativity <= 64, got %u", _associativity);
+   _num_levels = floorLog2(_associativity);
+   _tree_bits_vec.resize(_num_sets, 0);
+}
+
+TreePLRUReplacementPolicy::~TreePLRUReplacementPolicy()
+{}
+
+UInt32
+TreePLRUReplacementPolicy::getReplacementWay(CacheLineInfo** cache_line_info_array, UInt32 set_num)
+{
+   // Fill invalid ways first, they are not visible in the tree bits
+   for (UInt32 i = 0; i < _associativity; i++)
+   {
+      if (!cache_line_info_array[i]->isValid())
+         return i;
+   }
+
+   UInt64 tree_bits = _tree_bits_vec[set_num];
+   UInt32 node = 1;
+   for (UInt32 level = 0; level < _num_levels; level++)
+      node = 2 * node + ((tree_bits >> node) & 1);
+   return node - _associativity;
+}
+
+void
+TreePLRUReplacementPolicy::update(CacheLineInfo** cache_line_info_array, UInt32 set_num, UInt32 accessed_way)
+{
+   // Make every node on the path point away from the accessed way
+   UInt64& tree_bits = _tree_bits_vec[set_num];
+   UInt32 node = 1;
+   for (SInt32 level = _num_levels - 1; level >= 0; level--)
+   {
+      UInt32 direction = (accessed_way >> level) & 1;
+      if (direction)
+         tree_bits &= ~(1ULL << node);
+      else
+         tree_bits |= (1ULL << node);
+      node = 2 * node + direction;
+   }
+}
+
+void
+TreePLRUReplacementPolicy::saveState(CheckpointWriter& writer)
+{
+   writer.putVector(_tree_bits_vec);
+}
+
+void
+TreePLRUReplacementPolicy::restoreState(CheckpointReader& reader)
+{
+   reader.getVector(_tree_bits_vec);
+}
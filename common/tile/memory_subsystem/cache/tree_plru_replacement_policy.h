@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+using std::vector;
+
+#include "cache_replacement_policy.h"
+
+// Tree pseudo-LRU. Each set keeps (associativity - 1) bits, one per node
+// of a binary tree over the ways, packed in a word. A node points to the
+// half of its subtree to be replaced next. Accesses and victim selection
+// walk one root-to-leaf path, i.e., log2(associativity) steps.
+
+class TreePLRUReplacementPolicy : public CacheReplacementPolicy
+{
+public:
+   TreePLRUReplacementPolicy(UInt32 cache_size, UInt32 associativity, UInt32 cache_line_size);
+   ~TreePLRUReplacementPolicy();
+
+   UInt32 getReplacementWay(CacheLineInfo** cache_line_info_array, UInt32 set_num);
+   void update(CacheLineInfo** cache_line_info_array, UInt32 set_num, UInt32 accessed_way);
+   void saveState(CheckpointWriter& writer);
+   void restoreState(CheckpointReader& reader);
+
+private:
+   // Bit (i) is tree node (i), the root is node 1, the children of
+   // node (i) are nodes (2i) and (2i+1)
+   vector<UInt64> _tree_bits_vec;
+   UInt32 _num_levels;
+};
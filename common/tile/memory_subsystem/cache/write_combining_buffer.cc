@@ -0,0 +1,113 @@
+#include <cstring>
+#include <algorithm>
+
+#include "write_combining_buffer.h"
+#include "log.h"
+
+using std::endl;
+
+WriteCombiningBuffer::WriteCombiningBuffer(UInt32 num_entries, UInt32 cache_line_size, UInt32 drain_latency)
+   : _num_entries(num_entries)
+   , _cache_line_size(cache_line_size)
+   , _drain_latency(drain_latency)
+   , _drain_completion_time(0)
+   , _total_stores(0)
+   , _total_merged_stores(0)
+   , _total_lines_drained(0)
+   , _total_l2_writes(0)
+   , _total_stalls(0)
+   , _total_stall_cycles(0)
+{
+   LOG_ASSERT_ERROR(_num_entries > 0, "Number of write-combining buffer entries must be > 0");
+}
+
+WriteCombiningBuffer::~WriteCombiningBuffer()
+{}
+
+bool
+WriteCombiningBuffer::write(IntPtr address, UInt32 offset, const Byte* data_buf, UInt32 data_length, bool modeled)
+{
+   LOG_ASSERT_ERROR(offset + data_length <= _cache_line_size,
+                    "Store of %u bytes at offset %u crosses the line", data_length, offset);
+
+   list<Entry>::iterator it = _entries.begin();
+   while ((it != _entries.end()) && (it->address != address))
+      it ++;
+
+   if (it == _entries.end())
+   {
+      if (_entries.size() == _num_entries)
+         return false;
+
+      it = _entries.insert(_entries.end(), Entry());
+      it->address = address;
+      it->data.resize(_cache_line_size);
+      it->written.resize(_cache_line_size, false);
+   }
+   else if (modeled)
+   {
+      _total_merged_stores ++;
+   }
+
+   memcpy(&it->data[offset], data_buf, data_length);
+   std::fill(it->written.begin() + offset, it->written.begin() + offset + data_length, true);
+   if (modeled)
+      _total_stores ++;
+   return true;
+}
+
+bool
+WriteCombiningBuffer::remove(IntPtr address, Byte* data_buf, vector<bool>& written)
+{
+   for (list<Entry>::iterator it = _entries.begin(); it != _entries.end(); it++)
+   {
+      if (it->address == address)
+      {
+         memcpy(data_buf, &it->data[0], _cache_line_size);
+         written.swap(it->written);
+         _entries.erase(it);
+         return true;
+      }
+   }
+   return false;
+}
+
+UInt64
+WriteCombiningBuffer::drain(UInt64 time, bool modeled)
+{
+   UInt64 start_time = std::max(time, _drain_completion_time);
+   _drain_completion_time = start_time + _drain_latency;
+   if (modeled)
+      _total_lines_drained ++;
+   return start_time;
+}
+
+void
+WriteCombiningBuffer::countL2Writes(UInt32 num_writes, bool modeled)
+{
+   if (modeled)
+      _total_l2_writes += num_writes;
+}
+
+void
+WriteCombiningBuffer::countStall(UInt64 stall_cycles, bool modeled)
+{
+   if (modeled && (stall_cycles > 0))
+   {
+      _total_stalls ++;
+      _total_stall_cycles += stall_cycles;
+   }
+}
+
+void
+WriteCombiningBuffer::outputSummary(std::ostream& out)
+{
+   out << "  Write-Combining Buffer L1-D:\n";
+   out << "    Num Entries: " << _num_entries << endl;
+   out << "    Stores: " << _total_stores << endl;
+   out << "    Merged Stores: " << _total_merged_stores << endl;
+   out << "    Lines Drained: " << _total_lines_drained << endl;
+   out << "    L2 Cache Writes: " << _total_l2_writes << endl;
+   out << "    Stalls: " << _total_stalls << endl;
+   out << "    Stall Cycles: " << _total_stall_cycles << endl;
+}
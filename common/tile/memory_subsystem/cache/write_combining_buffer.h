@@ -0,0 +1,72 @@
+#pragma once
+
+#include <list>
+#include <vector>
+#include <ostream>
+using std::list;
+using std::vector;
+
+#include "fixed_types.h"
+
+// Write-combining buffer between a write-through L1-D cache and the L2
+// cache. The stores that hit in the L1-D cache are merged into the entry of
+// their line instead of being written to the L2 cache one by one. A line
+// leaves the buffer (oldest first when all entries are taken) as one write
+// of the bytes it got to the L2 cache.
+//   Timing: the lines drain to the L2 cache one after the other,
+// 'drain_latency' cycles each. A store that needs an entry while all are
+// taken waits until the oldest line starts draining, an atomic waits until
+// the buffer is empty.
+
+class WriteCombiningBuffer
+{
+public:
+   WriteCombiningBuffer(UInt32 num_entries, UInt32 cache_line_size, UInt32 drain_latency);
+   ~WriteCombiningBuffer();
+
+   // Merge the store into the entry of its line ('address' is cache line
+   // aligned). False if the line has no entry and all the entries are taken
+   bool write(IntPtr address, UInt32 offset, const Byte* data_buf, UInt32 data_length, bool modeled);
+
+   bool isEmpty() const { return _entries.empty(); }
+   IntPtr getOldestAddress() const { return _entries.front().address; }
+
+   // Take the entry of 'address' out of the buffer: the line and the bytes
+   // that were written. False if the line has no entry
+   bool remove(IntPtr address, Byte* data_buf, vector<bool>& written);
+
+   // A line taken out at 'time' drains after the ones before it, returns
+   // the time it starts draining
+   UInt64 drain(UInt64 time, bool modeled);
+   // Time at which the last line drained is in the L2 cache
+   UInt64 getDrainCompletionTime() const { return _drain_completion_time; }
+
+   // The L2 cache writes a drained line took (one per run of written bytes)
+   void countL2Writes(UInt32 num_writes, bool modeled);
+   void countStall(UInt64 stall_cycles, bool modeled);
+
+   UInt32 getNumEntries() const { return _num_entries; }
+   void outputSummary(std::ostream& out);
+
+private:
+   struct Entry
+   {
+      IntPtr address;
+      vector<Byte> data;
+      vector<bool> written;
+   };
+
+   UInt32 _num_entries;
+   UInt32 _cache_line_size;
+   UInt32 _drain_latency;
+   // Oldest first
+   list<Entry> _entries;
+   UInt64 _drain_completion_time;
+
+   UInt64 _total_stores;
+   UInt64 _total_merged_stores;
+   UInt64 _total_lines_drained;
+   UInt64 _total_l2_writes;
+   UInt64 _total_stalls;
+   UInt64 _total_stall_cycles;
+};
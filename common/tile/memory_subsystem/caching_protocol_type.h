@@ -5,5 +5,6 @@ enum CachingProtocolType
    PR_L1_PR_L2_DRAM_DIRECTORY_MSI = 0,
    PR_L1_PR_L2_DRAM_DIRECTORY_MOSI,
    PR_L1_SH_L2_MSI,
+   PR_L1_PR_L2_DRAM_DIRECTORY_MESI,
    NUM_CACHING_PROTOCOL_TYPES
 };
@@ -0,0 +1,319 @@
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+#include "data_profiler.h"
+#include "simulator.h"
+#include "config.h"
+#include "log.h"
+
+using namespace std;
+
+const UInt32 DataProfiler::MAX_CACHES;
+const UInt32 DataProfiler::NUM_MISS_TYPES;
+
+DataProfiler::Site::Site(IntPtr pc_)
+   : pc(pc_)
+   , num_allocations(0)
+   , bytes_allocated(0)
+   , dram_reads(0)
+   , dram_writes(0)
+{
+   for (UInt32 i = 0; i < MAX_CACHES; i++)
+   {
+      misses[i] = 0;
+      invalidations[i] = 0;
+      for (UInt32 j = 0; j < NUM_MISS_TYPES; j++)
+         typed_misses[i][j] = 0;
+   }
+}
+
+DataProfiler::DataProfiler()
+   : m_num_top_sites(0)
+   , m_unknown_site(new Site(0))
+   , m_generation(0)
+   , m_pending_calls(Config::getSingleton()->getTotalTiles())
+   , m_num_allocation_calls(0)
+   , m_num_lookups(0)
+{
+   try
+   {
+      m_num_top_sites = Sim()->getCfg()->getInt("data_profiler/num_top_sites", 20);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read data_profiler/num_top_sites from the cfg file");
+   }
+}
+
+DataProfiler::~DataProfiler()
+{
+   for (map<IntPtr, Site*>::iterator it = m_sites.begin(); it != m_sites.end(); it++)
+      delete it->second;
+   delete m_unknown_site;
+}
+
+bool
+DataProfiler::isEnabled()
+{
+   try
+   {
+      return Sim()->getCfg()->getBool("data_profiler/enabled", false);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read data_profiler/enabled from the cfg file");
+      return false;
+   }
+}
+
+void
+DataProfiler::beginAllocation(tile_id_t tile_id, AllocationType type, IntPtr arg0, IntPtr arg1, IntPtr site)
+{
+   PendingCall& call = m_pending_calls[tile_id];
+
+   // free and munmap have nothing to wait for
+   if ((type == FREE) || (type == MUNMAP))
+   {
+      if ((call.depth == 0) && (arg0 != 0))
+      {
+         ScopedLock sl(m_lock);
+         removeAllocation(arg0);
+      }
+      return;
+   }
+
+   if (call.depth++ > 0)
+      return;
+   call.type = type;
+   call.arg0 = arg0;
+   call.arg1 = arg1;
+   call.site = site;
+}
+
+void
+DataProfiler::endAllocation(tile_id_t tile_id, IntPtr ret)
+{
+   PendingCall& call = m_pending_calls[tile_id];
+   if ((call.depth == 0) || (--call.depth > 0))
+      return;
+
+   ScopedLock sl(m_lock);
+   m_num_allocation_calls ++;
+   switch (call.type)
+   {
+   case MALLOC:
+      if (ret != 0)
+         addAllocation(ret, call.arg0, call.site);
+      break;
+
+   case CALLOC:
+      if (ret != 0)
+         addAllocation(ret, call.arg0 * call.arg1, call.site);
+      break;
+
+   case REALLOC:
+      // realloc(ptr, 0) frees ptr, a failed realloc leaves it allocated
+      if ((ret != 0) || (call.arg1 == 0))
+      {
+         if (call.arg0 != 0)
+            removeAllocation(call.arg0);
+         if (ret != 0)
+            addAllocation(ret, call.arg1, call.site);
+      }
+      break;
+
+   case MMAP:
+      if (ret != (IntPtr) -1)
+         addAllocation(ret, call.arg1, call.site);
+      break;
+
+   default:
+      LOG_PRINT_ERROR("Unexpected allocation call(%u)", call.type);
+      break;
+   }
+}
+
+void
+DataProfiler::addAllocation(IntPtr start, UInt64 size, IntPtr pc)
+{
+   map<IntPtr, Site*>::iterator it = m_sites.find(pc);
+   if (it == m_sites.end())
+      it = m_sites.insert(make_pair(pc, new Site(pc))).first;
+   Site* site = it->second;
+   site->num_allocations ++;
+   site->bytes_allocated += size;
+
+   // A zero-sized allocation still owns its address
+   Allocation allocation;
+   allocation.end = start + max(size, (UInt64) 1);
+   allocation.site = site;
+   m_allocations[start] = allocation;
+   m_generation ++;
+}
+
+void
+DataProfiler::removeAllocation(IntPtr start)
+{
+   if (m_allocations.erase(start) > 0)
+      m_generation ++;
+}
+
+DataProfiler::Site*
+DataProfiler::lookup(LookupCache& lookup_cache, IntPtr address)
+{
+   if ((lookup_cache.generation == m_generation) &&
+       (address >= lookup_cache.start) && (address < lookup_cache.end))
+   {
+      return lookup_cache.site;
+   }
+
+   ScopedLock sl(m_lock);
+   m_num_lookups ++;
+
+   // The allocation with the last start at or below the address, the gap
+   // around the address (of the unknown site) if it does not contain it
+   lookup_cache.generation = m_generation;
+   lookup_cache.start = 0;
+   lookup_cache.end = ~((IntPtr) 0);
+   lookup_cache.site = m_unknown_site;
+
+   map<IntPtr, Allocation>::iterator next = m_allocations.upper_bound(address);
+   if (next != m_allocations.end())
+      lookup_cache.end = next->first;
+   if (next != m_allocations.begin())
+   {
+      map<IntPtr, Allocation>::iterator prev = next;
+      prev --;
+      if (address < prev->second.end)
+      {
+         lookup_cache.start = prev->first;
+         lookup_cache.end = prev->second.end;
+         lookup_cache.site = prev->second.site;
+      }
+      else
+      {
+         lookup_cache.start = prev->second.end;
+      }
+   }
+   return lookup_cache.site;
+}
+
+UInt32
+DataProfiler::registerCache(const string& name)
+{
+   ScopedLock sl(m_lock);
+   for (UInt32 i = 0; i < m_cache_names.size(); i++)
+   {
+      if (m_cache_names[i] == name)
+         return i;
+   }
+   LOG_ASSERT_ERROR(m_cache_names.size() < MAX_CACHES, "Data profiler: more than %u caches", MAX_CACHES);
+   m_cache_names.push_back(name);
+   return m_cache_names.size() - 1;
+}
+
+void
+DataProfiler::recordCacheMiss(LookupCache& lookup_cache, UInt32 cache_index, IntPtr address, UInt32 miss_type)
+{
+   Site* site = lookup(lookup_cache, address);
+   __sync_fetch_and_add(&site->misses[cache_index], 1);
+   if (miss_type < NUM_MISS_TYPES)
+      __sync_fetch_and_add(&site->typed_misses[cache_index][miss_type], 1);
+}
+
+void
+DataProfiler::recordInvalidation(LookupCache& lookup_cache, UInt32 cache_index, IntPtr address)
+{
+   Site* site = lookup(lookup_cache, address);
+   __sync_fetch_and_add(&site->invalidations[cache_index], 1);
+}
+
+void
+DataProfiler::recordDramAccess(LookupCache& lookup_cache, IntPtr address, bool write)
+{
+   Site* site = lookup(lookup_cache, address);
+   if (write)
+      __sync_fetch_and_add(&site->dram_writes, 1);
+   else
+      __sync_fetch_and_add(&site->dram_reads, 1);
+}
+
+UInt64
+DataProfiler::getTotalMisses(const Site* site) const
+{
+   UInt64 total = site->dram_reads + site->dram_writes;
+   for (UInt32 i = 0; i < m_cache_names.size(); i++)
+      total += site->misses[i] + site->invalidations[i];
+   return total;
+}
+
+bool
+DataProfiler::compareMisses(const TopSite& a, const TopSite& b)
+{
+   return a.first > b.first;
+}
+
+void
+DataProfiler::outputSite(ostream& os, const Site* site) const
+{
+   static const char* miss_type_names[NUM_MISS_TYPES] = { "Cold", "Capacity", "Sharing" };
+
+   if (site->pc == 0)
+   {
+      os << "Site unknown:" << endl;
+   }
+   else
+   {
+      os << "Site 0x" << hex << site->pc << dec << ":" << endl;
+      os << "    Allocations: " << site->num_allocations << endl;
+      os << "    Bytes Allocated: " << site->bytes_allocated << endl;
+   }
+   for (UInt32 i = 0; i < m_cache_names.size(); i++)
+   {
+      if ((site->misses[i] == 0) && (site->invalidations[i] == 0))
+         continue;
+      os << "    " << m_cache_names[i] << " Misses: " << site->misses[i];
+      for (UInt32 j = 0; j < NUM_MISS_TYPES; j++)
+      {
+         if (site->typed_misses[i][j] > 0)
+            os << ", " << miss_type_names[j] << ": " << site->typed_misses[i][j];
+      }
+      os << endl;
+      os << "    " << m_cache_names[i] << " Invalidations: " << site->invalidations[i] << endl;
+   }
+   os << "    DRAM Reads: " << site->dram_reads << endl;
+   os << "    DRAM Writes: " << site->dram_writes << endl;
+}
+
+void
+DataProfiler::output()
+{
+   ScopedLock sl(m_lock);
+
+   vector<TopSite> sites;
+   sites.push_back(make_pair(getTotalMisses(m_unknown_site), m_unknown_site));
+   for (map<IntPtr, Site*>::iterator it = m_sites.begin(); it != m_sites.end(); it++)
+      sites.push_back(make_pair(getTotalMisses(it->second), it->second));
+   sort(sites.begin(), sites.end(), compareMisses);
+
+   ostringstream filename;
+   filename << "data_profile." << Config::getSingleton()->getCurrentProcessNum() << ".out";
+   ofstream os(Config::getSingleton()->formatOutputFileName(filename.str()).c_str());
+
+   os << "Data Profile Summary:" << endl;
+   os << "    Allocation Sites: " << m_sites.size() << endl;
+   os << "    Allocation Calls: " << m_num_allocation_calls << endl;
+   os << "    Live Allocations: " << m_allocations.size() << endl;
+   os << "    Allocation Lookups: " << m_num_lookups << endl;
+   os << endl;
+
+   for (UInt32 i = 0; (i < sites.size()) && (i < m_num_top_sites); i++)
+   {
+      if (sites[i].first == 0)
+         break;
+      outputSite(os, sites[i].second);
+   }
+   os.close();
+}
@@ -0,0 +1,141 @@
+#ifndef DATA_PROFILER_H
+#define DATA_PROFILER_H
+
+#include <map>
+#include <vector>
+#include <string>
+#include <ostream>
+
+#include "fixed_types.h"
+#include "lock.h"
+
+/*
+  Misses and coherence traffic by allocation site ([data_profiler]). The
+  front-end reports the calls to malloc, calloc, realloc, free, mmap and
+  munmap of the application, with the address of the call (the allocation
+  site), and the profiler keeps the live allocations in an interval map.
+  The caches attribute their misses (by miss type, with track_miss_types)
+  and the lines they invalidate (by coherence or inclusion), the memory
+  controllers their DRAM reads and writes, to the site of the allocation
+  holding the address. The other addresses (globals, stacks, allocations of
+  other processes) go to the unknown site 0.
+
+  Each component keeps the allocation it last found in a LookupCache, so
+  the accesses to one data structure rarely look up the map. The cached
+  allocation is valid while the map does not change.
+
+  Each process writes the sites with the most misses as
+  data_profile.<process>.out. The calls inside an allocation call (e.g.
+  the mmap of a large malloc) are not recorded on their own.
+ */
+class DataProfiler
+{
+public:
+   enum AllocationType
+   {
+      MALLOC = 0,
+      CALLOC,
+      REALLOC,
+      FREE,
+      MMAP,
+      MUNMAP,
+      NUM_ALLOCATION_TYPES
+   };
+
+   struct Site;
+
+   // Last allocation found by a component, only used under the lock of
+   // the component
+   struct LookupCache
+   {
+      LookupCache() : start(0), end(0), site(NULL), generation(~((UInt64) 0)) {}
+      IntPtr start;
+      IntPtr end;
+      Site* site;
+      UInt64 generation;
+   };
+
+   DataProfiler();
+   ~DataProfiler();
+
+   static bool isEnabled();
+
+   // Called by the front-end, before and after an allocation call of the
+   // application thread of a tile (arg0 and arg1 are its first arguments,
+   // 'site' the address it returns to)
+   void beginAllocation(tile_id_t tile_id, AllocationType type, IntPtr arg0, IntPtr arg1, IntPtr site);
+   void endAllocation(tile_id_t tile_id, IntPtr ret);
+
+   // Caches, by name (e.g. "L1-D", "L2"), index of their counters
+   UInt32 registerCache(const std::string& name);
+
+   // 'miss_type' is a Cache::MissType
+   void recordCacheMiss(LookupCache& lookup_cache, UInt32 cache_index, IntPtr address, UInt32 miss_type);
+   void recordInvalidation(LookupCache& lookup_cache, UInt32 cache_index, IntPtr address);
+   void recordDramAccess(LookupCache& lookup_cache, IntPtr address, bool write);
+
+   void output();
+
+   static const UInt32 MAX_CACHES = 8;
+   // Cache::NUM_MISS_TYPES
+   static const UInt32 NUM_MISS_TYPES = 3;
+
+   struct Site
+   {
+      Site(IntPtr pc_);
+      IntPtr pc;
+      UInt64 num_allocations;
+      UInt64 bytes_allocated;
+      // Updated by the components without the lock of the profiler
+      volatile UInt64 misses[MAX_CACHES];
+      volatile UInt64 typed_misses[MAX_CACHES][NUM_MISS_TYPES];
+      volatile UInt64 invalidations[MAX_CACHES];
+      volatile UInt64 dram_reads;
+      volatile UInt64 dram_writes;
+   };
+
+private:
+   struct Allocation
+   {
+      IntPtr end;
+      Site* site;
+   };
+
+   // Allocation call in progress on a tile (only touched by its thread)
+   struct PendingCall
+   {
+      PendingCall() : depth(0), type(NUM_ALLOCATION_TYPES), arg0(0), arg1(0), site(0) {}
+      UInt32 depth;
+      AllocationType type;
+      IntPtr arg0;
+      IntPtr arg1;
+      IntPtr site;
+   };
+
+   typedef std::pair<UInt64, Site*> TopSite;
+   static bool compareMisses(const TopSite& a, const TopSite& b);
+
+   Site* lookup(LookupCache& lookup_cache, IntPtr address);
+   void addAllocation(IntPtr start, UInt64 size, IntPtr pc);
+   void removeAllocation(IntPtr start);
+   UInt64 getTotalMisses(const Site* site) const;
+   void outputSite(std::ostream& os, const Site* site) const;
+
+   UInt32 m_num_top_sites;
+
+   // Live allocations by start address, and the sites by call address
+   std::map<IntPtr, Allocation> m_allocations;
+   std::map<IntPtr, Site*> m_sites;
+   Site* m_unknown_site;
+   Lock m_lock;
+   // Incremented by every change of the allocations
+   volatile UInt64 m_generation;
+
+   std::vector<std::string> m_cache_names;
+   std::vector<PendingCall> m_pending_calls;
+
+   UInt64 m_num_allocation_calls;
+   UInt64 m_num_lookups;
+};
+
+#endif // DATA_PROFILER_H
@@ -3,6 +3,8 @@
 #include "directory_entry.h"
 #include "log.h"
 
+vector<UInt64> Directory::_sharer_count_vec;
+
 Directory::Directory(CachingProtocolType caching_protocol_type, DirectoryType directory_type,
                      SInt32 total_entries, SInt32 max_hw_sharers, SInt32 max_num_sharers)
    : _total_entries(total_entries)
@@ -43,27 +45,63 @@ Directory::setDirectoryEntry(SInt32 entry_num, DirectoryEntry* directory_entry)
 void
 Directory::initializeSharerStats()
 {
-   _sharer_count_vec.resize(Config::getSingleton()->getTotalTiles()+1, 0);
+   // The directories are created with the tiles, one after the other
+   if (_sharer_count_vec.empty())
+      _sharer_count_vec.resize(Config::getSingleton()->getTotalTiles()+1, 0);
 }
 
 void
 Directory::updateSharerStats(SInt32 old_sharer_count, SInt32 new_sharer_count)
 {
-   assert(old_sharer_count >= 0 && old_sharer_count < (SInt32) Config::getSingleton()->getTotalTiles());
-   assert(new_sharer_count >= 0 && old_sharer_count < (SInt32) Config::getSingleton()->getTotalTiles());
+   assert(old_sharer_count >= 0 && old_sharer_count < (SInt32) _sharer_count_vec.size());
+   assert(new_sharer_count >= 0 && new_sharer_count < (SInt32) _sharer_count_vec.size());
+   if (old_sharer_count == new_sharer_count)
+      return;
    if (old_sharer_count > 0)
    {
-      assert(_sharer_count_vec[old_sharer_count] > 0);
-      _sharer_count_vec[old_sharer_count] --;
+      __attribute(__unused__) UInt64 old_count = __sync_fetch_and_sub(&_sharer_count_vec[old_sharer_count], 1);
+      assert(old_count > 0);
    }
    if (new_sharer_count > 0)
    {
-      _sharer_count_vec[new_sharer_count] ++;
+      __sync_fetch_and_add(&_sharer_count_vec[new_sharer_count], 1);
    }
 }
 
 void
 Directory::getSharerStats(vector<UInt64>& sharer_count_vec)
 {
-   sharer_count_vec = _sharer_count_vec;
+   // Each counter is read on its own, so a sample taken while the lines
+   // are being shared is only consistent counter by counter
+   sharer_count_vec.resize(_sharer_count_vec.size());
+   for (UInt32 i = 0; i < _sharer_count_vec.size(); i++)
+      sharer_count_vec[i] = *((volatile UInt64*) &_sharer_count_vec[i]);
+}
+
+void
+Directory::saveState(CheckpointWriter& writer)
+{
+   writer << _total_entries;
+   for (SInt32 i = 0; i < _total_entries; i++)
+      _directory_entry_list[i]->saveState(writer);
+}
+
+void
+Directory::restoreState(CheckpointReader& reader)
+{
+   SInt32 total_entries;
+   reader >> total_entries;
+   LOG_ASSERT_ERROR(total_entries == _total_entries, "Checkpoint directory entries(%i), expected(%i)",
+                    total_entries, _total_entries);
+
+   for (SInt32 i = 0; i < _total_entries; i++)
+   {
+      // The stats are shared with the other directories, only replace the
+      // lines of this one
+      if (_directory_entry_list[i]->getAddress() != INVALID_ADDRESS)
+         updateSharerStats(_directory_entry_list[i]->getNumSharers(), 0);
+      _directory_entry_list[i]->restoreState(reader);
+      if (_directory_entry_list[i]->getAddress() != INVALID_ADDRESS)
+         updateSharerStats(0, _directory_entry_list[i]->getNumSharers());
+   }
 }
@@ -9,6 +9,7 @@ class DirectoryEntry;
 #include "fixed_types.h"
 #include "directory_type.h"
 #include "caching_protocol_type.h"
+#include "checkpoint.h"
 
 class Directory
 {
@@ -20,15 +21,23 @@ public:
    DirectoryEntry* getDirectoryEntry(SInt32 entry_num);
    void setDirectoryEntry(SInt32 entry_num, DirectoryEntry* directory_entry);
    
-   // Sharer Stats
-   void updateSharerStats(SInt32 old_sharer_count, SInt32 new_sharer_count);
-   void getSharerStats(vector<UInt64>& sharer_count_vec);
+   // Sharer Stats: number of cached lines with each sharer count, over
+   // the directories of all the tiles. Kept up to date as sharers are
+   // added and removed, so a sample of it does not walk the directories
+   static void updateSharerStats(SInt32 old_sharer_count, SInt32 new_sharer_count);
+   static void getSharerStats(vector<UInt64>& sharer_count_vec);
+
+   // Checkpointing
+   void saveState(CheckpointWriter& writer);
+   void restoreState(CheckpointReader& reader);
 
 private:
    SInt32 _total_entries;
 
    vector<DirectoryEntry*> _directory_entry_list;
-   vector<UInt64> _sharer_count_vec;
+
+   // Updated by the home tiles of the lines with atomic increments
+   static vector<UInt64> _sharer_count_vec;
    
-   void initializeSharerStats();
+   static void initializeSharerStats();
 };
@@ -5,9 +5,16 @@
 #include "directory_entry_limited_no_broadcast.h"
 #include "directory_entry_ackwise.h"
 #include "directory_entry_limitless.h"
+#include "directory_entry_coarse_vector.h"
+#include "directory_entry_hierarchical.h"
+#include "simulator.h"
+#include "config.h"
+#include "bit_vector.h"
 #include "utils.h"
 #include "log.h"
 
+UInt32 DirectoryEntry::_cluster_size = 0;
+
 DirectoryEntry::DirectoryEntry(SInt32 max_hw_sharers)
    : _address(INVALID_ADDRESS)
    , _owner_id(INVALID_TILE_ID)
@@ -34,6 +41,10 @@ DirectoryEntry::parseDirectoryType(string directory_type)
       return ACKWISE;
    else if (directory_type == "limitless")
       return LIMITLESS;
+   else if (directory_type == "coarse_vector")
+      return COARSE_VECTOR;
+   else if (directory_type == "hierarchical")
+      return HIERARCHICAL;
    else
       LOG_PRINT_ERROR("Unsupported Directory Type: %s", directory_type.c_str());
    return (DirectoryType) -1;
@@ -65,6 +76,12 @@ DirectoryEntry::create(DirectoryType directory_type, SInt32 max_hw_sharers, SInt
    case LIMITLESS:
       return new DirectoryEntryLimitless(max_hw_sharers, max_num_sharers);
 
+   case COARSE_VECTOR:
+      return new DirectoryEntryCoarseVector(max_num_sharers);
+
+   case HIERARCHICAL:
+      return new DirectoryEntryHierarchical(max_num_sharers);
+
    default:
       LOG_PRINT_ERROR("Unrecognized Directory Type: %u", directory_type);
       return NULL;
@@ -84,12 +101,37 @@ DirectoryEntry::getSize(DirectoryType directory_type, SInt32 max_hw_sharers, SIn
    case ACKWISE:
    case LIMITLESS:
       return max_hw_sharers * ceilLog2(max_num_sharers);
+   case COARSE_VECTOR:
+      // Cluster bits + sharer count
+      return (max_num_sharers + getClusterSize() - 1) / getClusterSize() + ceilLog2(max_num_sharers + 1);
+   case HIERARCHICAL:
+      // Root + one leaf
+      return (max_num_sharers + getClusterSize() - 1) / getClusterSize() + getClusterSize();
    default:
       LOG_PRINT_ERROR("Unrecognized directory type(%u)", directory_type);
       return 0;
    }
 }
 
+UInt32
+DirectoryEntry::getClusterSize()
+{
+   // The entries are created with the tiles, one after the other
+   if (_cluster_size == 0)
+   {
+      try
+      {
+         _cluster_size = Sim()->getCfg()->getInt("dram_directory/cluster_size", 4);
+      }
+      catch (...)
+      {
+         LOG_PRINT_ERROR("Could not read dram_directory/cluster_size from the cfg file");
+      }
+      LOG_ASSERT_ERROR(_cluster_size > 0, "dram_directory/cluster_size(%u) must be > 0", _cluster_size);
+   }
+   return _cluster_size;
+}
+
 DirectoryBlockInfo*
 DirectoryEntry::getDirectoryBlockInfo()
 {
@@ -128,3 +170,57 @@ DirectoryEntry::resetUtilizationVec()
 {
    _utilization_vec.clear();
 }
+
+void
+DirectoryEntry::reset()
+{
+   LOG_ASSERT_ERROR(getNumSharers() == 0, "Address(%#lx): reset with %i sharers", _address, getNumSharers());
+   _address = INVALID_ADDRESS;
+   _owner_id = INVALID_TILE_ID;
+   _directory_block_info->setDState(DirectoryState::UNCACHED);
+   _utilization_vec.clear();
+}
+
+void
+DirectoryEntry::saveState(CheckpointWriter& writer)
+{
+   writer << (UInt64) _address << (SInt32) _owner_id << (UInt32) _directory_block_info->getDState();
+}
+
+void
+DirectoryEntry::restoreState(CheckpointReader& reader)
+{
+   UInt64 address;
+   SInt32 owner_id;
+   UInt32 dstate;
+   reader >> address >> owner_id >> dstate;
+   _address = address;
+   _owner_id = owner_id;
+   _directory_block_info->setDState((DirectoryState::Type) dstate);
+}
+
+void
+DirectoryEntry::saveSharers(CheckpointWriter& writer, BitVector* sharers)
+{
+   writer << sharers->capacity() << sharers->size();
+   vector<SInt32> sharers_list;
+   sharers->getSetBits(sharers_list);
+   for (UInt32 i = 0; i < sharers_list.size(); i++)
+      writer << (UInt32) sharers_list[i];
+}
+
+void
+DirectoryEntry::restoreSharers(CheckpointReader& reader, BitVector* sharers)
+{
+   UInt32 capacity, num_sharers;
+   reader >> capacity >> num_sharers;
+   LOG_ASSERT_ERROR(capacity == sharers->capacity(), "Checkpoint sharers capacity(%u), expected(%u)",
+                    capacity, sharers->capacity());
+   sharers->reset();
+   for (UInt32 i = 0; i < num_sharers; i++)
+   {
+      UInt32 sharer_id;
+      reader >> sharer_id;
+      sharers->set(sharer_id);
+   }
+}
@@ -9,6 +9,9 @@ using std::string;
 #include "directory_block_info.h"
 #include "directory_type.h"
 #include "caching_protocol_type.h"
+#include "checkpoint.h"
+
+class BitVector;
 
 class DirectoryEntry
 {
@@ -20,6 +23,8 @@ public:
    static DirectoryEntry* create(CachingProtocolType caching_protocol_type, DirectoryType directory_type,
                                  SInt32 max_hw_sharers, SInt32 max_num_sharers);
    static UInt32 getSize(DirectoryType directory_type, SInt32 max_hw_sharers, SInt32 max_num_sharers);
+   // Tiles per cluster of the coarse_vector and hierarchical entries
+   static UInt32 getClusterSize();
 
    DirectoryBlockInfo* getDirectoryBlockInfo();
 
@@ -40,12 +45,25 @@ public:
 
    virtual UInt32 getLatency() = 0;
 
+   // Invalidations of the entry sent to tiles that were not sharers (coarse_vector)
+   virtual UInt64 getNumExtraInvalidations() { return 0; }
+
    // Utilization
    void setUtilization(UInt64 utilization);
    void getUtilizationVec(vector<UInt64>& utilization_vec);
    void resetUtilizationVec();
 
+   // Makes an entry without sharers as good as new, so that it can be reused
+   virtual void reset();
+
+   // Checkpointing
+   virtual void saveState(CheckpointWriter& writer);
+   virtual void restoreState(CheckpointReader& reader);
+
 protected:
+   static void saveSharers(CheckpointWriter& writer, BitVector* sharers);
+   static void restoreSharers(CheckpointReader& reader, BitVector* sharers);
+
    IntPtr _address;
    DirectoryBlockInfo* _directory_block_info;
    tile_id_t _owner_id;
@@ -53,5 +71,6 @@ protected:
 
 private:
    vector<UInt64> _utilization_vec;
+   static UInt32 _cluster_size;
    static DirectoryEntry* create(DirectoryType directory_type, SInt32 max_hw_sharers, SInt32 max_num_sharers);
 };
@@ -90,3 +90,19 @@ DirectoryEntryAckwise::getLatency()
 {
    return 0;
 }
+
+void
+DirectoryEntryAckwise::saveState(CheckpointWriter& writer)
+{
+   DirectoryEntryLimited::saveState(writer);
+   writer << (UInt8) _global_enabled << _num_untracked_sharers;
+}
+
+void
+DirectoryEntryAckwise::restoreState(CheckpointReader& reader)
+{
+   DirectoryEntryLimited::restoreState(reader);
+   UInt8 global_enabled;
+   reader >> global_enabled >> _num_untracked_sharers;
+   _global_enabled = global_enabled;
+}
@@ -17,6 +17,9 @@ public:
 
    UInt32 getLatency();
 
+   void saveState(CheckpointWriter& writer);
+   void restoreState(CheckpointReader& reader);
+
 private:
    bool _global_enabled;
    SInt32 _num_untracked_sharers;
@@ -0,0 +1,118 @@
+#include <algorithm>
+
+#include "directory_entry_coarse_vector.h"
+#include "log.h"
+
+DirectoryEntryCoarseVector::DirectoryEntryCoarseVector(SInt32 max_num_sharers)
+   : DirectoryEntry(max_num_sharers)
+   , _max_num_sharers(max_num_sharers)
+   , _cluster_size(getClusterSize())
+   , _num_extra_invalidations(0)
+{
+   _clusters = new BitVector((_max_num_sharers + _cluster_size - 1) / _cluster_size);
+}
+
+DirectoryEntryCoarseVector::~DirectoryEntryCoarseVector()
+{
+   delete _clusters;
+}
+
+bool
+DirectoryEntryCoarseVector::hasSharer(tile_id_t sharer_id)
+{
+   return (std::find(_sharers.begin(), _sharers.end(), sharer_id) != _sharers.end());
+}
+
+// Return value says whether the sharer was successfully added
+//              'True' if it was successfully added
+//              'False' if there will be an eviction before adding
+bool
+DirectoryEntryCoarseVector::addSharer(tile_id_t sharer_id)
+{
+   LOG_ASSERT_ERROR(!hasSharer(sharer_id), "Could not add sharer(%i)", sharer_id);
+   _sharers.push_back(sharer_id);
+   _clusters->set(sharer_id / _cluster_size);
+   return true;
+}
+
+void
+DirectoryEntryCoarseVector::removeSharer(tile_id_t sharer_id, bool reply_expected)
+{
+   assert(!reply_expected);
+
+   vector<tile_id_t>::iterator it = std::find(_sharers.begin(), _sharers.end(), sharer_id);
+   assert(it != _sharers.end());
+   _sharers.erase(it);
+
+   // The other tiles of the cluster may still be sharers, a cluster bit is
+   // only known to be stale when there are no sharers left
+   if (_sharers.empty())
+      _clusters->reset();
+}
+
+// Return a pair:
+// val.first :- 'True' if all tiles are sharers
+//              'False' if NOT all tiles are sharers
+// val.second :- The tiles of the marked clusters
+bool
+DirectoryEntryCoarseVector::getSharersList(vector<tile_id_t>& sharers_list)
+{
+   vector<SInt32> cluster_list;
+   _clusters->getSetBits(cluster_list);
+
+   sharers_list.clear();
+   for (UInt32 i = 0; i < cluster_list.size(); i++)
+   {
+      SInt32 first_tile = cluster_list[i] * _cluster_size;
+      SInt32 last_tile = std::min(first_tile + (SInt32) _cluster_size, _max_num_sharers);
+      for (SInt32 tile_id = first_tile; tile_id < last_tile; tile_id++)
+         sharers_list.push_back(tile_id);
+   }
+
+   _num_extra_invalidations += sharers_list.size() - _sharers.size();
+   return false;
+}
+
+tile_id_t
+DirectoryEntryCoarseVector::getOneSharer()
+{
+   return _sharers[_rand_num.next(_sharers.size())];
+}
+
+SInt32
+DirectoryEntryCoarseVector::getNumSharers()
+{
+   return _sharers.size();
+}
+
+UInt32
+DirectoryEntryCoarseVector::getLatency()
+{
+   return 0;
+}
+
+void
+DirectoryEntryCoarseVector::saveState(CheckpointWriter& writer)
+{
+   DirectoryEntry::saveState(writer);
+   saveSharers(writer, _clusters);
+   writer << (UInt32) _sharers.size();
+   for (UInt32 i = 0; i < _sharers.size(); i++)
+      writer << (UInt32) _sharers[i];
+}
+
+void
+DirectoryEntryCoarseVector::restoreState(CheckpointReader& reader)
+{
+   DirectoryEntry::restoreState(reader);
+   restoreSharers(reader, _clusters);
+   UInt32 num_sharers;
+   reader >> num_sharers;
+   _sharers.resize(num_sharers);
+   for (UInt32 i = 0; i < num_sharers; i++)
+   {
+      UInt32 sharer_id;
+      reader >> sharer_id;
+      _sharers[i] = sharer_id;
+   }
+}
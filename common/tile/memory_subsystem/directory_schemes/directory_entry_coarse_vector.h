@@ -0,0 +1,41 @@
+#pragma once
+
+#include "directory_entry.h"
+#include "bit_vector.h"
+#include "random.h"
+
+// Coarse vector: one bit per cluster of [dram_directory] cluster_size tiles,
+// and a count of the sharers (for the acknowledgements). A bit is set when a
+// tile of its cluster is added, and the bits are only cleared when the count
+// drops to zero, so all the tiles of the marked clusters are invalidated. The
+// sharers themselves are kept for the simulator only, as a list
+class DirectoryEntryCoarseVector : public DirectoryEntry
+{
+public:
+   DirectoryEntryCoarseVector(SInt32 max_num_sharers);
+   ~DirectoryEntryCoarseVector();
+
+   bool hasSharer(tile_id_t sharer_id);
+   bool addSharer(tile_id_t sharer_id);
+   void removeSharer(tile_id_t sharer_id, bool reply_expected);
+
+   bool getSharersList(vector<tile_id_t>& sharers_list);
+   tile_id_t getOneSharer();
+   SInt32 getNumSharers();
+
+   UInt32 getLatency();
+
+   UInt64 getNumExtraInvalidations() { return _num_extra_invalidations; }
+
+   void saveState(CheckpointWriter& writer);
+   void restoreState(CheckpointReader& reader);
+
+private:
+   SInt32 _max_num_sharers;
+   UInt32 _cluster_size;
+   BitVector* _clusters;
+   vector<tile_id_t> _sharers;
+   // Tiles of the marked clusters that were not sharers, over the lifetime of the entry
+   UInt64 _num_extra_invalidations;
+   Random _rand_num;
+};
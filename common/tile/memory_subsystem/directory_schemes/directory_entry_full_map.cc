@@ -47,18 +47,7 @@ DirectoryEntryFullMap::removeSharer(tile_id_t sharer_id, bool reply_expected)
 bool
 DirectoryEntryFullMap::getSharersList(vector<tile_id_t>& sharers_list)
 {
-   sharers_list.resize(_sharers->size());
-
-   _sharers->resetFind();
-
-   tile_id_t new_sharer = -1;
-   SInt32 i = 0;
-   while ((new_sharer = _sharers->find()) != -1)
-   {
-      sharers_list[i] = new_sharer;
-      i++;
-      assert (i <= (tile_id_t) _sharers->size());
-   }
+   _sharers->getSetBits(sharers_list);
 
    return false;
 }
@@ -66,11 +55,9 @@ DirectoryEntryFullMap::getSharersList(vector<tile_id_t>& sharers_list)
 tile_id_t
 DirectoryEntryFullMap::getOneSharer()
 {
-   vector<tile_id_t> sharers_list;
-   getSharersList(sharers_list);
-
-   SInt32 index = _rand_num.next(sharers_list.size());
-   return sharers_list[index];
+   // Pick the sharer from the bit-vector directly instead of building the list
+   SInt32 index = _rand_num.next(_sharers->size());
+   return _sharers->findNth(index);
 }
 
 SInt32
@@ -84,3 +71,17 @@ DirectoryEntryFullMap::getLatency()
 {
    return 0;
 }
+
+void
+DirectoryEntryFullMap::saveState(CheckpointWriter& writer)
+{
+   DirectoryEntry::saveState(writer);
+   saveSharers(writer, _sharers);
+}
+
+void
+DirectoryEntryFullMap::restoreState(CheckpointReader& reader)
+{
+   DirectoryEntry::restoreState(reader);
+   restoreSharers(reader, _sharers);
+}
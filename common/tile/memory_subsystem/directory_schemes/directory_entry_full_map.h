@@ -23,6 +23,9 @@ public:
 
    UInt32 getLatency();
 
+   void saveState(CheckpointWriter& writer);
+   void restoreState(CheckpointReader& reader);
+
 private:
    BitVector* _sharers;
    Random _rand_num;
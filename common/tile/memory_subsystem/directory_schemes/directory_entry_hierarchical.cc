@@ -0,0 +1,142 @@
+#include "directory_entry_hierarchical.h"
+#include "log.h"
+
+DirectoryEntryHierarchical::DirectoryEntryHierarchical(SInt32 max_num_sharers)
+   : DirectoryEntry(max_num_sharers)
+   , _cluster_size(getClusterSize())
+   , _num_sharers(0)
+{
+   _root = new BitVector((max_num_sharers + _cluster_size - 1) / _cluster_size);
+}
+
+DirectoryEntryHierarchical::~DirectoryEntryHierarchical()
+{
+   for (map<UInt32,BitVector*>::iterator it = _leaves.begin(); it != _leaves.end(); it++)
+      delete it->second;
+   delete _root;
+}
+
+bool
+DirectoryEntryHierarchical::hasSharer(tile_id_t sharer_id)
+{
+   UInt32 cluster = sharer_id / _cluster_size;
+   if (!_root->at(cluster))
+      return false;
+   return _leaves[cluster]->at(sharer_id % _cluster_size);
+}
+
+// Return value says whether the sharer was successfully added
+//              'True' if it was successfully added
+//              'False' if there will be an eviction before adding
+bool
+DirectoryEntryHierarchical::addSharer(tile_id_t sharer_id)
+{
+   UInt32 cluster = sharer_id / _cluster_size;
+   if (!_root->at(cluster))
+   {
+      _root->set(cluster);
+      _leaves[cluster] = new BitVector(_cluster_size);
+   }
+
+   BitVector* leaf = _leaves[cluster];
+   LOG_ASSERT_ERROR(!leaf->at(sharer_id % _cluster_size), "Could not add sharer(%i)", sharer_id);
+   leaf->set(sharer_id % _cluster_size);
+   _num_sharers ++;
+   return true;
+}
+
+void
+DirectoryEntryHierarchical::removeSharer(tile_id_t sharer_id, bool reply_expected)
+{
+   assert(!reply_expected);
+
+   UInt32 cluster = sharer_id / _cluster_size;
+   assert(_root->at(cluster));
+   map<UInt32,BitVector*>::iterator it = _leaves.find(cluster);
+   assert(it->second->at(sharer_id % _cluster_size));
+   it->second->clear(sharer_id % _cluster_size);
+   _num_sharers --;
+
+   if (it->second->size() == 0)
+   {
+      delete it->second;
+      _leaves.erase(it);
+      _root->clear(cluster);
+   }
+}
+
+// Return a pair:
+// val.first :- 'True' if all tiles are sharers
+//              'False' if NOT all tiles are sharers
+// val.second :- A list of tracked sharers
+bool
+DirectoryEntryHierarchical::getSharersList(vector<tile_id_t>& sharers_list)
+{
+   sharers_list.clear();
+   for (map<UInt32,BitVector*>::iterator it = _leaves.begin(); it != _leaves.end(); it++)
+   {
+      vector<SInt32> leaf_list;
+      it->second->getSetBits(leaf_list);
+      for (UInt32 i = 0; i < leaf_list.size(); i++)
+         sharers_list.push_back(it->first * _cluster_size + leaf_list[i]);
+   }
+   return false;
+}
+
+tile_id_t
+DirectoryEntryHierarchical::getOneSharer()
+{
+   UInt32 index = _rand_num.next(_num_sharers);
+   for (map<UInt32,BitVector*>::iterator it = _leaves.begin(); it != _leaves.end(); it++)
+   {
+      if (index < it->second->size())
+         return it->first * _cluster_size + it->second->findNth(index);
+      index -= it->second->size();
+   }
+   LOG_PRINT_ERROR("No sharer at index(%u), Num Sharers(%i)", index, _num_sharers);
+   return INVALID_TILE_ID;
+}
+
+SInt32
+DirectoryEntryHierarchical::getNumSharers()
+{
+   return _num_sharers;
+}
+
+UInt32
+DirectoryEntryHierarchical::getLatency()
+{
+   return 0;
+}
+
+void
+DirectoryEntryHierarchical::saveState(CheckpointWriter& writer)
+{
+   DirectoryEntry::saveState(writer);
+   vector<tile_id_t> sharers_list;
+   getSharersList(sharers_list);
+   writer << (UInt32) sharers_list.size();
+   for (UInt32 i = 0; i < sharers_list.size(); i++)
+      writer << (UInt32) sharers_list[i];
+}
+
+void
+DirectoryEntryHierarchical::restoreState(CheckpointReader& reader)
+{
+   DirectoryEntry::restoreState(reader);
+
+   for (map<UInt32,BitVector*>::iterator it = _leaves.begin(); it != _leaves.end(); it++)
+      delete it->second;
+   _leaves.clear();
+   _root->reset();
+   _num_sharers = 0;
+
+   UInt32 num_sharers;
+   reader >> num_sharers;
+   for (UInt32 i = 0; i < num_sharers; i++)
+   {
+      UInt32 sharer_id;
+      reader >> sharer_id;
+      addSharer(sharer_id);
+   }
+}
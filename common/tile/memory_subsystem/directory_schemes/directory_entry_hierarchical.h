@@ -0,0 +1,40 @@
+#pragma once
+
+#include <map>
+using std::map;
+
+#include "directory_entry.h"
+#include "bit_vector.h"
+#include "random.h"
+
+// Two-level (hierarchical) sharer vector, as in the scalable coherence
+// directory: a root bit per cluster of [dram_directory] cluster_size tiles,
+// and a leaf bit vector of the tiles of each cluster with sharers. The sharers
+// are exact, the leaves only take space for the clusters in use
+class DirectoryEntryHierarchical : public DirectoryEntry
+{
+public:
+   DirectoryEntryHierarchical(SInt32 max_num_sharers);
+   ~DirectoryEntryHierarchical();
+
+   bool hasSharer(tile_id_t sharer_id);
+   bool addSharer(tile_id_t sharer_id);
+   void removeSharer(tile_id_t sharer_id, bool reply_expected);
+
+   bool getSharersList(vector<tile_id_t>& sharers_list);
+   tile_id_t getOneSharer();
+   SInt32 getNumSharers();
+
+   UInt32 getLatency();
+
+   void saveState(CheckpointWriter& writer);
+   void restoreState(CheckpointReader& reader);
+
+private:
+   UInt32 _cluster_size;
+   BitVector* _root;
+   // Cluster -> leaf, for the clusters with sharers
+   map<UInt32,BitVector*> _leaves;
+   SInt32 _num_sharers;
+   Random _rand_num;
+};
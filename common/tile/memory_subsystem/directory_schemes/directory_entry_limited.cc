@@ -103,3 +103,19 @@ DirectoryEntryLimited::getNumSharers()
 {
    return _num_tracked_sharers;
 }
+
+void
+DirectoryEntryLimited::saveState(CheckpointWriter& writer)
+{
+   DirectoryEntry::saveState(writer);
+   writer.putVector(_sharers);
+   writer << _num_tracked_sharers;
+}
+
+void
+DirectoryEntryLimited::restoreState(CheckpointReader& reader)
+{
+   DirectoryEntry::restoreState(reader);
+   reader.getVector(_sharers);
+   reader >> _num_tracked_sharers;
+}
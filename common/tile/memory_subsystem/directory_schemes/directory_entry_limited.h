@@ -17,6 +17,9 @@ public:
    tile_id_t getOneSharer();
    SInt32 getNumSharers();
 
+   void saveState(CheckpointWriter& writer);
+   void restoreState(CheckpointReader& reader);
+
 protected:
    vector<SInt16> _sharers;
    SInt32 _num_tracked_sharers;
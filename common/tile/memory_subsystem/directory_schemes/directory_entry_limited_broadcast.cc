@@ -88,3 +88,18 @@ DirectoryEntryLimitedBroadcast::getLatency()
    return 0;
 }
 
+void
+DirectoryEntryLimitedBroadcast::saveState(CheckpointWriter& writer)
+{
+   DirectoryEntryLimited::saveState(writer);
+   writer << (UInt8) _global_enabled << _num_sharers;
+}
+
+void
+DirectoryEntryLimitedBroadcast::restoreState(CheckpointReader& reader)
+{
+   DirectoryEntryLimited::restoreState(reader);
+   UInt8 global_enabled;
+   reader >> global_enabled >> _num_sharers;
+   _global_enabled = global_enabled;
+}
@@ -103,18 +103,7 @@ DirectoryEntryLimitless::getSharersList(vector<tile_id_t>& sharers_list)
 {
    if (_software_trap_enabled) // Explicit software tracking of sharers
    {
-      sharers_list.resize(_software_sharers->size());
-      
-      _software_sharers->resetFind();
-
-      tile_id_t new_sharer = -1;
-      SInt32 i = 0;
-      while ((new_sharer = _software_sharers->find()) != -1)
-      {
-         sharers_list[i] = new_sharer;
-         i++;
-         assert (i <= (tile_id_t) _software_sharers->size());
-      }
+      _software_sharers->getSetBits(sharers_list);
    }
    else // (!_software_trap_enabled) - Explicit hardware tracking of sharers
    {
@@ -135,3 +124,43 @@ DirectoryEntryLimitless::getLatency()
 {
    return (_software_trap_enabled) ? _software_trap_penalty : 0;
 }
+
+void
+DirectoryEntryLimitless::reset()
+{
+   DirectoryEntryLimited::reset();
+   // Back to tracking the sharers in hardware
+   _software_trap_enabled = false;
+   delete _software_sharers;
+   _software_sharers = NULL;
+}
+
+void
+DirectoryEntryLimitless::saveState(CheckpointWriter& writer)
+{
+   DirectoryEntryLimited::saveState(writer);
+   writer << (UInt8) _software_trap_enabled;
+   if (_software_trap_enabled)
+      saveSharers(writer, _software_sharers);
+}
+
+void
+DirectoryEntryLimitless::restoreState(CheckpointReader& reader)
+{
+   DirectoryEntryLimited::restoreState(reader);
+   UInt8 software_trap_enabled;
+   reader >> software_trap_enabled;
+   _software_trap_enabled = software_trap_enabled;
+
+   if (_software_trap_enabled)
+   {
+      if (!_software_sharers)
+         _software_sharers = new BitVector(_max_num_sharers);
+      restoreSharers(reader, _software_sharers);
+   }
+   else if (_software_sharers)
+   {
+      delete _software_sharers;
+      _software_sharers = NULL;
+   }
+}
@@ -18,6 +18,11 @@ public:
 
    UInt32 getLatency();
 
+   void reset();
+
+   void saveState(CheckpointWriter& writer);
+   void restoreState(CheckpointReader& reader);
+
 private:
    // Software Sharers
    BitVector* _software_sharers;
@@ -7,5 +7,7 @@ enum DirectoryType
    LIMITED_BROADCAST,
    ACKWISE,
    LIMITLESS,
+   COARSE_VECTOR,
+   HIERARCHICAL,
    NUM_DIRECTORY_TYPES
 };
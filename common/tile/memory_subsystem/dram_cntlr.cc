@@ -2,6 +2,8 @@
 #include "tile.h"
 #include "memory_manager.h"
 #include "clock_converter.h"
+#include "config.h"
+#include "simulator.h"
 #include "log.h"
 
 DramCntlr::DramCntlr(Tile* tile,
@@ -11,6 +13,7 @@ DramCntlr::DramCntlr(Tile* tile,
       string dram_queue_model_type,
       UInt32 cache_line_size)
    : _tile(tile)
+   , _data_profiler(Sim()->getDataProfiler())
    , _cache_line_size(cache_line_size)
 {
    _dram_perf_model = new DramPerfModel(dram_access_cost, 
@@ -31,8 +34,10 @@ DramCntlr::~DramCntlr()
 }
 
 void
-DramCntlr::getDataFromDram(IntPtr address, Byte* data_buf, bool modeled)
+DramCntlr::getDataFromDram(IntPtr address, Byte* data_buf, bool modeled, tile_id_t requester)
 {
+   ScopedLock sl(_lock);
+
    if (_data_map[address] == NULL)
    {
       _data_map[address] = new Byte[_cache_line_size];
@@ -40,35 +45,41 @@ DramCntlr::getDataFromDram(IntPtr address, Byte* data_buf, bool modeled)
    }
    memcpy((void*) data_buf, (void*) _data_map[address], _cache_line_size);
 
-   UInt64 dram_access_latency = modeled ? runDramPerfModel() : 0;
+   UInt64 dram_access_latency = modeled ? runDramPerfModel(address, requester) : 0;
    LOG_PRINT("Dram Access Latency(%llu)", dram_access_latency);
-   getShmemPerfModel()->incrCycleCount(dram_access_latency);
+   getShmemPerfModel(address)->incrCycleCount(dram_access_latency);
 
    addToDramAccessCount(address, READ);
+   if (modeled && _data_profiler)
+      _data_profiler->recordDramAccess(_data_profiler_lookup, address, false);
 }
 
 void
 DramCntlr::putDataToDram(IntPtr address, Byte* data_buf, bool modeled)
 {
+   ScopedLock sl(_lock);
+
    LOG_ASSERT_ERROR(_data_map[address] != NULL, "Data Buffer does not exist");
    
    memcpy((void*) _data_map[address], (void*) data_buf, _cache_line_size);
 
-   __attribute(__unused__) UInt64 dram_access_latency = modeled ? runDramPerfModel() : 0;
+   __attribute(__unused__) UInt64 dram_access_latency = modeled ? runDramPerfModel(address, INVALID_TILE_ID) : 0;
    
    addToDramAccessCount(address, WRITE);
+   if (modeled && _data_profiler)
+      _data_profiler->recordDramAccess(_data_profiler_lookup, address, true);
 }
 
 UInt64
-DramCntlr::runDramPerfModel()
+DramCntlr::runDramPerfModel(IntPtr address, tile_id_t requester)
 {
-   UInt64 pkt_cycle_count = getShmemPerfModel()->getCycleCount();
+   UInt64 pkt_cycle_count = getShmemPerfModel(address)->getCycleCount();
    UInt64 pkt_size = (UInt64) _cache_line_size;
 
    float tile_frequency = _tile->getCore()->getPerformanceModel()->getFrequency();
    UInt64 pkt_time = convertCycleCount(pkt_cycle_count, tile_frequency, 1.0);
 
-   UInt64 dram_access_latency = _dram_perf_model->getAccessLatency(pkt_time, pkt_size);
+   UInt64 dram_access_latency = _dram_perf_model->getAccessLatency(pkt_time, pkt_size, address, requester);
    
    return convertCycleCount(dram_access_latency, 1.0, tile_frequency);
 }
@@ -97,7 +108,60 @@ DramCntlr::printDramAccessCount()
 }
 
 ShmemPerfModel*
-DramCntlr::getShmemPerfModel()
+DramCntlr::getShmemPerfModel(IntPtr address)
+{
+   return _tile->getMemoryManager()->getDirectoryShmemPerfModel(address);
+}
+
+void
+DramCntlr::saveState(CheckpointWriter& writer)
+{
+   // Timing-only caches never hand real data to the controller
+   bool store_data = !Config::getSingleton()->areCachesTimingOnly();
+
+   UInt64 num_lines = 0;
+   for (map<IntPtr, Byte*>::iterator it = _data_map.begin(); it != _data_map.end(); it++)
+   {
+      if (it->second)
+         num_lines ++;
+   }
+
+   writer.beginSection("Dram Cntlr");
+   writer << _cache_line_size << (UInt8) store_data << num_lines;
+   for (map<IntPtr, Byte*>::iterator it = _data_map.begin(); it != _data_map.end(); it++)
+   {
+      if (!it->second)
+         continue;
+      writer << (UInt64) it->first;
+      if (store_data)
+         writer.put(it->second, _cache_line_size);
+   }
+}
+
+void
+DramCntlr::restoreState(CheckpointReader& reader)
 {
-   return _tile->getMemoryManager()->getShmemPerfModel();
+   reader.beginSection("Dram Cntlr");
+   UInt32 cache_line_size;
+   UInt8 store_data;
+   UInt64 num_lines;
+   reader >> cache_line_size >> store_data >> num_lines;
+   LOG_ASSERT_ERROR(cache_line_size == _cache_line_size, "Checkpoint cache line size(%u), expected(%u)",
+                    cache_line_size, _cache_line_size);
+
+   for (map<IntPtr, Byte*>::iterator it = _data_map.begin(); it != _data_map.end(); it++)
+      delete [] it->second;
+   _data_map.clear();
+
+   for (UInt64 i = 0; i < num_lines; i++)
+   {
+      UInt64 address;
+      reader >> address;
+      Byte* data_buf = new Byte[_cache_line_size];
+      if (store_data)
+         reader.get(data_buf, _cache_line_size);
+      else
+         memset((void*) data_buf, 0x00, _cache_line_size);
+      _data_map[address] = data_buf;
+   }
 }
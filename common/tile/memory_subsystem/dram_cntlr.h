@@ -7,6 +7,9 @@ using std::map;
 #include "dram_perf_model.h"
 #include "shmem_perf_model.h"
 #include "fixed_types.h"
+#include "checkpoint.h"
+#include "lock.h"
+#include "data_profiler.h"
 
 class DramCntlr
 {
@@ -28,19 +31,30 @@ public:
 
    DramPerfModel* getDramPerfModel() { return _dram_perf_model; }
 
-   void getDataFromDram(IntPtr address, Byte* data_buf, bool modeled);
+   // 'requester' is the tile the line is read for, for the DRAM QoS scheduler
+   void getDataFromDram(IntPtr address, Byte* data_buf, bool modeled, tile_id_t requester = INVALID_TILE_ID);
    void putDataToDram(IntPtr address, Byte* data_buf, bool modeled);
+
+   // Checkpointing of the lines held by this controller
+   void saveState(CheckpointWriter& writer);
+   void restoreState(CheckpointReader& reader);
    
 private:
    Tile* _tile;
    map<IntPtr, Byte*> _data_map;
+   // The directory of the tile may be served by several sim threads
+   Lock _lock;
    DramPerfModel* _dram_perf_model;
 
+   // DRAM accesses by allocation site ([data_profiler])
+   DataProfiler* _data_profiler;
+   DataProfiler::LookupCache _data_profiler_lookup;
+
    typedef std::map<IntPtr,UInt64> AccessCountMap;
    AccessCountMap* _dram_access_count;
 
-   ShmemPerfModel* getShmemPerfModel();
-   UInt64 runDramPerfModel();
+   ShmemPerfModel* getShmemPerfModel(IntPtr address);
+   UInt64 runDramPerfModel(IntPtr address, tile_id_t requester);
 
    void addToDramAccessCount(IntPtr address, AccessType access_type);
    void printDramAccessCount();
@@ -0,0 +1,188 @@
+#include "l3_cache_cntlr.h"
+#include "memory_manager.h"
+#include "dram_cntlr.h"
+#include "cache_line_info.h"
+#include "cache_replacement_policy.h"
+#include "cache_hash_fn.h"
+#include "simulator.h"
+#include "config.h"
+#include "log.h"
+
+L3CacheCntlr::L3CacheCntlr(MemoryManager* memory_manager,
+                           DramCntlr* dram_cntlr,
+                           CachingProtocolType caching_protocol_type,
+                           SInt32 cache_level,
+                           string l3_cache_type,
+                           UInt32 cache_line_size,
+                           float frequency)
+   : _memory_manager(memory_manager)
+   , _dram_cntlr(dram_cntlr)
+   , _cache_line_size(cache_line_size)
+{
+   UInt32 l3_cache_line_size = 0;
+   UInt32 l3_cache_size = 0;
+   UInt32 l3_cache_associativity = 0;
+   string l3_cache_replacement_policy;
+   UInt32 l3_cache_data_access_time = 0;
+   UInt32 l3_cache_tags_access_time = 0;
+   string l3_cache_perf_model_type;
+   bool l3_cache_track_miss_types = false;
+   try
+   {
+      string section = "l3_cache/" + l3_cache_type;
+      l3_cache_line_size = Sim()->getCfg()->getInt(section + "/cache_line_size");
+      l3_cache_size = Sim()->getCfg()->getInt(section + "/cache_size");
+      l3_cache_associativity = Sim()->getCfg()->getInt(section + "/associativity");
+      l3_cache_replacement_policy = Sim()->getCfg()->getString(section + "/replacement_policy");
+      l3_cache_data_access_time = Sim()->getCfg()->getInt(section + "/data_access_time");
+      l3_cache_tags_access_time = Sim()->getCfg()->getInt(section + "/tags_access_time");
+      l3_cache_perf_model_type = Sim()->getCfg()->getString(section + "/perf_model_type");
+      l3_cache_track_miss_types = Sim()->getCfg()->getBool(section + "/track_miss_types", false);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read [l3_cache/%s] parameters from the cfg file", l3_cache_type.c_str());
+   }
+
+   LOG_ASSERT_ERROR(l3_cache_line_size == _cache_line_size,
+                    "L3 Cache Line Size(%u) must be the same as the L1/L2 Cache Line Size(%u)",
+                    l3_cache_line_size, _cache_line_size);
+
+   _l3_cache_replacement_policy_obj =
+      CacheReplacementPolicy::create(l3_cache_replacement_policy, l3_cache_size, l3_cache_associativity, _cache_line_size);
+   _l3_cache_hash_fn_obj = new CacheHashFn(l3_cache_size, l3_cache_associativity, _cache_line_size);
+
+   _l3_cache = new Cache("L3",
+         caching_protocol_type,
+         Cache::UNIFIED_CACHE,
+         cache_level,
+         Cache::WRITE_BACK,
+         l3_cache_size,
+         l3_cache_associativity,
+         _cache_line_size,
+         _l3_cache_replacement_policy_obj,
+         _l3_cache_hash_fn_obj,
+         l3_cache_data_access_time,
+         frequency,
+         l3_cache_track_miss_types);
+
+   _l3_cache_perf_model = CachePerfModel::create(l3_cache_perf_model_type,
+         l3_cache_data_access_time, l3_cache_tags_access_time, frequency);
+
+   _l3_cache->registerStatistics(_memory_manager->getTile()->getId());
+}
+
+L3CacheCntlr::~L3CacheCntlr()
+{
+   delete _l3_cache_perf_model;
+   delete _l3_cache;
+   delete _l3_cache_replacement_policy_obj;
+   delete _l3_cache_hash_fn_obj;
+}
+
+string
+L3CacheCntlr::getType()
+{
+   try
+   {
+      return Sim()->getCfg()->getString("l3_cache/type", "none");
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read l3_cache/type from the cfg file");
+      return "none";
+   }
+}
+
+void
+L3CacheCntlr::getDataFromDram(IntPtr address, Byte* data_buf, bool modeled, tile_id_t requester)
+{
+   ScopedLock sl(_lock);
+
+   CacheLineInfo l3_cache_line_info;
+   _l3_cache->getCacheLineInfo(address, &l3_cache_line_info);
+   bool l3_cache_hit = (l3_cache_line_info.getCState() != CacheState::INVALID);
+   _l3_cache->updateMissCounters(address, Core::READ, !l3_cache_hit);
+
+   if (l3_cache_hit)
+   {
+      incrCycleCount(address, CachePerfModel::ACCESS_CACHE_DATA_AND_TAGS, modeled);
+      _l3_cache->accessCacheLine(address, Cache::LOAD, data_buf, _cache_line_size);
+      return;
+   }
+
+   incrCycleCount(address, CachePerfModel::ACCESS_CACHE_TAGS, modeled);
+   _dram_cntlr->getDataFromDram(address, data_buf, modeled, requester);
+   insertCacheLine(address, CacheState::CLEAN, data_buf, modeled);
+}
+
+void
+L3CacheCntlr::putDataToDram(IntPtr address, Byte* data_buf, bool modeled)
+{
+   ScopedLock sl(_lock);
+
+   CacheLineInfo l3_cache_line_info;
+   _l3_cache->getCacheLineInfo(address, &l3_cache_line_info);
+   bool l3_cache_hit = (l3_cache_line_info.getCState() != CacheState::INVALID);
+   _l3_cache->updateMissCounters(address, Core::WRITE, !l3_cache_hit);
+
+   // Off the critical path of the request, no latency
+   if (l3_cache_hit)
+   {
+      _l3_cache->accessCacheLine(address, Cache::STORE, data_buf, _cache_line_size);
+      l3_cache_line_info.setCState(CacheState::DIRTY);
+      _l3_cache->setCacheLineInfo(address, &l3_cache_line_info);
+   }
+   else
+   {
+      insertCacheLine(address, CacheState::DIRTY, data_buf, modeled);
+   }
+}
+
+void
+L3CacheCntlr::insertCacheLine(IntPtr address, CacheState::Type cstate, Byte* fill_buf, bool modeled)
+{
+   CacheLineInfo l3_cache_line_info(_l3_cache->getTag(address), cstate);
+
+   bool eviction;
+   IntPtr evicted_address;
+   CacheLineInfo evicted_cache_line_info;
+   Byte writeback_buf[_cache_line_size];
+
+   _l3_cache->insertCacheLine(address, &l3_cache_line_info, fill_buf,
+                              &eviction, &evicted_address, &evicted_cache_line_info, writeback_buf);
+
+   if (eviction && (evicted_cache_line_info.getCState() == CacheState::DIRTY))
+   {
+      LOG_PRINT("L3 Eviction: address(%#lx) written back", evicted_address);
+      _dram_cntlr->putDataToDram(evicted_address, writeback_buf, modeled);
+   }
+}
+
+void
+L3CacheCntlr::incrCycleCount(IntPtr address, CachePerfModel::CacheAccess_t access_type, bool modeled)
+{
+   if (modeled)
+      _memory_manager->getDirectoryShmemPerfModel(address)->incrCycleCount(_l3_cache_perf_model->getLatency(access_type));
+}
+
+void
+L3CacheCntlr::enable()
+{
+   _l3_cache->enable();
+   _l3_cache_perf_model->enable();
+}
+
+void
+L3CacheCntlr::disable()
+{
+   _l3_cache->disable();
+   _l3_cache_perf_model->disable();
+}
+
+void
+L3CacheCntlr::outputSummary(std::ostream& out)
+{
+   // Dirty Evictions are the writebacks to DRAM
+   _l3_cache->outputSummary(out);
+}
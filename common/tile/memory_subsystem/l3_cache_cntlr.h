@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <ostream>
+using std::string;
+
+#include "cache.h"
+#include "cache_perf_model.h"
+#include "caching_protocol_type.h"
+#include "fixed_types.h"
+#include "lock.h"
+
+class MemoryManager;
+class DramCntlr;
+class CacheReplacementPolicy;
+class CacheHashFn;
+
+// Slice of a shared L3 cache in front of the memory controller of a tile,
+// used by the dram directory of the private L2 protocols ([l3_cache]).
+// Non-inclusive: a line read from DRAM is filled in the slice, and the
+// lines written back by the L2 caches are kept in it (dirty) until they are
+// evicted to DRAM. The lines of the private caches are not invalidated when
+// the slice evicts them. A hit costs the data and tags access time of the
+// slice instead of the DRAM access, a miss the tags access time in addition.
+
+class L3CacheCntlr
+{
+public:
+   L3CacheCntlr(MemoryManager* memory_manager,
+                DramCntlr* dram_cntlr,
+                CachingProtocolType caching_protocol_type,
+                SInt32 cache_level,
+                string l3_cache_type,
+                UInt32 cache_line_size,
+                float frequency);
+   ~L3CacheCntlr();
+
+   // Type of the [l3_cache/<type>] preset of the slices, "none" without an L3
+   static string getType();
+
+   // Same as the DramCntlr ones, through the slice
+   void getDataFromDram(IntPtr address, Byte* data_buf, bool modeled, tile_id_t requester = INVALID_TILE_ID);
+   void putDataToDram(IntPtr address, Byte* data_buf, bool modeled);
+
+   Cache* getL3Cache() { return _l3_cache; }
+
+   void enable();
+   void disable();
+
+   void outputSummary(std::ostream& out);
+
+private:
+   MemoryManager* _memory_manager;
+   DramCntlr* _dram_cntlr;
+   UInt32 _cache_line_size;
+
+   Cache* _l3_cache;
+   CacheReplacementPolicy* _l3_cache_replacement_policy_obj;
+   CacheHashFn* _l3_cache_hash_fn_obj;
+   CachePerfModel* _l3_cache_perf_model;
+   // Shared by the sim threads of a sharded directory
+   Lock _lock;
+
+   void insertCacheLine(IntPtr address, CacheState::Type cstate, Byte* fill_buf, bool modeled);
+   void incrCycleCount(IntPtr address, CachePerfModel::CacheAccess_t access_type, bool modeled);
+};
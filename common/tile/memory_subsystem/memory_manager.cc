@@ -1,5 +1,8 @@
 using namespace std;
 
+#include <sstream>
+#include <fstream>
+
 #include "simulator.h"
 #include "config.h"
 #include "memory_manager.h"
@@ -7,10 +10,14 @@ using namespace std;
 #include "pr_l1_pr_l2_dram_directory_mosi/memory_manager.h"
 #include "pr_l1_sh_l2_msi/memory_manager.h"
 #include "network_model.h"
+#include "event_tracer.h"
+#include "clock_converter.h"
 #include "log.h"
 
 // Static Members
 CachingProtocolType MemoryManager::_caching_protocol_type;
+bool MemoryManager::_optimized_memory_controller_positions_computed = false;
+vector<tile_id_t> MemoryManager::_optimized_memory_controller_positions;
 
 MemoryManager::MemoryManager(Tile* tile, Network* network, ShmemPerfModel* shmem_perf_model)
    : _tile(tile)
@@ -21,6 +28,52 @@ MemoryManager::MemoryManager(Tile* tile, Network* network, ShmemPerfModel* shmem
 MemoryManager::~MemoryManager()
 {}
 
+UInt32
+MemoryManager::coreInitiateMemoryAccesses(MemComponent::Type mem_component,
+                                          Core::mem_op_t mem_op_type,
+                                          LineAccess* lines, UInt32 num_lines,
+                                          UInt64& curr_time, bool modeled,
+                                          UInt32 max_lines_in_flight)
+{
+   UInt64 issue_time = curr_time;
+   UInt32 num_misses = 0;
+   // Completion times of the lines in flight
+   vector<UInt64> completion_times(max_lines_in_flight, 0);
+   for (UInt32 i = 0; i < num_lines; i++)
+   {
+      UInt64 line_time = issue_time;
+      if (max_lines_in_flight > 0)
+         line_time = max(line_time, completion_times[i % max_lines_in_flight]);
+      issue_time = line_time + 1;
+
+      if (!coreInitiateMemoryAccess(mem_component, Core::NONE, mem_op_type,
+                                    lines[i].address, lines[i].offset,
+                                    lines[i].data_buf, lines[i].data_length,
+                                    line_time, modeled))
+      {
+         num_misses ++;
+      }
+      if (max_lines_in_flight > 0)
+         completion_times[i % max_lines_in_flight] = line_time;
+      curr_time = max(curr_time, line_time);
+   }
+   return num_misses;
+}
+
+void
+MemoryManager::traceDirectoryReq(const char* name, IntPtr address, UInt64 arrival_time, UInt64 finish_time)
+{
+   EventTracer* event_tracer = Sim()->getEventTracer();
+   if (!event_tracer || !event_tracer->isEnabled(EventTracer::DIRECTORY))
+      return;
+
+   float frequency = getTile()->getCore()->getPerformanceModel()->getFrequency();
+   event_tracer->record(EventTracer::DIRECTORY, name, getTile()->getId(),
+                        convertCycleCount(arrival_time, frequency, 1.0),
+                        convertCycleCount(finish_time, frequency, 1.0),
+                        address);
+}
+
 MemoryManager* 
 MemoryManager::createMMU(std::string protocol_type,
       Tile* tile, Network* network, ShmemPerfModel* shmem_perf_model)
@@ -30,6 +83,8 @@ MemoryManager::createMMU(std::string protocol_type,
    switch (_caching_protocol_type)
    {
    case PR_L1_PR_L2_DRAM_DIRECTORY_MSI:
+   case PR_L1_PR_L2_DRAM_DIRECTORY_MESI:
+      // MESI is the MSI protocol with an Exclusive state
       return new PrL1PrL2DramDirectoryMSI::MemoryManager(tile, network, shmem_perf_model);
 
    case PR_L1_PR_L2_DRAM_DIRECTORY_MOSI:
@@ -49,6 +104,8 @@ MemoryManager::parseProtocolType(std::string& protocol_type)
 {
    if (protocol_type == "pr_l1_pr_l2_dram_directory_msi")
       return PR_L1_PR_L2_DRAM_DIRECTORY_MSI;
+   else if (protocol_type == "pr_l1_pr_l2_dram_directory_mesi")
+      return PR_L1_PR_L2_DRAM_DIRECTORY_MESI;
    else if (protocol_type == "pr_l1_pr_l2_dram_directory_mosi")
       return PR_L1_PR_L2_DRAM_DIRECTORY_MOSI;
    else if (protocol_type == "pr_l1_sh_l2_msi")
@@ -57,6 +114,18 @@ MemoryManager::parseProtocolType(std::string& protocol_type)
       return NUM_CACHING_PROTOCOL_TYPES;
 }
 
+void
+MemoryManager::saveCheckpoint(CheckpointWriter& writer)
+{
+   LOG_PRINT_ERROR("Checkpoints are not supported by caching protocol(%u)", _caching_protocol_type);
+}
+
+void
+MemoryManager::restoreCheckpoint(CheckpointReader& reader)
+{
+   LOG_PRINT_ERROR("Checkpoints are not supported by caching protocol(%u)", _caching_protocol_type);
+}
+
 void MemoryManagerNetworkCallback(void* obj, NetPacket packet)
 {
    MemoryManager *mm = (MemoryManager*) obj;
@@ -81,6 +150,7 @@ MemoryManager::openCacheLineReplicationTraceFiles()
    switch (_caching_protocol_type)
    {
    case PR_L1_PR_L2_DRAM_DIRECTORY_MSI:
+   case PR_L1_PR_L2_DRAM_DIRECTORY_MESI:
       PrL1PrL2DramDirectoryMSI::MemoryManager::openCacheLineReplicationTraceFiles();
       break;
 
@@ -101,6 +171,7 @@ MemoryManager::closeCacheLineReplicationTraceFiles()
    switch (_caching_protocol_type)
    {
    case PR_L1_PR_L2_DRAM_DIRECTORY_MSI:
+   case PR_L1_PR_L2_DRAM_DIRECTORY_MESI:
       PrL1PrL2DramDirectoryMSI::MemoryManager::closeCacheLineReplicationTraceFiles();
       break;
 
@@ -121,6 +192,7 @@ MemoryManager::outputCacheLineReplicationSummary()
    switch (_caching_protocol_type)
    {
    case PR_L1_PR_L2_DRAM_DIRECTORY_MSI:
+   case PR_L1_PR_L2_DRAM_DIRECTORY_MESI:
       PrL1PrL2DramDirectoryMSI::MemoryManager::outputCacheLineReplicationSummary();
       break;
 
@@ -141,11 +213,14 @@ MemoryManager::getTileListWithMemoryControllers()
    string num_memory_controllers_str;
    string memory_controller_positions_from_cfg_file = "";
 
+   string placement_policy;
+
    UInt32 application_tile_count = Config::getSingleton()->getApplicationTiles();
    try
    {
       num_memory_controllers_str = Sim()->getCfg()->getString("dram/num_controllers");
       memory_controller_positions_from_cfg_file = Sim()->getCfg()->getString("dram/controller_positions");
+      placement_policy = Sim()->getCfg()->getString("dram/placement/policy", "fixed");
    }
    catch (...)
    {
@@ -153,6 +228,8 @@ MemoryManager::getTileListWithMemoryControllers()
    }
 
    UInt32 num_memory_controllers = (num_memory_controllers_str == "ALL") ? application_tile_count : convertFromString<UInt32>(num_memory_controllers_str);
+   LOG_ASSERT_ERROR((placement_policy == "fixed") || (placement_policy == "profile"),
+                    "Unrecognized DRAM placement policy(%s), expected fixed or profile", placement_policy.c_str());
    
    LOG_ASSERT_ERROR(num_memory_controllers <= application_tile_count, "Num Memory Controllers(%i), Num Application Tiles(%i)",
                     num_memory_controllers, application_tile_count);
@@ -189,15 +266,20 @@ MemoryManager::getTileListWithMemoryControllers()
          pair<bool, vector<tile_id_t> > tile_list_with_memory_controllers_1 = NetworkModel::computeMemoryControllerPositions(l_models_memory_1, num_memory_controllers, application_tile_count);
          pair<bool, vector<tile_id_t> > tile_list_with_memory_controllers_2 = NetworkModel::computeMemoryControllerPositions(l_models_memory_2, num_memory_controllers, application_tile_count);
 
+         vector<tile_id_t> tile_list_with_memory_controllers;
          if (tile_list_with_memory_controllers_1.first)
-            return tile_list_with_memory_controllers_1.second;
+            tile_list_with_memory_controllers = tile_list_with_memory_controllers_1.second;
          else if (tile_list_with_memory_controllers_2.first)
-            return tile_list_with_memory_controllers_2.second;
+            tile_list_with_memory_controllers = tile_list_with_memory_controllers_2.second;
          else
          {
             // Return Any of them - Both the network models do not have specific positions
-            return tile_list_with_memory_controllers_1.second;
+            tile_list_with_memory_controllers = tile_list_with_memory_controllers_1.second;
          }
+
+         if (placement_policy == "profile")
+            return optimizeMemoryControllerPositions(tile_list_with_memory_controllers);
+         return tile_list_with_memory_controllers;
       }
    }
    else
@@ -211,6 +293,92 @@ MemoryManager::getTileListWithMemoryControllers()
    }
 }
 
+vector<tile_id_t>
+MemoryManager::optimizeMemoryControllerPositions(const vector<tile_id_t>& initial_positions)
+{
+   if (_optimized_memory_controller_positions_computed)
+      return _optimized_memory_controller_positions;
+
+   string traffic_profile;
+   double link_load_weight = 0;
+   string output_dir;
+   try
+   {
+      traffic_profile = Sim()->getCfg()->getString("dram/placement/traffic_profile");
+      link_load_weight = Sim()->getCfg()->getFloat("dram/placement/link_load_weight", 1.0);
+      output_dir = Sim()->getCfg()->getString("general/output_dir");
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read [dram/placement] parameters from the cfg file");
+   }
+
+   vector<UInt64> traffic;
+   readDramTrafficProfile(traffic_profile, traffic);
+
+   UInt32 l_models_memory_1 = NetworkModel::parseNetworkType(Config::getSingleton()->getNetworkType(STATIC_NETWORK_MEMORY_1));
+   UInt32 l_models_memory_2 = NetworkModel::parseNetworkType(Config::getSingleton()->getNetworkType(STATIC_NETWORK_MEMORY_2));
+
+   pair<bool, vector<tile_id_t> > optimized_positions =
+      NetworkModel::optimizeMemoryControllerPositions(l_models_memory_1, traffic, initial_positions, link_load_weight);
+   if (!optimized_positions.first)
+      optimized_positions = NetworkModel::optimizeMemoryControllerPositions(l_models_memory_2, traffic, initial_positions, link_load_weight);
+   LOG_ASSERT_WARNING(optimized_positions.first,
+                      "The memory networks have no memory controller placement search, using the default positions");
+
+   _optimized_memory_controller_positions = optimized_positions.second;
+   _optimized_memory_controller_positions_computed = true;
+
+   // Write the positions as a cfg override, for the next runs
+   if (optimized_positions.first && (Config::getSingleton()->getCurrentProcessNum() == 0))
+   {
+      ostringstream positions;
+      for (vector<tile_id_t>::iterator it = _optimized_memory_controller_positions.begin();
+            it != _optimized_memory_controller_positions.end(); it++)
+      {
+         positions << ((it == _optimized_memory_controller_positions.begin()) ? "" : ",") << *it;
+      }
+
+      string filename = output_dir + "/dram_controller_positions.cfg";
+      ofstream override_file(filename.c_str());
+      LOG_ASSERT_ERROR(override_file.good(), "Could not open %s", filename.c_str());
+      override_file << "[dram]" << endl
+                    << "controller_positions = \"" << positions.str() << "\"" << endl;
+      override_file.close();
+
+      fprintf(stderr, "\n[[Graphite]] --> [ Memory controller positions from the traffic profile written to %s ]\n",
+              filename.c_str());
+   }
+
+   return _optimized_memory_controller_positions;
+}
+
+void
+MemoryManager::readDramTrafficProfile(const string& filename, vector<UInt64>& traffic)
+{
+   // One line per tile: <tile_id> <number of DRAM requests>, '#' starts a comment.
+   // The tiles that are not listed have no traffic
+   UInt32 application_tile_count = Config::getSingleton()->getApplicationTiles();
+   traffic.assign(application_tile_count, 0);
+
+   ifstream profile(filename.c_str());
+   LOG_ASSERT_ERROR(profile.good(), "Could not open the DRAM traffic profile(%s)", filename.c_str());
+
+   string line;
+   while (getline(profile, line))
+   {
+      line = line.substr(0, line.find('#'));
+      istringstream fields(line);
+      SInt32 tile_id;
+      UInt64 num_requests;
+      if (!(fields >> tile_id))
+         continue;
+      LOG_ASSERT_ERROR((fields >> num_requests) && (tile_id >= 0) && (tile_id < (SInt32) application_tile_count),
+                       "Invalid line in the DRAM traffic profile(%s): %s", filename.c_str(), line.c_str());
+      traffic[tile_id] += num_requests;
+   }
+}
+
 void
 MemoryManager::printTileListWithMemoryControllers(vector<tile_id_t>& tile_list_with_memory_controllers)
 {
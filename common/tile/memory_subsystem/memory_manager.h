@@ -9,12 +9,22 @@ using namespace std;
 #include "mem_component.h"
 #include "caching_protocol_type.h"
 #include "shmem_perf_model.h"
+#include "checkpoint.h"
 
 void MemoryManagerNetworkCallback(void* obj, NetPacket packet);
 
 class MemoryManager
 {
 public:
+   // A cache line of a multi-line access of the core
+   struct LineAccess
+   {
+      IntPtr address;
+      UInt32 offset;
+      Byte* data_buf;
+      UInt32 data_length;
+   };
+
    MemoryManager(Tile* tile, Network* network, ShmemPerfModel* shmem_perf_model);
    virtual ~MemoryManager();
 
@@ -24,30 +34,61 @@ public:
                                          IntPtr address, UInt32 offset,
                                          Byte* data_buf, UInt32 data_length,
                                          UInt64& curr_time, bool modeled) = 0;
+   // The lines of one access, issued one per cycle from 'curr_time' so that
+   // their latencies overlap: 'curr_time' ends as the time the last one
+   // completes. With 'max_lines_in_flight', a line also waits for the one
+   // that many lines before it to complete. Returns the number of lines that missed
+   virtual UInt32 coreInitiateMemoryAccesses(MemComponent::Type mem_component,
+                                             Core::mem_op_t mem_op_type,
+                                             LineAccess* lines, UInt32 num_lines,
+                                             UInt64& curr_time, bool modeled,
+                                             UInt32 max_lines_in_flight = 0);
+   // Serves an L1 read hit without the memory manager lock if the protocol
+   // supports it. Returns false if the access must go through coreInitiateMemoryAccess()
+   virtual bool coreProbeL1Hit(MemComponent::Type mem_component,
+                               IntPtr address, UInt32 offset,
+                               Byte* data_buf, UInt32 data_length,
+                               UInt64& curr_time)
+   { return false; }
 
    virtual void handleMsgFromNetwork(NetPacket& packet) = 0;
 
    Tile* getTile()   { return _tile; }
    virtual UInt32 getCacheLineSize() = 0;
+   virtual Cache* getL1ICache() = 0;
+   virtual Cache* getL1DCache() = 0;
+   virtual Cache* getL2Cache() = 0;
    ShmemPerfModel* getShmemPerfModel() { return _shmem_perf_model; }
+   // Clock of the directory of this tile that handles 'address', the clock of
+   // the tile unless the protocol shards its directory over several sim threads
+   virtual ShmemPerfModel* getDirectoryShmemPerfModel(IntPtr address) { return getShmemPerfModel(); }
 
    virtual tile_id_t getShmemRequester(const void* pkt_data) = 0;
 
    virtual void enableModels() = 0;
    virtual void disableModels() = 0;
 
+   // State of the memory system in the checkpoint of the tile (Tile::processCheckpoint())
+   virtual void saveCheckpoint(CheckpointWriter& writer);
+   virtual void restoreCheckpoint(CheckpointReader& reader);
+
    // Modeling
    // getModeledLength() returns the length of the msg in bits
    virtual UInt32 getModeledLength(const void* pkt_data) = 0;
    virtual bool isModeled(const void* pkt_data) = 0;
 
    static CachingProtocolType parseProtocolType(std::string& protocol_type);
+   static CachingProtocolType getCachingProtocolType() { return _caching_protocol_type; }
    static MemoryManager* createMMU(std::string protocol_type,
                                        Tile* tile, Network* network,
                                        ShmemPerfModel* shmem_perf_model);
    
    virtual void outputSummary(std::ostream& os) = 0;
 
+   // Span of a request at the directory in the event trace, from its arrival
+   // to its completion (in cycles of the tile)
+   void traceDirectoryReq(const char* name, IntPtr address, UInt64 arrival_time, UInt64 finish_time);
+
    // Cache line replication trace
    static void openCacheLineReplicationTraceFiles();
    static void closeCacheLineReplicationTraceFiles();
@@ -64,7 +105,14 @@ private:
    Tile* _tile;
    Network* _network;
    ShmemPerfModel* _shmem_perf_model;
-   
+
+   // Placement search of the memory controllers (dram/placement/policy = profile),
+   // computed once per process
+   static bool _optimized_memory_controller_positions_computed;
+   static vector<tile_id_t> _optimized_memory_controller_positions;
+   vector<tile_id_t> optimizeMemoryControllerPositions(const vector<tile_id_t>& initial_positions);
+   void readDramTrafficProfile(const string& filename, vector<UInt64>& traffic);
+
    void parseMemoryControllerList(string& memory_controller_positions,
                                   vector<tile_id_t>& tile_list_from_cfg_file,
                                   SInt32 application_tile_count);
@@ -0,0 +1,231 @@
+#include "mmu.h"
+#include "tlb.h"
+#include "core.h"
+#include "tile.h"
+#include "simulator.h"
+#include "config.h"
+#include "utils.h"
+#include "log.h"
+
+using namespace std;
+
+MMU::MMU(Core* core)
+   : m_core(core)
+   , m_walking(false)
+   , m_num_page_walks(0)
+   , m_num_page_walk_accesses(0)
+   , m_total_page_walk_latency(0)
+   , m_shootdown_pending(false)
+   , m_num_shootdowns(0)
+   , m_num_shootdown_invalidations(0)
+{
+   UInt32 page_size = 0;
+   UInt32 l1_itlb_entries = 0, l1_itlb_associativity = 0;
+   UInt32 l1_dtlb_entries = 0, l1_dtlb_associativity = 0;
+   UInt32 l2_tlb_entries = 0, l2_tlb_associativity = 0;
+   UInt32 page_walk_cache_entries = 0;
+   try
+   {
+      page_size = Sim()->getCfg()->getInt("mmu/page_size", 4096);
+      l1_itlb_entries = Sim()->getCfg()->getInt("mmu/l1_itlb/entries", 64);
+      l1_itlb_associativity = Sim()->getCfg()->getInt("mmu/l1_itlb/associativity", 4);
+      l1_dtlb_entries = Sim()->getCfg()->getInt("mmu/l1_dtlb/entries", 64);
+      l1_dtlb_associativity = Sim()->getCfg()->getInt("mmu/l1_dtlb/associativity", 4);
+      l2_tlb_entries = Sim()->getCfg()->getInt("mmu/l2_tlb/entries", 1536);
+      l2_tlb_associativity = Sim()->getCfg()->getInt("mmu/l2_tlb/associativity", 12);
+      m_l2_tlb_latency = Sim()->getCfg()->getInt("mmu/l2_tlb/latency", 7);
+      page_walk_cache_entries = Sim()->getCfg()->getInt("mmu/page_walk_cache/entries", 32);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read [mmu] parameters from the cfg file");
+   }
+
+   m_page_size_log2 = isPower2(page_size) ? floorLog2(page_size) : 0;
+   LOG_ASSERT_ERROR((m_page_size_log2 >= BASE_PAGE_SIZE_LOG2) &&
+                    (((m_page_size_log2 - BASE_PAGE_SIZE_LOG2) % BITS_PER_LEVEL) == 0) &&
+                    (m_page_size_log2 < BASE_PAGE_SIZE_LOG2 + (NUM_LEVELS - 1) * BITS_PER_LEVEL),
+                    "mmu/page_size(%u) must be 4096 (4 KB), 2097152 (2 MB) or 1073741824 (1 GB)", page_size);
+   m_leaf_level = (m_page_size_log2 - BASE_PAGE_SIZE_LOG2) / BITS_PER_LEVEL;
+
+   m_l1_itlb = new TLB("L1 ITLB", l1_itlb_entries, l1_itlb_associativity);
+   m_l1_dtlb = new TLB("L1 DTLB", l1_dtlb_entries, l1_dtlb_associativity);
+   m_l2_tlb = new TLB("L2 TLB", l2_tlb_entries, l2_tlb_associativity);
+   // Fully associative
+   m_page_walk_cache = new TLB("Page Walk Cache", page_walk_cache_entries, page_walk_cache_entries);
+
+   m_core->getNetwork()->registerCallback(TLB_SHOOTDOWN_TYPE, networkCallback, this);
+}
+
+MMU::~MMU()
+{
+   m_core->getNetwork()->unregisterCallback(TLB_SHOOTDOWN_TYPE);
+   delete m_page_walk_cache;
+   delete m_l2_tlb;
+   delete m_l1_dtlb;
+   delete m_l1_itlb;
+}
+
+bool
+MMU::isEnabled()
+{
+   try
+   {
+      return Sim()->getCfg()->getBool("mmu/enabled", false) && Config::getSingleton()->isSimulatingSharedMemory();
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read mmu/enabled from the cfg file");
+      return false;
+   }
+}
+
+UInt64
+MMU::translate(IntPtr address, UInt32 size, bool instruction, UInt64 time)
+{
+   if (m_shootdown_pending)
+      applyShootdowns();
+
+   UInt64 latency = translatePage(address, instruction, time);
+   // The access spans two pages
+   if ((size > 1) && (((address + size - 1) >> m_page_size_log2) != (address >> m_page_size_log2)))
+      latency += translatePage(address + size - 1, instruction, time + latency);
+   return latency;
+}
+
+UInt64
+MMU::translatePage(IntPtr address, bool instruction, UInt64 time)
+{
+   IntPtr page = address >> m_page_size_log2;
+   TLB* l1_tlb = instruction ? m_l1_itlb : m_l1_dtlb;
+   if (l1_tlb->lookup(page))
+      return 0;
+
+   UInt64 latency = m_l2_tlb_latency;
+   if (!m_l2_tlb->lookup(page))
+   {
+      latency += walk(address, time + latency);
+      m_l2_tlb->insert(page);
+   }
+   l1_tlb->insert(page);
+   return latency;
+}
+
+UInt64
+MMU::walk(IntPtr address, UInt64 time)
+{
+   // Below the lowest upper level entry in the page walk cache
+   UInt32 start_level = NUM_LEVELS - 1;
+   for (UInt32 level = m_leaf_level + 1; level < NUM_LEVELS; level++)
+   {
+      if (m_page_walk_cache->lookup(getWalkCacheKey(level, address)))
+      {
+         start_level = level - 1;
+         break;
+      }
+   }
+
+   m_walking = true;
+   UInt64 curr_time = time;
+   for (SInt32 level = start_level; level >= (SInt32) m_leaf_level; level--)
+   {
+      Byte entry[ENTRY_SIZE];
+      curr_time += m_core->initiateMemoryAccess(MemComponent::L1_DCACHE, Core::NONE, Core::READ,
+                                                getEntryAddress(level, address), entry, ENTRY_SIZE,
+                                                false, curr_time).second;
+      if (level > (SInt32) m_leaf_level)
+         m_page_walk_cache->insert(getWalkCacheKey(level, address));
+      m_num_page_walk_accesses ++;
+   }
+   m_walking = false;
+
+   m_num_page_walks ++;
+   m_total_page_walk_latency += curr_time - time;
+   return curr_time - time;
+}
+
+IntPtr
+MMU::getEntryAddress(UInt32 level, IntPtr address)
+{
+   // The tables of a level are contiguous, indexed by the address bits
+   // above those the level translates
+   IntPtr index = (address & ((1ULL << 48) - 1)) >> (BASE_PAGE_SIZE_LOG2 + level * BITS_PER_LEVEL);
+   return PAGE_TABLE_BASE + (((IntPtr) level) << 40) + index * ENTRY_SIZE;
+}
+
+IntPtr
+MMU::getWalkCacheKey(UInt32 level, IntPtr address)
+{
+   return (((address & ((1ULL << 48) - 1)) >> (BASE_PAGE_SIZE_LOG2 + level * BITS_PER_LEVEL)) << 2) | level;
+}
+
+void
+MMU::sendShootdown(Network* network, IntPtr start, IntPtr end)
+{
+   Shootdown shootdown;
+   shootdown.start = start;
+   shootdown.end = end;
+
+   vector<tile_id_t> receivers;
+   for (tile_id_t tile_id = 0; tile_id < (tile_id_t) Config::getSingleton()->getApplicationTiles(); tile_id++)
+      receivers.push_back(tile_id);
+
+   LOG_PRINT("TLB shootdown of [%#lx, %#lx) to %u tiles", start, end, (UInt32) receivers.size());
+   NetPacket packet(network->getTile()->getCore()->getPerformanceModel()->getCycleCount(), TLB_SHOOTDOWN_TYPE,
+                    network->getTile()->getId(), NetPacket::BROADCAST,
+                    sizeof(shootdown), (const void*) &shootdown);
+   vector<Byte> multicast_bitmap;
+   packet.setMulticastReceivers(receivers, multicast_bitmap);
+   network->netSend(packet);
+}
+
+void
+MMU::networkCallback(void* obj, NetPacket packet)
+{
+   MMU* mmu = (MMU*) obj;
+   LOG_ASSERT_ERROR(packet.length == sizeof(Shootdown), "Unexpected TLB shootdown length(%u)", packet.length);
+   mmu->receiveShootdown(*((Shootdown*) packet.data));
+}
+
+void
+MMU::receiveShootdown(const Shootdown& shootdown)
+{
+   ScopedLock sl(m_shootdown_lock);
+   m_pending_shootdowns.push_back(shootdown);
+   m_shootdown_pending = true;
+}
+
+void
+MMU::applyShootdowns()
+{
+   ScopedLock sl(m_shootdown_lock);
+   for (vector<Shootdown>::iterator it = m_pending_shootdowns.begin(); it != m_pending_shootdowns.end(); it++)
+   {
+      IntPtr begin_page = it->start >> m_page_size_log2;
+      IntPtr end_page = (it->end + (1ULL << m_page_size_log2) - 1) >> m_page_size_log2;
+      m_num_shootdown_invalidations += m_l1_itlb->invalidate(begin_page, end_page);
+      m_num_shootdown_invalidations += m_l1_dtlb->invalidate(begin_page, end_page);
+      m_num_shootdown_invalidations += m_l2_tlb->invalidate(begin_page, end_page);
+      // Like invlpg, the paging structure caches are flushed
+      m_page_walk_cache->invalidate(0, ~((IntPtr) 0));
+      m_num_shootdowns ++;
+   }
+   m_pending_shootdowns.clear();
+   m_shootdown_pending = false;
+}
+
+void
+MMU::outputSummary(ostream& os)
+{
+   os << "  MMU Summary:" << endl;
+   m_l1_itlb->outputSummary(os);
+   m_l1_dtlb->outputSummary(os);
+   m_l2_tlb->outputSummary(os);
+   m_page_walk_cache->outputSummary(os);
+   os << "    Page Walks: " << m_num_page_walks << endl;
+   os << "    Page Walk Accesses: " << m_num_page_walk_accesses << endl;
+   os << "    Average Page Walk Latency (in clock cycles): "
+      << ((m_num_page_walks > 0) ? ((float) m_total_page_walk_latency / m_num_page_walks) : 0.0) << endl;
+   os << "    Shootdowns: " << m_num_shootdowns << endl;
+   os << "    Shootdown Invalidations: " << m_num_shootdown_invalidations << endl;
+}
@@ -0,0 +1,97 @@
+#ifndef MMU_H
+#define MMU_H
+
+#include <vector>
+#include <utility>
+#include <ostream>
+
+#include "fixed_types.h"
+#include "lock.h"
+#include "network.h"
+
+class Core;
+class TLB;
+
+/*
+  Address translation of the accesses of a core ([mmu]). The pages of an
+  access are looked up in the L1 TLB (instruction or data, in parallel with
+  the L1 cache) and then in the L2 TLB ('latency' cycles). An L2 TLB miss
+  walks the page table: a radix tree of 9 bits per level over 48-bit
+  addresses, 4 levels for 4 KB pages (3 for 2 MB, 2 for 1 GB), with one
+  8-byte entry read per level through the caches of the core (as a plain
+  data read, one after the other). The page table is laid out level by level
+  at PAGE_TABLE_BASE, out of the address space of the application. The page
+  walk cache keeps the entries of the upper levels, the walk starts below
+  the lowest one it has.
+
+  munmap (VMManager) multicasts a shootdown of the range to the application
+  tiles. It is queued by the sim thread and applied by the core before its
+  next translation.
+ */
+class MMU
+{
+public:
+   MMU(Core* core);
+   ~MMU();
+
+   // mmu/enabled, with the shared memory
+   static bool isEnabled();
+
+   // Cycles to translate the pages of [address, address + size) at 'time'
+   UInt64 translate(IntPtr address, UInt32 size, bool instruction, UInt64 time);
+   // The page table accesses of a walk are not translated
+   bool isWalking() const { return m_walking; }
+
+   void outputSummary(std::ostream& os);
+
+   // Shootdown of [start, end) in the TLBs of all the application tiles
+   static void sendShootdown(Network* network, IntPtr start, IntPtr end);
+   // TLB_SHOOTDOWN_TYPE packets of the tile network
+   static void networkCallback(void* obj, NetPacket packet);
+
+private:
+   static const IntPtr PAGE_TABLE_BASE = 0xffff800000000000ULL;
+   static const UInt32 NUM_LEVELS = 4;
+   static const UInt32 BITS_PER_LEVEL = 9;
+   static const UInt32 BASE_PAGE_SIZE_LOG2 = 12;
+   static const UInt32 ENTRY_SIZE = 8;
+
+   struct Shootdown
+   {
+      IntPtr start;
+      IntPtr end;
+   };
+
+   Core* m_core;
+   UInt32 m_page_size_log2;
+   // The level of the page table entries that map the pages
+   UInt32 m_leaf_level;
+
+   TLB* m_l1_itlb;
+   TLB* m_l1_dtlb;
+   TLB* m_l2_tlb;
+   UInt32 m_l2_tlb_latency;
+   TLB* m_page_walk_cache;
+
+   bool m_walking;
+   UInt64 m_num_page_walks;
+   UInt64 m_num_page_walk_accesses;
+   UInt64 m_total_page_walk_latency;
+
+   // Shootdowns received by the sim thread, not yet applied
+   Lock m_shootdown_lock;
+   std::vector<Shootdown> m_pending_shootdowns;
+   volatile bool m_shootdown_pending;
+   UInt64 m_num_shootdowns;
+   UInt64 m_num_shootdown_invalidations;
+
+   UInt64 translatePage(IntPtr address, bool instruction, UInt64 time);
+   UInt64 walk(IntPtr address, UInt64 time);
+   static IntPtr getEntryAddress(UInt32 level, IntPtr address);
+   // Key of the entry of an upper level in the page walk cache
+   static IntPtr getWalkCacheKey(UInt32 level, IntPtr address);
+   void receiveShootdown(const Shootdown& shootdown);
+   void applyShootdowns();
+};
+
+#endif
@@ -0,0 +1,118 @@
+#include <algorithm>
+
+#include "cache_bank_model.h"
+#include "simulator.h"
+#include "utils.h"
+#include "log.h"
+
+CacheBankModel::CacheBankModel(UInt32 num_banks, UInt32 num_ports, bool pipelined, bool sequential,
+                               UInt64 data_array_access_time, UInt64 tag_array_access_time, UInt32 line_size)
+   : _enabled(false)
+   , _num_banks(num_banks)
+   , _log_line_size(floorLog2(line_size))
+   , _sequential(sequential)
+   , _tag_array_access_time(tag_array_access_time)
+   , _tag_array_busy_time(pipelined ? 1 : std::max<UInt64>(tag_array_access_time, 1))
+   , _data_array_busy_time(pipelined ? 1 : std::max<UInt64>(data_array_access_time, 1))
+   , _total_accesses(0)
+   , _total_bank_conflicts(0)
+   , _total_port_conflicts(0)
+   , _total_queue_delay(0)
+{
+   LOG_ASSERT_ERROR(num_ports > 0, "Number of ports of a banked slice(%u) must be > 0", num_ports);
+
+   Bank free_bank = { 0, 0 };
+   _banks.resize(_num_banks, free_bank);
+   _port_free_times.resize(num_ports, 0);
+}
+
+CacheBankModel::~CacheBankModel()
+{}
+
+CacheBankModel*
+CacheBankModel::create(string cfg_section, string cache_perf_model_type,
+                       UInt64 data_array_access_time, UInt64 tag_array_access_time, UInt32 line_size)
+{
+   UInt32 num_banks = 0;
+   UInt32 num_ports = 0;
+   bool pipelined = false;
+   try
+   {
+      num_banks = Sim()->getCfg()->getInt(cfg_section + "/num_banks", 0);
+      num_ports = Sim()->getCfg()->getInt(cfg_section + "/num_ports", 1);
+      pipelined = Sim()->getCfg()->getBool(cfg_section + "/pipelined_banks", true);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read [%s] bank parameters from the cfg file", cfg_section.c_str());
+   }
+
+   if (num_banks == 0)
+      return (CacheBankModel*) NULL;
+
+   bool sequential = (CachePerfModel::parseModelType(cache_perf_model_type) == CachePerfModel::CACHE_PERF_MODEL_SEQUENTIAL);
+   return new CacheBankModel(num_banks, num_ports, pipelined, sequential,
+                             data_array_access_time, tag_array_access_time, line_size);
+}
+
+UInt64
+CacheBankModel::computeQueueDelay(IntPtr address, CachePerfModel::CacheAccess_t access, UInt64 time)
+{
+   if (!_enabled)
+      return 0;
+
+   // A port is busy for a cycle with each request
+   vector<UInt64>::iterator port = std::min_element(_port_free_times.begin(), _port_free_times.end());
+   UInt64 port_time = std::max(time, *port);
+   *port = port_time + 1;
+
+   Bank& bank = _banks[(address >> _log_line_size) % _num_banks];
+   UInt64 ready_time = port_time;
+   UInt64 start_time = port_time;
+   if (access != CachePerfModel::ACCESS_CACHE_DATA)
+   {
+      start_time = std::max(port_time, bank.tag_array_free_time);
+      bank.tag_array_free_time = start_time + _tag_array_busy_time;
+   }
+   if (access != CachePerfModel::ACCESS_CACHE_TAGS)
+   {
+      // The data array is read after the tags with a sequential lookup
+      UInt64 data_ready_time = start_time;
+      if (_sequential && (access == CachePerfModel::ACCESS_CACHE_DATA_AND_TAGS))
+      {
+         data_ready_time += _tag_array_access_time;
+         ready_time += _tag_array_access_time;
+      }
+      UInt64 data_start_time = std::max(data_ready_time, bank.data_array_free_time);
+      bank.data_array_free_time = data_start_time + _data_array_busy_time;
+      start_time = data_start_time;
+   }
+
+   UInt64 queue_delay = (port_time - time) + (start_time - ready_time);
+   _total_accesses ++;
+   if (port_time > time)
+      _total_port_conflicts ++;
+   if (start_time > ready_time)
+      _total_bank_conflicts ++;
+   _total_queue_delay += queue_delay;
+   return queue_delay;
+}
+
+void
+CacheBankModel::outputSummary(std::ostream& out)
+{
+   out << "    Banks: " << _num_banks << endl;
+   out << "      Bank Accesses: " << _total_accesses << endl;
+   out << "      Bank Conflict Rate (%): ";
+   if (_total_accesses > 0)
+      out << 100.0 * _total_bank_conflicts / _total_accesses;
+   out << endl;
+   out << "      Port Conflict Rate (%): ";
+   if (_total_accesses > 0)
+      out << 100.0 * _total_port_conflicts / _total_accesses;
+   out << endl;
+   out << "      Average Queue Delay (in cycles): ";
+   if (_total_accesses > 0)
+      out << ((double) _total_queue_delay) / _total_accesses;
+   out << endl;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iostream>
+using std::string;
+using std::vector;
+
+#include "cache_perf_model.h"
+#include "fixed_types.h"
+
+// Contention of the requests of all the tiles for the banks of a shared
+// cache or directory slice ([l2_cache/*] and [dram_directory] num_banks).
+// The lines are interleaved over 'num_banks' banks; each bank has a tag
+// array and a data array that are each busy for an access until a
+// busy-until time. Pipelined arrays start a new access every cycle, the
+// others are busy for their whole access time. The tag and data arrays of
+// a bank overlap like in the perf model of the cache (parallel or
+// sequential). The slice takes at most 'num_ports' requests per cycle.
+// The requests are served in the order the slice processes them, an access
+// waits for the port and the arrays of its bank to be free. O(num_ports)
+// per access.
+class CacheBankModel
+{
+public:
+   CacheBankModel(UInt32 num_banks, UInt32 num_ports, bool pipelined, bool sequential,
+                  UInt64 data_array_access_time, UInt64 tag_array_access_time, UInt32 line_size);
+   ~CacheBankModel();
+
+   // Returns NULL if [cfg_section]/num_banks is 0
+   static CacheBankModel* create(string cfg_section, string cache_perf_model_type,
+                                 UInt64 data_array_access_time, UInt64 tag_array_access_time, UInt32 line_size);
+
+   // Cycles 'access' to the line of 'address', arriving at 'time' (in
+   // cycles), waits for a port and the arrays of its bank
+   UInt64 computeQueueDelay(IntPtr address, CachePerfModel::CacheAccess_t access, UInt64 time);
+
+   void enable()     { _enabled = true;  }
+   void disable()    { _enabled = false; }
+
+   void outputSummary(std::ostream& out);
+
+private:
+   struct Bank
+   {
+      UInt64 tag_array_free_time;
+      UInt64 data_array_free_time;
+   };
+
+   bool _enabled;
+   UInt32 _num_banks;
+   UInt32 _log_line_size;
+   bool _sequential;
+   UInt64 _tag_array_access_time;
+   UInt64 _tag_array_busy_time;
+   UInt64 _data_array_busy_time;
+
+   vector<Bank> _banks;
+   // Cycle each port is free from
+   vector<UInt64> _port_free_times;
+
+   UInt64 _total_accesses;
+   UInt64 _total_bank_conflicts;
+   UInt64 _total_port_conflicts;
+   UInt64 _total_queue_delay;
+};
@@ -0,0 +1,187 @@
+#include <cmath>
+#include <algorithm>
+using namespace std;
+
+#include "simulator.h"
+#include "dram_bank_model.h"
+#include "utils.h"
+#include "log.h"
+
+DramBankModel::DramBankModel(float dram_bandwidth, UInt32 cache_line_size,
+                             bool queue_model_enabled, string queue_model_type)
+   : m_num_accesses(0)
+   , m_num_row_hits(0)
+   , m_num_row_empty(0)
+   , m_num_row_conflicts(0)
+   , m_num_bypassing_row_hits(0)
+{
+   UInt32 row_size = 0;
+   string page_policy;
+   string scheduler;
+   try
+   {
+      m_num_channels = Sim()->getCfg()->getInt("dram/banked/num_channels", 1);
+      m_num_ranks = Sim()->getCfg()->getInt("dram/banked/num_ranks", 1);
+      m_num_banks = Sim()->getCfg()->getInt("dram/banked/num_banks", 8);
+      row_size = Sim()->getCfg()->getInt("dram/banked/row_size", 2048);
+      page_policy = Sim()->getCfg()->getString("dram/banked/page_policy", "open");
+      scheduler = Sim()->getCfg()->getString("dram/banked/scheduler", "fr_fcfs");
+      m_max_bypassing_row_hits = Sim()->getCfg()->getInt("dram/banked/max_row_hits_ahead_of_conflict", 4);
+      m_t_rcd = Sim()->getCfg()->getInt("dram/banked/t_rcd", 15);
+      m_t_cas = Sim()->getCfg()->getInt("dram/banked/t_cas", 15);
+      m_t_rp = Sim()->getCfg()->getInt("dram/banked/t_rp", 15);
+      m_controller_latency = Sim()->getCfg()->getInt("dram/banked/controller_latency", 20);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read [dram/banked] parameters from the cfg file");
+   }
+
+   LOG_ASSERT_ERROR((m_num_channels > 0) && (m_num_ranks > 0) && (m_num_banks > 0),
+                    "Invalid DRAM organization: channels(%u), ranks(%u), banks(%u)",
+                    m_num_channels, m_num_ranks, m_num_banks);
+   LOG_ASSERT_ERROR(isPower2(cache_line_size), "Cache line size(%u) must be a power of 2", cache_line_size);
+   LOG_ASSERT_ERROR((row_size >= cache_line_size) && ((row_size % cache_line_size) == 0),
+                    "DRAM row size(%u) must be a multiple of the cache line size(%u)", row_size, cache_line_size);
+   m_lines_per_row = row_size / cache_line_size;
+   m_cache_line_size_log2 = floorLog2(cache_line_size);
+
+   if (page_policy == "open")
+      m_page_policy = OPEN_PAGE;
+   else if (page_policy == "closed")
+      m_page_policy = CLOSED_PAGE;
+   else
+      LOG_PRINT_ERROR("Unrecognized DRAM page policy(%s), expected open or closed", page_policy.c_str());
+
+   if (scheduler == "fcfs")
+      m_scheduler = FCFS;
+   else if (scheduler == "fr_fcfs")
+      m_scheduler = FR_FCFS;
+   else
+      LOG_PRINT_ERROR("Unrecognized DRAM scheduler(%s), expected fcfs or fr_fcfs", scheduler.c_str());
+
+   // The bandwidth of the controller (in bytes per ns) is split among its channels
+   float channel_bandwidth = dram_bandwidth / m_num_channels;
+   m_t_burst = max<UInt64>((UInt64) ceil(cache_line_size / channel_bandwidth), 1);
+
+   m_banks.resize(m_num_channels * m_num_ranks * m_num_banks);
+   for (vector<Bank>::iterator it = m_banks.begin(); it != m_banks.end(); it++)
+   {
+      (*it).open_row = INVALID_ROW;
+      (*it).closed_row = INVALID_ROW;
+      (*it).closed_row_time = 0;
+      (*it).num_bypassing_row_hits = 0;
+      (*it).queue_model = queue_model_enabled ? QueueModel::create(queue_model_type, m_t_burst) : NULL;
+   }
+   m_channel_queue_models.resize(m_num_channels);
+   for (UInt32 i = 0; i < m_num_channels; i++)
+      m_channel_queue_models[i] = queue_model_enabled ? QueueModel::create(queue_model_type, m_t_burst) : NULL;
+}
+
+DramBankModel::~DramBankModel()
+{
+   for (vector<Bank>::iterator it = m_banks.begin(); it != m_banks.end(); it++)
+      delete (*it).queue_model;
+   for (UInt32 i = 0; i < m_num_channels; i++)
+      delete m_channel_queue_models[i];
+}
+
+UInt64
+DramBankModel::computeQueueDelay(QueueModel* queue_model, UInt64 time, UInt64 processing_time)
+{
+   return queue_model ? queue_model->computeQueueDelay(time, processing_time) : 0;
+}
+
+UInt64
+DramBankModel::getAccessLatency(UInt64 time, IntPtr address, UInt64& queue_delay)
+{
+   // Consecutive lines share a row, consecutive rows go to different channels, then banks
+   UInt64 row = ((UInt64) address >> m_cache_line_size_log2) / m_lines_per_row;
+   UInt32 channel = row % m_num_channels;
+   row /= m_num_channels;
+   UInt32 bank_id = row % (m_num_ranks * m_num_banks);
+   row /= (m_num_ranks * m_num_banks);
+   Bank& bank = m_banks[channel * m_num_ranks * m_num_banks + bank_id];
+
+   bool row_hit = (bank.open_row == row);
+   bool ahead_of_conflict = false;
+   if ( (!row_hit) && (m_scheduler == FR_FCFS) && (bank.closed_row == row) &&
+        (time < bank.closed_row_time) && (bank.num_bypassing_row_hits < m_max_bypassing_row_hits) )
+   {
+      row_hit = true;
+      ahead_of_conflict = true;
+   }
+
+   // Latency until the data is out of the bank, and the time the bank is busy
+   UInt64 command_latency;
+   UInt64 bank_occupancy;
+   if (row_hit)
+   {
+      command_latency = m_t_cas;
+      bank_occupancy = m_t_burst;
+      m_num_row_hits ++;
+   }
+   else if (bank.open_row == INVALID_ROW)
+   {
+      command_latency = m_t_rcd + m_t_cas;
+      bank_occupancy = m_t_rcd + m_t_burst;
+      m_num_row_empty ++;
+   }
+   else
+   {
+      command_latency = m_t_rp + m_t_rcd + m_t_cas;
+      bank_occupancy = m_t_rp + m_t_rcd + m_t_burst;
+      m_num_row_conflicts ++;
+   }
+   // The row is precharged right after the access
+   if (m_page_policy == CLOSED_PAGE)
+      bank_occupancy += m_t_rp;
+
+   UInt64 bank_queue_delay = computeQueueDelay(bank.queue_model, time, bank_occupancy);
+
+   // Update the row buffer
+   if (ahead_of_conflict)
+   {
+      bank.num_bypassing_row_hits ++;
+      m_num_bypassing_row_hits ++;
+   }
+   else if ((!row_hit) && (m_page_policy == OPEN_PAGE))
+   {
+      bank.closed_row = bank.open_row;
+      bank.closed_row_time = time + bank_queue_delay;
+      bank.num_bypassing_row_hits = 0;
+      bank.open_row = row;
+   }
+
+   // Burst on the data bus of the channel
+   UInt64 data_time = time + bank_queue_delay + command_latency;
+   UInt64 channel_queue_delay = computeQueueDelay(m_channel_queue_models[channel], data_time, m_t_burst);
+
+   m_num_accesses ++;
+
+   queue_delay = bank_queue_delay + channel_queue_delay;
+   return m_controller_latency + queue_delay + command_latency + m_t_burst;
+}
+
+void
+DramBankModel::outputSummary(ostream& out)
+{
+   out << "    Row Buffer:" << endl;
+   out << "      Row Hits: " << m_num_row_hits << endl;
+   out << "      Row Empty: " << m_num_row_empty << endl;
+   out << "      Row Conflicts: " << m_num_row_conflicts << endl;
+   out << "      Row Hit Rate (\%): " <<
+      ((m_num_accesses > 0) ? (100.0 * m_num_row_hits / m_num_accesses) : 0.0) << endl;
+   out << "      Row Hits Ahead Of Conflicts: " << m_num_bypassing_row_hits << endl;
+}
+
+void
+DramBankModel::dummyOutputSummary(ostream& out)
+{
+   out << "    Row Buffer:" << endl;
+   out << "      Row Hits: " << endl;
+   out << "      Row Empty: " << endl;
+   out << "      Row Conflicts: " << endl;
+   out << "      Row Hit Rate (\%): " << endl;
+   out << "      Row Hits Ahead Of Conflicts: " << endl;
+}
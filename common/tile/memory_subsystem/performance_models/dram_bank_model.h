@@ -0,0 +1,103 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <iostream>
+using std::vector;
+using std::string;
+using std::ostream;
+
+#include "queue_model.h"
+#include "fixed_types.h"
+
+// Bank-level timing of the DRAM behind one controller (dram/model = banked).
+// The controller has a number of channels, each with its own data bus, and
+// every channel has ranks of banks. Each bank has a row buffer that is either
+// kept open after an access (open page policy) or precharged right away
+// (closed page policy), so an access is a row hit (tCAS), an access to a
+// precharged bank (tRCD + tCAS) or a row conflict (tRP + tRCD + tCAS), plus
+// the burst on the channel data bus.
+//   The occupancy of the banks and the data buses is kept in queue models (of
+// dram/queue_model/type), as the requests do not reach the controller in the
+// order of their simulated time. The row buffers are updated in the order
+// the requests are processed.
+//   With the FR-FCFS scheduler, a request to the row that was closed by a row
+// conflict which has not started yet (in simulated time) would have been
+// picked first by the scheduler, so it is a row hit and the row stays the one
+// of the conflicting request. The number of row hits that can go ahead of a
+// conflict is capped.
+//   All the times are in ns.
+class DramBankModel
+{
+public:
+   DramBankModel(float dram_bandwidth, UInt32 cache_line_size,
+                 bool queue_model_enabled, string queue_model_type);
+   ~DramBankModel();
+
+   // Latency of an access to the line at 'address' that arrives at 'time'.
+   // 'queue_delay' is the part of it spent waiting for the bank and the data bus
+   UInt64 getAccessLatency(UInt64 time, IntPtr address, UInt64& queue_delay);
+
+   void outputSummary(ostream& out);
+   static void dummyOutputSummary(ostream& out);
+
+private:
+   enum PagePolicy
+   {
+      OPEN_PAGE = 0,
+      CLOSED_PAGE
+   };
+
+   enum Scheduler
+   {
+      FCFS = 0,
+      FR_FCFS
+   };
+
+   struct Bank
+   {
+      // Row in the row buffer, INVALID_ROW if precharged
+      UInt64 open_row;
+      // FR-FCFS: row closed by the latest row conflict, and the time the
+      // conflict started
+      UInt64 closed_row;
+      UInt64 closed_row_time;
+      UInt32 num_bypassing_row_hits;
+
+      QueueModel* queue_model;
+   };
+
+   static const UInt64 INVALID_ROW = ~((UInt64) 0);
+
+   // Organization
+   UInt32 m_num_channels;
+   UInt32 m_num_ranks;
+   UInt32 m_num_banks;
+   UInt32 m_lines_per_row;
+   UInt32 m_cache_line_size_log2;
+
+   PagePolicy m_page_policy;
+   Scheduler m_scheduler;
+   UInt32 m_max_bypassing_row_hits;
+
+   // Timing
+   UInt64 m_t_rcd;
+   UInt64 m_t_cas;
+   UInt64 m_t_rp;
+   UInt64 m_t_burst;
+   UInt64 m_controller_latency;
+
+   // Banks of all the ranks and channels, [(channel * num_ranks + rank) * num_banks + bank]
+   vector<Bank> m_banks;
+   // Data bus of each channel
+   vector<QueueModel*> m_channel_queue_models;
+
+   // Performance Counters
+   UInt64 m_num_accesses;
+   UInt64 m_num_row_hits;
+   UInt64 m_num_row_empty;
+   UInt64 m_num_row_conflicts;
+   UInt64 m_num_bypassing_row_hits;
+
+   UInt64 computeQueueDelay(QueueModel* queue_model, UInt64 time, UInt64 processing_time);
+};
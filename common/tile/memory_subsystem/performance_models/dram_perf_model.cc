@@ -6,6 +6,7 @@ using namespace std;
 #include "dram_perf_model.h"
 #include "queue_model_history_list.h"
 #include "queue_model_history_tree.h"
+#include "queue_model_history_list_fast.h"
 
 // Note: Each Dram Controller owns a single DramModel object
 // Hence, m_dram_bandwidth is the bandwidth for a single DRAM controller
@@ -28,8 +29,38 @@ DramPerfModel::DramPerfModel(float dram_access_cost,
    m_cache_block_size(cache_block_size),
    m_queue_model_type(queue_model_type),
    m_queue_model_enabled(queue_model_enabled),
+   m_bank_model(NULL),
+   m_hybrid_model(NULL),
+   m_qos_scheduler(NULL),
    m_enabled(false)
 {
+   std::string model_type;
+   try
+   {
+      model_type = Sim()->getCfg()->getString("dram/model", "simple");
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read dram/model from the cfg file");
+   }
+
+   if (model_type == "banked")
+   {
+      m_bank_model = new DramBankModel(dram_bandwidth, cache_block_size,
+                                       queue_model_enabled, queue_model_type);
+   }
+   else
+   {
+      LOG_ASSERT_ERROR(model_type == "simple", "Unrecognized DRAM model(%s), expected simple or banked",
+                       model_type.c_str());
+   }
+
+   if (HybridMemoryModel::isEnabled())
+      m_hybrid_model = new HybridMemoryModel(dram_bandwidth, cache_block_size,
+                                             queue_model_enabled, queue_model_type);
+
+   m_qos_scheduler = DramQosScheduler::create(dram_bandwidth, cache_block_size);
+
    initializePerformanceCounters();
    createQueueModels();
 }
@@ -37,12 +68,16 @@ DramPerfModel::DramPerfModel(float dram_access_cost,
 DramPerfModel::~DramPerfModel()
 {
    destroyQueueModels();
+   delete m_bank_model;
+   delete m_hybrid_model;
+   delete m_qos_scheduler;
 }
 
 void
 DramPerfModel::createQueueModels()
 {
-   if (m_queue_model_enabled)
+   // The bank model has its own queue models
+   if (m_queue_model_enabled && !m_bank_model)
    {
       UInt64 min_processing_time = (UInt64) ((float) m_cache_block_size / m_dram_bandwidth) + 1;
       m_queue_model = QueueModel::create(m_queue_model_type, min_processing_time);
@@ -56,10 +91,7 @@ DramPerfModel::createQueueModels()
 void
 DramPerfModel::destroyQueueModels()
 {
-   if (m_queue_model_enabled)
-   {
-      delete m_queue_model;
-   }
+   delete m_queue_model;
 }
 
 void
@@ -71,7 +103,7 @@ DramPerfModel::initializePerformanceCounters()
 }
 
 UInt64 
-DramPerfModel::getAccessLatency(UInt64 pkt_time, UInt64 pkt_size)
+DramPerfModel::getAccessLatency(UInt64 pkt_time, UInt64 pkt_size, IntPtr address, tile_id_t requester)
 {
    // pkt_size is in 'Bytes'
    // m_dram_bandwidth is in 'Bytes per clock cycle'
@@ -81,30 +113,53 @@ DramPerfModel::getAccessLatency(UInt64 pkt_time, UInt64 pkt_size)
       return 0;
    }
 
+   // Held back by the QoS scheduler, then served
+   UInt64 qos_delay = m_qos_scheduler ? m_qos_scheduler->getSchedulingDelay(pkt_time, pkt_size, requester) : 0;
+   UInt64 queue_delay = 0;
+   UInt64 access_latency = qos_delay +
+      computeAccessLatency(pkt_time + qos_delay, pkt_size, address, requester, queue_delay);
+   queue_delay += qos_delay;
+   LOG_PRINT("Address(%#lx), Access Latency(%llu), Queue Delay(%llu)", address, access_latency, queue_delay);
+
+   // Update Memory Counters
+   m_num_accesses ++;
+   m_total_access_latency += (double) access_latency;
+   m_total_queueing_delay += (double) queue_delay;
+
+   if (m_qos_scheduler)
+      m_qos_scheduler->recordAccess(requester, access_latency, queue_delay);
+
+   return access_latency;
+}
+
+UInt64
+DramPerfModel::computeAccessLatency(UInt64 pkt_time, UInt64 pkt_size, IntPtr address, tile_id_t requester,
+                                    UInt64& queue_delay)
+{
+   UInt64 migration_latency = 0;
+   if (m_hybrid_model)
+   {
+      bool in_hbm = m_hybrid_model->access(address, migration_latency);
+      if (in_hbm)
+         return migration_latency + m_hybrid_model->getHbmAccessLatency(pkt_time, pkt_size, requester, queue_delay);
+   }
+
+   if (m_bank_model)
+      return migration_latency + m_bank_model->getAccessLatency(pkt_time, address, queue_delay);
+
    UInt64 processing_time = (UInt64) ((float) pkt_size/m_dram_bandwidth) + 1;
    LOG_PRINT("Processing Time(%llu)", processing_time);
 
    // Compute Queue Delay
-   UInt64 queue_delay;
    if (m_queue_model)
    {
-      queue_delay = m_queue_model->computeQueueDelay(pkt_time, processing_time);
+      queue_delay = m_queue_model->computeQueueDelay(pkt_time, processing_time, requester);
    }
    else
    {
       queue_delay = 0;
    }
-   LOG_PRINT("Queue Delay(%llu)", queue_delay);
-   UInt64 access_latency = queue_delay + processing_time + m_dram_access_cost;
-   LOG_PRINT("Access Latency(%llu)", access_latency);
-
-
-   // Update Memory Counters
-   m_num_accesses ++;
-   m_total_access_latency += (double) access_latency;
-   m_total_queueing_delay += (double) queue_delay;
-
-   return access_latency;
+   return migration_latency + queue_delay + processing_time + m_dram_access_cost;
 }
 
 void
@@ -130,8 +185,16 @@ DramPerfModel::outputSummary(ostream& out)
       (float) (m_total_queueing_delay / m_num_accesses) << endl;
 
 
+   if (m_bank_model)
+      m_bank_model->outputSummary(out);
+   if (m_hybrid_model)
+      m_hybrid_model->outputSummary(out);
+   if (m_qos_scheduler)
+      m_qos_scheduler->outputSummary(out);
+
    std::string queue_model_type = Sim()->getCfg()->getString("dram/queue_model/type");
-   if (m_queue_model && ((queue_model_type == "history_list") || (queue_model_type == "history_tree")))
+   if (m_queue_model && ((queue_model_type == "history_list") || (queue_model_type == "history_tree") ||
+                         (queue_model_type == "history_list_fast")))
    {
       out << "    Queue Model:" << endl;
        
@@ -144,6 +207,15 @@ DramPerfModel::outputSummary(ostream& out)
          out << "      Queue Utilization(\%): " << queue_utilization * 100 << endl;
          out << "      Analytical Model Used(\%): " << frac_requests_using_analytical_model * 100 << endl;
       }
+      else if (queue_model_type == "history_list_fast")
+      {
+         float queue_utilization = ((QueueModelHistoryListFast*) m_queue_model)->getQueueUtilization();
+         float frac_requests_using_analytical_model = \
+            ((float) ((QueueModelHistoryListFast*) m_queue_model)->getTotalRequestsUsingAnalyticalModel()) / \
+            ((QueueModelHistoryListFast*) m_queue_model)->getTotalRequests();
+         out << "      Queue Utilization(\%): " << queue_utilization * 100 << endl;
+         out << "      Analytical Model Used(\%): " << frac_requests_using_analytical_model * 100 << endl;
+      }
       else // (queue_model_type == "history_tree")
       {
          float queue_utilization = ((QueueModelHistoryTree*) m_queue_model)->getQueueUtilization();
@@ -163,10 +235,18 @@ DramPerfModel::dummyOutputSummary(ostream& out)
    out << "    Total Dram Accesses: " << endl;
    out << "    Average Dram Access Latency (in ns): " << endl;
    out << "    Average Dram Contention Delay (in ns): " << endl;
+
+   if (Sim()->getCfg()->getString("dram/model", "simple") == "banked")
+      DramBankModel::dummyOutputSummary(out);
+   if (HybridMemoryModel::isEnabled())
+      HybridMemoryModel::dummyOutputSummary(out);
+   if (DramQosScheduler::isEnabled())
+      DramQosScheduler::dummyOutputSummary(out);
    
    bool queue_model_enabled = Sim()->getCfg()->getBool("dram/queue_model/enabled");
    std::string queue_model_type = Sim()->getCfg()->getString("dram/queue_model/type");
-   if (queue_model_enabled && ((queue_model_type == "history_list") || (queue_model_type == "history_tree")))
+   if (queue_model_enabled && ((queue_model_type == "history_list") || (queue_model_type == "history_tree") ||
+                               (queue_model_type == "history_list_fast")))
    {
       out << "    Queue Model:" << endl;
       out << "      Queue Utilization(\%): " << endl;
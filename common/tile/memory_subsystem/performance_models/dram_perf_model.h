@@ -3,6 +3,9 @@
 #include "queue_model.h"
 #include "fixed_types.h"
 #include "moving_average.h"
+#include "dram_bank_model.h"
+#include "hybrid_memory_model.h"
+#include "dram_qos_scheduler.h"
 
 // Note: Each Dram Controller owns a single DramModel object
 // Hence, m_dram_bandwidth is the bandwidth for a single DRAM controller
@@ -15,6 +18,13 @@
 // It sort of increases the queueing delay to a huge value if
 // the arrival times of adjacent packets are spread over a large
 // simulated time period
+// With dram/model = banked, the latency comes from the bank-level model
+// (DramBankModel) instead, and m_dram_access_cost and the queue model
+// above are not used
+// With dram/hybrid/enabled, part of the pages are in an HBM tier
+// (HybridMemoryModel), and only the DDR accesses go through the model above
+// With a [dram/qos] policy, the requests of each tile are first held back by
+// the DramQosScheduler
 class DramPerfModel
 {
    private:
@@ -29,6 +39,13 @@ class DramPerfModel
       QueueModel* m_queue_model;
       std::string m_queue_model_type;
       bool m_queue_model_enabled;
+
+      // Bank-level model, NULL for the simple model
+      DramBankModel* m_bank_model;
+      // HBM + DDR tiers, NULL if not enabled
+      HybridMemoryModel* m_hybrid_model;
+      // NULL without a [dram/qos] policy
+      DramQosScheduler* m_qos_scheduler;
       
       bool m_enabled;
 
@@ -37,6 +54,8 @@ class DramPerfModel
       volatile double m_total_access_latency;
       volatile double m_total_queueing_delay;
 
+      UInt64 computeAccessLatency(UInt64 pkt_time, UInt64 pkt_size, IntPtr address, tile_id_t requester,
+                                  UInt64& queue_delay);
       void createQueueModels();
       void destroyQueueModels();
       void initializePerformanceCounters();
@@ -50,7 +69,9 @@ class DramPerfModel
 
       ~DramPerfModel();
 
-      UInt64 getAccessLatency(UInt64 pkt_time, UInt64 pkt_size);
+      // 'requester' is the tile the access is made for, INVALID_TILE_ID for a writeback
+      UInt64 getAccessLatency(UInt64 pkt_time, UInt64 pkt_size, IntPtr address,
+                              tile_id_t requester = INVALID_TILE_ID);
       void enable();
       void disable();
 
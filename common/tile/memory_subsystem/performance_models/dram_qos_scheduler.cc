@@ -0,0 +1,204 @@
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+using namespace std;
+
+#include "simulator.h"
+#include "config.h"
+#include "dram_qos_scheduler.h"
+#include "utils.h"
+#include "log.h"
+
+DramQosScheduler::DramQosScheduler(Policy policy, float dram_bandwidth, UInt32 cache_line_size)
+   : m_policy(policy)
+   , m_dram_bandwidth(dram_bandwidth)
+   , m_cache_line_size(cache_line_size)
+   , m_batch_id(0)
+   , m_batch_end(0)
+{
+   float core_bandwidth = 0;
+   string core_bandwidths;
+   try
+   {
+      m_marking_cap = Sim()->getCfg()->getInt("dram/qos/marking_cap", 5);
+      core_bandwidth = Sim()->getCfg()->getFloat("dram/qos/core_bandwidth", 0);
+      core_bandwidths = Sim()->getCfg()->getString("dram/qos/core_bandwidths", "");
+      m_bucket_size = Sim()->getCfg()->getInt("dram/qos/bucket_size", 1024);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read [dram/qos] parameters from the cfg file");
+   }
+
+   LOG_ASSERT_ERROR(m_marking_cap > 0, "DRAM QoS marking cap must be > 0");
+
+   UInt32 num_tiles = Config::getSingleton()->getTotalTiles();
+   // An equal share of the controller by default
+   if (core_bandwidth <= 0)
+      core_bandwidth = dram_bandwidth / num_tiles;
+
+   TileState tile_state;
+   tile_state.bucket_time = 0;
+   tile_state.bandwidth = core_bandwidth;
+   tile_state.batch_id = 0;
+   tile_state.num_marked_requests = 0;
+   tile_state.num_accesses = 0;
+   tile_state.total_access_latency = 0;
+   tile_state.total_queue_delay = 0;
+   tile_state.total_qos_delay = 0;
+   m_tiles.resize(num_tiles + 1, tile_state);
+
+   parseCoreBandwidths(core_bandwidths);
+}
+
+DramQosScheduler::~DramQosScheduler()
+{}
+
+DramQosScheduler*
+DramQosScheduler::create(float dram_bandwidth, UInt32 cache_line_size)
+{
+   string policy;
+   try
+   {
+      policy = Sim()->getCfg()->getString("dram/qos/policy", "none");
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read dram/qos/policy from the cfg file");
+   }
+
+   if (policy == "none")
+      return NULL;
+   else if (policy == "fcfs")
+      return new DramQosScheduler(FCFS, dram_bandwidth, cache_line_size);
+   else if (policy == "par_bs")
+      return new DramQosScheduler(PAR_BS, dram_bandwidth, cache_line_size);
+   else if (policy == "token_bucket")
+      return new DramQosScheduler(TOKEN_BUCKET, dram_bandwidth, cache_line_size);
+
+   LOG_PRINT_ERROR("Unrecognized DRAM QoS policy(%s), expected none, fcfs, par_bs or token_bucket",
+                   policy.c_str());
+   return NULL;
+}
+
+bool
+DramQosScheduler::isEnabled()
+{
+   return (Sim()->getCfg()->getString("dram/qos/policy", "none") != "none");
+}
+
+void
+DramQosScheduler::parseCoreBandwidths(string core_bandwidths)
+{
+   // "<tile>:<bandwidth>, ..."
+   vector<string> entries;
+   parseList(core_bandwidths, entries, ",");
+   for (vector<string>::iterator it = entries.begin(); it != entries.end(); it++)
+   {
+      vector<string> fields;
+      parseList(*it, fields, ":");
+      LOG_ASSERT_ERROR(fields.size() == 2, "Malformed DRAM QoS core bandwidth(%s), expected <tile>:<bandwidth>",
+                       (*it).c_str());
+
+      SInt32 tile_id = atoi(fields[0].c_str());
+      LOG_ASSERT_ERROR((tile_id >= 0) && (tile_id < (SInt32) m_tiles.size() - 1),
+                       "Invalid tile(%i) in DRAM QoS core bandwidths", tile_id);
+      m_tiles[tile_id].bandwidth = atof(fields[1].c_str());
+      LOG_ASSERT_ERROR(m_tiles[tile_id].bandwidth > 0, "DRAM QoS bandwidth of tile(%i) must be > 0", tile_id);
+   }
+}
+
+DramQosScheduler::TileState&
+DramQosScheduler::getTileState(tile_id_t requester)
+{
+   if (requester == INVALID_TILE_ID)
+      return m_tiles.back();
+   LOG_ASSERT_ERROR((requester >= 0) && (requester < (tile_id_t) m_tiles.size() - 1),
+                    "Invalid DRAM requester(%i)", requester);
+   return m_tiles[requester];
+}
+
+UInt64
+DramQosScheduler::getSchedulingDelay(UInt64 time, UInt64 pkt_size, tile_id_t requester)
+{
+   if ((m_policy == FCFS) || (requester == INVALID_TILE_ID))
+      return 0;
+
+   TileState& tile_state = getTileState(requester);
+   UInt64 delay = 0;
+
+   if (m_policy == PAR_BS)
+   {
+      if (time >= m_batch_end)
+      {
+         // The previous batch is done, a new one starts
+         m_batch_id ++;
+         m_batch_end = time;
+      }
+      if (tile_state.batch_id != m_batch_id)
+      {
+         tile_state.batch_id = m_batch_id;
+         tile_state.num_marked_requests = 0;
+      }
+
+      if (tile_state.num_marked_requests < m_marking_cap)
+      {
+         tile_state.num_marked_requests ++;
+         m_batch_end += (UInt64) ((float) pkt_size / m_dram_bandwidth) + 1;
+      }
+      else
+      {
+         delay = m_batch_end - time;
+      }
+   }
+   else // (m_policy == TOKEN_BUCKET)
+   {
+      // Generic cell rate algorithm: a request may arrive up to the burst
+      // ahead of its theoretical arrival time (bandwidths in bytes per ns)
+      double burst_time = m_bucket_size / tile_state.bandwidth;
+      double start_time = max((double) time, tile_state.bucket_time - burst_time);
+      tile_state.bucket_time = max(tile_state.bucket_time, start_time) + pkt_size / tile_state.bandwidth;
+      delay = (UInt64) ceil(start_time - (double) time);
+   }
+
+   tile_state.total_qos_delay += delay;
+   return delay;
+}
+
+void
+DramQosScheduler::recordAccess(tile_id_t requester, UInt64 access_latency, UInt64 queue_delay)
+{
+   TileState& tile_state = getTileState(requester);
+   tile_state.num_accesses ++;
+   tile_state.total_access_latency += access_latency;
+   tile_state.total_queue_delay += queue_delay;
+}
+
+void
+DramQosScheduler::outputSummary(ostream& out)
+{
+   out << "    QoS Scheduler:" << endl;
+   for (UInt32 i = 0; i < m_tiles.size(); i++)
+   {
+      TileState& tile_state = m_tiles[i];
+      if (tile_state.num_accesses == 0)
+         continue;
+
+      if (i == m_tiles.size() - 1)
+         out << "      Writebacks:";
+      else
+         out << "      Tile " << i << ":";
+      out << " Accesses " << tile_state.num_accesses;
+      out << ", Average Latency (in ns) " << ((double) tile_state.total_access_latency) / tile_state.num_accesses;
+      out << ", Average QoS Delay (in ns) " << ((double) tile_state.total_qos_delay) / tile_state.num_accesses;
+      UInt64 unloaded_latency = tile_state.total_access_latency - tile_state.total_queue_delay;
+      out << ", Slowdown " << ((unloaded_latency > 0) ?
+                               ((double) tile_state.total_access_latency) / unloaded_latency : 1.0) << endl;
+   }
+}
+
+void
+DramQosScheduler::dummyOutputSummary(ostream& out)
+{
+   out << "    QoS Scheduler:" << endl;
+}
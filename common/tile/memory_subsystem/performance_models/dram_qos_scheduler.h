@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <iostream>
+using std::vector;
+using std::string;
+using std::ostream;
+
+#include "fixed_types.h"
+
+// Request scheduler of a memory controller for performance isolation
+// between the tiles ([dram/qos]). It holds a request back before the DRAM
+// model serves it, by policy:
+//   fcfs: never, the requests are only accounted per tile
+//   par_bs: the batching of PAR-BS. Up to 'marking_cap' requests of each tile
+// are marked in the current batch; the further requests of a tile wait for
+// the end of the batch, which grows by the service time of every marked request
+//   token_bucket: each tile has a bandwidth cap (core_bandwidth, or its
+// core_bandwidths entry) with a burst of 'bucket_size' bytes, the requests
+// over it wait for the tokens
+// The row-buffer aware FR-FCFS scheduler is the one of the banked DRAM model.
+//   The latencies and the queueing delays (QoS delay included) of each tile
+// are reported, with its slowdown: the latency over the one it would have
+// had without any queueing.
+//   The writebacks have no requester, they are never held back. All the
+// times are in ns.
+class DramQosScheduler
+{
+public:
+   enum Policy
+   {
+      FCFS = 0,
+      PAR_BS,
+      TOKEN_BUCKET
+   };
+
+   DramQosScheduler(Policy policy, float dram_bandwidth, UInt32 cache_line_size);
+   ~DramQosScheduler();
+
+   // Reads the [dram/qos] policy, NULL for none
+   static DramQosScheduler* create(float dram_bandwidth, UInt32 cache_line_size);
+   static bool isEnabled();
+
+   // Time the request of 'requester' arriving at 'time' is held back
+   UInt64 getSchedulingDelay(UInt64 time, UInt64 pkt_size, tile_id_t requester);
+   void recordAccess(tile_id_t requester, UInt64 access_latency, UInt64 queue_delay);
+
+   void outputSummary(ostream& out);
+   static void dummyOutputSummary(ostream& out);
+
+private:
+   struct TileState
+   {
+      // token_bucket: theoretical arrival time of the next request
+      double bucket_time;
+      double bandwidth;
+      // par_bs
+      UInt64 batch_id;
+      UInt32 num_marked_requests;
+
+      // Performance Counters
+      UInt64 num_accesses;
+      UInt64 total_access_latency;
+      UInt64 total_queue_delay;
+      UInt64 total_qos_delay;
+   };
+
+   Policy m_policy;
+   float m_dram_bandwidth;
+   UInt32 m_cache_line_size;
+
+   // par_bs
+   UInt32 m_marking_cap;
+   UInt64 m_batch_id;
+   UInt64 m_batch_end;
+
+   // token_bucket
+   UInt32 m_bucket_size;
+
+   // Indexed by tile, the last one is for the writebacks
+   vector<TileState> m_tiles;
+
+   TileState& getTileState(tile_id_t requester);
+   void parseCoreBandwidths(string core_bandwidths);
+};
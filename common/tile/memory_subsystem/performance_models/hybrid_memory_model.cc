@@ -0,0 +1,241 @@
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+using namespace std;
+
+#include "simulator.h"
+#include "config.h"
+#include "hybrid_memory_model.h"
+#include "utils.h"
+#include "log.h"
+
+HybridMemoryModel::HybridMemoryModel(float ddr_bandwidth, UInt32 cache_line_size,
+                                     bool queue_model_enabled, string queue_model_type)
+   : m_num_hbm_pages(0)
+   , m_ddr_bandwidth(ddr_bandwidth)
+   , m_epoch_accesses(0)
+   , m_num_hbm_accesses(0)
+   , m_num_ddr_accesses(0)
+   , m_num_migrations(0)
+   , m_total_migration_latency(0)
+{
+   string policy;
+   string static_ranges;
+   UInt32 hbm_capacity = 0;
+   try
+   {
+      m_hbm_access_cost = (UInt64) Sim()->getCfg()->getFloat("dram/hybrid/hbm_latency", 60);
+      m_hbm_bandwidth = Sim()->getCfg()->getFloat("dram/hybrid/hbm_bandwidth", 25);
+      hbm_capacity = Sim()->getCfg()->getInt("dram/hybrid/hbm_capacity", 64);
+      m_page_size = Sim()->getCfg()->getInt("dram/hybrid/page_size", 4096);
+      policy = Sim()->getCfg()->getString("dram/hybrid/policy", "first_touch");
+      static_ranges = Sim()->getCfg()->getString("dram/hybrid/static_ranges", "");
+      m_epoch = Sim()->getCfg()->getInt("dram/hybrid/epoch", 10000);
+      m_hot_threshold = Sim()->getCfg()->getInt("dram/hybrid/hot_threshold", 16);
+      m_sample_rate = Sim()->getCfg()->getInt("dram/hybrid/sample_rate", 1);
+      m_migration_cost = (UInt64) Sim()->getCfg()->getFloat("dram/hybrid/migration_latency", 1000);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read [dram/hybrid] parameters from the cfg file");
+   }
+
+   LOG_ASSERT_ERROR(isPower2(m_page_size), "Hybrid memory page size(%u) must be a power of 2", m_page_size);
+   LOG_ASSERT_ERROR(m_hbm_bandwidth > 0, "HBM bandwidth(%f) must be > 0", m_hbm_bandwidth);
+   LOG_ASSERT_ERROR((m_epoch > 0) && (m_sample_rate > 0),
+                    "Hybrid memory epoch(%llu) and sample rate(%u) must be > 0", m_epoch, m_sample_rate);
+   m_page_size_log2 = floorLog2(m_page_size);
+   // hbm_capacity is in MB
+   m_hbm_capacity = (((UInt64) hbm_capacity) << 20) >> m_page_size_log2;
+
+   if (policy == "static")
+      m_policy = STATIC;
+   else if (policy == "first_touch")
+      m_policy = FIRST_TOUCH;
+   else if (policy == "hot_page")
+      m_policy = HOT_PAGE;
+   else
+      LOG_PRINT_ERROR("Unrecognized hybrid memory policy(%s), expected static, first_touch or hot_page",
+                      policy.c_str());
+
+   if (m_policy == STATIC)
+      parseStaticRanges(static_ranges);
+
+   UInt64 min_processing_time = (UInt64) ((float) cache_line_size / m_hbm_bandwidth) + 1;
+   m_queue_model = queue_model_enabled ? QueueModel::create(queue_model_type, min_processing_time) : NULL;
+}
+
+HybridMemoryModel::~HybridMemoryModel()
+{
+   delete m_queue_model;
+}
+
+bool
+HybridMemoryModel::isEnabled()
+{
+   try
+   {
+      return Sim()->getCfg()->getBool("dram/hybrid/enabled", false);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read dram/hybrid/enabled from the cfg file");
+      return false;
+   }
+}
+
+void
+HybridMemoryModel::parseStaticRanges(string ranges)
+{
+   // "<start>:<end>, ..." with the end excluded
+   vector<string> range_list;
+   parseList(ranges, range_list, ",");
+   for (vector<string>::iterator it = range_list.begin(); it != range_list.end(); it++)
+   {
+      vector<string> bounds;
+      parseList(*it, bounds, ":");
+      LOG_ASSERT_ERROR(bounds.size() == 2, "Malformed hybrid memory range(%s), expected <start>:<end>",
+                       (*it).c_str());
+
+      AddressRange range;
+      range.start = (IntPtr) strtoull(bounds[0].c_str(), NULL, 0);
+      range.end = (IntPtr) strtoull(bounds[1].c_str(), NULL, 0);
+      LOG_ASSERT_ERROR(range.start < range.end, "Empty hybrid memory range(%s)", (*it).c_str());
+      m_static_ranges.push_back(range);
+   }
+}
+
+bool
+HybridMemoryModel::isInStaticRange(IntPtr address)
+{
+   for (vector<AddressRange>::iterator it = m_static_ranges.begin(); it != m_static_ranges.end(); it++)
+   {
+      if ((address >= (*it).start) && (address < (*it).end))
+         return true;
+   }
+   return false;
+}
+
+bool
+HybridMemoryModel::access(IntPtr address, UInt64& migration_latency)
+{
+   migration_latency = 0;
+
+   UInt64 page_num = ((UInt64) address) >> m_page_size_log2;
+   map<UInt64, Page>::iterator it = m_pages.find(page_num);
+   if (it == m_pages.end())
+   {
+      Page page;
+      if (m_policy == STATIC)
+         page.in_hbm = isInStaticRange(address);
+      else
+         page.in_hbm = (m_num_hbm_pages < m_hbm_capacity);
+      page.access_count = 0;
+      if (page.in_hbm)
+         m_num_hbm_pages ++;
+      it = m_pages.insert(make_pair(page_num, page)).first;
+   }
+
+   bool in_hbm = it->second.in_hbm;
+   if (in_hbm)
+      m_num_hbm_accesses ++;
+   else
+      m_num_ddr_accesses ++;
+
+   if (m_policy == HOT_PAGE)
+   {
+      m_epoch_accesses ++;
+      if ((m_epoch_accesses % m_sample_rate) == 0)
+         it->second.access_count ++;
+      if (m_epoch_accesses == m_epoch)
+      {
+         // The access starts the migrations, and is done from the tier it was in
+         migration_latency = migrateHotPages();
+         m_epoch_accesses = 0;
+      }
+   }
+   return in_hbm;
+}
+
+UInt64
+HybridMemoryModel::migrateHotPages()
+{
+   // Hot DDR pages, hottest first, and HBM pages, coldest first
+   vector< pair<UInt32, UInt64> > hot_pages;
+   vector< pair<UInt32, UInt64> > hbm_pages;
+   for (map<UInt64, Page>::iterator it = m_pages.begin(); it != m_pages.end(); it++)
+   {
+      if (it->second.in_hbm)
+         hbm_pages.push_back(make_pair(it->second.access_count, it->first));
+      else if (it->second.access_count >= m_hot_threshold)
+         hot_pages.push_back(make_pair(it->second.access_count, it->first));
+   }
+   sort(hot_pages.rbegin(), hot_pages.rend());
+   sort(hbm_pages.begin(), hbm_pages.end());
+
+   // A page copy over both tiers (bandwidths in bytes per ns)
+   UInt64 copy_latency = (UInt64) ceil(m_page_size / m_hbm_bandwidth) + (UInt64) ceil(m_page_size / m_ddr_bandwidth);
+
+   UInt64 migration_latency = 0;
+   vector< pair<UInt32, UInt64> >::iterator victim = hbm_pages.begin();
+   for (vector< pair<UInt32, UInt64> >::iterator it = hot_pages.begin(); it != hot_pages.end(); it++)
+   {
+      if (m_num_hbm_pages < m_hbm_capacity)
+      {
+         // Free HBM page
+         m_num_hbm_pages ++;
+         migration_latency += copy_latency + m_migration_cost;
+      }
+      else
+      {
+         // Swap with a colder HBM page
+         if ((victim == hbm_pages.end()) || (victim->first >= it->first))
+            break;
+         m_pages[victim->second].in_hbm = false;
+         victim ++;
+         migration_latency += 2 * copy_latency + m_migration_cost;
+      }
+      m_pages[it->second].in_hbm = true;
+      m_num_migrations ++;
+   }
+
+   for (map<UInt64, Page>::iterator it = m_pages.begin(); it != m_pages.end(); it++)
+      it->second.access_count /= 2;
+
+   m_total_migration_latency += migration_latency;
+   return migration_latency;
+}
+
+UInt64
+HybridMemoryModel::getHbmAccessLatency(UInt64 time, UInt64 pkt_size, tile_id_t requester, UInt64& queue_delay)
+{
+   UInt64 processing_time = (UInt64) ((float) pkt_size / m_hbm_bandwidth) + 1;
+   queue_delay = m_queue_model ? m_queue_model->computeQueueDelay(time, processing_time, requester) : 0;
+   return queue_delay + processing_time + m_hbm_access_cost;
+}
+
+void
+HybridMemoryModel::outputSummary(ostream& out)
+{
+   UInt64 num_accesses = m_num_hbm_accesses + m_num_ddr_accesses;
+   out << "    Hybrid Memory:" << endl;
+   out << "      HBM Accesses: " << m_num_hbm_accesses << endl;
+   out << "      DDR Accesses: " << m_num_ddr_accesses << endl;
+   out << "      HBM Hit Rate (\%): " <<
+      ((num_accesses > 0) ? (100.0 * m_num_hbm_accesses / num_accesses) : 0.0) << endl;
+   out << "      HBM Pages: " << m_num_hbm_pages << endl;
+   out << "      Page Migrations: " << m_num_migrations << endl;
+   out << "      Total Migration Latency (in ns): " << m_total_migration_latency << endl;
+}
+
+void
+HybridMemoryModel::dummyOutputSummary(ostream& out)
+{
+   out << "    Hybrid Memory:" << endl;
+   out << "      HBM Accesses: " << endl;
+   out << "      DDR Accesses: " << endl;
+   out << "      HBM Hit Rate (\%): " << endl;
+   out << "      HBM Pages: " << endl;
+   out << "      Page Migrations: " << endl;
+   out << "      Total Migration Latency (in ns): " << endl;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include <string>
+#include <iostream>
+using std::map;
+using std::vector;
+using std::string;
+using std::ostream;
+
+#include "queue_model.h"
+#include "fixed_types.h"
+
+// Two memory tiers behind one controller ([dram/hybrid]): a small, fast
+// HBM and the DDR of the [dram] model. The memory is managed in pages, and
+// the placement policy decides which pages are in HBM:
+//   static: the pages in the static_ranges address ranges, whatever the capacity
+//   first_touch: the first pages accessed at the controller, up to the capacity
+//   hot_page: first touch, then every 'epoch' accesses the hottest DDR pages
+// are migrated to HBM, in place of the coldest HBM pages. The accesses are
+// counted one in 'sample_rate', and the counts are halved every epoch.
+//   An HBM access costs the HBM latency plus the line transfer at the HBM
+// bandwidth (with a queue model of dram/queue_model/type). A migration is a
+// swap of two pages, so it copies a page each way over both tiers, plus a
+// fixed remapping cost; the access that starts the epoch waits for it.
+//   All the times are in ns.
+class HybridMemoryModel
+{
+public:
+   HybridMemoryModel(float ddr_bandwidth, UInt32 cache_line_size,
+                     bool queue_model_enabled, string queue_model_type);
+   ~HybridMemoryModel();
+
+   // Whether the [dram/hybrid] tiers are enabled
+   static bool isEnabled();
+
+   // Places the page of 'address' and counts the access. Returns whether it
+   // is in HBM, and in 'migration_latency' the time spent migrating pages
+   bool access(IntPtr address, UInt64& migration_latency);
+   // Latency of an HBM access of 'pkt_size' bytes that arrives at 'time'
+   UInt64 getHbmAccessLatency(UInt64 time, UInt64 pkt_size, tile_id_t requester, UInt64& queue_delay);
+
+   void outputSummary(ostream& out);
+   static void dummyOutputSummary(ostream& out);
+
+private:
+   enum Policy
+   {
+      STATIC = 0,
+      FIRST_TOUCH,
+      HOT_PAGE
+   };
+
+   struct Page
+   {
+      bool in_hbm;
+      UInt32 access_count;
+   };
+
+   struct AddressRange
+   {
+      IntPtr start;
+      IntPtr end;
+   };
+
+   Policy m_policy;
+   UInt32 m_page_size;
+   UInt32 m_page_size_log2;
+   UInt64 m_hbm_capacity;   // In pages
+   UInt64 m_num_hbm_pages;
+   vector<AddressRange> m_static_ranges;
+
+   // Timing
+   UInt64 m_hbm_access_cost;
+   float m_hbm_bandwidth;
+   float m_ddr_bandwidth;
+   UInt64 m_migration_cost;
+   QueueModel* m_queue_model;
+
+   // hot_page
+   UInt64 m_epoch;
+   UInt32 m_hot_threshold;
+   UInt32 m_sample_rate;
+   UInt64 m_epoch_accesses;
+
+   map<UInt64, Page> m_pages;
+
+   // Performance Counters
+   UInt64 m_num_hbm_accesses;
+   UInt64 m_num_ddr_accesses;
+   UInt64 m_num_migrations;
+   UInt64 m_total_migration_latency;
+
+   void parseStaticRanges(string ranges);
+   bool isInStaticRange(IntPtr address);
+   UInt64 migrateHotPages();
+};
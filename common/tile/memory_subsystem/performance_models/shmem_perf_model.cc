@@ -6,50 +6,52 @@
 #include "tile_manager.h"
 #include "fxsupport.h"
 
-ShmemPerfModel::ShmemPerfModel()
-   : _cycle_count(0)
+ShmemPerfModel::ShmemPerfModel(UInt32 num_threads)
+   : _thread_state(num_threads)
+   , _curr_thread_idx(0)
    , _enabled(false)
 {
-   initializePerformanceCounters();
+   LOG_ASSERT_ERROR(num_threads > 0, "Number of hardware threads must be > 0");
 }
 
 ShmemPerfModel::~ShmemPerfModel()
 {}
 
 void
-ShmemPerfModel::initializePerformanceCounters()
+ShmemPerfModel::setCurrentThread(UInt32 thread_idx)
 {
-   _num_memory_accesses = 0;
-   _total_memory_access_latency_in_clock_cycles = 0;
-   _total_memory_access_latency_in_ns = 0;
+   LOG_ASSERT_ERROR(thread_idx < _thread_state.size(), "Thread index(%u) out of range, %u hardware threads",
+                    thread_idx, (UInt32) _thread_state.size());
+   _curr_thread_idx = thread_idx;
 }
 
 void 
 ShmemPerfModel::setCycleCount(UInt64 count)
 {
-   LOG_PRINT("setCycleCount: count(%llu)", count);
-   _cycle_count = count;
+   LOG_PRINT("setCycleCount: thread(%u), count(%llu)", _curr_thread_idx, count);
+   _thread_state[_curr_thread_idx].cycle_count = count;
 }
 
 UInt64
 ShmemPerfModel::getCycleCount()
 {
-   return _cycle_count;
+   return _thread_state[_curr_thread_idx].cycle_count;
 }
 
 void
 ShmemPerfModel::updateCycleCount(UInt64 cycle_count)
 {
-   LOG_PRINT("updateCycleCount: cycle_count(%llu)", cycle_count);
-   if (_cycle_count < cycle_count)
-      _cycle_count = cycle_count;
+   LOG_PRINT("updateCycleCount: thread(%u), cycle_count(%llu)", _curr_thread_idx, cycle_count);
+   UInt64& curr_cycle_count = _thread_state[_curr_thread_idx].cycle_count;
+   if (curr_cycle_count < cycle_count)
+      curr_cycle_count = cycle_count;
 }
 
 void
 ShmemPerfModel::incrCycleCount(UInt64 count)
 {
    if (_enabled)
-      _cycle_count += count;
+      _thread_state[_curr_thread_idx].cycle_count += count;
 }
 
 void
@@ -57,27 +59,55 @@ ShmemPerfModel::incrTotalMemoryAccessLatency(UInt64 memory_access_latency)
 {
    if (_enabled)
    {
-      _num_memory_accesses ++;
-      _total_memory_access_latency_in_clock_cycles += memory_access_latency;
+      ThreadState& state = _thread_state[_curr_thread_idx];
+      state.num_memory_accesses ++;
+      state.total_memory_access_latency_in_clock_cycles += memory_access_latency;
+   }
+}
+
+void
+ShmemPerfModel::convertMemoryAccessLatency(volatile float core_frequency)
+{
+   for (UInt32 i = 0; i < _thread_state.size(); i++)
+   {
+      ThreadState& state = _thread_state[i];
+      state.total_memory_access_latency_in_ns +=
+         static_cast<UInt64>(ceil(static_cast<float>(state.total_memory_access_latency_in_clock_cycles) / core_frequency));
+      state.total_memory_access_latency_in_clock_cycles = 0;
    }
 }
 
 void
 ShmemPerfModel::updateInternalVariablesOnFrequencyChange(volatile float core_frequency)
 {
-   _total_memory_access_latency_in_ns +=
-      static_cast<UInt64>(ceil(static_cast<float>(_total_memory_access_latency_in_clock_cycles) / core_frequency));
-   _total_memory_access_latency_in_clock_cycles = 0;
+   convertMemoryAccessLatency(core_frequency);
 }
 
 void
 ShmemPerfModel::outputSummary(ostream& out, volatile float core_frequency)
 {
-   _total_memory_access_latency_in_ns +=
-      static_cast<UInt64>(ceil(static_cast<float>(_total_memory_access_latency_in_clock_cycles) / core_frequency));
+   convertMemoryAccessLatency(core_frequency);
+
+   UInt64 num_memory_accesses = 0;
+   UInt64 total_memory_access_latency_in_ns = 0;
+   for (UInt32 i = 0; i < _thread_state.size(); i++)
+   {
+      num_memory_accesses += _thread_state[i].num_memory_accesses;
+      total_memory_access_latency_in_ns += _thread_state[i].total_memory_access_latency_in_ns;
+   }
    
    out << "Shared Memory Model summary: " << endl;
-   out << "    Total Memory Accesses: " << _num_memory_accesses << endl;
+   out << "    Total Memory Accesses: " << num_memory_accesses << endl;
    out << "    Average Memory Access Latency (in ns): " << 
-      static_cast<float>(_total_memory_access_latency_in_ns) / _num_memory_accesses << endl;
+      static_cast<float>(total_memory_access_latency_in_ns) / num_memory_accesses << endl;
+   if (_thread_state.size() > 1)
+   {
+      for (UInt32 i = 0; i < _thread_state.size(); i++)
+      {
+         const ThreadState& state = _thread_state[i];
+         out << "    Thread " << i << " Memory Accesses: " << state.num_memory_accesses << endl;
+         out << "    Thread " << i << " Average Memory Access Latency (in ns): " <<
+            static_cast<float>(state.total_memory_access_latency_in_ns) / state.num_memory_accesses << endl;
+      }
+   }
 }
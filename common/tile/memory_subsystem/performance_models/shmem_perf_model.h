@@ -1,14 +1,25 @@
 #pragma once
 
 #include <iostream>
+#include <vector>
 using std::ostream;
+using std::vector;
+
+// The cycle count of the memory accesses of a tile and their latency
+// statistics, kept for each hardware thread of the tile
+// (general/max_threads_per_core). The thread of the access being modeled
+// is selected with setCurrentThread() when an app thread initiates it; the
+// sim thread, which completes the access, works on the same thread.
 
 class ShmemPerfModel
 {
 public:
-   ShmemPerfModel();
+   ShmemPerfModel(UInt32 num_threads = 1);
    ~ShmemPerfModel();
 
+   void setCurrentThread(UInt32 thread_idx);
+   UInt32 getCurrentThread()  { return _curr_thread_idx; }
+
    void setCycleCount(UInt64 count);
    UInt64 getCycleCount();
    void incrCycleCount(UInt64 count);
@@ -25,12 +36,24 @@ public:
    void outputSummary(ostream& out, volatile float core_frequency);
 
 private:
-   UInt64 _cycle_count;
+   struct ThreadState
+   {
+      ThreadState()
+         : cycle_count(0)
+         , num_memory_accesses(0)
+         , total_memory_access_latency_in_clock_cycles(0)
+         , total_memory_access_latency_in_ns(0)
+      {}
+
+      UInt64 cycle_count;
+      UInt64 num_memory_accesses;
+      UInt64 total_memory_access_latency_in_clock_cycles;
+      UInt64 total_memory_access_latency_in_ns;
+   };
+
+   vector<ThreadState> _thread_state;
+   UInt32 _curr_thread_idx;
    bool _enabled;
 
-   UInt64 _num_memory_accesses;
-   UInt64 _total_memory_access_latency_in_clock_cycles;
-   UInt64 _total_memory_access_latency_in_ns;
-
-   void initializePerformanceCounters();
+   void convertMemoryAccessLatency(volatile float core_frequency);
 };
@@ -11,6 +11,7 @@ PinMemoryManager::PinMemoryManager(Core* core):
    {
       __attribute(__unused__) int status = posix_memalign ((void**) &m_scratchpad[i], 4 * sizeof (void*), m_scratchpad_size);
       assert (status == 0);
+      m_host_access[i] = false;
    }
 }
 
@@ -22,6 +23,7 @@ PinMemoryManager::redirectMemOp (bool has_lock_prefix, IntPtr tgt_ea, IntPtr siz
 {
    assert (op_num < NUM_ACCESS_TYPES);
    char *scratchpad = m_scratchpad [op_num];
+   m_host_access [op_num] = m_core->isHostStackAccess(tgt_ea, size);
 
    if (is_read)
    {
@@ -44,23 +46,26 @@ PinMemoryManager::redirectMemOp (bool has_lock_prefix, IntPtr tgt_ea, IntPtr siz
       m_core->accessMemory(lock_signal, mem_op_type, tgt_ea, scratchpad, size, true);
 
    }
-   return (carbon_reg_t) scratchpad;
+   return m_host_access [op_num] ? (carbon_reg_t) tgt_ea : (carbon_reg_t) scratchpad;
 }
 
 void 
 PinMemoryManager::completeMemWrite (bool has_lock_prefix, IntPtr tgt_ea, IntPtr size, UInt32 op_num)
 {
-   char *scratchpad = m_scratchpad [op_num];
+   // The instruction wrote either the scratchpad or the stack in place
+   char *buffer = m_host_access [op_num] ? (char*) tgt_ea : m_scratchpad [op_num];
 
    Core::lock_signal_t lock_signal = (has_lock_prefix) ? Core::UNLOCK : Core::NONE;
 
-   m_core->accessMemory (lock_signal, Core::WRITE, tgt_ea, scratchpad, size, true);
+   m_core->accessMemory (lock_signal, Core::WRITE, tgt_ea, buffer, size, true);
 }
 
 carbon_reg_t 
 PinMemoryManager::redirectPushf ( IntPtr tgt_esp, IntPtr size )
 {
    m_saved_esp = tgt_esp;
+   // pushf always writes the scratchpad
+   m_host_access [0] = false;
    return ((carbon_reg_t) m_scratchpad [0]) + size;
 }
 
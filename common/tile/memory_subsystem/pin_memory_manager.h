@@ -22,6 +22,9 @@ class PinMemoryManager
       // pushf and popf
       static const unsigned int m_scratchpad_size = 4 * 1024;
       char *m_scratchpad [NUM_ACCESS_TYPES];
+      // The operand is a stack access the instruction does in host memory
+      // (stack/direct_host_access), the scratchpad is not used
+      bool m_host_access [NUM_ACCESS_TYPES];
       
       // Used to redirect pushf and popf
       carbon_reg_t m_saved_esp;
@@ -6,7 +6,9 @@ namespace PrL1PrL2DramDirectoryMOSI
 enum CacheLevel
 {
    L1,
-   L2
+   L2,
+   // Slices of the shared L3 cache (plain CacheLineInfo, CLEAN or DIRTY)
+   L3
 };
 
 }
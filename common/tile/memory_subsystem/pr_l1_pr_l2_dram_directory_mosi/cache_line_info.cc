@@ -14,6 +14,8 @@ createCacheLineInfo(SInt32 cache_level)
       return new PrL1CacheLineInfo();
    case L2:
       return new PrL2CacheLineInfo();
+   case L3:
+      return new CacheLineInfo();
    default:
       LOG_PRINT_ERROR("Unrecognized Cache Level(%u)", cache_level);
       return (CacheLineInfo*) NULL;
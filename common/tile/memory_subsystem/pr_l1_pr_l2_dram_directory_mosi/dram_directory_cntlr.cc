@@ -15,9 +15,12 @@ DramDirectoryCntlr::DramDirectoryCntlr(MemoryManager* memory_manager,
       UInt32 dram_directory_max_hw_sharers,
       string dram_directory_type_str,
       UInt32 num_dram_cntlrs,
-      string dram_directory_access_time_str)
+      string dram_directory_access_time_str,
+      bool owner_forwarding)
    : _memory_manager(memory_manager)
    , _dram_cntlr(dram_cntlr)
+   , _l3_cache_cntlr(NULL)
+   , _forward_ex_reqs(owner_forwarding)
    , _enabled(false)
 {
    _dram_directory_cache = new DirectoryCache(_memory_manager->getTile(),
@@ -35,6 +38,9 @@ DramDirectoryCntlr::DramDirectoryCntlr(MemoryManager* memory_manager,
    _cached_data_list = new DataList(cache_line_size);
 
    _directory_type = DirectoryEntry::parseDirectoryType(dram_directory_type_str);
+   // The requester of a forwarded SH_REQ becomes a sharer next to the owner
+   _forward_sh_reqs = owner_forwarding &&
+                      ((_directory_type != LIMITED_NO_BROADCAST) || (dram_directory_max_hw_sharers > 1));
 
    // Update Counters
    initializeEventCounters();
@@ -61,7 +67,7 @@ DramDirectoryCntlr::handleMsgFromL2Cache(tile_id_t sender, ShmemMsg* shmem_msg)
          IntPtr address = shmem_msg->getAddress();
          
          // Add request onto a queue
-         ShmemReq* shmem_req = new ShmemReq(shmem_msg, msg_time);
+         ShmemReq* shmem_req = new (_shmem_req_pool.allocate()) ShmemReq(shmem_msg, msg_time);
          _dram_directory_req_queue_list->enqueue(address, shmem_req);
 
          if (_dram_directory_req_queue_list->count(address) == 1)
@@ -100,6 +106,14 @@ DramDirectoryCntlr::handleMsgFromL2Cache(tile_id_t sender, ShmemMsg* shmem_msg)
       processWbRepFromL2Cache(sender, shmem_msg);
       break;
 
+   case ShmemMsg::FWD_NACK_REP:
+      processFwdNackRepFromL2Cache(sender, shmem_msg);
+      break;
+
+   case ShmemMsg::UNBLOCK_REP:
+      processUnblockRepFromL2Cache(sender, shmem_msg);
+      break;
+
    default:
       LOG_PRINT_ERROR("Unrecognized Shmem Msg Type: %u", shmem_msg_type);
       break;
@@ -121,9 +135,14 @@ DramDirectoryCntlr::processNextReqFromL2Cache(IntPtr address)
 
    // Update latency counters
    updateShmemReqLatencyCounters(completed_shmem_req);
+   ShmemMsg::Type completed_type = completed_shmem_req->getShmemMsg()->getType();
+   getMemoryManager()->traceDirectoryReq((completed_type == ShmemMsg::EX_REQ) ? "EX_REQ" :
+                                         (completed_type == ShmemMsg::SH_REQ) ? "SH_REQ" : "NULLIFY_REQ",
+                                         address, completed_shmem_req->getArrivalTime(),
+                                         completed_shmem_req->getProcessingFinishTime());
 
    // Delete the completed shmem req
-   delete completed_shmem_req;
+   _shmem_req_pool.release(completed_shmem_req);
 
    // No longer should any data be cached for this address
    assert(_cached_data_list->lookup(address) == NULL);
@@ -191,7 +210,7 @@ DramDirectoryCntlr::processDirectoryEntryAllocationReq(ShmemReq* shmem_req)
    ShmemMsg nullify_msg(ShmemMsg::NULLIFY_REQ, MemComponent::DRAM_DIRECTORY, MemComponent::DRAM_DIRECTORY,
                         requester, INVALID_TILE_ID, false, replaced_address, msg_modeled);
 
-   ShmemReq* nullify_req = new ShmemReq(&nullify_msg, msg_time);
+   ShmemReq* nullify_req = new (_shmem_req_pool.allocate()) ShmemReq(&nullify_msg, msg_time);
    _dram_directory_req_queue_list->enqueue(replaced_address, nullify_req);
 
    assert(_dram_directory_req_queue_list->count(replaced_address) == 1);
@@ -318,11 +337,19 @@ DramDirectoryCntlr::processExReqFromL2Cache(ShmemReq* shmem_req, DirectoryEntry*
    {
    case DirectoryState::MODIFIED:
       {
-         // FLUSH_REQ to Owner
-         ShmemMsg shmem_msg(ShmemMsg::FLUSH_REQ, MemComponent::DRAM_DIRECTORY, MemComponent::L2_CACHE,
-               requester, INVALID_TILE_ID, false, address,
-               msg_modeled);
-         getMemoryManager()->sendMsg(directory_entry->getOwner(), shmem_msg);
+         if (_forward_ex_reqs && (directory_entry->getOwner() != requester))
+         {
+            // The owner sends the data to the requester
+            forwardShmemReqToOwner(ShmemMsg::FWD_FLUSH_REQ, shmem_req, directory_entry);
+         }
+         else
+         {
+            // FLUSH_REQ to Owner
+            ShmemMsg shmem_msg(ShmemMsg::FLUSH_REQ, MemComponent::DRAM_DIRECTORY, MemComponent::L2_CACHE,
+                  requester, INVALID_TILE_ID, false, address,
+                  msg_modeled);
+            getMemoryManager()->sendMsg(directory_entry->getOwner(), shmem_msg);
+         }
       }
       break;
 
@@ -442,12 +469,20 @@ DramDirectoryCntlr::processShReqFromL2Cache(ShmemReq* shmem_req, DirectoryEntry*
    {
    case DirectoryState::MODIFIED:
       {
-         ShmemMsg shmem_msg(ShmemMsg::WB_REQ, MemComponent::DRAM_DIRECTORY, MemComponent::L2_CACHE,
-               requester, INVALID_TILE_ID, false, address,
-               msg_modeled);
-         getMemoryManager()->sendMsg(directory_entry->getOwner(), shmem_msg);
+         if (_forward_sh_reqs && (directory_entry->getOwner() != requester))
+         {
+            // The owner sends the data to the requester and keeps the line OWNED
+            forwardShmemReqToOwner(ShmemMsg::FWD_WB_REQ, shmem_req, directory_entry);
+         }
+         else
+         {
+            ShmemMsg shmem_msg(ShmemMsg::WB_REQ, MemComponent::DRAM_DIRECTORY, MemComponent::L2_CACHE,
+                  requester, INVALID_TILE_ID, false, address,
+                  msg_modeled);
+            getMemoryManager()->sendMsg(directory_entry->getOwner(), shmem_msg);
 
-         shmem_req->setSharerTileId(directory_entry->getOwner());
+            shmem_req->setSharerTileId(directory_entry->getOwner());
+         }
       }
       break;
 
@@ -577,7 +612,7 @@ DramDirectoryCntlr::retrieveDataAndSendToL2Cache(ShmemMsg::Type reply_msg_type,
       // I have to get the data from DRAM
       Byte data_buf[getCacheLineSize()];
       
-      _dram_cntlr->getDataFromDram(address, data_buf, msg_modeled);
+      getDataFromDram(address, receiver, data_buf, msg_modeled);
       
       ShmemMsg shmem_msg(reply_msg_type, MemComponent::DRAM_DIRECTORY, MemComponent::L2_CACHE,
             receiver, INVALID_TILE_ID, false, address,
@@ -648,6 +683,24 @@ DramDirectoryCntlr::processFlushRepFromL2Cache(tile_id_t sender, const ShmemMsg*
    LOG_ASSERT_ERROR(curr_dstate != DirectoryState::UNCACHED,
          "Address(%#lx), State(%u)", address, curr_dstate);
 
+   if (_dram_directory_req_queue_list->count(address) > 0)
+   {
+      ShmemReq* shmem_req = _dram_directory_req_queue_list->front(address);
+      if (shmem_req->isForwarded())
+      {
+         // The owner evicted the line before the forward reached it (it NACKs),
+         // or after it sent it OWNED to the requester (that unblocks)
+         LOG_ASSERT_ERROR(sender == shmem_req->getSharerTileId(),
+               "Address(%#lx), FLUSH_REP, sender(%i), forwarded to owner(%i)",
+               address, sender, shmem_req->getSharerTileId());
+
+         _cached_data_list->insert(address, shmem_msg->getDataBuf());
+         if (shmem_req->isForwardNacked())
+            restartNackedShmemReq(shmem_req, directory_entry);
+         return;
+      }
+   }
+
    switch (curr_dstate)
    {
    case DirectoryState::MODIFIED:
@@ -786,6 +839,148 @@ DramDirectoryCntlr::processWbRepFromL2Cache(tile_id_t sender, const ShmemMsg* sh
    }
 }
 
+void
+DramDirectoryCntlr::processFwdNackRepFromL2Cache(tile_id_t sender, const ShmemMsg* shmem_msg)
+{
+   IntPtr address = shmem_msg->getAddress();
+
+   DirectoryEntry* directory_entry = _dram_directory_cache->getDirectoryEntry(address);
+   assert(directory_entry);
+
+   LOG_ASSERT_ERROR(_dram_directory_req_queue_list->count(address) > 0,
+         "Address(%#lx), FWD_NACK_REP, req queue empty!!", address);
+
+   ShmemReq* shmem_req = _dram_directory_req_queue_list->front(address);
+   LOG_ASSERT_ERROR(shmem_req->isForwarded() && (sender == shmem_req->getSharerTileId()),
+         "Address(%#lx), FWD_NACK_REP, sender(%i), forwarded(%s) to owner(%i)",
+         address, sender, shmem_req->isForwarded() ? "true" : "false", shmem_req->getSharerTileId());
+
+   // The FLUSH_REP of the eviction may still be on its way
+   shmem_req->setForwardNacked();
+   if (_cached_data_list->lookup(address) != NULL)
+      restartNackedShmemReq(shmem_req, directory_entry);
+}
+
+void
+DramDirectoryCntlr::processUnblockRepFromL2Cache(tile_id_t sender, const ShmemMsg* shmem_msg)
+{
+   IntPtr address = shmem_msg->getAddress();
+
+   DirectoryEntry* directory_entry = _dram_directory_cache->getDirectoryEntry(address);
+   assert(directory_entry);
+
+   DirectoryBlockInfo* directory_block_info = directory_entry->getDirectoryBlockInfo();
+
+   LOG_ASSERT_ERROR(_dram_directory_req_queue_list->count(address) > 0,
+         "Address(%#lx), UNBLOCK_REP, req queue empty!!", address);
+
+   ShmemReq* shmem_req = _dram_directory_req_queue_list->front(address);
+   LOG_ASSERT_ERROR(shmem_req->isForwarded() && (sender == shmem_req->getShmemMsg()->getRequester()),
+         "Address(%#lx), UNBLOCK_REP, sender(%i), forwarded(%s) for requester(%i)",
+         address, sender, shmem_req->isForwarded() ? "true" : "false", shmem_req->getShmemMsg()->getRequester());
+   LOG_ASSERT_ERROR(directory_block_info->getDState() == DirectoryState::MODIFIED,
+         "Address(%#lx), UNBLOCK_REP, State(%u)", address, directory_block_info->getDState());
+
+   tile_id_t owner = shmem_req->getSharerTileId();
+   shmem_req->setForwarded(false);
+   shmem_req->setSharerTileId(INVALID_TILE_ID);
+
+   // Data of an eviction of the owner that raced with the forward
+   Byte* evicted_data_buf = _cached_data_list->lookup(address);
+   bool add_result = false;
+
+   switch (shmem_req->getShmemMsg()->getType())
+   {
+   case ShmemMsg::EX_REQ:
+      // The owner invalidated its copy when forwarding it
+      LOG_ASSERT_ERROR(evicted_data_buf == NULL, "Address(%#lx), EX_REQ, owner(%i) evicted a forwarded line",
+            address, owner);
+
+      removeSharer(directory_entry, owner, false);
+      add_result = addSharer(directory_entry, sender);
+      directory_entry->setOwner(sender);
+      break;
+
+   case ShmemMsg::SH_REQ:
+      add_result = addSharer(directory_entry, sender);
+      if (evicted_data_buf != NULL)
+      {
+         // The OWNED copy was evicted since, DRAM gets the data
+         removeSharer(directory_entry, owner, false);
+         directory_entry->setOwner(INVALID_TILE_ID);
+         directory_block_info->setDState(DirectoryState::SHARED);
+
+         sendDataToDram(address, evicted_data_buf, shmem_msg->isModeled());
+         _cached_data_list->erase(address);
+      }
+      else
+      {
+         directory_block_info->setDState(DirectoryState::OWNED);
+      }
+      break;
+
+   default:
+      LOG_PRINT_ERROR("Unrecognized request type(%u)", shmem_req->getShmemMsg()->getType());
+      break;
+   }
+
+   LOG_ASSERT_ERROR(add_result, "Address(%#lx), UNBLOCK_REP, could not add sharer(%i)", address, sender);
+
+   // Process Next Request
+   processNextReqFromL2Cache(address);
+}
+
+void
+DramDirectoryCntlr::forwardShmemReqToOwner(ShmemMsg::Type fwd_msg_type, ShmemReq* shmem_req, DirectoryEntry* directory_entry)
+{
+   // The directory entry is updated when the requester unblocks it, the
+   // owner may have evicted the line meanwhile
+   tile_id_t owner = directory_entry->getOwner();
+   ShmemMsg* req_msg = shmem_req->getShmemMsg();
+
+   ShmemMsg shmem_msg(fwd_msg_type, MemComponent::DRAM_DIRECTORY, MemComponent::L2_CACHE,
+         req_msg->getRequester(), INVALID_TILE_ID, false, req_msg->getAddress(),
+         req_msg->isModeled());
+   getMemoryManager()->sendMsg(owner, shmem_msg);
+
+   shmem_req->setSharerTileId(owner);
+   shmem_req->setForwarded(true);
+
+   if (_enabled)
+   {
+      if (fwd_msg_type == ShmemMsg::FWD_FLUSH_REQ)
+         _total_forwarded_exreq ++;
+      else
+         _total_forwarded_shreq ++;
+   }
+}
+
+void
+DramDirectoryCntlr::restartNackedShmemReq(ShmemReq* shmem_req, DirectoryEntry* directory_entry)
+{
+   // The FLUSH_REP of the owner completes the request as without forwarding
+   IntPtr address = shmem_req->getShmemMsg()->getAddress();
+   tile_id_t owner = shmem_req->getSharerTileId();
+   DirectoryBlockInfo* directory_block_info = directory_entry->getDirectoryBlockInfo();
+
+   LOG_ASSERT_ERROR((directory_block_info->getDState() == DirectoryState::MODIFIED) && (directory_entry->getOwner() == owner),
+         "Address(%#lx), State(%u), owner(%i), forwarded to(%i)",
+         address, directory_block_info->getDState(), directory_entry->getOwner(), owner);
+
+   shmem_req->setForwarded(false);
+   removeSharer(directory_entry, owner, false);
+   directory_entry->setOwner(INVALID_TILE_ID);
+   directory_block_info->setDState(DirectoryState::UNCACHED);
+
+   if (_enabled)
+      _total_nacked_forwards ++;
+
+   if (shmem_req->getShmemMsg()->getType() == ShmemMsg::SH_REQ)
+      sendDataToDram(address, _cached_data_list->lookup(address), shmem_req->getShmemMsg()->isModeled());
+
+   restartShmemReq(owner, shmem_req, directory_entry);
+}
+
 void 
 DramDirectoryCntlr::restartShmemReq(tile_id_t sender, ShmemReq* shmem_req, DirectoryEntry* directory_entry)
 {
@@ -824,11 +1019,23 @@ DramDirectoryCntlr::restartShmemReq(tile_id_t sender, ShmemReq* shmem_req, Direc
    }
 }
 
+void
+DramDirectoryCntlr::getDataFromDram(IntPtr address, tile_id_t requester, Byte* data_buf, bool msg_modeled)
+{
+   if (_l3_cache_cntlr)
+      _l3_cache_cntlr->getDataFromDram(address, data_buf, msg_modeled, requester);
+   else
+      _dram_cntlr->getDataFromDram(address, data_buf, msg_modeled, requester);
+}
+
 void
 DramDirectoryCntlr::sendDataToDram(IntPtr address, Byte* data_buf, bool msg_modeled)
 {
    // Write data to Dram
-   _dram_cntlr->putDataToDram(address, data_buf, msg_modeled);
+   if (_l3_cache_cntlr)
+      _l3_cache_cntlr->putDataToDram(address, data_buf, msg_modeled);
+   else
+      _dram_cntlr->putDataToDram(address, data_buf, msg_modeled);
 }
 
 void
@@ -859,6 +1066,11 @@ DramDirectoryCntlr::initializeEventCounters()
    _total_nullifyreq_serialization_time = 0;
    _total_nullifyreq_processing_time = 0;
 
+   // Owner forwarding counters
+   _total_forwarded_exreq = 0;
+   _total_forwarded_shreq = 0;
+   _total_nacked_forwards = 0;
+
    // Invalidation Counters
    _total_invalidations_unicast_mode = 0;
    _total_invalidations_broadcast_mode = 0;
@@ -1017,15 +1229,18 @@ DramDirectoryCntlr::updateInvalidationLatencyCounters(bool initial_broadcast_mod
 bool
 DramDirectoryCntlr::addSharer(DirectoryEntry* directory_entry, tile_id_t sharer_id)
 {
-   _dram_directory_cache->getDirectory()->updateSharerStats(directory_entry->getNumSharers(), directory_entry->getNumSharers() + 1);
-   return directory_entry->addSharer(sharer_id);
+   SInt32 old_sharer_count = directory_entry->getNumSharers();
+   bool add_result = directory_entry->addSharer(sharer_id);
+   Directory::updateSharerStats(old_sharer_count, directory_entry->getNumSharers());
+   return add_result;
 }
 
 void
 DramDirectoryCntlr::removeSharer(DirectoryEntry* directory_entry, tile_id_t sharer_id, bool reply_expected)
 {
-   _dram_directory_cache->getDirectory()->updateSharerStats(directory_entry->getNumSharers(), directory_entry->getNumSharers() - 1);
+   SInt32 old_sharer_count = directory_entry->getNumSharers();
    directory_entry->removeSharer(sharer_id, reply_expected);
+   Directory::updateSharerStats(old_sharer_count, directory_entry->getNumSharers());
 }
 
 void
@@ -1096,6 +1311,10 @@ DramDirectoryCntlr::outputSummary(ostream& out)
       out << "    Average Nullify Request Processing Time: " << endl;
    }
 
+   out << "    Owner Forwarded Requests - Exclusive: " << _total_forwarded_exreq << endl;
+   out << "    Owner Forwarded Requests - Shared: " << _total_forwarded_shreq << endl;
+   out << "    Owner Forwarded Requests - NACKed: " << _total_nacked_forwards << endl;
+
    out << "    Total Invalidation Requests - Unicast Mode: " << _total_invalidations_unicast_mode << endl;
    if (_total_invalidations_unicast_mode > 0)
    {
@@ -1156,6 +1375,10 @@ DramDirectoryCntlr::dummyOutputSummary(ostream& out)
    out << "    Average Nullify Request Serialization Time: " << endl;
    out << "    Average Nullify Request Processing Time: " << endl;
 
+   out << "    Owner Forwarded Requests - Exclusive: " << endl;
+   out << "    Owner Forwarded Requests - Shared: " << endl;
+   out << "    Owner Forwarded Requests - NACKed: " << endl;
+
    out << "    Total Invalidation Requests - Unicast Mode: " << endl;
    out << "    Average Sharers Invalidated - Unicast Mode: " << endl;
    out << "    Average Invalidation Processing Time - Unicast Mode: " << endl;
@@ -11,7 +11,9 @@ namespace PrL1PrL2DramDirectoryMOSI
 
 #include "directory_cache.h"
 #include "hash_map_queue.h"
+#include "object_pool.h"
 #include "dram_cntlr.h"
+#include "l3_cache_cntlr.h"
 #include "address_home_lookup.h"
 #include "shmem_req.h"
 #include "shmem_msg.h"
@@ -31,12 +33,15 @@ namespace PrL1PrL2DramDirectoryMOSI
                          UInt32 dram_directory_max_hw_sharers,
                          string dram_directory_type_str,
                          UInt32 num_dram_cntlrs,
-                         string dram_directory_access_time_str);
+                         string dram_directory_access_time_str,
+                         bool owner_forwarding);
       ~DramDirectoryCntlr();
 
       void handleMsgFromL2Cache(tile_id_t sender, ShmemMsg* shmem_msg);
 
       DirectoryCache* getDramDirectoryCache() { return _dram_directory_cache; }
+      // The DRAM accesses go through the L3 cache slice when there is one
+      void setL3CacheCntlr(L3CacheCntlr* l3_cache_cntlr) { _l3_cache_cntlr = l3_cache_cntlr; }
      
       void enable() { _enabled = true; }
       void disable() { _enabled = false; }
@@ -64,13 +69,20 @@ namespace PrL1PrL2DramDirectoryMOSI
       MemoryManager* _memory_manager;
       DirectoryCache* _dram_directory_cache;
       DramCntlr* _dram_cntlr;
+      L3CacheCntlr* _l3_cache_cntlr;
 
       // Type of directory - (full_map, limited_broadcast, limited_no_broadcast, ackwise, limitless)
       DirectoryType _directory_type;
 
       HashMapQueue<IntPtr,ShmemReq*>* _dram_directory_req_queue_list;
+      // Storage of the queued ShmemReqs, recycled
+      ObjectPool<ShmemReq> _shmem_req_pool;
       DataList* _cached_data_list;
 
+      // The owner of a MODIFIED line sends it to the requester (3-hop)
+      bool _forward_ex_reqs;
+      bool _forward_sh_reqs;
+
       bool _enabled;
 
       // Event Counters
@@ -96,6 +108,10 @@ namespace PrL1PrL2DramDirectoryMOSI
       UInt64 _total_nullifyreq_serialization_time;
       UInt64 _total_nullifyreq_processing_time;
 
+      UInt64 _total_forwarded_exreq;
+      UInt64 _total_forwarded_shreq;
+      UInt64 _total_nacked_forwards;
+
       UInt64 _total_invalidations_unicast_mode;
       UInt64 _total_sharers_invalidated_unicast_mode;
       UInt64 _total_invalidation_processing_time_unicast_mode;
@@ -120,6 +136,11 @@ namespace PrL1PrL2DramDirectoryMOSI
       void processInvRepFromL2Cache(tile_id_t sender, const ShmemMsg* shmem_msg);
       void processFlushRepFromL2Cache(tile_id_t sender, const ShmemMsg* shmem_msg);
       void processWbRepFromL2Cache(tile_id_t sender, const ShmemMsg* shmem_msg);
+      void processFwdNackRepFromL2Cache(tile_id_t sender, const ShmemMsg* shmem_msg);
+      void processUnblockRepFromL2Cache(tile_id_t sender, const ShmemMsg* shmem_msg);
+      void forwardShmemReqToOwner(ShmemMsg::Type fwd_msg_type, ShmemReq* shmem_req, DirectoryEntry* directory_entry);
+      void restartNackedShmemReq(ShmemReq* shmem_req, DirectoryEntry* directory_entry);
+      void getDataFromDram(IntPtr address, tile_id_t requester, Byte* data_buf, bool msg_modeled);
       void sendDataToDram(IntPtr address, Byte* data_buf, bool msg_modeled);
    
       void sendShmemMsg(ShmemMsg::Type requester_msg_type, ShmemMsg::Type send_msg_type, IntPtr address,
@@ -18,9 +18,12 @@ L1CacheCntlr::L1CacheCntlr(MemoryManager* memory_manager,
                            string L1_dcache_replacement_policy,
                            UInt32 L1_dcache_access_delay,
                            bool L1_dcache_track_miss_types,
+                           UInt32 write_combining_buffer_entries,
+                           UInt32 write_combining_drain_latency,
                            float frequency)
    : _memory_manager(memory_manager)
    , _L2_cache_cntlr(NULL)
+   , _write_combining_buffer(NULL)
 {
    _L1_icache_replacement_policy_obj = 
       CacheReplacementPolicy::create(L1_icache_replacement_policy, L1_icache_size, L1_icache_associativity, cache_line_size);
@@ -55,10 +58,17 @@ L1CacheCntlr::L1CacheCntlr(MemoryManager* memory_manager,
          L1_dcache_access_delay,
          frequency,
          L1_dcache_track_miss_types);
+
+   if (write_combining_buffer_entries > 0)
+   {
+      _write_combining_buffer = new WriteCombiningBuffer(write_combining_buffer_entries, cache_line_size,
+                                                         write_combining_drain_latency);
+   }
 }
 
 L1CacheCntlr::~L1CacheCntlr()
 {
+   delete _write_combining_buffer;
    delete _L1_icache;
    delete _L1_dcache;
    delete _L1_icache_replacement_policy_obj;
@@ -87,6 +97,10 @@ L1CacheCntlr::processMemOpFromTile(MemComponent::Type mem_component,
    bool L1_cache_hit = true;
    UInt32 access_num = 0;
 
+   // An atomic sees the earlier stores in the L2 cache
+   if (lock_signal == Core::LOCK)
+      drainWriteCombiningBuffer(true);
+
    while(1)
    {
       access_num ++;
@@ -117,6 +131,10 @@ L1CacheCntlr::processMemOpFromTile(MemComponent::Type mem_component,
       if (lock_signal == Core::UNLOCK)
          LOG_PRINT_ERROR("Expected to find address(%#lx) in L1 Cache", ca_address);
 
+      // The L2 cache may evict or refill a line with stores in the
+      // write-combining buffer
+      drainWriteCombiningBuffer(false);
+
       pair<bool,Cache::MissType> L2_cache_miss_info = _L2_cache_cntlr->processShmemRequestFromL1Cache(mem_component, mem_op_type, ca_address);
       bool L2_cache_miss = L2_cache_miss_info.first;
       if (!L2_cache_miss)
@@ -166,13 +184,98 @@ L1CacheCntlr::accessCache(MemComponent::Type mem_component,
    case Core::WRITE:
       L1_cache->accessCacheLine(ca_address + offset, Cache::STORE, data_buf, data_length);
       // Write-through cache - Write the L2 Cache also
-      _L2_cache_cntlr->writeCacheLine(ca_address, offset, data_buf, data_length);
+      writeL2CacheLine(ca_address, offset, data_buf, data_length);
       break;
 
    default:
       LOG_PRINT_ERROR("Unsupported Mem Op Type: %u", mem_op_type);
       break;
    }
+
+   // The line utilization of the L2 cache counts the accesses to its copy
+   _L2_cache_cntlr->getL2Cache()->markAccessedWords(ca_address + offset, data_length);
+}
+
+void
+L1CacheCntlr::writeL2CacheLine(IntPtr ca_address, UInt32 offset, Byte* data_buf, UInt32 data_length)
+{
+   if (!_write_combining_buffer)
+   {
+      _L2_cache_cntlr->writeCacheLine(ca_address, offset, data_buf, data_length);
+      return;
+   }
+
+   bool modeled = _L1_dcache->isEnabled();
+   if (!_write_combining_buffer->write(ca_address, offset, data_buf, data_length, modeled))
+   {
+      // All the entries are taken, wait for the oldest line to start draining
+      UInt64 curr_time = getShmemPerfModel()->getCycleCount();
+      UInt64 start_time = drainWriteCombiningLine(_write_combining_buffer->getOldestAddress(), curr_time);
+      if (getShmemPerfModel()->isEnabled())
+      {
+         _write_combining_buffer->countStall(start_time - curr_time, modeled);
+         getShmemPerfModel()->updateCycleCount(start_time);
+      }
+
+      bool written = _write_combining_buffer->write(ca_address, offset, data_buf, data_length, modeled);
+      LOG_ASSERT_ERROR(written, "Write-combining buffer full after draining a line");
+   }
+}
+
+UInt64
+L1CacheCntlr::drainWriteCombiningLine(IntPtr address, UInt64 time)
+{
+   Byte data_buf[getCacheLineSize()];
+   vector<bool> written;
+   bool removed = _write_combining_buffer->remove(address, data_buf, written);
+   LOG_ASSERT_ERROR(removed, "Address(%#lx) not in the write-combining buffer", address);
+
+   // One L2 cache write per run of written bytes
+   UInt32 num_writes = 0;
+   UInt32 offset = 0;
+   while (offset < written.size())
+   {
+      if (!written[offset])
+      {
+         offset ++;
+         continue;
+      }
+      UInt32 end = offset;
+      while ((end < written.size()) && written[end])
+         end ++;
+      _L2_cache_cntlr->writeCacheLine(address, offset, &data_buf[offset], end - offset);
+      num_writes ++;
+      offset = end;
+   }
+
+   bool modeled = _L1_dcache->isEnabled();
+   _write_combining_buffer->countL2Writes(num_writes, modeled);
+   return _write_combining_buffer->drain(time, modeled);
+}
+
+void
+L1CacheCntlr::drainWriteCombiningBuffer(bool wait_for_drain)
+{
+   if (!_write_combining_buffer || _write_combining_buffer->isEmpty())
+      return;
+
+   UInt64 curr_time = getShmemPerfModel()->getCycleCount();
+   while (!_write_combining_buffer->isEmpty())
+      drainWriteCombiningLine(_write_combining_buffer->getOldestAddress(), curr_time);
+
+   UInt64 completion_time = _write_combining_buffer->getDrainCompletionTime();
+   if (wait_for_drain && getShmemPerfModel()->isEnabled() && (completion_time > curr_time))
+   {
+      _write_combining_buffer->countStall(completion_time - curr_time, _L1_dcache->isEnabled());
+      getShmemPerfModel()->updateCycleCount(completion_time);
+   }
+}
+
+void
+L1CacheCntlr::outputSummary(std::ostream& out)
+{
+   if (_write_combining_buffer)
+      _write_combining_buffer->outputSummary(out);
 }
 
 bool
@@ -19,6 +19,7 @@ namespace PrL1PrL2DramDirectoryMOSI
 #include "shmem_perf_model.h"
 #include "cache_replacement_policy.h"
 #include "cache_hash_fn.h"
+#include "write_combining_buffer.h"
 
 namespace PrL1PrL2DramDirectoryMOSI
 {
@@ -37,6 +38,8 @@ namespace PrL1PrL2DramDirectoryMOSI
                    string L1_dcache_replacement_policy,
                    UInt32 L1_dcache_access_delay,
                    bool L1_dcache_track_miss_types,
+                   UInt32 write_combining_buffer_entries,
+                   UInt32 write_combining_drain_latency,
                    float frequency);
       ~L1CacheCntlr();
 
@@ -60,6 +63,13 @@ namespace PrL1PrL2DramDirectoryMOSI
       void setCacheLineState(MemComponent::Type mem_component, IntPtr address, CacheState::Type cstate);
       void invalidateCacheLine(MemComponent::Type mem_component, IntPtr address);
 
+      // Write the lines in the write-combining buffer to the L2 cache. Before
+      // the L2 cache handles a msg, on an L1 miss and before an atomic (the
+      // only one that waits for the lines to drain)
+      void drainWriteCombiningBuffer(bool wait_for_drain);
+
+      void outputSummary(std::ostream& out);
+
    private:
       MemoryManager* _memory_manager;
       Cache* _L1_icache;
@@ -69,11 +79,16 @@ namespace PrL1PrL2DramDirectoryMOSI
       CacheHashFn* _L1_icache_hash_fn_obj;
       CacheHashFn* _L1_dcache_hash_fn_obj;
       L2CacheCntlr* _L2_cache_cntlr;
+      // NULL: every store is written through to the L2 cache
+      WriteCombiningBuffer* _write_combining_buffer;
 
       void accessCache(MemComponent::Type mem_component,
             Core::mem_op_t mem_op_type, 
             IntPtr ca_address, UInt32 offset,
             Byte* data_buf, UInt32 data_length);
+      void writeL2CacheLine(IntPtr ca_address, UInt32 offset,
+            Byte* data_buf, UInt32 data_length);
+      UInt64 drainWriteCombiningLine(IntPtr address, UInt64 time);
       bool operationPermissibleinL1Cache(MemComponent::Type mem_component, 
             IntPtr address, Core::mem_op_t mem_op_type,
             UInt32 access_num);
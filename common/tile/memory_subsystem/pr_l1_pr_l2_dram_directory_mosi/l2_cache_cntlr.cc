@@ -1,6 +1,9 @@
 #include "l1_cache_cntlr.h"
 #include "l2_cache_cntlr.h"
 #include "memory_manager.h"
+#include "tile.h"
+#include "core.h"
+#include "spin_detector.h"
 #include "log.h"
 
 namespace PrL1PrL2DramDirectoryMOSI
@@ -259,6 +262,11 @@ void
 L2CacheCntlr::handleMsgFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_msg)
 {
    ShmemMsg::Type shmem_msg_type = shmem_msg->getType();
+
+   // The line may be read, invalidated or evicted with stores in the
+   // write-combining buffer of the L1-D cache
+   _L1_cache_cntlr->drainWriteCombiningBuffer(false);
+
    switch (shmem_msg_type)
    {
    case ShmemMsg::EX_REP:
@@ -282,6 +290,10 @@ L2CacheCntlr::handleMsgFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_msg)
    case ShmemMsg::INV_FLUSH_COMBINED_REQ:
       processInvFlushCombinedReqFromDramDirectory(sender, shmem_msg);
       break;
+   case ShmemMsg::FWD_FLUSH_REQ:
+   case ShmemMsg::FWD_WB_REQ:
+      processFwdReqFromDramDirectory(sender, shmem_msg);
+      break;
    default:
       LOG_PRINT_ERROR("Unrecognized msg type: %u", shmem_msg_type);
       break;
@@ -310,6 +322,24 @@ L2CacheCntlr::handleMsgFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_msg)
    }
 }
 
+void
+L2CacheCntlr::handleMsgFromL2Cache(tile_id_t sender, ShmemMsg* shmem_msg)
+{
+   LOG_ASSERT_ERROR((shmem_msg->getType() == ShmemMsg::EX_REP) || (shmem_msg->getType() == ShmemMsg::SH_REP),
+                    "Address(%#lx), forwarded msg type(%s)", shmem_msg->getAddress(), SPELL_SHMSG(shmem_msg->getType()));
+
+   // The directory waits for the line to get here before it handles the
+   // next request for it
+   ShmemMsg send_shmem_msg(ShmemMsg::UNBLOCK_REP, MemComponent::L2_CACHE, MemComponent::DRAM_DIRECTORY
+                          , getTileId(), INVALID_TILE_ID, false, shmem_msg->getAddress()
+                          , shmem_msg->isModeled()
+                          );
+   getMemoryManager()->sendMsg(getHome(shmem_msg->getAddress()), send_shmem_msg);
+
+   // Same as a reply of the directory
+   handleMsgFromDramDirectory(sender, shmem_msg);
+}
+
 void
 L2CacheCntlr::processExRepFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_msg)
 {
@@ -383,6 +413,10 @@ L2CacheCntlr::processInvReqFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_m
    _L2_cache->getCacheLineInfo(address, &L2_cache_line_info);
    CacheState::Type cstate = L2_cache_line_info.getCState();
 
+   // A spin loop of the core may be polling the line (core/spin_detection)
+   if (cstate != CacheState::INVALID)
+      notifySpinDetector();
+
    if (cstate != CacheState::INVALID)
    {
       assert(cstate == CacheState::SHARED);
@@ -433,6 +467,10 @@ L2CacheCntlr::processFlushReqFromDramDirectory(tile_id_t sender, ShmemMsg* shmem
    _L2_cache->getCacheLineInfo(address, &L2_cache_line_info);
    CacheState::Type cstate = L2_cache_line_info.getCState();
 
+   // A spin loop of the core may be polling the line (core/spin_detection)
+   if (cstate != CacheState::INVALID)
+      notifySpinDetector();
+
    if (cstate != CacheState::INVALID)
    {
       // Update Shared Mem perf counters for access to L2 Cache
@@ -538,6 +576,65 @@ L2CacheCntlr::processInvFlushCombinedReqFromDramDirectory(tile_id_t sender, Shme
    }
 }
 
+void
+L2CacheCntlr::processFwdReqFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_msg)
+{
+   IntPtr address = shmem_msg->getAddress();
+   bool flush = (shmem_msg->getType() == ShmemMsg::FWD_FLUSH_REQ);
+
+   PrL2CacheLineInfo L2_cache_line_info;
+   _L2_cache->getCacheLineInfo(address, &L2_cache_line_info);
+   CacheState::Type cstate = L2_cache_line_info.getCState();
+
+   if (cstate != CacheState::INVALID)
+   {
+      LOG_ASSERT_ERROR(cstate == CacheState::MODIFIED, "Address(%#lx), %s, State(%u)",
+                       address, SPELL_SHMSG(shmem_msg->getType()), cstate);
+
+      // Update Shared Mem perf counters for access to L2 Cache
+      getMemoryManager()->incrCycleCount(MemComponent::L2_CACHE, CachePerfModel::ACCESS_CACHE_DATA_AND_TAGS);
+      // Update Shared Mem perf counters for access to L1 Cache
+      getMemoryManager()->incrCycleCount(L2_cache_line_info.getCachedLoc(), CachePerfModel::ACCESS_CACHE_TAGS);
+
+      Byte data_buf[getCacheLineSize()];
+      readCacheLine(address, data_buf);
+
+      if (flush)
+      {
+         // MODIFIED -> INVALID
+         updateInvalidationCounters();
+         invalidateCacheLineInL1(L2_cache_line_info.getCachedLoc(), address);
+         invalidateCacheLine(address, L2_cache_line_info);
+      }
+      else
+      {
+         // MODIFIED -> OWNED
+         setCacheLineStateInL1(L2_cache_line_info.getCachedLoc(), address, CacheState::OWNED);
+         L2_cache_line_info.setCState(CacheState::OWNED);
+         _L2_cache->setCacheLineInfo(address, &L2_cache_line_info);
+      }
+
+      // The data goes to the requester, that unblocks the directory
+      ShmemMsg send_shmem_msg(flush ? ShmemMsg::EX_REP : ShmemMsg::SH_REP, MemComponent::L2_CACHE, MemComponent::L2_CACHE
+                             , shmem_msg->getRequester(), INVALID_TILE_ID, false, address
+                             , data_buf, getCacheLineSize(), shmem_msg->isModeled()
+                             );
+      getMemoryManager()->sendMsg(shmem_msg->getRequester(), send_shmem_msg);
+   }
+   else
+   {
+      // Update Shared Mem perf counters for access to L2 Cache
+      getMemoryManager()->incrCycleCount(MemComponent::L2_CACHE, CachePerfModel::ACCESS_CACHE_TAGS);
+
+      // Evicted, the FLUSH_REP of the eviction gives the data to the directory
+      ShmemMsg send_shmem_msg(ShmemMsg::FWD_NACK_REP, MemComponent::L2_CACHE, MemComponent::DRAM_DIRECTORY
+                             , shmem_msg->getRequester(), INVALID_TILE_ID, false, address
+                             , shmem_msg->isModeled()
+                             );
+      getMemoryManager()->sendMsg(sender, send_shmem_msg);
+   }
+}
+
 void
 L2CacheCntlr::updateInvalidationCounters()
 {
@@ -636,4 +733,12 @@ L2CacheCntlr::getShmemPerfModel()
    return _memory_manager->getShmemPerfModel();
 }
 
+void
+L2CacheCntlr::notifySpinDetector()
+{
+   SpinDetector* spin_detector = getMemoryManager()->getTile()->getCore()->getSpinDetector();
+   if (spin_detector)
+      spin_detector->notifyInvalidation(getShmemPerfModel()->getCycleCount());
+}
+
 }
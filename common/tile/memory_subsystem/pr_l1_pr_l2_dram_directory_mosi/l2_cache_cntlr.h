@@ -49,6 +49,8 @@ namespace PrL1PrL2DramDirectoryMOSI
       void handleMsgFromL1Cache(ShmemMsg* shmem_msg);
       // Handle message from Dram Dir
       void handleMsgFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_msg);
+      // Handle the reply forwarded by the owner of the line
+      void handleMsgFromL2Cache(tile_id_t sender, ShmemMsg* shmem_msg);
       // Output summary
       void outputSummary(ostream& out);
 
@@ -105,6 +107,7 @@ namespace PrL1PrL2DramDirectoryMOSI
       void processFlushReqFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_msg);
       void processWbReqFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_msg);
       void processInvFlushCombinedReqFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_msg);
+      void processFwdReqFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_msg);
 
       void processBufferedShmemReqFromDramDirectory();
 
@@ -113,6 +116,8 @@ namespace PrL1PrL2DramDirectoryMOSI
       UInt32 getCacheLineSize();
       MemoryManager* getMemoryManager()         { return _memory_manager; }
       ShmemPerfModel* getShmemPerfModel();
+      // An invalidation or flush from the directory may release a spin loop
+      void notifySpinDetector();
 
       // Dram Directory Home Lookup
       tile_id_t getHome(IntPtr address)
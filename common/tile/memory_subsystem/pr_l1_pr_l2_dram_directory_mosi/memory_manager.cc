@@ -11,12 +11,13 @@ namespace PrL1PrL2DramDirectoryMOSI
 {
 
 // Static variables
-ofstream MemoryManager::_cache_line_replication_file;
+TraceFile MemoryManager::_cache_line_replication_file;
 
 MemoryManager::MemoryManager(Tile* tile, Network* network, ShmemPerfModel* shmem_perf_model)
    : ::MemoryManager(tile, network, shmem_perf_model)
    , _dram_directory_cntlr(NULL)
    , _dram_cntlr(NULL)
+   , _l3_cache_cntlr(NULL)
    , _dram_cntlr_present(false)
    , _enabled(false)
 {
@@ -64,6 +65,9 @@ MemoryManager::MemoryManager(Tile* tile, Network* network, ShmemPerfModel* shmem
    bool dram_queue_model_enabled = false;
    std::string dram_queue_model_type;
 
+   UInt32 write_combining_buffer_entries = 0;
+   bool owner_forwarding = false;
+
    try
    {
       // L1 ICache
@@ -118,6 +122,12 @@ MemoryManager::MemoryManager(Tile* tile, Network* network, ShmemPerfModel* shmem
       // SHARED_MEM_1 is used to communicate messages from L2_CACHE to DRAM_DIRECTORY
       // SHARED_MEM_2 is used to communicate messages from DRAM_DIRECTORY to L2_CACHE
       _switch_networks = Sim()->getCfg()->getBool("caching_protocol/pr_L1_pr_L2_dram_directory_mosi/switch_networks");
+
+      // Stores merged on their way from the L1-D cache to the L2 cache
+      write_combining_buffer_entries = Sim()->getCfg()->getInt("caching_protocol/pr_L1_pr_L2_dram_directory_mosi/write_combining_buffer_entries", 0);
+
+      // The owner of a MODIFIED line sends it to the requester (3-hop)
+      owner_forwarding = Sim()->getCfg()->getBool("caching_protocol/pr_L1_pr_L2_dram_directory_mosi/owner_forwarding", false);
    }
    catch(...)
    {
@@ -159,10 +169,24 @@ MemoryManager::MemoryManager(Tile* tile, Network* network, ShmemPerfModel* shmem
             dram_directory_max_hw_sharers,
             dram_directory_type_str,
             num_memory_controllers,
-            dram_directory_access_time_str);
+            dram_directory_access_time_str,
+            owner_forwarding);
+
+      string l3_cache_type = L3CacheCntlr::getType();
+      if (l3_cache_type != "none")
+      {
+         _l3_cache_cntlr = new L3CacheCntlr(this,
+               _dram_cntlr,
+               PR_L1_PR_L2_DRAM_DIRECTORY_MOSI,
+               L3,
+               l3_cache_type,
+               getCacheLineSize(),
+               core_frequency);
+         _dram_directory_cntlr->setL3CacheCntlr(_l3_cache_cntlr);
+      }
    }
 
-   _dram_directory_home_lookup = new AddressHomeLookup(dram_directory_home_lookup_param, tile_list_with_memory_controllers, getCacheLineSize());
+   _dram_directory_home_lookup = new AddressHomeLookup(dram_directory_home_lookup_param, tile_list_with_memory_controllers, getCacheLineSize(), getTile()->getId());
 
    _L1_cache_cntlr = new L1CacheCntlr(this,
          getCacheLineSize(),
@@ -176,6 +200,8 @@ MemoryManager::MemoryManager(Tile* tile, Network* network, ShmemPerfModel* shmem
          L1_dcache_replacement_policy,
          L1_dcache_data_access_time,
          L1_dcache_track_miss_types,
+         write_combining_buffer_entries,
+         L2_cache_data_access_time,
          core_frequency);
    
    _L2_cache_cntlr = new L2CacheCntlr(this,
@@ -199,6 +225,11 @@ MemoryManager::MemoryManager(Tile* tile, Network* network, ShmemPerfModel* shmem
    _L2_cache_perf_model = CachePerfModel::create(L2_cache_perf_model_type,
          L2_cache_data_access_time, L2_cache_tags_access_time, core_frequency);
 
+   // Counters of the stats file
+   _L1_cache_cntlr->getL1ICache()->registerStatistics(getTile()->getId());
+   _L1_cache_cntlr->getL1DCache()->registerStatistics(getTile()->getId());
+   _L2_cache_cntlr->getL2Cache()->registerStatistics(getTile()->getId());
+
    // Register Call-backs
    getNetwork()->registerCallback(SHARED_MEM_1, MemoryManagerNetworkCallback, this);
    getNetwork()->registerCallback(SHARED_MEM_2, MemoryManagerNetworkCallback, this);
@@ -221,6 +252,7 @@ MemoryManager::~MemoryManager()
    {
       delete _dram_cntlr;
       delete _dram_directory_cntlr;
+      delete _l3_cache_cntlr;
    }
 }
 
@@ -252,7 +284,10 @@ void
 MemoryManager::handleMsgFromNetwork(NetPacket& packet)
 {
    core_id_t sender = packet.sender;
-   ShmemMsg* shmem_msg = ShmemMsg::getShmemMsg((Byte*) packet.data);
+   // The msg (and its data) is read in place, the packet is kept until it is handled
+   ShmemMsg packet_shmem_msg;
+   ShmemMsg::getShmemMsg((Byte*) packet.data, &packet_shmem_msg);
+   ShmemMsg* shmem_msg = &packet_shmem_msg;
    UInt64 msg_time = packet.time;
 
    MemComponent::Type receiver_mem_component = shmem_msg->getReceiverMemComponent();
@@ -284,6 +319,10 @@ MemoryManager::handleMsgFromNetwork(NetPacket& packet)
             _L2_cache_cntlr->handleMsgFromDramDirectory(sender.tile_id, shmem_msg);
             break;
 
+         case MemComponent::L2_CACHE:
+            _L2_cache_cntlr->handleMsgFromL2Cache(sender.tile_id, shmem_msg);
+            break;
+
          default:
             LOG_PRINT_ERROR("Unrecognized sender component(%u)",
                   sender_mem_component);
@@ -313,17 +352,6 @@ MemoryManager::handleMsgFromNetwork(NetPacket& packet)
       break;
    }
 
-   // Delete the allocated Shared Memory Message
-   // First delete 'data_buf' if it is present
-   // LOG_PRINT("Finished handling Shmem Msg");
-
-   if (shmem_msg->getDataLength() > 0)
-   {
-      assert(shmem_msg->getDataBuf());
-      delete [] shmem_msg->getDataBuf();
-   }
-   delete shmem_msg;
-
    // Release lock
    _lock.release();
 }
@@ -333,7 +361,7 @@ MemoryManager::sendMsg(tile_id_t receiver, ShmemMsg& shmem_msg)
 {
    assert((shmem_msg.getDataBuf() == NULL) == (shmem_msg.getDataLength() == 0));
 
-   Byte* msg_buf = shmem_msg.makeMsgBuf();
+   ShmemMsgBuf<ShmemMsg> msg_buf(shmem_msg);
    UInt64 msg_time = getShmemPerfModel()->getCycleCount();
 
    LOG_PRINT("Time(%llu), Sending Msg: type(%s), address(%#llx), "
@@ -346,11 +374,8 @@ MemoryManager::sendMsg(tile_id_t receiver, ShmemMsg& shmem_msg)
 
    NetPacket packet(msg_time, packet_type,
          getTile()->getId(), receiver,
-         shmem_msg.getMsgLen(), (const void*) msg_buf);
+         shmem_msg.getMsgLen(), (const void*) msg_buf.getBuf());
    getNetwork()->netSend(packet);
-
-   // Delete the Msg Buf
-   delete [] msg_buf;
 }
 
 void
@@ -358,7 +383,7 @@ MemoryManager::broadcastMsg(ShmemMsg& shmem_msg)
 {
    assert((shmem_msg.getDataBuf() == NULL) == (shmem_msg.getDataLength() == 0));
 
-   Byte* msg_buf = shmem_msg.makeMsgBuf();
+   ShmemMsgBuf<ShmemMsg> msg_buf(shmem_msg);
    UInt64 msg_time = getShmemPerfModel()->getCycleCount();
 
    LOG_PRINT("Time(%llu), Broadcasting Msg: type(%s), address(%#llx), "
@@ -371,11 +396,8 @@ MemoryManager::broadcastMsg(ShmemMsg& shmem_msg)
 
    NetPacket packet(msg_time, packet_type,
          getTile()->getId(), NetPacket::BROADCAST,
-         shmem_msg.getMsgLen(), (const void*) msg_buf);
+         shmem_msg.getMsgLen(), (const void*) msg_buf.getBuf());
    getNetwork()->netSend(packet);
-
-   // Delete the Msg Buf
-   delete [] msg_buf;
 }
 
 PacketType
@@ -390,6 +412,9 @@ MemoryManager::getPacketType(MemComponent::Type sender_mem_component, MemCompone
       }
       else if (sender_mem_component == MemComponent::L2_CACHE)
       {
+         // The replies forwarded by the owners travel with the replies of the directory
+         if (receiver_mem_component == MemComponent::L2_CACHE)
+            return SHARED_MEM_2;
          assert(receiver_mem_component == MemComponent::DRAM_DIRECTORY);
          return SHARED_MEM_1;
       }
@@ -457,6 +482,8 @@ MemoryManager::enableModels()
       _dram_directory_cntlr->enable();
       _dram_directory_cntlr->getDramDirectoryCache()->enable();
       _dram_cntlr->getDramPerfModel()->enable();
+      if (_l3_cache_cntlr)
+         _l3_cache_cntlr->enable();
    }
 }
 
@@ -481,6 +508,8 @@ MemoryManager::disableModels()
       _dram_directory_cntlr->disable();
       _dram_directory_cntlr->getDramDirectoryCache()->disable();
       _dram_cntlr->getDramPerfModel()->disable();
+      if (_l3_cache_cntlr)
+         _l3_cache_cntlr->disable();
    }
 }
 
@@ -492,12 +521,18 @@ MemoryManager::outputSummary(std::ostream &os)
    _L1_cache_cntlr->getL1DCache()->outputSummary(os);
    _L2_cache_cntlr->getL2Cache()->outputSummary(os);
    _L2_cache_cntlr->outputSummary(os);
+   _L1_cache_cntlr->outputSummary(os);
 
    if (_dram_cntlr_present)
    {
       _dram_directory_cntlr->outputSummary(os);
       os << "Dram Directory Cache Summary:\n";
       _dram_directory_cntlr->getDramDirectoryCache()->outputSummary(os);
+      if (_l3_cache_cntlr)
+      {
+         os << "L3 Cache Summary:\n";
+         _l3_cache_cntlr->outputSummary(os);
+      }
       _dram_cntlr->getDramPerfModel()->outputSummary(os);
    }
    else
@@ -564,8 +599,9 @@ void
 MemoryManager::outputCacheLineReplicationSummary()
 {
    // Static Function to Compute the Time Varying Replication Index of a Cache Line
-   // Go through the set of all caches and directories and get the
-   // number of times each cache line is replicated
+   // Go through the set of all caches and get the number of exclusive and shared
+   // lines. The number of sharers of the lines is kept by the directories as the
+   // sharers are added and removed
 
    SInt32 total_tiles = (SInt32) Config::getSingleton()->getTotalTiles();
    
@@ -574,7 +610,10 @@ MemoryManager::outputCacheLineReplicationSummary()
    UInt64 total_exclusive_lines_L2_cache = 0;
    UInt64 total_shared_lines_L2_cache = 0;
    UInt64 total_cache_lines_L2_cache = 0;
-   vector<UInt64> total_cache_line_sharer_count(total_tiles+1, 0);
+   vector<UInt64> total_cache_line_sharer_count;
+   Directory::getSharerStats(total_cache_line_sharer_count);
+   for (SInt32 num_sharers = 1; num_sharers <= total_tiles; num_sharers ++)
+      total_cache_lines_L2_cache += total_cache_line_sharer_count[num_sharers];
    
    for (SInt32 tile_id = 0; tile_id < total_tiles; tile_id ++)
    {
@@ -585,9 +624,6 @@ MemoryManager::outputCacheLineReplicationSummary()
       Cache* L1_icache = memory_manager->getL1ICache();
       Cache* L1_dcache = memory_manager->getL1DCache();
       Cache* L2_cache = memory_manager->getL2Cache();
-      Directory* directory = (Directory*) NULL;
-      if (memory_manager->isDramCntlrPresent())
-         directory = memory_manager->getDramDirectoryCache()->getDirectory();
    
       // Get total lines in L1 caches & L2 cache
       vector<UInt64> L1_icache_line_state_counters;
@@ -609,17 +645,6 @@ MemoryManager::outputCacheLineReplicationSummary()
       total_shared_lines_L1_cache += (num_shared_lines_L1_icache + num_shared_lines_L1_dcache);
       total_exclusive_lines_L2_cache += num_exclusive_lines_L2_cache;
       total_shared_lines_L2_cache += num_shared_lines_L2_cache;
-
-      if (directory)
-      {
-         vector<UInt64> cache_line_sharer_count;
-         directory->getSharerStats(cache_line_sharer_count);
-         for (SInt32 num_sharers = 1; num_sharers <= total_tiles; num_sharers ++)
-         {
-            total_cache_line_sharer_count[num_sharers] += cache_line_sharer_count[num_sharers];
-            total_cache_lines_L2_cache += cache_line_sharer_count[num_sharers];
-         }
-      }
    }
 
    // Write to file
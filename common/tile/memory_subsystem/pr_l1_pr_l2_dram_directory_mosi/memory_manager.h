@@ -10,8 +10,10 @@ using std::ofstream;
 #include "l2_cache_cntlr.h"
 #include "dram_directory_cntlr.h"
 #include "dram_cntlr.h"
+#include "l3_cache_cntlr.h"
 #include "address_home_lookup.h"
 #include "shmem_msg.h"
+#include "trace_file.h"
 #include "mem_component.h"
 #include "lock.h"
 #include "semaphore.h"
@@ -77,6 +79,8 @@ namespace PrL1PrL2DramDirectoryMOSI
       L2CacheCntlr* _L2_cache_cntlr;
       DramDirectoryCntlr* _dram_directory_cntlr;
       DramCntlr* _dram_cntlr;
+      // Shared L3 cache slice in front of the DRAM controller, NULL without one
+      L3CacheCntlr* _l3_cache_cntlr;
       
       // Home Lookups
       AddressHomeLookup* _dram_directory_home_lookup;
@@ -101,7 +105,7 @@ namespace PrL1PrL2DramDirectoryMOSI
       bool _switch_networks;
 
       // Cache Line Replication
-      static ofstream _cache_line_replication_file;
+      static TraceFile _cache_line_replication_file;
 
       // Get Packet Type for a message
       PacketType getPacketType(MemComponent::Type sender_mem_component, MemComponent::Type receiver_mem_component);
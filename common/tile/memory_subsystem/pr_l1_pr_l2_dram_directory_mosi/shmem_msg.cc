@@ -17,6 +17,8 @@ namespace PrL1PrL2DramDirectoryMOSI
       , _data_buf(NULL)
       , _data_length(0)
       , _modeled(false)
+      , _modeled_data_length(0)
+      , _data_elided(false)
    {}
 
    ShmemMsg::ShmemMsg(Type msg_type
@@ -38,6 +40,8 @@ namespace PrL1PrL2DramDirectoryMOSI
       , _data_buf(NULL)
       , _data_length(0)
       , _modeled(modeled)
+      , _modeled_data_length(0)
+      , _data_elided(false)
    {}
 
    ShmemMsg::ShmemMsg(Type msg_type
@@ -61,6 +65,8 @@ namespace PrL1PrL2DramDirectoryMOSI
       , _data_buf(data_buf)
       , _data_length(data_length)
       , _modeled(modeled)
+      , _modeled_data_length(0)
+      , _data_elided(false)
    {}
 
    ShmemMsg::ShmemMsg(const ShmemMsg* shmem_msg)
@@ -84,39 +90,44 @@ namespace PrL1PrL2DramDirectoryMOSI
       _data_buf = shmem_msg->getDataBuf();
       _data_length = shmem_msg->getDataLength();
       _modeled = shmem_msg->isModeled();
+      _modeled_data_length = 0;
+      _data_elided = false;
    }
 
-   ShmemMsg*
-   ShmemMsg::getShmemMsg(Byte* msg_buf)
+   void
+   ShmemMsg::getShmemMsg(Byte* msg_buf, ShmemMsg* shmem_msg)
    {
-      ShmemMsg* shmem_msg = new ShmemMsg();
       memcpy((void*) shmem_msg, msg_buf, sizeof(*shmem_msg));
       if (shmem_msg->getDataLength() > 0)
-      {
-         shmem_msg->setDataBuf(new Byte[shmem_msg->getDataLength()]);
-         memcpy((void*) shmem_msg->getDataBuf(), msg_buf + sizeof(*shmem_msg), shmem_msg->getDataLength());
-      }
-      return shmem_msg;
+         shmem_msg->setDataBuf(shmem_msg->_data_elided ? getZeroData(shmem_msg->getDataLength()) :
+                               (msg_buf + sizeof(*shmem_msg)));
    }
 
-   Byte*
-   ShmemMsg::makeMsgBuf()
+   void
+   ShmemMsg::makeMsgBuf(Byte* msg_buf)
    {
-      Byte* msg_buf = new Byte[getMsgLen()];
+      _modeled_data_length = computeModeledDataLength(_data_buf, _data_length);
+      _data_elided = isDataElided(_data_buf, _data_length);
       memcpy(msg_buf, (void*) this, sizeof(*this));
-      if (_data_length > 0)
+      if ((_data_length > 0) && (!_data_elided))
       {
          LOG_ASSERT_ERROR(_data_buf != NULL, "_data_buf(%p)", _data_buf);
-         memcpy(msg_buf + sizeof(*this), (void*) _data_buf, _data_length); 
+         memcpy(msg_buf + sizeof(*this), (void*) _data_buf, _data_length);
       }
+   }
 
-      return msg_buf; 
+   Byte*
+   ShmemMsg::makeMsgBuf()
+   {
+      Byte* msg_buf = new Byte[getMsgLen()];
+      makeMsgBuf(msg_buf);
+      return msg_buf;
    }
 
    UInt32
    ShmemMsg::getMsgLen()
    {
-      return (sizeof(*this) + _data_length);
+      return (sizeof(*this) + (isDataElided(_data_buf, _data_length) ? 0 : _data_length));
    }
 
    UInt32
@@ -131,9 +142,16 @@ namespace PrL1PrL2DramDirectoryMOSI
       case WB_REQ:
       case UPGRADE_REP:
       case INV_REP:
+      case FWD_NACK_REP:
+      case UNBLOCK_REP:
          // msg_type + address
          return (_num_msg_type_bits + _num_physical_address_bits);
          
+      case FWD_FLUSH_REQ:
+      case FWD_WB_REQ:
+         // msg_type + address + requester
+         return (_num_msg_type_bits + _num_physical_address_bits + Config::getSingleton()->getTileIDLength());
+
       case INV_FLUSH_COMBINED_REQ:
          // msg_type + address + single_receiver
          return (_num_msg_type_bits + _num_physical_address_bits + Config::getSingleton()->getTileIDLength());
@@ -142,8 +160,8 @@ namespace PrL1PrL2DramDirectoryMOSI
       case SH_REP:
       case FLUSH_REP:
       case WB_REP:
-         // msg_type + address + cache_block
-         return (_num_msg_type_bits + _num_physical_address_bits + _data_length * 8);
+         // msg_type + address + cache_block (compressed)
+         return (_num_msg_type_bits + _num_physical_address_bits + _modeled_data_length);
 
       default:
          LOG_PRINT_ERROR("Unrecognized Msg Type(%u)", _msg_type);
@@ -184,6 +202,14 @@ namespace PrL1PrL2DramDirectoryMOSI
          return "WB_REP";
       case NULLIFY_REQ:
          return "NULLIFY_REQ";
+      case FWD_FLUSH_REQ:
+         return "FWD_FLUSH_REQ";
+      case FWD_WB_REQ:
+         return "FWD_WB_REQ";
+      case FWD_NACK_REP:
+         return "FWD_NACK_REP";
+      case UNBLOCK_REP:
+         return "UNBLOCK_REP";
       default:
          LOG_PRINT_ERROR("Unrecognized shmem msg type(%u)", type);
          return "";
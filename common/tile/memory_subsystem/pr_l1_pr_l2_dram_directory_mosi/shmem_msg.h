@@ -24,7 +24,14 @@ namespace PrL1PrL2DramDirectoryMOSI
          INV_REP,
          FLUSH_REP,
          WB_REP,
-         NULLIFY_REQ
+         NULLIFY_REQ,
+         // Owner forwarding: the owner sends the line to the requester
+         // (EX_REP/SH_REP), which unblocks the directory. The owner that no
+         // longer has the line NACKs
+         FWD_FLUSH_REQ,
+         FWD_WB_REQ,
+         FWD_NACK_REP,
+         UNBLOCK_REP
       }; 
 
       ShmemMsg();
@@ -52,7 +59,11 @@ namespace PrL1PrL2DramDirectoryMOSI
       ~ShmemMsg();
 
       void clone(const ShmemMsg* shmem_msg);
-      static ShmemMsg* getShmemMsg(Byte* msg_buf);
+      // Reads the msg in place: 'data_buf' points into 'msg_buf', which must
+      // outlive 'shmem_msg'
+      static void getShmemMsg(Byte* msg_buf, ShmemMsg* shmem_msg);
+      // Writes the msg into 'msg_buf', of at least getMsgLen() bytes
+      void makeMsgBuf(Byte* msg_buf);
       Byte* makeMsgBuf();
       UInt32 getMsgLen();
 
@@ -87,8 +98,12 @@ namespace PrL1PrL2DramDirectoryMOSI
       Byte* _data_buf;
       UInt32 _data_length;
       bool _modeled;
+      // Set when the msg buffer is made: the modeled length of the data (in
+      // bits), and whether the data was left out of the buffer
+      UInt32 _modeled_data_length;
+      bool _data_elided;
 
-      static const UInt32 _num_msg_type_bits = 4;
+      static const UInt32 _num_msg_type_bits = 5;
    };
 
    #define SPELL_SHMSG(x)        (ShmemMsg::getName(x).c_str())
@@ -11,7 +11,7 @@ namespace PrL1PrL2DramDirectoryMOSI
    class ShmemReq
    {
    private:
-      ShmemMsg* _shmem_msg;
+      ShmemMsg _shmem_msg;
       
       UInt64 _arrival_time;
       UInt64 _processing_start_time;
@@ -21,13 +21,18 @@ namespace PrL1PrL2DramDirectoryMOSI
       bool _initial_broadcast_mode;
       tile_id_t _sharer_tile_id;
       bool _upgrade_reply;
+      // Forwarded to the owner (_sharer_tile_id), waiting for the UNBLOCK_REP
+      bool _forwarded;
+      bool _forward_nacked;
 
    public:
       ShmemReq(ShmemMsg* shmem_msg, UInt64 time);
       ~ShmemReq();
 
-      ShmemMsg* getShmemMsg() const
-      { return _shmem_msg; }
+      ShmemMsg* getShmemMsg()
+      { return &_shmem_msg; }
+      const ShmemMsg* getShmemMsg() const
+      { return &_shmem_msg; }
       UInt64 getSerializationTime() const
       { return _processing_start_time - _arrival_time; }
       UInt64 getProcessingTime() const
@@ -63,5 +68,14 @@ namespace PrL1PrL2DramDirectoryMOSI
       { _upgrade_reply = true; }
       bool isUpgradeReply() const
       { return _upgrade_reply; }
+
+      void setForwarded(bool forwarded)
+      { _forwarded = forwarded; }
+      bool isForwarded() const
+      { return _forwarded; }
+      void setForwardNacked()
+      { _forward_nacked = true; }
+      bool isForwardNacked() const
+      { return _forward_nacked; }
    };
 }
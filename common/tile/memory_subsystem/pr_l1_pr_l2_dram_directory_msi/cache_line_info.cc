@@ -14,6 +14,8 @@ createCacheLineInfo(SInt32 cache_level)
       return new PrL1CacheLineInfo();
    case L2:
       return new PrL2CacheLineInfo();
+   case L3:
+      return new CacheLineInfo();
    default:
       LOG_PRINT_ERROR("Unrecognized Cache Level(%u)", cache_level);
       return (CacheLineInfo*) NULL;
@@ -25,6 +27,7 @@ createCacheLineInfo(SInt32 cache_level)
 PrL2CacheLineInfo::PrL2CacheLineInfo(IntPtr tag, CacheState::Type cstate, MemComponent::Type cached_loc)
    : CacheLineInfo(tag, cstate)
    , _cached_loc(cached_loc)
+   , _prefetched(false)
 {}
 
 PrL2CacheLineInfo::~PrL2CacheLineInfo()
@@ -57,6 +60,7 @@ PrL2CacheLineInfo::invalidate()
 {
    CacheLineInfo::invalidate();
    _cached_loc = MemComponent::INVALID;
+   _prefetched = false;
 }
 
 void 
@@ -65,6 +69,25 @@ PrL2CacheLineInfo::assign(CacheLineInfo* cache_line_info)
    CacheLineInfo::assign(cache_line_info);
    PrL2CacheLineInfo* L2_cache_line_info = dynamic_cast<PrL2CacheLineInfo*>(cache_line_info);
    _cached_loc = L2_cache_line_info->getCachedLoc();
+   _prefetched = L2_cache_line_info->isPrefetched();
+}
+
+void
+PrL2CacheLineInfo::saveState(CheckpointWriter& writer)
+{
+   CacheLineInfo::saveState(writer);
+   writer << (UInt32) _cached_loc << (UInt8) _prefetched;
+}
+
+void
+PrL2CacheLineInfo::restoreState(CheckpointReader& reader)
+{
+   CacheLineInfo::restoreState(reader);
+   UInt32 cached_loc;
+   UInt8 prefetched;
+   reader >> cached_loc >> prefetched;
+   _cached_loc = (MemComponent::Type) cached_loc;
+   _prefetched = prefetched;
 }
 
 }
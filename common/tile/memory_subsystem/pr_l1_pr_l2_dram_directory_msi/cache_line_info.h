@@ -22,12 +22,19 @@ public:
    MemComponent::Type getCachedLoc();
    void setCachedLoc(MemComponent::Type cached_loc);
    void clearCachedLoc(MemComponent::Type cached_loc);
+   // Brought in by a prefetch and not accessed since
+   bool isPrefetched() const { return _prefetched; }
+   void setPrefetched(bool prefetched) { _prefetched = prefetched; }
 
    void invalidate();
    void assign(CacheLineInfo* cache_line_info);
 
+   void saveState(CheckpointWriter& writer);
+   void restoreState(CheckpointReader& reader);
+
 private:
    MemComponent::Type _cached_loc;
+   bool _prefetched;
 };
 
 }
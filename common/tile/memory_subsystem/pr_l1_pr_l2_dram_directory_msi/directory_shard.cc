@@ -0,0 +1,78 @@
+#include "directory_shard.h"
+#include "shmem_msg.h"
+#include "log.h"
+
+namespace PrL1PrL2DramDirectoryMSI
+{
+
+DirectoryShard::DirectoryShard(DramDirectoryCntlr* dram_directory_cntlr)
+   : _dram_directory_cntlr(dram_directory_cntlr)
+{
+   _dram_directory_cntlr->setShmemPerfModel(&_shmem_perf_model);
+   _thread = Thread::create(this);
+   _thread->run();
+}
+
+DirectoryShard::~DirectoryShard()
+{
+   ShardMsg quit_msg;
+   quit_msg.sender = INVALID_TILE_ID;
+   quit_msg.time = 0;
+   quit_msg.msg_buf = NULL;
+   pushMsg(quit_msg);
+   _exit_sem.wait();
+
+   delete _thread;
+   delete _dram_directory_cntlr;
+}
+
+void
+DirectoryShard::enqueueMsg(tile_id_t sender, UInt64 time, const void* msg_buf, UInt32 msg_len)
+{
+   ShardMsg msg;
+   msg.sender = sender;
+   msg.time = time;
+   msg.msg_buf = new Byte[msg_len];
+   memcpy(msg.msg_buf, msg_buf, msg_len);
+   pushMsg(msg);
+}
+
+void
+DirectoryShard::pushMsg(const ShardMsg& msg)
+{
+   _queue_lock.acquire();
+   _msg_queue.push(msg);
+   _queue_lock.release();
+   _msg_sem.signal();
+}
+
+void
+DirectoryShard::run()
+{
+   while (true)
+   {
+      _msg_sem.wait();
+
+      _queue_lock.acquire();
+      ShardMsg msg = _msg_queue.front();
+      _msg_queue.pop();
+      _queue_lock.release();
+
+      if (msg.msg_buf == NULL)
+         break;
+
+      ShmemMsg shmem_msg;
+      ShmemMsg::getShmemMsg(msg.msg_buf, &shmem_msg);
+
+      _lock.acquire();
+      _shmem_perf_model.setCycleCount(msg.time);
+      _dram_directory_cntlr->handleMsgFromL2Cache(msg.sender, &shmem_msg);
+      _lock.release();
+
+      delete [] msg.msg_buf;
+   }
+
+   _exit_sem.signal();
+}
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <queue>
+using std::queue;
+
+#include "dram_directory_cntlr.h"
+#include "shmem_perf_model.h"
+#include "thread.h"
+#include "lock.h"
+#include "semaphore.h"
+#include "fixed_types.h"
+
+namespace PrL1PrL2DramDirectoryMSI
+{
+   // A slice of the directory of a tile served by a sim thread of its own
+   // (caching_protocol/pr_l1_pr_l2_dram_directory_msi/directory_sim_threads).
+   // The lines of the tile are interleaved over the shards by the address bits
+   // above the ones of the home lookup, each shard has its own DramDirectoryCntlr (with its part of the
+   // directory entries) and its own clock, so the directory requests to
+   // different lines are modeled concurrently. The msgs of a line are handled
+   // in order by its shard. The DRAM controller and the L3 cache slice are
+   // shared with the other shards (they lock themselves).
+   //
+   // The sim thread of the tile pushes the msgs, the thread of the shard
+   // handles them.
+   class DirectoryShard : public Runnable
+   {
+   public:
+      DirectoryShard(DramDirectoryCntlr* dram_directory_cntlr);
+      ~DirectoryShard();
+
+      // Copies the msg, the packet is released by the caller
+      void enqueueMsg(tile_id_t sender, UInt64 time, const void* msg_buf, UInt32 msg_len);
+
+      DramDirectoryCntlr* getDramDirectoryCntlr() { return _dram_directory_cntlr; }
+      ShmemPerfModel* getShmemPerfModel() { return &_shmem_perf_model; }
+
+      // Held while a msg is handled, to enable/disable/save the models
+      Lock& getLock() { return _lock; }
+
+   private:
+      struct ShardMsg
+      {
+         tile_id_t sender;
+         UInt64 time;
+         // NULL to stop the thread
+         Byte* msg_buf;
+      };
+
+      DramDirectoryCntlr* _dram_directory_cntlr;
+      ShmemPerfModel _shmem_perf_model;
+      Thread* _thread;
+
+      Lock _lock;
+      Lock _queue_lock;
+      queue<ShardMsg> _msg_queue;
+      Semaphore _msg_sem;
+      Semaphore _exit_sem;
+
+      void run();
+      void pushMsg(const ShardMsg& msg);
+   };
+}
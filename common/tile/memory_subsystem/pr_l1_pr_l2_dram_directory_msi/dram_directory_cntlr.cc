@@ -3,6 +3,7 @@ using namespace std;
 #include "dram_directory_cntlr.h"
 #include "log.h"
 #include "memory_manager.h"
+#include "page_classifier.h"
 
 namespace PrL1PrL2DramDirectoryMSI
 {
@@ -16,9 +17,28 @@ DramDirectoryCntlr::DramDirectoryCntlr(MemoryManager* memory_manager,
       UInt32 dram_directory_max_hw_sharers,
       string dram_directory_type_str,
       string dram_directory_access_time_str,
-      UInt32 num_dram_cntlrs)
+      UInt32 num_dram_cntlrs,
+      bool multicast_invalidations,
+      bool coalesce_sh_reqs,
+      bool exclusive_state,
+      UInt32 far_atomics_sharers_threshold,
+      UInt32 far_atomics_contention_threshold)
    : _memory_manager(memory_manager)
    , _dram_cntlr(dram_cntlr)
+   , _l3_cache_cntlr(NULL)
+   , _shmem_perf_model(memory_manager->getShmemPerfModel())
+   , _multicast_invalidations(multicast_invalidations)
+   , _coalesce_sh_reqs(coalesce_sh_reqs)
+   , _exclusive_state(exclusive_state)
+   , _far_atomics_sharers_threshold(far_atomics_sharers_threshold)
+   , _far_atomics_contention_threshold(far_atomics_contention_threshold)
+   , _total_sh_reqs(0)
+   , _total_coalesced_sh_reqs(0)
+   , _total_exclusive_reps(0)
+   , _total_atomic_reqs(0)
+   , _total_far_atomics(0)
+   , _total_private_reqs(0)
+   , _total_untracked_evictions(0)
 {
    _dram_directory_cache = new DirectoryCache(_memory_manager->getTile(),
                                               PR_L1_PR_L2_DRAM_DIRECTORY_MSI,
@@ -52,37 +72,40 @@ DramDirectoryCntlr::handleMsgFromL2Cache(tile_id_t sender, ShmemMsg* shmem_msg)
    {
       case ShmemMsg::EX_REQ:
       case ShmemMsg::SH_REQ:
+      case ShmemMsg::ATOMIC_REQ:
 
          {
             IntPtr address = shmem_msg->getAddress();
             
+            if (shmem_msg_type == ShmemMsg::SH_REQ)
+               _total_sh_reqs ++;
+
             // Add request onto a queue
-            ShmemReq* shmem_req = new ShmemReq(shmem_msg, msg_time);
+            ShmemReq* shmem_req = new (_shmem_req_pool.allocate()) ShmemReq(shmem_msg, msg_time);
             _dram_directory_req_queue_list->enqueue(address, shmem_req);
             if (_dram_directory_req_queue_list->count(address) == 1)
-            {
-               if (shmem_msg_type == ShmemMsg::EX_REQ)
-                  processExReqFromL2Cache(shmem_req);
-               else if (shmem_msg_type == ShmemMsg::SH_REQ)
-                  processShReqFromL2Cache(shmem_req);
-               else
-                  LOG_PRINT_ERROR("Unrecognized Request(%u)", shmem_msg_type);
-            }
+               processReqFromL2Cache(shmem_req);
          }
          break;
 
       case ShmemMsg::INV_REP:
-         processInvRepFromL2Cache(sender, shmem_msg);
+         if (!processUntrackedEviction(sender, shmem_msg))
+            processInvRepFromL2Cache(sender, shmem_msg);
          break;
 
       case ShmemMsg::FLUSH_REP:
-         processFlushRepFromL2Cache(sender, shmem_msg);
+         if (!processUntrackedEviction(sender, shmem_msg))
+            processFlushRepFromL2Cache(sender, shmem_msg);
          break;
 
       case ShmemMsg::WB_REP:
          processWbRepFromL2Cache(sender, shmem_msg);
          break;
 
+      case ShmemMsg::ATOMIC_WB_REP:
+         processAtomicWbRepFromL2Cache(sender, shmem_msg);
+         break;
+
       default:
          LOG_PRINT_ERROR("Unrecognized Shmem Msg Type: %u", shmem_msg_type);
          break;
@@ -90,13 +113,22 @@ DramDirectoryCntlr::handleMsgFromL2Cache(tile_id_t sender, ShmemMsg* shmem_msg)
 }
 
 void
-DramDirectoryCntlr::processNextReqFromL2Cache(IntPtr address)
+DramDirectoryCntlr::processNextReqFromL2Cache(IntPtr address, Byte* coalesce_data_buf)
 {
    LOG_PRINT("Start processNextReqFromL2Cache(%#lx)", address);
 
    assert(_dram_directory_req_queue_list->count(address) >= 1);
    ShmemReq* completed_shmem_req = _dram_directory_req_queue_list->dequeue(address);
-   delete completed_shmem_req;
+   ShmemMsg::Type completed_type = completed_shmem_req->getShmemMsg()->getType();
+   getMemoryManager()->traceDirectoryReq((completed_type == ShmemMsg::EX_REQ) ? "EX_REQ" :
+                                         (completed_type == ShmemMsg::SH_REQ) ? "SH_REQ" :
+                                         (completed_type == ShmemMsg::ATOMIC_REQ) ? "ATOMIC_REQ" : "NULLIFY_REQ",
+                                         address, completed_shmem_req->getArrivalTime(),
+                                         getShmemPerfModel()->getCycleCount());
+   _shmem_req_pool.release(completed_shmem_req);
+
+   if (coalesce_data_buf)
+      coalesceShReqs(address, coalesce_data_buf);
 
    if (! _dram_directory_req_queue_list->empty(address))
    {
@@ -107,16 +139,66 @@ DramDirectoryCntlr::processNextReqFromL2Cache(IntPtr address)
       shmem_req->updateTime(getShmemPerfModel()->getCycleCount());
       getShmemPerfModel()->updateCycleCount(shmem_req->getTime());
 
-      if (shmem_req->getShmemMsg()->getType() == ShmemMsg::EX_REQ)
-         processExReqFromL2Cache(shmem_req);
-      else if (shmem_req->getShmemMsg()->getType() == ShmemMsg::SH_REQ)
-         processShReqFromL2Cache(shmem_req);
-      else
-         LOG_PRINT_ERROR("Unrecognized Request(%u)", shmem_req->getShmemMsg()->getType());
+      processReqFromL2Cache(shmem_req);
    }
    LOG_PRINT("End processNextReqFromL2Cache(%#lx)", address);
 }
 
+void
+DramDirectoryCntlr::processReqFromL2Cache(ShmemReq* shmem_req)
+{
+   if (PageClassifier::isEnabled() && processPrivateReq(shmem_req))
+      return;
+
+   ShmemMsg::Type shmem_msg_type = shmem_req->getShmemMsg()->getType();
+   if (shmem_msg_type == ShmemMsg::EX_REQ)
+      processExReqFromL2Cache(shmem_req);
+   else if (shmem_msg_type == ShmemMsg::SH_REQ)
+      processShReqFromL2Cache(shmem_req);
+   else if (shmem_msg_type == ShmemMsg::ATOMIC_REQ)
+      processAtomicReqFromL2Cache(shmem_req);
+   else
+      LOG_PRINT_ERROR("Unrecognized Request(%u)", shmem_msg_type);
+}
+
+bool
+DramDirectoryCntlr::processPrivateReq(ShmemReq* shmem_req)
+{
+   ShmemMsg* shmem_msg = shmem_req->getShmemMsg();
+   IntPtr address = shmem_msg->getAddress();
+   tile_id_t requester = shmem_msg->getRequester();
+
+   // The line of a private page has no directory entry, it is answered
+   // without looking up the directory. An atomic is near
+   ShmemMsg::Type reply_msg_type = ShmemMsg::EX_REP;
+   if (shmem_msg->getType() == ShmemMsg::SH_REQ)
+      reply_msg_type = _exclusive_state ? ShmemMsg::EXCLUSIVE_REP : ShmemMsg::SH_REP;
+   if (!PageClassifier::processRequest(address, requester, reply_msg_type != ShmemMsg::SH_REP))
+      return false;
+
+   if (shmem_msg->getType() == ShmemMsg::ATOMIC_REQ)
+      shmem_msg->setType(ShmemMsg::EX_REQ);
+   _total_private_reqs ++;
+
+   retrieveDataAndSendToL2Cache(reply_msg_type, requester, address, NULL, shmem_msg->isModeled());
+
+   // Process Next Request
+   processNextReqFromL2Cache(address);
+   return true;
+}
+
+bool
+DramDirectoryCntlr::processUntrackedEviction(tile_id_t sender, ShmemMsg* shmem_msg)
+{
+   if (!PageClassifier::isEnabled() || !PageClassifier::removeUntrackedLine(shmem_msg->getAddress(), sender))
+      return false;
+
+   // The data of a MODIFIED line goes back to DRAM as in a tracked eviction
+   _total_untracked_evictions ++;
+   sendDataToDram(shmem_msg->getAddress(), shmem_msg->getDataBuf(), shmem_msg->isModeled());
+   return true;
+}
+
 DirectoryEntry*
 DramDirectoryCntlr::processDirectoryEntryAllocationReq(ShmemReq* shmem_req)
 {
@@ -149,12 +231,13 @@ DramDirectoryCntlr::processDirectoryEntryAllocationReq(ShmemReq* shmem_req)
 
    // We get the entry with the lowest number of sharers
    DirectoryEntry* directory_entry = _dram_directory_cache->replaceDirectoryEntry(replaced_address, address);
+   trackUntrackedLine(directory_entry, address);
 
    // The NULLIFY requests are always modeled in the network
    bool msg_modeled = true;
    ShmemMsg nullify_msg(ShmemMsg::NULLIFY_REQ, MemComponent::DRAM_DIRECTORY, MemComponent::DRAM_DIRECTORY, requester, replaced_address, msg_modeled);
 
-   ShmemReq* nullify_req = new ShmemReq(&nullify_msg, msg_time);
+   ShmemReq* nullify_req = new (_shmem_req_pool.allocate()) ShmemReq(&nullify_msg, msg_time);
    _dram_directory_req_queue_list->enqueue(replaced_address, nullify_req);
 
    assert(_dram_directory_req_queue_list->count(replaced_address) == 1);
@@ -163,6 +246,28 @@ DramDirectoryCntlr::processDirectoryEntryAllocationReq(ShmemReq* shmem_req)
    return directory_entry;
 }
 
+void
+DramDirectoryCntlr::trackUntrackedLine(DirectoryEntry* directory_entry, IntPtr address)
+{
+   // A line of a page that was private, still cached by its former owner
+   tile_id_t owner;
+   bool exclusive;
+   if (!PageClassifier::isEnabled() || !PageClassifier::trackLine(address, owner, exclusive))
+      return;
+
+   __attribute(__unused__) bool add_result = addSharer(directory_entry, owner);
+   assert(add_result);
+   if (exclusive)
+   {
+      directory_entry->setOwner(owner);
+      directory_entry->getDirectoryBlockInfo()->setDState(DirectoryState::MODIFIED);
+   }
+   else
+   {
+      directory_entry->getDirectoryBlockInfo()->setDState(DirectoryState::SHARED);
+   }
+}
+
 void
 DramDirectoryCntlr::processNullifyReq(ShmemReq* shmem_req)
 {
@@ -189,26 +294,7 @@ DramDirectoryCntlr::processNullifyReq(ShmemReq* shmem_req)
    case DirectoryState::SHARED:
 
       {
-         vector<tile_id_t> sharers_list;
-         bool all_tiles_sharers = directory_entry->getSharersList(sharers_list);
-         if (all_tiles_sharers)
-         {
-            // Broadcast Invalidation Request to all tiles 
-            // (irrespective of whether they are sharers or not)
-            ShmemMsg msg(ShmemMsg::INV_REQ, MemComponent::DRAM_DIRECTORY, MemComponent::L2_CACHE, requester, address,
-                         msg_modeled);
-            getMemoryManager()->broadcastMsg(msg);
-         }
-         else
-         {
-            // Send Invalidation Request to only a specific set of sharers
-            for (UInt32 i = 0; i < sharers_list.size(); i++)
-            {
-               ShmemMsg msg(ShmemMsg::INV_REQ, MemComponent::DRAM_DIRECTORY, MemComponent::L2_CACHE, requester, address,
-                            msg_modeled);
-               getMemoryManager()->sendMsg(sharers_list[i], msg);
-            }
-         }
+         sendInvReqToSharers(directory_entry, requester, address, msg_modeled);
       }
       break;
 
@@ -229,6 +315,33 @@ DramDirectoryCntlr::processNullifyReq(ShmemReq* shmem_req)
 
 }
 
+void
+DramDirectoryCntlr::sendInvReqToSharers(DirectoryEntry* directory_entry, tile_id_t requester, IntPtr address, bool msg_modeled)
+{
+   ShmemMsg msg(ShmemMsg::INV_REQ, MemComponent::DRAM_DIRECTORY, MemComponent::L2_CACHE, requester, address,
+                msg_modeled);
+
+   vector<tile_id_t> sharers_list;
+   bool all_tiles_sharers = directory_entry->getSharersList(sharers_list);
+   if (all_tiles_sharers)
+   {
+      // Broadcast Invalidation Request to all tiles 
+      // (irrespective of whether they are sharers or not)
+      getMemoryManager()->broadcastMsg(msg);
+   }
+   else if (_multicast_invalidations && (sharers_list.size() > 1))
+   {
+      // One Invalidation Request, replicated by the network to the sharers
+      getMemoryManager()->multicastMsg(sharers_list, msg);
+   }
+   else
+   {
+      // Send Invalidation Request to only a specific set of sharers
+      for (UInt32 i = 0; i < sharers_list.size(); i++)
+         getMemoryManager()->sendMsg(sharers_list[i], msg);
+   }
+}
+
 void
 DramDirectoryCntlr::processExReqFromL2Cache(ShmemReq* shmem_req, Byte* cached_data_buf)
 {
@@ -260,26 +373,7 @@ DramDirectoryCntlr::processExReqFromL2Cache(ShmemReq* shmem_req, Byte* cached_da
 
       {
          assert(cached_data_buf == NULL);
-         vector<tile_id_t> sharers_list;
-         bool all_tiles_sharers = directory_entry->getSharersList(sharers_list);
-         if (all_tiles_sharers)
-         {
-            // Broadcast Invalidation Request to all tiles 
-            // (irrespective of whether they are sharers or not)
-            ShmemMsg msg(ShmemMsg::INV_REQ, MemComponent::DRAM_DIRECTORY, MemComponent::L2_CACHE, requester, address,
-                         msg_modeled);
-            getMemoryManager()->broadcastMsg(msg);
-         }
-         else
-         {
-            // Send Invalidation Request to only a specific set of sharers
-            for (UInt32 i = 0; i < sharers_list.size(); i++)
-            {
-               ShmemMsg msg(ShmemMsg::INV_REQ, MemComponent::DRAM_DIRECTORY, MemComponent::L2_CACHE, requester, address,
-                            msg_modeled);
-               getMemoryManager()->sendMsg(sharers_list[i], msg);
-            }
-         }
+         sendInvReqToSharers(directory_entry, requester, address, msg_modeled);
       }
       break;
 
@@ -287,7 +381,7 @@ DramDirectoryCntlr::processExReqFromL2Cache(ShmemReq* shmem_req, Byte* cached_da
       
       {
          // Modifiy the directory entry contents
-         __attribute(__unused__) bool add_result = directory_entry->addSharer(requester);
+         __attribute(__unused__) bool add_result = addSharer(directory_entry, requester);
          assert(add_result);
          directory_entry->setOwner(requester);
          directory_block_info->setDState(DirectoryState::MODIFIED);
@@ -334,7 +428,7 @@ DramDirectoryCntlr::processShReqFromL2Cache(ShmemReq* shmem_req, Byte* cached_da
 
    case DirectoryState::SHARED:
       {
-         bool add_result = directory_entry->addSharer(requester);
+         bool add_result = addSharer(directory_entry, requester);
          if (add_result == false)
          {
             tile_id_t sharer_id = directory_entry->getOneSharer();
@@ -345,10 +439,7 @@ DramDirectoryCntlr::processShReqFromL2Cache(ShmemReq* shmem_req, Byte* cached_da
          }
          else
          {
-            retrieveDataAndSendToL2Cache(ShmemMsg::SH_REP, requester, address, cached_data_buf, msg_modeled);
-   
-            // Process Next Request
-            processNextReqFromL2Cache(address);
+            sendShRepToL2Cache(address, requester, cached_data_buf, msg_modeled);
          }
       }
       break;
@@ -356,14 +447,28 @@ DramDirectoryCntlr::processShReqFromL2Cache(ShmemReq* shmem_req, Byte* cached_da
    case DirectoryState::UNCACHED:
       {
          // Modifiy the directory entry contents
-         __attribute(__unused__) bool add_result = directory_entry->addSharer(requester);
+         __attribute(__unused__) bool add_result = addSharer(directory_entry, requester);
          assert(add_result);
-         directory_block_info->setDState(DirectoryState::SHARED);
 
-         retrieveDataAndSendToL2Cache(ShmemMsg::SH_REP, requester, address, cached_data_buf, msg_modeled);
-   
-         // Process Next Request
-         processNextReqFromL2Cache(address);
+         if (_exclusive_state)
+         {
+            // The requester can write the line without asking again. As it
+            // may do so silently, the directory sees it as the owner
+            directory_entry->setOwner(requester);
+            directory_block_info->setDState(DirectoryState::MODIFIED);
+            _total_exclusive_reps ++;
+
+            retrieveDataAndSendToL2Cache(ShmemMsg::EXCLUSIVE_REP, requester, address, cached_data_buf, msg_modeled);
+
+            // Process Next Request
+            processNextReqFromL2Cache(address);
+         }
+         else
+         {
+            directory_block_info->setDState(DirectoryState::SHARED);
+
+            sendShRepToL2Cache(address, requester, cached_data_buf, msg_modeled);
+         }
       }
       break;
 
@@ -373,6 +478,136 @@ DramDirectoryCntlr::processShReqFromL2Cache(ShmemReq* shmem_req, Byte* cached_da
    }
 }
 
+void
+DramDirectoryCntlr::processAtomicReqFromL2Cache(ShmemReq* shmem_req, Byte* cached_data_buf)
+{
+   IntPtr address = shmem_req->getShmemMsg()->getAddress();
+   tile_id_t requester = shmem_req->getShmemMsg()->getRequester();
+   bool msg_modeled = shmem_req->getShmemMsg()->isModeled();
+
+   DirectoryEntry* directory_entry = _dram_directory_cache->getDirectoryEntry(address);
+   if (directory_entry == NULL)
+   {
+      directory_entry = processDirectoryEntryAllocationReq(shmem_req);
+   }
+
+   // Near or far is decided when the request gets to the front of the queue
+   if (!shmem_req->isFarAtomic())
+   {
+      _total_atomic_reqs ++;
+      if (!isFarAtomic(directory_entry, requester, address))
+      {
+         // Near: the requester gets the line in the MODIFIED state
+         assert(cached_data_buf == NULL);
+         shmem_req->getShmemMsg()->setType(ShmemMsg::EX_REQ);
+         processExReqFromL2Cache(shmem_req);
+         return;
+      }
+      shmem_req->setFarAtomic(true);
+      _total_far_atomics ++;
+   }
+
+   DirectoryBlockInfo* directory_block_info = directory_entry->getDirectoryBlockInfo();
+   DirectoryState::Type curr_dstate = directory_block_info->getDState();
+
+   switch (curr_dstate)
+   {
+   case DirectoryState::MODIFIED:
+      {
+         assert(cached_data_buf == NULL);
+         ShmemMsg msg(ShmemMsg::FLUSH_REQ, MemComponent::DRAM_DIRECTORY, MemComponent::L2_CACHE, requester, address,
+                      msg_modeled);
+         getMemoryManager()->sendMsg(directory_entry->getOwner(), msg);
+      }
+      break;
+
+   case DirectoryState::SHARED:
+      {
+         assert(cached_data_buf == NULL);
+         sendInvReqToSharers(directory_entry, requester, address, msg_modeled);
+      }
+      break;
+
+   case DirectoryState::UNCACHED:
+      {
+         // The line stays UNCACHED, the request holds it at the front of the
+         // queue until the ATOMIC_WB_REP
+         retrieveDataAndSendToL2Cache(ShmemMsg::ATOMIC_REP, requester, address, cached_data_buf, msg_modeled);
+      }
+      break;
+
+   default:
+      LOG_PRINT_ERROR("Unsupported Directory State: %u", curr_dstate);
+      break;
+   }
+}
+
+bool
+DramDirectoryCntlr::isFarAtomic(DirectoryEntry* directory_entry, tile_id_t requester, IntPtr address)
+{
+   UInt32 num_other_sharers = directory_entry->getNumSharers() - (directory_entry->hasSharer(requester) ? 1 : 0);
+
+   AtomicHistory& history = _atomic_history[address];
+   bool contended = (num_other_sharers > 0) ||
+                    ((history.last_requester != INVALID_TILE_ID) && (history.last_requester != requester));
+   if (contended && (history.contention < MAX_ATOMIC_CONTENTION))
+      history.contention ++;
+   else if (!contended && (history.contention > 0))
+      history.contention --;
+   history.last_requester = requester;
+
+   return (num_other_sharers >= _far_atomics_sharers_threshold) ||
+          (history.contention >= _far_atomics_contention_threshold);
+}
+
+void
+DramDirectoryCntlr::coalesceShReqs(IntPtr address, Byte* data_buf)
+{
+   // The SH_REQs at the front of the queue are answered with the data of
+   // the SH_REQ that just completed, instead of a directory transaction each
+   DirectoryEntry* directory_entry = _dram_directory_cache->getDirectoryEntry(address);
+   assert(directory_entry);
+   assert(directory_entry->getDirectoryBlockInfo()->getDState() == DirectoryState::SHARED);
+
+   while (!_dram_directory_req_queue_list->empty(address))
+   {
+      ShmemReq* shmem_req = _dram_directory_req_queue_list->front(address);
+      if (shmem_req->getShmemMsg()->getType() != ShmemMsg::SH_REQ)
+         break;
+
+      // No room for another sharer, the request needs an invalidation first
+      tile_id_t requester = shmem_req->getShmemMsg()->getRequester();
+      if (!addSharer(directory_entry, requester))
+         break;
+
+      shmem_req->updateTime(getShmemPerfModel()->getCycleCount());
+      getShmemPerfModel()->updateCycleCount(shmem_req->getTime());
+
+      LOG_PRINT("Coalesced SH_REQ(%#lx) from requester(%i)", address, requester);
+      retrieveDataAndSendToL2Cache(ShmemMsg::SH_REP, requester, address, data_buf, shmem_req->getShmemMsg()->isModeled());
+      _total_coalesced_sh_reqs ++;
+
+      _dram_directory_req_queue_list->dequeue(address);
+      _shmem_req_pool.release(shmem_req);
+   }
+}
+
+void
+DramDirectoryCntlr::sendShRepToL2Cache(IntPtr address, tile_id_t requester, Byte* cached_data_buf, bool msg_modeled)
+{
+   // Keep the data to answer the coalesced requests
+   Byte data_buf[getCacheLineSize()];
+   if (cached_data_buf == NULL)
+   {
+      getDataFromDram(address, requester, data_buf, msg_modeled);
+      cached_data_buf = data_buf;
+   }
+   retrieveDataAndSendToL2Cache(ShmemMsg::SH_REP, requester, address, cached_data_buf, msg_modeled);
+
+   // Process Next Request
+   processNextReqFromL2Cache(address, _coalesce_sh_reqs ? cached_data_buf : NULL);
+}
+
 void
 DramDirectoryCntlr::retrieveDataAndSendToL2Cache(ShmemMsg::Type reply_msg_type,
       tile_id_t receiver, IntPtr address, Byte* cached_data_buf, bool msg_modeled)
@@ -393,7 +628,7 @@ DramDirectoryCntlr::retrieveDataAndSendToL2Cache(ShmemMsg::Type reply_msg_type,
       // I have to get the data from DRAM
       Byte data_buf[getCacheLineSize()];
       
-      _dram_cntlr->getDataFromDram(address, data_buf, msg_modeled);
+      getDataFromDram(address, receiver, data_buf, msg_modeled);
       
       ShmemMsg msg(reply_msg_type, MemComponent::DRAM_DIRECTORY, MemComponent::L2_CACHE, receiver, address,
                    data_buf, getCacheLineSize(), msg_modeled);
@@ -412,7 +647,7 @@ DramDirectoryCntlr::processInvRepFromL2Cache(tile_id_t sender, ShmemMsg* shmem_m
    DirectoryBlockInfo* directory_block_info = directory_entry->getDirectoryBlockInfo();
    assert(directory_block_info->getDState() == DirectoryState::SHARED);
 
-   directory_entry->removeSharer(sender);
+   removeSharer(directory_entry, sender);
    if (directory_entry->getNumSharers() == 0)
    {
       directory_block_info->setDState(DirectoryState::UNCACHED);
@@ -439,6 +674,14 @@ DramDirectoryCntlr::processInvRepFromL2Cache(tile_id_t sender, ShmemMsg* shmem_m
          // A ShmemMsg::SH_REQ caused the invalidation
          processShReqFromL2Cache(shmem_req);
       }
+      else if (shmem_req->getShmemMsg()->getType() == ShmemMsg::ATOMIC_REQ)
+      {
+         // A far atomic caused the invalidation
+         if (directory_block_info->getDState() == DirectoryState::UNCACHED)
+         {
+            processAtomicReqFromL2Cache(shmem_req);
+         }
+      }
       else // shmem_req->getShmemMsg()->getType() == ShmemMsg::NULLIFY_REQ
       {
          if (directory_block_info->getDState() == DirectoryState::UNCACHED)
@@ -460,7 +703,7 @@ DramDirectoryCntlr::processFlushRepFromL2Cache(tile_id_t sender, ShmemMsg* shmem
    DirectoryBlockInfo* directory_block_info = directory_entry->getDirectoryBlockInfo();
    assert(directory_block_info->getDState() == DirectoryState::MODIFIED);
 
-   directory_entry->removeSharer(sender);
+   removeSharer(directory_entry, sender);
    directory_entry->setOwner(INVALID_TILE_ID);
    directory_block_info->setDState(DirectoryState::UNCACHED);
 
@@ -483,6 +726,11 @@ DramDirectoryCntlr::processFlushRepFromL2Cache(tile_id_t sender, ShmemMsg* shmem
          sendDataToDram(address, shmem_msg->getDataBuf(), shmem_msg->isModeled());
          processShReqFromL2Cache(shmem_req, shmem_msg->getDataBuf());
       }
+      else if (shmem_req->getShmemMsg()->getType() == ShmemMsg::ATOMIC_REQ)
+      {
+         // The data goes to DRAM with the ATOMIC_WB_REP
+         processAtomicReqFromL2Cache(shmem_req, shmem_msg->getDataBuf());
+      }
       else // shmem_req->getShmemMsg()->getType() == ShmemMsg::NULLIFY_REQ
       {
          // Write Data To Dram
@@ -536,23 +784,99 @@ DramDirectoryCntlr::processWbRepFromL2Cache(tile_id_t sender, ShmemMsg* shmem_ms
    }
 }
 
+void
+DramDirectoryCntlr::processAtomicWbRepFromL2Cache(tile_id_t sender, ShmemMsg* shmem_msg)
+{
+   IntPtr address = shmem_msg->getAddress();
+
+   LOG_ASSERT_ERROR(_dram_directory_req_queue_list->count(address) > 0,
+                    "Address(%#lx), ATOMIC_WB_REP without a far atomic", address);
+   ShmemReq* shmem_req = _dram_directory_req_queue_list->front(address);
+   LOG_ASSERT_ERROR(shmem_req->isFarAtomic() && (shmem_req->getShmemMsg()->getRequester() == sender),
+                    "Address(%#lx), ATOMIC_WB_REP from tile(%i), Req(%u)",
+                    address, sender, shmem_req->getShmemMsg()->getType());
+
+   // Update Time
+   shmem_req->updateTime(getShmemPerfModel()->getCycleCount());
+   getShmemPerfModel()->updateCycleCount(shmem_req->getTime());
+
+   // Write Data to Dram
+   sendDataToDram(address, shmem_msg->getDataBuf(), shmem_msg->isModeled());
+
+   // Process Next Request
+   processNextReqFromL2Cache(address);
+}
+
+void
+DramDirectoryCntlr::getDataFromDram(IntPtr address, tile_id_t requester, Byte* data_buf, bool msg_modeled)
+{
+   if (_l3_cache_cntlr)
+      _l3_cache_cntlr->getDataFromDram(address, data_buf, msg_modeled, requester);
+   else
+      _dram_cntlr->getDataFromDram(address, data_buf, msg_modeled, requester);
+}
+
 void
 DramDirectoryCntlr::sendDataToDram(IntPtr address, Byte* data_buf, bool modeled)
 {
+   // A clean EXCLUSIVE line comes back without data, DRAM is up to date
+   if (data_buf == NULL)
+      return;
+
    // Write data to Dram
-   _dram_cntlr->putDataToDram(address, data_buf, modeled);
+   if (_l3_cache_cntlr)
+      _l3_cache_cntlr->putDataToDram(address, data_buf, modeled);
+   else
+      _dram_cntlr->putDataToDram(address, data_buf, modeled);
 }
 
-UInt32
-DramDirectoryCntlr::getCacheLineSize()
+bool
+DramDirectoryCntlr::addSharer(DirectoryEntry* directory_entry, tile_id_t sharer_id)
 {
-   return _memory_manager->getCacheLineSize();
+   SInt32 old_sharer_count = directory_entry->getNumSharers();
+   bool add_result = directory_entry->addSharer(sharer_id);
+   Directory::updateSharerStats(old_sharer_count, directory_entry->getNumSharers());
+   return add_result;
+}
+
+void
+DramDirectoryCntlr::removeSharer(DirectoryEntry* directory_entry, tile_id_t sharer_id)
+{
+   SInt32 old_sharer_count = directory_entry->getNumSharers();
+   directory_entry->removeSharer(sharer_id);
+   Directory::updateSharerStats(old_sharer_count, directory_entry->getNumSharers());
+}
+
+void
+DramDirectoryCntlr::outputSummary(ostream& out)
+{
+   out << "Dram Directory Cntlr: " << endl;
+   out << "    Shared Requests: " << _total_sh_reqs << endl;
+   out << "    Coalesced Shared Requests: " << _total_coalesced_sh_reqs << endl;
+   out << "    Exclusive Replies: " << _total_exclusive_reps << endl;
+   out << "    Atomic Requests: " << _total_atomic_reqs << endl;
+   out << "    Far Atomics: " << _total_far_atomics << endl;
+   out << "    Private Page Requests: " << _total_private_reqs << endl;
+   out << "    Untracked Evictions: " << _total_untracked_evictions << endl;
+}
+
+void
+DramDirectoryCntlr::dummyOutputSummary(ostream& out)
+{
+   out << "Dram Directory Cntlr: " << endl;
+   out << "    Shared Requests: " << endl;
+   out << "    Coalesced Shared Requests: " << endl;
+   out << "    Exclusive Replies: " << endl;
+   out << "    Atomic Requests: " << endl;
+   out << "    Far Atomics: " << endl;
+   out << "    Private Page Requests: " << endl;
+   out << "    Untracked Evictions: " << endl;
 }
 
-ShmemPerfModel*
-DramDirectoryCntlr::getShmemPerfModel()
+UInt32
+DramDirectoryCntlr::getCacheLineSize()
 {
-   return _memory_manager->getShmemPerfModel();
+   return _memory_manager->getCacheLineSize();
 }
 
 }
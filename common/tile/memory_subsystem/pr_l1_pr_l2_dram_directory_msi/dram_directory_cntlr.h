@@ -1,7 +1,9 @@
 #pragma once
 
 #include <string>
+#include <map>
 using std::string;
+using std::map;
 
 // Forward Decls
 namespace PrL1PrL2DramDirectoryMSI
@@ -11,7 +13,9 @@ namespace PrL1PrL2DramDirectoryMSI
 
 #include "directory_cache.h"
 #include "hash_map_queue.h"
+#include "object_pool.h"
 #include "dram_cntlr.h"
+#include "l3_cache_cntlr.h"
 #include "address_home_lookup.h"
 #include "shmem_req.h"
 #include "shmem_msg.h"
@@ -31,36 +35,104 @@ namespace PrL1PrL2DramDirectoryMSI
             UInt32 dram_directory_max_hw_sharers,
             string dram_directory_type_str,
             string dram_directory_access_time_str,
-            UInt32 num_dram_cntlrs);
+            UInt32 num_dram_cntlrs,
+            bool multicast_invalidations,
+            bool coalesce_sh_reqs,
+            bool exclusive_state,
+            UInt32 far_atomics_sharers_threshold,
+            UInt32 far_atomics_contention_threshold);
       ~DramDirectoryCntlr();
 
       void handleMsgFromL2Cache(tile_id_t sender, ShmemMsg* shmem_msg);
       
       DirectoryCache* getDramDirectoryCache() { return _dram_directory_cache; }
+      // The DRAM accesses go through the L3 cache slice when there is one
+      void setL3CacheCntlr(L3CacheCntlr* l3_cache_cntlr) { _l3_cache_cntlr = l3_cache_cntlr; }
+      // The clock of the tile, or the one of the sim thread of a directory shard
+      void setShmemPerfModel(ShmemPerfModel* shmem_perf_model) { _shmem_perf_model = shmem_perf_model; }
+
+      void outputSummary(ostream& out);
+      static void dummyOutputSummary(ostream& out);
    
    private:
       // Functional Models
       MemoryManager* _memory_manager;
       DirectoryCache* _dram_directory_cache;
       DramCntlr* _dram_cntlr;
+      L3CacheCntlr* _l3_cache_cntlr;
+      ShmemPerfModel* _shmem_perf_model;
       HashMapQueue<IntPtr,ShmemReq*>* _dram_directory_req_queue_list;
+      // Storage of the queued ShmemReqs, recycled
+      ObjectPool<ShmemReq> _shmem_req_pool;
+
+      // Send the invalidations to many sharers as one multicast
+      bool _multicast_invalidations;
+      // Answer the SH_REQs queued behind an SH_REQ with the data it got
+      bool _coalesce_sh_reqs;
+      // MESI: a SH_REQ for an uncached line gets the line in the EXCLUSIVE state
+      bool _exclusive_state;
+
+      // Far atomics: an ATOMIC_REQ is performed at the home (far) when the
+      // line has at least '_far_atomics_sharers_threshold' other sharers, or
+      // when the contention counter of the line reached
+      // '_far_atomics_contention_threshold'. Otherwise it is an EX_REQ (near)
+      struct AtomicHistory
+      {
+         AtomicHistory() : last_requester(INVALID_TILE_ID), contention(0) {}
+         tile_id_t last_requester;
+         // Saturating, up when an atomic finds the line with another tile
+         // (a sharer or the last atomic), down otherwise
+         UInt32 contention;
+      };
+      static const UInt32 MAX_ATOMIC_CONTENTION = 3;
+      UInt32 _far_atomics_sharers_threshold;
+      UInt32 _far_atomics_contention_threshold;
+      map<IntPtr,AtomicHistory> _atomic_history;
+
+      // Event Counters
+      UInt64 _total_sh_reqs;
+      UInt64 _total_coalesced_sh_reqs;
+      UInt64 _total_exclusive_reps;
+      UInt64 _total_atomic_reqs;
+      UInt64 _total_far_atomics;
+      UInt64 _total_private_reqs;
+      UInt64 _total_untracked_evictions;
 
       UInt32 getCacheLineSize();
       MemoryManager* getMemoryManager() { return _memory_manager; }
-      ShmemPerfModel* getShmemPerfModel();
+      ShmemPerfModel* getShmemPerfModel() { return _shmem_perf_model; }
 
       // Private Functions
       DirectoryEntry* processDirectoryEntryAllocationReq(ShmemReq* shmem_req);
       void processNullifyReq(ShmemReq* shmem_req);
+      // The line was cached untracked by the owner of its (now shared) page
+      void trackUntrackedLine(DirectoryEntry* directory_entry, IntPtr address);
+      void sendInvReqToSharers(DirectoryEntry* directory_entry, tile_id_t requester, IntPtr address, bool msg_modeled);
+
+      // Update the sharers of an entry along with the sharer stats
+      bool addSharer(DirectoryEntry* directory_entry, tile_id_t sharer_id);
+      void removeSharer(DirectoryEntry* directory_entry, tile_id_t sharer_id);
 
-      void processNextReqFromL2Cache(IntPtr address);
+      void processNextReqFromL2Cache(IntPtr address, Byte* coalesce_data_buf = NULL);
+      // The request at the front of the queue of its line
+      void processReqFromL2Cache(ShmemReq* shmem_req);
+      // Misses and evictions of the lines of private pages (PageClassifier),
+      // true if handled without the directory
+      bool processPrivateReq(ShmemReq* shmem_req);
+      bool processUntrackedEviction(tile_id_t sender, ShmemMsg* shmem_msg);
+      void coalesceShReqs(IntPtr address, Byte* data_buf);
+      void sendShRepToL2Cache(IntPtr address, tile_id_t requester, Byte* cached_data_buf, bool msg_modeled);
       void processExReqFromL2Cache(ShmemReq* shmem_req, Byte* cached_data_buf = NULL);
       void processShReqFromL2Cache(ShmemReq* shmem_req, Byte* cached_data_buf = NULL);
+      void processAtomicReqFromL2Cache(ShmemReq* shmem_req, Byte* cached_data_buf = NULL);
+      bool isFarAtomic(DirectoryEntry* directory_entry, tile_id_t requester, IntPtr address);
       void retrieveDataAndSendToL2Cache(ShmemMsg::Type reply_msg_type, tile_id_t receiver, IntPtr address, Byte* cached_data_buf, bool msg_modeled);
 
       void processInvRepFromL2Cache(tile_id_t sender, ShmemMsg* shmem_msg);
       void processFlushRepFromL2Cache(tile_id_t sender, ShmemMsg* shmem_msg);
       void processWbRepFromL2Cache(tile_id_t sender, ShmemMsg* shmem_msg);
+      void processAtomicWbRepFromL2Cache(tile_id_t sender, ShmemMsg* shmem_msg);
+      void getDataFromDram(IntPtr address, tile_id_t requester, Byte* data_buf, bool msg_modeled);
       void sendDataToDram(IntPtr address, Byte* data_buf, bool msg_modeled);
    };
 }
@@ -18,9 +18,12 @@ L1CacheCntlr::L1CacheCntlr(MemoryManager* memory_manager,
                            string l1_dcache_replacement_policy,
                            UInt32 l1_dcache_access_delay,
                            bool l1_dcache_track_miss_types,
+                           UInt32 write_combining_buffer_entries,
+                           UInt32 write_combining_drain_latency,
                            float frequency)
    : _memory_manager(memory_manager)
    , _l2_cache_cntlr(NULL)
+   , _write_combining_buffer(NULL)
 {
    _l1_icache_replacement_policy_obj = 
       CacheReplacementPolicy::create(l1_icache_replacement_policy, l1_icache_size, l1_icache_associativity, cache_line_size);
@@ -55,10 +58,17 @@ L1CacheCntlr::L1CacheCntlr(MemoryManager* memory_manager,
          l1_dcache_access_delay,
          frequency,
          l1_icache_track_miss_types);
+
+   if (write_combining_buffer_entries > 0)
+   {
+      _write_combining_buffer = new WriteCombiningBuffer(write_combining_buffer_entries, cache_line_size,
+                                                         write_combining_drain_latency);
+   }
 }
 
 L1CacheCntlr::~L1CacheCntlr()
 {
+   delete _write_combining_buffer;
    delete _l1_icache;
    delete _l1_dcache;
    delete _l1_icache_replacement_policy_obj;
@@ -86,6 +96,11 @@ L1CacheCntlr::processMemOpFromTile(MemComponent::Type mem_component,
 
    bool l1_cache_hit = true;
    UInt32 access_num = 0;
+   bool in_caller_miss = false;
+
+   // An atomic sees the earlier stores in the L2 cache
+   if (lock_signal == Core::LOCK)
+      drainWriteCombiningBuffer(true);
 
    while(1)
    {
@@ -94,10 +109,24 @@ L1CacheCntlr::processMemOpFromTile(MemComponent::Type mem_component,
                        "access_num(%u)", access_num);
 
       // Wake up the network thread after acquiring the lock
-      if (access_num == 2)
+      if ((access_num == 2) && !in_caller_miss)
       {
          _memory_manager->wakeUpSimThread();
       }
+      else
+      {
+         // The line may still be on its way from a miss that completes
+         // later in simulated time
+         _l2_cache_cntlr->waitForOutstandingMiss(ca_address);
+      }
+
+      // The atomic is performed at the home of the line (far atomics)
+      if ( (lock_signal != Core::NONE) &&
+           _l2_cache_cntlr->accessFarAtomicLine(mem_op_type, ca_address, offset, data_buf, data_length) )
+      {
+         getMemoryManager()->incrCycleCount(mem_component, CachePerfModel::ACCESS_CACHE_DATA_AND_TAGS);
+         return l1_cache_hit;
+      }
 
       if (operationPermissibleinL1Cache(mem_component, ca_address, mem_op_type, access_num))
       {
@@ -117,6 +146,10 @@ L1CacheCntlr::processMemOpFromTile(MemComponent::Type mem_component,
       
       LOG_ASSERT_ERROR(lock_signal != Core::UNLOCK, "Expected to find address(%#lx) in L1 Cache", ca_address);
 
+      // The L2 cache may evict or refill a line with stores in the
+      // write-combining buffer
+      drainWriteCombiningBuffer(false);
+
       // Invalidate the cache line before passing the request to L2 Cache
       invalidateCacheLine(mem_component, ca_address);
 
@@ -144,18 +177,52 @@ L1CacheCntlr::processMemOpFromTile(MemComponent::Type mem_component,
       // Is the miss type modeled? If yes, all the msgs' created by this miss are modeled 
       bool msg_modeled = Config::getSingleton()->isApplicationTile(getTileId());
       ShmemMsg::Type shmem_msg_type = getShmemMsgType(mem_op_type);
+      // The home of the line may perform the atomic (far atomics)
+      if ((lock_signal == Core::LOCK) && (shmem_msg_type == ShmemMsg::EX_REQ))
+         shmem_msg_type = ShmemMsg::ATOMIC_REQ;
 
       // Construct the message and send out a request to the SIM thread for the cache data
       ShmemMsg shmem_msg(shmem_msg_type, mem_component, MemComponent::L2_CACHE, getTileId(), ca_address, msg_modeled);
-      getMemoryManager()->sendMsg(getTileId(), shmem_msg);
+      // In functional warmup (and with synchronous coherence), the APP thread
+      // completes the miss itself
+      in_caller_miss = _memory_manager->processFunctionalWarmupMiss(shmem_msg) ||
+                       _memory_manager->processSynchronousMiss(shmem_msg);
+      if (!in_caller_miss)
+      {
+         getMemoryManager()->sendMsg(getTileId(), shmem_msg);
 
-      _memory_manager->waitForSimThread();
+         _memory_manager->waitForSimThread();
+      }
    }
 
    LOG_PRINT_ERROR("Should not reach here");
    return false;
 }
 
+bool
+L1CacheCntlr::probeL1Hit(MemComponent::Type mem_component,
+                         IntPtr ca_address, UInt32 offset,
+                         Byte* data_buf, UInt32 data_length)
+{
+   return getL1Cache(mem_component)->probeCacheLine(ca_address + offset, data_buf, data_length);
+}
+
+void
+L1CacheCntlr::replayL1Hit(MemComponent::Type mem_component, IntPtr ca_address, bool in_order)
+{
+   Cache* l1_cache = getL1Cache(mem_component);
+
+   // Same updates as a hit in processMemOpFromTile(). A line filled again
+   // since the hit must not be touched, it is not the one that was read
+   l1_cache->updateMissCounters(ca_address, Core::READ, false);
+   if (!in_order)
+      return;
+
+   CacheState::Type cstate = getCacheLineState(mem_component, ca_address);
+   if (CacheState(cstate).readable())
+      l1_cache->accessCacheLine(ca_address, Cache::LOAD);
+}
+
 void
 L1CacheCntlr::accessCache(MemComponent::Type mem_component,
       Core::mem_op_t mem_op_type, IntPtr ca_address, UInt32 offset,
@@ -172,13 +239,98 @@ L1CacheCntlr::accessCache(MemComponent::Type mem_component,
    case Core::WRITE:
       l1_cache->accessCacheLine(ca_address + offset, Cache::STORE, data_buf, data_length);
       // Write-through cache - Write the L2 Cache also
-      _l2_cache_cntlr->writeCacheLine(ca_address, offset, data_buf, data_length);
+      writeL2CacheLine(ca_address, offset, data_buf, data_length);
       break;
 
    default:
       LOG_PRINT_ERROR("Unsupported Mem Op Type: %u", mem_op_type);
       break;
    }
+
+   // The line utilization of the L2 cache counts the accesses to its copy
+   _l2_cache_cntlr->getL2Cache()->markAccessedWords(ca_address + offset, data_length);
+}
+
+void
+L1CacheCntlr::writeL2CacheLine(IntPtr ca_address, UInt32 offset, Byte* data_buf, UInt32 data_length)
+{
+   if (!_write_combining_buffer)
+   {
+      _l2_cache_cntlr->writeCacheLine(ca_address, offset, data_buf, data_length);
+      return;
+   }
+
+   bool modeled = _l1_dcache->isEnabled();
+   if (!_write_combining_buffer->write(ca_address, offset, data_buf, data_length, modeled))
+   {
+      // All the entries are taken, wait for the oldest line to start draining
+      UInt64 curr_time = getShmemPerfModel()->getCycleCount();
+      UInt64 start_time = drainWriteCombiningLine(_write_combining_buffer->getOldestAddress(), curr_time);
+      if (getShmemPerfModel()->isEnabled())
+      {
+         _write_combining_buffer->countStall(start_time - curr_time, modeled);
+         getShmemPerfModel()->updateCycleCount(start_time);
+      }
+
+      bool written = _write_combining_buffer->write(ca_address, offset, data_buf, data_length, modeled);
+      LOG_ASSERT_ERROR(written, "Write-combining buffer full after draining a line");
+   }
+}
+
+UInt64
+L1CacheCntlr::drainWriteCombiningLine(IntPtr address, UInt64 time)
+{
+   Byte data_buf[getCacheLineSize()];
+   vector<bool> written;
+   bool removed = _write_combining_buffer->remove(address, data_buf, written);
+   LOG_ASSERT_ERROR(removed, "Address(%#lx) not in the write-combining buffer", address);
+
+   // One L2 cache write per run of written bytes
+   UInt32 num_writes = 0;
+   UInt32 offset = 0;
+   while (offset < written.size())
+   {
+      if (!written[offset])
+      {
+         offset ++;
+         continue;
+      }
+      UInt32 end = offset;
+      while ((end < written.size()) && written[end])
+         end ++;
+      _l2_cache_cntlr->writeCacheLine(address, offset, &data_buf[offset], end - offset);
+      num_writes ++;
+      offset = end;
+   }
+
+   bool modeled = _l1_dcache->isEnabled();
+   _write_combining_buffer->countL2Writes(num_writes, modeled);
+   return _write_combining_buffer->drain(time, modeled);
+}
+
+void
+L1CacheCntlr::drainWriteCombiningBuffer(bool wait_for_drain)
+{
+   if (!_write_combining_buffer || _write_combining_buffer->isEmpty())
+      return;
+
+   UInt64 curr_time = getShmemPerfModel()->getCycleCount();
+   while (!_write_combining_buffer->isEmpty())
+      drainWriteCombiningLine(_write_combining_buffer->getOldestAddress(), curr_time);
+
+   UInt64 completion_time = _write_combining_buffer->getDrainCompletionTime();
+   if (wait_for_drain && getShmemPerfModel()->isEnabled() && (completion_time > curr_time))
+   {
+      _write_combining_buffer->countStall(completion_time - curr_time, _l1_dcache->isEnabled());
+      getShmemPerfModel()->updateCycleCount(completion_time);
+   }
+}
+
+void
+L1CacheCntlr::outputSummary(std::ostream& out)
+{
+   if (_write_combining_buffer)
+      _write_combining_buffer->outputSummary(out);
 }
 
 bool
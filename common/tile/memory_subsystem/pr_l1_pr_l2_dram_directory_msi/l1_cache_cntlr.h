@@ -18,6 +18,7 @@ namespace PrL1PrL2DramDirectoryMSI
 #include "shmem_perf_model.h"
 #include "cache_replacement_policy.h"
 #include "cache_hash_fn.h"
+#include "write_combining_buffer.h"
 
 namespace PrL1PrL2DramDirectoryMSI
 {
@@ -36,6 +37,8 @@ namespace PrL1PrL2DramDirectoryMSI
                    string l1_dcache_replacement_policy,
                    UInt32 l1_dcache_access_delay,
                    bool l1_dcache_track_miss_types,
+                   UInt32 write_combining_buffer_entries,
+                   UInt32 write_combining_drain_latency,
                    float frequency);
       ~L1CacheCntlr();
 
@@ -51,6 +54,15 @@ namespace PrL1PrL2DramDirectoryMSI
             Byte* data_buf, UInt32 data_length,
             bool modeled);
 
+      // L1 read hit fast path: probeL1Hit() reads the line without the
+      // memory manager lock, replayL1Hit() later applies the replacement and
+      // counter updates of the hit under the lock. A hit that is not
+      // 'in_order' (the caches may have changed since) only updates the counters
+      bool probeL1Hit(MemComponent::Type mem_component,
+            IntPtr ca_address, UInt32 offset,
+            Byte* data_buf, UInt32 data_length);
+      void replayL1Hit(MemComponent::Type mem_component, IntPtr ca_address, bool in_order);
+
       void insertCacheLine(MemComponent::Type mem_component,
             IntPtr address, CacheState::Type cstate, Byte* fill_buf,
             bool* eviction, IntPtr* evicted_address);
@@ -59,6 +71,13 @@ namespace PrL1PrL2DramDirectoryMSI
       void setCacheLineState(MemComponent::Type mem_component, IntPtr address, CacheState::Type cstate);
       void invalidateCacheLine(MemComponent::Type mem_component, IntPtr address);
 
+      // Write the lines in the write-combining buffer to the L2 cache. Before
+      // the L2 cache handles a msg, on an L1 miss and before an atomic (the
+      // only one that waits for the lines to drain)
+      void drainWriteCombiningBuffer(bool wait_for_drain);
+
+      void outputSummary(std::ostream& out);
+
    private:
       MemoryManager* _memory_manager;
       Cache* _l1_icache;
@@ -68,11 +87,16 @@ namespace PrL1PrL2DramDirectoryMSI
       CacheHashFn* _l1_icache_hash_fn_obj;
       CacheHashFn* _l1_dcache_hash_fn_obj;
       L2CacheCntlr* _l2_cache_cntlr;
+      // NULL: every store is written through to the L2 cache
+      WriteCombiningBuffer* _write_combining_buffer;
 
       void accessCache(MemComponent::Type mem_component,
             Core::mem_op_t mem_op_type, 
             IntPtr ca_address, UInt32 offset,
             Byte* data_buf, UInt32 data_length);
+      void writeL2CacheLine(IntPtr ca_address, UInt32 offset,
+            Byte* data_buf, UInt32 data_length);
+      UInt64 drainWriteCombiningLine(IntPtr address, UInt64 time);
       bool operationPermissibleinL1Cache(MemComponent::Type mem_component,
             IntPtr address, Core::mem_op_t mem_op_type,
             UInt32 access_num);
@@ -1,6 +1,11 @@
+#include <cstring>
+
 #include "l1_cache_cntlr.h"
 #include "l2_cache_cntlr.h"
 #include "memory_manager.h"
+#include "tile.h"
+#include "core.h"
+#include "spin_detector.h"
 #include "log.h"
 
 namespace PrL1PrL2DramDirectoryMSI
@@ -15,13 +20,46 @@ L2CacheCntlr::L2CacheCntlr(MemoryManager* memory_manager,
                            string l2_cache_replacement_policy,
                            UInt32 l2_cache_access_delay,
                            bool l2_cache_track_miss_types,
+                           string l2_cache_prefetcher,
+                           UInt32 l2_cache_prefetch_degree,
+                           UInt32 l2_cache_max_outstanding_prefetches,
+                           UInt32 l2_cache_num_mshrs,
+                           CacheCompressor* l2_cache_compressor,
+                           bool exclusive_state,
+                           bool far_atomics,
                            float frequency)
    : _memory_manager(memory_manager)
+   , _l2_cache_compressor(l2_cache_compressor)
    , _l1_cache_cntlr(l1_cache_cntlr)
    , _dram_directory_home_lookup(dram_directory_home_lookup)
+   , _outstanding_shmem_msg_mshr_time(UINT64_MAX_)
+   , _mshr_file(NULL)
+   , _total_mshr_full_stalls(0)
+   , _total_mshr_full_stall_cycles(0)
+   , _total_mshr_merges(0)
+   , _total_mshr_merge_cycles(0)
+   , _exclusive_state(exclusive_state)
+   , _total_exclusive_fills(0)
+   , _total_silent_upgrades(0)
+   , _far_atomics(far_atomics)
+   , _far_atomic_address(INVALID_ADDRESS)
+   , _far_atomic_buf(NULL)
+   , _far_atomic_modeled(false)
+   , _total_far_atomics(0)
+   , _max_outstanding_prefetches(l2_cache_max_outstanding_prefetches)
+   , _demand_waiting_for_prefetch_type(ShmemMsg::INVALID_MSG_TYPE)
+   , _demand_waiting_for_prefetch_modeled(false)
+   , _total_prefetches_issued(0)
+   , _total_useful_prefetches(0)
+   , _total_late_prefetches(0)
+   , _total_unused_prefetches(0)
+   , _total_uncovered_misses(0)
 {
+   // A compressed cache has tag_factor times more ways of tags, over the same sets
+   UInt32 tag_factor = _l2_cache_compressor ? _l2_cache_compressor->getTagFactor() : 1;
    _l2_cache_replacement_policy_obj = 
-      CacheReplacementPolicy::create(l2_cache_replacement_policy, l2_cache_size, l2_cache_associativity, cache_line_size);
+      CacheReplacementPolicy::create(l2_cache_replacement_policy, l2_cache_size * tag_factor,
+                                     l2_cache_associativity * tag_factor, cache_line_size);
    _l2_cache_hash_fn_obj = new CacheHashFn(l2_cache_size, l2_cache_associativity, cache_line_size);
    
    _l2_cache = new Cache("L2",
@@ -36,19 +74,35 @@ L2CacheCntlr::L2CacheCntlr(MemoryManager* memory_manager,
          _l2_cache_hash_fn_obj,
          l2_cache_access_delay,
          frequency,
-         l2_cache_track_miss_types);
+         l2_cache_track_miss_types,
+         _l2_cache_compressor);
+
+   _prefetcher = Prefetcher::create(l2_cache_prefetcher, cache_line_size, l2_cache_prefetch_degree);
+
+   // 0 MSHRs: the number of outstanding misses is not modeled
+   if (l2_cache_num_mshrs > 0)
+      _mshr_file = new MSHRFile(l2_cache_num_mshrs);
+
+   if (_far_atomics)
+      _far_atomic_buf = new Byte[cache_line_size];
 }
 
 L2CacheCntlr::~L2CacheCntlr()
 {
+   delete [] _far_atomic_buf;
+   delete _mshr_file;
+   delete _prefetcher;
    delete _l2_cache;
    delete _l2_cache_replacement_policy_obj;
    delete _l2_cache_hash_fn_obj;
+   delete _l2_cache_compressor;
 }
 
 void
 L2CacheCntlr::invalidateCacheLine(IntPtr address, PrL2CacheLineInfo& l2_cache_line_info)
 {
+   if (l2_cache_line_info.isPrefetched() && _l2_cache->isEnabled())
+      _total_unused_prefetches ++;
    l2_cache_line_info.invalidate();
    _l2_cache->setCacheLineInfo(address, &l2_cache_line_info);
 }
@@ -63,16 +117,35 @@ void
 L2CacheCntlr::writeCacheLine(IntPtr address, UInt32 offset, Byte* data_buf, UInt32 data_length)
 {
    _l2_cache->accessCacheLine(address + offset, Cache::STORE, data_buf, data_length);
+
+   if (_exclusive_state)
+   {
+      PrL2CacheLineInfo l2_cache_line_info;
+      _l2_cache->getCacheLineInfo(address, &l2_cache_line_info);
+      if (l2_cache_line_info.getCState() == CacheState::EXCLUSIVE)
+      {
+         // E -> M, the directory already has this tile as the owner
+         l2_cache_line_info.setCState(CacheState::MODIFIED);
+         _l2_cache->setCacheLineInfo(address, &l2_cache_line_info);
+         setCacheLineStateInL1(MemComponent::L1_DCACHE, address, CacheState::MODIFIED);
+         if (_l2_cache->isEnabled())
+            _total_silent_upgrades ++;
+      }
+   }
 }
 
 void
-L2CacheCntlr::insertCacheLine(IntPtr address, CacheState::Type cstate, Byte* fill_buf, MemComponent::Type mem_component)
+L2CacheCntlr::insertCacheLine(IntPtr address, CacheState::Type cstate, Byte* fill_buf, MemComponent::Type mem_component,
+                              bool prefetched)
 {
    // Construct meta-data info about l2 cache line
    PrL2CacheLineInfo l2_cache_line_info;
    l2_cache_line_info.setTag(_l2_cache->getTag(address));
    l2_cache_line_info.setCState(cstate);
-   l2_cache_line_info.setCachedLoc(mem_component);
+   // Prefetched lines are not in the L1 cache
+   if (mem_component != MemComponent::INVALID)
+      l2_cache_line_info.setCachedLoc(mem_component);
+   l2_cache_line_info.setPrefetched(prefetched);
 
    // Evicted line information
    bool eviction;
@@ -84,28 +157,46 @@ L2CacheCntlr::insertCacheLine(IntPtr address, CacheState::Type cstate, Byte* fil
                               &eviction, &evicted_address, &evicted_cache_line_info, writeback_buf);
 
    if (eviction)
-   {
-      LOG_PRINT("Eviction: address(%#lx)", evicted_address);
-      invalidateCacheLineInL1(evicted_cache_line_info.getCachedLoc(), evicted_address);
+      evictCacheLine(evicted_address, evicted_cache_line_info, writeback_buf);
 
-      UInt32 home_node_id = getHome(evicted_address);
-      bool eviction_msg_modeled = Config::getSingleton()->isApplicationTile(getTileId());
+   // The data of the line may not fit in a compressed set yet
+   while (_l2_cache->evictCacheLineForSpace(address, &evicted_address, &evicted_cache_line_info, writeback_buf))
+      evictCacheLine(evicted_address, evicted_cache_line_info, writeback_buf);
+}
 
-      if (evicted_cache_line_info.getCState() == CacheState::MODIFIED)
-      {
-         // Send back the data also
-         ShmemMsg msg(ShmemMsg::FLUSH_REP, MemComponent::L2_CACHE, MemComponent::DRAM_DIRECTORY, getTileId(), evicted_address,
-                      writeback_buf, getCacheLineSize(), eviction_msg_modeled);
-         getMemoryManager()->sendMsg(home_node_id, msg);
-      }
-      else
-      {
-         LOG_ASSERT_ERROR(evicted_cache_line_info.getCState() == CacheState::SHARED,
-               "evicted_address(%#lx), cache state(%u), cached loc(%u)",
-               evicted_address, evicted_cache_line_info.getCState(), evicted_cache_line_info.getCachedLoc());
-         ShmemMsg msg(ShmemMsg::INV_REP, MemComponent::L2_CACHE, MemComponent::DRAM_DIRECTORY, getTileId(), evicted_address, eviction_msg_modeled);
-         getMemoryManager()->sendMsg(home_node_id, msg);
-      }
+void
+L2CacheCntlr::evictCacheLine(IntPtr evicted_address, PrL2CacheLineInfo& evicted_cache_line_info, Byte* writeback_buf)
+{
+   LOG_PRINT("Eviction: address(%#lx)", evicted_address);
+   invalidateCacheLineInL1(evicted_cache_line_info.getCachedLoc(), evicted_address);
+
+   if (evicted_cache_line_info.isPrefetched() && _l2_cache->isEnabled())
+      _total_unused_prefetches ++;
+
+   UInt32 home_node_id = getHome(evicted_address);
+   bool eviction_msg_modeled = Config::getSingleton()->isApplicationTile(getTileId());
+
+   if (evicted_cache_line_info.getCState() == CacheState::MODIFIED)
+   {
+      // Send back the data also
+      ShmemMsg msg(ShmemMsg::FLUSH_REP, MemComponent::L2_CACHE, MemComponent::DRAM_DIRECTORY, getTileId(), evicted_address,
+                   writeback_buf, getCacheLineSize(), eviction_msg_modeled);
+      getMemoryManager()->sendMsg(home_node_id, msg);
+   }
+   else if (evicted_cache_line_info.getCState() == CacheState::EXCLUSIVE)
+   {
+      // Clean, the directory only has to know that the owner is gone
+      ShmemMsg msg(ShmemMsg::FLUSH_REP, MemComponent::L2_CACHE, MemComponent::DRAM_DIRECTORY, getTileId(), evicted_address,
+                   eviction_msg_modeled);
+      getMemoryManager()->sendMsg(home_node_id, msg);
+   }
+   else
+   {
+      LOG_ASSERT_ERROR(evicted_cache_line_info.getCState() == CacheState::SHARED,
+            "evicted_address(%#lx), cache state(%u), cached loc(%u)",
+            evicted_address, evicted_cache_line_info.getCState(), evicted_cache_line_info.getCachedLoc());
+      ShmemMsg msg(ShmemMsg::INV_REP, MemComponent::L2_CACHE, MemComponent::DRAM_DIRECTORY, getTileId(), evicted_address, eviction_msg_modeled);
+      getMemoryManager()->sendMsg(home_node_id, msg);
    }
 }
 
@@ -160,6 +251,26 @@ L2CacheCntlr::insertCacheLineInHierarchy(IntPtr address, CacheState::Type cstate
    insertCacheLineInL1(mem_component, address, cstate, fill_buf);
 }
 
+void
+L2CacheCntlr::waitForOutstandingMiss(IntPtr address)
+{
+   if (!_mshr_file)
+      return;
+
+   UInt64 curr_time = getShmemPerfModel()->getCycleCount();
+   UInt64 completion_time = _mshr_file->getCompletionTime(address, curr_time);
+   if (completion_time > curr_time)
+   {
+      // Merged with the miss that is filling the line
+      if (_l2_cache->isEnabled())
+      {
+         _total_mshr_merges ++;
+         _total_mshr_merge_cycles += (completion_time - curr_time);
+      }
+      getShmemPerfModel()->setCycleCount(completion_time);
+   }
+}
+
 pair<bool,Cache::MissType>
 L2CacheCntlr::processShmemRequestFromL1Cache(MemComponent::Type mem_component, Core::mem_op_t mem_op_type, IntPtr address)
 {
@@ -169,6 +280,16 @@ L2CacheCntlr::processShmemRequestFromL1Cache(MemComponent::Type mem_component, C
    PrL2CacheLineInfo l2_cache_line_info;
    _l2_cache->getCacheLineInfo(address, &l2_cache_line_info);
 
+   // First access to a prefetched line, keep the stream going
+   if (l2_cache_line_info.isPrefetched())
+   {
+      if (_l2_cache->isEnabled())
+         _total_useful_prefetches ++;
+      l2_cache_line_info.setPrefetched(false);
+      _l2_cache->setCacheLineInfo(address, &l2_cache_line_info);
+      trainPrefetcher(address, Config::getSingleton()->isApplicationTile(getTileId()));
+   }
+
    // Get the state associated with the address in the L2 cache
    CacheState::Type cstate = l2_cache_line_info.getCState();
 
@@ -181,6 +302,8 @@ L2CacheCntlr::processShmemRequestFromL1Cache(MemComponent::Type mem_component, C
       
       // Read the cache line from L2 cache
       readCacheLine(address, data_buf);
+      // A compressed line is decompressed on its way to the L1 cache
+      getShmemPerfModel()->incrCycleCount(_l2_cache->getDecompressionLatency(address));
 
       // Insert the cache line in the L1 cache
       insertCacheLineInL1(mem_component, address, cstate, data_buf);
@@ -209,10 +332,40 @@ L2CacheCntlr::handleMsgFromL1Cache(ShmemMsg* shmem_msg)
    _outstanding_shmem_msg.setAddress(address);
    _outstanding_shmem_msg.setSenderMemComponent(sender_mem_component);
    _outstanding_shmem_msg_time = getShmemPerfModel()->getCycleCount();
+   _outstanding_shmem_msg_mshr_time = UINT64_MAX_;
+
+   if (_outstanding_prefetches.count(address) > 0)
+   {
+      // Merged with the MSHR of the prefetch
+      // The line is on its way, wait for it instead of requesting it again
+      if (_l2_cache->isEnabled())
+         _total_late_prefetches ++;
+      // An atomic waiting for the line is performed near
+      _demand_waiting_for_prefetch_type = (shmem_msg_type == ShmemMsg::SH_REQ) ? ShmemMsg::SH_REQ : ShmemMsg::EX_REQ;
+      _demand_waiting_for_prefetch_modeled = shmem_msg->isModeled();
+      return;
+   }
+
+   // Wait for a free MSHR before sending the request out
+   if (_mshr_file && shmem_msg->isModeled())
+   {
+      UInt64 allocation_time = _mshr_file->getAllocationTime(_outstanding_shmem_msg_time);
+      if (allocation_time > _outstanding_shmem_msg_time)
+      {
+         if (_l2_cache->isEnabled())
+         {
+            _total_mshr_full_stalls ++;
+            _total_mshr_full_stall_cycles += (allocation_time - _outstanding_shmem_msg_time);
+         }
+         getShmemPerfModel()->setCycleCount(allocation_time);
+      }
+      _outstanding_shmem_msg_mshr_time = allocation_time;
+   }
    
    switch (shmem_msg_type)
    {
       case ShmemMsg::EX_REQ:
+      case ShmemMsg::ATOMIC_REQ:
          processExReqFromL1Cache(shmem_msg);
          break;
 
@@ -224,6 +377,43 @@ L2CacheCntlr::handleMsgFromL1Cache(ShmemMsg* shmem_msg)
          LOG_PRINT_ERROR("Unrecognized shmem msg type (%u)", shmem_msg_type);
          break;
    }
+
+   if (_l2_cache->isEnabled())
+      _total_uncovered_misses ++;
+   trainPrefetcher(address, shmem_msg->isModeled());
+}
+
+void
+L2CacheCntlr::trainPrefetcher(IntPtr address, bool modeled)
+{
+   if (!_prefetcher)
+      return;
+
+   vector<IntPtr> prefetch_addresses;
+   _prefetcher->getPrefetchAddresses(address, prefetch_addresses);
+
+   for (vector<IntPtr>::iterator it = prefetch_addresses.begin(); it != prefetch_addresses.end(); it++)
+   {
+      IntPtr prefetch_address = *it;
+      if (_outstanding_prefetches.size() >= _max_outstanding_prefetches)
+         break;
+
+      // Skip lines that are present or already requested
+      if ( (prefetch_address == _outstanding_shmem_msg.getAddress()) ||
+           (_outstanding_prefetches.count(prefetch_address) > 0) )
+         continue;
+      PrL2CacheLineInfo l2_cache_line_info;
+      _l2_cache->getCacheLineInfo(prefetch_address, &l2_cache_line_info);
+      if (l2_cache_line_info.getCState() != CacheState::INVALID)
+         continue;
+
+      _outstanding_prefetches[prefetch_address] = getShmemPerfModel()->getCycleCount();
+      if (_l2_cache->isEnabled())
+         _total_prefetches_issued ++;
+
+      ShmemMsg msg(ShmemMsg::SH_REQ, MemComponent::L2_CACHE, MemComponent::DRAM_DIRECTORY, getTileId(), prefetch_address, modeled);
+      getMemoryManager()->sendMsg(getHome(prefetch_address), msg);
+   }
 }
 
 void
@@ -245,8 +435,15 @@ L2CacheCntlr::processExReqFromL1Cache(ShmemMsg* shmem_msg)
       getMemoryManager()->sendMsg(getHome(address), msg);
    }
 
-   // Send out EX_REQ to DRAM_DIRECTORY
-   ShmemMsg msg(ShmemMsg::EX_REQ, MemComponent::L2_CACHE, MemComponent::DRAM_DIRECTORY, getTileId(), address, shmem_msg->isModeled());
+   // The directory decides if an atomic is performed at the home, for one
+   // line at a time. Functional warmup keeps them near
+   ShmemMsg::Type req_type = ShmemMsg::EX_REQ;
+   if ( (shmem_msg->getType() == ShmemMsg::ATOMIC_REQ) && _far_atomics &&
+        (_far_atomic_address == INVALID_ADDRESS) && !_memory_manager->isHandlingFunctionalWarmupMsg() )
+      req_type = ShmemMsg::ATOMIC_REQ;
+
+   // Send out EX_REQ/ATOMIC_REQ to DRAM_DIRECTORY
+   ShmemMsg msg(req_type, MemComponent::L2_CACHE, MemComponent::DRAM_DIRECTORY, getTileId(), address, shmem_msg->isModeled());
    getMemoryManager()->sendMsg(getHome(address), msg);
 }
 
@@ -264,7 +461,19 @@ void
 L2CacheCntlr::handleMsgFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_msg)
 {
    ShmemMsg::Type shmem_msg_type = shmem_msg->getType();
-   switch (shmem_msg_type)
+
+   // The line may be read, invalidated or evicted with stores in the
+   // write-combining buffer of the L1-D cache
+   _l1_cache_cntlr->drainWriteCombiningBuffer(false);
+
+   if ( isDataRep(shmem_msg_type) && (_outstanding_prefetches.count(shmem_msg->getAddress()) > 0) )
+   {
+      // Replies to prefetches only complete a request from the L1 cache
+      // if one was waiting for the line
+      if (!processPrefetchRepFromDramDirectory(sender, shmem_msg))
+         return;
+   }
+   else switch (shmem_msg_type)
    {
       case ShmemMsg::EX_REP:
          processExRepFromDramDirectory(sender, shmem_msg);
@@ -272,6 +481,12 @@ L2CacheCntlr::handleMsgFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_msg)
       case ShmemMsg::SH_REP:
          processShRepFromDramDirectory(sender, shmem_msg);
          break;
+      case ShmemMsg::EXCLUSIVE_REP:
+         processExclusiveRepFromDramDirectory(sender, shmem_msg);
+         break;
+      case ShmemMsg::ATOMIC_REP:
+         processAtomicRepFromDramDirectory(sender, shmem_msg);
+         break;
       case ShmemMsg::INV_REQ:
          processInvReqFromDramDirectory(sender, shmem_msg);
          break;
@@ -286,7 +501,7 @@ L2CacheCntlr::handleMsgFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_msg)
          break;
    }
 
-   if ((shmem_msg_type == ShmemMsg::EX_REP) || (shmem_msg_type == ShmemMsg::SH_REP))
+   if (isDataRep(shmem_msg_type))
    {
       LOG_ASSERT_ERROR(_outstanding_shmem_msg_time <= getShmemPerfModel()->getCycleCount(),
                        "Outstanding msg time(%llu), Curr cycle count(%llu)",
@@ -298,12 +513,29 @@ L2CacheCntlr::handleMsgFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_msg)
 
       // Increment the clock by the time taken to update the L2 cache
       getMemoryManager()->incrCycleCount(MemComponent::L2_CACHE, CachePerfModel::ACCESS_CACHE_DATA_AND_TAGS);
+      getShmemPerfModel()->incrCycleCount(_l2_cache->getCompressionLatency(shmem_msg->getAddress()));
+
+      // The MSHR is held until the line is filled
+      if (_mshr_file && (_outstanding_shmem_msg_mshr_time != UINT64_MAX_))
+      {
+         _mshr_file->allocate(shmem_msg->getAddress(), _outstanding_shmem_msg_mshr_time,
+                              getShmemPerfModel()->getCycleCount());
+      }
 
       // There are no more outstanding memory requests
       _outstanding_shmem_msg.setAddress(INVALID_ADDRESS);
       
-      _memory_manager->wakeUpAppThread();
-      _memory_manager->waitForAppThread();
+      // In functional warmup, the APP thread is the one handling the reply.
+      // With synchronous coherence, the APP thread waits for the flag
+      if (_memory_manager->isSynchronousMissOutstanding())
+      {
+         _memory_manager->completeSynchronousMiss(getShmemPerfModel()->getCycleCount());
+      }
+      else if (!_memory_manager->isHandlingFunctionalWarmupMsg())
+      {
+         _memory_manager->wakeUpAppThread();
+         _memory_manager->waitForAppThread();
+      }
    }
 }
 
@@ -327,6 +559,111 @@ L2CacheCntlr::processShRepFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_ms
    insertCacheLineInHierarchy(address, CacheState::SHARED, data_buf);
 }
 
+void
+L2CacheCntlr::processExclusiveRepFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_msg)
+{
+   IntPtr address = shmem_msg->getAddress();
+   Byte* data_buf = shmem_msg->getDataBuf();
+
+   if (_l2_cache->isEnabled())
+      _total_exclusive_fills ++;
+
+   // Insert Cache Line in L1 and L2 Caches
+   insertCacheLineInHierarchy(address, CacheState::EXCLUSIVE, data_buf);
+}
+
+void
+L2CacheCntlr::processAtomicRepFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_msg)
+{
+   assert(_far_atomic_address == INVALID_ADDRESS);
+
+   // The line is not filled in the L1 and L2 caches, it stays at the home
+   _far_atomic_address = shmem_msg->getAddress();
+   _far_atomic_modeled = shmem_msg->isModeled();
+   memcpy(_far_atomic_buf, shmem_msg->getDataBuf(), getCacheLineSize());
+
+   if (_l2_cache->isEnabled())
+      _total_far_atomics ++;
+}
+
+bool
+L2CacheCntlr::accessFarAtomicLine(Core::mem_op_t mem_op_type, IntPtr address, UInt32 offset,
+                                  Byte* data_buf, UInt32 data_length)
+{
+   if (address != _far_atomic_address)
+      return false;
+
+   if (mem_op_type != Core::WRITE)
+   {
+      memcpy(data_buf, _far_atomic_buf + offset, data_length);
+      return true;
+   }
+
+   // The write completes the atomic, the home gets the line back and serves
+   // the next request for it. Off the critical path of the core
+   memcpy(_far_atomic_buf + offset, data_buf, data_length);
+   ShmemMsg msg(ShmemMsg::ATOMIC_WB_REP, MemComponent::L2_CACHE, MemComponent::DRAM_DIRECTORY, getTileId(), address,
+                _far_atomic_buf, getCacheLineSize(), _far_atomic_modeled);
+   getMemoryManager()->sendMsg(getHome(address), msg);
+
+   _far_atomic_address = INVALID_ADDRESS;
+   return true;
+}
+
+bool
+L2CacheCntlr::processPrefetchRepFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_msg)
+{
+   IntPtr address = shmem_msg->getAddress();
+   Byte* data_buf = shmem_msg->getDataBuf();
+   CacheState::Type cstate = CacheState::SHARED;
+   if (shmem_msg->getType() == ShmemMsg::EX_REP)
+      cstate = CacheState::MODIFIED;
+   else if (shmem_msg->getType() == ShmemMsg::EXCLUSIVE_REP)
+      cstate = CacheState::EXCLUSIVE;
+
+   map<IntPtr,UInt64>::iterator prefetch_it = _outstanding_prefetches.find(address);
+   UInt64 prefetch_issue_time = prefetch_it->second;
+   _outstanding_prefetches.erase(prefetch_it);
+
+   // Prefetches are bounded by max_outstanding_prefetches and do not take
+   // up MSHRs, but later accesses to the line wait until it is filled
+   if (_mshr_file && shmem_msg->isModeled())
+   {
+      _mshr_file->allocate(address, prefetch_issue_time, getShmemPerfModel()->getCycleCount(), false);
+   }
+
+   if (address != _outstanding_shmem_msg.getAddress())
+   {
+      // Nobody is waiting, the line goes to the L2 cache only
+      insertCacheLine(address, cstate, data_buf, MemComponent::INVALID, true);
+      if ((cstate == CacheState::EXCLUSIVE) && _l2_cache->isEnabled())
+         _total_exclusive_fills ++;
+      return false;
+   }
+
+   ShmemMsg::Type demand_type = _demand_waiting_for_prefetch_type;
+   _demand_waiting_for_prefetch_type = ShmemMsg::INVALID_MSG_TYPE;
+
+   if ((demand_type == ShmemMsg::SH_REQ) || CacheState(cstate).writable())
+   {
+      if ((cstate == CacheState::EXCLUSIVE) && _l2_cache->isEnabled())
+         _total_exclusive_fills ++;
+      insertCacheLineInHierarchy(address, cstate, data_buf);
+      return true;
+   }
+
+   // The L1 cache wants to write, upgrade the prefetched line
+   assert(demand_type == ShmemMsg::EX_REQ);
+   insertCacheLine(address, cstate, data_buf, MemComponent::INVALID);
+   // The upgrade takes over the MSHR of the prefetch
+   if (_mshr_file && _demand_waiting_for_prefetch_modeled)
+      _outstanding_shmem_msg_mshr_time = getShmemPerfModel()->getCycleCount();
+   ShmemMsg demand_msg(ShmemMsg::EX_REQ, _outstanding_shmem_msg.getSenderMemComponent(), MemComponent::L2_CACHE,
+                       getTileId(), address, _demand_waiting_for_prefetch_modeled);
+   processExReqFromL1Cache(&demand_msg);
+   return false;
+}
+
 void
 L2CacheCntlr::processInvReqFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_msg)
 {
@@ -337,6 +674,10 @@ L2CacheCntlr::processInvReqFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_m
    
    CacheState::Type cstate = l2_cache_line_info.getCState();
 
+   // A spin loop of the core may be polling the line (core/spin_detection)
+   if (cstate != CacheState::INVALID)
+      notifySpinDetector();
+
    if (cstate != CacheState::INVALID)
    {
       assert(cstate == CacheState::SHARED);
@@ -370,7 +711,27 @@ L2CacheCntlr::processFlushReqFromDramDirectory(tile_id_t sender, ShmemMsg* shmem
    PrL2CacheLineInfo l2_cache_line_info;
    _l2_cache->getCacheLineInfo(address, &l2_cache_line_info);
    CacheState::Type cstate = l2_cache_line_info.getCState();
+
+   // A spin loop of the core may be polling the line (core/spin_detection)
    if (cstate != CacheState::INVALID)
+      notifySpinDetector();
+   if (cstate == CacheState::EXCLUSIVE)
+   {
+      // Update Shared Mem perf counters for access to L2 Cache
+      getMemoryManager()->incrCycleCount(MemComponent::L2_CACHE, CachePerfModel::ACCESS_CACHE_TAGS);
+      // Update Shared Mem perf counters for access to L1 Cache
+      getMemoryManager()->incrCycleCount(l2_cache_line_info.getCachedLoc(), CachePerfModel::ACCESS_CACHE_TAGS);
+
+      // Invalidate the line in L1 and L2 Caches
+      invalidateCacheLineInL1(l2_cache_line_info.getCachedLoc(), address);
+      invalidateCacheLine(address, l2_cache_line_info);
+
+      // Clean line, send FLUSH_REP without the data
+      ShmemMsg msg(ShmemMsg::FLUSH_REP, MemComponent::L2_CACHE, MemComponent::DRAM_DIRECTORY, shmem_msg->getRequester(), address,
+                   shmem_msg->isModeled());
+      getMemoryManager()->sendMsg(sender, msg);
+   }
+   else if (cstate != CacheState::INVALID)
    {
       assert(cstate == CacheState::MODIFIED);
       
@@ -410,7 +771,24 @@ L2CacheCntlr::processWbReqFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_ms
    _l2_cache->getCacheLineInfo(address, &l2_cache_line_info);
    CacheState::Type cstate = l2_cache_line_info.getCState();
 
-   if (cstate != CacheState::INVALID)
+   if (cstate == CacheState::EXCLUSIVE)
+   {
+      // Update Shared Mem perf counters for access to L2 Cache
+      getMemoryManager()->incrCycleCount(MemComponent::L2_CACHE, CachePerfModel::ACCESS_CACHE_TAGS);
+      // Update Shared Mem perf counters for access to L1 Cache
+      getMemoryManager()->incrCycleCount(l2_cache_line_info.getCachedLoc(), CachePerfModel::ACCESS_CACHE_TAGS);
+
+      // E -> S in L1 and L2 Caches
+      setCacheLineStateInL1(l2_cache_line_info.getCachedLoc(), address, CacheState::SHARED);
+      l2_cache_line_info.setCState(CacheState::SHARED);
+      _l2_cache->setCacheLineInfo(address, &l2_cache_line_info);
+
+      // Clean line, send WB_REP without the data
+      ShmemMsg msg(ShmemMsg::WB_REP, MemComponent::L2_CACHE, MemComponent::DRAM_DIRECTORY, shmem_msg->getRequester(), address,
+                   shmem_msg->isModeled());
+      getMemoryManager()->sendMsg(sender, msg);
+   }
+   else if (cstate != CacheState::INVALID)
    {
       assert(cstate == CacheState::MODIFIED);
  
@@ -467,6 +845,76 @@ L2CacheCntlr::operationPermissibleinL2Cache(Core::mem_op_t mem_op_type, IntPtr a
    return make_pair(!cache_hit, cache_miss_type);
 }
 
+void
+L2CacheCntlr::outputSummary(std::ostream& out)
+{
+   outputPrefetcherSummary(out);
+   outputMSHRSummary(out);
+   outputExclusiveStateSummary(out);
+   outputFarAtomicsSummary(out);
+}
+
+void
+L2CacheCntlr::outputPrefetcherSummary(std::ostream& out)
+{
+   if (!_prefetcher)
+      return;
+
+   UInt64 covered_misses = _total_useful_prefetches + _total_late_prefetches;
+   out << "  Prefetcher L2:\n";
+   out << "    Prefetches Issued: " << _total_prefetches_issued << endl;
+   out << "    Useful Prefetches: " << _total_useful_prefetches << endl;
+   out << "    Late Prefetches: " << _total_late_prefetches << endl;
+   out << "    Unused Prefetches: " << _total_unused_prefetches << endl;
+   if (_total_prefetches_issued > 0)
+      out << "    Accuracy (%): " << 100.0 * covered_misses / _total_prefetches_issued << endl;
+   else
+      out << "    Accuracy (%): " << endl;
+   if ((covered_misses + _total_uncovered_misses) > 0)
+      out << "    Coverage (%): " << 100.0 * covered_misses / (covered_misses + _total_uncovered_misses) << endl;
+   else
+      out << "    Coverage (%): " << endl;
+   if (covered_misses > 0)
+      out << "    Timeliness (%): " << 100.0 * _total_useful_prefetches / covered_misses << endl;
+   else
+      out << "    Timeliness (%): " << endl;
+}
+
+void
+L2CacheCntlr::outputMSHRSummary(std::ostream& out)
+{
+   if (!_mshr_file)
+      return;
+
+   out << "  MSHRs L2:\n";
+   out << "    Num MSHRs: " << _mshr_file->getNumEntries() << endl;
+   out << "    Stalls (All MSHRs Busy): " << _total_mshr_full_stalls << endl;
+   out << "    Stall Cycles (All MSHRs Busy): " << _total_mshr_full_stall_cycles << endl;
+   out << "    Accesses Merged with Outstanding Misses: " << _total_mshr_merges << endl;
+   out << "    Merge Wait Cycles: " << _total_mshr_merge_cycles << endl;
+}
+
+void
+L2CacheCntlr::outputExclusiveStateSummary(std::ostream& out)
+{
+   if (!_exclusive_state)
+      return;
+
+   out << "  Exclusive State L2:\n";
+   out << "    Exclusive Fills: " << _total_exclusive_fills << endl;
+   out << "    Silent Upgrades (E -> M): " << _total_silent_upgrades << endl;
+}
+
+void
+L2CacheCntlr::outputFarAtomicsSummary(std::ostream& out)
+{
+   if (!_far_atomics)
+      return;
+
+   out << "  Far Atomics L2:\n";
+   out << "    Far Atomics: " << _total_far_atomics << endl;
+}
+
 tile_id_t
 L2CacheCntlr::getTileId()
 {
@@ -485,4 +933,12 @@ L2CacheCntlr::getShmemPerfModel()
    return _memory_manager->getShmemPerfModel();
 }
 
+void
+L2CacheCntlr::notifySpinDetector()
+{
+   SpinDetector* spin_detector = getMemoryManager()->getTile()->getCore()->getSpinDetector();
+   if (spin_detector)
+      spin_detector->notifyInvalidation(getShmemPerfModel()->getCycleCount());
+}
+
 }
@@ -2,8 +2,10 @@
 
 #include <map>
 #include <string>
+#include <vector>
 using std::map;
 using std::string;
+using std::vector;
 
 // Forward declarations
 namespace PrL1PrL2DramDirectoryMSI
@@ -21,6 +23,9 @@ namespace PrL1PrL2DramDirectoryMSI
 #include "shmem_perf_model.h"
 #include "cache_replacement_policy.h"
 #include "cache_hash_fn.h"
+#include "prefetcher.h"
+#include "mshr_file.h"
+#include "cache_compressor.h"
 
 namespace PrL1PrL2DramDirectoryMSI
 {
@@ -36,15 +41,32 @@ namespace PrL1PrL2DramDirectoryMSI
                    string l2_cache_replacement_policy,
                    UInt32 l2_cache_access_delay,
                    bool l2_cache_track_miss_types,
+                   string l2_cache_prefetcher,
+                   UInt32 l2_cache_prefetch_degree,
+                   UInt32 l2_cache_max_outstanding_prefetches,
+                   UInt32 l2_cache_num_mshrs,
+                   CacheCompressor* l2_cache_compressor,
+                   bool exclusive_state,
+                   bool far_atomics,
                    float frequency);
       ~L2CacheCntlr();
 
       Cache* getL2Cache() { return _l2_cache; }
 
+      void outputSummary(std::ostream& out);
+
       // Handle Request from L1 Cache - This is done for better simulator performance
       pair<bool,Cache::MissType> processShmemRequestFromL1Cache(MemComponent::Type mem_component, Core::mem_op_t mem_op_type, IntPtr address);
-      // Write-through Cache. Hence needs to be written by the APP thread
+      // Delay an access to a line that is still being filled in simulated time
+      void waitForOutstandingMiss(IntPtr address);
+      // Write-through Cache. Hence needs to be written by the APP thread.
+      // The first write to an EXCLUSIVE line makes it MODIFIED silently
       void writeCacheLine(IntPtr address, UInt32 offset, Byte* data_buf, UInt32 data_length);
+      // Far atomics: the read and the write of an atomic performed at the
+      // home of the line access the copy it got with the ATOMIC_REP, the
+      // write sends it back. Returns false if 'address' is not that line
+      bool accessFarAtomicLine(Core::mem_op_t mem_op_type, IntPtr address, UInt32 offset,
+                               Byte* data_buf, UInt32 data_length);
 
       // Handle message from L1 Cache
       void handleMsgFromL1Cache(ShmemMsg* shmem_msg);
@@ -57,16 +79,66 @@ namespace PrL1PrL2DramDirectoryMSI
       Cache* _l2_cache;
       CacheReplacementPolicy* _l2_cache_replacement_policy_obj;
       CacheHashFn* _l2_cache_hash_fn_obj;
+      // Compression of the L2 cache lines (NULL if none)
+      CacheCompressor* _l2_cache_compressor;
       L1CacheCntlr* _l1_cache_cntlr;
       AddressHomeLookup* _dram_directory_home_lookup;
       
       // Outstanding Miss information
       ShmemMsg _outstanding_shmem_msg;
       UInt64 _outstanding_shmem_msg_time;
+      // Time the outstanding miss got an MSHR, UINT64_MAX_ if it does not hold one
+      UInt64 _outstanding_shmem_msg_mshr_time;
+
+      // MSHRs (NULL if the number of MSHRs is not modeled)
+      MSHRFile* _mshr_file;
+      // MSHR counters
+      UInt64 _total_mshr_full_stalls;
+      UInt64 _total_mshr_full_stall_cycles;
+      UInt64 _total_mshr_merges;
+      UInt64 _total_mshr_merge_cycles;
+
+      // MESI: lines no other tile has are filled in the EXCLUSIVE state
+      bool _exclusive_state;
+      UInt64 _total_exclusive_fills;
+      UInt64 _total_silent_upgrades;
+
+      // Far atomics: the misses of atomics are ATOMIC_REQs, the directory
+      // decides if they are performed at the home. The line of the atomic
+      // performed at the home, INVALID_ADDRESS if none
+      bool _far_atomics;
+      IntPtr _far_atomic_address;
+      Byte* _far_atomic_buf;
+      bool _far_atomic_modeled;
+      UInt64 _total_far_atomics;
+
+      // Prefetching (NULL if disabled)
+      Prefetcher* _prefetcher;
+      UInt32 _max_outstanding_prefetches;
+      // Outstanding prefetches and the time they were issued
+      map<IntPtr,UInt64> _outstanding_prefetches;
+      // Request from the L1 cache waiting for the prefetch of the same
+      // line, INVALID_MSG_TYPE if none
+      ShmemMsg::Type _demand_waiting_for_prefetch_type;
+      bool _demand_waiting_for_prefetch_modeled;
+
+      // Prefetch counters
+      UInt64 _total_prefetches_issued;
+      // Prefetched lines accessed by the core
+      UInt64 _total_useful_prefetches;
+      // Demand misses on lines that were being prefetched
+      UInt64 _total_late_prefetches;
+      // Prefetched lines evicted or invalidated before being accessed
+      UInt64 _total_unused_prefetches;
+      // Demand misses not covered by a prefetch
+      UInt64 _total_uncovered_misses;
       
       // L2 cache operations
       void readCacheLine(IntPtr address, Byte* data_buf);
-      void insertCacheLine(IntPtr address, CacheState::Type cstate, Byte* fill_buf, MemComponent::Type mem_component);
+      void insertCacheLine(IntPtr address, CacheState::Type cstate, Byte* fill_buf, MemComponent::Type mem_component,
+                           bool prefetched = false);
+      // Tells the L1 cache and the directory that the line left the L2 cache
+      void evictCacheLine(IntPtr evicted_address, PrL2CacheLineInfo& evicted_cache_line_info, Byte* writeback_buf);
       void invalidateCacheLine(IntPtr address, PrL2CacheLineInfo& l2_cache_line_info);
 
       // L1 cache operations
@@ -86,15 +158,34 @@ namespace PrL1PrL2DramDirectoryMSI
       // Process Request from Dram Dir
       void processExRepFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_msg);
       void processShRepFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_msg);
+      void processExclusiveRepFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_msg);
       void processInvReqFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_msg);
       void processFlushReqFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_msg);
       void processWbReqFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_msg);
+      void processAtomicRepFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_msg);
+      // Returns true if a request from the L1 cache was waiting for the line
+      bool processPrefetchRepFromDramDirectory(tile_id_t sender, ShmemMsg* shmem_msg);
+
+      // Prefetching
+      void trainPrefetcher(IntPtr address, bool modeled);
+      void outputPrefetcherSummary(std::ostream& out);
+      void outputMSHRSummary(std::ostream& out);
+      void outputExclusiveStateSummary(std::ostream& out);
+      void outputFarAtomicsSummary(std::ostream& out);
+
+      static bool isDataRep(ShmemMsg::Type shmem_msg_type)
+      {
+         return (shmem_msg_type == ShmemMsg::EX_REP) || (shmem_msg_type == ShmemMsg::SH_REP) ||
+                (shmem_msg_type == ShmemMsg::EXCLUSIVE_REP) || (shmem_msg_type == ShmemMsg::ATOMIC_REP);
+      }
 
       // Utilities
       tile_id_t getTileId();
       UInt32 getCacheLineSize();
       MemoryManager* getMemoryManager()   { return _memory_manager; }
       ShmemPerfModel* getShmemPerfModel();
+      // An invalidation or flush from the directory may release a spin loop
+      void notifySpinDetector();
 
       // Dram Directory Home Lookup
       tile_id_t getHome(IntPtr address) { return _dram_directory_home_lookup->getHome(address); }
@@ -1,4 +1,7 @@
+#include <sched.h>
+
 #include "memory_manager.h"
+#include "page_classifier.h"
 #include "cache.h"
 #include "simulator.h"
 #include "tile_manager.h"
@@ -10,14 +13,30 @@ namespace PrL1PrL2DramDirectoryMSI
 {
 
 // Static variables
-ofstream MemoryManager::_cache_line_replication_file;
+TraceFile MemoryManager::_cache_line_replication_file;
+Lock MemoryManager::_functional_warmup_lock;
+bool MemoryManager::_functional_warmup_done = false;
+queue<MemoryManager::FunctionalWarmupMsg> MemoryManager::_functional_warmup_msg_queue;
+Lock MemoryManager::_synchronous_miss_locks[NUM_SYNCHRONOUS_MISS_LOCKS];
 
 MemoryManager::MemoryManager(Tile* tile, Network* network, ShmemPerfModel* shmem_perf_model)
    : ::MemoryManager(tile, network, shmem_perf_model)
    , _dram_directory_cntlr(NULL)
    , _dram_cntlr(NULL)
+   , _l3_cache_cntlr(NULL)
+   , _log_num_directory_shards(0)
+   , _directory_shard_shift(0)
    , _dram_cntlr_present(false)
+   , _l1_hit_fast_path(false)
+   , _l1_version(0)
+   , _num_deferred_l1_hits(0)
+   , _num_replayed_l1_hits(0)
    , _enabled(false)
+   , _functional_warmup(false)
+   , _handling_msg_queue(NULL)
+   , _synchronous_coherence(false)
+   , _synchronous_miss_outstanding(false)
+   , _synchronous_miss_completion_time(0)
 {
    // Read Parameters from the Config file
    std::string l1_icache_type;
@@ -49,6 +68,15 @@ MemoryManager::MemoryManager(Tile* tile, Network* network, ShmemPerfModel* shmem
    UInt32 l2_cache_tags_access_time = 0;
    std::string l2_cache_perf_model_type;
    bool l2_cache_track_miss_types = false;
+   std::string l2_cache_prefetcher;
+   UInt32 l2_cache_prefetch_degree = 0;
+   UInt32 l2_cache_max_outstanding_prefetches = 0;
+   UInt32 l2_cache_num_mshrs = 0;
+   std::string l2_cache_compression;
+   UInt32 l2_cache_compression_tag_factor = 0;
+   UInt32 l2_cache_compression_segment_size = 0;
+   UInt32 l2_cache_compression_latency = 0;
+   UInt32 l2_cache_decompression_latency = 0;
 
    std::string dram_directory_total_entries_str;
    UInt32 dram_directory_associativity = 0;
@@ -57,6 +85,16 @@ MemoryManager::MemoryManager(Tile* tile, Network* network, ShmemPerfModel* shmem
    std::string dram_directory_type_str;
    UInt32 dram_directory_home_lookup_param = 0;
    std::string dram_directory_access_time_str;
+   bool dram_directory_multicast_invalidations = false;
+   bool dram_directory_coalesce_sh_reqs = false;
+   bool far_atomics = false;
+   UInt32 far_atomics_sharers_threshold = 0;
+   UInt32 far_atomics_contention_threshold = 0;
+   UInt32 num_directory_shards = 1;
+   bool private_page_classification = false;
+   UInt32 private_page_size = 0;
+
+   UInt32 write_combining_buffer_entries = 0;
 
    volatile float dram_latency = 0.0;
    volatile float per_dram_controller_bandwidth = 0.0;
@@ -99,6 +137,15 @@ MemoryManager::MemoryManager(Tile* tile, Network* network, ShmemPerfModel* shmem
       l2_cache_tags_access_time = Sim()->getCfg()->getInt(l2_cache_type + "/tags_access_time");
       l2_cache_perf_model_type = Sim()->getCfg()->getString(l2_cache_type + "/perf_model_type");
       l2_cache_track_miss_types = Sim()->getCfg()->getBool(l2_cache_type + "/track_miss_types");
+      l2_cache_prefetcher = Sim()->getCfg()->getString(l2_cache_type + "/prefetcher", "none");
+      l2_cache_prefetch_degree = Sim()->getCfg()->getInt(l2_cache_type + "/prefetch_degree", 2);
+      l2_cache_max_outstanding_prefetches = Sim()->getCfg()->getInt(l2_cache_type + "/max_outstanding_prefetches", 8);
+      l2_cache_num_mshrs = Sim()->getCfg()->getInt(l2_cache_type + "/num_mshrs", 0);
+      l2_cache_compression = Sim()->getCfg()->getString(l2_cache_type + "/compression", "none");
+      l2_cache_compression_tag_factor = Sim()->getCfg()->getInt(l2_cache_type + "/compression_tag_factor", 2);
+      l2_cache_compression_segment_size = Sim()->getCfg()->getInt(l2_cache_type + "/compression_segment_size", 8);
+      l2_cache_compression_latency = Sim()->getCfg()->getInt(l2_cache_type + "/compression_latency", 2);
+      l2_cache_decompression_latency = Sim()->getCfg()->getInt(l2_cache_type + "/decompression_latency", 1);
 
       // Dram Directory Cache
       dram_directory_total_entries_str = Sim()->getCfg()->getString("dram_directory/total_entries");
@@ -116,6 +163,32 @@ MemoryManager::MemoryManager(Tile* tile, Network* network, ShmemPerfModel* shmem
 
       // Directory Type
       directory_type = Sim()->getCfg()->getString("dram_directory/directory_type");
+
+      // Functional warmup
+      _functional_warmup = Sim()->getCfg()->getBool("caching_protocol/pr_l1_pr_l2_dram_directory_msi/functional_warmup", false);
+      _synchronous_coherence = Sim()->getCfg()->getBool("caching_protocol/pr_l1_pr_l2_dram_directory_msi/synchronous_coherence", false);
+
+      // Invalidations to many sharers
+      dram_directory_multicast_invalidations = Sim()->getCfg()->getBool("caching_protocol/pr_l1_pr_l2_dram_directory_msi/multicast_invalidations", false);
+      dram_directory_coalesce_sh_reqs = Sim()->getCfg()->getBool("caching_protocol/pr_l1_pr_l2_dram_directory_msi/coalesce_sh_reqs", false);
+
+      // Atomics performed at the home of the line
+      far_atomics = Sim()->getCfg()->getBool("caching_protocol/pr_l1_pr_l2_dram_directory_msi/far_atomics", false);
+      far_atomics_sharers_threshold = Sim()->getCfg()->getInt("caching_protocol/pr_l1_pr_l2_dram_directory_msi/far_atomics_sharers_threshold", 4);
+      far_atomics_contention_threshold = Sim()->getCfg()->getInt("caching_protocol/pr_l1_pr_l2_dram_directory_msi/far_atomics_contention_threshold", 2);
+
+      // L1 read hits without the lock
+      _l1_hit_fast_path = Sim()->getCfg()->getBool("caching_protocol/pr_l1_pr_l2_dram_directory_msi/l1_hit_fast_path", false);
+
+      // Stores merged on their way from the L1-D cache to the L2 cache
+      write_combining_buffer_entries = Sim()->getCfg()->getInt("caching_protocol/pr_l1_pr_l2_dram_directory_msi/write_combining_buffer_entries", 0);
+
+      // Sim threads of the directory of a tile
+      num_directory_shards = Sim()->getCfg()->getInt("caching_protocol/pr_l1_pr_l2_dram_directory_msi/directory_sim_threads", 1);
+
+      // Lines of private pages not tracked by the directory
+      private_page_classification = Sim()->getCfg()->getBool("caching_protocol/pr_l1_pr_l2_dram_directory_msi/private_page_classification", false);
+      private_page_size = Sim()->getCfg()->getInt("caching_protocol/pr_l1_pr_l2_dram_directory_msi/private_page_size", 4096);
    }
    catch(...)
    {
@@ -128,6 +201,41 @@ MemoryManager::MemoryManager(Tile* tile, Network* network, ShmemPerfModel* shmem
             "Limited Broadcast directory scheme CANNOT be used with the MSI protocol.");
    }
 
+   // The APP thread updates the caches and directories of other tiles directly
+   if (_functional_warmup && (Config::getSingleton()->getProcessCount() > 1))
+   {
+      if (getTile()->getId() == 0)
+         LOG_PRINT_WARNING("Functional warmup needs all tiles in one process, disabled");
+      _functional_warmup = false;
+   }
+   // The timing of the other modes depends on the handoffs to the SIM threads
+   if (_synchronous_coherence &&
+       ((Config::getSingleton()->getSimulationMode() != Config::LITE) || (Config::getSingleton()->getProcessCount() > 1)))
+   {
+      if (getTile()->getId() == 0)
+         LOG_PRINT_WARNING("Synchronous coherence needs lite mode with all tiles in one process, disabled");
+      _synchronous_coherence = false;
+   }
+
+   LOG_ASSERT_ERROR(isPower2(num_directory_shards),
+                    "Directory sim threads(%u) must be a power of 2", num_directory_shards);
+   // The functional warmup msgs are handled by the APP thread in place
+   if ((_functional_warmup || _synchronous_coherence) && (num_directory_shards > 1))
+   {
+      if (getTile()->getId() == 0)
+         LOG_PRINT_WARNING("Functional warmup and synchronous coherence need one directory sim thread, directory_sim_threads ignored");
+      num_directory_shards = 1;
+   }
+
+   // A hit may have to wait for a miss to the same line in the MSHRs,
+   // only the slow path models that
+   if (_l1_hit_fast_path && (l2_cache_num_mshrs > 0))
+   {
+      if (getTile()->getId() == 0)
+         LOG_PRINT_WARNING("The L1 hit fast path does not model the MSHRs, disabled");
+      _l1_hit_fast_path = false;
+   }
+
    // Check if all cache line sizes are the same
    LOG_ASSERT_ERROR((l1_icache_line_size == l1_dcache_line_size) && (l1_dcache_line_size == l2_cache_line_size),
       "Cache Line Sizes of L1-I, L1-D and L2 Caches must be the same. "
@@ -137,7 +245,24 @@ MemoryManager::MemoryManager(Tile* tile, Network* network, ShmemPerfModel* shmem
    _cache_line_size = l1_icache_line_size;
    dram_directory_home_lookup_param = ceilLog2(_cache_line_size);
 
+   // The page table is shared by the directories of all tiles
+   if (private_page_classification)
+   {
+      if (Config::getSingleton()->getProcessCount() > 1)
+      {
+         if (getTile()->getId() == 0)
+            LOG_PRINT_WARNING("Private page classification needs all tiles in one process, disabled");
+      }
+      else
+      {
+         PageClassifier::initialize(private_page_size, _cache_line_size);
+      }
+   }
+
    float core_frequency = Config::getSingleton()->getCoreFrequency(Tile::getMainCoreId(getTile()->getId()));
+
+   // pr_l1_pr_l2_dram_directory_mesi adds the EXCLUSIVE state to this protocol
+   bool exclusive_state = (getCachingProtocolType() == PR_L1_PR_L2_DRAM_DIRECTORY_MESI);
   
    std::vector<tile_id_t> tile_list_with_memory_controllers = getTileListWithMemoryControllers();
    UInt32 num_memory_controllers = tile_list_with_memory_controllers.size();
@@ -156,21 +281,61 @@ MemoryManager::MemoryManager(Tile* tile, Network* network, ShmemPerfModel* shmem
 
       LOG_PRINT("Instantiated Dram Cntlr");
 
-      _dram_directory_cntlr = new DramDirectoryCntlr(this,
-            _dram_cntlr,
-            dram_directory_total_entries_str,
-            dram_directory_associativity,
-            getCacheLineSize(),
-            dram_directory_max_num_sharers,
-            dram_directory_max_hw_sharers,
-            dram_directory_type_str,
-            dram_directory_access_time_str,
-            num_memory_controllers);
+      string l3_cache_type = L3CacheCntlr::getType();
+      if (l3_cache_type != "none")
+      {
+         _l3_cache_cntlr = new L3CacheCntlr(this,
+               _dram_cntlr,
+               PR_L1_PR_L2_DRAM_DIRECTORY_MSI,
+               L3,
+               l3_cache_type,
+               getCacheLineSize(),
+               core_frequency);
+      }
+
+      // Each shard has its part of the entries, the directory caches index
+      // their sets above the home and shard bits as with more slices
+      string shard_total_entries_str = dram_directory_total_entries_str;
+      if ((num_directory_shards > 1) && (dram_directory_total_entries_str != "auto"))
+      {
+         UInt32 total_entries = convertFromString<UInt32>(dram_directory_total_entries_str);
+         LOG_ASSERT_ERROR((total_entries % num_directory_shards) == 0,
+                          "Dram directory total entries(%u) must be a multiple of the directory sim threads(%u)",
+                          total_entries, num_directory_shards);
+         shard_total_entries_str = convertToString<UInt32>(total_entries / num_directory_shards);
+      }
+      _log_num_directory_shards = floorLog2(num_directory_shards);
+      _directory_shard_shift = ceilLog2(getCacheLineSize()) + ceilLog2(num_memory_controllers);
+
+      for (UInt32 i = 0; i < num_directory_shards; i++)
+      {
+         DramDirectoryCntlr* dram_directory_cntlr = new DramDirectoryCntlr(this,
+               _dram_cntlr,
+               shard_total_entries_str,
+               dram_directory_associativity,
+               getCacheLineSize(),
+               dram_directory_max_num_sharers,
+               dram_directory_max_hw_sharers,
+               dram_directory_type_str,
+               dram_directory_access_time_str,
+               num_memory_controllers * num_directory_shards,
+               dram_directory_multicast_invalidations,
+               dram_directory_coalesce_sh_reqs,
+               exclusive_state,
+               far_atomics_sharers_threshold,
+               far_atomics_contention_threshold);
+         dram_directory_cntlr->setL3CacheCntlr(_l3_cache_cntlr);
+
+         if (i == 0)
+            _dram_directory_cntlr = dram_directory_cntlr;
+         else
+            _directory_shards.push_back(new DirectoryShard(dram_directory_cntlr));
+      }
       
       LOG_PRINT("Instantiated Dram Directory Cntlr");
    }
 
-   _dram_directory_home_lookup = new AddressHomeLookup(dram_directory_home_lookup_param, tile_list_with_memory_controllers, getCacheLineSize());
+   _dram_directory_home_lookup = new AddressHomeLookup(dram_directory_home_lookup_param, tile_list_with_memory_controllers, getCacheLineSize(), getTile()->getId());
 
    LOG_PRINT("Instantiated Dram Directory Home Lookup");
 
@@ -186,6 +351,8 @@ MemoryManager::MemoryManager(Tile* tile, Network* network, ShmemPerfModel* shmem
          l1_dcache_replacement_policy,
          l1_dcache_data_access_time,
          l1_dcache_track_miss_types,
+         write_combining_buffer_entries,
+         l2_cache_data_access_time,
          core_frequency);
    
    LOG_PRINT("Instantiated L1 Cache Cntlr");
@@ -199,6 +366,15 @@ MemoryManager::MemoryManager(Tile* tile, Network* network, ShmemPerfModel* shmem
          l2_cache_replacement_policy,
          l2_cache_data_access_time,
          l2_cache_track_miss_types,
+         l2_cache_prefetcher,
+         l2_cache_prefetch_degree,
+         l2_cache_max_outstanding_prefetches,
+         l2_cache_num_mshrs,
+         CacheCompressor::create(l2_cache_compression, getCacheLineSize(), l2_cache_compression_tag_factor,
+                                 l2_cache_compression_segment_size, l2_cache_compression_latency,
+                                 l2_cache_decompression_latency),
+         exclusive_state,
+         far_atomics,
          core_frequency);
 
    LOG_PRINT("Instantiated L2 Cache Cntlr");
@@ -215,6 +391,11 @@ MemoryManager::MemoryManager(Tile* tile, Network* network, ShmemPerfModel* shmem
 
    LOG_PRINT("Instantiated Cache Performance Models");
 
+   // Counters of the stats file
+   _l1_cache_cntlr->getL1ICache()->registerStatistics(getTile()->getId());
+   _l1_cache_cntlr->getL1DCache()->registerStatistics(getTile()->getId());
+   _l2_cache_cntlr->getL2Cache()->registerStatistics(getTile()->getId());
+
    // Register Call-backs
    getNetwork()->registerCallback(SHARED_MEM_1, MemoryManagerNetworkCallback, this);
    getNetwork()->registerCallback(SHARED_MEM_2, MemoryManagerNetworkCallback, this);
@@ -235,8 +416,11 @@ MemoryManager::~MemoryManager()
    delete _l2_cache_cntlr;
    if (_dram_cntlr_present)
    {
+      for (UInt32 i = 0; i < _directory_shards.size(); i++)
+         delete _directory_shards[i];
       delete _dram_cntlr;
       delete _dram_directory_cntlr;
+      delete _l3_cache_cntlr;
    }
 }
 
@@ -249,7 +433,7 @@ MemoryManager::coreInitiateMemoryAccess(MemComponent::Type mem_component,
                                         UInt64& curr_time, bool modeled)
 {
    if (lock_signal != Core::UNLOCK)
-      _lock.acquire();
+      acquireLock();
   
    getShmemPerfModel()->setCycleCount(curr_time);
 
@@ -259,22 +443,131 @@ MemoryManager::coreInitiateMemoryAccess(MemComponent::Type mem_component,
    curr_time = getShmemPerfModel()->getCycleCount();
 
    if (lock_signal != Core::LOCK)
-      _lock.release();
+      releaseLock();
 
    return ret;
 }
 
+UInt32
+MemoryManager::coreInitiateMemoryAccesses(MemComponent::Type mem_component,
+                                          Core::mem_op_t mem_op_type,
+                                          LineAccess* lines, UInt32 num_lines,
+                                          UInt64& curr_time, bool modeled,
+                                          UInt32 max_lines_in_flight)
+{
+   // The lock is taken once for all the lines (it is let go while a miss
+   // waits for the sim thread)
+   acquireLock();
+
+   UInt64 issue_time = curr_time;
+   UInt32 num_misses = 0;
+   // Completion times of the lines in flight
+   vector<UInt64> completion_times(max_lines_in_flight, 0);
+   for (UInt32 i = 0; i < num_lines; i++)
+   {
+      UInt64 line_time = issue_time;
+      if (max_lines_in_flight > 0)
+         line_time = max(line_time, completion_times[i % max_lines_in_flight]);
+      issue_time = line_time + 1;
+      getShmemPerfModel()->setCycleCount(line_time);
+
+      if (!_l1_cache_cntlr->processMemOpFromTile(mem_component, Core::NONE, mem_op_type,
+                                                 lines[i].address, lines[i].offset,
+                                                 lines[i].data_buf, lines[i].data_length, modeled))
+      {
+         num_misses ++;
+      }
+      if (max_lines_in_flight > 0)
+         completion_times[i % max_lines_in_flight] = getShmemPerfModel()->getCycleCount();
+      curr_time = max(curr_time, getShmemPerfModel()->getCycleCount());
+   }
+
+   releaseLock();
+
+   return num_misses;
+}
+
+bool
+MemoryManager::coreProbeL1Hit(MemComponent::Type mem_component,
+                              IntPtr address, UInt32 offset,
+                              Byte* data_buf, UInt32 data_length,
+                              UInt64& curr_time)
+{
+   if (!_l1_hit_fast_path || ((_num_deferred_l1_hits - _num_replayed_l1_hits) == MAX_DEFERRED_L1_HITS))
+      return false;
+
+   // Seqlock reader: '_l1_version' is odd while a thread holds '_lock'
+   UInt32 version = _l1_version;
+   if (version & 1)
+      return false;
+   __sync_synchronize();
+
+   bool hit = _l1_cache_cntlr->probeL1Hit(mem_component, address, offset, data_buf, data_length);
+
+   __sync_synchronize();
+   if (!hit || (_l1_version != version))
+      return false;
+
+   // Only the app thread of the tile appends. The hit is published before
+   // the count, and a thread that takes the lock bumps the version before
+   // it reads the count, so the hit is either replayed by the next one to
+   // take the lock or found late
+   DeferredL1Hit& deferred_l1_hit = _deferred_l1_hits[_num_deferred_l1_hits % MAX_DEFERRED_L1_HITS];
+   deferred_l1_hit.mem_component = mem_component;
+   deferred_l1_hit.address = address;
+   deferred_l1_hit.version = version;
+   __sync_synchronize();
+   _num_deferred_l1_hits ++;
+
+   if (getShmemPerfModel()->isEnabled())
+   {
+      CachePerfModel* l1_cache_perf_model = (mem_component == MemComponent::L1_ICACHE) ?
+                                            _l1_icache_perf_model : _l1_dcache_perf_model;
+      curr_time += l1_cache_perf_model->getLatency(CachePerfModel::ACCESS_CACHE_DATA_AND_TAGS);
+   }
+   return true;
+}
+
+void
+MemoryManager::replayDeferredL1Hits(UInt32 version)
+{
+   UInt32 num_deferred_l1_hits = _num_deferred_l1_hits;
+   __sync_synchronize();
+   for (UInt32 i = _num_replayed_l1_hits; i != num_deferred_l1_hits; i++)
+   {
+      const DeferredL1Hit& deferred_l1_hit = _deferred_l1_hits[i % MAX_DEFERRED_L1_HITS];
+      _l1_cache_cntlr->replayL1Hit(deferred_l1_hit.mem_component, deferred_l1_hit.address,
+                                   deferred_l1_hit.version == version);
+   }
+   __sync_synchronize();
+   _num_replayed_l1_hits = num_deferred_l1_hits;
+}
+
 void
 MemoryManager::handleMsgFromNetwork(NetPacket& packet)
 {
    core_id_t sender = packet.sender;
-   ShmemMsg* shmem_msg = ShmemMsg::getShmemMsg((Byte*) packet.data);
+   // The msg (and its data) is read in place, the packet is kept until it is handled
+   ShmemMsg packet_shmem_msg;
+   ShmemMsg::getShmemMsg((Byte*) packet.data, &packet_shmem_msg);
+   ShmemMsg* shmem_msg = &packet_shmem_msg;
    UInt64 msg_time = packet.time;
 
    MemComponent::Type receiver_mem_component = shmem_msg->getReceiverMemComponent();
    MemComponent::Type sender_mem_component = shmem_msg->getSenderMemComponent();
 
-   _lock.acquire();
+   // The msgs of the other directory shards go to their threads, without '_lock'
+   if ((receiver_mem_component == MemComponent::DRAM_DIRECTORY) && !_directory_shards.empty())
+   {
+      UInt32 shard = getDirectoryShard(shmem_msg->getAddress());
+      if (shard > 0)
+      {
+         _directory_shards[shard - 1]->enqueueMsg(sender.tile_id, msg_time, packet.data, packet.length);
+         return;
+      }
+   }
+
+   acquireLock();
 
    getShmemPerfModel()->setCycleCount(msg_time);
 
@@ -284,6 +577,17 @@ MemoryManager::handleMsgFromNetwork(NetPacket& packet)
             shmem_msg->getType(), shmem_msg->getAddress(), sender_mem_component, receiver_mem_component, sender.tile_id, sender.core_type, packet.receiver.tile_id, packet.receiver.core_type);    
    }
 
+   handleMsg(sender.tile_id, shmem_msg);
+
+   releaseLock();
+}
+
+void
+MemoryManager::handleMsg(tile_id_t sender, ShmemMsg* shmem_msg)
+{
+   MemComponent::Type receiver_mem_component = shmem_msg->getReceiverMemComponent();
+   MemComponent::Type sender_mem_component = shmem_msg->getSenderMemComponent();
+
    switch (receiver_mem_component)
    {
    case MemComponent::L2_CACHE:
@@ -291,12 +595,12 @@ MemoryManager::handleMsgFromNetwork(NetPacket& packet)
       {
          case MemComponent::L1_ICACHE:
          case MemComponent::L1_DCACHE:
-            assert(sender.tile_id == getTile()->getId());
+            assert(sender == getTile()->getId());
             _l2_cache_cntlr->handleMsgFromL1Cache(shmem_msg);
             break;
 
          case MemComponent::DRAM_DIRECTORY:
-            _l2_cache_cntlr->handleMsgFromDramDirectory(sender.tile_id, shmem_msg);
+            _l2_cache_cntlr->handleMsgFromDramDirectory(sender, shmem_msg);
             break;
 
          default:
@@ -312,7 +616,7 @@ MemoryManager::handleMsgFromNetwork(NetPacket& packet)
          LOG_ASSERT_ERROR(_dram_cntlr_present, "Dram Cntlr NOT present");
 
          case MemComponent::L2_CACHE:
-            _dram_directory_cntlr->handleMsgFromL2Cache(sender.tile_id, shmem_msg);
+            _dram_directory_cntlr->handleMsgFromL2Cache(sender, shmem_msg);
             break;
 
          default:
@@ -327,19 +631,6 @@ MemoryManager::handleMsgFromNetwork(NetPacket& packet)
             receiver_mem_component);
       break;
    }
-
-   // Delete the allocated Shared Memory Message
-   // First delete 'data_buf' if it is present
-   // LOG_PRINT("Finished handling Shmem Msg");
-
-   if (shmem_msg->getDataLength() > 0)
-   {
-      assert(shmem_msg->getDataBuf());
-      delete [] shmem_msg->getDataBuf();
-   }
-   delete shmem_msg;
-
-   _lock.release();
 }
 
 void
@@ -347,8 +638,14 @@ MemoryManager::sendMsg(tile_id_t receiver, ShmemMsg& shmem_msg)
 {
    assert((shmem_msg.getDataBuf() == NULL) == (shmem_msg.getDataLength() == 0));
 
-   Byte* msg_buf = shmem_msg.makeMsgBuf();
-   UInt64 msg_time = getShmemPerfModel()->getCycleCount();
+   if (_handling_msg_queue)
+   {
+      enqueueFunctionalWarmupMsg(receiver, shmem_msg, *_handling_msg_queue);
+      return;
+   }
+
+   ShmemMsgBuf<ShmemMsg> msg_buf(shmem_msg);
+   UInt64 msg_time = getSenderShmemPerfModel(shmem_msg)->getCycleCount();
 
    if (_enabled)
    {
@@ -359,11 +656,8 @@ MemoryManager::sendMsg(tile_id_t receiver, ShmemMsg& shmem_msg)
 
    NetPacket packet(msg_time, SHARED_MEM_1,
          getTile()->getId(), receiver,
-         shmem_msg.getMsgLen(), (const void*) msg_buf);
+         shmem_msg.getMsgLen(), (const void*) msg_buf.getBuf());
    getNetwork()->netSend(packet);
-
-   // Delete the Msg Buf
-   delete [] msg_buf;
 }
 
 void
@@ -371,8 +665,15 @@ MemoryManager::broadcastMsg(ShmemMsg& shmem_msg)
 {
    assert((shmem_msg.getDataBuf() == NULL) == (shmem_msg.getDataLength() == 0));
 
-   Byte* msg_buf = shmem_msg.makeMsgBuf();
-   UInt64 msg_time = getShmemPerfModel()->getCycleCount();
+   if (_handling_msg_queue)
+   {
+      for (tile_id_t receiver = 0; receiver < (tile_id_t) Config::getSingleton()->getTotalTiles(); receiver ++)
+         enqueueFunctionalWarmupMsg(receiver, shmem_msg, *_handling_msg_queue);
+      return;
+   }
+
+   ShmemMsgBuf<ShmemMsg> msg_buf(shmem_msg);
+   UInt64 msg_time = getSenderShmemPerfModel(shmem_msg)->getCycleCount();
 
    if (_enabled)
    {
@@ -383,11 +684,172 @@ MemoryManager::broadcastMsg(ShmemMsg& shmem_msg)
 
    NetPacket packet(msg_time, SHARED_MEM_1,
          getTile()->getId(), NetPacket::BROADCAST,
-         shmem_msg.getMsgLen(), (const void*) msg_buf);
+         shmem_msg.getMsgLen(), (const void*) msg_buf.getBuf());
+   getNetwork()->netSend(packet);
+}
+
+void
+MemoryManager::multicastMsg(const vector<tile_id_t>& receivers, ShmemMsg& shmem_msg)
+{
+   assert((shmem_msg.getDataBuf() == NULL) == (shmem_msg.getDataLength() == 0));
+
+   if (_handling_msg_queue)
+   {
+      for (vector<tile_id_t>::const_iterator it = receivers.begin(); it != receivers.end(); it++)
+         enqueueFunctionalWarmupMsg(*it, shmem_msg, *_handling_msg_queue);
+      return;
+   }
+
+   ShmemMsgBuf<ShmemMsg> msg_buf(shmem_msg);
+   UInt64 msg_time = getSenderShmemPerfModel(shmem_msg)->getCycleCount();
+
+   if (_enabled)
+   {
+      LOG_PRINT("Multicasting Msg: type(%u), address(%#llx), sender_mem_component(%u), receiver_mem_component(%u), requester(%i), sender(%i), num_receivers(%u)",
+                shmem_msg.getType(), shmem_msg.getAddress(), shmem_msg.getSenderMemComponent(), shmem_msg.getReceiverMemComponent(),
+                shmem_msg.getRequester(), getTile()->getId(), (UInt32) receivers.size());
+   }
+
+   NetPacket packet(msg_time, SHARED_MEM_1,
+         getTile()->getId(), NetPacket::BROADCAST,
+         shmem_msg.getMsgLen(), (const void*) msg_buf.getBuf());
+   vector<Byte> multicast_bitmap;
+   packet.setMulticastReceivers(receivers, multicast_bitmap);
    getNetwork()->netSend(packet);
+}
+
+UInt32
+MemoryManager::getDirectoryShard(IntPtr address)
+{
+   return getBits<IntPtr>(address, _directory_shard_shift + _log_num_directory_shards, _directory_shard_shift);
+}
+
+ShmemPerfModel*
+MemoryManager::getDirectoryShmemPerfModel(IntPtr address)
+{
+   UInt32 shard = _directory_shards.empty() ? 0 : getDirectoryShard(address);
+   return (shard == 0) ? getShmemPerfModel() : _directory_shards[shard - 1]->getShmemPerfModel();
+}
+
+// The directory sends with the clock of the shard of the line
+ShmemPerfModel*
+MemoryManager::getSenderShmemPerfModel(ShmemMsg& shmem_msg)
+{
+   if (shmem_msg.getSenderMemComponent() == MemComponent::DRAM_DIRECTORY)
+      return getDirectoryShmemPerfModel(shmem_msg.getAddress());
+   return getShmemPerfModel();
+}
+
+bool
+MemoryManager::processFunctionalWarmupMiss(ShmemMsg& shmem_msg)
+{
+   if (!_functional_warmup || _functional_warmup_done)
+      return false;
+
+   // Like waiting for the SIM thread, but the APP thread delivers the msgs.
+   // One miss is in flight at a time, so the directories see the same
+   // sequence of requests as with a network that never reorders msgs
+   releaseLock();
+   _functional_warmup_lock.acquire();
+
+   bool functional_warmup = !_functional_warmup_done;
+   if (functional_warmup)
+   {
+      enqueueFunctionalWarmupMsg(getTile()->getId(), shmem_msg, _functional_warmup_msg_queue);
+      deliverFunctionalWarmupMsgs(_functional_warmup_msg_queue);
+   }
 
-   // Delete the Msg Buf
-   delete [] msg_buf;
+   _functional_warmup_lock.release();
+   acquireLock();
+
+   return functional_warmup;
+}
+
+bool
+MemoryManager::processSynchronousMiss(ShmemMsg& shmem_msg)
+{
+   if (!_synchronous_coherence)
+      return false;
+
+   // The directory handles one miss of a stripe at a time, the others wait
+   // here instead of in its request queue
+   Lock& miss_lock = _synchronous_miss_locks[(shmem_msg.getAddress() >> ceilLog2(getCacheLineSize())) % NUM_SYNCHRONOUS_MISS_LOCKS];
+
+   queue<FunctionalWarmupMsg> msg_queue;
+   enqueueFunctionalWarmupMsg(getTile()->getId(), shmem_msg, msg_queue);
+   _synchronous_miss_outstanding = true;
+   releaseLock();
+
+   miss_lock.acquire();
+   deliverFunctionalWarmupMsgs(msg_queue);
+   miss_lock.release();
+
+   // The queues of the other misses deliver the rest, without waiting on each other
+   while (_synchronous_miss_outstanding)
+      sched_yield();
+
+   acquireLock();
+   // Other msgs may have been handled by the tile since the reply
+   getShmemPerfModel()->setCycleCount(_synchronous_miss_completion_time);
+   return true;
+}
+
+void
+MemoryManager::completeSynchronousMiss(UInt64 time)
+{
+   _synchronous_miss_completion_time = time;
+   __sync_synchronize();
+   _synchronous_miss_outstanding = false;
+}
+
+void
+MemoryManager::enqueueFunctionalWarmupMsg(tile_id_t receiver, ShmemMsg& shmem_msg, queue<FunctionalWarmupMsg>& msg_queue)
+{
+   FunctionalWarmupMsg msg;
+   msg.sender = getTile()->getId();
+   msg.receiver = receiver;
+   msg.time = getShmemPerfModel()->getCycleCount();
+   msg.msg_buf = shmem_msg.makeMsgBuf();
+   if (_synchronous_coherence)
+   {
+      // The time it would have arrived at through the network
+      NetPacket packet(msg.time, SHARED_MEM_1,
+            getTile()->getId(), receiver,
+            shmem_msg.getMsgLen(), (const void*) msg.msg_buf);
+      msg.time = getNetwork()->netModelSend(packet);
+   }
+   msg_queue.push(msg);
+}
+
+void
+MemoryManager::deliverFunctionalWarmupMsgs(queue<FunctionalWarmupMsg>& msg_queue)
+{
+   while (!msg_queue.empty())
+   {
+      FunctionalWarmupMsg msg = msg_queue.front();
+      msg_queue.pop();
+
+      MemoryManager* memory_manager = (MemoryManager*) Sim()->getTileManager()->getTileFromID(msg.receiver)->getMemoryManager();
+      memory_manager->handleFunctionalWarmupMsg(msg, msg_queue);
+   }
+}
+
+void
+MemoryManager::handleFunctionalWarmupMsg(const FunctionalWarmupMsg& msg, queue<FunctionalWarmupMsg>& msg_queue)
+{
+   ShmemMsg shmem_msg;
+   ShmemMsg::getShmemMsg(msg.msg_buf, &shmem_msg);
+
+   acquireLock();
+   _handling_msg_queue = &msg_queue;
+
+   getShmemPerfModel()->setCycleCount(msg.time);
+   handleMsg(msg.sender, &shmem_msg);
+
+   _handling_msg_queue = NULL;
+   releaseLock();
+
+   delete [] msg.msg_buf;
 }
 
 void
@@ -422,6 +884,13 @@ MemoryManager::enableModels()
    LOG_PRINT("enableModels() start");
    _enabled = true;
 
+   // Later misses go through the network
+   if (_functional_warmup)
+   {
+      ScopedLock sl(_functional_warmup_lock);
+      _functional_warmup_done = true;
+   }
+
    _l1_cache_cntlr->getL1ICache()->enable();
    _l1_icache_perf_model->enable();
    
@@ -434,11 +903,82 @@ MemoryManager::enableModels()
    if (_dram_cntlr_present)
    {
       _dram_directory_cntlr->getDramDirectoryCache()->enable();
+      for (UInt32 i = 0; i < _directory_shards.size(); i++)
+      {
+         ScopedLock sl(_directory_shards[i]->getLock());
+         _directory_shards[i]->getDramDirectoryCntlr()->getDramDirectoryCache()->enable();
+         _directory_shards[i]->getShmemPerfModel()->enable();
+      }
       _dram_cntlr->getDramPerfModel()->enable();
+      if (_l3_cache_cntlr)
+         _l3_cache_cntlr->enable();
    }
    LOG_PRINT("enableModels() end");
 }
 
+// The checkpoint is taken with the application quiescent, e.g., at a
+// CarbonEnableModels() after a barrier, so no miss is in flight
+void
+MemoryManager::saveCheckpoint(CheckpointWriter& writer)
+{
+   ScopedLock sl(_lock);
+
+   // The L2 cache is saved with the buffered stores
+   _l1_cache_cntlr->drainWriteCombiningBuffer(false);
+
+   _l1_cache_cntlr->getL1ICache()->saveState(writer);
+   _l1_cache_cntlr->getL1DCache()->saveState(writer);
+   _l2_cache_cntlr->getL2Cache()->saveState(writer);
+
+   writer << (UInt8) _dram_cntlr_present;
+   if (_dram_cntlr_present)
+   {
+      _dram_directory_cntlr->getDramDirectoryCache()->saveState(writer);
+      for (UInt32 i = 0; i < _directory_shards.size(); i++)
+      {
+         ScopedLock shard_sl(_directory_shards[i]->getLock());
+         _directory_shards[i]->getDramDirectoryCntlr()->getDramDirectoryCache()->saveState(writer);
+      }
+      _dram_cntlr->saveState(writer);
+      if (_l3_cache_cntlr)
+         _l3_cache_cntlr->getL3Cache()->saveState(writer);
+   }
+
+   // Shared by all tiles, saved once
+   if (PageClassifier::isEnabled() && (getTile()->getId() == 0))
+      PageClassifier::saveState(writer);
+}
+
+void
+MemoryManager::restoreCheckpoint(CheckpointReader& reader)
+{
+   ScopedLock sl(_lock);
+
+   _l1_cache_cntlr->getL1ICache()->restoreState(reader);
+   _l1_cache_cntlr->getL1DCache()->restoreState(reader);
+   _l2_cache_cntlr->getL2Cache()->restoreState(reader);
+
+   UInt8 dram_cntlr_present;
+   reader >> dram_cntlr_present;
+   LOG_ASSERT_ERROR((bool) dram_cntlr_present == _dram_cntlr_present,
+                    "Checkpoint and tile(%i) disagree on the memory controller placement", getTile()->getId());
+   if (_dram_cntlr_present)
+   {
+      _dram_directory_cntlr->getDramDirectoryCache()->restoreState(reader);
+      for (UInt32 i = 0; i < _directory_shards.size(); i++)
+      {
+         ScopedLock shard_sl(_directory_shards[i]->getLock());
+         _directory_shards[i]->getDramDirectoryCntlr()->getDramDirectoryCache()->restoreState(reader);
+      }
+      _dram_cntlr->restoreState(reader);
+      if (_l3_cache_cntlr)
+         _l3_cache_cntlr->getL3Cache()->restoreState(reader);
+   }
+
+   if (PageClassifier::isEnabled() && (getTile()->getId() == 0))
+      PageClassifier::restoreState(reader);
+}
+
 void
 MemoryManager::disableModels()
 {
@@ -457,7 +997,15 @@ MemoryManager::disableModels()
    if (_dram_cntlr_present)
    {
       _dram_directory_cntlr->getDramDirectoryCache()->disable();
+      for (UInt32 i = 0; i < _directory_shards.size(); i++)
+      {
+         ScopedLock sl(_directory_shards[i]->getLock());
+         _directory_shards[i]->getDramDirectoryCntlr()->getDramDirectoryCache()->disable();
+         _directory_shards[i]->getShmemPerfModel()->disable();
+      }
       _dram_cntlr->getDramPerfModel()->disable();
+      if (_l3_cache_cntlr)
+         _l3_cache_cntlr->disable();
    }
    LOG_PRINT("disableModels() end");
 }
@@ -465,20 +1013,41 @@ MemoryManager::disableModels()
 void
 MemoryManager::outputSummary(std::ostream &os)
 {
+   // The app thread is done, count its last L1 hits (replayed by acquireLock())
+   acquireLock();
+   releaseLock();
+
    os << "Cache Summary:\n";
    _l1_cache_cntlr->getL1ICache()->outputSummary(os);
    _l1_cache_cntlr->getL1DCache()->outputSummary(os);
    _l2_cache_cntlr->getL2Cache()->outputSummary(os);
+   _l2_cache_cntlr->outputSummary(os);
+   _l1_cache_cntlr->outputSummary(os);
 
    if (_dram_cntlr_present)
    {      
       _dram_cntlr->getDramPerfModel()->outputSummary(os);
+      _dram_directory_cntlr->outputSummary(os);
       os << "Dram Directory Cache Summary:\n";
       _dram_directory_cntlr->getDramDirectoryCache()->outputSummary(os);
+      for (UInt32 i = 0; i < _directory_shards.size(); i++)
+      {
+         DramDirectoryCntlr* dram_directory_cntlr = _directory_shards[i]->getDramDirectoryCntlr();
+         os << "Dram Directory Shard " << i + 1 << " Summary:\n";
+         dram_directory_cntlr->outputSummary(os);
+         os << "Dram Directory Cache Summary:\n";
+         dram_directory_cntlr->getDramDirectoryCache()->outputSummary(os);
+      }
+      if (_l3_cache_cntlr)
+      {
+         os << "L3 Cache Summary:\n";
+         _l3_cache_cntlr->outputSummary(os);
+      }
    }
    else
    {
       DramPerfModel::dummyOutputSummary(os);
+      DramDirectoryCntlr::dummyOutputSummary(os);
       os << "Dram Directory Cache Summary:\n";
       DirectoryCache::dummyOutputSummary(os, getTile()->getId());
    }
@@ -488,27 +1057,27 @@ void
 MemoryManager::waitForAppThread()
 {
    _sim_thread_sem.wait();
-   _lock.acquire();
+   acquireLock();
 }
 
 void
 MemoryManager::wakeUpAppThread()
 {
-   _lock.release();
+   releaseLock();
    _app_thread_sem.signal();
 }
 
 void
 MemoryManager::waitForSimThread()
 {
-   _lock.release();
+   releaseLock();
    _app_thread_sem.wait();
 }
 
 void
 MemoryManager::wakeUpSimThread()
 {
-   _lock.acquire();
+   acquireLock();
    _sim_thread_sem.signal();
 }
 
@@ -539,8 +1108,9 @@ void
 MemoryManager::outputCacheLineReplicationSummary()
 {
    // Static Function to Compute the Time Varying Replication Index of a Cache Line
-   // Go through the set of all caches and directories and get the
-   // number of times each cache line is replicated
+   // Go through the set of all caches and get the number of exclusive and shared
+   // lines. The number of sharers of the lines is kept by the directories as the
+   // sharers are added and removed
 
    SInt32 total_tiles = (SInt32) Config::getSingleton()->getTotalTiles();
    
@@ -549,7 +1119,10 @@ MemoryManager::outputCacheLineReplicationSummary()
    UInt64 total_exclusive_lines_l2_cache = 0;
    UInt64 total_shared_lines_l2_cache = 0;
    UInt64 total_cache_lines_l2_cache = 0;
-   vector<UInt64> total_cache_line_sharer_count(total_tiles+1, 0);
+   vector<UInt64> total_cache_line_sharer_count;
+   Directory::getSharerStats(total_cache_line_sharer_count);
+   for (SInt32 num_sharers = 1; num_sharers <= total_tiles; num_sharers ++)
+      total_cache_lines_l2_cache += total_cache_line_sharer_count[num_sharers];
    
    for (SInt32 tile_id = 0; tile_id < total_tiles; tile_id ++)
    {
@@ -560,9 +1133,6 @@ MemoryManager::outputCacheLineReplicationSummary()
       Cache* l1_icache = memory_manager->getL1ICache();
       Cache* l1_dcache = memory_manager->getL1DCache();
       Cache* l2_cache = memory_manager->getL2Cache();
-      Directory* directory = (Directory*) NULL;
-      if (memory_manager->isDramCntlrPresent())
-         directory = memory_manager->getDramDirectoryCache()->getDirectory();
    
       // Get total lines in L1 caches & L2 cache
       vector<UInt64> _l1_icache_line_state_counters;
@@ -572,11 +1142,15 @@ MemoryManager::outputCacheLineReplicationSummary()
       l1_dcache->getCacheLineStateCounters(_l1_dcache_line_state_counters);
       l2_cache->getCacheLineStateCounters(_l2_cache_line_state_counters);
 
-      UInt64 num_exclusive_lines_l1_icache = _l1_icache_line_state_counters[CacheState::MODIFIED];
+      // Lines with a single owner, MODIFIED or (MESI) EXCLUSIVE
+      UInt64 num_exclusive_lines_l1_icache = _l1_icache_line_state_counters[CacheState::MODIFIED] +
+                                             _l1_icache_line_state_counters[CacheState::EXCLUSIVE];
       UInt64 num_shared_lines_l1_icache = _l1_icache_line_state_counters[CacheState::SHARED];
-      UInt64 num_exclusive_lines_l1_dcache = _l1_dcache_line_state_counters[CacheState::MODIFIED];
+      UInt64 num_exclusive_lines_l1_dcache = _l1_dcache_line_state_counters[CacheState::MODIFIED] +
+                                             _l1_dcache_line_state_counters[CacheState::EXCLUSIVE];
       UInt64 num_shared_lines_l1_dcache = _l1_dcache_line_state_counters[CacheState::SHARED];
-      UInt64 num_exclusive_lines_l2_cache = _l2_cache_line_state_counters[CacheState::MODIFIED];
+      UInt64 num_exclusive_lines_l2_cache = _l2_cache_line_state_counters[CacheState::MODIFIED] +
+                                            _l2_cache_line_state_counters[CacheState::EXCLUSIVE];
       UInt64 num_shared_lines_l2_cache = _l2_cache_line_state_counters[CacheState::SHARED];
 
       // Get total
@@ -584,17 +1158,6 @@ MemoryManager::outputCacheLineReplicationSummary()
       total_shared_lines_l1_cache += (num_shared_lines_l1_icache + num_shared_lines_l1_dcache);
       total_exclusive_lines_l2_cache += num_exclusive_lines_l2_cache;
       total_shared_lines_l2_cache += num_shared_lines_l2_cache;
-
-      if (directory)
-      {
-         vector<UInt64> cache_line_sharer_count;
-         directory->getSharerStats(cache_line_sharer_count);
-         for (SInt32 num_sharers = 1; num_sharers <= total_tiles; num_sharers ++)
-         {
-            total_cache_line_sharer_count[num_sharers] += cache_line_sharer_count[num_sharers];
-            total_cache_lines_l2_cache += cache_line_sharer_count[num_sharers];
-         }
-      }
    }
 
    // Write to file
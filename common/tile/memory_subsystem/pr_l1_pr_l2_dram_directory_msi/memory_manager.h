@@ -1,17 +1,23 @@
 #pragma once
 
+#include <queue>
+using std::queue;
+
 #include "../memory_manager.h"
 #include "cache.h"
 #include "l1_cache_cntlr.h"
 #include "l2_cache_cntlr.h"
 #include "dram_directory_cntlr.h"
+#include "directory_shard.h"
 #include "dram_cntlr.h"
+#include "l3_cache_cntlr.h"
 #include "address_home_lookup.h"
 #include "shmem_msg.h"
 #include "mem_component.h"
 #include "semaphore.h"
 #include "fixed_types.h"
 #include "shmem_perf_model.h"
+#include "trace_file.h"
 
 namespace PrL1PrL2DramDirectoryMSI
 {
@@ -30,21 +36,35 @@ namespace PrL1PrL2DramDirectoryMSI
       DramCntlr* getDramCntlr() { return _dram_cntlr; }
       bool isDramCntlrPresent() { return _dram_cntlr_present; }
       AddressHomeLookup* getDramDirectoryHomeLookup() { return _dram_directory_home_lookup; }
+      ShmemPerfModel* getDirectoryShmemPerfModel(IntPtr address);
 
       bool coreInitiateMemoryAccess(MemComponent::Type mem_component,
                                     Core::lock_signal_t lock_signal, Core::mem_op_t mem_op_type,
                                     IntPtr address, UInt32 offset, Byte* data_buf, UInt32 data_length,
                                     UInt64& curr_time, bool modeled);
+      UInt32 coreInitiateMemoryAccesses(MemComponent::Type mem_component, Core::mem_op_t mem_op_type,
+                                        LineAccess* lines, UInt32 num_lines,
+                                        UInt64& curr_time, bool modeled,
+                                        UInt32 max_lines_in_flight = 0);
+      bool coreProbeL1Hit(MemComponent::Type mem_component,
+                          IntPtr address, UInt32 offset, Byte* data_buf, UInt32 data_length,
+                          UInt64& curr_time);
 
       void handleMsgFromNetwork(NetPacket& packet);
 
       // Send/Broadcast msg
       void sendMsg(tile_id_t receiver, ShmemMsg& msg);
       void broadcastMsg(ShmemMsg& msg);
+      // A single packet to all the receivers, routed as a multicast tree by the
+      // networks with a broadcast tree
+      void multicastMsg(const vector<tile_id_t>& receivers, ShmemMsg& msg);
      
       void enableModels();
       void disableModels();
 
+      void saveCheckpoint(CheckpointWriter& writer);
+      void restoreCheckpoint(CheckpointReader& reader);
+
       tile_id_t getShmemRequester(const void* pkt_data)
       { return ((ShmemMsg*) pkt_data)->getRequester(); }
       UInt32 getModeledLength(const void* pkt_data)
@@ -60,6 +80,17 @@ namespace PrL1PrL2DramDirectoryMSI
       void waitForSimThread();
       void wakeUpSimThread();
 
+      // Functional warmup: complete a miss of the APP thread without the SIM threads.
+      // Returns false if the miss must go through the network
+      bool processFunctionalWarmupMiss(ShmemMsg& shmem_msg);
+      // Synchronous coherence: same, with the models, for the whole run
+      bool processSynchronousMiss(ShmemMsg& shmem_msg);
+      // The msg being handled was delivered by an APP thread, not the network
+      bool isHandlingFunctionalWarmupMsg() { return (_handling_msg_queue != NULL); }
+      // The reply of a miss of the APP thread of this tile was handled at 'time'
+      bool isSynchronousMissOutstanding() { return _synchronous_miss_outstanding; }
+      void completeSynchronousMiss(UInt64 time);
+
       // Cache line replication trace
       static void openCacheLineReplicationTraceFiles();
       static void closeCacheLineReplicationTraceFiles();
@@ -72,6 +103,20 @@ namespace PrL1PrL2DramDirectoryMSI
       L2CacheCntlr* _l2_cache_cntlr;
       DramDirectoryCntlr* _dram_directory_cntlr;
       DramCntlr* _dram_cntlr;
+      // Shared L3 cache slice in front of the DRAM controller, NULL without one
+      L3CacheCntlr* _l3_cache_cntlr;
+
+      // Directory shards (caching_protocol/pr_l1_pr_l2_dram_directory_msi/directory_sim_threads).
+      // Shard 0 is '_dram_directory_cntlr', served by the sim thread of the
+      // tile, the others have a thread of their own. The shard of a line is
+      // given by the '_log_num_directory_shards' address bits above the
+      // ones that select its home
+      vector<DirectoryShard*> _directory_shards;
+      UInt32 _log_num_directory_shards;
+      UInt32 _directory_shard_shift;
+
+      UInt32 getDirectoryShard(IntPtr address);
+      ShmemPerfModel* getSenderShmemPerfModel(ShmemMsg& shmem_msg);
 
       // Home lookups
       AddressHomeLookup* _dram_directory_home_lookup;
@@ -83,6 +128,40 @@ namespace PrL1PrL2DramDirectoryMSI
       Semaphore _app_thread_sem;
       Semaphore _sim_thread_sem;
 
+      // L1 read hit fast path (caching_protocol/pr_l1_pr_l2_dram_directory_msi/l1_hit_fast_path).
+      // '_l1_version' is odd while '_lock' is held, so the app thread can read
+      // its L1 caches without the lock and fall back when they changed under it.
+      // The replacement and counter updates of those hits are queued (a ring
+      // appended by the app thread only) and replayed by the next thread that
+      // takes the lock, before it changes the caches. A hit appended after
+      // another thread has taken the lock since its probe is late: only its
+      // counters are updated, the line may have been replaced in between
+      struct DeferredL1Hit
+      {
+         MemComponent::Type mem_component;
+         IntPtr address;
+         UInt32 version;
+      };
+      static const UInt32 MAX_DEFERRED_L1_HITS = 64;
+      bool _l1_hit_fast_path;
+      volatile UInt32 _l1_version;
+      DeferredL1Hit _deferred_l1_hits[MAX_DEFERRED_L1_HITS];
+      volatile UInt32 _num_deferred_l1_hits;
+      volatile UInt32 _num_replayed_l1_hits;
+
+      void acquireLock()
+      {
+         _lock.acquire();
+         UInt32 version = _l1_version ++;
+         __sync_synchronize();
+         if (_num_deferred_l1_hits != _num_replayed_l1_hits)
+            replayDeferredL1Hits(version);
+      }
+      void releaseLock()
+      { __sync_synchronize(); _l1_version ++; _lock.release(); }
+      // 'version' is the one the lock was taken at
+      void replayDeferredL1Hits(UInt32 version);
+
       UInt32 _cache_line_size;
       bool _enabled;
 
@@ -91,7 +170,44 @@ namespace PrL1PrL2DramDirectoryMSI
       CachePerfModel* _l1_dcache_perf_model;
       CachePerfModel* _l2_cache_perf_model;
       
+      // Functional warmup (before the models are first enabled).
+      // Misses are completed one at a time by the APP thread that takes them
+      // by delivering the msgs in order from a queue instead of the network
+      struct FunctionalWarmupMsg
+      {
+         tile_id_t sender;
+         tile_id_t receiver;
+         UInt64 time;
+         Byte* msg_buf;
+      };
+      bool _functional_warmup;
+      // Queue of the miss whose msg is being handled (with '_lock' held),
+      // the msgs it sends go there. NULL while handling a network msg
+      queue<FunctionalWarmupMsg>* _handling_msg_queue;
+      static Lock _functional_warmup_lock;
+      static bool _functional_warmup_done;
+      static queue<FunctionalWarmupMsg> _functional_warmup_msg_queue;
+
+      // Synchronous coherence (caching_protocol/pr_l1_pr_l2_dram_directory_msi/synchronous_coherence).
+      // Lite mode, one process: the APP thread completes its misses as in the
+      // functional warmup, but with the models, each msg arriving at the time
+      // given by the network models along its route. The misses to lines of
+      // different lock stripes (line address bits) run concurrently, each
+      // with a queue of its own
+      static const UInt32 NUM_SYNCHRONOUS_MISS_LOCKS = 1024;
+      bool _synchronous_coherence;
+      static Lock _synchronous_miss_locks[NUM_SYNCHRONOUS_MISS_LOCKS];
+      // The reply may be handled by the thread of another miss, or by the
+      // SIM thread if the request waited behind a network one at the directory
+      volatile bool _synchronous_miss_outstanding;
+      UInt64 _synchronous_miss_completion_time;
+
+      void enqueueFunctionalWarmupMsg(tile_id_t receiver, ShmemMsg& shmem_msg, queue<FunctionalWarmupMsg>& msg_queue);
+      void deliverFunctionalWarmupMsgs(queue<FunctionalWarmupMsg>& msg_queue);
+      void handleFunctionalWarmupMsg(const FunctionalWarmupMsg& msg, queue<FunctionalWarmupMsg>& msg_queue);
+      void handleMsg(tile_id_t sender, ShmemMsg* shmem_msg);
+      
       // Cache Line Replication
-      static ofstream _cache_line_replication_file;
+      static TraceFile _cache_line_replication_file;
    };
 }
@@ -0,0 +1,151 @@
+#include "page_classifier.h"
+#include "checkpoint.h"
+#include "config.h"
+#include "utils.h"
+#include "log.h"
+
+namespace PrL1PrL2DramDirectoryMSI
+{
+
+bool PageClassifier::_enabled = false;
+UInt32 PageClassifier::_page_size_log2 = 0;
+UInt32 PageClassifier::_cache_line_size_log2 = 0;
+PageClassifier::PageTable* PageClassifier::_page_tables = NULL;
+Lock* PageClassifier::_locks = NULL;
+
+void
+PageClassifier::initialize(UInt32 page_size, UInt32 cache_line_size)
+{
+   // The memory managers are created one after the other, the first one sets it up
+   if (_enabled)
+      return;
+
+   LOG_ASSERT_ERROR(isPower2(page_size) && (page_size >= cache_line_size) && (page_size / cache_line_size <= 64),
+                    "Private page size(%u) must be a power of 2, with at most 64 lines(%u bytes)",
+                    page_size, cache_line_size);
+
+   _page_size_log2 = floorLog2(page_size);
+   _cache_line_size_log2 = floorLog2(cache_line_size);
+   _page_tables = new PageTable[NUM_BUCKETS];
+   _locks = new Lock[NUM_BUCKETS];
+   _enabled = true;
+}
+
+bool
+PageClassifier::processRequest(IntPtr address, tile_id_t requester, bool exclusive)
+{
+   UInt64 page_num = getPageNum(address);
+   UInt32 bucket = getBucket(page_num);
+   ScopedLock sl(_locks[bucket]);
+
+   PageTable::iterator it = _page_tables[bucket].find(page_num);
+   if (it == _page_tables[bucket].end())
+   {
+      PageInfo page_info;
+      page_info.owner = requester;
+      page_info.shared = false;
+      page_info.untracked_lines = 0;
+      page_info.exclusive_lines = 0;
+      it = _page_tables[bucket].insert(make_pair(page_num, page_info)).first;
+   }
+   PageInfo& page_info = it->second;
+
+   if (page_info.shared)
+      return false;
+   if (page_info.owner != requester)
+   {
+      LOG_PRINT("Page(%#lx) of tile(%i) shared by tile(%i)", page_num << _page_size_log2, page_info.owner, requester);
+      page_info.shared = true;
+      return false;
+   }
+
+   UInt64 line_bit = getLineBit(address);
+   page_info.untracked_lines |= line_bit;
+   if (exclusive)
+      page_info.exclusive_lines |= line_bit;
+   return true;
+}
+
+bool
+PageClassifier::removeUntrackedLine(IntPtr address, tile_id_t sender)
+{
+   UInt64 page_num = getPageNum(address);
+   UInt32 bucket = getBucket(page_num);
+   ScopedLock sl(_locks[bucket]);
+
+   PageTable::iterator it = _page_tables[bucket].find(page_num);
+   UInt64 line_bit = getLineBit(address);
+   if ((it == _page_tables[bucket].end()) || !(it->second.untracked_lines & line_bit))
+      return false;
+
+   LOG_ASSERT_ERROR(it->second.owner == sender, "Untracked address(%#lx) of tile(%i) evicted by tile(%i)",
+                    address, it->second.owner, sender);
+   it->second.untracked_lines &= ~line_bit;
+   it->second.exclusive_lines &= ~line_bit;
+   return true;
+}
+
+bool
+PageClassifier::trackLine(IntPtr address, tile_id_t& owner, bool& exclusive)
+{
+   UInt64 page_num = getPageNum(address);
+   UInt32 bucket = getBucket(page_num);
+   ScopedLock sl(_locks[bucket]);
+
+   PageTable::iterator it = _page_tables[bucket].find(page_num);
+   UInt64 line_bit = getLineBit(address);
+   if ((it == _page_tables[bucket].end()) || !(it->second.untracked_lines & line_bit))
+      return false;
+
+   // Only the first request of another tile makes the page shared
+   LOG_ASSERT_ERROR(it->second.shared, "Address(%#lx) of private page tracked", address);
+   owner = it->second.owner;
+   exclusive = (it->second.exclusive_lines & line_bit);
+   it->second.untracked_lines &= ~line_bit;
+   it->second.exclusive_lines &= ~line_bit;
+   return true;
+}
+
+void
+PageClassifier::saveState(CheckpointWriter& writer)
+{
+   UInt64 num_pages = 0;
+   for (UInt32 i = 0; i < NUM_BUCKETS; i++)
+      num_pages += _page_tables[i].size();
+
+   writer.beginSection("Page Classifier");
+   writer << _page_size_log2 << num_pages;
+   for (UInt32 i = 0; i < NUM_BUCKETS; i++)
+   {
+      for (PageTable::iterator it = _page_tables[i].begin(); it != _page_tables[i].end(); it++)
+      {
+         writer << it->first << it->second.owner << (UInt8) it->second.shared
+                << it->second.untracked_lines << it->second.exclusive_lines;
+      }
+   }
+}
+
+void
+PageClassifier::restoreState(CheckpointReader& reader)
+{
+   reader.beginSection("Page Classifier");
+   UInt32 page_size_log2;
+   UInt64 num_pages;
+   reader >> page_size_log2 >> num_pages;
+   LOG_ASSERT_ERROR(page_size_log2 == _page_size_log2, "Checkpoint private page size(%u), expected(%u)",
+                    1 << page_size_log2, 1 << _page_size_log2);
+
+   for (UInt32 i = 0; i < NUM_BUCKETS; i++)
+      _page_tables[i].clear();
+   for (UInt64 i = 0; i < num_pages; i++)
+   {
+      UInt64 page_num;
+      PageInfo page_info;
+      UInt8 shared;
+      reader >> page_num >> page_info.owner >> shared >> page_info.untracked_lines >> page_info.exclusive_lines;
+      page_info.shared = shared;
+      _page_tables[getBucket(page_num)][page_num] = page_info;
+   }
+}
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <map>
+using std::map;
+
+#include "fixed_types.h"
+#include "lock.h"
+
+class CheckpointWriter;
+class CheckpointReader;
+
+namespace PrL1PrL2DramDirectoryMSI
+{
+
+// Private/shared classification of the pages (private_page_classification).
+// A page is private to the first tile that misses on it, until another tile
+// misses on it: it is shared from then on. The misses of the owner to the
+// lines of a private page are answered by the home without a directory
+// entry (no directory access, no entry allocated or nullified). Such a line
+// is untracked: the page table keeps one bit for it (and one more if the
+// owner may write it), cleared when the owner evicts it.
+//   When the page becomes shared, the owner keeps its lines. The home of each
+// untracked line turns its bits into a directory entry (the owner as sharer,
+// or as owner of a MODIFIED line) when it next allocates an entry for it, so
+// the protocol goes on as if the line had always been tracked.
+//   The page table is shared by the tiles, so it needs all of them in one
+// process.
+class PageClassifier
+{
+public:
+   static void initialize(UInt32 page_size, UInt32 cache_line_size);
+   static bool isEnabled()    { return _enabled; }
+
+   // Miss of 'requester' to the line of 'address'. True if the page is
+   // private to 'requester', the line is then untracked ('exclusive' if the
+   // requester may write it). False if the page is (or becomes) shared
+   static bool processRequest(IntPtr address, tile_id_t requester, bool exclusive);
+
+   // Eviction of a line by 'sender', true if the line was untracked. The
+   // line is not cached anymore
+   static bool removeUntrackedLine(IntPtr address, tile_id_t sender);
+
+   // The directory entry of a line is allocated, true if the line is cached
+   // untracked by 'owner' ('exclusive' if it may be MODIFIED). It is tracked
+   // by the entry from then on
+   static bool trackLine(IntPtr address, tile_id_t& owner, bool& exclusive);
+
+   static void saveState(CheckpointWriter& writer);
+   static void restoreState(CheckpointReader& reader);
+
+private:
+   struct PageInfo
+   {
+      tile_id_t owner;
+      bool shared;
+      // One bit per line of the page
+      UInt64 untracked_lines;
+      UInt64 exclusive_lines;
+   };
+   typedef map<UInt64,PageInfo> PageTable;
+
+   static const UInt32 NUM_BUCKETS = 1024;
+
+   static bool _enabled;
+   static UInt32 _page_size_log2;
+   static UInt32 _cache_line_size_log2;
+   static PageTable* _page_tables;
+   static Lock* _locks;
+
+   static UInt64 getPageNum(IntPtr address)  { return address >> _page_size_log2; }
+   static UInt32 getBucket(UInt64 page_num)  { return page_num % NUM_BUCKETS; }
+   static UInt64 getLineBit(IntPtr address)
+   { return ((UInt64) 1) << ((address >> _cache_line_size_log2) & ((1 << (_page_size_log2 - _cache_line_size_log2)) - 1)); }
+};
+
+}
@@ -20,12 +20,19 @@ namespace PrL1PrL2DramDirectoryMSI
          WB_REQ,
          EX_REP,
          SH_REP,
+         // MESI: reply to a SH_REQ for a line no other tile has
+         EXCLUSIVE_REP,
          UPGRADE_REP,
          INV_REP,
          FLUSH_REP,
          WB_REP,
          NULLIFY_REQ,
-         MAX_MSG_TYPE = NULLIFY_REQ,
+         // Far atomics: the atomic gets a copy of the line held at its home,
+         // the line is written back to the home when the atomic completes
+         ATOMIC_REQ,
+         ATOMIC_REP,
+         ATOMIC_WB_REP,
+         MAX_MSG_TYPE = ATOMIC_WB_REP,
          NUM_MSG_TYPES = MAX_MSG_TYPE - MIN_MSG_TYPE + 1
       };  
       
@@ -48,7 +55,11 @@ namespace PrL1PrL2DramDirectoryMSI
 
       ~ShmemMsg();
 
-      static ShmemMsg* getShmemMsg(Byte* msg_buf);
+      // Reads the msg in place: 'data_buf' points into 'msg_buf', which must
+      // outlive 'shmem_msg'
+      static void getShmemMsg(Byte* msg_buf, ShmemMsg* shmem_msg);
+      // Writes the msg into 'msg_buf', of at least getMsgLen() bytes
+      void makeMsgBuf(Byte* msg_buf);
       Byte* makeMsgBuf();
       UInt32 getMsgLen();
 
@@ -64,6 +75,7 @@ namespace PrL1PrL2DramDirectoryMSI
       UInt32 getDataLength() const { return _data_length; }
       bool isModeled() const { return _modeled; }
 
+      void setType(Type msg_type) { _msg_type = msg_type; }
       void setAddress(IntPtr address) { _address = address; }
       void setSenderMemComponent(MemComponent::Type mem_component) { _sender_mem_component = mem_component; }
       void setDataBuf(Byte* data_buf) { _data_buf = data_buf; }
@@ -77,7 +89,11 @@ namespace PrL1PrL2DramDirectoryMSI
       Byte* _data_buf;
       UInt32 _data_length;
       bool _modeled;
+      // Set when the msg buffer is made: the modeled length of the data (in
+      // bits), and whether the data was left out of the buffer
+      UInt32 _modeled_data_length;
+      bool _data_elided;
 
-      static const UInt32 _num_msg_type_bits = 4;
+      static const UInt32 _num_msg_type_bits = 5;
    };
 }
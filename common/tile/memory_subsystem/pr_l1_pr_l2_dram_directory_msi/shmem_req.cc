@@ -4,16 +4,15 @@
 namespace PrL1PrL2DramDirectoryMSI
 {
    ShmemReq::ShmemReq(ShmemMsg* shmem_msg, UInt64 time):
-      m_time(time)
+      m_shmem_msg(shmem_msg), // Local copy of the shmem_msg
+      m_time(time),
+      m_arrival_time(time),
+      m_far_atomic(false)
    {
-      // Make a local copy of the shmem_msg
-      m_shmem_msg = new ShmemMsg(shmem_msg);
       LOG_ASSERT_ERROR(shmem_msg->getDataBuf() == NULL, 
             "Shmem Reqs should not have data payloads");
    }
 
    ShmemReq::~ShmemReq()
-   {
-      delete m_shmem_msg;
-   }
+   {}
 }
@@ -8,17 +8,24 @@ namespace PrL1PrL2DramDirectoryMSI
    class ShmemReq
    {
       private:
-         ShmemMsg* m_shmem_msg;
+         ShmemMsg m_shmem_msg;
          UInt64 m_time;
+         UInt64 m_arrival_time;
+         // An ATOMIC_REQ performed at the home, holding the line until its ATOMIC_WB_REP
+         bool m_far_atomic;
 
       public:
          ShmemReq(ShmemMsg* shmem_msg, UInt64 time);
          ~ShmemReq();
 
-         ShmemMsg* getShmemMsg() { return m_shmem_msg; }
+         ShmemMsg* getShmemMsg() { return &m_shmem_msg; }
+         const ShmemMsg* getShmemMsg() const { return &m_shmem_msg; }
          UInt64 getTime() { return m_time; }
+         UInt64 getArrivalTime() { return m_arrival_time; }
+         bool isFarAtomic() { return m_far_atomic; }
          
          void setTime(UInt64 time) { m_time = time; }
+         void setFarAtomic(bool far_atomic) { m_far_atomic = far_atomic; }
          void updateTime(UInt64 time)
          {
             if (time > m_time)
@@ -30,7 +30,7 @@ DramCntlr::handleMsgFromL2Cache(tile_id_t sender, ShmemMsg* shmem_msg)
    case ShmemMsg::DRAM_FETCH_REQ:
       {
          Byte data_buf[_cache_line_size];
-         getDataFromDram(address, data_buf, msg_modeled);
+         getDataFromDram(address, data_buf, msg_modeled, requester);
          LOG_PRINT("Finished fetching data from DRAM_CNTLR, sending reply");
          ShmemMsg dram_reply(ShmemMsg::DRAM_FETCH_REP, MemComponent::DRAM_CNTLR, MemComponent::L2_CACHE,
                              requester, false, address,
@@ -1,5 +1,7 @@
 #include "l1_cache_cntlr.h"
 #include "memory_manager.h"
+#include "nuca_placement.h"
+#include "network_model_emesh_hop_by_hop.h"
 #include "log.h"
 
 namespace PrL1ShL2MSI
@@ -18,9 +20,25 @@ L1CacheCntlr::L1CacheCntlr(MemoryManager* memory_manager,
                            string L1_dcache_replacement_policy,
                            UInt32 L1_dcache_access_delay,
                            bool L1_dcache_track_miss_types,
+                           UInt32 L2_replica_size,
+                           UInt32 L2_replica_associativity,
+                           string L2_replica_replacement_policy,
+                           bool replicate_instructions,
+                           bool victim_replication,
                            float frequency)
    : _memory_manager(memory_manager)
    , _L2_cache_home_lookup(L2_cache_home_lookup)
+   , _L2_replica_cache(NULL)
+   , _L2_replica_replacement_policy_obj(NULL)
+   , _L2_replica_hash_fn_obj(NULL)
+   , _replicate_instructions(replicate_instructions)
+   , _victim_replication(victim_replication)
+   , _enabled(false)
+   , _total_L2_requests(0)
+   , _total_L2_request_hops(0)
+   , _total_static_L2_request_hops(0)
+   , _total_replica_fills(0)
+   , _total_replica_evictions(0)
 {
    _L1_icache_replacement_policy_obj = 
       CacheReplacementPolicy::create(L1_icache_replacement_policy, L1_icache_size, L1_icache_associativity, cache_line_size);
@@ -55,6 +73,26 @@ L1CacheCntlr::L1CacheCntlr(MemoryManager* memory_manager,
          L1_dcache_access_delay,
          frequency,
          L1_dcache_track_miss_types);
+
+   if (L2_replica_size > 0)
+   {
+      _L2_replica_replacement_policy_obj =
+         CacheReplacementPolicy::create(L2_replica_replacement_policy, L2_replica_size, L2_replica_associativity, cache_line_size);
+      _L2_replica_hash_fn_obj = new CacheHashFn(L2_replica_size, L2_replica_associativity, cache_line_size);
+      // The replicas keep the L1 cache they stand for in the caching component of the L2 line info
+      _L2_replica_cache = new Cache("L2-Replica",
+            PR_L1_SH_L2_MSI,
+            Cache::UNIFIED_CACHE,
+            L2,
+            Cache::WRITE_BACK,
+            L2_replica_size,
+            L2_replica_associativity,
+            cache_line_size,
+            _L2_replica_replacement_policy_obj,
+            _L2_replica_hash_fn_obj,
+            L1_dcache_access_delay,
+            frequency);
+   }
 }
 
 L1CacheCntlr::~L1CacheCntlr()
@@ -65,6 +103,9 @@ L1CacheCntlr::~L1CacheCntlr()
    delete _L1_dcache_replacement_policy_obj;
    delete _L1_icache_hash_fn_obj;
    delete _L1_dcache_hash_fn_obj;
+   delete _L2_replica_cache;
+   delete _L2_replica_replacement_policy_obj;
+   delete _L2_replica_hash_fn_obj;
 }      
 
 bool
@@ -235,6 +276,11 @@ L1CacheCntlr::insertCacheLine(MemComponent::Type mem_component, IntPtr address,
       assert(evicted_cache_line_info.isValid());
       LOG_PRINT("evicted address(%#lx)", evicted_address);
 
+      // The tile stays a sharer as long as the line is replicated in the local L2 slice
+      if ( (evicted_cache_line_info.getCState() == CacheState::SHARED) && _L2_replica_cache &&
+           keepInL2Replica(mem_component, evicted_address, writeback_buf) )
+         return;
+
       UInt32 L2_cache_home = getL2CacheHome(evicted_address);
       bool msg_modeled = Config::getSingleton()->isApplicationTile(getTileId());
 
@@ -280,11 +326,19 @@ L1CacheCntlr::handleMsgFromCore(ShmemMsg* shmem_msg)
    _outstanding_shmem_msg_time = getShmemPerfModel()->getCycleCount();
 
    IntPtr address = shmem_msg->getAddress();
+
+   // Look for a replica in the local L2 slice first
+   if (_L2_replica_cache && processReqInL2Replica(shmem_msg))
+      return;
+
+   tile_id_t L2_cache_home = getL2CacheHome(address);
+   updateL2RequestCounters(address, L2_cache_home);
+
    // Send msg out to L2 cache
    ShmemMsg send_shmem_msg(shmem_msg->getType(), shmem_msg->getReceiverMemComponent(), MemComponent::L2_CACHE,
                            shmem_msg->getRequester(), false, address,
                            shmem_msg->isModeled());
-   getMemoryManager()->sendMsg(_L2_cache_home_lookup->getHome(address), send_shmem_msg);
+   getMemoryManager()->sendMsg(L2_cache_home, send_shmem_msg);
 }
 
 void
@@ -362,6 +416,13 @@ L1CacheCntlr::processShRepFromL2Cache(tile_id_t sender, ShmemMsg* shmem_msg)
    assert(address == _outstanding_shmem_msg.getAddress());
    // Insert Cache Line in L1-I/L1-D Cache
    insertCacheLine(mem_component, address, CacheState::SHARED, data_buf);
+
+   // Instructions are read-only, keep a copy of the ones homed elsewhere in the local L2 slice
+   if ( _L2_replica_cache && _replicate_instructions && (mem_component == MemComponent::L1_ICACHE) &&
+        (sender != getTileId()) )
+   {
+      insertL2Replica(mem_component, address, data_buf);
+   }
 }
 
 void
@@ -400,14 +461,19 @@ L1CacheCntlr::processInvReqFromL2Cache(tile_id_t sender, ShmemMsg* shmem_msg)
    // Update Shared Mem perf counters for access to L1-D Cache
    getMemoryManager()->incrCycleCount(mem_component, CachePerfModel::ACCESS_CACHE_TAGS);
 
-   if (cstate != CacheState::INVALID)
-   {
-      LOG_ASSERT_ERROR(cstate == CacheState::SHARED, "cstate(%u)", cstate);
+   // A replica in the local L2 slice is dropped along with the L1 copy
+   bool replica_invalidated = (_L2_replica_cache != NULL) && invalidateL2Replica(address);
 
+   if ((cstate != CacheState::INVALID) || replica_invalidated)
+   {
       // SHARED -> INVALID 
+      if (cstate != CacheState::INVALID)
+      {
+         LOG_ASSERT_ERROR(cstate == CacheState::SHARED, "cstate(%u)", cstate);
 
-      // Invalidate the line in L1-D Cache
-      invalidateCacheLine(mem_component, address);
+         // Invalidate the line in L1-D Cache
+         invalidateCacheLine(mem_component, address);
+      }
       
       ShmemMsg send_shmem_msg(ShmemMsg::INV_REP, mem_component, MemComponent::L2_CACHE,
                               shmem_msg->getRequester(), shmem_msg->isReplyExpected(), address,
@@ -534,9 +600,181 @@ L1CacheCntlr::getL1Cache(MemComponent::Type mem_component)
 tile_id_t
 L1CacheCntlr::getL2CacheHome(IntPtr address)
 {
+   if (NucaPlacement::isEnabled())
+      return NucaPlacement::getHome(address, getTileId(), _L2_cache_home_lookup->getHome(address));
    return _L2_cache_home_lookup->getHome(address);
 }
 
+void
+L1CacheCntlr::updateL2RequestCounters(IntPtr address, tile_id_t L2_cache_home)
+{
+   if (!_enabled || !NucaPlacement::isEnabled())
+      return;
+
+   // Hops on the mesh to the slice the request goes to, and to the slice of the static mapping
+   _total_L2_requests ++;
+   if (L2_cache_home != INVALID_TILE_ID)
+      _total_L2_request_hops += NetworkModelEMeshHopByHop::computeDistance(getTileId(), L2_cache_home);
+   _total_static_L2_request_hops += NetworkModelEMeshHopByHop::computeDistance(getTileId(), _L2_cache_home_lookup->getHome(address));
+}
+
+bool
+L1CacheCntlr::processReqInL2Replica(ShmemMsg* shmem_msg)
+{
+   IntPtr address = shmem_msg->getAddress();
+   MemComponent::Type mem_component = shmem_msg->getReceiverMemComponent();
+   ShmemMsg::Type shmem_msg_type = shmem_msg->getType();
+
+   ShL2CacheLineInfo replica_line_info;
+   _L2_replica_cache->getCacheLineInfo(address, &replica_line_info);
+   bool replica_hit = replica_line_info.isValid() && (replica_line_info.getCachingComponent() == mem_component);
+   _L2_replica_cache->updateMissCounters(address, (shmem_msg_type == ShmemMsg::SH_REQ) ? Core::READ : Core::WRITE,
+                                         !replica_hit);
+
+   if (!replica_line_info.isValid())
+   {
+      getMemoryManager()->incrCycleCount(MemComponent::L2_CACHE, CachePerfModel::ACCESS_CACHE_TAGS);
+      return false;
+   }
+   getMemoryManager()->incrCycleCount(MemComponent::L2_CACHE, CachePerfModel::ACCESS_CACHE_DATA_AND_TAGS);
+
+   if (!replica_hit)
+   {
+      // The home has this tile as a sharer for the other L1 cache, give the line back first
+      MemComponent::Type replica_mem_component;
+      invalidateL2Replica(address, &replica_mem_component);
+      sendInvRepForL2Replica(replica_mem_component, address);
+      return false;
+   }
+
+   if (shmem_msg_type == ShmemMsg::SH_REQ)
+   {
+      // Answer the request from the replica, as the home slice would
+      Byte data_buf[getCacheLineSize()];
+      _L2_replica_cache->accessCacheLine(address, Cache::LOAD, data_buf, getCacheLineSize());
+      updateL2RequestCounters(address, INVALID_TILE_ID);
+
+      ShmemMsg reply_msg(ShmemMsg::SH_REP, MemComponent::L2_CACHE, mem_component,
+                         getTileId(), false, address,
+                         data_buf, getCacheLineSize(),
+                         shmem_msg->isModeled());
+      handleMsgFromL2Cache(getTileId(), &reply_msg);
+      return true;
+   }
+
+   // A write needs the home. Move the replica to the L1-D cache, so that the
+   // home sees an upgrade from a sharer as it would without the replica
+   assert(mem_component == MemComponent::L1_DCACHE);
+   PrL1CacheLineInfo L1_cache_line_info;
+   getCacheLineInfo(mem_component, address, &L1_cache_line_info);
+   if (L1_cache_line_info.getCState() == CacheState::INVALID)
+   {
+      Byte data_buf[getCacheLineSize()];
+      _L2_replica_cache->accessCacheLine(address, Cache::LOAD, data_buf, getCacheLineSize());
+      invalidateL2Replica(address);
+      insertCacheLine(mem_component, address, CacheState::SHARED, data_buf);
+   }
+   else
+   {
+      invalidateL2Replica(address);
+   }
+   return false;
+}
+
+bool
+L1CacheCntlr::keepInL2Replica(MemComponent::Type mem_component, IntPtr address, Byte* data_buf)
+{
+   ShL2CacheLineInfo replica_line_info;
+   _L2_replica_cache->getCacheLineInfo(address, &replica_line_info);
+   if (replica_line_info.isValid())
+   {
+      LOG_ASSERT_ERROR(replica_line_info.getCachingComponent() == mem_component,
+                       "Address(%#lx): replica of mem component(%u), evicted from(%u)",
+                       address, replica_line_info.getCachingComponent(), mem_component);
+      return true;
+   }
+
+   if (!_victim_replication)
+      return false;
+
+   insertL2Replica(mem_component, address, data_buf);
+   return true;
+}
+
+void
+L1CacheCntlr::insertL2Replica(MemComponent::Type mem_component, IntPtr address, Byte* data_buf)
+{
+   ShL2CacheLineInfo replica_line_info(_L2_replica_cache->getTag(address));
+   replica_line_info.setCState(CacheState::SHARED);
+   replica_line_info.setCachingComponent(mem_component);
+
+   bool eviction;
+   IntPtr evicted_address;
+   ShL2CacheLineInfo evicted_line_info;
+
+   _L2_replica_cache->insertCacheLine(address, &replica_line_info, data_buf,
+                                      &eviction, &evicted_address, &evicted_line_info, NULL);
+   if (_enabled)
+      _total_replica_fills ++;
+
+   if (eviction)
+   {
+      // The tile is no longer a sharer if the L1 cache does not have the line either
+      MemComponent::Type evicted_mem_component = evicted_line_info.getCachingComponent();
+      PrL1CacheLineInfo L1_cache_line_info;
+      getCacheLineInfo(evicted_mem_component, evicted_address, &L1_cache_line_info);
+      if (L1_cache_line_info.getCState() == CacheState::INVALID)
+      {
+         sendInvRepForL2Replica(evicted_mem_component, evicted_address);
+         if (_enabled)
+            _total_replica_evictions ++;
+      }
+   }
+}
+
+bool
+L1CacheCntlr::invalidateL2Replica(IntPtr address, MemComponent::Type* mem_component)
+{
+   ShL2CacheLineInfo replica_line_info;
+   _L2_replica_cache->getCacheLineInfo(address, &replica_line_info);
+   if (!replica_line_info.isValid())
+      return false;
+
+   if (mem_component)
+      *mem_component = replica_line_info.getCachingComponent();
+   replica_line_info.invalidate();
+   _L2_replica_cache->setCacheLineInfo(address, &replica_line_info);
+   return true;
+}
+
+void
+L1CacheCntlr::sendInvRepForL2Replica(MemComponent::Type mem_component, IntPtr address)
+{
+   bool msg_modeled = Config::getSingleton()->isApplicationTile(getTileId());
+   ShmemMsg send_shmem_msg(ShmemMsg::INV_REP, mem_component, MemComponent::L2_CACHE,
+                           getTileId(), false, address,
+                           msg_modeled);
+   getMemoryManager()->sendMsg(getL2CacheHome(address), send_shmem_msg);
+}
+
+void
+L1CacheCntlr::outputSummary(ostream& out)
+{
+   out << "    L2 Requests: " << _total_L2_requests << endl;
+   if (_total_L2_requests > 0)
+   {
+      out << "    Average Hops To L2 Home: " << 1.0 * _total_L2_request_hops / _total_L2_requests << endl;
+      out << "    Average Hops To Static L2 Home: " << 1.0 * _total_static_L2_request_hops / _total_L2_requests << endl;
+   }
+   else
+   {
+      out << "    Average Hops To L2 Home: " << endl;
+      out << "    Average Hops To Static L2 Home: " << endl;
+   }
+   out << "    Replica Fills: " << _total_replica_fills << endl;
+   out << "    Replica Evictions: " << _total_replica_evictions << endl;
+}
+
 ShmemMsg::Type
 L1CacheCntlr::getShmemMsgType(Core::mem_op_t mem_op_type)
 {
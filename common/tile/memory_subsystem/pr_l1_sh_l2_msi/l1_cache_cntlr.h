@@ -40,11 +40,17 @@ namespace PrL1ShL2MSI
                    string L1_dcache_replacement_policy,
                    UInt32 L1_dcache_access_delay,
                    bool L1_dcache_track_miss_types,
+                   UInt32 L2_replica_size,
+                   UInt32 L2_replica_associativity,
+                   string L2_replica_replacement_policy,
+                   bool replicate_instructions,
+                   bool victim_replication,
                    float frequency);
       ~L1CacheCntlr();
 
       Cache* getL1ICache() { return _L1_icache; }
       Cache* getL1DCache() { return _L1_dcache; }
+      Cache* getL2ReplicaCache() { return _L2_replica_cache; }
 
       bool processMemOpFromCore(MemComponent::Type mem_component,
             Core::lock_signal_t lock_signal,
@@ -55,6 +61,11 @@ namespace PrL1ShL2MSI
       void handleMsgFromCore(ShmemMsg* shmem_msg);
       void handleMsgFromL2Cache(tile_id_t sender, ShmemMsg* shmem_msg);
 
+      void outputSummary(ostream& out);
+
+      void enable() { _enabled = true; }
+      void disable() { _enabled = false; }
+
    private:
       MemoryManager* _memory_manager;
       Cache* _L1_icache;
@@ -65,6 +76,27 @@ namespace PrL1ShL2MSI
       CacheHashFn* _L1_dcache_hash_fn_obj;
       AddressHomeLookup* _L2_cache_home_lookup;
 
+      // Replicas of lines homed in other slices, kept in some of the ways of
+      // the local L2 slice (l2_placement = nuca). Like the L1 caches, they
+      // make this tile a sharer of the line at its home
+      Cache* _L2_replica_cache;
+      CacheReplacementPolicy* _L2_replica_replacement_policy_obj;
+      CacheHashFn* _L2_replica_hash_fn_obj;
+      // Replicate the instruction lines fetched from other slices
+      bool _replicate_instructions;
+      // Keep the SHARED lines evicted from the L1 caches as replicas
+      bool _victim_replication;
+
+      // Is enabled?
+      bool _enabled;
+
+      // Requests to the L2 and the hops to their home slice
+      UInt64 _total_L2_requests;
+      UInt64 _total_L2_request_hops;
+      UInt64 _total_static_L2_request_hops;
+      UInt64 _total_replica_fills;
+      UInt64 _total_replica_evictions;
+
       // Outstanding msg info
       UInt64 _outstanding_shmem_msg_time;
       ShmemMsg _outstanding_shmem_msg;
@@ -76,6 +108,13 @@ namespace PrL1ShL2MSI
       void insertCacheLine(MemComponent::Type mem_component, IntPtr address, CacheState::Type cstate, Byte* data_buf);
       void invalidateCacheLine(MemComponent::Type mem_component, IntPtr address);
 
+      // Operations of the replicas in the local L2 slice
+      bool processReqInL2Replica(ShmemMsg* shmem_msg);
+      bool keepInL2Replica(MemComponent::Type mem_component, IntPtr address, Byte* data_buf);
+      void insertL2Replica(MemComponent::Type mem_component, IntPtr address, Byte* data_buf);
+      bool invalidateL2Replica(IntPtr address, MemComponent::Type* mem_component = NULL);
+      void sendInvRepForL2Replica(MemComponent::Type mem_component, IntPtr address);
+
       void accessCache(MemComponent::Type mem_component,
                        Core::mem_op_t mem_op_type, 
                        IntPtr ca_address, UInt32 offset,
@@ -96,6 +135,7 @@ namespace PrL1ShL2MSI
       void processWbReqFromL2Cache(tile_id_t sender, ShmemMsg* shmem_msg);
 
       tile_id_t getL2CacheHome(IntPtr address);
+      void updateL2RequestCounters(IntPtr address, tile_id_t L2_cache_home);
 
       // Utilities
       tile_id_t getTileId();
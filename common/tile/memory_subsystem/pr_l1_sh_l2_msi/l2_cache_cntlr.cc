@@ -5,6 +5,8 @@
 #include "directory_entry.h"
 #include "l2_cache_replacement_policy.h"
 #include "l2_cache_hash_fn.h"
+#include "nuca_placement.h"
+#include "network_model_emesh_hop_by_hop.h"
 #include "log.h"
 
 #define TYPE(shmem_req)    (shmem_req->getShmemMsg()->getType())
@@ -24,9 +26,13 @@ L2CacheCntlr::L2CacheCntlr(MemoryManager* memory_manager,
    : _memory_manager(memory_manager)
    , _dram_home_lookup(dram_home_lookup)
    , _enabled(false)
+   , _total_forwarded_reqs(0)
+   , _total_forwarded_req_hops(0)
+   , _total_page_migrations(0)
 {
    _L2_cache_replacement_policy_obj =
-      new L2CacheReplacementPolicy(L2_cache_size, L2_cache_associativity, cache_line_size, _L2_cache_req_queue_list);
+      new L2CacheReplacementPolicy(L2_cache_size, L2_cache_associativity, cache_line_size,
+                                   L2_cache_replacement_policy, _L2_cache_req_queue_list);
    _L2_cache_hash_fn_obj = new L2CacheHashFn(L2_cache_size, L2_cache_associativity, cache_line_size);
 
    // L2 cache
@@ -135,6 +141,9 @@ L2CacheCntlr::allocateCacheLine(IntPtr address, ShL2CacheLineInfo* L2_cache_line
    _L2_cache->insertCacheLine(address, L2_cache_line_info, (Byte*) NULL,
                               &eviction, &evicted_address, &evicted_cache_line_info, writeback_buf);
 
+   if (NucaPlacement::isEnabled())
+      NucaPlacement::addCachedLine(address);
+
    if (eviction)
    {
       assert(evicted_cache_line_info.isValid());
@@ -157,7 +166,7 @@ L2CacheCntlr::allocateCacheLine(IntPtr address, ShL2CacheLineInfo* L2_cache_line
                            getTileId(), false, evicted_address,
                            msg_modeled); 
       // Create a new ShmemReq for removing the sharers of the evicted cache line
-      ShmemReq* nullify_req = new ShmemReq(&nullify_msg, eviction_time);
+      ShmemReq* nullify_req = new (_shmem_req_pool.allocate()) ShmemReq(&nullify_msg, eviction_time);
       // Insert the nullify_req into the set of requests to be processed
       _L2_cache_req_queue_list.enqueue(evicted_address, nullify_req);
       
@@ -178,7 +187,7 @@ void
 L2CacheCntlr::handleMsgFromL1Cache(tile_id_t sender, ShmemMsg* shmem_msg)
 {
    // Incr cycle count for every message that comes into the L2 cache
-   _memory_manager->incrCycleCount(MemComponent::L2_CACHE, CachePerfModel::ACCESS_CACHE_DATA_AND_TAGS);
+   _memory_manager->incrL2CacheCycleCount(shmem_msg->getAddress(), CachePerfModel::ACCESS_CACHE_DATA_AND_TAGS);
 
    ShmemMsg::Type shmem_msg_type = shmem_msg->getType();
    UInt64 msg_time = getShmemPerfModel()->getCycleCount();
@@ -186,8 +195,12 @@ L2CacheCntlr::handleMsgFromL1Cache(tile_id_t sender, ShmemMsg* shmem_msg)
    
    if ( (shmem_msg_type == ShmemMsg::EX_REQ) || (shmem_msg_type == ShmemMsg::SH_REQ) )
    {
+      // The page may have moved to another slice
+      if (NucaPlacement::isEnabled() && forwardShmemReq(shmem_msg))
+         return;
+
       // Add request onto a queue
-      ShmemReq* shmem_req = new ShmemReq(shmem_msg, msg_time);
+      ShmemReq* shmem_req = new (_shmem_req_pool.allocate()) ShmemReq(shmem_msg, msg_time);
       _L2_cache_req_queue_list.enqueue(address, shmem_req);
 
       if (_L2_cache_req_queue_list.count(address) == 1)
@@ -238,11 +251,32 @@ L2CacheCntlr::handleMsgFromL1Cache(tile_id_t sender, ShmemMsg* shmem_msg)
    }
 }
 
+bool
+L2CacheCntlr::forwardShmemReq(ShmemMsg* shmem_msg)
+{
+   IntPtr address = shmem_msg->getAddress();
+   bool migrated = false;
+   tile_id_t home = NucaPlacement::processRequest(address, shmem_msg->getRequester(), getTileId(), migrated);
+   if (_enabled && migrated)
+      _total_page_migrations ++;
+   if (home == getTileId())
+      return false;
+
+   LOG_PRINT("Forwarding request(%u) for address(%#lx) to slice(%i)", shmem_msg->getType(), address, home);
+   getMemoryManager()->sendMsg(home, *shmem_msg);
+   if (_enabled)
+   {
+      _total_forwarded_reqs ++;
+      _total_forwarded_req_hops += NetworkModelEMeshHopByHop::computeDistance(getTileId(), home);
+   }
+   return true;
+}
+
 void
 L2CacheCntlr::handleMsgFromDram(tile_id_t sender, ShmemMsg* shmem_msg)
 {
    // Incr cycle count for every message that comes into the L2 cache
-   _memory_manager->incrCycleCount(MemComponent::L2_CACHE, CachePerfModel::ACCESS_CACHE_DATA_AND_TAGS);
+   _memory_manager->incrL2CacheCycleCount(shmem_msg->getAddress(), CachePerfModel::ACCESS_CACHE_DATA_AND_TAGS);
 
    IntPtr address = shmem_msg->getAddress();
 
@@ -277,9 +311,14 @@ L2CacheCntlr::processNextReqFromL1Cache(IntPtr address)
    
    // Get the completed shmem req
    ShmemReq* completed_shmem_req = _L2_cache_req_queue_list.dequeue(address);
+   ShmemMsg::Type completed_type = TYPE(completed_shmem_req);
+   getMemoryManager()->traceDirectoryReq((completed_type == ShmemMsg::EX_REQ) ? "EX_REQ" :
+                                         (completed_type == ShmemMsg::SH_REQ) ? "SH_REQ" : "NULLIFY_REQ",
+                                         address, completed_shmem_req->getArrivalTime(),
+                                         getShmemPerfModel()->getCycleCount());
 
    // Delete the completed shmem req
-   delete completed_shmem_req;
+   _shmem_req_pool.release(completed_shmem_req);
 
    if (!_L2_cache_req_queue_list.empty(address))
    {
@@ -396,6 +435,8 @@ L2CacheCntlr::processNullifyReq(ShmemReq* nullify_req, Byte* data_buf)
       delete L2_cache_line_info.getDirectoryEntry();
       // Remove the address from the evicted map since its handling is complete
       _evicted_cache_line_map.erase(address);
+      if (NucaPlacement::isEnabled())
+         NucaPlacement::removeCachedLine(address);
 
       // Process the next request if completed
       processNextReqFromL1Cache(address);
@@ -872,6 +913,14 @@ L2CacheCntlr::storeDataInDram(IntPtr address, Byte* data_buf, tile_id_t requeste
    getMemoryManager()->sendMsg(getDramHome(address), send_msg);
 }
 
+void
+L2CacheCntlr::outputSummary(ostream& out)
+{
+   out << "    Page Migrations: " << _total_page_migrations << endl;
+   out << "    Forwarded Requests: " << _total_forwarded_reqs << endl;
+   out << "    Forwarded Request Hops: " << _total_forwarded_req_hops << endl;
+}
+
 Core::mem_op_t
 L2CacheCntlr::getMemOpTypeFromShmemMsgType(ShmemMsg::Type shmem_msg_type)
 {
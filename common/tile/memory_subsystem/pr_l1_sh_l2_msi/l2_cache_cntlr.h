@@ -18,6 +18,7 @@ using std::map;
 #include "mem_component.h"
 #include "fixed_types.h"
 #include "hash_map_queue.h"
+#include "object_pool.h"
 #include "shmem_perf_model.h"
 #include "cache_replacement_policy.h"
 #include "cache_hash_fn.h"
@@ -63,9 +64,16 @@ namespace PrL1ShL2MSI
 
       // Req list into the L2 cache
       HashMapQueue<IntPtr,ShmemReq*> _L2_cache_req_queue_list;
+      // Storage of the queued ShmemReqs, recycled
+      ObjectPool<ShmemReq> _shmem_req_pool;
       // Evicted cache line map
       map<IntPtr,ShL2CacheLineInfo> _evicted_cache_line_map;
 
+      // NUCA placement counters
+      UInt64 _total_forwarded_reqs;
+      UInt64 _total_forwarded_req_hops;
+      UInt64 _total_page_migrations;
+
       // L2 cache operations
       void getCacheLineInfo(IntPtr address, ShL2CacheLineInfo* L2_cache_line_info,
                             ShmemMsg::Type shmem_msg_type = ShmemMsg::INVALID_MSG_TYPE, bool update_miss_counters = false);
@@ -85,6 +93,8 @@ namespace PrL1ShL2MSI
 
       // Restart the shmem request
       void restartShmemReq(ShmemReq* shmem_req, ShL2CacheLineInfo* L2_cache_line_info, Byte* data_buf);
+      // Forward a request for a page that moved to another slice (l2_placement = nuca)
+      bool forwardShmemReq(ShmemMsg* shmem_msg);
       // Process the next request to a cache line
       void processNextReqFromL1Cache(IntPtr address);
       // Process shmem request
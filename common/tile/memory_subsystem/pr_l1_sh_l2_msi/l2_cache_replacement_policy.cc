@@ -9,19 +9,38 @@ namespace PrL1ShL2MSI
 {
 
 L2CacheReplacementPolicy::L2CacheReplacementPolicy(UInt32 cache_size, UInt32 associativity, UInt32 cache_line_size,
+                                                   string policy_str,
                                                    HashMapQueue<IntPtr,ShmemReq*>& L2_cache_req_queue_list)
    : CacheReplacementPolicy(cache_size, associativity, cache_line_size)
    , _L2_cache_req_queue_list(L2_cache_req_queue_list)
+   , _base_policy(NULL)
 {
    _log_cache_line_size = floorLog2(cache_line_size);
+
+   // lru and round_robin keep the sharer-based policy
+   Type policy = parse(policy_str);
+   if ((policy != LRU) && (policy != ROUND_ROBIN))
+      _base_policy = create(policy_str, cache_size, associativity, cache_line_size);
 }
 
 L2CacheReplacementPolicy::~L2CacheReplacementPolicy()
-{}
+{
+   delete _base_policy;
+}
 
 UInt32
 L2CacheReplacementPolicy::getReplacementWay(CacheLineInfo** cache_line_info_array, UInt32 set_num)
 {
+   if (_base_policy)
+   {
+      UInt32 way = _base_policy->getReplacementWay(cache_line_info_array, set_num);
+      CacheLineInfo* L2_cache_line_info = cache_line_info_array[way];
+      if ( (L2_cache_line_info->getCState() == CacheState::INVALID) ||
+           (_L2_cache_req_queue_list.empty(getAddressFromTag(L2_cache_line_info->getTag()))) )
+         return way;
+      // Requests are pending on the chosen line, fall back to the sharer-based choice
+   }
+
    UInt32 way = UINT32_MAX_;
    SInt32 min_num_sharers = (SInt32) Config::getSingleton()->getTotalTiles() + 1;
 
@@ -68,7 +87,31 @@ L2CacheReplacementPolicy::getReplacementWay(CacheLineInfo** cache_line_info_arra
 
 void
 L2CacheReplacementPolicy::update(CacheLineInfo** cache_line_info_array, UInt32 set_num, UInt32 accessed_way)
-{}
+{
+   if (_base_policy)
+      _base_policy->update(cache_line_info_array, set_num, accessed_way);
+}
+
+void
+L2CacheReplacementPolicy::insert(CacheLineInfo** cache_line_info_array, UInt32 set_num, UInt32 inserted_way)
+{
+   if (_base_policy)
+      _base_policy->insert(cache_line_info_array, set_num, inserted_way);
+}
+
+void
+L2CacheReplacementPolicy::saveState(CheckpointWriter& writer)
+{
+   if (_base_policy)
+      _base_policy->saveState(writer);
+}
+
+void
+L2CacheReplacementPolicy::restoreState(CheckpointReader& reader)
+{
+   if (_base_policy)
+      _base_policy->restoreState(reader);
+}
 
 IntPtr
 L2CacheReplacementPolicy::getAddressFromTag(IntPtr tag) const
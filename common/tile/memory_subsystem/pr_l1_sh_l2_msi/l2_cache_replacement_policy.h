@@ -7,18 +7,29 @@
 namespace PrL1ShL2MSI
 {
 
+// By default, evicts the line with the fewest sharers among those with
+// no pending requests. With replacement_policy = tree_plru, srrip, brrip
+// or ship, the victim is chosen by that policy instead, unless the line
+// it picks has pending requests.
+
 class L2CacheReplacementPolicy : public CacheReplacementPolicy
 {
 public:
    L2CacheReplacementPolicy(UInt32 cache_size, UInt32 associativity, UInt32 cache_line_size,
+                            string policy_str,
                             HashMapQueue<IntPtr,ShmemReq*>& L2_cache_req_queue_list);
    ~L2CacheReplacementPolicy();
 
    UInt32 getReplacementWay(CacheLineInfo** cache_line_info_array, UInt32 set_num);
    void update(CacheLineInfo** cache_line_info_array, UInt32 set_num, UInt32 accessed_way);
+   void insert(CacheLineInfo** cache_line_info_array, UInt32 set_num, UInt32 inserted_way);
+   void saveState(CheckpointWriter& writer);
+   void restoreState(CheckpointReader& reader);
 
 private:
    HashMapQueue<IntPtr,ShmemReq*>& _L2_cache_req_queue_list;
+   // NULL if the victim is the line with the fewest sharers
+   CacheReplacementPolicy* _base_policy;
    UInt32 _log_cache_line_size;
    
    IntPtr getAddressFromTag(IntPtr tag) const;
@@ -4,6 +4,7 @@
 #include "tile_manager.h"
 #include "clock_converter.h"
 #include "l2_directory_cfg.h"
+#include "nuca_placement.h"
 #include "network.h"
 #include "log.h"
 
@@ -52,6 +53,14 @@ MemoryManager::MemoryManager(Tile* tile, Network* network, ShmemPerfModel* shmem
    SInt32 L2_directory_max_hw_sharers = 0;
    std::string L2_directory_type_str;
    
+   // L2 Placement
+   std::string L2_placement;
+   UInt32 nuca_page_size = 0;
+   UInt32 nuca_migration_threshold = 0;
+   bool nuca_replicate_instructions = false;
+   bool nuca_victim_replication = false;
+   UInt32 nuca_replica_ways = 0;
+
    // Dram
    volatile float dram_latency = 0.0;
    volatile float per_dram_controller_bandwidth = 0.0;
@@ -109,6 +118,14 @@ MemoryManager::MemoryManager(Tile* tile, Network* network, ShmemPerfModel* shmem
       // SHARED_MEM_1 is used to communicate messages from L1-I/L1-D caches and memory controller
       // SHARED_MEM_2 is used to communicate messages from L2 cache
       _switch_networks = Sim()->getCfg()->getBool("caching_protocol/pr_l1_sh_l2_msi/switch_networks");
+
+      // L2 Placement
+      L2_placement = Sim()->getCfg()->getString("caching_protocol/pr_l1_sh_l2_msi/l2_placement", "static");
+      nuca_page_size = Sim()->getCfg()->getInt("caching_protocol/pr_l1_sh_l2_msi/nuca/page_size", 4096);
+      nuca_migration_threshold = Sim()->getCfg()->getInt("caching_protocol/pr_l1_sh_l2_msi/nuca/migration_threshold", 0);
+      nuca_replicate_instructions = Sim()->getCfg()->getBool("caching_protocol/pr_l1_sh_l2_msi/nuca/replicate_instructions", false);
+      nuca_victim_replication = Sim()->getCfg()->getBool("caching_protocol/pr_l1_sh_l2_msi/nuca/victim_replication", false);
+      nuca_replica_ways = Sim()->getCfg()->getInt("caching_protocol/pr_l1_sh_l2_msi/nuca/replica_ways", 2);
    }
    catch(...)
    {
@@ -127,13 +144,13 @@ MemoryManager::MemoryManager(Tile* tile, Network* network, ShmemPerfModel* shmem
    
    UInt32 dram_home_lookup_param = ceilLog2(_cache_line_size);
    std::vector<tile_id_t> tile_list_with_dram_controllers = getTileListWithMemoryControllers();
-   _dram_home_lookup = new AddressHomeLookup(dram_home_lookup_param, tile_list_with_dram_controllers, getCacheLineSize());
+   _dram_home_lookup = new AddressHomeLookup(dram_home_lookup_param, tile_list_with_dram_controllers, getCacheLineSize(), getTile()->getId());
    
    UInt32 L2_cache_home_lookup_param = ceilLog2(_cache_line_size);
    std::vector<tile_id_t> tile_list;
    for (tile_id_t i = 0; i < (tile_id_t) Config::getSingleton()->getApplicationTiles(); i++)
       tile_list.push_back(i);
-   _L2_cache_home_lookup = new AddressHomeLookup(L2_cache_home_lookup_param, tile_list, getCacheLineSize());
+   _L2_cache_home_lookup = new AddressHomeLookup(L2_cache_home_lookup_param, tile_list, getCacheLineSize(), getTile()->getId());
 
    if (find(tile_list_with_dram_controllers.begin(), tile_list_with_dram_controllers.end(), getTile()->getId())
          != tile_list_with_dram_controllers.end())
@@ -153,6 +170,31 @@ MemoryManager::MemoryManager(Tile* tile, Network* network, ShmemPerfModel* shmem
    L2DirectoryCfg::setMaxHWSharers(L2_directory_max_hw_sharers);
    L2DirectoryCfg::setMaxNumSharers(L2_directory_max_num_sharers);
 
+   // Set L2 placement params. The replicas take some of the ways of the local L2 slice
+   UInt32 L2_replica_size = 0;
+   UInt32 L2_replica_associativity = 0;
+   if (L2_placement == "nuca")
+   {
+      NucaPlacement::initialize(nuca_page_size, nuca_migration_threshold);
+      if (nuca_replicate_instructions || nuca_victim_replication)
+      {
+         LOG_ASSERT_ERROR((nuca_replica_ways > 0) && (nuca_replica_ways < L2_cache_associativity),
+                          "NUCA replica ways(%u) must be between 1 and L2 associativity(%u) - 1",
+                          nuca_replica_ways, L2_cache_associativity);
+         LOG_ASSERT_ERROR((L2_cache_size % L2_cache_associativity) == 0,
+                          "L2 cache size(%u) not a multiple of its associativity(%u)",
+                          L2_cache_size, L2_cache_associativity);
+         L2_replica_size = L2_cache_size / L2_cache_associativity * nuca_replica_ways;
+         L2_replica_associativity = nuca_replica_ways;
+         L2_cache_size -= L2_replica_size;
+         L2_cache_associativity -= L2_replica_associativity;
+      }
+   }
+   else if (L2_placement != "static")
+   {
+      LOG_PRINT_ERROR("Unrecognized L2 placement(%s), expected static or nuca", L2_placement.c_str());
+   }
+
    // Instantiate L1 cache cntlr
    _L1_cache_cntlr = new L1CacheCntlr(this,
          _L2_cache_home_lookup,
@@ -167,6 +209,11 @@ MemoryManager::MemoryManager(Tile* tile, Network* network, ShmemPerfModel* shmem
          L1_dcache_replacement_policy,
          L1_dcache_data_access_time,
          L1_dcache_track_miss_types,
+         L2_replica_size,
+         L2_replica_associativity,
+         L2_cache_replacement_policy,
+         nuca_replicate_instructions,
+         nuca_victim_replication,
          core_frequency);
    
    // Instantiate L2 cache cntlr
@@ -187,6 +234,13 @@ MemoryManager::MemoryManager(Tile* tile, Network* network, ShmemPerfModel* shmem
          L1_dcache_data_access_time, L1_dcache_tags_access_time, core_frequency);
    _L2_cache_perf_model = CachePerfModel::create(L2_cache_perf_model_type,
          L2_cache_data_access_time, L2_cache_tags_access_time, core_frequency);
+   _L2_cache_bank_model = CacheBankModel::create(L2_cache_type, L2_cache_perf_model_type,
+         L2_cache_data_access_time, L2_cache_tags_access_time, getCacheLineSize());
+
+   // Counters of the stats file
+   _L1_cache_cntlr->getL1ICache()->registerStatistics(getTile()->getId());
+   _L1_cache_cntlr->getL1DCache()->registerStatistics(getTile()->getId());
+   _L2_cache_cntlr->getL2Cache()->registerStatistics(getTile()->getId());
 
    // Register Call-backs
    getNetwork()->registerCallback(SHARED_MEM_1, MemoryManagerNetworkCallback, this);
@@ -202,6 +256,7 @@ MemoryManager::~MemoryManager()
    delete _L1_icache_perf_model;
    delete _L1_dcache_perf_model;
    delete _L2_cache_perf_model;
+   delete _L2_cache_bank_model;
 
    // Delete home lookup functions
    delete _dram_home_lookup;
@@ -244,7 +299,10 @@ void
 MemoryManager::handleMsgFromNetwork(NetPacket& packet)
 {
    core_id_t sender = packet.sender;
-   ShmemMsg* shmem_msg = ShmemMsg::getShmemMsg((Byte*) packet.data);
+   // The msg (and its data) is read in place, the packet is kept until it is handled
+   ShmemMsg packet_shmem_msg;
+   ShmemMsg::getShmemMsg((Byte*) packet.data, &packet_shmem_msg);
+   ShmemMsg* shmem_msg = &packet_shmem_msg;
    UInt64 msg_time = packet.time;
 
    MemComponent::Type receiver_mem_component = shmem_msg->getReceiverMemComponent();
@@ -314,16 +372,6 @@ MemoryManager::handleMsgFromNetwork(NetPacket& packet)
       break;
    }
 
-   // Delete the allocated Shared Memory Message
-   // First delete 'data_buf' if it is present
-
-   if (shmem_msg->getDataLength() > 0)
-   {
-      assert(shmem_msg->getDataBuf());
-      delete [] shmem_msg->getDataBuf();
-   }
-   delete shmem_msg;
-
    // Release lock
    _lock.release();
 }
@@ -335,7 +383,7 @@ MemoryManager::sendMsg(tile_id_t receiver, ShmemMsg& shmem_msg)
                     "Address(%#lx), Type(%u), Sender Component(%u), Receiver Component(%u)",
                     shmem_msg.getAddress(), shmem_msg.getType(), shmem_msg.getSenderMemComponent(), shmem_msg.getReceiverMemComponent());
 
-   Byte* msg_buf = shmem_msg.makeMsgBuf();
+   ShmemMsgBuf<ShmemMsg> msg_buf(shmem_msg);
    UInt64 msg_time = getShmemPerfModel()->getCycleCount();
 
    LOG_PRINT("Time(%llu), Sending Msg: type(%u), address(%#lx), sender_mem_component(%u), receiver_mem_component(%u), requester(%i), sender(%i), receiver(%i), modeled(%s)",
@@ -348,11 +396,8 @@ MemoryManager::sendMsg(tile_id_t receiver, ShmemMsg& shmem_msg)
 
    NetPacket packet(msg_time, packet_type,
          getTile()->getId(), receiver,
-         shmem_msg.getMsgLen(), (const void*) msg_buf);
+         shmem_msg.getMsgLen(), (const void*) msg_buf.getBuf());
    getNetwork()->netSend(packet);
-
-   // Delete the Msg Buf
-   delete [] msg_buf;
 }
 
 void
@@ -360,7 +405,7 @@ MemoryManager::broadcastMsg(ShmemMsg& shmem_msg)
 {
    assert((shmem_msg.getDataBuf() == NULL) == (shmem_msg.getDataLength() == 0));
 
-   Byte* msg_buf = shmem_msg.makeMsgBuf();
+   ShmemMsgBuf<ShmemMsg> msg_buf(shmem_msg);
    UInt64 msg_time = getShmemPerfModel()->getCycleCount();
 
    LOG_PRINT("Time(%llu), Broadcasting Msg: type(%u), address(%#llx), sender_mem_component(%u), receiver_mem_component(%u), requester(%i), sender(%i), modeled(%s)",
@@ -373,11 +418,8 @@ MemoryManager::broadcastMsg(ShmemMsg& shmem_msg)
 
    NetPacket packet(msg_time, packet_type,
          getTile()->getId(), NetPacket::BROADCAST,
-         shmem_msg.getMsgLen(), (const void*) msg_buf);
+         shmem_msg.getMsgLen(), (const void*) msg_buf.getBuf());
    getNetwork()->netSend(packet);
-
-   // Delete the Msg Buf
-   delete [] msg_buf;
 }
 
 PacketType
@@ -433,6 +475,15 @@ MemoryManager::incrCycleCount(MemComponent::Type mem_component, CachePerfModel::
    }
 }
 
+void
+MemoryManager::incrL2CacheCycleCount(IntPtr address, CachePerfModel::CacheAccess_t access_type)
+{
+   UInt64 latency = _L2_cache_perf_model->getLatency(access_type);
+   if (_L2_cache_bank_model)
+      latency += _L2_cache_bank_model->computeQueueDelay(address, access_type, getShmemPerfModel()->getCycleCount());
+   getShmemPerfModel()->incrCycleCount(latency);
+}
+
 void
 MemoryManager::enableModels()
 {
@@ -446,7 +497,13 @@ MemoryManager::enableModels()
    
    _L2_cache_cntlr->getL2Cache()->enable();
    _L2_cache_perf_model->enable();
+   if (_L2_cache_bank_model)
+      _L2_cache_bank_model->enable();
+
+   if (_L1_cache_cntlr->getL2ReplicaCache())
+      _L1_cache_cntlr->getL2ReplicaCache()->enable();
 
+   _L1_cache_cntlr->enable();
    _L2_cache_cntlr->enable();
 
    if (_dram_cntlr_present)
@@ -468,7 +525,13 @@ MemoryManager::disableModels()
 
    _L2_cache_cntlr->getL2Cache()->disable();
    _L2_cache_perf_model->disable();
+   if (_L2_cache_bank_model)
+      _L2_cache_bank_model->disable();
+
+   if (_L1_cache_cntlr->getL2ReplicaCache())
+      _L1_cache_cntlr->getL2ReplicaCache()->disable();
 
+   _L1_cache_cntlr->disable();
    _L2_cache_cntlr->disable();
 
    if (_dram_cntlr_present)
@@ -484,6 +547,17 @@ MemoryManager::outputSummary(std::ostream &os)
    _L1_cache_cntlr->getL1ICache()->outputSummary(os);
    _L1_cache_cntlr->getL1DCache()->outputSummary(os);
    _L2_cache_cntlr->getL2Cache()->outputSummary(os);
+   if (_L2_cache_bank_model)
+      _L2_cache_bank_model->outputSummary(os);
+   if (_L1_cache_cntlr->getL2ReplicaCache())
+      _L1_cache_cntlr->getL2ReplicaCache()->outputSummary(os);
+
+   if (NucaPlacement::isEnabled())
+   {
+      os << "  L2 Placement:" << endl;
+      _L1_cache_cntlr->outputSummary(os);
+      _L2_cache_cntlr->outputSummary(os);
+   }
 
    if (_dram_cntlr_present)
    {
@@ -15,6 +15,7 @@ using std::ofstream;
 #include "semaphore.h"
 #include "fixed_types.h"
 #include "shmem_perf_model.h"
+#include "cache_bank_model.h"
 #include "network.h"
 
 namespace PrL1ShL2MSI
@@ -62,6 +63,8 @@ namespace PrL1ShL2MSI
       void wakeUpSimThread();
 
       void incrCycleCount(MemComponent::Type mem_component, CachePerfModel::CacheAccess_t access_type);
+      // Access to the L2 slice by a msg, through its banks (if modeled)
+      void incrL2CacheCycleCount(IntPtr address, CachePerfModel::CacheAccess_t access_type);
 
    private:
       // L1/L2 cache cntlrs and DRAM_CNTLR cntlr
@@ -83,6 +86,8 @@ namespace PrL1ShL2MSI
       CachePerfModel* _L1_icache_perf_model;
       CachePerfModel* _L1_dcache_perf_model;
       CachePerfModel* _L2_cache_perf_model;
+      // Banks of the L2 slice ([l2_cache/*] num_banks), NULL if not modeled
+      CacheBankModel* _L2_cache_bank_model;
 
       UInt32 _cache_line_size;
       bool _enabled;
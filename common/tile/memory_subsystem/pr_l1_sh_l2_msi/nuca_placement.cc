@@ -0,0 +1,124 @@
+#include "nuca_placement.h"
+#include "config.h"
+#include "utils.h"
+#include "log.h"
+
+namespace PrL1ShL2MSI
+{
+
+bool NucaPlacement::_enabled = false;
+UInt32 NucaPlacement::_page_size_log2 = 0;
+UInt32 NucaPlacement::_migration_threshold = 0;
+NucaPlacement::PageTable* NucaPlacement::_page_tables = NULL;
+Lock* NucaPlacement::_locks = NULL;
+
+void
+NucaPlacement::initialize(UInt32 page_size, UInt32 migration_threshold)
+{
+   // The memory managers are created one after the other, the first one sets it up
+   if (_enabled)
+      return;
+
+   LOG_ASSERT_ERROR(Config::getSingleton()->getProcessCount() == 1,
+                    "l2_placement = nuca needs all tiles in one process");
+   LOG_ASSERT_ERROR(isPower2(page_size), "NUCA page size(%u) must be a power of 2", page_size);
+
+   _page_size_log2 = floorLog2(page_size);
+   _migration_threshold = migration_threshold;
+   _page_tables = new PageTable[NUM_BUCKETS];
+   _locks = new Lock[NUM_BUCKETS];
+   _enabled = true;
+}
+
+tile_id_t
+NucaPlacement::getHome(IntPtr address, tile_id_t requester, tile_id_t static_home)
+{
+   UInt64 page_num = getPageNum(address);
+   UInt32 bucket = getBucket(page_num);
+   ScopedLock sl(_locks[bucket]);
+
+   PageTable::iterator it = _page_tables[bucket].find(page_num);
+   if (it == _page_tables[bucket].end())
+   {
+      PageInfo page_info;
+      page_info.home = Config::getSingleton()->isApplicationTile(requester) ? requester : static_home;
+      page_info.num_cached_lines = 0;
+      page_info.remote_requester = INVALID_TILE_ID;
+      page_info.num_remote_requests = 0;
+      it = _page_tables[bucket].insert(make_pair(page_num, page_info)).first;
+   }
+   return it->second.home;
+}
+
+tile_id_t
+NucaPlacement::processRequest(IntPtr address, tile_id_t requester, tile_id_t home, bool& migrated)
+{
+   UInt64 page_num = getPageNum(address);
+   UInt32 bucket = getBucket(page_num);
+   ScopedLock sl(_locks[bucket]);
+
+   migrated = false;
+
+   PageTable::iterator it = _page_tables[bucket].find(page_num);
+   LOG_ASSERT_ERROR(it != _page_tables[bucket].end(), "Address(%#lx) was never placed", address);
+   PageInfo& page_info = it->second;
+
+   // The page moved after the request was sent
+   if (page_info.home != home)
+      return page_info.home;
+
+   if (requester == home)
+   {
+      page_info.remote_requester = INVALID_TILE_ID;
+      page_info.num_remote_requests = 0;
+      return home;
+   }
+
+   if (requester == page_info.remote_requester)
+   {
+      page_info.num_remote_requests ++;
+   }
+   else
+   {
+      page_info.remote_requester = requester;
+      page_info.num_remote_requests = 1;
+   }
+
+   if ( (_migration_threshold > 0) && (page_info.num_remote_requests >= _migration_threshold) &&
+        (page_info.num_cached_lines == 0) && Config::getSingleton()->isApplicationTile(requester) )
+   {
+      LOG_PRINT("Page(%#lx) migrates from slice(%i) to slice(%i)", page_num << _page_size_log2, home, requester);
+      page_info.home = requester;
+      page_info.remote_requester = INVALID_TILE_ID;
+      page_info.num_remote_requests = 0;
+      migrated = true;
+   }
+   return page_info.home;
+}
+
+void
+NucaPlacement::addCachedLine(IntPtr address)
+{
+   UInt64 page_num = getPageNum(address);
+   UInt32 bucket = getBucket(page_num);
+   ScopedLock sl(_locks[bucket]);
+
+   PageTable::iterator it = _page_tables[bucket].find(page_num);
+   LOG_ASSERT_ERROR(it != _page_tables[bucket].end(), "Address(%#lx) was never placed", address);
+   it->second.num_cached_lines ++;
+}
+
+void
+NucaPlacement::removeCachedLine(IntPtr address)
+{
+   UInt64 page_num = getPageNum(address);
+   UInt32 bucket = getBucket(page_num);
+   ScopedLock sl(_locks[bucket]);
+
+   PageTable::iterator it = _page_tables[bucket].find(page_num);
+   LOG_ASSERT_ERROR((it != _page_tables[bucket].end()) && (it->second.num_cached_lines > 0),
+                    "Address(%#lx) has no line cached", address);
+   it->second.num_cached_lines --;
+}
+
+}
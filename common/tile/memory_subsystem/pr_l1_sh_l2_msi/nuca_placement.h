@@ -0,0 +1,65 @@
+#pragma once
+
+#include <map>
+using std::map;
+
+#include "fixed_types.h"
+#include "lock.h"
+
+namespace PrL1ShL2MSI
+{
+
+// Distance-aware placement of the pages in the L2 slices (l2_placement = nuca).
+// A page is homed at the slice of the application tile that first misses on
+// it. A page can later migrate to the slice of a remote tile that made the
+// last migration_threshold requests to it, but only once none of its lines is
+// left in its current slice: as the L2 is inclusive, no L1 or replica holds
+// the page then, so no coherence state has to move with it. The requests that
+// reach the old slice after the migration are forwarded to the new one.
+//   The page table is shared by the tiles, so it needs all of them in one
+// process. It is not checkpointed.
+class NucaPlacement
+{
+public:
+   static void initialize(UInt32 page_size, UInt32 migration_threshold);
+   static bool isEnabled()    { return _enabled; }
+
+   // Home slice of the page of 'address', placing the page at the slice of
+   // 'requester' if this is its first access. Pages first accessed by tiles
+   // without a slice go to 'static_home'
+   static tile_id_t getHome(IntPtr address, tile_id_t requester, tile_id_t static_home);
+
+   // Called by the slice 'home' on a request from 'requester'. Returns the
+   // slice that should process the request, 'home' unless the page moved
+   // ('migrated' tells whether it moved on this very request)
+   static tile_id_t processRequest(IntPtr address, tile_id_t requester, tile_id_t home, bool& migrated);
+
+   // Lines of a page resident in its home slice (including the evicted
+   // lines whose sharers are being invalidated)
+   static void addCachedLine(IntPtr address);
+   static void removeCachedLine(IntPtr address);
+
+private:
+   struct PageInfo
+   {
+      tile_id_t home;
+      UInt32 num_cached_lines;
+      // Consecutive requests from the same remote tile
+      tile_id_t remote_requester;
+      UInt32 num_remote_requests;
+   };
+   typedef map<UInt64,PageInfo> PageTable;
+
+   static const UInt32 NUM_BUCKETS = 1024;
+
+   static bool _enabled;
+   static UInt32 _page_size_log2;
+   static UInt32 _migration_threshold;
+   static PageTable* _page_tables;
+   static Lock* _locks;
+
+   static UInt64 getPageNum(IntPtr address)  { return address >> _page_size_log2; }
+   static UInt32 getBucket(UInt64 page_num)  { return page_num % NUM_BUCKETS; }
+};
+
+}
@@ -58,7 +58,11 @@ public:
    ~ShmemMsg();
 
    void clone(const ShmemMsg* shmem_msg);
-   static ShmemMsg* getShmemMsg(Byte* msg_buf);
+   // Reads the msg in place: 'data_buf' points into 'msg_buf', which must
+   // outlive 'shmem_msg'
+   static void getShmemMsg(Byte* msg_buf, ShmemMsg* shmem_msg);
+   // Writes the msg into 'msg_buf', of at least getMsgLen() bytes
+   void makeMsgBuf(Byte* msg_buf);
    Byte* makeMsgBuf();
    UInt32 getMsgLen();
 
@@ -88,6 +92,10 @@ private:
    Byte* _data_buf;
    UInt32 _data_length;
    bool _modeled;
+   // Set when the msg buffer is made: the modeled length of the data (in
+   // bits), and whether the data was left out of the buffer
+   UInt32 _modeled_data_length;
+   bool _data_elided;
    
    static const UInt32 _num_msg_type_bits = 4;
 };
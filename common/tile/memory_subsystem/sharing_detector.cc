@@ -0,0 +1,188 @@
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+#include "sharing_detector.h"
+#include "simulator.h"
+#include "config.h"
+#include "log.h"
+
+using namespace std;
+
+const UInt32 SharingDetector::NUM_STRIPES;
+const UInt32 SharingDetector::MAX_PCS_PER_LINE;
+
+SharingDetector::SharingDetector()
+   : m_granularity(1)
+   , m_num_top_lines(0)
+{
+   try
+   {
+      m_num_top_lines = Sim()->getCfg()->getInt("sharing_detector/num_top_lines", 20);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read sharing_detector/num_top_lines from the cfg file");
+   }
+}
+
+SharingDetector::~SharingDetector()
+{}
+
+bool
+SharingDetector::isEnabled()
+{
+   try
+   {
+      return Sim()->getCfg()->getBool("sharing_detector/enabled", false);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read sharing_detector/enabled from the cfg file");
+      return false;
+   }
+}
+
+UInt64
+SharingDetector::getMask(UInt32 granularity, UInt32 offset, UInt32 size)
+{
+   UInt32 first = offset / granularity;
+   UInt32 last = (offset + size - 1) / granularity;
+   UInt32 num_bits = last - first + 1;
+   UInt64 bits = (num_bits >= 64) ? ~((UInt64) 0) : ((((UInt64) 1) << num_bits) - 1);
+   return bits << first;
+}
+
+void
+SharingDetector::recordAccess(tile_id_t tile_id, IntPtr line_address, UInt32 line_size,
+                              UInt32 offset, UInt32 size, bool write, IntPtr pc)
+{
+   UInt32 granularity = (line_size + 63) / 64;
+   m_granularity = granularity;
+
+   Stripe& stripe = m_stripes[(line_address / line_size) % NUM_STRIPES];
+   ScopedLock sl(stripe.lock);
+
+   map<IntPtr, LineInfo>::iterator it = stripe.lines.find(line_address);
+   if (it == stripe.lines.end())
+   {
+      if (!write)
+         return;
+      it = stripe.lines.insert(make_pair(line_address, LineInfo())).first;
+   }
+   LineInfo& line = it->second;
+
+   if ((line.last_tile_id != INVALID_TILE_ID) && (line.last_tile_id != tile_id) && (write || line.last_write))
+      line.num_transfers ++;
+   line.last_tile_id = tile_id;
+   line.last_write = write;
+
+   if (!write)
+      return;
+
+   UInt32 i = 0;
+   while ((i < line.writers.size()) && (line.writers[i].tile_id != tile_id))
+      i ++;
+   if (i == line.writers.size())
+   {
+      Writer writer;
+      writer.tile_id = tile_id;
+      writer.mask = 0;
+      writer.num_writes = 0;
+      line.writers.push_back(writer);
+   }
+   line.writers[i].mask |= getMask(granularity, offset, size);
+   line.writers[i].num_writes ++;
+
+   if ((pc != 0) && (line.pcs.size() < MAX_PCS_PER_LINE) &&
+       (find(line.pcs.begin(), line.pcs.end(), make_pair(pc, tile_id)) == line.pcs.end()))
+   {
+      line.pcs.push_back(make_pair(pc, tile_id));
+   }
+}
+
+bool
+SharingDetector::isFalseSharing(const LineInfo& line)
+{
+   if (line.writers.size() < 2)
+      return false;
+
+   UInt64 written = 0;
+   for (UInt32 i = 0; i < line.writers.size(); i++)
+   {
+      if (written & line.writers[i].mask)
+         return false;
+      written |= line.writers[i].mask;
+   }
+   return true;
+}
+
+bool
+SharingDetector::compareTransfers(const TopLine& a, const TopLine& b)
+{
+   return a.first > b.first;
+}
+
+void
+SharingDetector::outputLine(ostream& os, IntPtr address, const LineInfo& line) const
+{
+   os << "Line 0x" << hex << address << dec << ": " << line.num_transfers << " transfers, ";
+   if (line.writers.size() < 2)
+      os << "one writer" << endl;
+   else
+      os << (isFalseSharing(line) ? "false sharing" : "true sharing") << endl;
+
+   for (UInt32 i = 0; i < line.writers.size(); i++)
+   {
+      const Writer& writer = line.writers[i];
+      os << "    Tile " << writer.tile_id << ": " << writer.num_writes << " writes, mask 0x"
+         << hex << setw(16) << setfill('0') << writer.mask << dec << setfill(' ') << endl;
+   }
+   for (UInt32 i = 0; i < line.pcs.size(); i++)
+      os << "    Written at 0x" << hex << line.pcs[i].first << dec << " (tile " << line.pcs[i].second << ")" << endl;
+}
+
+void
+SharingDetector::output()
+{
+   UInt64 num_written_lines = 0;
+   UInt64 num_shared_lines = 0;
+   UInt64 num_false_sharing_lines = 0;
+   UInt64 total_transfers = 0;
+   vector<TopLine> lines;
+
+   for (UInt32 s = 0; s < NUM_STRIPES; s++)
+   {
+      ScopedLock sl(m_stripes[s].lock);
+      for (map<IntPtr, LineInfo>::iterator it = m_stripes[s].lines.begin(); it != m_stripes[s].lines.end(); it++)
+      {
+         const LineInfo& line = it->second;
+         num_written_lines ++;
+         total_transfers += line.num_transfers;
+         if (line.writers.size() >= 2)
+            num_shared_lines ++;
+         if (isFalseSharing(line))
+            num_false_sharing_lines ++;
+         if (line.num_transfers > 0)
+            lines.push_back(make_pair(line.num_transfers, make_pair(it->first, &line)));
+      }
+   }
+   sort(lines.begin(), lines.end(), compareTransfers);
+
+   ostringstream filename;
+   filename << "sharing." << Config::getSingleton()->getCurrentProcessNum() << ".out";
+   ofstream os(Config::getSingleton()->formatOutputFileName(filename.str()).c_str());
+
+   os << "Sharing Summary:" << endl;
+   os << "    Lines Written: " << num_written_lines << endl;
+   os << "    Lines Written by Several Tiles: " << num_shared_lines << endl;
+   os << "    Lines with False Sharing: " << num_false_sharing_lines << endl;
+   os << "    Total Transfers: " << total_transfers << endl;
+   os << "    Bytes per Mask Bit: " << m_granularity << endl;
+   os << endl;
+
+   for (UInt32 i = 0; (i < lines.size()) && (i < m_num_top_lines); i++)
+      outputLine(os, lines[i].second.first, *lines[i].second.second);
+   os.close();
+}
@@ -0,0 +1,86 @@
+#ifndef SHARING_DETECTOR_H
+#define SHARING_DETECTOR_H
+
+#include <map>
+#include <vector>
+#include <string>
+#include <ostream>
+
+#include "fixed_types.h"
+#include "lock.h"
+
+/*
+  Lines written by several tiles ([sharing_detector]). The core accesses of
+  the program are recorded line by line with the bytes they touch: for each
+  line written by a tile, the bytes each tile wrote, and the number of
+  transfers of the line, i.e. accesses by another tile than the previous
+  one where either is a write (what the directory turns into an
+  invalidation or a downgrade). A line written by several tiles is
+  false sharing when the bytes they wrote do not overlap.
+
+  Each process writes the lines of its tiles with the most transfers as
+  sharing.<process>.out, with the writers and the addresses of the
+  instructions that wrote them.
+
+  The lines are split among stripes, each with its own lock, so that the
+  tiles seldom wait for each other. Lines that are only read are not kept.
+ */
+class SharingDetector
+{
+public:
+   SharingDetector();
+   ~SharingDetector();
+
+   static bool isEnabled();
+
+   // An access of the core of a tile to [offset, offset + size) of a line
+   // (by the instruction at 'pc', 0 if unknown)
+   void recordAccess(tile_id_t tile_id, IntPtr line_address, UInt32 line_size,
+                     UInt32 offset, UInt32 size, bool write, IntPtr pc);
+
+   void output();
+
+private:
+   static const UInt32 NUM_STRIPES = 64;
+   static const UInt32 MAX_PCS_PER_LINE = 4;
+
+   struct Writer
+   {
+      tile_id_t tile_id;
+      UInt64 mask;
+      UInt64 num_writes;
+   };
+
+   struct LineInfo
+   {
+      LineInfo() : last_tile_id(INVALID_TILE_ID), last_write(false), num_transfers(0) {}
+      tile_id_t last_tile_id;
+      bool last_write;
+      UInt64 num_transfers;
+      std::vector<Writer> writers;
+      // Distinct (instruction address, tile) of the writes, the first ones
+      std::vector<std::pair<IntPtr, tile_id_t> > pcs;
+   };
+
+   struct Stripe
+   {
+      std::map<IntPtr, LineInfo> lines;
+      Lock lock;
+   };
+
+   // Transfers, address and info of a line (the maps do not move the info)
+   typedef std::pair<UInt64, std::pair<IntPtr, const LineInfo*> > TopLine;
+   static bool compareTransfers(const TopLine& a, const TopLine& b);
+
+   static UInt64 getMask(UInt32 granularity, UInt32 offset, UInt32 size);
+   static bool isFalseSharing(const LineInfo& line);
+   void outputLine(std::ostream& os, IntPtr address, const LineInfo& line) const;
+
+   // Bytes of a line per bit of the masks (the lines of all the tiles
+   // have the same size)
+   volatile UInt32 m_granularity;
+   UInt32 m_num_top_lines;
+   Stripe m_stripes[NUM_STRIPES];
+};
+
+#endif // SHARING_DETECTOR_H
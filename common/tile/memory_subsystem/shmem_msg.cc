@@ -0,0 +1,88 @@
+#include "shmem_msg.h"
+#include "cache_compressor.h"
+#include "simulator.h"
+#include "config.h"
+#include "log.h"
+
+Byte ShmemMsg::_zero_data[MAX_ZERO_DATA_LENGTH];
+
+static ShmemMsg::CompressionScheme parseCompressionScheme(const string& scheme)
+{
+   if (scheme == "none")
+      return ShmemMsg::NO_COMPRESSION;
+   else if (scheme == "zero")
+      return ShmemMsg::ZERO_COMPRESSION;
+   else if (scheme == "bdi")
+      return ShmemMsg::BDI_COMPRESSION;
+   LOG_PRINT_ERROR("Unrecognized network/compression(%s)", scheme.c_str());
+   return ShmemMsg::NUM_COMPRESSION_SCHEMES;
+}
+
+static ShmemMsg::CompressionScheme readCompressionScheme()
+{
+   try
+   {
+      return parseCompressionScheme(Sim()->getCfg()->getString("network/compression", "none"));
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read network/compression from the cfg file");
+      return ShmemMsg::NO_COMPRESSION;
+   }
+}
+
+ShmemMsg::CompressionScheme
+ShmemMsg::getCompressionScheme()
+{
+   static CompressionScheme scheme = readCompressionScheme();
+   return scheme;
+}
+
+UInt32
+ShmemMsg::computeModeledDataLength(const Byte* data_buf, UInt32 data_length)
+{
+   if (data_length == 0)
+      return 0;
+
+   switch (getCompressionScheme())
+   {
+   case NO_COMPRESSION:
+      return (data_length * 8);
+
+   case ZERO_COMPRESSION:
+      return isZeroData(data_buf, data_length) ? 1 : (1 + data_length * 8);
+
+   case BDI_COMPRESSION:
+      // An all-zero line is the encoding alone
+      return (_num_encoding_bits + CacheCompressor::computeBDISize(data_buf, data_length) * 8);
+
+   default:
+      LOG_PRINT_ERROR("Unrecognized compression scheme(%u)", getCompressionScheme());
+      return 0;
+   }
+}
+
+bool
+ShmemMsg::isDataElided(const Byte* data_buf, UInt32 data_length)
+{
+   return ( (getCompressionScheme() != NO_COMPRESSION) && (data_length > 0) &&
+            (data_length <= MAX_ZERO_DATA_LENGTH) && isZeroData(data_buf, data_length) );
+}
+
+Byte*
+ShmemMsg::getZeroData(UInt32 data_length)
+{
+   LOG_ASSERT_ERROR(data_length <= MAX_ZERO_DATA_LENGTH, "Zero data of %u bytes", data_length);
+   return _zero_data;
+}
+
+bool
+ShmemMsg::isZeroData(const Byte* data_buf, UInt32 data_length)
+{
+   for (UInt32 i = 0; i < data_length; i++)
+   {
+      if (data_buf[i] != 0)
+         return false;
+   }
+   return true;
+}
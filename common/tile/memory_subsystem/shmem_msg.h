@@ -4,6 +4,70 @@
 
 class ShmemMsg
 {
+public:
+   // Compression of the cache lines carried by the msgs (network/compression)
+   //  - none
+   //  - zero: an all-zero line is a single bit
+   //  - bdi: base-delta-immediate (and zero and repeated-value lines)
+   // The modeled length of a msg has its compressed line. An all-zero line
+   // is also left out of the msg buffer (with zero and bdi), the receiver
+   // reads it from a shared zero line
+   enum CompressionScheme
+   {
+      NO_COMPRESSION = 0,
+      ZERO_COMPRESSION,
+      BDI_COMPRESSION,
+      NUM_COMPRESSION_SCHEMES
+   };
+   static CompressionScheme getCompressionScheme();
+
 protected:
    static const UInt32 _num_physical_address_bits = 48;
+
+   // Modeled length (in bits) of the data of a msg
+   static UInt32 computeModeledDataLength(const Byte* data_buf, UInt32 data_length);
+   // Is the data left out of the msg buffer
+   static bool isDataElided(const Byte* data_buf, UInt32 data_length);
+   // The data of a msg whose data was left out (must not be written)
+   static Byte* getZeroData(UInt32 data_length);
+
+private:
+   static bool isZeroData(const Byte* data_buf, UInt32 data_length);
+
+   static const UInt32 _num_encoding_bits = 4;
+   static const UInt32 MAX_ZERO_DATA_LENGTH = 1024;
+   static Byte _zero_data[MAX_ZERO_DATA_LENGTH];
+};
+
+// The buffer of a msg of a protocol (ShmemMsgT::makeMsgBuf()) to send. It is
+// on the stack, unless the msg is longer than MAX_STACK_MSG_LEN (a header
+// and a few cache lines), and is released when it goes out of scope
+template <class ShmemMsgT>
+class ShmemMsgBuf
+{
+public:
+   ShmemMsgBuf(ShmemMsgT& shmem_msg)
+      : _msg_len(shmem_msg.getMsgLen())
+   {
+      _msg_buf = (_msg_len <= MAX_STACK_MSG_LEN) ? _stack_msg_buf : new Byte[_msg_len];
+      shmem_msg.makeMsgBuf(_msg_buf);
+   }
+   ~ShmemMsgBuf()
+   {
+      if (_msg_buf != _stack_msg_buf)
+         delete [] _msg_buf;
+   }
+
+   const Byte* getBuf() const { return _msg_buf; }
+   UInt32 getLen() const { return _msg_len; }
+
+private:
+   static const UInt32 MAX_STACK_MSG_LEN = 1024;
+
+   UInt32 _msg_len;
+   Byte* _msg_buf;
+   Byte _stack_msg_buf[MAX_STACK_MSG_LEN];
+
+   ShmemMsgBuf(const ShmemMsgBuf&);
+   ShmemMsgBuf& operator=(const ShmemMsgBuf&);
 };
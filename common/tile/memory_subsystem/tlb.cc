@@ -0,0 +1,84 @@
+#include "tlb.h"
+#include "log.h"
+
+using namespace std;
+
+TLB::TLB(string name, UInt32 num_entries, UInt32 associativity)
+   : m_name(name)
+   , m_associativity(associativity)
+   , m_num_accesses(0)
+   , m_num_misses(0)
+   , m_num_invalidations(0)
+{
+   LOG_ASSERT_ERROR((associativity > 0) && (num_entries >= associativity) && ((num_entries % associativity) == 0),
+                    "%s: entries(%u) must be a multiple of the associativity(%u)", name.c_str(), num_entries, associativity);
+   m_num_sets = num_entries / associativity;
+   m_sets.resize(m_num_sets);
+   for (UInt32 i = 0; i < m_num_sets; i++)
+      m_sets[i].reserve(m_associativity);
+}
+
+TLB::~TLB()
+{}
+
+bool
+TLB::lookup(IntPtr page)
+{
+   m_num_accesses ++;
+   vector<IntPtr>& set = getSet(page);
+   for (UInt32 i = 0; i < set.size(); i++)
+   {
+      if (set[i] == page)
+      {
+         // Most recently used first
+         for (UInt32 j = i; j > 0; j--)
+            set[j] = set[j-1];
+         set[0] = page;
+         return true;
+      }
+   }
+   m_num_misses ++;
+   return false;
+}
+
+void
+TLB::insert(IntPtr page)
+{
+   vector<IntPtr>& set = getSet(page);
+   if (set.size() < m_associativity)
+      set.push_back(page);
+   for (UInt32 j = set.size() - 1; j > 0; j--)
+      set[j] = set[j-1];
+   set[0] = page;
+}
+
+UInt32
+TLB::invalidate(IntPtr begin_page, IntPtr end_page)
+{
+   UInt32 num_invalidated = 0;
+   for (UInt32 i = 0; i < m_num_sets; i++)
+   {
+      vector<IntPtr>& set = m_sets[i];
+      UInt32 num_kept = 0;
+      for (UInt32 j = 0; j < set.size(); j++)
+      {
+         if ((set[j] >= begin_page) && (set[j] < end_page))
+            num_invalidated ++;
+         else
+            set[num_kept ++] = set[j];
+      }
+      set.resize(num_kept);
+   }
+   m_num_invalidations += num_invalidated;
+   return num_invalidated;
+}
+
+void
+TLB::outputSummary(ostream& os)
+{
+   os << "    " << m_name << ":" << endl;
+   os << "      Accesses: " << m_num_accesses << endl;
+   os << "      Misses: " << m_num_misses << endl;
+   os << "      Miss Rate: " << ((m_num_accesses > 0) ? (100.0 * m_num_misses / m_num_accesses) : 0.0) << endl;
+   os << "      Invalidations: " << m_num_invalidations << endl;
+}
@@ -0,0 +1,47 @@
+#ifndef TLB_H
+#define TLB_H
+
+#include <vector>
+#include <string>
+#include <ostream>
+
+#include "fixed_types.h"
+
+/*
+  Set associative TLB with LRU replacement. The entries are page numbers
+  (or any key of the same kind, the page walk cache keeps the upper level
+  entries of the page table in one), and a set is kept most recently used
+  first. Only used by the thread that models the accesses of the core.
+ */
+class TLB
+{
+public:
+   TLB(std::string name, UInt32 num_entries, UInt32 associativity);
+   ~TLB();
+
+   // A hit makes the page the most recently used of its set
+   bool lookup(IntPtr page);
+   // The least recently used page of the set is evicted
+   void insert(IntPtr page);
+   // Drops the pages in [begin_page, end_page), returns how many there were
+   UInt32 invalidate(IntPtr begin_page, IntPtr end_page);
+
+   UInt64 getNumAccesses() const { return m_num_accesses; }
+   UInt64 getNumMisses() const { return m_num_misses; }
+
+   void outputSummary(std::ostream& os);
+
+private:
+   std::string m_name;
+   UInt32 m_num_sets;
+   UInt32 m_associativity;
+   std::vector< std::vector<IntPtr> > m_sets;
+
+   UInt64 m_num_accesses;
+   UInt64 m_num_misses;
+   UInt64 m_num_invalidations;
+
+   std::vector<IntPtr>& getSet(IntPtr page) { return m_sets[page % m_num_sets]; }
+};
+
+#endif
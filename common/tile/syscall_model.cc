@@ -14,6 +14,8 @@
 #include "tile.h"
 #include "tile_manager.h"
 #include "vm_manager.h"
+#include "distributed_futex_server.h"
+#include "host_profiler.h"
 
 #include <errno.h>
 #include <string>
@@ -38,13 +40,41 @@
 // ------ Included for writev
 #include <sys/uio.h>
 
+// ------ Included for mmap
+#include <sys/mman.h>
+#include <string.h>
+
 using namespace std;
 
 SyscallMdl::SyscallMdl(Network *net)
    : m_called_enter(false)
    , m_ret_val(0)
    , m_network(net)
+   , m_distributed_futexes(DistributedFutexServer::isEnabled())
+   , m_batch_fd(-1)
+   , m_pid(-1)
+   , m_mmap_chunk_start(0)
+   , m_mmap_chunk_end(0)
 {
+   try
+   {
+      m_chunk_size = Sim()->getCfg()->getInt("mcp/syscall_chunk_size", 0);
+      m_write_batch_size = Sim()->getCfg()->getInt("mcp/write_batch_size", 0);
+      m_local_syscalls = Sim()->getCfg()->getBool("mcp/local_syscalls", false);
+      m_mmap_chunk_size = Sim()->getCfg()->getInt("vm_manager/local_mmap_chunk_size", 0);
+      m_local_mmap_max_size = Sim()->getCfg()->getInt("vm_manager/local_mmap_max_size", 65536);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read mcp syscall parameters from the cfg file");
+   }
+
+   LOG_ASSERT_ERROR((m_mmap_chunk_size == 0) || (m_local_mmap_max_size <= m_mmap_chunk_size),
+         "vm_manager/local_mmap_max_size(%llu) must not exceed vm_manager/local_mmap_chunk_size(%llu)",
+         m_local_mmap_max_size, m_mmap_chunk_size);
+
+   for (int fd = 0; fd < m_num_std_fds; fd++)
+      m_std_fd_stat_valid[fd] = false;
 }
 
 // --------------------------------------------
@@ -117,6 +147,11 @@ IntPtr SyscallMdl::runExit(IntPtr old_return)
 IntPtr SyscallMdl::runEnter(IntPtr syscall_number, syscall_args_t &args)
 {
    LOG_PRINT("Got Syscall: %i", syscall_number);
+   HostProfiler::Scope profile(Sim()->getHostProfiler(), HostProfiler::SYSCALL);
+
+   // The writes held back go out before any other syscall of the thread
+   if (syscall_number != SYS_write)
+      flushWrites();
 
    // Reset the buffers for the new transmission
    m_recv_buff.clear();
@@ -310,12 +345,43 @@ IntPtr SyscallMdl::marshallOpenCall(syscall_args_t &args)
 
 IntPtr SyscallMdl::marshallReadCall(syscall_args_t &args)
 {
-
    /*
        Syscall Args
        int fd, void *buf, size_t count
 
+       Sent to the MCP in requests of at most m_chunk_size bytes, until
+       one reads less than asked for
+   */
+
+   int fd = (int)args.arg0;
+   IntPtr buf = (IntPtr)args.arg1;
+   size_t count = (size_t)args.arg2;
 
+   size_t chunk_size = (m_chunk_size > 0) ? m_chunk_size : count;
+   size_t done = 0;
+   IntPtr ret = 0;
+   do
+   {
+      size_t len = min(chunk_size, count - done);
+      int bytes = sendReadChunk(fd, buf + done, len);
+      if (bytes == -1)
+      {
+         // What was read before the error is returned, as the kernel does
+         ret = (done > 0) ? (IntPtr) done : -1;
+         break;
+      }
+      done += bytes;
+      ret = done;
+      if ((size_t) bytes < len)
+         break;
+   } while (done < count);
+
+   return ret;
+}
+
+int SyscallMdl::sendReadChunk(int fd, IntPtr buf, size_t count)
+{
+   /*
        Transmit
 
        Field               Type
@@ -332,12 +398,9 @@ IntPtr SyscallMdl::marshallReadCall(syscall_args_t &args)
 
    */
 
-   int fd = (int)args.arg0;
-   void *buf = (void *)args.arg1;
-   size_t count = (size_t)args.arg2;
    Core *core = Sim()->getTileManager()->getCurrentCore();
 
-   // if shared mem, provide the buf to read into
+   startRequest(SYS_read);
    m_send_buff << fd << count;
    m_network->netSend(Config::getSingleton()->getMCPCoreId(), MCP_REQUEST_TYPE, m_send_buff.getBuffer(), m_send_buff.size());
 
@@ -354,13 +417,11 @@ IntPtr SyscallMdl::marshallReadCall(syscall_args_t &args)
    {
       assert(m_recv_buff.size() == bytes);
 
-      // Read data from MCP into a local buffer
-      char* read_buf = new char[bytes];
-      m_recv_buff >> make_pair(read_buf, bytes);
+      // The data from the MCP is written to memory from the message itself
+      char* read_buf = (char*) m_recv_buff.getView(bytes);
       
       // Write the data to memory
-      Core* core = Sim()->getTileManager()->getCurrentCore();
-      core->accessMemory(Core::NONE, Core::WRITE, (IntPtr) buf, read_buf, bytes);
+      core->accessMemory(Core::NONE, Core::WRITE, buf, read_buf, bytes);
    }
    else
    {
@@ -378,7 +439,64 @@ IntPtr SyscallMdl::marshallWriteCall(syscall_args_t &args)
        Syscall Args
        int fd, void *buf, size_t count
 
+       Kept in the write batch if it fits, else sent to the MCP in requests
+       of at most m_chunk_size bytes, until one writes less than asked for
+   */
+
+   int fd = (int)args.arg0;
+   IntPtr buf = (IntPtr)args.arg1;
+   size_t count = (size_t)args.arg2;
 
+   // Always pass all the data in the message, even if shared memory is available
+   // I think this is a reasonable model and is definitely one less thing to keep
+   // track of when you switch between shared-memory/no shared-memory
+   Core *core = Sim()->getTileManager()->getCurrentCore();
+
+   if ((count > 0) && (count <= m_write_batch_size))
+   {
+      if ((fd != m_batch_fd) || (m_write_batch.size() + count > m_write_batch_size))
+         flushWrites();
+
+      // The write is taken to succeed: an error shows up as a warning when
+      // the batch is sent
+      size_t offset = m_write_batch.size();
+      m_write_batch.resize(offset + count);
+      m_batch_fd = fd;
+      core->accessMemory (Core::NONE, Core::READ, buf, &m_write_batch[offset], count);
+      return count;
+   }
+
+   // Keep the writes to the fd in order
+   flushWrites();
+
+   size_t chunk_size = (m_chunk_size > 0) ? m_chunk_size : count;
+   char *write_buf = new char [min(chunk_size, count)];
+   size_t done = 0;
+   IntPtr ret = 0;
+   do
+   {
+      size_t len = min(chunk_size, count - done);
+      core->accessMemory (Core::NONE, Core::READ, buf + done, write_buf, len);
+      int bytes = sendWriteChunk(fd, write_buf, len);
+      if (bytes == -1)
+      {
+         ret = (done > 0) ? (IntPtr) done : -1;
+         break;
+      }
+      done += bytes;
+      ret = done;
+      if ((size_t) bytes < len)
+         break;
+   } while (done < count);
+
+   delete [] write_buf;
+
+   return ret;
+}
+
+int SyscallMdl::sendWriteChunk(int fd, const char *buf, size_t count)
+{
+   /*
        Transmit
 
        Field               Type
@@ -395,24 +513,13 @@ IntPtr SyscallMdl::marshallWriteCall(syscall_args_t &args)
 
    */
 
-   int fd = (int)args.arg0;
-   void *buf = (void *)args.arg1;
-   size_t count = (size_t)args.arg2;
-
-   char *write_buf = new char [count];
-   // Always pass all the data in the message, even if shared memory is available
-   // I think this is a reasonable model and is definitely one less thing to keep
-   // track of when you switch between shared-memory/no shared-memory
-   Core *core = Sim()->getTileManager()->getCurrentCore();
-   core->accessMemory (Core::NONE, Core::READ, (IntPtr) buf, (char*) write_buf, count);
-
-   m_send_buff << fd << count << make_pair(write_buf, count);
-
-   delete [] write_buf;
+   startRequest(SYS_write);
+   m_send_buff << fd << count << make_pair(buf, count);
 
    m_network->netSend(Config::getSingleton()->getMCPCoreId(), MCP_REQUEST_TYPE, m_send_buff.getBuffer(), m_send_buff.size());
 
    NetPacket recv_pkt;
+   Core *core = Sim()->getTileManager()->getCurrentCore();
    recv_pkt = m_network->netRecv(Config::getSingleton()->getMCPCoreId(), core->getId(), MCP_RESPONSE_TYPE);
    assert(recv_pkt.length == sizeof(int));
    m_recv_buff << make_pair(recv_pkt.data, recv_pkt.length);
@@ -425,6 +532,29 @@ IntPtr SyscallMdl::marshallWriteCall(syscall_args_t &args)
    return status;
 }
 
+void SyscallMdl::flushWrites()
+{
+   if (m_write_batch.empty())
+      return;
+
+   int bytes = sendWriteChunk(m_batch_fd, &m_write_batch[0], m_write_batch.size());
+   if (bytes != (int) m_write_batch.size())
+   {
+      LOG_PRINT_WARNING("Batched write of %u bytes to fd(%i) returned %i",
+                        (UInt32) m_write_batch.size(), m_batch_fd, bytes);
+   }
+   m_write_batch.clear();
+}
+
+void SyscallMdl::startRequest(IntPtr syscall_number)
+{
+   m_recv_buff.clear();
+   m_send_buff.clear();
+
+   int msg_type = MCP_MESSAGE_SYS_CALL;
+   m_send_buff << msg_type << syscall_number;
+}
+
 IntPtr SyscallMdl::marshallWritevCall(syscall_args_t &args)
 {
    //
@@ -511,6 +641,9 @@ IntPtr SyscallMdl::marshallCloseCall(syscall_args_t &args)
 
    int fd = (int)args.arg0;
 
+   if ((fd >= 0) && (fd < m_num_std_fds))
+      m_std_fd_stat_valid[fd] = false;
+
    m_send_buff << fd;
    m_network->netSend(Config::getSingleton()->getMCPCoreId(), MCP_REQUEST_TYPE, m_send_buff.getBuffer(), m_send_buff.size());
 
@@ -634,6 +767,14 @@ IntPtr SyscallMdl::marshallFstatCall(syscall_args_t &args)
    struct stat buf;
 
    Core* core = Sim()->getTileManager()->getCurrentCore();
+
+   bool std_fd = m_local_syscalls && (fd >= 0) && (fd < m_num_std_fds);
+   if (std_fd && m_std_fd_stat_valid[fd])
+   {
+      core->accessMemory(Core::NONE, Core::WRITE, (IntPtr) args.arg1, (char*) &m_std_fd_stat[fd], sizeof(struct stat));
+      return 0;
+   }
+
    // Read the data from memory
    core->accessMemory(Core::NONE, Core::READ, (IntPtr) args.arg1, (char*) &buf, sizeof(struct stat));
 
@@ -658,6 +799,14 @@ IntPtr SyscallMdl::marshallFstatCall(syscall_args_t &args)
    m_recv_buff.get<int>(result);
    m_recv_buff >> make_pair(&buf, sizeof(struct stat));
 
+   // The size of a regular file changes with the writes to it, the
+   // terminals and pipes stay as they are
+   if (std_fd && (result == 0) && !S_ISREG(buf.st_mode))
+   {
+      m_std_fd_stat[fd] = buf;
+      m_std_fd_stat_valid[fd] = true;
+   }
+
    // Write the data to memory
    core->accessMemory(Core::NONE, Core::WRITE, (IntPtr) args.arg1, (char*) &buf, sizeof(struct stat));
 
@@ -709,6 +858,10 @@ IntPtr SyscallMdl::marshallIoctlCall(syscall_args_t &args)
 
 IntPtr SyscallMdl::marshallGetpidCall (syscall_args_t &args)
 {
+   // The pid of the simulated process does not change
+   if (m_local_syscalls && (m_pid != -1))
+      return m_pid;
+
    // send the data
    m_network->netSend(Config::getSingleton()->getMCPCoreId(), MCP_REQUEST_TYPE, m_send_buff.getBuffer(), m_send_buff.size());
 
@@ -723,6 +876,7 @@ IntPtr SyscallMdl::marshallGetpidCall (syscall_args_t &args)
    // return the result
    int result;
    m_recv_buff >> result;
+   m_pid = result;
 
    delete [] (Byte*) recv_pkt.data;
 
@@ -838,6 +992,7 @@ IntPtr SyscallMdl::marshallMmapCall (syscall_args_t &args)
    //  flags           int
    //  fd              int
    //  pgoffset        off_t
+   //  delegated       bool     (a chunk for the local mmaps)
    //
    //
    //  RECEIVE
@@ -845,6 +1000,7 @@ IntPtr SyscallMdl::marshallMmapCall (syscall_args_t &args)
    //  Field           Type
    //  --------------|------
    //  start           void*
+   //  recycled_length UInt64   (mapped before, at the top)
    // 
    // --------------------------------------------
 
@@ -855,36 +1011,81 @@ IntPtr SyscallMdl::marshallMmapCall (syscall_args_t &args)
 
    if (Config::getSingleton()->isSimulatingSharedMemory())
    {
-      m_send_buff.put(start);
-      m_send_buff.put(length);
-      m_send_buff.put(prot);
-      m_send_buff.put(flags);
-      m_send_buff.put(fd);
-      m_send_buff.put(pgoffset);
+      UInt64 page_size = getpagesize();
+      UInt64 mapped_length = (length + page_size - 1) & ~(page_size - 1);
+      bool local = (m_mmap_chunk_size > 0) && (mapped_length > 0) && (mapped_length <= m_local_mmap_max_size) &&
+                   (fd == -1) && ((flags & (MAP_ANONYMOUS | MAP_PRIVATE | MAP_FIXED)) == (MAP_ANONYMOUS | MAP_PRIVATE));
+      if (!local)
+         return (carbon_reg_t) sendMmapRequest(start, length, prot, flags, fd, pgoffset, false);
+
+      if (m_mmap_chunk_end - m_mmap_chunk_start < mapped_length)
+      {
+         // The rest of the last chunk is left over
+         m_mmap_chunk_start = sendMmapRequest(NULL, m_mmap_chunk_size, PROT_READ | PROT_WRITE,
+                                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0, true);
+         m_mmap_chunk_end = m_mmap_chunk_start + m_mmap_chunk_size;
+      }
+      m_mmap_chunk_end -= mapped_length;
 
-      // send the data
-      m_network->netSend (Config::getSingleton()->getMCPCoreId(), MCP_REQUEST_TYPE, m_send_buff.getBuffer(), m_send_buff.size());
+      LOG_PRINT("Local mmap(0x%x) returned 0x%x", length, m_mmap_chunk_end);
+      return (carbon_reg_t) m_mmap_chunk_end;
+   }
+   else
+   {
+      return (carbon_reg_t) syscall(SYS_mmap, start, length, prot, flags, fd, pgoffset);
+   }
+}
 
-      // get a result
-      NetPacket recv_pkt;
+IntPtr SyscallMdl::sendMmapRequest(void *start, size_t length, int prot, int flags, int fd, off_t pgoffset, bool delegated)
+{
+   startRequest(SYS_mmap);
+   m_send_buff.put(start);
+   m_send_buff.put(length);
+   m_send_buff.put(prot);
+   m_send_buff.put(flags);
+   m_send_buff.put(fd);
+   m_send_buff.put(pgoffset);
+   m_send_buff.put(delegated);
+
+   // send the data
+   m_network->netSend (Config::getSingleton()->getMCPCoreId(), MCP_REQUEST_TYPE, m_send_buff.getBuffer(), m_send_buff.size());
+
+   // get a result
+   NetPacket recv_pkt;
    Core *core = Sim()->getTileManager()->getCurrentCore();
-      recv_pkt = m_network->netRecv(Config::getSingleton()->getMCPCoreId(), core->getId(), MCP_RESPONSE_TYPE);
+   recv_pkt = m_network->netRecv(Config::getSingleton()->getMCPCoreId(), core->getId(), MCP_RESPONSE_TYPE);
 
-      // Create a buffer out of the result
-      m_recv_buff << make_pair (recv_pkt.data, recv_pkt.length);
+   // Create a buffer out of the result
+   m_recv_buff << make_pair (recv_pkt.data, recv_pkt.length);
 
-      // Return the result
-      void *addr;
-      m_recv_buff.get(addr);
+   // Return the result
+   void *addr;
+   UInt64 recycled_length;
+   m_recv_buff.get(addr);
+   m_recv_buff.get(recycled_length);
 
-      // Delete the data buffer
-      delete [] (Byte*) recv_pkt.data;
+   // Delete the data buffer
+   delete [] (Byte*) recv_pkt.data;
 
-      return (carbon_reg_t) addr;
+   // The anonymous pages come zeroed, not with the data of the last mapping
+   if (recycled_length > 0)
+   {
+      UInt64 mapped_length = (length + getpagesize() - 1) & ~((UInt64) getpagesize() - 1);
+      clearMemory((IntPtr) addr + mapped_length - recycled_length, recycled_length);
    }
-   else
+
+   return (IntPtr) addr;
+}
+
+void SyscallMdl::clearMemory(IntPtr addr, UInt64 length)
+{
+   Core *core = Sim()->getTileManager()->getCurrentCore();
+   char zeros[m_scratchpad_size];
+   memset(zeros, 0, sizeof(zeros));
+   for (UInt64 offset = 0; offset < length; offset += m_scratchpad_size)
    {
-      return (carbon_reg_t) syscall(SYS_mmap, start, length, prot, flags, fd, pgoffset);
+      UInt32 size = (UInt32) min((UInt64) m_scratchpad_size, length - offset);
+      core->accessMemory(Core::NONE, Core::WRITE, addr + offset, zeros, size);
    }
 }
 
@@ -1021,6 +1222,26 @@ IntPtr SyscallMdl::marshallFutexCall (syscall_args_t &args)
       volatile float core_frequency = core->getPerformanceModel()->getFrequency();
       start_time = convertCycleCount(core->getPerformanceModel()->getCycleCount(), core_frequency, 1.0);
 
+      if (m_distributed_futexes)
+      {
+         // The futex is handled by its home tile, the reply comes at the time it is woken up
+         m_send_buff.clear();
+         int msg_type = MCP_MESSAGE_FUTEX;
+         m_send_buff << msg_type << addr1 << op << val1 << timeout << addr2 << val3;
+         m_network->netSend(DistributedFutexServer::getHome((IntPtr) addr1), FUTEX_SERVER_REQUEST_TYPE,
+                            m_send_buff.getBuffer(), m_send_buff.size());
+
+         core->setState(Core::STALLED);
+         NetPacket recv_pkt = m_network->netRecvType(FUTEX_SERVER_RESPONSE_TYPE, core->getId());
+         core->setState(Core::WAKING_UP);
+
+         LOG_ASSERT_ERROR(recv_pkt.length == sizeof(int), "Unexpected futex reply size(%u)", recv_pkt.length);
+         int ret_val = *((int*) recv_pkt.data);
+         delete [] (Byte*) recv_pkt.data;
+
+         return (carbon_reg_t) ret_val;
+      }
+
       // Package the arguments for the syscall
       m_send_buff.put(addr1);
       m_send_buff.put(op);
@@ -1054,12 +1275,7 @@ IntPtr SyscallMdl::marshallFutexCall (syscall_args_t &args)
 
       // For FUTEX_WAKE, end_time = start_time
       // Look at common/system/syscall_server.cc for this
-      if (end_time > start_time)
-      {
-         UInt64 cycles_elapsed = convertCycleCount(end_time - start_time, 1.0, core_frequency);
-
-         core->getPerformanceModel()->queueDynamicInstruction(new SyncInstruction(cycles_elapsed));
-      }
+      core->wakeUp(start_time, end_time);
 
       // Delete the data buffer
       delete [] (Byte*) recv_pkt.data;
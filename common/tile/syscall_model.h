@@ -2,6 +2,10 @@
 #define SYSCALL_MODEL_H
 
 #include <iostream>
+#include <vector>
+
+// --- included for syscall: fstat
+#include <sys/stat.h>
 
 #include "message_types.h"
 #include "packetize.h"
@@ -35,6 +39,9 @@ class SyscallMdl
       void saveSyscallNumber (IntPtr syscall_number);
       IntPtr retrieveSyscallNumber();
 
+      // Sends the writes held back by the write batch (mcp/write_batch_size)
+      void flushWrites();
+
       void *copyArgToBuffer(UInt32 arg_num, IntPtr arg_addr, UInt32 size);
       void copyArgFromBuffer(UInt32 arg_num, IntPtr arg_addr, UInt32 size);
 
@@ -59,6 +66,39 @@ class SyscallMdl
       UnstructuredBuffer m_send_buff;
       UnstructuredBuffer m_recv_buff;
       Network *m_network;
+      // sync_server/distributed_futexes
+      bool m_distributed_futexes;
+
+      // [mcp] The reads and writes go to the MCP in requests of at most
+      // 'syscall_chunk_size' bytes (0: whole), the writes of up to
+      // 'write_batch_size' bytes to the same fd are held back and sent
+      // together, and with 'local_syscalls' getpid and fstat on the standard
+      // streams are answered from the results of the first calls
+      UInt32 m_chunk_size;
+      UInt32 m_write_batch_size;
+      bool m_local_syscalls;
+
+      int m_batch_fd;
+      std::vector<char> m_write_batch;
+
+      static const int m_num_std_fds = 3;
+      int m_pid;
+      bool m_std_fd_stat_valid[m_num_std_fds];
+      struct stat m_std_fd_stat[m_num_std_fds];
+
+      // [vm_manager] The mmaps of up to 'local_mmap_max_size' bytes are
+      // carved out of a chunk of 'local_mmap_chunk_size' bytes taken from
+      // the MCP, top down
+      UInt64 m_mmap_chunk_size;
+      UInt64 m_local_mmap_max_size;
+      IntPtr m_mmap_chunk_start;
+      IntPtr m_mmap_chunk_end;
+
+      void startRequest(IntPtr syscall_number);
+      int sendReadChunk(int fd, IntPtr buf, size_t count);
+      int sendWriteChunk(int fd, const char *buf, size_t count);
+      IntPtr sendMmapRequest(void *start, size_t length, int prot, int flags, int fd, off_t pgoffset, bool delegated);
+      void clearMemory(IntPtr addr, UInt64 length);
 
       IntPtr marshallOpenCall(syscall_args_t &args);
       IntPtr marshallReadCall(syscall_args_t &args);
@@ -1,17 +1,27 @@
+#include <sstream>
+
 #include "tile.h"
 #include "tile_manager.h"
 #include "network.h"
 #include "network_model.h"
 #include "syscall_model.h"
 #include "sync_client.h"
+#include "distributed_sync_server.h"
+#include "distributed_futex_server.h"
+#include "barrier_release.h"
 #include "network_types.h"
 #include "memory_manager.h"
 #include "pin_memory_manager.h"
+#include "mmu.h"
+#include "spin_detector.h"
+#include "idle_state_model.h"
 #include "clock_skew_minimization_object.h"
 #include "core_model.h"
 #include "main_core.h"
 #include "core.h"
 #include "simulator.h"
+#include "checkpoint.h"
+#include "host_memory.h"
 #include "log.h"
 
 using namespace std;
@@ -20,26 +30,76 @@ Tile::Tile(tile_id_t id)
    : m_tile_id(id)
    , m_shmem_perf_model(NULL)
    , m_memory_manager(NULL)
+   , m_sync_server(NULL)
+   , m_futex_server(NULL)
+   , m_checkpoint_save_on_disable(false)
+   , m_checkpoint_restored(false)
+   , m_checkpoint_saved(false)
+   , m_network_footprint(0)
+   , m_memory_subsystem_footprint(0)
+   , m_core_footprint(0)
+   , m_sync_server_footprint(0)
 {
    LOG_PRINT("Tile ctor for: %d", id);
 
+   string save_point;
+   try
+   {
+      m_checkpoint_load_dir = Sim()->getCfg()->getString("checkpoint/load_dir", "");
+      m_checkpoint_save_dir = Sim()->getCfg()->getString("checkpoint/save_dir", "");
+      save_point = Sim()->getCfg()->getString("checkpoint/save_point", "enable");
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read [checkpoint] parameters from the cfg file");
+   }
+   LOG_ASSERT_ERROR((save_point == "enable") || (save_point == "disable"),
+                    "Unrecognized checkpoint/save_point(%s)", save_point.c_str());
+   m_checkpoint_save_on_disable = (save_point == "disable");
+   // The application runs on between the save and the restore point, the
+   // data of the simulated memory would be stale
+   LOG_ASSERT_ERROR(!m_checkpoint_save_on_disable || (m_checkpoint_save_dir == "") ||
+                    Config::getSingleton()->areCachesTimingOnly(),
+                    "checkpoint/save_point = disable requires caching_protocol/timing_only = true");
+
+   // The heap bytes before the network is built
+   UInt64 heap_bytes = 0;
+   measureHeapGrowth(heap_bytes);
+
    m_network = new Network(this);
+   m_network_footprint = measureHeapGrowth(heap_bytes);
 
    if (Config::getSingleton()->isSimulatingSharedMemory())
    {
-      m_shmem_perf_model = new ShmemPerfModel();
+      m_shmem_perf_model = new ShmemPerfModel(Config::getSingleton()->getMaxThreadsPerCore());
       LOG_PRINT("instantiated shared memory performance model");
 
       m_memory_manager = MemoryManager::createMMU(Sim()->getCfg()->getString("caching_protocol/type"),
                                                   this, this->getNetwork(), m_shmem_perf_model);
       LOG_PRINT("instantiated memory manager model");
    }
+   m_memory_subsystem_footprint = measureHeapGrowth(heap_bytes);
 
    m_main_core = new MainCore(this);
+   m_core_footprint = measureHeapGrowth(heap_bytes);
+
+   if (DistributedSyncServer::isEnabled() && Config::getSingleton()->isApplicationTile(m_tile_id))
+      m_sync_server = new DistributedSyncServer(this);
+   if (DistributedFutexServer::isEnabled() && Config::getSingleton()->isApplicationTile(m_tile_id))
+      m_futex_server = new DistributedFutexServer(this);
+   m_sync_server_footprint = measureHeapGrowth(heap_bytes);
+
+   // The barrier releases are passed on by the application tiles
+   if (Config::getSingleton()->isApplicationTile(m_tile_id))
+      m_network->registerCallback(BARRIER_RELEASE_TYPE, BarrierRelease::networkCallback, m_network);
 }
 
 Tile::~Tile()
 {
+   if (Config::getSingleton()->isApplicationTile(m_tile_id))
+      m_network->unregisterCallback(BARRIER_RELEASE_TYPE);
+   delete m_futex_server;
+   delete m_sync_server;
    delete m_main_core;
    if (Config::getSingleton()->isSimulatingSharedMemory())
    {
@@ -56,6 +116,10 @@ void Tile::outputSummary(std::ostream &os)
    if (Config::getSingleton()->getEnablePerformanceModeling())
    {
       getCore()->getPerformanceModel()->outputSummary(os);
+      if (getCore()->getSpinDetector())
+         getCore()->getSpinDetector()->outputSummary(os);
+      if (getCore()->getIdleStateModel())
+         getCore()->getIdleStateModel()->outputSummary(os);
    }
    LOG_PRINT("Network Summary");
    getNetwork()->outputSummary(os);
@@ -65,9 +129,34 @@ void Tile::outputSummary(std::ostream &os)
    {
       getCore()->getShmemPerfModel()->outputSummary(os, Config::getSingleton()->getCoreFrequency(getCore()->getId()));
       getCore()->getMemoryManager()->outputSummary(os);
+      if (getCore()->getMMU())
+         getCore()->getMMU()->outputSummary(os);
+   }
+
+   if (Config::getSingleton()->isMemoryReportEnabled())
+   {
+      // Other threads may allocate while a tile is built, the numbers are
+      // approximate
+      os << "Memory Footprint Summary:\n";
+      os << "    Network (in bytes): " << m_network_footprint << endl;
+      os << "    Network Models Created: " << getNetwork()->getNumModelsCreated() << endl;
+      os << "    Memory Subsystem (in bytes): " << m_memory_subsystem_footprint << endl;
+      os << "    Core (in bytes): " << m_core_footprint << endl;
+      os << "    Sync Servers (in bytes): " << m_sync_server_footprint << endl;
    }
 }
 
+UInt64 Tile::measureHeapGrowth(UInt64& heap_bytes)
+{
+   if (!Config::getSingleton()->isMemoryReportEnabled())
+      return 0;
+
+   UInt64 last_heap_bytes = heap_bytes;
+   heap_bytes = HostMemory::getHeapBytesInUse();
+   // Zero if the heap shrank (frees of other threads)
+   return (heap_bytes > last_heap_bytes) ? (heap_bytes - last_heap_bytes) : 0;
+}
+
 void Tile::enablePerformanceModels()
 {
    LOG_PRINT("enablePerformanceModels(%i) start", m_tile_id);
@@ -76,6 +165,7 @@ void Tile::enablePerformanceModels()
 
    getNetwork()->enableModels();
    getCore()->getShmemPerfModel()->enable();
+   processCheckpoint(true);
    getCore()->getMemoryManager()->enableModels();
    getCore()->getPerformanceModel()->enable();
    LOG_PRINT("enablePerformanceModels(%i) end", m_tile_id);
@@ -91,12 +181,50 @@ void Tile::disablePerformanceModels()
    getCore()->getShmemPerfModel()->disable();
    getCore()->getMemoryManager()->disableModels();
    getCore()->getPerformanceModel()->disable();
+   processCheckpoint(false);
    LOG_PRINT("disablePerformanceModels(%i) end", m_tile_id);
 }
 
+void Tile::processCheckpoint(bool enabling)
+{
+   if (enabling && !m_checkpoint_restored)
+   {
+      m_checkpoint_restored = true;
+      if (m_checkpoint_load_dir != "")
+      {
+         LOG_PRINT("Restoring checkpoint from %s", m_checkpoint_load_dir.c_str());
+         CheckpointReader reader(getCheckpointFilename(m_checkpoint_load_dir));
+         if (m_memory_manager)
+            m_memory_manager->restoreCheckpoint(reader);
+         getCore()->getPerformanceModel()->restoreState(reader);
+      }
+   }
+
+   if ((enabling != m_checkpoint_save_on_disable) && !m_checkpoint_saved)
+   {
+      m_checkpoint_saved = true;
+      if (m_checkpoint_save_dir != "")
+      {
+         LOG_PRINT("Saving checkpoint to %s", m_checkpoint_save_dir.c_str());
+         CheckpointWriter writer(getCheckpointFilename(m_checkpoint_save_dir));
+         if (m_memory_manager)
+            m_memory_manager->saveCheckpoint(writer);
+         getCore()->getPerformanceModel()->saveState(writer);
+      }
+   }
+}
+
+string Tile::getCheckpointFilename(const string& dir)
+{
+   ostringstream filename;
+   filename << dir << "/tile_" << m_tile_id << ".ckpt";
+   return filename.str();
+}
+
 void
 Tile::updateInternalVariablesOnFrequencyChange(volatile float frequency)
 {
    getCore()->getPerformanceModel()->updateInternalVariablesOnFrequencyChange(frequency);
    getCore()->getShmemPerfModel()->updateInternalVariablesOnFrequencyChange(frequency);
+   getNetwork()->updateInternalVariablesOnFrequencyChange(frequency);
 }
@@ -9,6 +9,8 @@ class MemoryManager;
 class SyscallMdl;
 class SyncClient;
 class ClockSkewMinimizationClient;
+class DistributedSyncServer;
+class DistributedFutexServer;
 
 #include "mem_component.h"
 #include "fixed_types.h"
@@ -45,11 +47,36 @@ public:
    void disablePerformanceModels();
 
 private:
+   // Restores the checkpoint of the tile at the first enable, saves it at
+   // the first enable or disable ([checkpoint])
+   void processCheckpoint(bool enabling);
+   string getCheckpointFilename(const string& dir);
+   // Heap bytes allocated since 'heap_bytes', which is moved to now
+   static UInt64 measureHeapGrowth(UInt64& heap_bytes);
+
    tile_id_t m_tile_id;
    Network *m_network;
    ShmemPerfModel* m_shmem_perf_model;
    MemoryManager *m_memory_manager;
    Core *m_main_core;
+   // sync_server/distributed
+   DistributedSyncServer *m_sync_server;
+   // sync_server/distributed_futexes
+   DistributedFutexServer *m_futex_server;
+
+   // [checkpoint]
+   string m_checkpoint_load_dir;
+   string m_checkpoint_save_dir;
+   bool m_checkpoint_save_on_disable;
+   bool m_checkpoint_restored;
+   bool m_checkpoint_saved;
+
+   // general/memory_report: heap bytes allocated by each part of the tile
+   // when it was built
+   UInt64 m_network_footprint;
+   UInt64 m_memory_subsystem_footprint;
+   UInt64 m_core_footprint;
+   UInt64 m_sync_server_footprint;
 };
 
 #endif
@@ -0,0 +1,91 @@
+#include <assert.h>
+
+#include "message_buffer.h"
+#include "message_ring.h"
+#include "log.h"
+
+MessageRing* MessageBuffer::m_free_lists[NUM_SIZE_CLASSES];
+
+void MessageBuffer::allocatePool()
+{
+   for (SInt32 i = 0; i < NUM_SIZE_CLASSES; i++)
+   {
+      assert(m_free_lists[i] == NULL);
+      m_free_lists[i] = new MessageRing(MAX_FREE_BUFFERS, 0);
+   }
+}
+
+void MessageBuffer::releasePool()
+{
+   for (SInt32 i = 0; i < NUM_SIZE_CLASSES; i++)
+   {
+      MessageRing* free_list = m_free_lists[i];
+      m_free_lists[i] = NULL;
+
+      Byte* block;
+      while (free_list->tryPop(block))
+         delete [] block;
+      delete free_list;
+   }
+}
+
+SInt32 MessageBuffer::getSizeClass(UInt32 size)
+{
+   SInt32 size_class = 0;
+   UInt32 class_size = MIN_BUFFER_SIZE;
+   while (class_size < size)
+   {
+      size_class ++;
+      class_size <<= 1;
+   }
+   return size_class;
+}
+
+Byte* MessageBuffer::allocate(UInt32 length)
+{
+   UInt32 size = length + sizeof(Header);
+   SInt32 size_class = getSizeClass(size);
+
+   Byte* block = NULL;
+   if (size_class < NUM_SIZE_CLASSES)
+   {
+      MessageRing* free_list = m_free_lists[size_class];
+      if ((free_list == NULL) || (!free_list->tryPop(block)))
+         block = new Byte[MIN_BUFFER_SIZE << size_class];
+   }
+   else
+   {
+      block = new Byte[size];
+   }
+
+   Header* header = (Header*) block;
+   header->ref_count = 1;
+   header->size_class = size_class;
+
+   return block + sizeof(Header);
+}
+
+void MessageBuffer::addReference(Byte* buffer)
+{
+   __sync_fetch_and_add(&getHeader(buffer)->ref_count, 1);
+}
+
+void MessageBuffer::release(Byte* buffer)
+{
+   Header* header = getHeader(buffer);
+
+   SInt32 ref_count = __sync_sub_and_fetch(&header->ref_count, 1);
+   LOG_ASSERT_ERROR(ref_count >= 0, "Message buffer(%p) released too many times", buffer);
+   if (ref_count > 0)
+      return;
+
+   Byte* block = (Byte*) header;
+   SInt32 size_class = header->size_class;
+   if (size_class < NUM_SIZE_CLASSES)
+   {
+      MessageRing* free_list = m_free_lists[size_class];
+      if ((free_list != NULL) && free_list->tryPush(block))
+         return;
+   }
+   delete [] block;
+}
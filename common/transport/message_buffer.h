@@ -0,0 +1,48 @@
+#ifndef MESSAGE_BUFFER_H
+#define MESSAGE_BUFFER_H
+
+#include "fixed_types.h"
+
+class MessageRing;
+
+// Reference-counted message buffers handed out by the transports.
+// A small header with the reference count sits in front of the
+// returned pointer, so a message is a single allocation.
+// Released buffers go back to per-size-class free lists and are
+// reused, so small messages (e.g., coherence traffic) normally do
+// not touch the heap at all.
+//
+// Every buffer returned by Transport::Node::recv() is a MessageBuffer
+// and must be given back with release() instead of delete [].
+
+class MessageBuffer
+{
+public:
+   static void allocatePool();
+   static void releasePool();
+
+   // Returns a buffer of 'length' bytes with a reference count of 1
+   static Byte* allocate(UInt32 length);
+   static void addReference(Byte* buffer);
+   static void release(Byte* buffer);
+
+private:
+   struct Header
+   {
+      volatile SInt32 ref_count;
+      SInt32 size_class;
+      UInt64 padding;
+   };
+
+   static const SInt32 NUM_SIZE_CLASSES = 8;
+   static const UInt32 MIN_BUFFER_SIZE = 64;
+   static const UInt32 MAX_FREE_BUFFERS = 4096;
+
+   static SInt32 getSizeClass(UInt32 size);
+   static Header* getHeader(Byte* buffer)
+   { return (Header*) (buffer - sizeof(Header)); }
+
+   static MessageRing* m_free_lists[NUM_SIZE_CLASSES];
+};
+
+#endif // MESSAGE_BUFFER_H
@@ -0,0 +1,453 @@
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "rdma_channel.h"
+#include "simulator.h"
+#include "config.h"
+#include "utils.h"
+#include "log.h"
+
+#ifdef RDMA_ENABLED
+
+#include <infiniband/verbs.h>
+
+// -- Device, shared by the channels of the process -- //
+
+static ibv_context *s_context = NULL;
+static ibv_pd *s_pd = NULL;
+static UInt32 s_num_channels = 0;
+static UInt8 s_port = 1;
+static SInt32 s_gid_index = -1;
+static Lock s_device_lock;
+
+static void openDevice()
+{
+   ScopedLock sl(s_device_lock);
+   if (s_num_channels ++ > 0)
+      return;
+
+   std::string device_name;
+   try
+   {
+      device_name = Sim()->getCfg()->getString("transport/rdma/device", "");
+      s_port = Sim()->getCfg()->getInt("transport/rdma/port", 1);
+      s_gid_index = Sim()->getCfg()->getInt("transport/rdma/gid_index", -1);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read [transport/rdma] parameters from the cfg file");
+   }
+
+   SInt32 num_devices = 0;
+   ibv_device **devices = ibv_get_device_list(&num_devices);
+   LOG_ASSERT_ERROR(devices && (num_devices > 0), "No RDMA device found");
+
+   ibv_device *device = NULL;
+   for (SInt32 i = 0; i < num_devices; i++)
+   {
+      if ((device_name == "") || (device_name == ibv_get_device_name(devices[i])))
+      {
+         device = devices[i];
+         break;
+      }
+   }
+   LOG_ASSERT_ERROR(device, "RDMA device %s not found", device_name.c_str());
+
+   s_context = ibv_open_device(device);
+   LOG_ASSERT_ERROR(s_context, "Failed to open RDMA device %s", ibv_get_device_name(device));
+   ibv_free_device_list(devices);
+
+   s_pd = ibv_alloc_pd(s_context);
+   LOG_ASSERT_ERROR(s_pd, "Failed to allocate an RDMA protection domain");
+
+   LOG_PRINT("Opened RDMA device, port(%u), gid_index(%i)", s_port, s_gid_index);
+}
+
+static void closeDevice()
+{
+   ScopedLock sl(s_device_lock);
+   if (-- s_num_channels > 0)
+      return;
+
+   ibv_dealloc_pd(s_pd);
+   ibv_close_device(s_context);
+   s_pd = NULL;
+   s_context = NULL;
+}
+
+// -- RdmaChannel -- //
+
+RdmaChannel::RdmaChannel()
+   : m_capacity(0)
+   , m_region(NULL)
+   , m_region_size(0)
+   , m_qp(NULL)
+   , m_cq(NULL)
+   , m_mr(NULL)
+   , m_psn(0)
+   , m_remote_addr(0)
+   , m_remote_rkey(0)
+   , m_send_head(0)
+   , m_recv_tail(0)
+   , m_recv_tail_sent(0)
+   , m_num_posts(0)
+   , m_signal_pending(false)
+{
+}
+
+RdmaChannel::~RdmaChannel()
+{
+}
+
+void RdmaChannel::init(UInt32 capacity)
+{
+   LOG_ASSERT_ERROR(m_qp == NULL, "RDMA channel already initialized");
+   LOG_ASSERT_ERROR(isPower2(capacity), "RDMA channel capacity(%u) must be a power of 2", capacity);
+
+   openDevice();
+
+   m_capacity = capacity;
+   m_region_size = sizeof(Region) + 2 * capacity;
+   void *region = NULL;
+   __attribute(__unused__) SInt32 err = posix_memalign(&region, 4096, m_region_size);
+   LOG_ASSERT_ERROR(err == 0, "Failed to allocate an RDMA region of %u bytes", m_region_size);
+   memset(region, 0, m_region_size);
+   m_region = (Region*) region;
+
+   m_mr = ibv_reg_mr(s_pd, m_region, m_region_size, IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_WRITE);
+   LOG_ASSERT_ERROR(m_mr, "Failed to register an RDMA region of %u bytes", m_region_size);
+
+   m_cq = ibv_create_cq(s_context, SEND_QUEUE_DEPTH, NULL, NULL, 0);
+   LOG_ASSERT_ERROR(m_cq, "Failed to create an RDMA completion queue");
+
+   ibv_qp_init_attr qp_init_attr;
+   memset(&qp_init_attr, 0, sizeof(qp_init_attr));
+   qp_init_attr.send_cq = m_cq;
+   qp_init_attr.recv_cq = m_cq;
+   qp_init_attr.cap.max_send_wr = SEND_QUEUE_DEPTH;
+   qp_init_attr.cap.max_recv_wr = 1;
+   qp_init_attr.cap.max_send_sge = 1;
+   qp_init_attr.cap.max_recv_sge = 1;
+   qp_init_attr.cap.max_inline_data = sizeof(UInt64);
+   qp_init_attr.qp_type = IBV_QPT_RC;
+   qp_init_attr.sq_sig_all = 0;
+   m_qp = ibv_create_qp(s_pd, &qp_init_attr);
+   LOG_ASSERT_ERROR(m_qp, "Failed to create an RDMA queue pair");
+
+   ibv_qp_attr attr;
+   memset(&attr, 0, sizeof(attr));
+   attr.qp_state = IBV_QPS_INIT;
+   attr.pkey_index = 0;
+   attr.port_num = s_port;
+   attr.qp_access_flags = IBV_ACCESS_REMOTE_WRITE;
+   err = ibv_modify_qp(m_qp, &attr, IBV_QP_STATE | IBV_QP_PKEY_INDEX | IBV_QP_PORT | IBV_QP_ACCESS_FLAGS);
+   LOG_ASSERT_ERROR(err == 0, "Failed to move the RDMA queue pair to INIT");
+
+   m_psn = m_qp->qp_num & 0xffffff;
+}
+
+void RdmaChannel::getConnectionInfo(ConnectionInfo& info)
+{
+   memset(&info, 0, sizeof(info));
+
+   ibv_port_attr port_attr;
+   __attribute(__unused__) SInt32 err = ibv_query_port(s_context, s_port, &port_attr);
+   LOG_ASSERT_ERROR(err == 0, "Failed to query RDMA port %u", s_port);
+
+   if (s_gid_index >= 0)
+   {
+      ibv_gid gid;
+      err = ibv_query_gid(s_context, s_port, s_gid_index, &gid);
+      LOG_ASSERT_ERROR(err == 0, "Failed to query RDMA gid %i", s_gid_index);
+      memcpy(info.gid, gid.raw, sizeof(info.gid));
+   }
+
+   info.qp_num = m_qp->qp_num;
+   info.psn = m_psn;
+   info.lid = port_attr.lid;
+   info.addr = (UInt64) (uintptr_t) m_region;
+   info.rkey = m_mr->rkey;
+}
+
+void RdmaChannel::connect(const ConnectionInfo& remote)
+{
+   m_remote_addr = remote.addr;
+   m_remote_rkey = remote.rkey;
+
+   ibv_port_attr port_attr;
+   __attribute(__unused__) SInt32 err = ibv_query_port(s_context, s_port, &port_attr);
+   LOG_ASSERT_ERROR(err == 0, "Failed to query RDMA port %u", s_port);
+
+   ibv_qp_attr attr;
+   memset(&attr, 0, sizeof(attr));
+   attr.qp_state = IBV_QPS_RTR;
+   attr.path_mtu = port_attr.active_mtu;
+   attr.dest_qp_num = remote.qp_num;
+   attr.rq_psn = remote.psn;
+   attr.max_dest_rd_atomic = 1;
+   attr.min_rnr_timer = 12;
+   attr.ah_attr.dlid = remote.lid;
+   attr.ah_attr.sl = 0;
+   attr.ah_attr.src_path_bits = 0;
+   attr.ah_attr.port_num = s_port;
+   if (s_gid_index >= 0)
+   {
+      // RoCE, or InfiniBand across subnets
+      attr.ah_attr.is_global = 1;
+      memcpy(attr.ah_attr.grh.dgid.raw, remote.gid, sizeof(remote.gid));
+      attr.ah_attr.grh.sgid_index = s_gid_index;
+      attr.ah_attr.grh.hop_limit = 1;
+   }
+   err = ibv_modify_qp(m_qp, &attr,
+                       IBV_QP_STATE | IBV_QP_AV | IBV_QP_PATH_MTU | IBV_QP_DEST_QPN |
+                       IBV_QP_RQ_PSN | IBV_QP_MAX_DEST_RD_ATOMIC | IBV_QP_MIN_RNR_TIMER);
+   LOG_ASSERT_ERROR(err == 0, "Failed to move the RDMA queue pair to RTR");
+
+   memset(&attr, 0, sizeof(attr));
+   attr.qp_state = IBV_QPS_RTS;
+   attr.timeout = 14;
+   attr.retry_cnt = 7;
+   attr.rnr_retry = 7;
+   attr.sq_psn = m_psn;
+   attr.max_rd_atomic = 1;
+   err = ibv_modify_qp(m_qp, &attr,
+                       IBV_QP_STATE | IBV_QP_TIMEOUT | IBV_QP_RETRY_CNT |
+                       IBV_QP_RNR_RETRY | IBV_QP_SQ_PSN | IBV_QP_MAX_QP_RD_ATOMIC);
+   LOG_ASSERT_ERROR(err == 0, "Failed to move the RDMA queue pair to RTS");
+
+   LOG_PRINT("RDMA channel connected: qp(%u) to remote qp(%u)", m_qp->qp_num, remote.qp_num);
+}
+
+void RdmaChannel::postSend(ibv_send_wr *wr_list)
+{
+   // Must be called with m_post_lock held. Only one post in
+   // SIGNAL_INTERVAL asks for a completion, and the previous one is
+   // reaped before, which bounds the work requests in the send queue.
+   ibv_send_wr *last_wr = wr_list;
+   while (last_wr->next)
+      last_wr = last_wr->next;
+
+   m_num_posts ++;
+   if ((m_num_posts % SIGNAL_INTERVAL) == 0)
+   {
+      if (m_signal_pending)
+         waitForCompletion();
+      last_wr->send_flags |= IBV_SEND_SIGNALED;
+      m_signal_pending = true;
+   }
+
+   ibv_send_wr *bad_wr = NULL;
+   __attribute(__unused__) SInt32 err = ibv_post_send(m_qp, wr_list, &bad_wr);
+   LOG_ASSERT_ERROR(err == 0, "Failed to post an RDMA write: %s", strerror(err));
+}
+
+void RdmaChannel::waitForCompletion()
+{
+   ibv_wc wc;
+   SInt32 num_completions;
+   while ((num_completions = ibv_poll_cq(m_cq, 1, &wc)) == 0)
+      ;
+   LOG_ASSERT_ERROR(num_completions == 1, "Failed to poll the RDMA completion queue");
+   LOG_ASSERT_ERROR(wc.status == IBV_WC_SUCCESS, "RDMA write failed: %s", ibv_wc_status_str(wc.status));
+   m_signal_pending = false;
+}
+
+void RdmaChannel::send(const void* buffer, UInt32 length)
+{
+   const Byte *src = (const Byte*) buffer;
+   Byte *send_data = m_region->data + m_capacity;
+
+   while (length > 0)
+   {
+      UInt64 free_space = m_capacity - (m_send_head - m_region->tail);
+      if (free_space == 0)
+      {
+         // Wait for the remote reader to drain the ring
+         sched_yield();
+         continue;
+      }
+
+      UInt32 offset = m_send_head & (m_capacity - 1);
+      UInt32 chunk = getMin<UInt64>(getMin<UInt64>(free_space, length), m_capacity - offset);
+      memcpy(&send_data[offset], src, chunk);
+
+      src += chunk;
+      length -= chunk;
+      m_send_head += chunk;
+
+      // The data, then the head that publishes it, in one post. The
+      // writes of a reliable connection are placed in order. The head is
+      // inlined, copied when posted.
+      UInt64 head = m_send_head;
+
+      ibv_sge data_sge;
+      data_sge.addr = (uintptr_t) &send_data[offset];
+      data_sge.length = chunk;
+      data_sge.lkey = m_mr->lkey;
+
+      ibv_sge head_sge;
+      head_sge.addr = (uintptr_t) &head;
+      head_sge.length = sizeof(head);
+      head_sge.lkey = 0;
+
+      ibv_send_wr wr[2];
+      memset(wr, 0, sizeof(wr));
+      wr[0].sg_list = &data_sge;
+      wr[0].num_sge = 1;
+      wr[0].opcode = IBV_WR_RDMA_WRITE;
+      wr[0].wr.rdma.remote_addr = m_remote_addr + offsetof(Region, data) + offset;
+      wr[0].wr.rdma.rkey = m_remote_rkey;
+      wr[0].next = &wr[1];
+      wr[1].sg_list = &head_sge;
+      wr[1].num_sge = 1;
+      wr[1].opcode = IBV_WR_RDMA_WRITE;
+      wr[1].send_flags = IBV_SEND_INLINE;
+      wr[1].wr.rdma.remote_addr = m_remote_addr + offsetof(Region, head);
+      wr[1].wr.rdma.rkey = m_remote_rkey;
+      wr[1].next = NULL;
+
+      ScopedLock sl(m_post_lock);
+      postSend(wr);
+   }
+}
+
+void RdmaChannel::writeTail(UInt64 tail)
+{
+   ibv_sge tail_sge;
+   tail_sge.addr = (uintptr_t) &tail;
+   tail_sge.length = sizeof(tail);
+   tail_sge.lkey = 0;
+
+   ibv_send_wr wr;
+   memset(&wr, 0, sizeof(wr));
+   wr.sg_list = &tail_sge;
+   wr.num_sge = 1;
+   wr.opcode = IBV_WR_RDMA_WRITE;
+   wr.send_flags = IBV_SEND_INLINE;
+   wr.wr.rdma.remote_addr = m_remote_addr + offsetof(Region, tail);
+   wr.wr.rdma.rkey = m_remote_rkey;
+   wr.next = NULL;
+
+   ScopedLock sl(m_post_lock);
+   postSend(&wr);
+   m_recv_tail_sent = tail;
+}
+
+bool RdmaChannel::recv(void *buffer, UInt32 length, bool block)
+{
+   Byte *dst = (Byte*) buffer;
+
+   // Like a socket, only the start of a message is non-blocking.
+   // Once any part of it is available, wait for the remainder.
+   if (!block && (m_region->head == m_recv_tail))
+      return false;
+
+   while (length > 0)
+   {
+      UInt64 available = m_region->head - m_recv_tail;
+      if (available == 0)
+      {
+         sched_yield();
+         continue;
+      }
+      __sync_synchronize();
+
+      UInt32 offset = m_recv_tail & (m_capacity - 1);
+      UInt32 chunk = getMin<UInt64>(getMin<UInt64>(available, length), m_capacity - offset);
+      memcpy(dst, &m_region->data[offset], chunk);
+
+      dst += chunk;
+      length -= chunk;
+      m_recv_tail += chunk;
+
+      // Hand the space back in large steps, or at once if the ring may be
+      // full and the sender waiting
+      if ((m_recv_tail - m_recv_tail_sent >= m_capacity / 8) || (m_region->head == m_recv_tail))
+         writeTail(m_recv_tail);
+   }
+
+   return true;
+}
+
+void RdmaChannel::close()
+{
+   if (m_qp == NULL)
+      return;
+
+   {
+      ScopedLock sl(m_post_lock);
+      if (m_signal_pending)
+         waitForCompletion();
+   }
+
+   ibv_destroy_qp(m_qp);
+   ibv_destroy_cq(m_cq);
+   ibv_dereg_mr(m_mr);
+   free(m_region);
+   m_qp = NULL;
+   m_cq = NULL;
+   m_mr = NULL;
+   m_region = NULL;
+
+   closeDevice();
+
+   LOG_PRINT("Closed RDMA channel");
+}
+
+#else // RDMA_ENABLED
+
+RdmaChannel::RdmaChannel()
+   : m_capacity(0)
+   , m_region(NULL)
+   , m_region_size(0)
+   , m_qp(NULL)
+   , m_cq(NULL)
+   , m_mr(NULL)
+   , m_psn(0)
+   , m_remote_addr(0)
+   , m_remote_rkey(0)
+   , m_send_head(0)
+   , m_recv_tail(0)
+   , m_recv_tail_sent(0)
+   , m_num_posts(0)
+   , m_signal_pending(false)
+{
+}
+
+RdmaChannel::~RdmaChannel()
+{
+}
+
+void RdmaChannel::init(UInt32 capacity)
+{
+   LOG_PRINT_ERROR("transport/type = rdma needs a build with RDMA_ENABLED (see common/Makefile.common)");
+}
+
+void RdmaChannel::getConnectionInfo(ConnectionInfo& info)
+{
+   LOG_PRINT_ERROR("Built without RDMA support");
+}
+
+void RdmaChannel::connect(const ConnectionInfo& remote)
+{
+   LOG_PRINT_ERROR("Built without RDMA support");
+}
+
+void RdmaChannel::send(const void* buffer, UInt32 length)
+{
+   LOG_PRINT_ERROR("Built without RDMA support");
+}
+
+bool RdmaChannel::recv(void *buffer, UInt32 length, bool block)
+{
+   LOG_PRINT_ERROR("Built without RDMA support");
+   return false;
+}
+
+void RdmaChannel::close()
+{
+}
+
+#endif // RDMA_ENABLED
@@ -0,0 +1,97 @@
+#ifndef RDMA_CHANNEL_H
+#define RDMA_CHANNEL_H
+
+#include <string>
+
+#include "fixed_types.h"
+#include "lock.h"
+
+struct ibv_qp;
+struct ibv_cq;
+struct ibv_mr;
+struct ibv_send_wr;
+
+// Two-way byte stream between two processes over an InfiniBand (or RoCE)
+// reliable connection (transport/type = rdma). Each side registers a ring
+// that the other side fills with one-sided RDMA writes: the data, then
+// the new head, posted together with a single doorbell. The reader polls
+// its ring like a ShmemChannel and hands the space back by writing its
+// tail to the sender the same way. The connection is set up through the
+// sockets of the transport. The interface mirrors SockTransport::Socket
+// so the two are interchangeable.
+//   Needs a build with RDMA_ENABLED (Makefile.common) and libibverbs.
+
+class RdmaChannel
+{
+public:
+   // Exchanged through the sockets to connect the queue pairs
+   struct ConnectionInfo
+   {
+      UInt32 qp_num;
+      UInt32 psn;
+      UInt16 lid;
+      Byte gid[16];
+      UInt64 addr;
+      UInt32 rkey;
+   };
+
+   RdmaChannel();
+   ~RdmaChannel();
+
+   // Registers the rings and creates the queue pair, then connects it to
+   // the one of the remote process
+   void init(UInt32 capacity);
+   void getConnectionInfo(ConnectionInfo& info);
+   void connect(const ConnectionInfo& remote);
+
+   void send(const void* buffer, UInt32 length);
+   bool recv(void *buffer, UInt32 length, bool block);
+
+   void close();
+
+private:
+   // Registered memory. The head and recv data are written by the remote
+   // process, the tail too (the bytes of the send data it has read). The
+   // send data is the local copy written from, at the same offsets as
+   // in the remote recv data.
+   struct Region
+   {
+      volatile UInt64 head;
+      char pad0[56];
+      volatile UInt64 tail;
+      char pad1[56];
+      Byte data[0];
+   };
+
+   static const UInt32 SIGNAL_INTERVAL = 32;
+   static const UInt32 SEND_QUEUE_DEPTH = 5 * SIGNAL_INTERVAL;
+
+   void postSend(ibv_send_wr *wr_list);
+   void waitForCompletion();
+   void writeTail(UInt64 tail);
+
+   UInt32 m_capacity;
+   Region *m_region;
+   UInt32 m_region_size;
+
+   ibv_qp *m_qp;
+   ibv_cq *m_cq;
+   ibv_mr *m_mr;
+   UInt32 m_psn;
+
+   UInt64 m_remote_addr;
+   UInt32 m_remote_rkey;
+
+   // Bytes written to the remote ring
+   UInt64 m_send_head;
+   // Bytes read from the local ring, and the last count sent back
+   UInt64 m_recv_tail;
+   UInt64 m_recv_tail_sent;
+
+   // Serializes the posts of the sending threads and the update thread
+   Lock m_post_lock;
+   UInt64 m_num_posts;
+   bool m_signal_pending;
+};
+
+#endif // RDMA_CHANNEL_H
@@ -0,0 +1,129 @@
+#include <string.h>
+
+#include "ringtransport.h"
+#include "message_buffer.h"
+#include "simulator.h"
+#include "config.h"
+#include "log.h"
+
+// -- RingTransport -- //
+
+RingTransport::RingTransport()
+{
+   LOG_ASSERT_ERROR(Config::getSingleton()->getProcessCount() == 1,
+                    "Can only use RingTransport with a single process.");
+
+   Config::getSingleton()->setProcessNum(0);
+
+   UInt32 num_slots = Sim()->getCfg()->getInt("transport/ring/num_slots", DEFAULT_NUM_SLOTS);
+   UInt32 spin_count = Sim()->getCfg()->getInt("transport/ring/spin_count", DEFAULT_SPIN_COUNT);
+
+   m_num_tiles = Config::getSingleton()->getNumLocalTiles();
+   m_tile_rings = new MessageRing* [m_num_tiles];
+   for (UInt32 i = 0; i < m_num_tiles; i++)
+      m_tile_rings[i] = new MessageRing(num_slots, spin_count);
+   m_global_ring = new MessageRing(num_slots, spin_count);
+
+   m_global_node = new RingNode(-1, m_global_ring, this);
+
+   LOG_PRINT("Created RingTransport: num_slots(%u), spin_count(%u)", num_slots, spin_count);
+}
+
+RingTransport::~RingTransport()
+{
+   // The networks delete the Transport::Nodes of the tiles
+   delete m_global_node;
+
+   for (UInt32 i = 0; i < m_num_tiles; i++)
+   {
+      Byte *data;
+      while (m_tile_rings[i]->tryPop(data))
+      {
+         LOG_PRINT_WARNING("Unread message in ring for tile: %u", i);
+         MessageBuffer::release(data);
+      }
+      delete m_tile_rings[i];
+   }
+   delete [] m_tile_rings;
+   delete m_global_ring;
+}
+
+Transport::Node* RingTransport::createNode(tile_id_t tile_id)
+{
+   return new RingNode(tile_id, getRingForTile(tile_id), this);
+}
+
+void RingTransport::barrier()
+{
+   // We assume a single process, so this is a NOOP
+}
+
+Transport::Node* RingTransport::getGlobalNode()
+{
+   return m_global_node;
+}
+
+MessageRing* RingTransport::getRingForTile(tile_id_t tile_id)
+{
+   LOG_ASSERT_ERROR(0 <= tile_id && (UInt32) tile_id < m_num_tiles,
+                    "Tile id out of range: %d", tile_id);
+   return m_tile_rings[tile_id];
+}
+
+// -- RingTransport::RingNode -- //
+
+RingTransport::RingNode::RingNode(tile_id_t tile_id, MessageRing *ring, RingTransport *trans)
+   : Node(tile_id)
+   , m_ring(ring)
+   , m_transport(trans)
+{
+}
+
+RingTransport::RingNode::~RingNode()
+{
+}
+
+void RingTransport::RingNode::globalSend(SInt32 dest_proc, const void *buffer, UInt32 length)
+{
+   LOG_ASSERT_ERROR(dest_proc == 0, "Destination other than zero: %d", dest_proc);
+   send(m_transport->m_global_ring, buffer, length);
+}
+
+void RingTransport::RingNode::send(tile_id_t dest_tile, const void *buffer, UInt32 length)
+{
+   send(m_transport->getRingForTile(dest_tile), buffer, length);
+}
+
+void RingTransport::RingNode::send(MessageRing *dest_ring, const void *buffer, UInt32 length)
+{
+   // The receiver releases the buffer returned by recv()
+   Byte *data = MessageBuffer::allocate(length);
+   memcpy(data, buffer, length);
+
+   LOG_PRINT("sending msg -- size: %u, data: %p, dest: %p", length, data, dest_ring);
+
+   dest_ring->push(data);
+   Transport::notifyArrival();
+}
+
+void RingTransport::RingNode::sendBuffer(tile_id_t dest_tile, Byte *buffer, UInt32 length)
+{
+   LOG_PRINT("sending buffer -- size: %u, data: %p, dest: %d", length, buffer, dest_tile);
+
+   m_transport->getRingForTile(dest_tile)->push(buffer);
+   Transport::notifyArrival();
+}
+
+Byte* RingTransport::RingNode::recv()
+{
+   Byte *data = m_ring->pop();
+
+   LOG_PRINT("msg recv'd -- data: %p, this: %p", data, this);
+
+   return data;
+}
+
+bool RingTransport::RingNode::query()
+{
+   return !m_ring->empty();
+}
@@ -0,0 +1,60 @@
+#ifndef RING_TRANSPORT_H
+#define RING_TRANSPORT_H
+
+#include "transport.h"
+#include "message_ring.h"
+
+// In-process transport where each destination node owns a bounded
+// lock-free ring. Senders never take a lock, receivers spin briefly
+// before blocking. Only usable with a single process.
+
+class RingTransport : public Transport
+{
+public:
+   RingTransport();
+   ~RingTransport();
+
+   class RingNode : public Node
+   {
+   public:
+      RingNode(tile_id_t tile_id, MessageRing *ring, RingTransport *trans);
+      ~RingNode();
+
+      void globalSend(SInt32 dest_proc, const void *buffer, UInt32 length);
+      void send(tile_id_t dest_tile, const void *buffer, UInt32 length);
+      Byte* recv();
+      bool query();
+
+      void sendBuffer(tile_id_t dest_tile, Byte *buffer, UInt32 length);
+
+      UInt32 getQueueDepth() { return m_ring->size(); }
+
+   private:
+      void send(MessageRing *dest_ring, const void *buffer, UInt32 length);
+
+      MessageRing *m_ring;
+      RingTransport *m_transport;
+   };
+
+   Node* createNode(tile_id_t tile_id);
+
+   void barrier();
+   Node* getGlobalNode();
+
+private:
+   static const UInt32 DEFAULT_NUM_SLOTS = 1024;
+   static const UInt32 DEFAULT_SPIN_COUNT = 1000;
+
+   MessageRing* getRingForTile(tile_id_t tile_id);
+
+   UInt32 m_num_tiles;
+
+   // Rings are created up-front so that messages can be sent to a
+   // tile before its node is created
+   MessageRing **m_tile_rings;
+   MessageRing *m_global_ring;
+
+   Node *m_global_node;
+};
+
+#endif // RING_TRANSPORT_H
@@ -0,0 +1,90 @@
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+
+#include "shmem_barrier.h"
+#include "log.h"
+
+ShmemBarrier::ShmemBarrier()
+   : m_owner(false)
+   , m_state(NULL)
+{
+}
+
+ShmemBarrier::~ShmemBarrier()
+{
+}
+
+void ShmemBarrier::create(const std::string& name, SInt32 num_procs)
+{
+   m_name = name;
+   m_owner = true;
+
+   // Remove a segment left over by a previous run
+   shm_unlink(m_name.c_str());
+
+   SInt32 fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+   LOG_ASSERT_ERROR(fd >= 0, "Failed to create shared memory segment %s", m_name.c_str());
+
+   __attribute(__unused__) SInt32 err = ftruncate(fd, sizeof(State));
+   LOG_ASSERT_ERROR(err == 0, "Failed to size shared memory segment %s", m_name.c_str());
+
+   void *addr = mmap(NULL, sizeof(State), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   LOG_ASSERT_ERROR(addr != MAP_FAILED, "Failed to map shared memory segment %s", m_name.c_str());
+   ::close(fd);
+
+   m_state = (State*) addr;
+   m_state->count = 0;
+   m_state->generation = 0;
+   m_state->num_procs = num_procs;
+   __sync_synchronize();
+}
+
+void ShmemBarrier::open(const std::string& name)
+{
+   m_name = name;
+   m_owner = false;
+
+   SInt32 fd = shm_open(m_name.c_str(), O_RDWR, S_IRUSR | S_IWUSR);
+   LOG_ASSERT_ERROR(fd >= 0, "Failed to open shared memory segment %s", m_name.c_str());
+
+   void *addr = mmap(NULL, sizeof(State), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   LOG_ASSERT_ERROR(addr != MAP_FAILED, "Failed to map shared memory segment %s", m_name.c_str());
+   ::close(fd);
+
+   m_state = (State*) addr;
+}
+
+void ShmemBarrier::wait()
+{
+   SInt32 generation = m_state->generation;
+
+   if (__sync_add_and_fetch(&m_state->count, 1) == m_state->num_procs)
+   {
+      // Last one in, release everybody
+      m_state->count = 0;
+      __sync_fetch_and_add(&m_state->generation, 1);
+      syscall(SYS_futex, (void*) &m_state->generation, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+   }
+   else
+   {
+      while (m_state->generation == generation)
+         syscall(SYS_futex, (void*) &m_state->generation, FUTEX_WAIT, generation, NULL, NULL, 0);
+   }
+}
+
+void ShmemBarrier::close()
+{
+   if (m_state == NULL)
+      return;
+
+   munmap(m_state, sizeof(State));
+   m_state = NULL;
+
+   if (m_owner)
+      shm_unlink(m_name.c_str());
+}
@@ -0,0 +1,39 @@
+#ifndef SHMEM_BARRIER_H
+#define SHMEM_BARRIER_H
+
+#include <string>
+
+#include "fixed_types.h"
+
+// Barrier between processes on the same host. The state lives in a
+// POSIX shared memory segment and waiting processes sleep on a
+// (process-shared) futex.
+
+class ShmemBarrier
+{
+public:
+   ShmemBarrier();
+   ~ShmemBarrier();
+
+   // One process creates the segment, the others open it
+   void create(const std::string& name, SInt32 num_procs);
+   void open(const std::string& name);
+
+   void wait();
+
+   void close();
+
+private:
+   struct State
+   {
+      volatile SInt32 count;
+      volatile SInt32 generation;
+      SInt32 num_procs;
+   };
+
+   std::string m_name;
+   bool m_owner;
+   State *m_state;
+};
+
+#endif // SHMEM_BARRIER_H
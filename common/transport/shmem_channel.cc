@@ -0,0 +1,159 @@
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <string.h>
+
+#include "shmem_channel.h"
+#include "utils.h"
+#include "log.h"
+
+ShmemChannel::ShmemChannel()
+   : m_owner(false)
+   , m_map_size(0)
+   , m_ring(NULL)
+{
+}
+
+ShmemChannel::~ShmemChannel()
+{
+}
+
+void ShmemChannel::create(const std::string& name, UInt32 capacity)
+{
+   LOG_ASSERT_ERROR(m_ring == NULL, "Shared memory channel %s already open", name.c_str());
+   LOG_ASSERT_ERROR(isPower2(capacity), "Shared memory channel capacity(%u) must be a power of 2", capacity);
+
+   m_name = name;
+   m_owner = true;
+
+   // Remove a segment left over by a previous run
+   shm_unlink(m_name.c_str());
+
+   SInt32 fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+   LOG_ASSERT_ERROR(fd >= 0, "Failed to create shared memory segment %s", m_name.c_str());
+
+   UInt32 size = sizeof(Ring) + capacity;
+   __attribute(__unused__) SInt32 err = ftruncate(fd, size);
+   LOG_ASSERT_ERROR(err == 0, "Failed to size shared memory segment %s", m_name.c_str());
+
+   map(fd, size);
+
+   m_ring->head = 0;
+   m_ring->tail = 0;
+   m_ring->capacity = capacity;
+   __sync_synchronize();
+
+   LOG_PRINT("Created shared memory channel %s of capacity %u", m_name.c_str(), capacity);
+}
+
+void ShmemChannel::open(const std::string& name)
+{
+   LOG_ASSERT_ERROR(m_ring == NULL, "Shared memory channel %s already open", name.c_str());
+
+   m_name = name;
+   m_owner = false;
+
+   SInt32 fd = shm_open(m_name.c_str(), O_RDWR, S_IRUSR | S_IWUSR);
+   LOG_ASSERT_ERROR(fd >= 0, "Failed to open shared memory segment %s", m_name.c_str());
+
+   struct stat st;
+   __attribute(__unused__) SInt32 err = fstat(fd, &st);
+   LOG_ASSERT_ERROR(err == 0, "Failed to stat shared memory segment %s", m_name.c_str());
+
+   map(fd, st.st_size);
+
+   LOG_PRINT("Opened shared memory channel %s", m_name.c_str());
+}
+
+void ShmemChannel::map(SInt32 fd, UInt32 size)
+{
+   void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   LOG_ASSERT_ERROR(addr != MAP_FAILED, "Failed to map shared memory segment %s", m_name.c_str());
+   ::close(fd);
+
+   m_map_size = size;
+   m_ring = (Ring*) addr;
+}
+
+void ShmemChannel::send(const void* buffer, UInt32 length)
+{
+   const Byte *src = (const Byte*) buffer;
+   UInt32 capacity = m_ring->capacity;
+   UInt64 head = m_ring->head;
+
+   while (length > 0)
+   {
+      UInt64 free_space = capacity - (head - m_ring->tail);
+      if (free_space == 0)
+      {
+         // Wait for the reader to drain the ring
+         sched_yield();
+         continue;
+      }
+
+      UInt32 offset = head & (capacity - 1);
+      UInt32 chunk = getMin<UInt64>(getMin<UInt64>(free_space, length), capacity - offset);
+      memcpy(&m_ring->data[offset], src, chunk);
+
+      src += chunk;
+      length -= chunk;
+      head += chunk;
+
+      // Publish the data before moving the head
+      __sync_synchronize();
+      m_ring->head = head;
+   }
+}
+
+bool ShmemChannel::recv(void *buffer, UInt32 length, bool block)
+{
+   Byte *dst = (Byte*) buffer;
+   UInt32 capacity = m_ring->capacity;
+   UInt64 tail = m_ring->tail;
+
+   // Like a socket, only the start of a message is non-blocking.
+   // Once any part of it is available, wait for the remainder.
+   if (!block && (m_ring->head == tail))
+      return false;
+
+   while (length > 0)
+   {
+      UInt64 available = m_ring->head - tail;
+      if (available == 0)
+      {
+         sched_yield();
+         continue;
+      }
+      __sync_synchronize();
+
+      UInt32 offset = tail & (capacity - 1);
+      UInt32 chunk = getMin<UInt64>(getMin<UInt64>(available, length), capacity - offset);
+      memcpy(dst, &m_ring->data[offset], chunk);
+
+      dst += chunk;
+      length -= chunk;
+      tail += chunk;
+
+      // Finish reading before handing the space back
+      __sync_synchronize();
+      m_ring->tail = tail;
+   }
+
+   return true;
+}
+
+void ShmemChannel::close()
+{
+   if (m_ring == NULL)
+      return;
+
+   munmap(m_ring, m_map_size);
+   m_ring = NULL;
+
+   if (m_owner)
+      shm_unlink(m_name.c_str());
+
+   LOG_PRINT("Closed shared memory channel %s", m_name.c_str());
+}
@@ -0,0 +1,49 @@
+#ifndef SHMEM_CHANNEL_H
+#define SHMEM_CHANNEL_H
+
+#include <string>
+
+#include "fixed_types.h"
+
+// One-way byte stream between two processes on the same host, backed
+// by a ring in a POSIX shared memory segment. There is a single writer
+// (the sending process, serialized by its send lock) and a single
+// reader (the update thread of the receiving process). The interface
+// mirrors SockTransport::Socket so the two are interchangeable.
+
+class ShmemChannel
+{
+public:
+   ShmemChannel();
+   ~ShmemChannel();
+
+   // The receiving side creates the segment, the sending side opens it
+   void create(const std::string& name, UInt32 capacity);
+   void open(const std::string& name);
+
+   void send(const void* buffer, UInt32 length);
+   bool recv(void *buffer, UInt32 length, bool block);
+
+   void close();
+
+private:
+   struct Ring
+   {
+      volatile UInt64 head;
+      char pad0[56];
+      volatile UInt64 tail;
+      char pad1[56];
+      UInt32 capacity;
+      char pad2[60];
+      Byte data[0];
+   };
+
+   void map(SInt32 fd, UInt32 size);
+
+   std::string m_name;
+   bool m_owner;
+   UInt32 m_map_size;
+   Ring *m_ring;
+};
+
+#endif // SHMEM_CHANNEL_H
@@ -1,6 +1,7 @@
 #include <string.h>
 
 #include "smtransport.h"
+#include "message_buffer.h"
 #include "config.h"
 #include "log.h"
 
@@ -72,6 +73,7 @@ void SmTransport::clearNodeForId(tile_id_t tile_id)
 
 SmTransport::SmNode::SmNode(tile_id_t tile_id, SmTransport *smt)
    : Node(tile_id)
+   , m_queue_depth(0)
    , m_smt(smt)
 {
 }
@@ -97,15 +99,33 @@ void SmTransport::SmNode::send(SInt32 dest_id, const void* buffer, UInt32 length
 
 void SmTransport::SmNode::send(SmNode *dest_node, const void *buffer, UInt32 length)
 {
-   Byte *data = new Byte[length];
+   Byte *data = MessageBuffer::allocate(length);
    memcpy(data, buffer, length);
 
    LOG_PRINT("sending msg -- size: %i, data: %p, dest: %p", length, data, dest_node);
 
-   dest_node->m_lock.acquire();
-   dest_node->m_queue.push(data);
-   dest_node->m_lock.release();
-   dest_node->m_cond.broadcast();
+   dest_node->enqueue(data);
+}
+
+void SmTransport::SmNode::sendBuffer(SInt32 dest_id, Byte *buffer, UInt32 length)
+{
+   SmNode *dest_node = m_smt->getNodeFromId(dest_id);
+   LOG_ASSERT_ERROR(dest_node != NULL, "Attempt to send to non-existent node: %d", dest_id);
+
+   LOG_PRINT("sending buffer -- size: %i, data: %p, dest: %p", length, buffer, dest_node);
+
+   dest_node->enqueue(buffer);
+}
+
+void SmTransport::SmNode::enqueue(Byte *data)
+{
+   m_lock.acquire();
+   m_queue.push(data);
+   m_queue_depth = m_queue.size();
+   m_lock.release();
+   m_cond.broadcast();
+
+   Transport::notifyArrival();
 }
 
 Byte* SmTransport::SmNode::recv()
@@ -120,6 +140,7 @@ Byte* SmTransport::SmNode::recv()
       {
          Byte *data = m_queue.front();
          m_queue.pop();
+         m_queue_depth = m_queue.size();
          m_lock.release();
 
          LOG_PRINT("msg recv'd -- data: %p, this: %p", data, this);
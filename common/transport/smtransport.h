@@ -23,10 +23,17 @@ public:
       Byte* recv();
       bool query();
 
+      void sendBuffer(tile_id_t, Byte*, UInt32);
+
+      UInt32 getQueueDepth() { return m_queue_depth; }
+
    private:
       void send(SmNode *dest, const void *buffer, UInt32 length);
+      void enqueue(Byte *data);
 
       std::queue<Byte*> m_queue;
+      // Size of m_queue, written under m_lock
+      volatile UInt32 m_queue_depth;
       Lock m_lock;
       ConditionVariable m_cond;
       SmTransport *m_smt;
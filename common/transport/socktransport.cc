@@ -9,28 +9,53 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <sched.h>
+#include <sys/time.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 
 #include "log.h"
 #include "config.h"
 #include "simulator.h" //interface to config file singleton
 #include "socktransport.h"
-
-// #define __CHECKSUM_ENABLED__     1
-
-#ifdef __CHECKSUM_ENABLED__
+#include "message_buffer.h"
+#include "network.h"
 #include "checksum.h"
-#endif // __CHECKSUM_ENABLED__
 
 using std::string;
 
-SockTransport::SockTransport()
-   : m_update_thread_state(RUNNING)
+static UInt64 getTime()
+{
+   timeval t;
+   gettimeofday(&t, NULL);
+   return (((UInt64) t.tv_sec) * 1000000 + t.tv_usec);
+}
+
+SockTransport::SockTransport(bool shmem_enabled, bool rdma_enabled)
+   : m_num_barrier_rounds(0)
+   , m_barrier_round_sems(NULL)
+   , m_update_thread_state(RUNNING)
+   , m_epoll_enabled(false)
+   , m_epoll_fd(-1)
+   , m_wakeup_fd(-1)
+   , m_recv_buffers(NULL)
+   , m_shmem_enabled(shmem_enabled)
+   , m_shmem_send_channels(NULL)
+   , m_shmem_recv_channels(NULL)
+   , m_shmem_barrier_enabled(false)
+   , m_rdma_enabled(rdma_enabled)
+   , m_rdma_channels(NULL)
+   , m_send_frame_counts(NULL)
+   , m_recv_frame_counts(NULL)
 {
    m_base_port = Sim()->getCfg()->getInt("transport/base_port", DEFAULT_BASE_PORT);
 
    getProcInfo();
    initSockets();
    initBufferLists();
+   initBatches();
+   initEpoll();
+   initBarrier();
+   initIntegrity();
 
    m_update_thread = Thread::create(updateThreadFunc, this);
    m_update_thread->run();
@@ -58,20 +83,8 @@ void SockTransport::getProcInfo()
    LOG_PRINT("Process number set to %i", Config::getSingleton()->getCurrentProcessNum());
 }
 
-void SockTransport::initSockets()
+void SockTransport::getProcAddresses(std::vector<std::string>& proc_addrs)
 {
-   SInt32 my_port;
-
-   LOG_PRINT("initSockets()");
-
-   // -- server side
-   my_port = m_base_port + m_proc_index;
-   m_server_socket.listen(my_port, m_num_procs);
-
-   // -- client side
-   m_send_sockets = new Socket[m_num_procs];
-   m_send_locks = new Lock[m_num_procs];
-
    for (SInt32 proc = 0; proc < m_num_procs; proc++)
    {
       // Look up the mapping in the config file to find the address for this
@@ -88,8 +101,35 @@ void SockTransport::initSockets()
       {
           LOG_ASSERT_ERROR(false, "Key: %s not found in config!", server_string.c_str());
       }
+      proc_addrs.push_back(server_addr);
+   }
+}
 
-      m_send_sockets[proc].connect(server_addr.c_str(), m_base_port + proc);
+void SockTransport::initSockets()
+{
+   SInt32 my_port;
+
+   LOG_PRINT("initSockets()");
+
+   std::vector<std::string> proc_addrs;
+   getProcAddresses(proc_addrs);
+
+   // The shared memory segments this process reads from must exist
+   // before we connect to anybody; see openShmemChannels()
+   if (m_shmem_enabled)
+      createShmemChannels(proc_addrs);
+
+   // -- server side
+   my_port = m_base_port + m_proc_index;
+   m_server_socket.listen(my_port, m_num_procs);
+
+   // -- client side
+   m_send_sockets = new Socket[m_num_procs];
+   m_send_locks = new Lock[m_num_procs];
+
+   for (SInt32 proc = 0; proc < m_num_procs; proc++)
+   {
+      m_send_sockets[proc].connect(proc_addrs[proc].c_str(), m_base_port + proc);
 
       m_send_sockets[proc].send(&m_proc_index, sizeof(m_proc_index));
    }
@@ -111,6 +151,135 @@ void SockTransport::initSockets()
 
       m_recv_sockets[proc_index] = sock;
    }
+
+   if (m_shmem_enabled)
+      openShmemChannels();
+   if (m_rdma_enabled)
+      initRdmaChannels();
+}
+
+string SockTransport::getShmemName(SInt32 src_proc, SInt32 dest_proc)
+{
+   // The base port distinguishes simultaneous simulations on a host
+   char name[64];
+   if (src_proc < 0)
+      snprintf(name, sizeof(name), "/graphite_%d_barrier", m_base_port);
+   else
+      snprintf(name, sizeof(name), "/graphite_%d_%d_%d", m_base_port, src_proc, dest_proc);
+   return string(name);
+}
+
+void SockTransport::createShmemChannels(const std::vector<std::string>& proc_addrs)
+{
+   UInt32 channel_size = Sim()->getCfg()->getInt("transport/shmem/channel_size", DEFAULT_SHMEM_CHANNEL_SIZE);
+
+   // Processes with the same process_map entry share a host. Messages
+   // to ourselves never leave the process, so no channel is needed.
+   m_local_procs.resize(m_num_procs);
+   bool all_local = true;
+   for (SInt32 proc = 0; proc < m_num_procs; proc++)
+   {
+      m_local_procs[proc] = (proc != m_proc_index) && (proc_addrs[proc] == proc_addrs[m_proc_index]);
+      all_local = all_local && ((proc == m_proc_index) || m_local_procs[proc]);
+   }
+
+   m_shmem_send_channels = new ShmemChannel[m_num_procs];
+   m_shmem_recv_channels = new ShmemChannel[m_num_procs];
+   for (SInt32 proc = 0; proc < m_num_procs; proc++)
+   {
+      if (m_local_procs[proc])
+         m_shmem_recv_channels[proc].create(getShmemName(proc, m_proc_index), channel_size);
+   }
+
+   m_shmem_barrier_enabled = all_local && (m_num_procs > 1);
+   if (m_shmem_barrier_enabled && (m_proc_index == 0))
+      m_shmem_barrier.create(getShmemName(-1, -1), m_num_procs);
+}
+
+void SockTransport::openShmemChannels()
+{
+   // Every process creates its segments before connecting, and we
+   // have accepted a connection from everybody, so all the segments
+   // exist by now.
+   for (SInt32 proc = 0; proc < m_num_procs; proc++)
+   {
+      if (m_local_procs[proc])
+         m_shmem_send_channels[proc].open(getShmemName(m_proc_index, proc));
+   }
+
+   if (m_shmem_barrier_enabled && (m_proc_index != 0))
+      m_shmem_barrier.open(getShmemName(-1, -1));
+
+   LOG_PRINT("Shared memory channels open, shared memory barrier(%s)",
+             m_shmem_barrier_enabled ? "true" : "false");
+}
+
+void SockTransport::initRdmaChannels()
+{
+   UInt32 channel_size = Sim()->getCfg()->getInt("transport/rdma/channel_size", DEFAULT_RDMA_CHANNEL_SIZE);
+
+   // Every process sends its queue pair info to every other one, then
+   // reads theirs; the sockets buffer the info, so nobody waits on a send
+   m_rdma_channels = new RdmaChannel[m_num_procs];
+   for (SInt32 proc = 0; proc < m_num_procs; proc++)
+   {
+      if (proc == m_proc_index)
+         continue;
+      m_rdma_channels[proc].init(channel_size);
+      RdmaChannel::ConnectionInfo info;
+      m_rdma_channels[proc].getConnectionInfo(info);
+      m_send_sockets[proc].send(&info, sizeof(info));
+   }
+
+   for (SInt32 proc = 0; proc < m_num_procs; proc++)
+   {
+      if (proc == m_proc_index)
+         continue;
+      RdmaChannel::ConnectionInfo remote_info;
+      m_recv_sockets[proc].recv(&remote_info, sizeof(remote_info), true);
+      m_rdma_channels[proc].connect(remote_info);
+   }
+
+   // A queue pair may only be written once the remote one is connected
+   SInt32 ready = 1;
+   for (SInt32 proc = 0; proc < m_num_procs; proc++)
+   {
+      if (proc != m_proc_index)
+         m_send_sockets[proc].send(&ready, sizeof(ready));
+   }
+   for (SInt32 proc = 0; proc < m_num_procs; proc++)
+   {
+      if (proc != m_proc_index)
+         m_recv_sockets[proc].recv(&ready, sizeof(ready), true);
+   }
+
+   LOG_PRINT("RDMA channels connected, size(%u)", channel_size);
+}
+
+bool SockTransport::isChannelProc(SInt32 proc)
+{
+   return ((m_shmem_enabled && m_local_procs[proc]) ||
+           (m_rdma_enabled && (proc != m_proc_index)));
+}
+
+void SockTransport::sendToProc(SInt32 dest_proc, const void *buffer, UInt32 length)
+{
+   if (m_shmem_enabled && m_local_procs[dest_proc])
+      m_shmem_send_channels[dest_proc].send(buffer, length);
+   else if (m_rdma_enabled && (dest_proc != m_proc_index))
+      m_rdma_channels[dest_proc].send(buffer, length);
+   else
+      m_send_sockets[dest_proc].send(buffer, length);
+}
+
+bool SockTransport::recvFromProc(SInt32 src_proc, void *buffer, UInt32 length, bool block)
+{
+   if (m_shmem_enabled && m_local_procs[src_proc])
+      return m_shmem_recv_channels[src_proc].recv(buffer, length, block);
+   else if (m_rdma_enabled && (src_proc != m_proc_index))
+      return m_rdma_channels[src_proc].recv(buffer, length, block);
+   else
+      return m_recv_sockets[src_proc].recv(buffer, length, block);
 }
 
 void SockTransport::initBufferLists()
@@ -119,14 +288,159 @@ void SockTransport::initBufferLists()
       = Config::getSingleton()->getTotalTiles() // for tiles
       + 1; // for global node
 
-   m_buffer_lists = new buffer_list[m_num_lists];
+   m_priority_lanes_enabled = Sim()->getCfg()->getBool("transport/priority_lanes", false);
+   m_starvation_limit = Sim()->getCfg()->getInt("transport/priority_starvation_limit", 16);
+
+   m_buffer_lists = new buffer_list[m_num_lists * NUM_LANES];
 
-#ifdef __CHECKSUM_ENABLED__
-   m_header_lists = new std::list<Header*>[m_num_lists];
-#endif // __CHECKSUM_ENABLED__
+   m_lane_bypasses = new UInt32[m_num_lists];
+   for (SInt32 i = 0; i < m_num_lists; i++)
+      m_lane_bypasses[i] = 0;
 
    m_buffer_list_locks = new Lock[m_num_lists];
    m_buffer_list_sems = new Semaphore[m_num_lists];
+   m_buffer_list_sizes = new volatile UInt32[m_num_lists];
+   for (SInt32 i = 0; i < m_num_lists; i++)
+      m_buffer_list_sizes[i] = 0;
+}
+
+void SockTransport::initBatches()
+{
+   m_batching_enabled = Sim()->getCfg()->getBool("transport/socket/batching/enabled", false);
+   m_batch_size = Sim()->getCfg()->getInt("transport/socket/batching/size", DEFAULT_BATCH_SIZE);
+   m_batch_timeout = Sim()->getCfg()->getInt("transport/socket/batching/timeout", DEFAULT_BATCH_TIMEOUT);
+
+   m_send_batches = new Batch[m_num_procs];
+   for (SInt32 proc = 0; proc < m_num_procs; proc++)
+   {
+      // Room for the length and tag of the batch itself in front
+      m_send_batches[proc].buffer = m_batching_enabled
+                                    ? new Byte[sizeof(UInt32) + sizeof(SInt32) + m_batch_size]
+                                    : NULL;
+      m_send_batches[proc].length = 0;
+      m_send_batches[proc].start_time = 0;
+   }
+
+   LOG_PRINT("Batching enabled(%s), size(%u), timeout(%llu)",
+             m_batching_enabled ? "true" : "false", m_batch_size, m_batch_timeout);
+}
+
+void SockTransport::initEpoll()
+{
+   m_epoll_enabled = Sim()->getCfg()->getBool("transport/socket/epoll", false);
+   if (!m_epoll_enabled)
+      return;
+
+   UInt32 recv_buffer_size = Sim()->getCfg()->getInt("transport/socket/recv_buffer_size", DEFAULT_RECV_BUFFER_SIZE);
+   LOG_ASSERT_ERROR(recv_buffer_size >= sizeof(UInt32) + sizeof(SInt32),
+                    "transport/socket/recv_buffer_size(%u) is too small", recv_buffer_size);
+
+   m_epoll_fd = epoll_create(m_num_procs + 1);
+   LOG_ASSERT_ERROR(m_epoll_fd >= 0, "epoll_create failed: %s", strerror(errno));
+
+   m_recv_buffers = new RecvBuffer[m_num_procs];
+   for (SInt32 proc = 0; proc < m_num_procs; proc++)
+   {
+      m_recv_buffers[proc].data = NULL;
+      m_recv_buffers[proc].capacity = 0;
+      m_recv_buffers[proc].start = 0;
+      m_recv_buffers[proc].end = 0;
+
+      // Processes that send through shared memory or RDMA are polled
+      if (isChannelProc(proc))
+         continue;
+
+      m_recv_buffers[proc].data = new Byte[recv_buffer_size];
+      m_recv_buffers[proc].capacity = recv_buffer_size;
+
+      struct epoll_event event;
+      event.events = EPOLLIN;
+      event.data.u32 = proc;
+      SInt32 err = epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_recv_sockets[proc].getFd(), &event);
+      LOG_ASSERT_ERROR(err == 0, "epoll_ctl failed for process %d: %s", proc, strerror(errno));
+   }
+
+   m_wakeup_fd = eventfd(0, EFD_NONBLOCK);
+   LOG_ASSERT_ERROR(m_wakeup_fd >= 0, "eventfd failed: %s", strerror(errno));
+   struct epoll_event event;
+   event.events = EPOLLIN;
+   event.data.u32 = m_num_procs;
+   SInt32 err = epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_wakeup_fd, &event);
+   LOG_ASSERT_ERROR(err == 0, "epoll_ctl failed for the wakeup eventfd: %s", strerror(errno));
+
+   LOG_PRINT("Epoll receiver enabled, recv buffer size(%u)", recv_buffer_size);
+}
+
+void SockTransport::initBarrier()
+{
+   string barrier_type = Sim()->getCfg()->getString("transport/barrier", "ring");
+   if (barrier_type == "ring")
+      m_barrier_type = RING_BARRIER;
+   else if (barrier_type == "dissemination")
+      m_barrier_type = DISSEMINATION_BARRIER;
+   else
+      LOG_PRINT_ERROR("Unrecognized transport barrier type(%s)", barrier_type.c_str());
+
+   if (m_barrier_type == DISSEMINATION_BARRIER)
+   {
+      while ((1 << m_num_barrier_rounds) < m_num_procs)
+         m_num_barrier_rounds ++;
+      m_barrier_round_sems = new Semaphore[m_num_barrier_rounds];
+   }
+
+   LOG_PRINT("Transport barrier(%s), rounds(%i)", barrier_type.c_str(), m_num_barrier_rounds);
+}
+
+void SockTransport::initIntegrity()
+{
+   string integrity = Sim()->getCfg()->getString("transport/socket/integrity", "off");
+   if (integrity == "off")
+      m_integrity_mode = INTEGRITY_OFF;
+   else if (integrity == "sampled")
+      m_integrity_mode = INTEGRITY_SAMPLED;
+   else if (integrity == "full")
+      m_integrity_mode = INTEGRITY_FULL;
+   else
+      LOG_PRINT_ERROR("Unrecognized transport integrity mode(%s)", integrity.c_str());
+
+   m_integrity_sample_rate = Sim()->getCfg()->getInt("transport/socket/integrity_sample_rate", 64);
+   LOG_ASSERT_ERROR(m_integrity_sample_rate > 0, "Transport integrity sample rate must be > 0");
+
+   m_send_frame_counts = new UInt64[m_num_procs];
+   m_recv_frame_counts = new UInt64[m_num_procs];
+   for (SInt32 proc = 0; proc < m_num_procs; proc++)
+   {
+      m_send_frame_counts[proc] = 0;
+      m_recv_frame_counts[proc] = 0;
+   }
+
+   LOG_PRINT("Transport integrity(%s), sample rate(%u)", integrity.c_str(), m_integrity_sample_rate);
+}
+
+bool SockTransport::isDataTag(SInt32 tag)
+{
+   return ((tag != BARRIER_TAG) && (tag != TERMINATE_TAG));
+}
+
+bool SockTransport::isCheckedFrame(UInt64 frame_index)
+{
+   switch (m_integrity_mode)
+   {
+   case INTEGRITY_FULL:
+      return true;
+   case INTEGRITY_SAMPLED:
+      return ((frame_index % m_integrity_sample_rate) == 0);
+   default:
+      return false;
+   }
+}
+
+void SockTransport::checkFrame(SInt32 src_proc, const Byte *buffer, UInt32 length, UInt32 crc)
+{
+   UInt32 computed_crc = computeCrc32c(buffer, length);
+   LOG_ASSERT_ERROR(computed_crc == crc,
+                    "CRC32C Error from process %d: computed(%#x), received(%#x), length(%u)",
+                    src_proc, computed_crc, crc, length);
 }
 
 void SockTransport::updateThreadFunc(void *vp)
@@ -137,8 +451,19 @@ void SockTransport::updateThreadFunc(void *vp)
 
    while (st->m_update_thread_state == RUNNING)
    {
-      st->updateBufferLists();
-      sched_yield();
+      if (st->m_epoll_enabled)
+      {
+         st->updateBufferListsEpoll();
+         if (st->m_batching_enabled)
+            st->flushBatches(true);
+      }
+      else
+      {
+         st->updateBufferLists();
+         if (st->m_batching_enabled)
+            st->flushBatches(true);
+         sched_yield();
+      }
    }
 
    st->m_update_thread_state = EXITED;
@@ -150,87 +475,325 @@ void SockTransport::updateBufferLists()
 {
    for (SInt32 i = 0; i < m_num_procs; i++)
    {
-      while (true)
+      if (!updateBufferList(i))
+         return;
+   }
+}
+
+bool SockTransport::updateBufferList(SInt32 i)
+{
+   while (true)
+   {
+      UInt32 length;
+
+      m_recv_locks[i].acquire();
+
+      // first get packet length, abort if none available
+      if (!recvFromProc(i, &length, sizeof(length), false))
       {
-         UInt32 length;
+         m_recv_locks[i].release();
+         return true;
+      }
 
-         m_recv_locks[i].acquire();
+      // now receive tag
+      SInt32 tag;
+      recvFromProc(i, &tag, sizeof(tag), true);
 
-         // first get packet length, abort if none available
-         if (!m_recv_sockets[i].recv(&length, sizeof(length), false))
-         {
-            m_recv_locks[i].release();
-            break;
-         }
+      // now receive packet
+      Byte *buffer = MessageBuffer::allocate(length);
+      recvFromProc(i, buffer, length, true);
 
-         // now receive tag
-         SInt32 tag;
-         m_recv_sockets[i].recv(&tag, sizeof(tag), true);
+      // now receive the CRC32C, if any
+      if (isDataTag(tag) && isCheckedFrame(m_recv_frame_counts[i]++))
+      {
+         UInt32 crc;
+         recvFromProc(i, &crc, sizeof(crc), true);
+         checkFrame(i, buffer, length, crc);
+      }
 
-         // now receive packet
-         Byte *buffer = new Byte[length];
-         m_recv_sockets[i].recv(buffer, length, true);
+      m_recv_locks[i].release();
 
-#ifdef __CHECKSUM_ENABLED__
-         // now receive checksum
-         UInt64 checksum = 0;
-         if ((tag != TERMINATE_TAG) && (tag != BARRIER_TAG))
-         {
-            m_recv_sockets[i].recv(&checksum, sizeof(checksum), true);
-         }
-#endif // __CHECKSUM_ENABLED__
+      if (!processPacket(i, tag, buffer, length))
+         return false;
+   }
+}
 
-         m_recv_locks[i].release();
+bool SockTransport::processPacket(SInt32 i, SInt32 tag, Byte *buffer, UInt32 length)
+{
+   switch (tag)
+   {
+   case TERMINATE_TAG:
+      LOG_PRINT("Quit message received.");
+      LOG_ASSERT_ERROR(m_update_thread_state == RUNNING, "Terminate received in unexpected state: %d", m_update_thread_state);
+      LOG_ASSERT_ERROR(i == m_proc_index, "Terminate received from unexpected process: %d != %d", i, m_proc_index);
+      m_update_thread_state = EXITING;
+
+      MessageBuffer::release(buffer);
+      return false;
+
+   case BARRIER_TAG:
+      if (m_barrier_type == DISSEMINATION_BARRIER)
+      {
+         SInt32 round;
+         memcpy(&round, buffer, sizeof(round));
+         LOG_ASSERT_ERROR(0 <= round && round < m_num_barrier_rounds, "Unexpected barrier round: %d", round);
+         LOG_ASSERT_ERROR(i == (m_proc_index + m_num_procs - (1 << round) % m_num_procs) % m_num_procs,
+                          "Barrier update of round %d from unexpected process: %d", round, i);
+         m_barrier_round_sems[round].signal();
+      }
+      else
+      {
+         m_barrier_sem.signal();
+         LOG_ASSERT_ERROR(i == (m_proc_index + m_num_procs - 1) % m_num_procs,
+                          "Barrier update from unexpected process: %d", i);
+      }
+      MessageBuffer::release(buffer);
+      break;
+
+   case BATCH_TAG:
+      splitBatch(buffer, length);
+      MessageBuffer::release(buffer);
+      break;
+
+   case GLOBAL_TAG:
+   default:
+      insertInBufferList(tag, buffer);
+      // do NOT delete buffer
+      break;
+   };
+   return true;
+}
+
+void SockTransport::updateBufferListsEpoll()
+{
+   // The shared memory and RDMA channels cannot be waited on, and the
+   // stale batches are flushed by this thread: poll while there are any
+   bool polling = false;
+   for (SInt32 i = 0; i < m_num_procs; i++)
+   {
+      if (!isChannelProc(i))
+         continue;
+      polling = true;
+      if (!updateBufferList(i))
+         return;
+   }
+   if (m_batching_enabled)
+   {
+      // Unlocked peek, a batch started after it wakes us up
+      for (SInt32 i = 0; (i < m_num_procs) && !polling; i++)
+         polling = (m_send_batches[i].length > 0);
+   }
+
+   struct epoll_event events[m_num_procs + 1];
+   SInt32 num_events = epoll_wait(m_epoll_fd, events, m_num_procs + 1, polling ? 0 : -1);
+   if (num_events < 0)
+   {
+      LOG_ASSERT_ERROR(errno == EINTR, "epoll_wait failed: %s", strerror(errno));
+      return;
+   }
 
-         switch (tag)
+   for (SInt32 e = 0; e < num_events; e++)
+   {
+      SInt32 proc = events[e].data.u32;
+      if (proc == m_num_procs)
+      {
+         UInt64 count;
+         SInt32 err = ::read(m_wakeup_fd, &count, sizeof(count));
+         LOG_ASSERT_WARNING(err == sizeof(count) || errno == EAGAIN, "Failed to read the wakeup eventfd");
+         continue;
+      }
+      if (!readSocket(proc))
+         return;
+   }
+
+   if (polling && (num_events == 0))
+      sched_yield();
+}
+
+bool SockTransport::readSocket(SInt32 src_proc)
+{
+   RecvBuffer &recv_buffer = m_recv_buffers[src_proc];
+   SInt32 fd = m_recv_sockets[src_proc].getFd();
+
+   while (true)
+   {
+      // Move the partial packet to the front to make room
+      if ((recv_buffer.start > 0) && (recv_buffer.end == recv_buffer.capacity))
+      {
+         memmove(recv_buffer.data, recv_buffer.data + recv_buffer.start, recv_buffer.end - recv_buffer.start);
+         recv_buffer.end -= recv_buffer.start;
+         recv_buffer.start = 0;
+      }
+
+      SInt32 recvd = ::recv(fd, recv_buffer.data + recv_buffer.end,
+                            recv_buffer.capacity - recv_buffer.end, MSG_DONTWAIT);
+      if (recvd < 0)
+      {
+         LOG_ASSERT_ERROR((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR),
+                          "Error on socket(%i) from process %d: %s", fd, src_proc, strerror(errno));
+         if (errno == EINTR)
+            continue;
+         return true;
+      }
+      if (recvd == 0)
+      {
+         // The process closed its end: nothing more to wait for
+         LOG_PRINT("Socket(%i) from process %d closed", fd, src_proc);
+         epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+         return true;
+      }
+
+      recv_buffer.end += recvd;
+      if (!parseRecvBuffer(src_proc))
+         return false;
+   }
+}
+
+bool SockTransport::parseRecvBuffer(SInt32 src_proc)
+{
+   RecvBuffer &recv_buffer = m_recv_buffers[src_proc];
+   const UInt32 header_length = sizeof(UInt32) + sizeof(SInt32);
+
+   while (recv_buffer.end - recv_buffer.start >= header_length)
+   {
+      Byte *p = recv_buffer.data + recv_buffer.start;
+      UInt32 length;
+      SInt32 tag;
+      memcpy(&length, p, sizeof(length));
+      memcpy(&tag, p + sizeof(length), sizeof(tag));
+
+      // The frame is only counted once it is complete
+      bool checked = isDataTag(tag) && isCheckedFrame(m_recv_frame_counts[src_proc]);
+      UInt32 packet_length = header_length + length + (checked ? sizeof(UInt32) : 0);
+
+      if (recv_buffer.end - recv_buffer.start < packet_length)
+      {
+         // Grow the buffer if the packet does not fit
+         if (packet_length > recv_buffer.capacity)
          {
-         case TERMINATE_TAG:
-            LOG_PRINT("Quit message received.");
-            LOG_ASSERT_ERROR(m_update_thread_state == RUNNING, "Terminate received in unexpected state: %d", m_update_thread_state);
-            LOG_ASSERT_ERROR(i == m_proc_index, "Terminate received from unexpected process: %d != %d", i, m_proc_index);
-            m_update_thread_state = EXITING;
-
-            delete [] buffer;
-            return;
-
-         case BARRIER_TAG:
-            m_barrier_sem.signal();
-            LOG_ASSERT_ERROR(i == (m_proc_index + m_num_procs - 1) % m_num_procs,
-                             "Barrier update from unexpected process: %d", i);
-            delete [] buffer;
-            break;
-
-         case GLOBAL_TAG:
-         default:
-#ifdef __CHECKSUM_ENABLED__
-            Header* header = new Header(length, checksum);
-            insertInBufferList(tag, buffer, header);
-#else
-            insertInBufferList(tag, buffer);
-#endif // __CHECKSUM_ENABLED__
-            // do NOT delete buffer
-            break;
-         };
+            Byte *data = new Byte[packet_length];
+            memcpy(data, p, recv_buffer.end - recv_buffer.start);
+            delete [] recv_buffer.data;
+            recv_buffer.data = data;
+            recv_buffer.capacity = packet_length;
+            recv_buffer.end -= recv_buffer.start;
+            recv_buffer.start = 0;
+         }
+         break;
       }
+
+      Byte *buffer = MessageBuffer::allocate(length);
+      memcpy(buffer, p + header_length, length);
+      if (isDataTag(tag))
+         m_recv_frame_counts[src_proc] ++;
+      if (checked)
+      {
+         UInt32 crc;
+         memcpy(&crc, p + header_length + length, sizeof(crc));
+         checkFrame(src_proc, buffer, length, crc);
+      }
+      recv_buffer.start += packet_length;
+
+      if (!processPacket(src_proc, tag, buffer, length))
+         return false;
+   }
+
+   if (recv_buffer.start == recv_buffer.end)
+   {
+      recv_buffer.start = 0;
+      recv_buffer.end = 0;
+   }
+   return true;
+}
+
+void SockTransport::wakeUpdateThread()
+{
+   UInt64 count = 1;
+   SInt32 err = ::write(m_wakeup_fd, &count, sizeof(count));
+   LOG_ASSERT_WARNING(err == sizeof(count), "Failed to wake up the update thread");
+}
+
+void SockTransport::splitBatch(Byte *batch, UInt32 length)
+{
+   // A batch is a sequence of regular packets: Length, Tag, Data
+   UInt32 offset = 0;
+   while (offset < length)
+   {
+      Packet *p = (Packet*) (batch + offset);
+      Byte *buffer = MessageBuffer::allocate(p->length);
+      memcpy(buffer, &p->data, p->length);
+      offset += sizeof(p->length) + sizeof(p->tag) + p->length;
+
+      insertInBufferList(p->tag, buffer);
    }
+   LOG_ASSERT_ERROR(offset == length, "Malformed batch: offset(%u), length(%u)", offset, length);
 }
 
-void SockTransport::insertInBufferList(SInt32 tag, Byte *buffer, Header* header)
+void SockTransport::insertInBufferList(SInt32 tag, Byte *buffer)
 {
    if (tag == GLOBAL_TAG)
       tag = m_num_lists - 1;
 
    LOG_ASSERT_ERROR(0 <= tag && tag < m_num_lists, "Unexpected tag value: %d", tag);
-   m_buffer_list_locks[tag].acquire();
-   m_buffer_lists[tag].push_back(buffer);
+   UInt32 list = tag * NUM_LANES + getLane(tag, buffer);
 
-#ifdef __CHECKSUM_ENABLED__
-   m_header_lists[tag].push_back(header);
-#endif // __CHECKSUM_ENABLED__
-   
+   m_buffer_list_locks[tag].acquire();
+   m_buffer_lists[list].push_back(buffer);
+   m_buffer_list_sizes[tag] ++;
    m_buffer_list_locks[tag].release();
    
    m_buffer_list_sems[tag].signal();
+
+   Transport::notifyArrival();
+}
+
+UInt32 SockTransport::getLane(SInt32 tag, const Byte *buffer)
+{
+   // The messages of the global node are not network packets
+   if (!m_priority_lanes_enabled || (tag == m_num_lists - 1))
+      return SYSTEM_LANE;
+
+   PacketType type;
+   memcpy(&type, buffer + offsetof(NetPacket, type), sizeof(type));
+   LOG_ASSERT_ERROR(0 <= type && type < NUM_PACKET_TYPES, "Unexpected packet type(%i)", type);
+
+   switch (g_type_to_static_network_map[type])
+   {
+   case STATIC_NETWORK_SYSTEM:
+      return SYSTEM_LANE;
+   case STATIC_NETWORK_MEMORY_1:
+   case STATIC_NETWORK_MEMORY_2:
+      return MEMORY_LANE;
+   default:
+      return USER_LANE;
+   }
+}
+
+UInt32 SockTransport::selectLane(SInt32 tag)
+{
+   buffer_list *lists = &m_buffer_lists[tag * NUM_LANES];
+
+   UInt32 lane = 0;
+   while (lists[lane].empty())
+      lane ++;
+
+   // Is a lower lane waiting behind it?
+   UInt32 lower_lane = lane + 1;
+   while ((lower_lane < NUM_LANES) && lists[lower_lane].empty())
+      lower_lane ++;
+
+   if (lower_lane == NUM_LANES)
+   {
+      m_lane_bypasses[tag] = 0;
+      return lane;
+   }
+   if (m_lane_bypasses[tag] >= m_starvation_limit)
+   {
+      m_lane_bypasses[tag] = 0;
+      return lower_lane;
+   }
+   m_lane_bypasses[tag] ++;
+   return lane;
 }
 
 void SockTransport::terminateUpdateThread()
@@ -254,17 +817,36 @@ SockTransport::~SockTransport()
 
    delete m_global_node;
 
+   if (m_batching_enabled)
+      flushBatches(false);
+
    terminateUpdateThread();
    delete m_update_thread;
 
+   for (SInt32 i = 0; i < m_num_procs; i++)
+      delete [] m_send_batches[i].buffer;
+   delete [] m_send_batches;
+
+   delete [] m_barrier_round_sems;
+
    delete [] m_buffer_list_sems;
+   delete [] m_buffer_list_sizes;
    delete [] m_buffer_list_locks;
 
-#ifdef __CHECKSUM_ENABLED__
-   delete [] m_header_lists;
-#endif // __CHECKSUM_ENABLED__
+   delete [] m_send_frame_counts;
+   delete [] m_recv_frame_counts;
 
    delete [] m_buffer_lists;
+   delete [] m_lane_bypasses;
+
+   if (m_epoll_enabled)
+   {
+      for (SInt32 i = 0; i < m_num_procs; i++)
+         delete [] m_recv_buffers[i].data;
+      delete [] m_recv_buffers;
+      ::close(m_wakeup_fd);
+      ::close(m_epoll_fd);
+   }
 
    for (SInt32 i = 0; i < m_num_procs; i++)
    {
@@ -272,6 +854,25 @@ SockTransport::~SockTransport()
       m_send_sockets[i].close();
    }
    m_server_socket.close();
+
+   if (m_shmem_enabled)
+   {
+      for (SInt32 i = 0; i < m_num_procs; i++)
+      {
+         m_shmem_send_channels[i].close();
+         m_shmem_recv_channels[i].close();
+      }
+      delete [] m_shmem_send_channels;
+      delete [] m_shmem_recv_channels;
+      m_shmem_barrier.close();
+   }
+
+   if (m_rdma_enabled)
+   {
+      for (SInt32 i = 0; i < m_num_procs; i++)
+         m_rdma_channels[i].close();
+      delete [] m_rdma_channels;
+   }
    
    delete [] m_recv_locks;
    delete [] m_recv_sockets;
@@ -286,7 +887,8 @@ Transport::Node* SockTransport::createNode(tile_id_t tile_id)
 
 void SockTransport::barrier()
 {
-   // We implement a barrier using a ring of messages. We are using a
+   // We implement a barrier using a ring of messages (or a dissemination
+   // barrier, see disseminationBarrier()). We are using a
    // single socket for the entire process, however, and it is
    // multiplexed between many tiles. So updates occur asynchronously
    // and possibly in other threads. That's what the semaphore takes
@@ -300,20 +902,68 @@ void SockTransport::barrier()
 
    LOG_PRINT("Entering transport barrier");
 
-   Socket &sock = m_send_sockets[(m_proc_index+1) % m_num_procs];
+   // When every process is on this host, a shared memory barrier
+   // avoids the two trips around the ring
+   if (m_shmem_barrier_enabled)
+   {
+      if (m_batching_enabled)
+         flushBatches(false);
+      m_shmem_barrier.wait();
+      LOG_PRINT("Exiting transport barrier");
+      return;
+   }
+
+   // Everything sent before the barrier must arrive before it
+   if (m_batching_enabled)
+      flushBatches(false);
+
+   if (m_barrier_type == DISSEMINATION_BARRIER)
+      disseminationBarrier();
+   else
+      ringBarrier();
+
+   LOG_PRINT("Exiting transport barrier");
+}
+
+void SockTransport::ringBarrier()
+{
+   SInt32 next_proc = (m_proc_index+1) % m_num_procs;
    SInt32 message[] = { sizeof(SInt32), BARRIER_TAG, 0 };
 
    if (m_proc_index != 0)
       m_barrier_sem.wait();
 
-   sock.send(message, sizeof(message));
+   m_send_locks[next_proc].acquire();
+   sendToProc(next_proc, message, sizeof(message));
+   m_send_locks[next_proc].release();
 
    m_barrier_sem.wait();
 
    if (m_proc_index != m_num_procs - 1)
-      sock.send(message, sizeof(message));
+   {
+      m_send_locks[next_proc].acquire();
+      sendToProc(next_proc, message, sizeof(message));
+      m_send_locks[next_proc].release();
+   }
+}
 
-   LOG_PRINT("Exiting transport barrier");
+void SockTransport::disseminationBarrier()
+{
+   // After round k, a process knows that the 2^(k+1) processes behind it
+   // have arrived. The messages of a round always come from the same
+   // process, in order, so a process already in the next barrier only
+   // adds to the count of the round semaphore.
+   for (SInt32 round = 0; round < m_num_barrier_rounds; round++)
+   {
+      SInt32 dest_proc = (m_proc_index + (1 << round)) % m_num_procs;
+      SInt32 message[] = { sizeof(SInt32), BARRIER_TAG, round };
+
+      m_send_locks[dest_proc].acquire();
+      sendToProc(dest_proc, message, sizeof(message));
+      m_send_locks[dest_proc].release();
+
+      m_barrier_round_sems[round].wait();
+   }
 }
 
 Transport::Node* SockTransport::getGlobalNode()
@@ -354,28 +1004,23 @@ Byte* SockTransport::SockNode::recv()
 
    tile_id_t tag = getTileId();
    tag = (tag == GLOBAL_TAG) ? m_transport->m_num_lists - 1 : tag;
+
+   // We are possibly about to block waiting for a reply, so do not
+   // let our own messages sit in a batch
+   if (m_transport->m_batching_enabled && !query())
+      m_transport->flushBatches(false);
    
    m_transport->m_buffer_list_sems[tag].wait();
 
    Lock &lock = m_transport->m_buffer_list_locks[tag];
    lock.acquire();
    
-   buffer_list &list = m_transport->m_buffer_lists[tag];
-   LOG_ASSERT_ERROR(!list.empty(), "Buffer list empty after waiting on semaphore.");
+   LOG_ASSERT_ERROR(m_transport->m_buffer_list_sizes[tag] > 0, "Buffer list empty after waiting on semaphore.");
+   UInt32 index = tag * NUM_LANES + m_transport->selectLane(tag);
+   buffer_list &list = m_transport->m_buffer_lists[index];
    Byte* buffer = list.front();
    list.pop_front();
-
-#ifdef __CHECKSUM_ENABLED__
-   std::list<Header*> &header_list = m_transport->m_header_lists[tag];
-   Header* header = header_list.front();
-   header_list.pop_front();
-   
-   LOG_ASSERT_ERROR(header->m_checksum == computeCheckSum(buffer, header->m_length),
-         "Checksum Error: computed checksum(%llu), received checksum(%llu), received length(%u)",
-         computeCheckSum(buffer, header->m_length), header->m_checksum, header->m_length);
-
-   delete header;
-#endif // __CHECKSUM_ENABLED__
+   m_transport->m_buffer_list_sizes[tag] --;
 
    lock.release();
 
@@ -384,16 +1029,22 @@ Byte* SockTransport::SockNode::recv()
    return buffer;
 }
 
+UInt32 SockTransport::SockNode::getQueueDepth()
+{
+   tile_id_t tag = getTileId();
+   tag = (tag == GLOBAL_TAG) ? m_transport->m_num_lists - 1 : tag;
+   return m_transport->m_buffer_list_sizes[tag];
+}
+
 bool SockTransport::SockNode::query()
 {
    tile_id_t tag = getTileId();
    tag = (tag == GLOBAL_TAG) ? m_transport->m_num_lists - 1 : tag;
 
-   buffer_list &list = m_transport->m_buffer_lists[tag];
    Lock &lock = m_transport->m_buffer_list_locks[tag];
 
    lock.acquire();
-   bool result = !list.empty();
+   bool result = (m_transport->m_buffer_list_sizes[tag] > 0);
    lock.release();
    return result;
 }
@@ -407,46 +1058,27 @@ void SockTransport::SockNode::send(SInt32 dest_proc,
    // (1) remote process, use sockets
    // (2) single process, put directly in buffer list
 
-#ifdef __CHECKSUM_ENABLED__
-   UInt64 checksum =  computeCheckSum((const Byte*) buffer, length);
-#endif // __CHECKSUM_ENABLED__
-
    if (dest_proc == m_transport->m_proc_index)
    {
-      Byte *buff_cpy = new Byte[length];
+      Byte *buff_cpy = MessageBuffer::allocate(length);
       memcpy(buff_cpy, buffer, length);
 
-#ifdef __CHECKSUM_ENABLED__
-      Header* header =  new Header(length, checksum);
-      m_transport->insertInBufferList(tag, buff_cpy, header);
-#else
       m_transport->insertInBufferList(tag, buff_cpy);
-#endif // __CHECKSUM_ENABLED__
    }
    else
    {
-#ifdef __CHECKSUM_ENABLED__
-      SInt32 pkt_len = sizeof(length) + sizeof(tag) + length + sizeof(checksum);
-#else
       SInt32 pkt_len = sizeof(length) + sizeof(tag) + length;
-#endif // __CHECKSUM_ENABLED__
 
       Byte *pkt_buff = new Byte[pkt_len];
 
-      // Length, Tag, Data, (Checksum)
+      // Length, Tag, Data
       Packet *p = (Packet*)pkt_buff;
       
       p->length = length;
       p->tag = tag;
       memcpy(&p->data, buffer, length);
 
-#ifdef __CHECKSUM_ENABLED__
-      memcpy(&p->data + length, &checksum, sizeof(checksum));
-#endif // __CHECKSUM_ENABLED__
-
-      m_transport->m_send_locks[dest_proc].acquire();
-      m_transport->m_send_sockets[dest_proc].send(pkt_buff, pkt_len);
-      m_transport->m_send_locks[dest_proc].release();
+      m_transport->sendPacket(dest_proc, pkt_buff, pkt_len);
 
       delete [] pkt_buff;
    }
@@ -454,6 +1086,112 @@ void SockTransport::SockNode::send(SInt32 dest_proc,
    LOG_PRINT("Message sent.");
 }
 
+void SockTransport::SockNode::sendBuffer(tile_id_t dest_tile,
+                                         Byte *buffer,
+                                         UInt32 length)
+{
+   int dest_proc = Config::getSingleton()->getProcessNumForTile(dest_tile);
+
+   if (dest_proc == m_transport->m_proc_index)
+   {
+      // Single process, hand the buffer over without copying
+      m_transport->insertInBufferList(dest_tile, buffer);
+   }
+   else
+   {
+      send(dest_proc, dest_tile, buffer, length);
+      MessageBuffer::release(buffer);
+   }
+}
+
+void SockTransport::sendPacket(SInt32 dest_proc, const Byte *pkt_buff, UInt32 pkt_len)
+{
+   m_send_locks[dest_proc].acquire();
+
+   if (!m_batching_enabled)
+   {
+      sendFrame(dest_proc, pkt_buff, pkt_len);
+   }
+   else
+   {
+      Batch &batch = m_send_batches[dest_proc];
+
+      if (batch.length + pkt_len > m_batch_size)
+         flushBatch(dest_proc);
+
+      if (pkt_len > m_batch_size)
+      {
+         // Too large to be batched
+         sendFrame(dest_proc, pkt_buff, pkt_len);
+      }
+      else
+      {
+         if (batch.length == 0)
+         {
+            batch.start_time = getTime();
+            // The update thread flushes the batch once it is stale
+            if (m_epoll_enabled)
+               wakeUpdateThread();
+         }
+         memcpy(batch.buffer + sizeof(UInt32) + sizeof(SInt32) + batch.length, pkt_buff, pkt_len);
+         batch.length += pkt_len;
+
+         if (batch.length >= m_batch_size)
+            flushBatch(dest_proc);
+      }
+   }
+
+   m_send_locks[dest_proc].release();
+}
+
+void SockTransport::flushBatch(SInt32 dest_proc)
+{
+   // Must be called with m_send_locks[dest_proc] held
+   Batch &batch = m_send_batches[dest_proc];
+   if (batch.length == 0)
+      return;
+
+   Packet *p = (Packet*) batch.buffer;
+   p->length = batch.length;
+   p->tag = BATCH_TAG;
+   sendFrame(dest_proc, batch.buffer, sizeof(UInt32) + sizeof(SInt32) + batch.length);
+
+   batch.length = 0;
+}
+
+void SockTransport::sendFrame(SInt32 dest_proc, const Byte *frame, UInt32 frame_len)
+{
+   // Must be called with m_send_locks[dest_proc] held
+   sendToProc(dest_proc, frame, frame_len);
+
+   if (isCheckedFrame(m_send_frame_counts[dest_proc]++))
+   {
+      const UInt32 header_length = sizeof(UInt32) + sizeof(SInt32);
+      UInt32 crc = computeCrc32c(frame + header_length, frame_len - header_length);
+      sendToProc(dest_proc, &crc, sizeof(crc));
+   }
+}
+
+void SockTransport::flushBatches(bool stale_only)
+{
+   UInt64 curr_time = stale_only ? getTime() : 0;
+
+   for (SInt32 proc = 0; proc < m_num_procs; proc++)
+   {
+      Batch &batch = m_send_batches[proc];
+
+      // Unlocked peek, re-checked by flushBatch() under the lock
+      if (batch.length == 0)
+         continue;
+      if (stale_only && (curr_time < batch.start_time + m_batch_timeout))
+         continue;
+
+      m_send_locks[proc].acquire();
+      flushBatch(proc);
+      m_send_locks[proc].release();
+   }
+}
+
 // -- Socket
 
 SockTransport::Socket::Socket()
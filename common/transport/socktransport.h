@@ -4,13 +4,21 @@
 #include "transport.h"
 #include "thread.h"
 #include "semaphore.h"
+#include "shmem_channel.h"
+#include "shmem_barrier.h"
+#include "rdma_channel.h"
 
 #include <list>
+#include <string>
+#include <vector>
 
 class SockTransport : public Transport
 {
 public:
-   SockTransport();
+   // With shmem_enabled, processes on the same host talk through shared
+   // memory channels instead of TCP sockets; with rdma_enabled, all the
+   // processes talk through RDMA channels, set up over the sockets
+   SockTransport(bool shmem_enabled = false, bool rdma_enabled = false);
    ~SockTransport();
    
    class SockNode : public Node
@@ -24,6 +32,10 @@ public:
       Byte* recv();
       bool query();
 
+      void sendBuffer(tile_id_t dest_tile, Byte *buffer, UInt32 length);
+
+      UInt32 getQueueDepth();
+
    private:
       void send(SInt32 dest_proc, UInt32 tag, const void *buffer, UInt32 length);
 
@@ -43,24 +55,81 @@ private:
       Byte data;
    } __attribute__((__packed__));
 
-   struct Header
+   // Messages to a remote process are (optionally) coalesced into a
+   // batch that is written with a single send(). The batch itself is
+   // framed like any other packet, with BATCH_TAG as its tag.
+   struct Batch
    {
-      Header(UInt32 length, UInt64 checksum):
-         m_length(length), m_checksum(checksum) {}
+      Byte *buffer;
+      UInt32 length;
+      UInt64 start_time;
+   };
 
-      UInt32 m_length;
-      UInt64 m_checksum;
+   // Bytes read from a socket by the epoll receiver, in large chunks.
+   // Complete packets are parsed out of [start, end), a partial one
+   // stays there until the rest arrives.
+   struct RecvBuffer
+   {
+      Byte *data;
+      UInt32 capacity;
+      UInt32 start;
+      UInt32 end;
    };
-   
+
    void getProcInfo();
+   void getProcAddresses(std::vector<std::string>& proc_addrs);
    void initSockets();
+   void createShmemChannels(const std::vector<std::string>& proc_addrs);
+   void openShmemChannels();
+   void initRdmaChannels();
+   // The messages from the process come through a channel, not its socket
+   bool isChannelProc(SInt32 proc);
+   std::string getShmemName(SInt32 src_proc, SInt32 dest_proc);
    void initBufferLists();
-   void insertInBufferList(SInt32 tag, Byte *buffer, Header* header = NULL);
+   void initBatches();
+   void insertInBufferList(SInt32 tag, Byte *buffer);
+   // Priority lane of a packet received for a tile
+   UInt32 getLane(SInt32 tag, const Byte *buffer);
+   // Lane to pop from, must be called with the lock of the list held
+   UInt32 selectLane(SInt32 tag);
+   void splitBatch(Byte *batch, UInt32 length);
+
+   // Raw byte stream to/from a process over a socket or shared memory.
+   // sendToProc() must be called with the destination's send lock held.
+   void sendToProc(SInt32 dest_proc, const void *buffer, UInt32 length);
+   bool recvFromProc(SInt32 src_proc, void *buffer, UInt32 length, bool block);
+
+   void sendPacket(SInt32 dest_proc, const Byte *pkt_buff, UInt32 pkt_len);
+   // A packet or a batch, followed by its CRC32C when it is checked
+   void sendFrame(SInt32 dest_proc, const Byte *frame, UInt32 frame_len);
+   void flushBatch(SInt32 dest_proc);
+   void flushBatches(bool stale_only);
 
    static void updateThreadFunc(void *vp);
    void updateBufferLists();
+   // false once the terminate message of this process is received
+   bool updateBufferList(SInt32 src_proc);
+   bool processPacket(SInt32 src_proc, SInt32 tag, Byte *buffer, UInt32 length);
    void terminateUpdateThread();
 
+   // Event-driven receiver ([transport/socket] epoll): the update thread
+   // sleeps in epoll_wait() on the sockets instead of polling them
+   void initEpoll();
+   void initBarrier();
+   void ringBarrier();
+   void disseminationBarrier();
+   void updateBufferListsEpoll();
+   bool readSocket(SInt32 src_proc);
+   bool parseRecvBuffer(SInt32 src_proc);
+   void wakeUpdateThread();
+
+   // Integrity mode ([transport/socket] integrity)
+   void initIntegrity();
+   static bool isDataTag(SInt32 tag);
+   // Whether the data frame with this index on a stream carries a CRC32C
+   bool isCheckedFrame(UInt64 frame_index);
+   void checkFrame(SInt32 src_proc, const Byte *buffer, UInt32 length, UInt32 crc);
+
    class Socket
    {
    public:
@@ -79,6 +148,8 @@ private:
 
       void close();
 
+      SInt32 getFd() const { return m_socket; }
+
    private:
       Socket(SInt32);
 
@@ -96,6 +167,13 @@ private:
    static const SInt32 GLOBAL_TAG = -1;
    static const SInt32 BARRIER_TAG = -2;
    static const SInt32 TERMINATE_TAG = -3;
+   static const SInt32 BATCH_TAG = -4;
+
+   static const UInt32 DEFAULT_BATCH_SIZE = 16384;
+   static const UInt32 DEFAULT_BATCH_TIMEOUT = 50;
+   static const UInt32 DEFAULT_SHMEM_CHANNEL_SIZE = 1 << 20;
+   static const UInt32 DEFAULT_RECV_BUFFER_SIZE = 1 << 16;
+   static const UInt32 DEFAULT_RDMA_CHANNEL_SIZE = 1 << 20;
 
    Node *m_global_node;
 
@@ -103,7 +181,20 @@ private:
    SInt32 m_num_procs;
    SInt32 m_proc_index;
 
+   // Transport barrier ([transport] barrier): a token twice around the
+   // ring of processes, O(P) latencies, or a dissemination barrier, where
+   // in round k every process signals the one 2^k ahead and waits for the
+   // one 2^k behind, O(log P) latencies
+   enum BarrierType
+   {
+      RING_BARRIER,
+      DISSEMINATION_BARRIER
+   };
+   BarrierType m_barrier_type;
    Semaphore m_barrier_sem;
+   // Dissemination barrier: one per round, signaled by the round's source
+   SInt32 m_num_barrier_rounds;
+   Semaphore *m_barrier_round_sems;
 
    Socket m_server_socket;
    Lock *m_recv_locks;
@@ -114,13 +205,78 @@ private:
    Thread *m_update_thread;
    UpdateThreadState m_update_thread_state;
 
+   // Traffic classes ([transport] priority_lanes): the messages of a
+   // node are queued by the static network of their packet type, and
+   // received from the system lane first, then the user one (MCP and
+   // sync requests) and the memory one last
+   enum Lane
+   {
+      SYSTEM_LANE = 0,
+      USER_LANE,
+      MEMORY_LANE,
+      NUM_LANES
+   };
+
    typedef std::list<Byte*> buffer_list;
    SInt32 m_num_lists;
+   // Indexed by list * NUM_LANES + lane
    buffer_list *m_buffer_lists;
-   std::list<Header*> *m_header_lists;
+
+   bool m_priority_lanes_enabled;
+   // A waiting lower lane is served after this many messages bypassed it
+   UInt32 m_starvation_limit;
+   // Per list, written under its lock
+   UInt32 *m_lane_bypasses;
 
    Lock *m_buffer_list_locks;
+   // Sizes of the buffer lists, written under their locks
+   volatile UInt32 *m_buffer_list_sizes;
    Semaphore *m_buffer_list_sems;
+
+   bool m_batching_enabled;
+   // Flush a batch once it holds this many bytes
+   UInt32 m_batch_size;
+   // or once its first message has waited this long (in microseconds)
+   UInt64 m_batch_timeout;
+   // Batches are protected by m_send_locks
+   Batch *m_send_batches;
+
+   bool m_epoll_enabled;
+   SInt32 m_epoll_fd;
+   // eventfd that wakes the update thread when a batch is started
+   SInt32 m_wakeup_fd;
+   // Read by the update thread only
+   RecvBuffer *m_recv_buffers;
+
+   bool m_shmem_enabled;
+   // Processes on the same host as this one
+   std::vector<bool> m_local_procs;
+   ShmemChannel *m_shmem_send_channels;
+   ShmemChannel *m_shmem_recv_channels;
+   // Used when all processes are on the same host
+   bool m_shmem_barrier_enabled;
+   ShmemBarrier m_shmem_barrier;
+
+   bool m_rdma_enabled;
+   RdmaChannel *m_rdma_channels;
+
+   // The data frames (packets and batches, not the barrier and terminate
+   // messages) are followed by the CRC32C of their data: none, one in
+   // 'integrity_sample_rate' of each stream, or all of them. Both ends
+   // count the data frames of a stream, which is ordered, so the sampled
+   // ones need no flag.
+   enum IntegrityMode
+   {
+      INTEGRITY_OFF,
+      INTEGRITY_SAMPLED,
+      INTEGRITY_FULL
+   };
+   IntegrityMode m_integrity_mode;
+   UInt32 m_integrity_sample_rate;
+   // Per destination, protected by m_send_locks
+   UInt64 *m_send_frame_counts;
+   // Per source, written by the update thread under m_recv_locks
+   UInt64 *m_recv_frame_counts;
 };
 
 #endif // SOCK_TRANSPORT_H
@@ -6,18 +6,28 @@
 #include "smtransport.h"
 //#include "mpitransport.h"
 #include "socktransport.h"
+#include "ringtransport.h"
+#include "message_buffer.h"
 
+#include "simulator.h"
 #include "config.h"
 #include "log.h"
 
 // -- Transport -- //
 
 Transport *Transport::m_singleton;
+Transport::ArrivalCallback Transport::m_arrival_callback;
+void *Transport::m_arrival_callback_arg;
 
 Transport::Transport()
 {
 }
 
+Transport::~Transport()
+{
+   MessageBuffer::releasePool();
+}
+
 Transport* Transport::create()
 {
    // dynamically choose the transport based on number of processes
@@ -25,8 +35,22 @@ Transport* Transport::create()
 
    assert(m_singleton == NULL);
 
-   if (true)
+   MessageBuffer::allocatePool();
+
+   std::string type_str = Sim()->getCfg()->getString("transport/type", "socket");
+   Type type = parseType(type_str);
+
+   if (type == SOCKET)
       m_singleton = new SockTransport();
+
+   else if (type == RING)
+      m_singleton = new RingTransport();
+
+   else if (type == SHMEM)
+      m_singleton = new SockTransport(true);
+
+   else if (type == RDMA)
+      m_singleton = new SockTransport(false, true);
    
    // else if (Config::getSingleton()->getProcessCount() == 1)
    //    m_singleton = new SmTransport();
@@ -35,16 +59,40 @@ Transport* Transport::create()
    //    m_singleton = new MpiTransport();
    
    else
-      LOG_PRINT_ERROR("Negative no. processes ?!");
+      LOG_PRINT_ERROR("Unrecognized transport type: %u", type);
 
    return m_singleton;
 }
 
+Transport::Type Transport::parseType(std::string type)
+{
+   if (type == "socket")
+      return SOCKET;
+   else if (type == "ring")
+      return RING;
+   else if (type == "shmem")
+      return SHMEM;
+   else if (type == "rdma")
+      return RDMA;
+   else
+   {
+      LOG_PRINT_ERROR("Unrecognized transport type: %s", type.c_str());
+      return NUM_TYPES;
+   }
+}
+
 Transport* Transport::getSingleton()
 {
    return m_singleton;
 }
 
+void Transport::setArrivalCallback(ArrivalCallback callback, void *arg)
+{
+   m_arrival_callback_arg = arg;
+   __sync_synchronize();
+   m_arrival_callback = callback;
+}
+
 // -- Node -- //
 
 Transport::Node::Node(tile_id_t tile_id)
@@ -56,3 +104,9 @@ tile_id_t Transport::Node::getTileId()
 {
    return m_tile_id;
 }
+
+void Transport::Node::sendBuffer(tile_id_t dest, Byte *buffer, UInt32 length)
+{
+   send(dest, buffer, length);
+   MessageBuffer::release(buffer);
+}
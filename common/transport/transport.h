@@ -4,11 +4,21 @@
 #include "fixed_types.h"
 
 #include <map>
+#include <string>
 
 class Transport
 {
 public:
-   virtual ~Transport() { };
+   virtual ~Transport();
+
+   enum Type
+   {
+      SOCKET = 0,
+      RING,
+      SHMEM,
+      RDMA,
+      NUM_TYPES
+   };
 
    class Node
    {
@@ -20,6 +30,14 @@ public:
       virtual Byte* recv() = 0;
       virtual bool query() = 0;
 
+      // Zero-copy send: hands one reference of a MessageBuffer to the
+      // transport. The default implementation copies and releases it.
+      virtual void sendBuffer(tile_id_t dest, Byte *buffer, UInt32 length);
+
+      // Messages waiting to be received, read without a lock (for
+      // monitoring, the value may be slightly stale)
+      virtual UInt32 getQueueDepth() { return 0; }
+
    protected:
       tile_id_t getTileId();
       Node(tile_id_t tile_id);
@@ -36,11 +54,28 @@ public:
    virtual void barrier() = 0;
    virtual Node* getGlobalNode() = 0; // for communication not linked to a tile
 
+   // Called by the transports once a message is queued for one of the
+   // nodes of the process (and the queue lock is released), so that the
+   // threads that poll many nodes (the sim thread pool) can sleep until
+   // there is work. There is no callback unless one is set
+   typedef void (*ArrivalCallback)(void *arg);
+   static void setArrivalCallback(ArrivalCallback callback, void *arg);
+   static void notifyArrival()
+   {
+      if (m_arrival_callback)
+         m_arrival_callback(m_arrival_callback_arg);
+   }
+
 protected:
    Transport();
 
 private:
+   static Type parseType(std::string type);
+
    static Transport *m_singleton;
+
+   static ArrivalCallback m_arrival_callback;
+   static void *m_arrival_callback_arg;
 };
 
 #endif // TRANSPORT_H
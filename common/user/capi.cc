@@ -5,6 +5,10 @@
 #include "carbon_user.h"
 #include "log.h"
 
+#include <vector>
+#include <cstring>
+using std::vector;
+
 CAPI_return_t CAPI_rank(int *tile_id)
 {
    *tile_id = CarbonGetTileId();
@@ -110,3 +114,251 @@ CAPI_return_t CAPI_message_receive_w_ex(CAPI_endpoint_t sender,
 
    return core ? core->coreRecvW(sending_tile, receiving_tile, buffer, size, net_type) : CAPI_ReceiverNotInitialized;
 }
+
+CAPI_return_t CAPI_message_receive_nb_ex(CAPI_endpoint_t sender, 
+      CAPI_endpoint_t receiver,
+      char *buffer, 
+      int size,
+      carbon_network_t net_type,
+      int *received)
+{
+   Core *core = Sim()->getTileManager()->getCurrentCore();
+
+   LOG_PRINT("SimRecvNB - sender: %d, recv: %d, size: %d", sender, receiver, size);
+
+   *received = 0;
+
+   tile_id_t sending_tile = CAPI_ENDPOINT_ANY;
+   if (sender != CAPI_ENDPOINT_ANY)
+      sending_tile = Config::getSingleton()->getTileFromCommId(sender);
+   
+   tile_id_t receiving_tile = Config::getSingleton()->getTileFromCommId(receiver);
+
+   if(sending_tile == INVALID_TILE_ID)
+       return CAPI_SenderNotInitialized;
+   if(receiving_tile == INVALID_TILE_ID)
+       return CAPI_ReceiverNotInitialized;
+   if (!core)
+       return CAPI_ReceiverNotInitialized;
+
+   bool got_message = false;
+   CAPI_return_t ret = core->coreRecvNB(sending_tile, receiving_tile, buffer, size, net_type, got_message);
+   *received = got_message ? 1 : 0;
+   return ret;
+}
+
+// -- Non-blocking messages -- //
+
+CAPI_return_t CAPI_message_isend(CAPI_endpoint_t sender,
+      CAPI_endpoint_t receiver,
+      char *buffer,
+      int size,
+      carbon_network_t net_type,
+      CAPI_request_t *request)
+{
+   request->is_receive = 0;
+   request->sender = sender;
+   request->receiver = receiver;
+   request->buffer = buffer;
+   request->size = size;
+   request->net_type = net_type;
+   request->complete = 1;
+
+   return CAPI_message_send_w_ex(sender, receiver, buffer, size, net_type);
+}
+
+CAPI_return_t CAPI_message_irecv(CAPI_endpoint_t sender,
+      CAPI_endpoint_t receiver,
+      char *buffer,
+      int size,
+      carbon_network_t net_type,
+      CAPI_request_t *request)
+{
+   request->is_receive = 1;
+   request->sender = sender;
+   request->receiver = receiver;
+   request->buffer = buffer;
+   request->size = size;
+   request->net_type = net_type;
+   request->complete = 0;
+
+   return CAPI_message_receive_nb_ex(sender, receiver, buffer, size, net_type, &request->complete);
+}
+
+CAPI_return_t CAPI_wait(CAPI_request_t *request)
+{
+   if (request->complete)
+      return CAPI_StatusOk;
+
+   CAPI_return_t ret = CAPI_message_receive_w_ex(request->sender, request->receiver,
+                                                 request->buffer, request->size, request->net_type);
+   request->complete = 1;
+   return ret;
+}
+
+CAPI_return_t CAPI_test(CAPI_request_t *request, int *complete)
+{
+   CAPI_return_t ret = CAPI_StatusOk;
+   if (!request->complete)
+   {
+      ret = CAPI_message_receive_nb_ex(request->sender, request->receiver,
+                                       request->buffer, request->size, request->net_type, &request->complete);
+   }
+   *complete = request->complete;
+   return ret;
+}
+
+// -- Collectives -- //
+
+template <class T>
+static void reduceElements(T *accum, const T *operand, int count, CAPI_reduce_op_t op)
+{
+   for (int i = 0; i < count; i++)
+   {
+      switch (op)
+      {
+      case CAPI_SUM:
+         accum[i] += operand[i];
+         break;
+      case CAPI_MIN:
+         if (operand[i] < accum[i])
+            accum[i] = operand[i];
+         break;
+      case CAPI_MAX:
+         if (operand[i] > accum[i])
+            accum[i] = operand[i];
+         break;
+      default:
+         LOG_PRINT_ERROR("Unrecognized CAPI reduce op(%i)", op);
+         break;
+      }
+   }
+}
+
+static int getDatatypeSize(CAPI_datatype_t datatype)
+{
+   switch (datatype)
+   {
+   case CAPI_INT:
+      return sizeof(int);
+   case CAPI_DOUBLE:
+      return sizeof(double);
+   default:
+      return 0;
+   }
+}
+
+CAPI_return_t CAPI_broadcast(CAPI_endpoint_t root,
+      CAPI_endpoint_t endpoint,
+      int num_endpoints,
+      char *buffer,
+      int size,
+      carbon_network_t net_type)
+{
+   if ((root < 0) || (root >= num_endpoints) || (endpoint < 0) || (endpoint >= num_endpoints))
+      return CAPI_InvalidArgument;
+
+   // Rank relative to the root: the endpoint receives from the one that
+   // differs in its lowest set bit, then forwards to the ones below it
+   int rel_rank = (endpoint - root + num_endpoints) % num_endpoints;
+   int mask = 1;
+   while (mask < num_endpoints)
+   {
+      if (rel_rank & mask)
+      {
+         CAPI_endpoint_t parent = (rel_rank - mask + root) % num_endpoints;
+         CAPI_return_t ret = CAPI_message_receive_w_ex(parent, endpoint, buffer, size, net_type);
+         if (ret != CAPI_StatusOk)
+            return ret;
+         break;
+      }
+      mask <<= 1;
+   }
+
+   for (mask >>= 1; mask > 0; mask >>= 1)
+   {
+      if (rel_rank + mask < num_endpoints)
+      {
+         CAPI_endpoint_t child = (rel_rank + mask + root) % num_endpoints;
+         CAPI_return_t ret = CAPI_message_send_w_ex(endpoint, child, buffer, size, net_type);
+         if (ret != CAPI_StatusOk)
+            return ret;
+      }
+   }
+   return CAPI_StatusOk;
+}
+
+CAPI_return_t CAPI_reduce(CAPI_endpoint_t root,
+      CAPI_endpoint_t endpoint,
+      int num_endpoints,
+      char *send_buffer,
+      char *recv_buffer,
+      int count,
+      CAPI_datatype_t datatype,
+      CAPI_reduce_op_t op,
+      carbon_network_t net_type)
+{
+   int datatype_size = getDatatypeSize(datatype);
+   if ((datatype_size == 0) || (count <= 0) ||
+       (root < 0) || (root >= num_endpoints) || (endpoint < 0) || (endpoint >= num_endpoints))
+      return CAPI_InvalidArgument;
+
+   int size = count * datatype_size;
+   vector<char> accum(send_buffer, send_buffer + size);
+   vector<char> operand(size);
+
+   // Mirror of the broadcast: combine the partial results of the children,
+   // then send them up to the parent
+   int rel_rank = (endpoint - root + num_endpoints) % num_endpoints;
+   for (int mask = 1; mask < num_endpoints; mask <<= 1)
+   {
+      if (rel_rank & mask)
+      {
+         CAPI_endpoint_t parent = (rel_rank - mask + root) % num_endpoints;
+         return CAPI_message_send_w_ex(endpoint, parent, &accum[0], size, net_type);
+      }
+      if (rel_rank + mask < num_endpoints)
+      {
+         CAPI_endpoint_t child = (rel_rank + mask + root) % num_endpoints;
+         CAPI_return_t ret = CAPI_message_receive_w_ex(child, endpoint, &operand[0], size, net_type);
+         if (ret != CAPI_StatusOk)
+            return ret;
+         if (datatype == CAPI_INT)
+            reduceElements((int*) &accum[0], (const int*) &operand[0], count, op);
+         else
+            reduceElements((double*) &accum[0], (const double*) &operand[0], count, op);
+      }
+   }
+
+   memcpy(recv_buffer, &accum[0], size);
+   return CAPI_StatusOk;
+}
+
+CAPI_return_t CAPI_alltoall(CAPI_endpoint_t endpoint,
+      int num_endpoints,
+      char *send_buffer,
+      char *recv_buffer,
+      int size,
+      carbon_network_t net_type)
+{
+   if ((endpoint < 0) || (endpoint >= num_endpoints))
+      return CAPI_InvalidArgument;
+
+   memcpy(recv_buffer + endpoint * size, send_buffer + endpoint * size, size);
+
+   // Step i sends to the endpoint i ahead and receives from the one i
+   // behind, so every endpoint sends and receives one block per step. The
+   // sends are buffered by the network and do not wait for the receiver.
+   for (int i = 1; i < num_endpoints; i++)
+   {
+      CAPI_endpoint_t dst = (endpoint + i) % num_endpoints;
+      CAPI_endpoint_t src = (endpoint - i + num_endpoints) % num_endpoints;
+      CAPI_return_t ret = CAPI_message_send_w_ex(endpoint, dst, send_buffer + dst * size, size, net_type);
+      if (ret != CAPI_StatusOk)
+         return ret;
+      ret = CAPI_message_receive_w_ex(src, endpoint, recv_buffer + src * size, size, net_type);
+      if (ret != CAPI_StatusOk)
+         return ret;
+   }
+   return CAPI_StatusOk;
+}
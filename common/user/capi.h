@@ -16,6 +16,29 @@ typedef enum {
 typedef int CAPI_return_t;
 typedef int CAPI_endpoint_t;
 
+// A non-blocking send or receive, owned by the caller until CAPI_wait()
+// or CAPI_test() completes it
+typedef struct {
+   int is_receive;
+   int complete;
+   CAPI_endpoint_t sender;
+   CAPI_endpoint_t receiver;
+   char *buffer;
+   int size;
+   carbon_network_t net_type;
+} CAPI_request_t;
+
+typedef enum {
+   CAPI_INT = 0,
+   CAPI_DOUBLE
+} CAPI_datatype_t;
+
+typedef enum {
+   CAPI_SUM = 0,
+   CAPI_MIN,
+   CAPI_MAX
+} CAPI_reduce_op_t;
+
 CAPI_return_t CAPI_Initialize(int rank);
 CAPI_return_t CAPI_rank(int *rank);
 CAPI_return_t CAPI_message_send_w(CAPI_endpoint_t send_endpoint, CAPI_endpoint_t receive_endpoint, char * buffer, int size);
@@ -23,11 +46,31 @@ CAPI_return_t CAPI_message_receive_w(CAPI_endpoint_t send_endpoint, CAPI_endpoin
 
 CAPI_return_t CAPI_message_send_w_ex(CAPI_endpoint_t send_endpoint, CAPI_endpoint_t receive_endpoint, char * buffer, int size, carbon_network_t net_type);
 CAPI_return_t CAPI_message_receive_w_ex(CAPI_endpoint_t send_endpoint, CAPI_endpoint_t receive_endpoint, char * buffer, int size, carbon_network_t net_type);
+// Returns at once, '*received' tells whether the message had arrived
+CAPI_return_t CAPI_message_receive_nb_ex(CAPI_endpoint_t send_endpoint, CAPI_endpoint_t receive_endpoint, char * buffer, int size, carbon_network_t net_type, int *received);
+
+// Non-blocking messages. The messages are buffered by the network, so a send
+// completes when it is posted; a receive completes in CAPI_wait() or
+// CAPI_test(), and its buffer must not be used before.
+CAPI_return_t CAPI_message_isend(CAPI_endpoint_t send_endpoint, CAPI_endpoint_t receive_endpoint, char * buffer, int size, carbon_network_t net_type, CAPI_request_t *request);
+CAPI_return_t CAPI_message_irecv(CAPI_endpoint_t send_endpoint, CAPI_endpoint_t receive_endpoint, char * buffer, int size, carbon_network_t net_type, CAPI_request_t *request);
+CAPI_return_t CAPI_wait(CAPI_request_t *request);
+CAPI_return_t CAPI_test(CAPI_request_t *request, int *complete);
+
+// Collectives among the endpoints 0 .. num_endpoints-1, called by all of
+// them. Broadcast and reduce use binomial trees rooted at 'root' (log2(N)
+// steps, no endpoint sends more than log2(N) messages); all-to-all sends
+// the 'size'-byte block i of the send buffer of every endpoint to endpoint i,
+// in N-1 pairwise steps.
+CAPI_return_t CAPI_broadcast(CAPI_endpoint_t root, CAPI_endpoint_t endpoint, int num_endpoints, char * buffer, int size, carbon_network_t net_type);
+CAPI_return_t CAPI_reduce(CAPI_endpoint_t root, CAPI_endpoint_t endpoint, int num_endpoints, char * send_buffer, char * recv_buffer, int count, CAPI_datatype_t datatype, CAPI_reduce_op_t op, carbon_network_t net_type);
+CAPI_return_t CAPI_alltoall(CAPI_endpoint_t endpoint, int num_endpoints, char * send_buffer, char * recv_buffer, int size, carbon_network_t net_type);
 
 enum {
    CAPI_StatusOk,
    CAPI_SenderNotInitialized,
-   CAPI_ReceiverNotInitialized
+   CAPI_ReceiverNotInitialized,
+   CAPI_InvalidArgument
 };
 
 #ifdef __cplusplus
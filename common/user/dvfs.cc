@@ -3,6 +3,9 @@
 #include "tile_manager.h"
 #include "tile.h"
 #include "core_model.h"
+#include "statistics_manager.h"
+#include "thermal_model.h"
+#include "log.h"
 #include "fxsupport.h"
 
 void CarbonGetCoreFrequency(volatile float* frequency)
@@ -26,3 +29,15 @@ void CarbonSetCoreFrequency(volatile float* frequency)
    tile->updateInternalVariablesOnFrequencyChange(*frequency);
    Config::getSingleton()->setCoreFrequency(tile->getCore()->getId(), *frequency);
 }
+
+void CarbonGetCoreTemperature(volatile float* temperature)
+{
+   // Floating Point Save/Restore
+   FloatingPointHandler floating_point_handler;
+
+   StatisticsManager* statistics_manager = Sim()->getStatisticsManager();
+   ThermalModel* thermal_model = statistics_manager ? statistics_manager->getThermalModel() : NULL;
+   LOG_ASSERT_ERROR(thermal_model, "CarbonGetCoreTemperature needs the temperature statistic of [statistics_trace]");
+
+   *temperature = thermal_model->getTemperature(Sim()->getTileManager()->getCurrentTileID());
+}
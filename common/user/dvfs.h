@@ -8,6 +8,9 @@ extern "C"
 
 void CarbonGetCoreFrequency(volatile float* frequency);
 void CarbonSetCoreFrequency(volatile float* frequency);
+// Temperature (in C) of the tile, at the last sample of the statistics
+// trace (needs the 'temperature' statistic)
+void CarbonGetCoreTemperature(volatile float* temperature);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,26 @@
+#include "stats_replay.h"
+#include "simulator.h"
+#include "stats_registry.h"
+#include "config.h"
+#include "log.h"
+
+void CarbonReplayStats()
+{
+   LOG_ASSERT_ERROR(Config::getSingleton()->getProcessCount() == 1, "Stats replay requires a single process");
+   LOG_ASSERT_ERROR(Sim()->getStatsRegistry(), "Stats replay requires [general] stats_file");
+
+   string filename;
+   try
+   {
+      filename = Sim()->getCfg()->getString("stats_replay/file", "");
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read stats_replay/file from the cfg file");
+   }
+   LOG_ASSERT_ERROR(filename != "", "Set [stats_replay] file to the stats file of the recorded run");
+
+   // The models stay disabled, the counters are the ones of the recorded run
+   UInt32 num_loaded = Sim()->getStatsRegistry()->load(filename);
+   LOG_PRINT("Loaded %u counters from the stats file(%s)", num_loaded, filename.c_str());
+}
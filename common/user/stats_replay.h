@@ -0,0 +1,13 @@
+#ifndef STATS_REPLAY_H
+#define STATS_REPLAY_H
+
+// Loads the counters of the tiles from the stats file of an earlier run
+// ([stats_replay] file), without simulating anything. Called by the main
+// thread after CarbonStartSim(): CarbonStopSim() then outputs the summary of
+// that run, with the power and area of the power parameters of this one
+// (tools/power_sweep). The tiles and timing parameters must be those of the
+// recorded run and [general] stats_file must be set, so the models register
+// their counters
+void CarbonReplayStats();
+
+#endif // STATS_REPLAY_H
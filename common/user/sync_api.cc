@@ -10,57 +10,75 @@
 #include "config_file.hpp"
 #include "carbon_user.h"
 #include "thread_support_private.h"
+#include "instruction_trace.h"
+
+// The instruction stream trace (trace_record/enabled) has the sync events
+static void recordSyncEvent(Core* core, InstructionTrace::SyncType sync_type, SInt32 id, SInt32 argument = 0)
+{
+   InstructionTraceWriter* trace_writer = core->getPerformanceModel()->getTraceWriter();
+   if (trace_writer)
+      trace_writer->writeSync(sync_type, id, argument);
+}
 
 void CarbonMutexInit(carbon_mutex_t *mux)
 {
    Core *core = Sim()->getTileManager()->getCurrentCore();
    core->getSyncClient()->mutexInit(mux);
+   recordSyncEvent(core, InstructionTrace::MUTEX_INIT, *mux);
 }
 
 void CarbonMutexLock(carbon_mutex_t *mux)
 {
    Core *core = Sim()->getTileManager()->getCurrentCore();
    core->getSyncClient()->mutexLock(mux);
+   recordSyncEvent(core, InstructionTrace::MUTEX_LOCK, *mux);
 }
 
 void CarbonMutexUnlock(carbon_mutex_t *mux)
 {
    Core *core = Sim()->getTileManager()->getCurrentCore();
    core->getSyncClient()->mutexUnlock(mux);
+   recordSyncEvent(core, InstructionTrace::MUTEX_UNLOCK, *mux);
 }
 
 void CarbonCondInit(carbon_cond_t *cond)
 {
    Core *core = Sim()->getTileManager()->getCurrentCore();
    core->getSyncClient()->condInit(cond);
+   recordSyncEvent(core, InstructionTrace::COND_INIT, *cond);
 }
 
 void CarbonCondWait(carbon_cond_t *cond, carbon_mutex_t *mux)
 {
    Core *core = Sim()->getTileManager()->getCurrentCore();
    core->getSyncClient()->condWait(cond, mux);
+   recordSyncEvent(core, InstructionTrace::COND_WAIT, *cond, *mux);
 }
 
 void CarbonCondSignal(carbon_cond_t *cond)
 {
    Core *core = Sim()->getTileManager()->getCurrentCore();
    core->getSyncClient()->condSignal(cond);
+   recordSyncEvent(core, InstructionTrace::COND_SIGNAL, *cond);
 }
 
 void CarbonCondBroadcast(carbon_cond_t *cond)
 {
    Core *core = Sim()->getTileManager()->getCurrentCore();
    core->getSyncClient()->condBroadcast(cond);
+   recordSyncEvent(core, InstructionTrace::COND_BROADCAST, *cond);
 }
 
 void CarbonBarrierInit(carbon_barrier_t *barrier, UInt32 count)
 {
    Core *core = Sim()->getTileManager()->getCurrentCore();
    core->getSyncClient()->barrierInit(barrier, count);
+   recordSyncEvent(core, InstructionTrace::BARRIER_INIT, *barrier, count);
 }
 
 void CarbonBarrierWait(carbon_barrier_t *barrier)
 {
    Core *core = Sim()->getTileManager()->getCurrentCore();
    core->getSyncClient()->barrierWait(barrier);
+   recordSyncEvent(core, InstructionTrace::BARRIER_WAIT, *barrier);
 }
@@ -11,6 +11,16 @@
 #include "config_file.hpp"
 #include "carbon_user.h"
 #include "thread_support_private.h"
+#include "core.h"
+#include "core_model.h"
+#include "instruction_trace.h"
+
+// The instruction stream trace (trace_record/enabled) has the thread events
+static InstructionTraceWriter* getTraceWriter()
+{
+   Core* core = Sim()->getTileManager()->getCurrentCore();
+   return core ? core->getPerformanceModel()->getTraceWriter() : NULL;
+}
 
 // FIXME: Pthread wrappers are untested.
 int CarbonPthreadCreate(pthread_t *tid, int *attr, thread_func_t func, void *arg)
@@ -32,12 +42,17 @@ int CarbonPthreadJoin(pthread_t tid, void **pparg)
 carbon_thread_t CarbonSpawnThread(thread_func_t func, void *arg)
 {
    carbon_thread_t tid = Sim()->getThreadManager()->spawnThread(INVALID_TILE_ID, func, arg);
+   if (getTraceWriter())
+      getTraceWriter()->writeThreadSpawn(INVALID_TILE_ID, tid);
    return tid;
 }
 
 carbon_thread_t CarbonSpawnThreadOnTile(tile_id_t tile_id, thread_func_t func, void *arg)
 {
-   return Sim()->getThreadManager()->spawnThread(tile_id, func, arg);
+   carbon_thread_t tid = Sim()->getThreadManager()->spawnThread(tile_id, func, arg);
+   if (getTraceWriter())
+      getTraceWriter()->writeThreadSpawn(tile_id, tid);
+   return tid;
 }
 
 
@@ -54,6 +69,8 @@ bool CarbonSchedGetAffinity(thread_id_t thread_id, UInt32 cpusetsize, cpu_set_t*
 void CarbonJoinThread(carbon_thread_t tid)
 {
    Sim()->getThreadManager()->joinThread(tid);
+   if (getTraceWriter())
+      getTraceWriter()->writeThreadJoin(tid);
 }
 
 // Support functions provided by the simulator
@@ -49,6 +49,16 @@ typedef struct
    cpu_set_t* cpu_set;
 } ThreadAffinityRequest;
 
+// The counters are the totals of the core model of the tile at the exit
+typedef struct
+{
+   SInt32 msg_type;
+   core_id_t core_id;
+   thread_id_t thread_idx;
+   UInt64 instruction_count;
+   UInt64 memory_stall_cycles;
+} ThreadExitRequest;
+
 typedef struct 
 {
    SInt32 msg_type;
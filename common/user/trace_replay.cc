@@ -0,0 +1,195 @@
+#include <map>
+#include <vector>
+
+#include "trace_replay.h"
+#include "simulator.h"
+#include "tile_manager.h"
+#include "core.h"
+#include "core_model.h"
+#include "instruction_trace.h"
+#include "carbon_user.h"
+#include "lock.h"
+#include "log.h"
+
+// The readers (and their basic blocks, that the core models may still hold)
+// are kept until the process exits
+static string trace_directory;
+static bool summarize_basic_blocks = false;
+static std::vector<InstructionTraceReader*> trace_readers;
+
+// The sync objects and threads of the replay, by their recorded ids
+static std::map<SInt32, carbon_mutex_t> mutexes;
+static std::map<SInt32, carbon_cond_t> conds;
+static std::map<SInt32, carbon_barrier_t> barriers;
+static std::map<SInt32, carbon_thread_t> threads;
+static Lock replay_lock;
+
+static void replayInstructionTrace();
+
+static void* replayThreadFunc(void*)
+{
+   replayInstructionTrace();
+   return NULL;
+}
+
+static InstructionTraceReader* getTraceReader(tile_id_t tile_id)
+{
+   ScopedLock sl(replay_lock);
+
+   LOG_ASSERT_ERROR(tile_id < (tile_id_t) trace_readers.size(), "No instruction trace for tile(%i)", tile_id);
+   // The threads of a tile continue its trace one after the other
+   if (!trace_readers[tile_id])
+   {
+      trace_readers[tile_id] = new InstructionTraceReader(InstructionTrace::getFileName(trace_directory, tile_id),
+                                                          summarize_basic_blocks);
+   }
+   return trace_readers[tile_id];
+}
+
+template <typename T>
+static T* getSyncObject(std::map<SInt32, T>& objects, SInt32 id)
+{
+   ScopedLock sl(replay_lock);
+   // Created on init, the entries never move
+   return &objects[id];
+}
+
+static void replaySync(const InstructionTraceReader::Record& record)
+{
+   switch (record.sync_type)
+   {
+   case InstructionTrace::MUTEX_INIT:
+      CarbonMutexInit(getSyncObject(mutexes, record.id));
+      break;
+   case InstructionTrace::MUTEX_LOCK:
+      CarbonMutexLock(getSyncObject(mutexes, record.id));
+      break;
+   case InstructionTrace::MUTEX_UNLOCK:
+      CarbonMutexUnlock(getSyncObject(mutexes, record.id));
+      break;
+   case InstructionTrace::COND_INIT:
+      CarbonCondInit(getSyncObject(conds, record.id));
+      break;
+   case InstructionTrace::COND_WAIT:
+      CarbonCondWait(getSyncObject(conds, record.id), getSyncObject(mutexes, record.argument));
+      break;
+   case InstructionTrace::COND_SIGNAL:
+      CarbonCondSignal(getSyncObject(conds, record.id));
+      break;
+   case InstructionTrace::COND_BROADCAST:
+      CarbonCondBroadcast(getSyncObject(conds, record.id));
+      break;
+   case InstructionTrace::BARRIER_INIT:
+      CarbonBarrierInit(getSyncObject(barriers, record.id), record.argument);
+      break;
+   case InstructionTrace::BARRIER_WAIT:
+      CarbonBarrierWait(getSyncObject(barriers, record.id));
+      break;
+   default:
+      LOG_PRINT_ERROR("Unrecognized sync type(%u)", record.sync_type);
+      break;
+   }
+}
+
+// Feeds the core model of the thread as the Pin frontend would: the basic
+// blocks, the memory accesses (through the memory system) and the branch
+// outcomes, and redoes the sync and thread operations, until the thread exits
+static void replayInstructionTrace()
+{
+   Core* core = Sim()->getTileManager()->getCurrentCore();
+   CoreModel* core_model = core->getPerformanceModel();
+   InstructionTraceReader* trace_reader = getTraceReader(core->getTileId());
+
+   std::vector<Byte> data_buf;
+   InstructionTraceReader::Record record;
+   while (trace_reader->readRecord(record))
+   {
+      switch (record.type)
+      {
+      case InstructionTrace::BASIC_BLOCK:
+         core_model->queueBasicBlock(record.basic_block);
+         core_model->iterate();
+         break;
+
+      case InstructionTrace::MEMORY_ACCESS:
+         // The data is not recorded
+         if (data_buf.size() < record.size)
+            data_buf.resize(record.size);
+         core->initiateMemoryAccess(MemComponent::L1_DCACHE, record.lock_signal, record.mem_op_type,
+                                    record.address, (record.size > 0) ? &data_buf[0] : NULL, record.size,
+                                    true);
+         break;
+
+      case InstructionTrace::BRANCH:
+         {
+            DynamicInstructionInfo info = DynamicInstructionInfo::createBranchInfo(record.taken, record.address);
+            core_model->pushDynamicInstructionInfo(info);
+         }
+         break;
+
+      case InstructionTrace::STRING:
+         {
+            DynamicInstructionInfo info = DynamicInstructionInfo::createStringInfo(record.size);
+            core_model->pushDynamicInstructionInfo(info);
+         }
+         break;
+
+      case InstructionTrace::SYNC:
+         replaySync(record);
+         break;
+
+      case InstructionTrace::THREAD_SPAWN:
+         {
+            // The threads are spawned in the same order, so they get the
+            // same tiles as when they were recorded
+            carbon_thread_t thread_id = (record.tile_id == INVALID_TILE_ID) ?
+                                        CarbonSpawnThread(replayThreadFunc, NULL) :
+                                        CarbonSpawnThreadOnTile(record.tile_id, replayThreadFunc, NULL);
+            ScopedLock sl(replay_lock);
+            threads[record.id] = thread_id;
+         }
+         break;
+
+      case InstructionTrace::THREAD_JOIN:
+         {
+            carbon_thread_t thread_id;
+            {
+               ScopedLock sl(replay_lock);
+               LOG_ASSERT_ERROR(threads.find(record.id) != threads.end(), "Join of thread(%i) that was not spawned", record.id);
+               thread_id = threads[record.id];
+            }
+            CarbonJoinThread(thread_id);
+         }
+         break;
+
+      case InstructionTrace::THREAD_EXIT:
+         return;
+
+      default:
+         LOG_PRINT_ERROR("Unrecognized record type(%u)", record.type);
+         break;
+      }
+   }
+}
+
+void CarbonReplayInstructionTraces()
+{
+   LOG_ASSERT_ERROR(Config::getSingleton()->isSimulatingSharedMemory(), "Trace replay requires shared memory");
+   LOG_ASSERT_ERROR(Sim()->getTileManager()->getCurrentTileID() == 0, "Trace replay must be started by the main thread");
+
+   try
+   {
+      trace_directory = Sim()->getCfg()->getString("trace_replay/directory", ".");
+      summarize_basic_blocks = Sim()->getCfg()->getBool("core/basic_block_summaries", false);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read [trace_replay] parameters from the cfg file");
+   }
+
+   trace_readers.resize(Config::getSingleton()->getApplicationTiles(), NULL);
+
+   Simulator::enablePerformanceModelsInCurrentProcess();
+   replayInstructionTrace();
+   Simulator::disablePerformanceModelsInCurrentProcess();
+}
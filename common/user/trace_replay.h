@@ -0,0 +1,10 @@
+#ifndef TRACE_REPLAY_H
+#define TRACE_REPLAY_H
+
+// Replays the instruction stream traces of a run ([trace_record] enabled = true)
+// from [trace_replay] directory, without Pin. Called by the main thread after
+// CarbonStartSim(): it replays the trace of tile 0, which spawns (and joins)
+// the threads that replay the other traces
+void CarbonReplayInstructionTraces();
+
+#endif // TRACE_REPLAY_H
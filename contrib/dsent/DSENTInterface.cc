@@ -4,8 +4,14 @@
 
 #include <iostream>
 #include <ostream>
+#include <sstream>
 #include <cassert>
 #include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/file.h>
 
 using namespace std;
 using namespace LibUtil;
@@ -25,10 +31,10 @@ namespace dsent_contrib
     DSENTInterface::Overwrite::~Overwrite()
     {}
 
-    void DSENTInterface::allocate(const string& dsent_path_, unsigned int tech_node_)
+    void DSENTInterface::allocate(const string& dsent_path_, unsigned int tech_node_, const string& cache_file_path_)
     {
         assert(!m_singleton);
-        m_singleton = new DSENTInterface(String(dsent_path_), tech_node_);
+        m_singleton = new DSENTInterface(String(dsent_path_), tech_node_, String(cache_file_path_));
     }
 
     void DSENTInterface::release()
@@ -43,7 +49,8 @@ namespace dsent_contrib
         return m_singleton;
     }
 
-    DSENTInterface::DSENTInterface(const String& dsent_path_, unsigned int tech_node_)
+    DSENTInterface::DSENTInterface(const String& dsent_path_, unsigned int tech_node_, const String& cache_file_path_)
+        : m_cache_file_path_(cache_file_path_)
     {
         m_el_link_cfg_file_path_ = dsent_path_ + "/dsent-core/configs/" + el_link_cfg_file_name;
         m_op_link_cfg_file_path_ = dsent_path_ + "/dsent-core/configs/" + op_link_cfg_file_name;
@@ -59,10 +66,81 @@ namespace dsent_contrib
         else if (tech_node_ == 11) m_elec_tech_file_path_ = dsent_path_ + "/dsent-core/tech/tech_models/" + "TG11LVT.model";
         else assert(false);
 
+        pthread_mutex_init(&m_evaluations_lock_, NULL);
+        m_files_version_ = get_files_version();
+        if (m_cache_file_path_ != "")
+            load_cache_file();
     }
 
     DSENTInterface::~DSENTInterface()
-    {}
+    {
+        pthread_mutex_destroy(&m_evaluations_lock_);
+    }
+
+    String DSENTInterface::get_files_version() const
+    {
+        // A changed config or tech file gives different keys
+        const String* files[] = { &m_el_link_cfg_file_path_, &m_op_link_cfg_file_path_, &m_router_cfg_file_path_,
+                                  &m_elec_tech_file_path_, &m_phot_tech_file_path_ };
+        ostringstream version;
+        for (unsigned int i = 0; i < sizeof(files) / sizeof(files[0]); i++)
+        {
+            struct stat file_stat;
+            if (stat(files[i]->c_str(), &file_stat) == 0)
+                version << file_stat.st_size << "." << file_stat.st_mtime << ":";
+            else
+                version << "none:";
+        }
+        return String(version.str());
+    }
+
+    void DSENTInterface::load_cache_file()
+    {
+        int fd = open(m_cache_file_path_.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+
+        flock(fd, LOCK_SH);
+        string contents;
+        char buffer[4096];
+        ssize_t num_bytes;
+        while ((num_bytes = read(fd, buffer, sizeof(buffer))) > 0)
+            contents.append(buffer, num_bytes);
+        flock(fd, LOCK_UN);
+        close(fd);
+
+        // key<TAB>output<TAB>output...
+        istringstream lines(contents);
+        string line;
+        while (getline(lines, line))
+        {
+            vector<String> fields = String(line).split("\t");
+            if (fields.size() < 2)
+                continue;
+            m_evaluations_[fields[0]] = vector<String>(fields.begin() + 1, fields.end());
+        }
+    }
+
+    void DSENTInterface::append_to_cache_file(const String& key_, const vector<String>& outputs_) const
+    {
+        String line = key_;
+        for (vector<String>::const_iterator it = outputs_.begin(); it != outputs_.end(); it++)
+            line += "\t" + *it;
+        line += "\n";
+
+        // Appends of whole lines under the lock, for the runs that share the file
+        int fd = open(m_cache_file_path_.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0664);
+        if (fd < 0)
+        {
+            cerr << "[DSENT] Could not open the evaluation cache file (" << m_cache_file_path_ << ")" << endl;
+            return;
+        }
+        flock(fd, LOCK_EX);
+        if (write(fd, line.c_str(), line.size()) != (ssize_t) line.size())
+            cerr << "[DSENT] Could not write to the evaluation cache file (" << m_cache_file_path_ << ")" << endl;
+        flock(fd, LOCK_UN);
+        close(fd);
+    }
 
     vector<String> DSENTInterface::run_dsent(const String& cfg_file_path_, const vector<String>& evals_, const vector<Overwrite>& overwrites_) const
     {
@@ -107,6 +185,22 @@ namespace dsent_contrib
         // Append full overrides string
         dsent_args->push_back(overrides_str);
 
+        // The arguments, with the versions of the files they name, are the key
+        String key = m_files_version_;
+        for (unsigned int i = 0; i < dsent_args->size(); i++)
+            key += " " + dsent_args->at(i);
+
+        // DSENT is not reentrant, the lock is held while it runs
+        pthread_mutex_lock(&m_evaluations_lock_);
+        EvaluationMap::const_iterator cached = m_evaluations_.find(key);
+        if (cached != m_evaluations_.end())
+        {
+            vector<String> outputs = cached->second;
+            pthread_mutex_unlock(&m_evaluations_lock_);
+            delete dsent_args;
+            return outputs;
+        }
+
         // Convert arguments vector to char**
         char** dsent_args_raw = new char*[dsent_args->size()];    
         for (unsigned int i = 0; i < dsent_args->size(); i++)
@@ -128,8 +222,14 @@ namespace dsent_contrib
         delete dsent_args_raw;
         delete dsent_args;
 
-        // Return split line-by-line outputs
-        return dsent_out_string.split("\n");
+        // Split line-by-line outputs
+        vector<String> outputs = dsent_out_string.split("\n");
+        m_evaluations_[key] = outputs;
+        if (m_cache_file_path_ != "")
+            append_to_cache_file(key, outputs);
+        pthread_mutex_unlock(&m_evaluations_lock_);
+
+        return outputs;
     }
 }
 
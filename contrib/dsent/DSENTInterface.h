@@ -3,6 +3,8 @@
 
 #include <iostream>
 #include <vector>
+#include <map>
+#include <pthread.h>
 #include "Type.h"
 
 namespace dsent_contrib
@@ -30,12 +32,13 @@ namespace dsent_contrib
             };
 
         public:
-            DSENTInterface(const String& dsent_path_, unsigned int tech_node_);
+            DSENTInterface(const String& dsent_path_, unsigned int tech_node_, const String& cache_file_path_);
             ~DSENTInterface();
 
         public:
-            // Allocate/release singletons
-            static void allocate(const string& dsent_path_, unsigned int tech_node_);
+            // Allocate/release singletons. The evaluations are also kept in
+            // cache_file_path_, across runs, if it is not empty
+            static void allocate(const string& dsent_path_, unsigned int tech_node_, const string& cache_file_path_ = "");
             static void release();
             static DSENTInterface* getSingleton();
 
@@ -47,9 +50,21 @@ namespace dsent_contrib
             inline const String& get_elec_tech_file_path() const { return m_elec_tech_file_path_; }
             inline const String& get_phot_tech_file_path() const { return m_phot_tech_file_path_; }
 
-            // Run DSENT with some specified arguments, returning outputs
+            // Run DSENT with some specified arguments, returning outputs. The
+            // routers and links of the tiles are mostly identical: the outputs
+            // are cached by arguments, and a model is only evaluated once
             std::vector<String> run_dsent(const String& cfg_file_path_, const std::vector<String>& evals_, const std::vector<Overwrite>& overwrites_) const;
 
+        private:
+            // Evaluation cache, keyed by the DSENT arguments (config file,
+            // evals and overwrites, with the tech model files)
+            typedef std::map<String, std::vector<String> > EvaluationMap;
+
+            // Size and modification time of the config and tech files
+            String get_files_version() const;
+            void load_cache_file();
+            void append_to_cache_file(const String& key_, const std::vector<String>& outputs_) const;
+
         private:
             // Config file paths
             String m_el_link_cfg_file_path_;
@@ -58,6 +73,11 @@ namespace dsent_contrib
             // Tech file paths
             String m_elec_tech_file_path_;
             String m_phot_tech_file_path_;
+            // Persistent evaluation cache file (empty if none)
+            String m_cache_file_path_;
+            String m_files_version_;
+            mutable EvaluationMap m_evaluations_;
+            mutable pthread_mutex_t m_evaluations_lock_;
 
         private:        
             // Singleton
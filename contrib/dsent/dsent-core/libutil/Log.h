@@ -26,6 +26,9 @@ namespace LibUtil
             static void printLine(const String& str_);
             static void printLine(std::ostream& stream_, const String& str_);
 
+            // Whether the log is written, to skip building the messages
+            static bool isLog() { return msIsLog; }
+
         protected:
             static Log* msSingleton;
             static const bool msIsLog;
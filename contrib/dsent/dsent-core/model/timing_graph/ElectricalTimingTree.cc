@@ -44,17 +44,17 @@ namespace DSENT
         // Size up the nodes if timing is not met
         while(required_delay_ < delay)
         {
-            Log::printLine(getInstanceName() + " -> Timing Optimization Iteration " + (String) iteration + 
-                    ": Required delay = " + (String) required_delay_ + ", Delay = " +
-                    (String) delay + ", Slack = " + (String) (required_delay_ - delay));
+            if (Log::isLog())
+                Log::printLine(getInstanceName() + " -> Timing Optimization Iteration " + (String) iteration + 
+                        ": Required delay = " + (String) required_delay_ + ", Delay = " +
+                        (String) delay + ", Slack = " + (String) (required_delay_ - delay));
 
-            ElectricalTimingNode* node_for_timing_opt = NULL;
+            // Find the node to optimize timing for, it would return a node to size up
+            ElectricalTimingNode* node_for_timing_opt = findNodeForTimingOpt(node_);
             // Go into the less expensive critical path delay calculation
             // While the timing is not met for this critical path
             while (required_delay_ < delay)
             {
-                // Find the node to optimize timing for, it would return a node to size up
-                node_for_timing_opt = findNodeForTimingOpt(node_);
                 // Give up if there are no appropriate nodes to size up or 
                 // max number of iterations has been reached
                 // Size up the chosen node if there is an appropriate node to size up
@@ -63,11 +63,13 @@ namespace DSENT
                 else
                     node_for_timing_opt->increaseDrivingStrength();
 
-                // Re-evaluate the delay of the critical path
-                delay = calculateCritPathDelay(node_);
+                // Re-evaluate the delay of the critical path, and find the next node to
+                // size up in the same walk
+                delay = walkCritPath(node_, &node_for_timing_opt);
                 iteration++;
                 crit_path_iteration++;
-                Log::printLine(getInstanceName() + " -> Critical Path Slack: " + (String) (required_delay_ - delay));
+                if (Log::isLog())
+                    Log::printLine(getInstanceName() + " -> Critical Path Slack: " + (String) (required_delay_ - delay));
             }            
             // Give up if there are no appropriate nodes to size up or
             // max number of iterations has been reached
@@ -80,9 +82,10 @@ namespace DSENT
             delay = performCritPathExtract(node_);
             min_delay = (min_delay > delay) ? delay : min_delay;
         }
-        Log::printLine(getInstanceName() + " -> Timing Optimization Ended after Iteration: " + (String) iteration + 
-                ": Required delay = " + (String) required_delay_ + ", Delay = " +
-                (String) delay + ", Slack = " + (String) (required_delay_ - delay));            
+        if (Log::isLog())
+            Log::printLine(getInstanceName() + " -> Timing Optimization Ended after Iteration: " + (String) iteration + 
+                    ": Required delay = " + (String) required_delay_ + ", Delay = " +
+                    (String) delay + ", Slack = " + (String) (required_delay_ - delay));            
                 
         min_delay = (min_delay > delay) ? delay : min_delay;
         
@@ -149,23 +152,7 @@ namespace DSENT
 
     double ElectricalTimingTree::calculateCritPathDelay(ElectricalTimingNode* node_) const
     {
-        // Simplest case where theres nothing to optimize
-        if (node_ == NULL)
-            return 0.0;
-
-        double delay = 0.0;
-        int crit_path = 0;
-
-        // Traverse the critical path and sum up delays
-        while (crit_path >= 0)
-        {
-            delay += node_->calculateDelay();
-            //Move on to the next node in the critical path
-            crit_path = node_->getCritPath();
-            if (crit_path >= 0)
-                node_ = node_->getDownstreamNodes()->at(crit_path);
-        }
-        return delay;
+        return walkCritPath(node_, NULL);
     }
     //-------------------------------------------------------------------------
 
@@ -174,46 +161,59 @@ namespace DSENT
     //-------------------------------------------------------------------------
     ElectricalTimingNode* ElectricalTimingTree::findNodeForTimingOpt(ElectricalTimingNode* node_) const
     {
+        ElectricalTimingNode* worst = NULL;
+        walkCritPath(node_, &worst);
+        return worst;
+    }
+
+    double ElectricalTimingTree::walkCritPath(ElectricalTimingNode* node_, ElectricalTimingNode** worst_) const
+    {
+        if (worst_ != NULL)
+            *worst_ = NULL;
+
         // Simplest case where theres nothing to optimize
         if (node_ == NULL)
-            return NULL;
+            return 0.0;
 
+        double delay = 0.0;
         double max_transition_ratio = -10.0;
         double current_transition_ratio = 0.0;
-        double previous_transition = 1e3 * node_->getTotalDownstreamCap();
+        double previous_transition = (worst_ != NULL) ? 1e3 * node_->getTotalDownstreamCap() : 0.0;
         double current_transition = 0.0;
-        ElectricalTimingNode* worst = NULL;        
         int crit_path = 0;
 
-        // Find the node with the highest max_transition_ratio to return
+        // Traverse the critical path, sum up delays and find the node with the
+        // highest max_transition_ratio
         while (crit_path >= 0)
         {
             current_transition = node_->calculateDelay();
+            delay += current_transition;
 
-            //If the node is not yet at max size, it is a potential choice for size up
-            if (!node_->hasMaxDrivingStrength())
-            {            
-                current_transition_ratio = current_transition / previous_transition;                
-
-                if (current_transition_ratio > max_transition_ratio)
-                {
-                    worst = node_;
-                    max_transition_ratio = current_transition_ratio;
+            if (worst_ != NULL)
+            {
+                //If the node is not yet at max size, it is a potential choice for size up
+                if (!node_->hasMaxDrivingStrength())
+                {            
+                    current_transition_ratio = current_transition / previous_transition;                
+
+                    if (current_transition_ratio > max_transition_ratio)
+                    {
+                        *worst_ = node_;
+                        max_transition_ratio = current_transition_ratio;
+                    }
                 }
-            }
 
-            if (node_->isDriver())
-                previous_transition = 0.0;            
-            previous_transition += current_transition;
+                if (node_->isDriver())
+                    previous_transition = 0.0;            
+                previous_transition += current_transition;
+            }
 
             //Move on to the next node in the critical path
             crit_path = node_->getCritPath();
-
             if (crit_path >= 0)
                 node_ = node_->getDownstreamNodes()->at(crit_path);
         }
-
-        return worst;
+        return delay;
     }
     //-------------------------------------------------------------------------
 
@@ -54,6 +54,9 @@ namespace DSENT
             // Recursively calculate delay from a starting node, finding and marking the 
             // critical path along the way and returns the delay of the critical path
             double extractCritPathDelay(ElectricalTimingNode* node_);            
+            // Walk the marked critical path from a starting node once, returning its
+            // delay and, if worst_ is not NULL, the node to size up next
+            double walkCritPath(ElectricalTimingNode* node_, ElectricalTimingNode** worst_) const;
 
         public:
             // Set the sequence number of the timing tree
@@ -0,0 +1,55 @@
+#include "allocation_tracking.h"
+#include "simulator.h"
+#include "tile_manager.h"
+#include "data_profiler.h"
+
+static void beginAllocationCall(UINT32 type, ADDRINT arg0, ADDRINT arg1, ADDRINT site)
+{
+   tile_id_t tile_id = Sim()->getTileManager()->getCurrentTileID();
+   if (tile_id != INVALID_TILE_ID)
+      Sim()->getDataProfiler()->beginAllocation(tile_id, (DataProfiler::AllocationType) type, arg0, arg1, site);
+}
+
+static void endAllocationCall(ADDRINT ret)
+{
+   tile_id_t tile_id = Sim()->getTileManager()->getCurrentTileID();
+   if (tile_id != INVALID_TILE_ID)
+      Sim()->getDataProfiler()->endAllocation(tile_id, ret);
+}
+
+void addAllocationTracking(RTN rtn, const std::string& name)
+{
+   if (!Sim()->getDataProfiler())
+      return;
+
+   DataProfiler::AllocationType type;
+   if (name == "malloc") type = DataProfiler::MALLOC;
+   else if (name == "calloc") type = DataProfiler::CALLOC;
+   else if (name == "realloc") type = DataProfiler::REALLOC;
+   else if (name == "free") type = DataProfiler::FREE;
+   else if ((name == "mmap") || (name == "mmap64")) type = DataProfiler::MMAP;
+   else if (name == "munmap") type = DataProfiler::MUNMAP;
+   else return;
+
+   RTN_Open(rtn);
+
+   // The call site is the address the call returns to
+   RTN_InsertCall(rtn, IPOINT_BEFORE,
+         AFUNPTR(beginAllocationCall),
+         IARG_UINT32, (UINT32) type,
+         IARG_FUNCARG_ENTRYPOINT_VALUE, 0,
+         IARG_FUNCARG_ENTRYPOINT_VALUE, 1,
+         IARG_RETURN_IP,
+         IARG_END);
+
+   // free and munmap have no result to wait for
+   if ((type != DataProfiler::FREE) && (type != DataProfiler::MUNMAP))
+   {
+      RTN_InsertCall(rtn, IPOINT_AFTER,
+            AFUNPTR(endAllocationCall),
+            IARG_FUNCRET_EXITPOINT_VALUE,
+            IARG_END);
+   }
+
+   RTN_Close(rtn);
+}
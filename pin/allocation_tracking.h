@@ -0,0 +1,12 @@
+#ifndef ALLOCATION_TRACKING_H
+#define ALLOCATION_TRACKING_H
+
+#include <string>
+#include "pin.H"
+
+// Allocation calls of the application (malloc, calloc, realloc, free, mmap
+// and munmap), reported to the data profiler with their call site when
+// data_profiler/enabled. Instrumented the same way in both modes
+void addAllocationTracking(RTN rtn, const std::string& name);
+
+#endif
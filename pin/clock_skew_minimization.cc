@@ -3,6 +3,7 @@
 #include "tile_manager.h"
 #include "tile.h"
 #include "clock_skew_minimization_object.h"
+#include "host_resource_manager.h"
 
 static bool enabled()
 {
@@ -35,3 +36,31 @@ void addPeriodicSync(INS ins)
 
    INS_InsertCall(ins, IPOINT_BEFORE, AFUNPTR(handlePeriodicSync), IARG_END);
 }
+
+// host_resources/balance_progress: the app thread of a tile reports its
+// progress once per basic block, and the host resource manager holds back
+// the tiles that run ahead
+bool progressBalancingEnabled()
+{
+   return Sim()->getCfg()->getBool("host_resources/balance_progress", false);
+}
+
+void handleProgressBalancing()
+{
+   if (!Sim()->isEnabled())
+      return;
+
+   Core* core = Sim()->getTileManager()->getCurrentCore();
+   if (!core || (core->getTile()->getId() >= (tile_id_t) Sim()->getConfig()->getApplicationTiles()))
+      return;
+
+   HostResourceManager *host_resource_manager = Sim()->getHostResourceManager();
+   if (host_resource_manager)
+      host_resource_manager->balanceProgress(core);
+}
+
+void addProgressBalancing(TRACE trace)
+{
+   for (BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl))
+      BBL_InsertCall(bbl, IPOINT_BEFORE, AFUNPTR(handleProgressBalancing), IARG_END);
+}
@@ -6,4 +6,8 @@
 void handlePeriodicSync();
 void addPeriodicSync(INS ins);
 
+bool progressBalancingEnabled();
+void handleProgressBalancing();
+void addProgressBalancing(TRACE trace);
+
 #endif /* __CLOCK_SKEW_MINIMIZATION_H__ */
@@ -189,6 +189,14 @@ void syscallEnterRunModel(THREADID threadIndex, CONTEXT *ctx, SYSCALL_STANDARD s
          modifyCloneContext (ctx, syscall_standard);
       }
 
+      else if ( (syscall_number == SYS_fork) ||
+            (syscall_number == SYS_vfork) )
+      {
+         // The child process would not see the simulated address space
+         LOG_PRINT_ERROR("The application forked (syscall(%d)), multi-process applications need lite mode",
+               (int) syscall_number);
+      }
+
       else if (syscall_number == SYS_time)
       {
          modifyTimeContext (ctx, syscall_standard);
@@ -645,6 +653,11 @@ void modifyCloneContext (CONTEXT *ctxt, SYSCALL_STANDARD syscall_standard)
       SyscallMdl::syscall_args_t args = syscallArgs (ctxt, syscall_standard);
       core->getSyscallMdl()->saveSyscallArgs (args);
 
+      // The memory of the application is in the simulated address space, a
+      // child process (fork) would not see it. Lite mode runs the children natively
+      LOG_ASSERT_ERROR(((IntPtr) args.arg0) & CLONE_VM,
+            "The application forked (clone flags(%#lx)), multi-process applications need lite mode", (IntPtr) args.arg0);
+
       LOG_PRINT("Clone Syscall: flags(0x%x), stack(0x%x), parent_tidptr(0x%x), child_tidptr(0x%x), tls(0x%x)",
             (IntPtr) args.arg0, (IntPtr) args.arg1, (IntPtr) args.arg2, (IntPtr) args.arg3, (IntPtr) args.arg4);
 
@@ -866,3 +879,15 @@ SyscallMdl::syscall_args_t syscallArgs(CONTEXT *ctxt, SYSCALL_STANDARD syscall_s
    return args;
 }
 
+void forkInParentCallback(THREADID threadIndex, const CONTEXT* ctx, VOID* v)
+{
+   // Only reached if the fork was not seen by the syscall model (syscall
+   // modeling disabled), which stops on a fork otherwise
+   LOG_PRINT_ERROR("The application forked, multi-process applications need lite mode");
+}
+
+void forkInChildCallback(THREADID threadIndex, const CONTEXT* ctx, VOID* v)
+{
+   // The parent stops the simulation, the child must not reach the simulator
+   PIN_Detach();
+}
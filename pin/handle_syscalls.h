@@ -10,6 +10,10 @@ void syscallExitRunModel(THREADID threadIndex, CONTEXT *ctx, SYSCALL_STANDARD sy
 void contextChange (THREADID threadIndex, CONTEXT_CHANGE_REASON context_change_reason, const CONTEXT *from, CONTEXT *to, INT32 info, VOID *v);
 void threadStart (THREADID threadIndex, CONTEXT *ctx, INT32 flags, VOID *v);
 
+// A fork() of the application is not supported in full mode, see lite mode
+void forkInParentCallback(THREADID threadIndex, const CONTEXT* ctx, VOID* v);
+void forkInChildCallback(THREADID threadIndex, const CONTEXT* ctx, VOID* v);
+
 SyscallMdl::syscall_args_t syscallArgs (CONTEXT *ctxt, SYSCALL_STANDARD syscall_standard);
 void modifyRtsigprocmaskContext (CONTEXT *ctxt, SYSCALL_STANDARD syscall_standard);
 void restoreRtsigprocmaskContext (CONTEXT *ctxt, SYSCALL_STANDARD syscall_standard);
@@ -1,3 +1,8 @@
+#include <string.h>
+#include <algorithm>
+#include <new>
+using std::max;
+
 #include "instruction_modeling.h"
 
 #include "simulator.h"
@@ -5,17 +10,36 @@
 #include "opcodes.h"
 #include "tile_manager.h"
 #include "tile.h"
+#include "host_profiler.h"
+#include "instruction_arena.h"
+#include "spin_detector.h"
+#include "lite/memory_modeling.h"
+
+// The basic blocks and instructions of the instrumented code, which live
+// as long as the simulation
+static InstructionArena instruction_arena;
 
 void handleBasicBlock(BasicBlock *sim_basic_block)
 {
    if (!Sim()->isEnabled())
       return;
 
-   CoreModel *prfmdl = Sim()->getTileManager()->getCurrentCore()->getPerformanceModel();
+   HostProfiler::Scope profile(Sim()->getHostProfiler(), HostProfiler::BASIC_BLOCK);
+   Core *core = Sim()->getTileManager()->getCurrentCore();
+   CoreModel *prfmdl = core->getPerformanceModel();
    prfmdl->queueBasicBlock(sim_basic_block);
 
-   //FIXME: put this in a thread
+   // Modeled right away, unless the core model has a timing thread
    prfmdl->iterate();
+
+   // A spin loop waits for the write that releases it (core/spin_detection)
+   SpinDetector *spin_detector = core->getSpinDetector();
+   if (spin_detector && spin_detector->addBasicBlock((IntPtr) sim_basic_block))
+   {
+      UInt64 skipped_cycles = spin_detector->wait(prfmdl->getCycleCount());
+      if (skipped_cycles > 0)
+         prfmdl->queueDynamicInstruction(new SyncInstruction(skipped_cycles));
+   }
 }
 
 void handleBranch(BOOL taken, ADDRINT target)
@@ -23,6 +47,7 @@ void handleBranch(BOOL taken, ADDRINT target)
    if (!Sim()->isEnabled())
       return;
 
+   HostProfiler::Scope profile(Sim()->getHostProfiler(), HostProfiler::BRANCH);
    CoreModel *prfmdl = Sim()->getTileManager()->getCurrentCore()->getPerformanceModel();
 
    DynamicInstructionInfo info = DynamicInstructionInfo::createBranchInfo(taken, target);
@@ -35,6 +60,10 @@ void fillOperandListMemOps(OperandList *list, INS ins)
    // rewriteMemOp etc from redirect_memory.cc and it MUST BE
    // MAINTAINED to reflect that code.
 
+   // A bulk string instruction is charged its block transfer apart
+   if (lite::isBulkStringInstruction(ins))
+      return;
+
    if (Sim()->getConfig()->getSimulationMode() == Config::FULL)
    {
       // stack ops
@@ -153,18 +182,132 @@ VOID fillOperandList(OperandList *list, INS ins)
    }
 }
 
-VOID addInstructionModeling(INS ins)
+static bool hasPrefix(const string& mnemonic, const char* prefix)
 {
+   return (mnemonic.compare(0, strlen(prefix), prefix) == 0);
+}
+
+static bool hasSuffix(const string& mnemonic, const char* suffix)
+{
+   UInt32 length = strlen(suffix);
+   return (mnemonic.size() >= length) && (mnemonic.compare(mnemonic.size() - length, length, suffix) == 0);
+}
+
+static bool hasAnyPrefix(const string& mnemonic, const char* const prefixes[])
+{
+   for (UInt32 i = 0; prefixes[i]; i++)
+   {
+      if (hasPrefix(mnemonic, prefixes[i]))
+         return true;
+   }
+   return false;
+}
+
+// Widest SSE/AVX register operand of 'ins' in bits, 0 if it has none
+static UInt32 getVectorWidth(INS ins)
+{
+   UInt32 width = 0;
+   for (UInt32 i = 0; i < INS_OperandCount(ins); i++)
+   {
+      if (!INS_OperandIsReg(ins, i))
+         continue;
+      // XMM: 16 bytes, YMM: 32, ZMM: 64 (the x87 registers are 10)
+      UInt32 size = REG_Size(INS_OperandReg(ins, i));
+      if (size >= 16)
+         width = max<UInt32>(width, 8 * size);
+   }
+   return width;
+}
+
+// Classifies the SSE/AVX instructions from their mnemonic and the width of
+// their registers. Scalar fp operations get the scalar fp types, packed ones
+// the vector type of their width. Returns INST_GENERIC for the others
+static InstructionType getVectorInstructionType(INS ins)
+{
+   UInt32 width = getVectorWidth(ins);
+   if (width == 0)
+      return INST_GENERIC;
+
+   // The VEX/EVEX forms do the same as the legacy ones
+   string mnemonic = INS_Mnemonic(ins);
+   if ((mnemonic.size() > 1) && (mnemonic[0] == 'V'))
+      mnemonic = mnemonic.substr(1);
+
+   static const char* const fma[] = { "FMADD", "FMSUB", "FNMADD", "FNMSUB", NULL };
+   static const char* const fp_add[] = { "ADD", "SUB", "MIN", "MAX", "CMP", "HADD", "HSUB", "ROUND", NULL };
+   static const char* const fp_mul[] = { "MUL", "DP", "RCP", "RSQRT", NULL };
+   static const char* const fp_div[] = { "DIV", "SQRT", NULL };
+   static const char* const fp_logical[] = { "AND", "OR", "XOR", NULL };
+   static const char* const fp_shuffle[] = { "SHUF", "UNPCK", "BLEND", "PERM", "INSERT", "EXTRACT", "BROADCAST",
+                                             "MOVDDUP", "MOVSHDUP", "MOVSLDUP", NULL };
+   static const char* const int_mul[] = { "PMUL", "PMADD", NULL };
+   static const char* const int_shuffle[] = { "PSHUF", "PERM", "PUNPCK", "PALIGNR", "PBLEND", "PINSR", "PEXTR",
+                                              "PBROADCAST", "PACK", "PMOV", "INSERTI", "EXTRACTI", NULL };
+   static const char* const int_alu[] = { "PADD", "PSUB", "PAND", "POR", "PXOR", "PCMP", "PMIN", "PMAX", "PABS",
+                                          "PAVG", "PSIGN", "PTEST", "PSLL", "PSRL", "PSRA", "PHADD", "PHSUB", NULL };
+
+   bool packed = hasSuffix(mnemonic, "PS") || hasSuffix(mnemonic, "PD");
+   bool scalar = hasSuffix(mnemonic, "SS") || hasSuffix(mnemonic, "SD");
+
+   if (hasAnyPrefix(mnemonic, fma))
+      return scalar ? INST_FMUL : Instruction::getVectorInstructionType(INST_VFMUL_128, width);
+
+   // CVTSI2SD, CVTSS2SD, CVTTSD2SI, ... are scalar, CVTDQ2PS, CVTPS2PD, ... packed
+   if (hasPrefix(mnemonic, "CVT"))
+   {
+      if ((mnemonic.find("SS") != string::npos) || (mnemonic.find("SD") != string::npos) ||
+          (mnemonic.find("SI") != string::npos))
+         return INST_FADD;
+      return Instruction::getVectorInstructionType(INST_VFADD_128, width);
+   }
 
-   BasicBlock *basic_block = new BasicBlock();
+   if (packed || scalar)
+   {
+      InstructionType type_128 = INST_GENERIC;
+      InstructionType scalar_type = INST_GENERIC;
+      if (hasAnyPrefix(mnemonic, fp_div))
+         type_128 = INST_VFDIV_128, scalar_type = INST_FDIV;
+      else if (hasAnyPrefix(mnemonic, fp_mul))
+         type_128 = INST_VFMUL_128, scalar_type = INST_FMUL;
+      else if (hasAnyPrefix(mnemonic, fp_add))
+         type_128 = INST_VFADD_128, scalar_type = INST_FADD;
+      else if (packed && hasAnyPrefix(mnemonic, fp_logical))
+         type_128 = INST_VINT_128;
+      else if (packed && hasAnyPrefix(mnemonic, fp_shuffle))
+         type_128 = INST_VSHUFFLE_128;
+
+      if (type_128 == INST_GENERIC)
+         return INST_GENERIC;
+      if (scalar)
+         return scalar_type;
+      return Instruction::getVectorInstructionType(type_128, width);
+   }
+
+   if (hasAnyPrefix(mnemonic, fp_shuffle))
+      return Instruction::getVectorInstructionType(INST_VSHUFFLE_128, width);
+   if (hasAnyPrefix(mnemonic, int_mul))
+      return Instruction::getVectorInstructionType(INST_VIMUL_128, width);
+   if (hasAnyPrefix(mnemonic, int_shuffle))
+      return Instruction::getVectorInstructionType(INST_VSHUFFLE_128, width);
+   if (hasAnyPrefix(mnemonic, int_alu))
+      return Instruction::getVectorInstructionType(INST_VINT_128, width);
+
+   return INST_GENERIC;
+}
+
+static Instruction* createInstruction(INS ins)
+{
+   Instruction* instruction;
 
    OperandList list;
    fillOperandList(&list, ins);
 
+   InstructionType vector_type = getVectorInstructionType(ins);
+
    // branches
    if (INS_IsBranch(ins) && INS_HasFallThrough(ins))
    {
-      basic_block->push_back(new BranchInstruction(INS_Opcode(ins), list));
+      instruction = new (instruction_arena.allocate(sizeof(BranchInstruction))) BranchInstruction(INS_Opcode(ins), list);
 
       INS_InsertCall(
          ins, IPOINT_TAKEN_BRANCH, (AFUNPTR)handleBranch,
@@ -179,30 +322,71 @@ VOID addInstructionModeling(INS ins)
          IARG_END);
    }
 
+   // SSE/AVX operations
+   else if (vector_type != INST_GENERIC)
+   {
+      instruction = new (instruction_arena.allocate(sizeof(ArithInstruction))) ArithInstruction(vector_type, INS_Opcode(ins), list);
+   }
+
    // Now handle instructions which have a static cost
    else
    {
       switch(INS_Opcode(ins))
       {
       case OPCODE_DIV:
-         basic_block->push_back(new ArithInstruction(INST_DIV, INS_Opcode(ins), list));
+         instruction = new (instruction_arena.allocate(sizeof(ArithInstruction))) ArithInstruction(INST_DIV, INS_Opcode(ins), list);
          break;
       case OPCODE_MUL:
-         basic_block->push_back(new ArithInstruction(INST_MUL, INS_Opcode(ins), list));
+         instruction = new (instruction_arena.allocate(sizeof(ArithInstruction))) ArithInstruction(INST_MUL, INS_Opcode(ins), list);
          break;
       case OPCODE_FDIV:
-         basic_block->push_back(new ArithInstruction(INST_FDIV, INS_Opcode(ins), list));
+         instruction = new (instruction_arena.allocate(sizeof(ArithInstruction))) ArithInstruction(INST_FDIV, INS_Opcode(ins), list);
          break;
       case OPCODE_FMUL:
-         basic_block->push_back(new ArithInstruction(INST_FMUL, INS_Opcode(ins), list));
+         instruction = new (instruction_arena.allocate(sizeof(ArithInstruction))) ArithInstruction(INST_FMUL, INS_Opcode(ins), list);
          break;
       default:
-         basic_block->push_back(new GenericInstruction(INS_Opcode(ins), list));
+         instruction = new (instruction_arena.allocate(sizeof(GenericInstruction))) GenericInstruction(INS_Opcode(ins), list);
       }
    }
 
-   basic_block->front()->setAddress(INS_Address(ins));
-   basic_block->front()->setSize(INS_Size(ins));
+   instruction->setAddress(INS_Address(ins));
+   instruction->setSize(INS_Size(ins));
+
+   return instruction;
+}
+
+static BasicBlock* createBasicBlock(UInt32 num_instructions)
+{
+   BasicBlock *basic_block = new (instruction_arena.allocate(sizeof(BasicBlock))) BasicBlock();
+   basic_block->reserve(num_instructions);
+   return basic_block;
+}
+
+VOID addInstructionModeling(INS ins)
+{
+   BasicBlock *basic_block = createBasicBlock(1);
+   basic_block->push_back(createInstruction(ins));
 
    INS_InsertCall(ins, IPOINT_BEFORE, AFUNPTR(handleBasicBlock), IARG_PTR, basic_block, IARG_END);
 }
+
+VOID addBasicBlockModeling(BBL bbl)
+{
+   BasicBlock *basic_block = createBasicBlock(BBL_NumIns(bbl));
+   for (INS ins = BBL_InsHead(bbl); INS_Valid(ins); ins = INS_Next(ins))
+      basic_block->push_back(createInstruction(ins));
+
+   // The costs are static, add them up once
+   basic_block->summarize();
+
+   // Before the memory operations of the first instruction are emulated
+   INS_InsertCall(BBL_InsHead(bbl), IPOINT_BEFORE, AFUNPTR(handleBasicBlock),
+                  IARG_CALL_ORDER, CALL_ORDER_FIRST,
+                  IARG_PTR, basic_block, IARG_END);
+}
+
+VOID newInstructionModelingGeneration()
+{
+   instruction_arena.newGeneration();
+}
@@ -4,5 +4,9 @@
 #include <pin.H>
 
 void addInstructionModeling(INS ins);
+// One basic block per Pin BBL, summarized (core/basic_block_summaries)
+void addBasicBlockModeling(BBL bbl);
+// The code cache was flushed, the blocks instrumented next are stored apart
+void newInstructionModelingGeneration();
 
 #endif
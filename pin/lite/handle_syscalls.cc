@@ -53,6 +53,12 @@ void syscallEnterRunModel(THREADID threadIndex, CONTEXT* ctx, SYSCALL_STANDARD s
    {
       PIN_SetSyscallNumber(ctx, syscall_standard, SYS_getpid);
    }
+   else if (syscall_number == SYS_vfork)
+   {
+      // The child detaches from Pin (forkInChildCallback) and cannot borrow the
+      // memory and the thread of its parent: run the vfork as a fork
+      PIN_SetSyscallNumber(ctx, syscall_standard, SYS_fork);
+   }
 }
 
 void syscallExitRunModel(THREADID threadIndex, CONTEXT* ctx, SYSCALL_STANDARD syscall_standard, void* v)
@@ -74,4 +80,19 @@ void syscallExitRunModel(THREADID threadIndex, CONTEXT* ctx, SYSCALL_STANDARD sy
    LOG_PRINT("Exit Syscall(%i) - Return Value(%#llx)", (int) syscall_number, (long long unsigned int) syscall_return);
 }
 
+void forkInParentCallback(THREADID threadIndex, const CONTEXT* ctx, VOID* v)
+{
+   static bool warned = false;
+   if (!warned)
+      LOG_PRINT_WARNING("The application forked, its child processes run natively and are not simulated");
+   warned = true;
+}
+
+void forkInChildCallback(THREADID threadIndex, const CONTEXT* ctx, VOID* v)
+{
+   // Only the forking thread exists in the child, none of the sim threads:
+   // the child must not reach the simulator (nor its Fini on exit)
+   PIN_Detach();
+}
+
 }
@@ -10,4 +10,10 @@ void handleFutexSyscall(CONTEXT* ctx);
 void syscallEnterRunModel(THREADID threadIndex, CONTEXT* ctx, SYSCALL_STANDARD syscall_standard, void* v);
 void syscallExitRunModel(THREADID threadIndex, CONTEXT* ctx, SYSCALL_STANDARD syscall_standard, void* v);
 
+// A fork() of the application: only the process started by the simulator is
+// simulated, the child processes run natively (the sim threads, the transport
+// and the simulated address space belong to the parent process)
+void forkInParentCallback(THREADID threadIndex, const CONTEXT* ctx, VOID* v);
+void forkInChildCallback(THREADID threadIndex, const CONTEXT* ctx, VOID* v);
+
 }
@@ -1,13 +1,212 @@
+#include <math.h>
+#include <algorithm>
+
 #include "lite/memory_modeling.h"
 #include "simulator.h"
 #include "tile_manager.h"
 #include "tile.h"
+#include "sampling_manager.h"
+#include "core_model.h"
+#include "dynamic_instruction_info.h"
+#include "instruction_trace.h"
+#include "host_profiler.h"
 
 namespace lite
 {
 
+// Of the plain accesses of a tile, 1 in 'period' is modeled and the others
+// take the mean latency of the modeled ones of the last window
+struct MemorySampler
+{
+   UInt32 period;
+   UInt32 countdown;
+
+   UInt32 window_accesses;
+   UInt32 window_misses;
+   UInt32 window_count[2];
+   UInt64 window_latency[2];
+
+   // Of the last window, per READ and WRITE
+   UInt64 mean_latency[2];
+   double miss_rate;
+};
+
+static bool memory_sampling = false;
+static UInt32 sampling_window;
+static UInt32 sampling_max_period;
+static double sampling_tolerance;
+static MemorySampler* memory_samplers = NULL;
+
+static bool bulk_memory_transfers = false;
+static UInt32 bulk_transfer_lines_in_flight;
+// Of EFLAGS: the string instructions go down the addresses
+static const ADDRINT DIRECTION_FLAG = 0x400;
+
+struct MemoryAccess
+{
+   IntPtr address;
+   UInt32 size;
+   bool is_write;
+};
+
+// Enough for the basic blocks of most traces, it is modeled early if full
+static const UInt32 MEMORY_ACCESS_BUFFER_SIZE = 256;
+
+struct MemoryAccessBuffer
+{
+   UInt32 num_accesses;
+   MemoryAccess accesses[MEMORY_ACCESS_BUFFER_SIZE];
+};
+
+// Holds the buffer of the thread, so that the analysis routines get it
+// without a TLS lookup
+static REG buffer_reg = REG_INVALID();
+
+static VOID flushMemoryAccesses(MemoryAccessBuffer* buffer)
+{
+   for (UInt32 i = 0; i < buffer->num_accesses; i++)
+   {
+      const MemoryAccess& access = buffer->accesses[i];
+      if (access.is_write)
+         handleMemoryWrite(false, access.address, access.size);
+      else
+         handleMemoryRead(false, access.address, access.size);
+   }
+   buffer->num_accesses = 0;
+}
+
+static VOID PIN_FAST_ANALYSIS_CALL recordMemoryAccess(MemoryAccessBuffer* buffer, BOOL is_write, ADDRINT address, UINT32 size)
+{
+   MemoryAccess& access = buffer->accesses[buffer->num_accesses ++];
+   access.address = address;
+   access.size = size;
+   access.is_write = is_write;
+
+   if (buffer->num_accesses == MEMORY_ACCESS_BUFFER_SIZE)
+      flushMemoryAccesses(buffer);
+}
+
+void initializeBatchedMemoryModeling()
+{
+   buffer_reg = PIN_ClaimToolRegister();
+   LOG_ASSERT_ERROR(REG_valid(buffer_reg), "No Pin tool register left for the memory access buffer");
+}
+
+void addBatchedMemoryModeling(TRACE trace)
+{
+   for (BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl))
+   {
+      for (INS ins = BBL_InsHead(bbl); INS_Valid(ins); ins = INS_Next(ins))
+      {
+         // The accesses so far are modeled before the last instruction of
+         // the block, an atomic update, a bulk string instruction and a
+         // syscall, which are modeled as usual
+         if ((ins == BBL_InsTail(bbl)) || INS_IsAtomicUpdate(ins) || isBulkStringInstruction(ins) ||
+             INS_IsSyscall(ins))
+         {
+            INS_InsertCall(ins, IPOINT_BEFORE,
+                  AFUNPTR(flushMemoryAccesses),
+                  IARG_REG_VALUE, buffer_reg,
+                  IARG_END);
+
+            if (!INS_IsSyscall(ins))
+               addMemoryModeling(ins);
+            continue;
+         }
+
+         // The writes are modeled after the instruction executes, as in
+         // addMemoryModeling()
+         if (INS_IsMemoryRead(ins))
+         {
+            INS_InsertCall(ins, IPOINT_BEFORE,
+                  AFUNPTR(recordMemoryAccess), IARG_FAST_ANALYSIS_CALL,
+                  IARG_REG_VALUE, buffer_reg,
+                  IARG_BOOL, FALSE,
+                  IARG_MEMORYREAD_EA,
+                  IARG_MEMORYREAD_SIZE,
+                  IARG_END);
+         }
+         if (INS_HasMemoryRead2(ins))
+         {
+            INS_InsertCall(ins, IPOINT_BEFORE,
+                  AFUNPTR(recordMemoryAccess), IARG_FAST_ANALYSIS_CALL,
+                  IARG_REG_VALUE, buffer_reg,
+                  IARG_BOOL, FALSE,
+                  IARG_MEMORYREAD2_EA,
+                  IARG_MEMORYREAD_SIZE,
+                  IARG_END);
+         }
+         if (INS_IsMemoryWrite(ins))
+         {
+            INS_InsertCall(ins, IPOINT_BEFORE,
+                  AFUNPTR(recordMemoryAccess), IARG_FAST_ANALYSIS_CALL,
+                  IARG_REG_VALUE, buffer_reg,
+                  IARG_BOOL, TRUE,
+                  IARG_MEMORYWRITE_EA,
+                  IARG_MEMORYWRITE_SIZE,
+                  IARG_END);
+         }
+      }
+   }
+}
+
+void threadStartBatchedMemoryModeling(CONTEXT* ctxt)
+{
+   MemoryAccessBuffer* buffer = new MemoryAccessBuffer;
+   buffer->num_accesses = 0;
+   PIN_SetContextReg(ctxt, buffer_reg, (ADDRINT) buffer);
+}
+
+void threadFiniBatchedMemoryModeling(const CONTEXT* ctxt)
+{
+   MemoryAccessBuffer* buffer = (MemoryAccessBuffer*) PIN_GetContextReg(ctxt, buffer_reg);
+   flushMemoryAccesses(buffer);
+   delete buffer;
+}
+
+static BOOL PIN_FAST_ANALYSIS_CALL isFirstRepIteration(BOOL first_iteration)
+{
+   return first_iteration;
+}
+
+// At the first iteration, the registers hold the addresses and the count
+// of the whole instruction
+static VOID handleBulkStringInstruction(BOOL is_copy, ADDRINT src, ADDRINT dst, ADDRINT count,
+                                        UINT32 element_size, ADDRINT flags)
+{
+   UInt64 size = ((UInt64) count) * element_size;
+   if (size == 0)
+      return;
+
+   // Down the addresses, the last element is at the lowest one
+   if (flags & DIRECTION_FLAG)
+   {
+      src -= (size - element_size);
+      dst -= (size - element_size);
+   }
+   handleBulkTransfer(is_copy ? src : 0, dst, size);
+}
+
 void addMemoryModeling(INS ins)
 {
+   if (isBulkStringInstruction(ins))
+   {
+      INS_InsertIfCall(ins, IPOINT_BEFORE,
+            AFUNPTR(isFirstRepIteration), IARG_FAST_ANALYSIS_CALL,
+            IARG_FIRST_REP_ITERATION,
+            IARG_END);
+      INS_InsertThenCall(ins, IPOINT_BEFORE,
+            AFUNPTR(handleBulkStringInstruction),
+            IARG_BOOL, INS_IsMemoryRead(ins),
+            IARG_REG_VALUE, REG_GSI,
+            IARG_REG_VALUE, REG_GDI,
+            IARG_REG_VALUE, REG_GCX,
+            IARG_UINT32, INS_MemoryWriteSize(ins),
+            IARG_REG_VALUE, REG_GFLAGS,
+            IARG_END);
+      return;
+   }
+
    if (INS_IsMemoryRead(ins) || INS_IsMemoryWrite(ins))
    {
       if (INS_IsMemoryRead(ins))
@@ -49,36 +248,215 @@ void addMemoryModeling(INS ins)
    }
 }
 
+void initializeMemorySampling()
+{
+   try
+   {
+      memory_sampling = Sim()->getCfg()->getBool("sampling/lite_memory/enabled", false);
+      sampling_window = Sim()->getCfg()->getInt("sampling/lite_memory/window", 1000);
+      sampling_max_period = Sim()->getCfg()->getInt("sampling/lite_memory/max_period", 16);
+      sampling_tolerance = Sim()->getCfg()->getFloat("sampling/lite_memory/tolerance", 0.01);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read sampling/lite_memory parameters from the cfg file");
+   }
+
+   if (!memory_sampling)
+      return;
+
+   LOG_ASSERT_ERROR(sampling_window > 0, "sampling/lite_memory/window must be > 0");
+   LOG_ASSERT_ERROR(sampling_max_period > 0, "sampling/lite_memory/max_period must be > 0");
+
+   UInt32 total_tiles = Config::getSingleton()->getTotalTiles();
+   memory_samplers = new MemorySampler[total_tiles];
+   for (UInt32 i = 0; i < total_tiles; i++)
+   {
+      MemorySampler& sampler = memory_samplers[i];
+      sampler.period = 1;
+      sampler.countdown = 0;
+      sampler.window_accesses = 0;
+      sampler.window_misses = 0;
+      sampler.window_count[0] = sampler.window_count[1] = 0;
+      sampler.window_latency[0] = sampler.window_latency[1] = 0;
+      sampler.mean_latency[0] = sampler.mean_latency[1] = 0;
+      sampler.miss_rate = -1;
+   }
+}
+
+void initializeBulkMemoryTransfers()
+{
+   try
+   {
+      bulk_memory_transfers = Sim()->getCfg()->getBool("general/lite_bulk_memory_transfers", false);
+      bulk_transfer_lines_in_flight = Sim()->getCfg()->getInt("general/bulk_transfer_lines_in_flight", 8);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read general/lite_bulk_memory_transfers from the cfg file");
+   }
+
+   LOG_ASSERT_ERROR(!bulk_memory_transfers || (bulk_transfer_lines_in_flight > 0),
+                    "general/bulk_transfer_lines_in_flight must be > 0");
+}
+
+bool bulkMemoryTransfersEnabled()
+{
+   return bulk_memory_transfers;
+}
+
+// REP MOVS and REP STOS, whose count is known when they start (REPE/REPNE
+// CMPS and SCAS stop on the data, LODS only keeps the last element)
+bool isBulkStringInstruction(INS ins)
+{
+   if (!bulk_memory_transfers || !INS_RepPrefix(ins) || !INS_IsStringop(ins))
+      return false;
+
+   std::string mnemonic = INS_Mnemonic(ins);
+   return (mnemonic.find("MOVS") != std::string::npos) || (mnemonic.find("STOS") != std::string::npos);
+}
+
+// Returns true if the access is not modeled but given the estimated latency
+static bool extrapolateMemoryAccess(Core* core, Core::mem_op_t mem_op_type, IntPtr address, UInt32 size)
+{
+   if (!memory_sampling || !Sim()->isEnabled())
+      return false;
+
+   MemorySampler& sampler = memory_samplers[core->getTileId()];
+   if (sampler.countdown == 0)
+   {
+      sampler.countdown = sampler.period - 1;
+      return false;
+   }
+   sampler.countdown --;
+
+   // What MainCore::initiateMemoryAccess() gives the core model
+   CoreModel* core_model = core->getPerformanceModel();
+   if (core_model->isEnabled() && core_model->getTraceWriter())
+      core_model->getTraceWriter()->writeMemoryAccess(mem_op_type, Core::NONE, address, size);
+
+   UInt32 type = (mem_op_type == Core::WRITE) ? 1 : 0;
+   DynamicInstructionInfo info = DynamicInstructionInfo::createMemoryInfo(sampler.mean_latency[type], address,
+         (mem_op_type == Core::WRITE) ? Operand::WRITE : Operand::READ, 0);
+   core_model->pushDynamicInstructionInfo(info);
+   return true;
+}
+
+static void sampleMemoryAccess(Core* core, Core::mem_op_t mem_op_type, std::pair<UInt32, UInt64> result)
+{
+   if (!memory_sampling || !Sim()->isEnabled())
+      return;
+
+   MemorySampler& sampler = memory_samplers[core->getTileId()];
+   UInt32 type = (mem_op_type == Core::WRITE) ? 1 : 0;
+   sampler.window_count[type] ++;
+   sampler.window_latency[type] += result.second;
+   sampler.window_accesses ++;
+   if (result.first > 0)
+      sampler.window_misses ++;
+
+   if (sampler.window_accesses < sampling_window)
+      return;
+
+   for (UInt32 i = 0; i < 2; i++)
+   {
+      if (sampler.window_count[i] > 0)
+         sampler.mean_latency[i] = sampler.window_latency[i] / sampler.window_count[i];
+      sampler.window_count[i] = 0;
+      sampler.window_latency[i] = 0;
+   }
+
+   // Fewer accesses are modeled while the miss rate holds, more when it moves
+   double miss_rate = ((double) sampler.window_misses) / sampler.window_accesses;
+   if ((sampler.miss_rate >= 0) && (fabs(miss_rate - sampler.miss_rate) <= sampling_tolerance))
+      sampler.period = std::min(2 * sampler.period, sampling_max_period);
+   else
+      sampler.period = std::max(sampler.period / 2, (UInt32) 1);
+   sampler.countdown = std::min(sampler.countdown, sampler.period - 1);
+
+   LOG_PRINT("Tile(%i): miss rate(%f), memory sampling period(%u)", core->getTileId(), miss_rate, sampler.period);
+
+   sampler.miss_rate = miss_rate;
+   sampler.window_accesses = 0;
+   sampler.window_misses = 0;
+}
+
+// Sampled simulation warms up the caches while the models are disabled
+static bool isWarmingCaches()
+{
+   SamplingManager* sampling_manager = Sim()->getSamplingManager();
+   return (sampling_manager && sampling_manager->isWarmingCaches());
+}
+
 void handleMemoryRead(bool is_atomic_update, IntPtr read_address, UInt32 read_data_size)
 {
-   if (!Sim()->isEnabled())
+   if (!Sim()->isEnabled() && !isWarmingCaches())
+      return;
+
+   HostProfiler::Scope profile(Sim()->getHostProfiler(), HostProfiler::LITE_MEMORY);
+   Core* core = Sim()->getTileManager()->getCurrentCore();
+
+   // The atomic updates are always modeled
+   if (!is_atomic_update && extrapolateMemoryAccess(core, Core::READ, read_address, read_data_size))
       return;
 
    Byte read_data_buf[read_data_size];
 
-   Core* core = Sim()->getTileManager()->getCurrentCore();
-   core->initiateMemoryAccess(MemComponent::L1_DCACHE,
+   std::pair<UInt32, UInt64> result = core->initiateMemoryAccess(MemComponent::L1_DCACHE,
          (is_atomic_update) ? Core::LOCK : Core::NONE,
          (is_atomic_update) ? Core::READ_EX : Core::READ,
          read_address,
          read_data_buf,
          read_data_size,
          true);
+
+   if (!is_atomic_update)
+      sampleMemoryAccess(core, Core::READ, result);
 }
 
 void handleMemoryWrite(bool is_atomic_update, IntPtr write_address, UInt32 write_data_size)
 {
-   if (!Sim()->isEnabled())
+   if (!Sim()->isEnabled() && !isWarmingCaches())
       return;
 
+   HostProfiler::Scope profile(Sim()->getHostProfiler(), HostProfiler::LITE_MEMORY);
    Core* core = Sim()->getTileManager()->getCurrentCore();
-   core->initiateMemoryAccess(MemComponent::L1_DCACHE,
+
+   if (!is_atomic_update && extrapolateMemoryAccess(core, Core::WRITE, write_address, write_data_size))
+      return;
+
+   std::pair<UInt32, UInt64> result = core->initiateMemoryAccess(MemComponent::L1_DCACHE,
          (is_atomic_update) ? Core::UNLOCK : Core::NONE,
          Core::WRITE,
          write_address,
          (Byte*) write_address,
          write_data_size,
          true);
+
+   if (!is_atomic_update)
+      sampleMemoryAccess(core, Core::WRITE, result);
+}
+
+void handleBulkTransfer(IntPtr src, IntPtr dst, UInt64 size)
+{
+   if (!Sim()->isEnabled() && !isWarmingCaches())
+      return;
+
+   HostProfiler::Scope profile(Sim()->getHostProfiler(), HostProfiler::LITE_MEMORY);
+   Core* core = Sim()->getTileManager()->getCurrentCore();
+   if (!core)
+      return;
+
+   // The reads of the source and the writes of the destination are in
+   // flight together
+   UInt64 time = core->getPerformanceModel()->getCycleCount();
+   UInt64 latency = 0;
+   if (src != 0)
+      latency = core->initiateBlockTransfer(Core::READ, src, size, bulk_transfer_lines_in_flight, time).second;
+   latency = std::max(latency, core->initiateBlockTransfer(Core::WRITE, dst, size, bulk_transfer_lines_in_flight, time).second);
+
+   if (latency > 0)
+      core->getPerformanceModel()->queueDynamicInstruction(new DynamicInstruction(latency, INST_STRING));
 }
 
 IntPtr captureWriteEa(IntPtr tgt_ea)
@@ -7,6 +7,26 @@ namespace lite
 {
 
 void addMemoryModeling(INS ins);
+
+// Batched memory modeling (general/lite_batched_memory_modeling): the
+// accesses of a basic block are collected in a per-thread buffer and
+// modeled together before its last instruction
+void initializeBatchedMemoryModeling();
+void addBatchedMemoryModeling(TRACE trace);
+void threadStartBatchedMemoryModeling(CONTEXT* ctxt);
+void threadFiniBatchedMemoryModeling(const CONTEXT* ctxt);
+// Sampled memory modeling (sampling/lite_memory): only some of the plain
+// accesses go to the memory system, the others take an estimated latency
+void initializeMemorySampling();
+// Bulk memory transfers (general/lite_bulk_memory_transfers): the REP
+// MOVS/STOS instructions and the glibc memcpy/memmove/memset copy or set
+// their data natively at once, and are modeled as one block transfer
+void initializeBulkMemoryTransfers();
+bool bulkMemoryTransfersEnabled();
+bool isBulkStringInstruction(INS ins);
+// 'src' is 0 for a set
+void handleBulkTransfer(IntPtr src, IntPtr dst, UInt64 size);
+
 void handleMemoryRead(bool is_atomic_update, IntPtr read_address, UInt32 read_data_size);
 void handleMemoryWrite(bool is_atomic_update, IntPtr write_address, UInt32 write_data_size);
 IntPtr captureWriteEa(IntPtr tgt_ea);
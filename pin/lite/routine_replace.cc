@@ -1,12 +1,17 @@
 #include <string>
 #include <map>
+#include <string.h>
 using namespace std;
 
 #include "lite/routine_replace.h"
+#include "lite/memory_modeling.h"
 #include "simulator.h"
 #include "tile_manager.h"
 #include "tile.h"
 #include "log.h"
+#include "sampling.h"
+#include "roi.h"
+#include "allocation_tracking.h"
 
 // The Pintool can easily read from application memory, so
 // we dont need to explicitly initialize stuff and do a special ret
@@ -20,6 +25,16 @@ void routineCallback(RTN rtn, void* v)
 {
    string rtn_name = RTN_Name(rtn);
 
+   // Region of interest
+   addRegionOfInterest(rtn);
+
+   // Allocation sites of the data profiler
+   addAllocationTracking(rtn, rtn_name);
+
+   // Bulk copies and sets
+   if (bulkMemoryTransfersEnabled())
+      addBulkTransferRoutine(rtn, rtn_name);
+
    // Enable Models
    if (rtn_name == "CarbonEnableModels")
    {
@@ -66,7 +81,14 @@ void routineCallback(RTN rtn, void* v)
       RTN_Open(rtn);
 
       // Before main()
-      if (! Sim()->getCfg()->getBool("general/trigger_models_within_application", false))
+      if (Sim()->getSamplingManager())
+      {
+         RTN_InsertCall(rtn, IPOINT_BEFORE,
+               AFUNPTR(startSampling),
+               IARG_END);
+      }
+      else if (! Sim()->getCfg()->getBool("general/trigger_models_within_application", false) &&
+               ! regionOfInterestEnabled())
       {
          RTN_InsertCall(rtn, IPOINT_BEFORE,
                AFUNPTR(Simulator::enablePerformanceModelsInCurrentProcess),
@@ -74,7 +96,14 @@ void routineCallback(RTN rtn, void* v)
       }
 
       // After main()
-      if (! Sim()->getCfg()->getBool("general/trigger_models_within_application", false))
+      if (Sim()->getSamplingManager())
+      {
+         RTN_InsertCall(rtn, IPOINT_AFTER,
+               AFUNPTR(stopSampling),
+               IARG_END);
+      }
+      else if (! Sim()->getCfg()->getBool("general/trigger_models_within_application", false) &&
+               ! regionOfInterestEnabled())
       {
          RTN_InsertCall(rtn, IPOINT_AFTER,
                AFUNPTR(Simulator::disablePerformanceModelsInCurrentProcess),
@@ -429,6 +458,30 @@ void routineCallback(RTN rtn, void* v)
             IARG_FUNCARG_ENTRYPOINT_VALUE, 4,
             IARG_END);
    }
+   else if (rtn_name == "CAPI_message_receive_nb_ex")
+   {
+      PROTO proto = PROTO_Allocate(PIN_PARG(CAPI_return_t),
+            CALLINGSTD_DEFAULT,
+            "CAPI_message_receive_nb_ex",
+            PIN_PARG(CAPI_endpoint_t),
+            PIN_PARG(CAPI_endpoint_t),
+            PIN_PARG(char*),
+            PIN_PARG(int),
+            PIN_PARG(UInt32),
+            PIN_PARG(int*),
+            PIN_PARG_END());
+
+      RTN_ReplaceSignature(rtn,
+            AFUNPTR(CAPI_message_receive_nb_ex),
+            IARG_PROTOTYPE, proto,
+            IARG_FUNCARG_ENTRYPOINT_VALUE, 0,
+            IARG_FUNCARG_ENTRYPOINT_VALUE, 1,
+            IARG_FUNCARG_ENTRYPOINT_VALUE, 2,
+            IARG_FUNCARG_ENTRYPOINT_VALUE, 3,
+            IARG_FUNCARG_ENTRYPOINT_VALUE, 4,
+            IARG_FUNCARG_ENTRYPOINT_VALUE, 5,
+            IARG_END);
+   }
 
    // Getting Simulated Time
    else if (rtn_name == "CarbonGetTime")
@@ -473,6 +526,81 @@ void routineCallback(RTN rtn, void* v)
             IARG_FUNCARG_ENTRYPOINT_VALUE, 0,
             IARG_END);
    }
+   else if (rtn_name == "CarbonGetCoreTemperature")
+   {
+      PROTO proto = PROTO_Allocate(PIN_PARG(void),
+            CALLINGSTD_DEFAULT,
+            "CarbonGetCoreTemperature",
+            PIN_PARG(float*),
+            PIN_PARG_END());
+
+      RTN_ReplaceSignature(rtn,
+            AFUNPTR(CarbonGetCoreTemperature),
+            IARG_PROTOTYPE, proto,
+            IARG_FUNCARG_ENTRYPOINT_VALUE, 0,
+            IARG_END);
+   }
+}
+
+// The implementations of memcpy, memmove and memset that glibc selects at
+// load time (memcpy and memset themselves may be their IFUNC resolvers),
+// but not the checked _chk variants
+void addBulkTransferRoutine(RTN rtn, const string& rtn_name)
+{
+   if (rtn_name.find("_chk") != string::npos)
+      return;
+
+   if ((rtn_name.compare(0, 9, "__memcpy_") == 0) || (rtn_name.compare(0, 10, "__memmove_") == 0))
+   {
+      PROTO proto = PROTO_Allocate(PIN_PARG(void*),
+            CALLINGSTD_DEFAULT,
+            "memmove",
+            PIN_PARG(void*),
+            PIN_PARG(const void*),
+            PIN_PARG(size_t),
+            PIN_PARG_END());
+
+      RTN_ReplaceSignature(rtn,
+            AFUNPTR(lite::emuMemmove),
+            IARG_PROTOTYPE, proto,
+            IARG_FUNCARG_ENTRYPOINT_VALUE, 0,
+            IARG_FUNCARG_ENTRYPOINT_VALUE, 1,
+            IARG_FUNCARG_ENTRYPOINT_VALUE, 2,
+            IARG_END);
+   }
+   else if (rtn_name.compare(0, 9, "__memset_") == 0)
+   {
+      PROTO proto = PROTO_Allocate(PIN_PARG(void*),
+            CALLINGSTD_DEFAULT,
+            "memset",
+            PIN_PARG(void*),
+            PIN_PARG(int),
+            PIN_PARG(size_t),
+            PIN_PARG_END());
+
+      RTN_ReplaceSignature(rtn,
+            AFUNPTR(lite::emuMemset),
+            IARG_PROTOTYPE, proto,
+            IARG_FUNCARG_ENTRYPOINT_VALUE, 0,
+            IARG_FUNCARG_ENTRYPOINT_VALUE, 1,
+            IARG_FUNCARG_ENTRYPOINT_VALUE, 2,
+            IARG_END);
+   }
+}
+
+// memcpy is a memmove too
+void* emuMemmove(void* dst, const void* src, size_t n)
+{
+   memmove(dst, src, n);
+   handleBulkTransfer((IntPtr) src, (IntPtr) dst, n);
+   return dst;
+}
+
+void* emuMemset(void* dst, int c, size_t n)
+{
+   memset(dst, c, n);
+   handleBulkTransfer(0, (IntPtr) dst, n);
+   return dst;
 }
 
 AFUNPTR getFunptr(CONTEXT* context, string func_name)
@@ -17,6 +17,11 @@ void emuCarbonJoinThread(CONTEXT* context, carbon_thread_t tid);
 int emuPthreadJoin(CONTEXT* context, pthread_t thread, void** thead_return);
 IntPtr nullFunction();
 
+// Bulk memory transfers (general/lite_bulk_memory_transfers)
+void addBulkTransferRoutine(RTN rtn, const string& rtn_name);
+void* emuMemmove(void* dst, const void* src, size_t n);
+void* emuMemset(void* dst, int c, size_t n);
+
 AFUNPTR getFunptr(CONTEXT* context, string func_name);
 
 }
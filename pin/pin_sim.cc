@@ -44,6 +44,10 @@
 #include "progress_trace.h"
 #include "clock_skew_minimization.h"
 #include "handle_threads.h"
+#include "sampling.h"
+#include "roi.h"
+#include "allocation_tracking.h"
+#include "host_profiler.h"
 
 #include "redirect_memory.h"
 #include "handle_syscalls.h"
@@ -61,6 +65,12 @@
 // -- a PinSimulator class or smthg
 bool done_app_initialization = false;
 config::ConfigFile *cfg;
+// Core performance modeling of whole basic blocks (traceCallback)
+bool basic_block_summaries = false;
+// Lite mode memory modeling of whole basic blocks (traceCallback)
+bool batched_memory_modeling = false;
+// Progress balancing of the tiles, once per basic block (traceCallback)
+bool progress_balancing = false;
 
 // clone stuff
 extern int *parent_tidptr;
@@ -104,6 +114,15 @@ void routineCallback(RTN rtn, void *v)
    
    replaceUserAPIFunction(rtn, rtn_name);
 
+   // Region of interest
+   addRegionOfInterest(rtn);
+
+   // Allocation sites of the data profiler
+   addAllocationTracking(rtn, rtn_name);
+
+   // Allocation sites of the data profiler
+   addAllocationTracking(rtn, rtn_name);
+
    // ---------------------------------------------------------------
 
    std::string module = Log::getSingleton()->getModule(__FILE__);
@@ -164,6 +183,8 @@ void routineCallback(RTN rtn, void *v)
 
 VOID instructionCallback (INS ins, void *v)
 {
+   HostProfiler::Scope profile(Sim()->getHostProfiler(), HostProfiler::INSTRUMENTATION);
+
    // Debugging Function
    if (Log::getSingleton()->isLoggingEnabled())
    {
@@ -174,16 +195,21 @@ VOID instructionCallback (INS ins, void *v)
             IARG_END);
    }
 
-   if (Config::getSingleton()->getEnablePerformanceModeling())
+   // Only the memory accesses are instrumented while sampled simulation
+   // fast-forwards (they warm up the caches)
+   if (instrumentPerformanceModels())
    {
-      // Core Performance Modeling
-      addInstructionModeling(ins);
-   }
+      if (Config::getSingleton()->getEnablePerformanceModeling() && !basic_block_summaries)
+      {
+         // Core Performance Modeling
+         addInstructionModeling(ins);
+      }
 
-   // Progress Trace
-   addProgressTrace(ins);
-   // Clock Skew Minimization
-   addPeriodicSync(ins);
+      // Progress Trace
+      addProgressTrace(ins);
+      // Clock Skew Minimization
+      addPeriodicSync(ins);
+   }
    // Scheduling
    addYield(ins);
 
@@ -214,7 +240,7 @@ VOID instructionCallback (INS ins, void *v)
                IARG_CONTEXT,
                IARG_END);
       }
-      else
+      else if (!batched_memory_modeling && insideRegionOfInterest())
       {
          // Instrument Memory Operations
          lite::addMemoryModeling(ins);
@@ -223,11 +249,44 @@ VOID instructionCallback (INS ins, void *v)
 }
 
 // syscall model wrappers
+VOID traceCallback (TRACE trace, void *v)
+{
+   HostProfiler::Scope profile(Sim()->getHostProfiler(), HostProfiler::INSTRUMENTATION);
+
+   // Sampled Simulation
+   if (Sim()->getSamplingManager())
+      addSampling(trace);
+
+   // Core Performance Modeling
+   if (basic_block_summaries && instrumentPerformanceModels())
+   {
+      for (BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl))
+         addBasicBlockModeling(bbl);
+   }
+
+   // Instrument Memory Operations
+   if (batched_memory_modeling && insideRegionOfInterest())
+      lite::addBatchedMemoryModeling(trace);
+
+   // Progress Balancing
+   if (progress_balancing && instrumentPerformanceModels())
+      addProgressBalancing(trace);
+}
+
 void initializeSyscallModeling()
 {
    InitLock(&clone_memory_update_lock);
 }
 
+// Host profiler
+static UInt64 code_cache_flushes = 0;
+
+VOID codeCacheFlushed(VOID *v)
+{
+   code_cache_flushes ++;
+   newInstructionModelingGeneration();
+}
+
 void ApplicationStart()
 {
 }
@@ -235,6 +294,11 @@ void ApplicationStart()
 void ApplicationExit(int, void*)
 {
    LOG_PRINT("Application exit.");
+   if (Sim()->getHostProfiler())
+   {
+      Sim()->getHostProfiler()->setCodeCacheStats(CODECACHE_CodeMemUsed(), CODECACHE_NumTracesInCache(),
+                                                   code_cache_flushes);
+   }
    Simulator::release();
    shutdownProgressTrace();
    delete cfg;
@@ -244,6 +308,9 @@ VOID threadStartCallback(THREADID threadIndex, CONTEXT *ctxt, INT32 flags, VOID
 {
    threadStartProgressTrace();
 
+   if (batched_memory_modeling)
+      lite::threadStartBatchedMemoryModeling(ctxt);
+
    // Conditions under which we must initialize a core
    // 1) (!done_app_initialization) && (curr_process_num == 0)
    // 2) (done_app_initialization) && (!thread_spawner)
@@ -371,6 +438,9 @@ VOID threadStartCallback(THREADID threadIndex, CONTEXT *ctxt, INT32 flags, VOID
 
 VOID threadFiniCallback(THREADID threadIndex, const CONTEXT *ctxt, INT32 flags, VOID *v)
 {
+   if (batched_memory_modeling)
+      lite::threadFiniBatchedMemoryModeling(ctxt);
+
    Sim()->getThreadManager()->onThreadExit();
 }
 
@@ -416,6 +486,17 @@ int main(int argc, char *argv[])
 
    PIN_AddThreadStartFunction(threadStartCallback, 0);
    PIN_AddThreadFiniFunction(threadFiniCallback, 0);
+
+   if (Sim()->getConfig()->getSimulationMode() == Config::FULL)
+   {
+      PIN_AddForkFunction(FPOINT_AFTER_IN_PARENT, forkInParentCallback, 0);
+      PIN_AddForkFunction(FPOINT_AFTER_IN_CHILD, forkInChildCallback, 0);
+   }
+   else // Sim()->getConfig()->getSimulationMode() == Config::LITE
+   {
+      PIN_AddForkFunction(FPOINT_AFTER_IN_PARENT, lite::forkInParentCallback, 0);
+      PIN_AddForkFunction(FPOINT_AFTER_IN_CHILD, lite::forkInChildCallback, 0);
+   }
    
    if ((cfg->getBool("general/enable_syscall_modeling")))
    {
@@ -433,10 +514,28 @@ int main(int argc, char *argv[])
       }
    }
 
+   basic_block_summaries = Config::getSingleton()->getEnablePerformanceModeling() &&
+                           cfg->getBool("core/basic_block_summaries", false);
+   batched_memory_modeling = (Sim()->getConfig()->getSimulationMode() == Config::LITE) &&
+                             cfg->getBool("general/lite_batched_memory_modeling", false);
+   if (batched_memory_modeling)
+      lite::initializeBatchedMemoryModeling();
+   if (Sim()->getConfig()->getSimulationMode() == Config::LITE)
+   {
+      lite::initializeMemorySampling();
+      lite::initializeBulkMemoryTransfers();
+   }
+   initRegionOfInterest();
+   progress_balancing = progressBalancingEnabled();
+   if (basic_block_summaries || batched_memory_modeling || progress_balancing || Sim()->getSamplingManager())
+      TRACE_AddInstrumentFunction(traceCallback, 0);
+
    INS_AddInstrumentFunction(instructionCallback, 0);
 
    initProgressTrace();
 
+   CODECACHE_AddCacheFlushedFunction(codeCacheFlushed, 0);
+
    PIN_AddFiniFunction(ApplicationExit, 0);
 
    // Never returns
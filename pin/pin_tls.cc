@@ -1,12 +1,24 @@
+#include <unistd.h>
+#include <sys/syscall.h>
 #include <cstdio>
 #include <cstdlib>
 #include "tls.h"
+#include "lockfree_hash.h"
 #include <pin.H>
 
+/*
+  PinTLS keeps the values of the threads Pin knows (the application
+  threads and the threads spawned with PIN_SpawnInternalThread) in Pin's
+  thread data: a get is a lookup in the current thread's Pin state, with
+  no lock and no system call. The values of any other thread are kept, as
+  by HashTLS, in a lock-free hash map from the thread ids.
+*/
+
 class PinTLS : public TLS
 {
 public:
     PinTLS()
+       : _other_threads(INITIAL_SIZE)
     {
         _key = PIN_CreateThreadDataKey(NULL);
     }
@@ -18,19 +30,34 @@ public:
 
     void* get()
     {
-        return PIN_GetThreadData(_key);
+        if (PIN_ThreadId() != INVALID_THREADID)
+            return PIN_GetThreadData(_key);
+
+        std::pair<bool, UInt64> entry = _other_threads.find(syscall(SYS_gettid));
+        return entry.first ? (void*) entry.second : NULL;
     }
 
     const void* get() const
     {
-        return PIN_GetThreadData(_key);
+        return ((PinTLS*)this)->get();
     }
 
     void set(void *vp)
     {
-        if (!PIN_SetThreadData(_key, vp))
+        if (PIN_ThreadId() != INVALID_THREADID)
+        {
+            if (!PIN_SetThreadData(_key, vp))
+            {
+                fprintf(stderr, "Error setting TLS -- pin tid = %d", PIN_ThreadId());
+                exit(EXIT_FAILURE);
+            }
+            return;
+        }
+
+        int tid = syscall(SYS_gettid);
+        if (!_other_threads.update(tid, (UInt64) vp) && !_other_threads.insert(tid, (UInt64) vp))
         {
-            fprintf(stderr, "Error setting TLS -- pin tid = %d", PIN_ThreadId());
+            fprintf(stderr, "Error setting TLS -- tid = %d", tid);
             exit(EXIT_FAILURE);
         }
     }
@@ -42,16 +69,19 @@ public:
 
     void erase()
     {
+        if (PIN_ThreadId() == INVALID_THREADID)
+            _other_threads.erase(syscall(SYS_gettid));
     }
 
 private:
+    static const int INITIAL_SIZE = 16;
+
     TLS_KEY _key;
+    LockFreeHash _other_threads;
 };
 
-#if 0
 // override HashTLS
 TLS* TLS::create()
 {
     return new PinTLS();
 }
-#endif
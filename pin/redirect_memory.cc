@@ -4,6 +4,7 @@
 #include "core.h"
 #include "pin_memory_manager.h"
 #include "core_model.h"
+#include "host_profiler.h"
 
 // FIXME: Only need this function because some memory accesses are made before cores have
 // been initialized. Should not evnentually need this
@@ -12,6 +13,7 @@ void memOp (Core::lock_signal_t lock_signal, Core::mem_op_t mem_op_type, IntPtr
 {   
    assert (lock_signal == Core::NONE);
 
+   HostProfiler::Scope profile(Sim()->getHostProfiler(), HostProfiler::MEMORY_REDIRECT);
    Core *core = Sim()->getTileManager()->getCurrentCore();
    LOG_ASSERT_ERROR(core, "Could not find Core object for current thread");
    core->accessMemory (lock_signal, mem_op_type, d_addr, data_buffer, data_size, true);
@@ -225,6 +227,7 @@ void rewriteMemOp (INS ins)
             IARG_MEMORYREAD_SIZE,
             IARG_UINT32, i,
             IARG_BOOL, INS_MemoryOperandIsRead(ins, i),
+            IARG_INST_PTR,
             IARG_RETURN_REGS, REG(REG_INST_G0+i),
             IARG_END);
       
@@ -248,6 +251,7 @@ void rewriteMemOp (INS ins)
                IARG_REG_VALUE, REG_INST_G3, // Is IARG_MEMORYWRITE_EA,
                IARG_MEMORYWRITE_SIZE,
                IARG_UINT32, i,
+               IARG_INST_PTR,
                IARG_END);
       }
    }
@@ -418,7 +422,7 @@ ADDRINT completePopf (ADDRINT esp, ADDRINT size)
    }
 }
 
-ADDRINT redirectMemOp (bool has_lock_prefix, ADDRINT tgt_ea, ADDRINT size, UInt32 op_num, bool is_read)
+ADDRINT redirectMemOp (bool has_lock_prefix, ADDRINT tgt_ea, ADDRINT size, UInt32 op_num, bool is_read, ADDRINT ins_address)
 {
    Core *core = Sim()->getTileManager()->getCurrentCore();
   
@@ -427,8 +431,10 @@ ADDRINT redirectMemOp (bool has_lock_prefix, ADDRINT tgt_ea, ADDRINT size, UInt3
       PinMemoryManager *mem_manager = core->getPinMemoryManager ();
       assert (mem_manager != NULL);
 
-      return (ADDRINT) mem_manager->redirectMemOp (has_lock_prefix, (IntPtr) tgt_ea, (IntPtr) size, op_num, is_read);
-
+      core->setInstructionAddress((IntPtr) ins_address);
+      ADDRINT redirected_ea = (ADDRINT) mem_manager->redirectMemOp (has_lock_prefix, (IntPtr) tgt_ea, (IntPtr) size, op_num, is_read);
+      core->setInstructionAddress(0);
+      return redirected_ea;
    }
    else
    {
@@ -446,13 +452,15 @@ ADDRINT redirectMemOpSaveEa(ADDRINT ea)
    return ea;
 }
 
-VOID completeMemWrite (bool has_lock_prefix, ADDRINT tgt_ea, ADDRINT size, UInt32 op_num)
+VOID completeMemWrite (bool has_lock_prefix, ADDRINT tgt_ea, ADDRINT size, UInt32 op_num, ADDRINT ins_address)
 {
    Core *core = Sim()->getTileManager()->getCurrentCore();
 
    if (core)
    {
+      core->setInstructionAddress((IntPtr) ins_address);
       core->getPinMemoryManager()->completeMemWrite (has_lock_prefix, (IntPtr) tgt_ea, (IntPtr) size, op_num);
+      core->setInstructionAddress(0);
    }
    else
    {
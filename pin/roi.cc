@@ -0,0 +1,125 @@
+#include <string>
+#include <stdlib.h>
+
+#include "roi.h"
+#include "simulator.h"
+#include "config.h"
+#include "log.h"
+
+static bool roi_enabled = false;
+static volatile bool roi_inside = false;
+
+static std::string roi_start;
+static std::string roi_end;
+static UInt64 roi_start_count;
+static UInt64 roi_end_count;
+
+static volatile UInt64 num_start_calls = 0;
+static volatile UInt64 num_end_returns = 0;
+
+static VOID enterRegionOfInterest()
+{
+   if (__sync_add_and_fetch(&num_start_calls, 1) != roi_start_count)
+      return;
+
+   fprintf(stderr, "[[Graphite]] --> [ Entering Region of Interest (%s) ]\n", roi_start.c_str());
+   roi_inside = true;
+   Simulator::enablePerformanceModelsInCurrentProcess();
+
+   // Instrument the code again with the models (the trace that is
+   // executing finishes as it was instrumented)
+   CODECACHE_FlushCache();
+}
+
+static VOID exitRegionOfInterest()
+{
+   if (!roi_inside || (__sync_add_and_fetch(&num_end_returns, 1) != roi_end_count))
+      return;
+
+   fprintf(stderr, "[[Graphite]] --> [ Leaving Region of Interest (%s) ]\n", roi_end.c_str());
+   Simulator::disablePerformanceModelsInCurrentProcess();
+   roi_inside = false;
+
+   CODECACHE_FlushCache();
+}
+
+static bool matchRoutine(RTN rtn, const std::string& routine)
+{
+   if (routine.compare(0, 2, "0x") == 0)
+      return (RTN_Address(rtn) == (ADDRINT) strtoull(routine.c_str(), NULL, 16));
+   return (RTN_Name(rtn) == routine);
+}
+
+void initRegionOfInterest()
+{
+   try
+   {
+      roi_enabled = Sim()->getCfg()->getBool("roi/enabled", false);
+      roi_start = Sim()->getCfg()->getString("roi/start", "");
+      roi_end = Sim()->getCfg()->getString("roi/end", "");
+      roi_start_count = Sim()->getCfg()->getInt("roi/start_count", 1);
+      roi_end_count = Sim()->getCfg()->getInt("roi/end_count", 0);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read roi parameters from the cfg file");
+   }
+
+   if (!roi_enabled)
+      return;
+
+   LOG_ASSERT_ERROR(roi_start != "", "roi/start must be given");
+   LOG_ASSERT_ERROR(roi_start_count > 0, "roi/start_count must be > 0");
+   if (roi_end == "")
+   {
+      // The return of the invocation of the start routine that opened the
+      // region (unless it recurses)
+      roi_end = roi_start;
+      if (roi_end_count == 0)
+         roi_end_count = 1;
+   }
+   LOG_ASSERT_ERROR(roi_end_count > 0, "roi/end_count must be > 0");
+
+   // The models are switched in this process only
+   LOG_ASSERT_ERROR(Config::getSingleton()->getProcessCount() == 1,
+         "The region of interest needs a single process, not %u", Config::getSingleton()->getProcessCount());
+   LOG_ASSERT_ERROR(!Sim()->getSamplingManager(), "The region of interest and sampled simulation exclude each other");
+   LOG_ASSERT_ERROR(!Sim()->getCfg()->getBool("general/trigger_models_within_application", false),
+         "The region of interest and general/trigger_models_within_application exclude each other");
+}
+
+bool regionOfInterestEnabled()
+{
+   return roi_enabled;
+}
+
+bool insideRegionOfInterest()
+{
+   return (!roi_enabled || roi_inside);
+}
+
+void addRegionOfInterest(RTN rtn)
+{
+   if (!roi_enabled)
+      return;
+
+   bool start = matchRoutine(rtn, roi_start);
+   bool end = matchRoutine(rtn, roi_end);
+   if (!start && !end)
+      return;
+
+   RTN_Open(rtn);
+   if (start)
+   {
+      RTN_InsertCall(rtn, IPOINT_BEFORE,
+            AFUNPTR(enterRegionOfInterest),
+            IARG_END);
+   }
+   if (end)
+   {
+      RTN_InsertCall(rtn, IPOINT_AFTER,
+            AFUNPTR(exitRegionOfInterest),
+            IARG_END);
+   }
+   RTN_Close(rtn);
+}
@@ -0,0 +1,18 @@
+#ifndef ROI_H
+#define ROI_H
+
+#include "pin.H"
+
+// Region of interest (roi/enabled): the models are switched on at the
+// 'start_count'-th call of the 'start' routine and off at the 'end_count'-th
+// return of the 'end' routine after that (by default the return of the
+// start routine), instead of around main(). A routine is given by name or by address (0x...).
+// Outside the region only what the functional simulation needs is
+// instrumented
+void initRegionOfInterest();
+bool regionOfInterestEnabled();
+void addRegionOfInterest(RTN rtn);
+// Are the performance models instrumented
+bool insideRegionOfInterest();
+
+#endif
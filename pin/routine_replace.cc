@@ -16,6 +16,8 @@
 #include "thread_start.h"
 #include "network.h"
 #include "packet_type.h"
+#include "sampling.h"
+#include "roi.h"
 // End Memory redirection stuff
 // --------------------------------------
 
@@ -72,6 +74,7 @@ bool replaceUserAPIFunction(RTN& rtn, string& name)
    else if (name == "CAPI_message_receive_w") msg_ptr = AFUNPTR(replacement_CAPI_message_receive_w);
    else if (name == "CAPI_message_send_w_ex") msg_ptr = AFUNPTR(replacement_CAPI_message_send_w_ex);
    else if (name == "CAPI_message_receive_w_ex") msg_ptr = AFUNPTR(replacement_CAPI_message_receive_w_ex);
+   else if (name == "CAPI_message_receive_nb_ex") msg_ptr = AFUNPTR(replacement_CAPI_message_receive_nb_ex);
 
    // synchronization
    else if (name == "CarbonMutexInit") msg_ptr = AFUNPTR(replacementMutexInit);
@@ -99,6 +102,7 @@ bool replaceUserAPIFunction(RTN& rtn, string& name)
    // For Dynamic Frequency Scaling
    else if (name == "CarbonGetCoreFrequency") msg_ptr = AFUNPTR(replacementCarbonGetCoreFrequency);
    else if (name == "CarbonSetCoreFrequency") msg_ptr = AFUNPTR(replacementCarbonSetCoreFrequency);
+   else if (name == "CarbonGetCoreTemperature") msg_ptr = AFUNPTR(replacementCarbonGetCoreTemperature);
 
    // Turn off performance modeling at _start()
    if (name == "_start")
@@ -118,7 +122,14 @@ bool replaceUserAPIFunction(RTN& rtn, string& name)
       RTN_Open (rtn);
 
       // Before main()
-      if (! Sim()->getCfg()->getBool("general/trigger_models_within_application",false))
+      if (Sim()->getSamplingManager())
+      {
+         RTN_InsertCall(rtn, IPOINT_BEFORE,
+               AFUNPTR(startSampling),
+               IARG_END);
+      }
+      else if (! Sim()->getCfg()->getBool("general/trigger_models_within_application",false) &&
+               ! regionOfInterestEnabled())
       {
          RTN_InsertCall(rtn, IPOINT_BEFORE,
                AFUNPTR(Simulator::enablePerformanceModelsInCurrentProcess),
@@ -126,7 +137,14 @@ bool replaceUserAPIFunction(RTN& rtn, string& name)
       }
 
       // After main()
-      if (! Sim()->getCfg()->getBool("general/trigger_models_within_application",false))
+      if (Sim()->getSamplingManager())
+      {
+         RTN_InsertCall(rtn, IPOINT_AFTER,
+               AFUNPTR(stopSampling),
+               IARG_END);
+      }
+      else if (! Sim()->getCfg()->getBool("general/trigger_models_within_application",false) &&
+               ! regionOfInterestEnabled())
       {
          RTN_InsertCall(rtn, IPOINT_AFTER,
                AFUNPTR(Simulator::disablePerformanceModelsInCurrentProcess),
@@ -589,6 +607,41 @@ void replacement_CAPI_message_receive_w_ex (CONTEXT *ctxt)
    retFromReplacedRtn (ctxt, ret_val);
 }
 
+void replacement_CAPI_message_receive_nb_ex (CONTEXT *ctxt)
+{
+   // Only the user-threads (all of which are cores) call
+   // the CAPI communication API functions
+   Core *core = Sim()->getTileManager()->getCurrentCore();
+   assert (core);
+   
+   CAPI_endpoint_t sender;
+   CAPI_endpoint_t receiver;
+   char *buffer;
+   int size;
+   carbon_network_t net_type;
+   int *received;
+   int received_buf;
+   CAPI_return_t ret_val = 0;
+
+   initialize_replacement_args (ctxt,
+         IARG_UINT32, &sender,
+         IARG_UINT32, &receiver,
+         IARG_PTR, &buffer,
+         IARG_UINT32, &size,
+         IARG_UINT32, &net_type,
+         IARG_PTR, &received,
+         CARBON_IARG_END);
+
+   char *buf = new char [size];
+   ret_val = CAPI_message_receive_nb_ex (sender, receiver, buf, size, net_type, &received_buf);
+   if (received_buf)
+      core->accessMemory (Core::NONE, Core::WRITE, (ADDRINT) buffer, buf, size);
+   core->accessMemory (Core::NONE, Core::WRITE, (ADDRINT) received, (char*) &received_buf, sizeof (int));
+
+   delete [] buf;
+   retFromReplacedRtn (ctxt, ret_val);
+}
+
 
 void replacementMutexInit (CONTEXT *ctxt)
 {
@@ -895,6 +948,24 @@ void replacementCarbonGetCoreFrequency(CONTEXT *ctxt)
    retFromReplacedRtn(ctxt, ret_val);
 }
 
+void replacementCarbonGetCoreTemperature(CONTEXT *ctxt)
+{
+   float* temperature;
+
+   initialize_replacement_args(ctxt,
+         IARG_PTR, &temperature,
+         CARBON_IARG_END);
+
+   volatile float temperature_buf;
+   CarbonGetCoreTemperature(&temperature_buf);
+
+   Core* core = Sim()->getTileManager()->getCurrentCore();
+   core->accessMemory(Core::NONE, Core::WRITE, (IntPtr) temperature, (char*) &temperature_buf, sizeof(temperature_buf));
+
+   ADDRINT ret_val = PIN_GetContextReg(ctxt, REG_GAX);
+   retFromReplacedRtn(ctxt, ret_val);
+}
+
 void replacementCarbonSetCoreFrequency(CONTEXT *ctxt)
 {
    float* core_frequency;
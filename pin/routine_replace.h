@@ -48,6 +48,7 @@ void replacement_CAPI_message_send_w (CONTEXT *ctxt);
 void replacement_CAPI_message_receive_w (CONTEXT *ctxt);
 void replacement_CAPI_message_send_w_ex (CONTEXT *ctxt);
 void replacement_CAPI_message_receive_w_ex (CONTEXT *ctxt);
+void replacement_CAPI_message_receive_nb_ex (CONTEXT *ctxt);
 
 // pthread
 void replacementPthreadCreate(CONTEXT *ctxt);
@@ -67,6 +68,7 @@ void replacementCarbonGetTime(CONTEXT *ctxt);
 
 // Dynamic Frequency Scaling
 void replacementCarbonGetCoreFrequency(CONTEXT *ctxt);
+void replacementCarbonGetCoreTemperature(CONTEXT *ctxt);
 void replacementCarbonSetCoreFrequency(CONTEXT *ctxt);
 
 void initialize_replacement_args (CONTEXT *ctxt, ...);
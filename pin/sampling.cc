@@ -0,0 +1,46 @@
+#include "sampling.h"
+#include "simulator.h"
+#include "sampling_manager.h"
+#include "roi.h"
+
+static VOID PIN_FAST_ANALYSIS_CALL countSampledInstructions(THREADID thread_id, UINT32 num_instructions)
+{
+   // The schedule follows the main thread
+   if (thread_id != 0)
+      return;
+
+   // The models were switched on or off: flush the code cache so that the
+   // code is instrumented again for the new phase (the trace that is
+   // executing finishes as it was instrumented)
+   if (Sim()->getSamplingManager()->countInstructions(num_instructions))
+      CODECACHE_FlushCache();
+}
+
+void addSampling(TRACE trace)
+{
+   for (BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl))
+   {
+      BBL_InsertCall(bbl, IPOINT_BEFORE,
+            AFUNPTR(countSampledInstructions),
+            IARG_FAST_ANALYSIS_CALL,
+            IARG_THREAD_ID,
+            IARG_UINT32, BBL_NumIns(bbl),
+            IARG_END);
+   }
+}
+
+bool instrumentPerformanceModels()
+{
+   SamplingManager* sampling_manager = Sim()->getSamplingManager();
+   return insideRegionOfInterest() && (!sampling_manager || sampling_manager->isDetailed());
+}
+
+void startSampling()
+{
+   Sim()->getSamplingManager()->start();
+}
+
+void stopSampling()
+{
+   Sim()->getSamplingManager()->stop();
+}
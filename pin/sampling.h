@@ -0,0 +1,15 @@
+#ifndef SAMPLING_H
+#define SAMPLING_H
+
+#include "pin.H"
+
+// Sampled simulation (sampling/enabled)
+void addSampling(TRACE trace);
+// The performance models are only instrumented in the detailed windows
+bool instrumentPerformanceModels();
+
+// Around main()
+void startSampling();
+void stopSampling();
+
+#endif
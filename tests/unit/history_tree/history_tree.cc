@@ -3,6 +3,7 @@
 #include "fixed_types.h"
 #include "queue_model_history_tree.h"
 #include "queue_model_history_list.h"
+#include "queue_model_history_list_fast.h"
 
 #define NUM_PACKETS  10
 
@@ -19,35 +20,174 @@ UInt64 pkt_cfg[NUM_PACKETS][3] = {
    {75, 10, 10}
 };
 
-int main(int argc, char* argv[])
+// Splits of a free interval, a packet filling a gap exactly (the busy
+// intervals around it merge) and packets older than the previous ones
+UInt64 split_merge_pkt_cfg[NUM_PACKETS][3] = {
+   {100, 10, 0},     // Split [0,inf) into [0,100) and [110,inf)
+   {110, 10, 0},     // Start of [110,inf), now [120,inf)
+   {130, 10, 0},     // Split into [120,130) and [140,inf)
+   {120, 10, 0},     // Fills [120,130), removed
+   {95,  10, 45},    // Does not fit in [0,100), waits for 140
+   {50,  20, 0},     // Out of order, splits [0,100) into [0,50) and [70,100)
+   {60,  5,  10},    // Waits for 70, [75,100) left
+   {0,   50, 0},     // Fills [0,50), removed
+   {65,  10, 10},    // Waits for 75
+   {90,  15, 60}     // Does not fit in [85,100), waits for 150
+};
+
+// Same with a min processing time of 4: the free intervals shorter than
+// that are dropped
+UInt64 min_processing_time_pkt_cfg[NUM_PACKETS][3] = {
+   {100, 10, 0},
+   {112, 10, 0},     // Leaves [110,112), too short
+   {130, 10, 0},
+   {122, 6,  0},     // Leaves [128,130), too short
+   {98,  2,  0},     // Ends [0,100) at 98
+   {90,  4,  0},
+   {40,  10, 0},
+   {45,  2,  5},
+   {20,  25, 32},
+   {150, 3,  0}
+};
+
+// Random stream of packets, a quarter of them older than the previous ones
+#define NUM_RANDOM_PACKETS 20000
+
+static UInt32 _random_state;
+static UInt32 getRandom()
 {
-   CarbonStartSim(argc, argv);
-   printf("Starting History-Tree test\n");
+   _random_state = _random_state * 1103515245 + 12345;
+   return (_random_state >> 8);
+}
 
-   QueueModelHistoryTree queue_model(1);
-   
+bool checkPackets(const char* name, QueueModel* queue_model, UInt64 pkts[][3])
+{
    for (SInt32 i = 0; i < NUM_PACKETS; i++)
    {
-      UInt64 queue_delay = queue_model.computeQueueDelay(pkt_cfg[i][0], pkt_cfg[i][1]);
-      if (queue_delay != pkt_cfg[i][2])
+      UInt64 queue_delay = queue_model->computeQueueDelay(pkts[i][0], pkts[i][1]);
+      if (queue_delay != pkts[i][2])
       {
-         fprintf(stderr, "*ERROR* Queue Delay: Pkt(%llu,%llu), Expected(%llu), Got(%llu)\n", 
-                 (long long unsigned int) pkt_cfg[i][0],
-                 (long long unsigned int) pkt_cfg[i][1],
-                 (long long unsigned int) pkt_cfg[i][2],
+         fprintf(stderr, "*ERROR* %s: Queue Delay: Pkt(%llu,%llu), Expected(%llu), Got(%llu)\n", name,
+                 (long long unsigned int) pkts[i][0],
+                 (long long unsigned int) pkts[i][1],
+                 (long long unsigned int) pkts[i][2],
                  (long long unsigned int) queue_delay);
-         fprintf(stderr, "History-Tree test: FAILED\n");
-         exit(EXIT_FAILURE);
+         return false;
       }
 
-      printf("Queue Delay: Pkt(%llu,%llu), Delay(%llu)\n",
-            (long long unsigned int) pkt_cfg[i][0],
-            (long long unsigned int) pkt_cfg[i][1],
+      printf("%s: Queue Delay: Pkt(%llu,%llu), Delay(%llu)\n", name,
+            (long long unsigned int) pkts[i][0],
+            (long long unsigned int) pkts[i][1],
             (long long unsigned int) queue_delay);
    }
-   
+   return true;
+}
+
+// The delays of the random stream, hashed, against the ones given by the
+// AVL interval tree that the blocked array replaced
+bool checkRandomPackets(const char* name, QueueModel* queue_model, UInt64 expected_hash)
+{
+   _random_state = 1;
+   UInt64 time = 1000;
+   UInt64 hash = 0;
+   for (SInt32 i = 0; i < NUM_RANDOM_PACKETS; i++)
+   {
+      time += getRandom() % 24;
+      UInt64 pkt_time = time;
+      if ((getRandom() % 4) == 0)
+         pkt_time -= getRandom() % 256;
+      UInt64 processing_time = 1 + (getRandom() % 16);
+
+      hash = hash * 31 + queue_model->computeQueueDelay(pkt_time, processing_time);
+   }
+
+   if (hash != expected_hash)
+   {
+      fprintf(stderr, "*ERROR* %s: Random Packets: Expected Hash(%#llx), Got(%#llx)\n", name,
+              (long long unsigned int) expected_hash, (long long unsigned int) hash);
+      return false;
+   }
+
+   printf("%s: Random Packets: Hash(%#llx)\n", name, (long long unsigned int) hash);
+   return true;
+}
+
+// The history list and its array-backed version, fed the same packets,
+// must give the same delays
+bool checkSameDelays(const char* name, QueueModel* queue_model, QueueModel* fast_queue_model)
+{
+   for (SInt32 i = 0; i < NUM_PACKETS; i++)
+   {
+      UInt64 queue_delay = queue_model->computeQueueDelay(pkt_cfg[i][0], pkt_cfg[i][1]);
+      UInt64 fast_queue_delay = fast_queue_model->computeQueueDelay(pkt_cfg[i][0], pkt_cfg[i][1]);
+      if (fast_queue_delay != queue_delay)
+      {
+         fprintf(stderr, "*ERROR* %s: Queue Delay: Pkt(%llu,%llu), Expected(%llu), Got(%llu)\n", name,
+                 (long long unsigned int) pkt_cfg[i][0],
+                 (long long unsigned int) pkt_cfg[i][1],
+                 (long long unsigned int) queue_delay,
+                 (long long unsigned int) fast_queue_delay);
+         return false;
+      }
+   }
+
+   _random_state = 1;
+   UInt64 time = 1000;
+   for (SInt32 i = 0; i < NUM_RANDOM_PACKETS; i++)
+   {
+      time += getRandom() % 24;
+      UInt64 pkt_time = time;
+      if ((getRandom() % 4) == 0)
+         pkt_time -= getRandom() % 256;
+      UInt64 processing_time = 1 + (getRandom() % 16);
+
+      UInt64 queue_delay = queue_model->computeQueueDelay(pkt_time, processing_time);
+      UInt64 fast_queue_delay = fast_queue_model->computeQueueDelay(pkt_time, processing_time);
+      if (fast_queue_delay != queue_delay)
+      {
+         fprintf(stderr, "*ERROR* %s: Random Packet(%i): Queue Delay: Pkt(%llu,%llu), Expected(%llu), Got(%llu)\n", name, i,
+                 (long long unsigned int) pkt_time,
+                 (long long unsigned int) processing_time,
+                 (long long unsigned int) queue_delay,
+                 (long long unsigned int) fast_queue_delay);
+         return false;
+      }
+   }
+
+   printf("%s: Same Delays\n", name);
+   return true;
+}
+
+int main(int argc, char* argv[])
+{
+   CarbonStartSim(argc, argv);
+   printf("Starting History-Tree test\n");
+
+   QueueModelHistoryTree queue_model(1);
+   QueueModelHistoryTree split_merge_queue_model(1);
+   QueueModelHistoryTree min_processing_time_queue_model(4);
+   QueueModelHistoryTree random_queue_model(1);
+   QueueModelHistoryTree random_min_processing_time_queue_model(4);
+   QueueModelHistoryList list_queue_model(1);
+   QueueModelHistoryListFast fast_list_queue_model(1);
+   QueueModelHistoryList min_processing_time_list_queue_model(4);
+   QueueModelHistoryListFast min_processing_time_fast_list_queue_model(4);
+
+   if ( !checkPackets("Basic", &queue_model, pkt_cfg) ||
+        !checkPackets("Split-Merge", &split_merge_queue_model, split_merge_pkt_cfg) ||
+        !checkPackets("Min-Processing-Time", &min_processing_time_queue_model, min_processing_time_pkt_cfg) ||
+        !checkRandomPackets("Random", &random_queue_model, 0x82d7d9332d997149ULL) ||
+        !checkRandomPackets("Random-Min-Processing-Time", &random_min_processing_time_queue_model, 0x9d8aebabed803bb6ULL) ||
+        !checkSameDelays("History-List-Fast", &list_queue_model, &fast_list_queue_model) ||
+        !checkSameDelays("History-List-Fast-Min-Processing-Time", &min_processing_time_list_queue_model,
+                         &min_processing_time_fast_list_queue_model) )
+   {
+      fprintf(stderr, "History-Tree test: FAILED\n");
+      exit(EXIT_FAILURE);
+   }
+
    printf("History-Tree test: SUCCESS\n");
    CarbonStopSim();
-   
+
    return 0;
 }
@@ -0,0 +1,573 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <map>
+#include <vector>
+#include <string>
+using namespace std;
+
+#include "simulator.h"
+#include "tile_manager.h"
+#include "tile.h"
+#include "network.h"
+#include "smtransport.h"
+#include "message_buffer.h"
+#include "packetize.h"
+#include "cache.h"
+#include "cache_set.h"
+#include "cache_line_info.h"
+#include "cache_replacement_policy.h"
+#include "cache_hash_fn.h"
+#include "directory_cache.h"
+#include "pr_l1_pr_l2_dram_directory_msi/cache_level.h"
+#include "queue_model.h"
+#include "interval_tree.h"
+#include "carbon_user.h"
+#include "config.h"
+#include "utils.h"
+#include "log.h"
+
+// Micro-benchmarks of the hot components of the simulator, natively, under
+// the Carbon runtime (the components read their parameters from the cfg
+// file, some need a tile). Each benchmark runs its operation num_ops times
+// on data set up beforehand, after a warmup of a tenth of that, and reports
+// the wall clock time (in ns) and the heap allocations (operator new calls
+// of the benchmark thread) per operation, on stdout and in
+// <output_dir>/bench_components.csv.
+//   With [bench_components] baseline set to the csv of an earlier run, a
+// benchmark more than 'tolerance' slower than in the baseline, or that
+// allocates more, is a regression and the run fails.
+
+// Allocations of the current thread, counted by the operator new below
+static __thread UInt64 _num_allocations = 0;
+
+void* operator new(size_t size) throw(std::bad_alloc)
+{
+   _num_allocations ++;
+   void* ptr = malloc(size ? size : 1);
+   if (ptr == NULL)
+      throw std::bad_alloc();
+   return ptr;
+}
+
+void* operator new[](size_t size) throw(std::bad_alloc)
+{
+   return operator new(size);
+}
+
+void operator delete(void* ptr) throw()
+{
+   free(ptr);
+}
+
+void operator delete[](void* ptr) throw()
+{
+   free(ptr);
+}
+
+static UInt64 getTimeNs()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ((UInt64) ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+// Same sequence on every run, so that the runs compare
+static UInt32 _random_state = 12345;
+static UInt32 getRandom()
+{
+   _random_state = _random_state * 1103515245 + 12345;
+   return (_random_state >> 8);
+}
+
+// Number of precomputed operands of a benchmark (a power of 2, operation i
+// uses operand i % NUM_OPERANDS)
+static const UInt32 NUM_OPERANDS = 4096;
+
+class Benchmark
+{
+public:
+   Benchmark(string name) : _name(name) {}
+   virtual ~Benchmark() {}
+
+   const string& getName() const { return _name; }
+   virtual void run(UInt64 num_ops) = 0;
+
+private:
+   string _name;
+};
+
+// Cache::accessCacheLine, loads that hit in a 32 KB, 8-way L1
+class CacheAccessBenchmark : public Benchmark
+{
+public:
+   CacheAccessBenchmark()
+      : Benchmark("cache_access_hit")
+   {
+      _replacement_policy = CacheReplacementPolicy::create("lru", 32, 8, 64);
+      _hash_fn = new CacheHashFn(32, 8, 64);
+      _cache = new Cache("L1-D", PR_L1_PR_L2_DRAM_DIRECTORY_MSI, Cache::DATA_CACHE, PrL1PrL2DramDirectoryMSI::L1,
+                         Cache::WRITE_BACK, 32, 8, 64, _replacement_policy, _hash_fn, 1, 1.0);
+
+      // Half of the lines, so that no insertion evicts another
+      Byte fill_buf[64];
+      memset(fill_buf, 0, sizeof(fill_buf));
+      CacheLineInfo* inserted_info = CacheLineInfo::create(PR_L1_PR_L2_DRAM_DIRECTORY_MSI, PrL1PrL2DramDirectoryMSI::L1);
+      CacheLineInfo* evicted_info = CacheLineInfo::create(PR_L1_PR_L2_DRAM_DIRECTORY_MSI, PrL1PrL2DramDirectoryMSI::L1);
+      for (UInt32 i = 0; i < NUM_LINES; i++)
+      {
+         bool eviction;
+         IntPtr evicted_address;
+         inserted_info->setTag(_cache->getTag(i * 64));
+         inserted_info->setCState(CacheState::SHARED);
+         _cache->insertCacheLine(i * 64, inserted_info, fill_buf, &eviction, &evicted_address, evicted_info, NULL);
+      }
+      delete inserted_info;
+      delete evicted_info;
+
+      for (UInt32 i = 0; i < NUM_OPERANDS; i++)
+         _addresses[i] = (getRandom() % NUM_LINES) * 64 + (getRandom() % 8) * 8;
+   }
+   ~CacheAccessBenchmark()
+   {
+      delete _cache;
+      delete _hash_fn;
+      delete _replacement_policy;
+   }
+
+   void run(UInt64 num_ops)
+   {
+      Byte buf[8];
+      for (UInt64 i = 0; i < num_ops; i++)
+         _cache->accessCacheLine(_addresses[i & (NUM_OPERANDS-1)], Cache::LOAD, buf, sizeof(buf));
+   }
+
+private:
+   static const UInt32 NUM_LINES = 256;
+   CacheReplacementPolicy* _replacement_policy;
+   CacheHashFn* _hash_fn;
+   Cache* _cache;
+   IntPtr _addresses[NUM_OPERANDS];
+};
+
+// CacheSet::find in a full 8-way set, of the tags in the set (hit) or not
+class CacheSetFindBenchmark : public Benchmark
+{
+public:
+   CacheSetFindBenchmark(bool hit)
+      : Benchmark(hit ? "cache_set_find_hit" : "cache_set_find_miss")
+   {
+      _replacement_policy = CacheReplacementPolicy::create("lru", 32, ASSOCIATIVITY, 64);
+      _set = new CacheSet(0, PR_L1_PR_L2_DRAM_DIRECTORY_MSI, PrL1PrL2DramDirectoryMSI::L1,
+                          _replacement_policy, ASSOCIATIVITY, 64, NULL);
+
+      CacheLineInfo* inserted_info = CacheLineInfo::create(PR_L1_PR_L2_DRAM_DIRECTORY_MSI, PrL1PrL2DramDirectoryMSI::L1);
+      CacheLineInfo* evicted_info = CacheLineInfo::create(PR_L1_PR_L2_DRAM_DIRECTORY_MSI, PrL1PrL2DramDirectoryMSI::L1);
+      for (UInt32 i = 0; i < ASSOCIATIVITY; i++)
+      {
+         bool eviction;
+         inserted_info->setTag(i * 64);
+         inserted_info->setCState(CacheState::SHARED);
+         _set->insert(inserted_info, NULL, &eviction, evicted_info, NULL);
+      }
+      delete inserted_info;
+      delete evicted_info;
+
+      for (UInt32 i = 0; i < NUM_OPERANDS; i++)
+         _tags[i] = ((getRandom() % ASSOCIATIVITY) + (hit ? 0 : ASSOCIATIVITY)) * 64;
+   }
+   ~CacheSetFindBenchmark()
+   {
+      delete _set;
+      delete _replacement_policy;
+   }
+
+   void run(UInt64 num_ops)
+   {
+      UInt32 line_index;
+      for (UInt64 i = 0; i < num_ops; i++)
+         _set->find(_tags[i & (NUM_OPERANDS-1)], &line_index);
+   }
+
+private:
+   static const UInt32 ASSOCIATIVITY = 8;
+   CacheReplacementPolicy* _replacement_policy;
+   CacheSet* _set;
+   IntPtr _tags[NUM_OPERANDS];
+};
+
+// QueueModel::computeQueueDelay of a queue model type, at a utilization of
+// about 0.5, with the requests slightly out of order
+class QueueModelBenchmark : public Benchmark
+{
+public:
+   QueueModelBenchmark(string type)
+      : Benchmark("queue_model_" + type)
+      , _time(0)
+   {
+      _queue_model = QueueModel::create(type, PROCESSING_TIME);
+      for (UInt32 i = 0; i < NUM_OPERANDS; i++)
+         _jitter[i] = getRandom() % (4 * PROCESSING_TIME);
+   }
+   ~QueueModelBenchmark()
+   {
+      delete _queue_model;
+   }
+
+   void run(UInt64 num_ops)
+   {
+      for (UInt64 i = 0; i < num_ops; i++)
+      {
+         _time += 2 * PROCESSING_TIME;
+         _queue_model->computeQueueDelay(_time + _jitter[i & (NUM_OPERANDS-1)], PROCESSING_TIME);
+      }
+   }
+
+private:
+   static const UInt64 PROCESSING_TIME = 4;
+   QueueModel* _queue_model;
+   UInt64 _time;
+   UInt64 _jitter[NUM_OPERANDS];
+};
+
+// IntervalTree of NUM_INTERVALS intervals [20k + 10, 20k + 20): search, or
+// insert and remove of an interval in a gap
+class IntervalTreeBenchmark : public Benchmark
+{
+public:
+   IntervalTreeBenchmark(bool search)
+      : Benchmark(search ? "interval_tree_search" : "interval_tree_insert_remove")
+      , _search(search)
+   {
+      _tree = new IntervalTree(2 * NUM_INTERVALS);
+      for (UInt32 i = 0; i < NUM_INTERVALS; i++)
+         _tree->insert(i, 20 * i + 10, 20 * i + 20);
+
+      for (UInt32 i = 0; i < NUM_OPERANDS; i++)
+      {
+         // Before the start of the last interval, so that one is found
+         _times[i] = getRandom() % (20 * (NUM_INTERVALS - 1));
+         _lengths[i] = 1 + (getRandom() % 10);
+         _indices[i] = getRandom() % NUM_INTERVALS;
+      }
+   }
+   ~IntervalTreeBenchmark()
+   {
+      delete _tree;
+   }
+
+   void run(UInt64 num_ops)
+   {
+      if (_search)
+      {
+         for (UInt64 i = 0; i < num_ops; i++)
+            _tree->search(_times[i & (NUM_OPERANDS-1)], _lengths[i & (NUM_OPERANDS-1)]);
+      }
+      else
+      {
+         for (UInt64 i = 0; i < num_ops; i++)
+         {
+            UInt32 index = _indices[i & (NUM_OPERANDS-1)];
+            _tree->insert(index, 20 * index, 20 * index + 5);
+            _tree->remove(index);
+         }
+      }
+   }
+
+private:
+   static const UInt32 NUM_INTERVALS = 512;
+   bool _search;
+   IntervalTree* _tree;
+   UInt64 _times[NUM_OPERANDS];
+   UInt64 _lengths[NUM_OPERANDS];
+   UInt32 _indices[NUM_OPERANDS];
+};
+
+// UnstructuredBuffer encode and decode of a coherence message: a few
+// scalars and a cache line
+class UnstructuredBufferBenchmark : public Benchmark
+{
+public:
+   UnstructuredBufferBenchmark()
+      : Benchmark("unstructured_buffer_encode_decode")
+   {
+      memset(_line, 0x5a, sizeof(_line));
+   }
+
+   void run(UInt64 num_ops)
+   {
+      Byte line[64];
+      for (UInt64 i = 0; i < num_ops; i++)
+      {
+         _buffer.clear();
+         UInt32 type = 1;
+         SInt32 sender = 2;
+         IntPtr address = i * 64;
+         UInt32 length = sizeof(_line);
+         _buffer << type << sender << address << length;
+         _buffer.put(_line, sizeof(_line));
+
+         _buffer >> type >> sender >> address >> length;
+         _buffer.get(line, sizeof(line));
+      }
+   }
+
+private:
+   UnstructuredBuffer _buffer;
+   Byte _line[64];
+};
+
+// SmTransport send and recv of a packet between two nodes, of a transport
+// of its own (not the one of the simulator)
+class SmTransportBenchmark : public Benchmark
+{
+public:
+   SmTransportBenchmark()
+      : Benchmark("sm_transport_send_recv")
+   {
+      // The transport is not deleted: ~Transport releases the message buffer
+      // pool that the transport of the simulator also uses
+      _transport = new SmTransport();
+      _sender = _transport->createNode(0);
+      _receiver = _transport->createNode(1);
+      memset(_data, 0, sizeof(_data));
+   }
+   ~SmTransportBenchmark()
+   {
+      delete _sender;
+      delete _receiver;
+   }
+
+   void run(UInt64 num_ops)
+   {
+      for (UInt64 i = 0; i < num_ops; i++)
+      {
+         _sender->send(1, _data, sizeof(_data));
+         MessageBuffer::release(_receiver->recv());
+      }
+   }
+
+private:
+   Transport* _transport;
+   Transport::Node* _sender;
+   Transport::Node* _receiver;
+   Byte _data[64];
+};
+
+// NetQueue matching of netRecv: a packet is pushed, then one is popped, from
+// a queue of NUM_QUEUED packets from NUM_SENDERS senders, of two types. The
+// match is on a sender and a type, or on any packet
+class NetQueueBenchmark : public Benchmark
+{
+public:
+   NetQueueBenchmark(bool match_sender)
+      : Benchmark(match_sender ? "net_queue_match_sender" : "net_queue_match_any")
+      , _match_sender(match_sender)
+   {
+      for (UInt32 i = 0; i < NUM_QUEUED; i++)
+         _queue.push(createPacket(i, i % NUM_SENDERS, (i / NUM_SENDERS) % 2));
+
+      for (UInt32 i = 0; i < NUM_OPERANDS; i++)
+      {
+         _packets[i] = createPacket(NUM_QUEUED + i, getRandom() % NUM_SENDERS, getRandom() % 2);
+         _matches[i].receiver = _packets[i].receiver;
+         if (_match_sender)
+         {
+            _matches[i].senders.push_back(_packets[i].sender);
+            _matches[i].types.push_back(_packets[i].type);
+         }
+      }
+   }
+
+   void run(UInt64 num_ops)
+   {
+      NetPacket packet;
+      for (UInt64 i = 0; i < num_ops; i++)
+      {
+         const NetMatch& match = _matches[i & (NUM_OPERANDS-1)];
+         _queue.push(_packets[i & (NUM_OPERANDS-1)]);
+         _queue.pop(match, match.receiver, packet);
+      }
+   }
+
+private:
+   static const UInt32 NUM_SENDERS = 16;
+   static const UInt32 NUM_QUEUED = 64;
+   bool _match_sender;
+   NetQueue _queue;
+   NetPacket _packets[NUM_OPERANDS];
+   NetMatch _matches[NUM_OPERANDS];
+
+   static NetPacket createPacket(UInt64 time, SInt32 sender, UInt32 type)
+   {
+      return NetPacket(time, (type == 0) ? SHARED_MEM_1 : SHARED_MEM_2, sender, 0, 0, NULL);
+   }
+};
+
+// DirectoryCache::getDirectoryEntry of entries present in a 4096-entry,
+// 16-way full map directory
+class DirectoryCacheBenchmark : public Benchmark
+{
+public:
+   DirectoryCacheBenchmark()
+      : Benchmark("directory_cache_lookup")
+   {
+      UInt32 num_tiles = Config::getSingleton()->getApplicationTiles();
+      _directory_cache = new DirectoryCache(Sim()->getTileManager()->getTileFromID(0),
+                                            PR_L1_PR_L2_DRAM_DIRECTORY_MSI, "full_map", "4096", 16, 64,
+                                            num_tiles, num_tiles, 1, "1");
+
+      // The sets fill up unevenly, the lookups are of the entries created
+      vector<IntPtr> addresses;
+      for (UInt32 i = 0; i < 4096; i++)
+      {
+         if (_directory_cache->getDirectoryEntry(i * 64))
+            addresses.push_back(i * 64);
+      }
+      LOG_ASSERT_ERROR(!addresses.empty(), "No directory entry created");
+      for (UInt32 i = 0; i < NUM_OPERANDS; i++)
+         _addresses[i] = addresses[getRandom() % addresses.size()];
+   }
+   ~DirectoryCacheBenchmark()
+   {
+      delete _directory_cache;
+   }
+
+   void run(UInt64 num_ops)
+   {
+      for (UInt64 i = 0; i < num_ops; i++)
+         _directory_cache->getDirectoryEntry(_addresses[i & (NUM_OPERANDS-1)]);
+   }
+
+private:
+   DirectoryCache* _directory_cache;
+   IntPtr _addresses[NUM_OPERANDS];
+};
+
+struct Result
+{
+   double ns_per_op;
+   double allocations_per_op;
+};
+
+static Result runBenchmark(Benchmark* benchmark, UInt64 num_ops)
+{
+   benchmark->run(max<UInt64>(num_ops / 10, 1));
+
+   UInt64 start_allocations = _num_allocations;
+   UInt64 start_time = getTimeNs();
+   benchmark->run(num_ops);
+   UInt64 end_time = getTimeNs();
+   UInt64 end_allocations = _num_allocations;
+
+   Result result;
+   result.ns_per_op = ((double) (end_time - start_time)) / num_ops;
+   result.allocations_per_op = ((double) (end_allocations - start_allocations)) / num_ops;
+   return result;
+}
+
+// Results of the csv of an earlier run
+static map<string, Result> readBaseline(string filename)
+{
+   map<string, Result> baseline;
+   FILE* file = fopen(filename.c_str(), "r");
+   LOG_ASSERT_ERROR(file, "Could not open bench_components baseline(%s)", filename.c_str());
+
+   char line[256];
+   char name[256];
+   Result result;
+   while (fgets(line, sizeof(line), file))
+   {
+      // The header does not parse
+      if (sscanf(line, "%255[^,],%lf,%lf", name, &result.ns_per_op, &result.allocations_per_op) == 3)
+         baseline[name] = result;
+   }
+   fclose(file);
+   return baseline;
+}
+
+int main(int argc, char* argv[])
+{
+   CarbonStartSim(argc, argv);
+
+   UInt64 num_ops = 0;
+   string filter;
+   string baseline_filename;
+   double tolerance = 0.0;
+   try
+   {
+      num_ops = (UInt64) Sim()->getCfg()->getInt("bench_components/num_ops", 1000000);
+      filter = Sim()->getCfg()->getString("bench_components/filter", "");
+      baseline_filename = Sim()->getCfg()->getString("bench_components/baseline", "");
+      tolerance = Sim()->getCfg()->getFloat("bench_components/tolerance", 0.2);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read [bench_components] parameters from the cfg file");
+   }
+   LOG_ASSERT_ERROR(num_ops > 0, "[bench_components] num_ops must be positive");
+
+   map<string, Result> baseline;
+   if (baseline_filename != "")
+      baseline = readBaseline(baseline_filename);
+
+   vector<Benchmark*> benchmarks;
+   benchmarks.push_back(new CacheAccessBenchmark());
+   benchmarks.push_back(new CacheSetFindBenchmark(true));
+   benchmarks.push_back(new CacheSetFindBenchmark(false));
+   benchmarks.push_back(new QueueModelBenchmark("basic"));
+   benchmarks.push_back(new QueueModelBenchmark("history_list"));
+   benchmarks.push_back(new QueueModelBenchmark("history_tree"));
+   benchmarks.push_back(new QueueModelBenchmark("history_list_fast"));
+   benchmarks.push_back(new QueueModelBenchmark("windowed"));
+   benchmarks.push_back(new IntervalTreeBenchmark(true));
+   benchmarks.push_back(new IntervalTreeBenchmark(false));
+   benchmarks.push_back(new UnstructuredBufferBenchmark());
+   benchmarks.push_back(new SmTransportBenchmark());
+   benchmarks.push_back(new NetQueueBenchmark(true));
+   benchmarks.push_back(new NetQueueBenchmark(false));
+   benchmarks.push_back(new DirectoryCacheBenchmark());
+
+   string output_filename = Config::getSingleton()->formatOutputFileName("bench_components.csv");
+   FILE* output_file = fopen(output_filename.c_str(), "w");
+   LOG_ASSERT_ERROR(output_file, "Could not open %s", output_filename.c_str());
+   fprintf(output_file, "benchmark,ns_per_op,allocations_per_op\n");
+
+   UInt32 num_regressions = 0;
+   for (UInt32 i = 0; i < benchmarks.size(); i++)
+   {
+      Benchmark* benchmark = benchmarks[i];
+      if (benchmark->getName().find(filter) == string::npos)
+         continue;
+
+      Result result = runBenchmark(benchmark, num_ops);
+      fprintf(output_file, "%s,%g,%g\n", benchmark->getName().c_str(), result.ns_per_op, result.allocations_per_op);
+      printf("[bench_components] %-36s %10.2f ns/op %8.3f allocs/op", benchmark->getName().c_str(),
+             result.ns_per_op, result.allocations_per_op);
+
+      map<string, Result>::iterator it = baseline.find(benchmark->getName());
+      if (it != baseline.end())
+      {
+         const Result& base = it->second;
+         bool regression = (result.ns_per_op > base.ns_per_op * (1.0 + tolerance)) ||
+                           (result.allocations_per_op > base.allocations_per_op + 0.001);
+         printf("   (baseline %.2f ns/op %.3f allocs/op)%s", base.ns_per_op, base.allocations_per_op,
+                regression ? " REGRESSION" : "");
+         if (regression)
+            num_regressions ++;
+      }
+      printf("\n");
+   }
+   fclose(output_file);
+
+   for (UInt32 i = 0; i < benchmarks.size(); i++)
+      delete benchmarks[i];
+
+   if (baseline_filename != "")
+      printf("[bench_components] %u regressions against %s\n", num_regressions, baseline_filename.c_str());
+
+   CarbonStopSim();
+   return (num_regressions > 0) ? 1 : 0;
+}
@@ -0,0 +1,347 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <pthread.h>
+#include <vector>
+#include <string>
+using namespace std;
+
+#include "simulator.h"
+#include "instruction_trace.h"
+#include "carbon_user.h"
+#include "config.h"
+#include "lock.h"
+#include "utils.h"
+#include "log.h"
+
+// Miss-rate curves of the instruction stream traces of a recorded run
+// ([trace_record] enabled = true, in [trace_replay] directory), natively:
+// every trace is read once per line size, and the accesses of its tile go
+// through an LRU stack per set for every number of sets at once (Mattson's
+// stack distances), which gives the misses of every associativity up to
+// max_associativity in the same pass.
+//   l1_icache - the instruction fetches (the lines of the basic blocks)
+//   l1_dcache - the memory accesses
+//   l2_cache  - the misses of the L1 caches of the cfg file (LRU), both
+// for the sizes (in KB) in [min_size, max_size] with power of 2 sets and
+// ways. The traces are processed by 'threads' host threads (0: one per host
+// core). Writes <output_dir>/cache_curves.csv, a row per tile, level and
+// geometry, and prints the curves of all tiles together.
+
+static vector<UInt32> _line_sizes;
+static UInt64 _min_size = 4;
+static UInt64 _max_size = 4096;
+static UInt32 _max_associativity = 16;
+static string _trace_directory;
+
+enum CacheLevel
+{
+   L1_ICACHE = 0,
+   L1_DCACHE,
+   L2_CACHE,
+   NUM_CACHE_LEVELS
+};
+static const char* _cache_level_names[NUM_CACHE_LEVELS] = { "l1_icache", "l1_dcache", "l2_cache" };
+
+// The LRU stacks of all the sets of one number of sets: the lines of a set
+// are ordered from the most recently used, up to max_associativity of them
+class StackDistanceProfile
+{
+public:
+   StackDistanceProfile(UInt32 num_sets, UInt32 max_associativity):
+      m_num_sets(num_sets),
+      m_max_associativity(max_associativity),
+      m_lines(num_sets * max_associativity),
+      m_set_sizes(num_sets, 0),
+      m_hits(max_associativity, 0),
+      m_num_accesses(0)
+   {}
+
+   // Returns the stack distance of the line, max_associativity if it is
+   // not in the stack of its set
+   UInt32 access(IntPtr line)
+   {
+      m_num_accesses ++;
+      UInt32 set_index = line & (m_num_sets - 1);
+      IntPtr* set = &m_lines[set_index * m_max_associativity];
+      UInt32& size = m_set_sizes[set_index];
+
+      UInt32 distance = 0;
+      while ((distance < size) && (set[distance] != line))
+         distance ++;
+
+      bool hit = (distance < size);
+      UInt32 shift = distance;
+      if (hit)
+         m_hits[distance] ++;
+      else if (size < m_max_associativity)
+         size ++;                               // The line takes a free way
+      else
+         shift = m_max_associativity - 1;       // The least recently used line is evicted
+      memmove(&set[1], &set[0], shift * sizeof(IntPtr));
+      set[0] = line;
+      return hit ? distance : m_max_associativity;
+   }
+
+   UInt32 getNumSets() const { return m_num_sets; }
+   UInt64 getNumAccesses() const { return m_num_accesses; }
+   UInt64 getNumMisses(UInt32 associativity) const
+   {
+      UInt64 num_hits = 0;
+      for (UInt32 i = 0; i < associativity; i++)
+         num_hits += m_hits[i];
+      return m_num_accesses - num_hits;
+   }
+
+private:
+   UInt32 m_num_sets;
+   UInt32 m_max_associativity;
+   vector<IntPtr> m_lines;
+   vector<UInt32> m_set_sizes;
+   vector<UInt64> m_hits;
+   UInt64 m_num_accesses;
+};
+
+// An LRU cache, to filter the accesses that reach the L2 cache
+class LruCache
+{
+public:
+   LruCache(UInt32 size, UInt32 associativity, UInt32 line_size):
+      m_line_size_log(floorLog2(line_size)),
+      m_associativity(associativity),
+      m_stacks(size / (associativity * line_size), associativity)
+   {}
+
+   bool access(IntPtr address)
+   {
+      return (m_stacks.access(address >> m_line_size_log) < m_associativity);
+   }
+
+private:
+   UInt32 m_line_size_log;
+   UInt32 m_associativity;
+   StackDistanceProfile m_stacks;
+};
+
+// The profiles of a trace for one line size, the unit of work of a thread
+struct Profile
+{
+   tile_id_t tile_id;
+   UInt32 line_size;
+   vector<StackDistanceProfile*> stacks[NUM_CACHE_LEVELS];
+};
+
+static vector<Profile*> _profiles;
+static UInt32 _next_profile = 0;
+static Lock _lock;
+
+static void accessLevel(Profile* profile, CacheLevel level, IntPtr address)
+{
+   IntPtr line = address >> floorLog2(profile->line_size);
+   for (UInt32 i = 0; i < profile->stacks[level].size(); i++)
+      profile->stacks[level][i]->access(line);
+}
+
+static LruCache* createL1Cache(string cache_type)
+{
+   UInt32 line_size = 0;
+   UInt32 size = 0;
+   UInt32 associativity = 0;
+   try
+   {
+      line_size = Sim()->getCfg()->getInt(cache_type + "/cache_line_size");
+      size = Sim()->getCfg()->getInt(cache_type + "/cache_size");
+      associativity = Sim()->getCfg()->getInt(cache_type + "/associativity");
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read [%s] parameters from the cfg file", cache_type.c_str());
+   }
+   return new LruCache(size * 1024, associativity, line_size);
+}
+
+static void computeProfile(Profile* profile)
+{
+   tile_id_t tile_id = profile->tile_id;
+   LruCache* l1_icache = createL1Cache("l1_icache/" + Config::getSingleton()->getL1ICacheType(tile_id));
+   LruCache* l1_dcache = createL1Cache("l1_dcache/" + Config::getSingleton()->getL1DCacheType(tile_id));
+
+   InstructionTraceReader trace_reader(InstructionTrace::getFileName(_trace_directory, tile_id), false);
+   InstructionTraceReader::Record record;
+   IntPtr last_fetch_line = INVALID_ADDRESS;
+   while (trace_reader.readRecord(record))
+   {
+      if (record.type == InstructionTrace::BASIC_BLOCK)
+      {
+         // A fetch per line of the instructions
+         for (UInt32 i = 0; i < record.basic_block->size(); i++)
+         {
+            IntPtr address = (*record.basic_block)[i]->getAddress();
+            IntPtr fetch_line = address >> floorLog2(profile->line_size);
+            if (fetch_line == last_fetch_line)
+               continue;
+            last_fetch_line = fetch_line;
+            accessLevel(profile, L1_ICACHE, address);
+            if (!l1_icache->access(address))
+               accessLevel(profile, L2_CACHE, address);
+         }
+      }
+      else if (record.type == InstructionTrace::MEMORY_ACCESS)
+      {
+         accessLevel(profile, L1_DCACHE, record.address);
+         if (!l1_dcache->access(record.address))
+            accessLevel(profile, L2_CACHE, record.address);
+      }
+   }
+
+   delete l1_icache;
+   delete l1_dcache;
+}
+
+static void* computeProfiles(void*)
+{
+   while (true)
+   {
+      Profile* profile;
+      {
+         ScopedLock sl(_lock);
+         if (_next_profile == _profiles.size())
+            return NULL;
+         profile = _profiles[_next_profile ++];
+      }
+      computeProfile(profile);
+   }
+}
+
+static bool traceExists(string filename)
+{
+   return (access(filename.c_str(), R_OK) == 0);
+}
+
+int main(int argc, char* argv[])
+{
+   CarbonStartSim(argc, argv);
+
+   SInt32 num_threads = 0;
+   string line_sizes;
+   try
+   {
+      line_sizes = Sim()->getCfg()->getString("cache_curves/line_sizes", "64");
+      _min_size = Sim()->getCfg()->getInt("cache_curves/min_size", 4);
+      _max_size = Sim()->getCfg()->getInt("cache_curves/max_size", 4096);
+      _max_associativity = Sim()->getCfg()->getInt("cache_curves/max_associativity", 16);
+      num_threads = Sim()->getCfg()->getInt("cache_curves/threads", 0);
+      _trace_directory = Sim()->getCfg()->getString("trace_replay/directory", ".");
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read [cache_curves] parameters from the cfg file");
+   }
+   LOG_ASSERT_ERROR(isPower2(_max_associativity), "max_associativity(%u) must be a power of 2", _max_associativity);
+   LOG_ASSERT_ERROR(isPower2(_min_size) && (_min_size <= _max_size), "Need power of 2 min_size(%llu) <= max_size(%llu)",
+                    (unsigned long long) _min_size, (unsigned long long) _max_size);
+   vector<string> line_size_list;
+   parseList(line_sizes, line_size_list, ",");
+   for (vector<string>::iterator it = line_size_list.begin(); it != line_size_list.end(); it++)
+   {
+      UInt32 line_size = convertFromString<UInt32>(*it);
+      LOG_ASSERT_ERROR(isPower2(line_size), "Line size(%u) must be a power of 2", line_size);
+      _line_sizes.push_back(line_size);
+   }
+   if (num_threads <= 0)
+      num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+   // A profile per trace and line size, with the numbers of sets of the
+   // sizes in [min_size, max_size]
+   SInt32 num_tiles = (SInt32) Config::getSingleton()->getApplicationTiles();
+   for (tile_id_t tile_id = 0; tile_id < num_tiles; tile_id++)
+   {
+      if (!traceExists(InstructionTrace::getFileName(_trace_directory, tile_id)))
+         continue;
+      for (UInt32 i = 0; i < _line_sizes.size(); i++)
+      {
+         Profile* profile = new Profile();
+         profile->tile_id = tile_id;
+         profile->line_size = _line_sizes[i];
+         for (UInt64 num_sets = 1; num_sets * _line_sizes[i] <= _max_size * 1024; num_sets *= 2)
+         {
+            if (num_sets * _line_sizes[i] * _max_associativity < _min_size * 1024)
+               continue;
+            for (UInt32 level = 0; level < NUM_CACHE_LEVELS; level++)
+               profile->stacks[level].push_back(new StackDistanceProfile(num_sets, _max_associativity));
+         }
+         _profiles.push_back(profile);
+      }
+   }
+   LOG_ASSERT_ERROR(!_profiles.empty(), "No instruction traces in %s", _trace_directory.c_str());
+
+   vector<pthread_t> threads(num_threads);
+   for (SInt32 i = 0; i < num_threads; i++)
+      pthread_create(&threads[i], NULL, computeProfiles, NULL);
+   for (SInt32 i = 0; i < num_threads; i++)
+      pthread_join(threads[i], NULL);
+
+   string output_filename = Config::getSingleton()->formatOutputFileName("cache_curves.csv");
+   FILE* output_file = fopen(output_filename.c_str(), "w");
+   LOG_ASSERT_ERROR(output_file, "Could not open %s", output_filename.c_str());
+   fprintf(output_file, "tile,level,line_size,num_sets,associativity,size,accesses,misses,miss_rate\n");
+
+   // The curves of all the tiles together: the fewest misses of a size, by
+   // level and line size
+   printf("[cache_curves] %u traces, miss rate of all the tiles by size (in KB), best associativity\n",
+          (UInt32) (_profiles.size() / _line_sizes.size()));
+   for (UInt32 level = 0; level < NUM_CACHE_LEVELS; level++)
+   {
+      for (UInt32 i = 0; i < _line_sizes.size(); i++)
+      {
+         printf("%s, line size %u:", _cache_level_names[level], _line_sizes[i]);
+         for (UInt64 size = _min_size; size <= _max_size; size *= 2)
+         {
+            UInt64 best_accesses = 0;
+            UInt64 best_misses = 0;
+            UInt32 best_associativity = 0;
+            for (UInt32 associativity = 1; associativity <= _max_associativity; associativity *= 2)
+            {
+               UInt64 accesses = 0;
+               UInt64 misses = 0;
+               bool found = false;
+               for (UInt32 j = 0; j < _profiles.size(); j++)
+               {
+                  Profile* profile = _profiles[j];
+                  if (profile->line_size != _line_sizes[i])
+                     continue;
+                  for (UInt32 k = 0; k < profile->stacks[level].size(); k++)
+                  {
+                     StackDistanceProfile* stacks = profile->stacks[level][k];
+                     if (((UInt64) stacks->getNumSets()) * associativity * _line_sizes[i] != size * 1024)
+                        continue;
+                     found = true;
+                     accesses += stacks->getNumAccesses();
+                     misses += stacks->getNumMisses(associativity);
+                     fprintf(output_file, "%i,%s,%u,%u,%u,%llu,%llu,%llu,%g\n", profile->tile_id, _cache_level_names[level],
+                             _line_sizes[i], stacks->getNumSets(), associativity, (unsigned long long) size,
+                             (unsigned long long) stacks->getNumAccesses(),
+                             (unsigned long long) stacks->getNumMisses(associativity),
+                             (stacks->getNumAccesses() > 0) ? (((double) stacks->getNumMisses(associativity)) / stacks->getNumAccesses()) : 0.0);
+                  }
+               }
+               if (found && ((best_associativity == 0) || (misses < best_misses)))
+               {
+                  best_accesses = accesses;
+                  best_misses = misses;
+                  best_associativity = associativity;
+               }
+            }
+            if (best_associativity > 0)
+               printf(" %llu:%.4f(%u)", (unsigned long long) size,
+                      (best_accesses > 0) ? (((double) best_misses) / best_accesses) : 0.0, best_associativity);
+         }
+         printf("\n");
+      }
+   }
+   fclose(output_file);
+
+   CarbonStopSim();
+   return 0;
+}
@@ -4,6 +4,14 @@
 This is the server process that listens for spawn requests
 and then spawns the simulator with the appropriate
 environment variable set for that process number
+
+The daemon also keeps a warm cache directory (in shared memory by default)
+with the McPAT and DSENT results of the runs it spawns ([general]
+warm_cache_dir): the first run of a configuration computes them, the later
+runs load them instead of running McPAT and DSENT. The directory outlives
+the runs and is kept across restarts of the daemon.
+
+usage: carbon_simd.py [--warm-cache-dir=<dir>] [--no-warm-cache]
 """
 
 import socket
@@ -15,6 +23,7 @@ import threading
 
 running_process_list = []
 listen_port = 1999
+warm_cache_dir = "/dev/shm/carbon_warm_cache_%d" % os.getuid()
 
 allowed_hosts = ["127.0.0.1", "cagnode1", "cagnode2",
         "cagnode3", "cagnode4", "cagnode5", "cagnode6", "cagnode7",
@@ -63,6 +72,8 @@ def spawn_process(number,command,socket):
     env = {}
     env["CARBON_PROCESS_INDEX"] = str(number)
     env["LD_LIBRARY_PATH"] = "/afs/csail/group/carbon/tools/boost_1_38_0/stage/lib"
+    if warm_cache_dir:
+        env["CARBON_WARM_CACHE_DIR"] = warm_cache_dir
 
     #subproc = subprocess.Popen(command, shell=True, env=env, stdout = subprocess.PIPE, stderr = subprocess.PIPE)
     subproc = subprocess.Popen(command, shell=True, env=env, stdout = socket, stderr = socket, stdin = socket)
@@ -77,6 +88,23 @@ def kill_all_processes():
     running_process_list = []
 
 
+def init_warm_cache():
+    if not warm_cache_dir:
+        return
+    if not os.path.isdir(warm_cache_dir):
+        os.makedirs(warm_cache_dir)
+    print "warm cache directory: %s" % warm_cache_dir
+
+def warm_cache_status():
+    if not warm_cache_dir:
+        return "none"
+    files = sorted(os.listdir(warm_cache_dir))
+    entries = []
+    for name in files:
+        path = os.path.join(warm_cache_dir, name)
+        entries.append("%s:%d" % (name, len(open(path).readlines())))
+    return "%s,%s" % (warm_cache_dir, ",".join(entries))
+
 def handle_command(data, client):
     if data[0] == 's':
         print "got spawn command: ", data
@@ -88,6 +116,11 @@ def handle_command(data, client):
         # Create a thread to watch the spawned process
         SimWatcher(process, client).start()
 
+    elif data[0] == 'w' and len(data) == 1:
+        # Location of the warm cache and the entries of its files
+        print "got warm cache status command."
+        client.send(warm_cache_status())
+        client.close()
     elif data[0] == 'c' and len(data) == 1:
         print "got close all command."
         kill_all_processes()
@@ -100,6 +133,17 @@ def handle_command(data, client):
         client.close()
         print "terminating connection"
 
+for arg in sys.argv[1:]:
+    if arg.startswith("--warm-cache-dir="):
+        warm_cache_dir = arg.split("=", 1)[1]
+    elif arg == "--no-warm-cache":
+        warm_cache_dir = ""
+    else:
+        print "usage: %s [--warm-cache-dir=<dir>] [--no-warm-cache]" % sys.argv[0]
+        sys.exit(-1)
+
+init_warm_cache()
+
 try:
     allowed_hosts = map(lambda x: socket.gethostbyname(x), allowed_hosts)
 except:
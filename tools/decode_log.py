@@ -0,0 +1,146 @@
+#!/usr/bin/env python
+
+# Decodes the binary logs (log/format = binary) into the lines of the text
+# logs, merged in timestamp order:
+#     decode_log.py output_files/log_*.bin > log_all
+
+import os
+import re
+import struct
+import sys
+
+BINARY_END = 0
+BINARY_STRING = 1
+BINARY_ENTRY = 2
+BINARY_INT = 3
+BINARY_FLOAT = 4
+BINARY_TEXT = 5
+
+MODULE_LENGTH = 10
+
+conversion = re.compile(r"%([-+ #0']*)(\*|\d+)?(?:\.(\*|\d*))?(?:hh|h|ll|l|q|j|z|t|L)?([diouxXeEfFgGaAcspn%])")
+
+class Reader:
+
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def done(self):
+        return self.pos >= len(self.data)
+
+    def read(self, fmt):
+        size = struct.calcsize(fmt)
+        values = struct.unpack(fmt, self.data[self.pos:self.pos + size])
+        self.pos += size
+        return values
+
+    def read_text(self):
+        (length,) = self.read("=I")
+        text = self.data[self.pos:self.pos + length].decode("latin-1")
+        self.pos += length
+        return text
+
+def to_signed(value):
+    if value >= (1 << 63):
+        return value - (1 << 64)
+    return value
+
+def format_message(fmt, args):
+
+    args = list(args)
+
+    def next_arg():
+        if len(args) == 0:
+            return 0
+        return args.pop(0)
+
+    def convert(m):
+        (flags, width, precision, kind) = m.groups()
+        if kind == "%":
+            return "%"
+        if kind == "n":
+            return ""
+        if width == "*":
+            width = str(to_signed(next_arg()))
+        if precision == "*":
+            precision = str(to_signed(next_arg()))
+        spec = "%" + flags.replace("'", "") + (width or "")
+        if precision is not None:
+            spec += "." + precision
+        value = next_arg()
+        if kind in "di":
+            return (spec + "d") % to_signed(value)
+        if kind == "p":
+            return (spec + "s") % ("0x%x" % value)
+        if kind == "c":
+            return (spec + "c") % chr(value & 0xff)
+        if kind in "aA":
+            return (spec + "s") % float(value).hex()
+        return (spec + kind) % value
+
+    return conversion.sub(convert, fmt)
+
+def module_name(filename):
+    return os.path.basename(filename)[:MODULE_LENGTH].ljust(MODULE_LENGTH)
+
+def decode(filename, entries):
+
+    f = open(filename, "rb")
+    data = f.read()
+    f.close()
+
+    if data[0:4] != b"GLOG":
+        sys.stderr.write("%s: not a binary log\n" % filename)
+        sys.exit(1)
+    reader = Reader(data[8:])
+    tid = re.sub(r"\D", "", os.path.basename(filename)) or "0"
+
+    strings = {}
+    while not reader.done():
+        (tag,) = reader.read("=B")
+        if tag == BINARY_STRING:
+            (address,) = reader.read("=Q")
+            strings[address] = reader.read_text()
+        elif tag == BINARY_ENTRY:
+            (time, fmt, source_file, line, tile_id, process_num, sim_thread) = reader.read("=QQQiiiB")
+            args = []
+            while True:
+                (kind,) = reader.read("=B")
+                if kind == BINARY_END:
+                    break
+                elif kind == BINARY_INT:
+                    args.append(reader.read("=Q")[0])
+                elif kind == BINARY_FLOAT:
+                    args.append(reader.read("=d")[0])
+                elif kind == BINARY_TEXT:
+                    args.append(reader.read_text())
+                else:
+                    sys.stderr.write("%s: bad argument kind %d\n" % (filename, kind))
+                    sys.exit(1)
+
+            module = module_name(strings[source_file])
+            if tile_id != -1:
+                prefix = "%-10d [%5s]  (%2d) [%2d]%s[%s:%4d]  " % (time, tid, process_num, tile_id, "* " if sim_thread else "  ", module, line)
+            elif process_num != -1:
+                prefix = "%-10d [%5s]  (%2d) [  ]  [%s:%4d]  " % (time, tid, process_num, module, line)
+            else:
+                prefix = "%-10d [%5s]  (  ) [  ]  [%s:%4d]  " % (time, tid, module, line)
+            entries.append((time, len(entries), prefix + format_message(strings[fmt], args)))
+        else:
+            sys.stderr.write("%s: bad record tag %d\n" % (filename, tag))
+            sys.exit(1)
+
+if __name__ == "__main__":
+
+    if len(sys.argv) < 2:
+        sys.stderr.write("Usage: %s log_<tid>.bin...\n" % sys.argv[0])
+        sys.exit(1)
+
+    entries = []
+    for filename in sys.argv[1:]:
+        decode(filename, entries)
+
+    entries.sort()
+    for (time, index, message) in entries:
+        sys.stdout.write(message + "\n")
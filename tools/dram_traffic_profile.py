@@ -0,0 +1,51 @@
+#!/usr/bin/env python
+
+# Writes the DRAM traffic profile of a run (the L2 cache misses of every tile)
+# for the memory controller placement search ([dram/placement] policy = profile)
+
+import re
+import sys
+from optparse import OptionParser
+
+def rowSearch(output_file_contents, num_tiles, heading, key):
+   key += "(.*)"
+   heading_found = False
+
+   for line in output_file_contents:
+      if heading_found:
+         match_key = re.search(key, line)
+         if match_key:
+            counts = line.split('|')
+            event_counts = counts[1:num_tiles+1]
+            for i in range(0, num_tiles):
+               if (len(event_counts[i].split()) == 0):
+                  event_counts[i] = "0.0"
+            return map(lambda x: float(x), event_counts)
+      else:
+         if (re.search(heading, line)):
+            heading_found = True
+
+   print "ERROR: Could not find key [%s,%s]" % (heading, key)
+   sys.exit(1)
+
+parser = OptionParser()
+parser.add_option("--input-file", dest="input_file", help="Graphite Output File (sim.out)")
+parser.add_option("--profile-file", dest="profile_file", help="DRAM Traffic Profile")
+parser.add_option("--num-tiles", dest="num_tiles", type="int", help="Number of Application Tiles")
+(options,args) = parser.parse_args()
+
+try:
+   output_file_contents = open(options.input_file, 'r').readlines()
+except IOError:
+   print "ERROR: Could not open file (%s)" % (options.input_file)
+   sys.exit(3)
+
+l2_cache_misses = rowSearch(output_file_contents, options.num_tiles, "Cache L2", "Cache Misses")
+
+profile_file = open(options.profile_file, 'w')
+profile_file.write("# <tile_id> <num_requests>, from %s\n" % (options.input_file))
+for tile_id in range(0, options.num_tiles):
+   profile_file.write("%d %d\n" % (tile_id, int(l2_cache_misses[tile_id])))
+profile_file.close()
+
+print "Written DRAM traffic profile: %s" % (options.profile_file)
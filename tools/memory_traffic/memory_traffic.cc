@@ -0,0 +1,261 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/time.h>
+#include <vector>
+#include <string>
+using namespace std;
+
+#include "simulator.h"
+#include "tile_manager.h"
+#include "tile.h"
+#include "core.h"
+#include "memory_manager.h"
+#include "clock_skew_minimization_object.h"
+#include "carbon_user.h"
+#include "config.h"
+#include "lock.h"
+#include "log.h"
+
+// Drives the memory subsystem of every tile with synthetic address streams,
+// natively, from a thread per tile ([memory_traffic]): each tile issues
+// num_accesses accesses of access_size bytes to its L1 data cache through
+// MemoryManager::coreInitiateMemoryAccess(), gap cycles after the previous
+// one completes. It reports the throughput of the simulator (accesses per
+// host second) and the simulated latency and miss rate, which exercises
+// the coherence protocol without Pin or an application.
+//   Patterns:
+//   stride            - each tile walks its own working_set with a stride
+//   random            - random lines of one working_set shared by all tiles
+//   producer_consumer - each tile writes the lines of its buffer in order
+//                       and reads those of the buffer of the previous tile
+//   migratory         - read then write of random lines of the shared
+//                       working_set, the lines migrate from tile to tile
+// In stride and random, write_fraction of the accesses are writes.
+
+enum TrafficPattern
+{
+   STRIDE = 0,
+   RANDOM,
+   PRODUCER_CONSUMER,
+   MIGRATORY
+};
+
+static TrafficPattern _pattern = STRIDE;
+static UInt64 _num_accesses = 10000;
+static UInt32 _access_size = 8;
+static double _write_fraction = 0.3;
+static UInt64 _working_set = 1024 * 1024;
+static UInt64 _stride = 64;
+static UInt64 _gap = 10;
+
+static SInt32 _num_tiles;
+static UInt32 _cache_line_size;
+static carbon_barrier_t _barrier;
+
+// The private working sets, and the buffers of producer_consumer, are after
+// the shared one
+static const IntPtr SHARED_BASE = 0x10000000;
+static IntPtr _private_base;
+
+static Lock _lock;
+static UInt64 _total_accesses = 0;
+static UInt64 _total_misses = 0;
+static UInt64 _total_latency = 0;
+static UInt64 _max_latency = 0;
+static UInt64 _completion_time = 0;
+
+static TrafficPattern parseTrafficPattern(string pattern)
+{
+   if (pattern == "stride")
+      return STRIDE;
+   else if (pattern == "random")
+      return RANDOM;
+   else if (pattern == "producer_consumer")
+      return PRODUCER_CONSUMER;
+   else if (pattern == "migratory")
+      return MIGRATORY;
+   LOG_PRINT_ERROR("Unrecognized memory traffic pattern(%s)", pattern.c_str());
+   return STRIDE;
+}
+
+static double getHostTime()
+{
+   struct timeval t;
+   gettimeofday(&t, NULL);
+   return t.tv_sec + t.tv_usec / 1e6;
+}
+
+struct AccessState
+{
+   UInt64 time;
+   UInt64 num_accesses;
+   UInt64 num_misses;
+   UInt64 total_latency;
+   UInt64 max_latency;
+};
+
+// One access that does not cross a line
+static void accessMemory(Tile* tile, Core::mem_op_t mem_op_type, IntPtr address, AccessState& state)
+{
+   Byte buf[_access_size];
+   memset(buf, 0, _access_size);
+
+   IntPtr line_address = address - (address % _cache_line_size);
+   UInt32 offset = address % _cache_line_size;
+   UInt64 start_time = state.time;
+   bool hit = tile->getMemoryManager()->coreInitiateMemoryAccess(MemComponent::L1_DCACHE, Core::NONE, mem_op_type,
+                                                                line_address, offset, buf, _access_size,
+                                                                state.time, true);
+   UInt64 latency = state.time - start_time;
+
+   state.num_accesses ++;
+   if (!hit)
+      state.num_misses ++;
+   state.total_latency += latency;
+   state.max_latency = max<UInt64>(state.max_latency, latency);
+   state.time += _gap;
+
+   ClockSkewMinimizationClient* clock_skew_client = tile->getCore()->getClockSkewMinimizationClient();
+   if (clock_skew_client)
+      clock_skew_client->synchronize(state.time);
+}
+
+static Core::mem_op_t getRandomOp(struct drand48_data* rand_buffer)
+{
+   double r;
+   drand48_r(rand_buffer, &r);
+   return (r < _write_fraction) ? Core::WRITE : Core::READ;
+}
+
+static IntPtr getRandomSharedAddress(struct drand48_data* rand_buffer)
+{
+   long r;
+   lrand48_r(rand_buffer, &r);
+   UInt64 num_slots = _working_set / _access_size;
+   return SHARED_BASE + (r % num_slots) * _access_size;
+}
+
+static void* generateTraffic(void*)
+{
+   Tile* tile = Sim()->getTileManager()->getCurrentTile();
+   tile_id_t tile_id = tile->getId();
+   struct drand48_data rand_buffer;
+   srand48_r(tile_id + 1, &rand_buffer);
+
+   AccessState state;
+   state.time = 0;
+   state.num_accesses = 0;
+   state.num_misses = 0;
+   state.total_latency = 0;
+   state.max_latency = 0;
+
+   IntPtr private_base = _private_base + tile_id * _working_set;
+   tile_id_t producer = (tile_id + _num_tiles - 1) % _num_tiles;
+   IntPtr producer_base = _private_base + producer * _working_set;
+
+   CarbonBarrierWait(&_barrier);
+
+   for (UInt64 i = 0; state.num_accesses < _num_accesses; i++)
+   {
+      switch (_pattern)
+      {
+      case STRIDE:
+         accessMemory(tile, getRandomOp(&rand_buffer), private_base + (i * _stride) % _working_set, state);
+         break;
+      case RANDOM:
+         accessMemory(tile, getRandomOp(&rand_buffer), getRandomSharedAddress(&rand_buffer), state);
+         break;
+      case PRODUCER_CONSUMER:
+         {
+            IntPtr offset = (i * _cache_line_size) % _working_set;
+            accessMemory(tile, Core::WRITE, private_base + offset, state);
+            accessMemory(tile, Core::READ, producer_base + offset, state);
+            break;
+         }
+      case MIGRATORY:
+         {
+            IntPtr address = getRandomSharedAddress(&rand_buffer);
+            accessMemory(tile, Core::READ, address, state);
+            accessMemory(tile, Core::WRITE, address, state);
+            break;
+         }
+      default:
+         LOG_PRINT_ERROR("Unrecognized memory traffic pattern(%u)", _pattern);
+      }
+   }
+
+   ScopedLock sl(_lock);
+   _total_accesses += state.num_accesses;
+   _total_misses += state.num_misses;
+   _total_latency += state.total_latency;
+   _max_latency = max<UInt64>(_max_latency, state.max_latency);
+   _completion_time = max<UInt64>(_completion_time, state.time);
+   return NULL;
+}
+
+int main(int argc, char* argv[])
+{
+   CarbonStartSim(argc, argv);
+
+   _num_tiles = (SInt32) Config::getSingleton()->getApplicationTiles();
+
+   string pattern;
+   try
+   {
+      pattern = Sim()->getCfg()->getString("memory_traffic/pattern", "stride");
+      _num_accesses = Sim()->getCfg()->getInt("memory_traffic/num_accesses", 10000);
+      _access_size = Sim()->getCfg()->getInt("memory_traffic/access_size", 8);
+      _write_fraction = Sim()->getCfg()->getFloat("memory_traffic/write_fraction", 0.3);
+      _working_set = ((UInt64) Sim()->getCfg()->getInt("memory_traffic/working_set", 1024)) * 1024;
+      _stride = Sim()->getCfg()->getInt("memory_traffic/stride", 64);
+      _gap = Sim()->getCfg()->getInt("memory_traffic/gap", 10);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read [memory_traffic] parameters from the cfg file");
+   }
+   _pattern = parseTrafficPattern(pattern);
+
+   _cache_line_size = Sim()->getTileManager()->getTileFromID(0)->getMemoryManager()->getCacheLineSize();
+   LOG_ASSERT_ERROR((_access_size > 0) && (_cache_line_size % _access_size == 0),
+                    "Access size(%u) must divide the cache line size(%u)", _access_size, _cache_line_size);
+   LOG_ASSERT_ERROR((_stride % _access_size == 0) && (_working_set % _cache_line_size == 0) && (_working_set > 0),
+                    "Stride(%llu) must be a multiple of the access size, the working set of the line size",
+                    (unsigned long long) _stride);
+   _private_base = SHARED_BASE + _working_set;
+
+   Simulator::enablePerformanceModelsInCurrentProcess();
+
+   CarbonBarrierInit(&_barrier, _num_tiles);
+   double start_time = getHostTime();
+   vector<carbon_thread_t> threads(_num_tiles - 1);
+   for (SInt32 i = 0; i < _num_tiles - 1; i++)
+      threads[i] = CarbonSpawnThread(generateTraffic, NULL);
+   generateTraffic(NULL);
+   for (SInt32 i = 0; i < _num_tiles - 1; i++)
+      CarbonJoinThread(threads[i]);
+   double host_time = getHostTime() - start_time;
+
+   Simulator::disablePerformanceModelsInCurrentProcess();
+
+   double accesses_per_second = (host_time > 0) ? (_total_accesses / host_time) : 0.0;
+   double average_latency = (_total_accesses > 0) ? (((double) _total_latency) / _total_accesses) : 0.0;
+   double miss_rate = (_total_accesses > 0) ? (((double) _total_misses) / _total_accesses) : 0.0;
+   printf("[memory_traffic] pattern %s: %llu accesses in %g s (%g accesses/s), miss rate %g, "
+          "average latency %g, max latency %llu, completion time %llu\n",
+          pattern.c_str(), (unsigned long long) _total_accesses, host_time, accesses_per_second, miss_rate,
+          average_latency, (unsigned long long) _max_latency, (unsigned long long) _completion_time);
+
+   string output_filename = Config::getSingleton()->formatOutputFileName("memory_traffic.csv");
+   FILE* output_file = fopen(output_filename.c_str(), "w");
+   LOG_ASSERT_ERROR(output_file, "Could not open %s", output_filename.c_str());
+   fprintf(output_file, "pattern,accesses,host_time,accesses_per_second,miss_rate,average_latency,max_latency,completion_time\n");
+   fprintf(output_file, "%s,%llu,%g,%g,%g,%g,%llu,%llu\n", pattern.c_str(), (unsigned long long) _total_accesses,
+           host_time, accesses_per_second, miss_rate, average_latency,
+           (unsigned long long) _max_latency, (unsigned long long) _completion_time);
+   fclose(output_file);
+
+   CarbonStopSim();
+   return 0;
+}
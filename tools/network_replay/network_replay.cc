@@ -0,0 +1,195 @@
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <string>
+using namespace std;
+
+#include "simulator.h"
+#include "tile_manager.h"
+#include "tile.h"
+#include "core.h"
+#include "network.h"
+#include "network_trace.h"
+#include "carbon_user.h"
+#include "config.h"
+#include "lock.h"
+#include "log.h"
+
+// Replays the packet traces of one static network of a recorded run
+// ([network_replay] network, from the traces in [network_replay] directory)
+// on the network of CARBON_NET_USER_2 (network/user_model_2), natively, from
+// a thread per tile. A tile sends the packets of its trace in order, at their
+// recorded times. With dependency tracking, a packet that depends on a
+// received packet is sent once that packet has arrived, its recorded gap
+// after the arrival, so the replies follow the latency of the replayed
+// network. The packets carry their send time, the latency of a packet is its
+// arrival time minus its send time, in core cycles.
+//   The tiles are not synchronized: a tile waiting for the packet it depends
+// on would hold back the others.
+
+static const PacketType _packet_type = USER_2;
+static SInt32 _num_tiles;
+static carbon_barrier_t _barrier;
+
+static string _directory = ".";
+static SInt32 _network_id = STATIC_NETWORK_MEMORY_1;
+static bool _dependencies_enabled = true;
+
+static Lock _lock;
+static vector<UInt64> _num_packets_to;
+static UInt64 _total_packets_received = 0;
+static UInt64 _total_latency = 0;
+static UInt64 _max_latency = 0;
+static UInt64 _completion_time = 0;
+static UInt64 _total_dependent_packets = 0;
+
+struct ReceiveState
+{
+   // Arrival times of the packets received from each tile, in order
+   vector<vector<UInt64> > arrival_times;
+   UInt64 num_packets;
+   UInt64 total_latency;
+   UInt64 max_latency;
+   UInt64 last_arrival_time;
+};
+
+static void receivePacket(Tile* tile, ReceiveState& state)
+{
+   NetPacket packet = tile->getNetwork()->netRecvType(_packet_type, tile->getCore()->getId());
+   UInt64 send_time;
+   memcpy(&send_time, packet.data, sizeof(send_time));
+   UInt64 latency = packet.time - send_time;
+
+   state.arrival_times[packet.sender.tile_id].push_back(packet.time);
+   state.num_packets ++;
+   state.total_latency += latency;
+   state.max_latency = max<UInt64>(state.max_latency, latency);
+   state.last_arrival_time = max<UInt64>(state.last_arrival_time, packet.time);
+   delete [] (Byte*) packet.data;
+}
+
+static void sendPacket(Tile* tile, UInt64 time, tile_id_t receiver, UInt32 length)
+{
+   // The send time is in the payload
+   length = max<UInt32>(length, sizeof(UInt64));
+   Byte data[length];
+   memset(data, 0, length);
+   memcpy(data, &time, sizeof(time));
+   NetPacket packet(time, _packet_type, tile->getId(), receiver, length, data);
+   tile->getNetwork()->netSend(packet);
+}
+
+static void* replayTrace(void*)
+{
+   Tile* tile = Sim()->getTileManager()->getCurrentTile();
+   tile_id_t tile_id = tile->getId();
+
+   NetworkTraceReader reader(NetworkTrace::getFileName(_directory, _network_id, tile_id));
+   LOG_ASSERT_ERROR((reader.getTileId() == tile_id) && (reader.getNetworkId() == _network_id),
+                    "Network trace of tile(%i), network(%i), expected tile(%i), network(%i)",
+                    reader.getTileId(), reader.getNetworkId(), tile_id, _network_id);
+
+   ReceiveState state;
+   state.arrival_times.resize(_num_tiles);
+   state.num_packets = 0;
+   state.total_latency = 0;
+   state.max_latency = 0;
+   state.last_arrival_time = 0;
+
+   vector<UInt64> num_packets_to(_num_tiles, 0);
+   UInt64 num_dependent_packets = 0;
+   UInt64 time = 0;
+   NetworkTraceReader::Record record;
+   while (reader.readRecord(record))
+   {
+      LOG_ASSERT_ERROR((record.receiver >= 0) && (record.receiver < _num_tiles),
+                       "Packet to tile(%i) in the trace of tile(%i), %i tiles", record.receiver, tile_id, _num_tiles);
+
+      UInt64 send_time = record.time;
+      if (_dependencies_enabled && (record.dependency_sender != INVALID_TILE_ID))
+      {
+         tile_id_t sender = record.dependency_sender;
+         LOG_ASSERT_ERROR((sender >= 0) && (sender < _num_tiles), "Dependency on tile(%i), %i tiles", sender, _num_tiles);
+         while (state.arrival_times[sender].size() <= record.dependency_index)
+            receivePacket(tile, state);
+         send_time = state.arrival_times[sender][record.dependency_index] + record.dependency_gap;
+         num_dependent_packets ++;
+      }
+
+      // The packets of a tile are injected in order
+      time = max<UInt64>(time, send_time);
+      sendPacket(tile, time, record.receiver, record.length);
+      num_packets_to[record.receiver] ++;
+   }
+
+   {
+      ScopedLock sl(_lock);
+      for (SInt32 i = 0; i < _num_tiles; i++)
+         _num_packets_to[i] += num_packets_to[i];
+      _total_dependent_packets += num_dependent_packets;
+   }
+   CarbonBarrierWait(&_barrier);
+
+   // The packets not received yet
+   while (state.num_packets < _num_packets_to[tile_id])
+      receivePacket(tile, state);
+
+   {
+      ScopedLock sl(_lock);
+      _total_packets_received += state.num_packets;
+      _total_latency += state.total_latency;
+      _max_latency = max<UInt64>(_max_latency, state.max_latency);
+      _completion_time = max<UInt64>(_completion_time, state.last_arrival_time);
+   }
+   return NULL;
+}
+
+int main(int argc, char* argv[])
+{
+   CarbonStartSim(argc, argv);
+
+   _num_tiles = (SInt32) Config::getSingleton()->getApplicationTiles();
+
+   string network;
+   try
+   {
+      _directory = Sim()->getCfg()->getString("network_replay/directory", ".");
+      network = Sim()->getCfg()->getString("network_replay/network", "memory_1");
+      _dependencies_enabled = Sim()->getCfg()->getBool("network_replay/dependencies", true);
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read [network_replay] parameters from the cfg file");
+   }
+   _network_id = -1;
+   for (SInt32 i = 0; i < NUM_STATIC_NETWORKS; i++)
+   {
+      if (g_static_network_name_list[i] == network)
+         _network_id = i;
+   }
+   LOG_ASSERT_ERROR((_network_id >= 0) && (_network_id != STATIC_NETWORK_SYSTEM),
+                    "Unrecognized network(%s) to replay", network.c_str());
+
+   _num_packets_to.resize(_num_tiles, 0);
+
+   Simulator::enablePerformanceModelsInCurrentProcess();
+
+   CarbonBarrierInit(&_barrier, _num_tiles);
+   vector<carbon_thread_t> threads(_num_tiles - 1);
+   for (SInt32 i = 0; i < _num_tiles - 1; i++)
+      threads[i] = CarbonSpawnThread(replayTrace, NULL);
+   replayTrace(NULL);
+   for (SInt32 i = 0; i < _num_tiles - 1; i++)
+      CarbonJoinThread(threads[i]);
+
+   Simulator::disablePerformanceModelsInCurrentProcess();
+
+   double average_latency = (_total_packets_received > 0) ? (((double) _total_latency) / _total_packets_received) : 0.0;
+   printf("[network_replay] network %s: %llu packets (%llu dependent), average latency %g, max latency %llu, "
+          "completion time %llu\n", network.c_str(),
+          (unsigned long long) _total_packets_received, (unsigned long long) _total_dependent_packets,
+          average_latency, (unsigned long long) _max_latency, (unsigned long long) _completion_time);
+
+   CarbonStopSim();
+   return 0;
+}
@@ -0,0 +1,317 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include <string>
+using namespace std;
+
+#include "simulator.h"
+#include "tile_manager.h"
+#include "tile.h"
+#include "core.h"
+#include "network.h"
+#include "clock_skew_minimization_object.h"
+#include "carbon_user.h"
+#include "config.h"
+#include "lock.h"
+#include "utils.h"
+#include "log.h"
+
+// Injects synthetic or trace-driven traffic into the network of
+// CARBON_NET_USER_2 (network/user_model_2) from a thread per tile, natively,
+// and reports a latency-throughput curve ([network_traffic]): for each
+// offered load, every tile sends num_packets packets with exponential
+// inter-arrival times, then receives the ones sent to it. The latency of a
+// packet is its arrival time minus its send time (carried in the payload),
+// in core cycles. The load points run one after the other in the same
+// simulation, each starting after the last arrival of the previous one
+
+enum TrafficPattern
+{
+   UNIFORM = 0,
+   TRANSPOSE,
+   BIT_COMPLEMENT,
+   HOTSPOT,
+   TRACE
+};
+
+struct TracePacket
+{
+   UInt64 time;
+   tile_id_t receiver;
+   SInt32 size;
+};
+
+static TrafficPattern _pattern = UNIFORM;
+static vector<double> _offered_loads;
+static SInt32 _packet_size = 64;
+static UInt64 _num_packets = 1000;
+static tile_id_t _hotspot_tile = 0;
+static double _hotspot_fraction = 0.2;
+// Packets of each sender tile, from [network_traffic] trace_file
+static vector<vector<TracePacket> > _trace;
+
+static const PacketType _packet_type = USER_2;
+static SInt32 _num_tiles;
+static carbon_barrier_t _barrier;
+
+// Current load point
+static Lock _lock;
+static vector<UInt64> _num_packets_to;
+static UInt64 _phase_start_time = 0;
+static UInt64 _phase_end_time = 0;
+static UInt64 _total_packets_received;
+static UInt64 _total_latency;
+static UInt64 _max_latency;
+static FILE* _output_file;
+
+static TrafficPattern parseTrafficPattern(string pattern)
+{
+   if (pattern == "uniform")
+      return UNIFORM;
+   else if (pattern == "transpose")
+      return TRANSPOSE;
+   else if (pattern == "bit_complement")
+      return BIT_COMPLEMENT;
+   else if (pattern == "hotspot")
+      return HOTSPOT;
+   else if (pattern == "trace")
+      return TRACE;
+   LOG_PRINT_ERROR("Unrecognized traffic pattern(%s)", pattern.c_str());
+   return (TrafficPattern) -1;
+}
+
+// Trace lines: <time (in cycles)> <sender tile> <receiver tile> <size (in bytes)>
+static void readTrace(string filename)
+{
+   ifstream in(filename.c_str());
+   LOG_ASSERT_ERROR(in.good(), "Could not open traffic trace(%s)", filename.c_str());
+
+   _trace.resize(_num_tiles);
+   UInt64 time;
+   tile_id_t sender;
+   TracePacket packet;
+   while (in >> time >> sender >> packet.receiver >> packet.size)
+   {
+      LOG_ASSERT_ERROR((sender >= 0) && (sender < _num_tiles) && (packet.receiver >= 0) && (packet.receiver < _num_tiles),
+                       "Traffic trace packet from tile(%i) to tile(%i), %i tiles", sender, packet.receiver, _num_tiles);
+      packet.time = time;
+      packet.size = max<SInt32>(packet.size, sizeof(UInt64));
+      _trace[sender].push_back(packet);
+   }
+}
+
+static tile_id_t computeReceiver(tile_id_t sender, struct drand48_data* rand_buffer)
+{
+   SInt32 mesh_width = (SInt32) floor(sqrt(1.0 * _num_tiles));
+   double r;
+   switch (_pattern)
+   {
+   case UNIFORM:
+      {
+         drand48_r(rand_buffer, &r);
+         tile_id_t receiver = (tile_id_t) (r * (_num_tiles - 1));
+         return (receiver >= sender) ? (receiver + 1) : receiver;
+      }
+   case TRANSPOSE:
+      return (sender % mesh_width) * mesh_width + (sender / mesh_width);
+   case BIT_COMPLEMENT:
+      return (~sender) & (_num_tiles - 1);
+   case HOTSPOT:
+      {
+         drand48_r(rand_buffer, &r);
+         if ((r < _hotspot_fraction) && (sender != _hotspot_tile))
+            return _hotspot_tile;
+         drand48_r(rand_buffer, &r);
+         tile_id_t receiver = (tile_id_t) (r * (_num_tiles - 1));
+         return (receiver >= sender) ? (receiver + 1) : receiver;
+      }
+   default:
+      LOG_PRINT_ERROR("Unrecognized traffic pattern(%u)", _pattern);
+      return INVALID_TILE_ID;
+   }
+}
+
+static void sendPacket(Tile* tile, UInt64 time, tile_id_t receiver, SInt32 size, vector<UInt64>& num_packets_to)
+{
+   Byte data[size];
+   memset(data, 0, size);
+   memcpy(data, &time, sizeof(time));
+   NetPacket packet(time, _packet_type, tile->getId(), receiver, size, data);
+   tile->getNetwork()->netSend(packet);
+   num_packets_to[receiver] ++;
+
+   ClockSkewMinimizationClient* clock_skew_client = tile->getCore()->getClockSkewMinimizationClient();
+   if (clock_skew_client)
+      clock_skew_client->synchronize(time);
+}
+
+static void sendTraffic(Tile* tile, double offered_load, struct drand48_data* rand_buffer)
+{
+   tile_id_t tile_id = tile->getId();
+   vector<UInt64> num_packets_to(_num_tiles, 0);
+
+   if (_pattern == TRACE)
+   {
+      for (vector<TracePacket>::iterator it = _trace[tile_id].begin(); it != _trace[tile_id].end(); it++)
+      {
+         if (it->receiver != tile_id)
+            sendPacket(tile, _phase_start_time + it->time, it->receiver, it->size, num_packets_to);
+      }
+   }
+   else
+   {
+      tile_id_t receiver = computeReceiver(tile_id, rand_buffer);
+      UInt64 time = _phase_start_time;
+      for (UInt64 i = 0; i < _num_packets; i++)
+      {
+         // Exponential inter-arrival times, offered_load packets per cycle
+         double r;
+         drand48_r(rand_buffer, &r);
+         time += (UInt64) ceil(-log(1.0 - r) / offered_load);
+         if ((_pattern == UNIFORM) || (_pattern == HOTSPOT))
+            receiver = computeReceiver(tile_id, rand_buffer);
+         if (receiver != tile_id)
+            sendPacket(tile, time, receiver, _packet_size, num_packets_to);
+      }
+   }
+
+   ScopedLock sl(_lock);
+   for (SInt32 i = 0; i < _num_tiles; i++)
+      _num_packets_to[i] += num_packets_to[i];
+}
+
+static void receiveTraffic(Tile* tile)
+{
+   UInt64 num_packets = _num_packets_to[tile->getId()];
+   UInt64 total_latency = 0;
+   UInt64 max_latency = 0;
+   UInt64 last_arrival_time = 0;
+   for (UInt64 i = 0; i < num_packets; i++)
+   {
+      NetPacket packet = tile->getNetwork()->netRecvType(_packet_type, tile->getCore()->getId());
+      UInt64 send_time;
+      memcpy(&send_time, packet.data, sizeof(send_time));
+      UInt64 latency = packet.time - send_time;
+      total_latency += latency;
+      max_latency = max<UInt64>(max_latency, latency);
+      last_arrival_time = max<UInt64>(last_arrival_time, packet.time);
+      delete [] (Byte*) packet.data;
+   }
+
+   ScopedLock sl(_lock);
+   _total_packets_received += num_packets;
+   _total_latency += total_latency;
+   _max_latency = max<UInt64>(_max_latency, max_latency);
+   _phase_end_time = max<UInt64>(_phase_end_time, last_arrival_time);
+}
+
+static void outputLoadPoint(double offered_load)
+{
+   UInt64 num_cycles = (_phase_end_time > _phase_start_time) ? (_phase_end_time - _phase_start_time) : 1;
+   double accepted_load = ((double) _total_packets_received) / (_num_tiles * num_cycles);
+   double average_latency = (_total_packets_received > 0) ? (((double) _total_latency) / _total_packets_received) : 0.0;
+
+   printf("[network_traffic] offered load %g, accepted load %g, average latency %g, max latency %llu\n",
+          offered_load, accepted_load, average_latency, (unsigned long long) _max_latency);
+   fprintf(_output_file, "%g,%g,%g,%llu,%llu\n", offered_load, accepted_load, average_latency,
+           (unsigned long long) _max_latency, (unsigned long long) _total_packets_received);
+   fflush(_output_file);
+
+   // Next load point
+   for (SInt32 i = 0; i < _num_tiles; i++)
+      _num_packets_to[i] = 0;
+   _phase_start_time = _phase_end_time + 1;
+   _total_packets_received = 0;
+   _total_latency = 0;
+   _max_latency = 0;
+}
+
+static void* generateTraffic(void*)
+{
+   Tile* tile = Sim()->getTileManager()->getCurrentTile();
+   struct drand48_data rand_buffer;
+   srand48_r(tile->getId() + 1, &rand_buffer);
+
+   for (UInt32 i = 0; i < _offered_loads.size(); i++)
+   {
+      CarbonBarrierWait(&_barrier);
+      sendTraffic(tile, _offered_loads[i], &rand_buffer);
+      CarbonBarrierWait(&_barrier);
+      receiveTraffic(tile);
+      CarbonBarrierWait(&_barrier);
+      if (tile->getId() == 0)
+         outputLoadPoint(_offered_loads[i]);
+   }
+   return NULL;
+}
+
+int main(int argc, char* argv[])
+{
+   CarbonStartSim(argc, argv);
+
+   _num_tiles = (SInt32) Config::getSingleton()->getApplicationTiles();
+
+   string offered_loads;
+   string trace_file;
+   try
+   {
+      _pattern = parseTrafficPattern(Sim()->getCfg()->getString("network_traffic/pattern", "uniform"));
+      offered_loads = Sim()->getCfg()->getString("network_traffic/offered_loads", "0.01, 0.05, 0.1");
+      _packet_size = Sim()->getCfg()->getInt("network_traffic/packet_size", 64);
+      _num_packets = Sim()->getCfg()->getInt("network_traffic/num_packets", 1000);
+      _hotspot_tile = Sim()->getCfg()->getInt("network_traffic/hotspot_tile", 0);
+      _hotspot_fraction = Sim()->getCfg()->getFloat("network_traffic/hotspot_fraction", 0.2);
+      trace_file = Sim()->getCfg()->getString("network_traffic/trace_file", "");
+   }
+   catch (...)
+   {
+      LOG_PRINT_ERROR("Could not read [network_traffic] parameters from the cfg file");
+   }
+   LOG_ASSERT_ERROR(_packet_size >= (SInt32) sizeof(UInt64), "Packet size(%i) must hold the send time", _packet_size);
+   LOG_ASSERT_ERROR((_pattern != BIT_COMPLEMENT) || isPower2(_num_tiles), "bit_complement needs a power of 2 tiles");
+   LOG_ASSERT_ERROR((_hotspot_tile >= 0) && (_hotspot_tile < _num_tiles), "Invalid hotspot tile(%i)", _hotspot_tile);
+
+   if (_pattern == TRACE)
+   {
+      readTrace(trace_file);
+      // A single load point, at the times of the trace
+      _offered_loads.push_back(0);
+   }
+   else
+   {
+      vector<string> loads;
+      parseList(offered_loads, loads, ",");
+      for (vector<string>::iterator it = loads.begin(); it != loads.end(); it++)
+      {
+         double load = atof(it->c_str());
+         LOG_ASSERT_ERROR(load > 0, "Offered load(%s) must be > 0", it->c_str());
+         _offered_loads.push_back(load);
+      }
+   }
+
+   _num_packets_to.resize(_num_tiles, 0);
+   string output_filename = Config::getSingleton()->formatOutputFileName("network_traffic.csv");
+   _output_file = fopen(output_filename.c_str(), "w");
+   LOG_ASSERT_ERROR(_output_file, "Could not open %s", output_filename.c_str());
+   fprintf(_output_file, "offered_load,accepted_load,average_latency,max_latency,num_packets\n");
+
+   Simulator::enablePerformanceModelsInCurrentProcess();
+
+   CarbonBarrierInit(&_barrier, _num_tiles);
+   vector<carbon_thread_t> threads(_num_tiles - 1);
+   for (SInt32 i = 0; i < _num_tiles - 1; i++)
+      threads[i] = CarbonSpawnThread(generateTraffic, NULL);
+   generateTraffic(NULL);
+   for (SInt32 i = 0; i < _num_tiles - 1; i++)
+      CarbonJoinThread(threads[i]);
+
+   Simulator::disablePerformanceModelsInCurrentProcess();
+
+   fclose(_output_file);
+
+   CarbonStopSim();
+   return 0;
+}
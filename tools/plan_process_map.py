@@ -0,0 +1,260 @@
+#!/usr/bin/env python
+
+# Plans the mapping of the application tiles to the processes of a
+# distributed run ([general] tile_process_map) from an earlier run of the
+# application: the packets sent between every pair of tiles come from its
+# packet traces ([network_trace] enabled = true), the load of every tile from
+# the instructions it simulated (the Core Model Summary of its sim.out) or,
+# better, the host time it took to simulate them (the load report of the
+# barrier server, [clock_skew_minimization] load_report_file).
+# Tiles that exchange many bytes are put in the same process, so that fewer
+# packets go through the transport between processes, while every process
+# simulates at most (1 + balance) times its share of the instructions.
+#
+#   ./tools/plan_process_map.py --trace-dir results/latest --sim-out results/latest/sim.out \
+#                               --num-tiles 64 --num-processes 4
+# prints the cfg override, e.g. --general/tile_process_map="0,0,1,1,..."
+
+import os
+import re
+import sys
+import struct
+from optparse import OptionParser
+
+trace_magic = 0x52544e47
+trace_version = 1
+
+def readUnsigned(data, position):
+   value = 0
+   shift = 0
+   while True:
+      byte = ord(data[position])
+      position += 1
+      value |= (byte & 0x7f) << shift
+      shift += 7
+      if (byte & 0x80) == 0:
+         return (value, position)
+
+# Adds the bytes sent by the tile of a trace to every receiver to 'traffic'
+def readTrace(filename, num_tiles, traffic):
+   data = open(filename, 'rb').read()
+   (magic, version, tile_id, network_id) = struct.unpack("<IIII", data[0:16])
+   if (magic != trace_magic) or (version != trace_version):
+      print "ERROR: %s is not a network trace (version %d)" % (filename, trace_version)
+      sys.exit(1)
+   if (tile_id >= num_tiles):
+      return 0
+
+   num_packets = 0
+   position = 16
+   while position < len(data):
+      (time_delta, position) = readUnsigned(data, position)
+      (receiver, position) = readUnsigned(data, position)
+      position += 1                                      # type
+      (length, position) = readUnsigned(data, position)
+      (dependency_sender, position) = readUnsigned(data, position)
+      if (dependency_sender != 0):
+         (dependency_index, position) = readUnsigned(data, position)
+         (dependency_gap, position) = readUnsigned(data, position)
+      if (receiver < num_tiles):
+         traffic[tile_id][receiver] += length
+         traffic[receiver][tile_id] += length
+      num_packets += 1
+   return num_packets
+
+def rowSearch(output_file_contents, num_tiles, heading, key):
+   key += "(.*)"
+   heading_found = False
+
+   for line in output_file_contents:
+      if heading_found:
+         match_key = re.search(key, line)
+         if match_key:
+            counts = line.split('|')
+            event_counts = counts[1:num_tiles+1]
+            for i in range(0, num_tiles):
+               if (len(event_counts[i].split()) == 0):
+                  event_counts[i] = "0.0"
+            return map(lambda x: float(x), event_counts)
+      else:
+         if (re.search(heading, line)):
+            heading_found = True
+
+   print "ERROR: Could not find key [%s,%s]" % (heading, key)
+   sys.exit(1)
+
+def getCrossTraffic(mapping, traffic):
+   cross_traffic = 0
+   for i in range(0, len(mapping)):
+      for j in range(i+1, len(mapping)):
+         if (mapping[i] != mapping[j]):
+            cross_traffic += traffic[i][j]
+   return cross_traffic
+
+def getProcessLoads(mapping, load, num_processes):
+   process_loads = [0.0] * num_processes
+   for tile_id in range(0, len(mapping)):
+      process_loads[mapping[tile_id]] += load[tile_id]
+   return process_loads
+
+# Contiguous blocks of tiles of about the same load
+def getContiguousMapping(load, num_processes):
+   num_tiles = len(load)
+   total_load = sum(load)
+   mapping = []
+   process = 0
+   process_load = 0.0
+   for tile_id in range(0, num_tiles):
+      # Leave at least one tile to each of the remaining processes
+      remaining_processes = num_processes - process - 1
+      if (process_load > 0.0) and (remaining_processes > 0) and \
+         ((process_load + load[tile_id] / 2 > total_load * (process + 1) / num_processes) or \
+          (num_tiles - tile_id <= remaining_processes)):
+         process += 1
+      mapping.append(process)
+      process_load += load[tile_id]
+   return mapping
+
+# Kernighan-Lin style refinement: moves of a tile to another process, and
+# swaps of two tiles of different processes, that reduce the traffic between
+# processes and keep every process under max_load, the best one first,
+# until none is left
+def refineMapping(mapping, traffic, load, num_processes, max_load):
+   num_tiles = len(mapping)
+   process_loads = getProcessLoads(mapping, load, num_processes)
+   process_sizes = [mapping.count(process) for process in range(0, num_processes)]
+
+   # connectivity[tile][process]: bytes between the tile and the process
+   connectivity = [[0] * num_processes for tile_id in range(0, num_tiles)]
+   for i in range(0, num_tiles):
+      for j in range(0, num_tiles):
+         if (i != j):
+            connectivity[i][mapping[j]] += traffic[i][j]
+
+   def move(tile_id, process):
+      old_process = mapping[tile_id]
+      for j in range(0, num_tiles):
+         if (j != tile_id) and (traffic[tile_id][j] != 0):
+            connectivity[j][old_process] -= traffic[tile_id][j]
+            connectivity[j][process] += traffic[tile_id][j]
+      process_loads[old_process] -= load[tile_id]
+      process_loads[process] += load[tile_id]
+      process_sizes[old_process] -= 1
+      process_sizes[process] += 1
+      mapping[tile_id] = process
+
+   while True:
+      best_gain = 0
+      best_move = None
+      for i in range(0, num_tiles):
+         pi = mapping[i]
+         for q in range(0, num_processes):
+            if (q == pi):
+               continue
+            gain_i = connectivity[i][q] - connectivity[i][pi]
+            # Move of i to q, no process is left empty
+            if (gain_i > best_gain) and (process_sizes[pi] > 1) and \
+               (process_loads[q] + load[i] <= max_load):
+               best_gain = gain_i
+               best_move = (i, q, None)
+            # Swap of i with a tile j of q
+            for j in range(i+1, num_tiles):
+               if (mapping[j] != q):
+                  continue
+               gain = gain_i + connectivity[j][pi] - connectivity[j][q] - 2 * traffic[i][j]
+               if (gain > best_gain) and \
+                  (process_loads[q] + load[i] - load[j] <= max_load) and \
+                  (process_loads[pi] + load[j] - load[i] <= max_load):
+                  best_gain = gain
+                  best_move = (i, q, j)
+      if best_move is None:
+         return mapping
+      (i, q, j) = best_move
+      if j is not None:
+         move(j, mapping[i])
+      move(i, q)
+
+parser = OptionParser()
+parser.add_option("--trace-dir", dest="trace_dir", help="Output directory of the traced run (network_trace.*)")
+parser.add_option("--networks", dest="networks", default="",
+                  help="Networks of the traces to use, comma separated (default: all)")
+parser.add_option("--sim-out", dest="sim_out", default="",
+                  help="sim.out of the run, for the instructions of every tile (default: the same on every tile)")
+parser.add_option("--load-report", dest="load_report", default="",
+                  help="Load report of the run, for the host time of every tile (in place of --sim-out)")
+parser.add_option("--num-tiles", dest="num_tiles", type="int", help="Number of Application Tiles")
+parser.add_option("--num-processes", dest="num_processes", type="int", help="Number of Processes")
+parser.add_option("--balance", dest="balance", type="float", default=0.1,
+                  help="Largest excess of the load of a process over its share (a fraction)")
+(options,args) = parser.parse_args()
+
+if (not options.trace_dir) or (not options.num_tiles) or (not options.num_processes):
+   parser.print_help()
+   sys.exit(2)
+if (options.num_processes > options.num_tiles):
+   print "ERROR: More processes (%d) than tiles (%d)" % (options.num_processes, options.num_tiles)
+   sys.exit(2)
+
+num_tiles = options.num_tiles
+num_processes = options.num_processes
+
+traffic = [[0] * num_tiles for tile_id in range(0, num_tiles)]
+networks = [network.strip() for network in options.networks.split(",") if (network.strip() != "")]
+num_traces = 0
+num_packets = 0
+for filename in sorted(os.listdir(options.trace_dir)):
+   match = re.match("network_trace\.(.*)\.([0-9]+)$", filename)
+   if (not match) or ((len(networks) > 0) and (match.group(1) not in networks)):
+      continue
+   num_packets += readTrace("%s/%s" % (options.trace_dir, filename), num_tiles, traffic)
+   num_traces += 1
+if (num_traces == 0):
+   print "ERROR: No network traces in %s" % (options.trace_dir)
+   sys.exit(1)
+
+if (options.load_report != ""):
+   load = [0.0] * num_tiles
+   try:
+      for line in open(options.load_report, 'r').readlines():
+         fields = line.split()
+         if (len(fields) == 4) and (fields[0] == "tile") and (int(fields[1]) < num_tiles):
+            load[int(fields[1])] = float(fields[3])
+   except IOError:
+      print "ERROR: Could not open file (%s)" % (options.load_report)
+      sys.exit(3)
+elif (options.sim_out != ""):
+   try:
+      output_file_contents = open(options.sim_out, 'r').readlines()
+   except IOError:
+      print "ERROR: Could not open file (%s)" % (options.sim_out)
+      sys.exit(3)
+   load = rowSearch(output_file_contents, num_tiles, "Core Model Summary", "Total Instructions")
+else:
+   load = [1.0] * num_tiles
+# A tile that simulated nothing still counts, so that it is not piled up
+max_tile_load = max(load + [1.0])
+load = [max(tile_load, max_tile_load * 1e-3) for tile_load in load]
+
+# The refinement starts from the contiguous mapping and, if it is balanced,
+# from the round-robin one (that of the simulator); the better result is kept
+max_load = sum(load) / num_processes * (1 + options.balance)
+contiguous_mapping = getContiguousMapping(load, num_processes)
+round_robin_mapping = [tile_id % num_processes for tile_id in range(0, num_tiles)]
+max_load = max(max_load, max(getProcessLoads(contiguous_mapping, load, num_processes)))
+mapping = refineMapping(list(contiguous_mapping), traffic, load, num_processes, max_load)
+if (max(getProcessLoads(round_robin_mapping, load, num_processes)) <= max_load):
+   other_mapping = refineMapping(list(round_robin_mapping), traffic, load, num_processes, max_load)
+   if (getCrossTraffic(other_mapping, traffic) < getCrossTraffic(mapping, traffic)):
+      mapping = other_mapping
+
+total_traffic = getCrossTraffic([tile_id for tile_id in range(0, num_tiles)], traffic)
+print "%d packets (%d bytes) from %d traces" % (num_packets, total_traffic, num_traces)
+for name, m in [("Round-robin", round_robin_mapping),
+                ("Contiguous", contiguous_mapping),
+                ("Planned", mapping)]:
+   cross_traffic = getCrossTraffic(m, traffic)
+   process_loads = getProcessLoads(m, load, num_processes)
+   print "%s: %d bytes between processes (%.1f%%), load imbalance %.3f" % \
+         (name.ljust(12), cross_traffic, 100.0 * cross_traffic / max(total_traffic, 1),
+          max(process_loads) / (sum(process_loads) / num_processes))
+print "--general/tile_process_map=\"%s\"" % (",".join([str(process) for process in mapping]))
@@ -0,0 +1,108 @@
+#!/usr/bin/env python
+
+# Recomputes the power and area of one recorded run for several sets of power
+# parameters, without simulating it again. The run must have written its
+# stats file ([general] stats_file), which holds the event counters of the
+# cores, caches, routers and links. For each set, tools/power_sweep loads
+# them into freshly built models (McPAT and DSENT run with the new
+# parameters) and outputs the summary of the run; the power, energy and area
+# rows of each summary are then summed over the tiles into one table, e.g.
+#     power_sweep.py --stats-file results/latest/sim.stats --num-cores 64 \
+#                    --sets sweep.txt --output-file sweep.csv
+# with a set per line in sweep.txt: a name, then the parameters
+#     tech_22  --general/technology_node=22
+#     tech_32  --general/technology_node=32
+# The timing parameters and the number of cores must be those of the
+# recorded run; the summaries are in results/power_sweep/<name>.
+
+import os
+import re
+import subprocess
+import sys
+from optparse import OptionParser
+
+sim_root = os.path.abspath(os.path.join(os.path.dirname(sys.argv[0]), ".."))
+
+# Rows of the summary that are power, energy or area
+power_row = re.compile(r"\(in (W|J|mm\^2)\)")
+
+def readSets(filename):
+   sets = []
+   for line in open(filename, "r"):
+      line = line.split("#")[0].strip()
+      if line:
+         fields = line.split()
+         sets.append((fields[0], fields[1:]))
+   return sets
+
+def runSet(name, params, options):
+   output_dir = "power_sweep/%s" % name
+   command = ["make", "-C", os.path.join(sim_root, "tools", "power_sweep"),
+              "CORES=%d" % options.num_cores,
+              "STATS_FILE=%s" % os.path.abspath(options.stats_file),
+              "OUTPUT_DIR=%s" % output_dir,
+              "PARAMS=%s" % " ".join(params)]
+   if options.config_file:
+      command.append("CONFIG_FILE=%s" % options.config_file)
+   if subprocess.call(command) != 0:
+      sys.stderr.write("ERROR: set %s failed\n" % name)
+      sys.exit(1)
+   return os.path.join(sim_root, "results", output_dir, "sim.out")
+
+# Totals over the tiles of the power, energy and area rows, named by their
+# section (the last row without values) and label
+def readTotals(filename):
+   totals = {}
+   order = []
+   section = ""
+   for line in open(filename, "r"):
+      fields = line.split("|")
+      if len(fields) < 2:
+         continue
+      label = fields[0].strip().rstrip(":")
+      values = [field.strip() for field in fields[1:] if field.strip()]
+      if not values:
+         section = label
+         continue
+      if not power_row.search(label):
+         continue
+      total = 0.0
+      for value in values:
+         try:
+            total += float(value)
+         except ValueError:
+            pass
+      key = "%s/%s" % (section, label)
+      if key not in totals:
+         order.append(key)
+         totals[key] = 0.0
+      totals[key] += total
+   return (order, totals)
+
+parser = OptionParser()
+parser.add_option("--stats-file", dest="stats_file", help="Stats file of the recorded run")
+parser.add_option("--num-cores", dest="num_cores", type="int", help="Number of cores of the recorded run")
+parser.add_option("--sets", dest="sets", help="Parameter sets, one per line: name --section/key=value...")
+parser.add_option("--config-file", dest="config_file", default="", help="Config file of the recorded run (relative to the Graphite home)")
+parser.add_option("--output-file", dest="output_file", default="", help="Table of the totals (CSV, else stdout)")
+(options, args) = parser.parse_args()
+
+if not options.stats_file or not options.num_cores or not options.sets:
+   parser.print_help()
+   sys.exit(1)
+
+columns = []
+results = []
+for (name, params) in readSets(options.sets):
+   (order, totals) = readTotals(runSet(name, params, options))
+   for key in order:
+      if key not in columns:
+         columns.append(key)
+   results.append((name, totals))
+
+out = open(options.output_file, "w") if options.output_file else sys.stdout
+out.write(",".join(["Set"] + ["\"%s\"" % column for column in columns]) + "\n")
+for (name, totals) in results:
+   out.write(",".join([name] + [("%g" % totals[column]) if column in totals else "" for column in columns]) + "\n")
+if options.output_file:
+   out.close()
@@ -0,0 +1,16 @@
+#include "carbon_user.h"
+#include "stats_replay.h"
+
+// Outputs the summary of a recorded run ([general] stats_file) with the power
+// and area of the power parameters of this configuration, without simulating
+// it again. The configuration must otherwise be the one of the recorded run,
+// with [stats_replay] file = its stats file (see tools/power_sweep.py)
+int main(int argc, char **argv)
+{
+   CarbonStartSim(argc, argv);
+
+   CarbonReplayStats();
+
+   CarbonStopSim();
+   return 0;
+}
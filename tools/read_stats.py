@@ -0,0 +1,66 @@
+#!/usr/bin/env python
+
+# Loads the stats file of a run ([general] stats_file): a matrix with a row
+# per tile and a column per counter, e.g.
+#     from read_stats import readStats
+#     stats = readStats("results/latest/sim.stats")
+#     stats["Core Model/Total Instructions"]     # one value per tile
+# or, from the command line, prints the totals over the tiles:
+#     read_stats.py results/latest/sim.stats [counter...]
+
+import array
+import struct
+import sys
+try:
+   import numpy
+except ImportError:
+   numpy = None
+
+UINT64 = 0
+DOUBLE = 1
+
+def readStats(filename):
+   f = open(filename, "rb")
+   data = f.read()
+   f.close()
+
+   if data[0:4] != b"GSTA":
+      raise ValueError("%s: not a stats file" % filename)
+   (version, num_tiles, num_counters) = struct.unpack_from("=III", data, 4)
+   if version != 1:
+      raise ValueError("%s: unknown version %d" % (filename, version))
+
+   pos = 16
+   columns = []
+   for i in range(num_counters):
+      (kind, length) = struct.unpack_from("=BI", data, pos)
+      pos += 5
+      name = data[pos:pos + length].decode("latin-1")
+      pos += length
+      columns.append((name, kind))
+
+   stats = {}
+   for (name, kind) in columns:
+      # numpy arrays are views of the file, else arrays of the values
+      if numpy:
+         dtype = numpy.float64 if kind == DOUBLE else numpy.uint64
+         stats[name] = numpy.frombuffer(data, dtype=dtype, count=num_tiles, offset=pos)
+      else:
+         values = array.array("d" if kind == DOUBLE else "Q")
+         if hasattr(values, "frombytes"):
+            values.frombytes(data[pos:pos + 8 * num_tiles])
+         else:
+            values.fromstring(data[pos:pos + 8 * num_tiles])
+         stats[name] = values
+      pos += 8 * num_tiles
+   return stats
+
+if __name__ == "__main__":
+   if len(sys.argv) < 2:
+      sys.stderr.write("Usage: %s <stats file> [counter...]\n" % sys.argv[0])
+      sys.exit(1)
+
+   stats = readStats(sys.argv[1])
+   names = sys.argv[2:] or sorted(stats.keys())
+   for name in names:
+      sys.stdout.write("%s: %s\n" % (name, sum(stats[name])))
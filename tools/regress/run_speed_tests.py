@@ -0,0 +1,254 @@
+#!/usr/bin/env python
+
+# Simulation-speed regression tests: runs the benchmarks of speed_config.py
+# on every tile count and records, for every run, the host wall time, the
+# simulated instructions per host second (KIPS), the peak RSS and the CPU
+# time of every thread of the simulator. The runs are then compared with
+# those of the baseline: a benchmark is slower if its mean wall time (or
+# KIPS, peak RSS, busiest thread) is worse by more than min_slowdown and the
+# difference is significant (Welch's t-test over the repetitions).
+#
+# Run from the Graphite home directory:
+#   ./tools/regress/run_speed_tests.py                 - run and compare
+#   ./tools/regress/run_speed_tests.py --compare-only  - compare the last runs
+#   ./tools/regress/run_speed_tests.py --save-baseline - make the last runs the baseline
+# The exit status is 1 if there is a regression.
+
+import sys
+import os
+import re
+import time
+import math
+import shutil
+from optparse import OptionParser
+
+sys.path.append("./tools/")
+sys.path.append("./tools/regress/")
+
+import spawn
+from speed_config import *
+
+clock_ticks = os.sysconf(os.sysconf_names['SC_CLK_TCK'])
+runs_file = "%s/speed.csv" % (speed_results_dir)
+summary_file = "./tools/regress/speed_summary.log"
+
+# Metrics compared with the baseline, and whether larger is worse
+metric_list = [("wall_time", True), ("kips", False), ("peak_rss", True), ("max_thread_cpu_time", True)]
+field_list = ["benchmark", "num_tiles", "repetition", "wall_time", "kips", "peak_rss",
+              "max_thread_cpu_time", "total_cpu_time", "thread_cpu_times"]
+
+# Two-sided critical values of Student's t at 0.10, 0.05 and 0.01, by degrees
+# of freedom (the last row for more than 30)
+t_table_levels = [0.10, 0.05, 0.01]
+t_table = [
+      (1, [6.314, 12.706, 63.657]), (2, [2.920, 4.303, 9.925]), (3, [2.353, 3.182, 5.841]),
+      (4, [2.132, 2.776, 4.604]), (5, [2.015, 2.571, 4.032]), (6, [1.943, 2.447, 3.707]),
+      (7, [1.895, 2.365, 3.499]), (8, [1.860, 2.306, 3.355]), (9, [1.833, 2.262, 3.250]),
+      (10, [1.812, 2.228, 3.169]), (12, [1.782, 2.179, 3.055]), (15, [1.753, 2.131, 2.947]),
+      (20, [1.725, 2.086, 2.845]), (30, [1.697, 2.042, 2.750]), (1000000, [1.645, 1.960, 2.576])]
+
+# CPU time (in seconds) of every thread of a process, by thread id
+def readThreadCpuTimes(pid):
+   cpu_times = {}
+   try:
+      thread_ids = os.listdir("/proc/%d/task" % (pid))
+   except OSError:
+      return cpu_times
+   for thread_id in thread_ids:
+      try:
+         stat = open("/proc/%d/task/%s/stat" % (pid, thread_id), 'r').read()
+      except IOError:
+         continue
+      # utime and stime are the 14th and 15th fields, the 2nd (the command
+      # name, in parentheses) may have spaces
+      fields = stat[stat.rfind(')') + 2:].split()
+      cpu_times[thread_id] = float(int(fields[11]) + int(fields[12])) / clock_ticks
+   return cpu_times
+
+def parseStatsFile(stats_filename, key):
+   for line in open(stats_filename, 'r').readlines():
+      match = re.search(key + "\s*=\s*([-e0-9.]+)", line)
+      if match:
+         return float(match.group(1))
+   return None
+
+# Runs one simulation, returns its row of the runs file, None if it failed
+def runSimulation(benchmark, command, mode, num_tiles, repetition, run_dir):
+   try:
+      os.makedirs(run_dir)
+   except OSError:
+      pass
+
+   if (benchmark == "synthetic_memory"):
+      lines = open(synthetic_memory_input, 'r').readlines()
+      lines[0] = "%d\n" % (num_tiles)
+      open("%s/input" % (run_dir), 'w').writelines(lines)
+
+   graphite_home = spawn.get_graphite_home()
+   sim_flags = "-c %s/carbon_sim.cfg --general/total_cores=%d --general/num_processes=1 --general/enable_shared_mem=true --general/output_dir=%s" \
+               % (graphite_home, num_tiles, run_dir)
+   command = command % {"tiles": num_tiles, "run_dir": run_dir}
+   if (mode == "pin"):
+      pin_path = "%s/intel64/bin/pinbin" % spawn.get_pin_home(graphite_home)
+      pin_lib = "%s/lib/pin_sim" % (graphite_home)
+      command = "%s -tool_exit_timeout 1 -mt -t %s %s -- %s" % (pin_path, pin_lib, sim_flags, command)
+   else:
+      command = "%s %s" % (command, sim_flags)
+   # exec, so that the process is the simulator and not a shell
+   command = "exec %s > %s/output 2>&1" % (command, run_dir)
+   open("%s/command" % (run_dir), 'w').write(command)
+   print "Running %s, %d tiles, repetition %d: %s" % (benchmark, num_tiles, repetition, command)
+
+   start_time = time.time()
+   proc = spawn.spawn_job(0, command, graphite_home)
+   # The threads of the simulator are sampled until it exits, the last
+   # sample of a thread is its CPU time
+   thread_cpu_times = {}
+   while True:
+      thread_cpu_times.update(readThreadCpuTimes(proc.pid))
+      (pid, status, rusage) = os.wait4(proc.pid, os.WNOHANG)
+      if (pid != 0):
+         break
+      time.sleep(0.2)
+   wall_time = time.time() - start_time
+
+   if (status != 0):
+      print "ERROR: %s, %d tiles failed (status %d), see %s/output" % (benchmark, num_tiles, status, run_dir)
+      return None
+
+   cmd = "./tools/parse_output.py --input-file %s/sim.out --stats-file %s/stats.out --num-cores %d > /dev/null" \
+         % (run_dir, run_dir, num_tiles)
+   if (os.system(cmd) != 0):
+      print "ERROR: Could not parse %s/sim.out" % (run_dir)
+      return None
+   target_instructions = parseStatsFile("%s/stats.out" % (run_dir), "Target-Instructions")
+
+   cpu_times = sorted(thread_cpu_times.values(), reverse=True)
+   return {"benchmark": benchmark,
+           "num_tiles": num_tiles,
+           "repetition": repetition,
+           "wall_time": wall_time,
+           "kips": target_instructions / wall_time / 1000,
+           "peak_rss": rusage.ru_maxrss,                         # In KB
+           "max_thread_cpu_time": max(cpu_times + [0.0]),
+           "total_cpu_time": rusage.ru_utime + rusage.ru_stime,
+           "thread_cpu_times": " ".join(["%.2f" % (cpu_time) for cpu_time in cpu_times])}
+
+def writeRuns(filename, runs):
+   out = open(filename, 'w')
+   out.write(",".join(field_list) + "\n")
+   for run in runs:
+      out.write(",".join([str(run[field]) for field in field_list]) + "\n")
+   out.close()
+
+def readRuns(filename):
+   runs = []
+   lines = open(filename, 'r').readlines()
+   for line in lines[1:]:
+      values = line.rstrip("\n").split(",")
+      run = dict(zip(field_list, values))
+      run["num_tiles"] = int(run["num_tiles"])
+      for metric, larger_is_worse in metric_list:
+         run[metric] = float(run[metric])
+      runs.append(run)
+   return runs
+
+def mean(values):
+   return sum(values) / len(values)
+
+def variance(values):
+   if (len(values) < 2):
+      return 0.0
+   m = mean(values)
+   return sum([(value - m) ** 2 for value in values]) / (len(values) - 1)
+
+# Is the difference of the means of two samples significant (Welch's t-test)?
+def isSignificant(sample, baseline_sample):
+   if (len(sample) < 2) or (len(baseline_sample) < 2):
+      return False
+   v1 = variance(sample) / len(sample)
+   v2 = variance(baseline_sample) / len(baseline_sample)
+   if (v1 + v2 == 0.0):
+      return (mean(sample) != mean(baseline_sample))
+   t = abs(mean(sample) - mean(baseline_sample)) / math.sqrt(v1 + v2)
+   dof = (v1 + v2) ** 2 / ((v1 ** 2) / (len(sample) - 1) + (v2 ** 2) / (len(baseline_sample) - 1))
+
+   # The row at or below the degrees of freedom, its critical value is larger
+   level = t_table_levels.index(significance_level)
+   critical_value = t_table[0][1][level]
+   for table_dof, critical_values in t_table:
+      if (table_dof <= dof):
+         critical_value = critical_values[level]
+   return (t > critical_value)
+
+# Writes the comparison of the runs with the baseline, returns the number
+# of regressions
+def compareRuns(runs, baseline_runs, out):
+   num_regressions = 0
+   out.write("%s | %s | %s | %s | %s | %s |\n" % ("Benchmark".center(20), "Tiles".center(6), "Metric".center(20),
+             "Baseline".center(12), "Current".center(12), "Change".center(18)))
+   out.write("_" * 100 + "\n\n")
+   for benchmark, directory, command, mode in speed_benchmark_list:
+      for num_tiles in num_tiles_list:
+         current = [run for run in runs if (run["benchmark"] == benchmark) and (run["num_tiles"] == num_tiles)]
+         baseline = [run for run in baseline_runs if (run["benchmark"] == benchmark) and (run["num_tiles"] == num_tiles)]
+         if (len(current) == 0) or (len(baseline) == 0):
+            out.write("%s | %s | %s |\n" % (benchmark.ljust(20), str(num_tiles).center(6), "NO DATA".center(20)))
+            continue
+         for metric, larger_is_worse in metric_list:
+            sample = [run[metric] for run in current]
+            baseline_sample = [run[metric] for run in baseline]
+            change = (mean(sample) - mean(baseline_sample)) / mean(baseline_sample) if (mean(baseline_sample) != 0.0) else 0.0
+            slowdown = change if larger_is_worse else -change
+            regression = (slowdown > min_slowdown) and isSignificant(sample, baseline_sample)
+            if regression:
+               num_regressions += 1
+            out.write("%s | %s | %s | %s | %s | %s |\n" % (benchmark.ljust(20), str(num_tiles).center(6), metric.ljust(20),
+                      ("%.2f" % mean(baseline_sample)).rjust(12), ("%.2f" % mean(sample)).rjust(12),
+                      (("%+.1f%%" % (change * 100)) + (" SLOWER" if regression else "")).ljust(18)))
+   out.write("_" * 100 + "\n\n")
+   out.write("%d regressions against %s\n" % (num_regressions, speed_baseline_file))
+   return num_regressions
+
+parser = OptionParser()
+parser.add_option("--compare-only", dest="compare_only", action="store_true", default=False,
+                  help="Compare the runs of the last invocation with the baseline")
+parser.add_option("--save-baseline", dest="save_baseline", action="store_true", default=False,
+                  help="Make the runs of the last invocation the baseline")
+(options, args) = parser.parse_args()
+
+if options.save_baseline:
+   shutil.copyfile(runs_file, speed_baseline_file)
+   print "Saved %s as the baseline %s" % (runs_file, speed_baseline_file)
+   sys.exit(0)
+
+if not options.compare_only:
+   for benchmark, directory, command, mode in speed_benchmark_list:
+      os.system("make -C %s BUILD_MODE=build" % (directory))
+
+   try:
+      shutil.rmtree(speed_results_dir)
+   except OSError:
+      pass
+   os.makedirs(speed_results_dir)
+
+   runs = []
+   for benchmark, directory, command, mode in speed_benchmark_list:
+      for num_tiles in num_tiles_list:
+         for repetition in range(0, num_repetitions):
+            run_dir = os.path.abspath("%s/%s-%d-%d" % (speed_results_dir, benchmark, num_tiles, repetition))
+            run = runSimulation(benchmark, command, mode, num_tiles, repetition, run_dir)
+            if run:
+               runs.append(run)
+   writeRuns(runs_file, runs)
+
+runs = readRuns(runs_file)
+if not os.path.exists(speed_baseline_file):
+   print "No baseline (%s), save one with --save-baseline" % (speed_baseline_file)
+   sys.exit(0)
+
+out = open(summary_file, 'w')
+num_regressions = compareRuns(runs, readRuns(speed_baseline_file), out)
+out.close()
+print open(summary_file, 'r').read()
+sys.exit(1 if (num_regressions > 0) else 0)
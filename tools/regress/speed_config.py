@@ -0,0 +1,32 @@
+#!/usr/bin/env python
+
+# Simulation-speed regression tests (run_speed_tests.py). Every benchmark
+# runs on every tile count, num_repetitions times, one run at a time on this
+# machine so that the host times compare.
+
+speed_results_dir = "./tools/regress/speed_results"
+speed_baseline_file = "./tools/regress/speed_baseline.csv"
+
+num_tiles_list = [16, 64, 256]
+num_repetitions = 3
+
+# A slowdown is a regression if it is larger than min_slowdown (a fraction)
+# and significant at significance_level (Welch's t-test, two-sided; 0.10,
+# 0.05 or 0.01)
+min_slowdown = 0.03
+significance_level = 0.05
+
+# Benchmark, its directory, its command ('%(tiles)i' is the tile count,
+# '%(run_dir)s' the output directory of the run) and how it runs ("pin" or
+# "standalone", as MODE in its Makefile)
+speed_benchmark_list = [
+      ("radix", "tests/benchmarks/radix", "./tests/benchmarks/radix/radix -p%(tiles)i -n1048576", "pin"),
+      ("fft", "tests/benchmarks/fft", "./tests/benchmarks/fft/fft -p%(tiles)i -m20", "pin"),
+      ("ocean_contiguous", "tests/benchmarks/ocean_contiguous", "./tests/benchmarks/ocean_contiguous/ocean_contiguous -p%(tiles)i", "pin"),
+      ("lu_contiguous", "tests/benchmarks/lu_contiguous", "./tests/benchmarks/lu_contiguous/lu_contiguous -p%(tiles)i", "pin"),
+      ("stream", "tests/apps/stream", "./tests/apps/stream/stream", "pin"),
+      ("synthetic_memory", "tests/benchmarks/synthetic_memory", "./tests/benchmarks/synthetic_memory/synthetic_memory < %(run_dir)s/input", "standalone")]
+
+# Input of synthetic_memory, its first line (the number of threads) is
+# replaced by the tile count
+synthetic_memory_input = "./tests/benchmarks/synthetic_memory/inputs/input.64"
@@ -0,0 +1,311 @@
+#!/usr/bin/env python
+
+# Runs a design-space sweep: one simulation per point of a grid of
+# carbon_sim.cfg parameters, packed onto the machines by their predicted
+# cores and memory, e.g.
+#     sweep.py --sweep-file sweep.txt --results-dir results/sweep
+# with, in sweep.txt (one directive per line, '#' comments):
+#     command ./tests/benchmarks/fft/fft -p%(general/total_cores)s -m16
+#     mode pin                              # pin (default) or standalone
+#     machine cagnode6 16 32                # name, cores, memory (in GB)
+#     machine cagnode7 16 32                # (default: this machine)
+#     param general/total_cores 16 64       # a grid dimension: key, values
+#     param l2_cache/T1/cache_size 256 512
+#     option --general/enable_power_modeling=true   # the same for all points
+#     checkpoint                            # reuse warmup checkpoints
+#     warmup_ignore network/user_model_1    # a key that does not change the
+#                                           # warmed-up state
+# The command is formatted with the parameters of the point.
+#
+# A point is identified by a hash of its effective config (the config file,
+# the options and the parameters of the point), its command and the binaries
+# it runs (the application, and pin_sim.so with Pin). Its results go to
+# <results-dir>/points/<hash>; a point that already completed there is not
+# run again, so a sweep can be extended or resumed.
+#   With 'checkpoint', the points that differ only in warmup_ignore keys
+# share a checkpoint of the caches ([checkpoint] in carbon_sim.cfg): the
+# first one saves it at the start of the region of interest and the others
+# restore it, instead of warming up again. The checkpoints are kept in
+# <results-dir>/checkpoints/<hash> and reused by later sweeps.
+#   <results-dir>/sweep.csv lists the points, their status and directory.
+
+import os
+import re
+import sys
+import time
+import hashlib
+import multiprocessing
+from optparse import OptionParser
+
+sim_root = os.path.abspath(os.path.join(os.path.dirname(sys.argv[0]), ".."))
+sys.path.append(os.path.join(sim_root, "tools"))
+
+import spawn
+import spawn_master
+
+# Memory model of a simulation (in MB): a fixed part, and per tile a fixed
+# part and the caches (data and line info)
+base_memory = 512
+tile_memory = 16
+cache_memory_factor = 1.5
+cache_size_keys = ["l1_icache/T1/cache_size", "l1_dcache/T1/cache_size", "l2_cache/T1/cache_size"]
+
+class Sweep:
+   def __init__(self):
+      self.command = ""
+      self.mode = "pin"
+      self.machines = []
+      self.params = []
+      self.options = []
+      self.checkpoint = False
+      self.warmup_ignore = []
+
+class Machine:
+   def __init__(self, name, cores, memory):
+      self.name = name
+      self.cores = cores
+      self.memory = memory            # In MB
+      self.free_cores = cores
+      self.free_memory = memory
+
+class Point:
+   def __init__(self, values):
+      self.values = values            # (key, value) of each parameter
+      self.hash = ""
+      self.warmup_hash = ""
+      self.directory = ""
+      self.status = "pending"
+      self.cores = 1
+      self.memory = 0
+      self.checkpoint_flags = ""
+      self.machine = None
+      self.procs = None
+
+def readSweep(filename):
+   sweep = Sweep()
+   for line in open(filename, "r"):
+      line = line.split("#")[0].strip()
+      if not line:
+         continue
+      fields = line.split()
+      directive = fields[0]
+      if directive == "command":
+         sweep.command = line[len("command"):].strip()
+      elif directive == "mode":
+         sweep.mode = fields[1]
+      elif directive == "machine":
+         sweep.machines.append(Machine(fields[1], int(fields[2]), int(float(fields[3]) * 1024)))
+      elif directive == "param":
+         sweep.params.append((fields[1], fields[2:]))
+      elif directive == "option":
+         sweep.options.extend(fields[1:])
+      elif directive == "checkpoint":
+         sweep.checkpoint = True
+      elif directive == "warmup_ignore":
+         sweep.warmup_ignore.extend(fields[1:])
+      else:
+         sys.stderr.write("ERROR: unrecognized directive(%s) in %s\n" % (directive, filename))
+         sys.exit(1)
+   if not sweep.command:
+      sys.stderr.write("ERROR: no command in %s\n" % filename)
+      sys.exit(1)
+   if not sweep.machines:
+      memory = os.sysconf("SC_PAGE_SIZE") * os.sysconf("SC_PHYS_PAGES") / (1024 * 1024)
+      sweep.machines.append(Machine("localhost", multiprocessing.cpu_count(), memory))
+   return sweep
+
+# Values of the config file, by section/key
+def readConfig(filename):
+   config = {}
+   section = ""
+   for line in open(filename, "r"):
+      line = line.split("#")[0].strip()
+      match = re.match(r"^\[(.*)\]$", line)
+      if match:
+         section = match.group(1)
+         continue
+      match = re.match(r"^([^=\s]+)\s*=\s*(.*)$", line)
+      if match:
+         config["%s/%s" % (section, match.group(1))] = match.group(2).strip().strip("\"")
+   return config
+
+def hashFile(filename):
+   digest = hashlib.sha1()
+   f = open(filename, "rb")
+   while True:
+      data = f.read(1 << 20)
+      if not data:
+         break
+      digest.update(data)
+   f.close()
+   return digest.hexdigest()
+
+# The points of the grid, in order
+def expandGrid(params):
+   points = [[]]
+   for (key, values) in params:
+      points = [point + [(key, value)] for point in points for value in values]
+   return [Point(values) for values in points]
+
+def getOverrides(point, keys_ignored = []):
+   return ["--%s=%s" % (key, value) for (key, value) in point.values if key not in keys_ignored]
+
+def computeHash(items):
+   return hashlib.sha1("\n".join(items)).hexdigest()
+
+def predictResources(point, config, machines):
+   effective = dict(config)
+   effective.update(dict(point.values))
+   num_tiles = int(effective["general/total_cores"])
+   cache_size = sum([float(effective.get(key, "0")) for key in cache_size_keys])
+   memory = base_memory + num_tiles * (tile_memory + cache_size * cache_memory_factor / 1024)
+   # A thread per tile, at most a machine
+   cores = min(num_tiles, max([machine.cores for machine in machines]))
+   return (cores, int(memory))
+
+def startPoint(point, sweep, options, graphite_home):
+   num_tiles = dict(point.values).get("general/total_cores", options.config["general/total_cores"])
+   sim_flags = "-c %s --general/num_processes=1 --process_map/process0=%s --general/output_dir=%s %s %s %s" \
+               % (options.config_file, point.machine.name, point.directory,
+                  " ".join(sweep.options), " ".join(getOverrides(point)), point.checkpoint_flags)
+   command = sweep.command % dict(point.values)
+   if sweep.mode == "pin":
+      pin_path = "%s/intel64/bin/pinbin" % spawn.get_pin_home(graphite_home)
+      pin_lib = "%s/lib/pin_sim" % graphite_home
+      command = "%s -tool_exit_timeout 1 -mt -t %s %s -- %s" % (pin_path, pin_lib, sim_flags, command)
+   else:
+      command = "%s %s" % (command, sim_flags)
+   command += " > %s/output 2>&1" % point.directory
+
+   if not os.path.exists(point.directory):
+      os.makedirs(point.directory)
+   open(os.path.join(point.directory, "command"), "w").write(command)
+   open(os.path.join(point.directory, "point"), "w").write("\n".join(getOverrides(point)) + "\n")
+
+   print "[sweep.py] Starting point %s (%s tiles) on %s: %s" % (point.hash[:12], num_tiles, point.machine.name,
+                                                               " ".join(getOverrides(point)))
+   point.procs = spawn_master.spawn_job([point.machine.name], command, graphite_home, graphite_home)
+   point.status = "running"
+
+parser = OptionParser()
+parser.add_option("--sweep-file", dest="sweep_file", help="Sweep description")
+parser.add_option("--results-dir", dest="results_dir", default="results/sweep", help="Results directory")
+parser.add_option("--config-file", dest="config_file", default="carbon_sim.cfg", help="Base config file")
+parser.add_option("--dry-run", dest="dry_run", action="store_true", default=False, help="List the points to run")
+(options, args) = parser.parse_args()
+
+if not options.sweep_file:
+   parser.print_help()
+   sys.exit(1)
+
+graphite_home = sim_root
+options.config_file = os.path.abspath(options.config_file)
+options.results_dir = os.path.abspath(options.results_dir)
+options.config = readConfig(options.config_file)
+sweep = readSweep(options.sweep_file)
+points = expandGrid(sweep.params)
+
+# Hashes of the points and of their warmup state
+config_hash = hashFile(options.config_file)
+binary_hashes = [hashFile(os.path.join(graphite_home, sweep.command.split()[0]))]
+if sweep.mode == "pin":
+   binary_hashes.append(hashFile(os.path.join(graphite_home, "lib", "pin_sim.so")))
+for point in points:
+   common = [config_hash, sweep.mode] + binary_hashes + sweep.options
+   point.hash = computeHash(common + [sweep.command % dict(point.values)] + getOverrides(point))
+   point.warmup_hash = computeHash(common + [sweep.command % dict(point.values)] +
+                                   getOverrides(point, sweep.warmup_ignore))
+   point.directory = os.path.join(options.results_dir, "points", point.hash)
+   (point.cores, point.memory) = predictResources(point, options.config, sweep.machines)
+   if os.path.exists(os.path.join(point.directory, "done")):
+      point.status = "reused"
+
+# Checkpoints: the first point to run of each warmup group saves it, unless
+# it exists
+savers = {}
+for point in points:
+   if not sweep.checkpoint or point.status != "pending":
+      continue
+   checkpoint_dir = os.path.join(options.results_dir, "checkpoints", point.warmup_hash)
+   if os.path.exists(os.path.join(checkpoint_dir, "done")):
+      point.checkpoint_flags = "--checkpoint/load_dir=%s" % checkpoint_dir
+   elif point.warmup_hash not in savers:
+      savers[point.warmup_hash] = point
+      point.checkpoint_flags = "--checkpoint/save_dir=%s" % checkpoint_dir
+      if not os.path.exists(checkpoint_dir):
+         os.makedirs(checkpoint_dir)
+   else:
+      point.checkpoint_flags = "--checkpoint/load_dir=%s" % checkpoint_dir
+
+max_memory = max([machine.memory for machine in sweep.machines])
+for point in points:
+   if point.status == "pending" and point.memory > max_memory:
+      print "[sweep.py] Point %s needs %d MB, more than any machine" % (point.hash[:12], point.memory)
+      point.status = "too_large"
+
+if options.dry_run:
+   for point in points:
+      print "%s %-10s %3d cores %6d MB %s %s" % (point.hash[:12], point.status, point.cores, point.memory,
+                                                 " ".join(getOverrides(point)), point.checkpoint_flags)
+   sys.exit(0)
+
+# Largest first, the checkpoint savers before the points that wait for them
+pending = [point for point in points if point.status == "pending"]
+pending.sort(key = lambda point: (point not in savers.values(), -point.memory))
+running = []
+try:
+   while pending or running:
+      for point in list(pending):
+         saver = savers.get(point.warmup_hash)
+         if saver and saver is not point:
+            if saver.status in ["pending", "running"]:
+               continue
+            if saver.status != "done":
+               # Warm up again
+               point.checkpoint_flags = ""
+         for machine in sweep.machines:
+            if (machine.free_cores >= point.cores) and (machine.free_memory >= point.memory):
+               point.machine = machine
+               machine.free_cores -= point.cores
+               machine.free_memory -= point.memory
+               startPoint(point, sweep, options, graphite_home)
+               pending.remove(point)
+               running.append(point)
+               break
+
+      for point in list(running):
+         status = spawn_master.poll_job(point.procs)
+         if status == None:
+            continue
+         running.remove(point)
+         point.machine.free_cores += point.cores
+         point.machine.free_memory += point.memory
+         if status == 0:
+            point.status = "done"
+            open(os.path.join(point.directory, "done"), "w").close()
+            if savers.get(point.warmup_hash) is point:
+               open(os.path.join(options.results_dir, "checkpoints", point.warmup_hash, "done"), "w").close()
+         else:
+            point.status = "failed"
+            print "[sweep.py] Point %s failed (%d), see %s/output" % (point.hash[:12], status, point.directory)
+
+      time.sleep(0.5)
+
+except KeyboardInterrupt:
+   for point in running:
+      spawn_master.kill_job(point.procs)
+   sys.exit(1)
+
+if not os.path.exists(options.results_dir):
+   os.makedirs(options.results_dir)
+out = open(os.path.join(options.results_dir, "sweep.csv"), "w")
+out.write(",".join([key for (key, values) in sweep.params] + ["status", "hash", "directory"]) + "\n")
+for point in points:
+   out.write(",".join([value for (key, value) in point.values] + [point.status, point.hash, point.directory]) + "\n")
+out.close()
+
+num_failed = len([point for point in points if point.status not in ["done", "reused"]])
+print "[sweep.py] %d points: %d run, %d reused, %d failed" % (len(points),
+      len([point for point in points if point.status == "done"]),
+      len([point for point in points if point.status == "reused"]), num_failed)
+sys.exit(1 if num_failed > 0 else 0)
@@ -0,0 +1,15 @@
+#include "carbon_user.h"
+#include "trace_replay.h"
+
+// Replays the instruction stream traces of a recorded run ([trace_record]
+// enabled = true), natively. The configuration must be the one of the
+// recorded run, with [trace_replay] directory = its output directory
+int main(int argc, char **argv)
+{
+   CarbonStartSim(argc, argv);
+
+   CarbonReplayInstructionTraces();
+
+   CarbonStopSim();
+   return 0;
+}